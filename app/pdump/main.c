@@ -27,6 +27,8 @@
 #include <rte_string_fns.h>
 #include <rte_pdump.h>
 
+#include "pcapng.h"
+
 #define CMD_LINE_OPT_PDUMP "pdump"
 #define PDUMP_PORT_ARG "port"
 #define PDUMP_PCI_ARG "device_id"
@@ -37,6 +39,7 @@
 #define PDUMP_RING_SIZE_ARG "ring-size"
 #define PDUMP_MSIZE_ARG "mbuf-size"
 #define PDUMP_NUM_MBUFS_ARG "total-num-mbufs"
+#define PDUMP_SNAPLEN_ARG "snap-len"
 
 #define VDEV_NAME_FMT "net_pcap_%s_%d"
 #define VDEV_PCAP_ARGS_FMT "tx_pcap=%s"
@@ -73,7 +76,8 @@ enum pdump_en_dis {
 
 enum pcap_stream {
 	IFACE = 1,
-	PCAP = 2
+	PCAP = 2,
+	PCAPNG = 3
 };
 
 enum pdump_by {
@@ -91,6 +95,7 @@ static const char * const valid_pdump_arguments[] = {
 	PDUMP_RING_SIZE_ARG,
 	PDUMP_MSIZE_ARG,
 	PDUMP_NUM_MBUFS_ARG,
+	PDUMP_SNAPLEN_ARG,
 	NULL
 };
 
@@ -110,6 +115,7 @@ struct pdump_tuples {
 	uint32_t ring_size;
 	uint16_t mbuf_data_size;
 	uint32_t total_num_mbufs;
+	uint32_t snaplen;
 
 	/* params for library API call */
 	uint32_t dir;
@@ -124,6 +130,8 @@ struct pdump_tuples {
 	enum pcap_stream rx_vdev_stream_type;
 	enum pcap_stream tx_vdev_stream_type;
 	bool single_pdump_dev;
+	struct pcapng_writer *rx_pcapng;
+	struct pcapng_writer *tx_pcapng;
 
 	/* stats */
 	struct pdump_stats stats;
@@ -151,7 +159,8 @@ pdump_usage(const char *prgname)
 			" tx-dev=<iface or pcap file>,"
 			"[ring-size=<ring size>default:16384],"
 			"[mbuf-size=<mbuf data size>default:2176],"
-			"[total-num-mbufs=<number of mbufs>default:65535]'\n",
+			"[total-num-mbufs=<number of mbufs>default:65535],"
+			"[snap-len=<bytes captured per packet>default:0]'\n",
 			prgname);
 }
 
@@ -187,17 +196,25 @@ parse_rxtxdev(const char *key, const char *value, void *extra_args)
 {
 
 	struct pdump_tuples *pt = extra_args;
+	size_t len = strlen(value);
+	size_t suffix_len = strlen(PCAPNG_FILE_SUFFIX);
+	bool pcapng = len > suffix_len &&
+		!strcmp(value + len - suffix_len, PCAPNG_FILE_SUFFIX);
 
 	if (!strcmp(key, PDUMP_RX_DEV_ARG)) {
 		snprintf(pt->rx_dev, sizeof(pt->rx_dev), "%s", value);
 		/* identify the tx stream type for pcap vdev */
 		if (if_nametoindex(pt->rx_dev))
 			pt->rx_vdev_stream_type = IFACE;
+		else if (pcapng)
+			pt->rx_vdev_stream_type = PCAPNG;
 	} else if (!strcmp(key, PDUMP_TX_DEV_ARG)) {
 		snprintf(pt->tx_dev, sizeof(pt->tx_dev), "%s", value);
 		/* identify the tx stream type for pcap vdev */
 		if (if_nametoindex(pt->tx_dev))
 			pt->tx_vdev_stream_type = IFACE;
+		else if (pcapng)
+			pt->tx_vdev_stream_type = PCAPNG;
 	}
 
 	return 0;
@@ -306,6 +323,13 @@ parse_pdump(const char *optarg)
 		/* if captured packets has to send to the same vdev */
 		if (!strcmp(pt->rx_dev, pt->tx_dev))
 			pt->single_pdump_dev = true;
+		if ((pt->rx_vdev_stream_type == PCAPNG) !=
+				(pt->tx_vdev_stream_type == PCAPNG)) {
+			printf("--pdump=\"%s\": rx-dev and tx-dev must be "
+				"both pcapng files or none\n", optarg);
+			ret = -1;
+			goto free_kvlist;
+		}
 		pt->dir = RTE_PDUMP_FLAG_RXTX;
 	} else if (cnt1 == 1) {
 		ret = rte_kvargs_process(kvlist, PDUMP_RX_DEV_ARG,
@@ -361,6 +385,19 @@ parse_pdump(const char *optarg)
 	} else
 		pt->total_num_mbufs = MBUFS_PER_POOL;
 
+	/* snaplen parsing and validation */
+	cnt1 = rte_kvargs_count(kvlist, PDUMP_SNAPLEN_ARG);
+	if (cnt1 == 1) {
+		v.min = 0;
+		v.max = UINT32_MAX;
+		ret = rte_kvargs_process(kvlist, PDUMP_SNAPLEN_ARG,
+						&parse_uint_value, &v);
+		if (ret < 0)
+			goto free_kvlist;
+		pt->snaplen = (uint32_t) v.val;
+	} else
+		pt->snaplen = 0;
+
 	num_tuples++;
 
 free_kvlist:
@@ -461,6 +498,29 @@ pdump_rxtx(struct rte_ring *ring, uint16_t vdev_id, struct pdump_stats *stats)
 	}
 }
 
+static inline void
+pdump_pcapng(struct rte_ring *ring, struct pcapng_writer *w, int outbound,
+		struct pdump_stats *stats)
+{
+	/* write input packets of port to the pcapng file */
+	struct rte_mbuf *rxtx_bufs[BURST_SIZE];
+	uint16_t nb_in_wr, i;
+
+	const uint16_t nb_in_deq = rte_ring_dequeue_burst(ring,
+			(void *)rxtx_bufs, BURST_SIZE, NULL);
+	stats->dequeue_pkts += nb_in_deq;
+
+	if (nb_in_deq) {
+		nb_in_wr = pcapng_write_pkts(w, rxtx_bufs, nb_in_deq,
+				outbound);
+		stats->tx_pkts += nb_in_wr;
+		stats->freed_pkts += nb_in_deq - nb_in_wr;
+
+		for (i = 0; i < nb_in_deq; i++)
+			rte_pktmbuf_free(rxtx_bufs[i]);
+	}
+}
+
 static void
 free_ring_data(struct rte_ring *ring, uint16_t vdev_id,
 		struct pdump_stats *stats)
@@ -469,6 +529,14 @@ free_ring_data(struct rte_ring *ring, uint16_t vdev_id,
 		pdump_rxtx(ring, vdev_id, stats);
 }
 
+static void
+free_ring_data_pcapng(struct rte_ring *ring, struct pcapng_writer *w,
+		int outbound, struct pdump_stats *stats)
+{
+	while (rte_ring_count(ring))
+		pdump_pcapng(ring, w, outbound, stats);
+}
+
 static void
 cleanup_rings(void)
 {
@@ -481,6 +549,13 @@ cleanup_rings(void)
 		if (pt->device_id)
 			free(pt->device_id);
 
+		/* close the pcapng files */
+		if (pt->tx_pcapng != pt->rx_pcapng)
+			pcapng_close(pt->tx_pcapng);
+		pcapng_close(pt->rx_pcapng);
+		pt->rx_pcapng = NULL;
+		pt->tx_pcapng = NULL;
+
 		/* free the rings */
 		if (pt->rx_ring)
 			rte_ring_free(pt->rx_ring);
@@ -506,6 +581,15 @@ cleanup_pdump_resources(void)
 		* transmit rest of the enqueued packets of the rings on to
 		* the vdev, in order to release mbufs to the mepool.
 		**/
+		if (pt->rx_pcapng != NULL || pt->tx_pcapng != NULL) {
+			if (pt->dir & RTE_PDUMP_FLAG_RX)
+				free_ring_data_pcapng(pt->rx_ring,
+					pt->rx_pcapng, 0, &pt->stats);
+			if (pt->dir & RTE_PDUMP_FLAG_TX)
+				free_ring_data_pcapng(pt->tx_ring,
+					pt->tx_pcapng, 1, &pt->stats);
+			continue;
+		}
 		if (pt->dir & RTE_PDUMP_FLAG_RX)
 			free_ring_data(pt->rx_ring, pt->rx_vdev_id, &pt->stats);
 		if (pt->dir & RTE_PDUMP_FLAG_TX)
@@ -564,6 +648,53 @@ configure_vdev(uint16_t port_id)
 	return 0;
 }
 
+/*
+ * Create the rings of a tuple dumped into pcapng files, and open the
+ * files. The packets of both directions share the file if it is the same.
+ */
+static void
+create_ring_pcapng(struct pdump_tuples *pt, int i)
+{
+	char ring_name[SIZE];
+
+	if (pt->dir & RTE_PDUMP_FLAG_RX) {
+		snprintf(ring_name, SIZE, RX_RING, i);
+		pt->rx_ring = rte_ring_create(ring_name, pt->ring_size,
+				rte_socket_id(), 0);
+		if (pt->rx_ring == NULL) {
+			cleanup_rings();
+			rte_exit(EXIT_FAILURE, "%s:%s:%d\n",
+					rte_strerror(rte_errno),
+					__func__, __LINE__);
+		}
+		pt->rx_pcapng = pcapng_open(pt->rx_dev);
+		if (pt->rx_pcapng == NULL) {
+			cleanup_rings();
+			rte_exit(EXIT_FAILURE, "pcapng file creation failed\n");
+		}
+	}
+
+	if (pt->dir & RTE_PDUMP_FLAG_TX) {
+		snprintf(ring_name, SIZE, TX_RING, i);
+		pt->tx_ring = rte_ring_create(ring_name, pt->ring_size,
+				rte_socket_id(), 0);
+		if (pt->tx_ring == NULL) {
+			cleanup_rings();
+			rte_exit(EXIT_FAILURE, "%s:%s:%d\n",
+					rte_strerror(rte_errno),
+					__func__, __LINE__);
+		}
+		if (pt->single_pdump_dev)
+			pt->tx_pcapng = pt->rx_pcapng;
+		else
+			pt->tx_pcapng = pcapng_open(pt->tx_dev);
+		if (pt->tx_pcapng == NULL) {
+			cleanup_rings();
+			rte_exit(EXIT_FAILURE, "pcapng file creation failed\n");
+		}
+	}
+}
+
 static void
 create_mp_ring_vdev(void)
 {
@@ -596,7 +727,12 @@ create_mp_ring_vdev(void)
 		}
 		pt->mp = mbuf_pool;
 
-		if (pt->dir == RTE_PDUMP_FLAG_RXTX) {
+		if ((pt->dir & RTE_PDUMP_FLAG_RX &&
+				pt->rx_vdev_stream_type == PCAPNG) ||
+				(pt->dir & RTE_PDUMP_FLAG_TX &&
+				 pt->tx_vdev_stream_type == PCAPNG)) {
+			create_ring_pcapng(pt, i);
+		} else if (pt->dir == RTE_PDUMP_FLAG_RXTX) {
 			/* if captured packets has to send to the same vdev */
 			/* create rx_ring */
 			snprintf(ring_name, SIZE, RX_RING, i);
@@ -768,47 +904,50 @@ enable_pdump(void)
 		pt = &pdump_t[i];
 		if (pt->dir == RTE_PDUMP_FLAG_RXTX) {
 			if (pt->dump_by_type == DEVICE_ID) {
-				ret = rte_pdump_enable_by_deviceid(
+				ret = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
 						RTE_PDUMP_FLAG_RX,
+						pt->snaplen,
 						pt->rx_ring,
 						pt->mp, NULL);
-				ret1 = rte_pdump_enable_by_deviceid(
+				ret1 = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
 						RTE_PDUMP_FLAG_TX,
+						pt->snaplen,
 						pt->tx_ring,
 						pt->mp, NULL);
 			} else if (pt->dump_by_type == PORT_ID) {
-				ret = rte_pdump_enable(pt->port, pt->queue,
-						RTE_PDUMP_FLAG_RX,
+				ret = rte_pdump_enable_bpf(pt->port, pt->queue,
+						RTE_PDUMP_FLAG_RX, pt->snaplen,
 						pt->rx_ring, pt->mp, NULL);
-				ret1 = rte_pdump_enable(pt->port, pt->queue,
-						RTE_PDUMP_FLAG_TX,
+				ret1 = rte_pdump_enable_bpf(pt->port, pt->queue,
+						RTE_PDUMP_FLAG_TX, pt->snaplen,
 						pt->tx_ring, pt->mp, NULL);
 			}
 		} else if (pt->dir == RTE_PDUMP_FLAG_RX) {
 			if (pt->dump_by_type == DEVICE_ID)
-				ret = rte_pdump_enable_by_deviceid(
+				ret = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
-						pt->dir, pt->rx_ring,
+						pt->dir, pt->snaplen,
+						pt->rx_ring,
 						pt->mp, NULL);
 			else if (pt->dump_by_type == PORT_ID)
-				ret = rte_pdump_enable(pt->port, pt->queue,
-						pt->dir,
+				ret = rte_pdump_enable_bpf(pt->port, pt->queue,
+						pt->dir, pt->snaplen,
 						pt->rx_ring, pt->mp, NULL);
 		} else if (pt->dir == RTE_PDUMP_FLAG_TX) {
 			if (pt->dump_by_type == DEVICE_ID)
-				ret = rte_pdump_enable_by_deviceid(
+				ret = rte_pdump_enable_bpf_by_deviceid(
 						pt->device_id,
 						pt->queue,
-						pt->dir,
+						pt->dir, pt->snaplen,
 						pt->tx_ring, pt->mp, NULL);
 			else if (pt->dump_by_type == PORT_ID)
-				ret = rte_pdump_enable(pt->port, pt->queue,
-						pt->dir,
+				ret = rte_pdump_enable_bpf(pt->port, pt->queue,
+						pt->dir, pt->snaplen,
 						pt->tx_ring, pt->mp, NULL);
 		}
 		if (ret < 0 || ret1 < 0) {
@@ -827,6 +966,15 @@ dump_packets(void)
 	while (!quit_signal) {
 		for (i = 0; i < num_tuples; i++) {
 			pt = &pdump_t[i];
+			if (pt->rx_pcapng != NULL || pt->tx_pcapng != NULL) {
+				if (pt->dir & RTE_PDUMP_FLAG_RX)
+					pdump_pcapng(pt->rx_ring,
+						pt->rx_pcapng, 0, &pt->stats);
+				if (pt->dir & RTE_PDUMP_FLAG_TX)
+					pdump_pcapng(pt->tx_ring,
+						pt->tx_pcapng, 1, &pt->stats);
+				continue;
+			}
 			if (pt->dir & RTE_PDUMP_FLAG_RX)
 				pdump_rxtx(pt->rx_ring, pt->rx_vdev_id,
 					&pt->stats);
@@ -0,0 +1,358 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_pdump.h>
+
+#include "pcapng.h"
+
+/* Write buffer, flushed in full buffer writes. */
+#define PCAPNG_BUF_SIZE (1 << 20)
+#define PCAPNG_BUF_ALIGN 4096
+
+#define PCAPNG_SHB_TYPE 0x0A0D0D0A
+#define PCAPNG_IDB_TYPE 0x00000001
+#define PCAPNG_EPB_TYPE 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+#define PCAPNG_OPT_END 0
+#define PCAPNG_SHB_USERAPPL 4
+#define PCAPNG_IF_NAME 2
+#define PCAPNG_IF_TSRESOL 9
+#define PCAPNG_EPB_FLAGS 2
+
+#define PCAPNG_EPB_FLAG_INBOUND 1
+#define PCAPNG_EPB_FLAG_OUTBOUND 2
+
+#define PCAPNG_LINKTYPE_ETHERNET 1
+/* if_tsresol value for nanosecond timestamps */
+#define PCAPNG_TSRESOL_NSEC 9
+
+#define NSEC_PER_SEC 1000000000ULL
+
+#define PCAPNG_ALIGN(len) RTE_ALIGN_CEIL(len, 4)
+#define PCAPNG_IF_NAME_SIZE 64
+
+struct pcapng_block_hdr {
+	uint32_t type;
+	uint32_t len;
+};
+
+struct pcapng_shb {
+	struct pcapng_block_hdr hdr;
+	uint32_t magic;
+	uint16_t major;
+	uint16_t minor;
+	int64_t section_len;
+};
+
+struct pcapng_idb {
+	struct pcapng_block_hdr hdr;
+	uint16_t linktype;
+	uint16_t reserved;
+	uint32_t snaplen;
+};
+
+struct pcapng_epb {
+	struct pcapng_block_hdr hdr;
+	uint32_t if_id;
+	uint32_t ts_high;
+	uint32_t ts_low;
+	uint32_t cap_len;
+	uint32_t orig_len;
+};
+
+struct pcapng_opt {
+	uint16_t code;
+	uint16_t len;
+};
+
+/* epb_flags option and end of options, after the packet data */
+struct pcapng_epb_trailer {
+	struct pcapng_opt flags_opt;
+	uint32_t flags;
+	struct pcapng_opt end_opt;
+	uint32_t len;
+};
+
+struct pcapng_writer {
+	int fd;
+	uint8_t *buf;
+	uint32_t buf_len;
+	/* TSC and wall clock time at the creation of the writer */
+	uint64_t tsc_base;
+	uint64_t ns_base;
+	uint64_t tsc_hz;
+	/* next interface id */
+	uint32_t nb_ifs;
+	/* interface id plus one of each port and queue, 0 if none yet */
+	uint32_t if_ids[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
+};
+
+static int
+pcapng_flush(struct pcapng_writer *w)
+{
+	uint32_t off = 0;
+	ssize_t n;
+
+	while (off < w->buf_len) {
+		n = write(w->fd, w->buf + off, w->buf_len - off);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		off += n;
+	}
+	w->buf_len = 0;
+
+	return 0;
+}
+
+/* Append data to the buffer, writing the buffer each time it is full. */
+static inline int
+pcapng_append(struct pcapng_writer *w, const void *data, uint32_t len)
+{
+	const uint8_t *src = data;
+	uint32_t n;
+
+	while (len > 0) {
+		n = RTE_MIN(len, PCAPNG_BUF_SIZE - w->buf_len);
+		memcpy(w->buf + w->buf_len, src, n);
+		w->buf_len += n;
+		src += n;
+		len -= n;
+		if (w->buf_len == PCAPNG_BUF_SIZE && pcapng_flush(w) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int
+pcapng_write_shb(struct pcapng_writer *w)
+{
+	static const char appl[] = "dpdk-pdump";
+	struct pcapng_shb shb;
+	struct pcapng_opt opt;
+	uint32_t len, pad = 0;
+	uint32_t appl_len = sizeof(appl) - 1;
+
+	len = sizeof(shb) + sizeof(opt) + PCAPNG_ALIGN(appl_len) +
+		sizeof(opt) + sizeof(len);
+	shb.hdr.type = PCAPNG_SHB_TYPE;
+	shb.hdr.len = len;
+	shb.magic = PCAPNG_BYTE_ORDER_MAGIC;
+	shb.major = 1;
+	shb.minor = 0;
+	shb.section_len = -1;
+
+	opt.code = PCAPNG_SHB_USERAPPL;
+	opt.len = appl_len;
+	if (pcapng_append(w, &shb, sizeof(shb)) < 0 ||
+			pcapng_append(w, &opt, sizeof(opt)) < 0 ||
+			pcapng_append(w, appl, appl_len) < 0 ||
+			pcapng_append(w, &pad,
+				PCAPNG_ALIGN(appl_len) - appl_len) < 0)
+		return -1;
+
+	opt.code = PCAPNG_OPT_END;
+	opt.len = 0;
+	if (pcapng_append(w, &opt, sizeof(opt)) < 0 ||
+			pcapng_append(w, &len, sizeof(len)) < 0)
+		return -1;
+
+	return 0;
+}
+
+static int
+pcapng_write_idb(struct pcapng_writer *w, uint16_t port, uint16_t queue)
+{
+	char dev_name[RTE_ETH_NAME_MAX_LEN];
+	char name[PCAPNG_IF_NAME_SIZE];
+	struct pcapng_idb idb;
+	struct pcapng_opt opt;
+	uint32_t len, name_len, pad = 0;
+	uint8_t tsresol[4] = { PCAPNG_TSRESOL_NSEC, 0, 0, 0 };
+
+	if (rte_eth_dev_get_name_by_port(port, dev_name) != 0)
+		snprintf(dev_name, sizeof(dev_name), "port%u", port);
+	snprintf(name, sizeof(name), "%s:%u", dev_name, queue);
+	name_len = strlen(name);
+
+	len = sizeof(idb) + sizeof(opt) + PCAPNG_ALIGN(name_len) +
+		sizeof(opt) + sizeof(tsresol) + sizeof(opt) + sizeof(len);
+	idb.hdr.type = PCAPNG_IDB_TYPE;
+	idb.hdr.len = len;
+	idb.linktype = PCAPNG_LINKTYPE_ETHERNET;
+	idb.reserved = 0;
+	idb.snaplen = 0;
+	if (pcapng_append(w, &idb, sizeof(idb)) < 0)
+		return -1;
+
+	opt.code = PCAPNG_IF_NAME;
+	opt.len = name_len;
+	if (pcapng_append(w, &opt, sizeof(opt)) < 0 ||
+			pcapng_append(w, name, name_len) < 0 ||
+			pcapng_append(w, &pad,
+				PCAPNG_ALIGN(name_len) - name_len) < 0)
+		return -1;
+
+	opt.code = PCAPNG_IF_TSRESOL;
+	opt.len = 1;
+	if (pcapng_append(w, &opt, sizeof(opt)) < 0 ||
+			pcapng_append(w, tsresol, sizeof(tsresol)) < 0)
+		return -1;
+
+	opt.code = PCAPNG_OPT_END;
+	opt.len = 0;
+	if (pcapng_append(w, &opt, sizeof(opt)) < 0 ||
+			pcapng_append(w, &len, sizeof(len)) < 0)
+		return -1;
+
+	return 0;
+}
+
+struct pcapng_writer *
+pcapng_open(const char *path)
+{
+	struct pcapng_writer *w;
+	struct timespec ts;
+
+	w = calloc(1, sizeof(*w));
+	if (w == NULL)
+		return NULL;
+
+	if (posix_memalign((void **)&w->buf, PCAPNG_BUF_ALIGN,
+				PCAPNG_BUF_SIZE) != 0) {
+		free(w);
+		return NULL;
+	}
+
+	w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (w->fd < 0) {
+		printf("cannot open %s: %s\n", path, strerror(errno));
+		free(w->buf);
+		free(w);
+		return NULL;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	w->tsc_base = rte_rdtsc();
+	w->ns_base = ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+	w->tsc_hz = rte_get_tsc_hz();
+
+	if (pcapng_write_shb(w) < 0) {
+		pcapng_close(w);
+		return NULL;
+	}
+
+	return w;
+}
+
+static inline uint64_t
+pcapng_tsc_to_ns(const struct pcapng_writer *w, uint64_t tsc)
+{
+	uint64_t delta;
+
+	/* Packets captured before the writer creation get its time */
+	delta = tsc > w->tsc_base ? tsc - w->tsc_base : 0;
+
+	return w->ns_base + (delta / w->tsc_hz) * NSEC_PER_SEC +
+		(delta % w->tsc_hz) * NSEC_PER_SEC / w->tsc_hz;
+}
+
+static inline int
+pcapng_write_epb(struct pcapng_writer *w, struct rte_mbuf *m,
+		uint32_t if_id, int outbound)
+{
+	struct pcapng_epb epb;
+	struct pcapng_epb_trailer trailer;
+	const struct rte_mbuf *seg;
+	uint64_t ns;
+	uint32_t pad = 0, data_len;
+
+	data_len = PCAPNG_ALIGN(m->pkt_len);
+	ns = pcapng_tsc_to_ns(w, m->timestamp);
+
+	epb.hdr.type = PCAPNG_EPB_TYPE;
+	epb.hdr.len = sizeof(epb) + data_len + sizeof(trailer);
+	epb.if_id = if_id;
+	epb.ts_high = ns >> 32;
+	epb.ts_low = (uint32_t)ns;
+	epb.cap_len = m->pkt_len;
+	epb.orig_len = RTE_MAX(RTE_PDUMP_MBUF_ORIG_LEN(m), m->pkt_len);
+	if (pcapng_append(w, &epb, sizeof(epb)) < 0)
+		return -1;
+
+	for (seg = m; seg != NULL; seg = seg->next)
+		if (pcapng_append(w, rte_pktmbuf_mtod(seg, void *),
+					seg->data_len) < 0)
+			return -1;
+	if (pcapng_append(w, &pad, data_len - m->pkt_len) < 0)
+		return -1;
+
+	trailer.flags_opt.code = PCAPNG_EPB_FLAGS;
+	trailer.flags_opt.len = sizeof(trailer.flags);
+	trailer.flags = outbound ? PCAPNG_EPB_FLAG_OUTBOUND :
+		PCAPNG_EPB_FLAG_INBOUND;
+	trailer.end_opt.code = PCAPNG_OPT_END;
+	trailer.end_opt.len = 0;
+	trailer.len = epb.hdr.len;
+
+	return pcapng_append(w, &trailer, sizeof(trailer));
+}
+
+uint16_t
+pcapng_write_pkts(struct pcapng_writer *w, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, int outbound)
+{
+	struct rte_mbuf *m;
+	uint32_t *if_id;
+	uint16_t i, queue;
+
+	for (i = 0; i < nb_pkts; i++) {
+		m = pkts[i];
+		queue = RTE_PDUMP_MBUF_QUEUE(m);
+		if (m->port >= RTE_MAX_ETHPORTS ||
+				queue >= RTE_MAX_QUEUES_PER_PORT)
+			continue;
+
+		/* Describe the interface before its first packet */
+		if_id = &w->if_ids[m->port][queue];
+		if (*if_id == 0) {
+			if (pcapng_write_idb(w, m->port, queue) < 0)
+				break;
+			*if_id = ++w->nb_ifs;
+		}
+
+		if (pcapng_write_epb(w, m, *if_id - 1, outbound) < 0)
+			break;
+	}
+
+	return i;
+}
+
+void
+pcapng_close(struct pcapng_writer *w)
+{
+	if (w == NULL)
+		return;
+
+	if (w->buf_len > 0 && pcapng_flush(w) < 0)
+		printf("cannot write pcapng file: %s\n", strerror(errno));
+	close(w->fd);
+	free(w->buf);
+	free(w);
+}
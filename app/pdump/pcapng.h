@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _PCAPNG_H_
+#define _PCAPNG_H_
+
+/**
+ * @file
+ * Buffered pcapng file writer of the packets mirrored by librte_pdump.
+ *
+ * The packets are written in Enhanced Packet Blocks with nanosecond
+ * timestamps derived from their capture TSC, and one Interface
+ * Description Block per captured port and queue, so that the packets of
+ * several queues and of both directions can be interleaved in one file.
+ * The blocks are accumulated in a large buffer written to the file in
+ * buffer sized chunks.
+ */
+
+#include <stdint.h>
+
+#include <rte_mbuf.h>
+
+#define PCAPNG_FILE_SUFFIX ".pcapng"
+
+struct pcapng_writer;
+
+/**
+ * Create a pcapng file and write its section header.
+ *
+ * @param path
+ *  Path of the file, truncated if it exists.
+ * @return
+ *  The writer, or NULL on error.
+ */
+struct pcapng_writer *pcapng_open(const char *path);
+
+/**
+ * Write mirrored packets into a pcapng file. The packets are not freed.
+ *
+ * @param w
+ *  Writer of the file.
+ * @param pkts
+ *  Packets mirrored by librte_pdump.
+ * @param nb_pkts
+ *  Number of packets.
+ * @param outbound
+ *  Non-zero for transmitted packets, zero for received packets.
+ * @return
+ *  The number of packets written, less than nb_pkts on write error.
+ */
+uint16_t pcapng_write_pkts(struct pcapng_writer *w, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, int outbound);
+
+/**
+ * Write the buffered blocks into the file and close it.
+ *
+ * @param w
+ *  Writer of the file.
+ */
+void pcapng_close(struct pcapng_writer *w);
+
+#endif /* _PCAPNG_H_ */
@@ -12,6 +12,7 @@
 #include <stdlib.h>
 #include <getopt.h>
 #include <unistd.h>
+#include <signal.h>
 
 #include <rte_eal.h>
 #include <rte_common.h>
@@ -29,6 +30,11 @@
 #include <rte_branch_prediction.h>
 #include <rte_string_fns.h>
 #include <rte_metrics.h>
+#include <rte_cycles.h>
+#ifdef RTE_LIBRTE_VHOST
+#include <rte_vhost.h>
+#include <rte_vdpa.h>
+#endif
 
 /* Maximum long option length for option parsing. */
 #define MAX_LONG_OPT_SZ 64
@@ -65,6 +71,15 @@ static char *xstats_name;
 static uint32_t nb_xstats_ids;
 static uint64_t xstats_ids[MAX_NB_XSTATS_IDS];
 
+/**< Enable monitor mode, sampling every monitor_interval ms. */
+static uint32_t monitor_interval;
+/**< Number of monitor samples, until interrupted if 0. */
+static uint32_t monitor_count;
+/**< Enable monitoring of the vhost devices. */
+static uint32_t monitor_vhost;
+/**< Set by SIGINT and SIGTERM to stop the monitor mode. */
+static volatile int monitor_quit;
+
 /**< display usage */
 static void
 proc_info_usage(const char *prgname)
@@ -83,7 +98,12 @@ proc_info_usage(const char *prgname)
 		"  --stats-reset: to reset port statistics\n"
 		"  --xstats-reset: to reset port extended statistics\n"
 		"  --collectd-format: to print statistics to STDOUT in expected by collectd format\n"
-		"  --host-id STRING: host id used to identify the system process is running on\n",
+		"  --host-id STRING: host id used to identify the system process is running on\n"
+		"  --monitor MS: to display port and queue rates every MS ms, "
+			"with the rates of the xstats if --xstats is given\n"
+		"  --monitor-count N: to stop monitoring after N samples\n"
+		"  --monitor-vhost: to attach the monitor mode to the vhost "
+			"devices and display their vring rates\n",
 		prgname);
 }
 
@@ -190,6 +210,9 @@ proc_info_parse_args(int argc, char **argv)
 		{"collectd-format", 0, NULL, 0},
 		{"xstats-ids", 1, NULL, 1},
 		{"host-id", 0, NULL, 0},
+		{"monitor", required_argument, NULL, 1},
+		{"monitor-count", required_argument, NULL, 1},
+		{"monitor-vhost", 0, NULL, 0},
 		{NULL, 0, 0, 0}
 	};
 
@@ -233,6 +256,10 @@ proc_info_parse_args(int argc, char **argv)
 			else if (!strncmp(long_option[option_index].name, "xstats-reset",
 					MAX_LONG_OPT_SZ))
 				reset_xstats = 1;
+			/* Monitor the vhost devices */
+			if (!strncmp(long_option[option_index].name,
+					"monitor-vhost", MAX_LONG_OPT_SZ))
+				monitor_vhost = 1;
 			break;
 		case 1:
 			/* Print xstat single value given by name*/
@@ -254,6 +281,17 @@ proc_info_parse_args(int argc, char **argv)
 					return -1;
 				}
 
+			} else if (!strncmp(long_option[option_index].name,
+					"monitor", MAX_LONG_OPT_SZ)) {
+				monitor_interval = strtoul(optarg, NULL, 10);
+				if (monitor_interval == 0) {
+					printf("invalid monitor interval\n");
+					proc_info_usage(prgname);
+					return -1;
+				}
+			} else if (!strncmp(long_option[option_index].name,
+					"monitor-count", MAX_LONG_OPT_SZ)) {
+				monitor_count = strtoul(optarg, NULL, 10);
 			}
 			break;
 		default:
@@ -584,6 +622,343 @@ metrics_display(int port_id)
 	rte_free(names);
 }
 
+/*
+ * Monitor mode: the process attaches once and samples the counters at a
+ * set interval, the rates being the differences between two samples.
+ */
+
+#define MAX_MONITOR_DEVS 64
+
+struct monitor_port {
+	uint16_t port_id;
+	uint16_t nb_queues;
+	struct rte_eth_stats stats;
+	int nb_xstats;
+	struct rte_eth_xstat_name *xstats_names;
+	uint64_t *xstats;
+	uint64_t *xstats_prev;
+};
+
+static struct monitor_port monitor_ports[RTE_MAX_ETHPORTS];
+static uint16_t nb_monitor_ports;
+
+#ifdef RTE_LIBRTE_VHOST
+struct monitor_vhost_dev {
+	int vid;
+	uint16_t nr_vring;
+	char ifname[MAX_STRING_LEN];
+	struct rte_vhost_vring_stats *stats;
+};
+
+struct monitor_vdpa_dev {
+	int did;
+	uint32_t nr_queue;
+	struct rte_vdpa_stats *stats;
+};
+
+static struct monitor_vhost_dev monitor_vhost_devs[MAX_MONITOR_DEVS];
+static uint32_t nb_monitor_vhost_devs;
+static struct monitor_vdpa_dev monitor_vdpa_devs[MAX_MONITOR_DEVS];
+static uint32_t nb_monitor_vdpa_devs;
+#endif
+
+static void
+monitor_signal_handler(int signum __rte_unused)
+{
+	monitor_quit = 1;
+}
+
+static int
+monitor_port_init(struct monitor_port *mp, uint16_t port_id)
+{
+	struct rte_eth_dev_info dev_info;
+	int len;
+
+	mp->port_id = port_id;
+	rte_eth_dev_info_get(port_id, &dev_info);
+	mp->nb_queues = RTE_MIN(RTE_MAX(dev_info.nb_rx_queues,
+				dev_info.nb_tx_queues),
+			RTE_ETHDEV_QUEUE_STAT_CNTRS);
+	rte_eth_stats_get(port_id, &mp->stats);
+
+	if (!enable_xstats)
+		return 0;
+
+	len = rte_eth_xstats_get_names_by_id(port_id, NULL, 0, NULL);
+	if (len <= 0)
+		return 0;
+	mp->xstats_names = malloc(sizeof(*mp->xstats_names) * len);
+	mp->xstats = malloc(sizeof(*mp->xstats) * len);
+	mp->xstats_prev = malloc(sizeof(*mp->xstats_prev) * len);
+	if (mp->xstats_names == NULL || mp->xstats == NULL ||
+			mp->xstats_prev == NULL) {
+		printf("Cannot allocate memory for xstats\n");
+		return -1;
+	}
+	if (len != rte_eth_xstats_get_names_by_id(port_id,
+			mp->xstats_names, len, NULL) ||
+			rte_eth_xstats_get_by_id(port_id, NULL,
+				mp->xstats_prev, len) != len) {
+		printf("Cannot get xstats of port %u\n", port_id);
+		return -1;
+	}
+	mp->nb_xstats = len;
+
+	return 0;
+}
+
+static void
+monitor_port_display(struct monitor_port *mp, double secs)
+{
+	struct rte_eth_stats stats, *prev = &mp->stats;
+	uint64_t *tmp;
+	uint16_t q;
+	int i;
+
+	if (rte_eth_stats_get(mp->port_id, &stats) != 0)
+		return;
+
+	printf("%-6u%-8s%10.3f%10.1f%10.3f%10.1f%12.0f%12.0f\n",
+		mp->port_id, "all",
+		(stats.ipackets - prev->ipackets) / secs / 1e6,
+		(stats.ibytes - prev->ibytes) * 8 / secs / 1e6,
+		(stats.opackets - prev->opackets) / secs / 1e6,
+		(stats.obytes - prev->obytes) * 8 / secs / 1e6,
+		(stats.imissed - prev->imissed +
+		 stats.rx_nombuf - prev->rx_nombuf) / secs,
+		(stats.ierrors - prev->ierrors +
+		 stats.oerrors - prev->oerrors) / secs);
+
+	/* The queue counters are the stat registers, one per queue */
+	for (q = 0; q < mp->nb_queues; q++)
+		printf("%-6s%-8u%10.3f%10.1f%10.3f%10.1f%12.0f%12s\n",
+			"", q,
+			(stats.q_ipackets[q] - prev->q_ipackets[q]) /
+				secs / 1e6,
+			(stats.q_ibytes[q] - prev->q_ibytes[q]) * 8 /
+				secs / 1e6,
+			(stats.q_opackets[q] - prev->q_opackets[q]) /
+				secs / 1e6,
+			(stats.q_obytes[q] - prev->q_obytes[q]) * 8 /
+				secs / 1e6,
+			(stats.q_errors[q] - prev->q_errors[q]) / secs, "-");
+	*prev = stats;
+
+	if (mp->nb_xstats == 0 ||
+			rte_eth_xstats_get_by_id(mp->port_id, NULL,
+				mp->xstats, mp->nb_xstats) != mp->nb_xstats)
+		return;
+
+	/* Only the counters which moved, per second */
+	for (i = 0; i < mp->nb_xstats; i++)
+		if (mp->xstats[i] != mp->xstats_prev[i])
+			printf("      %s: %.0f/s\n", mp->xstats_names[i].name,
+				(mp->xstats[i] - mp->xstats_prev[i]) / secs);
+	tmp = mp->xstats_prev;
+	mp->xstats_prev = mp->xstats;
+	mp->xstats = tmp;
+}
+
+#ifdef RTE_LIBRTE_VHOST
+/*
+ * The vhost devices are served by the primary process, they are found by
+ * attaching to each device ID in turn, which maps the guest memory once.
+ */
+static void
+monitor_vhost_init(void)
+{
+	struct monitor_vhost_dev *md;
+	uint16_t i;
+	int vid, ret;
+
+	for (vid = 0; nb_monitor_vhost_devs < MAX_MONITOR_DEVS; vid++) {
+		ret = rte_vhost_mp_attach(vid);
+		/* Past the last device ID, or no vhost in the primary */
+		if (ret != 0 && ret != -ENODEV && ret != -ENOTSUP &&
+				ret != -EAGAIN)
+			break;
+		if (ret != 0) {
+			if (ret != -ENODEV)
+				printf("Cannot attach to vhost device %d: %s\n",
+					vid, strerror(-ret));
+			continue;
+		}
+
+		md = &monitor_vhost_devs[nb_monitor_vhost_devs];
+		md->vid = vid;
+		md->nr_vring = rte_vhost_get_vring_num(vid);
+		rte_vhost_get_ifname(vid, md->ifname, sizeof(md->ifname));
+		md->stats = calloc(md->nr_vring, sizeof(*md->stats));
+		if (md->stats == NULL) {
+			rte_vhost_mp_detach(vid);
+			continue;
+		}
+		for (i = 0; i < md->nr_vring; i++)
+			rte_vhost_vring_stats_get(vid, i, &md->stats[i]);
+		nb_monitor_vhost_devs++;
+	}
+}
+
+static void
+monitor_vdpa_init(void)
+{
+	struct rte_vdpa_device *vdev;
+	struct monitor_vdpa_dev *md;
+	uint32_t q;
+	int did;
+
+	for (did = rte_vdpa_find_next(0);
+			did >= 0 && nb_monitor_vdpa_devs < MAX_MONITOR_DEVS;
+			did = rte_vdpa_find_next(did + 1)) {
+		vdev = rte_vdpa_get_device(did);
+		md = &monitor_vdpa_devs[nb_monitor_vdpa_devs];
+		md->did = did;
+		md->nr_queue = 0;
+		if (vdev->ops->get_queue_num != NULL)
+			vdev->ops->get_queue_num(did, &md->nr_queue);
+		md->nr_queue *= 2;
+		md->stats = calloc(md->nr_queue, sizeof(*md->stats));
+		if (md->nr_queue == 0 || md->stats == NULL ||
+				rte_vdpa_get_stats(did, 0, &md->stats[0]) < 0) {
+			free(md->stats);
+			continue;
+		}
+		for (q = 1; q < md->nr_queue; q++)
+			rte_vdpa_get_stats(did, q, &md->stats[q]);
+		nb_monitor_vdpa_devs++;
+	}
+}
+
+static void
+monitor_vhost_display(double secs)
+{
+	struct rte_vhost_vring_stats stats, *prev;
+	struct rte_vdpa_stats vstats, *vprev;
+	uint32_t d, q;
+
+	for (d = 0; d < nb_monitor_vhost_devs; d++) {
+		struct monitor_vhost_dev *md = &monitor_vhost_devs[d];
+
+		if (md->vid < 0)
+			continue;
+		printf("vhost %d %s\n", md->vid, md->ifname);
+		for (q = 0; q < md->nr_vring; q++) {
+			/* Destroyed by the primary process, detached */
+			if (rte_vhost_vring_stats_get(md->vid, q,
+					&stats) < 0) {
+				printf("      device gone\n");
+				md->vid = -1;
+				break;
+			}
+			prev = &md->stats[q];
+			printf("      vring %-3u %-4s%10.3f%10.1f"
+				" empty %10.0f/s notify %10.0f/s\n",
+				q, q & 1 ? "deq" : "enq",
+				(stats.packets - prev->packets) / secs / 1e6,
+				(stats.bytes - prev->bytes) * 8 / secs / 1e6,
+				(stats.empty_polls - prev->empty_polls) / secs,
+				(stats.guest_notifications -
+				 prev->guest_notifications) / secs);
+			*prev = stats;
+		}
+	}
+
+	for (d = 0; d < nb_monitor_vdpa_devs; d++) {
+		struct monitor_vdpa_dev *md = &monitor_vdpa_devs[d];
+
+		printf("vdpa %d\n", md->did);
+		for (q = 0; q < md->nr_queue; q++) {
+			if (rte_vdpa_get_stats(md->did, q, &vstats) < 0)
+				continue;
+			vprev = &md->stats[q];
+			printf("      queue %-3u %10.3f%10.1f"
+				" errors %10.0f/s kicks %10.0f/s\n", q,
+				(vstats.packets - vprev->packets) / secs / 1e6,
+				(vstats.bytes - vprev->bytes) * 8 / secs / 1e6,
+				(vstats.errors - vprev->errors) / secs,
+				(vstats.kicks - vprev->kicks) / secs);
+			*vprev = vstats;
+		}
+	}
+}
+
+static void
+monitor_vhost_uninit(void)
+{
+	uint32_t d;
+
+	for (d = 0; d < nb_monitor_vhost_devs; d++) {
+		if (monitor_vhost_devs[d].vid >= 0)
+			rte_vhost_mp_detach(monitor_vhost_devs[d].vid);
+		free(monitor_vhost_devs[d].stats);
+	}
+	for (d = 0; d < nb_monitor_vdpa_devs; d++)
+		free(monitor_vdpa_devs[d].stats);
+}
+#endif
+
+static void
+monitor_run(void)
+{
+	uint64_t hz = rte_get_tsc_hz();
+	uint64_t prev_tsc, tsc;
+	uint32_t sample;
+	uint16_t i;
+	double secs;
+
+	RTE_ETH_FOREACH_DEV(i) {
+		if (!(enabled_port_mask & (1 << i)))
+			continue;
+		if (monitor_port_init(&monitor_ports[nb_monitor_ports], i))
+			goto out;
+		nb_monitor_ports++;
+	}
+#ifdef RTE_LIBRTE_VHOST
+	if (monitor_vhost) {
+		monitor_vhost_init();
+		monitor_vdpa_init();
+	}
+#endif
+
+	signal(SIGINT, monitor_signal_handler);
+	signal(SIGTERM, monitor_signal_handler);
+
+	prev_tsc = rte_rdtsc();
+	for (sample = 1; !monitor_quit &&
+			(monitor_count == 0 || sample <= monitor_count);
+			sample++) {
+		/* Sleeping, not to take a core from the primary process */
+		usleep(monitor_interval * 1000);
+		if (monitor_quit)
+			break;
+
+		tsc = rte_rdtsc();
+		secs = (double)(tsc - prev_tsc) / hz;
+		prev_tsc = tsc;
+
+		printf("\n##### sample %u, %.3f s #####\n", sample, secs);
+		printf("%-6s%-8s%10s%10s%10s%10s%12s%12s\n", "Port", "Queue",
+			"RX-Mpps", "RX-Mbps", "TX-Mpps", "TX-Mbps",
+			"Drop-pps", "Error-pps");
+		for (i = 0; i < nb_monitor_ports; i++)
+			monitor_port_display(&monitor_ports[i], secs);
+#ifdef RTE_LIBRTE_VHOST
+		monitor_vhost_display(secs);
+#endif
+		fflush(stdout);
+	}
+
+out:
+#ifdef RTE_LIBRTE_VHOST
+	monitor_vhost_uninit();
+#endif
+	for (i = 0; i < nb_monitor_ports; i++) {
+		free(monitor_ports[i].xstats_names);
+		free(monitor_ports[i].xstats);
+		free(monitor_ports[i].xstats_prev);
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -640,6 +1015,11 @@ main(int argc, char **argv)
 	if (enabled_port_mask == 0)
 		enabled_port_mask = 0xffff;
 
+	if (monitor_interval) {
+		monitor_run();
+		goto cleanup;
+	}
+
 	RTE_ETH_FOREACH_DEV(i) {
 		if (enabled_port_mask & (1 << i)) {
 			if (enable_stats)
@@ -664,6 +1044,7 @@ main(int argc, char **argv)
 	if (enable_metrics)
 		metrics_display(RTE_METRICS_GLOBAL);
 
+cleanup:
 	ret = rte_eal_cleanup();
 	if (ret)
 		printf("Error from rte_eal_cleanup(), %d\n", ret);
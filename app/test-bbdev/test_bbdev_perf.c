@@ -37,6 +37,11 @@ static struct test_bbdev_vector test_vector;
 /* Switch between PMD and Interrupt for throughput TC */
 static bool intr_enabled;
 
+/* Number of lcores used by the scaling TC step, 0 outside of scaling TC */
+static unsigned int scaling_lcores;
+/* Throughput of the scaling TC step, summed over the active devices */
+static double scaling_mbps;
+
 /* Represents tested active devices */
 static struct active_device {
 	const char *driver_name;
@@ -1081,7 +1086,7 @@ run_test_case_on_device(test_case_function *test_case_func, uint8_t dev_id,
 			ad->ops_mempool,
 			burst_sz,
 			get_num_ops(),
-			get_num_lcores());
+			scaling_lcores ? scaling_lcores : get_num_lcores());
 	if (f_ret != TEST_SUCCESS) {
 		printf("Couldn't init test op params");
 		goto fail;
@@ -1566,7 +1571,7 @@ throughput_pmd_lcore_enc(void *arg)
 
 	return TEST_SUCCESS;
 }
-static void
+static double
 print_throughput(struct thread_params *t_params, unsigned int used_cores)
 {
 	unsigned int lcore_id, iter = 0;
@@ -1583,6 +1588,8 @@ print_throughput(struct thread_params *t_params, unsigned int used_cores)
 	printf(
 		"\n\tTotal stats for %u cores: throughput: %.8lg MOPS, %.8lg Mbps\n",
 		used_cores, total_mops, total_mbps);
+
+	return total_mbps;
 }
 
 /*
@@ -1678,7 +1685,7 @@ throughput_test(struct active_device *ad,
 	/* Print throughput if interrupts are disabled and test passed */
 	if (!intr_enabled) {
 		if (test_vector.op_type != RTE_BBDEV_OP_NONE)
-			print_throughput(t_params, num_lcores);
+			scaling_mbps += print_throughput(t_params, num_lcores);
 		return ret;
 	}
 
@@ -2317,6 +2324,41 @@ throughput_tc(void)
 	return run_test_case(throughput_test);
 }
 
+/* Run the throughput test on 1 up to all the lcores, one queue per lcore,
+ * and report the speedup and efficiency over a single lcore.
+ */
+static int
+scaling_tc(void)
+{
+	unsigned int n, max_lcores = RTE_MIN(get_num_lcores(),
+			(unsigned int)MAX_QUEUES);
+	static double mbps[MAX_QUEUES];
+	double speedup;
+	int ret = TEST_SUCCESS;
+
+	for (n = 1; n <= max_lcores; n++) {
+		scaling_lcores = n;
+		scaling_mbps = 0;
+		ret = run_test_case(throughput_test);
+		if (ret != TEST_SUCCESS)
+			break;
+		mbps[n - 1] = scaling_mbps;
+	}
+	scaling_lcores = 0;
+
+	if (ret != TEST_SUCCESS)
+		return ret;
+
+	printf("\nScaling: lcores, throughput (Mbps), speedup, efficiency\n");
+	for (n = 1; n <= max_lcores; n++) {
+		speedup = mbps[0] > 0 ? mbps[n - 1] / mbps[0] : 0;
+		printf("\t%u\t%.8lg\t%.3lf\t%.1lf%%\n", n, mbps[n - 1],
+				speedup, speedup * 100 / n);
+	}
+
+	return TEST_SUCCESS;
+}
+
 static int
 offload_cost_tc(void)
 {
@@ -2351,6 +2393,16 @@ static struct unit_test_suite bbdev_throughput_testsuite = {
 	}
 };
 
+static struct unit_test_suite bbdev_scaling_testsuite = {
+	.suite_name = "BBdev Scaling Tests",
+	.setup = testsuite_setup,
+	.teardown = testsuite_teardown,
+	.unit_test_cases = {
+		TEST_CASE_ST(ut_setup, ut_teardown, scaling_tc),
+		TEST_CASES_END() /**< NULL terminate unit test array */
+	}
+};
+
 static struct unit_test_suite bbdev_validation_testsuite = {
 	.suite_name = "BBdev Validation Tests",
 	.setup = testsuite_setup,
@@ -2393,6 +2445,7 @@ static struct unit_test_suite bbdev_interrupt_testsuite = {
 };
 
 REGISTER_TEST_COMMAND(throughput, bbdev_throughput_testsuite);
+REGISTER_TEST_COMMAND(scaling, bbdev_scaling_testsuite);
 REGISTER_TEST_COMMAND(validation, bbdev_validation_testsuite);
 REGISTER_TEST_COMMAND(latency, bbdev_latency_testsuite);
 REGISTER_TEST_COMMAND(offload, bbdev_offload_cost_testsuite);
@@ -46,6 +46,8 @@
 
 #define CPERF_CSV		("csv-friendly")
 
+#define CPERF_VHOST_LOOPBACK	("vhost-loopback")
+
 /* benchmark-specific options */
 #define CPERF_PMDCC_DELAY_MS	("pmd-cyclecount-delay-ms")
 
@@ -111,6 +113,8 @@ struct cperf_options {
 	uint16_t digest_sz;
 
 	char device_type[RTE_CRYPTODEV_NAME_MAX_LEN];
+	/* host device of the vhost-crypto loopback, empty if disabled */
+	char vhost_loopback_dev[RTE_CRYPTODEV_NAME_MAX_LEN];
 	enum cperf_op_type op_type;
 
 	char *test_file;
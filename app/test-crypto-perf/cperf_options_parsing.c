@@ -56,6 +56,8 @@ usage(char *progname)
 		" --pmd-cyclecount-delay-ms N: set delay between enqueue\n"
 		"           and dequeue in pmd-cyclecount benchmarking mode\n"
 		" --csv-friendly: enable test result output CSV friendly\n"
+		" --vhost-loopback TYPE: run the test on virtio-user, served\n"
+		"           by vhost-crypto on a TYPE device in this process\n"
 		" -h: prints this help\n",
 		progname);
 }
@@ -419,6 +421,27 @@ parse_device_type(struct cperf_options *opts, const char *arg)
 	return 0;
 }
 
+static int
+parse_vhost_loopback(struct cperf_options *opts, const char *arg)
+{
+#ifdef RTE_LIBRTE_VHOST
+	if (strlen(arg) > (sizeof(opts->vhost_loopback_dev) - 1))
+		return -1;
+
+	strncpy(opts->vhost_loopback_dev, arg,
+			sizeof(opts->vhost_loopback_dev) - 1);
+	*(opts->vhost_loopback_dev + sizeof(opts->vhost_loopback_dev) - 1) =
+			'\0';
+
+	return 0;
+#else
+	RTE_SET_USED(opts);
+	RTE_SET_USED(arg);
+	RTE_LOG(ERR, USER1, "vhost loopback needs the vhost library\n");
+	return -1;
+#endif
+}
+
 static int
 parse_op_type(struct cperf_options *opts, const char *arg)
 {
@@ -760,6 +783,8 @@ static struct option lgopts[] = {
 
 	{ CPERF_PMDCC_DELAY_MS, required_argument, 0, 0 },
 
+	{ CPERF_VHOST_LOOPBACK, required_argument, 0, 0 },
+
 	{ NULL, 0, 0, 0 }
 };
 
@@ -859,6 +884,7 @@ cperf_opts_parse_long(int opt_idx, struct cperf_options *opts)
 		{ CPERF_DIGEST_SZ,	parse_digest_sz },
 		{ CPERF_CSV,		parse_csv_friendly},
 		{ CPERF_PMDCC_DELAY_MS,	parse_pmd_cyclecount_delay_ms},
+		{ CPERF_VHOST_LOOPBACK,	parse_vhost_loopback },
 	};
 	unsigned int i;
 
@@ -1071,6 +1097,11 @@ cperf_options_check(struct cperf_options *options)
 			return -EINVAL;
 	}
 
+	/* the test runs on the virtio-user end of the loopback */
+	if (options->vhost_loopback_dev[0] != '\0')
+		snprintf(options->device_type, sizeof(options->device_type),
+				"crypto_virtio_user");
+
 	return 0;
 }
 
@@ -1110,6 +1141,9 @@ cperf_options_dump(struct cperf_options *opts)
 	printf("\n# segment size: %u\n", opts->segment_sz);
 	printf("#\n");
 	printf("# cryptodev type: %s\n", opts->device_type);
+	if (opts->vhost_loopback_dev[0] != '\0')
+		printf("# vhost loopback host device type: %s\n",
+				opts->vhost_loopback_dev);
 	printf("#\n");
 	printf("# number of queue pairs per device: %u\n", opts->nb_qps);
 	printf("# crypto operation: %s\n", cperf_op_type_strs[opts->op_type]);
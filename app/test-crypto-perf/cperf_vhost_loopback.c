@@ -0,0 +1,471 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2018 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <limits.h>
+
+#include <rte_cycles.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_mempool.h>
+#include <rte_cryptodev.h>
+#include <rte_bus_vdev.h>
+#include <rte_vhost.h>
+#include <rte_vhost_crypto.h>
+
+#include "cperf_vhost_loopback.h"
+
+#define CPERF_VHOST_VDEV_NAME		"crypto_virtio_user0"
+#define CPERF_VHOST_MAX_QUEUES		8U
+#define CPERF_VHOST_MAX_BURST		64U
+#define CPERF_VHOST_SESSIONS		1024
+#define CPERF_VHOST_OP_CACHE		128
+#define CPERF_VHOST_ATTACH_WAIT_MS	1000
+/* room for the IV vhost-crypto writes right after the symmetric op */
+#define CPERF_VHOST_OP_PRIV_SZ		16
+
+struct cperf_vhost_stage {
+	uint64_t cycles;
+	uint64_t bursts;
+	uint64_t ops;
+};
+
+enum cperf_vhost_stage_id {
+	CPERF_VHOST_PARSE,	/* rte_vhost_crypto_fetch_requests() */
+	CPERF_VHOST_SUBMIT,	/* rte_cryptodev_enqueue_burst() */
+	CPERF_VHOST_COMPLETE,	/* dequeue and finalize_requests() */
+	CPERF_VHOST_NB_STAGES
+};
+
+static const char * const cperf_vhost_stage_strs[] = {
+	[CPERF_VHOST_PARSE] = "parse",
+	[CPERF_VHOST_SUBMIT] = "submit",
+	[CPERF_VHOST_COMPLETE] = "complete"
+};
+
+static struct {
+	int initialized;
+	int vdev_created;
+	int registered;
+	int cdev_started;
+	unsigned int lcore_id;
+	uint8_t cdev_id;
+	uint32_t nb_descriptors;
+	struct rte_mempool *sess_pool;
+	struct rte_mempool *cop_pool;
+	char path[PATH_MAX];
+
+	/* set by the vhost-user thread, read by the host lcore */
+	volatile int vid;
+	volatile uint16_t nb_queues;
+	volatile int quit;
+
+	struct cperf_vhost_stage stages[CPERF_VHOST_NB_STAGES];
+	uint64_t tsc_round_start;
+} loopback = {
+	.vid = -1,
+};
+
+static inline void
+cperf_vhost_stage_add(enum cperf_vhost_stage_id id, uint64_t cycles,
+		uint16_t nb_ops)
+{
+	struct cperf_vhost_stage *stage = &loopback.stages[id];
+
+	stage->cycles += cycles;
+	stage->bursts++;
+	stage->ops += nb_ops;
+}
+
+static int
+cperf_vhost_new_device(int vid)
+{
+	uint16_t nb_queues;
+	int ret;
+
+	ret = rte_vhost_crypto_create(vid, loopback.cdev_id,
+			loopback.sess_pool,
+			rte_cryptodev_socket_id(loopback.cdev_id));
+	if (ret) {
+		RTE_LOG(ERR, USER1, "Cannot create vhost crypto\n");
+		return ret;
+	}
+
+	nb_queues = rte_vhost_get_vring_num(vid);
+	if (nb_queues > CPERF_VHOST_MAX_QUEUES) {
+		rte_vhost_crypto_free(vid);
+		return -EINVAL;
+	}
+
+	loopback.nb_queues = nb_queues;
+	rte_wmb();
+	loopback.vid = vid;
+
+	return 0;
+}
+
+/*
+ * The backend goes away when the virtio-user device is stopped, which
+ * main() only does once cperf_vhost_loopback_stop() parked the host lcore.
+ */
+static void
+cperf_vhost_destroy_device(int vid)
+{
+	loopback.vid = -1;
+	rte_wmb();
+
+	rte_vhost_crypto_free(vid);
+}
+
+static const struct vhost_device_ops cperf_vhost_device_ops = {
+	.new_device = cperf_vhost_new_device,
+	.destroy_device = cperf_vhost_destroy_device,
+};
+
+static int
+cperf_vhost_host_worker(void *arg __rte_unused)
+{
+	struct rte_crypto_op *ops[CPERF_VHOST_MAX_BURST];
+	struct rte_crypto_op *ops_deq[CPERF_VHOST_MAX_BURST];
+	int callfds[CPERF_VHOST_MAX_QUEUES];
+	uint32_t nb_inflight = 0;
+	uint16_t nb_callfds;
+	uint16_t fetched, enqd, deqd, q;
+	uint64_t tsc_start, tsc_end;
+	int vid;
+
+	if (rte_crypto_op_bulk_alloc(loopback.cop_pool,
+			RTE_CRYPTO_OP_TYPE_SYMMETRIC, ops,
+			CPERF_VHOST_MAX_BURST) < CPERF_VHOST_MAX_BURST) {
+		RTE_LOG(ERR, USER1, "Failed to alloc host crypto ops\n");
+		return -ENOMEM;
+	}
+
+	while (!loopback.quit) {
+		vid = loopback.vid;
+		if (vid < 0) {
+			rte_pause();
+			continue;
+		}
+		rte_rmb();
+
+		for (q = 0; q < loopback.nb_queues; q++) {
+			fetched = RTE_MIN(CPERF_VHOST_MAX_BURST,
+					loopback.nb_descriptors - nb_inflight);
+
+			/* only bursts that moved requests are accounted, an
+			 * idle poll tells nothing about the cost of a stage
+			 */
+			tsc_start = rte_rdtsc();
+			fetched = rte_vhost_crypto_fetch_requests(vid, q, ops,
+					fetched);
+			tsc_end = rte_rdtsc();
+			if (fetched) {
+				cperf_vhost_stage_add(CPERF_VHOST_PARSE,
+						tsc_end - tsc_start, fetched);
+
+				tsc_start = tsc_end;
+				enqd = 0;
+				while (enqd < fetched)
+					enqd += rte_cryptodev_enqueue_burst(
+							loopback.cdev_id, 0,
+							ops + enqd,
+							fetched - enqd);
+				tsc_end = rte_rdtsc();
+				cperf_vhost_stage_add(CPERF_VHOST_SUBMIT,
+						tsc_end - tsc_start, fetched);
+
+				nb_inflight += fetched;
+				while (rte_crypto_op_bulk_alloc(
+						loopback.cop_pool,
+						RTE_CRYPTO_OP_TYPE_SYMMETRIC,
+						ops, fetched) < fetched)
+					rte_pause();
+			}
+
+			if (nb_inflight == 0)
+				continue;
+
+			tsc_start = rte_rdtsc();
+			deqd = rte_cryptodev_dequeue_burst(loopback.cdev_id, 0,
+					ops_deq, CPERF_VHOST_MAX_BURST);
+			if (deqd == 0)
+				continue;
+			deqd = rte_vhost_crypto_finalize_requests(ops_deq,
+					deqd, callfds, &nb_callfds);
+			tsc_end = rte_rdtsc();
+			cperf_vhost_stage_add(CPERF_VHOST_COMPLETE,
+					tsc_end - tsc_start, deqd);
+
+			/* the virtio-user driver polls, callfds are unused */
+			nb_inflight -= deqd;
+			rte_mempool_put_bulk(loopback.cop_pool,
+					(void **)ops_deq, deqd);
+		}
+	}
+
+	rte_mempool_put_bulk(loopback.cop_pool, (void **)ops,
+			CPERF_VHOST_MAX_BURST);
+
+	return 0;
+}
+
+static int
+cperf_vhost_host_cdev_init(struct cperf_options *opts)
+{
+	struct rte_cryptodev_config conf;
+	struct rte_cryptodev_qp_conf qp_conf = {
+		.nb_descriptors = opts->nb_descriptors
+	};
+	uint32_t sess_size;
+	int socket_id;
+	int ret;
+
+	if (rte_cryptodev_devices_get(opts->vhost_loopback_dev,
+			&loopback.cdev_id, 1) == 0) {
+		RTE_LOG(ERR, USER1, "No crypto devices type %s available\n",
+				opts->vhost_loopback_dev);
+		return -EINVAL;
+	}
+
+	socket_id = rte_cryptodev_socket_id(loopback.cdev_id);
+	conf.nb_queue_pairs = 1;
+	conf.socket_id = socket_id;
+	loopback.nb_descriptors = opts->nb_descriptors;
+
+	sess_size = RTE_MAX(rte_cryptodev_sym_get_header_session_size(),
+			rte_cryptodev_sym_get_private_session_size(
+				loopback.cdev_id));
+	loopback.sess_pool = rte_mempool_create("vhost_sess_mp",
+			CPERF_VHOST_SESSIONS, sess_size, 0, 0,
+			NULL, NULL, NULL, NULL, socket_id, 0);
+	if (loopback.sess_pool == NULL) {
+		RTE_LOG(ERR, USER1, "Cannot create vhost session pool\n");
+		return -ENOMEM;
+	}
+
+	loopback.cop_pool = rte_crypto_op_pool_create("vhost_cop_mp",
+			RTE_CRYPTO_OP_TYPE_SYMMETRIC,
+			opts->nb_descriptors + 2 * CPERF_VHOST_MAX_BURST +
+			CPERF_VHOST_OP_CACHE * rte_lcore_count(),
+			CPERF_VHOST_OP_CACHE, CPERF_VHOST_OP_PRIV_SZ,
+			socket_id);
+	if (loopback.cop_pool == NULL) {
+		RTE_LOG(ERR, USER1, "Cannot create vhost crypto op pool\n");
+		return -ENOMEM;
+	}
+
+	ret = rte_cryptodev_configure(loopback.cdev_id, &conf);
+	if (ret < 0) {
+		RTE_LOG(ERR, USER1, "Failed to configure cryptodev %u\n",
+				loopback.cdev_id);
+		return -EINVAL;
+	}
+
+	ret = rte_cryptodev_queue_pair_setup(loopback.cdev_id, 0, &qp_conf,
+			socket_id, loopback.sess_pool);
+	if (ret < 0) {
+		RTE_LOG(ERR, USER1, "Failed to setup queue pair on "
+				"cryptodev %u\n", loopback.cdev_id);
+		return -EINVAL;
+	}
+
+	ret = rte_cryptodev_start(loopback.cdev_id);
+	if (ret < 0) {
+		RTE_LOG(ERR, USER1, "Failed to start device %u: error %d\n",
+				loopback.cdev_id, ret);
+		return -EPERM;
+	}
+	loopback.cdev_started = 1;
+
+	return 0;
+}
+
+int
+cperf_vhost_loopback_init(struct cperf_options *opts)
+{
+	char args[PATH_MAX + 64];
+	unsigned int lcore_id;
+	uint32_t nb_queues;
+	int ret;
+
+	/* the host takes the last slave lcore, the test the others */
+	loopback.lcore_id = RTE_MAX_LCORE;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+		loopback.lcore_id = lcore_id;
+	if (rte_lcore_count() < 3) {
+		RTE_LOG(ERR, USER1, "vhost loopback needs at least 3 lcores\n");
+		return -EINVAL;
+	}
+	nb_queues = RTE_MIN(rte_lcore_count() - 2, CPERF_VHOST_MAX_QUEUES);
+
+	ret = cperf_vhost_host_cdev_init(opts);
+	if (ret < 0)
+		return ret;
+
+	snprintf(loopback.path, sizeof(loopback.path),
+			"/tmp/cperf-vhost-crypto-%d.sock", getpid());
+	unlink(loopback.path);
+
+	if (rte_vhost_driver_register(loopback.path, 0) < 0) {
+		RTE_LOG(ERR, USER1, "Cannot register %s\n", loopback.path);
+		return -EINVAL;
+	}
+	loopback.registered = 1;
+
+	if (rte_vhost_driver_callback_register(loopback.path,
+			&cperf_vhost_device_ops) < 0 ||
+			rte_vhost_driver_start(loopback.path) < 0) {
+		RTE_LOG(ERR, USER1, "Cannot start vhost-user on %s\n",
+				loopback.path);
+		return -EINVAL;
+	}
+
+	ret = rte_eal_remote_launch(cperf_vhost_host_worker, NULL,
+			loopback.lcore_id);
+	if (ret < 0) {
+		RTE_LOG(ERR, USER1, "Cannot launch host lcore %u\n",
+				loopback.lcore_id);
+		return ret;
+	}
+	loopback.initialized = 1;
+
+	snprintf(args, sizeof(args), "path=%s,queues=%u,queue_size=%u",
+			loopback.path, nb_queues,
+			rte_align32pow2(opts->nb_descriptors));
+	ret = rte_vdev_init(CPERF_VHOST_VDEV_NAME, args);
+	if (ret < 0) {
+		RTE_LOG(ERR, USER1, "Cannot create %s\n",
+				CPERF_VHOST_VDEV_NAME);
+		return ret;
+	}
+	loopback.vdev_created = 1;
+
+	return 0;
+}
+
+int
+cperf_vhost_loopback_attach(void)
+{
+	unsigned int i;
+
+	if (!loopback.initialized)
+		return 0;
+
+	/* the backend attaches from the vhost-user thread once the started
+	 * device set up its vrings, sessions cannot be created before that
+	 */
+	for (i = 0; loopback.vid < 0 && i < CPERF_VHOST_ATTACH_WAIT_MS; i++)
+		rte_delay_ms(1);
+	if (loopback.vid < 0) {
+		RTE_LOG(ERR, USER1, "vhost-crypto backend did not attach\n");
+		return -ENODEV;
+	}
+
+	loopback.tsc_round_start = rte_rdtsc_precise();
+
+	return 0;
+}
+
+void
+cperf_vhost_loopback_report(const struct cperf_options *opts)
+{
+	static int only_once;
+	uint64_t tsc_hz = rte_get_tsc_hz();
+	uint64_t tsc_now = rte_rdtsc_precise();
+	uint64_t busy = 0;
+	unsigned int i;
+
+	if (!loopback.initialized)
+		return;
+
+	if (!opts->csv) {
+		if (!only_once)
+			printf("\n%12s%12s%12s%12s%12s%12s%12s\n\n",
+				"Host lcore", "Buf Size", "Stage", "Ops",
+				"Cycles/Brst", "Cycles/Op", "MOps");
+	} else {
+		if (!only_once)
+			printf("\n#Host lcore,Buffer Size(B),Stage,Ops,"
+				"Cycles/Burst,Cycles/Op,Ops(Millions)\n\n");
+	}
+	only_once = 1;
+
+	for (i = 0; i < CPERF_VHOST_NB_STAGES; i++) {
+		struct cperf_vhost_stage *stage = &loopback.stages[i];
+		double per_burst = stage->bursts ?
+			(double)stage->cycles / stage->bursts : 0;
+		double per_op = stage->ops ?
+			(double)stage->cycles / stage->ops : 0;
+		/* what one lcore would sustain doing nothing but this stage */
+		double mops = stage->cycles ? ((double)stage->ops /
+			stage->cycles) * tsc_hz / 1000000 : 0;
+
+		busy += stage->cycles;
+
+		if (!opts->csv)
+			printf("%12u%12u%12s%12"PRIu64"%12.2f%12.2f%12.4f\n",
+				loopback.lcore_id, opts->test_buffer_size,
+				cperf_vhost_stage_strs[i], stage->ops,
+				per_burst, per_op, mops);
+		else
+			printf("%u;%u;%s;%"PRIu64";%.3f;%.3f;%.3f\n",
+				loopback.lcore_id, opts->test_buffer_size,
+				cperf_vhost_stage_strs[i], stage->ops,
+				per_burst, per_op, mops);
+	}
+
+	if (!opts->csv)
+		printf("%12s%12s%12s%11.2f%%\n", "", "", "busy",
+			tsc_now > loopback.tsc_round_start ? 100.0 * busy /
+			(tsc_now - loopback.tsc_round_start) : 0);
+	else
+		printf("%u;%u;busy;%.3f\n", loopback.lcore_id,
+			opts->test_buffer_size,
+			tsc_now > loopback.tsc_round_start ? 100.0 * busy /
+			(tsc_now - loopback.tsc_round_start) : 0);
+
+	/* all requests of the round have completed, the host is idle */
+	memset(loopback.stages, 0, sizeof(loopback.stages));
+	loopback.tsc_round_start = rte_rdtsc_precise();
+}
+
+void
+cperf_vhost_loopback_stop(void)
+{
+	if (!loopback.initialized || loopback.quit)
+		return;
+
+	loopback.quit = 1;
+	rte_eal_wait_lcore(loopback.lcore_id);
+}
+
+void
+cperf_vhost_loopback_free(void)
+{
+	cperf_vhost_loopback_stop();
+
+	if (loopback.vdev_created)
+		rte_vdev_uninit(CPERF_VHOST_VDEV_NAME);
+	loopback.vdev_created = 0;
+
+	if (loopback.registered) {
+		rte_vhost_driver_unregister(loopback.path);
+		unlink(loopback.path);
+	}
+	loopback.registered = 0;
+
+	if (loopback.cdev_started)
+		rte_cryptodev_stop(loopback.cdev_id);
+	loopback.cdev_started = 0;
+
+	rte_mempool_free(loopback.cop_pool);
+	loopback.cop_pool = NULL;
+	rte_mempool_free(loopback.sess_pool);
+	loopback.sess_pool = NULL;
+	loopback.initialized = 0;
+}
@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2018 Intel Corporation
+ */
+
+#ifndef _CPERF_VHOST_LOOPBACK_
+#define _CPERF_VHOST_LOOPBACK_
+
+#include "cperf_options.h"
+
+/*
+ * Loopback mode: the vhost-crypto host processing runs on the last slave
+ * lcore, serving a crypto_virtio_user device created in the same process.
+ * The test then runs on crypto_virtio_user as on any other device type.
+ */
+
+int
+cperf_vhost_loopback_init(struct cperf_options *opts);
+
+int
+cperf_vhost_loopback_attach(void);
+
+void
+cperf_vhost_loopback_report(const struct cperf_options *opts);
+
+void
+cperf_vhost_loopback_stop(void);
+
+void
+cperf_vhost_loopback_free(void);
+
+#endif /* _CPERF_VHOST_LOOPBACK_ */
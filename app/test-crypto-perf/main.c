@@ -20,6 +20,9 @@
 #include "cperf_test_latency.h"
 #include "cperf_test_verify.h"
 #include "cperf_test_pmd_cyclecount.h"
+#ifdef RTE_LIBRTE_VHOST
+#include "cperf_vhost_loopback.h"
+#endif
 
 
 const char *cperf_test_type_strs[] = {
@@ -78,6 +81,9 @@ cperf_initialize_cryptodev(struct cperf_options *opts, uint8_t *enabled_cdevs,
 	}
 
 	nb_lcores = rte_lcore_count() - 1;
+	/* the vhost-crypto host of the loopback has its own lcore */
+	if (opts->vhost_loopback_dev[0] != '\0')
+		nb_lcores--;
 
 	if (nb_lcores < 1) {
 		RTE_LOG(ERR, USER1,
@@ -445,6 +451,46 @@ cperf_check_test_vector(struct cperf_options *opts,
 	return 0;
 }
 
+#ifdef RTE_LIBRTE_PMD_CRYPTO_SCHEDULER
+/*
+ * Print how the load-aware scheduler spread the last run across its
+ * slaves, to compare heterogeneous slaves.
+ */
+static void
+cperf_scheduler_report(struct cperf_options *opts, uint8_t *enabled_cdevs,
+		uint8_t nb_cryptodevs)
+{
+	struct rte_cryptodev_scheduler_load_option load;
+	uint8_t i;
+	uint32_t j;
+
+	if (opts->silent || strcmp(opts->device_type, "crypto_scheduler"))
+		return;
+
+	for (i = 0; i < nb_cryptodevs; i++) {
+		if (rte_cryptodev_scheduler_mode_get(enabled_cdevs[i]) !=
+				CDEV_SCHED_MODE_LOAD_AWARE)
+			continue;
+		if (rte_cryptodev_scheduler_option_get(enabled_cdevs[i],
+				CDEV_SCHED_OPTION_LOAD, &load) < 0)
+			continue;
+
+		printf("\n# Scheduler %u load, buffer size %u\n",
+				enabled_cdevs[i], opts->test_buffer_size);
+		printf("# %8s%16s%16s%12s%12s\n", "Slave", "Enqueued",
+				"Dequeued", "Queue full", "Cycles/op");
+		for (j = 0; j < load.nb_slaves; j++)
+			printf("  %8u%16"PRIu64"%16"PRIu64"%12"PRIu64
+					"%12"PRIu64"\n",
+					load.slaves[j].dev_id,
+					load.slaves[j].enqueued_count,
+					load.slaves[j].dequeued_count,
+					load.slaves[j].enqueue_full_count,
+					load.slaves[j].op_cycles);
+	}
+}
+#endif
+
 int
 main(int argc, char **argv)
 {
@@ -487,6 +533,16 @@ main(int argc, char **argv)
 		goto err;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	if (opts.vhost_loopback_dev[0] != '\0') {
+		ret = cperf_vhost_loopback_init(&opts);
+		if (ret) {
+			RTE_LOG(ERR, USER1, "Failed to set up vhost loopback\n");
+			goto err;
+		}
+	}
+#endif
+
 	nb_cryptodevs = cperf_initialize_cryptodev(&opts, enabled_cdevs,
 			session_pool_socket);
 
@@ -500,6 +556,11 @@ main(int argc, char **argv)
 		goto err;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	if (cperf_vhost_loopback_attach() < 0)
+		goto err;
+#endif
+
 	ret = cperf_verify_devices_capabilities(&opts, enabled_cdevs,
 			nb_cryptodevs);
 	if (ret) {
@@ -625,6 +686,12 @@ main(int argc, char **argv)
 			rte_eal_wait_lcore(lcore_id);
 			i++;
 		}
+#ifdef RTE_LIBRTE_VHOST
+		cperf_vhost_loopback_report(&opts);
+#endif
+#ifdef RTE_LIBRTE_PMD_CRYPTO_SCHEDULER
+		cperf_scheduler_report(&opts, enabled_cdevs, nb_cryptodevs);
+#endif
 	} else {
 
 		/* Get next size from range or list */
@@ -652,6 +719,13 @@ main(int argc, char **argv)
 				rte_eal_wait_lcore(lcore_id);
 				i++;
 			}
+#ifdef RTE_LIBRTE_VHOST
+			cperf_vhost_loopback_report(&opts);
+#endif
+#ifdef RTE_LIBRTE_PMD_CRYPTO_SCHEDULER
+			cperf_scheduler_report(&opts, enabled_cdevs,
+					nb_cryptodevs);
+#endif
 
 			/* Get next size from range or list */
 			if (opts.inc_buffer_size != 0)
@@ -675,9 +749,16 @@ main(int argc, char **argv)
 		i++;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	/* park the host before its virtio-user device goes away */
+	cperf_vhost_loopback_stop();
+#endif
 	for (i = 0; i < nb_cryptodevs &&
 			i < RTE_CRYPTO_MAX_DEVS; i++)
 		rte_cryptodev_stop(enabled_cdevs[i]);
+#ifdef RTE_LIBRTE_VHOST
+	cperf_vhost_loopback_free();
+#endif
 
 	free_test_vector(t_vec, &opts);
 
@@ -695,9 +776,15 @@ main(int argc, char **argv)
 		i++;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	cperf_vhost_loopback_stop();
+#endif
 	for (i = 0; i < nb_cryptodevs &&
 			i < RTE_CRYPTO_MAX_DEVS; i++)
 		rte_cryptodev_stop(enabled_cdevs[i]);
+#ifdef RTE_LIBRTE_VHOST
+	cperf_vhost_loopback_free();
+#endif
 	rte_free(opts.imix_buffer_sizes);
 	free_test_vector(t_vec, &opts);
 
@@ -13,6 +13,7 @@
 
 #include "evt_options.h"
 #include "evt_test.h"
+#include "evt_vhost.h"
 
 struct evt_options opt;
 struct evt_test *test;
@@ -41,6 +42,8 @@ signal_handler(int signum)
 			if (test->ops.test_result)
 				test->ops.test_result(test, &opt);
 
+			evt_vhost_result(&opt);
+
 			if (opt.prod_type == EVT_PROD_TYPE_ETH_RX_ADPTR) {
 				RTE_ETH_FOREACH_DEV(i)
 					rte_eth_dev_close(i);
@@ -99,6 +102,14 @@ main(int argc, char **argv)
 		goto error;
 	}
 
+	/* The tests look for the vhost ports when checking the options */
+	if (opt.nb_vhost) {
+		if (evt_vhost_create(&opt)) {
+			evt_err("failed to create the vhost ports");
+			goto error;
+		}
+	}
+
 	/* Get struct evt_test *test from name */
 	test = evt_test_get(opt.test_name);
 	if (test == NULL) {
@@ -171,6 +182,14 @@ main(int argc, char **argv)
 		}
 	}
 
+	/* Feed the vhost ports, the tests then launch their lcores */
+	if (opt.nb_vhost) {
+		if (evt_vhost_launch(&opt, evt_test_priv(test))) {
+			evt_err("failed to launch the virtio-user ports");
+			goto eventdev_destroy;
+		}
+	}
+
 	/* Launch lcores */
 	if (test->ops.launch_lcores) {
 		if (test->ops.launch_lcores(test, &opt)) {
@@ -183,6 +202,7 @@ main(int argc, char **argv)
 
 	/* Print the test result */
 	ret = test->ops.test_result(test, &opt);
+	evt_vhost_result(&opt);
 nocap:
 	if (ret == EVT_TEST_SUCCESS) {
 		printf("Result: "CLGRN"%s"CLNRM"\n", "Success");
@@ -107,6 +107,34 @@ evt_parse_timer_prod_type_burst(struct evt_options *opt,
 	return 0;
 }
 
+static int
+evt_parse_vhost_prod_type(struct evt_options *opt,
+		const char *arg __rte_unused)
+{
+	opt->prod_type = EVT_PROD_TYPE_ETH_RX_ADPTR;
+	if (!opt->nb_vhost)
+		opt->nb_vhost = 1;
+	return 0;
+}
+
+static int
+evt_parse_nb_vhost(struct evt_options *opt, const char *arg)
+{
+	int ret;
+
+	ret = parser_read_uint8(&(opt->nb_vhost), arg);
+	if (!ret && !opt->nb_vhost)
+		ret = -EINVAL;
+	opt->prod_type = EVT_PROD_TYPE_ETH_RX_ADPTR;
+	return ret;
+}
+
+static int
+evt_parse_pkt_seed(struct evt_options *opt, const char *arg)
+{
+	return parser_read_uint64(&(opt->pkt_seed), arg);
+}
+
 static int
 evt_parse_test_name(struct evt_options *opt, const char *arg)
 {
@@ -246,6 +274,10 @@ usage(char *program)
 		"\t                     in ns.\n"
 		"\t--prod_type_timerdev_burst : use timer device as producer\n"
 		"\t                             burst mode.\n"
+		"\t--prod_type_vhost   : use vhost ports as producer, fed by\n"
+		"\t                     virtio-user ports on the plcores.\n"
+		"\t--nb_vhost         : number of vhost ports, default 1.\n"
+		"\t--pkt_seed         : seed of the virtio-user packet mix.\n"
 		"\t--nb_timers        : number of timers to arm.\n"
 		"\t--nb_timer_adptrs  : number of timer adapters to use.\n"
 		"\t--timer_tick_nsec  : timer tick interval in ns.\n"
@@ -314,6 +346,9 @@ static struct option lgopts[] = {
 	{ EVT_PROD_ETHDEV,         0, 0, 0 },
 	{ EVT_PROD_TIMERDEV,       0, 0, 0 },
 	{ EVT_PROD_TIMERDEV_BURST, 0, 0, 0 },
+	{ EVT_PROD_VHOST,          0, 0, 0 },
+	{ EVT_NB_VHOST,            1, 0, 0 },
+	{ EVT_PKT_SEED,            1, 0, 0 },
 	{ EVT_NB_TIMERS,           1, 0, 0 },
 	{ EVT_NB_TIMER_ADPTRS,     1, 0, 0 },
 	{ EVT_TIMER_TICK_NSEC,     1, 0, 0 },
@@ -345,6 +380,9 @@ evt_opts_parse_long(int opt_idx, struct evt_options *opt)
 		{ EVT_PROD_ETHDEV, evt_parse_eth_prod_type},
 		{ EVT_PROD_TIMERDEV, evt_parse_timer_prod_type},
 		{ EVT_PROD_TIMERDEV_BURST, evt_parse_timer_prod_type_burst},
+		{ EVT_PROD_VHOST, evt_parse_vhost_prod_type},
+		{ EVT_NB_VHOST, evt_parse_nb_vhost},
+		{ EVT_PKT_SEED, evt_parse_pkt_seed},
 		{ EVT_NB_TIMERS, evt_parse_nb_timers},
 		{ EVT_NB_TIMER_ADPTRS, evt_parse_nb_timer_adptrs},
 		{ EVT_TIMER_TICK_NSEC, evt_parse_timer_tick_nsec},
@@ -34,6 +34,9 @@
 #define EVT_PROD_ETHDEV          ("prod_type_ethdev")
 #define EVT_PROD_TIMERDEV        ("prod_type_timerdev")
 #define EVT_PROD_TIMERDEV_BURST  ("prod_type_timerdev_burst")
+#define EVT_PROD_VHOST           ("prod_type_vhost")
+#define EVT_NB_VHOST             ("nb_vhost")
+#define EVT_PKT_SEED             ("pkt_seed")
 #define EVT_NB_TIMERS            ("nb_timers")
 #define EVT_NB_TIMER_ADPTRS      ("nb_timer_adptrs")
 #define EVT_TIMER_TICK_NSEC      ("timer_tick_nsec")
@@ -74,6 +77,8 @@ struct evt_options {
 	enum evt_prod_type prod_type;
 	uint8_t timdev_use_burst;
 	uint8_t timdev_cnt;
+	uint8_t nb_vhost;
+	uint64_t pkt_seed;
 };
 
 void evt_options_default(struct evt_options *opt);
@@ -280,6 +285,12 @@ evt_dump_producer_type(struct evt_options *opt)
 		snprintf(name, EVT_PROD_MAX_NAME_LEN,
 				"Ethdev Rx Adapter producers");
 		evt_dump("nb_ethdev", "%d", rte_eth_dev_count_avail());
+		if (opt->nb_vhost) {
+			snprintf(name, EVT_PROD_MAX_NAME_LEN,
+				"vhost Rx Adapter producers");
+			evt_dump_producer_lcores(opt);
+			evt_dump("pkt_seed", "%"PRIu64, opt->pkt_seed);
+		}
 		break;
 	case EVT_PROD_TYPE_EVENT_TIMER_ADPTR:
 		if (opt->timdev_use_burst)
@@ -0,0 +1,417 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_byteorder.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_bus_vdev.h>
+#include <rte_event_eth_rx_adapter.h>
+#include <rte_event_eth_tx_adapter.h>
+#include <rte_ip.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_service.h>
+#include <rte_udp.h>
+
+#include "evt_vhost.h"
+
+#define EVT_VHOST_MAX_PAIRS	16
+#define EVT_VHOST_QUEUE_SIZE	1024
+#define EVT_VHOST_BURST		32
+#define EVT_VHOST_POOL_SZ	(16 * 1024)
+/* The service cycles are read on 32 bits, before they wrap */
+#define EVT_VHOST_SAMPLE_MS	100
+
+/*
+ * Frame sizes of the packet mix, CRC excluded: 7 x 64, 4 x 594 and
+ * 1 x 1518 bytes, in this order.
+ */
+static const uint16_t evt_vhost_pkt_mix[] = {
+	60, 60, 60, 590, 60, 60, 590, 60, 60, 590, 1514, 590,
+};
+
+struct evt_vhost_stage {
+	uint64_t pkts;
+	uint64_t cycles;
+};
+
+/* Cycles of an adapter service, UINT32_MAX without service */
+struct evt_vhost_service {
+	uint32_t id;
+	uint32_t last;
+	uint64_t cycles;
+};
+
+struct evt_vhost_pair {
+	uint16_t vhost_port;
+	uint16_t peer_port;
+	/* Packet mix state, one per pair for it not to depend on lcores */
+	uint64_t rand;
+	uint32_t seq;
+	struct evt_vhost_stage guest_tx;
+	struct evt_vhost_stage guest_rx;
+	struct evt_vhost_service rx_service;
+	struct evt_vhost_service tx_service;
+} __rte_cache_aligned;
+
+static struct {
+	struct evt_vhost_pair pairs[EVT_VHOST_MAX_PAIRS];
+	uint8_t nb_pairs;
+	unsigned int nb_peers;
+	struct rte_mempool *pool;
+	int *done;
+	uint64_t tsc_start;
+} evt_vhost;
+
+static uint16_t
+evt_vhost_port_create(const char *name, const char *args)
+{
+	uint16_t port;
+
+	if (rte_vdev_init(name, args) < 0 ||
+			rte_eth_dev_get_port_by_name(name, &port) != 0) {
+		evt_err("failed to create %s (%s)", name, args);
+		return RTE_MAX_ETHPORTS;
+	}
+
+	return port;
+}
+
+int
+evt_vhost_create(struct evt_options *opt)
+{
+	struct rte_eth_dev_owner owner = { .name = "evt_vhost" };
+	uint8_t i;
+
+	if (opt->nb_vhost > EVT_VHOST_MAX_PAIRS) {
+		evt_err("number of vhost ports exceeds %d",
+				EVT_VHOST_MAX_PAIRS);
+		return -EINVAL;
+	}
+	if (evt_lcores_has_overlap(opt->plcores, rte_get_master_lcore()) ||
+			evt_lcores_has_overlap_multi(opt->plcores,
+				opt->wlcores) ||
+			evt_has_disabled_lcore(opt->plcores)) {
+		evt_err("invalid virtio-user lcores");
+		return -EINVAL;
+	}
+	if (!evt_has_active_lcore(opt->plcores)) {
+		evt_err("minimum one producer lcore is required for virtio-user");
+		return -EINVAL;
+	}
+
+	/* Hide the virtio-user ports from RTE_ETH_FOREACH_DEV */
+	if (rte_eth_dev_owner_new(&owner.id)) {
+		evt_err("failed to get an ethdev owner");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < opt->nb_vhost; i++) {
+		struct evt_vhost_pair *pair = &evt_vhost.pairs[i];
+		char path[PATH_MAX], name[RTE_ETH_NAME_MAX_LEN];
+		char args[PATH_MAX + 64];
+
+		snprintf(path, sizeof(path), "/tmp/evt-vhost%u-%d", i,
+				getpid());
+		unlink(path);
+
+		snprintf(name, sizeof(name), "net_vhost_evt%u", i);
+		snprintf(args, sizeof(args), "iface=%s,queues=1", path);
+		pair->vhost_port = evt_vhost_port_create(name, args);
+		if (pair->vhost_port == RTE_MAX_ETHPORTS)
+			return -ENODEV;
+
+		/* Connects to the vhost port, which listens on the path */
+		snprintf(name, sizeof(name), "net_virtio_user_evt%u", i);
+		snprintf(args, sizeof(args), "path=%s,queues=1,queue_size=%u",
+				path, EVT_VHOST_QUEUE_SIZE);
+		pair->peer_port = evt_vhost_port_create(name, args);
+		if (pair->peer_port == RTE_MAX_ETHPORTS)
+			return -ENODEV;
+
+		if (rte_eth_dev_owner_set(pair->peer_port, &owner)) {
+			evt_err("failed to own virtio-user port %d",
+					pair->peer_port);
+			return -EINVAL;
+		}
+
+		/* Never 0 for xorshift */
+		pair->rand = (opt->pkt_seed + i + 1) * 0x9E3779B97F4A7C15ULL;
+		if (pair->rand == 0)
+			pair->rand = 1;
+
+		evt_vhost.nb_pairs++;
+	}
+
+	return 0;
+}
+
+static inline uint64_t
+evt_vhost_rand(struct evt_vhost_pair *pair)
+{
+	uint64_t x = pair->rand;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	pair->rand = x;
+
+	return x;
+}
+
+/* UDP/IPv4 packets of nb_flows flows, by source address */
+static void
+evt_vhost_build_pkt(struct evt_vhost_pair *pair, struct rte_mbuf *m,
+		uint32_t nb_flows)
+{
+	uint16_t len = evt_vhost_pkt_mix[pair->seq++ %
+		RTE_DIM(evt_vhost_pkt_mix)];
+	struct ether_hdr *eth = rte_pktmbuf_mtod(m, struct ether_hdr *);
+	struct ipv4_hdr *ip = (struct ipv4_hdr *)(eth + 1);
+	struct udp_hdr *udp = (struct udp_hdr *)(ip + 1);
+	uint32_t flow = evt_vhost_rand(pair) % nb_flows;
+
+	memset(eth, 0, sizeof(*eth) + sizeof(*ip) + sizeof(*udp));
+	eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+	ip->version_ihl = 0x45;
+	ip->total_length = rte_cpu_to_be_16(len - sizeof(*eth));
+	ip->time_to_live = 64;
+	ip->next_proto_id = IPPROTO_UDP;
+	ip->src_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 0) + flow);
+	ip->dst_addr = rte_cpu_to_be_32(IPv4(10, 1, 0, 0));
+	ip->hdr_checksum = rte_ipv4_cksum(ip);
+	udp->dgram_len = rte_cpu_to_be_16(len - sizeof(*eth) - sizeof(*ip));
+
+	m->data_len = len;
+	m->pkt_len = len;
+}
+
+static void
+evt_vhost_service_sample(struct evt_vhost_service *service)
+{
+	uint32_t cycles;
+
+	if (service->id == UINT32_MAX ||
+			rte_service_attr_get(service->id,
+				RTE_SERVICE_ATTR_CYCLES, &cycles))
+		return;
+
+	service->cycles += (uint32_t)(cycles - service->last);
+	service->last = cycles;
+}
+
+static void
+evt_vhost_services_sample(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < evt_vhost.nb_pairs; i++) {
+		evt_vhost_service_sample(&evt_vhost.pairs[i].rx_service);
+		evt_vhost_service_sample(&evt_vhost.pairs[i].tx_service);
+	}
+}
+
+static int
+evt_vhost_peer(void *arg)
+{
+	struct evt_options *opt = arg;
+	struct rte_mbuf *pkts[EVT_VHOST_BURST];
+	uint64_t tsc, tsc_sample, sample_period;
+	unsigned int peer = 0, lcore_id;
+	uint16_t i, k, n;
+
+	/* Pairs are spread over the producer lcores */
+	RTE_LCORE_FOREACH(lcore_id) {
+		if (lcore_id == rte_lcore_id())
+			break;
+		if (opt->plcores[lcore_id])
+			peer++;
+	}
+
+	sample_period = rte_get_tsc_hz() * EVT_VHOST_SAMPLE_MS / 1000;
+	tsc_sample = rte_rdtsc();
+
+	while (!*(volatile int *)evt_vhost.done) {
+		if (peer == 0 && rte_rdtsc() - tsc_sample > sample_period) {
+			evt_vhost_services_sample();
+			tsc_sample = rte_rdtsc();
+		}
+
+		for (i = peer; i < evt_vhost.nb_pairs;
+				i += evt_vhost.nb_peers) {
+			struct evt_vhost_pair *pair = &evt_vhost.pairs[i];
+
+			tsc = rte_rdtsc();
+			if (rte_pktmbuf_alloc_bulk(evt_vhost.pool, pkts,
+						EVT_VHOST_BURST) == 0) {
+				for (k = 0; k < EVT_VHOST_BURST; k++)
+					evt_vhost_build_pkt(pair, pkts[k],
+							opt->nb_flows);
+				n = rte_eth_tx_burst(pair->peer_port, 0, pkts,
+						EVT_VHOST_BURST);
+				for (k = n; k < EVT_VHOST_BURST; k++)
+					rte_pktmbuf_free(pkts[k]);
+				if (n) {
+					pair->guest_tx.pkts += n;
+					pair->guest_tx.cycles +=
+						rte_rdtsc() - tsc;
+				}
+			}
+
+			tsc = rte_rdtsc();
+			n = rte_eth_rx_burst(pair->peer_port, 0, pkts,
+					EVT_VHOST_BURST);
+			if (n) {
+				for (k = 0; k < n; k++)
+					rte_pktmbuf_free(pkts[k]);
+				pair->guest_rx.pkts += n;
+				pair->guest_rx.cycles += rte_rdtsc() - tsc;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void
+evt_vhost_stats_enable(struct evt_vhost_pair *pair)
+{
+	pair->rx_service.id = UINT32_MAX;
+	pair->tx_service.id = UINT32_MAX;
+
+	/* No service with the internal ports of the event device */
+	if (rte_event_eth_rx_adapter_service_id_get(pair->vhost_port,
+				&pair->rx_service.id))
+		pair->rx_service.id = UINT32_MAX;
+	if (rte_event_eth_tx_adapter_service_id_get(pair->vhost_port,
+				&pair->tx_service.id))
+		pair->tx_service.id = UINT32_MAX;
+
+	if (pair->rx_service.id != UINT32_MAX)
+		rte_service_set_stats_enable(pair->rx_service.id, 1);
+	if (pair->tx_service.id != UINT32_MAX)
+		rte_service_set_stats_enable(pair->tx_service.id, 1);
+	evt_vhost_service_sample(&pair->rx_service);
+	evt_vhost_service_sample(&pair->tx_service);
+	pair->rx_service.cycles = 0;
+	pair->tx_service.cycles = 0;
+}
+
+int
+evt_vhost_launch(struct evt_options *opt, int *done)
+{
+	static const struct rte_eth_conf peer_conf;
+	unsigned int lcore_id;
+	uint8_t i;
+	int ret;
+
+	evt_vhost.done = done;
+	evt_vhost.nb_peers = evt_nr_active_lcores(opt->plcores);
+	evt_vhost.pool = rte_pktmbuf_pool_create("evt_vhost_pool",
+			EVT_VHOST_POOL_SZ, 256, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+			opt->socket_id);
+	if (evt_vhost.pool == NULL) {
+		evt_err("failed to create the virtio-user mempool");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < evt_vhost.nb_pairs; i++) {
+		uint16_t port = evt_vhost.pairs[i].peer_port;
+
+		if (rte_eth_dev_configure(port, 1, 1, &peer_conf) < 0 ||
+				rte_eth_rx_queue_setup(port, 0,
+					EVT_VHOST_QUEUE_SIZE, rte_socket_id(),
+					NULL, evt_vhost.pool) < 0 ||
+				rte_eth_tx_queue_setup(port, 0,
+					EVT_VHOST_QUEUE_SIZE, rte_socket_id(),
+					NULL) < 0 ||
+				rte_eth_dev_start(port) < 0) {
+			evt_err("failed to start virtio-user port %d", port);
+			return -EINVAL;
+		}
+
+		evt_vhost_stats_enable(&evt_vhost.pairs[i]);
+	}
+
+	evt_vhost.tsc_start = rte_rdtsc();
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (!opt->plcores[lcore_id])
+			continue;
+
+		ret = rte_eal_remote_launch(evt_vhost_peer, opt, lcore_id);
+		if (ret) {
+			evt_err("failed to launch virtio-user lcore %d",
+					lcore_id);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void
+evt_vhost_stage_print(const char *stage, uint16_t port, uint64_t pkts,
+		uint64_t cycles, uint64_t tsc)
+{
+	printf("%-10s%8u%16"PRIu64"%12.1f%12.1f\n", stage, port, pkts,
+			pkts ? (double)cycles / pkts : 0,
+			tsc ? 100.0 * cycles / tsc : 0);
+}
+
+/*
+ * The adapters are accounted with their service, idle polls included: the
+ * cycles per packet are the cost of the vhost dequeue and enqueue only when
+ * the services are saturated.
+ */
+void
+evt_vhost_result(struct evt_options *opt)
+{
+	uint64_t tsc = rte_rdtsc() - evt_vhost.tsc_start;
+	uint8_t i;
+
+	if (!opt->nb_vhost || evt_vhost.tsc_start == 0)
+		return;
+
+	evt_vhost_services_sample();
+
+	printf("\n%-10s%8s%16s%12s%12s\n",
+		"Stage", "Port", "Packets", "Cycles/Pkt", "Busy %");
+
+	for (i = 0; i < evt_vhost.nb_pairs; i++) {
+		struct evt_vhost_pair *pair = &evt_vhost.pairs[i];
+		struct rte_event_eth_rx_adapter_stats rx_stats;
+		struct rte_event_eth_tx_adapter_stats tx_stats;
+		uint16_t port = pair->vhost_port;
+
+		evt_vhost_stage_print("guest-tx", pair->peer_port,
+				pair->guest_tx.pkts, pair->guest_tx.cycles,
+				tsc);
+
+		if (pair->rx_service.id != UINT32_MAX &&
+				!rte_event_eth_rx_adapter_stats_get(port,
+					&rx_stats))
+			evt_vhost_stage_print("vhost-rx", port,
+					rx_stats.rx_packets,
+					pair->rx_service.cycles, tsc);
+
+		if (pair->tx_service.id != UINT32_MAX &&
+				!rte_event_eth_tx_adapter_stats_get(port,
+					&tx_stats))
+			evt_vhost_stage_print("vhost-tx", port,
+					tx_stats.tx_packets,
+					pair->tx_service.cycles, tsc);
+
+		evt_vhost_stage_print("guest-rx", pair->peer_port,
+				pair->guest_rx.pkts, pair->guest_rx.cycles,
+				tsc);
+	}
+}
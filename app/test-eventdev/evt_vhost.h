@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _EVT_VHOST_
+#define _EVT_VHOST_
+
+#include "evt_options.h"
+
+/*
+ * vhost producers: each vhost port is fed by a virtio-user port of the
+ * same process, standing for the VM. The virtio-user ports are owned by
+ * the application, the tests only see the vhost ports.
+ */
+
+/* Create the port pairs, before the tests look for ethdevs */
+int evt_vhost_create(struct evt_options *opt);
+
+/* Start the virtio-user ports and their lcores, until *done is set */
+int evt_vhost_launch(struct evt_options *opt, int *done);
+
+/* Print the cycles spent crossing the vrings, per stage */
+void evt_vhost_result(struct evt_options *opt);
+
+#endif /* _EVT_VHOST_ */
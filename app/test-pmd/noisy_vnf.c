@@ -32,43 +32,67 @@
 
 #include "testpmd.h"
 
+/* Simulation counters of a forwarding lcore */
+struct noisy_lcore {
+	uint64_t pkts;
+	uint64_t sim_pkts;
+	uint64_t sim_cycles;
+	uint64_t next_line;
+} __rte_cache_aligned;
+
 struct noisy_config {
 	struct rte_ring *f;
 	uint64_t prev_time;
-	char *vnf_mem;
+	volatile char *vnf_mem;
+	uint64_t nb_lines;
+	uint64_t start_time;
 	bool do_buffering;
 	bool do_flush;
 	bool do_sim;
+	struct noisy_lcore lcore[RTE_MAX_LCORE];
 };
 
 struct noisy_config *noisy_cfg[RTE_MAX_ETHPORTS];
 
-static inline void
-do_write(char *vnf_mem)
+/*
+ * Offset of the next cache line to access in the working set, spread over
+ * the whole of it whatever the access pattern.
+ */
+static inline uint64_t
+next_offset(struct noisy_config *ncf, struct noisy_lcore *nlc)
 {
-	uint64_t i = rte_rand();
-	uint64_t w = rte_rand();
+	uint64_t line;
+
+	if (noisy_lkup_pattern == NOISY_LKUP_PATTERN_SEQUENTIAL) {
+		line = nlc->next_line;
+		if (++nlc->next_line == ncf->nb_lines)
+			nlc->next_line = 0;
+	} else {
+		line = rte_rand() % ncf->nb_lines;
+	}
 
-	vnf_mem[i % ((noisy_lkup_mem_sz * 1024 * 1024) /
-			RTE_CACHE_LINE_SIZE)] = w;
+	return line * RTE_CACHE_LINE_SIZE;
 }
 
 static inline void
-do_read(char *vnf_mem)
+do_write(struct noisy_config *ncf, struct noisy_lcore *nlc)
 {
-	uint64_t i = rte_rand();
-	uint64_t r;
+	ncf->vnf_mem[next_offset(ncf, nlc)] = (char)rte_rand();
+}
 
-	r = vnf_mem[i % ((noisy_lkup_mem_sz * 1024 * 1024) /
-			RTE_CACHE_LINE_SIZE)];
-	r++;
+static inline void
+do_read(struct noisy_config *ncf, struct noisy_lcore *nlc)
+{
+	/* volatile, for the load not to be optimized out */
+	(void)ncf->vnf_mem[next_offset(ncf, nlc)];
 }
 
 static inline void
-do_readwrite(char *vnf_mem)
+do_readwrite(struct noisy_config *ncf, struct noisy_lcore *nlc)
 {
-	do_read(vnf_mem);
-	do_write(vnf_mem);
+	uint64_t off = next_offset(ncf, nlc);
+
+	ncf->vnf_mem[off] = ncf->vnf_mem[off] + 1;
 }
 
 /*
@@ -77,19 +101,25 @@ do_readwrite(char *vnf_mem)
 static void
 sim_memory_lookups(struct noisy_config *ncf, uint16_t nb_pkts)
 {
+	struct noisy_lcore *nlc = &ncf->lcore[rte_lcore_id()];
+	uint64_t start;
 	uint16_t i, j;
 
-	if (!ncf->do_sim)
+	nlc->pkts += nb_pkts;
+	if (!ncf->do_sim || nb_pkts == 0)
 		return;
 
+	start = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
 		for (j = 0; j < noisy_lkup_num_writes; j++)
-			do_write(ncf->vnf_mem);
+			do_write(ncf, nlc);
 		for (j = 0; j < noisy_lkup_num_reads; j++)
-			do_read(ncf->vnf_mem);
+			do_read(ncf, nlc);
 		for (j = 0; j < noisy_lkup_num_reads_writes; j++)
-			do_readwrite(ncf->vnf_mem);
+			do_readwrite(ncf, nlc);
 	}
+	nlc->sim_cycles += rte_rdtsc() - start;
+	nlc->sim_pkts += nb_pkts;
 }
 
 static uint16_t
@@ -219,11 +249,54 @@ pkt_burst_noisy_vnf(struct fwd_stream *fs)
 #define NOISY_STRSIZE 256
 #define NOISY_RING "noisy_ring_%d\n"
 
+/*
+ * Achieved packet rate of the port against the cost of the simulated
+ * accesses: the cycles per access give the cache miss latency met in the
+ * working set and the cycles per packet the budget left to the vswitch.
+ * The cost of the random generator is included.
+ */
+static void
+noisy_stats_display(portid_t pi, struct noisy_config *ncf)
+{
+	uint64_t accesses_per_pkt = noisy_lkup_num_writes +
+		noisy_lkup_num_reads + 2 * noisy_lkup_num_reads_writes;
+	uint64_t elapsed = rte_rdtsc() - ncf->start_time;
+	uint64_t hz = rte_get_tsc_hz();
+	uint64_t pkts = 0, sim_pkts = 0, sim_cycles = 0;
+	unsigned int lc;
+
+	if (!ncf->do_sim || elapsed == 0)
+		return;
+
+	for (lc = 0; lc < RTE_MAX_LCORE; lc++) {
+		pkts += ncf->lcore[lc].pkts;
+		sim_pkts += ncf->lcore[lc].sim_pkts;
+		sim_cycles += ncf->lcore[lc].sim_cycles;
+	}
+
+	printf("\n  Noisy VNF port %d: %" PRIu64 " KB %s working set"
+	       " on socket %d\n", pi,
+	       ncf->nb_lines * RTE_CACHE_LINE_SIZE / 1024,
+	       noisy_lkup_pattern == NOISY_LKUP_PATTERN_SEQUENTIAL ?
+	       "sequential" : "random", noisy_lkup_socket);
+	printf("  Achieved rate: %.3f Mpps, %" PRIu64 " accesses/pkt\n",
+	       (double)pkts * hz / elapsed / 1000000, accesses_per_pkt);
+	if (sim_pkts == 0)
+		return;
+	printf("  Cycles/access: %.1f, cycles/pkt: %.1f, "
+	       "rate bound by the accesses: %.3f Mpps\n",
+	       accesses_per_pkt ?
+	       (double)sim_cycles / (sim_pkts * accesses_per_pkt) : 0,
+	       (double)sim_cycles / sim_pkts,
+	       sim_cycles ? (double)sim_pkts * hz / sim_cycles / 1000000 : 0);
+}
+
 static void
 noisy_fwd_end(portid_t pi)
 {
+	noisy_stats_display(pi, noisy_cfg[pi]);
 	rte_ring_free(noisy_cfg[pi]->f);
-	rte_free(noisy_cfg[pi]->vnf_mem);
+	rte_free((void *)(uintptr_t)noisy_cfg[pi]->vnf_mem);
 	rte_free(noisy_cfg[pi]);
 }
 
@@ -258,17 +331,28 @@ noisy_fwd_begin(portid_t pi)
 				 noisy_tx_sw_bufsz);
 	}
 	if (noisy_lkup_mem_sz > 0) {
-		n->vnf_mem = (char *) rte_zmalloc("vnf sim memory",
+		n->vnf_mem = rte_zmalloc_socket("vnf sim memory",
 				 noisy_lkup_mem_sz * 1024 * 1024,
-				 RTE_CACHE_LINE_SIZE);
+				 RTE_CACHE_LINE_SIZE, noisy_lkup_socket);
 		if (!n->vnf_mem)
 			rte_exit(EXIT_FAILURE,
 			   "rte_zmalloc(%" PRIu64 ") for vnf memory) failed\n",
 			   noisy_lkup_mem_sz);
+		if (noisy_lkup_working_set_sz > noisy_lkup_mem_sz * 1024)
+			rte_exit(EXIT_FAILURE,
+				 "--noisy-lkup-working-set must not exceed "
+				 "--noisy-lkup-memory\n");
+		n->nb_lines = (noisy_lkup_working_set_sz ?
+			       noisy_lkup_working_set_sz :
+			       noisy_lkup_mem_sz * 1024) * 1024 /
+			RTE_CACHE_LINE_SIZE;
+		if (n->nb_lines == 0)
+			n->nb_lines = 1;
 	} else if (n->do_sim) {
 		rte_exit(EXIT_FAILURE,
 			 "--noisy-lkup-memory-size must be > 0\n");
 	}
+	n->start_time = rte_rdtsc();
 }
 
 struct fwd_engine noisy_vnf_engine = {
@@ -201,6 +201,10 @@ usage(char* progname)
 	printf("  --noisy-lkup-num-writes=N: do N random writes per packet\n");
 	printf("  --noisy-lkup-num-reads=N: do N random reads per packet\n");
 	printf("  --noisy-lkup-num-writes=N: do N random reads and writes per packet\n");
+	printf("  --noisy-lkup-working-set=N: access N KB of VNF memory\n");
+	printf("  --noisy-lkup-socket=N: allocate VNF memory on socket N\n");
+	printf("  --noisy-lkup-pattern=random|sequential: "
+	       "access pattern in VNF memory\n");
 }
 
 #ifdef RTE_LIBRTE_CMDLINE
@@ -649,6 +653,9 @@ launch_args_parse(int argc, char** argv)
 		{ "noisy-lkup-num-writes",	1, 0, 0 },
 		{ "noisy-lkup-num-reads",	1, 0, 0 },
 		{ "noisy-lkup-num-reads-writes", 1, 0, 0 },
+		{ "noisy-lkup-working-set",	1, 0, 0 },
+		{ "noisy-lkup-socket",		1, 0, 0 },
+		{ "noisy-lkup-pattern",		1, 0, 0 },
 		{ 0, 0, 0, 0 },
 	};
 
@@ -1238,6 +1245,38 @@ launch_args_parse(int argc, char** argv)
 					rte_exit(EXIT_FAILURE,
 						 "noisy-lkup-num-reads-writes must be >= 0\n");
 			}
+			if (!strcmp(lgopts[opt_idx].name,
+				    "noisy-lkup-working-set")) {
+				n = atoi(optarg);
+				if (n >= 0)
+					noisy_lkup_working_set_sz = n;
+				else
+					rte_exit(EXIT_FAILURE,
+						 "noisy-lkup-working-set must be >= 0\n");
+			}
+			if (!strcmp(lgopts[opt_idx].name,
+				    "noisy-lkup-socket")) {
+				n = atoi(optarg);
+				if (!new_socket_id((unsigned int)n))
+					noisy_lkup_socket = n;
+				else
+					rte_exit(EXIT_FAILURE,
+						 "noisy-lkup-socket must be a "
+						 "socket with memory\n");
+			}
+			if (!strcmp(lgopts[opt_idx].name,
+				    "noisy-lkup-pattern")) {
+				if (!strcmp(optarg, "random"))
+					noisy_lkup_pattern =
+						NOISY_LKUP_PATTERN_RANDOM;
+				else if (!strcmp(optarg, "sequential"))
+					noisy_lkup_pattern =
+						NOISY_LKUP_PATTERN_SEQUENTIAL;
+				else
+					rte_exit(EXIT_FAILURE,
+						 "noisy-lkup-pattern must be "
+						 "random or sequential\n");
+			}
 			break;
 		case 'h':
 			usage(argv[0]);
@@ -0,0 +1,425 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2018 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_byteorder.h>
+#include <rte_cycles.h>
+#include <rte_atomic.h>
+#include <rte_branch_prediction.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_mempool.h>
+#include <rte_mbuf.h>
+#include <rte_ether.h>
+#include <rte_ethdev.h>
+#include <rte_ip.h>
+#include <rte_udp.h>
+#include <rte_flow.h>
+#include <rte_metrics.h>
+
+#include "testpmd.h"
+
+/*
+ * Round trip latency mode: every stream transmits packets stamped with
+ * the TSC on its TX queue, and measures the stamped packets coming back
+ * on its RX queue, e.g. after a guest looped them back through a vhost
+ * port. Packets are sent in a closed loop: a TX queue keeps at most
+ * nb_pkt_per_burst packets in flight, so with a burst of 1 each sample
+ * is a bare round trip, without queueing behind the previous packets.
+ */
+
+#define RTT_UDP_PORT 4789
+#define RTT_MAGIC 0x5254547374616d70ULL /* "RTTstamp" */
+
+#define IP_SRC_ADDR ((192U << 24) | (168 << 16) | (0 << 8) | 1)
+#define IP_DST_ADDR ((192U << 24) | (168 << 16) | (0 << 8) | 2)
+#define IP_DEFTTL  64
+#define IP_VHL_DEF (0x40 | 0x05)
+
+/* Log-linear histogram: 16 buckets per power of two, 6% precision. */
+#define RTT_SUB_BITS 4
+#define RTT_SUB_BUCKETS (1 << RTT_SUB_BITS)
+#define RTT_NB_BUCKETS ((64 - RTT_SUB_BITS + 1) * RTT_SUB_BUCKETS)
+
+/* In flight packets not back after this time are accounted as lost. */
+#define RTT_LOSS_TIMEOUT_MS 100
+
+struct rtt_stamp {
+	uint64_t magic;
+	uint64_t tsc;
+	uint16_t tx_port;
+	uint16_t tx_queue;
+} __attribute__((__packed__));
+
+#define RTT_STAMP_OFF (sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr) + \
+		       sizeof(struct udp_hdr))
+#define RTT_MIN_PKT_LEN (RTT_STAMP_OFF + sizeof(struct rtt_stamp))
+
+struct rtt_queue {
+	/* RX side, updated by the lcore polling the queue */
+	uint64_t samples;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t hist[RTT_NB_BUCKETS];
+	/* TX side, returned is updated by the lcore receiving the packets */
+	rte_atomic32_t returned;
+	uint32_t sent;
+	uint64_t lost;
+	uint64_t last_tx_tsc;
+} __rte_cache_aligned;
+
+struct rtt_port {
+	uint16_t nb_queues;
+	struct rtt_queue q[];
+};
+
+static struct rtt_port *rtt_ports[RTE_MAX_ETHPORTS];
+static struct ipv4_hdr rtt_ip_hdr;
+static struct udp_hdr rtt_udp_hdr;
+static uint16_t rtt_pkt_len;
+static uint64_t rtt_loss_cycles;
+static int rtt_metrics_key = -1;
+
+static const char * const rtt_metrics_names[] = {
+	"rtt_latency_p50_ns",
+	"rtt_latency_p99_ns",
+	"rtt_latency_p999_ns",
+	"rtt_latency_max_ns",
+	"rtt_lost_packets",
+};
+
+static inline unsigned int
+rtt_bucket(uint64_t cycles)
+{
+	unsigned int msb;
+
+	if (cycles < 2 * RTT_SUB_BUCKETS)
+		return cycles;
+	msb = 63 - __builtin_clzll(cycles);
+	return (msb - RTT_SUB_BITS + 1) * RTT_SUB_BUCKETS +
+		((cycles >> (msb - RTT_SUB_BITS)) & (RTT_SUB_BUCKETS - 1));
+}
+
+/* Lowest latency counted in a bucket. */
+static uint64_t
+rtt_bucket_cycles(unsigned int idx)
+{
+	unsigned int msb;
+
+	if (idx < 2 * RTT_SUB_BUCKETS)
+		return idx;
+	msb = idx / RTT_SUB_BUCKETS + RTT_SUB_BITS - 1;
+	return (uint64_t)(RTT_SUB_BUCKETS + idx % RTT_SUB_BUCKETS) <<
+		(msb - RTT_SUB_BITS);
+}
+
+static uint64_t
+rtt_percentile(const uint64_t *hist, uint64_t samples, double pct)
+{
+	uint64_t rank = (uint64_t)(samples * pct / 100.0);
+	uint64_t count = 0;
+	unsigned int i;
+
+	for (i = 0; i < RTT_NB_BUCKETS; i++) {
+		count += hist[i];
+		if (count > rank)
+			break;
+	}
+	return rtt_bucket_cycles(RTE_MIN(i, RTT_NB_BUCKETS - 1U));
+}
+
+static inline uint64_t
+rtt_ns(uint64_t cycles)
+{
+	return (double)cycles * NS_PER_S / rte_get_tsc_hz();
+}
+
+static void
+rtt_receive(struct rtt_queue *rxq, struct rte_mbuf *pkt, uint64_t now)
+{
+	const struct ether_hdr *eth_hdr;
+	const struct ipv4_hdr *ip_hdr;
+	const struct udp_hdr *udp_hdr;
+	const struct rtt_stamp *stamp;
+	struct rtt_port *txp;
+	uint64_t cycles;
+
+	if (pkt->data_len < RTT_MIN_PKT_LEN)
+		return;
+	eth_hdr = rte_pktmbuf_mtod(pkt, struct ether_hdr *);
+	ip_hdr = (const struct ipv4_hdr *)(eth_hdr + 1);
+	udp_hdr = (const struct udp_hdr *)(ip_hdr + 1);
+	if (eth_hdr->ether_type != rte_cpu_to_be_16(ETHER_TYPE_IPv4) ||
+	    ip_hdr->next_proto_id != IPPROTO_UDP ||
+	    udp_hdr->dst_port != rte_cpu_to_be_16(RTT_UDP_PORT))
+		return;
+	stamp = rte_pktmbuf_mtod_offset(pkt, const struct rtt_stamp *,
+					RTT_STAMP_OFF);
+	if (stamp->magic != RTT_MAGIC || stamp->tx_port >= RTE_MAX_ETHPORTS)
+		return;
+
+	cycles = now - stamp->tsc;
+	rxq->samples++;
+	rxq->sum += cycles;
+	if (cycles < rxq->min)
+		rxq->min = cycles;
+	if (cycles > rxq->max)
+		rxq->max = cycles;
+	rxq->hist[rtt_bucket(cycles)]++;
+
+	txp = rtt_ports[stamp->tx_port];
+	if (txp != NULL && stamp->tx_queue < txp->nb_queues)
+		rte_atomic32_inc(&txp->q[stamp->tx_queue].returned);
+}
+
+static void
+rtt_transmit(struct fwd_stream *fs, struct rtt_queue *txq, uint64_t now)
+{
+	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+	struct rte_mempool *mbp;
+	struct ether_hdr *eth_hdr;
+	struct rtt_stamp *stamp;
+	struct rte_mbuf *pkt;
+	int32_t in_flight;
+	uint16_t nb_pkt;
+	uint16_t nb_tx;
+	uint16_t i;
+
+	in_flight = (int32_t)(txq->sent -
+			      rte_atomic32_read(&txq->returned));
+	if (in_flight < 0)
+		in_flight = 0;
+	if (in_flight >= nb_pkt_per_burst) {
+		if (now - txq->last_tx_tsc < rtt_loss_cycles)
+			return;
+		/* give up on the packets in flight */
+		txq->lost += in_flight;
+		txq->sent = rte_atomic32_read(&txq->returned);
+		in_flight = 0;
+	}
+
+	mbp = current_fwd_lcore()->mbp;
+	for (nb_pkt = 0; nb_pkt < nb_pkt_per_burst - in_flight; nb_pkt++) {
+		pkt = rte_mbuf_raw_alloc(mbp);
+		if (pkt == NULL)
+			break;
+		rte_pktmbuf_reset_headroom(pkt);
+		pkt->data_len = rtt_pkt_len;
+		pkt->pkt_len = rtt_pkt_len;
+		pkt->nb_segs = 1;
+		pkt->next = NULL;
+		pkt->ol_flags = 0;
+		pkt->l2_len = sizeof(struct ether_hdr);
+		pkt->l3_len = sizeof(struct ipv4_hdr);
+
+		eth_hdr = rte_pktmbuf_mtod(pkt, struct ether_hdr *);
+		ether_addr_copy(&peer_eth_addrs[fs->peer_addr],
+				&eth_hdr->d_addr);
+		ether_addr_copy(&ports[fs->tx_port].eth_addr,
+				&eth_hdr->s_addr);
+		eth_hdr->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+		rte_memcpy(eth_hdr + 1, &rtt_ip_hdr, sizeof(rtt_ip_hdr));
+		rte_memcpy((char *)(eth_hdr + 1) + sizeof(rtt_ip_hdr),
+			   &rtt_udp_hdr, sizeof(rtt_udp_hdr));
+		stamp = rte_pktmbuf_mtod_offset(pkt, struct rtt_stamp *,
+						RTT_STAMP_OFF);
+		stamp->magic = RTT_MAGIC;
+		stamp->tx_port = fs->tx_port;
+		stamp->tx_queue = fs->tx_queue;
+		pkts_burst[nb_pkt] = pkt;
+	}
+	if (nb_pkt == 0)
+		return;
+
+	/* stamp last, as close as possible to the transmission */
+	now = rte_rdtsc();
+	for (i = 0; i < nb_pkt; i++)
+		rte_pktmbuf_mtod_offset(pkts_burst[i], struct rtt_stamp *,
+					RTT_STAMP_OFF)->tsc = now;
+	nb_tx = rte_eth_tx_burst(fs->tx_port, fs->tx_queue, pkts_burst,
+				 nb_pkt);
+	txq->sent += nb_tx;
+	txq->last_tx_tsc = now;
+	fs->tx_packets += nb_tx;
+#ifdef RTE_TEST_PMD_RECORD_BURST_STATS
+	fs->tx_burst_stats.pkt_burst_spread[nb_tx]++;
+#endif
+	if (unlikely(nb_tx < nb_pkt)) {
+		fs->fwd_dropped += nb_pkt - nb_tx;
+		do {
+			rte_pktmbuf_free(pkts_burst[nb_tx]);
+		} while (++nb_tx < nb_pkt);
+	}
+}
+
+/*
+ * Measure the stamped packets received, then top up the packets in flight.
+ */
+static void
+pkt_burst_rtt(struct fwd_stream *fs)
+{
+	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+	struct rtt_queue *rxq;
+	struct rtt_queue *txq;
+	uint16_t nb_rx;
+	uint16_t i;
+	uint64_t now;
+#ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
+	uint64_t start_tsc;
+	uint64_t end_tsc;
+	uint64_t core_cycles;
+
+	start_tsc = rte_rdtsc();
+#endif
+
+	rxq = &rtt_ports[fs->rx_port]->q[fs->rx_queue];
+	txq = &rtt_ports[fs->tx_port]->q[fs->tx_queue];
+
+	nb_rx = rte_eth_rx_burst(fs->rx_port, fs->rx_queue, pkts_burst,
+				 nb_pkt_per_burst);
+	now = rte_rdtsc();
+	if (nb_rx != 0) {
+#ifdef RTE_TEST_PMD_RECORD_BURST_STATS
+		fs->rx_burst_stats.pkt_burst_spread[nb_rx]++;
+#endif
+		fs->rx_packets += nb_rx;
+		for (i = 0; i < nb_rx; i++) {
+			rtt_receive(rxq, pkts_burst[i], now);
+			rte_pktmbuf_free(pkts_burst[i]);
+		}
+	}
+
+	rtt_transmit(fs, txq, now);
+
+#ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
+	end_tsc = rte_rdtsc();
+	core_cycles = (end_tsc - start_tsc);
+	fs->core_cycles = (uint64_t) (fs->core_cycles + core_cycles);
+#endif
+}
+
+static void
+rtt_setup_headers(void)
+{
+	uint16_t len;
+
+	rtt_pkt_len = RTE_MAX(tx_pkt_length, (uint16_t)RTT_MIN_PKT_LEN);
+
+	len = rtt_pkt_len - sizeof(struct ether_hdr) - sizeof(struct ipv4_hdr);
+	memset(&rtt_udp_hdr, 0, sizeof(rtt_udp_hdr));
+	rtt_udp_hdr.src_port = rte_cpu_to_be_16(RTT_UDP_PORT);
+	rtt_udp_hdr.dst_port = rte_cpu_to_be_16(RTT_UDP_PORT);
+	rtt_udp_hdr.dgram_len = rte_cpu_to_be_16(len);
+
+	len += sizeof(struct ipv4_hdr);
+	memset(&rtt_ip_hdr, 0, sizeof(rtt_ip_hdr));
+	rtt_ip_hdr.version_ihl = IP_VHL_DEF;
+	rtt_ip_hdr.time_to_live = IP_DEFTTL;
+	rtt_ip_hdr.next_proto_id = IPPROTO_UDP;
+	rtt_ip_hdr.total_length = rte_cpu_to_be_16(len);
+	rtt_ip_hdr.src_addr = rte_cpu_to_be_32(IP_SRC_ADDR);
+	rtt_ip_hdr.dst_addr = rte_cpu_to_be_32(IP_DST_ADDR);
+	rtt_ip_hdr.hdr_checksum = rte_ipv4_cksum(&rtt_ip_hdr);
+}
+
+static void
+rtt_fwd_begin(portid_t pi)
+{
+	struct rtt_port *rp;
+	uint16_t nb_queues = RTE_MAX(nb_rxq, nb_txq);
+	uint16_t i;
+
+	rtt_setup_headers();
+	rtt_loss_cycles = rte_get_tsc_hz() * RTT_LOSS_TIMEOUT_MS / MS_PER_S;
+
+	rte_free(rtt_ports[pi]);
+	rp = rte_zmalloc_socket("testpmd: struct rtt_port", sizeof(*rp) +
+				nb_queues * sizeof(rp->q[0]),
+				RTE_CACHE_LINE_SIZE,
+				rte_eth_dev_socket_id(pi));
+	if (rp == NULL)
+		rte_exit(EXIT_FAILURE,
+			 "rtt: cannot allocate stats of port %u\n", pi);
+	rp->nb_queues = nb_queues;
+	for (i = 0; i < nb_queues; i++)
+		rp->q[i].min = UINT64_MAX;
+	rtt_ports[pi] = rp;
+
+	if (rtt_metrics_key < 0)
+		rtt_metrics_key = rte_metrics_reg_names(rtt_metrics_names,
+					RTE_DIM(rtt_metrics_names));
+}
+
+static void
+rtt_fwd_end(portid_t pi)
+{
+	struct rtt_port *rp = rtt_ports[pi];
+	uint64_t values[RTE_DIM(rtt_metrics_names)];
+	uint64_t *hist;
+	uint64_t samples = 0;
+	uint64_t lost = 0;
+	uint64_t max = 0;
+	struct rtt_queue *q;
+	unsigned int b;
+	uint16_t i;
+
+	if (rp == NULL)
+		return;
+	hist = rte_zmalloc("testpmd: rtt histogram",
+			   RTT_NB_BUCKETS * sizeof(*hist), 0);
+
+	printf("\n  Round trip latency of port %u (us):\n", pi);
+	for (i = 0; i < rp->nb_queues; i++) {
+		q = &rp->q[i];
+		lost += q->lost;
+		if (q->samples == 0)
+			continue;
+		printf("    RX queue %-3u samples: %-12"PRIu64
+		       " min: %-8.2f avg: %-8.2f max: %-8.2f\n"
+		       "                  p50: %-8.2f p99: %-8.2f"
+		       " p99.9: %-8.2f\n", i, q->samples,
+		       rtt_ns(q->min) / 1000.0,
+		       rtt_ns(q->sum / q->samples) / 1000.0,
+		       rtt_ns(q->max) / 1000.0,
+		       rtt_ns(rtt_percentile(q->hist, q->samples, 50)) / 1000.0,
+		       rtt_ns(rtt_percentile(q->hist, q->samples, 99)) / 1000.0,
+		       rtt_ns(rtt_percentile(q->hist, q->samples, 99.9)) /
+		       1000.0);
+		samples += q->samples;
+		max = RTE_MAX(max, q->max);
+		if (hist != NULL)
+			for (b = 0; b < RTT_NB_BUCKETS; b++)
+				hist[b] += q->hist[b];
+	}
+	if (lost != 0)
+		printf("    Lost packets: %"PRIu64"\n", lost);
+
+	/* export the port wide figures, as the latencystats library does */
+	if (rtt_metrics_key >= 0 && hist != NULL && samples != 0) {
+		values[0] = rtt_ns(rtt_percentile(hist, samples, 50));
+		values[1] = rtt_ns(rtt_percentile(hist, samples, 99));
+		values[2] = rtt_ns(rtt_percentile(hist, samples, 99.9));
+		values[3] = rtt_ns(max);
+		values[4] = lost;
+		rte_metrics_update_values(pi, rtt_metrics_key, values,
+					  RTE_DIM(values));
+	}
+
+	rte_free(hist);
+	rte_free(rp);
+	rtt_ports[pi] = NULL;
+}
+
+struct fwd_engine rtt_fwd_engine = {
+	.fwd_mode_name  = "rtt",
+	.port_fwd_begin = rtt_fwd_begin,
+	.port_fwd_end   = rtt_fwd_end,
+	.packet_fwd     = pkt_burst_rtt,
+};
@@ -179,6 +179,7 @@ struct fwd_engine * fwd_engines[] = {
 	&csum_fwd_engine,
 	&icmp_echo_engine,
 	&noisy_vnf_engine,
+	&rtt_fwd_engine,
 #if defined RTE_LIBRTE_PMD_SOFTNIC
 	&softnic_fwd_engine,
 #endif
@@ -308,6 +309,22 @@ uint64_t noisy_lkup_num_reads;
  */
 uint64_t noisy_lkup_num_reads_writes;
 
+/*
+ * Configurable size in KB of the part of the VNF simulation memory area
+ * really accessed, the whole area when 0.
+ */
+uint64_t noisy_lkup_working_set_sz;
+
+/*
+ * Configurable socket of the VNF simulation memory area.
+ */
+int noisy_lkup_socket = SOCKET_ID_ANY;
+
+/*
+ * Configurable pattern of the accesses to the VNF simulation memory area.
+ */
+enum noisy_lkup_pattern noisy_lkup_pattern = NOISY_LKUP_PATTERN_RANDOM;
+
 /*
  * Receive Side Scaling (RSS) configuration.
  */
@@ -263,6 +263,7 @@ extern struct fwd_engine tx_only_engine;
 extern struct fwd_engine csum_fwd_engine;
 extern struct fwd_engine icmp_echo_engine;
 extern struct fwd_engine noisy_vnf_engine;
+extern struct fwd_engine rtt_fwd_engine;
 #ifdef SOFTNIC
 extern struct fwd_engine softnic_fwd_engine;
 #endif
@@ -403,6 +404,15 @@ extern uint64_t noisy_lkup_mem_sz;
 extern uint64_t noisy_lkup_num_writes;
 extern uint64_t noisy_lkup_num_reads;
 extern uint64_t noisy_lkup_num_reads_writes;
+extern uint64_t noisy_lkup_working_set_sz;
+extern int noisy_lkup_socket;
+
+/* Access patterns in the noisy neighbour simulation memory */
+enum noisy_lkup_pattern {
+	NOISY_LKUP_PATTERN_RANDOM,
+	NOISY_LKUP_PATTERN_SEQUENTIAL,
+};
+extern enum noisy_lkup_pattern noisy_lkup_pattern;
 
 extern uint8_t dcb_config;
 extern uint8_t dcb_test;
@@ -48,6 +48,7 @@
 /* mbuf defines */
 #define RTE_MBUF_DEFAULT_MEMPOOL_OPS "ring_mp_mc"
 #define RTE_MBUF_REFCNT_ATOMIC 1
+#undef RTE_MBUF_TX_OFFLOAD_CACHELINE0
 #define RTE_PKTMBUF_HEADROOM 128
 
 /* ether defines */
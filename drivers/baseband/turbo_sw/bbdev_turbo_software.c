@@ -3,6 +3,8 @@
  */
 
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include <rte_common.h>
 #include <rte_bus_vdev.h>
@@ -10,6 +12,8 @@
 #include <rte_ring.h>
 #include <rte_kvargs.h>
 #include <rte_cycles.h>
+#include <rte_pause.h>
+#include <rte_lcore.h>
 
 #include <rte_bbdev.h>
 #include <rte_bbdev_pmd.h>
@@ -37,26 +41,94 @@ static int bbdev_turbo_sw_logtype;
 #define DEINT_OUTPUT_BUF_SIZE (DEINT_INPUT_BUF_SIZE * 6)
 #define ADAPTER_OUTPUT_BUF_SIZE ((RTE_BBDEV_MAX_CB_SIZE + 4) * 48)
 
+/* Maximum number of decoding workers per queue */
+#define TURBO_SW_MAX_WORKERS 32
+/* Empty polls of a worker before it starts sleeping */
+#define TURBO_SW_WORKER_IDLE_SPINS 1024
+/* Sleep time of an idle worker, in microseconds */
+#define TURBO_SW_WORKER_SLEEP_US 10
+
 /* private data structure */
 struct bbdev_private {
 	unsigned int max_nb_queues;  /**< Max number of queues */
+	uint16_t nb_workers;  /**< Decoding workers per queue */
 };
 
 /*  Initialisation params structure that can be used by Turbo SW driver */
 struct turbo_sw_params {
 	int socket_id;  /*< Turbo SW device socket */
 	uint16_t queues_num;  /*< Turbo SW device queues number */
+	uint16_t workers_num;  /*< Turbo SW decoding workers per queue */
 };
 
 /* Accecptable params for Turbo SW devices */
 #define TURBO_SW_MAX_NB_QUEUES_ARG  "max_nb_queues"
 #define TURBO_SW_SOCKET_ID_ARG      "socket_id"
+#define TURBO_SW_WORKERS_ARG        "workers"
 
 static const char * const turbo_sw_valid_params[] = {
 	TURBO_SW_MAX_NB_QUEUES_ARG,
-	TURBO_SW_SOCKET_ID_ARG
+	TURBO_SW_SOCKET_ID_ARG,
+	TURBO_SW_WORKERS_ARG,
+	NULL
+};
+
+/* Decoder buffers, used by the queue or by a worker */
+struct turbo_sw_dec_bufs {
+	/* Alpha gamma buf for bblib_turbo_decoder() function */
+	int8_t *ag;
+	/* Temp buf for bblib_turbo_decoder() function */
+	uint16_t *code_block;
+	/* Input buf for bblib_rate_dematching_lte() function */
+	uint8_t *deint_input;
+	/* Output buf for bblib_rate_dematching_lte() function */
+	uint8_t *deint_output;
+	/* Output buf for bblib_turbodec_adapter_lte() function */
+	uint8_t *adapter_output;
 };
 
+struct turbo_sw_dec_tb;
+
+/* Code block of a decode operation */
+struct turbo_sw_dec_cb {
+	/* Transport block of the code block */
+	struct turbo_sw_dec_tb *tb;
+	uint16_t k;
+	uint16_t kw;
+	uint16_t in_offset;
+	uint16_t out_offset;
+	/* Input left from the start of the code block */
+	uint16_t total_left;
+};
+
+/* Decode operation split in code blocks */
+struct turbo_sw_dec_tb {
+	struct rte_bbdev_dec_op *op;
+	uint8_t c;
+	uint8_t nb_cbs;
+	uint16_t crc24_overlap;
+	bool check_crc_24b;
+	/* Results of the code blocks, merged into the op once all are done,
+	 * updated atomically when the code blocks are decoded by workers
+	 */
+	uint8_t remaining;
+	uint8_t iter_count;
+	int status;
+	uint32_t hard_out_len;
+	/* Set when the op can be dequeued */
+	uint32_t done;
+	struct turbo_sw_dec_cb cbs[RTE_BBDEV_MAX_CODE_BLOCKS];
+} __rte_cache_aligned;
+
+struct turbo_sw_queue;
+
+/* Decoding worker of a queue */
+struct turbo_sw_worker {
+	pthread_t thread;
+	struct turbo_sw_queue *q;
+	struct turbo_sw_dec_bufs dec;
+} __rte_cache_aligned;
+
 /* queue */
 struct turbo_sw_queue {
 	/* Ring for processed (encoded/decoded) operations which are ready to
@@ -69,20 +141,28 @@ struct turbo_sw_queue {
 	uint8_t *enc_in;
 	/* Stores output from turbo encoder */
 	uint8_t *enc_out;
-	/* Alpha gamma buf for bblib_turbo_decoder() function */
-	int8_t *ag;
-	/* Temp buf for bblib_turbo_decoder() function */
-	uint16_t *code_block;
-	/* Input buf for bblib_rate_dematching_lte() function */
-	uint8_t *deint_input;
-	/* Output buf for bblib_rate_dematching_lte() function */
-	uint8_t *deint_output;
-	/* Output buf for bblib_turbodec_adapter_lte() function */
-	uint8_t *adapter_output;
+	/* Decoder buffers */
+	struct turbo_sw_dec_bufs dec;
 	/* Operation type of this queue */
 	enum rte_bbdev_op_type type;
+
+	/* When the decode queue is served by workers, its operations are
+	 * placed in enqueue order in tbs, their code blocks are placed in
+	 * cb_ring and decoded by the workers, and the operations are
+	 * dequeued in enqueue order once all their code blocks are done.
+	 */
+	struct turbo_sw_dec_tb *tbs;
+	uint32_t tb_mask;
+	uint32_t tb_head;
+	uint32_t tb_tail;
+	struct rte_ring *cb_ring;
+	struct turbo_sw_worker *workers;
+	uint16_t nb_workers;
+	int stop;
 } __rte_cache_aligned;
 
+static void *turbo_sw_worker_main(void *arg);
+
 /* Calculate index based on Table 5.1.3-3 from TS34.212 */
 static inline int32_t
 compute_idx(uint16_t k)
@@ -167,7 +247,11 @@ info_get(struct rte_bbdev *dev, struct rte_bbdev_driver_info *dev_info)
 		.queue_size = RTE_BBDEV_QUEUE_SIZE_LIMIT,
 	};
 
+#ifdef RTE_BBDEV_SDK_AVX512
+	static const enum rte_cpu_flag_t cpu_flag = RTE_CPUFLAG_AVX512F;
+#else
 	static const enum rte_cpu_flag_t cpu_flag = RTE_CPUFLAG_SSE4_2;
+#endif
 
 	default_queue_conf.socket = dev->data->socket_id;
 
@@ -185,6 +269,137 @@ info_get(struct rte_bbdev *dev, struct rte_bbdev_driver_info *dev_info)
 	rte_bbdev_log_debug("got device info from %u\n", dev->data->dev_id);
 }
 
+/* Free decoder buffers */
+static void
+dec_bufs_free(struct turbo_sw_dec_bufs *b)
+{
+	rte_free(b->ag);
+	rte_free(b->code_block);
+	rte_free(b->deint_input);
+	rte_free(b->deint_output);
+	rte_free(b->adapter_output);
+}
+
+/* Allocate decoder buffers of a worker */
+static int
+dec_bufs_alloc(struct turbo_sw_dec_bufs *b, int socket)
+{
+	b->ag = rte_zmalloc_socket(NULL,
+			RTE_BBDEV_MAX_CB_SIZE * 10 * sizeof(*b->ag),
+			RTE_CACHE_LINE_SIZE, socket);
+	b->code_block = rte_zmalloc_socket(NULL,
+			RTE_BBDEV_MAX_CB_SIZE * sizeof(*b->code_block),
+			RTE_CACHE_LINE_SIZE, socket);
+	b->deint_input = rte_zmalloc_socket(NULL,
+			DEINT_INPUT_BUF_SIZE * sizeof(*b->deint_input),
+			RTE_CACHE_LINE_SIZE, socket);
+	b->deint_output = rte_zmalloc_socket(NULL,
+			DEINT_OUTPUT_BUF_SIZE * sizeof(*b->deint_output),
+			RTE_CACHE_LINE_SIZE, socket);
+	b->adapter_output = rte_zmalloc_socket(NULL,
+			ADAPTER_OUTPUT_BUF_SIZE * sizeof(*b->adapter_output),
+			RTE_CACHE_LINE_SIZE, socket);
+
+	if (b->ag == NULL || b->code_block == NULL ||
+			b->deint_input == NULL || b->deint_output == NULL ||
+			b->adapter_output == NULL) {
+		dec_bufs_free(b);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/* Stop the decoding workers of a queue and free their resources */
+static void
+q_stop_workers(struct turbo_sw_queue *q)
+{
+	uint16_t i;
+
+	__atomic_store_n(&q->stop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < q->nb_workers; i++) {
+		pthread_join(q->workers[i].thread, NULL);
+		dec_bufs_free(&q->workers[i].dec);
+	}
+	q->nb_workers = 0;
+
+	rte_free(q->workers);
+	rte_ring_free(q->cb_ring);
+	rte_free(q->tbs);
+}
+
+/* Start the decoding workers of a queue */
+static int
+q_start_workers(struct rte_bbdev *dev, uint16_t q_id,
+		struct turbo_sw_queue *q,
+		const struct rte_bbdev_queue_conf *queue_conf,
+		uint16_t nb_workers)
+{
+	uint32_t nb_tbs = rte_align32pow2(queue_conf->queue_size);
+	char name[RTE_RING_NAMESIZE];
+	char thread_name[16];
+	struct turbo_sw_worker *w;
+	uint16_t i;
+	int ret;
+
+	q->tbs = rte_zmalloc_socket(RTE_STR(DRIVER_NAME),
+			nb_tbs * sizeof(*q->tbs), RTE_CACHE_LINE_SIZE,
+			queue_conf->socket);
+	if (q->tbs == NULL) {
+		rte_bbdev_log(ERR, "Failed to allocate queue memory");
+		return -ENOMEM;
+	}
+	q->tb_mask = nb_tbs - 1;
+
+	/* The code blocks of all the operations must fit in the ring */
+	ret = snprintf(name, RTE_RING_NAMESIZE, RTE_STR(DRIVER_NAME)"_cbs%u:%u",
+			dev->data->dev_id, q_id);
+	if ((ret < 0) || (ret >= (int)RTE_RING_NAMESIZE)) {
+		rte_bbdev_log(ERR,
+				"Creating queue name for device %u queue %u failed",
+				dev->data->dev_id, q_id);
+		return -ENAMETOOLONG;
+	}
+	q->cb_ring = rte_ring_create(name, nb_tbs * RTE_BBDEV_MAX_CODE_BLOCKS,
+			queue_conf->socket, RING_F_SP_ENQ | RING_F_EXACT_SZ);
+	if (q->cb_ring == NULL) {
+		rte_bbdev_log(ERR, "Failed to create ring for %s", name);
+		return -ENOMEM;
+	}
+
+	q->workers = rte_zmalloc_socket(RTE_STR(DRIVER_NAME),
+			nb_workers * sizeof(*q->workers), RTE_CACHE_LINE_SIZE,
+			queue_conf->socket);
+	if (q->workers == NULL) {
+		rte_bbdev_log(ERR, "Failed to allocate queue memory");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nb_workers; i++) {
+		w = &q->workers[i];
+		w->q = q;
+		ret = dec_bufs_alloc(&w->dec, queue_conf->socket);
+		if (ret != 0) {
+			rte_bbdev_log(ERR, "Failed to allocate worker memory");
+			return ret;
+		}
+
+		snprintf(thread_name, sizeof(thread_name), "tsw-%u-%u-%u",
+				dev->data->dev_id, q_id, i);
+		ret = rte_ctrl_thread_create(&w->thread, thread_name, NULL,
+				turbo_sw_worker_main, w);
+		if (ret != 0) {
+			rte_bbdev_log(ERR, "Failed to start worker %s",
+					thread_name);
+			dec_bufs_free(&w->dec);
+			return ret;
+		}
+		q->nb_workers++;
+	}
+
+	return 0;
+}
+
 /* Release queue */
 static int
 q_release(struct rte_bbdev *dev, uint16_t q_id)
@@ -192,14 +407,11 @@ q_release(struct rte_bbdev *dev, uint16_t q_id)
 	struct turbo_sw_queue *q = dev->data->queues[q_id].queue_private;
 
 	if (q != NULL) {
+		q_stop_workers(q);
 		rte_ring_free(q->processed_pkts);
 		rte_free(q->enc_out);
 		rte_free(q->enc_in);
-		rte_free(q->ag);
-		rte_free(q->code_block);
-		rte_free(q->deint_input);
-		rte_free(q->deint_output);
-		rte_free(q->adapter_output);
+		dec_bufs_free(&q->dec);
 		rte_free(q);
 		dev->data->queues[q_id].queue_private = NULL;
 	}
@@ -216,6 +428,7 @@ q_setup(struct rte_bbdev *dev, uint16_t q_id,
 {
 	int ret;
 	struct turbo_sw_queue *q;
+	struct bbdev_private *internals = dev->data->dev_private;
 	char name[RTE_RING_NAMESIZE];
 
 	/* Allocate the queue data structure. */
@@ -273,10 +486,10 @@ q_setup(struct rte_bbdev *dev, uint16_t q_id,
 				dev->data->dev_id, q_id);
 		return -ENAMETOOLONG;
 	}
-	q->ag = rte_zmalloc_socket(name,
-			RTE_BBDEV_MAX_CB_SIZE * 10 * sizeof(*q->ag),
+	q->dec.ag = rte_zmalloc_socket(name,
+			RTE_BBDEV_MAX_CB_SIZE * 10 * sizeof(*q->dec.ag),
 			RTE_CACHE_LINE_SIZE, queue_conf->socket);
-	if (q->ag == NULL) {
+	if (q->dec.ag == NULL) {
 		rte_bbdev_log(ERR,
 			"Failed to allocate queue memory for %s", name);
 		goto free_q;
@@ -291,10 +504,10 @@ q_setup(struct rte_bbdev *dev, uint16_t q_id,
 				dev->data->dev_id, q_id);
 		return -ENAMETOOLONG;
 	}
-	q->code_block = rte_zmalloc_socket(name,
-			RTE_BBDEV_MAX_CB_SIZE * sizeof(*q->code_block),
+	q->dec.code_block = rte_zmalloc_socket(name,
+			RTE_BBDEV_MAX_CB_SIZE * sizeof(*q->dec.code_block),
 			RTE_CACHE_LINE_SIZE, queue_conf->socket);
-	if (q->code_block == NULL) {
+	if (q->dec.code_block == NULL) {
 		rte_bbdev_log(ERR,
 			"Failed to allocate queue memory for %s", name);
 		goto free_q;
@@ -310,10 +523,10 @@ q_setup(struct rte_bbdev *dev, uint16_t q_id,
 				dev->data->dev_id, q_id);
 		return -ENAMETOOLONG;
 	}
-	q->deint_input = rte_zmalloc_socket(name,
-			DEINT_INPUT_BUF_SIZE * sizeof(*q->deint_input),
+	q->dec.deint_input = rte_zmalloc_socket(name,
+			DEINT_INPUT_BUF_SIZE * sizeof(*q->dec.deint_input),
 			RTE_CACHE_LINE_SIZE, queue_conf->socket);
-	if (q->deint_input == NULL) {
+	if (q->dec.deint_input == NULL) {
 		rte_bbdev_log(ERR,
 			"Failed to allocate queue memory for %s", name);
 		goto free_q;
@@ -329,10 +542,10 @@ q_setup(struct rte_bbdev *dev, uint16_t q_id,
 				dev->data->dev_id, q_id);
 		return -ENAMETOOLONG;
 	}
-	q->deint_output = rte_zmalloc_socket(NULL,
-			DEINT_OUTPUT_BUF_SIZE * sizeof(*q->deint_output),
+	q->dec.deint_output = rte_zmalloc_socket(NULL,
+			DEINT_OUTPUT_BUF_SIZE * sizeof(*q->dec.deint_output),
 			RTE_CACHE_LINE_SIZE, queue_conf->socket);
-	if (q->deint_output == NULL) {
+	if (q->dec.deint_output == NULL) {
 		rte_bbdev_log(ERR,
 			"Failed to allocate queue memory for %s", name);
 		goto free_q;
@@ -348,10 +561,11 @@ q_setup(struct rte_bbdev *dev, uint16_t q_id,
 				dev->data->dev_id, q_id);
 		return -ENAMETOOLONG;
 	}
-	q->adapter_output = rte_zmalloc_socket(NULL,
-			ADAPTER_OUTPUT_BUF_SIZE * sizeof(*q->adapter_output),
+	q->dec.adapter_output = rte_zmalloc_socket(NULL,
+			ADAPTER_OUTPUT_BUF_SIZE *
+			sizeof(*q->dec.adapter_output),
 			RTE_CACHE_LINE_SIZE, queue_conf->socket);
-	if (q->adapter_output == NULL) {
+	if (q->dec.adapter_output == NULL) {
 		rte_bbdev_log(ERR,
 			"Failed to allocate queue memory for %s", name);
 		goto free_q;
@@ -375,19 +589,23 @@ q_setup(struct rte_bbdev *dev, uint16_t q_id,
 
 	q->type = queue_conf->op_type;
 
+	if (q->type == RTE_BBDEV_OP_TURBO_DEC && internals->nb_workers > 0) {
+		ret = q_start_workers(dev, q_id, q, queue_conf,
+				internals->nb_workers);
+		if (ret != 0)
+			goto free_q;
+	}
+
 	dev->data->queues[q_id].queue_private = q;
 	rte_bbdev_log_debug("setup device queue %s", name);
 	return 0;
 
 free_q:
+	q_stop_workers(q);
 	rte_ring_free(q->processed_pkts);
 	rte_free(q->enc_out);
 	rte_free(q->enc_in);
-	rte_free(q->ag);
-	rte_free(q->code_block);
-	rte_free(q->deint_input);
-	rte_free(q->deint_output);
-	rte_free(q->adapter_output);
+	dec_bufs_free(&q->dec);
 	rte_free(q);
 	return -EFAULT;
 }
@@ -901,11 +1119,11 @@ move_padding_bytes(const uint8_t *in, uint8_t *out, uint16_t k,
 	rte_memcpy(&out[(nd - 1) + 2 * (kpi + 64)], &in[2 * kpi], d);
 }
 
-static inline void
-process_dec_cb(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op,
-		uint8_t c, uint16_t k, uint16_t kw, struct rte_mbuf *m_in,
-		struct rte_mbuf *m_out, uint16_t in_offset, uint16_t out_offset,
-		bool check_crc_24b, uint16_t crc24_overlap, uint16_t total_left)
+/* Decode a code block, returns the status bits of the operation to set */
+static inline int
+process_dec_cb(struct turbo_sw_dec_bufs *b, const struct turbo_sw_dec_tb *tb,
+		const struct turbo_sw_dec_cb *cb, uint8_t *iter_count,
+		uint16_t *out_len)
 {
 	int ret;
 	int32_t k_idx;
@@ -916,18 +1134,20 @@ process_dec_cb(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op,
 	struct bblib_turbo_adapter_ul_request adapter_req;
 	struct bblib_turbo_decoder_request turbo_req;
 	struct bblib_turbo_decoder_response turbo_resp;
-	struct rte_bbdev_op_turbo_dec *dec = &op->turbo_dec;
+	struct rte_bbdev_op_turbo_dec *dec = &tb->op->turbo_dec;
+	uint16_t k = cb->k;
+
+	*iter_count = 0;
+	*out_len = 0;
 
 	k_idx = compute_idx(k);
 
-	ret = is_dec_input_valid(k_idx, kw, total_left);
-	if (ret != 0) {
-		op->status |= 1 << RTE_BBDEV_DATA_ERROR;
-		return;
-	}
+	ret = is_dec_input_valid(k_idx, cb->kw, cb->total_left);
+	if (ret != 0)
+		return 1 << RTE_BBDEV_DATA_ERROR;
 
-	in = rte_pktmbuf_mtod_offset(m_in, uint8_t *, in_offset);
-	ncb = kw;
+	in = rte_pktmbuf_mtod_offset(dec->input.data, uint8_t *, cb->in_offset);
+	ncb = cb->kw;
 	ncb_without_null = (k + 4) * 3;
 
 	if (check_bit(dec->op_flags, RTE_BBDEV_TURBO_SUBBLOCK_DEINTERLEAVE)) {
@@ -937,73 +1157,71 @@ process_dec_cb(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op,
 		/* SW decoder accepts only a circular buffer without NULL bytes
 		 * so the input needs to be converted.
 		 */
-		remove_nulls_from_circular_buf(in, q->deint_input, k, ncb);
+		remove_nulls_from_circular_buf(in, b->deint_input, k, ncb);
 
-		deint_req.pharqbuffer = q->deint_input;
+		deint_req.pharqbuffer = b->deint_input;
 		deint_req.ncb = ncb_without_null;
-		deint_resp.pinteleavebuffer = q->deint_output;
+		deint_resp.pinteleavebuffer = b->deint_output;
 		bblib_deinterleave_ul(&deint_req, &deint_resp);
 	} else
-		move_padding_bytes(in, q->deint_output, k, ncb);
+		move_padding_bytes(in, b->deint_output, k, ncb);
 
-	adapter_input = q->deint_output;
+	adapter_input = b->deint_output;
 
 	if (dec->op_flags & RTE_BBDEV_TURBO_POS_LLR_1_BIT_IN)
 		adapter_req.isinverted = 1;
 	else if (dec->op_flags & RTE_BBDEV_TURBO_NEG_LLR_1_BIT_IN)
 		adapter_req.isinverted = 0;
 	else {
-		op->status |= 1 << RTE_BBDEV_DRV_ERROR;
 		rte_bbdev_log(ERR, "LLR format wasn't specified");
-		return;
+		return 1 << RTE_BBDEV_DRV_ERROR;
 	}
 
 	adapter_req.ncb = ncb_without_null;
 	adapter_req.pinteleavebuffer = adapter_input;
-	adapter_resp.pharqout = q->adapter_output;
+	adapter_resp.pharqout = b->adapter_output;
 	bblib_turbo_adapter_ul(&adapter_req, &adapter_resp);
 
-	out = (uint8_t *)rte_pktmbuf_append(m_out, ((k - crc24_overlap) >> 3));
-	if (out == NULL) {
-		op->status |= 1 << RTE_BBDEV_DATA_ERROR;
-		rte_bbdev_log(ERR, "Too little space in output mbuf");
-		return;
-	}
-	/* rte_bbdev_op_data.offset can be different than the offset of the
+	/* The output of all the code blocks is appended by prepare_dec_tb(),
+	 * rte_bbdev_op_data.offset can be different than the offset of the
 	 * appended bytes
 	 */
-	out = rte_pktmbuf_mtod_offset(m_out, uint8_t *, out_offset);
-	if (check_crc_24b)
-		turbo_req.c = c + 1;
+	out = rte_pktmbuf_mtod_offset(dec->hard_output.data, uint8_t *,
+			cb->out_offset);
+	if (tb->check_crc_24b)
+		turbo_req.c = tb->c + 1;
 	else
-		turbo_req.c = c;
-	turbo_req.input = (int8_t *)q->adapter_output;
+		turbo_req.c = tb->c;
+	turbo_req.input = (int8_t *)b->adapter_output;
 	turbo_req.k = k;
 	turbo_req.k_idx = k_idx;
 	turbo_req.max_iter_num = dec->iter_max;
 	turbo_req.early_term_disable = !check_bit(dec->op_flags,
 			RTE_BBDEV_TURBO_EARLY_TERMINATION);
-	turbo_resp.ag_buf = q->ag;
-	turbo_resp.cb_buf = q->code_block;
+	turbo_resp.ag_buf = b->ag;
+	turbo_resp.cb_buf = b->code_block;
 	turbo_resp.output = out;
 	iter_cnt = bblib_turbo_decoder(&turbo_req, &turbo_resp);
-	dec->hard_output.length += (k >> 3);
+	*out_len = k >> 3;
 
-	if (iter_cnt > 0) {
-		/* Temporary solution for returned iter_count from SDK */
-		iter_cnt = (iter_cnt - 1) / 2;
-		dec->iter_count = RTE_MAX(iter_cnt, dec->iter_count);
-	} else {
-		op->status |= 1 << RTE_BBDEV_DATA_ERROR;
+	if (iter_cnt <= 0) {
 		rte_bbdev_log(ERR, "Turbo Decoder failed");
-		return;
+		return 1 << RTE_BBDEV_DATA_ERROR;
 	}
+	/* Temporary solution for returned iter_count from SDK */
+	*iter_count = (iter_cnt - 1) / 2;
+
+	return 0;
 }
 
-static inline void
-enqueue_dec_one_op(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op)
+/* Split a decode operation in code blocks and append their output.
+ * Returns 0 when there are code blocks to decode, -1 otherwise, the status
+ * of the operation being set.
+ */
+static inline int
+prepare_dec_tb(struct turbo_sw_dec_tb *tb, struct rte_bbdev_dec_op *op)
 {
-	uint8_t c, r = 0;
+	uint8_t c, r;
 	uint16_t kw, k = 0;
 	uint16_t crc24_overlap = 0;
 	struct rte_bbdev_op_turbo_dec *dec = &op->turbo_dec;
@@ -1012,14 +1230,17 @@ enqueue_dec_one_op(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op)
 	uint16_t in_offset = dec->input.offset;
 	uint16_t total_left = dec->input.length;
 	uint16_t out_offset = dec->hard_output.offset;
+	uint16_t out_len = 0;
 
 	/* Clear op status */
 	op->status = 0;
+	tb->op = op;
+	tb->nb_cbs = 0;
 
 	if (m_in == NULL || m_out == NULL) {
 		rte_bbdev_log(ERR, "Invalid mbuf pointer");
 		op->status = 1 << RTE_BBDEV_DATA_ERROR;
-		return;
+		return -1;
 	}
 
 	if (dec->code_block_mode == 0) { /* For Transport Block mode */
@@ -1029,11 +1250,22 @@ enqueue_dec_one_op(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op)
 		c = 1;
 	}
 
+	/* To keep CRC24 attached to end of Code block, use
+	 * RTE_BBDEV_TURBO_DEC_TB_CRC_24B_KEEP flag as it
+	 * removed by default once verified.
+	 */
 	if ((c > 1) && !check_bit(dec->op_flags,
 		RTE_BBDEV_TURBO_DEC_TB_CRC_24B_KEEP))
 		crc24_overlap = 24;
 
-	while (total_left > 0) {
+	tb->c = c;
+	tb->crc24_overlap = crc24_overlap;
+	tb->check_crc_24b = check_bit(dec->op_flags,
+			RTE_BBDEV_TURBO_CRC_TYPE_24B);
+
+	for (r = 0; total_left > 0 && r < RTE_BBDEV_MAX_CODE_BLOCKS; r++) {
+		struct turbo_sw_dec_cb *cb = &tb->cbs[r];
+
 		if (dec->code_block_mode == 0)
 			k = (r < dec->tb_params.c_neg) ?
 				dec->tb_params.k_neg : dec->tb_params.k_pos;
@@ -1050,27 +1282,55 @@ enqueue_dec_one_op(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op)
 		 */
 		kw = RTE_ALIGN_CEIL(k + 4, RTE_BBDEV_C_SUBBLOCK) * 3;
 
-		process_dec_cb(q, op, c, k, kw, m_in, m_out, in_offset,
-				out_offset, check_bit(dec->op_flags,
-				RTE_BBDEV_TURBO_CRC_TYPE_24B), crc24_overlap,
-				total_left);
-		/* To keep CRC24 attached to end of Code block, use
-		 * RTE_BBDEV_TURBO_DEC_TB_CRC_24B_KEEP flag as it
-		 * removed by default once verified.
-		 */
+		cb->tb = tb;
+		cb->k = k;
+		cb->kw = kw;
+		cb->in_offset = in_offset;
+		cb->out_offset = out_offset;
+		cb->total_left = total_left;
 
-		/* Update total_left */
-		total_left -= kw;
+		/* Update total_left, a too short input being reported by
+		 * process_dec_cb()
+		 */
+		total_left -= RTE_MIN(kw, total_left);
 		/* Update offsets for next CBs (if exist) */
 		in_offset += kw;
 		out_offset += ((k - crc24_overlap) >> 3);
-		r++;
+		out_len += ((k - crc24_overlap) >> 3);
 	}
 	if (total_left != 0) {
 		op->status |= 1 << RTE_BBDEV_DATA_ERROR;
 		rte_bbdev_log(ERR,
 				"Mismatch between mbuf length and included Circular buffer sizes");
 	}
+
+	if (rte_pktmbuf_append(m_out, out_len) == NULL) {
+		op->status |= 1 << RTE_BBDEV_DATA_ERROR;
+		rte_bbdev_log(ERR, "Too little space in output mbuf");
+		return -1;
+	}
+
+	tb->nb_cbs = r;
+	return r > 0 ? 0 : -1;
+}
+
+static inline void
+enqueue_dec_one_op(struct turbo_sw_queue *q, struct rte_bbdev_dec_op *op)
+{
+	struct turbo_sw_dec_tb tb;
+	struct rte_bbdev_op_turbo_dec *dec = &op->turbo_dec;
+	uint8_t r, iter_count;
+	uint16_t out_len;
+
+	if (prepare_dec_tb(&tb, op) != 0)
+		return;
+
+	for (r = 0; r < tb.nb_cbs; r++) {
+		op->status |= process_dec_cb(&q->dec, &tb, &tb.cbs[r],
+				&iter_count, &out_len);
+		dec->hard_output.length += out_len;
+		dec->iter_count = RTE_MAX(iter_count, dec->iter_count);
+	}
 }
 
 static inline uint16_t
@@ -1086,6 +1346,102 @@ enqueue_dec_all_ops(struct turbo_sw_queue *q, struct rte_bbdev_dec_op **ops,
 			NULL);
 }
 
+/* Decode a code block on a worker. The worker completing the last code
+ * block of an operation merges the results into it.
+ */
+static inline void
+worker_process_cb(struct turbo_sw_dec_bufs *b, struct turbo_sw_dec_cb *cb)
+{
+	struct turbo_sw_dec_tb *tb = cb->tb;
+	struct rte_bbdev_op_turbo_dec *dec = &tb->op->turbo_dec;
+	uint8_t iter_count, cur;
+	uint16_t out_len;
+	int status;
+
+	status = process_dec_cb(b, tb, cb, &iter_count, &out_len);
+	if (status != 0)
+		__atomic_fetch_or(&tb->status, status, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&tb->hard_out_len, out_len, __ATOMIC_RELAXED);
+	cur = __atomic_load_n(&tb->iter_count, __ATOMIC_RELAXED);
+	while (iter_count > cur && !__atomic_compare_exchange_n(
+			&tb->iter_count, &cur, iter_count, 0,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+	if (__atomic_sub_fetch(&tb->remaining, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+
+	tb->op->status |= tb->status;
+	dec->hard_output.length += tb->hard_out_len;
+	dec->iter_count = RTE_MAX(tb->iter_count, dec->iter_count);
+	__atomic_store_n(&tb->done, 1, __ATOMIC_RELEASE);
+}
+
+/* Decoding worker main loop */
+static void *
+turbo_sw_worker_main(void *arg)
+{
+	struct turbo_sw_worker *w = arg;
+	struct turbo_sw_queue *q = w->q;
+	struct turbo_sw_dec_cb *cb;
+	unsigned int idle = 0;
+
+	while (!__atomic_load_n(&q->stop, __ATOMIC_RELAXED)) {
+		if (rte_ring_dequeue(q->cb_ring, (void **)&cb) != 0) {
+			if (++idle < TURBO_SW_WORKER_IDLE_SPINS)
+				rte_pause();
+			else
+				usleep(TURBO_SW_WORKER_SLEEP_US);
+			continue;
+		}
+		idle = 0;
+		worker_process_cb(&w->dec, cb);
+	}
+
+	return NULL;
+}
+
+/* Hand the code blocks of decode operations to the workers */
+static inline uint16_t
+enqueue_dec_all_ops_workers(struct turbo_sw_queue *q,
+		struct rte_bbdev_dec_op **ops, uint16_t nb_ops)
+{
+	void *cbs[RTE_BBDEV_MAX_CODE_BLOCKS];
+	struct turbo_sw_dec_tb *tb;
+	uint32_t head = q->tb_head;
+	uint32_t free_tbs;
+	uint16_t i;
+	uint8_t r;
+
+	free_tbs = q->tb_mask + 1 -
+			(head - __atomic_load_n(&q->tb_tail, __ATOMIC_ACQUIRE));
+	nb_ops = RTE_MIN(nb_ops, free_tbs);
+
+	for (i = 0; i < nb_ops; i++, head++) {
+		tb = &q->tbs[head & q->tb_mask];
+		tb->status = 0;
+		tb->hard_out_len = 0;
+		tb->iter_count = 0;
+		tb->done = 0;
+
+		if (prepare_dec_tb(tb, ops[i]) != 0) {
+			tb->done = 1;
+			continue;
+		}
+
+		tb->remaining = tb->nb_cbs;
+		for (r = 0; r < tb->nb_cbs; r++)
+			cbs[r] = &tb->cbs[r];
+		/* Cannot fail, the ring holds the code blocks of all the
+		 * operations of the queue.
+		 */
+		rte_ring_enqueue_bulk(q->cb_ring, cbs, tb->nb_cbs, NULL);
+	}
+
+	__atomic_store_n(&q->tb_head, head, __ATOMIC_RELEASE);
+	return nb_ops;
+}
+
 /* Enqueue burst */
 static uint16_t
 enqueue_enc_ops(struct rte_bbdev_queue_data *q_data,
@@ -1120,6 +1476,22 @@ enqueue_dec_ops(struct rte_bbdev_queue_data *q_data,
 	return nb_enqueued;
 }
 
+/* Enqueue burst to the decoding workers */
+static uint16_t
+enqueue_dec_ops_workers(struct rte_bbdev_queue_data *q_data,
+		 struct rte_bbdev_dec_op **ops, uint16_t nb_ops)
+{
+	struct turbo_sw_queue *q = q_data->queue_private;
+	uint16_t nb_enqueued = 0;
+
+	nb_enqueued = enqueue_dec_all_ops_workers(q, ops, nb_ops);
+
+	q_data->queue_stats.enqueue_err_count += nb_ops - nb_enqueued;
+	q_data->queue_stats.enqueued_count += nb_enqueued;
+
+	return nb_enqueued;
+}
+
 /* Dequeue decode burst */
 static uint16_t
 dequeue_dec_ops(struct rte_bbdev_queue_data *q_data,
@@ -1133,6 +1505,31 @@ dequeue_dec_ops(struct rte_bbdev_queue_data *q_data,
 	return nb_dequeued;
 }
 
+/* Dequeue decode burst from the decoding workers, in enqueue order */
+static uint16_t
+dequeue_dec_ops_workers(struct rte_bbdev_queue_data *q_data,
+		struct rte_bbdev_dec_op **ops, uint16_t nb_ops)
+{
+	struct turbo_sw_queue *q = q_data->queue_private;
+	uint32_t head = __atomic_load_n(&q->tb_head, __ATOMIC_ACQUIRE);
+	uint32_t tail = q->tb_tail;
+	struct turbo_sw_dec_tb *tb;
+	uint16_t nb_dequeued;
+
+	for (nb_dequeued = 0; nb_dequeued < nb_ops && tail != head;
+			nb_dequeued++, tail++) {
+		tb = &q->tbs[tail & q->tb_mask];
+		if (!__atomic_load_n(&tb->done, __ATOMIC_ACQUIRE))
+			break;
+		ops[nb_dequeued] = tb->op;
+	}
+
+	__atomic_store_n(&q->tb_tail, tail, __ATOMIC_RELEASE);
+	q_data->queue_stats.dequeued_count += nb_dequeued;
+
+	return nb_dequeued;
+}
+
 /* Dequeue encode burst */
 static uint16_t
 dequeue_enc_ops(struct rte_bbdev_queue_data *q_data,
@@ -1194,6 +1591,18 @@ parse_turbo_sw_params(struct turbo_sw_params *params, const char *input_args)
 					RTE_MAX_NUMA_NODES);
 			goto exit;
 		}
+
+		ret = rte_kvargs_process(kvlist, turbo_sw_valid_params[2],
+					&parse_u16_arg, &params->workers_num);
+		if (ret < 0)
+			goto exit;
+
+		if (params->workers_num > TURBO_SW_MAX_WORKERS) {
+			rte_bbdev_log(ERR, "Invalid workers, must be <= %u",
+					TURBO_SW_MAX_WORKERS);
+			ret = -EINVAL;
+			goto exit;
+		}
 	}
 
 exit:
@@ -1229,11 +1638,18 @@ turbo_sw_bbdev_create(struct rte_vdev_device *vdev,
 
 	/* register rx/tx burst functions for data path */
 	bbdev->dequeue_enc_ops = dequeue_enc_ops;
-	bbdev->dequeue_dec_ops = dequeue_dec_ops;
 	bbdev->enqueue_enc_ops = enqueue_enc_ops;
-	bbdev->enqueue_dec_ops = enqueue_dec_ops;
+	if (init_params->workers_num > 0) {
+		bbdev->dequeue_dec_ops = dequeue_dec_ops_workers;
+		bbdev->enqueue_dec_ops = enqueue_dec_ops_workers;
+	} else {
+		bbdev->dequeue_dec_ops = dequeue_dec_ops;
+		bbdev->enqueue_dec_ops = enqueue_dec_ops;
+	}
 	((struct bbdev_private *) bbdev->data->dev_private)->max_nb_queues =
 			init_params->queues_num;
+	((struct bbdev_private *) bbdev->data->dev_private)->nb_workers =
+			init_params->workers_num;
 
 	return 0;
 }
@@ -1244,7 +1660,8 @@ turbo_sw_bbdev_probe(struct rte_vdev_device *vdev)
 {
 	struct turbo_sw_params init_params = {
 		rte_socket_id(),
-		RTE_BBDEV_DEFAULT_MAX_NB_QUEUES
+		RTE_BBDEV_DEFAULT_MAX_NB_QUEUES,
+		0
 	};
 	const char *name;
 	const char *input_args;
@@ -1259,8 +1676,9 @@ turbo_sw_bbdev_probe(struct rte_vdev_device *vdev)
 	parse_turbo_sw_params(&init_params, input_args);
 
 	rte_bbdev_log_debug(
-			"Initialising %s on NUMA node %d with max queues: %d\n",
-			name, init_params.socket_id, init_params.queues_num);
+			"Initialising %s on NUMA node %d with max queues: %d, workers: %d\n",
+			name, init_params.socket_id, init_params.queues_num,
+			init_params.workers_num);
 
 	return turbo_sw_bbdev_create(vdev, &init_params);
 }
@@ -1296,7 +1714,8 @@ static struct rte_vdev_driver bbdev_turbo_sw_pmd_drv = {
 RTE_PMD_REGISTER_VDEV(DRIVER_NAME, bbdev_turbo_sw_pmd_drv);
 RTE_PMD_REGISTER_PARAM_STRING(DRIVER_NAME,
 	TURBO_SW_MAX_NB_QUEUES_ARG"=<int> "
-	TURBO_SW_SOCKET_ID_ARG"=<int>");
+	TURBO_SW_SOCKET_ID_ARG"=<int> "
+	TURBO_SW_WORKERS_ARG"=<int>");
 RTE_PMD_REGISTER_ALIAS(DRIVER_NAME, turbo_sw);
 
 RTE_INIT(turbo_sw_bbdev_init_log)
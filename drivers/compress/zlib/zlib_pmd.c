@@ -2,11 +2,21 @@
  * Copyright(c) 2018 Cavium Networks
  */
 
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
 #include <rte_bus_vdev.h>
 #include <rte_common.h>
+#include <rte_kvargs.h>
+#include <rte_pause.h>
 
 #include "zlib_pmd_private.h"
 
+/* Busy polls of an idle worker before it sleeps between polls */
+#define ZLIB_WORKER_IDLE_SPINS		4096
+#define ZLIB_WORKER_IDLE_SLEEP_US	10
+
 /** Compute next mbuf in the list, assign data buffer and length,
  *  returns 0 if mbuf is NULL
  */
@@ -18,25 +28,47 @@
 static void
 process_zlib_deflate(struct rte_comp_op *op, z_stream *strm)
 {
-	int ret, flush, fin_flush;
+	int ret = Z_OK, flush, fin_flush;
+	int stateful = (op->op_type == RTE_COMP_OP_STATEFUL);
 	struct rte_mbuf *mbuf_src = op->m_src;
 	struct rte_mbuf *mbuf_dst = op->m_dst;
+	uLong total_in, total_out;
+
+	if (unlikely(!strm)) {
+		op->status = RTE_COMP_OP_STATUS_INVALID_ARGS;
+		ZLIB_PMD_ERR("Invalid z_stream\n");
+		return;
+	}
 
+	/* A stateless op always ends the stream, a stateful one only when
+	 * it is the last one of the stream.
+	 */
 	switch (op->flush_flag) {
+	case RTE_COMP_FLUSH_NONE:
+		fin_flush = Z_NO_FLUSH;
+		break;
+	case RTE_COMP_FLUSH_SYNC:
+		fin_flush = Z_SYNC_FLUSH;
+		break;
 	case RTE_COMP_FLUSH_FULL:
+		fin_flush = stateful ? Z_FULL_FLUSH : Z_FINISH;
+		break;
 	case RTE_COMP_FLUSH_FINAL:
 		fin_flush = Z_FINISH;
 		break;
 	default:
-		op->status = RTE_COMP_OP_STATUS_INVALID_ARGS;
-		ZLIB_PMD_ERR("Invalid flush value\n");
+		fin_flush = -1;
 	}
-
-	if (unlikely(!strm)) {
+	if (fin_flush < 0 || (!stateful && fin_flush != Z_FINISH)) {
 		op->status = RTE_COMP_OP_STATUS_INVALID_ARGS;
-		ZLIB_PMD_ERR("Invalid z_stream\n");
+		ZLIB_PMD_ERR("Invalid flush value\n");
 		return;
 	}
+
+	/* the totals of a stateful stream include its previous ops */
+	total_in = strm->total_in;
+	total_out = strm->total_out;
+
 	/* Update z_stream with the inputs provided by application */
 	strm->next_in = rte_pktmbuf_mtod_offset(mbuf_src, uint8_t *,
 			op->src.offset);
@@ -54,9 +86,11 @@ process_zlib_deflate(struct rte_comp_op *op, z_stream *strm)
 	op->status = RTE_COMP_OP_STATUS_SUCCESS;
 
 	do {
-		/* Set flush value to Z_FINISH for last block */
-		if ((op->src.length - strm->total_in) <= strm->avail_in) {
-			strm->avail_in = (op->src.length - strm->total_in);
+		/* Set flush value of the op for last block */
+		if ((op->src.length - (strm->total_in - total_in)) <=
+				strm->avail_in) {
+			strm->avail_in = op->src.length -
+				(strm->total_in - total_in);
 			flush = fin_flush;
 		}
 		do {
@@ -85,37 +119,55 @@ process_zlib_deflate(struct rte_comp_op *op, z_stream *strm)
 	/* Update source buffer to next mbuf
 	 * Exit if input buffers are fully consumed
 	 */
-	} while (COMPUTE_BUF(mbuf_src, strm->next_in, strm->avail_in));
+	} while ((strm->total_in - total_in) < op->src.length &&
+		COMPUTE_BUF(mbuf_src, strm->next_in, strm->avail_in));
 
 def_end:
 	/* Update op stats */
 	switch (op->status) {
 	case RTE_COMP_OP_STATUS_SUCCESS:
-		op->consumed += strm->total_in;
+		op->consumed += strm->total_in - total_in;
 	/* Fall-through */
 	case RTE_COMP_OP_STATUS_OUT_OF_SPACE_TERMINATED:
-		op->produced += strm->total_out;
+		op->produced += strm->total_out - total_out;
 		break;
 	default:
 		ZLIB_PMD_ERR("stats not updated for status:%d\n",
 				op->status);
 	}
 
-	deflateReset(strm);
+	/* A stateful op may be resumed from where the output ran out */
+	if (stateful && op->status ==
+			RTE_COMP_OP_STATUS_OUT_OF_SPACE_TERMINATED) {
+		op->status = RTE_COMP_OP_STATUS_OUT_OF_SPACE_RECOVERABLE;
+		op->consumed += strm->total_in - total_in;
+		return;
+	}
+
+	if (!stateful || ret == Z_STREAM_END ||
+			op->status != RTE_COMP_OP_STATUS_SUCCESS)
+		deflateReset(strm);
 }
 
 static void
 process_zlib_inflate(struct rte_comp_op *op, z_stream *strm)
 {
-	int ret, flush;
+	int ret = Z_OK, flush;
+	int stateful = (op->op_type == RTE_COMP_OP_STATEFUL);
 	struct rte_mbuf *mbuf_src = op->m_src;
 	struct rte_mbuf *mbuf_dst = op->m_dst;
+	uLong total_in, total_out;
 
 	if (unlikely(!strm)) {
 		op->status = RTE_COMP_OP_STATUS_INVALID_ARGS;
 		ZLIB_PMD_ERR("Invalid z_stream\n");
 		return;
 	}
+
+	/* the totals of a stateful stream include its previous ops */
+	total_in = strm->total_in;
+	total_out = strm->total_out;
+
 	strm->next_in = rte_pktmbuf_mtod_offset(mbuf_src, uint8_t *,
 			op->src.offset);
 
@@ -132,6 +184,11 @@ process_zlib_inflate(struct rte_comp_op *op, z_stream *strm)
 	op->status = RTE_COMP_OP_STATUS_SUCCESS;
 
 	do {
+		/* Do not read beyond the input of the op */
+		if ((op->src.length - (strm->total_in - total_in)) <=
+				strm->avail_in)
+			strm->avail_in = op->src.length -
+				(strm->total_in - total_in);
 		do {
 			ret = inflate(strm, flush);
 
@@ -171,43 +228,69 @@ process_zlib_inflate(struct rte_comp_op *op, z_stream *strm)
 	/* Read next input buffer to be processed, exit if compressed
 	 * blocks are fully read
 	 */
-	} while (COMPUTE_BUF(mbuf_src, strm->next_in, strm->avail_in));
+	} while ((strm->total_in - total_in) < op->src.length &&
+		COMPUTE_BUF(mbuf_src, strm->next_in, strm->avail_in));
 
 inf_end:
 	/* Update op stats */
 	switch (op->status) {
 	case RTE_COMP_OP_STATUS_SUCCESS:
-		op->consumed += strm->total_in;
+		op->consumed += strm->total_in - total_in;
 	/* Fall-through */
 	case RTE_COMP_OP_STATUS_OUT_OF_SPACE_TERMINATED:
-		op->produced += strm->total_out;
+		op->produced += strm->total_out - total_out;
 		break;
 	default:
 		ZLIB_PMD_ERR("stats not produced for status:%d\n",
 				op->status);
 	}
 
-	inflateReset(strm);
+	/* A stateful op may be resumed from where the output ran out */
+	if (stateful && op->status ==
+			RTE_COMP_OP_STATUS_OUT_OF_SPACE_TERMINATED) {
+		op->status = RTE_COMP_OP_STATUS_OUT_OF_SPACE_RECOVERABLE;
+		op->consumed += strm->total_in - total_in;
+		return;
+	}
+
+	if (!stateful || ret == Z_STREAM_END ||
+			op->status != RTE_COMP_OP_STATUS_SUCCESS)
+		inflateReset(strm);
 }
 
-/** Process comp operation for mbuf */
-static inline int
-process_zlib_op(struct zlib_qp *qp, struct rte_comp_op *op)
+/** Process comp operation with the stream of its xform or stateful stream */
+static inline void
+zlib_process_op(struct rte_comp_op *op, struct zlib_stream *stream)
 {
-	struct zlib_stream *stream;
-	struct zlib_priv_xform *private_xform;
-
-	if ((op->op_type == RTE_COMP_OP_STATEFUL) ||
+	if (unlikely(stream == NULL ||
 			(op->src.offset > rte_pktmbuf_data_len(op->m_src)) ||
-			(op->dst.offset > rte_pktmbuf_data_len(op->m_dst))) {
+			(op->dst.offset > rte_pktmbuf_data_len(op->m_dst)))) {
 		op->status = RTE_COMP_OP_STATUS_INVALID_ARGS;
 		ZLIB_PMD_ERR("Invalid source or destination buffers or "
 			     "invalid Operation requested\n");
-	} else {
-		private_xform = (struct zlib_priv_xform *)op->private_xform;
-		stream = &private_xform->stream;
-		stream->comp(op, &stream->strm);
+		return;
 	}
+
+	stream->comp(op, &stream->strm);
+}
+
+static inline struct zlib_stream *
+zlib_op_stream(struct rte_comp_op *op)
+{
+	struct zlib_priv_xform *private_xform;
+
+	if (op->op_type == RTE_COMP_OP_STATEFUL)
+		return op->stream;
+
+	private_xform = (struct zlib_priv_xform *)op->private_xform;
+	return &private_xform->stream;
+}
+
+/** Process comp operation for mbuf */
+static inline int
+process_zlib_op(struct zlib_qp *qp, struct rte_comp_op *op)
+{
+	zlib_process_op(op, zlib_op_stream(op));
 	/* whatever is out of op, put it into completion queue with
 	 * its status
 	 */
@@ -350,12 +433,226 @@ zlib_pmd_dequeue_burst(void *queue_pair,
 	return nb_dequeued;
 }
 
+/** Stream of a worker configured for the private xform of an op */
+static struct zlib_stream *
+zlib_worker_stream(struct zlib_worker *worker, struct rte_comp_op *op)
+{
+	struct zlib_priv_xform *private_xform = op->private_xform;
+	struct zlib_stream *stream;
+	uint64_t *id;
+
+	if (private_xform->xform.type == RTE_COMP_COMPRESS) {
+		stream = &worker->def;
+		id = &worker->def_id;
+	} else {
+		stream = &worker->inf;
+		id = &worker->inf_id;
+	}
+
+	if (likely(*id == private_xform->id))
+		return stream;
+
+	if (*id != 0)
+		stream->free(&stream->strm);
+	*id = 0;
+	if (zlib_set_stream_parameters(&private_xform->xform, stream) < 0)
+		return NULL;
+	*id = private_xform->id;
+
+	return stream;
+}
+
+/** Worker thread, processing the stateless ops of a queue pair */
+void *
+zlib_worker_main(void *arg)
+{
+	struct zlib_worker *worker = arg;
+	struct zlib_qp *qp = worker->qp;
+	struct zlib_op_slot *slot;
+	uint32_t n, idle = 0;
+
+	while (!qp->stop) {
+		n = __atomic_load_n(&qp->next, __ATOMIC_RELAXED);
+		if (n == __atomic_load_n(&qp->head, __ATOMIC_ACQUIRE)) {
+			if (++idle < ZLIB_WORKER_IDLE_SPINS)
+				rte_pause();
+			else
+				usleep(ZLIB_WORKER_IDLE_SLEEP_US);
+			continue;
+		}
+		if (!__atomic_compare_exchange_n(&qp->next, &n, n + 1, 0,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			continue;
+		idle = 0;
+
+		slot = &qp->slots[n & qp->slot_mask];
+		if (!slot->skip)
+			zlib_process_op(slot->op,
+				zlib_worker_stream(worker, slot->op));
+
+		__atomic_store_n(&slot->done, 1, __ATOMIC_RELEASE);
+	}
+
+	if (worker->def_id != 0)
+		worker->def.free(&worker->def.strm);
+	if (worker->inf_id != 0)
+		worker->inf.free(&worker->inf.strm);
+
+	return NULL;
+}
+
+/*
+ * When the queue pair is served by workers, the enqueue only fills the
+ * slots, except for the stateful ops which are processed in order here,
+ * and the dequeue returns the ops processed by the workers.
+ */
+static uint16_t
+zlib_pmd_enqueue_burst_workers(void *queue_pair,
+			struct rte_comp_op **ops, uint16_t nb_ops)
+{
+	struct zlib_qp *qp = queue_pair;
+	struct zlib_op_slot *slot;
+	uint32_t head, free_slots;
+	uint16_t i, enqd;
+
+	head = qp->head;
+	free_slots = qp->slot_mask + 1 -
+		(head - __atomic_load_n(&qp->tail, __ATOMIC_ACQUIRE));
+	enqd = RTE_MIN(nb_ops, free_slots);
+
+	for (i = 0; i < enqd; i++) {
+		slot = &qp->slots[(head + i) & qp->slot_mask];
+		slot->op = ops[i];
+		slot->done = 0;
+		slot->skip = (ops[i]->op_type == RTE_COMP_OP_STATEFUL);
+		if (slot->skip)
+			zlib_process_op(ops[i], ops[i]->stream);
+	}
+
+	__atomic_store_n(&qp->head, head + enqd, __ATOMIC_RELEASE);
+
+	qp->qp_stats.enqueued_count += enqd;
+	qp->qp_stats.enqueue_err_count += nb_ops - enqd;
+
+	return enqd;
+}
+
+static uint16_t
+zlib_pmd_dequeue_burst_workers(void *queue_pair,
+			struct rte_comp_op **ops, uint16_t nb_ops)
+{
+	struct zlib_qp *qp = queue_pair;
+	struct zlib_op_slot *slot;
+	uint32_t tail = qp->tail;
+	uint16_t nb_dequeued = 0;
+
+	while (nb_dequeued < nb_ops &&
+			tail != __atomic_load_n(&qp->head, __ATOMIC_ACQUIRE)) {
+		slot = &qp->slots[tail & qp->slot_mask];
+		if (!__atomic_load_n(&slot->done, __ATOMIC_ACQUIRE))
+			break;
+		ops[nb_dequeued++] = slot->op;
+		tail++;
+	}
+
+	__atomic_store_n(&qp->tail, tail, __ATOMIC_RELEASE);
+	qp->qp_stats.dequeued_count += nb_dequeued;
+
+	return nb_dequeued;
+}
+
+/**
+ * Parse unsigned integer from argument
+ */
+static int
+zlib_parse_uint_arg(const char *key __rte_unused,
+		const char *value, void *extra_args)
+{
+	int i;
+	char *end;
+
+	errno = 0;
+	i = strtol(value, &end, 10);
+	if (*end != 0 || errno != 0 || i < 0)
+		return -EINVAL;
+
+	*((uint32_t *)extra_args) = i;
+	return 0;
+}
+
+/**
+ * Parse name from argument
+ */
+static int
+zlib_parse_name_arg(const char *key __rte_unused,
+		const char *value, void *extra_args)
+{
+	struct rte_compressdev_pmd_init_params *params = extra_args;
+	int n;
+
+	n = snprintf(params->name, RTE_COMPRESSDEV_NAME_MAX_LEN, "%s", value);
+	if (n >= RTE_COMPRESSDEV_NAME_MAX_LEN)
+		return -EINVAL;
+
+	return 0;
+}
+
+static const char * const zlib_valid_params[] = {
+	RTE_COMPRESSDEV_PMD_NAME_ARG,
+	RTE_COMPRESSDEV_PMD_SOCKET_ID_ARG,
+	ZLIB_PMD_WORKERS_ARG,
+	NULL
+};
+
+/** Parse the generic parameters and the number of workers */
+static int
+zlib_parse_input_args(struct rte_compressdev_pmd_init_params *params,
+		uint32_t *nb_workers, const char *args)
+{
+	struct rte_kvargs *kvlist;
+	int ret;
+
+	if (args == NULL)
+		return 0;
+
+	kvlist = rte_kvargs_parse(args, zlib_valid_params);
+	if (kvlist == NULL)
+		return -EINVAL;
+
+	ret = rte_kvargs_process(kvlist, RTE_COMPRESSDEV_PMD_SOCKET_ID_ARG,
+			&zlib_parse_uint_arg, &params->socket_id);
+	if (ret < 0)
+		goto free_kvlist;
+
+	ret = rte_kvargs_process(kvlist, RTE_COMPRESSDEV_PMD_NAME_ARG,
+			&zlib_parse_name_arg, params);
+	if (ret < 0)
+		goto free_kvlist;
+
+	ret = rte_kvargs_process(kvlist, ZLIB_PMD_WORKERS_ARG,
+			&zlib_parse_uint_arg, nb_workers);
+	if (ret < 0)
+		goto free_kvlist;
+
+	if (*nb_workers > ZLIB_PMD_MAX_WORKERS) {
+		ZLIB_PMD_ERR("At most %u workers per queue pair",
+				ZLIB_PMD_MAX_WORKERS);
+		ret = -EINVAL;
+	}
+
+free_kvlist:
+	rte_kvargs_free(kvlist);
+	return ret;
+}
+
 static int
 zlib_create(const char *name,
 		struct rte_vdev_device *vdev,
-		struct rte_compressdev_pmd_init_params *init_params)
+		struct rte_compressdev_pmd_init_params *init_params,
+		uint32_t nb_workers)
 {
 	struct rte_compressdev *dev;
+	struct zlib_private *internals;
 
 	dev = rte_compressdev_pmd_create(name, &vdev->device,
 			sizeof(struct zlib_private), init_params);
@@ -366,9 +663,17 @@ zlib_create(const char *name,
 
 	dev->dev_ops = rte_zlib_pmd_ops;
 
+	internals = dev->data->dev_private;
+	internals->nb_workers = nb_workers;
+
 	/* register rx/tx burst functions for data path */
-	dev->dequeue_burst = zlib_pmd_dequeue_burst;
-	dev->enqueue_burst = zlib_pmd_enqueue_burst;
+	if (nb_workers != 0) {
+		dev->dequeue_burst = zlib_pmd_dequeue_burst_workers;
+		dev->enqueue_burst = zlib_pmd_enqueue_burst_workers;
+	} else {
+		dev->dequeue_burst = zlib_pmd_dequeue_burst;
+		dev->enqueue_burst = zlib_pmd_enqueue_burst;
+	}
 
 	return 0;
 }
@@ -382,6 +687,7 @@ zlib_probe(struct rte_vdev_device *vdev)
 	};
 	const char *name;
 	const char *input_args;
+	uint32_t nb_workers = 0;
 	int retval;
 
 	name = rte_vdev_device_name(vdev);
@@ -391,7 +697,7 @@ zlib_probe(struct rte_vdev_device *vdev)
 
 	input_args = rte_vdev_device_args(vdev);
 
-	retval = rte_compressdev_pmd_parse_input_args(&init_params, input_args);
+	retval = zlib_parse_input_args(&init_params, &nb_workers, input_args);
 	if (retval < 0) {
 		ZLIB_PMD_LOG(ERR,
 			"Failed to parse initialisation arguments[%s]\n",
@@ -399,7 +705,7 @@ zlib_probe(struct rte_vdev_device *vdev)
 		return -EINVAL;
 	}
 
-	return zlib_create(name, vdev, &init_params);
+	return zlib_create(name, vdev, &init_params, nb_workers);
 }
 
 static int
@@ -425,6 +731,9 @@ static struct rte_vdev_driver zlib_pmd_drv = {
 };
 
 RTE_PMD_REGISTER_VDEV(COMPRESSDEV_NAME_ZLIB_PMD, zlib_pmd_drv);
+RTE_PMD_REGISTER_PARAM_STRING(COMPRESSDEV_NAME_ZLIB_PMD,
+	"socket_id=<int> "
+	"workers=<int>");
 
 RTE_INIT(zlib_init_log)
 {
@@ -14,7 +14,9 @@ static const struct rte_compressdev_capabilities zlib_pmd_capabilities[] = {
 		.algo = RTE_COMP_ALGO_DEFLATE,
 		.comp_feature_flags = (RTE_COMP_FF_NONCOMPRESSED_BLOCKS |
 					RTE_COMP_FF_HUFFMAN_FIXED |
-					RTE_COMP_FF_HUFFMAN_DYNAMIC),
+					RTE_COMP_FF_HUFFMAN_DYNAMIC |
+					RTE_COMP_FF_STATEFUL_COMPRESSION |
+					RTE_COMP_FF_STATEFUL_DECOMPRESSION),
 		.window_size = {
 			.min = 8,
 			.max = 15,
@@ -122,6 +124,65 @@ zlib_pmd_info_get(struct rte_compressdev *dev,
 	}
 }
 
+/** Stop the workers of a queue pair and free its slots */
+static void
+zlib_pmd_qp_stop_workers(struct zlib_qp *qp)
+{
+	uint16_t i;
+
+	qp->stop = 1;
+	for (i = 0; i < qp->nb_workers; i++)
+		pthread_join(qp->workers[i].thread, NULL);
+	qp->nb_workers = 0;
+
+	rte_free(qp->workers);
+	qp->workers = NULL;
+	rte_free(qp->slots);
+	qp->slots = NULL;
+}
+
+/** Create the slots and workers of a queue pair */
+static int
+zlib_pmd_qp_start_workers(struct rte_compressdev *dev, struct zlib_qp *qp,
+		uint32_t max_inflight_ops, int socket_id)
+{
+	struct zlib_private *internals = dev->data->dev_private;
+	char name[RTE_MAX_THREAD_NAME_LEN];
+	struct zlib_worker *worker;
+	uint32_t nb_slots = rte_align32pow2(max_inflight_ops);
+	uint16_t i;
+	int ret;
+
+	qp->slots = rte_zmalloc_socket("ZLIB PMD op slots",
+			nb_slots * sizeof(*qp->slots), RTE_CACHE_LINE_SIZE,
+			socket_id);
+	qp->workers = rte_zmalloc_socket("ZLIB PMD workers",
+			internals->nb_workers * sizeof(*qp->workers),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (qp->slots == NULL || qp->workers == NULL) {
+		zlib_pmd_qp_stop_workers(qp);
+		return -ENOMEM;
+	}
+	qp->slot_mask = nb_slots - 1;
+
+	for (i = 0; i < internals->nb_workers; i++) {
+		worker = &qp->workers[i];
+		worker->qp = qp;
+		snprintf(name, sizeof(name), "zlib-%u-%u-%u",
+				dev->data->dev_id, qp->id, i);
+		ret = rte_ctrl_thread_create(&worker->thread, name, NULL,
+				zlib_worker_main, worker);
+		if (ret != 0) {
+			ZLIB_PMD_ERR("Cannot create worker thread %s", name);
+			zlib_pmd_qp_stop_workers(qp);
+			return ret;
+		}
+		qp->nb_workers++;
+	}
+
+	return 0;
+}
+
 /** Release queue pair */
 static int
 zlib_pmd_qp_release(struct rte_compressdev *dev, uint16_t qp_id)
@@ -129,6 +190,7 @@ zlib_pmd_qp_release(struct rte_compressdev *dev, uint16_t qp_id)
 	struct zlib_qp *qp = dev->data->queue_pairs[qp_id];
 
 	if (qp != NULL) {
+		zlib_pmd_qp_stop_workers(qp);
 		rte_ring_free(qp->processed_pkts);
 		rte_free(qp);
 		dev->data->queue_pairs[qp_id] = NULL;
@@ -179,6 +241,7 @@ static int
 zlib_pmd_qp_setup(struct rte_compressdev *dev, uint16_t qp_id,
 		uint32_t max_inflight_ops, int socket_id)
 {
+	struct zlib_private *internals = dev->data->dev_private;
 	struct zlib_qp *qp = NULL;
 
 	/* Free memory prior to re-allocation if needed. */
@@ -197,10 +260,16 @@ zlib_pmd_qp_setup(struct rte_compressdev *dev, uint16_t qp_id,
 	if (zlib_pmd_qp_set_unique_name(dev, qp))
 		goto qp_setup_cleanup;
 
-	qp->processed_pkts = zlib_pmd_qp_create_processed_pkts_ring(qp,
-			max_inflight_ops, socket_id);
-	if (qp->processed_pkts == NULL)
-		goto qp_setup_cleanup;
+	if (internals->nb_workers != 0) {
+		if (zlib_pmd_qp_start_workers(dev, qp, max_inflight_ops,
+				socket_id))
+			goto qp_setup_cleanup;
+	} else {
+		qp->processed_pkts = zlib_pmd_qp_create_processed_pkts_ring(qp,
+				max_inflight_ops, socket_id);
+		if (qp->processed_pkts == NULL)
+			goto qp_setup_cleanup;
+	}
 
 	memset(&qp->qp_stats, 0, sizeof(qp->qp_stats));
 	return 0;
@@ -209,6 +278,7 @@ zlib_pmd_qp_setup(struct rte_compressdev *dev, uint16_t qp_id,
 	if (qp) {
 		rte_free(qp);
 		qp = NULL;
+		dev->data->queue_pairs[qp_id] = NULL;
 	}
 	return -1;
 }
@@ -254,7 +324,20 @@ zlib_pmd_private_xform_create(struct rte_compressdev *dev,
 		const struct rte_comp_xform *xform,
 		void **private_xform)
 {
-	return zlib_pmd_stream_create(dev, xform, private_xform);
+	static uint64_t xform_id;
+	struct zlib_priv_xform *priv_xform;
+	int ret;
+
+	ret = zlib_pmd_stream_create(dev, xform, private_xform);
+	if (ret < 0)
+		return ret;
+
+	/* the workers configure their own streams from these parameters */
+	priv_xform = *private_xform;
+	priv_xform->xform = *xform;
+	priv_xform->id = __atomic_add_fetch(&xform_id, 1, __ATOMIC_RELAXED);
+
+	return 0;
 }
 
 /** Clear the memory of stream so it doesn't leave key material behind */
@@ -300,8 +383,8 @@ struct rte_compressdev_ops zlib_pmd_ops = {
 		.private_xform_create	= zlib_pmd_private_xform_create,
 		.private_xform_free	= zlib_pmd_private_xform_free,
 
-		.stream_create	= NULL,
-		.stream_free	= NULL
+		.stream_create	= zlib_pmd_stream_create,
+		.stream_free	= zlib_pmd_stream_free
 };
 
 struct rte_compressdev_ops *rte_zlib_pmd_ops = &zlib_pmd_ops;
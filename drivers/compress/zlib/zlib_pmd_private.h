@@ -5,6 +5,7 @@
 #ifndef _RTE_ZLIB_PMD_PRIVATE_H_
 #define _RTE_ZLIB_PMD_PRIVATE_H_
 
+#include <pthread.h>
 #include <zlib.h>
 #include <rte_compressdev.h>
 #include <rte_compressdev_pmd.h>
@@ -14,6 +15,11 @@
 
 #define DEF_MEM_LEVEL			8
 
+#define ZLIB_PMD_WORKERS_ARG		("workers")
+/**< Number of worker threads per queue pair */
+#define ZLIB_PMD_MAX_WORKERS		32
+/**< Maximum number of worker threads per queue pair */
+
 int zlib_logtype_driver;
 #define ZLIB_PMD_LOG(level, fmt, args...) \
 	rte_log(RTE_LOG_ ## level, zlib_logtype_driver, "%s(): "fmt "\n", \
@@ -28,19 +34,10 @@ int zlib_logtype_driver;
 
 struct zlib_private {
 	struct rte_mempool *mp;
+	uint16_t nb_workers;
+	/**< Number of worker threads per queue pair, 0 for none */
 };
 
-struct zlib_qp {
-	struct rte_ring *processed_pkts;
-	/**< Ring for placing process packets */
-	struct rte_compressdev_stats qp_stats;
-	/**< Queue pair statistics */
-	uint16_t id;
-	/**< Queue Pair Identifier */
-	char name[RTE_COMPRESSDEV_NAME_MAX_LEN];
-	/**< Unique Queue Pair Name */
-} __rte_cache_aligned;
-
 /* Algorithm handler function prototype */
 typedef void (*comp_func_t)(struct rte_comp_op *op, z_stream *strm);
 
@@ -59,12 +56,70 @@ struct zlib_stream {
 /** ZLIB private xform structure */
 struct zlib_priv_xform {
 	struct zlib_stream stream;
+	struct rte_comp_xform xform;
+	/**< Parameters of the xform, to configure the worker streams */
+	uint64_t id;
+	/**< Unique identifier of the xform */
+} __rte_cache_aligned;
+
+/** Slot of an op in the ring of a queue pair served by workers */
+struct zlib_op_slot {
+	struct rte_comp_op *op;
+	uint32_t skip;
+	/**< Set when the op was processed by enqueue */
+	volatile uint32_t done;
+	/**< Set by the worker which claimed the slot, once the op is
+	processed */
+};
+
+struct zlib_qp;
+
+/** Worker thread of a queue pair */
+struct zlib_worker {
+	pthread_t thread;
+	struct zlib_qp *qp;
+	struct zlib_stream def;
+	/**< Compression stream, configured for the xform def_id */
+	struct zlib_stream inf;
+	/**< Decompression stream, configured for the xform inf_id */
+	uint64_t def_id;
+	uint64_t inf_id;
+} __rte_cache_aligned;
+
+struct zlib_qp {
+	struct rte_ring *processed_pkts;
+	/**< Ring for placing process packets */
+	struct rte_compressdev_stats qp_stats;
+	/**< Queue pair statistics */
+	uint16_t id;
+	/**< Queue Pair Identifier */
+	char name[RTE_COMPRESSDEV_NAME_MAX_LEN];
+	/**< Unique Queue Pair Name */
+
+	/* When the queue pair is served by workers, the ops are placed in
+	 * the slots in enqueue order, claimed by the workers and returned
+	 * in enqueue order once processed.
+	 */
+	struct zlib_op_slot *slots;
+	uint32_t slot_mask;
+	uint32_t head;
+	/**< Next slot to fill, written by enqueue */
+	uint32_t tail;
+	/**< Next slot to return, written by dequeue */
+	uint32_t next __rte_cache_aligned;
+	/**< Next slot to process, claimed by the workers */
+	volatile int stop;
+	struct zlib_worker *workers;
+	uint16_t nb_workers;
 } __rte_cache_aligned;
 
 int
 zlib_set_stream_parameters(const struct rte_comp_xform *xform,
 		struct zlib_stream *stream);
 
+void *
+zlib_worker_main(void *arg);
+
 /** Device specific operations function pointer structure */
 extern struct rte_compressdev_ops *rte_zlib_pmd_ops;
 
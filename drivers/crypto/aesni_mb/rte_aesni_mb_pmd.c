@@ -690,27 +690,80 @@ get_session(struct aesni_mb_qp *qp, struct rte_crypto_op *op)
 	return sess;
 }
 
+/**
+ * Take a batch of operations from the ingress queue and get their sessions
+ * ahead of the job submissions, so that the loads of the operations, of
+ * the sessions and of the mbufs overlap. Bursts mixing many sessions,
+ * as with many IPsec tunnels, would otherwise stall on each of them.
+ * Consecutive operations of a session share a single lookup.
+ *
+ * @param	qp	queue pair
+ *
+ * @return
+ * - Number of operations in the batch
+ */
+static inline uint16_t
+prepare_mb_batch(struct aesni_mb_qp *qp)
+{
+	struct rte_crypto_op **ops = qp->batch_ops;
+	struct rte_cryptodev_sym_session *last = NULL;
+	struct aesni_mb_session *sess = NULL;
+	uint16_t i, nb_ops;
+
+	nb_ops = rte_ring_dequeue_burst(qp->ingress_queue, (void **)ops,
+			AESNI_MB_BATCH_SIZE, NULL);
+
+	for (i = 0; i < nb_ops; i++) {
+		rte_prefetch0(ops[i]->sym->m_src);
+		if (ops[i]->sess_type == RTE_CRYPTO_OP_WITH_SESSION)
+			rte_prefetch0(ops[i]->sym->session);
+	}
+
+	for (i = 0; i < nb_ops; i++) {
+		struct rte_crypto_op *op = ops[i];
+
+		if (op->sess_type == RTE_CRYPTO_OP_WITH_SESSION &&
+				op->sym->session == last && last != NULL) {
+			qp->batch_sess[i] = sess;
+			continue;
+		}
+
+		sess = get_session(qp, op);
+		last = op->sess_type == RTE_CRYPTO_OP_WITH_SESSION ?
+				op->sym->session : NULL;
+		if (sess != NULL)
+			rte_prefetch0(sess);
+		qp->batch_sess[i] = sess;
+	}
+
+	qp->batch_head = 0;
+	qp->batch_len = nb_ops;
+
+	return nb_ops;
+}
+
 /**
  * Process a crypto operation and complete a JOB_AES_HMAC job structure for
  * submission to the multi buffer library for processing.
  *
- * @param	qp	queue pair
  * @param	job	JOB_AES_HMAC structure to fill
- * @param	m	mbuf to process
+ * @param	qp	queue pair
+ * @param	op	crypto operation to process
+ * @param	session	session of the operation, NULL if invalid
+ * @param	digest_idx	index of the next temporary digest
  *
  * @return
- * - Completed JOB_AES_HMAC structure pointer on success
- * - NULL pointer if completion of JOB_AES_HMAC structure isn't possible
+ * - 0 on success
+ * - -1 if completion of JOB_AES_HMAC structure isn't possible
  */
 static inline int
 set_mb_job_params(JOB_AES_HMAC *job, struct aesni_mb_qp *qp,
-		struct rte_crypto_op *op, uint8_t *digest_idx)
+		struct rte_crypto_op *op, struct aesni_mb_session *session,
+		uint8_t *digest_idx)
 {
 	struct rte_mbuf *m_src = op->sym->m_src, *m_dst;
-	struct aesni_mb_session *session;
 	uint16_t m_offset = 0;
 
-	session = get_session(qp, op);
 	if (session == NULL) {
 		op->status = RTE_CRYPTO_OP_STATUS_INVALID_SESSION;
 		return -1;
@@ -874,6 +927,7 @@ set_mb_job_params(JOB_AES_HMAC *job, struct aesni_mb_qp *qp,
 
 	/* Set user data to be crypto operation data struct */
 	job->user_data = op;
+	job->user_data2 = session;
 
 	return 0;
 }
@@ -924,9 +978,7 @@ static inline struct rte_crypto_op *
 post_process_mb_job(struct aesni_mb_qp *qp, JOB_AES_HMAC *job)
 {
 	struct rte_crypto_op *op = (struct rte_crypto_op *)job->user_data;
-	struct aesni_mb_session *sess = get_sym_session_private_data(
-							op->sym->session,
-							cryptodev_driver_id);
+	struct aesni_mb_session *sess = job->user_data2;
 
 	if (likely(op->status == RTE_CRYPTO_OP_STATUS_NOT_PROCESSED)) {
 		switch (job->status) {
@@ -947,7 +999,7 @@ post_process_mb_job(struct aesni_mb_qp *qp, JOB_AES_HMAC *job)
 	}
 
 	/* Free session if a session-less crypto op */
-	if (op->sess_type == RTE_CRYPTO_OP_SESSIONLESS) {
+	if (op->sess_type == RTE_CRYPTO_OP_SESSIONLESS && sess != NULL) {
 		memset(sess, 0, sizeof(struct aesni_mb_session));
 		memset(op->sym->session, 0,
 				rte_cryptodev_sym_get_header_session_size());
@@ -1021,6 +1073,7 @@ set_job_null_op(JOB_AES_HMAC *job, struct rte_crypto_op *op)
 
 	/* Set user data to be crypto operation data struct */
 	job->user_data = op;
+	job->user_data2 = NULL;
 
 	return job;
 }
@@ -1031,6 +1084,7 @@ aesni_mb_pmd_dequeue_burst(void *queue_pair, struct rte_crypto_op **ops,
 {
 	struct aesni_mb_qp *qp = queue_pair;
 
+	struct aesni_mb_session *sess;
 	struct rte_crypto_op *op;
 	JOB_AES_HMAC *job;
 
@@ -1056,16 +1110,21 @@ aesni_mb_pmd_dequeue_burst(void *queue_pair, struct rte_crypto_op **ops,
 		}
 
 		/*
-		 * Get next operation to process from ingress queue.
-		 * There is no need to return the job to the MB_MGR
+		 * Get next operation to process from the batch taken from
+		 * the ingress queue, which outlives the burst if it gets
+		 * full. There is no need to return the job to the MB_MGR
 		 * if there are no more operations to process, since the MB_MGR
 		 * can use that pointer again in next get_next calls.
 		 */
-		retval = rte_ring_dequeue(qp->ingress_queue, (void **)&op);
-		if (retval < 0)
+		if (qp->batch_head == qp->batch_len &&
+				prepare_mb_batch(qp) == 0)
 			break;
 
-		retval = set_mb_job_params(job, qp, op, &digest_idx);
+		op = qp->batch_ops[qp->batch_head];
+		sess = qp->batch_sess[qp->batch_head];
+		qp->batch_head++;
+
+		retval = set_mb_job_params(job, qp, op, sess, &digest_idx);
 		if (unlikely(retval != 0)) {
 			qp->stats.dequeue_err_count++;
 			set_job_null_op(job, op);
@@ -117,6 +117,9 @@ struct aesni_mb_private {
 	/**< Max number of queue pairs supported by device */
 };
 
+/** Number of operations taken at once from the ingress queue */
+#define AESNI_MB_BATCH_SIZE	32
+
 /** AESNI Multi buffer queue pair */
 struct aesni_mb_qp {
 	uint16_t id;
@@ -142,6 +145,14 @@ struct aesni_mb_qp {
 	 * by the driver when verifying a digest provided
 	 * by the user (using authentication verify operation)
 	 */
+	uint16_t batch_head;
+	/**< Index of the next operation of the batch to submit */
+	uint16_t batch_len;
+	/**< Number of operations of the batch */
+	struct rte_crypto_op *batch_ops[AESNI_MB_BATCH_SIZE];
+	/**< Operations taken from the ingress queue, not submitted yet */
+	struct aesni_mb_session *batch_sess[AESNI_MB_BATCH_SIZE];
+	/**< Sessions of the batch operations, NULL if invalid */
 } __rte_cache_aligned;
 
 /** AES-NI multi-buffer private session structure */
@@ -13,8 +13,9 @@
  * The RTE Cryptodev Scheduler Device allows the aggregation of multiple (slave)
  * Cryptodevs into a single logical crypto device, and the scheduling the
  * crypto operations to the slaves based on the mode of the specified mode of
- * operation specified and supported. This implementation supports 3 modes of
- * operation: round robin, packet-size based, and fail-over.
+ * operation specified and supported. This implementation supports 5 modes of
+ * operation: round robin, packet-size based, fail-over, multi-core and
+ * load-aware.
  */
 
 #include <stdint.h>
@@ -40,6 +41,8 @@ extern "C" {
 #define SCHEDULER_MODE_NAME_FAIL_OVER		fail-over
 /** multi-core scheduling mode string */
 #define SCHEDULER_MODE_NAME_MULTI_CORE		multi-core
+/** Load-aware scheduling mode string */
+#define SCHEDULER_MODE_NAME_LOAD_AWARE		load-aware
 
 /**
  * Crypto scheduler PMD operation modes
@@ -56,6 +59,8 @@ enum rte_cryptodev_scheduler_mode {
 	CDEV_SCHED_MODE_FAILOVER,
 	/** multi-core mode */
 	CDEV_SCHED_MODE_MULTICORE,
+	/** Load-aware mode */
+	CDEV_SCHED_MODE_LOAD_AWARE,
 
 	CDEV_SCHED_MODE_COUNT /**< number of modes */
 };
@@ -69,6 +74,7 @@ enum rte_cryptodev_scheduler_mode {
 enum rte_cryptodev_schedule_option_type {
 	CDEV_SCHED_OPTION_NOT_SET = 0,
 	CDEV_SCHED_OPTION_THRESHOLD,
+	CDEV_SCHED_OPTION_LOAD,
 
 	CDEV_SCHED_OPTION_COUNT
 };
@@ -81,6 +87,32 @@ struct rte_cryptodev_scheduler_threshold_option {
 	uint32_t threshold;	/**< Threshold for packet-size mode */
 };
 
+/**
+ * Load of a slave, measured by the load-aware mode
+ */
+struct rte_cryptodev_scheduler_slave_load {
+	uint8_t dev_id;			/**< Slave device ID */
+	uint64_t enqueued_count;	/**< Ops enqueued to the slave */
+	uint64_t dequeued_count;	/**< Ops dequeued from the slave */
+	/** Bursts the slave could not take entirely, its queue being full */
+	uint64_t enqueue_full_count;
+	uint64_t inflight;		/**< Ops being processed */
+	/** Average TSC cycles per op queued ahead of a completion, 0 if not
+	 * measured yet
+	 */
+	uint64_t op_cycles;
+};
+
+/**
+ * Load option structure, only read, of the load-aware mode. The counters
+ * are summed over the queue pairs and reset when the scheduler starts.
+ */
+struct rte_cryptodev_scheduler_load_option {
+	uint32_t nb_slaves;	/**< Number of valid entries of slaves */
+	struct rte_cryptodev_scheduler_slave_load
+			slaves[RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES];
+};
+
 struct rte_cryptodev_scheduler;
 
 /**
@@ -277,6 +309,8 @@ extern struct rte_cryptodev_scheduler *crypto_scheduler_pkt_size_based_distr;
 extern struct rte_cryptodev_scheduler *crypto_scheduler_failover;
 /** multi-core mode scheduler */
 extern struct rte_cryptodev_scheduler *crypto_scheduler_multicore;
+/** Load-aware mode scheduler */
+extern struct rte_cryptodev_scheduler *crypto_scheduler_load_aware;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,405 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <rte_cryptodev.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+
+#include "rte_cryptodev_scheduler_operations.h"
+#include "scheduler_pmd_private.h"
+
+/** Number of enqueued bursts tracked per slave, a power of two */
+#define LA_NB_BURST_RECORDS		64
+/** Weight of a new sample in the per-op cost average, as a shift */
+#define LA_EWMA_SHIFT			3
+
+/** burst enqueued to a slave, waiting for completion */
+struct la_burst_record {
+	uint64_t tsc;		/**< enqueue time */
+	uint32_t nb_ops;	/**< ops of the burst */
+	uint32_t depth;		/**< ops in flight with the burst */
+};
+
+/** load-aware slave context */
+struct la_slave {
+	struct scheduler_slave slave;
+
+	/** average cycles spent per op queued ahead of a completion */
+	uint64_t op_cycles;
+
+	struct la_burst_record records[LA_NB_BURST_RECORDS];
+	uint32_t rec_head;	/**< oldest record */
+	uint32_t rec_tail;	/**< next free record */
+	uint32_t rec_done;	/**< ops of the oldest record dequeued */
+
+	uint64_t enqueued_count;
+	uint64_t dequeued_count;
+	uint64_t enqueue_full_count;
+};
+
+/** load-aware scheduler queue pair context */
+struct la_scheduler_qp_ctx {
+	struct la_slave slaves[RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES];
+	uint32_t nb_slaves;
+
+	uint32_t last_enq_slave_idx;
+	uint32_t last_deq_slave_idx;
+} __rte_cache_aligned;
+
+/*
+ * Expected cycles before a burst of nb_ops enqueued to the slave completes:
+ * the ops in flight plus the burst, at the cost measured per op. A slave
+ * without sample yet costs only its depth, so that it gets traffic.
+ */
+static __rte_always_inline uint64_t
+la_slave_cost(const struct la_slave *s, uint16_t nb_ops)
+{
+	return (uint64_t)(s->slave.nb_inflight_cops + nb_ops) *
+			(s->op_cycles + 1);
+}
+
+static __rte_always_inline void
+la_slave_record(struct la_slave *s, uint16_t nb_ops, uint64_t tsc)
+{
+	struct la_burst_record *r;
+
+	if (s->rec_tail - s->rec_head == LA_NB_BURST_RECORDS) {
+		/* merge into the newest burst, its latency gets pessimistic */
+		r = &s->records[(s->rec_tail - 1) & (LA_NB_BURST_RECORDS - 1)];
+		r->nb_ops += nb_ops;
+		r->depth += nb_ops;
+		return;
+	}
+
+	r = &s->records[s->rec_tail & (LA_NB_BURST_RECORDS - 1)];
+	r->tsc = tsc;
+	r->nb_ops = nb_ops;
+	r->depth = s->slave.nb_inflight_cops + nb_ops;
+	s->rec_tail++;
+}
+
+/*
+ * Account completed ops, slaves completing the ops of a queue pair in
+ * order: each completed burst gives a sample of the cycles per op.
+ */
+static __rte_always_inline void
+la_slave_complete(struct la_slave *s, uint16_t nb_ops, uint64_t tsc)
+{
+	while (nb_ops > 0 && s->rec_head != s->rec_tail) {
+		struct la_burst_record *r =
+			&s->records[s->rec_head & (LA_NB_BURST_RECORDS - 1)];
+		uint32_t left = r->nb_ops - s->rec_done;
+		uint64_t sample;
+
+		if (nb_ops < left) {
+			s->rec_done += nb_ops;
+			return;
+		}
+
+		sample = (tsc - r->tsc) / r->depth;
+		if (s->op_cycles == 0)
+			s->op_cycles = sample;
+		else
+			s->op_cycles += ((int64_t)sample -
+					(int64_t)s->op_cycles) >> LA_EWMA_SHIFT;
+
+		nb_ops -= left;
+		s->rec_done = 0;
+		s->rec_head++;
+	}
+}
+
+static uint16_t
+schedule_enqueue(void *qp, struct rte_crypto_op **ops, uint16_t nb_ops)
+{
+	struct la_scheduler_qp_ctx *la_qp_ctx =
+			((struct scheduler_qp_ctx *)qp)->private_qp_ctx;
+	uint32_t nb_slaves = la_qp_ctx->nb_slaves;
+	uint32_t full_mask = 0;
+	uint16_t nb_enq = 0;
+	uint16_t i;
+
+	if (unlikely(nb_ops == 0))
+		return 0;
+
+	for (i = 0; i < nb_ops && i < 4; i++)
+		rte_prefetch0(ops[i]->sym->session);
+
+	while (nb_enq < nb_ops &&
+			full_mask != RTE_LEN2MASK(nb_slaves, uint32_t)) {
+		uint16_t nb_left = nb_ops - nb_enq;
+		uint32_t idx = la_qp_ctx->last_enq_slave_idx;
+		uint32_t best_idx = UINT32_MAX;
+		uint64_t best_cost = UINT64_MAX;
+		struct la_slave *s;
+		uint16_t processed_ops;
+		uint32_t j;
+
+		/* start after the last one, to spread the ties */
+		for (j = 0; j < nb_slaves; j++) {
+			uint64_t cost;
+
+			if (++idx == nb_slaves)
+				idx = 0;
+			if (full_mask & (1U << idx))
+				continue;
+			cost = la_slave_cost(&la_qp_ctx->slaves[idx], nb_left);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_idx = idx;
+			}
+		}
+
+		s = &la_qp_ctx->slaves[best_idx];
+		processed_ops = rte_cryptodev_enqueue_burst(s->slave.dev_id,
+				s->slave.qp_id, &ops[nb_enq], nb_left);
+		if (processed_ops > 0) {
+			la_slave_record(s, processed_ops, rte_rdtsc());
+			s->slave.nb_inflight_cops += processed_ops;
+			s->enqueued_count += processed_ops;
+			la_qp_ctx->last_enq_slave_idx = best_idx;
+		}
+		if (processed_ops < nb_left) {
+			s->enqueue_full_count++;
+			full_mask |= 1U << best_idx;
+		}
+
+		nb_enq += processed_ops;
+	}
+
+	return nb_enq;
+}
+
+static uint16_t
+schedule_enqueue_ordering(void *qp, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	struct rte_ring *order_ring =
+			((struct scheduler_qp_ctx *)qp)->order_ring;
+	uint16_t nb_ops_to_enq = get_max_enqueue_order_count(order_ring,
+			nb_ops);
+	uint16_t nb_ops_enqd = schedule_enqueue(qp, ops,
+			nb_ops_to_enq);
+
+	scheduler_order_insert(order_ring, ops, nb_ops_enqd);
+
+	return nb_ops_enqd;
+}
+
+static uint16_t
+schedule_dequeue(void *qp, struct rte_crypto_op **ops, uint16_t nb_ops)
+{
+	struct la_scheduler_qp_ctx *la_qp_ctx =
+			((struct scheduler_qp_ctx *)qp)->private_qp_ctx;
+	uint32_t nb_slaves = la_qp_ctx->nb_slaves;
+	uint32_t idx = la_qp_ctx->last_deq_slave_idx;
+	uint16_t nb_deq = 0;
+	uint64_t tsc = 0;
+	uint32_t j;
+
+	for (j = 0; j < nb_slaves && nb_deq < nb_ops; j++) {
+		struct la_slave *s = &la_qp_ctx->slaves[idx];
+		uint16_t nb_deq_ops;
+
+		if (++idx == nb_slaves)
+			idx = 0;
+
+		if (s->slave.nb_inflight_cops == 0)
+			continue;
+
+		nb_deq_ops = rte_cryptodev_dequeue_burst(s->slave.dev_id,
+				s->slave.qp_id, &ops[nb_deq], nb_ops - nb_deq);
+		if (nb_deq_ops == 0)
+			continue;
+
+		if (tsc == 0)
+			tsc = rte_rdtsc();
+		la_slave_complete(s, nb_deq_ops, tsc);
+		s->slave.nb_inflight_cops -= nb_deq_ops;
+		s->dequeued_count += nb_deq_ops;
+		nb_deq += nb_deq_ops;
+	}
+
+	la_qp_ctx->last_deq_slave_idx = idx;
+
+	return nb_deq;
+}
+
+static uint16_t
+schedule_dequeue_ordering(void *qp, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	struct rte_ring *order_ring =
+			((struct scheduler_qp_ctx *)qp)->order_ring;
+
+	schedule_dequeue(qp, ops, nb_ops);
+
+	return scheduler_order_drain(order_ring, ops, nb_ops);
+}
+
+static int
+slave_attach(__rte_unused struct rte_cryptodev *dev,
+		__rte_unused uint8_t slave_id)
+{
+	return 0;
+}
+
+static int
+slave_detach(__rte_unused struct rte_cryptodev *dev,
+		__rte_unused uint8_t slave_id)
+{
+	return 0;
+}
+
+static int
+scheduler_start(struct rte_cryptodev *dev)
+{
+	struct scheduler_ctx *sched_ctx = dev->data->dev_private;
+	uint16_t i;
+
+	if (sched_ctx->reordering_enabled) {
+		dev->enqueue_burst = &schedule_enqueue_ordering;
+		dev->dequeue_burst = &schedule_dequeue_ordering;
+	} else {
+		dev->enqueue_burst = &schedule_enqueue;
+		dev->dequeue_burst = &schedule_dequeue;
+	}
+
+	for (i = 0; i < dev->data->nb_queue_pairs; i++) {
+		struct scheduler_qp_ctx *qp_ctx = dev->data->queue_pairs[i];
+		struct la_scheduler_qp_ctx *la_qp_ctx =
+				qp_ctx->private_qp_ctx;
+		uint32_t j;
+
+		memset(la_qp_ctx, 0, sizeof(*la_qp_ctx));
+		for (j = 0; j < sched_ctx->nb_slaves; j++) {
+			la_qp_ctx->slaves[j].slave.dev_id =
+					sched_ctx->slaves[j].dev_id;
+			la_qp_ctx->slaves[j].slave.qp_id = i;
+		}
+
+		la_qp_ctx->nb_slaves = sched_ctx->nb_slaves;
+	}
+
+	return 0;
+}
+
+static int
+scheduler_stop(struct rte_cryptodev *dev)
+{
+	uint16_t i;
+
+	for (i = 0; i < dev->data->nb_queue_pairs; i++) {
+		struct scheduler_qp_ctx *qp_ctx = dev->data->queue_pairs[i];
+		struct la_scheduler_qp_ctx *la_qp_ctx = qp_ctx->private_qp_ctx;
+		uint32_t j;
+
+		for (j = 0; j < la_qp_ctx->nb_slaves; j++) {
+			if (la_qp_ctx->slaves[j].slave.nb_inflight_cops) {
+				CR_SCHED_LOG(ERR,
+					"Some crypto ops left in slave queue");
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int
+scheduler_config_qp(struct rte_cryptodev *dev, uint16_t qp_id)
+{
+	struct scheduler_qp_ctx *qp_ctx = dev->data->queue_pairs[qp_id];
+	struct la_scheduler_qp_ctx *la_qp_ctx;
+
+	la_qp_ctx = rte_zmalloc_socket(NULL, sizeof(*la_qp_ctx), 0,
+			rte_socket_id());
+	if (!la_qp_ctx) {
+		CR_SCHED_LOG(ERR, "failed allocate memory for private queue pair");
+		return -ENOMEM;
+	}
+
+	qp_ctx->private_qp_ctx = (void *)la_qp_ctx;
+
+	return 0;
+}
+
+static int
+scheduler_create_private_ctx(__rte_unused struct rte_cryptodev *dev)
+{
+	return 0;
+}
+
+static int
+scheduler_option_get(struct rte_cryptodev *dev, uint32_t option_type,
+		void *option)
+{
+	struct scheduler_ctx *sched_ctx = dev->data->dev_private;
+	struct rte_cryptodev_scheduler_load_option *load_option = option;
+	uint32_t nb_samples[RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES] = {0};
+	uint16_t i;
+	uint32_t j;
+
+	if ((enum rte_cryptodev_schedule_option_type)option_type !=
+			CDEV_SCHED_OPTION_LOAD) {
+		CR_SCHED_LOG(ERR, "Option not supported");
+		return -EINVAL;
+	}
+
+	memset(load_option, 0, sizeof(*load_option));
+	load_option->nb_slaves = sched_ctx->nb_slaves;
+	for (j = 0; j < sched_ctx->nb_slaves; j++)
+		load_option->slaves[j].dev_id = sched_ctx->slaves[j].dev_id;
+
+	/* the queue pairs are set up once the scheduler is started */
+	if (!dev->data->dev_started)
+		return 0;
+
+	for (i = 0; i < dev->data->nb_queue_pairs; i++) {
+		struct scheduler_qp_ctx *qp_ctx = dev->data->queue_pairs[i];
+		struct la_scheduler_qp_ctx *la_qp_ctx = qp_ctx->private_qp_ctx;
+
+		for (j = 0; j < la_qp_ctx->nb_slaves; j++) {
+			struct rte_cryptodev_scheduler_slave_load *load =
+					&load_option->slaves[j];
+			const struct la_slave *s = &la_qp_ctx->slaves[j];
+
+			load->enqueued_count += s->enqueued_count;
+			load->dequeued_count += s->dequeued_count;
+			load->enqueue_full_count += s->enqueue_full_count;
+			load->inflight += s->slave.nb_inflight_cops;
+			if (s->op_cycles != 0) {
+				load->op_cycles += s->op_cycles;
+				nb_samples[j]++;
+			}
+		}
+	}
+
+	for (j = 0; j < sched_ctx->nb_slaves; j++)
+		if (nb_samples[j] != 0)
+			load_option->slaves[j].op_cycles /= nb_samples[j];
+
+	return 0;
+}
+
+static struct rte_cryptodev_scheduler_ops scheduler_la_ops = {
+	slave_attach,
+	slave_detach,
+	scheduler_start,
+	scheduler_stop,
+	scheduler_config_qp,
+	scheduler_create_private_ctx,
+	NULL,	/* option_set */
+	scheduler_option_get
+};
+
+static struct rte_cryptodev_scheduler la_scheduler = {
+		.name = "load-aware-scheduler",
+		.description = "scheduler which will enqueue each burst to the "
+				"slave expected to complete it first",
+		.mode = CDEV_SCHED_MODE_LOAD_AWARE,
+		.ops = &scheduler_la_ops
+};
+
+struct rte_cryptodev_scheduler *crypto_scheduler_load_aware = &la_scheduler;
@@ -23,6 +23,10 @@ struct virtio_crypto_session {
 	} aad;
 
 	struct virtio_crypto_op_ctrl_req ctrl;
+
+	/* data request with the fields fixed for the session filled in */
+	struct virtio_crypto_op_data_req req_tmpl;
+	uint32_t hash_result_len;
 };
 
 #endif /* _VIRTIO_CRYPTO_ALGS_H_ */
@@ -149,7 +149,8 @@ virtio_crypto_send_command(struct virtqueue *vq,
 		VIRTIO_CRYPTO_SESSION_LOG_ERR("not enough heap memory");
 		return -ENOSPC;
 	}
-	phys_addr_started = rte_malloc_virt2iova(virt_addr_started);
+	phys_addr_started = VIRTIO_CRYPTO_ADDR(vq->hw, virt_addr_started,
+		rte_malloc_virt2iova(virt_addr_started));
 
 	/* address to store indirect vring desc entries */
 	desc = (struct vring_desc *)
@@ -290,6 +291,29 @@ virtio_crypto_queue_release(struct virtqueue *vq)
 
 #define MPOOL_MAX_NAME_SZ 32
 
+/*
+ * Link the indirect table of an op cookie and point its first entry at the
+ * data request, once when the pool is created rather than for every op.
+ */
+static void
+virtio_crypto_op_cookie_init(struct rte_mempool *mp __rte_unused,
+		void *opaque, void *obj, unsigned int obj_idx __rte_unused)
+{
+	struct virtio_crypto_hw *hw = opaque;
+	struct virtio_crypto_op_cookie *cookie = obj;
+	uint16_t idx;
+
+	for (idx = 0; idx < (NUM_ENTRY_VIRTIO_CRYPTO_OP - 1); idx++)
+		cookie->desc[idx].next = idx + 1;
+	cookie->desc[NUM_ENTRY_VIRTIO_CRYPTO_OP - 1].next =
+		VQ_RING_DESC_CHAIN_END;
+
+	cookie->desc[0].addr = VIRTIO_CRYPTO_ADDR(hw, cookie,
+		rte_mempool_virt2iova(cookie));
+	cookie->desc[0].len = sizeof(struct virtio_crypto_op_data_req);
+	cookie->desc[0].flags = VRING_DESC_F_NEXT;
+}
+
 int
 virtio_crypto_queue_setup(struct rte_cryptodev *dev,
 		int queue_type,
@@ -360,8 +384,9 @@ virtio_crypto_queue_setup(struct rte_cryptodev *dev,
 					vq_size,
 					sizeof(struct virtio_crypto_op_cookie),
 					RTE_CACHE_LINE_SIZE, 0,
-					NULL, NULL, NULL, NULL, socket_id,
-					0);
+					NULL, NULL,
+					virtio_crypto_op_cookie_init, hw,
+					socket_id, 0);
 		if (!vq->mpool) {
 			VIRTIO_CRYPTO_DRV_LOG_ERR("Virtio Crypto PMD "
 					"Cannot create mempool");
@@ -418,7 +443,7 @@ virtio_crypto_queue_setup(struct rte_cryptodev *dev,
 	 * and only accepts 32 bit page frame number.
 	 * Check if the allocated physical memory exceeds 16TB.
 	 */
-	if ((mz->phys_addr + vq->vq_ring_size - 1)
+	if (!hw->virtio_user_dev && (mz->phys_addr + vq->vq_ring_size - 1)
 				>> (VIRTIO_PCI_QUEUE_ADDR_SHIFT + 32)) {
 		VIRTIO_CRYPTO_INIT_LOG_ERR("vring address shouldn't be "
 					"above 16TB!");
@@ -427,7 +452,7 @@ virtio_crypto_queue_setup(struct rte_cryptodev *dev,
 
 	memset(mz->addr, 0, sizeof(mz->len));
 	vq->mz = mz;
-	vq->vq_ring_mem = mz->phys_addr;
+	vq->vq_ring_mem = VIRTIO_CRYPTO_ADDR(hw, mz->addr, mz->phys_addr);
 	vq->vq_ring_virt_mem = mz->addr;
 	VIRTIO_CRYPTO_INIT_LOG_DBG("vq->vq_ring_mem(physical): 0x%"PRIx64,
 					(uint64_t)mz->phys_addr);
@@ -719,6 +744,36 @@ virtio_crypto_init_device(struct rte_cryptodev *cryptodev,
 	return 0;
 }
 
+/*
+ * Set up a crypto device once the ops of its transport, PCI or
+ * virtio-user, are in place.
+ * It returns 0 on success.
+ */
+int
+crypto_virtio_dev_init(struct rte_cryptodev *cryptodev)
+{
+	struct virtio_crypto_hw *hw = cryptodev->data->dev_private;
+
+	PMD_INIT_FUNC_TRACE();
+
+	cryptodev->driver_id = cryptodev_virtio_driver_id;
+	cryptodev->dev_ops = &virtio_crypto_dev_ops;
+
+	cryptodev->enqueue_burst = virtio_crypto_pkt_tx_burst;
+	cryptodev->dequeue_burst = virtio_crypto_pkt_rx_burst;
+
+	cryptodev->feature_flags = RTE_CRYPTODEV_FF_SYMMETRIC_CRYPTO |
+		RTE_CRYPTODEV_FF_SYM_OPERATION_CHAINING;
+
+	hw->virtio_dev_capabilities = virtio_capabilities;
+
+	if (virtio_crypto_init_device(cryptodev,
+			VIRTIO_CRYPTO_PMD_GUEST_FEATURES) < 0)
+		return -1;
+
+	return 0;
+}
+
 /*
  * This function is based on probe() function
  * It returns 0 on success.
@@ -737,18 +792,8 @@ crypto_virtio_create(const char *name, struct rte_pci_device *pci_dev,
 	if (cryptodev == NULL)
 		return -ENODEV;
 
-	cryptodev->driver_id = cryptodev_virtio_driver_id;
-	cryptodev->dev_ops = &virtio_crypto_dev_ops;
-
-	cryptodev->enqueue_burst = virtio_crypto_pkt_tx_burst;
-	cryptodev->dequeue_burst = virtio_crypto_pkt_rx_burst;
-
-	cryptodev->feature_flags = RTE_CRYPTODEV_FF_SYMMETRIC_CRYPTO |
-		RTE_CRYPTODEV_FF_SYM_OPERATION_CHAINING;
-
 	hw = cryptodev->data->dev_private;
 	hw->dev_id = cryptodev->data->dev_id;
-	hw->virtio_dev_capabilities = virtio_capabilities;
 
 	VIRTIO_CRYPTO_INIT_LOG_DBG("dev %d vendorID=0x%x deviceID=0x%x",
 		cryptodev->data->dev_id, pci_dev->id.vendor_id,
@@ -758,11 +803,7 @@ crypto_virtio_create(const char *name, struct rte_pci_device *pci_dev,
 	if (vtpci_cryptodev_init(pci_dev, hw))
 		return -1;
 
-	if (virtio_crypto_init_device(cryptodev,
-			VIRTIO_CRYPTO_PMD_GUEST_FEATURES) < 0)
-		return -1;
-
-	return 0;
+	return crypto_virtio_dev_init(cryptodev);
 }
 
 static int
@@ -986,7 +1027,8 @@ virtio_crypto_sym_clear_session(
 		VIRTIO_CRYPTO_SESSION_LOG_ERR("not enough heap room");
 		return;
 	}
-	malloc_phys_addr = rte_malloc_virt2iova(malloc_virt_addr);
+	malloc_phys_addr = VIRTIO_CRYPTO_ADDR(hw, malloc_virt_addr,
+		rte_malloc_virt2iova(malloc_virt_addr));
 
 	/* assign ctrl request op part */
 	ctrl = (struct virtio_crypto_op_ctrl_req *)malloc_virt_addr;
@@ -1299,6 +1341,43 @@ virtio_crypto_check_sym_configure_session_paras(
 	return 0;
 }
 
+/* Fill in the data request fields that are the same for every op */
+static void
+virtio_crypto_sym_init_req_tmpl(struct virtio_crypto_session *session)
+{
+	struct virtio_crypto_sym_create_session_req *sym_sess_req =
+		&session->ctrl.u.sym_create_session;
+	struct virtio_crypto_alg_chain_session_para *chain_para =
+		&sym_sess_req->u.chain.para;
+	struct virtio_crypto_op_data_req *req = &session->req_tmpl;
+	uint32_t cipher_op;
+
+	req->header.session_id = session->session_id;
+	req->u.sym_req.op_type = sym_sess_req->op_type;
+
+	if (sym_sess_req->op_type == VIRTIO_CRYPTO_SYM_OP_CIPHER) {
+		cipher_op = sym_sess_req->u.cipher.para.op;
+		req->u.sym_req.u.cipher.para.iv_len = session->iv.length;
+	} else {
+		cipher_op = chain_para->cipher_param.op;
+		if (chain_para->hash_mode == VIRTIO_CRYPTO_SYM_HASH_MODE_PLAIN)
+			session->hash_result_len =
+				chain_para->u.hash_param.hash_result_len;
+		if (chain_para->hash_mode == VIRTIO_CRYPTO_SYM_HASH_MODE_AUTH)
+			session->hash_result_len =
+				chain_para->u.mac_param.hash_result_len;
+		req->u.sym_req.u.chain.para.iv_len = session->iv.length;
+		req->u.sym_req.u.chain.para.aad_len = chain_para->aad_len;
+		req->u.sym_req.u.chain.para.hash_result_len =
+			session->hash_result_len;
+	}
+
+	if (cipher_op == VIRTIO_CRYPTO_OP_ENCRYPT)
+		req->header.opcode = VIRTIO_CRYPTO_CIPHER_ENCRYPT;
+	else
+		req->header.opcode = VIRTIO_CRYPTO_CIPHER_DECRYPT;
+}
+
 static int
 virtio_crypto_sym_configure_session(
 		struct rte_cryptodev *dev,
@@ -1395,6 +1474,8 @@ virtio_crypto_sym_configure_session(
 		goto error_out;
 	}
 
+	virtio_crypto_sym_init_req_tmpl(session);
+
 	set_sym_session_private_data(sess, dev->driver_id,
 		session_private);
 
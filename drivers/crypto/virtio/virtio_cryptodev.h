@@ -10,7 +10,8 @@
 #include "virtio_ring.h"
 
 /* Features desired/implemented by this driver. */
-#define VIRTIO_CRYPTO_PMD_GUEST_FEATURES (1ULL << VIRTIO_F_VERSION_1)
+#define VIRTIO_CRYPTO_PMD_GUEST_FEATURES (1ULL << VIRTIO_F_VERSION_1 | \
+	1ULL << VIRTIO_RING_F_EVENT_IDX)
 
 #define CRYPTODEV_NAME_VIRTIO_PMD crypto_virtio
 
@@ -53,6 +54,8 @@ int virtio_crypto_queue_setup(struct rte_cryptodev *dev,
 
 void virtio_crypto_queue_release(struct virtqueue *vq);
 
+int crypto_virtio_dev_init(struct rte_cryptodev *cryptodev);
+
 uint16_t virtio_crypto_pkt_tx_burst(void *tx_queue,
 		struct rte_crypto_op **tx_pkts,
 		uint16_t nb_pkts);
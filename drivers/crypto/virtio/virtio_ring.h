@@ -95,7 +95,9 @@ struct vring {
  * versa. They are at the end for backwards compatibility.
  */
 #define vring_used_event(vr)  ((vr)->avail->ring[(vr)->num])
-#define vring_avail_event(vr) (*(uint16_t *)&(vr)->used->ring[(vr)->num])
+#define vring_avail_event(vr) \
+	(*(volatile uint16_t *)RTE_PTR_ADD((vr)->used->ring, \
+		(vr)->num * sizeof(struct vring_used_elem)))
 
 static inline size_t
 vring_size(unsigned int num, unsigned long align)
@@ -107,7 +107,11 @@ virtqueue_dequeue_burst_rx(struct virtqueue *vq,
 	return i;
 }
 
-static int
+/*
+ * The fields fixed for the session come from its request template, only
+ * the lengths and offsets of the op are filled in here.
+ */
+static inline int
 virtqueue_crypto_sym_pkt_header_arrange(
 		struct rte_crypto_op *cop,
 		struct virtio_crypto_op_data_req *data,
@@ -115,70 +119,28 @@ virtqueue_crypto_sym_pkt_header_arrange(
 {
 	struct rte_crypto_sym_op *sym_op = cop->sym;
 	struct virtio_crypto_op_data_req *req_data = data;
-	struct virtio_crypto_op_ctrl_req *ctrl = &session->ctrl;
-	struct virtio_crypto_sym_create_session_req *sym_sess_req =
-		&ctrl->u.sym_create_session;
-	struct virtio_crypto_alg_chain_session_para *chain_para =
-		&sym_sess_req->u.chain.para;
-	struct virtio_crypto_cipher_session_para *cipher_para;
+	struct virtio_crypto_cipher_data_req *cipher;
+	struct virtio_crypto_alg_chain_data_req *chain;
 
-	req_data->header.session_id = session->session_id;
+	*req_data = session->req_tmpl;
 
-	switch (sym_sess_req->op_type) {
+	switch (req_data->u.sym_req.op_type) {
 	case VIRTIO_CRYPTO_SYM_OP_CIPHER:
-		req_data->u.sym_req.op_type = VIRTIO_CRYPTO_SYM_OP_CIPHER;
-
-		cipher_para = &sym_sess_req->u.cipher.para;
-		if (cipher_para->op == VIRTIO_CRYPTO_OP_ENCRYPT)
-			req_data->header.opcode = VIRTIO_CRYPTO_CIPHER_ENCRYPT;
-		else
-			req_data->header.opcode = VIRTIO_CRYPTO_CIPHER_DECRYPT;
-
-		req_data->u.sym_req.u.cipher.para.iv_len
-			= session->iv.length;
-
-		req_data->u.sym_req.u.cipher.para.src_data_len =
-			(sym_op->cipher.data.length +
-				sym_op->cipher.data.offset);
-		req_data->u.sym_req.u.cipher.para.dst_data_len =
-			req_data->u.sym_req.u.cipher.para.src_data_len;
+		cipher = &req_data->u.sym_req.u.cipher;
+		cipher->para.src_data_len = sym_op->cipher.data.length +
+			sym_op->cipher.data.offset;
+		cipher->para.dst_data_len = cipher->para.src_data_len;
 		break;
 	case VIRTIO_CRYPTO_SYM_OP_ALGORITHM_CHAINING:
-		req_data->u.sym_req.op_type =
-			VIRTIO_CRYPTO_SYM_OP_ALGORITHM_CHAINING;
-
-		cipher_para = &chain_para->cipher_param;
-		if (cipher_para->op == VIRTIO_CRYPTO_OP_ENCRYPT)
-			req_data->header.opcode = VIRTIO_CRYPTO_CIPHER_ENCRYPT;
-		else
-			req_data->header.opcode = VIRTIO_CRYPTO_CIPHER_DECRYPT;
-
-		req_data->u.sym_req.u.chain.para.iv_len = session->iv.length;
-		req_data->u.sym_req.u.chain.para.aad_len = session->aad.length;
-
-		req_data->u.sym_req.u.chain.para.src_data_len =
-			(sym_op->cipher.data.length +
-				sym_op->cipher.data.offset);
-		req_data->u.sym_req.u.chain.para.dst_data_len =
-			req_data->u.sym_req.u.chain.para.src_data_len;
-		req_data->u.sym_req.u.chain.para.cipher_start_src_offset =
+		chain = &req_data->u.sym_req.u.chain;
+		chain->para.src_data_len = sym_op->cipher.data.length +
 			sym_op->cipher.data.offset;
-		req_data->u.sym_req.u.chain.para.len_to_cipher =
-			sym_op->cipher.data.length;
-		req_data->u.sym_req.u.chain.para.hash_start_src_offset =
-			sym_op->auth.data.offset;
-		req_data->u.sym_req.u.chain.para.len_to_hash =
-			sym_op->auth.data.length;
-		req_data->u.sym_req.u.chain.para.aad_len =
-			chain_para->aad_len;
-
-		if (chain_para->hash_mode == VIRTIO_CRYPTO_SYM_HASH_MODE_PLAIN)
-			req_data->u.sym_req.u.chain.para.hash_result_len =
-				chain_para->u.hash_param.hash_result_len;
-		if (chain_para->hash_mode ==
-			VIRTIO_CRYPTO_SYM_HASH_MODE_AUTH)
-			req_data->u.sym_req.u.chain.para.hash_result_len =
-				chain_para->u.mac_param.hash_result_len;
+		chain->para.dst_data_len = chain->para.src_data_len;
+		chain->para.cipher_start_src_offset =
+			sym_op->cipher.data.offset;
+		chain->para.len_to_cipher = sym_op->cipher.data.length;
+		chain->para.hash_start_src_offset = sym_op->auth.data.offset;
+		chain->para.len_to_hash = sym_op->auth.data.length;
 		break;
 	default:
 		return -1;
@@ -201,18 +163,17 @@ virtqueue_crypto_sym_enqueue_xmit(
 	struct vring_desc *desc;
 	uint64_t indirect_op_data_req_phys_addr;
 	uint16_t req_data_len = sizeof(struct virtio_crypto_op_data_req);
-	uint32_t indirect_vring_addr_offset = req_data_len +
-		sizeof(struct virtio_crypto_inhdr);
-	uint32_t indirect_iv_addr_offset = indirect_vring_addr_offset +
-			sizeof(struct vring_desc) * NUM_ENTRY_VIRTIO_CRYPTO_OP;
+	uint32_t indirect_vring_addr_offset =
+		offsetof(struct virtio_crypto_op_cookie, desc);
+	uint32_t indirect_iv_addr_offset =
+		offsetof(struct virtio_crypto_op_cookie, iv);
 	struct rte_crypto_sym_op *sym_op = cop->sym;
 	struct virtio_crypto_session *session =
 		(struct virtio_crypto_session *)get_sym_session_private_data(
 		cop->sym->session, cryptodev_virtio_driver_id);
 	struct virtio_crypto_op_data_req *op_data_req;
-	uint32_t hash_result_len = 0;
 	struct virtio_crypto_op_cookie *crypto_op_cookie;
-	struct virtio_crypto_alg_chain_session_para *para;
+	struct virtio_crypto_hw *hw = txvq->hw;
 
 	if (unlikely(sym_op->m_src->nb_segs != 1))
 		return -EMSGSIZE;
@@ -233,36 +194,35 @@ virtqueue_crypto_sym_enqueue_xmit(
 		return -EFAULT;
 	}
 	crypto_op_cookie = dxp->cookie;
-	indirect_op_data_req_phys_addr =
-		rte_mempool_virt2iova(crypto_op_cookie);
 	op_data_req = (struct virtio_crypto_op_data_req *)crypto_op_cookie;
 
-	if (virtqueue_crypto_sym_pkt_header_arrange(cop, op_data_req, session))
+	if (virtqueue_crypto_sym_pkt_header_arrange(cop, op_data_req,
+			session)) {
+		rte_mempool_put(txvq->mpool, crypto_op_cookie);
 		return -EFAULT;
+	}
 
 	/* status is initialized to VIRTIO_CRYPTO_ERR */
 	((struct virtio_crypto_inhdr *)
 		((uint8_t *)op_data_req + req_data_len))->status =
 		VIRTIO_CRYPTO_ERR;
 
-	/* point to indirect vring entry */
+	/*
+	 * point to indirect vring entry, its links and the first part,
+	 * virtio_crypto_op_data_req, are set up when the cookie is created
+	 */
 	desc = (struct vring_desc *)
 		((uint8_t *)op_data_req + indirect_vring_addr_offset);
-	for (idx = 0; idx < (NUM_ENTRY_VIRTIO_CRYPTO_OP - 1); idx++)
-		desc[idx].next = idx + 1;
-	desc[NUM_ENTRY_VIRTIO_CRYPTO_OP - 1].next = VQ_RING_DESC_CHAIN_END;
-
-	idx = 0;
-
-	/* indirect vring: first part, virtio_crypto_op_data_req */
-	desc[idx].addr = indirect_op_data_req_phys_addr;
-	desc[idx].len = req_data_len;
-	desc[idx++].flags = VRING_DESC_F_NEXT;
+	indirect_op_data_req_phys_addr = desc[0].addr;
+	idx = 1;
 
 	/* indirect vring: iv of cipher */
 	if (session->iv.length) {
-		if (cop->phys_addr)
-			desc[idx].addr = cop->phys_addr + session->iv.offset;
+		if (hw->virtio_user_dev || cop->phys_addr)
+			desc[idx].addr = VIRTIO_CRYPTO_ADDR(hw,
+				rte_crypto_op_ctod_offset(cop, uint8_t *,
+					session->iv.offset),
+				cop->phys_addr + session->iv.offset);
 		else {
 			rte_memcpy(crypto_op_cookie->iv,
 					rte_crypto_op_ctod_offset(cop,
@@ -284,32 +244,35 @@ virtqueue_crypto_sym_enqueue_xmit(
 	}
 
 	/* indirect vring: src data */
-	desc[idx].addr = rte_pktmbuf_mtophys_offset(sym_op->m_src, 0);
+	desc[idx].addr = VIRTIO_CRYPTO_ADDR(hw,
+		rte_pktmbuf_mtod(sym_op->m_src, void *),
+		rte_pktmbuf_mtophys(sym_op->m_src));
 	desc[idx].len = (sym_op->cipher.data.offset
 		+ sym_op->cipher.data.length);
 	desc[idx++].flags = VRING_DESC_F_NEXT;
 
 	/* indirect vring: dst data */
 	if (sym_op->m_dst) {
-		desc[idx].addr = rte_pktmbuf_mtophys_offset(sym_op->m_dst, 0);
+		desc[idx].addr = VIRTIO_CRYPTO_ADDR(hw,
+			rte_pktmbuf_mtod(sym_op->m_dst, void *),
+			rte_pktmbuf_mtophys(sym_op->m_dst));
 		desc[idx].len = (sym_op->cipher.data.offset
 			+ sym_op->cipher.data.length);
 	} else {
-		desc[idx].addr = rte_pktmbuf_mtophys_offset(sym_op->m_src, 0);
+		desc[idx].addr = VIRTIO_CRYPTO_ADDR(hw,
+			rte_pktmbuf_mtod(sym_op->m_src, void *),
+			rte_pktmbuf_mtophys(sym_op->m_src));
 		desc[idx].len = (sym_op->cipher.data.offset
 			+ sym_op->cipher.data.length);
 	}
 	desc[idx++].flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
 
 	/* indirect vring: digest result */
-	para = &(session->ctrl.u.sym_create_session.u.chain.para);
-	if (para->hash_mode == VIRTIO_CRYPTO_SYM_HASH_MODE_PLAIN)
-		hash_result_len = para->u.hash_param.hash_result_len;
-	if (para->hash_mode == VIRTIO_CRYPTO_SYM_HASH_MODE_AUTH)
-		hash_result_len = para->u.mac_param.hash_result_len;
-	if (hash_result_len > 0) {
-		desc[idx].addr = sym_op->auth.digest.phys_addr;
-		desc[idx].len = hash_result_len;
+	if (session->hash_result_len > 0) {
+		desc[idx].addr = VIRTIO_CRYPTO_ADDR(hw,
+			sym_op->auth.digest.data,
+			sym_op->auth.digest.phys_addr);
+		desc[idx].len = session->hash_result_len;
 		desc[idx++].flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
 	}
 
@@ -374,6 +337,7 @@ virtio_crypto_vring_start(struct virtqueue *vq)
 	vring_init(vr, size, ring_mem, VIRTIO_PCI_VRING_ALIGN);
 	vq->vq_desc_tail_idx = (uint16_t)(vq->vq_nentries - 1);
 	vq->vq_free_cnt = vq->vq_nentries;
+	vq->vq_kick_avail_idx = vq->vq_avail_idx;
 
 	/* Chain all the descriptors in the ring with an END */
 	for (i = 0; i < size - 1; i++)
@@ -0,0 +1,417 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2010-2016 Intel Corporation
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_atomic.h>
+
+#include "vhost.h"
+#include "virtio_user_dev.h"
+#include "../virtio_logs.h"
+#include "../virtqueue.h"
+
+/* features we pass through to the vhost-user crypto backend */
+#define VIRTIO_USER_SUPPORTED_FEATURES		\
+	(1ULL << VIRTIO_F_VERSION_1 |		\
+	 1ULL << VIRTIO_RING_F_EVENT_IDX)
+
+#define VIRTIO_USER_SUPPORTED_PROTOCOL_FEATURES	\
+	(1ULL << VHOST_USER_PROTOCOL_F_CRYPTO_SESSION)
+
+static int
+virtio_user_kick_queue(struct virtio_user_dev *dev, uint32_t queue_sel)
+{
+	struct vring *vring = &dev->vrings[queue_sel];
+	/* no eventfds: the backend polls the data rings and we never sleep */
+	struct vhost_vring_file file = {
+		.index = queue_sel,
+		.fd = -1,
+	};
+	struct vhost_vring_state state;
+	struct vhost_vring_addr addr = {
+		.index = queue_sel,
+		.desc_user_addr = (uint64_t)(uintptr_t)vring->desc,
+		.avail_user_addr = (uint64_t)(uintptr_t)vring->avail,
+		.used_user_addr = (uint64_t)(uintptr_t)vring->used,
+		.log_guest_addr = 0,
+		.flags = 0, /* disable log */
+	};
+
+	/* The backend allocates its virtqueue on the first message
+	 * carrying the index, so SET_VRING_CALL has to come first.
+	 */
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_VRING_CALL,
+			&file) < 0)
+		return -1;
+
+	state.index = queue_sel;
+	state.num = vring->num;
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_VRING_NUM,
+			&state) < 0)
+		return -1;
+
+	state.index = queue_sel;
+	state.num = vring->used->idx;
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_VRING_BASE,
+			&state) < 0)
+		return -1;
+
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_VRING_ADDR,
+			&addr) < 0)
+		return -1;
+
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_VRING_KICK,
+			&file) < 0)
+		return -1;
+
+	/* with VHOST_USER_F_PROTOCOL_FEATURES rings start disabled */
+	if (dev->protocol_features) {
+		state.index = queue_sel;
+		state.num = 1;
+		if (crypto_vhost_user_sock(dev, VHOST_USER_SET_VRING_ENABLE,
+				&state) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+int
+crypto_virtio_user_start_device(struct virtio_user_dev *dev)
+{
+	uint64_t features;
+	uint32_t i;
+
+	pthread_mutex_lock(&dev->mutex);
+
+	features = dev->features;
+	if (dev->protocol_features)
+		features |= 1ULL << VHOST_USER_F_PROTOCOL_FEATURES;
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_FEATURES,
+			&features) < 0)
+		goto error;
+
+	/* the memory is pre-allocated, the table is sent once */
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_MEM_TABLE, NULL) < 0)
+		goto error;
+
+	for (i = 0; i < dev->max_dataqueues; i++) {
+		if (dev->vrings[i].num == 0)
+			continue;
+		if (virtio_user_kick_queue(dev, i) < 0)
+			goto error;
+	}
+
+	dev->started = true;
+	pthread_mutex_unlock(&dev->mutex);
+
+	return 0;
+error:
+	pthread_mutex_unlock(&dev->mutex);
+	VIRTIO_CRYPTO_INIT_LOG_ERR("failed to start %s", dev->path);
+	return -1;
+}
+
+int
+crypto_virtio_user_stop_device(struct virtio_user_dev *dev)
+{
+	struct vhost_vring_state state;
+	uint32_t i;
+	int ret = 0;
+
+	pthread_mutex_lock(&dev->mutex);
+
+	if (!dev->started)
+		goto out;
+
+	/* the first GET_VRING_BASE tears the device down in the backend */
+	for (i = 0; i < dev->max_dataqueues; i++) {
+		if (dev->vrings[i].num == 0)
+			continue;
+		state.index = i;
+		if (crypto_vhost_user_sock(dev, VHOST_USER_GET_VRING_BASE,
+				&state) < 0) {
+			VIRTIO_CRYPTO_INIT_LOG_ERR("get_vring_base failed, "
+					"index=%u", i);
+			ret = -1;
+		}
+	}
+
+	dev->started = false;
+out:
+	pthread_mutex_unlock(&dev->mutex);
+
+	return ret;
+}
+
+int
+crypto_virtio_user_dev_init(struct virtio_user_dev *dev, char *path,
+		uint32_t queues, uint32_t queue_size)
+{
+	uint64_t features;
+	uint64_t protocol_features;
+
+	pthread_mutex_init(&dev->mutex, NULL);
+	snprintf(dev->path, PATH_MAX, "%s", path);
+	dev->vhostfd = -1;
+	dev->max_dataqueues = queues;
+	dev->queue_size = queue_size;
+	dev->status = 0;
+	dev->started = false;
+	dev->protocol_features = 0;
+	memset(dev->vrings, 0, sizeof(dev->vrings));
+
+	if (crypto_vhost_user_setup(dev) < 0) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("backend set up fails");
+		return -1;
+	}
+
+	if (crypto_vhost_user_sock(dev, VHOST_USER_SET_OWNER, NULL) < 0) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("set_owner fails: %s",
+				strerror(errno));
+		goto error;
+	}
+
+	if (crypto_vhost_user_sock(dev, VHOST_USER_GET_FEATURES,
+			&features) < 0) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("get_features failed: %s",
+				strerror(errno));
+		goto error;
+	}
+
+	/* sessions are created through vhost-user messages, not the ring */
+	if (features & (1ULL << VHOST_USER_F_PROTOCOL_FEATURES)) {
+		if (crypto_vhost_user_sock(dev,
+				VHOST_USER_GET_PROTOCOL_FEATURES,
+				&protocol_features) < 0)
+			goto error;
+		protocol_features &= VIRTIO_USER_SUPPORTED_PROTOCOL_FEATURES;
+		if (crypto_vhost_user_sock(dev,
+				VHOST_USER_SET_PROTOCOL_FEATURES,
+				&protocol_features) < 0)
+			goto error;
+		dev->protocol_features = protocol_features;
+	}
+
+	if (!(dev->protocol_features &
+			(1ULL << VHOST_USER_PROTOCOL_F_CRYPTO_SESSION))) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("%s does not offer crypto sessions",
+				path);
+		goto error;
+	}
+
+	dev->device_features = features & VIRTIO_USER_SUPPORTED_FEATURES;
+
+	/* The backend has no config space of its own, so advertise what
+	 * every vhost-user crypto backend implements.
+	 */
+	memset(&dev->config, 0, sizeof(dev->config));
+	dev->config.status = VIRTIO_CRYPTO_S_HW_READY;
+	dev->config.max_dataqueues = queues;
+	dev->config.crypto_services = 1 << VIRTIO_CRYPTO_SERVICE_CIPHER |
+		1 << VIRTIO_CRYPTO_SERVICE_HASH |
+		1 << VIRTIO_CRYPTO_SERVICE_MAC;
+	dev->config.cipher_algo_l = 1 << VIRTIO_CRYPTO_CIPHER_AES_CBC;
+	dev->config.mac_algo_l = 1 << VIRTIO_CRYPTO_MAC_HMAC_SHA1;
+	dev->config.max_cipher_key_len =
+		VHOST_USER_CRYPTO_MAX_CIPHER_KEY_LENGTH;
+	dev->config.max_auth_key_len = VHOST_USER_CRYPTO_MAX_HMAC_KEY_LENGTH;
+
+	return 0;
+error:
+	close(dev->vhostfd);
+	dev->vhostfd = -1;
+	return -1;
+}
+
+void
+crypto_virtio_user_dev_uninit(struct virtio_user_dev *dev)
+{
+	crypto_virtio_user_stop_device(dev);
+
+	if (dev->vhostfd >= 0)
+		close(dev->vhostfd);
+	dev->vhostfd = -1;
+}
+
+static uint8_t
+virtio_user_create_session(struct virtio_user_dev *dev,
+		struct virtio_crypto_op_ctrl_req *ctrl,
+		struct vring_desc *desc, uint16_t idx,
+		int64_t *session_id)
+{
+	struct virtio_crypto_sym_create_session_req *sym =
+		&ctrl->u.sym_create_session;
+	struct virtio_crypto_alg_chain_session_para *chain =
+		&sym->u.chain.para;
+	struct virtio_crypto_cipher_session_para *cipher;
+	struct vhost_user_crypto_session_param param;
+	uint8_t status = VIRTIO_CRYPTO_OK;
+
+	memset(&param, 0, sizeof(param));
+	param.op_code = ctrl->header.opcode;
+	param.op_type = sym->op_type;
+
+	switch (sym->op_type) {
+	case VIRTIO_CRYPTO_SYM_OP_CIPHER:
+		cipher = &sym->u.cipher.para;
+		break;
+	case VIRTIO_CRYPTO_SYM_OP_ALGORITHM_CHAINING:
+		cipher = &chain->cipher_param;
+		param.chaining_dir = chain->alg_chain_order;
+		param.hash_mode = chain->hash_mode;
+		param.aad_len = chain->aad_len;
+		if (chain->hash_mode == VIRTIO_CRYPTO_SYM_HASH_MODE_AUTH) {
+			param.hash_algo = chain->u.mac_param.algo;
+			param.digest_len = chain->u.mac_param.hash_result_len;
+			param.auth_key_len = chain->u.mac_param.auth_key_len;
+		} else {
+			param.hash_algo = chain->u.hash_param.algo;
+			param.digest_len =
+				chain->u.hash_param.hash_result_len;
+		}
+		break;
+	default:
+		return VIRTIO_CRYPTO_NOTSUPP;
+	}
+
+	param.cipher_algo = cipher->algo;
+	param.cipher_key_len = cipher->keylen;
+	param.dir = cipher->op;
+
+	if (param.cipher_key_len > VHOST_USER_CRYPTO_MAX_CIPHER_KEY_LENGTH ||
+			param.auth_key_len >
+			VHOST_USER_CRYPTO_MAX_HMAC_KEY_LENGTH)
+		return VIRTIO_CRYPTO_BADMSG;
+
+	/* the keys follow the request in the order the driver wrote them */
+	if (param.cipher_key_len > 0) {
+		if (!(desc[idx].flags & VRING_DESC_F_NEXT))
+			return VIRTIO_CRYPTO_BADMSG;
+		idx = desc[idx].next;
+		if (desc[idx].len != param.cipher_key_len)
+			return VIRTIO_CRYPTO_BADMSG;
+		memcpy(param.cipher_key_buf,
+			(void *)(uintptr_t)desc[idx].addr,
+			param.cipher_key_len);
+	}
+
+	if (param.auth_key_len > 0) {
+		if (!(desc[idx].flags & VRING_DESC_F_NEXT))
+			return VIRTIO_CRYPTO_BADMSG;
+		idx = desc[idx].next;
+		if (desc[idx].len != param.auth_key_len)
+			return VIRTIO_CRYPTO_BADMSG;
+		memcpy(param.auth_key_buf,
+			(void *)(uintptr_t)desc[idx].addr,
+			param.auth_key_len);
+	}
+
+	if (crypto_vhost_user_sock(dev, VHOST_USER_CRYPTO_CREATE_SESS,
+			&param) < 0)
+		status = VIRTIO_CRYPTO_ERR;
+	else if (param.session_id < 0)
+		status = (uint8_t)-param.session_id;
+	else
+		*session_id = param.session_id;
+
+	/* don't leave key material on the stack */
+	memset(param.cipher_key_buf, 0, sizeof(param.cipher_key_buf));
+	memset(param.auth_key_buf, 0, sizeof(param.auth_key_buf));
+
+	return status;
+}
+
+static uint32_t
+virtio_user_handle_ctrl_msg(struct virtio_user_dev *dev, struct vring *vring,
+		uint16_t idx_hdr)
+{
+	struct virtio_crypto_op_ctrl_req *ctrl;
+	struct virtio_crypto_session_input *input;
+	struct virtio_crypto_inhdr *inhdr;
+	struct vring_desc *desc;
+	uint64_t session_id;
+	int64_t new_id = 0;
+	uint32_t nb_desc;
+	uint16_t idx_status;
+	uint8_t status;
+
+	/* the driver always posts ctrl requests as one indirect table */
+	if (!(vring->desc[idx_hdr].flags & VRING_DESC_F_INDIRECT))
+		return 0;
+
+	desc = (struct vring_desc *)(uintptr_t)vring->desc[idx_hdr].addr;
+	nb_desc = vring->desc[idx_hdr].len / sizeof(struct vring_desc);
+	if (nb_desc < 2)
+		return 0;
+
+	ctrl = (struct virtio_crypto_op_ctrl_req *)(uintptr_t)desc[0].addr;
+	idx_status = nb_desc - 1;
+
+	switch (ctrl->header.opcode) {
+	case VIRTIO_CRYPTO_CIPHER_CREATE_SESSION:
+		input = (struct virtio_crypto_session_input *)
+			(uintptr_t)desc[idx_status].addr;
+		if (!dev->started)
+			status = VIRTIO_CRYPTO_ERR;
+		else
+			status = virtio_user_create_session(dev, ctrl, desc, 0,
+					&new_id);
+		input->session_id = (uint64_t)new_id;
+		input->status = status;
+		return sizeof(*input);
+	case VIRTIO_CRYPTO_CIPHER_DESTROY_SESSION:
+		inhdr = (struct virtio_crypto_inhdr *)
+			(uintptr_t)desc[idx_status].addr;
+		session_id = ctrl->u.destroy_session.session_id;
+		if (dev->started && crypto_vhost_user_sock(dev,
+				VHOST_USER_CRYPTO_CLOSE_SESS, &session_id) == 0)
+			inhdr->status = VIRTIO_CRYPTO_OK;
+		else
+			inhdr->status = VIRTIO_CRYPTO_ERR;
+		return sizeof(*inhdr);
+	default:
+		VIRTIO_CRYPTO_DRV_LOG_ERR("unsupported ctrl opcode %u",
+				ctrl->header.opcode);
+		inhdr = (struct virtio_crypto_inhdr *)
+			(uintptr_t)desc[idx_status].addr;
+		inhdr->status = VIRTIO_CRYPTO_NOTSUPP;
+		return sizeof(*inhdr);
+	}
+}
+
+/* Control requests are answered in place: session setup is a vhost-user
+ * message, so there is nothing for the backend to poll on this ring.
+ */
+void
+crypto_virtio_user_handle_cq(struct virtio_user_dev *dev, uint16_t queue_idx)
+{
+	struct vring *vring = &dev->vrings[queue_idx];
+	struct vring_used_elem *uep;
+	uint16_t avail_idx, desc_idx;
+	uint32_t n_written;
+
+	pthread_mutex_lock(&dev->mutex);
+
+	while (vring->used->idx !=
+			*(volatile uint16_t *)&vring->avail->idx) {
+		rte_smp_rmb();
+		avail_idx = vring->used->idx & (vring->num - 1);
+		desc_idx = vring->avail->ring[avail_idx];
+
+		n_written = virtio_user_handle_ctrl_msg(dev, vring, desc_idx);
+
+		uep = &vring->used->ring[avail_idx];
+		uep->id = desc_idx;
+		uep->len = n_written;
+
+		rte_smp_wmb();
+		vring->used->idx++;
+	}
+
+	pthread_mutex_unlock(&dev->mutex);
+}
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2010-2016 Intel Corporation
+ */
+
+#ifndef _VIRTIO_USER_DEV_H
+#define _VIRTIO_USER_DEV_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "../virtio_pci.h"
+#include "../virtio_ring.h"
+
+#define VIRTIO_USER_MAX_DATAQUEUES 8
+
+struct virtio_user_dev {
+	int		vhostfd;
+	uint32_t	max_dataqueues;
+	uint32_t	queue_size;
+	uint64_t	device_features; /* supported by the backend and us */
+	uint64_t	features; /* the negotiated features */
+	uint64_t	protocol_features; /* negotiated protocol features */
+	uint8_t		status;
+	bool		started;
+	char		path[PATH_MAX];
+	/* device config, the backend only handles the requests */
+	struct virtio_crypto_config config;
+	/* data queues, then the control queue the driver handles itself */
+	struct vring	vrings[VIRTIO_USER_MAX_DATAQUEUES + 1];
+	pthread_mutex_t	mutex;
+};
+
+int crypto_virtio_user_dev_init(struct virtio_user_dev *dev, char *path,
+		uint32_t queues, uint32_t queue_size);
+void crypto_virtio_user_dev_uninit(struct virtio_user_dev *dev);
+int crypto_virtio_user_start_device(struct virtio_user_dev *dev);
+int crypto_virtio_user_stop_device(struct virtio_user_dev *dev);
+void crypto_virtio_user_handle_cq(struct virtio_user_dev *dev,
+		uint16_t queue_idx);
+
+#endif
@@ -0,0 +1,375 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2010-2016 Intel Corporation
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_malloc.h>
+#include <rte_kvargs.h>
+#include <rte_bus_vdev.h>
+#include <rte_cryptodev_pmd.h>
+
+#include "virtio_cryptodev.h"
+#include "virtio_logs.h"
+#include "virtio_pci.h"
+#include "virtqueue.h"
+#include "virtio_user/virtio_user_dev.h"
+
+#define virtio_user_get_dev(hw) \
+	((struct virtio_user_dev *)(hw)->virtio_user_dev)
+
+static void
+virtio_user_read_dev_config(struct virtio_crypto_hw *hw, size_t offset,
+		void *dst, int length)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	if (offset + length > sizeof(dev->config)) {
+		VIRTIO_CRYPTO_DRV_LOG_ERR("not supported offset=%zu, len=%d",
+				offset, length);
+		return;
+	}
+
+	memcpy(dst, (uint8_t *)&dev->config + offset, length);
+}
+
+static void
+virtio_user_write_dev_config(struct virtio_crypto_hw *hw __rte_unused,
+		size_t offset, const void *src __rte_unused, int length)
+{
+	VIRTIO_CRYPTO_DRV_LOG_ERR("not supported offset=%zu, len=%d",
+			offset, length);
+}
+
+static void
+virtio_user_reset(struct virtio_crypto_hw *hw)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	if (dev->status & VIRTIO_CONFIG_STATUS_DRIVER_OK)
+		crypto_virtio_user_stop_device(dev);
+}
+
+static void
+virtio_user_set_status(struct virtio_crypto_hw *hw, uint8_t status)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	if (status & VIRTIO_CONFIG_STATUS_DRIVER_OK)
+		crypto_virtio_user_start_device(dev);
+	else if (status == VIRTIO_CONFIG_STATUS_RESET)
+		virtio_user_reset(hw);
+	dev->status = status;
+}
+
+static uint8_t
+virtio_user_get_status(struct virtio_crypto_hw *hw)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	return dev->status;
+}
+
+static uint64_t
+virtio_user_get_features(struct virtio_crypto_hw *hw)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	return dev->device_features;
+}
+
+static void
+virtio_user_set_features(struct virtio_crypto_hw *hw, uint64_t features)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	dev->features = features & dev->device_features;
+}
+
+static uint8_t
+virtio_user_get_isr(struct virtio_crypto_hw *hw __rte_unused)
+{
+	/* no interrupts, the driver polls everything */
+	return 0;
+}
+
+static uint16_t
+virtio_user_set_config_irq(struct virtio_crypto_hw *hw __rte_unused,
+		uint16_t vec __rte_unused)
+{
+	return 0;
+}
+
+static uint16_t
+virtio_user_set_queue_irq(struct virtio_crypto_hw *hw __rte_unused,
+		struct virtqueue *vq __rte_unused, uint16_t vec)
+{
+	/* pretend we have done that */
+	return vec;
+}
+
+static uint16_t
+virtio_user_get_queue_num(struct virtio_crypto_hw *hw,
+		uint16_t queue_id __rte_unused)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	/* Currently, each queue has same queue size */
+	return dev->queue_size;
+}
+
+static int
+virtio_user_setup_queue(struct virtio_crypto_hw *hw, struct virtqueue *vq)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+	uint16_t queue_idx = vq->vq_queue_index;
+	uint64_t desc_addr, avail_addr, used_addr;
+
+	if (queue_idx > VIRTIO_USER_MAX_DATAQUEUES)
+		return -1;
+
+	desc_addr = (uintptr_t)vq->vq_ring_virt_mem;
+	avail_addr = desc_addr + vq->vq_nentries * sizeof(struct vring_desc);
+	used_addr = RTE_ALIGN_CEIL(avail_addr + offsetof(struct vring_avail,
+				ring[vq->vq_nentries]),
+				VIRTIO_PCI_VRING_ALIGN);
+
+	dev->vrings[queue_idx].num = vq->vq_nentries;
+	dev->vrings[queue_idx].desc = (void *)(uintptr_t)desc_addr;
+	dev->vrings[queue_idx].avail = (void *)(uintptr_t)avail_addr;
+	dev->vrings[queue_idx].used = (void *)(uintptr_t)used_addr;
+
+	return 0;
+}
+
+static void
+virtio_user_del_queue(struct virtio_crypto_hw *hw, struct virtqueue *vq)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	/* the backend learns about it from GET_VRING_BASE at reset */
+	memset(&dev->vrings[vq->vq_queue_index], 0, sizeof(struct vring));
+}
+
+static void
+virtio_user_notify_queue(struct virtio_crypto_hw *hw, struct virtqueue *vq)
+{
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	/* the backend polls the data queues, only the control queue is
+	 * ours to serve
+	 */
+	if (vq == hw->cvq)
+		crypto_virtio_user_handle_cq(dev, vq->vq_queue_index);
+}
+
+static const struct virtio_pci_ops virtio_user_ops = {
+	.read_dev_cfg	= virtio_user_read_dev_config,
+	.write_dev_cfg	= virtio_user_write_dev_config,
+	.reset		= virtio_user_reset,
+	.get_status	= virtio_user_get_status,
+	.set_status	= virtio_user_set_status,
+	.get_features	= virtio_user_get_features,
+	.set_features	= virtio_user_set_features,
+	.get_isr	= virtio_user_get_isr,
+	.set_config_irq	= virtio_user_set_config_irq,
+	.set_queue_irq	= virtio_user_set_queue_irq,
+	.get_queue_num	= virtio_user_get_queue_num,
+	.setup_queue	= virtio_user_setup_queue,
+	.del_queue	= virtio_user_del_queue,
+	.notify_queue	= virtio_user_notify_queue,
+};
+
+static const char *valid_args[] = {
+#define VIRTIO_USER_ARG_QUEUES_NUM     "queues"
+	VIRTIO_USER_ARG_QUEUES_NUM,
+#define VIRTIO_USER_ARG_QUEUE_SIZE     "queue_size"
+	VIRTIO_USER_ARG_QUEUE_SIZE,
+#define VIRTIO_USER_ARG_PATH           "path"
+	VIRTIO_USER_ARG_PATH,
+	NULL
+};
+
+#define VIRTIO_USER_DEF_Q_NUM	1
+#define VIRTIO_USER_DEF_Q_SZ	256
+
+static int
+get_string_arg(const char *key __rte_unused,
+	       const char *value, void *extra_args)
+{
+	if (!value || !extra_args)
+		return -EINVAL;
+
+	*(char **)extra_args = strdup(value);
+
+	if (!*(char **)extra_args)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static int
+get_integer_arg(const char *key __rte_unused,
+		const char *value, void *extra_args)
+{
+	if (!value || !extra_args)
+		return -EINVAL;
+
+	*(uint64_t *)extra_args = strtoull(value, NULL, 0);
+
+	return 0;
+}
+
+static int
+virtio_user_pmd_probe(struct rte_vdev_device *vdev)
+{
+	struct rte_cryptodev_pmd_init_params init_params = {
+		"",
+		sizeof(struct virtio_crypto_hw),
+		rte_socket_id(),
+		RTE_CRYPTODEV_PMD_DEFAULT_MAX_NB_QUEUE_PAIRS
+	};
+	struct rte_kvargs *kvlist = NULL;
+	struct rte_cryptodev *cryptodev;
+	struct virtio_crypto_hw *hw;
+	struct virtio_user_dev *dev;
+	uint64_t queues = VIRTIO_USER_DEF_Q_NUM;
+	uint64_t queue_size = VIRTIO_USER_DEF_Q_SZ;
+	char *path = NULL;
+	int ret = -1;
+
+	kvlist = rte_kvargs_parse(rte_vdev_device_args(vdev), valid_args);
+	if (!kvlist) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("error when parsing param");
+		goto end;
+	}
+
+	if (rte_kvargs_count(kvlist, VIRTIO_USER_ARG_PATH) == 1) {
+		if (rte_kvargs_process(kvlist, VIRTIO_USER_ARG_PATH,
+				       &get_string_arg, &path) < 0) {
+			VIRTIO_CRYPTO_INIT_LOG_ERR("error to parse %s",
+				VIRTIO_USER_ARG_PATH);
+			goto end;
+		}
+	} else {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("arg %s is mandatory for "
+			"virtio_user", VIRTIO_USER_ARG_PATH);
+		goto end;
+	}
+
+	if (rte_kvargs_count(kvlist, VIRTIO_USER_ARG_QUEUES_NUM) == 1) {
+		if (rte_kvargs_process(kvlist, VIRTIO_USER_ARG_QUEUES_NUM,
+				       &get_integer_arg, &queues) < 0) {
+			VIRTIO_CRYPTO_INIT_LOG_ERR("error to parse %s",
+				VIRTIO_USER_ARG_QUEUES_NUM);
+			goto end;
+		}
+	}
+
+	if (rte_kvargs_count(kvlist, VIRTIO_USER_ARG_QUEUE_SIZE) == 1) {
+		if (rte_kvargs_process(kvlist, VIRTIO_USER_ARG_QUEUE_SIZE,
+				       &get_integer_arg, &queue_size) < 0) {
+			VIRTIO_CRYPTO_INIT_LOG_ERR("error to parse %s",
+				VIRTIO_USER_ARG_QUEUE_SIZE);
+			goto end;
+		}
+	}
+
+	if (queues == 0 || queues > VIRTIO_USER_MAX_DATAQUEUES) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("arg %s must be in [1, %d]",
+			VIRTIO_USER_ARG_QUEUES_NUM,
+			VIRTIO_USER_MAX_DATAQUEUES);
+		goto end;
+	}
+
+	if (!rte_is_power_of_2(queue_size) || queue_size > UINT16_MAX) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("arg %s must be a power of 2",
+			VIRTIO_USER_ARG_QUEUE_SIZE);
+		goto end;
+	}
+
+	dev = rte_zmalloc(NULL, sizeof(*dev), 0);
+	if (!dev) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("malloc virtio_user_dev failed");
+		goto end;
+	}
+
+	cryptodev = rte_cryptodev_pmd_create(rte_vdev_device_name(vdev),
+			&vdev->device, &init_params);
+	if (cryptodev == NULL) {
+		rte_free(dev);
+		goto end;
+	}
+
+	hw = cryptodev->data->dev_private;
+	hw->dev_id = cryptodev->data->dev_id;
+	hw->modern = 1;
+	hw->virtio_user_dev = dev;
+	virtio_hw_internal[hw->dev_id].vtpci_ops = &virtio_user_ops;
+
+	if (crypto_virtio_user_dev_init(dev, path, queues, queue_size) < 0) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("crypto_virtio_user_dev_init fails");
+		goto err_destroy;
+	}
+
+	if (crypto_virtio_dev_init(cryptodev) < 0) {
+		VIRTIO_CRYPTO_INIT_LOG_ERR("crypto_virtio_dev_init fails");
+		crypto_virtio_user_dev_uninit(dev);
+		goto err_destroy;
+	}
+
+	ret = 0;
+	goto end;
+
+err_destroy:
+	rte_cryptodev_pmd_destroy(cryptodev);
+	rte_free(dev);
+end:
+	if (kvlist)
+		rte_kvargs_free(kvlist);
+	if (path)
+		free(path);
+	return ret;
+}
+
+static int
+virtio_user_pmd_remove(struct rte_vdev_device *vdev)
+{
+	struct rte_cryptodev *cryptodev;
+	struct virtio_crypto_hw *hw;
+	struct virtio_user_dev *dev;
+	const char *name;
+
+	if (!vdev)
+		return -EINVAL;
+
+	name = rte_vdev_device_name(vdev);
+	VIRTIO_CRYPTO_DRV_LOG_INFO("Un-Initializing %s", name);
+	cryptodev = rte_cryptodev_pmd_get_named_dev(name);
+	if (!cryptodev)
+		return -ENODEV;
+
+	/* make sure the device is stopped, queues freed */
+	if (cryptodev->data->dev_started)
+		rte_cryptodev_stop(cryptodev->data->dev_id);
+
+	hw = cryptodev->data->dev_private;
+	dev = hw->virtio_user_dev;
+	crypto_virtio_user_dev_uninit(dev);
+	rte_free(dev);
+
+	return rte_cryptodev_pmd_destroy(cryptodev);
+}
+
+static struct rte_vdev_driver virtio_user_driver = {
+	.probe = virtio_user_pmd_probe,
+	.remove = virtio_user_pmd_remove,
+};
+
+RTE_PMD_REGISTER_VDEV(crypto_virtio_user, virtio_user_driver);
+RTE_PMD_REGISTER_PARAM_STRING(crypto_virtio_user,
+	"path=<path> "
+	"queues=<int> "
+	"queue_size=<int>");
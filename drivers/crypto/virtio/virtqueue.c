@@ -13,6 +13,16 @@
 void
 virtqueue_disable_intr(struct virtqueue *vq)
 {
+	/*
+	 * With event idx the flags must stay 0, so put the used event as
+	 * far behind the ring as possible instead.
+	 */
+	if (vtpci_with_feature(vq->hw, VIRTIO_RING_F_EVENT_IDX)) {
+		vring_used_event(&vq->vq_ring) =
+			(uint16_t)(vq->vq_used_cons_idx - 1);
+		return;
+	}
+
 	/*
 	 * Set VRING_AVAIL_F_NO_INTERRUPT to hint host
 	 * not to interrupt when it consumes packets
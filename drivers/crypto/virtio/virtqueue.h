@@ -79,6 +79,7 @@ struct virtqueue {
 	 */
 	uint16_t vq_used_cons_idx;
 	uint16_t vq_avail_idx;
+	uint16_t vq_kick_avail_idx; /**< vq_avail_idx at the last kick check */
 
 	/* Statistics */
 	uint64_t	packets_sent_total;
@@ -107,6 +108,13 @@ virtqueue_full(const struct virtqueue *vq)
 	return vq->vq_free_cnt == 0;
 }
 
+/*
+ * The address of a buffer as the device sees it. A virtio-user backend maps
+ * the memory of the process, it gets the virtual address instead of the IOVA.
+ */
+#define VIRTIO_CRYPTO_ADDR(hw, va, iova) \
+	((hw)->virtio_user_dev ? (uint64_t)(uintptr_t)(va) : (uint64_t)(iova))
+
 #define VIRTQUEUE_NUSED(vq) \
 	((uint16_t)((vq)->vq_ring.used->idx - (vq)->vq_used_cons_idx))
 
@@ -137,7 +145,23 @@ vq_update_avail_ring(struct virtqueue *vq, uint16_t desc_idx)
 static inline int
 virtqueue_kick_prepare(struct virtqueue *vq)
 {
-	return !(vq->vq_ring.used->flags & VRING_USED_F_NO_NOTIFY);
+	uint16_t old_idx, new_idx;
+
+	if (!vtpci_with_feature(vq->hw, VIRTIO_RING_F_EVENT_IDX))
+		return !(vq->vq_ring.used->flags & VRING_USED_F_NO_NOTIFY);
+
+	/*
+	 * Only kick if the device asked to be notified for one of the
+	 * entries made available since the last check. avail->idx must be
+	 * visible before the device's avail event is read.
+	 */
+	virtio_mb();
+	old_idx = vq->vq_kick_avail_idx;
+	new_idx = vq->vq_avail_idx;
+	vq->vq_kick_avail_idx = new_idx;
+
+	return vring_need_event(vring_avail_event(&vq->vq_ring),
+			new_idx, old_idx);
 }
 
 static inline void
@@ -3,6 +3,7 @@
  */
 
 #include <stdbool.h>
+#include <string.h>
 
 #include <rte_cycles.h>
 #include <rte_eventdev_pmd.h>
@@ -63,8 +64,11 @@ dsw_port_setup(struct rte_eventdev *dev, uint8_t port_id,
 	port->load_update_interval =
 		(DSW_LOAD_UPDATE_INTERVAL * rte_get_timer_hz()) / US_PER_S;
 
-	port->migration_interval =
+	port->min_migration_interval =
 		(DSW_MIGRATION_INTERVAL * rte_get_timer_hz()) / US_PER_S;
+	port->max_migration_interval =
+		(DSW_MAX_MIGRATION_INTERVAL * rte_get_timer_hz()) / US_PER_S;
+	port->migration_interval = port->min_migration_interval;
 
 	dev->data->ports[port_id] = port;
 
@@ -249,6 +253,13 @@ initial_flow_to_port_assignment(struct dsw_evdev *dsw)
 	for (queue_id = 0; queue_id < dsw->num_queues; queue_id++) {
 		struct dsw_queue *queue = &dsw->queues[queue_id];
 		uint16_t flow_hash;
+
+		memset(queue->flow_migration_time, 0,
+		       sizeof(queue->flow_migration_time));
+		memset(queue->flow_migrations, 0,
+		       sizeof(queue->flow_migrations));
+		memset(queue->flow_prev_port, 0,
+		       sizeof(queue->flow_prev_port));
 		for (flow_hash = 0; flow_hash < DSW_MAX_FLOWS; flow_hash++) {
 			uint8_t port_idx =
 				rte_rand() % queue->num_serving_ports;
@@ -83,6 +83,27 @@
 #define DSW_MIN_SOURCE_LOAD_FOR_MIGRATION (DSW_LOAD_FROM_PERCENT(70))
 #define DSW_MAX_TARGET_LOAD_FOR_MIGRATION (DSW_LOAD_FROM_PERCENT(95))
 
+/* Bursty traffic makes the port load swing, and migrating flows on
+ * every load peak makes them go back and forth between ports. The
+ * migration decisions therefore also take the history of the input
+ * queue depth of the port into account. A port which keeps up with
+ * its input, i.e. with an average queue depth below its dequeue
+ * depth, only migrates flows when its load goes above
+ * DSW_MAX_TARGET_LOAD_FOR_MIGRATION. The target port load must also
+ * be below the source port load by some margin.
+ */
+#define DSW_OLD_QUEUE_DEPTH_WEIGHT (3)
+#define DSW_MIGRATION_LOAD_MARGIN (DSW_LOAD_FROM_PERCENT(10))
+
+/* A flow is not migrated again within this many migration intervals
+ * of its last migration. A port finding only such flows to migrate
+ * doubles its migration interval, up to DSW_MAX_MIGRATION_INTERVAL,
+ * while a port without a reason to migrate halves it, down to
+ * DSW_MIGRATION_INTERVAL.
+ */
+#define DSW_FLOW_MIGRATION_HOLDOFF (4)
+#define DSW_MAX_MIGRATION_INTERVAL (16*DSW_MIGRATION_INTERVAL)
+
 #define DSW_MAX_EVENTS_RECORDED (128)
 
 /* Only one outstanding migration per port is allowed */
@@ -153,10 +174,20 @@ struct dsw_port {
 	/* For the ctl interface and flow migration mechanism. */
 	uint64_t next_migration;
 	uint64_t migration_interval;
+	uint64_t min_migration_interval;
+	uint64_t max_migration_interval;
 	enum dsw_migration_state migration_state;
 
+	/* Average number of events waiting on the port input. */
+	uint32_t queue_depth;
+	/* Migrations skipped since the flows were migrated recently. */
+	uint64_t migrations_held_off;
+	/* Migrations moving a flow back to the port it last left. */
+	uint64_t migration_ping_pongs;
+
 	uint64_t migration_start;
 	uint64_t migrations;
+	uint64_t queue_migrations[DSW_MAX_QUEUES];
 	uint64_t migration_latency;
 
 	uint8_t migration_target_port_id;
@@ -208,6 +239,13 @@ struct dsw_queue {
 	uint16_t num_serving_ports;
 
 	uint8_t flow_to_port_map[DSW_MAX_FLOWS] __rte_cache_aligned;
+
+	/* Per-flow migration history, written by the port migrating
+	 * the flow.
+	 */
+	uint64_t flow_migration_time[DSW_MAX_FLOWS] __rte_cache_aligned;
+	uint16_t flow_migrations[DSW_MAX_FLOWS];
+	uint8_t flow_prev_port[DSW_MAX_FLOWS];
 };
 
 struct dsw_evdev {
@@ -162,6 +162,18 @@ dsw_port_load_update(struct dsw_port *port, uint64_t now)
 	rte_atomic16_set(&port->load, new_load);
 }
 
+static void
+dsw_port_queue_depth_update(struct dsw_port *port)
+{
+	uint32_t depth;
+
+	depth = rte_event_ring_count(port->in_ring) + port->in_buffer_len;
+
+	port->queue_depth =
+		(depth + port->queue_depth*DSW_OLD_QUEUE_DEPTH_WEIGHT) /
+		(DSW_OLD_QUEUE_DEPTH_WEIGHT+1);
+}
+
 static void
 dsw_port_consider_load_update(struct dsw_port *port, uint64_t now)
 {
@@ -171,6 +183,7 @@ dsw_port_consider_load_update(struct dsw_port *port, uint64_t now)
 	port->next_load_update = now + port->load_update_interval;
 
 	dsw_port_load_update(port, now);
+	dsw_port_queue_depth_update(port);
 }
 
 static void
@@ -401,10 +414,13 @@ dsw_select_migration_target(struct dsw_evdev *dsw,
 			    struct dsw_port *source_port,
 			    struct dsw_queue_flow_burst *bursts,
 			    uint16_t num_bursts, int16_t *port_loads,
-			    int16_t max_load, struct dsw_queue_flow *target_qf,
-			    uint8_t *target_port_id)
+			    int16_t max_load, uint64_t now,
+			    struct dsw_queue_flow *target_qf,
+			    uint8_t *target_port_id, bool *held_off)
 {
 	uint16_t source_load = port_loads[source_port->id];
+	uint64_t holdoff =
+		DSW_FLOW_MIGRATION_HOLDOFF * source_port->migration_interval;
 	uint16_t i;
 
 	for (i = 0; i < num_bursts; i++) {
@@ -417,12 +433,21 @@ dsw_select_migration_target(struct dsw_evdev *dsw,
 		struct dsw_queue *queue = &dsw->queues[qf->queue_id];
 		int16_t target_load;
 
+		/* A flow moved recently is likely to be part of a
+		 * load swing, rather than of a lasting imbalance.
+		 */
+		if (queue->flow_migrations[qf->flow_hash] > 0 &&
+		    now - queue->flow_migration_time[qf->flow_hash] < holdoff) {
+			*held_off = true;
+			continue;
+		}
+
 		dsw_find_lowest_load_port(queue->serving_ports,
 					  queue->num_serving_ports,
 					  source_port->id, port_loads,
 					  target_port_id, &target_load);
 
-		if (target_load < source_load &&
+		if (target_load + DSW_MIGRATION_LOAD_MARGIN < source_load &&
 		    target_load < max_load) {
 			*target_qf = *qf;
 			return true;
@@ -610,13 +635,42 @@ dsw_port_flush_paused_events(struct dsw_evdev *dsw,
 }
 
 static void
-dsw_port_migration_stats(struct dsw_port *port)
+dsw_port_migration_stats(struct dsw_evdev *dsw, struct dsw_port *port)
 {
+	uint8_t queue_id = port->migration_target_qf.queue_id;
+	uint16_t flow_hash = port->migration_target_qf.flow_hash;
+	struct dsw_queue *queue = &dsw->queues[queue_id];
+	uint64_t now = rte_get_timer_cycles();
 	uint64_t migration_latency;
 
-	migration_latency = (rte_get_timer_cycles() - port->migration_start);
+	migration_latency = (now - port->migration_start);
 	port->migration_latency += migration_latency;
 	port->migrations++;
+	port->queue_migrations[queue_id]++;
+
+	if (queue->flow_migrations[flow_hash] > 0 &&
+	    queue->flow_prev_port[flow_hash] ==
+	    port->migration_target_port_id)
+		port->migration_ping_pongs++;
+
+	if (queue->flow_migrations[flow_hash] < UINT16_MAX)
+		queue->flow_migrations[flow_hash]++;
+	queue->flow_prev_port[flow_hash] = port->id;
+	queue->flow_migration_time[flow_hash] = now;
+}
+
+static void
+dsw_port_relax_migration_interval(struct dsw_port *port)
+{
+	port->migration_interval = RTE_MAX(port->migration_interval / 2,
+					   port->min_migration_interval);
+}
+
+static void
+dsw_port_backoff_migration_interval(struct dsw_port *port)
+{
+	port->migration_interval = RTE_MIN(port->migration_interval * 2,
+					   port->max_migration_interval);
 }
 
 static void
@@ -628,7 +682,7 @@ dsw_port_end_migration(struct dsw_evdev *dsw, struct dsw_port *port)
 	port->migration_state = DSW_MIGRATION_STATE_IDLE;
 	port->seen_events_len = 0;
 
-	dsw_port_migration_stats(port);
+	dsw_port_migration_stats(dsw, port);
 
 	if (dsw->queues[queue_id].schedule_type != RTE_SCHED_TYPE_PARALLEL) {
 		dsw_port_remove_paused_flow(port, queue_id, flow_hash);
@@ -645,11 +699,13 @@ dsw_port_consider_migration(struct dsw_evdev *dsw,
 			    uint64_t now)
 {
 	bool any_port_below_limit;
+	bool held_off = false;
 	struct dsw_queue_flow *seen_events = source_port->seen_events;
 	uint16_t seen_events_len = source_port->seen_events_len;
 	struct dsw_queue_flow_burst bursts[DSW_MAX_EVENTS_RECORDED];
 	uint16_t num_bursts;
 	int16_t source_port_load;
+	int16_t min_source_load;
 	int16_t port_loads[dsw->num_ports];
 
 	if (now < source_port->next_migration)
@@ -684,12 +740,23 @@ dsw_port_consider_migration(struct dsw_evdev *dsw,
 		return;
 	}
 
+	/* A port where no backlog builds up is keeping up with its
+	 * input, and its load is allowed to peak higher.
+	 */
+	if (source_port->queue_depth >= source_port->dequeue_depth)
+		min_source_load = DSW_MIN_SOURCE_LOAD_FOR_MIGRATION;
+	else
+		min_source_load = DSW_MAX_TARGET_LOAD_FOR_MIGRATION;
+
 	source_port_load = rte_atomic16_read(&source_port->load);
-	if (source_port_load < DSW_MIN_SOURCE_LOAD_FOR_MIGRATION) {
+	if (source_port_load < min_source_load) {
 		DSW_LOG_DP_PORT(DEBUG, source_port->id,
-				"Load %d is below threshold level %d.\n",
+				"Load %d is below threshold level %d (queue "
+				"depth %u).\n",
 				DSW_LOAD_TO_PERCENT(source_port_load),
-		       DSW_LOAD_TO_PERCENT(DSW_MIN_SOURCE_LOAD_FOR_MIGRATION));
+				DSW_LOAD_TO_PERCENT(min_source_load),
+				source_port->queue_depth);
+		dsw_port_relax_migration_interval(source_port);
 		return;
 	}
 
@@ -735,16 +802,26 @@ dsw_port_consider_migration(struct dsw_evdev *dsw,
 	 */
 	if (!dsw_select_migration_target(dsw, source_port, bursts, num_bursts,
 					 port_loads,
-					 DSW_MIN_SOURCE_LOAD_FOR_MIGRATION,
+					 DSW_MIN_SOURCE_LOAD_FOR_MIGRATION, now,
 					 &source_port->migration_target_qf,
-					 &source_port->migration_target_port_id)
+					 &source_port->migration_target_port_id,
+					 &held_off)
 	    &&
 	    !dsw_select_migration_target(dsw, source_port, bursts, num_bursts,
 					 port_loads,
-					 DSW_MAX_TARGET_LOAD_FOR_MIGRATION,
+					 DSW_MAX_TARGET_LOAD_FOR_MIGRATION, now,
 					 &source_port->migration_target_qf,
-				       &source_port->migration_target_port_id))
+				       &source_port->migration_target_port_id,
+					 &held_off)) {
+		/* Flows are being moved back and forth faster than
+		 * the load settles; consider migration less often.
+		 */
+		if (held_off) {
+			source_port->migrations_held_off++;
+			dsw_port_backoff_migration_interval(source_port);
+		}
 		return;
+	}
 
 	DSW_LOG_DP_PORT(DEBUG, source_port->id, "Migrating queue_id %d "
 			"flow_hash %d from port %d to port %d.\n",
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include <rte_cycles.h>
 #include <rte_debug.h>
 
 /* The high bits in the xstats id is used to store an additional
@@ -45,6 +46,15 @@ struct dsw_xstats_port {
 	bool per_queue;
 };
 
+typedef
+uint64_t (*dsw_xstats_queue_get_value_fn)(struct dsw_evdev *dsw,
+					  uint8_t queue_id);
+
+struct dsw_xstats_queue {
+	const char *name_fmt;
+	dsw_xstats_queue_get_value_fn get_value_fn;
+};
+
 static uint64_t
 dsw_xstats_dev_credits_on_loan(struct dsw_evdev *dsw)
 {
@@ -86,6 +96,25 @@ dsw_xstats_port_get_queue_dequeued(struct dsw_evdev *dsw, uint8_t port_id,
 
 DSW_GEN_PORT_ACCESS_FN(migrations)
 
+static uint64_t
+dsw_xstats_port_get_queue_migrations(struct dsw_evdev *dsw, uint8_t port_id,
+				     uint8_t queue_id)
+{
+	return dsw->ports[port_id].queue_migrations[queue_id];
+}
+
+DSW_GEN_PORT_ACCESS_FN(migrations_held_off)
+DSW_GEN_PORT_ACCESS_FN(migration_ping_pongs)
+
+static uint64_t
+dsw_xstats_port_get_migration_interval(struct dsw_evdev *dsw, uint8_t port_id,
+				       uint8_t queue_id __rte_unused)
+{
+	uint64_t interval = dsw->ports[port_id].migration_interval;
+
+	return (interval * US_PER_S) / rte_get_timer_hz();
+}
+
 static uint64_t
 dsw_xstats_port_get_migration_latency(struct dsw_evdev *dsw, uint8_t port_id,
 				      uint8_t queue_id __rte_unused)
@@ -121,6 +150,7 @@ dsw_xstats_port_get_load(struct dsw_evdev *dsw, uint8_t port_id,
 	return DSW_LOAD_TO_PERCENT(load);
 }
 
+DSW_GEN_PORT_ACCESS_FN(queue_depth)
 DSW_GEN_PORT_ACCESS_FN(last_bg)
 
 static struct dsw_xstats_port dsw_port_xstats[] = {
@@ -138,6 +168,14 @@ static struct dsw_xstats_port dsw_port_xstats[] = {
 	  true },
 	{ "port_%u_migrations", dsw_xstats_port_get_migrations,
 	  false },
+	{ "port_%u_queue_%u_migrations", dsw_xstats_port_get_queue_migrations,
+	  true },
+	{ "port_%u_migrations_held_off",
+	  dsw_xstats_port_get_migrations_held_off, false },
+	{ "port_%u_migration_ping_pongs",
+	  dsw_xstats_port_get_migration_ping_pongs, false },
+	{ "port_%u_migration_interval", dsw_xstats_port_get_migration_interval,
+	  false },
 	{ "port_%u_migration_latency", dsw_xstats_port_get_migration_latency,
 	  false },
 	{ "port_%u_event_proc_latency", dsw_xstats_port_get_event_proc_latency,
@@ -146,10 +184,67 @@ static struct dsw_xstats_port dsw_port_xstats[] = {
 	  false },
 	{ "port_%u_load", dsw_xstats_port_get_load,
 	  false },
+	{ "port_%u_queue_depth", dsw_xstats_port_get_queue_depth,
+	  false },
 	{ "port_%u_last_bg", dsw_xstats_port_get_last_bg,
 	  false }
 };
 
+/* The per-flow statistics summarize how much the flows of a queue
+ * have been moving between ports.
+ */
+static uint64_t
+dsw_xstats_queue_get_flows_migrated(struct dsw_evdev *dsw, uint8_t queue_id)
+{
+	struct dsw_queue *queue = &dsw->queues[queue_id];
+	uint64_t flows = 0;
+	uint32_t flow_hash;
+
+	for (flow_hash = 0; flow_hash < DSW_MAX_FLOWS; flow_hash++)
+		if (queue->flow_migrations[flow_hash] > 0)
+			flows++;
+
+	return flows;
+}
+
+static uint64_t
+dsw_xstats_queue_get_flows_remigrated(struct dsw_evdev *dsw,
+				      uint8_t queue_id)
+{
+	struct dsw_queue *queue = &dsw->queues[queue_id];
+	uint64_t flows = 0;
+	uint32_t flow_hash;
+
+	for (flow_hash = 0; flow_hash < DSW_MAX_FLOWS; flow_hash++)
+		if (queue->flow_migrations[flow_hash] > 1)
+			flows++;
+
+	return flows;
+}
+
+static uint64_t
+dsw_xstats_queue_get_max_flow_migrations(struct dsw_evdev *dsw,
+					 uint8_t queue_id)
+{
+	struct dsw_queue *queue = &dsw->queues[queue_id];
+	uint16_t max_migrations = 0;
+	uint32_t flow_hash;
+
+	for (flow_hash = 0; flow_hash < DSW_MAX_FLOWS; flow_hash++)
+		max_migrations = RTE_MAX(max_migrations,
+					 queue->flow_migrations[flow_hash]);
+
+	return max_migrations;
+}
+
+static struct dsw_xstats_queue dsw_queue_xstats[] = {
+	{ "queue_%u_flows_migrated", dsw_xstats_queue_get_flows_migrated },
+	{ "queue_%u_flows_remigrated",
+	  dsw_xstats_queue_get_flows_remigrated },
+	{ "queue_%u_max_flow_migrations",
+	  dsw_xstats_queue_get_max_flow_migrations }
+};
+
 static int
 dsw_xstats_dev_get_names(struct rte_event_dev_xstats_name *xstats_names,
 			 unsigned int *ids, unsigned int size)
@@ -200,6 +295,22 @@ dsw_xstats_port_get_names(struct dsw_evdev *dsw, uint8_t port_id,
 	return id_idx;
 }
 
+static int
+dsw_xstats_queue_get_names(uint8_t queue_id,
+			   struct rte_event_dev_xstats_name *xstats_names,
+			   unsigned int *ids, unsigned int size)
+{
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(dsw_queue_xstats) && i < size; i++) {
+		ids[i] = i;
+		snprintf(xstats_names[i].name, RTE_EVENT_DEV_XSTATS_NAME_SIZE,
+			 dsw_queue_xstats[i].name_fmt, queue_id);
+	}
+
+	return i;
+}
+
 int
 dsw_xstats_get_names(const struct rte_eventdev *dev,
 		     enum rte_event_dev_xstats_mode mode,
@@ -216,7 +327,10 @@ dsw_xstats_get_names(const struct rte_eventdev *dev,
 		return dsw_xstats_port_get_names(dsw, queue_port_id,
 						 xstats_names, ids, size);
 	case RTE_EVENT_DEV_XSTATS_QUEUE:
-		return 0;
+		if (queue_port_id >= dsw->num_queues)
+			return 0;
+		return dsw_xstats_queue_get_names(queue_port_id, xstats_names,
+						  ids, size);
 	default:
 		RTE_ASSERT(false);
 		return -1;
@@ -259,6 +373,21 @@ dsw_xstats_port_get(const struct rte_eventdev *dev, uint8_t port_id,
 	return n;
 }
 
+static int
+dsw_xstats_queue_get(const struct rte_eventdev *dev, uint8_t queue_id,
+		     const unsigned int ids[], uint64_t values[], unsigned int n)
+{
+	struct dsw_evdev *dsw = dsw_pmd_priv(dev);
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		unsigned int id = ids[i];
+		struct dsw_xstats_queue *xstat = &dsw_queue_xstats[id];
+		values[i] = xstat->get_value_fn(dsw, queue_id);
+	}
+	return n;
+}
+
 int
 dsw_xstats_get(const struct rte_eventdev *dev,
 	       enum rte_event_dev_xstats_mode mode, uint8_t queue_port_id,
@@ -270,7 +399,7 @@ dsw_xstats_get(const struct rte_eventdev *dev,
 	case RTE_EVENT_DEV_XSTATS_PORT:
 		return dsw_xstats_port_get(dev, queue_port_id, ids, values, n);
 	case RTE_EVENT_DEV_XSTATS_QUEUE:
-		return 0;
+		return dsw_xstats_queue_get(dev, queue_port_id, ids, values, n);
 	default:
 		RTE_ASSERT(false);
 		return -1;
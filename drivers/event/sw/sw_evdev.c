@@ -19,19 +19,27 @@
 #define NUMA_NODE_ARG "numa_node"
 #define SCHED_QUANTA_ARG "sched_quanta"
 #define CREDIT_QUANTA_ARG "credit_quanta"
+#define SCHED_CORES_ARG "sched_cores"
 
 static void
 sw_info_get(struct rte_eventdev *dev, struct rte_event_dev_info *info);
 
+/* Prefix of the object names of a scheduler instance, unique per device */
+static void
+sw_name_prefix(const struct sw_evdev *sw, char *buf, size_t size)
+{
+	if (sw->shard_id == 0)
+		snprintf(buf, size, "sw%d", sw->data->dev_id);
+	else
+		snprintf(buf, size, "sw%d.%u", sw->data->dev_id, sw->shard_id);
+}
+
 static int
-sw_port_link(struct rte_eventdev *dev, void *port, const uint8_t queues[],
-		const uint8_t priorities[], uint16_t num)
+sw_shard_port_link(struct sw_evdev *sw, struct sw_port *p,
+		const uint8_t queues[], uint16_t num)
 {
-	struct sw_port *p = port;
-	struct sw_evdev *sw = sw_pmd_priv(dev);
 	int i;
 
-	RTE_SET_USED(priorities);
 	for (i = 0; i < num; i++) {
 		struct sw_qid *q = &sw->qids[queues[i]];
 		unsigned int j;
@@ -86,11 +94,30 @@ sw_port_link(struct rte_eventdev *dev, void *port, const uint8_t queues[],
 }
 
 static int
-sw_port_unlink(struct rte_eventdev *dev, void *port, uint8_t queues[],
-		uint16_t nb_unlinks)
+sw_port_link(struct rte_eventdev *dev, void *port, const uint8_t queues[],
+		const uint8_t priorities[], uint16_t num)
 {
 	struct sw_port *p = port;
 	struct sw_evdev *sw = sw_pmd_priv(dev);
+	uint32_t i;
+	int ret = 0;
+
+	RTE_SET_USED(priorities);
+
+	/* all the instances have the same links, and link the same queues */
+	for (i = 0; i < sw->nb_shards; i++) {
+		struct sw_evdev *shard = sw->shards[i];
+
+		ret = sw_shard_port_link(shard, &shard->ports[p->id], queues,
+				num);
+	}
+	return ret;
+}
+
+static int
+sw_shard_port_unlink(struct sw_evdev *sw, struct sw_port *p,
+		uint8_t queues[], uint16_t nb_unlinks)
+{
 	unsigned int i, j;
 
 	int unlinked = 0;
@@ -120,37 +147,47 @@ sw_port_unlink(struct rte_eventdev *dev, void *port, uint8_t queues[],
 	return unlinked;
 }
 
+static int
+sw_port_unlink(struct rte_eventdev *dev, void *port, uint8_t queues[],
+		uint16_t nb_unlinks)
+{
+	struct sw_port *p = port;
+	struct sw_evdev *sw = sw_pmd_priv(dev);
+	uint32_t i;
+	int ret = 0;
+
+	for (i = 0; i < sw->nb_shards; i++) {
+		struct sw_evdev *shard = sw->shards[i];
+
+		ret = sw_shard_port_unlink(shard, &shard->ports[p->id], queues,
+				nb_unlinks);
+	}
+	return ret;
+}
+
 static int
 sw_port_unlinks_in_progress(struct rte_eventdev *dev, void *port)
 {
-	RTE_SET_USED(dev);
+	struct sw_evdev *sw = sw_pmd_priv(dev);
 	struct sw_port *p = port;
-	return p->unlinks_in_progress;
+	uint32_t i;
+	int unlinks = 0;
+
+	/* each instance acks the unlinks of its own port */
+	for (i = 0; i < sw->nb_shards; i++)
+		unlinks += sw->shards[i]->ports[p->id].unlinks_in_progress;
+	return unlinks;
 }
 
 static int
-sw_port_setup(struct rte_eventdev *dev, uint8_t port_id,
+sw_shard_port_setup(struct sw_evdev *sw, uint8_t port_id,
 		const struct rte_event_port_conf *conf)
 {
-	struct sw_evdev *sw = sw_pmd_priv(dev);
 	struct sw_port *p = &sw->ports[port_id];
+	char prefix[RTE_RING_NAMESIZE];
 	char buf[RTE_RING_NAMESIZE];
 	unsigned int i;
 
-	struct rte_event_dev_info info;
-	sw_info_get(dev, &info);
-
-	/* detect re-configuring and return credits to instance if needed */
-	if (p->initialized) {
-		/* taking credits from pool is done one quanta at a time, and
-		 * credits may be spend (counted in p->inflights) or still
-		 * available in the port (p->inflight_credits). We must return
-		 * the sum to no leak credits
-		 */
-		int possible_inflights = p->inflight_credits + p->inflights;
-		rte_atomic32_sub(&sw->inflights, possible_inflights);
-	}
-
 	*p = (struct sw_port){0}; /* zero entire structure */
 	p->id = port_id;
 	p->sw = sw;
@@ -159,14 +196,15 @@ sw_port_setup(struct rte_eventdev *dev, uint8_t port_id,
 	 * times legally (assuming device is stopped). If ring exists, free it
 	 * to so it gets re-created with the correct size
 	 */
-	snprintf(buf, sizeof(buf), "sw%d_p%u_%s", dev->data->dev_id,
+	sw_name_prefix(sw, prefix, sizeof(prefix));
+	snprintf(buf, sizeof(buf), "%s_p%u_%s", prefix,
 			port_id, "rx_worker_ring");
 	struct rte_event_ring *existing_ring = rte_event_ring_lookup(buf);
 	if (existing_ring)
 		rte_event_ring_free(existing_ring);
 
 	p->rx_worker_ring = rte_event_ring_create(buf, MAX_SW_PROD_Q_DEPTH,
-			dev->data->socket_id,
+			sw->data->socket_id,
 			RING_F_SP_ENQ | RING_F_SC_DEQ | RING_F_EXACT_SZ);
 	if (p->rx_worker_ring == NULL) {
 		SW_LOG_ERR("Error creating RX worker ring for port %d\n",
@@ -174,18 +212,15 @@ sw_port_setup(struct rte_eventdev *dev, uint8_t port_id,
 		return -1;
 	}
 
-	p->inflight_max = conf->new_event_threshold;
-	p->implicit_release = !conf->disable_implicit_release;
-
 	/* check if ring exists, same as rx_worker above */
-	snprintf(buf, sizeof(buf), "sw%d_p%u, %s", dev->data->dev_id,
+	snprintf(buf, sizeof(buf), "%s_p%u, %s", prefix,
 			port_id, "cq_worker_ring");
 	existing_ring = rte_event_ring_lookup(buf);
 	if (existing_ring)
 		rte_event_ring_free(existing_ring);
 
 	p->cq_worker_ring = rte_event_ring_create(buf, conf->dequeue_depth,
-			dev->data->socket_id,
+			sw->data->socket_id,
 			RING_F_SP_ENQ | RING_F_SC_DEQ | RING_F_EXACT_SZ);
 	if (p->cq_worker_ring == NULL) {
 		rte_event_ring_free(p->rx_worker_ring);
@@ -200,23 +235,77 @@ sw_port_setup(struct rte_eventdev *dev, uint8_t port_id,
 		p->hist_list[i].fid = -1;
 		p->hist_list[i].qid = -1;
 	}
+
+	return 0;
+}
+
+static int
+sw_port_setup(struct rte_eventdev *dev, uint8_t port_id,
+		const struct rte_event_port_conf *conf)
+{
+	struct sw_evdev *sw = sw_pmd_priv(dev);
+	struct sw_port *p = &sw->ports[port_id];
+	unsigned int i;
+
+	struct rte_event_dev_info info;
+	sw_info_get(dev, &info);
+
+	/* detect re-configuring and return credits to instance if needed */
+	if (p->initialized) {
+		/* taking credits from pool is done one quanta at a time, and
+		 * credits may be spend (counted in p->inflights) or still
+		 * available in the port (p->inflight_credits). We must return
+		 * the sum to no leak credits
+		 */
+		int possible_inflights = p->inflight_credits;
+		for (i = 0; i < sw->nb_shards; i++)
+			possible_inflights +=
+				sw->shards[i]->ports[port_id].inflights;
+		rte_atomic32_sub(&sw->inflights, possible_inflights);
+	}
+
+	for (i = 0; i < sw->nb_shards; i++)
+		if (sw_shard_port_setup(sw->shards[i], port_id, conf) < 0)
+			return -1;
+
+	/* the port of the first instance is the one of the application */
+	for (i = 0; i < sw->nb_shards; i++) {
+		struct sw_port *shard_port = &sw->shards[i]->ports[port_id];
+
+		p->shard_rx_ring[i] = shard_port->rx_worker_ring;
+		p->shard_cq_ring[i] = shard_port->cq_worker_ring;
+	}
+	p->inflight_max = conf->new_event_threshold;
+	p->implicit_release = !conf->disable_implicit_release;
 	dev->data->ports[port_id] = p;
 
 	rte_smp_wmb();
-	p->initialized = 1;
+	for (i = 0; i < sw->nb_shards; i++)
+		sw->shards[i]->ports[port_id].initialized = 1;
 	return 0;
 }
 
+static void
+sw_shard_port_release(struct sw_port *p)
+{
+	rte_event_ring_free(p->rx_worker_ring);
+	rte_event_ring_free(p->cq_worker_ring);
+	memset(p, 0, sizeof(*p));
+}
+
 static void
 sw_port_release(void *port)
 {
 	struct sw_port *p = (void *)port;
+	unsigned int i;
+
 	if (p == NULL)
 		return;
 
-	rte_event_ring_free(p->rx_worker_ring);
-	rte_event_ring_free(p->cq_worker_ring);
-	memset(p, 0, sizeof(*p));
+	/* release the port in the other instances first */
+	for (i = 1; p->sw != NULL && i < p->sw->nb_shards; i++)
+		sw_shard_port_release(&p->sw->shards[i]->ports[p->id]);
+	sw_shard_port_release(p);
 }
 
 static int32_t
@@ -224,11 +313,13 @@ qid_init(struct sw_evdev *sw, unsigned int idx, int type,
 		const struct rte_event_queue_conf *queue_conf)
 {
 	unsigned int i;
-	int dev_id = sw->data->dev_id;
 	int socket_id = sw->data->socket_id;
+	char prefix[RTE_RING_NAMESIZE];
 	char buf[IQ_ROB_NAMESIZE];
 	struct sw_qid *qid = &sw->qids[idx];
 
+	sw_name_prefix(sw, prefix, sizeof(prefix));
+
 	/* Initialize the FID structures to no pinning (-1), and zero packets */
 	const struct sw_fid_t fid = {.cq = -1, .pcount = 0};
 	for (i = 0; i < RTE_DIM(qid->fids); i++)
@@ -257,7 +348,7 @@ qid_init(struct sw_evdev *sw, unsigned int idx, int type,
 			goto cleanup;
 		}
 
-		snprintf(buf, sizeof(buf), "sw%d_iq_%d_rob", dev_id, i);
+		snprintf(buf, sizeof(buf), "%s_iq_%d_rob", prefix, i);
 		qid->reorder_buffer = rte_zmalloc_socket(buf,
 				window_size * sizeof(qid->reorder_buffer[0]),
 				0, socket_id);
@@ -270,8 +361,8 @@ qid_init(struct sw_evdev *sw, unsigned int idx, int type,
 		       0,
 		       window_size * sizeof(qid->reorder_buffer[0]));
 
-		snprintf(ring_name, sizeof(ring_name), "sw%d_q%d_freelist",
-				dev_id, idx);
+		snprintf(ring_name, sizeof(ring_name), "%s_q%d_freelist",
+				prefix, idx);
 
 		/* lookup the ring, and if it already exists, free it */
 		struct rte_ring *cleanup = rte_ring_lookup(ring_name);
@@ -320,9 +411,8 @@ qid_init(struct sw_evdev *sw, unsigned int idx, int type,
 }
 
 static void
-sw_queue_release(struct rte_eventdev *dev, uint8_t id)
+qid_release(struct sw_evdev *sw, uint8_t id)
 {
-	struct sw_evdev *sw = sw_pmd_priv(dev);
 	struct sw_qid *qid = &sw->qids[id];
 
 	if (qid->type == RTE_SCHED_TYPE_ORDERED) {
@@ -332,6 +422,16 @@ sw_queue_release(struct rte_eventdev *dev, uint8_t id)
 	memset(qid, 0, sizeof(*qid));
 }
 
+static void
+sw_queue_release(struct rte_eventdev *dev, uint8_t id)
+{
+	struct sw_evdev *sw = sw_pmd_priv(dev);
+	uint32_t i;
+
+	for (i = 0; i < sw->nb_shards; i++)
+		qid_release(sw->shards[i], id);
+}
+
 static int
 sw_queue_setup(struct rte_eventdev *dev, uint8_t queue_id,
 		const struct rte_event_queue_conf *conf)
@@ -349,11 +449,21 @@ sw_queue_setup(struct rte_eventdev *dev, uint8_t queue_id,
 	}
 
 	struct sw_evdev *sw = sw_pmd_priv(dev);
+	uint32_t i;
+	int ret;
 
 	if (sw->qids[queue_id].initialized)
 		sw_queue_release(dev, queue_id);
 
-	return qid_init(sw, queue_id, type, conf);
+	/* each instance schedules the flows it owns, with its own reorder
+	 * window for ordered queues
+	 */
+	for (i = 0; i < sw->nb_shards; i++) {
+		ret = qid_init(sw->shards[i], queue_id, type, conf);
+		if (ret < 0)
+			return ret;
+	}
+	return 0;
 }
 
 static void
@@ -402,6 +512,36 @@ sw_ports_empty(struct sw_evdev *sw)
 	return 1;
 }
 
+static int
+sw_handoff_empty(struct sw_evdev *sw)
+{
+	unsigned int i;
+
+	for (i = 0; i < sw->nb_shards; i++) {
+		if (sw->handoff_ring[i] &&
+		    rte_event_ring_count(sw->handoff_ring[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int
+sw_dev_empty(struct sw_evdev *sw)
+{
+	unsigned int i;
+
+	for (i = 0; i < sw->nb_shards; i++) {
+		struct sw_evdev *shard = sw->shards[i];
+
+		if (!(sw_qids_empty(shard) && sw_ports_empty(shard) &&
+		      sw_handoff_empty(shard)))
+			return 0;
+	}
+
+	return 1;
+}
+
 static void
 sw_drain_ports(struct rte_eventdev *dev)
 {
@@ -429,9 +569,9 @@ sw_drain_ports(struct rte_eventdev *dev)
 }
 
 static void
-sw_drain_queue(struct rte_eventdev *dev, struct sw_iq *iq)
+sw_drain_queue(struct rte_eventdev *dev, struct sw_evdev *sw,
+		struct sw_iq *iq)
 {
-	struct sw_evdev *sw = sw_pmd_priv(dev);
 	eventdev_stop_flush_t flush;
 	uint8_t dev_id;
 	void *arg;
@@ -454,18 +594,22 @@ static void
 sw_drain_queues(struct rte_eventdev *dev)
 {
 	struct sw_evdev *sw = sw_pmd_priv(dev);
-	unsigned int i, j;
+	unsigned int i, j, s;
 
-	for (i = 0; i < sw->qid_count; i++) {
-		for (j = 0; j < SW_IQS_MAX; j++)
-			sw_drain_queue(dev, &sw->qids[i].iq[j]);
+	for (s = 0; s < sw->nb_shards; s++) {
+		struct sw_evdev *shard = sw->shards[s];
+
+		for (i = 0; i < shard->qid_count; i++) {
+			for (j = 0; j < SW_IQS_MAX; j++)
+				sw_drain_queue(dev, shard,
+						&shard->qids[i].iq[j]);
+		}
 	}
 }
 
 static void
-sw_clean_qid_iqs(struct rte_eventdev *dev)
+sw_clean_qid_iqs(struct sw_evdev *sw)
 {
-	struct sw_evdev *sw = sw_pmd_priv(dev);
 	int i, j;
 
 	/* Release the IQ memory of all configured qids */
@@ -512,11 +656,8 @@ sw_port_def_conf(struct rte_eventdev *dev, uint8_t port_id,
 }
 
 static int
-sw_dev_configure(const struct rte_eventdev *dev)
+sw_shard_configure(struct sw_evdev *sw, const struct rte_event_dev_config *conf)
 {
-	struct sw_evdev *sw = sw_pmd_priv(dev);
-	const struct rte_eventdev_data *data = dev->data;
-	const struct rte_event_dev_config *conf = &data->dev_conf;
 	int num_chunks, i;
 
 	sw->qid_count = conf->nb_event_queues;
@@ -547,6 +688,21 @@ sw_dev_configure(const struct rte_eventdev *dev)
 	for (i = 0; i < num_chunks; i++)
 		iq_free_chunk(sw, &sw->chunks[i]);
 
+	return 0;
+}
+
+static int
+sw_dev_configure(const struct rte_eventdev *dev)
+{
+	struct sw_evdev *sw = sw_pmd_priv(dev);
+	const struct rte_eventdev_data *data = dev->data;
+	const struct rte_event_dev_config *conf = &data->dev_conf;
+	uint32_t i;
+
+	for (i = 0; i < sw->nb_shards; i++)
+		if (sw_shard_configure(sw->shards[i], conf) < 0)
+			return -ENOMEM;
+
 	if (conf->event_dev_cfg & RTE_EVENT_DEV_CFG_PER_DEQUEUE_TIMEOUT)
 		return -ENOTSUP;
 
@@ -639,6 +795,14 @@ sw_dump(struct rte_eventdev *dev, FILE *f)
 	fprintf(f, "\tsched cq/qid call: %"PRIu64"\n", sw->sched_cq_qid_called);
 	fprintf(f, "\tsched no IQ enq: %"PRIu64"\n", sw->sched_no_iq_enqueues);
 	fprintf(f, "\tsched no CQ enq: %"PRIu64"\n", sw->sched_no_cq_enqueues);
+	for (i = 1; i < sw->nb_shards; i++) {
+		const struct sw_evdev *shard = sw->shards[i];
+
+		fprintf(f, "\tinstance %u: rx %"PRIu64"\tdrop %"PRIu64
+			"\ttx %"PRIu64"\tsched calls %"PRIu64"\n", i,
+			shard->stats.rx_pkts, shard->stats.rx_dropped,
+			shard->stats.tx_pkts, shard->sched_called);
+	}
 	uint32_t inflights = rte_atomic32_read(&sw->inflights);
 	uint32_t credits = sw->nb_events_limit - inflights;
 	fprintf(f, "\tinflight %d, credits: %d\n", inflights, credits);
@@ -771,19 +935,9 @@ sw_dump(struct rte_eventdev *dev, FILE *f)
 }
 
 static int
-sw_start(struct rte_eventdev *dev)
+sw_shard_start(struct sw_evdev *sw)
 {
 	unsigned int i, j;
-	struct sw_evdev *sw = sw_pmd_priv(dev);
-
-	rte_service_component_runstate_set(sw->service_id, 1);
-
-	/* check a service core is mapped to this service */
-	if (!rte_service_runstate_get(sw->service_id)) {
-		SW_LOG_ERR("Warning: No Service core enabled on service %s\n",
-				sw->service_name);
-		return -ENOENT;
-	}
 
 	/* check all ports are set up */
 	for (i = 0; i < sw->port_count; i++)
@@ -818,11 +972,37 @@ sw_start(struct rte_eventdev *dev)
 
 	sw_init_qid_iqs(sw);
 
+	return 0;
+}
+
+static int
+sw_start(struct rte_eventdev *dev)
+{
+	unsigned int i;
+	struct sw_evdev *sw = sw_pmd_priv(dev);
+	int ret;
+
+	rte_service_component_runstate_set(sw->service_id, 1);
+
+	/* check a service core is mapped to this service */
+	if (!rte_service_runstate_get(sw->service_id)) {
+		SW_LOG_ERR("Warning: No Service core enabled on service %s\n",
+				sw->service_name);
+		return -ENOENT;
+	}
+
+	for (i = 0; i < sw->nb_shards; i++) {
+		ret = sw_shard_start(sw->shards[i]);
+		if (ret < 0)
+			return ret;
+	}
+
 	if (sw_xstats_init(sw) < 0)
 		return -EINVAL;
 
 	rte_smp_wmb();
-	sw->started = 1;
+	for (i = 0; i < sw->nb_shards; i++)
+		sw->shards[i]->started = 1;
 
 	return 0;
 }
@@ -832,6 +1012,7 @@ sw_stop(struct rte_eventdev *dev)
 {
 	struct sw_evdev *sw = sw_pmd_priv(dev);
 	int32_t runstate;
+	uint32_t i;
 
 	/* Stop the scheduler if it's running */
 	runstate = rte_service_runstate_get(sw->service_id);
@@ -842,15 +1023,17 @@ sw_stop(struct rte_eventdev *dev)
 		rte_pause();
 
 	/* Flush all events out of the device */
-	while (!(sw_qids_empty(sw) && sw_ports_empty(sw))) {
+	while (!sw_dev_empty(sw)) {
 		sw_event_schedule(dev);
 		sw_drain_ports(dev);
 		sw_drain_queues(dev);
 	}
 
-	sw_clean_qid_iqs(dev);
+	for (i = 0; i < sw->nb_shards; i++)
+		sw_clean_qid_iqs(sw->shards[i]);
 	sw_xstats_uninit(sw);
-	sw->started = 0;
+	for (i = 0; i < sw->nb_shards; i++)
+		sw->shards[i]->started = 0;
 	rte_smp_wmb();
 
 	if (runstate == 1)
@@ -865,17 +1048,21 @@ sw_close(struct rte_eventdev *dev)
 
 	for (i = 0; i < sw->qid_count; i++)
 		sw_queue_release(dev, i);
-	sw->qid_count = 0;
 
 	for (i = 0; i < sw->port_count; i++)
 		sw_port_release(&sw->ports[i]);
-	sw->port_count = 0;
 
-	memset(&sw->stats, 0, sizeof(sw->stats));
-	sw->sched_called = 0;
-	sw->sched_no_iq_enqueues = 0;
-	sw->sched_no_cq_enqueues = 0;
-	sw->sched_cq_qid_called = 0;
+	for (i = 0; i < sw->nb_shards; i++) {
+		struct sw_evdev *shard = sw->shards[i];
+
+		shard->qid_count = 0;
+		shard->port_count = 0;
+		memset(&shard->stats, 0, sizeof(shard->stats));
+		shard->sched_called = 0;
+		shard->sched_no_iq_enqueues = 0;
+		shard->sched_no_cq_enqueues = 0;
+		shard->sched_cq_qid_called = 0;
+	}
 
 	return 0;
 }
@@ -910,6 +1097,16 @@ set_credit_quanta(const char *key __rte_unused, const char *value, void *opaque)
 	return 0;
 }
 
+static int
+set_sched_cores(const char *key __rte_unused, const char *value, void *opaque)
+{
+	int *cores = opaque;
+	*cores = atoi(value);
+	if (*cores < 1 || *cores > SW_SCHED_SHARDS_MAX)
+		return -1;
+	return 0;
+}
+
 
 static int32_t sw_sched_service_func(void *args)
 {
@@ -918,6 +1115,89 @@ static int32_t sw_sched_service_func(void *args)
 	return 0;
 }
 
+static int32_t sw_sched_mc_service_func(void *args)
+{
+	struct rte_eventdev *dev = args;
+	sw_event_schedule_mc(dev);
+	return 0;
+}
+
+static void
+sw_shards_free(struct sw_evdev *sw)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < sw->nb_shards; i++) {
+		struct sw_evdev *shard = sw->shards[i];
+
+		if (shard == NULL)
+			continue;
+		for (j = 0; j < sw->nb_shards; j++)
+			rte_event_ring_free(shard->handoff_ring[j]);
+		if (i != 0)
+			rte_free(shard);
+	}
+	sw->nb_shards = 1;
+}
+
+/* Allocate the scheduler instances of the multi-core scheduling mode, and
+ * the rings between each of them. The first instance is the device itself.
+ */
+static int
+sw_shards_alloc(struct sw_evdev *sw, int nb_shards, int socket_id)
+{
+	char prefix[RTE_RING_NAMESIZE];
+	char buf[RTE_RING_NAMESIZE];
+	int i, j;
+
+	sw->nb_shards = nb_shards;
+	sw->shards[0] = sw;
+	rte_spinlock_init(&sw->sched_lock);
+	if (nb_shards == 1)
+		return 0;
+
+	for (i = 1; i < nb_shards; i++) {
+		struct sw_evdev *shard = rte_zmalloc_socket(NULL,
+				sizeof(*shard), RTE_CACHE_LINE_SIZE, socket_id);
+		if (shard == NULL)
+			goto err;
+
+		shard->data = sw->data;
+		shard->sched_quanta = sw->sched_quanta;
+		shard->credit_update_quanta = sw->credit_update_quanta;
+		shard->shard_id = i;
+		rte_spinlock_init(&shard->sched_lock);
+		sw->shards[i] = shard;
+	}
+
+	for (i = 0; i < nb_shards; i++) {
+		struct sw_evdev *shard = sw->shards[i];
+
+		memcpy(shard->shards, sw->shards, sizeof(sw->shards));
+		shard->nb_shards = nb_shards;
+
+		sw_name_prefix(shard, prefix, sizeof(prefix));
+		for (j = 0; j < nb_shards; j++) {
+			if (j == i)
+				continue;
+			snprintf(buf, sizeof(buf), "%s_h%d", prefix, j);
+			shard->handoff_ring[j] = rte_event_ring_create(buf,
+					SW_INFLIGHT_EVENTS_TOTAL, socket_id,
+					RING_F_SP_ENQ | RING_F_SC_DEQ |
+					RING_F_EXACT_SZ);
+			if (shard->handoff_ring[j] == NULL)
+				goto err;
+		}
+	}
+
+	return 0;
+
+err:
+	SW_LOG_ERR("Error allocating scheduler instance\n");
+	sw_shards_free(sw);
+	return -ENOMEM;
+}
+
 static int
 sw_probe(struct rte_vdev_device *vdev)
 {
@@ -957,6 +1237,7 @@ sw_probe(struct rte_vdev_device *vdev)
 		NUMA_NODE_ARG,
 		SCHED_QUANTA_ARG,
 		CREDIT_QUANTA_ARG,
+		SCHED_CORES_ARG,
 		NULL
 	};
 	const char *name;
@@ -966,6 +1247,7 @@ sw_probe(struct rte_vdev_device *vdev)
 	int socket_id = rte_socket_id();
 	int sched_quanta  = SW_DEFAULT_SCHED_QUANTA;
 	int credit_quanta = SW_DEFAULT_CREDIT_QUANTA;
+	int sched_cores = 1;
 
 	name = rte_vdev_device_name(vdev);
 	params = rte_vdev_device_args(vdev);
@@ -1007,13 +1289,24 @@ sw_probe(struct rte_vdev_device *vdev)
 				return ret;
 			}
 
+			ret = rte_kvargs_process(kvlist, SCHED_CORES_ARG,
+					set_sched_cores, &sched_cores);
+			if (ret != 0) {
+				SW_LOG_ERR(
+					"%s: Error parsing sched cores parameter",
+					name);
+				rte_kvargs_free(kvlist);
+				return ret;
+			}
+
 			rte_kvargs_free(kvlist);
 		}
 	}
 
 	SW_LOG_INFO(
-			"Creating eventdev sw device %s, numa_node=%d, sched_quanta=%d, credit_quanta=%d\n",
-			name, socket_id, sched_quanta, credit_quanta);
+			"Creating eventdev sw device %s, numa_node=%d, sched_quanta=%d, credit_quanta=%d, sched_cores=%d\n",
+			name, socket_id, sched_quanta, credit_quanta,
+			sched_cores);
 
 	dev = rte_event_pmd_vdev_init(name,
 			sizeof(struct sw_evdev), socket_id);
@@ -1028,6 +1321,14 @@ sw_probe(struct rte_vdev_device *vdev)
 	dev->enqueue_forward_burst = sw_event_enqueue_burst;
 	dev->dequeue = sw_event_dequeue;
 	dev->dequeue_burst = sw_event_dequeue_burst;
+	if (sched_cores > 1) {
+		dev->enqueue = sw_event_enqueue_mc;
+		dev->enqueue_burst = sw_event_enqueue_burst_mc;
+		dev->enqueue_new_burst = sw_event_enqueue_burst_mc;
+		dev->enqueue_forward_burst = sw_event_enqueue_burst_mc;
+		dev->dequeue = sw_event_dequeue_mc;
+		dev->dequeue_burst = sw_event_dequeue_burst_mc;
+	}
 
 	if (rte_eal_process_type() != RTE_PROC_PRIMARY)
 		return 0;
@@ -1039,6 +1340,9 @@ sw_probe(struct rte_vdev_device *vdev)
 	sw->credit_update_quanta = credit_quanta;
 	sw->sched_quanta = sched_quanta;
 
+	if (sw_shards_alloc(sw, sched_cores, socket_id) < 0)
+		return -ENOMEM;
+
 	/* register service with EAL */
 	struct rte_service_spec service;
 	memset(&service, 0, sizeof(struct rte_service_spec));
@@ -1048,10 +1352,16 @@ sw_probe(struct rte_vdev_device *vdev)
 	service.socket_id = socket_id;
 	service.callback = sw_sched_service_func;
 	service.callback_userdata = (void *)dev;
+	/* each core running the service schedules one instance at a time */
+	if (sched_cores > 1) {
+		service.callback = sw_sched_mc_service_func;
+		service.capabilities = RTE_SERVICE_CAP_MT_SAFE;
+	}
 
 	int32_t ret = rte_service_component_register(&service, &sw->service_id);
 	if (ret) {
 		SW_LOG_ERR("service register() failed");
+		sw_shards_free(sw);
 		return -ENOEXEC;
 	}
 
@@ -1064,6 +1374,7 @@ sw_probe(struct rte_vdev_device *vdev)
 static int
 sw_remove(struct rte_vdev_device *vdev)
 {
+	struct rte_eventdev *dev;
 	const char *name;
 
 	name = rte_vdev_device_name(vdev);
@@ -1072,6 +1383,10 @@ sw_remove(struct rte_vdev_device *vdev)
 
 	SW_LOG_INFO("Closing eventdev sw device %s\n", name);
 
+	dev = rte_event_pmd_get_named_dev(name);
+	if (dev != NULL && rte_eal_process_type() == RTE_PROC_PRIMARY)
+		sw_shards_free(sw_pmd_priv(dev));
+
 	return rte_event_pmd_vdev_uninit(name);
 }
 
@@ -1082,7 +1397,8 @@ static struct rte_vdev_driver evdev_sw_pmd_drv = {
 
 RTE_PMD_REGISTER_VDEV(EVENTDEV_NAME_SW_PMD, evdev_sw_pmd_drv);
 RTE_PMD_REGISTER_PARAM_STRING(event_sw, NUMA_NODE_ARG "=<int> "
-		SCHED_QUANTA_ARG "=<int>" CREDIT_QUANTA_ARG "=<int>");
+		SCHED_QUANTA_ARG "=<int>" CREDIT_QUANTA_ARG "=<int>"
+		SCHED_CORES_ARG "=<int>");
 
 /* declared extern in header, for access from other .c files */
 int eventdev_sw_log_level;
@@ -9,6 +9,7 @@
 #include <rte_eventdev.h>
 #include <rte_eventdev_pmd_vdev.h>
 #include <rte_atomic.h>
+#include <rte_spinlock.h>
 
 #define SW_DEFAULT_CREDIT_QUANTA 32
 #define SW_DEFAULT_SCHED_QUANTA 128
@@ -21,6 +22,8 @@
 /* allow for lots of over-provisioning */
 #define MAX_SW_PROD_Q_DEPTH 4096
 #define SW_FRAGMENTS_MAX 16
+/* max scheduler instances of a device in multi-core scheduling mode */
+#define SW_SCHED_SHARDS_MAX 8
 
 /* Should be power-of-two minus one, to leave room for the next pointer */
 #define SW_EVS_PER_Q_CHUNK 255
@@ -42,6 +45,10 @@
 
 #define SW_NUM_POLL_BUCKETS (MAX_SW_CONS_Q_DEPTH >> SW_DEQ_STAT_BUCKET_SHIFT)
 
+#define FLOWID_MASK (SW_QID_NUM_FIDS-1)
+/* use cheap bit mixing, we only need to lose a few bits */
+#define SW_HASH_FLOWID(f) (((f) ^ (f >> 10)) & FLOWID_MASK)
+
 enum {
 	QE_FLAG_VALID_SHIFT = 0,
 	QE_FLAG_COMPLETE_SHIFT,
@@ -168,6 +175,12 @@ struct sw_port {
 	/** Ring and buffer for pushing packets to workers after scheduling */
 	struct rte_event_ring *cq_worker_ring;
 
+	/* Multi-core scheduling: rings of this port in each scheduler
+	 * instance, set in the port of the first instance only
+	 */
+	struct rte_event_ring *shard_rx_ring[SW_SCHED_SHARDS_MAX];
+	struct rte_event_ring *shard_cq_ring[SW_SCHED_SHARDS_MAX];
+
 	/* hole */
 
 	/* num releases yet to be completed on this port */
@@ -175,6 +188,9 @@ struct sw_port {
 	uint16_t inflight_max; /* app requested max inflights for this port */
 	uint16_t inflight_credits; /* num credits this port has right now */
 	uint8_t implicit_release; /* release events before dequeueing */
+	uint8_t deq_shard_next; /* instance to dequeue from first */
+	uint16_t deq_shard_head;
+	uint16_t deq_shard_tail;
 
 	uint16_t last_dequeue_burst_sz; /* how big the burst was */
 	uint64_t last_dequeue_ticks; /* used to track burst processing time */
@@ -201,6 +217,11 @@ struct sw_port {
 	struct rte_event cq_buf[MAX_SW_CONS_Q_DEPTH];
 
 	uint8_t num_qids_mapped;
+
+	/* Multi-core scheduling: instance each event yet to be released was
+	 * dequeued from, in dequeue order, to send its completion back to
+	 */
+	uint8_t deq_shards[SW_PORT_HIST_LIST];
 };
 
 struct sw_evdev {
@@ -256,6 +277,23 @@ struct sw_evdev {
 
 	uint32_t service_id;
 	char service_name[SW_PMD_NAME_MAX];
+
+	/* Multi-core scheduling: the flows are sharded across instances of
+	 * this structure, each scheduled by one service core at a time. The
+	 * first instance is the device private data.
+	 */
+	struct sw_evdev *shards[SW_SCHED_SHARDS_MAX];
+	uint8_t nb_shards;
+	uint8_t shard_id;
+	rte_spinlock_t sched_lock;
+
+	/* Rings and buffers handing events over to the instance owning their
+	 * flow, indexed by destination instance
+	 */
+	struct rte_event_ring *handoff_ring[SW_SCHED_SHARDS_MAX];
+	uint16_t handoff_buf_count[SW_SCHED_SHARDS_MAX];
+	struct rte_event handoff_buf[SW_SCHED_SHARDS_MAX]
+			[SCHED_DEQUEUE_BURST_SIZE];
 };
 
 static inline struct sw_evdev *
@@ -270,6 +308,14 @@ sw_pmd_priv_const(const struct rte_eventdev *eventdev)
 	return eventdev->data->dev_private;
 }
 
+/* Scheduler instance owning a flow in multi-core scheduling mode */
+static inline uint32_t
+sw_flow_shard(const struct sw_evdev *sw, uint32_t flow_id)
+{
+	return (SW_HASH_FLOWID(flow_id) * sw->nb_shards) >>
+			__builtin_ctz(SW_QID_NUM_FIDS);
+}
+
 uint16_t sw_event_enqueue(void *port, const struct rte_event *ev);
 uint16_t sw_event_enqueue_burst(void *port, const struct rte_event ev[],
 		uint16_t num);
@@ -277,7 +323,14 @@ uint16_t sw_event_enqueue_burst(void *port, const struct rte_event ev[],
 uint16_t sw_event_dequeue(void *port, struct rte_event *ev, uint64_t wait);
 uint16_t sw_event_dequeue_burst(void *port, struct rte_event *ev, uint16_t num,
 			uint64_t wait);
+uint16_t sw_event_enqueue_mc(void *port, const struct rte_event *ev);
+uint16_t sw_event_enqueue_burst_mc(void *port, const struct rte_event ev[],
+		uint16_t num);
+uint16_t sw_event_dequeue_mc(void *port, struct rte_event *ev, uint64_t wait);
+uint16_t sw_event_dequeue_burst_mc(void *port, struct rte_event *ev,
+		uint16_t num, uint64_t wait);
 void sw_event_schedule(struct rte_eventdev *dev);
+void sw_event_schedule_mc(struct rte_eventdev *dev);
 int sw_xstats_init(struct sw_evdev *dev);
 int sw_xstats_uninit(struct sw_evdev *dev);
 int sw_xstats_get_names(const struct rte_eventdev *dev,
@@ -4,6 +4,7 @@
 
 #include <rte_ring.h>
 #include <rte_hash_crc.h>
+#include <rte_per_lcore.h>
 #include <rte_event_ring.h>
 #include "sw_evdev.h"
 #include "iq_chunk.h"
@@ -22,9 +23,44 @@
 #define PRIO_TO_IQ(prio) (prio >> 6)
 
 #define MAX_PER_IQ_DEQUEUE 48
-#define FLOWID_MASK (SW_QID_NUM_FIDS-1)
-/* use cheap bit mixing, we only need to lose a few bits */
-#define SW_HASH_FLOWID(f) (((f) ^ (f >> 10)) & FLOWID_MASK)
+
+/* instance the next multi-core schedule call of an lcore starts with */
+static RTE_DEFINE_PER_LCORE(uint32_t, sw_next_shard);
+
+static inline void
+sw_handoff_flush(struct sw_evdev *sw, uint32_t shard)
+{
+	/* the ring holds all the events the device allows in flight, the
+	 * enqueue cannot fail
+	 */
+	rte_event_ring_enqueue_burst(sw->handoff_ring[shard],
+			sw->handoff_buf[shard], sw->handoff_buf_count[shard],
+			NULL);
+	sw->handoff_buf_count[shard] = 0;
+}
+
+/* Multi-core scheduling: events reaching an instance which does not own
+ * their flow, forwarded or reordered events, are handed over to the owner.
+ * Returns 1 if the event was handed over.
+ */
+static inline int
+sw_handoff(struct sw_evdev *sw, const struct rte_event *qe)
+{
+	uint32_t shard;
+
+	if (sw->nb_shards == 1)
+		return 0;
+
+	shard = sw_flow_shard(sw, qe->flow_id);
+	if (shard == sw->shard_id)
+		return 0;
+
+	sw->handoff_buf[shard][sw->handoff_buf_count[shard]++] = *qe;
+	if (sw->handoff_buf_count[shard] == SCHED_DEQUEUE_BURST_SIZE)
+		sw_handoff_flush(sw, shard);
+
+	return 1;
+}
 
 static inline uint32_t
 sw_schedule_atomic_to_cq(struct sw_evdev *sw, struct sw_qid * const qid,
@@ -299,6 +335,9 @@ sw_schedule_reorder(struct sw_evdev *sw, int qid_start, int qid_end)
 					continue;
 				}
 
+				if (sw_handoff(sw, qe))
+					continue;
+
 				pkts_iter++;
 
 				struct sw_qid *q = &sw->qids[dest_qid];
@@ -430,6 +469,9 @@ __pull_port_lb(struct sw_evdev *sw, uint32_t port_id, int allow_reorder)
 				goto end_qe;
 			}
 
+			if (sw_handoff(sw, qe))
+				goto end_qe;
+
 			/* Use the iq_num from above to push the QE
 			 * into the qid at the right priority
 			 */
@@ -484,6 +526,9 @@ sw_schedule_pull_port_dir(struct sw_evdev *sw, uint32_t port_id)
 
 		port->stats.rx_pkts++;
 
+		if (sw_handoff(sw, qe))
+			goto end_qe;
+
 		/* Use the iq_num from above to push the QE
 		 * into the qid at the right priority
 		 */
@@ -501,10 +546,39 @@ sw_schedule_pull_port_dir(struct sw_evdev *sw, uint32_t port_id)
 	return pkts_iter;
 }
 
-void
-sw_event_schedule(struct rte_eventdev *dev)
+static uint32_t
+sw_schedule_pull_handoff(struct sw_evdev *sw)
+{
+	struct rte_event qes[SCHED_DEQUEUE_BURST_SIZE];
+	uint32_t pkts_iter = 0;
+	uint32_t i, j, n;
+
+	for (i = 0; i < sw->nb_shards; i++) {
+		if (i == sw->shard_id)
+			continue;
+
+		n = rte_event_ring_dequeue_burst(
+				sw->shards[i]->handoff_ring[sw->shard_id],
+				qes, RTE_DIM(qes), NULL);
+		for (j = 0; j < n; j++) {
+			const struct rte_event *qe = &qes[j];
+			uint32_t iq_num = PRIO_TO_IQ(qe->priority);
+			struct sw_qid *qid = &sw->qids[qe->queue_id];
+
+			qid->iq_pkt_mask |= (1 << (iq_num));
+			iq_enqueue(sw, &qid->iq[iq_num], qe);
+			qid->iq_pkt_count[iq_num]++;
+			qid->stats.rx_pkts++;
+		}
+		pkts_iter += n;
+	}
+
+	return pkts_iter;
+}
+
+static void
+sw_schedule(struct sw_evdev *sw)
 {
-	struct sw_evdev *sw = sw_pmd_priv(dev);
 	uint32_t in_pkts, out_pkts;
 	uint32_t out_pkts_total = 0, in_pkts_total = 0;
 	int32_t sched_quanta = sw->sched_quanta;
@@ -536,6 +610,10 @@ sw_event_schedule(struct rte_eventdev *dev)
 			/* QID scan for re-ordered */
 			in_pkts += sw_schedule_reorder(sw, 0,
 					sw->qid_count);
+
+			/* events handed over by the other instances */
+			if (sw->nb_shards > 1)
+				in_pkts += sw_schedule_pull_handoff(sw);
 			in_pkts_this_iteration += in_pkts;
 		} while (in_pkts > 4 &&
 				(int)in_pkts_this_iteration < sched_quanta);
@@ -565,4 +643,40 @@ sw_event_schedule(struct rte_eventdev *dev)
 		sw->ports[i].cq_buf_count = 0;
 	}
 
+	for (i = 0; i < sw->nb_shards; i++)
+		if (sw->handoff_buf_count[i])
+			sw_handoff_flush(sw, i);
+}
+
+void
+sw_event_schedule(struct rte_eventdev *dev)
+{
+	struct sw_evdev *sw = sw_pmd_priv(dev);
+	uint32_t i;
+
+	for (i = 0; i < sw->nb_shards; i++)
+		sw_schedule(sw->shards[i]);
+}
+
+void
+sw_event_schedule_mc(struct rte_eventdev *dev)
+{
+	struct sw_evdev *sw = sw_pmd_priv(dev);
+	uint32_t start = RTE_PER_LCORE(sw_next_shard)++;
+	uint32_t i;
+
+	/* Run one instance not already scheduled by another service core,
+	 * starting from a different one on each call so that a single core
+	 * still goes through all of them.
+	 */
+	for (i = 0; i < sw->nb_shards; i++) {
+		struct sw_evdev *shard =
+			sw->shards[(start + i) % sw->nb_shards];
+
+		if (rte_spinlock_trylock(&shard->sched_lock)) {
+			sw_schedule(shard);
+			rte_spinlock_unlock(&shard->sched_lock);
+			return;
+		}
+	}
 }
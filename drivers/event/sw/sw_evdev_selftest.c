@@ -2951,6 +2951,191 @@ dev_stop_flush(struct test *t) /* test to check we can properly flush events */
 	return -1;
 }
 
+/* Enqueue all the events, the port getting credits a quanta at a time */
+static int
+multi_core_enqueue(uint8_t port, struct rte_event *ev, int nb_events)
+{
+	int enq = 0;
+
+	while (enq < nb_events) {
+		int n = rte_event_enqueue_burst(evdev, port, &ev[enq],
+				nb_events - enq);
+		if (n == 0)
+			break;
+		enq += n;
+	}
+	return enq;
+}
+
+/* Schedule and dequeue until all the events are dequeued */
+static int
+multi_core_dequeue(struct test *t, uint8_t port, struct rte_event *ev,
+		int nb_events)
+{
+	int deq = 0;
+	int i;
+
+	for (i = 0; i < 64 && deq < nb_events; i++) {
+		rte_service_run_iter_on_app_lcore(t->service_id, 1);
+		deq += rte_event_dequeue_burst(evdev, port, &ev[deq],
+				nb_events - deq, 0);
+	}
+	return deq;
+}
+
+static int
+multi_core_sched_check(struct test *t)
+{
+	static const struct rte_event_port_conf conf = {
+			.new_event_threshold = 1024,
+			.dequeue_depth = 32,
+			.enqueue_depth = 64,
+			.disable_implicit_release = 1,
+	};
+	struct rte_event ev[64];
+	uint64_t flows[64];
+	const int nb_events = RTE_DIM(ev);
+	int i, j;
+
+	/* one atomic queue per port, port 0 to queue 0, port 1 to queue 1 */
+	if (init(t, 2, 2) < 0 ||
+			create_atomic_qids(t, 2) < 0) {
+		printf("%d: Error initializing device\n", __LINE__);
+		return -1;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (rte_event_port_setup(evdev, i, &conf) < 0) {
+			printf("%d: Error setting up port %d\n", __LINE__, i);
+			goto err;
+		}
+		t->port[i] = i;
+		if (rte_event_port_link(evdev, t->port[i], &t->qid[i], NULL,
+				1) != 1) {
+			printf("%d: Error links queue to port\n", __LINE__);
+			goto err;
+		}
+	}
+
+	if (rte_event_dev_start(evdev) < 0) {
+		printf("%d: Error with start call\n", __LINE__);
+		goto err;
+	}
+
+	/* flows spread over the scheduler instances */
+	for (i = 0; i < nb_events; i++) {
+		ev[i] = (struct rte_event){
+			.op = RTE_EVENT_OP_NEW,
+			.queue_id = t->qid[0],
+			.flow_id = i * 331,
+			.u64 = i,
+		};
+	}
+	if (multi_core_enqueue(t->port[0], ev, nb_events) != nb_events) {
+		printf("%d: Error doing first enqueue\n", __LINE__);
+		goto err;
+	}
+
+	if (multi_core_dequeue(t, t->port[0], ev, nb_events) != nb_events) {
+		printf("%d: Error dequeuing events\n", __LINE__);
+		goto err;
+	}
+
+	/* forward with new flows, handed over to their instance */
+	for (i = 0; i < nb_events; i++) {
+		flows[ev[i].u64] = ev[i].flow_id;
+		ev[i].op = RTE_EVENT_OP_FORWARD;
+		ev[i].queue_id = t->qid[1];
+		ev[i].flow_id = ev[i].u64 * 977 + 1;
+	}
+	if (multi_core_enqueue(t->port[0], ev, nb_events) != nb_events) {
+		printf("%d: Error forwarding events\n", __LINE__);
+		goto err;
+	}
+
+	if (multi_core_dequeue(t, t->port[1], ev, nb_events) != nb_events) {
+		printf("%d: Error dequeuing forwarded events\n", __LINE__);
+		goto err;
+	}
+
+	/* all the events went through once, with their forwarded flow */
+	for (i = 0; i < nb_events; i++) {
+		if (ev[i].u64 >= (uint64_t)nb_events ||
+				ev[i].flow_id != ev[i].u64 * 977 + 1 ||
+				flows[ev[i].u64] != ev[i].u64 * 331) {
+			printf("%d: Unexpected event %"PRIu64"\n", __LINE__,
+					ev[i].u64);
+			goto err;
+		}
+		for (j = 0; j < i; j++)
+			if (ev[j].u64 == ev[i].u64) {
+				printf("%d: Duplicate event %"PRIu64"\n",
+						__LINE__, ev[i].u64);
+				goto err;
+			}
+	}
+
+	for (i = 0; i < nb_events; i++)
+		ev[i].op = RTE_EVENT_OP_RELEASE;
+	if (multi_core_enqueue(t->port[1], ev, nb_events) != nb_events) {
+		printf("%d: Error releasing events\n", __LINE__);
+		goto err;
+	}
+	for (i = 0; i < 2 * SW_SCHED_SHARDS_MAX; i++)
+		rte_service_run_iter_on_app_lcore(t->service_id, 1);
+
+	for (i = 0; i < 2; i++) {
+		char name[32];
+
+		snprintf(name, sizeof(name), "port_%u_inflight", i);
+		if (rte_event_dev_xstats_by_name_get(evdev, name, NULL) != 0) {
+			printf("%d: Port %d has events in flight\n",
+					__LINE__, i);
+			goto err;
+		}
+	}
+
+	cleanup(t);
+	return 0;
+err:
+	rte_event_dev_dump(evdev, stdout);
+	cleanup(t);
+	return -1;
+}
+
+/* Run the scheduler sharded over 4 instances, on a dedicated device */
+static int
+multi_core_sched(struct test *t)
+{
+	const char *name = "event_sw_mc";
+	uint32_t service_id = t->service_id;
+	int dev_id = evdev;
+	int ret = -1;
+
+	if (rte_vdev_init(name, "sched_cores=4") < 0) {
+		printf("%d: Error creating eventdev %s\n", __LINE__, name);
+		return -1;
+	}
+
+	evdev = rte_event_dev_get_dev_id(name);
+	if (evdev < 0 ||
+			rte_event_dev_service_id_get(evdev,
+				&t->service_id) < 0) {
+		printf("%d: Error finding eventdev %s\n", __LINE__, name);
+		goto out;
+	}
+	rte_service_runstate_set(t->service_id, 1);
+	rte_service_set_runstate_mapped_check(t->service_id, 0);
+
+	ret = multi_core_sched_check(t);
+
+out:
+	rte_vdev_uninit(name);
+	evdev = dev_id;
+	t->service_id = service_id;
+	return ret;
+}
+
 static int
 worker_loopback_worker_fn(void *arg)
 {
@@ -3367,6 +3552,12 @@ test_sw_eventdev(void)
 		printf("ERROR - Stop Flush test FAILED.\n");
 		goto test_fail;
 	}
+	printf("*** Running Multi-core Scheduler test...\n");
+	ret = multi_core_sched(t);
+	if (ret != 0) {
+		printf("ERROR - Multi-core Scheduler test FAILED.\n");
+		goto test_fail;
+	}
 	if (rte_lcore_count() >= 3) {
 		printf("*** Running Worker loopback test...\n");
 		ret = worker_loopback(t, 0);
@@ -10,8 +10,15 @@
 
 #define PORT_ENQUEUE_MAX_BURST_SIZE 64
 
+/* Multi-core scheduling: instance the next completion of the port goes to */
+static inline uint32_t
+sw_completion_shard(struct sw_port *p)
+{
+	return p->deq_shards[p->deq_shard_tail++ & (SW_PORT_HIST_LIST - 1)];
+}
+
 static inline void
-sw_event_release(struct sw_port *p, uint8_t index)
+sw_event_release(struct sw_port *p, uint8_t index, const int mc)
 {
 	/*
 	 * Drops the next outstanding event in our history. Used on dequeue
@@ -23,8 +30,12 @@ sw_event_release(struct sw_port *p, uint8_t index)
 	struct rte_event ev;
 	ev.op = sw_qe_flag_map[RTE_EVENT_OP_RELEASE];
 
+	struct rte_event_ring *ring = p->rx_worker_ring;
+	if (mc)
+		ring = p->shard_rx_ring[sw_completion_shard(p)];
+
 	uint16_t free_count;
-	rte_event_ring_enqueue_burst(p->rx_worker_ring, &ev, 1, &free_count);
+	rte_event_ring_enqueue_burst(ring, &ev, 1, &free_count);
 
 	/* each release returns one credit */
 	p->outstanding_releases--;
@@ -49,8 +60,54 @@ enqueue_burst_with_ops(struct rte_event_ring *r, const struct rte_event *events,
 	return rte_event_ring_enqueue_burst(r, tmp_evs, n, NULL);
 }
 
-uint16_t
-sw_event_enqueue_burst(void *port, const struct rte_event ev[], uint16_t num)
+/*
+ * Multi-core scheduling variant of enqueue_burst_with_ops: completions go to
+ * the instance the event was dequeued from, new events to the instance owning
+ * their flow. Stops at the first event not fitting in its ring.
+ */
+static inline unsigned int
+mc_enqueue_burst_with_ops(struct sw_port *p, const struct rte_event *events,
+		unsigned int n, uint8_t *ops)
+{
+	struct rte_event tmp_evs[SW_SCHED_SHARDS_MAX]
+			[PORT_ENQUEUE_MAX_BURST_SIZE];
+	unsigned int count[SW_SCHED_SHARDS_MAX] = {0};
+	unsigned int space[SW_SCHED_SHARDS_MAX];
+	const struct sw_evdev *sw = p->sw;
+	unsigned int i, s;
+
+	for (s = 0; s < sw->nb_shards; s++)
+		space[s] = rte_event_ring_free_count(p->shard_rx_ring[s]);
+
+	for (i = 0; i < n; i++) {
+		const int completion = (ops[i] & QE_FLAG_COMPLETE) &&
+				p->deq_shard_head != p->deq_shard_tail;
+
+		if (completion)
+			s = p->deq_shards[p->deq_shard_tail &
+					(SW_PORT_HIST_LIST - 1)];
+		else
+			s = sw_flow_shard(sw, events[i].flow_id);
+
+		if (count[s] == space[s])
+			break;
+
+		p->deq_shard_tail += completion;
+		tmp_evs[s][count[s]] = events[i];
+		tmp_evs[s][count[s]++].op = ops[i];
+	}
+
+	for (s = 0; s < sw->nb_shards; s++)
+		if (count[s])
+			rte_event_ring_enqueue_burst(p->shard_rx_ring[s],
+					tmp_evs[s], count[s], NULL);
+
+	return i;
+}
+
+static __rte_always_inline uint16_t
+__sw_event_enqueue_burst(void *port, const struct rte_event ev[], uint16_t num,
+		const int mc)
 {
 	int32_t i;
 	uint8_t new_ops[PORT_ENQUEUE_MAX_BURST_SIZE];
@@ -110,7 +167,11 @@ sw_event_enqueue_burst(void *port, const struct rte_event ev[], uint16_t num)
 	}
 
 	/* returns number of events actually enqueued */
-	uint32_t enq = enqueue_burst_with_ops(p->rx_worker_ring, ev, i,
+	uint32_t enq;
+	if (mc)
+		enq = mc_enqueue_burst_with_ops(p, ev, i, new_ops);
+	else
+		enq = enqueue_burst_with_ops(p->rx_worker_ring, ev, i,
 					     new_ops);
 	if (p->outstanding_releases == 0 && p->last_dequeue_burst_sz != 0) {
 		uint64_t burst_ticks = rte_get_timer_cycles() -
@@ -131,6 +192,12 @@ sw_event_enqueue_burst(void *port, const struct rte_event ev[], uint16_t num)
 	return enq;
 }
 
+uint16_t
+sw_event_enqueue_burst(void *port, const struct rte_event ev[], uint16_t num)
+{
+	return __sw_event_enqueue_burst(port, ev, num, 0);
+}
+
 uint16_t
 sw_event_enqueue(void *port, const struct rte_event *ev)
 {
@@ -138,8 +205,53 @@ sw_event_enqueue(void *port, const struct rte_event *ev)
 }
 
 uint16_t
-sw_event_dequeue_burst(void *port, struct rte_event *ev, uint16_t num,
-		uint64_t wait)
+sw_event_enqueue_burst_mc(void *port, const struct rte_event ev[],
+		uint16_t num)
+{
+	return __sw_event_enqueue_burst(port, ev, num, 1);
+}
+
+uint16_t
+sw_event_enqueue_mc(void *port, const struct rte_event *ev)
+{
+	return sw_event_enqueue_burst_mc(port, ev, 1);
+}
+
+/*
+ * Multi-core scheduling: dequeue from the CQ rings of the port in each
+ * instance, recording the instance of each event for its completion.
+ */
+static inline uint16_t
+mc_dequeue_burst(struct sw_port *p, struct rte_event *ev, uint16_t num)
+{
+	const uint32_t nb_shards = p->sw->nb_shards;
+	uint16_t space = SW_PORT_HIST_LIST -
+			(uint16_t)(p->deq_shard_head - p->deq_shard_tail);
+	uint16_t ndeq = 0;
+	uint32_t i, j;
+
+	num = RTE_MIN(num, space);
+	for (i = 0; i < nb_shards && ndeq < num; i++) {
+		uint32_t s = p->deq_shard_next;
+		uint16_t n;
+
+		if (++p->deq_shard_next == nb_shards)
+			p->deq_shard_next = 0;
+
+		n = rte_event_ring_dequeue_burst(p->shard_cq_ring[s],
+				&ev[ndeq], num - ndeq, NULL);
+		for (j = 0; j < n; j++)
+			p->deq_shards[p->deq_shard_head++ &
+					(SW_PORT_HIST_LIST - 1)] = s;
+		ndeq += n;
+	}
+
+	return ndeq;
+}
+
+static __rte_always_inline uint16_t
+__sw_event_dequeue_burst(void *port, struct rte_event *ev, uint16_t num,
+		uint64_t wait, const int mc)
 {
 	RTE_SET_USED(wait);
 	struct sw_port *p = (void *)port;
@@ -152,7 +264,7 @@ sw_event_dequeue_burst(void *port, struct rte_event *ev, uint16_t num,
 		uint16_t out_rels = p->outstanding_releases;
 		uint16_t i;
 		for (i = 0; i < out_rels; i++)
-			sw_event_release(p, i);
+			sw_event_release(p, i, mc);
 
 		/* Replenish credits if enough releases are performed */
 		if (p->inflight_credits >= credit_update_quanta * 2) {
@@ -162,7 +274,11 @@ sw_event_dequeue_burst(void *port, struct rte_event *ev, uint16_t num,
 	}
 
 	/* returns number of events actually dequeued */
-	uint16_t ndeq = rte_event_ring_dequeue_burst(ring, ev, num, NULL);
+	uint16_t ndeq;
+	if (mc)
+		ndeq = mc_dequeue_burst(p, ev, num);
+	else
+		ndeq = rte_event_ring_dequeue_burst(ring, ev, num, NULL);
 	if (unlikely(ndeq == 0)) {
 		p->zero_polls++;
 		p->total_polls++;
@@ -179,8 +295,28 @@ sw_event_dequeue_burst(void *port, struct rte_event *ev, uint16_t num,
 	return ndeq;
 }
 
+uint16_t
+sw_event_dequeue_burst(void *port, struct rte_event *ev, uint16_t num,
+		uint64_t wait)
+{
+	return __sw_event_dequeue_burst(port, ev, num, wait, 0);
+}
+
 uint16_t
 sw_event_dequeue(void *port, struct rte_event *ev, uint64_t wait)
 {
 	return sw_event_dequeue_burst(port, ev, 1, wait);
 }
+
+uint16_t
+sw_event_dequeue_burst_mc(void *port, struct rte_event *ev, uint16_t num,
+		uint64_t wait)
+{
+	return __sw_event_dequeue_burst(port, ev, num, wait, 1);
+}
+
+uint16_t
+sw_event_dequeue_mc(void *port, struct rte_event *ev, uint64_t wait)
+{
+	return sw_event_dequeue_burst_mc(port, ev, 1, wait);
+}
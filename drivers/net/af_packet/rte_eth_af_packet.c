@@ -30,6 +30,9 @@
 #define ETH_AF_PACKET_FRAMESIZE_ARG	"framesz"
 #define ETH_AF_PACKET_FRAMECOUNT_ARG	"framecnt"
 #define ETH_AF_PACKET_QDISC_BYPASS_ARG	"qdisc_bypass"
+#define ETH_AF_PACKET_TPACKET_V3_ARG	"tpacket_v3"
+#define ETH_AF_PACKET_BLOCKTMO_ARG	"blocktmo"
+#define ETH_AF_PACKET_RX_ZERO_COPY_ARG	"rx_zero_copy"
 
 #define DFLT_BLOCK_SIZE		(1 << 12)
 #define DFLT_FRAME_SIZE		(1 << 11)
@@ -37,6 +40,14 @@
 
 #define RTE_PMD_AF_PACKET_MAX_RINGS 16
 
+/* TPACKET_V3 Rx block referenced by zero-copy mbufs */
+struct pkt_rx_block {
+	struct rte_mbuf_ext_shared_info shinfo;
+	struct tpacket_block_desc *pbd;
+	/* set until the last mbuf pointing into the block is freed */
+	volatile uint8_t held;
+};
+
 struct pkt_rx_queue {
 	int sockfd;
 
@@ -45,6 +56,14 @@ struct pkt_rx_queue {
 	unsigned int framecount;
 	unsigned int framenum;
 
+	/* TPACKET_V3 block ring */
+	unsigned int blocksize;
+	unsigned int blockcount;
+	unsigned int blocknum;
+	uint32_t blk_pkts; /* packets left in the current block */
+	struct tpacket3_hdr *next_pkt;
+	struct pkt_rx_block *zc_blocks; /* NULL without zero-copy */
+
 	struct rte_mempool *mb_pool;
 	uint16_t in_port;
 
@@ -75,6 +94,8 @@ struct pmd_internals {
 	struct ether_addr eth_addr;
 
 	struct tpacket_req req;
+	struct tpacket_req3 req3;
+	unsigned int tpacket_v3;
 
 	struct pkt_rx_queue rx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
 	struct pkt_tx_queue tx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
@@ -87,6 +108,9 @@ static const char *valid_arguments[] = {
 	ETH_AF_PACKET_FRAMESIZE_ARG,
 	ETH_AF_PACKET_FRAMECOUNT_ARG,
 	ETH_AF_PACKET_QDISC_BYPASS_ARG,
+	ETH_AF_PACKET_TPACKET_V3_ARG,
+	ETH_AF_PACKET_BLOCKTMO_ARG,
+	ETH_AF_PACKET_RX_ZERO_COPY_ARG,
 	NULL
 };
 
@@ -163,6 +187,161 @@ eth_af_packet_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	return num_rx;
 }
 
+/*
+ * Return a TPACKET_V3 block to the kernel, once the last zero-copy mbuf
+ * pointing into it is freed.
+ */
+static void
+eth_af_packet_rx_block_free(void *addr __rte_unused, void *opaque)
+{
+	struct pkt_rx_block *blk = opaque;
+
+	blk->pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	rte_smp_wmb();
+	blk->held = 0;
+}
+
+/*
+ * Done reading the current block: release it, or drop the reference of
+ * the queue when zero-copy mbufs point into it, and advance the ring.
+ */
+static inline void
+eth_af_packet_rx_block_close(struct pkt_rx_queue *pkt_q)
+{
+	struct tpacket_block_desc *pbd;
+	struct pkt_rx_block *blk;
+
+	if (pkt_q->zc_blocks != NULL) {
+		blk = &pkt_q->zc_blocks[pkt_q->blocknum];
+		if (rte_mbuf_ext_refcnt_update(&blk->shinfo, -1) == 0)
+			eth_af_packet_rx_block_free(NULL, blk);
+	} else {
+		pbd = (struct tpacket_block_desc *)
+			(pkt_q->map + pkt_q->blocknum * pkt_q->blocksize);
+		pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	}
+
+	pkt_q->blk_pkts = 0;
+	if (++pkt_q->blocknum >= pkt_q->blockcount)
+		pkt_q->blocknum = 0;
+}
+
+/*
+ * Start reading the next block retired by the kernel, return its number of
+ * packets.
+ */
+static inline uint32_t
+eth_af_packet_rx_block_open(struct pkt_rx_queue *pkt_q)
+{
+	struct tpacket_block_desc *pbd;
+	struct pkt_rx_block *blk = NULL;
+
+	if (pkt_q->zc_blocks != NULL) {
+		/* still referenced by mbufs of the previous ring round */
+		blk = &pkt_q->zc_blocks[pkt_q->blocknum];
+		if (blk->held)
+			return 0;
+		rte_smp_rmb();
+	}
+
+	pbd = (struct tpacket_block_desc *)
+		(pkt_q->map + pkt_q->blocknum * pkt_q->blocksize);
+	if ((pbd->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+		return 0;
+	rte_smp_rmb();
+
+	/* the queue holds a reference until it has read the whole block */
+	if (blk != NULL) {
+		blk->held = 1;
+		rte_mbuf_ext_refcnt_set(&blk->shinfo, 1);
+	}
+	pkt_q->blk_pkts = pbd->hdr.bh1.num_pkts;
+	pkt_q->next_pkt = (struct tpacket3_hdr *)
+		((uint8_t *)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+	if (unlikely(pkt_q->blk_pkts == 0))
+		eth_af_packet_rx_block_close(pkt_q);
+	return pkt_q->blk_pkts;
+}
+
+static uint16_t
+eth_af_packet_rx_v3(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct tpacket3_hdr *ppd;
+	struct rte_mbuf *mbuf;
+	uint8_t *pbuf;
+	struct pkt_rx_queue *pkt_q = queue;
+	struct pkt_rx_block *blk;
+	uint16_t num_rx = 0;
+	unsigned long num_rx_bytes = 0;
+	unsigned long num_err = 0;
+
+	/*
+	 * Reads the packets of the blocks retired by the kernel, either
+	 * full or after the block timeout, in ring order. Each packet is
+	 * copied into a newly allocated mbuf, or with zero-copy, an mbuf
+	 * pointing into the ring is attached to it.
+	 */
+	while (num_rx < nb_pkts) {
+		if (pkt_q->blk_pkts == 0 &&
+		    eth_af_packet_rx_block_open(pkt_q) == 0)
+			break;
+
+		ppd = pkt_q->next_pkt;
+
+		/* allocate the next mbuf */
+		mbuf = rte_pktmbuf_alloc(pkt_q->mb_pool);
+		if (unlikely(mbuf == NULL))
+			break;
+
+		pbuf = (uint8_t *)ppd + ppd->tp_mac;
+		if (pkt_q->zc_blocks != NULL) {
+			blk = &pkt_q->zc_blocks[pkt_q->blocknum];
+			rte_pktmbuf_attach_extbuf(mbuf, ppd, RTE_BAD_IOVA,
+				ppd->tp_mac + ppd->tp_snaplen, &blk->shinfo);
+			rte_mbuf_ext_refcnt_update(&blk->shinfo, 1);
+			mbuf->data_off = ppd->tp_mac;
+		} else if (unlikely(ppd->tp_snaplen >
+				    rte_pktmbuf_tailroom(mbuf))) {
+			/* packet does not fit in the mbuf, drop it */
+			rte_pktmbuf_free(mbuf);
+			mbuf = NULL;
+			num_err++;
+		} else {
+			memcpy(rte_pktmbuf_mtod(mbuf, void *), pbuf,
+			       ppd->tp_snaplen);
+		}
+
+		if (mbuf != NULL) {
+			rte_pktmbuf_pkt_len(mbuf) = ppd->tp_snaplen;
+			rte_pktmbuf_data_len(mbuf) = ppd->tp_snaplen;
+
+			/* check for vlan info */
+			if (ppd->tp_status & TP_STATUS_VLAN_VALID) {
+				mbuf->vlan_tci = ppd->hv1.tp_vlan_tci;
+				mbuf->ol_flags |= (PKT_RX_VLAN |
+						   PKT_RX_VLAN_STRIPPED);
+			}
+			mbuf->hash.rss = ppd->hv1.tp_rxhash;
+			mbuf->ol_flags |= PKT_RX_RSS_HASH;
+			mbuf->port = pkt_q->in_port;
+
+			/* account for the receive frame */
+			bufs[num_rx++] = mbuf;
+			num_rx_bytes += mbuf->pkt_len;
+		}
+
+		/* advance in the block, release it after its last packet */
+		pkt_q->next_pkt = (struct tpacket3_hdr *)
+			((uint8_t *)ppd + ppd->tp_next_offset);
+		if (--pkt_q->blk_pkts == 0)
+			eth_af_packet_rx_block_close(pkt_q);
+	}
+	pkt_q->rx_pkts += num_rx;
+	pkt_q->rx_bytes += num_rx_bytes;
+	pkt_q->err_pkts += num_err;
+	return num_rx;
+}
+
 /*
  * Callback to handle sending packets through a real NIC.
  */
@@ -238,8 +417,9 @@ eth_af_packet_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 		rte_pktmbuf_free(mbuf);
 	}
 
-	/* kick-off transmits */
-	if (sendto(pkt_q->sockfd, NULL, 0, MSG_DONTWAIT, NULL, 0) == -1) {
+	/* kick-off transmits, all the frames of the burst at once */
+	if (num_tx != 0 &&
+	    sendto(pkt_q->sockfd, NULL, 0, MSG_DONTWAIT, NULL, 0) == -1) {
 		/* error sending -- no packets transmitted */
 		num_tx = 0;
 		num_tx_bytes = 0;
@@ -398,7 +578,11 @@ eth_rx_queue_setup(struct rte_eth_dev *dev,
 	data_size = internals->req.tp_frame_size;
 	data_size -= TPACKET2_HDRLEN - sizeof(struct sockaddr_ll);
 
-	if (data_size > buf_size) {
+	/*
+	 * TPACKET_V3 packets are only bounded by the block size, they are
+	 * dropped when too large for the mbuf, or not copied with zero-copy.
+	 */
+	if (data_size > buf_size && !internals->tpacket_v3) {
 		PMD_LOG(ERR,
 			"%s: %d bytes will not fit in mbuf (%d bytes)",
 			dev->device->name, data_size, buf_size);
@@ -528,6 +712,88 @@ open_packet_iface(const char *key __rte_unused,
 	return 0;
 }
 
+/*
+ * Opens the TPACKET_V2 Tx ring socket of a queue whose Rx ring uses
+ * TPACKET_V3, bound to the interface without receiving any packet.
+ */
+static int
+open_packet_tx_socket(const char *name, const char *iface, int if_index,
+		      struct tpacket_req *req, unsigned int qdisc_bypass,
+		      struct pkt_tx_queue *tx_queue)
+{
+	struct sockaddr_ll sockaddr;
+	int tpver = TPACKET_V2;
+	int discard = 1;
+	int sockfd;
+
+	/* no packet is received by a socket of protocol 0 */
+	sockfd = socket(AF_PACKET, SOCK_RAW, 0);
+	if (sockfd == -1) {
+		PMD_LOG(ERR, "%s: could not open Tx AF_PACKET socket", name);
+		return -1;
+	}
+
+	if (setsockopt(sockfd, SOL_PACKET, PACKET_VERSION,
+		       &tpver, sizeof(tpver)) == -1 ||
+	    setsockopt(sockfd, SOL_PACKET, PACKET_LOSS,
+		       &discard, sizeof(discard)) == -1) {
+		PMD_LOG(ERR,
+			"%s: could not set up Tx AF_PACKET socket for %s",
+			name, iface);
+		goto error;
+	}
+
+#if defined(PACKET_QDISC_BYPASS)
+	if (setsockopt(sockfd, SOL_PACKET, PACKET_QDISC_BYPASS,
+		       &qdisc_bypass, sizeof(qdisc_bypass)) == -1) {
+		PMD_LOG(ERR,
+			"%s: could not set PACKET_QDISC_BYPASS on Tx AF_PACKET socket for %s",
+			name, iface);
+		goto error;
+	}
+#else
+	RTE_SET_USED(qdisc_bypass);
+#endif
+
+	if (setsockopt(sockfd, SOL_PACKET, PACKET_TX_RING,
+		       req, sizeof(*req)) == -1) {
+		PMD_LOG(ERR,
+			"%s: could not set PACKET_TX_RING on AF_PACKET socket for %s",
+			name, iface);
+		goto error;
+	}
+
+	tx_queue->map = mmap(NULL, req->tp_block_size * req->tp_block_nr,
+			     PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED,
+			     sockfd, 0);
+	if (tx_queue->map == MAP_FAILED) {
+		PMD_LOG(ERR,
+			"%s: call to mmap failed on Tx AF_PACKET socket for %s",
+			name, iface);
+		goto error;
+	}
+
+	memset(&sockaddr, 0, sizeof(sockaddr));
+	sockaddr.sll_family = AF_PACKET;
+	sockaddr.sll_ifindex = if_index;
+	if (bind(sockfd, (const struct sockaddr *)&sockaddr,
+		 sizeof(sockaddr)) == -1) {
+		PMD_LOG(ERR,
+			"%s: could not bind Tx AF_PACKET socket to %s",
+			name, iface);
+		munmap(tx_queue->map, req->tp_block_size * req->tp_block_nr);
+		tx_queue->map = MAP_FAILED;
+		goto error;
+	}
+
+	tx_queue->sockfd = sockfd;
+	return 0;
+
+error:
+	close(sockfd);
+	return -1;
+}
+
 static struct rte_vdev_driver pmd_af_packet_drv;
 
 static int
@@ -539,6 +805,9 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
                        unsigned int framesize,
                        unsigned int framecnt,
 		       unsigned int qdisc_bypass,
+		       unsigned int tpacket_v3,
+		       unsigned int blocktmo,
+		       unsigned int rx_zero_copy,
                        struct pmd_internals **internals,
                        struct rte_eth_dev **eth_dev,
                        struct rte_kvargs *kvlist)
@@ -552,6 +821,8 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 	unsigned k_idx;
 	struct sockaddr_ll sockaddr;
 	struct tpacket_req *req;
+	struct tpacket_req3 *req3;
+	struct pkt_rx_block *blk;
 	struct pkt_rx_queue *rx_queue;
 	struct pkt_tx_queue *tx_queue;
 	int rc, tpver, discard;
@@ -594,6 +865,17 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 	req->tp_frame_size = framesize;
 	req->tp_frame_nr = framecnt;
 
+	req3 = &((*internals)->req3);
+
+	req3->tp_block_size = blocksize;
+	req3->tp_block_nr = blockcnt;
+	req3->tp_frame_size = framesize;
+	req3->tp_frame_nr = framecnt;
+	req3->tp_retire_blk_tov = blocktmo;
+	req3->tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+	(*internals)->tpacket_v3 = tpacket_v3;
+
 	ifnamelen = strlen(pair->value);
 	if (ifnamelen < sizeof(ifr.ifr_name)) {
 		memcpy(ifr.ifr_name, pair->value, ifnamelen);
@@ -646,7 +928,7 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			return -1;
 		}
 
-		tpver = TPACKET_V2;
+		tpver = tpacket_v3 ? TPACKET_V3 : TPACKET_V2;
 		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_VERSION,
 				&tpver, sizeof(tpver));
 		if (rc == -1) {
@@ -656,77 +938,138 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			goto error;
 		}
 
-		discard = 1;
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_LOSS,
-				&discard, sizeof(discard));
-		if (rc == -1) {
-			PMD_LOG(ERR,
-				"%s: could not set PACKET_LOSS on AF_PACKET socket for %s",
-				name, pair->value);
-			goto error;
-		}
+		rx_queue = &((*internals)->rx_queue[q]);
+		tx_queue = &((*internals)->tx_queue[q]);
+
+		if (tpacket_v3) {
+			/*
+			 * The Rx ring is made of blocks retired by the kernel
+			 * when full or after blocktmo, the Tx ring keeps
+			 * TPACKET_V2 frames on its own socket.
+			 */
+			rc = open_packet_tx_socket(name, pair->value,
+					(*internals)->if_index, req,
+					qdisc_bypass, tx_queue);
+			if (rc == -1)
+				goto error;
+
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING,
+					req3, sizeof(*req3));
+			if (rc == -1) {
+				PMD_LOG(ERR,
+					"%s: could not set PACKET_RX_RING on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
+
+			rx_queue->blocksize = req3->tp_block_size;
+			rx_queue->blockcount = req3->tp_block_nr;
+			rx_queue->map = mmap(NULL,
+					req3->tp_block_size * req3->tp_block_nr,
+					PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_LOCKED, qsockfd, 0);
+			if (rx_queue->map == MAP_FAILED) {
+				PMD_LOG(ERR,
+					"%s: call to mmap failed on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
+
+			if (rx_zero_copy) {
+				rx_queue->zc_blocks = rte_zmalloc_socket(name,
+					req3->tp_block_nr *
+					sizeof(*(rx_queue->zc_blocks)),
+					RTE_CACHE_LINE_SIZE, numa_node);
+				if (rx_queue->zc_blocks == NULL)
+					goto error;
+				for (i = 0; i < req3->tp_block_nr; ++i) {
+					blk = &rx_queue->zc_blocks[i];
+					blk->pbd = (struct tpacket_block_desc *)
+						(rx_queue->map +
+						 i * req3->tp_block_size);
+					blk->shinfo.free_cb =
+						eth_af_packet_rx_block_free;
+					blk->shinfo.fcb_opaque = blk;
+				}
+			}
+		} else {
+			discard = 1;
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_LOSS,
+					&discard, sizeof(discard));
+			if (rc == -1) {
+				PMD_LOG(ERR,
+					"%s: could not set PACKET_LOSS on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
 
 #if defined(PACKET_QDISC_BYPASS)
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_QDISC_BYPASS,
-				&qdisc_bypass, sizeof(qdisc_bypass));
-		if (rc == -1) {
-			PMD_LOG(ERR,
-				"%s: could not set PACKET_QDISC_BYPASS on AF_PACKET socket for %s",
-				name, pair->value);
-			goto error;
-		}
-#else
-		RTE_SET_USED(qdisc_bypass);
+			rc = setsockopt(qsockfd, SOL_PACKET,
+					PACKET_QDISC_BYPASS,
+					&qdisc_bypass, sizeof(qdisc_bypass));
+			if (rc == -1) {
+				PMD_LOG(ERR,
+					"%s: could not set PACKET_QDISC_BYPASS on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
 #endif
 
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING, req, sizeof(*req));
-		if (rc == -1) {
-			PMD_LOG(ERR,
-				"%s: could not set PACKET_RX_RING on AF_PACKET socket for %s",
-				name, pair->value);
-			goto error;
-		}
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING,
+					req, sizeof(*req));
+			if (rc == -1) {
+				PMD_LOG(ERR,
+					"%s: could not set PACKET_RX_RING on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
 
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_TX_RING, req, sizeof(*req));
-		if (rc == -1) {
-			PMD_LOG(ERR,
-				"%s: could not set PACKET_TX_RING on AF_PACKET "
-				"socket for %s", name, pair->value);
-			goto error;
-		}
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_TX_RING,
+					req, sizeof(*req));
+			if (rc == -1) {
+				PMD_LOG(ERR,
+					"%s: could not set PACKET_TX_RING on AF_PACKET "
+					"socket for %s", name, pair->value);
+				goto error;
+			}
 
-		rx_queue = &((*internals)->rx_queue[q]);
-		rx_queue->framecount = req->tp_frame_nr;
+			rx_queue->framecount = req->tp_frame_nr;
 
-		rx_queue->map = mmap(NULL, 2 * req->tp_block_size * req->tp_block_nr,
-				    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED,
-				    qsockfd, 0);
-		if (rx_queue->map == MAP_FAILED) {
-			PMD_LOG(ERR,
-				"%s: call to mmap failed on AF_PACKET socket for %s",
-				name, pair->value);
-			goto error;
-		}
+			rx_queue->map = mmap(NULL, 2 * req->tp_block_size *
+					req->tp_block_nr,
+					PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_LOCKED, qsockfd, 0);
+			if (rx_queue->map == MAP_FAILED) {
+				PMD_LOG(ERR,
+					"%s: call to mmap failed on AF_PACKET socket for %s",
+					name, pair->value);
+				goto error;
+			}
 
-		/* rdsize is same for both Tx and Rx */
-		rdsize = req->tp_frame_nr * sizeof(*(rx_queue->rd));
+			rx_queue->rd = rte_zmalloc_socket(name,
+					req->tp_frame_nr *
+					sizeof(*(rx_queue->rd)),
+					0, numa_node);
+			if (rx_queue->rd == NULL)
+				goto error;
+			for (i = 0; i < req->tp_frame_nr; ++i) {
+				rx_queue->rd[i].iov_base =
+					rx_queue->map + (i * framesize);
+				rx_queue->rd[i].iov_len = req->tp_frame_size;
+			}
 
-		rx_queue->rd = rte_zmalloc_socket(name, rdsize, 0, numa_node);
-		if (rx_queue->rd == NULL)
-			goto error;
-		for (i = 0; i < req->tp_frame_nr; ++i) {
-			rx_queue->rd[i].iov_base = rx_queue->map + (i * framesize);
-			rx_queue->rd[i].iov_len = req->tp_frame_size;
+			tx_queue->map = rx_queue->map +
+				req->tp_block_size * req->tp_block_nr;
+			tx_queue->sockfd = qsockfd;
 		}
 		rx_queue->sockfd = qsockfd;
 
-		tx_queue = &((*internals)->tx_queue[q]);
 		tx_queue->framecount = req->tp_frame_nr;
 		tx_queue->frame_data_size = req->tp_frame_size;
 		tx_queue->frame_data_size -= TPACKET2_HDRLEN -
 			sizeof(struct sockaddr_ll);
 
-		tx_queue->map = rx_queue->map + req->tp_block_size * req->tp_block_nr;
+		rdsize = req->tp_frame_nr * sizeof(*(tx_queue->rd));
 
 		tx_queue->rd = rte_zmalloc_socket(name, rdsize, 0, numa_node);
 		if (tx_queue->rd == NULL)
@@ -735,7 +1078,6 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 			tx_queue->rd[i].iov_base = tx_queue->map + (i * framesize);
 			tx_queue->rd[i].iov_len = req->tp_frame_size;
 		}
-		tx_queue->sockfd = qsockfd;
 
 		rc = bind(qsockfd, (const struct sockaddr*)&sockaddr, sizeof(sockaddr));
 		if (rc == -1) {
@@ -787,14 +1129,29 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 	if (qsockfd != -1)
 		close(qsockfd);
 	for (q = 0; q < nb_queues; q++) {
-		munmap((*internals)->rx_queue[q].map,
-		       2 * req->tp_block_size * req->tp_block_nr);
-
-		rte_free((*internals)->rx_queue[q].rd);
-		rte_free((*internals)->tx_queue[q].rd);
-		if (((*internals)->rx_queue[q].sockfd != 0) &&
-			((*internals)->rx_queue[q].sockfd != qsockfd))
-			close((*internals)->rx_queue[q].sockfd);
+		rx_queue = &((*internals)->rx_queue[q]);
+		tx_queue = &((*internals)->tx_queue[q]);
+
+		if (tpacket_v3) {
+			munmap(rx_queue->map,
+			       req3->tp_block_size * req3->tp_block_nr);
+			munmap(tx_queue->map,
+			       req->tp_block_size * req->tp_block_nr);
+		} else {
+			munmap(rx_queue->map,
+			       2 * req->tp_block_size * req->tp_block_nr);
+		}
+
+		rte_free(rx_queue->rd);
+		rte_free(rx_queue->zc_blocks);
+		rte_free(tx_queue->rd);
+		if ((tx_queue->sockfd != 0) &&
+			(tx_queue->sockfd != rx_queue->sockfd) &&
+			(tx_queue->sockfd != qsockfd))
+			close(tx_queue->sockfd);
+		if ((rx_queue->sockfd != 0) &&
+			(rx_queue->sockfd != qsockfd))
+			close(rx_queue->sockfd);
 	}
 	free((*internals)->if_name);
 	rte_free(*internals);
@@ -817,6 +1174,9 @@ rte_eth_from_packet(struct rte_vdev_device *dev,
 	unsigned int framecount = DFLT_FRAME_COUNT;
 	unsigned int qpairs = 1;
 	unsigned int qdisc_bypass = 1;
+	unsigned int tpacket_v3 = 0;
+	unsigned int blocktmo = 0; /* kernel default */
+	unsigned int rx_zero_copy = 0;
 
 	/* do some parameter checking */
 	if (*sockfd < 0)
@@ -878,6 +1238,36 @@ rte_eth_from_packet(struct rte_vdev_device *dev,
 			}
 			continue;
 		}
+		if (strstr(pair->key, ETH_AF_PACKET_TPACKET_V3_ARG) != NULL) {
+			tpacket_v3 = atoi(pair->value);
+			if (tpacket_v3 > 1) {
+				PMD_LOG(ERR,
+					"%s: invalid tpacket_v3 value",
+					name);
+				return -1;
+			}
+			continue;
+		}
+		if (strstr(pair->key, ETH_AF_PACKET_BLOCKTMO_ARG) != NULL) {
+			blocktmo = atoi(pair->value);
+			continue;
+		}
+		if (strstr(pair->key, ETH_AF_PACKET_RX_ZERO_COPY_ARG) != NULL) {
+			rx_zero_copy = atoi(pair->value);
+			if (rx_zero_copy > 1) {
+				PMD_LOG(ERR,
+					"%s: invalid rx_zero_copy value",
+					name);
+				return -1;
+			}
+			continue;
+		}
+	}
+
+	if (rx_zero_copy && !tpacket_v3) {
+		PMD_LOG(ERR,
+			"%s: Rx zero copy requires tpacket_v3=1", name);
+		return -1;
 	}
 
 	if (framesize > blocksize) {
@@ -899,16 +1289,24 @@ rte_eth_from_packet(struct rte_vdev_device *dev,
 	PMD_LOG(INFO, "%s:\tblock count %d", name, blockcount);
 	PMD_LOG(INFO, "%s:\tframe size %d", name, framesize);
 	PMD_LOG(INFO, "%s:\tframe count %d", name, framecount);
+	if (tpacket_v3) {
+		PMD_LOG(INFO, "%s:\tTPACKET_V3 Rx, block timeout %u ms%s",
+			name, blocktmo, rx_zero_copy ? ", zero copy" : "");
+	}
 
 	if (rte_pmd_init_internals(dev, *sockfd, qpairs,
 				   blocksize, blockcount,
 				   framesize, framecount,
 				   qdisc_bypass,
+				   tpacket_v3, blocktmo, rx_zero_copy,
 				   &internals, &eth_dev,
 				   kvlist) < 0)
 		return -1;
 
-	eth_dev->rx_pkt_burst = eth_af_packet_rx;
+	if (tpacket_v3)
+		eth_dev->rx_pkt_burst = eth_af_packet_rx_v3;
+	else
+		eth_dev->rx_pkt_burst = eth_af_packet_rx;
 	eth_dev->tx_pkt_burst = eth_af_packet_tx;
 
 	rte_eth_dev_probing_finish(eth_dev);
@@ -995,6 +1393,7 @@ rte_pmd_af_packet_remove(struct rte_vdev_device *dev)
 	internals = eth_dev->data->dev_private;
 	for (q = 0; q < internals->nb_queues; q++) {
 		rte_free(internals->rx_queue[q].rd);
+		rte_free(internals->rx_queue[q].zc_blocks);
 		rte_free(internals->tx_queue[q].rd);
 	}
 	free(internals->if_name);
@@ -1017,7 +1416,10 @@ RTE_PMD_REGISTER_PARAM_STRING(net_af_packet,
 	"blocksz=<int> "
 	"framesz=<int> "
 	"framecnt=<int> "
-	"qdisc_bypass=<0|1>");
+	"qdisc_bypass=<0|1> "
+	"tpacket_v3=<0|1> "
+	"blocktmo=<int> "
+	"rx_zero_copy=<0|1>");
 
 RTE_INIT(af_packet_init_log)
 {
@@ -0,0 +1,1105 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation.
+ */
+
+#include <rte_mbuf.h>
+#include <rte_mbuf_pool_ops.h>
+#include <rte_mempool.h>
+#include <rte_memzone.h>
+#include <rte_ethdev_driver.h>
+#include <rte_ethdev_vdev.h>
+#include <rte_malloc.h>
+#include <rte_kvargs.h>
+#include <rte_bus_vdev.h>
+#include <rte_string_fns.h>
+
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include <bpf/libbpf.h>
+#include <bpf/xsk.h>
+
+#define ETH_AF_XDP_IFACE_ARG		"iface"
+#define ETH_AF_XDP_START_QUEUE_ARG	"start_queue"
+#define ETH_AF_XDP_QUEUE_COUNT_ARG	"queue_count"
+#define ETH_AF_XDP_SHARED_UMEM_ARG	"shared_umem"
+#define ETH_AF_XDP_BUSY_BUDGET_ARG	"busy_budget"
+
+#define ETH_AF_XDP_MAX_QUEUE_PAIRS	16
+
+#define ETH_AF_XDP_FRAME_SIZE		XSK_UMEM__DEFAULT_FRAME_SIZE
+#define ETH_AF_XDP_NUM_BUFFERS		8192
+#define ETH_AF_XDP_DFLT_NUM_DESCS	XSK_RING_CONS__DEFAULT_NUM_DESCS
+#define ETH_AF_XDP_MP_CACHE_SIZE	256
+#define ETH_AF_XDP_RX_BATCH_SIZE	32
+#define ETH_AF_XDP_TX_BATCH_SIZE	32
+
+/* size of the mempool object header, first in each UMEM frame */
+#define ETH_AF_XDP_OBJHDR_SIZE \
+	RTE_CACHE_LINE_ROUNDUP(sizeof(struct rte_mempool_objhdr))
+/* offset of the packet data in a UMEM frame */
+#define ETH_AF_XDP_DATA_HEADROOM \
+	(ETH_AF_XDP_OBJHDR_SIZE + sizeof(struct rte_mbuf) + \
+	 RTE_PKTMBUF_HEADROOM)
+
+#define ETH_AF_XDP_BUSY_POLL_TIMEOUT	20 /* us */
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL		69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET		70
+#endif
+
+/*
+ * A UMEM is the memory area of a mempool of ETH_AF_XDP_FRAME_SIZE objects,
+ * each one filling exactly a UMEM frame: the mbuf of a frame is the one
+ * of the packet received in it, and an mbuf of the pool is sent without
+ * any copy.
+ */
+struct xsk_umem_info {
+	struct xsk_umem *umem;
+	struct rte_mempool *mb_pool;
+	const struct rte_memzone *mz;
+	char *buffer;
+	uint32_t mbuf_offset; /* offset of the mbuf in a frame */
+	unsigned int refcnt;
+};
+
+struct pkt_rx_queue {
+	struct xsk_ring_cons rx;
+	struct xsk_ring_prod fq;
+	struct xsk_ring_cons cq;
+	struct xsk_umem_info *umem;
+	struct xsk_socket *xsk;
+	struct pollfd fds[1];
+
+	uint16_t in_port;
+	int xsk_queue_idx;
+	int busy_budget;
+
+	volatile unsigned long rx_pkts;
+	volatile unsigned long rx_bytes;
+	volatile unsigned long rx_nombuf;
+
+	struct pkt_tx_queue *pair;
+};
+
+struct pkt_tx_queue {
+	struct xsk_ring_prod tx;
+	struct xsk_umem_info *umem;
+
+	volatile unsigned long tx_pkts;
+	volatile unsigned long err_pkts;
+	volatile unsigned long tx_bytes;
+
+	struct pkt_rx_queue *pair;
+};
+
+struct pmd_internals {
+	unsigned nb_queues;
+
+	int if_index;
+	char if_name[IFNAMSIZ];
+	int start_queue_idx;
+	int busy_budget;
+	struct ether_addr eth_addr;
+
+	/* UMEM of all the queues, NULL for a UMEM per queue */
+	unsigned int shared_umem;
+	struct xsk_umem_info *umem;
+
+	struct pkt_rx_queue rx_queue[ETH_AF_XDP_MAX_QUEUE_PAIRS];
+	struct pkt_tx_queue tx_queue[ETH_AF_XDP_MAX_QUEUE_PAIRS];
+};
+
+static const char *valid_arguments[] = {
+	ETH_AF_XDP_IFACE_ARG,
+	ETH_AF_XDP_START_QUEUE_ARG,
+	ETH_AF_XDP_QUEUE_COUNT_ARG,
+	ETH_AF_XDP_SHARED_UMEM_ARG,
+	ETH_AF_XDP_BUSY_BUDGET_ARG,
+	NULL
+};
+
+static struct rte_eth_link pmd_link = {
+	.link_speed = ETH_SPEED_NUM_10G,
+	.link_duplex = ETH_LINK_FULL_DUPLEX,
+	.link_status = ETH_LINK_DOWN,
+	.link_autoneg = ETH_LINK_FIXED,
+};
+
+static int af_xdp_logtype;
+
+#define PMD_LOG(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, af_xdp_logtype, \
+		"%s(): " fmt "\n", __func__, ##args)
+
+#define PMD_LOG_ERRNO(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, af_xdp_logtype, \
+		"%s(): " fmt ":%s\n", __func__, ##args, strerror(errno))
+
+static inline struct rte_mbuf *
+umem_addr_to_mbuf(struct xsk_umem_info *umem, uint64_t addr)
+{
+	uint64_t frame = addr & ~((uint64_t)ETH_AF_XDP_FRAME_SIZE - 1);
+
+	return (struct rte_mbuf *)(umem->buffer + frame + umem->mbuf_offset);
+}
+
+static inline uint64_t
+umem_mbuf_to_addr(struct xsk_umem_info *umem, struct rte_mbuf *mbuf)
+{
+	return (uint64_t)((char *)mbuf - umem->buffer - umem->mbuf_offset);
+}
+
+static inline int
+reserve_fill_queue(struct pkt_rx_queue *rxq, uint16_t reserve_size)
+{
+	struct xsk_umem_info *umem = rxq->umem;
+	struct rte_mbuf *mbufs[ETH_AF_XDP_RX_BATCH_SIZE];
+	uint32_t idx;
+	uint16_t i;
+
+	if (rte_pktmbuf_alloc_bulk(umem->mb_pool, mbufs, reserve_size) != 0) {
+		rxq->rx_nombuf += reserve_size;
+		return -ENOMEM;
+	}
+
+	if (xsk_ring_prod__reserve(&rxq->fq, reserve_size, &idx) !=
+	    reserve_size) {
+		for (i = 0; i < reserve_size; i++)
+			rte_pktmbuf_free(mbufs[i]);
+		return -ENOSPC;
+	}
+
+	for (i = 0; i < reserve_size; i++)
+		*xsk_ring_prod__fill_addr(&rxq->fq, idx++) =
+			umem_mbuf_to_addr(umem, mbufs[i]);
+
+	xsk_ring_prod__submit(&rxq->fq, reserve_size);
+	return 0;
+}
+
+static uint16_t
+eth_af_xdp_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_rx_queue *rxq = queue;
+	struct xsk_umem_info *umem = rxq->umem;
+	const struct xdp_desc *desc;
+	struct rte_mbuf *mbuf;
+	unsigned long rx_bytes = 0;
+	uint32_t idx_rx = 0;
+	uint16_t i, rcvd;
+
+	nb_pkts = RTE_MIN(nb_pkts, ETH_AF_XDP_RX_BATCH_SIZE);
+
+	rcvd = xsk_ring_cons__peek(&rxq->rx, nb_pkts, &idx_rx);
+	if (rcvd == 0) {
+		/*
+		 * Drive the NAPI context of the queue from this thread in
+		 * busy poll mode, wake it up when it asks for it otherwise.
+		 */
+		if (rxq->busy_budget)
+			(void)recvfrom(rxq->fds[0].fd, NULL, 0, MSG_DONTWAIT,
+				       NULL, NULL);
+		else if (xsk_ring_prod__needs_wakeup(&rxq->fq))
+			(void)poll(rxq->fds, 1, 0);
+		return 0;
+	}
+
+	for (i = 0; i < rcvd; i++) {
+		desc = xsk_ring_cons__rx_desc(&rxq->rx, idx_rx++);
+		/* the packet is in the frame of its own mbuf */
+		mbuf = umem_addr_to_mbuf(umem, desc->addr);
+		mbuf->data_off = umem->buffer + desc->addr -
+			(char *)mbuf->buf_addr;
+		rte_pktmbuf_pkt_len(mbuf) = desc->len;
+		rte_pktmbuf_data_len(mbuf) = desc->len;
+		mbuf->port = rxq->in_port;
+		bufs[i] = mbuf;
+		rx_bytes += desc->len;
+	}
+	xsk_ring_cons__release(&rxq->rx, rcvd);
+
+	/* give as many frames back to the kernel */
+	reserve_fill_queue(rxq, rcvd);
+
+	rxq->rx_pkts += rcvd;
+	rxq->rx_bytes += rx_bytes;
+	return rcvd;
+}
+
+static void
+pull_umem_cq(struct pkt_tx_queue *txq, uint32_t size)
+{
+	struct xsk_ring_cons *cq = &txq->pair->cq;
+	uint32_t idx_cq = 0;
+	uint32_t i, n;
+
+	n = xsk_ring_cons__peek(cq, size, &idx_cq);
+	for (i = 0; i < n; i++)
+		rte_pktmbuf_free(umem_addr_to_mbuf(txq->umem,
+				*xsk_ring_cons__comp_addr(cq, idx_cq++)));
+	xsk_ring_cons__release(cq, n);
+}
+
+static void
+kick_tx(struct pkt_tx_queue *txq)
+{
+	if (!txq->pair->busy_budget && !xsk_ring_prod__needs_wakeup(&txq->tx))
+		return;
+
+	if (send(xsk_socket__fd(txq->pair->xsk), NULL, 0,
+		 MSG_DONTWAIT) < 0 &&
+	    (errno == EAGAIN || errno == EBUSY))
+		/* the completion ring is full, free some room */
+		pull_umem_cq(txq, ETH_AF_XDP_TX_BATCH_SIZE);
+}
+
+/*
+ * The mbufs of the UMEM are sent from their own frame, the other ones are
+ * copied into a UMEM mbuf first.
+ */
+static uint16_t
+eth_af_xdp_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_tx_queue *txq = queue;
+	struct xsk_umem_info *umem = txq->umem;
+	struct rte_mbuf *mbuf, *local;
+	struct xdp_desc *desc;
+	unsigned long tx_bytes = 0;
+	uint16_t i, count = 0;
+	uint32_t idx_tx;
+	const void *data;
+	void *dst;
+
+	nb_pkts = RTE_MIN(nb_pkts, ETH_AF_XDP_TX_BATCH_SIZE);
+
+	/* free the mbufs of the packets sent by the kernel */
+	pull_umem_cq(txq, ETH_AF_XDP_TX_BATCH_SIZE);
+
+	for (i = 0; i < nb_pkts; i++) {
+		mbuf = bufs[i];
+
+		if (xsk_ring_prod__reserve(&txq->tx, 1, &idx_tx) != 1)
+			break;
+
+		if (mbuf->pool != umem->mb_pool || mbuf->nb_segs != 1 ||
+		    !RTE_MBUF_DIRECT(mbuf)) {
+			local = rte_pktmbuf_alloc(umem->mb_pool);
+			dst = local == NULL ? NULL :
+				rte_pktmbuf_append(local,
+						   rte_pktmbuf_pkt_len(mbuf));
+			if (dst == NULL) {
+				/* give the reserved descriptor back */
+				txq->tx.cached_prod--;
+				if (local == NULL)
+					break;
+				/* too big for a UMEM frame */
+				rte_pktmbuf_free(local);
+				rte_pktmbuf_free(mbuf);
+				txq->err_pkts++;
+				continue;
+			}
+			data = rte_pktmbuf_read(mbuf, 0,
+						rte_pktmbuf_pkt_len(mbuf), dst);
+			if (data != dst)
+				rte_memcpy(dst, data,
+					   rte_pktmbuf_pkt_len(mbuf));
+			rte_pktmbuf_free(mbuf);
+			mbuf = local;
+		}
+
+		desc = xsk_ring_prod__tx_desc(&txq->tx, idx_tx);
+		desc->addr = rte_pktmbuf_mtod(mbuf, char *) - umem->buffer;
+		desc->len = rte_pktmbuf_pkt_len(mbuf);
+		tx_bytes += desc->len;
+		count++;
+	}
+
+	xsk_ring_prod__submit(&txq->tx, count);
+	kick_tx(txq);
+
+	txq->tx_pkts += count;
+	txq->tx_bytes += tx_bytes;
+	return i;
+}
+
+static void
+xdp_umem_destroy(struct xsk_umem_info *umem)
+{
+	if (umem->umem != NULL)
+		xsk_umem__delete(umem->umem);
+	rte_mempool_free(umem->mb_pool);
+	rte_memzone_free(umem->mz);
+	rte_free(umem);
+}
+
+static struct xsk_umem_info *
+xdp_umem_configure(struct pmd_internals *internals, struct pkt_rx_queue *rxq,
+		   unsigned int nb_bufs, int socket_id)
+{
+	struct xsk_umem_config usr_config = {
+		.fill_size = ETH_AF_XDP_DFLT_NUM_DESCS,
+		.comp_size = ETH_AF_XDP_DFLT_NUM_DESCS,
+		.frame_size = ETH_AF_XDP_FRAME_SIZE,
+	};
+	struct rte_pktmbuf_pool_private mbp_priv;
+	char name[RTE_MEMZONE_NAMESIZE];
+	struct xsk_umem_info *umem;
+	struct rte_mempool *mp;
+	int ret;
+
+	umem = rte_zmalloc_socket("umem", sizeof(*umem), 0, socket_id);
+	if (umem == NULL) {
+		PMD_LOG(ERR, "failed to allocate umem info");
+		return NULL;
+	}
+
+	/* an object, header included, fills a frame */
+	snprintf(name, sizeof(name), "af_xdp_%s_%d", internals->if_name,
+		 rxq->xsk_queue_idx);
+	mp = rte_mempool_create_empty(name, nb_bufs,
+			ETH_AF_XDP_FRAME_SIZE - ETH_AF_XDP_OBJHDR_SIZE,
+			ETH_AF_XDP_MP_CACHE_SIZE, sizeof(mbp_priv),
+			socket_id, MEMPOOL_F_NO_SPREAD);
+	if (mp == NULL) {
+		PMD_LOG(ERR, "failed to create mempool %s", name);
+		goto err;
+	}
+	umem->mb_pool = mp;
+
+	if (mp->header_size + mp->elt_size + mp->trailer_size !=
+	    ETH_AF_XDP_FRAME_SIZE) {
+		PMD_LOG(ERR, "mempool objects do not fit UMEM frames");
+		goto err;
+	}
+
+	ret = rte_mempool_set_ops_byname(mp, rte_mbuf_best_mempool_ops(),
+					 NULL);
+	if (ret != 0) {
+		PMD_LOG(ERR, "failed to set mempool ops of %s", name);
+		goto err;
+	}
+
+	memset(&mbp_priv, 0, sizeof(mbp_priv));
+	mbp_priv.mbuf_data_room_size = mp->elt_size - sizeof(struct rte_mbuf);
+	rte_pktmbuf_pool_init(mp, &mbp_priv);
+
+	/* the UMEM must be contiguous, made of back to back objects */
+	snprintf(name, sizeof(name), "af_xdp_umem_%s_%d", internals->if_name,
+		 rxq->xsk_queue_idx);
+	umem->mz = rte_memzone_reserve_aligned(name,
+			(size_t)nb_bufs * ETH_AF_XDP_FRAME_SIZE, socket_id,
+			RTE_MEMZONE_IOVA_CONTIG, getpagesize());
+	if (umem->mz == NULL) {
+		PMD_LOG(ERR, "failed to reserve memzone %s", name);
+		goto err;
+	}
+	umem->buffer = umem->mz->addr;
+	umem->mbuf_offset = mp->header_size;
+
+	ret = rte_mempool_populate_iova(mp, umem->mz->addr, umem->mz->iova,
+					umem->mz->len, NULL, NULL);
+	if (ret < 0 || mp->populated_size != nb_bufs) {
+		PMD_LOG(ERR, "failed to populate mempool in %s", name);
+		goto err;
+	}
+	rte_mempool_obj_iter(mp, rte_pktmbuf_init, NULL);
+
+	/* the kernel writes the packets where the mbufs expect them */
+	if (ETH_AF_XDP_DATA_HEADROOM < XDP_PACKET_HEADROOM) {
+		PMD_LOG(ERR, "mbuf headroom smaller than XDP headroom");
+		goto err;
+	}
+	usr_config.frame_headroom =
+		ETH_AF_XDP_DATA_HEADROOM - XDP_PACKET_HEADROOM;
+
+	ret = xsk_umem__create(&umem->umem, umem->buffer,
+			       (uint64_t)nb_bufs * ETH_AF_XDP_FRAME_SIZE,
+			       &rxq->fq, &rxq->cq, &usr_config);
+	if (ret != 0) {
+		umem->umem = NULL;
+		PMD_LOG(ERR, "failed to create umem: %d", ret);
+		goto err;
+	}
+
+	return umem;
+
+err:
+	xdp_umem_destroy(umem);
+	return NULL;
+}
+
+static int
+configure_preferred_busy_poll(struct pkt_rx_queue *rxq)
+{
+	int sock_opt = 1;
+	int fd = xsk_socket__fd(rxq->xsk);
+	int ret;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+		       &sock_opt, sizeof(sock_opt)) < 0)
+		return -errno;
+
+	sock_opt = ETH_AF_XDP_BUSY_POLL_TIMEOUT;
+	if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL,
+		       &sock_opt, sizeof(sock_opt)) < 0)
+		goto err_prefer;
+
+	sock_opt = rxq->busy_budget;
+	if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET,
+		       &sock_opt, sizeof(sock_opt)) < 0)
+		goto err_timeout;
+
+	return 0;
+
+err_timeout:
+	ret = -errno;
+	sock_opt = 0;
+	setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &sock_opt, sizeof(sock_opt));
+	goto err;
+err_prefer:
+	ret = -errno;
+err:
+	sock_opt = 0;
+	setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+		   &sock_opt, sizeof(sock_opt));
+	return ret;
+}
+
+static void
+xdp_queue_free(struct pmd_internals *internals, struct pkt_rx_queue *rxq)
+{
+	struct xsk_umem_info *umem = rxq->umem;
+
+	if (rxq->xsk != NULL) {
+		xsk_socket__delete(rxq->xsk);
+		rxq->xsk = NULL;
+	}
+	if (umem != NULL && --umem->refcnt == 0) {
+		if (umem == internals->umem)
+			internals->umem = NULL;
+		xdp_umem_destroy(umem);
+	}
+	rxq->umem = NULL;
+	rxq->pair->umem = NULL;
+}
+
+static int
+xsk_configure(struct pmd_internals *internals, struct pkt_rx_queue *rxq,
+	      int socket_id)
+{
+	struct pkt_tx_queue *txq = rxq->pair;
+	struct xsk_socket_config cfg = {
+		.rx_size = ETH_AF_XDP_DFLT_NUM_DESCS,
+		.tx_size = ETH_AF_XDP_DFLT_NUM_DESCS,
+		.libbpf_flags = 0,
+		.xdp_flags = XDP_FLAGS_UPDATE_IF_NOEXIST,
+#if defined(XDP_USE_NEED_WAKEUP)
+		.bind_flags = XDP_USE_NEED_WAKEUP,
+#endif
+	};
+	struct xsk_umem_info *umem = internals->umem;
+	unsigned int filled;
+	int ret;
+
+	if (umem == NULL) {
+		umem = xdp_umem_configure(internals, rxq,
+				ETH_AF_XDP_NUM_BUFFERS *
+				(internals->shared_umem ?
+				 internals->nb_queues : 1),
+				socket_id);
+		if (umem == NULL)
+			return -ENOMEM;
+		if (internals->shared_umem)
+			internals->umem = umem;
+		ret = xsk_socket__create(&rxq->xsk, internals->if_name,
+				rxq->xsk_queue_idx, umem->umem,
+				&rxq->rx, &txq->tx, &cfg);
+	} else {
+		/* the socket comes with its own fill and completion rings */
+		ret = xsk_socket__create_shared(&rxq->xsk, internals->if_name,
+				rxq->xsk_queue_idx, umem->umem,
+				&rxq->rx, &txq->tx, &rxq->fq, &rxq->cq, &cfg);
+	}
+	umem->refcnt++;
+	rxq->umem = umem;
+	txq->umem = umem;
+	if (ret != 0) {
+		rxq->xsk = NULL;
+		PMD_LOG(ERR, "failed to create xsk socket: %d", ret);
+		goto err;
+	}
+
+	if (rxq->busy_budget) {
+		ret = configure_preferred_busy_poll(rxq);
+		if (ret != 0) {
+			PMD_LOG(ERR,
+				"failed to configure busy polling, disabled: %d",
+				ret);
+			rxq->busy_budget = 0;
+		}
+	}
+
+	for (filled = 0; filled < ETH_AF_XDP_DFLT_NUM_DESCS;
+	     filled += ETH_AF_XDP_RX_BATCH_SIZE) {
+		ret = reserve_fill_queue(rxq, ETH_AF_XDP_RX_BATCH_SIZE);
+		if (ret != 0) {
+			PMD_LOG(ERR, "failed to reserve fill queue");
+			goto err;
+		}
+	}
+
+	rxq->fds[0].fd = xsk_socket__fd(rxq->xsk);
+	rxq->fds[0].events = POLLIN;
+
+	return 0;
+
+err:
+	xdp_queue_free(internals, rxq);
+	return ret;
+}
+
+static int
+eth_dev_start(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	uint16_t i;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		if (internals->rx_queue[i].xsk == NULL) {
+			PMD_LOG(ERR, "Rx queue %u is not set up", i);
+			return -EINVAL;
+		}
+	}
+
+	dev->data->dev_link.link_status = ETH_LINK_UP;
+	return 0;
+}
+
+static void
+eth_dev_stop(struct rte_eth_dev *dev)
+{
+	dev->data->dev_link.link_status = ETH_LINK_DOWN;
+}
+
+static int
+eth_dev_configure(struct rte_eth_dev *dev)
+{
+	/* Rx and Tx queues go by pairs sharing an XDP socket */
+	if (dev->data->nb_rx_queues != dev->data->nb_tx_queues) {
+		PMD_LOG(ERR, "%u Rx queues for %u Tx queues",
+			dev->data->nb_rx_queues, dev->data->nb_tx_queues);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+eth_dev_info(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	dev_info->if_index = internals->if_index;
+	dev_info->max_mac_addrs = 1;
+	dev_info->max_rx_pktlen = ETH_AF_XDP_FRAME_SIZE -
+		ETH_AF_XDP_DATA_HEADROOM;
+	dev_info->max_rx_queues = internals->nb_queues;
+	dev_info->max_tx_queues = internals->nb_queues;
+	dev_info->min_rx_bufsize = 0;
+
+	dev_info->default_rxportconf.nb_queues = 1;
+	dev_info->default_txportconf.nb_queues = 1;
+	dev_info->default_rxportconf.ring_size = ETH_AF_XDP_DFLT_NUM_DESCS;
+	dev_info->default_txportconf.ring_size = ETH_AF_XDP_DFLT_NUM_DESCS;
+}
+
+static int
+eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *stats)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct xdp_statistics xdp_stats;
+	socklen_t optlen;
+	unsigned int i, imax;
+
+	imax = RTE_MIN(internals->nb_queues,
+		       (unsigned int)RTE_ETHDEV_QUEUE_STAT_CNTRS);
+	for (i = 0; i < internals->nb_queues; i++) {
+		struct pkt_rx_queue *rxq = &internals->rx_queue[i];
+		struct pkt_tx_queue *txq = &internals->tx_queue[i];
+
+		if (i < imax) {
+			stats->q_ipackets[i] = rxq->rx_pkts;
+			stats->q_ibytes[i] = rxq->rx_bytes;
+			stats->q_opackets[i] = txq->tx_pkts;
+			stats->q_obytes[i] = txq->tx_bytes;
+			stats->q_errors[i] = txq->err_pkts;
+		}
+
+		stats->ipackets += rxq->rx_pkts;
+		stats->ibytes += rxq->rx_bytes;
+		stats->rx_nombuf += rxq->rx_nombuf;
+		stats->opackets += txq->tx_pkts;
+		stats->obytes += txq->tx_bytes;
+		stats->oerrors += txq->err_pkts;
+
+		if (rxq->xsk == NULL)
+			continue;
+
+		/* packets dropped by the kernel for lack of room */
+		optlen = sizeof(xdp_stats);
+		if (getsockopt(xsk_socket__fd(rxq->xsk), SOL_XDP,
+			       XDP_STATISTICS, &xdp_stats, &optlen) != 0) {
+			PMD_LOG_ERRNO(ERR, "getsockopt() failed");
+			return -1;
+		}
+		stats->imissed += xdp_stats.rx_dropped;
+	}
+
+	return 0;
+}
+
+static void
+eth_stats_reset(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int i;
+
+	for (i = 0; i < internals->nb_queues; i++) {
+		internals->rx_queue[i].rx_pkts = 0;
+		internals->rx_queue[i].rx_bytes = 0;
+		internals->rx_queue[i].rx_nombuf = 0;
+		internals->tx_queue[i].tx_pkts = 0;
+		internals->tx_queue[i].err_pkts = 0;
+		internals->tx_queue[i].tx_bytes = 0;
+	}
+}
+
+static void
+remove_xdp_program(struct pmd_internals *internals)
+{
+	uint32_t curr_prog_id = 0;
+
+	if (bpf_get_link_xdp_id(internals->if_index, &curr_prog_id,
+				XDP_FLAGS_UPDATE_IF_NOEXIST)) {
+		PMD_LOG(ERR, "bpf_get_link_xdp_id failed");
+		return;
+	}
+	if (curr_prog_id != 0)
+		bpf_set_link_xdp_fd(internals->if_index, -1,
+				    XDP_FLAGS_UPDATE_IF_NOEXIST);
+}
+
+static void
+eth_dev_close(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int i;
+
+	PMD_LOG(INFO, "Closing AF_XDP ethdev on numa socket %u",
+		rte_socket_id());
+
+	for (i = 0; i < internals->nb_queues; i++)
+		xdp_queue_free(internals, &internals->rx_queue[i]);
+
+	remove_xdp_program(internals);
+}
+
+static void
+eth_queue_release(void *q __rte_unused)
+{
+}
+
+static int
+eth_link_update(struct rte_eth_dev *dev __rte_unused,
+		int wait_to_complete __rte_unused)
+{
+	return 0;
+}
+
+static int
+eth_rx_queue_setup(struct rte_eth_dev *dev,
+		   uint16_t rx_queue_id,
+		   uint16_t nb_rx_desc __rte_unused,
+		   unsigned int socket_id,
+		   const struct rte_eth_rxconf *rx_conf __rte_unused,
+		   struct rte_mempool *mb_pool __rte_unused)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct pkt_rx_queue *rxq = &internals->rx_queue[rx_queue_id];
+	int ret;
+
+	/*
+	 * The packets are received in the mbufs of the UMEM mempool, the
+	 * socket and its UMEM are kept until the port is closed.
+	 */
+	if (rxq->xsk == NULL) {
+		ret = xsk_configure(internals, rxq, socket_id);
+		if (ret != 0) {
+			PMD_LOG(ERR, "Failed to configure xdp socket");
+			return ret;
+		}
+	}
+
+	rxq->in_port = dev->data->port_id;
+	dev->data->rx_queues[rx_queue_id] = rxq;
+	return 0;
+}
+
+static int
+eth_tx_queue_setup(struct rte_eth_dev *dev,
+		   uint16_t tx_queue_id,
+		   uint16_t nb_tx_desc __rte_unused,
+		   unsigned int socket_id __rte_unused,
+		   const struct rte_eth_txconf *tx_conf __rte_unused)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	dev->data->tx_queues[tx_queue_id] = &internals->tx_queue[tx_queue_id];
+	return 0;
+}
+
+static int
+eth_dev_mtu_set(struct rte_eth_dev *dev, uint16_t mtu)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct ifreq ifr = { .ifr_mtu = mtu };
+	int ret;
+	int s;
+
+	if (mtu > ETH_AF_XDP_FRAME_SIZE - ETH_AF_XDP_DATA_HEADROOM -
+	    ETHER_HDR_LEN)
+		return -EINVAL;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return -EINVAL;
+
+	strlcpy(ifr.ifr_name, internals->if_name, IFNAMSIZ);
+	ret = ioctl(s, SIOCSIFMTU, &ifr);
+	close(s);
+
+	return (ret < 0) ? -errno : 0;
+}
+
+static void
+eth_dev_change_flags(char *if_name, uint32_t flags, uint32_t mask)
+{
+	struct ifreq ifr;
+	int s;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return;
+
+	strlcpy(ifr.ifr_name, if_name, IFNAMSIZ);
+	if (ioctl(s, SIOCGIFFLAGS, &ifr) < 0)
+		goto out;
+	ifr.ifr_flags &= mask;
+	ifr.ifr_flags |= flags;
+	if (ioctl(s, SIOCSIFFLAGS, &ifr) < 0)
+		goto out;
+out:
+	close(s);
+}
+
+static void
+eth_dev_promiscuous_enable(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	eth_dev_change_flags(internals->if_name, IFF_PROMISC, ~0);
+}
+
+static void
+eth_dev_promiscuous_disable(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	eth_dev_change_flags(internals->if_name, 0, ~IFF_PROMISC);
+}
+
+static const struct eth_dev_ops ops = {
+	.dev_start = eth_dev_start,
+	.dev_stop = eth_dev_stop,
+	.dev_close = eth_dev_close,
+	.dev_configure = eth_dev_configure,
+	.dev_infos_get = eth_dev_info,
+	.mtu_set = eth_dev_mtu_set,
+	.promiscuous_enable = eth_dev_promiscuous_enable,
+	.promiscuous_disable = eth_dev_promiscuous_disable,
+	.rx_queue_setup = eth_rx_queue_setup,
+	.tx_queue_setup = eth_tx_queue_setup,
+	.rx_queue_release = eth_queue_release,
+	.tx_queue_release = eth_queue_release,
+	.link_update = eth_link_update,
+	.stats_get = eth_stats_get,
+	.stats_reset = eth_stats_reset,
+};
+
+static int
+parse_integer_arg(const char *key __rte_unused,
+		  const char *value, void *extra_args)
+{
+	int *i = (int *)extra_args;
+	char *end;
+
+	*i = strtol(value, &end, 10);
+	if (*end != '\0' || *i < 0) {
+		PMD_LOG(ERR, "Argument has to be a positive integer.");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+parse_name_arg(const char *key __rte_unused,
+	       const char *value, void *extra_args)
+{
+	char *name = extra_args;
+
+	if (strnlen(value, IFNAMSIZ) > IFNAMSIZ - 1) {
+		PMD_LOG(ERR, "Invalid name %s, should be less than %u bytes.",
+			value, IFNAMSIZ);
+		return -EINVAL;
+	}
+
+	strlcpy(name, value, IFNAMSIZ);
+	return 0;
+}
+
+static int
+parse_parameters(struct rte_kvargs *kvlist, char *if_name, int *start_queue,
+		 int *queue_cnt, int *shared_umem, int *busy_budget)
+{
+	int ret;
+
+	ret = rte_kvargs_process(kvlist, ETH_AF_XDP_IFACE_ARG,
+				 &parse_name_arg, if_name);
+	if (ret < 0)
+		return ret;
+
+	ret = rte_kvargs_process(kvlist, ETH_AF_XDP_START_QUEUE_ARG,
+				 &parse_integer_arg, start_queue);
+	if (ret < 0)
+		return ret;
+
+	ret = rte_kvargs_process(kvlist, ETH_AF_XDP_QUEUE_COUNT_ARG,
+				 &parse_integer_arg, queue_cnt);
+	if (ret < 0)
+		return ret;
+	if (*queue_cnt < 1 || *queue_cnt > ETH_AF_XDP_MAX_QUEUE_PAIRS) {
+		PMD_LOG(ERR, "invalid queue_count value");
+		return -EINVAL;
+	}
+
+	ret = rte_kvargs_process(kvlist, ETH_AF_XDP_SHARED_UMEM_ARG,
+				 &parse_integer_arg, shared_umem);
+	if (ret < 0)
+		return ret;
+	if (*shared_umem > 1) {
+		PMD_LOG(ERR, "invalid shared_umem value");
+		return -EINVAL;
+	}
+
+	ret = rte_kvargs_process(kvlist, ETH_AF_XDP_BUSY_BUDGET_ARG,
+				 &parse_integer_arg, busy_budget);
+	if (ret < 0)
+		return ret;
+
+	return 0;
+}
+
+static int
+get_iface_info(const char *if_name, struct ether_addr *eth_addr,
+	       int *if_index)
+{
+	struct ifreq ifr;
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+	if (sock < 0)
+		return -1;
+
+	strlcpy(ifr.ifr_name, if_name, IFNAMSIZ);
+	if (ioctl(sock, SIOCGIFINDEX, &ifr))
+		goto error;
+
+	*if_index = ifr.ifr_ifindex;
+
+	if (ioctl(sock, SIOCGIFHWADDR, &ifr))
+		goto error;
+
+	rte_memcpy(eth_addr, ifr.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+
+	close(sock);
+	return 0;
+
+error:
+	close(sock);
+	return -1;
+}
+
+static struct rte_eth_dev *
+init_internals(struct rte_vdev_device *dev, const char *if_name,
+	       int start_queue_idx, int queue_cnt, int shared_umem,
+	       int busy_budget)
+{
+	const char *name = rte_vdev_device_name(dev);
+	const unsigned int numa_node = dev->device.numa_node;
+	struct pmd_internals *internals;
+	struct rte_eth_dev *eth_dev;
+	int i;
+
+	internals = rte_zmalloc_socket(name, sizeof(*internals), 0,
+				       numa_node);
+	if (internals == NULL)
+		return NULL;
+
+	internals->start_queue_idx = start_queue_idx;
+	internals->nb_queues = queue_cnt;
+	internals->shared_umem = shared_umem;
+	internals->busy_budget = busy_budget;
+	strlcpy(internals->if_name, if_name, IFNAMSIZ);
+
+	for (i = 0; i < queue_cnt; i++) {
+		internals->tx_queue[i].pair = &internals->rx_queue[i];
+		internals->rx_queue[i].pair = &internals->tx_queue[i];
+		internals->rx_queue[i].xsk_queue_idx = start_queue_idx + i;
+		internals->rx_queue[i].busy_budget = busy_budget;
+	}
+
+	if (get_iface_info(if_name, &internals->eth_addr,
+			   &internals->if_index) != 0) {
+		PMD_LOG(ERR, "%s: could not get information on %s",
+			name, if_name);
+		goto err;
+	}
+
+	eth_dev = rte_eth_vdev_allocate(dev, 0);
+	if (eth_dev == NULL)
+		goto err;
+
+	eth_dev->data->dev_private = internals;
+	eth_dev->data->dev_link = pmd_link;
+	eth_dev->data->mac_addrs = &internals->eth_addr;
+	eth_dev->dev_ops = &ops;
+	eth_dev->rx_pkt_burst = eth_af_xdp_rx;
+	eth_dev->tx_pkt_burst = eth_af_xdp_tx;
+
+	return eth_dev;
+
+err:
+	rte_free(internals);
+	return NULL;
+}
+
+static int
+rte_pmd_af_xdp_probe(struct rte_vdev_device *dev)
+{
+	struct rte_kvargs *kvlist;
+	char if_name[IFNAMSIZ] = {'\0'};
+	int xsk_start_queue_idx = 0;
+	int xsk_queue_cnt = 1;
+	int shared_umem = 0;
+	int busy_budget = 0;
+	struct rte_eth_dev *eth_dev;
+	const char *name = rte_vdev_device_name(dev);
+
+	PMD_LOG(INFO, "Initializing pmd_af_xdp for %s", name);
+
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		PMD_LOG(ERR, "Failed to probe %s: XDP sockets cannot be shared "
+			"with a secondary process", name);
+		return -ENOTSUP;
+	}
+
+	kvlist = rte_kvargs_parse(rte_vdev_device_args(dev), valid_arguments);
+	if (kvlist == NULL) {
+		PMD_LOG(ERR, "Invalid kvargs key");
+		return -EINVAL;
+	}
+
+	if (dev->device.numa_node == SOCKET_ID_ANY)
+		dev->device.numa_node = rte_socket_id();
+
+	if (parse_parameters(kvlist, if_name, &xsk_start_queue_idx,
+			     &xsk_queue_cnt, &shared_umem,
+			     &busy_budget) < 0) {
+		PMD_LOG(ERR, "Invalid kvargs value");
+		rte_kvargs_free(kvlist);
+		return -EINVAL;
+	}
+	rte_kvargs_free(kvlist);
+
+	if (strlen(if_name) == 0) {
+		PMD_LOG(ERR, "Network interface must be specified");
+		return -EINVAL;
+	}
+
+	eth_dev = init_internals(dev, if_name, xsk_start_queue_idx,
+				 xsk_queue_cnt, shared_umem, busy_budget);
+	if (eth_dev == NULL) {
+		PMD_LOG(ERR, "Failed to init internals");
+		return -1;
+	}
+
+	rte_eth_dev_probing_finish(eth_dev);
+	return 0;
+}
+
+static int
+rte_pmd_af_xdp_remove(struct rte_vdev_device *dev)
+{
+	struct rte_eth_dev *eth_dev = NULL;
+
+	PMD_LOG(INFO, "Removing AF_XDP ethdev on numa socket %u",
+		rte_socket_id());
+
+	if (dev == NULL)
+		return -1;
+
+	/* find the ethdev entry */
+	eth_dev = rte_eth_dev_allocated(rte_vdev_device_name(dev));
+	if (eth_dev == NULL)
+		return -1;
+
+	eth_dev_close(eth_dev);
+	/* mac_addrs must not be freed alone because part of dev_private */
+	eth_dev->data->mac_addrs = NULL;
+	rte_eth_dev_release_port(eth_dev);
+
+	return 0;
+}
+
+static struct rte_vdev_driver pmd_af_xdp_drv = {
+	.probe = rte_pmd_af_xdp_probe,
+	.remove = rte_pmd_af_xdp_remove,
+};
+
+RTE_PMD_REGISTER_VDEV(net_af_xdp, pmd_af_xdp_drv);
+RTE_PMD_REGISTER_PARAM_STRING(net_af_xdp,
+	"iface=<string> "
+	"start_queue=<int> "
+	"queue_count=<int> "
+	"shared_umem=<0|1> "
+	"busy_budget=<int>");
+
+RTE_INIT(af_xdp_init_log)
+{
+	af_xdp_logtype = rte_log_register("pmd.net.af_xdp");
+	if (af_xdp_logtype >= 0)
+		rte_log_set_level(af_xdp_logtype, RTE_LOG_NOTICE);
+}
@@ -897,6 +897,8 @@ bond_mode_8023ad_periodic_cb(void *arg)
 		show_warnings(slave_id);
 	}
 
+	bond_mode_8023ad_dist_update(internals);
+
 	rte_eal_alarm_set(internals->mode4.update_timeout_us,
 			bond_mode_8023ad_periodic_cb, arg);
 }
@@ -1033,6 +1035,41 @@ bond_mode_8023ad_deactivate_slave(struct rte_eth_dev *bond_dev __rte_unused,
 	return 0;
 }
 
+void
+bond_mode_8023ad_dist_update(struct bond_dev_private *internals)
+{
+	struct mode8023ad_private *mode4 = &internals->mode4;
+	struct mode8023ad_dist_table *dist;
+	struct port *port;
+	uint16_t slaves[RTE_MAX_ETHPORTS];
+	uint16_t slave_count = 0;
+	uint16_t i, slave_id;
+
+	for (i = 0; i < internals->active_slave_count; i++) {
+		slave_id = internals->active_slaves[i];
+		port = &bond_mode_8023ad_ports[slave_id];
+		if (ACTOR_STATE(port, DISTRIBUTING))
+			slaves[slave_count++] = slave_id;
+	}
+
+	dist = &mode4->dist[mode4->dist_idx];
+	if (slave_count == dist->slave_count && memcmp(slaves, dist->slaves,
+			sizeof(slaves[0]) * slave_count) == 0)
+		return;
+
+	/* Build the table not in use by the Tx burst functions, then swap.
+	 * The previous table is not rebuilt before the next update, a period
+	 * of the state machines later, so no burst is still reading it. */
+	dist = &mode4->dist[mode4->dist_idx ^ 1];
+	dist->slave_count = slave_count;
+	memcpy(dist->slaves, slaves, sizeof(slaves[0]) * slave_count);
+	for (i = 0; i < BOND_8023AD_DIST_BUCKETS; i++)
+		dist->bucket_slave[i] = slave_count != 0 ? i % slave_count : 0;
+
+	rte_smp_wmb();
+	mode4->dist_idx ^= 1;
+}
+
 void
 bond_mode_8023ad_mac_address_update(struct rte_eth_dev *bond_dev)
 {
@@ -1563,6 +1600,8 @@ bond_mode_8023ad_ext_periodic_cb(void *arg)
 		}
 	}
 
+	bond_mode_8023ad_dist_update(internals);
+
 	rte_eal_alarm_set(internals->mode4.update_timeout_us,
 			bond_mode_8023ad_ext_periodic_cb, arg);
 }
@@ -1586,6 +1625,7 @@ rte_eth_bond_8023ad_dedicated_queues_enable(uint16_t port)
 		return -1;
 
 	internals->mode4.dedicated_queues.enabled = 1;
+	internals->mode4.dedicated_queues.user_set = 1;
 
 	bond_ethdev_mode_set(dev, internals->mode);
 	return retval;
@@ -1607,6 +1647,7 @@ rte_eth_bond_8023ad_dedicated_queues_disable(uint16_t port)
 		return -1;
 
 	internals->mode4.dedicated_queues.enabled = 0;
+	internals->mode4.dedicated_queues.user_set = 1;
 
 	bond_ethdev_mode_set(dev, internals->mode);
 
@@ -285,6 +285,10 @@ rte_eth_bond_8023ad_ext_slowtx(uint16_t port_id, uint16_t slave_id,
  * filter rule required for rx and have enough queues that one rx and tx queue
  * can be reserved for the LACP state machines control packets.
  *
+ * Unless this function or rte_eth_bond_8023ad_dedicated_queues_disable() is
+ * called, the dedicated queues are enabled on device start when all slaves
+ * support them.
+ *
  * Bonding port must be stopped to change this configuration.
  *
  * @param port_id      Bonding device id
@@ -139,6 +139,23 @@ struct port {
 	struct rte_mempool *slow_pool;
 };
 
+/** Number of hash buckets of the Tx distribution table, power of 2 */
+#define BOND_8023AD_DIST_BUCKETS	256
+
+/**
+ * Distribution of the transmitted flows on the slaves in DISTRIBUTING state,
+ * built by the control path so that the Tx burst functions do not scan the
+ * slaves states.
+ */
+struct mode8023ad_dist_table {
+	uint16_t slave_count;
+	/**< Number of distributing slaves */
+	uint16_t slaves[RTE_MAX_ETHPORTS];
+	/**< Port IDs of the distributing slaves */
+	uint16_t bucket_slave[BOND_8023AD_DIST_BUCKETS];
+	/**< Index in slaves of the slave of each hash bucket */
+};
+
 struct mode8023ad_private {
 	uint64_t fast_periodic_timeout;
 	uint64_t slow_periodic_timeout;
@@ -160,6 +177,9 @@ struct mode8023ad_private {
 	 */
 	struct {
 		uint8_t enabled;
+		uint8_t user_set;
+		/**< Enabled or disabled by the application, otherwise enabled
+		 * on start when all the slaves support it */
 
 		struct rte_flow *flow[RTE_MAX_ETHPORTS];
 
@@ -167,6 +187,13 @@ struct mode8023ad_private {
 		uint16_t tx_qid;
 	} dedicated_queues;
 	enum rte_bond_8023ad_agg_selection agg_selection;
+
+	/**
+	 * Tx distribution tables: the Tx burst functions use dist[dist_idx]
+	 * while the control path builds the other one then swaps them.
+	 */
+	struct mode8023ad_dist_table dist[2];
+	volatile uint8_t dist_idx;
 };
 
 /**
@@ -280,6 +307,17 @@ bond_mode_8023ad_activate_slave(struct rte_eth_dev *dev, uint16_t port_id);
 int
 bond_mode_8023ad_deactivate_slave(struct rte_eth_dev *dev, uint16_t slave_pos);
 
+/**
+ * @internal
+ *
+ * Rebuilds the Tx distribution table from the slaves in DISTRIBUTING state,
+ * when they changed.
+ *
+ * @param internals Bonded device private data.
+ */
+void
+bond_mode_8023ad_dist_update(struct bond_dev_private *internals);
+
 /**
  * Updates state when MAC was changed on bonded device or one of its slaves.
  * @param bond_dev Bonded device
@@ -126,6 +126,11 @@ deactivate_slave(struct rte_eth_dev *eth_dev, uint16_t port_id)
 	RTE_ASSERT(active_count < RTE_DIM(internals->active_slaves));
 	internals->active_slave_count = active_count;
 
+	/* Stop distributing traffic to the slave without waiting for the
+	 * state machines */
+	if (internals->mode == BONDING_MODE_8023AD)
+		bond_mode_8023ad_dist_update(internals);
+
 	if (eth_dev->data->dev_started) {
 		if (internals->mode == BONDING_MODE_8023AD) {
 			bond_mode_8023ad_start(eth_dev);
@@ -914,14 +919,17 @@ rte_eth_bond_xmit_policy_set(uint16_t bonded_port_id, uint8_t policy)
 	case BALANCE_XMIT_POLICY_LAYER2:
 		internals->balance_xmit_policy = policy;
 		internals->burst_xmit_hash = burst_xmit_l2_hash;
+		internals->burst_xmit_bucket = burst_xmit_l2_bucket;
 		break;
 	case BALANCE_XMIT_POLICY_LAYER23:
 		internals->balance_xmit_policy = policy;
 		internals->burst_xmit_hash = burst_xmit_l23_hash;
+		internals->burst_xmit_bucket = burst_xmit_l23_bucket;
 		break;
 	case BALANCE_XMIT_POLICY_LAYER34:
 		internals->balance_xmit_policy = policy;
 		internals->burst_xmit_hash = burst_xmit_l34_hash;
+		internals->burst_xmit_bucket = burst_xmit_l34_bucket;
 		break;
 
 	default:
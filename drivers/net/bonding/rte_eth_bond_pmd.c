@@ -29,6 +29,8 @@
 
 #define HASH_L4_PORTS(h) ((h)->src_port ^ (h)->dst_port)
 
+#define BURST_XMIT_PREFETCH_OFFSET 3
+
 /* Table for statistics in mode 5 TLB */
 static uint64_t tlb_last_obytets[RTE_MAX_ETHPORTS];
 
@@ -294,79 +296,62 @@ bond_ethdev_rx_burst_8023ad_fast_queue(void *queue, struct rte_mbuf **bufs,
 	return num_rx_total;
 }
 
-static uint16_t
-bond_ethdev_tx_burst_8023ad_fast_queue(void *queue, struct rte_mbuf **bufs,
-		uint16_t nb_bufs)
+/*
+ * Transmit a burst on the distributing slaves of mode 4, selected with the
+ * Tx distribution table built by the state machines. Untransmitted mbufs
+ * are moved to the end of bufs.
+ */
+static __rte_always_inline uint16_t
+bond_ethdev_8023ad_dist_tx(struct bond_dev_private *internals,
+		uint16_t queue_id, struct rte_mbuf **bufs, uint16_t nb_bufs)
 {
-	struct bond_tx_queue *bd_tx_q = (struct bond_tx_queue *)queue;
-	struct bond_dev_private *internals = bd_tx_q->dev_private;
-
-	uint16_t slave_port_ids[RTE_MAX_ETHPORTS];
+	struct mode8023ad_private *mode4 = &internals->mode4;
+	const struct mode8023ad_dist_table *dist;
 	uint16_t slave_count;
 
-	uint16_t dist_slave_port_ids[RTE_MAX_ETHPORTS];
-	uint16_t dist_slave_count;
-
 	/* 2-D array to sort mbufs for transmission on each slave into */
 	struct rte_mbuf *slave_bufs[RTE_MAX_ETHPORTS][nb_bufs];
 	/* Number of mbufs for transmission on each slave */
 	uint16_t slave_nb_bufs[RTE_MAX_ETHPORTS] = { 0 };
-	/* Mapping array generated by hash function to map mbufs to slaves */
-	uint16_t bufs_slave_port_idxs[RTE_MAX_ETHPORTS] = { 0 };
+	/* Distribution table bucket of each mbuf */
+	uint16_t bufs_bucket[nb_bufs];
 
 	uint16_t slave_tx_count;
 	uint16_t total_tx_count = 0, total_tx_fail_count = 0;
 
 	uint16_t i;
 
-	if (unlikely(nb_bufs == 0))
-		return 0;
+	dist = &mode4->dist[mode4->dist_idx];
+	rte_smp_rmb();
 
-	/* Copy slave list to protect against slave up/down changes during tx
-	 * bursting */
-	slave_count = internals->active_slave_count;
-	if (unlikely(slave_count < 1))
+	slave_count = dist->slave_count;
+	if (unlikely(slave_count == 0))
 		return 0;
 
-	memcpy(slave_port_ids, internals->active_slaves,
-			sizeof(slave_port_ids[0]) * slave_count);
-
-
-	dist_slave_count = 0;
-	for (i = 0; i < slave_count; i++) {
-		struct port *port = &bond_mode_8023ad_ports[slave_port_ids[i]];
-
-		if (ACTOR_STATE(port, DISTRIBUTING))
-			dist_slave_port_ids[dist_slave_count++] =
-					slave_port_ids[i];
-	}
-
-	if (unlikely(dist_slave_count < 1))
-		return 0;
+	if (slave_count == 1)
+		return rte_eth_tx_burst(dist->slaves[0], queue_id, bufs,
+				nb_bufs);
 
 	/*
 	 * Populate slaves mbuf with the packets which are to be sent on it
 	 * selecting output slave using hash based on xmit policy
 	 */
-	internals->burst_xmit_hash(bufs, nb_bufs, dist_slave_count,
-			bufs_slave_port_idxs);
+	internals->burst_xmit_bucket(bufs, nb_bufs, bufs_bucket);
 
 	for (i = 0; i < nb_bufs; i++) {
 		/* Populate slave mbuf arrays with mbufs for that slave. */
-		uint8_t slave_idx = bufs_slave_port_idxs[i];
+		uint16_t slave_idx = dist->bucket_slave[bufs_bucket[i]];
 
 		slave_bufs[slave_idx][slave_nb_bufs[slave_idx]++] = bufs[i];
 	}
 
-
 	/* Send packet burst on each slave device */
-	for (i = 0; i < dist_slave_count; i++) {
+	for (i = 0; i < slave_count; i++) {
 		if (slave_nb_bufs[i] == 0)
 			continue;
 
-		slave_tx_count = rte_eth_tx_burst(dist_slave_port_ids[i],
-				bd_tx_q->queue_id, slave_bufs[i],
-				slave_nb_bufs[i]);
+		slave_tx_count = rte_eth_tx_burst(dist->slaves[i],
+				queue_id, slave_bufs[i], slave_nb_bufs[i]);
 
 		total_tx_count += slave_tx_count;
 
@@ -384,6 +369,18 @@ bond_ethdev_tx_burst_8023ad_fast_queue(void *queue, struct rte_mbuf **bufs,
 	return total_tx_count;
 }
 
+static uint16_t
+bond_ethdev_tx_burst_8023ad_fast_queue(void *queue, struct rte_mbuf **bufs,
+		uint16_t nb_bufs)
+{
+	struct bond_tx_queue *bd_tx_q = (struct bond_tx_queue *)queue;
+
+	if (unlikely(nb_bufs == 0))
+		return 0;
+
+	return bond_ethdev_8023ad_dist_tx(bd_tx_q->dev_private,
+			bd_tx_q->queue_id, bufs, nb_bufs);
+}
 
 static uint16_t
 bond_ethdev_rx_burst_8023ad(void *queue, struct rte_mbuf **bufs,
@@ -772,130 +769,175 @@ ipv6_hash(struct ipv6_hdr *ipv6_hdr)
 }
 
 
-void
-burst_xmit_l2_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
-		uint8_t slave_count, uint16_t *slaves)
+static inline uint32_t
+xmit_l2_hash(const struct rte_mbuf *buf)
 {
-	struct ether_hdr *eth_hdr;
-	uint32_t hash;
-	int i;
-
-	for (i = 0; i < nb_pkts; i++) {
-		eth_hdr = rte_pktmbuf_mtod(buf[i], struct ether_hdr *);
+	struct ether_hdr *eth_hdr = rte_pktmbuf_mtod(buf, struct ether_hdr *);
+	uint32_t hash = ether_hash(eth_hdr);
 
-		hash = ether_hash(eth_hdr);
-
-		slaves[i] = (hash ^= hash >> 8) % slave_count;
-	}
+	return hash ^ (hash >> 8);
 }
 
-void
-burst_xmit_l23_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
-		uint8_t slave_count, uint16_t *slaves)
+static inline uint32_t
+xmit_l23_hash(const struct rte_mbuf *buf)
 {
-	uint16_t i;
-	struct ether_hdr *eth_hdr;
-	uint16_t proto;
+	struct ether_hdr *eth_hdr = rte_pktmbuf_mtod(buf, struct ether_hdr *);
+	uint16_t proto = eth_hdr->ether_type;
 	size_t vlan_offset;
-	uint32_t hash, l3hash;
+	uint32_t hash, l3hash = 0;
 
-	for (i = 0; i < nb_pkts; i++) {
-		eth_hdr = rte_pktmbuf_mtod(buf[i], struct ether_hdr *);
-		l3hash = 0;
-
-		proto = eth_hdr->ether_type;
-		hash = ether_hash(eth_hdr);
+	hash = ether_hash(eth_hdr);
 
-		vlan_offset = get_vlan_offset(eth_hdr, &proto);
+	vlan_offset = get_vlan_offset(eth_hdr, &proto);
 
-		if (rte_cpu_to_be_16(ETHER_TYPE_IPv4) == proto) {
-			struct ipv4_hdr *ipv4_hdr = (struct ipv4_hdr *)
-					((char *)(eth_hdr + 1) + vlan_offset);
-			l3hash = ipv4_hash(ipv4_hdr);
+	if (rte_cpu_to_be_16(ETHER_TYPE_IPv4) == proto) {
+		struct ipv4_hdr *ipv4_hdr = (struct ipv4_hdr *)
+				((char *)(eth_hdr + 1) + vlan_offset);
+		l3hash = ipv4_hash(ipv4_hdr);
 
-		} else if (rte_cpu_to_be_16(ETHER_TYPE_IPv6) == proto) {
-			struct ipv6_hdr *ipv6_hdr = (struct ipv6_hdr *)
-					((char *)(eth_hdr + 1) + vlan_offset);
-			l3hash = ipv6_hash(ipv6_hdr);
-		}
+	} else if (rte_cpu_to_be_16(ETHER_TYPE_IPv6) == proto) {
+		struct ipv6_hdr *ipv6_hdr = (struct ipv6_hdr *)
+				((char *)(eth_hdr + 1) + vlan_offset);
+		l3hash = ipv6_hash(ipv6_hdr);
+	}
 
-		hash = hash ^ l3hash;
-		hash ^= hash >> 16;
-		hash ^= hash >> 8;
+	hash = hash ^ l3hash;
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
 
-		slaves[i] = hash % slave_count;
-	}
+	return hash;
 }
 
-void
-burst_xmit_l34_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
-		uint8_t slave_count, uint16_t *slaves)
+static inline uint32_t
+xmit_l34_hash(const struct rte_mbuf *buf)
 {
-	struct ether_hdr *eth_hdr;
-	uint16_t proto;
+	struct ether_hdr *eth_hdr = rte_pktmbuf_mtod(buf, struct ether_hdr *);
+	uint16_t proto = eth_hdr->ether_type;
 	size_t vlan_offset;
-	int i;
 
 	struct udp_hdr *udp_hdr;
 	struct tcp_hdr *tcp_hdr;
-	uint32_t hash, l3hash, l4hash;
+	uint32_t hash, l3hash = 0, l4hash = 0;
 
-	for (i = 0; i < nb_pkts; i++) {
-		eth_hdr = rte_pktmbuf_mtod(buf[i], struct ether_hdr *);
-		proto = eth_hdr->ether_type;
-		vlan_offset = get_vlan_offset(eth_hdr, &proto);
-		l3hash = 0;
-		l4hash = 0;
-
-		if (rte_cpu_to_be_16(ETHER_TYPE_IPv4) == proto) {
-			struct ipv4_hdr *ipv4_hdr = (struct ipv4_hdr *)
-					((char *)(eth_hdr + 1) + vlan_offset);
-			size_t ip_hdr_offset;
-
-			l3hash = ipv4_hash(ipv4_hdr);
-
-			/* there is no L4 header in fragmented packet */
-			if (likely(rte_ipv4_frag_pkt_is_fragmented(ipv4_hdr)
-								== 0)) {
-				ip_hdr_offset = (ipv4_hdr->version_ihl
-					& IPV4_HDR_IHL_MASK) *
-					IPV4_IHL_MULTIPLIER;
-
-				if (ipv4_hdr->next_proto_id == IPPROTO_TCP) {
-					tcp_hdr = (struct tcp_hdr *)
-						((char *)ipv4_hdr +
-							ip_hdr_offset);
-					l4hash = HASH_L4_PORTS(tcp_hdr);
-				} else if (ipv4_hdr->next_proto_id ==
-								IPPROTO_UDP) {
-					udp_hdr = (struct udp_hdr *)
-						((char *)ipv4_hdr +
-							ip_hdr_offset);
-					l4hash = HASH_L4_PORTS(udp_hdr);
-				}
-			}
-		} else if  (rte_cpu_to_be_16(ETHER_TYPE_IPv6) == proto) {
-			struct ipv6_hdr *ipv6_hdr = (struct ipv6_hdr *)
-					((char *)(eth_hdr + 1) + vlan_offset);
-			l3hash = ipv6_hash(ipv6_hdr);
+	vlan_offset = get_vlan_offset(eth_hdr, &proto);
+
+	if (rte_cpu_to_be_16(ETHER_TYPE_IPv4) == proto) {
+		struct ipv4_hdr *ipv4_hdr = (struct ipv4_hdr *)
+				((char *)(eth_hdr + 1) + vlan_offset);
+		size_t ip_hdr_offset;
+
+		l3hash = ipv4_hash(ipv4_hdr);
+
+		/* there is no L4 header in fragmented packet */
+		if (likely(rte_ipv4_frag_pkt_is_fragmented(ipv4_hdr) == 0)) {
+			ip_hdr_offset = (ipv4_hdr->version_ihl
+				& IPV4_HDR_IHL_MASK) *
+				IPV4_IHL_MULTIPLIER;
 
-			if (ipv6_hdr->proto == IPPROTO_TCP) {
-				tcp_hdr = (struct tcp_hdr *)(ipv6_hdr + 1);
+			if (ipv4_hdr->next_proto_id == IPPROTO_TCP) {
+				tcp_hdr = (struct tcp_hdr *)
+					((char *)ipv4_hdr + ip_hdr_offset);
 				l4hash = HASH_L4_PORTS(tcp_hdr);
-			} else if (ipv6_hdr->proto == IPPROTO_UDP) {
-				udp_hdr = (struct udp_hdr *)(ipv6_hdr + 1);
+			} else if (ipv4_hdr->next_proto_id == IPPROTO_UDP) {
+				udp_hdr = (struct udp_hdr *)
+					((char *)ipv4_hdr + ip_hdr_offset);
 				l4hash = HASH_L4_PORTS(udp_hdr);
 			}
 		}
+	} else if  (rte_cpu_to_be_16(ETHER_TYPE_IPv6) == proto) {
+		struct ipv6_hdr *ipv6_hdr = (struct ipv6_hdr *)
+				((char *)(eth_hdr + 1) + vlan_offset);
+		l3hash = ipv6_hash(ipv6_hdr);
 
-		hash = l3hash ^ l4hash;
-		hash ^= hash >> 16;
-		hash ^= hash >> 8;
+		if (ipv6_hdr->proto == IPPROTO_TCP) {
+			tcp_hdr = (struct tcp_hdr *)(ipv6_hdr + 1);
+			l4hash = HASH_L4_PORTS(tcp_hdr);
+		} else if (ipv6_hdr->proto == IPPROTO_UDP) {
+			udp_hdr = (struct udp_hdr *)(ipv6_hdr + 1);
+			l4hash = HASH_L4_PORTS(udp_hdr);
+		}
+	}
+
+	hash = l3hash ^ l4hash;
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
+
+	return hash;
+}
 
-		slaves[i] = hash % slave_count;
+/*
+ * Hash a burst of packets, prefetching the headers of the packets
+ * BURST_XMIT_PREFETCH_OFFSET packets ahead so that the header loads of
+ * consecutive packets overlap. The result is either the slave index, hash
+ * modulo slave_count, or the Tx distribution table bucket of mode 4.
+ */
+static __rte_always_inline void
+burst_xmit_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint32_t (*xmit_hash)(const struct rte_mbuf *buf),
+		uint8_t slave_count, uint16_t *slaves, const int bucket)
+{
+	uint32_t hash;
+	uint16_t i;
+
+	for (i = 0; i < nb_pkts && i < BURST_XMIT_PREFETCH_OFFSET; i++)
+		rte_prefetch0(rte_pktmbuf_mtod(buf[i], void *));
+
+	for (i = 0; i < nb_pkts; i++) {
+		if (i + BURST_XMIT_PREFETCH_OFFSET < nb_pkts)
+			rte_prefetch0(rte_pktmbuf_mtod(
+				buf[i + BURST_XMIT_PREFETCH_OFFSET], void *));
+
+		hash = xmit_hash(buf[i]);
+
+		if (bucket)
+			slaves[i] = hash & (BOND_8023AD_DIST_BUCKETS - 1);
+		else
+			slaves[i] = hash % slave_count;
 	}
 }
 
+void
+burst_xmit_l2_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint8_t slave_count, uint16_t *slaves)
+{
+	burst_xmit_hash(buf, nb_pkts, xmit_l2_hash, slave_count, slaves, 0);
+}
+
+void
+burst_xmit_l23_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint8_t slave_count, uint16_t *slaves)
+{
+	burst_xmit_hash(buf, nb_pkts, xmit_l23_hash, slave_count, slaves, 0);
+}
+
+void
+burst_xmit_l34_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint8_t slave_count, uint16_t *slaves)
+{
+	burst_xmit_hash(buf, nb_pkts, xmit_l34_hash, slave_count, slaves, 0);
+}
+
+void
+burst_xmit_l2_bucket(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint16_t *buckets)
+{
+	burst_xmit_hash(buf, nb_pkts, xmit_l2_hash, 0, buckets, 1);
+}
+
+void
+burst_xmit_l23_bucket(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint16_t *buckets)
+{
+	burst_xmit_hash(buf, nb_pkts, xmit_l23_hash, 0, buckets, 1);
+}
+
+void
+burst_xmit_l34_bucket(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint16_t *buckets)
+{
+	burst_xmit_hash(buf, nb_pkts, xmit_l34_hash, 0, buckets, 1);
+}
+
 struct bwg_slave {
 	uint64_t bwg_left_int;
 	uint64_t bwg_left_remainder;
@@ -1283,18 +1325,8 @@ bond_ethdev_tx_burst_8023ad(void *queue, struct rte_mbuf **bufs,
 	uint16_t slave_port_ids[RTE_MAX_ETHPORTS];
 	uint16_t slave_count;
 
-	uint16_t dist_slave_port_ids[RTE_MAX_ETHPORTS];
-	uint16_t dist_slave_count;
-
-	/* 2-D array to sort mbufs for transmission on each slave into */
-	struct rte_mbuf *slave_bufs[RTE_MAX_ETHPORTS][nb_bufs];
-	/* Number of mbufs for transmission on each slave */
-	uint16_t slave_nb_bufs[RTE_MAX_ETHPORTS] = { 0 };
-	/* Mapping array generated by hash function to map mbufs to slaves */
-	uint16_t bufs_slave_port_idxs[RTE_MAX_ETHPORTS] = { 0 };
-
 	uint16_t slave_tx_count;
-	uint16_t total_tx_count = 0, total_tx_fail_count = 0;
+	uint16_t total_tx_count;
 
 	uint16_t i;
 
@@ -1310,60 +1342,8 @@ bond_ethdev_tx_burst_8023ad(void *queue, struct rte_mbuf **bufs,
 	memcpy(slave_port_ids, internals->active_slaves,
 			sizeof(slave_port_ids[0]) * slave_count);
 
-	dist_slave_count = 0;
-	for (i = 0; i < slave_count; i++) {
-		struct port *port = &bond_mode_8023ad_ports[slave_port_ids[i]];
-
-		if (ACTOR_STATE(port, DISTRIBUTING))
-			dist_slave_port_ids[dist_slave_count++] =
-					slave_port_ids[i];
-	}
-
-	if (likely(dist_slave_count > 1)) {
-
-		/*
-		 * Populate slaves mbuf with the packets which are to be sent
-		 * on it, selecting output slave using hash based on xmit policy
-		 */
-		internals->burst_xmit_hash(bufs, nb_bufs, dist_slave_count,
-				bufs_slave_port_idxs);
-
-		for (i = 0; i < nb_bufs; i++) {
-			/*
-			 * Populate slave mbuf arrays with mbufs for that
-			 * slave
-			 */
-			uint8_t slave_idx = bufs_slave_port_idxs[i];
-
-			slave_bufs[slave_idx][slave_nb_bufs[slave_idx]++] =
-					bufs[i];
-		}
-
-
-		/* Send packet burst on each slave device */
-		for (i = 0; i < dist_slave_count; i++) {
-			if (slave_nb_bufs[i] == 0)
-				continue;
-
-			slave_tx_count = rte_eth_tx_burst(
-					dist_slave_port_ids[i],
-					bd_tx_q->queue_id, slave_bufs[i],
-					slave_nb_bufs[i]);
-
-			total_tx_count += slave_tx_count;
-
-			/* If tx burst fails move packets to end of bufs */
-			if (unlikely(slave_tx_count < slave_nb_bufs[i])) {
-				int slave_tx_fail_count = slave_nb_bufs[i] -
-						slave_tx_count;
-				total_tx_fail_count += slave_tx_fail_count;
-
-				memcpy(&bufs[nb_bufs - total_tx_fail_count],
-				       &slave_bufs[i][slave_tx_count],
-				       slave_tx_fail_count * sizeof(bufs[0]));
-			}
-		}
-	}
+	total_tx_count = bond_ethdev_8023ad_dist_tx(internals,
+			bd_tx_q->queue_id, bufs, nb_bufs);
 
 	/* Check for LACP control packets and send if available */
 	for (i = 0; i < slave_count; i++) {
@@ -1648,6 +1628,26 @@ mac_address_slaves_update(struct rte_eth_dev *bonded_eth_dev)
 	return 0;
 }
 
+static void
+bond_ethdev_8023ad_burst_set(struct rte_eth_dev *eth_dev)
+{
+	struct bond_dev_private *internals = eth_dev->data->dev_private;
+
+	if (internals->mode4.dedicated_queues.enabled == 0) {
+		eth_dev->rx_pkt_burst = bond_ethdev_rx_burst_8023ad;
+		eth_dev->tx_pkt_burst = bond_ethdev_tx_burst_8023ad;
+		RTE_BOND_LOG(WARNING,
+			"Using mode 4, it is necessary to do TX burst "
+			"and RX burst at least every 100ms.");
+	} else {
+		/* Use flow director's optimization */
+		eth_dev->rx_pkt_burst =
+				bond_ethdev_rx_burst_8023ad_fast_queue;
+		eth_dev->tx_pkt_burst =
+				bond_ethdev_tx_burst_8023ad_fast_queue;
+	}
+}
+
 int
 bond_ethdev_mode_set(struct rte_eth_dev *eth_dev, int mode)
 {
@@ -1676,19 +1676,7 @@ bond_ethdev_mode_set(struct rte_eth_dev *eth_dev, int mode)
 		if (bond_mode_8023ad_enable(eth_dev) != 0)
 			return -1;
 
-		if (internals->mode4.dedicated_queues.enabled == 0) {
-			eth_dev->rx_pkt_burst = bond_ethdev_rx_burst_8023ad;
-			eth_dev->tx_pkt_burst = bond_ethdev_tx_burst_8023ad;
-			RTE_BOND_LOG(WARNING,
-				"Using mode 4, it is necessary to do TX burst "
-				"and RX burst at least every 100ms.");
-		} else {
-			/* Use flow director's optimization */
-			eth_dev->rx_pkt_burst =
-					bond_ethdev_rx_burst_8023ad_fast_queue;
-			eth_dev->tx_pkt_burst =
-					bond_ethdev_tx_burst_8023ad_fast_queue;
-		}
+		bond_ethdev_8023ad_burst_set(eth_dev);
 		break;
 	case BONDING_MODE_TLB:
 		eth_dev->tx_pkt_burst = bond_ethdev_tx_burst_tlb;
@@ -2065,6 +2053,25 @@ bond_ethdev_start(struct rte_eth_dev *eth_dev)
 		bond_ethdev_promiscuous_enable(eth_dev);
 
 	if (internals->mode == BONDING_MODE_8023AD) {
+		struct mode8023ad_private *mode4 = &internals->mode4;
+
+		/* Steer the LACP traffic to dedicated queues when all the
+		 * slaves support it, unless the application chose or handles
+		 * the LACP packets itself.
+		 */
+		if (mode4->dedicated_queues.user_set == 0 &&
+				mode4->slowrx_cb == NULL) {
+			uint8_t enabled;
+
+			enabled = bond_8023ad_slow_pkt_hw_filter_supported(
+					internals->port_id) == 0;
+
+			if (enabled != mode4->dedicated_queues.enabled) {
+				mode4->dedicated_queues.enabled = enabled;
+				bond_ethdev_8023ad_burst_set(eth_dev);
+			}
+		}
+
 		if (internals->mode4.dedicated_queues.enabled == 1) {
 			internals->mode4.dedicated_queues.rx_qid =
 					eth_dev->data->nb_rx_queues;
@@ -3067,6 +3074,7 @@ bond_alloc(struct rte_vdev_device *dev, uint8_t mode)
 	internals->current_primary_port = RTE_MAX_ETHPORTS + 1;
 	internals->balance_xmit_policy = BALANCE_XMIT_POLICY_LAYER2;
 	internals->burst_xmit_hash = burst_xmit_l2_hash;
+	internals->burst_xmit_bucket = burst_xmit_l2_bucket;
 	internals->user_defined_mac = 0;
 
 	internals->link_status_polling_enabled = 0;
@@ -102,6 +102,9 @@ struct rte_flow {
 typedef void (*burst_xmit_hash_t)(struct rte_mbuf **buf, uint16_t nb_pkts,
 		uint8_t slave_count, uint16_t *slaves);
 
+typedef void (*burst_xmit_bucket_t)(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint16_t *buckets);
+
 /** Link Bonding PMD device private configuration Structure */
 struct bond_dev_private {
 	uint16_t port_id;			/**< Port Id of Bonded Port */
@@ -119,6 +122,8 @@ struct bond_dev_private {
 	/**< Transmit policy - l2 / l23 / l34 for operation in balance mode */
 	burst_xmit_hash_t burst_xmit_hash;
 	/**< Transmit policy hash function */
+	burst_xmit_bucket_t burst_xmit_bucket;
+	/**< Transmit policy hash function to mode 4 distribution buckets */
 
 	uint8_t user_defined_mac;
 	/**< Flag for whether MAC address is user defined or not */
@@ -273,6 +278,18 @@ void
 burst_xmit_l34_hash(struct rte_mbuf **buf, uint16_t nb_pkts,
 		uint8_t slave_count, uint16_t *slaves);
 
+void
+burst_xmit_l2_bucket(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint16_t *buckets);
+
+void
+burst_xmit_l23_bucket(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint16_t *buckets);
+
+void
+burst_xmit_l34_bucket(struct rte_mbuf **buf, uint16_t nb_pkts,
+		uint16_t *buckets);
+
 
 void
 bond_ethdev_primary_set(struct bond_dev_private *internals,
@@ -139,6 +139,8 @@ struct fs_priv {
 	uint8_t subs_head; /* if head == tail, no subs */
 	uint8_t subs_tail; /* first invalid */
 	uint8_t subs_tx; /* current emitting device */
+	/* only active sub_device, used by the direct bursts */
+	struct sub_device *subs_direct;
 	uint8_t current_probed;
 	/* flow mapping */
 	TAILQ_HEAD(sub_flows, rte_flow) flow_list;
@@ -205,6 +207,11 @@ uint16_t failsafe_rx_burst_fast(void *rxq,
 uint16_t failsafe_tx_burst_fast(void *txq,
 		struct rte_mbuf **tx_pkts, uint16_t nb_pkts);
 
+uint16_t failsafe_rx_burst_direct(void *rxq,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts);
+uint16_t failsafe_tx_burst_direct(void *txq,
+		struct rte_mbuf **tx_pkts, uint16_t nb_pkts);
+
 /* ARGS */
 
 int failsafe_args_parse(struct rte_eth_dev *dev, const char *params);
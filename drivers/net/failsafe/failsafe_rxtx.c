@@ -28,35 +28,80 @@ fs_tx_unsafe(struct sub_device *sdev)
 		(sdev->state != DEV_STARTED);
 }
 
+/*
+ * Return the emitting sub_device when it is the only one able to
+ * receive, NULL otherwise.
+ */
+static struct sub_device *
+fs_direct_subdev(struct rte_eth_dev *dev)
+{
+	struct sub_device *txd;
+	struct sub_device *sdev;
+	uint8_t i;
+
+	txd = TX_SUBDEV(dev);
+	if (fs_tx_unsafe(txd) || fs_rx_unsafe(txd))
+		return NULL;
+	FOREACH_SUBDEV(sdev, i, dev)
+		if (sdev != txd && !fs_rx_unsafe(sdev))
+			return NULL;
+	return txd;
+}
+
+static const char *
+fs_burst_name(int direct, int need_safe)
+{
+	return direct ? "direct" : need_safe ? "safe" : "fast";
+}
+
 void
 failsafe_set_burst_fn(struct rte_eth_dev *dev, int force_safe)
 {
 	struct sub_device *sdev;
+	eth_rx_burst_t rx_burst;
+	eth_tx_burst_t tx_burst;
 	uint8_t i;
-	int need_safe;
-	int safe_set;
+	int need_rx_safe;
+	int need_tx_safe;
+	int direct;
 
-	need_safe = force_safe;
+	/*
+	 * When a single sub_device is active, the direct bursts call it
+	 * without iterating over the sub_devices nor checking their state.
+	 * Any hot-plug event calls this function again to leave this mode.
+	 */
+	sdev = force_safe ? NULL : fs_direct_subdev(dev);
+	direct = (sdev != NULL);
+	if (direct) {
+		/*
+		 * A burst in progress may still use the previous one, it
+		 * is only replaced, and released by the removal once its
+		 * reference is dropped.
+		 */
+		PRIV(dev)->subs_direct = sdev;
+		rte_wmb();
+	}
+	need_rx_safe = force_safe;
 	FOREACH_SUBDEV(sdev, i, dev)
-		need_safe |= fs_rx_unsafe(sdev);
-	safe_set = (dev->rx_pkt_burst == &failsafe_rx_burst);
-	if (need_safe && !safe_set) {
-		DEBUG("Using safe RX bursts%s",
+		need_rx_safe |= fs_rx_unsafe(sdev);
+	need_tx_safe = force_safe || fs_tx_unsafe(TX_SUBDEV(dev));
+	rx_burst = direct ? &failsafe_rx_burst_direct :
+		   need_rx_safe ? &failsafe_rx_burst :
+		   &failsafe_rx_burst_fast;
+	tx_burst = direct ? &failsafe_tx_burst_direct :
+		   need_tx_safe ? &failsafe_tx_burst :
+		   &failsafe_tx_burst_fast;
+	if (dev->rx_pkt_burst != rx_burst) {
+		DEBUG("Using %s RX bursts%s",
+		      fs_burst_name(direct, need_rx_safe),
 		      (force_safe ? " (forced)" : ""));
-		dev->rx_pkt_burst = &failsafe_rx_burst;
-	} else if (!need_safe && safe_set) {
-		DEBUG("Using fast RX bursts");
-		dev->rx_pkt_burst = &failsafe_rx_burst_fast;
+		dev->rx_pkt_burst = rx_burst;
 	}
-	need_safe = force_safe || fs_tx_unsafe(TX_SUBDEV(dev));
-	safe_set = (dev->tx_pkt_burst == &failsafe_tx_burst);
-	if (need_safe && !safe_set) {
-		DEBUG("Using safe TX bursts%s",
+	if (dev->tx_pkt_burst != tx_burst) {
+		DEBUG("Using %s TX bursts%s",
+		      fs_burst_name(direct, need_tx_safe),
 		      (force_safe ? " (forced)" : ""));
-		dev->tx_pkt_burst = &failsafe_tx_burst;
-	} else if (!need_safe && safe_set) {
-		DEBUG("Using fast TX bursts");
-		dev->tx_pkt_burst = &failsafe_tx_burst_fast;
+		dev->tx_pkt_burst = tx_burst;
 	}
 	rte_wmb();
 }
@@ -155,3 +200,41 @@ failsafe_tx_burst_fast(void *queue,
 	FS_ATOMIC_V(txq->refcnt[sdev->sid]);
 	return nb_tx;
 }
+
+uint16_t
+failsafe_rx_burst_direct(void *queue,
+			 struct rte_mbuf **rx_pkts,
+			 uint16_t nb_pkts)
+{
+	struct sub_device *sdev;
+	struct rxq *rxq;
+	void *sub_rxq;
+	uint16_t nb_rx;
+
+	rxq = queue;
+	sdev = rxq->priv->subs_direct;
+	sub_rxq = ETH(sdev)->data->rx_queues[rxq->qid];
+	FS_ATOMIC_P(rxq->refcnt[sdev->sid]);
+	nb_rx = ETH(sdev)->rx_pkt_burst(sub_rxq, rx_pkts, nb_pkts);
+	FS_ATOMIC_V(rxq->refcnt[sdev->sid]);
+	return nb_rx;
+}
+
+uint16_t
+failsafe_tx_burst_direct(void *queue,
+			 struct rte_mbuf **tx_pkts,
+			 uint16_t nb_pkts)
+{
+	struct sub_device *sdev;
+	struct txq *txq;
+	void *sub_txq;
+	uint16_t nb_tx;
+
+	txq = queue;
+	sdev = txq->priv->subs_direct;
+	sub_txq = ETH(sdev)->data->tx_queues[txq->qid];
+	FS_ATOMIC_P(txq->refcnt[sdev->sid]);
+	nb_tx = ETH(sdev)->tx_pkt_burst(sub_txq, tx_pkts, nb_pkts);
+	FS_ATOMIC_V(txq->refcnt[sdev->sid]);
+	return nb_tx;
+}
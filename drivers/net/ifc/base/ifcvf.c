@@ -184,16 +184,34 @@ io_write64_twopart(u64 val, u32 *lo, u32 *hi)
 	IFCVF_WRITE_REG32(val >> 32, hi);
 }
 
+STATIC void
+ifcvf_set_ring_state(struct ifcvf_hw *hw, u32 i)
+{
+	*(u32 *)(hw->lm_cfg + IFCVF_LM_RING_STATE_OFFSET +
+			(i / 2) * IFCVF_LM_CFG_SIZE + (i % 2) * 4) =
+		(u32)hw->vring[i].last_avail_idx |
+		((u32)hw->vring[i].last_used_idx << 16);
+}
+
+STATIC void
+ifcvf_get_ring_state(struct ifcvf_hw *hw, u32 i)
+{
+	u32 ring_state;
+
+	ring_state = *(u32 *)(hw->lm_cfg + IFCVF_LM_RING_STATE_OFFSET +
+			(i / 2) * IFCVF_LM_CFG_SIZE + (i % 2) * 4);
+	hw->vring[i].last_avail_idx = (u16)(ring_state >> 16);
+	hw->vring[i].last_used_idx = (u16)(ring_state >> 16);
+}
+
 STATIC int
 ifcvf_hw_enable(struct ifcvf_hw *hw)
 {
 	struct ifcvf_pci_common_cfg *cfg;
-	u8 *lm_cfg;
 	u32 i;
 	u16 notify_off;
 
 	cfg = hw->common_cfg;
-	lm_cfg = hw->lm_cfg;
 
 	IFCVF_WRITE_REG16(0, &cfg->msix_config);
 	if (IFCVF_READ_REG16(&cfg->msix_config) == IFCVF_MSI_NO_VECTOR) {
@@ -211,10 +229,7 @@ ifcvf_hw_enable(struct ifcvf_hw *hw)
 				&cfg->queue_used_hi);
 		IFCVF_WRITE_REG16(hw->vring[i].size, &cfg->queue_size);
 
-		*(u32 *)(lm_cfg + IFCVF_LM_RING_STATE_OFFSET +
-				(i / 2) * IFCVF_LM_CFG_SIZE + (i % 2) * 4) =
-			(u32)hw->vring[i].last_avail_idx |
-			((u32)hw->vring[i].last_used_idx << 16);
+		ifcvf_set_ring_state(hw, i);
 
 		IFCVF_WRITE_REG16(i + 1, &cfg->queue_msix_vector);
 		if (IFCVF_READ_REG16(&cfg->queue_msix_vector) ==
@@ -227,7 +242,7 @@ ifcvf_hw_enable(struct ifcvf_hw *hw)
 		notify_off = IFCVF_READ_REG16(&cfg->queue_notify_off);
 		hw->notify_addr[i] = (void *)((u8 *)hw->notify_base +
 				notify_off * hw->notify_off_multiplier);
-		IFCVF_WRITE_REG16(1, &cfg->queue_enable);
+		IFCVF_WRITE_REG16(hw->vring[i].enable, &cfg->queue_enable);
 	}
 
 	return 0;
@@ -238,7 +253,6 @@ ifcvf_hw_disable(struct ifcvf_hw *hw)
 {
 	u32 i;
 	struct ifcvf_pci_common_cfg *cfg;
-	u32 ring_state;
 
 	cfg = hw->common_cfg;
 
@@ -247,10 +261,7 @@ ifcvf_hw_disable(struct ifcvf_hw *hw)
 		IFCVF_WRITE_REG16(i, &cfg->queue_select);
 		IFCVF_WRITE_REG16(0, &cfg->queue_enable);
 		IFCVF_WRITE_REG16(IFCVF_MSI_NO_VECTOR, &cfg->queue_msix_vector);
-		ring_state = *(u32 *)(hw->lm_cfg + IFCVF_LM_RING_STATE_OFFSET +
-				(i / 2) * IFCVF_LM_CFG_SIZE + (i % 2) * 4);
-		hw->vring[i].last_avail_idx = (u16)(ring_state >> 16);
-		hw->vring[i].last_used_idx = (u16)(ring_state >> 16);
+		ifcvf_get_ring_state(hw, i);
 	}
 }
 
@@ -278,6 +289,32 @@ ifcvf_stop_hw(struct ifcvf_hw *hw)
 	ifcvf_reset(hw);
 }
 
+void
+ifcvf_enable_vring_hw(struct ifcvf_hw *hw, int i)
+{
+	struct ifcvf_pci_common_cfg *cfg;
+
+	cfg = hw->common_cfg;
+
+	IFCVF_WRITE_REG16(i, &cfg->queue_select);
+	ifcvf_set_ring_state(hw, i);
+	IFCVF_WRITE_REG16(1, &cfg->queue_enable);
+	hw->vring[i].enable = 1;
+}
+
+void
+ifcvf_disable_vring_hw(struct ifcvf_hw *hw, int i)
+{
+	struct ifcvf_pci_common_cfg *cfg;
+
+	cfg = hw->common_cfg;
+
+	IFCVF_WRITE_REG16(i, &cfg->queue_select);
+	IFCVF_WRITE_REG16(0, &cfg->queue_enable);
+	ifcvf_get_ring_state(hw, i);
+	hw->vring[i].enable = 0;
+}
+
 void
 ifcvf_enable_logging(struct ifcvf_hw *hw, u64 log_base, u64 log_size)
 {
@@ -2,21 +2,28 @@
  * Copyright(c) 2018 Intel Corporation
  */
 
+#include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <linux/virtio_net.h>
+#include <stdbool.h>
 
 #include <rte_malloc.h>
 #include <rte_memory.h>
 #include <rte_bus_pci.h>
+#include <rte_devargs.h>
+#include <rte_kvargs.h>
+#include <rte_string_fns.h>
 #include <rte_vhost.h>
 #include <rte_vdpa.h>
 #include <rte_vfio.h>
 #include <rte_spinlock.h>
 #include <rte_log.h>
+#include <rte_service_component.h>
 
 #include "base/ifcvf.h"
 
@@ -28,6 +35,17 @@
 #define PAGE_SIZE 4096
 #endif
 
+#define IFCVF_VDPA_MODE		"vdpa"
+#define IFCVF_SW_FALLBACK_LM	"sw-live-migration"
+#define IFCVF_RELAY_SERVICE	"relay-service"
+
+static const char * const ifcvf_valid_arguments[] = {
+	IFCVF_VDPA_MODE,
+	IFCVF_SW_FALLBACK_LM,
+	IFCVF_RELAY_SERVICE,
+	NULL
+};
+
 static int ifcvf_vdpa_logtype;
 
 struct ifcvf_internal {
@@ -47,6 +65,38 @@ struct ifcvf_internal {
 	rte_atomic32_t dev_attached;
 	rte_atomic32_t running;
 	rte_spinlock_t lock;
+	bool sw_lm;
+	bool sw_fallback_running;
+	/* mediated vring for sw fallback */
+	struct vring m_vring[IFCVF_MAX_QUEUES * 2];
+	/* eventfd for used ring interrupt */
+	int intr_fd[IFCVF_MAX_QUEUES * 2];
+	/* kicks are relayed by the shared relay service */
+	bool relay_service;
+	bool relay_attached;
+	struct ifcvf_relay_ctx {
+		struct ifcvf_internal *internal;
+		uint16_t qid;
+		int kickfd;
+	} relay_ctx[IFCVF_MAX_QUEUES * 2];
+	/* software counters of the relays, the VF has no HW counters */
+	struct ifcvf_queue_stats {
+		uint64_t kicks;
+		uint64_t relay_used;
+		uint64_t relay_interrupts;
+		uint64_t relay_errors;
+	} stats[IFCVF_MAX_QUEUES * 2];
+};
+
+static const struct {
+	char name[RTE_VDPA_XSTATS_NAME_SIZE];
+	size_t offset;
+} ifcvf_xstats[] = {
+	{ "kicks", offsetof(struct ifcvf_queue_stats, kicks) },
+	{ "relay_used", offsetof(struct ifcvf_queue_stats, relay_used) },
+	{ "relay_interrupts",
+	  offsetof(struct ifcvf_queue_stats, relay_interrupts) },
+	{ "relay_errors", offsetof(struct ifcvf_queue_stats, relay_errors) },
 };
 
 struct internal_list {
@@ -323,10 +373,130 @@ vdpa_ifcvf_stop(struct ifcvf_internal *internal)
 	}
 }
 
+static int
+m_ifcvf_start(struct ifcvf_internal *internal)
+{
+	struct ifcvf_hw *hw = &internal->hw;
+	uint32_t i, nr_vring;
+	int vid, ret;
+	struct rte_vhost_vring vq;
+	void *vring_buf;
+	uint64_t m_vring_iova = IFCVF_MEDIATED_VRING;
+	uint64_t size;
+	uint64_t gpa;
+
+	memset(&vq, 0, sizeof(vq));
+	vid = internal->vid;
+	nr_vring = rte_vhost_get_vring_num(vid);
+	rte_vhost_get_negotiated_features(vid, &hw->req_features);
+
+	for (i = 0; i < nr_vring; i++) {
+		rte_vhost_get_vhost_vring(vid, i, &vq);
+
+		size = RTE_ALIGN_CEIL(vring_size(vq.size, PAGE_SIZE),
+				PAGE_SIZE);
+		vring_buf = rte_zmalloc("ifcvf", size, PAGE_SIZE);
+		if (vring_buf == NULL) {
+			DRV_LOG(ERR, "failed to allocate mediated vring.");
+			goto error;
+		}
+		vring_init(&internal->m_vring[i], vq.size, vring_buf,
+				PAGE_SIZE);
+
+		ret = rte_vfio_container_dma_map(internal->vfio_container_fd,
+			(uint64_t)(uintptr_t)vring_buf, m_vring_iova, size);
+		if (ret < 0) {
+			DRV_LOG(ERR, "mediated vring DMA map failed.");
+			goto error;
+		}
+
+		/*
+		 * The device still reads the guest descriptors and available
+		 * ring, only the used entries it writes go to the mediated
+		 * ring, the relay thread then copies them to the guest.
+		 */
+		gpa = hva_to_gpa(vid, (uint64_t)(uintptr_t)vq.desc);
+		if (gpa == 0) {
+			DRV_LOG(ERR, "Fail to get GPA for descriptor ring.");
+			goto error;
+		}
+		hw->vring[i].desc = gpa;
+
+		gpa = hva_to_gpa(vid, (uint64_t)(uintptr_t)vq.avail);
+		if (gpa == 0) {
+			DRV_LOG(ERR, "Fail to get GPA for available ring.");
+			goto error;
+		}
+		hw->vring[i].avail = gpa;
+
+		hw->vring[i].used = m_vring_iova +
+			(char *)internal->m_vring[i].used -
+			(char *)internal->m_vring[i].desc;
+
+		hw->vring[i].size = vq.size;
+
+		rte_vhost_get_vring_base(vid, i, &hw->vring[i].last_avail_idx,
+				&hw->vring[i].last_used_idx);
+		internal->m_vring[i].used->idx = hw->vring[i].last_used_idx;
+
+		m_vring_iova += size;
+	}
+	hw->nr_vring = nr_vring;
+
+	return ifcvf_start_hw(&internal->hw);
+
+error:
+	m_vring_iova = IFCVF_MEDIATED_VRING;
+	for (i = 0; i < nr_vring; i++) {
+		if (internal->m_vring[i].desc == NULL)
+			continue;
+		size = RTE_ALIGN_CEIL(vring_size(internal->m_vring[i].num,
+				PAGE_SIZE), PAGE_SIZE);
+		rte_vfio_container_dma_unmap(internal->vfio_container_fd,
+			(uint64_t)(uintptr_t)internal->m_vring[i].desc,
+			m_vring_iova, size);
+		rte_free(internal->m_vring[i].desc);
+		internal->m_vring[i].desc = NULL;
+		m_vring_iova += size;
+	}
+
+	return -1;
+}
+
+static void
+m_ifcvf_stop(struct ifcvf_internal *internal)
+{
+	int vid;
+	uint32_t i;
+	struct ifcvf_hw *hw = &internal->hw;
+	uint64_t m_vring_iova = IFCVF_MEDIATED_VRING;
+	uint64_t size;
+
+	vid = internal->vid;
+	ifcvf_stop_hw(hw);
+
+	for (i = 0; i < hw->nr_vring; i++) {
+		/* relay the last used entries written before the stop */
+		rte_vdpa_relay_vring_used(vid, i, &internal->m_vring[i]);
+		hw->vring[i].last_used_idx = internal->m_vring[i].used->idx;
+		rte_vhost_set_vring_base(vid, i, hw->vring[i].last_avail_idx,
+				hw->vring[i].last_used_idx);
+
+		size = RTE_ALIGN_CEIL(vring_size(internal->m_vring[i].num,
+				PAGE_SIZE), PAGE_SIZE);
+		rte_vfio_container_dma_unmap(internal->vfio_container_fd,
+			(uint64_t)(uintptr_t)internal->m_vring[i].desc,
+			m_vring_iova, size);
+		rte_free(internal->m_vring[i].desc);
+		internal->m_vring[i].desc = NULL;
+		m_vring_iova += size;
+	}
+}
+
 #define MSIX_IRQ_SET_BUF_LEN (sizeof(struct vfio_irq_set) + \
 		sizeof(int) * (IFCVF_MAX_QUEUES * 2 + 1))
 static int
-vdpa_enable_vfio_intr(struct ifcvf_internal *internal)
+vdpa_enable_vfio_intr(struct ifcvf_internal *internal, bool m_ring)
 {
 	int ret;
 	uint32_t i, nr_vring;
@@ -347,25 +517,51 @@ vdpa_enable_vfio_intr(struct ifcvf_internal *internal)
 	fd_ptr = (int *)&irq_set->data;
 	fd_ptr[RTE_INTR_VEC_ZERO_OFFSET] = internal->pdev->intr_handle.fd;
 
+	for (i = 0; i < nr_vring; i++)
+		internal->intr_fd[i] = -1;
+
 	for (i = 0; i < nr_vring; i++) {
 		rte_vhost_get_vhost_vring(internal->vid, i, &vring);
 		fd_ptr[RTE_INTR_VEC_RXTX_OFFSET + i] = vring.callfd;
+		/*
+		 * With mediated rings the used entries are relayed to the
+		 * guest first, so the device interrupts the relay thread.
+		 */
+		if (m_ring) {
+			internal->intr_fd[i] = eventfd(0, EFD_NONBLOCK);
+			if (internal->intr_fd[i] < 0) {
+				DRV_LOG(ERR, "can't setup eventfd: %s",
+					strerror(errno));
+				goto error;
+			}
+			fd_ptr[RTE_INTR_VEC_RXTX_OFFSET + i] =
+				internal->intr_fd[i];
+		}
 	}
 
 	ret = ioctl(internal->vfio_dev_fd, VFIO_DEVICE_SET_IRQS, irq_set);
 	if (ret) {
 		DRV_LOG(ERR, "Error enabling MSI-X interrupts: %s",
 				strerror(errno));
-		return -1;
+		goto error;
 	}
 
 	return 0;
+
+error:
+	for (i = 0; i < nr_vring; i++) {
+		if (internal->intr_fd[i] >= 0)
+			close(internal->intr_fd[i]);
+		internal->intr_fd[i] = -1;
+	}
+	return -1;
 }
 
 static int
 vdpa_disable_vfio_intr(struct ifcvf_internal *internal)
 {
 	int ret;
+	uint32_t i, nr_vring;
 	char irq_set_buf[MSIX_IRQ_SET_BUF_LEN];
 	struct vfio_irq_set *irq_set;
 
@@ -383,6 +579,13 @@ vdpa_disable_vfio_intr(struct ifcvf_internal *internal)
 		return -1;
 	}
 
+	nr_vring = rte_vhost_get_vring_num(internal->vid);
+	for (i = 0; i < nr_vring; i++) {
+		if (internal->intr_fd[i] >= 0)
+			close(internal->intr_fd[i]);
+		internal->intr_fd[i] = -1;
+	}
+
 	return 0;
 }
 
@@ -445,17 +648,197 @@ notify_relay(void *arg)
 			} while (1);
 
 			ifcvf_notify_queue(hw, qid);
+			internal->stats[qid].kicks++;
 		}
 	}
 
 	return NULL;
 }
 
+/*
+ * Notify relay service shared by all the devices probed with the
+ * relay-service argument: one epoll instance holds the kickfds of all the
+ * devices, it is polled without blocking from a service core.
+ */
+#define IFCVF_RELAY_BURST 32
+
+static struct {
+	rte_spinlock_t lock;
+	int epfd;
+	uint32_t id;
+	uint32_t refcnt; /* devices attached to the service */
+} relay_service = {
+	.lock = RTE_SPINLOCK_INITIALIZER,
+	.epfd = -1,
+};
+
+static int32_t
+relay_service_run(void *args __rte_unused)
+{
+	struct epoll_event events[IFCVF_RELAY_BURST];
+	struct ifcvf_relay_ctx *ctx;
+	int i, nfds, nbytes;
+	uint64_t buf;
+
+	/* the lock keeps the contexts alive while their kicks are relayed */
+	if (!rte_spinlock_trylock(&relay_service.lock))
+		return 0;
+
+	nfds = epoll_wait(relay_service.epfd, events, IFCVF_RELAY_BURST, 0);
+	for (i = 0; i < nfds; i++) {
+		ctx = events[i].data.ptr;
+		do {
+			nbytes = read(ctx->kickfd, &buf, 8);
+			if (nbytes < 0 && errno == EINTR)
+				continue;
+			break;
+		} while (1);
+
+		ifcvf_notify_queue(&ctx->internal->hw, ctx->qid);
+		ctx->internal->stats[ctx->qid].kicks++;
+	}
+
+	rte_spinlock_unlock(&relay_service.lock);
+	return 0;
+}
+
+/* must be called with the relay service lock held */
+static int
+relay_service_register(void)
+{
+	struct rte_service_spec service;
+	int ret;
+
+	if (relay_service.refcnt > 0) {
+		relay_service.refcnt++;
+		return 0;
+	}
+
+	relay_service.epfd = epoll_create(IFCVF_MAX_QUEUES * 2);
+	if (relay_service.epfd < 0) {
+		DRV_LOG(ERR, "failed to create epoll instance.");
+		return -1;
+	}
+
+	memset(&service, 0, sizeof(service));
+	snprintf(service.name, sizeof(service.name), "ifcvf_notify_relay");
+	service.socket_id = rte_socket_id();
+	service.callback = relay_service_run;
+	ret = rte_service_component_register(&service, &relay_service.id);
+	if (ret) {
+		DRV_LOG(ERR, "failed to register notify relay service.");
+		close(relay_service.epfd);
+		relay_service.epfd = -1;
+		return -1;
+	}
+	rte_service_component_runstate_set(relay_service.id, 1);
+	relay_service.refcnt = 1;
+
+	DRV_LOG(INFO, "notify relay service %u registered, it needs to be "
+		"mapped to a service core.", relay_service.id);
+	return 0;
+}
+
+/* must be called with the relay service lock held */
+static void
+relay_service_unregister(void)
+{
+	if (--relay_service.refcnt > 0)
+		return;
+
+	/* no iteration relays kicks while the lock is held */
+	rte_service_component_runstate_set(relay_service.id, 0);
+	rte_service_component_unregister(relay_service.id);
+	close(relay_service.epfd);
+	relay_service.epfd = -1;
+
+	DRV_LOG(INFO, "notify relay service %u unregistered.",
+		relay_service.id);
+}
+
+/* must be called with the relay service lock held */
+static void
+relay_service_detach(struct ifcvf_internal *internal)
+{
+	uint32_t qid;
+
+	if (!internal->relay_attached)
+		return;
+
+	for (qid = 0; qid < RTE_DIM(internal->relay_ctx); qid++) {
+		if (internal->relay_ctx[qid].internal == NULL)
+			continue;
+		epoll_ctl(relay_service.epfd, EPOLL_CTL_DEL,
+			  internal->relay_ctx[qid].kickfd, NULL);
+		internal->relay_ctx[qid].internal = NULL;
+	}
+	internal->relay_attached = false;
+	relay_service_unregister();
+}
+
+static int
+relay_service_del(struct ifcvf_internal *internal)
+{
+	rte_spinlock_lock(&relay_service.lock);
+	relay_service_detach(internal);
+	rte_spinlock_unlock(&relay_service.lock);
+
+	return 0;
+}
+
+static int
+relay_service_add(struct ifcvf_internal *internal)
+{
+	struct rte_vhost_vring vring;
+	struct epoll_event ev;
+	uint32_t qid, q_num;
+
+	q_num = rte_vhost_get_vring_num(internal->vid);
+
+	rte_spinlock_lock(&relay_service.lock);
+	if (relay_service_register())
+		goto error;
+	internal->relay_attached = true;
+
+	for (qid = 0; qid < q_num; qid++) {
+		struct ifcvf_relay_ctx *ctx = &internal->relay_ctx[qid];
+
+		if (rte_vhost_get_vhost_vring(internal->vid, qid, &vring)) {
+			DRV_LOG(ERR, "failed to get vring %u of vid %d.",
+				qid, internal->vid);
+			goto detach;
+		}
+		ctx->internal = internal;
+		ctx->qid = qid;
+		ctx->kickfd = vring.kickfd;
+		ev.events = EPOLLIN | EPOLLPRI;
+		ev.data.ptr = ctx;
+		if (epoll_ctl(relay_service.epfd, EPOLL_CTL_ADD, vring.kickfd,
+			      &ev) < 0) {
+			DRV_LOG(ERR, "epoll add error: %s", strerror(errno));
+			ctx->internal = NULL;
+			goto detach;
+		}
+	}
+	rte_spinlock_unlock(&relay_service.lock);
+
+	return 0;
+
+detach:
+	relay_service_detach(internal);
+error:
+	rte_spinlock_unlock(&relay_service.lock);
+	return -1;
+}
+
 static int
 setup_notify_relay(struct ifcvf_internal *internal)
 {
 	int ret;
 
+	if (internal->relay_service)
+		return relay_service_add(internal);
+
 	ret = pthread_create(&internal->tid, NULL, notify_relay,
 			(void *)internal);
 	if (ret) {
@@ -470,6 +853,9 @@ unset_notify_relay(struct ifcvf_internal *internal)
 {
 	void *status;
 
+	if (internal->relay_service)
+		return relay_service_del(internal);
+
 	if (internal->tid) {
 		pthread_cancel(internal->tid);
 		pthread_join(internal->tid, &status);
@@ -483,6 +869,198 @@ unset_notify_relay(struct ifcvf_internal *internal)
 	return 0;
 }
 
+static void
+update_used_ring(struct ifcvf_internal *internal, uint16_t qid)
+{
+	int ret;
+
+	ret = rte_vdpa_relay_vring_used(internal->vid, qid,
+			&internal->m_vring[qid]);
+	if (ret < 0)
+		internal->stats[qid].relay_errors++;
+	else
+		internal->stats[qid].relay_used += ret;
+	rte_vhost_vring_call(internal->vid, qid);
+}
+
+static void *
+vring_relay(void *arg)
+{
+	int i, vid, epfd, fd, nfds;
+	struct ifcvf_internal *internal = (struct ifcvf_internal *)arg;
+	struct rte_vhost_vring vring;
+	uint16_t qid, q_num;
+	struct epoll_event events[IFCVF_MAX_QUEUES * 4];
+	struct epoll_event ev;
+	int nbytes;
+	uint64_t buf;
+
+	vid = internal->vid;
+	q_num = rte_vhost_get_vring_num(vid);
+
+	/* add notify fd and interrupt fd to epoll */
+	epfd = epoll_create(IFCVF_MAX_QUEUES * 4);
+	if (epfd < 0) {
+		DRV_LOG(ERR, "failed to create epoll instance.");
+		return NULL;
+	}
+	internal->epfd = epfd;
+
+	for (qid = 0; qid < q_num; qid++) {
+		ev.events = EPOLLIN | EPOLLPRI;
+		rte_vhost_get_vhost_vring(vid, qid, &vring);
+		ev.data.u64 = qid << 1 | (uint64_t)vring.kickfd << 32;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, vring.kickfd, &ev) < 0) {
+			DRV_LOG(ERR, "epoll add error: %s", strerror(errno));
+			return NULL;
+		}
+	}
+
+	for (qid = 0; qid < q_num; qid++) {
+		ev.events = EPOLLIN | EPOLLPRI;
+		/* leave a flag to mark it's for interrupt */
+		ev.data.u64 = 1 | qid << 1 |
+			(uint64_t)internal->intr_fd[qid] << 32;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, internal->intr_fd[qid], &ev)
+				< 0) {
+			DRV_LOG(ERR, "epoll add error: %s", strerror(errno));
+			return NULL;
+		}
+		update_used_ring(internal, qid);
+	}
+
+	/* start relay with a first kick */
+	for (qid = 0; qid < q_num; qid++)
+		ifcvf_notify_queue(&internal->hw, qid);
+
+	/* listen to the events and react accordingly */
+	for (;;) {
+		nfds = epoll_wait(epfd, events, q_num * 2, -1);
+		if (nfds < 0) {
+			if (errno == EINTR)
+				continue;
+			DRV_LOG(ERR, "epoll_wait return fail\n");
+			return NULL;
+		}
+
+		for (i = 0; i < nfds; i++) {
+			fd = (uint32_t)(events[i].data.u64 >> 32);
+			do {
+				nbytes = read(fd, &buf, 8);
+				if (nbytes < 0) {
+					if (errno == EINTR ||
+					    errno == EWOULDBLOCK ||
+					    errno == EAGAIN)
+						continue;
+					DRV_LOG(INFO, "Error reading "
+						"kickfd: %s",
+						strerror(errno));
+				}
+				break;
+			} while (1);
+
+			qid = events[i].data.u32 >> 1;
+
+			if (events[i].data.u32 & 1) {
+				update_used_ring(internal, qid);
+				internal->stats[qid].relay_interrupts++;
+			} else {
+				ifcvf_notify_queue(&internal->hw, qid);
+				internal->stats[qid].kicks++;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static int
+setup_vring_relay(struct ifcvf_internal *internal)
+{
+	int ret;
+
+	ret = pthread_create(&internal->tid, NULL, vring_relay,
+			(void *)internal);
+	if (ret) {
+		DRV_LOG(ERR, "failed to create ring relay pthread.");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+unset_vring_relay(struct ifcvf_internal *internal)
+{
+	void *status;
+
+	if (internal->tid) {
+		pthread_cancel(internal->tid);
+		pthread_join(internal->tid, &status);
+	}
+	internal->tid = 0;
+
+	if (internal->epfd >= 0)
+		close(internal->epfd);
+	internal->epfd = -1;
+
+	return 0;
+}
+
+/*
+ * Move a running device to the mediated datapath: the device writes its
+ * used entries to host rings and the relay thread forwards them to the
+ * guest, logging exactly the guest pages written.
+ */
+static int
+ifcvf_sw_fallback_switchover(struct ifcvf_internal *internal)
+{
+	int ret;
+
+	rte_spinlock_lock(&internal->lock);
+
+	if (!rte_atomic32_read(&internal->running) ||
+	    internal->sw_fallback_running) {
+		rte_spinlock_unlock(&internal->lock);
+		return 0;
+	}
+
+	/* stop the direct IO data path */
+	unset_notify_relay(internal);
+	vdpa_ifcvf_stop(internal);
+	vdpa_disable_vfio_intr(internal);
+
+	/* set up interrupt for interrupt relay */
+	ret = vdpa_enable_vfio_intr(internal, true);
+	if (ret)
+		goto error;
+
+	/* config the VF */
+	ret = m_ifcvf_start(internal);
+	if (ret)
+		goto unset_intr;
+
+	/* set up vring relay thread */
+	ret = setup_vring_relay(internal);
+	if (ret)
+		goto stop_vf;
+
+	internal->sw_fallback_running = true;
+	rte_spinlock_unlock(&internal->lock);
+
+	return 0;
+
+stop_vf:
+	m_ifcvf_stop(internal);
+unset_intr:
+	vdpa_disable_vfio_intr(internal);
+error:
+	/* the guest memory stays mapped, it is unmapped on dev_close */
+	DRV_LOG(ERR, "vDPA (%d) software fallback switchover failed.",
+		internal->did);
+	rte_spinlock_unlock(&internal->lock);
+	return -1;
+}
+
 static int
 update_datapath(struct ifcvf_internal *internal)
 {
@@ -497,7 +1075,7 @@ update_datapath(struct ifcvf_internal *internal)
 		if (ret)
 			goto err;
 
-		ret = vdpa_enable_vfio_intr(internal);
+		ret = vdpa_enable_vfio_intr(internal, false);
 		if (ret)
 			goto err;
 
@@ -574,6 +1152,26 @@ ifcvf_dev_close(int vid)
 	}
 
 	internal = list->internal;
+
+	rte_spinlock_lock(&internal->lock);
+	if (internal->sw_fallback_running) {
+		/* unset ring relay */
+		unset_vring_relay(internal);
+
+		/* reset VF */
+		m_ifcvf_stop(internal);
+
+		/* remove interrupt setting */
+		vdpa_disable_vfio_intr(internal);
+
+		/* unset DMA map for guest memory */
+		ifcvf_dma_map(internal, 0);
+
+		internal->sw_fallback_running = false;
+		rte_atomic32_set(&internal->running, 0);
+	}
+	rte_spinlock_unlock(&internal->lock);
+
 	rte_atomic32_set(&internal->dev_attached, 0);
 	update_datapath(internal);
 
@@ -599,13 +1197,72 @@ ifcvf_set_features(int vid)
 	internal = list->internal;
 	rte_vhost_get_negotiated_features(vid, &features);
 
-	if (RTE_VHOST_NEED_LOG(features)) {
-		rte_vhost_get_log_base(vid, &log_base, &log_size);
-		rte_vfio_container_dma_map(internal->vfio_container_fd,
-				log_base, IFCVF_LOG_BASE, log_size);
-		ifcvf_enable_logging(&internal->hw, IFCVF_LOG_BASE, log_size);
+	if (!RTE_VHOST_NEED_LOG(features))
+		return 0;
+
+	if (internal->sw_lm)
+		return ifcvf_sw_fallback_switchover(internal);
+
+	rte_vhost_get_log_base(vid, &log_base, &log_size);
+	rte_vfio_container_dma_map(internal->vfio_container_fd,
+			log_base, IFCVF_LOG_BASE, log_size);
+	ifcvf_enable_logging(&internal->hw, IFCVF_LOG_BASE, log_size);
+
+	return 0;
+}
+
+static int
+ifcvf_set_vring_state(int vid, int vring, int state)
+{
+	int did;
+	struct internal_list *list;
+	struct ifcvf_internal *internal;
+	struct ifcvf_hw *hw;
+
+	did = rte_vhost_get_vdpa_device_id(vid);
+	list = find_internal_resource_by_did(did);
+	if (list == NULL) {
+		DRV_LOG(ERR, "Invalid device id: %d", did);
+		return -1;
+	}
+
+	internal = list->internal;
+	hw = &internal->hw;
+	if (vring < 0 || vring >= internal->max_queues * 2) {
+		DRV_LOG(ERR, "Vring index %d out of range", vring);
+		return -1;
 	}
 
+	rte_spinlock_lock(&internal->lock);
+	if (hw->vring[vring].enable == !!state)
+		goto unlock;
+
+	/*
+	 * The guest changes its number of queue pairs through the control
+	 * queue handled by the front-end, which then enables or disables
+	 * the vrings one by one. Not running, the state gets applied by the
+	 * next start. The mediated rings of the SW fallback keep their state
+	 * until the migration is done, the relay owns their indexes.
+	 */
+	if (!rte_atomic32_read(&internal->running) ||
+	    internal->sw_fallback_running || vring >= hw->nr_vring) {
+		hw->vring[vring].enable = !!state;
+		goto unlock;
+	}
+
+	if (state) {
+		ifcvf_enable_vring_hw(hw, vring);
+	} else {
+		ifcvf_disable_vring_hw(hw, vring);
+		rte_vhost_set_vring_base(vid, vring,
+				hw->vring[vring].last_avail_idx,
+				hw->vring[vring].last_used_idx);
+	}
+	DRV_LOG(INFO, "vid %d vring %d is %s", vid, vring,
+		state ? "enabled" : "disabled");
+
+unlock:
+	rte_spinlock_unlock(&internal->lock);
 	return 0;
 }
 
@@ -673,6 +1330,92 @@ ifcvf_get_notify_area(int vid, int qid, uint64_t *offset, uint64_t *size)
 	return 0;
 }
 
+static int
+ifcvf_get_stats(int did, uint16_t qid, struct rte_vdpa_stats *stats)
+{
+	struct internal_list *list;
+	struct ifcvf_queue_stats *qstats;
+
+	list = find_internal_resource_by_did(did);
+	if (list == NULL) {
+		DRV_LOG(ERR, "Invalid device id: %d", did);
+		return -1;
+	}
+
+	if (qid >= IFCVF_MAX_QUEUES * 2) {
+		DRV_LOG(ERR, "Invalid queue id: %u", qid);
+		return -1;
+	}
+
+	/*
+	 * Completions are only seen by the driver when they are relayed,
+	 * in the direct IO mode the device writes them to the guest alone.
+	 */
+	qstats = &list->internal->stats[qid];
+	memset(stats, 0, sizeof(*stats));
+	stats->packets = qstats->relay_used;
+	stats->errors = qstats->relay_errors;
+	stats->kicks = qstats->kicks;
+
+	return 0;
+}
+
+static int
+ifcvf_get_xstats(int did, uint16_t qid, struct rte_vdpa_xstat_name *names,
+		struct rte_vdpa_xstat *xstats, unsigned int n)
+{
+	struct internal_list *list;
+	struct ifcvf_queue_stats *qstats;
+	unsigned int i;
+
+	list = find_internal_resource_by_did(did);
+	if (list == NULL) {
+		DRV_LOG(ERR, "Invalid device id: %d", did);
+		return -1;
+	}
+
+	if (qid >= IFCVF_MAX_QUEUES * 2) {
+		DRV_LOG(ERR, "Invalid queue id: %u", qid);
+		return -1;
+	}
+
+	if (n < RTE_DIM(ifcvf_xstats))
+		return RTE_DIM(ifcvf_xstats);
+
+	qstats = &list->internal->stats[qid];
+	for (i = 0; i < RTE_DIM(ifcvf_xstats); i++) {
+		strlcpy(names[i].name, ifcvf_xstats[i].name,
+			sizeof(names[i].name));
+		xstats[i].id = i;
+		xstats[i].value = *(uint64_t *)((char *)qstats +
+				ifcvf_xstats[i].offset);
+	}
+
+	return RTE_DIM(ifcvf_xstats);
+}
+
+static int
+ifcvf_reset_stats(int did, uint16_t qid)
+{
+	struct internal_list *list;
+
+	list = find_internal_resource_by_did(did);
+	if (list == NULL) {
+		DRV_LOG(ERR, "Invalid device id: %d", did);
+		return -1;
+	}
+
+	if (qid >= IFCVF_MAX_QUEUES * 2) {
+		DRV_LOG(ERR, "Invalid queue id: %u", qid);
+		return -1;
+	}
+
+	memset(&list->internal->stats[qid], 0,
+	       sizeof(list->internal->stats[qid]));
+
+	return 0;
+}
+
 static int
 ifcvf_get_queue_num(int did, uint32_t *queue_num)
 {
@@ -724,14 +1467,33 @@ static struct rte_vdpa_dev_ops ifcvf_ops = {
 	.get_protocol_features = ifcvf_get_protocol_features,
 	.dev_conf = ifcvf_dev_config,
 	.dev_close = ifcvf_dev_close,
-	.set_vring_state = NULL,
+	.set_vring_state = ifcvf_set_vring_state,
 	.set_features = ifcvf_set_features,
 	.migration_done = NULL,
 	.get_vfio_group_fd = ifcvf_get_vfio_group_fd,
 	.get_vfio_device_fd = ifcvf_get_vfio_device_fd,
 	.get_notify_area = ifcvf_get_notify_area,
+	.get_stats = ifcvf_get_stats,
+	.get_xstats = ifcvf_get_xstats,
+	.reset_stats = ifcvf_reset_stats,
 };
 
+static int
+open_int(const char *key __rte_unused, const char *value, void *extra_args)
+{
+	uint16_t *n = extra_args;
+
+	if (value == NULL || extra_args == NULL)
+		return -EINVAL;
+
+	errno = 0;
+	*n = (uint16_t)strtoul(value, NULL, 0);
+	if (errno)
+		return -1;
+
+	return 0;
+}
+
 static int
 ifcvf_pci_probe(struct rte_pci_driver *pci_drv __rte_unused,
 		struct rte_pci_device *pci_dev)
@@ -739,6 +1501,10 @@ ifcvf_pci_probe(struct rte_pci_driver *pci_drv __rte_unused,
 	uint64_t features;
 	struct ifcvf_internal *internal = NULL;
 	struct internal_list *list = NULL;
+	struct rte_kvargs *kvlist = NULL;
+	uint16_t sw_fallback_lm = 0;
+	uint16_t relay_svc = 0;
+	int i;
 
 	if (rte_eal_process_type() != RTE_PROC_PRIMARY)
 		return 0;
@@ -752,6 +1518,9 @@ ifcvf_pci_probe(struct rte_pci_driver *pci_drv __rte_unused,
 		goto error;
 
 	internal->pdev = pci_dev;
+	internal->epfd = -1;
+	for (i = 0; i < IFCVF_MAX_QUEUES * 2; i++)
+		internal->intr_fd[i] = -1;
 	rte_spinlock_init(&internal->lock);
 	if (ifcvf_vfio_setup(internal) < 0)
 		return -1;
@@ -759,8 +1528,14 @@ ifcvf_pci_probe(struct rte_pci_driver *pci_drv __rte_unused,
 	if (ifcvf_init_hw(&internal->hw, internal->pdev) < 0)
 		return -1;
 
-	internal->max_queues = IFCVF_MAX_QUEUES;
 	features = ifcvf_get_features(&internal->hw);
+	internal->max_queues = 1;
+	if (features & (1ULL << VIRTIO_NET_F_MQ))
+		internal->max_queues = RTE_MIN(IFCVF_MAX_QUEUES,
+			RTE_MAX(internal->hw.dev_cfg->max_virtqueue_pairs, 1));
+	/* vrings are enabled until the front-end says otherwise */
+	for (i = 0; i < IFCVF_MAX_QUEUES * 2; i++)
+		internal->hw.vring[i].enable = 1;
 	internal->features = (features &
 		~(1ULL << VIRTIO_F_IOMMU_PLATFORM)) |
 		(1ULL << VIRTIO_NET_F_GUEST_ANNOUNCE) |
@@ -773,6 +1548,30 @@ ifcvf_pci_probe(struct rte_pci_driver *pci_drv __rte_unused,
 	internal->dev_addr.type = PCI_ADDR;
 	list->internal = internal;
 
+	if (pci_dev->device.devargs) {
+		kvlist = rte_kvargs_parse(pci_dev->device.devargs->args,
+				ifcvf_valid_arguments);
+		if (kvlist == NULL) {
+			DRV_LOG(ERR, "failed to parse device arguments.");
+			goto error;
+		}
+		if (rte_kvargs_count(kvlist, IFCVF_SW_FALLBACK_LM) &&
+		    rte_kvargs_process(kvlist, IFCVF_SW_FALLBACK_LM,
+				       &open_int, &sw_fallback_lm) < 0) {
+			rte_kvargs_free(kvlist);
+			goto error;
+		}
+		if (rte_kvargs_count(kvlist, IFCVF_RELAY_SERVICE) &&
+		    rte_kvargs_process(kvlist, IFCVF_RELAY_SERVICE,
+				       &open_int, &relay_svc) < 0) {
+			rte_kvargs_free(kvlist);
+			goto error;
+		}
+		rte_kvargs_free(kvlist);
+	}
+	internal->sw_lm = sw_fallback_lm;
+	internal->relay_service = relay_svc;
+
 	pthread_mutex_lock(&internal_list_lock);
 	TAILQ_INSERT_TAIL(&internal_list, list, next);
 	pthread_mutex_unlock(&internal_list_lock);
@@ -852,6 +1651,10 @@ static struct rte_pci_driver rte_ifcvf_vdpa = {
 RTE_PMD_REGISTER_PCI(net_ifcvf, rte_ifcvf_vdpa);
 RTE_PMD_REGISTER_PCI_TABLE(net_ifcvf, pci_id_ifcvf_map);
 RTE_PMD_REGISTER_KMOD_DEP(net_ifcvf, "* vfio-pci");
+RTE_PMD_REGISTER_PARAM_STRING(net_ifcvf,
+	IFCVF_VDPA_MODE "=<0|1> "
+	IFCVF_SW_FALLBACK_LM "=<0|1> "
+	IFCVF_RELAY_SERVICE "=<0|1>");
 
 RTE_INIT(ifcvf_vdpa_init_log)
 {
@@ -57,6 +57,12 @@ enum {
 /* Size of per-queue MR cache array for linear search. */
 #define MLX5_MR_CACHE_N 8
 
+/* Size of per-queue direct-mapped MR cache, looked up on linear search miss. */
+#define MLX5_MR_DM_CACHE_N 64
+
+/* Log2 of the size of the address range mapped to a direct-mapped entry. */
+#define MLX5_MR_DM_CACHE_SHIFT 21
+
 /* Size of MR cache table for binary search. */
 #define MLX5_MR_BTREE_CACHE_N 256
 
@@ -139,10 +145,14 @@ enum {
 #define MLX5_MPRQ_TWO_BYTE_SHIFT 0
 
 /*
- * Minimum size of packet to be memcpy'd instead of being attached as an
- * external buffer.
+ * Maximum size of packet to be memcpy'd instead of being attached as an
+ * external buffer. All the packets are attached by default, so that they
+ * are not copied before being handed off, e.g. to vhost.
  */
-#define MLX5_MPRQ_MEMCPY_DEFAULT_LEN 128
+#define MLX5_MPRQ_MEMCPY_DEFAULT_LEN 0
+
+/* Number of mbufs allocated at once by Multi-Packet RQ Rx burst. */
+#define MLX5_MPRQ_MBUF_BULK 32U
 
 /* Minimum number Rx queues to enable Multi-Packet RQ. */
 #define MLX5_MPRQ_MIN_RXQS 12
@@ -0,0 +1,748 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2018 Mellanox Technologies, Ltd
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_malloc.h>
+#include <rte_errno.h>
+
+#include "mlx5_utils.h"
+#include "mlx5_prm.h"
+#include "mlx5_glue.h"
+#include "mlx5_devx_cmds.h"
+
+/**
+ * Allocate a DevX object handle and issue its creation command.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] in
+ *   Command input buffer.
+ * @param[in] inlen
+ *   Size of @p in in bytes.
+ * @param[out] out
+ *   Command output buffer.
+ * @param[in] outlen
+ *   Size of @p out in bytes.
+ * @param[in] name
+ *   Object name used in log messages.
+ *
+ * @return
+ *   Pointer to the DevX object on success, NULL otherwise and rte_errno
+ *   is set.
+ */
+static struct mlx5_devx_obj *
+mlx5_devx_obj_new(struct ibv_context *ctx, const void *in, size_t inlen,
+		  void *out, size_t outlen, const char *name)
+{
+	struct mlx5_devx_obj *obj = rte_zmalloc(name, sizeof(*obj), 0);
+
+	if (!obj) {
+		DRV_LOG(ERR, "cannot allocate %s object memory", name);
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+	obj->obj = mlx5_glue->devx_obj_create(ctx, in, inlen, out, outlen);
+	if (!obj->obj) {
+		rte_errno = errno ? errno : ENODEV;
+		DRV_LOG(ERR, "cannot create %s object using DevX (%d)", name,
+			rte_errno);
+		rte_free(obj);
+		return NULL;
+	}
+	return obj;
+}
+
+/**
+ * Destroy any object allocated by a DevX API.
+ *
+ * @param[in] obj
+ *   Pointer to a general object.
+ *
+ * @return
+ *   0 on success, a negative value otherwise.
+ */
+int
+mlx5_devx_cmd_destroy(struct mlx5_devx_obj *obj)
+{
+	int ret;
+
+	if (!obj)
+		return 0;
+	ret = mlx5_glue->devx_obj_destroy(obj->obj);
+	rte_free(obj);
+	return ret;
+}
+
+/**
+ * Query HCA attributes, including the vDPA emulation capabilities.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[out] attr
+ *   Attributes device values.
+ *
+ * @return
+ *   0 on success, a negative value otherwise.
+ */
+int
+mlx5_devx_cmd_query_hca_attr(struct ibv_context *ctx,
+			     struct mlx5_hca_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(query_hca_cap_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(query_hca_cap_out)] = {0};
+	void *hcattr;
+	int status, syndrome, rc;
+
+	memset(attr, 0, sizeof(*attr));
+	MLX5_SET(query_hca_cap_in, in, opcode, MLX5_CMD_OP_QUERY_HCA_CAP);
+	MLX5_SET(query_hca_cap_in, in, op_mod,
+		 MLX5_GET_HCA_CAP_OP_MOD_GENERAL_DEVICE);
+	rc = mlx5_glue->devx_general_cmd(ctx, in, sizeof(in), out, sizeof(out));
+	if (rc)
+		goto error;
+	status = MLX5_GET(query_hca_cap_out, out, status);
+	syndrome = MLX5_GET(query_hca_cap_out, out, syndrome);
+	if (status) {
+		DRV_LOG(DEBUG, "failed to query devx HCA capabilities,"
+			" status %x, syndrome = %x", status, syndrome);
+		return -1;
+	}
+	hcattr = MLX5_ADDR_OF(query_hca_cap_out, out, capability);
+	attr->vhca_id = MLX5_GET(cmd_hca_cap, hcattr, vhca_id);
+	attr->log_max_klm_list_size = MLX5_GET(cmd_hca_cap, hcattr,
+					       log_max_klm_list_size);
+	attr->general_obj_types = MLX5_GET64(cmd_hca_cap, hcattr,
+					     general_obj_types);
+	if (!(attr->general_obj_types &
+	      MLX5_GENERAL_OBJ_TYPES_CAP_VIRTQ_NET_Q))
+		return 0;
+	memset(out, 0, sizeof(out));
+	MLX5_SET(query_hca_cap_in, in, op_mod,
+		 MLX5_GET_HCA_CAP_OP_MOD_VDPA_EMULATION);
+	rc = mlx5_glue->devx_general_cmd(ctx, in, sizeof(in), out, sizeof(out));
+	if (rc)
+		goto error;
+	status = MLX5_GET(query_hca_cap_out, out, status);
+	syndrome = MLX5_GET(query_hca_cap_out, out, syndrome);
+	if (status) {
+		DRV_LOG(DEBUG, "failed to query devx vDPA capabilities,"
+			" status %x, syndrome = %x", status, syndrome);
+		return -1;
+	}
+	hcattr = MLX5_ADDR_OF(query_hca_cap_out, out, capability);
+	attr->vdpa.valid = 1;
+	attr->vdpa.desc_tunnel_offload_type =
+		MLX5_GET(virtio_emulation_cap, hcattr,
+			 desc_tunnel_offload_type);
+	attr->vdpa.eth_frame_offload_type =
+		MLX5_GET(virtio_emulation_cap, hcattr, eth_frame_offload_type);
+	attr->vdpa.virtio_version_1_0 =
+		MLX5_GET(virtio_emulation_cap, hcattr, virtio_version_1_0);
+	attr->vdpa.tso_ipv4 = MLX5_GET(virtio_emulation_cap, hcattr, tso_ipv4);
+	attr->vdpa.tso_ipv6 = MLX5_GET(virtio_emulation_cap, hcattr, tso_ipv6);
+	attr->vdpa.tx_csum = MLX5_GET(virtio_emulation_cap, hcattr, tx_csum);
+	attr->vdpa.rx_csum = MLX5_GET(virtio_emulation_cap, hcattr, rx_csum);
+	attr->vdpa.event_mode = MLX5_GET(virtio_emulation_cap, hcattr,
+					 event_mode);
+	attr->vdpa.virtq_type = MLX5_GET(virtio_emulation_cap, hcattr,
+					 virtio_queue_type);
+	attr->vdpa.log_doorbell_stride =
+		MLX5_GET(virtio_emulation_cap, hcattr, log_doorbell_stride);
+	attr->vdpa.log_doorbell_bar_size =
+		MLX5_GET(virtio_emulation_cap, hcattr, log_doorbell_bar_size);
+	attr->vdpa.doorbell_bar_offset =
+		MLX5_GET64(virtio_emulation_cap, hcattr, doorbell_bar_offset);
+	attr->vdpa.max_num_virtio_queues =
+		MLX5_GET(virtio_emulation_cap, hcattr, max_num_virtio_queues);
+	attr->vdpa.umem_1_buffer_param_a =
+		MLX5_GET(virtio_emulation_cap, hcattr, umem_1_buffer_param_a);
+	attr->vdpa.umem_1_buffer_param_b =
+		MLX5_GET(virtio_emulation_cap, hcattr, umem_1_buffer_param_b);
+	attr->vdpa.umem_2_buffer_param_a =
+		MLX5_GET(virtio_emulation_cap, hcattr, umem_2_buffer_param_a);
+	attr->vdpa.umem_2_buffer_param_b =
+		MLX5_GET(virtio_emulation_cap, hcattr, umem_2_buffer_param_b);
+	attr->vdpa.umem_3_buffer_param_a =
+		MLX5_GET(virtio_emulation_cap, hcattr, umem_3_buffer_param_a);
+	attr->vdpa.umem_3_buffer_param_b =
+		MLX5_GET(virtio_emulation_cap, hcattr, umem_3_buffer_param_b);
+	return 0;
+error:
+	rc = (rc > 0) ? -rc : rc;
+	return rc;
+}
+
+/**
+ * Create a memory key, either a direct one covering a registered umem or
+ * an indirect one built from a KLM list of other memory keys.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] attr
+ *   Attributes of the requested mkey.
+ *
+ * @return
+ *   Pointer to the DevX mkey object on success, NULL otherwise and
+ *   rte_errno is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_mkey_create(struct ibv_context *ctx,
+			  struct mlx5_devx_mkey_attr *attr)
+{
+	struct mlx5_klm *klm_array = attr->klm_array;
+	int klm_num = attr->klm_num;
+	int in_size_dw = MLX5_ST_SZ_DW(create_mkey_in) +
+		     (klm_num ? RTE_ALIGN(klm_num, 4) : 0) * MLX5_ST_SZ_DW(klm);
+	uint32_t in[in_size_dw];
+	uint32_t out[MLX5_ST_SZ_DW(create_mkey_out)] = {0};
+	struct mlx5_devx_obj *mkey;
+	void *mkc;
+	size_t pgsize = sysconf(_SC_PAGESIZE);
+	uint32_t translation_size;
+	int i;
+
+	memset(in, 0, in_size_dw * 4);
+	MLX5_SET(create_mkey_in, in, opcode, MLX5_CMD_OP_CREATE_MKEY);
+	mkc = MLX5_ADDR_OF(create_mkey_in, in, memory_key_mkey_entry);
+	if (klm_num > 0) {
+		uint8_t *klm = (uint8_t *)MLX5_ADDR_OF(create_mkey_in, in,
+						       klm_pas_mtt);
+
+		translation_size = RTE_ALIGN(klm_num, 4);
+		for (i = 0; i < klm_num; i++) {
+			MLX5_SET(klm, klm, byte_count, klm_array[i].byte_count);
+			MLX5_SET(klm, klm, mkey, klm_array[i].mkey);
+			MLX5_SET64(klm, klm, address, klm_array[i].address);
+			klm += MLX5_ST_SZ_DB(klm);
+		}
+		/* Pad the KLM list with null entries. */
+		for (; i < (int)translation_size; i++) {
+			MLX5_SET(klm, klm, mkey, 0);
+			klm += MLX5_ST_SZ_DB(klm);
+		}
+		MLX5_SET(mkc, mkc, access_mode_1_0, MLX5_MKC_ACCESS_MODE_KLM);
+		MLX5_SET(mkc, mkc, log_page_size, attr->log_entity_size);
+	} else {
+		translation_size = (RTE_ALIGN(attr->size, pgsize) * 8) / 16;
+		MLX5_SET(mkc, mkc, access_mode_1_0, MLX5_MKC_ACCESS_MODE_MTT);
+		MLX5_SET(mkc, mkc, log_page_size, rte_log2_u32(pgsize));
+		MLX5_SET(create_mkey_in, in, mkey_umem_valid, 1);
+		MLX5_SET(create_mkey_in, in, mkey_umem_id, attr->umem_id);
+	}
+	MLX5_SET(create_mkey_in, in, translations_octword_actual_size,
+		 translation_size);
+	MLX5_SET(mkc, mkc, translations_octword_size, translation_size);
+	MLX5_SET(mkc, mkc, lw, 0x1);
+	MLX5_SET(mkc, mkc, lr, 0x1);
+	MLX5_SET(mkc, mkc, qpn, 0xffffff);
+	MLX5_SET(mkc, mkc, pd, attr->pd);
+	MLX5_SET(mkc, mkc, mkey_7_0, attr->umem_id & 0xFF);
+	MLX5_SET64(mkc, mkc, start_addr, attr->addr);
+	MLX5_SET64(mkc, mkc, len, attr->size);
+	mkey = mlx5_devx_obj_new(ctx, in, in_size_dw * 4, out, sizeof(out),
+				 "mkey");
+	if (!mkey)
+		return NULL;
+	mkey->id = MLX5_GET(create_mkey_out, out, mkey_index);
+	mkey->id = (mkey->id << 8) | (attr->umem_id & 0xFF);
+	return mkey;
+}
+
+/**
+ * Create a completion queue using DevX, buffers are provided as umems.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] attr
+ *   Attributes of the requested CQ.
+ *
+ * @return
+ *   Pointer to the DevX CQ object on success, NULL otherwise and rte_errno
+ *   is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_create_cq(struct ibv_context *ctx, struct mlx5_devx_cq_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(create_cq_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(create_cq_out)] = {0};
+	struct mlx5_devx_obj *cq;
+	void *cqctx = MLX5_ADDR_OF(create_cq_in, in, cq_context);
+
+	MLX5_SET(create_cq_in, in, opcode, MLX5_CMD_OP_CREATE_CQ);
+	MLX5_SET(cqc, cqctx, cqe_sz, MLX5_CQE_SIZE_64B);
+	MLX5_SET(cqc, cqctx, log_cq_size, attr->log_cq_size);
+	MLX5_SET(cqc, cqctx, log_page_size, attr->log_page_size -
+		 MLX5_ADAPTER_PAGE_SHIFT);
+	MLX5_SET(cqc, cqctx, c_eqn, attr->eqn);
+	MLX5_SET(cqc, cqctx, uar_page, attr->uar_page_id);
+	MLX5_SET(cqc, cqctx, cq_period, attr->cq_period);
+	MLX5_SET(cqc, cqctx, cq_max_count, attr->cq_max_count);
+	if (attr->q_umem_valid) {
+		MLX5_SET(create_cq_in, in, cq_umem_valid, attr->q_umem_valid);
+		MLX5_SET(create_cq_in, in, cq_umem_id, attr->q_umem_id);
+		MLX5_SET64(create_cq_in, in, cq_umem_offset,
+			   attr->q_umem_offset);
+	}
+	if (attr->db_umem_valid) {
+		MLX5_SET(cqc, cqctx, dbr_umem_valid, attr->db_umem_valid);
+		MLX5_SET(cqc, cqctx, dbr_umem_id, attr->db_umem_id);
+		MLX5_SET64(cqc, cqctx, dbr_addr, attr->db_umem_offset);
+	}
+	cq = mlx5_devx_obj_new(ctx, in, sizeof(in), out, sizeof(out), "cq");
+	if (!cq)
+		return NULL;
+	cq->id = MLX5_GET(create_cq_out, out, cqn);
+	return cq;
+}
+
+/**
+ * Create a RC queue pair using DevX. A QP without RQ and SQ sizes is a
+ * firmware side QP whose buffers are managed by the device itself.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] attr
+ *   Attributes of the requested QP.
+ *
+ * @return
+ *   Pointer to the DevX QP object on success, NULL otherwise and rte_errno
+ *   is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_create_qp(struct ibv_context *ctx, struct mlx5_devx_qp_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(create_qp_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(create_qp_out)] = {0};
+	struct mlx5_devx_obj *qp;
+	void *qpc = MLX5_ADDR_OF(create_qp_in, in, qpc);
+
+	MLX5_SET(create_qp_in, in, opcode, MLX5_CMD_OP_CREATE_QP);
+	MLX5_SET(qpc, qpc, st, MLX5_QP_ST_RC);
+	MLX5_SET(qpc, qpc, pd, attr->pd);
+	if (attr->uar_index) {
+		MLX5_SET(qpc, qpc, pm_state, MLX5_QP_PM_MIGRATED);
+		MLX5_SET(qpc, qpc, uar_page, attr->uar_index);
+		MLX5_SET(qpc, qpc, log_page_size, attr->log_page_size -
+			 MLX5_ADAPTER_PAGE_SHIFT);
+		if (attr->sq_size) {
+			assert(rte_is_power_of_2(attr->sq_size));
+			MLX5_SET(qpc, qpc, cqn_snd, attr->cqn);
+			MLX5_SET(qpc, qpc, log_sq_size,
+				 rte_log2_u32(attr->sq_size));
+		} else {
+			MLX5_SET(qpc, qpc, no_sq, 1);
+		}
+		if (attr->rq_size) {
+			assert(rte_is_power_of_2(attr->rq_size));
+			MLX5_SET(qpc, qpc, cqn_rcv, attr->cqn);
+			MLX5_SET(qpc, qpc, log_rq_stride, attr->log_rq_stride -
+				 MLX5_LOG_RQ_STRIDE_SHIFT);
+			MLX5_SET(qpc, qpc, log_rq_size,
+				 rte_log2_u32(attr->rq_size));
+			MLX5_SET(qpc, qpc, rq_type, MLX5_NON_ZERO_RQ);
+		} else {
+			MLX5_SET(qpc, qpc, rq_type, MLX5_ZERO_LEN_RQ);
+		}
+		if (attr->dbr_umem_valid) {
+			MLX5_SET(qpc, qpc, dbr_umem_valid,
+				 attr->dbr_umem_valid);
+			MLX5_SET(qpc, qpc, dbr_umem_id, attr->dbr_umem_id);
+		}
+		MLX5_SET64(qpc, qpc, dbr_addr, attr->dbr_address);
+		MLX5_SET64(create_qp_in, in, wq_umem_offset,
+			   attr->wq_umem_offset);
+		MLX5_SET(create_qp_in, in, wq_umem_id, attr->wq_umem_id);
+		MLX5_SET(create_qp_in, in, wq_umem_valid, 1);
+	} else {
+		/* Special QP to be managed by FW - no SQ\RQ\CQ\UAR\DB rec. */
+		MLX5_SET(qpc, qpc, rq_type, MLX5_ZERO_LEN_RQ);
+		MLX5_SET(qpc, qpc, no_sq, 1);
+	}
+	qp = mlx5_devx_obj_new(ctx, in, sizeof(in), out, sizeof(out), "qp");
+	if (!qp)
+		return NULL;
+	qp->id = MLX5_GET(create_qp_out, out, qpn);
+	return qp;
+}
+
+/**
+ * Modify the state of a QP created by DevX, connecting it to a remote QP
+ * on the same device.
+ *
+ * @param[in] qp
+ *   Pointer to the QP to modify.
+ * @param[in] qp_st_mod_op
+ *   The QP state modification operation (MLX5_CMD_OP_*2*_QP).
+ * @param[in] remote_qp_id
+ *   The remote QP ID for MLX5_CMD_OP_INIT2RTR_QP operation.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_devx_cmd_modify_qp_state(struct mlx5_devx_obj *qp, uint32_t qp_st_mod_op,
+			      uint32_t remote_qp_id)
+{
+	uint32_t in[MLX5_ST_SZ_DW(qp_2_state_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(qp_2_state_out)] = {0};
+	void *qpc = MLX5_ADDR_OF(qp_2_state_in, in, qpc);
+	int ret;
+
+	MLX5_SET(qp_2_state_in, in, opcode, qp_st_mod_op);
+	MLX5_SET(qp_2_state_in, in, qpn, qp->id);
+	switch (qp_st_mod_op) {
+	case MLX5_CMD_OP_RST2INIT_QP:
+		MLX5_SET(qpc, qpc, primary_address_path.vhca_port_num, 1);
+		MLX5_SET(qpc, qpc, rre, 1);
+		MLX5_SET(qpc, qpc, rwe, 1);
+		MLX5_SET(qpc, qpc, pm_state, MLX5_QP_PM_MIGRATED);
+		break;
+	case MLX5_CMD_OP_INIT2RTR_QP:
+		MLX5_SET(qpc, qpc, mtu, 1);
+		MLX5_SET(qpc, qpc, log_msg_max, 30);
+		MLX5_SET(qpc, qpc, remote_qpn, remote_qp_id);
+		MLX5_SET(qpc, qpc, min_rnr_nak, 0);
+		break;
+	case MLX5_CMD_OP_RTR2RTS_QP:
+		MLX5_SET(qpc, qpc, primary_address_path.ack_timeout, 14);
+		MLX5_SET(qpc, qpc, log_ack_req_freq, 0);
+		MLX5_SET(qpc, qpc, retry_count, 7);
+		MLX5_SET(qpc, qpc, rnr_retry, 7);
+		break;
+	default:
+		DRV_LOG(ERR, "invalid QP state modification operation %u",
+			qp_st_mod_op);
+		rte_errno = EINVAL;
+		return -rte_errno;
+	}
+	ret = mlx5_glue->devx_obj_modify(qp->obj, in, sizeof(in), out,
+					 sizeof(out));
+	if (ret) {
+		DRV_LOG(ERR, "failed to modify QP %d state by DevX", qp->id);
+		rte_errno = errno ? errno : EINVAL;
+		return -rte_errno;
+	}
+	return 0;
+}
+
+/**
+ * Allocate a transport domain.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ *
+ * @return
+ *   Pointer to the DevX TD object on success, NULL otherwise and rte_errno
+ *   is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_create_td(struct ibv_context *ctx)
+{
+	uint32_t in[MLX5_ST_SZ_DW(alloc_transport_domain_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(alloc_transport_domain_out)] = {0};
+	struct mlx5_devx_obj *td;
+
+	MLX5_SET(alloc_transport_domain_in, in, opcode,
+		 MLX5_CMD_OP_ALLOC_TRANSPORT_DOMAIN);
+	td = mlx5_devx_obj_new(ctx, in, sizeof(in), out, sizeof(out), "td");
+	if (!td)
+		return NULL;
+	td->id = MLX5_GET(alloc_transport_domain_out, out, transport_domain);
+	return td;
+}
+
+/**
+ * Create a transport interface send object.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] attr
+ *   Attributes of the requested TIS.
+ *
+ * @return
+ *   Pointer to the DevX TIS object on success, NULL otherwise and
+ *   rte_errno is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_create_tis(struct ibv_context *ctx,
+			 struct mlx5_devx_tis_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(create_tis_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(create_tis_out)] = {0};
+	struct mlx5_devx_obj *tis;
+	void *tis_ctx = MLX5_ADDR_OF(create_tis_in, in, ctx);
+
+	MLX5_SET(create_tis_in, in, opcode, MLX5_CMD_OP_CREATE_TIS);
+	MLX5_SET(tisc, tis_ctx, transport_domain, attr->transport_domain);
+	tis = mlx5_devx_obj_new(ctx, in, sizeof(in), out, sizeof(out), "tis");
+	if (!tis)
+		return NULL;
+	tis->id = MLX5_GET(create_tis_out, out, tisn);
+	return tis;
+}
+
+/**
+ * Create a receive queue table.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] attr
+ *   Attributes of the requested RQT, rq_list holds the virtq object IDs.
+ *
+ * @return
+ *   Pointer to the DevX RQT object on success, NULL otherwise and
+ *   rte_errno is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_create_rqt(struct ibv_context *ctx,
+			 struct mlx5_devx_rqt_attr *attr)
+{
+	size_t inlen = MLX5_ST_SZ_BYTES(create_rqt_in) +
+		       attr->rqt_actual_size * sizeof(uint32_t);
+	uint32_t out[MLX5_ST_SZ_DW(create_rqt_out)] = {0};
+	uint32_t *in = rte_zmalloc(__func__, inlen, 0);
+	struct mlx5_devx_obj *rqt;
+	void *rqt_ctx;
+	unsigned int i;
+
+	if (!in) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+	MLX5_SET(create_rqt_in, in, opcode, MLX5_CMD_OP_CREATE_RQT);
+	rqt_ctx = MLX5_ADDR_OF(create_rqt_in, in, rqt_context);
+	MLX5_SET(rqtc, rqt_ctx, rqt_max_size, attr->rqt_max_size);
+	MLX5_SET(rqtc, rqt_ctx, rqt_actual_size, attr->rqt_actual_size);
+	for (i = 0; i < attr->rqt_actual_size; i++)
+		MLX5_SET(rqtc, rqt_ctx, rq_num[i], attr->rq_list[i]);
+	rqt = mlx5_devx_obj_new(ctx, in, inlen, out, sizeof(out), "rqt");
+	rte_free(in);
+	if (!rqt)
+		return NULL;
+	rqt->id = MLX5_GET(create_rqt_out, out, rqtn);
+	return rqt;
+}
+
+/**
+ * Create an indirect transport interface receive object hashing over an
+ * RQT.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] attr
+ *   Attributes of the requested TIR.
+ *
+ * @return
+ *   Pointer to the DevX TIR object on success, NULL otherwise and
+ *   rte_errno is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_create_tir(struct ibv_context *ctx,
+			 struct mlx5_devx_tir_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(create_tir_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(create_tir_out)] = {0};
+	struct mlx5_devx_obj *tir;
+	void *tir_ctx = MLX5_ADDR_OF(create_tir_in, in, ctx);
+	void *outer = MLX5_ADDR_OF(tirc, tir_ctx,
+				   rx_hash_field_selector_outer);
+
+	MLX5_SET(create_tir_in, in, opcode, MLX5_CMD_OP_CREATE_TIR);
+	MLX5_SET(tirc, tir_ctx, disp_type, MLX5_TIRC_DISP_TYPE_INDIRECT);
+	MLX5_SET(tirc, tir_ctx, indirect_table, attr->indirect_table);
+	MLX5_SET(tirc, tir_ctx, transport_domain, attr->transport_domain);
+	MLX5_SET(tirc, tir_ctx, rx_hash_fn, MLX5_RX_HASH_FN_TOEPLITZ);
+	MLX5_SET(tirc, tir_ctx, rx_hash_symmetric, 1);
+	memcpy(MLX5_ADDR_OF(tirc, tir_ctx, rx_hash_toeplitz_key),
+	       attr->rx_hash_toeplitz_key, MLX5_RSS_HASH_KEY_LEN);
+	MLX5_SET(rx_hash_field_select, outer, l3_prot_type,
+		 attr->l3_prot_type);
+	MLX5_SET(rx_hash_field_select, outer, l4_prot_type,
+		 attr->l4_prot_type);
+	MLX5_SET(rx_hash_field_select, outer, selected_fields,
+		 attr->selected_fields);
+	tir = mlx5_devx_obj_new(ctx, in, sizeof(in), out, sizeof(out), "tir");
+	if (!tir)
+		return NULL;
+	tir->id = MLX5_GET(create_tir_out, out, tirn);
+	return tir;
+}
+
+/**
+ * Create a virtio net queue object.
+ *
+ * @param[in] ctx
+ *   ibv contexts returned from mlx5dv_open_device.
+ * @param[in] attr
+ *   Attributes of the requested virtq.
+ *
+ * @return
+ *   Pointer to the DevX virtq object on success, NULL otherwise and
+ *   rte_errno is set.
+ */
+struct mlx5_devx_obj *
+mlx5_devx_cmd_create_virtq(struct ibv_context *ctx,
+			   struct mlx5_devx_virtq_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(create_virtq_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(general_obj_out_cmd_hdr)] = {0};
+	struct mlx5_devx_obj *virtq;
+	void *virtctx = MLX5_ADDR_OF(create_virtq_in, in, virtq);
+	void *hdr = MLX5_ADDR_OF(create_virtq_in, in, hdr);
+	void *virtq_ctx = MLX5_ADDR_OF(virtio_net_q, virtctx,
+				       virtio_q_context);
+
+	MLX5_SET(general_obj_in_cmd_hdr, hdr, opcode,
+		 MLX5_CMD_OP_CREATE_GENERAL_OBJECT);
+	MLX5_SET(general_obj_in_cmd_hdr, hdr, obj_type,
+		 MLX5_GENERAL_OBJ_TYPE_VIRTQ);
+	MLX5_SET16(virtio_net_q, virtctx, hw_available_index,
+		   attr->hw_available_index);
+	MLX5_SET16(virtio_net_q, virtctx, hw_used_index, attr->hw_used_index);
+	MLX5_SET16(virtio_net_q, virtctx, tso_ipv4, attr->tso_ipv4);
+	MLX5_SET16(virtio_net_q, virtctx, tso_ipv6, attr->tso_ipv6);
+	MLX5_SET16(virtio_net_q, virtctx, tx_csum, attr->tx_csum);
+	MLX5_SET16(virtio_net_q, virtctx, rx_csum, attr->rx_csum);
+	MLX5_SET(virtio_net_q, virtctx, tisn_or_qpn, attr->tis_id);
+	MLX5_SET(virtio_q, virtq_ctx, virtio_version_1_0,
+		 attr->virtio_version_1_0);
+	MLX5_SET(virtio_q, virtq_ctx, event_mode, attr->event_mode);
+	MLX5_SET(virtio_q, virtq_ctx, event_qpn_or_msix, attr->qp_id);
+	MLX5_SET(virtio_q, virtq_ctx, offload_type,
+		 MLX5_VIRTQ_OFFLOAD_TYPE_ETH_FRAME);
+	MLX5_SET64(virtio_q, virtq_ctx, desc_addr, attr->desc_addr);
+	MLX5_SET64(virtio_q, virtq_ctx, used_addr, attr->used_addr);
+	MLX5_SET64(virtio_q, virtq_ctx, available_addr, attr->available_addr);
+	MLX5_SET16(virtio_q, virtq_ctx, queue_index, attr->queue_index);
+	MLX5_SET16(virtio_q, virtq_ctx, queue_size, attr->queue_size);
+	MLX5_SET16(virtio_q, virtq_ctx, virtio_q_type, attr->type);
+	MLX5_SET16(virtio_q, virtq_ctx, doorbell_stride_index,
+		   attr->doorbell_stride_index);
+	MLX5_SET(virtio_q, virtq_ctx, virtio_q_mkey, attr->mkey);
+	MLX5_SET(virtio_q, virtq_ctx, umem_1_id, attr->umems[0].id);
+	MLX5_SET(virtio_q, virtq_ctx, umem_1_size, attr->umems[0].size);
+	MLX5_SET64(virtio_q, virtq_ctx, umem_1_offset, attr->umems[0].offset);
+	MLX5_SET(virtio_q, virtq_ctx, umem_2_id, attr->umems[1].id);
+	MLX5_SET(virtio_q, virtq_ctx, umem_2_size, attr->umems[1].size);
+	MLX5_SET64(virtio_q, virtq_ctx, umem_2_offset, attr->umems[1].offset);
+	MLX5_SET(virtio_q, virtq_ctx, umem_3_id, attr->umems[2].id);
+	MLX5_SET(virtio_q, virtq_ctx, umem_3_size, attr->umems[2].size);
+	MLX5_SET64(virtio_q, virtq_ctx, umem_3_offset, attr->umems[2].offset);
+	virtq = mlx5_devx_obj_new(ctx, in, sizeof(in), out, sizeof(out),
+				  "virtq");
+	if (!virtq)
+		return NULL;
+	virtq->id = MLX5_GET(general_obj_out_cmd_hdr, out, obj_id);
+	return virtq;
+}
+
+/**
+ * Modify a virtio net queue object, the fields to change are selected by
+ * attr->type (MLX5_VIRTQ_MODIFY_TYPE_*).
+ *
+ * @param[in] virtq_obj
+ *   Pointer to the virtq object to modify.
+ * @param[in] attr
+ *   New attributes of the virtq.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_devx_cmd_modify_virtq(struct mlx5_devx_obj *virtq_obj,
+			   struct mlx5_devx_virtq_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(create_virtq_in)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(general_obj_out_cmd_hdr)] = {0};
+	void *virtq = MLX5_ADDR_OF(create_virtq_in, in, virtq);
+	void *hdr = MLX5_ADDR_OF(create_virtq_in, in, hdr);
+	int ret;
+
+	MLX5_SET(general_obj_in_cmd_hdr, hdr, opcode,
+		 MLX5_CMD_OP_MODIFY_GENERAL_OBJECT);
+	MLX5_SET(general_obj_in_cmd_hdr, hdr, obj_type,
+		 MLX5_GENERAL_OBJ_TYPE_VIRTQ);
+	MLX5_SET(general_obj_in_cmd_hdr, hdr, obj_id, virtq_obj->id);
+	MLX5_SET64(virtio_net_q, virtq, modify_field_select, attr->type);
+	switch (attr->type) {
+	case MLX5_VIRTQ_MODIFY_TYPE_STATE:
+		MLX5_SET16(virtio_net_q, virtq, state, attr->state);
+		break;
+	case MLX5_VIRTQ_MODIFY_TYPE_DIRTY_BITMAP_PARAMS:
+		MLX5_SET(virtio_net_q, virtq, dirty_bitmap_mkey,
+			 attr->dirty_bitmap_mkey);
+		MLX5_SET64(virtio_net_q, virtq, dirty_bitmap_addr,
+			   attr->dirty_bitmap_addr);
+		MLX5_SET(virtio_net_q, virtq, dirty_bitmap_size,
+			 attr->dirty_bitmap_size);
+		MLX5_SET16(virtio_net_q, virtq, vhost_log_page,
+			   attr->log_page_size);
+		break;
+	case MLX5_VIRTQ_MODIFY_TYPE_DIRTY_BITMAP_DUMP_ENABLE:
+		MLX5_SET(virtio_net_q, virtq, dirty_bitmap_dump_enable,
+			 attr->dirty_bitmap_dump_enable);
+		break;
+	case MLX5_VIRTQ_MODIFY_TYPE_Q_MKEY:
+		MLX5_SET(virtio_q, MLX5_ADDR_OF(virtio_net_q, virtq,
+						virtio_q_context),
+			 virtio_q_mkey, attr->mkey);
+		break;
+	default:
+		rte_errno = EINVAL;
+		return -rte_errno;
+	}
+	ret = mlx5_glue->devx_obj_modify(virtq_obj->obj, in, sizeof(in),
+					 out, sizeof(out));
+	if (ret) {
+		DRV_LOG(ERR, "failed to modify virtq %d by DevX",
+			virtq_obj->id);
+		rte_errno = errno ? errno : EINVAL;
+		return -rte_errno;
+	}
+	return 0;
+}
+
+/**
+ * Query the ring indexes and state of a virtio net queue object.
+ *
+ * @param[in] virtq_obj
+ *   Pointer to the virtq object to query.
+ * @param[out] attr
+ *   Filled with the hardware available and used indexes and the state.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_devx_cmd_query_virtq(struct mlx5_devx_obj *virtq_obj,
+			  struct mlx5_devx_virtq_attr *attr)
+{
+	uint32_t in[MLX5_ST_SZ_DW(general_obj_in_cmd_hdr)] = {0};
+	uint32_t out[MLX5_ST_SZ_DW(query_virtq_out)] = {0};
+	void *virtq = MLX5_ADDR_OF(query_virtq_out, out, virtq);
+	int ret;
+
+	MLX5_SET(general_obj_in_cmd_hdr, in, opcode,
+		 MLX5_CMD_OP_QUERY_GENERAL_OBJECT);
+	MLX5_SET(general_obj_in_cmd_hdr, in, obj_type,
+		 MLX5_GENERAL_OBJ_TYPE_VIRTQ);
+	MLX5_SET(general_obj_in_cmd_hdr, in, obj_id, virtq_obj->id);
+	ret = mlx5_glue->devx_obj_query(virtq_obj->obj, in, sizeof(in),
+					out, sizeof(out));
+	if (ret) {
+		DRV_LOG(ERR, "failed to query virtq %d by DevX",
+			virtq_obj->id);
+		rte_errno = errno ? errno : EINVAL;
+		return -rte_errno;
+	}
+	attr->hw_available_index = MLX5_GET16(virtio_net_q, virtq,
+					      hw_available_index);
+	attr->hw_used_index = MLX5_GET16(virtio_net_q, virtq, hw_used_index);
+	attr->state = MLX5_GET16(virtio_net_q, virtq, state);
+	return 0;
+}
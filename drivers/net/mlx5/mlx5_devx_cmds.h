@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2018 Mellanox Technologies, Ltd
+ */
+
+#ifndef RTE_PMD_MLX5_DEVX_CMDS_H_
+#define RTE_PMD_MLX5_DEVX_CMDS_H_
+
+#include <stdint.h>
+
+#include "mlx5_glue.h"
+#include "mlx5_prm.h"
+
+/* DevX object handle, id is the object number returned by firmware. */
+struct mlx5_devx_obj {
+	struct mlx5dv_devx_obj *obj; /* The DV object. */
+	int id; /* The object ID. */
+};
+
+/* vDPA emulation capabilities. */
+struct mlx5_hca_vdpa_attr {
+	uint8_t virtq_type; /* Bitmask of MLX5_VIRTQ_TYPE_*. */
+	uint32_t valid:1;
+	uint32_t desc_tunnel_offload_type:1;
+	uint32_t eth_frame_offload_type:1;
+	uint32_t virtio_version_1_0:1;
+	uint32_t tso_ipv4:1;
+	uint32_t tso_ipv6:1;
+	uint32_t tx_csum:1;
+	uint32_t rx_csum:1;
+	uint32_t event_mode:3;
+	uint32_t log_doorbell_stride:5;
+	uint32_t log_doorbell_bar_size:5;
+	uint32_t max_num_virtio_queues;
+	uint32_t umem_1_buffer_param_a;
+	uint32_t umem_1_buffer_param_b;
+	uint32_t umem_2_buffer_param_a;
+	uint32_t umem_2_buffer_param_b;
+	uint32_t umem_3_buffer_param_a;
+	uint32_t umem_3_buffer_param_b;
+	uint64_t doorbell_bar_offset;
+};
+
+/* HCA attributes. */
+struct mlx5_hca_attr {
+	uint16_t vhca_id;
+	uint8_t log_max_klm_list_size;
+	uint64_t general_obj_types;
+	struct mlx5_hca_vdpa_attr vdpa;
+};
+
+struct mlx5_klm {
+	uint32_t byte_count;
+	uint32_t mkey;
+	uint64_t address;
+};
+
+/* Memory key attributes, either direct over a umem or indirect (KLM). */
+struct mlx5_devx_mkey_attr {
+	uint64_t addr;
+	uint64_t size;
+	uint32_t umem_id;
+	uint32_t pd;
+	uint32_t log_entity_size;
+	uint32_t klm_num;
+	struct mlx5_klm *klm_array;
+};
+
+struct mlx5_devx_cq_attr {
+	uint32_t q_umem_valid:1;
+	uint32_t db_umem_valid:1;
+	uint32_t log_cq_size:5;
+	uint32_t log_page_size:5;
+	uint32_t uar_page_id;
+	uint32_t q_umem_id;
+	uint64_t q_umem_offset;
+	uint32_t db_umem_id;
+	uint64_t db_umem_offset;
+	uint32_t eqn;
+	uint16_t cq_period; /* Moderation period in usec, 0 to disable. */
+	uint16_t cq_max_count; /* Moderation count, 0 to disable. */
+};
+
+struct mlx5_devx_qp_attr {
+	uint32_t pd:24;
+	uint32_t uar_index:24;
+	uint32_t cqn:24;
+	uint32_t log_page_size:5;
+	uint32_t rq_size:17; /* Must be a power of 2. */
+	uint32_t log_rq_stride:3;
+	uint32_t sq_size:17; /* Must be a power of 2. */
+	uint32_t dbr_umem_valid:1;
+	uint32_t dbr_umem_id;
+	uint64_t dbr_address;
+	uint32_t wq_umem_id;
+	uint64_t wq_umem_offset;
+};
+
+struct mlx5_devx_tis_attr {
+	uint32_t transport_domain:24;
+};
+
+struct mlx5_devx_rqt_attr {
+	uint32_t rqt_max_size:16;
+	uint32_t rqt_actual_size:16;
+	uint32_t rq_list[];
+};
+
+struct mlx5_devx_tir_attr {
+	uint32_t transport_domain:24;
+	uint32_t indirect_table:24;
+	uint32_t l3_prot_type:1;
+	uint32_t l4_prot_type:1;
+	uint32_t selected_fields;
+	uint8_t rx_hash_toeplitz_key[MLX5_RSS_HASH_KEY_LEN];
+};
+
+/* Virtio queue attributes, used on create, modify and query. */
+struct mlx5_devx_virtq_attr {
+	uint16_t type;
+	struct {
+		uint32_t tso_ipv4:1;
+		uint32_t tso_ipv6:1;
+		uint32_t tx_csum:1;
+		uint32_t rx_csum:1;
+		uint32_t virtio_version_1_0:1;
+		uint32_t event_mode:3;
+		uint32_t state:4;
+		uint32_t dirty_bitmap_dump_enable:1;
+		uint32_t log_page_size:5;
+	};
+	uint32_t qp_id;
+	uint32_t queue_index;
+	uint32_t doorbell_stride_index;
+	uint32_t queue_size;
+	uint32_t tis_id;
+	uint32_t mkey;
+	uint32_t dirty_bitmap_mkey;
+	uint32_t dirty_bitmap_size;
+	uint64_t dirty_bitmap_addr;
+	uint16_t hw_available_index;
+	uint16_t hw_used_index;
+	uint64_t desc_addr;
+	uint64_t used_addr;
+	uint64_t available_addr;
+	uint64_t mod_fields_bitmap;
+	struct {
+		uint32_t id;
+		uint32_t size;
+		uint64_t offset;
+	} umems[3];
+};
+
+/* mlx5_devx_cmds.c */
+
+int mlx5_devx_cmd_destroy(struct mlx5_devx_obj *obj);
+int mlx5_devx_cmd_query_hca_attr(struct ibv_context *ctx,
+				 struct mlx5_hca_attr *attr);
+struct mlx5_devx_obj *mlx5_devx_cmd_mkey_create(struct ibv_context *ctx,
+					struct mlx5_devx_mkey_attr *attr);
+struct mlx5_devx_obj *mlx5_devx_cmd_create_cq(struct ibv_context *ctx,
+					      struct mlx5_devx_cq_attr *attr);
+struct mlx5_devx_obj *mlx5_devx_cmd_create_qp(struct ibv_context *ctx,
+					      struct mlx5_devx_qp_attr *attr);
+int mlx5_devx_cmd_modify_qp_state(struct mlx5_devx_obj *qp,
+				  uint32_t qp_st_mod_op, uint32_t remote_qp_id);
+struct mlx5_devx_obj *mlx5_devx_cmd_create_td(struct ibv_context *ctx);
+struct mlx5_devx_obj *mlx5_devx_cmd_create_tis(struct ibv_context *ctx,
+					       struct mlx5_devx_tis_attr *attr);
+struct mlx5_devx_obj *mlx5_devx_cmd_create_rqt(struct ibv_context *ctx,
+					       struct mlx5_devx_rqt_attr *attr);
+struct mlx5_devx_obj *mlx5_devx_cmd_create_tir(struct ibv_context *ctx,
+					       struct mlx5_devx_tir_attr *attr);
+struct mlx5_devx_obj *mlx5_devx_cmd_create_virtq(struct ibv_context *ctx,
+					struct mlx5_devx_virtq_attr *attr);
+int mlx5_devx_cmd_modify_virtq(struct mlx5_devx_obj *virtq_obj,
+			       struct mlx5_devx_virtq_attr *attr);
+int mlx5_devx_cmd_query_virtq(struct mlx5_devx_obj *virtq_obj,
+			      struct mlx5_devx_virtq_attr *attr);
+
+#endif /* RTE_PMD_MLX5_DEVX_CMDS_H_ */
@@ -14,6 +14,7 @@
 #include <rte_mempool.h>
 #include <rte_malloc.h>
 #include <rte_rwlock.h>
+#include <rte_vect.h>
 
 #include "mlx5.h"
 #include "mlx5_mr.h"
@@ -74,6 +75,52 @@ mr_btree_expand(struct mlx5_mr_btree *bt, int n)
 	return ret;
 }
 
+#ifdef RTE_MACHINE_CPUFLAG_AVX2
+/**
+ * Narrow down the range of the binary search in B-tree lookup table by
+ * comparing the search key to 4 pivots at once, gathered from the table, which
+ * splits the range in 5 at each step instead of 2.
+ *
+ * @param lkp_tbl
+ *   Pointer to the lookup table, whose first entry starts at 0.
+ * @param[in,out] n
+ *   Size of the table, replaced by the size of the narrowed range, no more
+ *   than 4.
+ * @param addr
+ *   Search key.
+ *
+ * @return
+ *   Index of the first entry of the narrowed range.
+ */
+static __rte_always_inline uint16_t
+mr_btree_lookup_narrow(const struct mlx5_mr_cache *lkp_tbl, uint16_t *n,
+		       uintptr_t addr)
+{
+	/* Signed comparisons are fine for user space addresses. */
+	const __m256i key = _mm256_set1_epi64x(addr);
+	const int sz = sizeof(*lkp_tbl);
+	uint16_t base = 0;
+
+	while (*n > 4) {
+		uint16_t step = *n / 5;
+		__m128i offs = _mm_setr_epi32((base + step) * sz,
+					      (base + 2 * step) * sz,
+					      (base + 3 * step) * sz,
+					      (base + 4 * step) * sz);
+		/* Start addresses are the first fields of the entries. */
+		__m256i starts = _mm256_i32gather_epi64
+			((const long long *)(const void *)lkp_tbl, offs, 1);
+		/* Number of pivots starting at or below the key. */
+		unsigned int le = 4 - __builtin_popcount(_mm256_movemask_pd
+			(_mm256_castsi256_pd(_mm256_cmpgt_epi64(starts, key))));
+
+		base += le * step;
+		*n = le == 4 ? *n - 4 * step : step;
+	}
+	return base;
+}
+#endif
+
 /**
  * Look up LKey from given B-tree lookup table, store the last index and return
  * searched LKey.
@@ -102,6 +149,9 @@ mr_btree_lookup(struct mlx5_mr_btree *bt, uint16_t *idx, uintptr_t addr)
 	/* First entry must be NULL for comparison. */
 	assert(bt->len > 0 || (lkp_tbl[0].start == 0 &&
 			       lkp_tbl[0].lkey == UINT32_MAX));
+#ifdef RTE_MACHINE_CPUFLAG_AVX2
+	base = mr_btree_lookup_narrow(lkp_tbl, &n, addr);
+#endif
 	/* Binary search. */
 	do {
 		register uint16_t delta = n >> 1;
@@ -987,12 +1037,14 @@ mlx5_mr_addr2mr_bh(struct rte_eth_dev *dev, struct mlx5_mr_ctrl *mr_ctrl,
 	/* Victim in top-half cache to replace with new entry. */
 	struct mlx5_mr_cache *repl = &mr_ctrl->cache[mr_ctrl->head];
 
+	mr_ctrl->th_miss++;
 	/* Binary-search MR translation table. */
 	lkey = mr_btree_lookup(&mr_ctrl->cache_bh, &bh_idx, addr);
 	/* Update top-half cache. */
 	if (likely(lkey != UINT32_MAX)) {
 		*repl = (*mr_ctrl->cache_bh.table)[bh_idx];
 	} else {
+		mr_ctrl->bh_miss++;
 		/*
 		 * If missed in local lookup table, search in the global cache
 		 * and local cache_bh[] will be updated inside if possible.
@@ -1002,6 +1054,8 @@ mlx5_mr_addr2mr_bh(struct rte_eth_dev *dev, struct mlx5_mr_ctrl *mr_ctrl,
 		if (unlikely(lkey == UINT32_MAX))
 			return UINT32_MAX;
 	}
+	/* Update the direct-mapped entry of the address. */
+	mr_ctrl->dm_cache[mlx5_mr_dm_cache_idx(addr)] = *repl;
 	/* Update the most recently used entry. */
 	mr_ctrl->mru = mr_ctrl->head;
 	/* Point to the next victim, the oldest. */
@@ -1099,6 +1153,8 @@ mlx5_mr_flush_local_cache(struct mlx5_mr_ctrl *mr_ctrl)
 	/* Reset the linear search array. */
 	mr_ctrl->head = 0;
 	memset(mr_ctrl->cache, 0, sizeof(mr_ctrl->cache));
+	/* Reset the direct-mapped array. */
+	memset(mr_ctrl->dm_cache, 0, sizeof(mr_ctrl->dm_cache));
 	/* Reset the B-tree table. */
 	mr_ctrl->cache_bh.len = 1;
 	mr_ctrl->cache_bh.overflow = 0;
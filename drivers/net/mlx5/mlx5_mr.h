@@ -60,6 +60,10 @@ struct mlx5_mr_ctrl {
 	uint16_t head; /* Index of the oldest entry in top-half cache. */
 	struct mlx5_mr_cache cache[MLX5_MR_CACHE_N]; /* Cache for top-half. */
 	struct mlx5_mr_btree cache_bh; /* Cache for bottom-half. */
+	uint64_t th_miss; /* Number of misses on top-half caches. */
+	uint64_t bh_miss; /* Number of misses on bottom-half cache. */
+	/* Direct-mapped cache for top-half, indexed by address. */
+	struct mlx5_mr_cache dm_cache[MLX5_MR_DM_CACHE_N];
 } __rte_packed;
 
 extern struct mlx5_dev_list  mlx5_mem_event_cb_list;
@@ -117,4 +121,32 @@ mlx5_mr_lookup_cache(struct mlx5_mr_cache *lkp_tbl, uint16_t *cached_idx,
 	return UINT32_MAX;
 }
 
+/* Index of the direct-mapped cache entry of an address. */
+#define mlx5_mr_dm_cache_idx(addr) \
+	(((addr) >> MLX5_MR_DM_CACHE_SHIFT) & (MLX5_MR_DM_CACHE_N - 1))
+
+/**
+ * Look up LKey from the direct-mapped cache entry of given address. Unlike
+ * the linear search array, it covers as many MRs as it has entries when the
+ * addresses are spread over many memory regions, e.g. the guest memory of a
+ * VM pointed by external buffers.
+ *
+ * @param dm_cache
+ *   Pointer to direct-mapped cache.
+ * @param addr
+ *   Search key.
+ *
+ * @return
+ *   Searched LKey on success, UINT32_MAX on no match.
+ */
+static __rte_always_inline uint32_t
+mlx5_mr_lookup_dm_cache(struct mlx5_mr_cache *dm_cache, uintptr_t addr)
+{
+	struct mlx5_mr_cache *entry = &dm_cache[mlx5_mr_dm_cache_idx(addr)];
+
+	if (likely(addr >= entry->start && addr < entry->end))
+		return entry->lkey;
+	return UINT32_MAX;
+}
+
 #endif /* RTE_PMD_MLX5_MR_H_ */
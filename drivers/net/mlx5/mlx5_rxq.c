@@ -123,6 +123,30 @@ mlx5_mprq_enabled(struct rte_eth_dev *dev)
 	return n == priv->rxqs_n;
 }
 
+/**
+ * Initialize the default rearm_data of the mbufs of a RX queue, written to
+ * the mbufs by the Rx burst functions initializing them in bulk.
+ *
+ * @param rxq
+ *   Pointer to RX queue structure.
+ */
+static void
+rxq_mbuf_initializer_init(struct mlx5_rxq_data *rxq)
+{
+	struct rte_mbuf *mbuf_init = &rxq->fake_mbuf;
+
+	mbuf_init->data_off = RTE_PKTMBUF_HEADROOM;
+	rte_mbuf_refcnt_set(mbuf_init, 1);
+	mbuf_init->nb_segs = 1;
+	mbuf_init->port = rxq->port_id;
+	/*
+	 * prevent compiler reordering:
+	 * rearm_data covers previous fields.
+	 */
+	rte_compiler_barrier();
+	rxq->mbuf_initializer = *(uint64_t *)&mbuf_init->rearm_data;
+}
+
 /**
  * Allocate RX queue elements for Multi-Packet RQ.
  *
@@ -154,6 +178,8 @@ rxq_alloc_elts_mprq(struct mlx5_rxq_ctrl *rxq_ctrl)
 		else
 			rxq->mprq_repl = buf;
 	}
+	/* Initialize default rearm_data for the mbufs attached to strides. */
+	rxq_mbuf_initializer_init(rxq);
 	DRV_LOG(DEBUG,
 		"port %u Rx queue %u allocated and configured %u segments",
 		rxq->port_id, rxq_ctrl->idx, wqe_n);
@@ -219,21 +245,10 @@ rxq_alloc_elts_sprq(struct mlx5_rxq_ctrl *rxq_ctrl)
 	/* If Rx vector is activated. */
 	if (mlx5_rxq_check_vec_support(&rxq_ctrl->rxq) > 0) {
 		struct mlx5_rxq_data *rxq = &rxq_ctrl->rxq;
-		struct rte_mbuf *mbuf_init = &rxq->fake_mbuf;
 		int j;
 
 		/* Initialize default rearm_data for vPMD. */
-		mbuf_init->data_off = RTE_PKTMBUF_HEADROOM;
-		rte_mbuf_refcnt_set(mbuf_init, 1);
-		mbuf_init->nb_segs = 1;
-		mbuf_init->port = rxq->port_id;
-		/*
-		 * prevent compiler reordering:
-		 * rearm_data covers previous fields.
-		 */
-		rte_compiler_barrier();
-		rxq->mbuf_initializer =
-			*(uint64_t *)&mbuf_init->rearm_data;
+		rxq_mbuf_initializer_init(rxq);
 		/* Padding with a fake mbuf for vectorized Rx. */
 		for (j = 0; j < MLX5_VPMD_DESCS_PER_LOOP; ++j)
 			(*rxq->elts)[elts_n + j] = &rxq->fake_mbuf;
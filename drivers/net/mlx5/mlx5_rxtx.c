@@ -2182,6 +2182,9 @@ mlx5_rx_burst_mprq(void *dpdk_rxq, struct rte_mbuf **pkts, uint16_t pkts_n)
 	uint32_t rq_ci = rxq->rq_ci;
 	uint16_t consumed_strd = rxq->consumed_strd;
 	struct mlx5_mprq_buf *buf = (*rxq->mprq_bufs)[rq_ci & wq_mask];
+	struct rte_mbuf *mbufs[MLX5_MPRQ_MBUF_BULK];
+	unsigned int mbuf_i = 0;
+	unsigned int mbuf_n = 0;
 
 	while (i < pkts_n) {
 		struct rte_mbuf *pkt;
@@ -2255,11 +2258,24 @@ mlx5_rx_burst_mprq(void *dpdk_rxq, struct rte_mbuf **pkts, uint16_t pkts_n)
 			++rxq->stats.idropped;
 			continue;
 		}
-		pkt = rte_pktmbuf_alloc(rxq->mp);
-		if (unlikely(pkt == NULL)) {
-			++rxq->stats.rx_nombuf;
-			break;
+		/* Allocate mbufs in bulk, for the remaining packets at most. */
+		if (mbuf_i == mbuf_n) {
+			mbuf_n = RTE_MIN(pkts_n - i, MLX5_MPRQ_MBUF_BULK);
+			mbuf_i = 0;
+			if (unlikely(rte_mempool_get_bulk(rxq->mp,
+							  (void **)mbufs,
+							  mbuf_n) < 0)) {
+				mbuf_n = 0;
+				++rxq->stats.rx_nombuf;
+				break;
+			}
 		}
+		pkt = mbufs[mbuf_i++];
+		/*
+		 * Like in vectorized Rx, mbufs in the pool have no next segment
+		 * and the remaining fields are set below.
+		 */
+		*(uint64_t *)&pkt->rearm_data = rxq->mbuf_initializer;
 		len = (byte_cnt & MLX5_MPRQ_LEN_MASK) >> MLX5_MPRQ_LEN_SHIFT;
 		assert((int)len >= (rxq->crc_present << 2));
 		if (rxq->crc_present)
@@ -2335,6 +2351,10 @@ mlx5_rx_burst_mprq(void *dpdk_rxq, struct rte_mbuf **pkts, uint16_t pkts_n)
 		*(pkts++) = pkt;
 		++i;
 	}
+	/* Give back the mbufs allocated in excess. */
+	if (mbuf_i != mbuf_n)
+		rte_mempool_put_bulk(rxq->mp, (void **)&mbufs[mbuf_i],
+				     mbuf_n - mbuf_i);
 	/* Update the consumer indexes. */
 	rxq->consumed_strd = consumed_strd;
 	rte_cio_wmb();
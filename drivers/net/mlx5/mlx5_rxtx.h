@@ -116,7 +116,7 @@ struct mlx5_rxq_data {
 	struct rte_mempool *mprq_mp; /* Mempool for Multi-Packet RQ. */
 	struct mlx5_mprq_buf *mprq_repl; /* Stashed mbuf for replenish. */
 	struct mlx5_rxq_stats stats;
-	uint64_t mbuf_initializer; /* Default rearm_data for vectorized Rx. */
+	uint64_t mbuf_initializer; /* Default rearm_data for bulk Rx. */
 	struct rte_mbuf fake_mbuf; /* elts padding for vectorized Rx. */
 	void *cq_uar; /* CQ user access region. */
 	uint32_t cqn; /* CQ number. */
@@ -648,6 +648,10 @@ mlx5_rx_addr2mr(struct mlx5_rxq_data *rxq, uintptr_t addr)
 	/* Linear search on MR cache array. */
 	lkey = mlx5_mr_lookup_cache(mr_ctrl->cache, &mr_ctrl->mru,
 				    MLX5_MR_CACHE_N, addr);
+	if (likely(lkey != UINT32_MAX))
+		return lkey;
+	/* Direct-mapped cache on miss. */
+	lkey = mlx5_mr_lookup_dm_cache(mr_ctrl->dm_cache, addr);
 	if (likely(lkey != UINT32_MAX))
 		return lkey;
 	/* Take slower bottom-half (Binary Search) on miss. */
@@ -680,6 +684,10 @@ mlx5_tx_mb2mr(struct mlx5_txq_data *txq, struct rte_mbuf *mb)
 	/* Linear search on MR cache array. */
 	lkey = mlx5_mr_lookup_cache(mr_ctrl->cache, &mr_ctrl->mru,
 				    MLX5_MR_CACHE_N, addr);
+	if (likely(lkey != UINT32_MAX))
+		return lkey;
+	/* Direct-mapped cache on miss. */
+	lkey = mlx5_mr_lookup_dm_cache(mr_ctrl->dm_cache, addr);
 	if (likely(lkey != UINT32_MAX))
 		return lkey;
 	/* Take slower bottom-half on miss. */
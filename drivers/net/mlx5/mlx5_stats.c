@@ -136,6 +136,60 @@ static const struct mlx5_counter_ctrl mlx5_counters_init[] = {
 
 static const unsigned int xstats_n = RTE_DIM(mlx5_counters_init);
 
+/* Software counters of the per-queue MR caches, following device ones. */
+static const char *const mlx5_mr_xstats_names[] = {
+	"rx_mr_cache_misses",
+	"rx_mr_btree_misses",
+	"tx_mr_cache_misses",
+	"tx_mr_btree_misses",
+};
+
+static const unsigned int mr_xstats_n = RTE_DIM(mlx5_mr_xstats_names);
+
+/**
+ * Read or reset the software counters of the per-queue MR caches.
+ *
+ * @param dev
+ *   Pointer to Ethernet device.
+ * @param[out] stats
+ *   Counters output buffer, in the order of mlx5_mr_xstats_names[], NULL to
+ *   reset the counters.
+ */
+static void
+mlx5_mr_xstats_get(struct rte_eth_dev *dev, uint64_t *stats)
+{
+	struct priv *priv = dev->data->dev_private;
+	struct mlx5_mr_ctrl *mr_ctrl;
+	unsigned int i;
+
+	if (stats)
+		memset(stats, 0, mr_xstats_n * sizeof(*stats));
+	for (i = 0; (i != priv->rxqs_n); ++i) {
+		if ((*priv->rxqs)[i] == NULL)
+			continue;
+		mr_ctrl = &(*priv->rxqs)[i]->mr_ctrl;
+		if (stats) {
+			stats[0] += mr_ctrl->th_miss;
+			stats[1] += mr_ctrl->bh_miss;
+		} else {
+			mr_ctrl->th_miss = 0;
+			mr_ctrl->bh_miss = 0;
+		}
+	}
+	for (i = 0; (i != priv->txqs_n); ++i) {
+		if ((*priv->txqs)[i] == NULL)
+			continue;
+		mr_ctrl = &(*priv->txqs)[i]->mr_ctrl;
+		if (stats) {
+			stats[2] += mr_ctrl->th_miss;
+			stats[3] += mr_ctrl->bh_miss;
+		} else {
+			mr_ctrl->th_miss = 0;
+			mr_ctrl->bh_miss = 0;
+		}
+	}
+}
+
 static inline void
 mlx5_read_ib_stat(struct priv *priv, const char *ctr_name, uint64_t *stat)
 {
@@ -335,7 +389,7 @@ mlx5_xstats_get(struct rte_eth_dev *dev, struct rte_eth_xstat *stats,
 	struct mlx5_xstats_ctrl *xstats_ctrl = &priv->xstats_ctrl;
 	uint16_t mlx5_stats_n = xstats_ctrl->mlx5_stats_n;
 
-	if (n >= mlx5_stats_n && stats) {
+	if (n >= mlx5_stats_n + mr_xstats_n && stats) {
 		int stats_n;
 		int ret;
 
@@ -351,8 +405,13 @@ mlx5_xstats_get(struct rte_eth_dev *dev, struct rte_eth_xstat *stats,
 			stats[i].id = i;
 			stats[i].value = (counters[i] - xstats_ctrl->base[i]);
 		}
+		mlx5_mr_xstats_get(dev, counters);
+		for (i = 0; i != mr_xstats_n; ++i) {
+			stats[mlx5_stats_n + i].id = mlx5_stats_n + i;
+			stats[mlx5_stats_n + i].value = counters[i];
+		}
 	}
-	return mlx5_stats_n;
+	return mlx5_stats_n + mr_xstats_n;
 }
 
 /**
@@ -477,6 +536,7 @@ mlx5_xstats_reset(struct rte_eth_dev *dev)
 	uint64_t counters[n];
 	int ret;
 
+	mlx5_mr_xstats_get(dev, NULL);
 	stats_n = mlx5_ethtool_get_stats_n(dev);
 	if (stats_n < 0) {
 		DRV_LOG(ERR, "port %u cannot get stats: %s", dev->data->port_id,
@@ -517,13 +577,17 @@ mlx5_xstats_get_names(struct rte_eth_dev *dev __rte_unused,
 	struct mlx5_xstats_ctrl *xstats_ctrl = &priv->xstats_ctrl;
 	unsigned int mlx5_xstats_n = xstats_ctrl->mlx5_stats_n;
 
-	if (n >= mlx5_xstats_n && xstats_names) {
+	if (n >= mlx5_xstats_n + mr_xstats_n && xstats_names) {
 		for (i = 0; i != mlx5_xstats_n; ++i) {
 			strncpy(xstats_names[i].name,
 				xstats_ctrl->info[i].dpdk_name,
 				RTE_ETH_XSTATS_NAME_SIZE);
 			xstats_names[i].name[RTE_ETH_XSTATS_NAME_SIZE - 1] = 0;
 		}
+		for (i = 0; i != mr_xstats_n; ++i)
+			snprintf(xstats_names[mlx5_xstats_n + i].name,
+				 RTE_ETH_XSTATS_NAME_SIZE, "%s",
+				 mlx5_mr_xstats_names[i]);
 	}
-	return mlx5_xstats_n;
+	return mlx5_xstats_n + mr_xstats_n;
 }
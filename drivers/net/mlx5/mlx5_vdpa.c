@@ -2,16 +2,663 @@
  * Copyright 2018 Mellanox Technologies, Ltd
  */
 
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <linux/virtio_net.h>
+
 #include <rte_bus_pci.h>
+#include <rte_devargs.h>
 #include <rte_errno.h>
+#include <rte_kvargs.h>
+#include <rte_string_fns.h>
+#include <rte_malloc.h>
+#include <rte_vdpa.h>
+#include <rte_vhost.h>
 
+#include "mlx5.h"
 #include "mlx5_glue.h"
 #include "mlx5_defs.h"
 #include "mlx5_utils.h"
+#include "mlx5_vdpa.h"
+
+#define MLX5_VDPA_DEFAULT_FEATURES ((1ULL << VHOST_USER_F_PROTOCOL_FEATURES) | \
+				    (1ULL << VIRTIO_F_ANY_LAYOUT) | \
+				    (1ULL << VIRTIO_NET_F_MQ) | \
+				    (1ULL << VIRTIO_NET_F_GUEST_ANNOUNCE) | \
+				    (1ULL << VHOST_F_LOG_ALL) | \
+				    (1ULL << VIRTIO_F_ORDER_PLATFORM))
+
+#define MLX5_VDPA_PROTOCOL_FEATURES \
+			    ((1ULL << VHOST_USER_PROTOCOL_F_REPLY_ACK) | \
+			     (1ULL << VHOST_USER_PROTOCOL_F_SLAVE_REQ) | \
+			     (1ULL << VHOST_USER_PROTOCOL_F_SLAVE_SEND_FD) | \
+			     (1ULL << VHOST_USER_PROTOCOL_F_MQ) | \
+			     (1ULL << VHOST_USER_PROTOCOL_F_LOG_SHMFD) | \
+			     (1ULL << VHOST_USER_PROTOCOL_F_HOST_NOTIFIER))
+
+/* Device parameter to set the guest interrupt moderation period in usec. */
+#define MLX5_VDPA_EVENT_US "event_us"
+
+/* Device parameter to set the completions count moderating a guest
+ * interrupt.
+ */
+#define MLX5_VDPA_EVENT_MAX_CQE "event_max_cqe"
+
+/* Maximal CQ moderation period the PRM cq_period field can hold. */
+#define MLX5_VDPA_EVENT_US_MAX 0xfff
 
 /** Driver-specific log messages type. */
 int mlx5_vdpa_logtype;
 
+static TAILQ_HEAD(mlx5_vdpa_privs, mlx5_vdpa_priv) priv_list =
+					      TAILQ_HEAD_INITIALIZER(priv_list);
+static pthread_mutex_t priv_list_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct mlx5_vdpa_priv *
+mlx5_vdpa_find_priv_resource_by_did(int did)
+{
+	struct mlx5_vdpa_priv *priv;
+	int found = 0;
+
+	pthread_mutex_lock(&priv_list_lock);
+	TAILQ_FOREACH(priv, &priv_list, next) {
+		if (did == priv->id) {
+			found = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&priv_list_lock);
+	if (!found) {
+		DRV_LOG(ERR, "invalid vDPA device id %d", did);
+		rte_errno = EINVAL;
+		return NULL;
+	}
+	return priv;
+}
+
+static struct mlx5_vdpa_priv *
+mlx5_vdpa_find_priv_resource_by_vid(int vid)
+{
+	return mlx5_vdpa_find_priv_resource_by_did
+					(rte_vhost_get_vdpa_device_id(vid));
+}
+
+static int
+mlx5_vdpa_get_queue_num(int did, uint32_t *queue_num)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_did(did);
+
+	if (priv == NULL)
+		return -1;
+	*queue_num = priv->caps.max_num_virtio_queues;
+	return 0;
+}
+
+static int
+mlx5_vdpa_get_vdpa_features(int did, uint64_t *features)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_did(did);
+
+	if (priv == NULL)
+		return -1;
+	/* Packed virtqs are not supported, only split rings are set up. */
+	*features = MLX5_VDPA_DEFAULT_FEATURES;
+	if (priv->caps.tso_ipv4)
+		*features |= (1ULL << VIRTIO_NET_F_HOST_TSO4);
+	if (priv->caps.tso_ipv6)
+		*features |= (1ULL << VIRTIO_NET_F_HOST_TSO6);
+	if (priv->caps.tx_csum)
+		*features |= (1ULL << VIRTIO_NET_F_CSUM);
+	if (priv->caps.rx_csum)
+		*features |= (1ULL << VIRTIO_NET_F_GUEST_CSUM);
+	if (priv->caps.virtio_version_1_0)
+		*features |= (1ULL << VIRTIO_F_VERSION_1);
+	return 0;
+}
+
+static int
+mlx5_vdpa_get_protocol_features(int did, uint64_t *features)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_did(did);
+
+	if (priv == NULL)
+		return -1;
+	*features = MLX5_VDPA_PROTOCOL_FEATURES;
+	return 0;
+}
+
+static int
+mlx5_vdpa_set_vring_state(int vid, int vring, int state)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+	struct mlx5_vdpa_virtq *virtq;
+	int ret = 0;
+
+	if (priv == NULL)
+		return -1;
+	rte_spinlock_lock(&priv->lock);
+	if (!priv->configured)
+		/* All the virtqs are created enabled on dev_conf. */
+		goto out;
+	if (vring >= (int)priv->nr_virtqs) {
+		DRV_LOG(ERR, "too big vring id: %d", vring);
+		ret = -1;
+		goto out;
+	}
+	virtq = &priv->virtqs[vring];
+	if (virtq->enable == !!state)
+		goto out;
+	ret = mlx5_vdpa_virtq_enable(virtq, state);
+	if (ret) {
+		DRV_LOG(ERR, "failed to %s virtq %d",
+			state ? "enable" : "disable", vring);
+		goto out;
+	}
+	/* RX virtqs have even indexes, update the receive steering. */
+	if (!(vring & 1))
+		ret = mlx5_vdpa_steer_update(priv);
+out:
+	rte_spinlock_unlock(&priv->lock);
+	return ret;
+}
+
+static int
+mlx5_vdpa_features_set(int vid)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+	uint64_t features;
+	int ret = 0;
+
+	if (priv == NULL)
+		return -1;
+	if (rte_vhost_get_negotiated_features(vid, &features)) {
+		DRV_LOG(ERR, "failed to get negotiated features");
+		return -1;
+	}
+	DRV_LOG(DEBUG, "vid %d negotiated features 0x%" PRIx64, vid,
+		features);
+	rte_spinlock_lock(&priv->lock);
+	if (priv->configured) {
+		/* Only VHOST_F_LOG_ALL may change on a running device. */
+		priv->features = features;
+		ret = mlx5_vdpa_lm_setup(priv);
+		if (ret)
+			DRV_LOG(ERR, "failed to %s dirty pages logging of vid"
+				" %d", RTE_VHOST_NEED_LOG(features) ?
+				"start" : "stop", vid);
+	}
+	rte_spinlock_unlock(&priv->lock);
+	return ret;
+}
+
+static int
+mlx5_vdpa_dev_close(int vid)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+
+	if (priv == NULL)
+		return -1;
+	rte_spinlock_lock(&priv->lock);
+	mlx5_vdpa_cqe_event_unset(priv);
+	if (priv->configured && mlx5_vdpa_lm_log(priv))
+		DRV_LOG(ERR, "failed to save the virtqs state of vid %d", vid);
+	mlx5_vdpa_lm_release(priv);
+	mlx5_vdpa_steer_unset(priv);
+	mlx5_vdpa_virtqs_release(priv);
+	mlx5_vdpa_event_qp_global_release(priv);
+	mlx5_vdpa_mem_dereg(priv);
+	priv->configured = 0;
+	priv->vid = 0;
+	rte_spinlock_unlock(&priv->lock);
+	return 0;
+}
+
+static int
+mlx5_vdpa_dev_config(int vid)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+
+	if (priv == NULL)
+		return -1;
+	if (priv->configured && mlx5_vdpa_dev_close(vid)) {
+		DRV_LOG(ERR, "failed to reconfigure vid %d", vid);
+		return -1;
+	}
+	rte_spinlock_lock(&priv->lock);
+	priv->vid = vid;
+	if (mlx5_vdpa_mem_register(priv) ||
+	    mlx5_vdpa_virtqs_prepare(priv) ||
+	    mlx5_vdpa_steer_setup(priv) ||
+	    mlx5_vdpa_cqe_event_setup(priv) ||
+	    mlx5_vdpa_lm_setup(priv)) {
+		rte_spinlock_unlock(&priv->lock);
+		mlx5_vdpa_dev_close(vid);
+		return -1;
+	}
+	priv->configured = 1;
+	rte_spinlock_unlock(&priv->lock);
+	DRV_LOG(INFO, "vid %d was configured with %u virtqs", vid,
+		priv->nr_virtqs);
+	return 0;
+}
+
+static int
+mlx5_vdpa_migration_done(int vid)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+
+	if (priv == NULL)
+		return -1;
+	/* The guest runs here now, nothing is left to be logged. */
+	rte_spinlock_lock(&priv->lock);
+	mlx5_vdpa_lm_release(priv);
+	rte_spinlock_unlock(&priv->lock);
+	return 0;
+}
+
+static int
+mlx5_vdpa_set_mem_table(int vid)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+	int ret = 0;
+
+	if (priv == NULL)
+		return -1;
+	rte_spinlock_lock(&priv->lock);
+	if (priv->configured)
+		ret = mlx5_vdpa_mem_register(priv);
+	rte_spinlock_unlock(&priv->lock);
+	if (ret) {
+		DRV_LOG(WARNING, "failed to update memory of vid %d, "
+			"reconfiguring the device", vid);
+		return mlx5_vdpa_dev_config(vid);
+	}
+	return 0;
+}
+
+static int
+mlx5_vdpa_get_device_fd(int vid)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+
+	if (priv == NULL)
+		return -1;
+	/* The doorbell page is mmapped from the command FD at the VAR offset. */
+	return priv->ctx->cmd_fd;
+}
+
+static int
+mlx5_vdpa_get_notify_area(int vid, int qid __rte_unused, uint64_t *offset,
+			  uint64_t *size)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_vid(vid);
+
+	if (priv == NULL)
+		return -1;
+	if (!priv->var) {
+		DRV_LOG(ERR, "VAR was not created for device %d", priv->id);
+		return -1;
+	}
+	*offset = priv->var->mmap_off;
+	*size = priv->var->length;
+	return 0;
+}
+
+static const struct {
+	char name[RTE_VDPA_XSTATS_NAME_SIZE];
+	size_t offset;
+} mlx5_vdpa_xstats[] = {
+	{ "kicks", offsetof(struct mlx5_vdpa_virtq, kicks) },
+	{ "completions", offsetof(struct mlx5_vdpa_virtq, eqp.cq.events) },
+	{ "completion_errors",
+	  offsetof(struct mlx5_vdpa_virtq, eqp.cq.errors) },
+	{ "interrupts", offsetof(struct mlx5_vdpa_virtq, eqp.cq.interrupts) },
+};
+
+static struct mlx5_vdpa_virtq *
+mlx5_vdpa_stats_virtq(int did, uint16_t qid)
+{
+	struct mlx5_vdpa_priv *priv = mlx5_vdpa_find_priv_resource_by_did(did);
+
+	if (priv == NULL)
+		return NULL;
+	if (qid >= priv->caps.max_num_virtio_queues * 2) {
+		DRV_LOG(ERR, "too big vring id: %u", qid);
+		rte_errno = EINVAL;
+		return NULL;
+	}
+	return &priv->virtqs[qid];
+}
+
+static int
+mlx5_vdpa_get_stats(int did, uint16_t qid, struct rte_vdpa_stats *stats)
+{
+	struct mlx5_vdpa_virtq *virtq = mlx5_vdpa_stats_virtq(did, qid);
+
+	if (virtq == NULL)
+		return -1;
+	/* Packets and bytes are not reported by the current firmware. */
+	memset(stats, 0, sizeof(*stats));
+	stats->errors = virtq->eqp.cq.errors;
+	stats->kicks = virtq->kicks;
+	return 0;
+}
+
+static int
+mlx5_vdpa_get_xstats(int did, uint16_t qid, struct rte_vdpa_xstat_name *names,
+		     struct rte_vdpa_xstat *xstats, unsigned int n)
+{
+	struct mlx5_vdpa_virtq *virtq = mlx5_vdpa_stats_virtq(did, qid);
+	unsigned int i;
+
+	if (virtq == NULL)
+		return -1;
+	if (n < RTE_DIM(mlx5_vdpa_xstats))
+		return RTE_DIM(mlx5_vdpa_xstats);
+	for (i = 0; i < RTE_DIM(mlx5_vdpa_xstats); i++) {
+		strlcpy(names[i].name, mlx5_vdpa_xstats[i].name,
+			sizeof(names[i].name));
+		xstats[i].id = i;
+		xstats[i].value = *(uint64_t *)((char *)virtq +
+				  mlx5_vdpa_xstats[i].offset);
+	}
+	return RTE_DIM(mlx5_vdpa_xstats);
+}
+
+static int
+mlx5_vdpa_reset_stats(int did, uint16_t qid)
+{
+	struct mlx5_vdpa_virtq *virtq = mlx5_vdpa_stats_virtq(did, qid);
+
+	if (virtq == NULL)
+		return -1;
+	virtq->kicks = 0;
+	virtq->eqp.cq.events = 0;
+	virtq->eqp.cq.errors = 0;
+	virtq->eqp.cq.interrupts = 0;
+	return 0;
+}
+
+static struct rte_vdpa_dev_ops mlx5_vdpa_ops = {
+	.get_queue_num = mlx5_vdpa_get_queue_num,
+	.get_features = mlx5_vdpa_get_vdpa_features,
+	.get_protocol_features = mlx5_vdpa_get_protocol_features,
+	.dev_conf = mlx5_vdpa_dev_config,
+	.dev_close = mlx5_vdpa_dev_close,
+	.set_vring_state = mlx5_vdpa_set_vring_state,
+	.set_features = mlx5_vdpa_features_set,
+	.migration_done = mlx5_vdpa_migration_done,
+	.get_vfio_group_fd = NULL,
+	.get_vfio_device_fd = mlx5_vdpa_get_device_fd,
+	.get_notify_area = mlx5_vdpa_get_notify_area,
+	.set_mem_table = mlx5_vdpa_set_mem_table,
+	.get_stats = mlx5_vdpa_get_stats,
+	.get_xstats = mlx5_vdpa_get_xstats,
+	.reset_stats = mlx5_vdpa_reset_stats,
+};
+
+/**
+ * Open the DevX context of the IB device of a PCI device.
+ *
+ * @param[in] pci_dev
+ *   PCI device information.
+ *
+ * @return
+ *   The DevX context on success, NULL otherwise and rte_errno is set.
+ */
+static struct ibv_context *
+mlx5_vdpa_get_ibv_ctx(struct rte_pci_device *pci_dev)
+{
+	struct ibv_device **ibv_list;
+	struct ibv_device *ibv_match = NULL;
+	struct ibv_context *ctx = NULL;
+	int n;
+
+	errno = 0;
+	ibv_list = mlx5_glue->get_device_list(&n);
+	if (!ibv_list) {
+		rte_errno = errno ? errno : ENOSYS;
+		DRV_LOG(ERR, "cannot list devices, is ib_uverbs loaded?");
+		return NULL;
+	}
+	while (n-- > 0) {
+		struct rte_pci_addr pci_addr;
+
+		DRV_LOG(DEBUG, "checking device \"%s\"", ibv_list[n]->name);
+		if (mlx5_ibv_device_to_pci_addr(ibv_list[n], &pci_addr))
+			continue;
+		if (rte_pci_addr_cmp(&pci_dev->addr, &pci_addr))
+			continue;
+		ibv_match = ibv_list[n];
+		break;
+	}
+	if (!ibv_match) {
+		DRV_LOG(DEBUG, "no matching IB device for PCI device "
+			PCI_PRI_FMT, pci_dev->addr.domain, pci_dev->addr.bus,
+			pci_dev->addr.devid, pci_dev->addr.function);
+		rte_errno = ENOENT;
+	} else {
+		ctx = mlx5_glue->dv_open_device(ibv_match);
+		if (!ctx) {
+			DRV_LOG(ERR, "failed to open IB device \"%s\" with"
+				" DevX", ibv_match->name);
+			rte_errno = errno ? errno : ENODEV;
+		}
+	}
+	mlx5_glue->free_device_list(ibv_list);
+	return ctx;
+}
+
+/**
+ * Allocate a protection domain and get its number.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_pd_create(struct mlx5_vdpa_priv *priv)
+{
+#ifdef HAVE_IBV_DEVX_OBJ
+	struct mlx5dv_obj obj;
+	struct mlx5dv_pd pd_info;
+	int ret = 0;
+
+	priv->pd = mlx5_glue->alloc_pd(priv->ctx);
+	if (priv->pd == NULL) {
+		DRV_LOG(ERR, "failed to allocate PD");
+		rte_errno = errno ? errno : ENOMEM;
+		return -rte_errno;
+	}
+	obj.pd.in = priv->pd;
+	obj.pd.out = &pd_info;
+	ret = mlx5_glue->dv_init_obj(&obj, MLX5DV_OBJ_PD);
+	if (ret) {
+		DRV_LOG(ERR, "failed to get PD object info");
+		mlx5_glue->dealloc_pd(priv->pd);
+		priv->pd = NULL;
+		rte_errno = ret;
+		return -rte_errno;
+	}
+	priv->pdn = pd_info.pdn;
+	return 0;
+#else
+	(void)priv;
+	DRV_LOG(ERR, "cannot get pdn - no DevX support");
+	rte_errno = ENOTSUP;
+	return -rte_errno;
+#endif
+}
+
+/**
+ * Release all the device global resources created on probe.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ */
+static void
+mlx5_vdpa_dev_release(struct mlx5_vdpa_priv *priv)
+{
+	if (priv->virtq_db_addr)
+		claim_zero(munmap(priv->virtq_db_addr, priv->var->length));
+	if (priv->var)
+		mlx5_glue->dv_free_var(priv->var);
+	if (priv->tis)
+		claim_zero(mlx5_devx_cmd_destroy(priv->tis));
+	if (priv->td)
+		claim_zero(mlx5_devx_cmd_destroy(priv->td));
+	if (priv->pd)
+		claim_zero(mlx5_glue->dealloc_pd(priv->pd));
+	if (priv->ctx)
+		claim_zero(mlx5_glue->close_device(priv->ctx));
+	rte_free(priv);
+}
+
+/**
+ * Create the device global resources: the PD, the transport objects used
+ * by the virtqs and the doorbell page.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_dev_prepare(struct mlx5_vdpa_priv *priv)
+{
+	struct mlx5_devx_tis_attr tis_attr = {0};
+
+	if (mlx5_vdpa_pd_create(priv))
+		return -rte_errno;
+	priv->td = mlx5_devx_cmd_create_td(priv->ctx);
+	if (!priv->td) {
+		DRV_LOG(ERR, "failed to create transport domain");
+		return -rte_errno;
+	}
+	tis_attr.transport_domain = priv->td->id;
+	priv->tis = mlx5_devx_cmd_create_tis(priv->ctx, &tis_attr);
+	if (!priv->tis) {
+		DRV_LOG(ERR, "failed to create TIS");
+		return -rte_errno;
+	}
+	priv->var = mlx5_glue->dv_alloc_var(priv->ctx, 0);
+	if (!priv->var) {
+		DRV_LOG(ERR, "failed to allocate VAR %u", errno);
+		rte_errno = errno ? errno : ENOMEM;
+		return -rte_errno;
+	}
+	/* Always map the entire page. */
+	priv->virtq_db_addr = mmap(NULL, priv->var->length, PROT_READ |
+				   PROT_WRITE, MAP_SHARED, priv->ctx->cmd_fd,
+				   priv->var->mmap_off);
+	if (priv->virtq_db_addr == MAP_FAILED) {
+		DRV_LOG(ERR, "failed to map doorbell page %u", errno);
+		priv->virtq_db_addr = NULL;
+		rte_errno = errno;
+		return -rte_errno;
+	}
+	DRV_LOG(DEBUG, "VAR address of doorbell mapping is %p",
+		priv->virtq_db_addr);
+	return 0;
+}
+
+/**
+ * Verify and store value for device argument.
+ *
+ * @param[in] key
+ *   Key argument to verify.
+ * @param[in] val
+ *   Value associated with key.
+ * @param opaque
+ *   User data.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_args_check(const char *key, const char *val, void *opaque)
+{
+	struct mlx5_vdpa_priv *priv = opaque;
+	unsigned long tmp;
+
+	errno = 0;
+	tmp = strtoul(val, NULL, 0);
+	if (errno) {
+		rte_errno = errno;
+		DRV_LOG(WARNING, "%s: \"%s\" is not a valid integer", key, val);
+		return -rte_errno;
+	}
+	if (strcmp(MLX5_VDPA_EVENT_US, key) == 0) {
+		if (tmp > MLX5_VDPA_EVENT_US_MAX) {
+			DRV_LOG(WARNING, "%s: %lu is bigger than %u", key, tmp,
+				MLX5_VDPA_EVENT_US_MAX);
+			rte_errno = EINVAL;
+			return -rte_errno;
+		}
+		priv->event_us = tmp;
+	} else if (strcmp(MLX5_VDPA_EVENT_MAX_CQE, key) == 0) {
+		if (tmp > UINT16_MAX) {
+			DRV_LOG(WARNING, "%s: %lu is bigger than %u", key, tmp,
+				UINT16_MAX);
+			rte_errno = EINVAL;
+			return -rte_errno;
+		}
+		priv->event_max_cqe = tmp;
+	} else {
+		DRV_LOG(WARNING, "%s: unknown parameter", key);
+		rte_errno = EINVAL;
+		return -rte_errno;
+	}
+	return 0;
+}
+
+/**
+ * Parse device parameters.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ * @param[in] devargs
+ *   Device arguments structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_args(struct mlx5_vdpa_priv *priv, struct rte_devargs *devargs)
+{
+	const char **params = (const char *[]){
+		MLX5_VDPA_EVENT_US,
+		MLX5_VDPA_EVENT_MAX_CQE,
+		NULL,
+	};
+	struct rte_kvargs *kvlist;
+	int i;
+
+	if (devargs == NULL)
+		return 0;
+	kvlist = rte_kvargs_parse(devargs->args, params);
+	if (kvlist == NULL)
+		return 0;
+	for (i = 0; (params[i] != NULL); ++i) {
+		if (rte_kvargs_count(kvlist, params[i]) &&
+		    rte_kvargs_process(kvlist, params[i],
+				       mlx5_vdpa_args_check, priv)) {
+			rte_errno = EINVAL;
+			rte_kvargs_free(kvlist);
+			return -rte_errno;
+		}
+	}
+	rte_kvargs_free(kvlist);
+	return 0;
+}
+
 /**
  * DPDK callback to register a PCI device.
  *
@@ -27,16 +674,73 @@ int mlx5_vdpa_logtype;
  */
 static int
 mlx5_vdpa_pci_probe(struct rte_pci_driver *pci_drv __rte_unused,
-		    struct rte_pci_device *pci_dev __rte_unused)
+		    struct rte_pci_device *pci_dev)
 {
-	rte_errno = ENOENT;
+	struct mlx5_vdpa_priv *priv = NULL;
+	struct ibv_context *ctx;
+	struct mlx5_hca_attr attr;
+	int ret;
+
+	ctx = mlx5_vdpa_get_ibv_ctx(pci_dev);
+	if (!ctx)
+		return -rte_errno;
+	ret = mlx5_devx_cmd_query_hca_attr(ctx, &attr);
+	if (ret) {
+		DRV_LOG(ERR, "unable to read HCA capabilities");
+		rte_errno = ENOTSUP;
+		goto error;
+	}
+	if (!attr.vdpa.valid || !attr.vdpa.max_num_virtio_queues) {
+		DRV_LOG(ERR, "not enough capabilities to support vdpa, maybe "
+			"old FW/OFED version?");
+		rte_errno = ENOTSUP;
+		goto error;
+	}
+	priv = rte_zmalloc("mlx5 vDPA device private", sizeof(*priv) +
+			   sizeof(struct mlx5_vdpa_virtq) *
+			   attr.vdpa.max_num_virtio_queues * 2,
+			   RTE_CACHE_LINE_SIZE);
+	if (!priv) {
+		DRV_LOG(ERR, "failed to allocate private memory");
+		rte_errno = ENOMEM;
+		goto error;
+	}
+	priv->caps = attr.vdpa;
+	priv->ctx = ctx;
+	priv->pci_dev = pci_dev;
+	priv->dev_addr.pci_addr = pci_dev->addr;
+	priv->dev_addr.type = PCI_ADDR;
+	rte_spinlock_init(&priv->lock);
+	SLIST_INIT(&priv->mr_list);
+	if (mlx5_vdpa_args(priv, pci_dev->device.devargs))
+		goto error;
+	if (mlx5_vdpa_dev_prepare(priv))
+		goto error;
+	priv->id = rte_vdpa_register_device(&priv->dev_addr, &mlx5_vdpa_ops);
+	if (priv->id < 0) {
+		DRV_LOG(ERR, "failed to register vDPA device");
+		rte_errno = rte_errno ? rte_errno : EINVAL;
+		goto error;
+	}
+	pthread_mutex_lock(&priv_list_lock);
+	TAILQ_INSERT_TAIL(&priv_list, priv, next);
+	pthread_mutex_unlock(&priv_list_lock);
+	DRV_LOG(INFO, "vDPA device %d was registered with %u virtq pairs",
+		priv->id, priv->caps.max_num_virtio_queues);
+	return 0;
+error:
+	if (priv)
+		mlx5_vdpa_dev_release(priv);
+	else
+		mlx5_glue->close_device(ctx);
 	return -rte_errno;
 }
 
 /**
  * DPDK callback to remove a PCI device.
  *
- * This function removes all Ethernet devices belong to a given PCI device.
+ * This function removes the vdpa device spawned out of a given PCI
+ * device.
  *
  * @param[in] pci_dev
  *   Pointer to the PCI device.
@@ -45,8 +749,29 @@ mlx5_vdpa_pci_probe(struct rte_pci_driver *pci_drv __rte_unused,
  *   0 on success, the function cannot fail.
  */
 static int
-mlx5_vdpa_pci_remove(struct rte_pci_device *pci_dev __rte_unused)
+mlx5_vdpa_pci_remove(struct rte_pci_device *pci_dev)
 {
+	struct mlx5_vdpa_priv *priv = NULL;
+	int found = 0;
+
+	pthread_mutex_lock(&priv_list_lock);
+	TAILQ_FOREACH(priv, &priv_list, next) {
+		if (!rte_pci_addr_cmp(&priv->pci_dev->addr, &pci_dev->addr)) {
+			found = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&priv_list_lock);
+	if (found) {
+		/* The close looks the device up in the list. */
+		if (priv->configured)
+			mlx5_vdpa_dev_close(priv->vid);
+		pthread_mutex_lock(&priv_list_lock);
+		TAILQ_REMOVE(&priv_list, priv, next);
+		pthread_mutex_unlock(&priv_list_lock);
+		rte_vdpa_unregister_device(priv->id);
+		mlx5_vdpa_dev_release(priv);
+	}
 	return 0;
 }
 
@@ -248,3 +973,6 @@ RTE_INIT(rte_mlx5_vdpa_init)
 RTE_PMD_EXPORT_NAME(net_mlx5_vdpa, __COUNTER__);
 RTE_PMD_REGISTER_PCI_TABLE(net_mlx5_vdpa, mlx5_vdpa_pci_id_map);
 RTE_PMD_REGISTER_KMOD_DEP(net_mlx5_vdpa, "* ib_uverbs & mlx5_core & mlx5_ib");
+RTE_PMD_REGISTER_PARAM_STRING(net_mlx5_vdpa,
+			      MLX5_VDPA_EVENT_US "=<int> "
+			      MLX5_VDPA_EVENT_MAX_CQE "=<int>");
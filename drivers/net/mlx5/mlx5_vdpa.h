@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2018 Mellanox Technologies, Ltd
+ */
+
+#ifndef RTE_PMD_MLX5_VDPA_H_
+#define RTE_PMD_MLX5_VDPA_H_
+
+#include <stdint.h>
+#include <sys/queue.h>
+#include <linux/virtio_net.h>
+
+#include <rte_vdpa.h>
+#include <rte_vhost.h>
+#include <rte_spinlock.h>
+#include <rte_interrupts.h>
+
+#include "mlx5_glue.h"
+#include "mlx5_prm.h"
+#include "mlx5_devx_cmds.h"
+
+#ifndef VIRTIO_F_RING_PACKED
+#define VIRTIO_F_RING_PACKED 34
+#endif
+
+#ifndef VIRTIO_F_ORDER_PLATFORM
+#define VIRTIO_F_ORDER_PLATFORM 36
+#endif
+
+#define MLX5_VDPA_INTR_RETRIES 256
+#define MLX5_VDPA_INTR_RETRIES_USEC 1000
+
+/* Number of umem buffers required by each hardware virtq. */
+#define MLX5_VDPA_VIRTQ_UMEMS_N 3
+
+/* Completion queue polled on behalf of a virtq to signal the guest. */
+struct mlx5_vdpa_cq {
+	uint16_t log_desc_n;
+	uint32_t cq_ci:24;
+	uint32_t arm_sn:2;
+	int callfd;
+	struct mlx5_devx_obj *cq;
+	struct mlx5dv_devx_umem *umem_obj;
+	union {
+		volatile void *umem_buf;
+		volatile struct mlx5_cqe *cqes;
+	};
+	volatile uint32_t *db_rec;
+	uint64_t events; /* Completions consumed. */
+	uint64_t errors; /* Error completions consumed. */
+	uint64_t interrupts; /* Guest notifications. */
+};
+
+/*
+ * Event QP pair: the firmware QP is given to the virtq which reports
+ * completions through it, the software QP receives them on its CQ.
+ */
+struct mlx5_vdpa_event_qp {
+	struct mlx5_vdpa_cq cq;
+	struct mlx5_devx_obj *fw_qp;
+	struct mlx5_devx_obj *sw_qp;
+	struct mlx5dv_devx_umem *umem_obj;
+	void *umem_buf;
+	volatile uint32_t *db_rec;
+};
+
+/* Guest memory region registered to the device. */
+struct mlx5_vdpa_query_mr {
+	SLIST_ENTRY(mlx5_vdpa_query_mr) next;
+	void *addr; /* Host virtual address. */
+	uint64_t gpa; /* Guest physical address. */
+	uint64_t length;
+	struct mlx5dv_devx_umem *umem;
+	struct mlx5_devx_obj *mkey;
+	int is_indirect;
+};
+
+struct mlx5_vdpa_priv;
+
+/* Hardware virtq state. */
+struct mlx5_vdpa_virtq {
+	uint8_t enable;
+	uint16_t index;
+	uint16_t vq_size;
+	int kickfd;
+	uint64_t kicks; /* Guest kicks relayed to the doorbell. */
+	struct mlx5_vdpa_priv *priv;
+	struct mlx5_devx_obj *virtq;
+	struct mlx5_vdpa_event_qp eqp;
+	struct {
+		struct mlx5dv_devx_umem *obj;
+		void *buf;
+		uint32_t size;
+	} umems[MLX5_VDPA_VIRTQ_UMEMS_N];
+	struct rte_intr_handle intr_handle;
+};
+
+/* Receive steering into the RX virtqs. */
+enum {
+	MLX5_VDPA_STEER_IPV4,
+	MLX5_VDPA_STEER_IPV6,
+	MLX5_VDPA_STEER_ANY,
+	MLX5_VDPA_STEER_MAX,
+};
+
+struct mlx5_vdpa_steer {
+	struct mlx5_devx_obj *rqt;
+	struct {
+		struct mlx5dv_flow_matcher *matcher;
+		struct mlx5_devx_obj *tir;
+		struct ibv_flow *flow;
+	} rss[MLX5_VDPA_STEER_MAX];
+};
+
+/* Hardware dirty pages logging into the vhost log region. */
+struct mlx5_vdpa_lm {
+	uint8_t enabled;
+	uint64_t base; /* Log region host virtual address. */
+	uint64_t size;
+	struct mlx5dv_devx_umem *umem;
+	struct mlx5_devx_obj *mkey;
+};
+
+struct mlx5_vdpa_priv {
+	TAILQ_ENTRY(mlx5_vdpa_priv) next;
+	uint8_t configured;
+	int id; /* vDPA device id. */
+	int vid; /* vhost device id. */
+	struct ibv_context *ctx; /* Device context. */
+	struct rte_pci_device *pci_dev;
+	struct rte_vdpa_dev_addr dev_addr;
+	struct mlx5_hca_vdpa_attr caps;
+	rte_spinlock_t lock; /* Serializes the vhost callbacks. */
+	uint32_t pdn; /* Protection Domain number. */
+	struct ibv_pd *pd;
+	uint32_t gpa_mkey_index;
+	struct ibv_mr *null_mr;
+	struct rte_vhost_memory *vmem;
+	uint32_t eqn;
+	struct mlx5dv_devx_event_channel *eventc;
+	struct mlx5dv_devx_uar *uar;
+	struct rte_intr_handle intr_handle;
+	struct mlx5_devx_obj *td;
+	struct mlx5_devx_obj *tis;
+	struct mlx5dv_var *var;
+	void *virtq_db_addr;
+	uint64_t features; /* Negotiated features. */
+	SLIST_HEAD(mr_list, mlx5_vdpa_query_mr) mr_list;
+	struct mlx5_vdpa_steer steer;
+	struct mlx5_vdpa_lm lm;
+	uint16_t event_us; /* Guest interrupt moderation period. */
+	uint16_t event_max_cqe; /* Guest interrupt moderation count. */
+	uint16_t nr_virtqs;
+	struct mlx5_vdpa_virtq virtqs[];
+};
+
+/* mlx5_vdpa_mem.c */
+
+void mlx5_vdpa_mem_dereg(struct mlx5_vdpa_priv *priv);
+int mlx5_vdpa_mem_register(struct mlx5_vdpa_priv *priv);
+
+/* mlx5_vdpa_event.c */
+
+int mlx5_vdpa_event_qp_create(struct mlx5_vdpa_priv *priv, uint16_t desc_n,
+			      int callfd, struct mlx5_vdpa_event_qp *eqp);
+void mlx5_vdpa_event_qp_destroy(struct mlx5_vdpa_event_qp *eqp);
+int mlx5_vdpa_cqe_event_setup(struct mlx5_vdpa_priv *priv);
+void mlx5_vdpa_cqe_event_unset(struct mlx5_vdpa_priv *priv);
+void mlx5_vdpa_event_qp_global_release(struct mlx5_vdpa_priv *priv);
+
+/* mlx5_vdpa_virtq.c */
+
+int mlx5_vdpa_virtqs_prepare(struct mlx5_vdpa_priv *priv);
+void mlx5_vdpa_virtqs_release(struct mlx5_vdpa_priv *priv);
+int mlx5_vdpa_virtq_enable(struct mlx5_vdpa_virtq *virtq, int enable);
+int mlx5_vdpa_virtqs_mkey_update(struct mlx5_vdpa_priv *priv);
+
+/* mlx5_vdpa_steer.c */
+
+int mlx5_vdpa_steer_setup(struct mlx5_vdpa_priv *priv);
+int mlx5_vdpa_steer_update(struct mlx5_vdpa_priv *priv);
+void mlx5_vdpa_steer_unset(struct mlx5_vdpa_priv *priv);
+
+/* mlx5_vdpa_lm.c */
+
+int mlx5_vdpa_lm_setup(struct mlx5_vdpa_priv *priv);
+void mlx5_vdpa_lm_release(struct mlx5_vdpa_priv *priv);
+int mlx5_vdpa_lm_log(struct mlx5_vdpa_priv *priv);
+
+#endif /* RTE_PMD_MLX5_VDPA_H_ */
@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2018 Mellanox Technologies, Ltd
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <linux/virtio_ring.h>
+
+#include <rte_malloc.h>
+#include <rte_errno.h>
+
+#include "mlx5_utils.h"
+#include "mlx5_vdpa.h"
+
+/* Bytes of a split used ring, including the flags, idx and avail event. */
+#define MLX5_VDPA_USED_RING_LEN(size) \
+	((size) * sizeof(struct vring_used_elem) + sizeof(uint16_t) * 3)
+
+/**
+ * Start or stop the hardware dirty pages reporting of all the virtqs.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ * @param[in] enable
+ *   Non-zero to start the reporting, stop it otherwise.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_logging_enable(struct mlx5_vdpa_priv *priv, int enable)
+{
+	struct mlx5_devx_virtq_attr attr = {
+		.type = MLX5_VIRTQ_MODIFY_TYPE_DIRTY_BITMAP_DUMP_ENABLE,
+		.dirty_bitmap_dump_enable = !!enable,
+	};
+	uint16_t i;
+
+	for (i = 0; i < priv->nr_virtqs; i++) {
+		if (!priv->virtqs[i].virtq)
+			continue;
+		attr.queue_index = i;
+		if (mlx5_devx_cmd_modify_virtq(priv->virtqs[i].virtq, &attr)) {
+			DRV_LOG(ERR, "failed to %s dirty bitmap dump of virtq"
+				" %u", enable ? "enable" : "disable", i);
+			return -rte_errno;
+		}
+	}
+	priv->lm.enabled = !!enable;
+	return 0;
+}
+
+/**
+ * Release the dirty bitmap registration.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ */
+static void
+mlx5_vdpa_dirty_bitmap_release(struct mlx5_vdpa_priv *priv)
+{
+	if (priv->lm.mkey) {
+		claim_zero(mlx5_devx_cmd_destroy(priv->lm.mkey));
+		priv->lm.mkey = NULL;
+	}
+	if (priv->lm.umem) {
+		claim_zero(mlx5_glue->devx_umem_dereg(priv->lm.umem));
+		priv->lm.umem = NULL;
+	}
+	priv->lm.base = 0;
+	priv->lm.size = 0;
+}
+
+/**
+ * Register the vhost log region to the device and point the dirty bitmap
+ * of all the virtqs to it, so the device marks the guest pages it writes
+ * directly in the vhost log.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ * @param[in] log_base
+ *   The vhost log region host virtual address.
+ * @param[in] log_size
+ *   The vhost log region size.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_dirty_bitmap_set(struct mlx5_vdpa_priv *priv, uint64_t log_base,
+			   uint64_t log_size)
+{
+	struct mlx5_devx_mkey_attr mkey_attr = {0};
+	struct mlx5_devx_virtq_attr attr = {
+		.type = MLX5_VIRTQ_MODIFY_TYPE_DIRTY_BITMAP_PARAMS,
+		.dirty_bitmap_addr = log_base,
+		.dirty_bitmap_size = log_size,
+	};
+	uint16_t i;
+
+	if (priv->lm.mkey && priv->lm.base == log_base &&
+	    priv->lm.size == log_size)
+		return 0;
+	mlx5_vdpa_dirty_bitmap_release(priv);
+	priv->lm.umem = mlx5_glue->devx_umem_reg(priv->ctx,
+						 (void *)(uintptr_t)log_base,
+						 log_size,
+						 IBV_ACCESS_LOCAL_WRITE);
+	if (!priv->lm.umem) {
+		DRV_LOG(ERR, "failed to register the dirty bitmap umem");
+		rte_errno = errno ? errno : ENOMEM;
+		return -rte_errno;
+	}
+	mkey_attr.addr = log_base;
+	mkey_attr.size = log_size;
+	mkey_attr.umem_id = priv->lm.umem->umem_id;
+	mkey_attr.pd = priv->pdn;
+	priv->lm.mkey = mlx5_devx_cmd_mkey_create(priv->ctx, &mkey_attr);
+	if (!priv->lm.mkey) {
+		DRV_LOG(ERR, "failed to create the dirty bitmap mkey");
+		goto error;
+	}
+	attr.dirty_bitmap_mkey = priv->lm.mkey->id;
+	for (i = 0; i < priv->nr_virtqs; i++) {
+		if (!priv->virtqs[i].virtq)
+			continue;
+		attr.queue_index = i;
+		if (mlx5_devx_cmd_modify_virtq(priv->virtqs[i].virtq, &attr)) {
+			DRV_LOG(ERR, "failed to set dirty bitmap of virtq %u",
+				i);
+			goto error;
+		}
+	}
+	priv->lm.base = log_base;
+	priv->lm.size = log_size;
+	DRV_LOG(DEBUG, "dirty bitmap 0x%" PRIx64 " of size %" PRIu64
+		" bytes is set", log_base, log_size);
+	return 0;
+error:
+	mlx5_vdpa_dirty_bitmap_release(priv);
+	return -rte_errno;
+}
+
+/**
+ * Apply the negotiated VHOST_F_LOG_ALL feature: start the hardware dirty
+ * pages reporting into the vhost log when it is set, stop it otherwise.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_lm_setup(struct mlx5_vdpa_priv *priv)
+{
+	uint64_t log_base;
+	uint64_t log_size;
+	int ret;
+
+	if (!RTE_VHOST_NEED_LOG(priv->features)) {
+		mlx5_vdpa_lm_release(priv);
+		return 0;
+	}
+	ret = rte_vhost_get_log_base(priv->vid, &log_base, &log_size);
+	if (ret || !log_base || !log_size) {
+		DRV_LOG(ERR, "failed to get the vhost log of vid %d",
+			priv->vid);
+		rte_errno = EINVAL;
+		return -rte_errno;
+	}
+	if (mlx5_vdpa_dirty_bitmap_set(priv, log_base, log_size))
+		return -rte_errno;
+	if (!priv->lm.enabled && mlx5_vdpa_logging_enable(priv, 1))
+		return -rte_errno;
+	DRV_LOG(INFO, "vid %d dirty pages logging is enabled", priv->vid);
+	return 0;
+}
+
+/**
+ * Stop the hardware dirty pages reporting and release its resources.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ */
+void
+mlx5_vdpa_lm_release(struct mlx5_vdpa_priv *priv)
+{
+	if (priv->lm.enabled && mlx5_vdpa_logging_enable(priv, 0))
+		DRV_LOG(WARNING, "failed to stop dirty pages logging of vid"
+			" %d", priv->vid);
+	priv->lm.enabled = 0;
+	mlx5_vdpa_dirty_bitmap_release(priv);
+}
+
+/**
+ * Suspend the virtqs and save their indexes in vhost, for the migration or
+ * for the software datapath taking the device over. While logging is on,
+ * mark their used rings dirty too, since they are the only guest memory the
+ * device writes without reporting it in the dirty bitmap.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_lm_log(struct mlx5_vdpa_priv *priv)
+{
+	struct mlx5_devx_virtq_attr attr = {0};
+	struct mlx5_vdpa_virtq *virtq;
+	uint16_t i;
+
+	for (i = 0; i < priv->nr_virtqs; i++) {
+		virtq = &priv->virtqs[i];
+		if (!virtq->virtq)
+			continue;
+		if (virtq->enable && mlx5_vdpa_virtq_enable(virtq, 0)) {
+			DRV_LOG(ERR, "failed to suspend virtq %u", i);
+			return -rte_errno;
+		}
+		if (mlx5_devx_cmd_query_virtq(virtq->virtq, &attr)) {
+			DRV_LOG(ERR, "failed to query virtq %u", i);
+			return -rte_errno;
+		}
+		if (rte_vhost_set_vring_base(priv->vid, i,
+					     attr.hw_available_index,
+					     attr.hw_used_index)) {
+			DRV_LOG(ERR, "failed to set virtq %u base", i);
+			rte_errno = EINVAL;
+			return -rte_errno;
+		}
+		if (RTE_VHOST_NEED_LOG(priv->features))
+			rte_vhost_log_used_vring(priv->vid, i, 0,
+						 MLX5_VDPA_USED_RING_LEN
+						 (virtq->vq_size));
+	}
+	return 0;
+}
@@ -0,0 +1,367 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2018 Mellanox Technologies, Ltd
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_common.h>
+
+#include "mlx5_utils.h"
+#include "mlx5_vdpa.h"
+
+/* Maximal byte count a single KLM entry can describe. */
+#define MLX5_MAX_KLM_BYTE_COUNT 0x80000000u
+
+/**
+ * Destroy all the memory regions of a list.
+ *
+ * @param[in] list
+ *   The memory regions list.
+ */
+static void
+mlx5_vdpa_mem_list_flush(struct mr_list *list)
+{
+	struct mlx5_vdpa_query_mr *entry;
+	struct mlx5_vdpa_query_mr *next;
+
+	entry = SLIST_FIRST(list);
+	while (entry) {
+		next = SLIST_NEXT(entry, next);
+		claim_zero(mlx5_devx_cmd_destroy(entry->mkey));
+		if (!entry->is_indirect)
+			claim_zero(mlx5_glue->devx_umem_dereg(entry->umem));
+		rte_free(entry);
+		entry = next;
+	}
+	SLIST_INIT(list);
+}
+
+/**
+ * Release all the prepared memory regions and all their related resources.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ */
+void
+mlx5_vdpa_mem_dereg(struct mlx5_vdpa_priv *priv)
+{
+	mlx5_vdpa_mem_list_flush(&priv->mr_list);
+	if (priv->null_mr) {
+		claim_zero(mlx5_glue->dereg_mr(priv->null_mr));
+		priv->null_mr = NULL;
+	}
+	if (priv->vmem) {
+		free(priv->vmem);
+		priv->vmem = NULL;
+	}
+	priv->gpa_mkey_index = 0;
+}
+
+static int
+mlx5_vdpa_regions_addr_cmp(const void *a, const void *b)
+{
+	const struct rte_vhost_mem_region *region_a = a;
+	const struct rte_vhost_mem_region *region_b = b;
+
+	if (region_a->guest_phys_addr < region_b->guest_phys_addr)
+		return -1;
+	if (region_a->guest_phys_addr > region_b->guest_phys_addr)
+		return 1;
+	return 0;
+}
+
+/**
+ * Count the KLM entries needed to describe the guest physical address
+ * space of a sorted memory table, including the holes between regions.
+ *
+ * @param[in] mem
+ *   The guest memory table, sorted by guest physical address.
+ *
+ * @return
+ *   The number of KLM entries.
+ */
+static uint32_t
+mlx5_vdpa_klm_count(struct rte_vhost_memory *mem)
+{
+	uint64_t prev_end = 0;
+	uint32_t klm_n = 0;
+	uint32_t i;
+
+	for (i = 0; i < mem->nregions; i++) {
+		struct rte_vhost_mem_region *reg = &mem->regions[i];
+
+		if (reg->guest_phys_addr > prev_end)
+			klm_n += RTE_ALIGN_CEIL(reg->guest_phys_addr - prev_end,
+						MLX5_MAX_KLM_BYTE_COUNT) /
+				 MLX5_MAX_KLM_BYTE_COUNT;
+		klm_n += RTE_ALIGN_CEIL(reg->size, MLX5_MAX_KLM_BYTE_COUNT) /
+			 MLX5_MAX_KLM_BYTE_COUNT;
+		prev_end = reg->guest_phys_addr + reg->size;
+	}
+	return klm_n;
+}
+
+/**
+ * Append KLM entries covering @p size bytes of @p mkey starting at
+ * @p addr, splitting it as needed by the KLM byte count limit.
+ *
+ * @return
+ *   The new number of filled KLM entries.
+ */
+static uint32_t
+mlx5_vdpa_klm_fill(struct mlx5_klm *klm_array, uint32_t klm_index,
+		   uint32_t mkey, uint64_t addr, uint64_t size)
+{
+	while (size) {
+		uint32_t chunk = RTE_MIN(size, (uint64_t)MLX5_MAX_KLM_BYTE_COUNT);
+
+		klm_array[klm_index].byte_count = chunk;
+		klm_array[klm_index].mkey = mkey;
+		klm_array[klm_index].address = addr;
+		klm_index++;
+		addr += chunk;
+		size -= chunk;
+	}
+	return klm_index;
+}
+
+static void
+mlx5_vdpa_mr_destroy(struct mlx5_vdpa_query_mr *entry)
+{
+	if (entry->mkey)
+		claim_zero(mlx5_devx_cmd_destroy(entry->mkey));
+	if (entry->umem)
+		claim_zero(mlx5_glue->devx_umem_dereg(entry->umem));
+	rte_free(entry);
+}
+
+/**
+ * Take out of a list the direct entry describing exactly a memory region,
+ * so it can be reused as is.
+ *
+ * @return
+ *   The entry if found, NULL otherwise.
+ */
+static struct mlx5_vdpa_query_mr *
+mlx5_vdpa_mr_reuse(struct mr_list *list, struct rte_vhost_mem_region *reg)
+{
+	struct mlx5_vdpa_query_mr *entry;
+
+	SLIST_FOREACH(entry, list, next) {
+		if (!entry->is_indirect &&
+		    entry->gpa == reg->guest_phys_addr &&
+		    entry->length == reg->size &&
+		    entry->addr == (void *)(uintptr_t)reg->host_user_addr) {
+			SLIST_REMOVE(list, entry, mlx5_vdpa_query_mr, next);
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Register a memory region as a direct mkey whose start address is the
+ * region guest physical address.
+ *
+ * @return
+ *   The new entry on success, NULL otherwise and rte_errno is set.
+ */
+static struct mlx5_vdpa_query_mr *
+mlx5_vdpa_mr_create(struct mlx5_vdpa_priv *priv,
+		    struct rte_vhost_mem_region *reg)
+{
+	struct mlx5_devx_mkey_attr mkey_attr = {0};
+	struct mlx5_vdpa_query_mr *entry;
+
+	entry = rte_zmalloc(__func__, sizeof(*entry), 0);
+	if (!entry) {
+		rte_errno = ENOMEM;
+		DRV_LOG(ERR, "failed to allocate mem entry memory");
+		return NULL;
+	}
+	entry->umem = mlx5_glue->devx_umem_reg(priv->ctx,
+					 (void *)(uintptr_t)reg->host_user_addr,
+					 reg->size, IBV_ACCESS_LOCAL_WRITE);
+	if (!entry->umem) {
+		DRV_LOG(ERR, "failed to register umem of GPA 0x%" PRIx64,
+			reg->guest_phys_addr);
+		rte_errno = errno ? errno : ENOMEM;
+		goto error;
+	}
+	mkey_attr.addr = (uintptr_t)(reg->guest_phys_addr);
+	mkey_attr.size = reg->size;
+	mkey_attr.umem_id = entry->umem->umem_id;
+	mkey_attr.pd = priv->pdn;
+	entry->mkey = mlx5_devx_cmd_mkey_create(priv->ctx, &mkey_attr);
+	if (!entry->mkey) {
+		DRV_LOG(ERR, "failed to create direct mkey of GPA 0x%" PRIx64,
+			reg->guest_phys_addr);
+		goto error;
+	}
+	entry->addr = (void *)(uintptr_t)(reg->host_user_addr);
+	entry->gpa = reg->guest_phys_addr;
+	entry->length = reg->size;
+	entry->is_indirect = 0;
+	return entry;
+error:
+	mlx5_vdpa_mr_destroy(entry);
+	return NULL;
+}
+
+/**
+ * Register all the memory regions of the virtio device to the HW and
+ * allocate all their related resources.
+ *
+ * Each region gets a direct mkey over its umem, whose start address is the
+ * region guest physical address. A single indirect mkey then maps the whole
+ * guest physical address space, so hardware virtqs can work with guest
+ * physical addresses only.
+ *
+ * When called again on a memory table change, regions which did not change
+ * keep their umem and direct mkey, only the new ones are registered since
+ * pinning the guest memory is by far the most expensive part. The indirect
+ * mkey is then rebuilt and the virtqs are moved to it before the previous
+ * mkeys are released.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_mem_register(struct mlx5_vdpa_priv *priv)
+{
+	struct mlx5_devx_mkey_attr mkey_attr = {0};
+	struct mlx5_vdpa_query_mr **regs_mr = NULL;
+	struct mlx5_vdpa_query_mr *entry = NULL;
+	struct mr_list old_list = SLIST_HEAD_INITIALIZER(old_list);
+	struct rte_vhost_memory *mem = NULL;
+	struct mlx5_klm *klm_array = NULL;
+	uint64_t prev_end = 0;
+	uint32_t klm_index = 0;
+	uint32_t reused = 0;
+	uint32_t klm_n;
+	uint32_t i;
+	int ret;
+
+	ret = rte_vhost_get_mem_table(priv->vid, &mem);
+	if (ret < 0 || !mem) {
+		DRV_LOG(ERR, "failed to get VM memory layout vid %d",
+			priv->vid);
+		rte_errno = EINVAL;
+		return -rte_errno;
+	}
+	qsort(mem->regions, mem->nregions, sizeof(mem->regions[0]),
+	      mlx5_vdpa_regions_addr_cmp);
+	if (!priv->null_mr) {
+		priv->null_mr = mlx5_glue->alloc_null_mr(priv->pd);
+		if (!priv->null_mr) {
+			DRV_LOG(ERR, "failed to allocate null MR");
+			rte_errno = errno ? errno : ENOTSUP;
+			goto error;
+		}
+		DRV_LOG(DEBUG, "dump fill mkey = %u", priv->null_mr->lkey);
+	}
+	regs_mr = rte_zmalloc(__func__, sizeof(*regs_mr) * mem->nregions, 0);
+	klm_n = mlx5_vdpa_klm_count(mem);
+	klm_array = rte_zmalloc(__func__, klm_n * sizeof(*klm_array), 0);
+	if (!regs_mr || !klm_array) {
+		rte_errno = ENOMEM;
+		goto error;
+	}
+	for (i = 0; i < mem->nregions; i++) {
+		struct rte_vhost_mem_region *reg = &mem->regions[i];
+
+		regs_mr[i] = mlx5_vdpa_mr_reuse(&priv->mr_list, reg);
+		if (regs_mr[i]) {
+			reused++;
+			continue;
+		}
+		regs_mr[i] = mlx5_vdpa_mr_create(priv, reg);
+		if (!regs_mr[i])
+			goto error;
+		DRV_LOG(DEBUG, "region %u: HVA 0x%" PRIx64 ", GPA 0x%" PRIx64
+			", size 0x%" PRIx64 " registered.", i,
+			reg->host_user_addr, reg->guest_phys_addr, reg->size);
+	}
+	/*
+	 * What is left are the previous indirect mkey and the regions removed
+	 * from the guest, the virtqs may still use them until moved to the new
+	 * indirect mkey.
+	 */
+	old_list = priv->mr_list;
+	SLIST_INIT(&priv->mr_list);
+	for (i = 0; i < mem->nregions; i++) {
+		struct rte_vhost_mem_region *reg = &mem->regions[i];
+
+		SLIST_INSERT_HEAD(&priv->mr_list, regs_mr[i], next);
+		if (reg->guest_phys_addr > prev_end)
+			klm_index = mlx5_vdpa_klm_fill(klm_array, klm_index,
+					priv->null_mr->lkey, 0,
+					reg->guest_phys_addr - prev_end);
+		klm_index = mlx5_vdpa_klm_fill(klm_array, klm_index,
+				regs_mr[i]->mkey->id, reg->guest_phys_addr,
+				reg->size);
+		prev_end = reg->guest_phys_addr + reg->size;
+	}
+	rte_free(regs_mr);
+	regs_mr = NULL;
+	assert(klm_index == klm_n);
+	entry = rte_zmalloc(__func__, sizeof(*entry), 0);
+	if (!entry) {
+		rte_errno = ENOMEM;
+		DRV_LOG(ERR, "failed to allocate memory for indirect entry");
+		goto error;
+	}
+	mkey_attr.addr = 0;
+	mkey_attr.size = prev_end;
+	mkey_attr.umem_id = 0;
+	mkey_attr.pd = priv->pdn;
+	mkey_attr.klm_num = klm_index;
+	mkey_attr.klm_array = klm_array;
+	mkey_attr.log_entity_size = 0;
+	entry->mkey = mlx5_devx_cmd_mkey_create(priv->ctx, &mkey_attr);
+	if (!entry->mkey) {
+		DRV_LOG(ERR, "failed to create indirect mkey");
+		goto error;
+	}
+	entry->is_indirect = 1;
+	SLIST_INSERT_HEAD(&priv->mr_list, entry, next);
+	entry = NULL;
+	priv->gpa_mkey_index = SLIST_FIRST(&priv->mr_list)->mkey->id;
+	rte_free(klm_array);
+	klm_array = NULL;
+	if (priv->vmem)
+		free(priv->vmem);
+	priv->vmem = mem;
+	mem = NULL;
+	if (!SLIST_EMPTY(&old_list)) {
+		if (mlx5_vdpa_virtqs_mkey_update(priv))
+			goto error;
+		mlx5_vdpa_mem_list_flush(&old_list);
+	}
+	DRV_LOG(INFO, "vid %d memory: %u regions, %u reused", priv->vid,
+		priv->vmem->nregions, reused);
+	return 0;
+error:
+	if (regs_mr) {
+		for (i = 0; i < mem->nregions; i++)
+			if (regs_mr[i])
+				mlx5_vdpa_mr_destroy(regs_mr[i]);
+		rte_free(regs_mr);
+	}
+	if (entry)
+		mlx5_vdpa_mr_destroy(entry);
+	mlx5_vdpa_mem_list_flush(&old_list);
+	if (mem)
+		free(mem);
+	rte_free(klm_array);
+	mlx5_vdpa_mem_dereg(priv);
+	return -rte_errno;
+}
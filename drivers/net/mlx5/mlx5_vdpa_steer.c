@@ -0,0 +1,244 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2018 Mellanox Technologies, Ltd
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_common.h>
+
+#include "mlx5_utils.h"
+#include "mlx5_rxtx.h"
+#include "mlx5_vdpa.h"
+
+/**
+ * Release the receive steering resources.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ */
+void
+mlx5_vdpa_steer_unset(struct mlx5_vdpa_priv *priv)
+{
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(priv->steer.rss); ++i) {
+		if (priv->steer.rss[i].flow) {
+			claim_zero(mlx5_glue->destroy_flow
+				   (priv->steer.rss[i].flow));
+			priv->steer.rss[i].flow = NULL;
+		}
+		if (priv->steer.rss[i].tir) {
+			claim_zero(mlx5_devx_cmd_destroy
+				   (priv->steer.rss[i].tir));
+			priv->steer.rss[i].tir = NULL;
+		}
+		if (priv->steer.rss[i].matcher) {
+			claim_zero(mlx5_glue->dv_destroy_flow_matcher
+				   (priv->steer.rss[i].matcher));
+			priv->steer.rss[i].matcher = NULL;
+		}
+	}
+	if (priv->steer.rqt) {
+		claim_zero(mlx5_devx_cmd_destroy(priv->steer.rqt));
+		priv->steer.rqt = NULL;
+	}
+}
+
+/**
+ * Create the RQT spreading the traffic over the enabled RX virtqs. RX
+ * virtqs have even indexes, the table is padded to a power of 2 by
+ * repeating them.
+ *
+ * @return
+ *   0 on success, 1 when there is no enabled RX virtq, a negative errno
+ *   value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_rqt_create(struct mlx5_vdpa_priv *priv)
+{
+	struct mlx5_devx_rqt_attr *attr;
+	uint32_t rqt_n = rte_align32pow2(RTE_MAX(priv->nr_virtqs / 2, 1));
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
+
+	attr = rte_zmalloc(__func__, sizeof(*attr) +
+			   rqt_n * sizeof(uint32_t), 0);
+	if (!attr) {
+		DRV_LOG(ERR, "failed to allocate RQT attributes memory");
+		rte_errno = ENOMEM;
+		return -rte_errno;
+	}
+	for (i = 0, j = 0; i < priv->nr_virtqs; i += 2)
+		if (priv->virtqs[i].enable && priv->virtqs[i].virtq)
+			attr->rq_list[j++] = priv->virtqs[i].virtq->id;
+	if (!j) {
+		rte_free(attr);
+		return 1;
+	}
+	for (k = j; j < rqt_n; ++j)
+		attr->rq_list[j] = attr->rq_list[j % k];
+	attr->rqt_max_size = rqt_n;
+	attr->rqt_actual_size = rqt_n;
+	priv->steer.rqt = mlx5_devx_cmd_create_rqt(priv->ctx, attr);
+	rte_free(attr);
+	if (!priv->steer.rqt) {
+		DRV_LOG(ERR, "failed to create RQT");
+		return -rte_errno;
+	}
+	return 0;
+}
+
+#if defined(HAVE_IBV_FLOW_DV_SUPPORT) && defined(HAVE_IBV_DEVX_OBJ)
+
+/**
+ * Create a TIR, a matcher and a flow for each steering type, IPv4 and IPv6
+ * traffic is hashed over the IP addresses, anything else hits the first
+ * RX virtq of the table.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+static int
+mlx5_vdpa_rss_flows_create(struct mlx5_vdpa_priv *priv)
+{
+	struct mlx5_devx_tir_attr tir_attr = {
+		.transport_domain = priv->td->id,
+		.indirect_table = priv->steer.rqt->id,
+	};
+	struct {
+		size_t size;
+		/**< Size of match value. Do NOT split size and key! */
+		uint32_t buf[MLX5_ST_SZ_DW(fte_match_param)];
+		/**< Matcher value. This value is used as the mask or a key. */
+	} matcher_mask, matcher_value;
+	struct mlx5dv_flow_matcher_attr dv_attr = {
+		.type = IBV_FLOW_ATTR_NORMAL,
+		.match_mask = (void *)&matcher_mask,
+	};
+	struct mlx5dv_flow_action_attr action;
+	void *headers_m = MLX5_ADDR_OF(fte_match_param, matcher_mask.buf,
+				       outer_headers);
+	void *headers_v = MLX5_ADDR_OF(fte_match_param, matcher_value.buf,
+				       outer_headers);
+	const uint32_t l3_hash =
+		(1 << MLX5_RX_HASH_FIELD_SELECT_SELECTED_FIELDS_SRC_IP) |
+		(1 << MLX5_RX_HASH_FIELD_SELECT_SELECTED_FIELDS_DST_IP);
+	static const struct {
+		uint8_t priority;
+		uint8_t ip_version;
+		uint8_t l3_prot_type;
+		uint8_t hash;
+	} vars[MLX5_VDPA_STEER_MAX] = {
+		[MLX5_VDPA_STEER_IPV4] = { 0, 4, MLX5_L3_PROT_TYPE_IPV4, 1 },
+		[MLX5_VDPA_STEER_IPV6] = { 0, 6, MLX5_L3_PROT_TYPE_IPV6, 1 },
+		[MLX5_VDPA_STEER_ANY] = { 1, 0, 0, 0 },
+	};
+	unsigned int i;
+
+	memcpy(tir_attr.rx_hash_toeplitz_key, rss_hash_default_key,
+	       MLX5_RSS_HASH_KEY_LEN);
+	for (i = 0; i < RTE_DIM(priv->steer.rss); ++i) {
+		memset(&matcher_mask, 0, sizeof(matcher_mask));
+		memset(&matcher_value, 0, sizeof(matcher_value));
+		matcher_mask.size = sizeof(matcher_mask.buf);
+		matcher_value.size = sizeof(matcher_value.buf);
+		if (vars[i].ip_version) {
+			MLX5_SET(fte_match_set_lyr_2_4, headers_m, ip_version,
+				 0xf);
+			MLX5_SET(fte_match_set_lyr_2_4, headers_v, ip_version,
+				 vars[i].ip_version);
+			dv_attr.match_criteria_enable =
+				1 << MLX5_MATCH_CRITERIA_ENABLE_OUTER_BIT;
+		} else {
+			dv_attr.match_criteria_enable = 0;
+		}
+		dv_attr.priority = vars[i].priority;
+		priv->steer.rss[i].matcher = mlx5_glue->dv_create_flow_matcher
+							(priv->ctx, &dv_attr);
+		if (!priv->steer.rss[i].matcher) {
+			DRV_LOG(ERR, "failed to create matcher %u", i);
+			rte_errno = errno ? errno : ENOMEM;
+			goto error;
+		}
+		tir_attr.l3_prot_type = vars[i].l3_prot_type;
+		tir_attr.selected_fields = vars[i].hash ? l3_hash : 0;
+		priv->steer.rss[i].tir = mlx5_devx_cmd_create_tir(priv->ctx,
+								  &tir_attr);
+		if (!priv->steer.rss[i].tir) {
+			DRV_LOG(ERR, "failed to create TIR %u", i);
+			goto error;
+		}
+		action.type = MLX5DV_FLOW_ACTION_DEST_DEVX;
+		action.obj = priv->steer.rss[i].tir->obj;
+		priv->steer.rss[i].flow = mlx5_glue->dv_create_flow
+					(priv->steer.rss[i].matcher,
+					 (void *)&matcher_value, 1, &action);
+		if (!priv->steer.rss[i].flow) {
+			DRV_LOG(ERR, "failed to create flow %u", i);
+			rte_errno = errno ? errno : ENOMEM;
+			goto error;
+		}
+	}
+	return 0;
+error:
+	/* Resources are released by the caller. */
+	return -rte_errno;
+}
+
+#else
+
+static int
+mlx5_vdpa_rss_flows_create(struct mlx5_vdpa_priv *priv __rte_unused)
+{
+	DRV_LOG(ERR, "DevX flow steering is not supported by rdma-core");
+	rte_errno = ENOTSUP;
+	return -rte_errno;
+}
+
+#endif
+
+/**
+ * Steer the receive traffic of the device to its enabled RX virtqs.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_steer_setup(struct mlx5_vdpa_priv *priv)
+{
+	int ret = mlx5_vdpa_rqt_create(priv);
+
+	if (ret) {
+		/* No enabled RX virtq yet, nothing to steer to. */
+		return ret > 0 ? 0 : ret;
+	}
+	if (mlx5_vdpa_rss_flows_create(priv))
+		goto error;
+	return 0;
+error:
+	mlx5_vdpa_steer_unset(priv);
+	return -rte_errno;
+}
+
+/**
+ * Update the receive steering after RX virtqs were enabled or disabled.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_steer_update(struct mlx5_vdpa_priv *priv)
+{
+	mlx5_vdpa_steer_unset(priv);
+	return mlx5_vdpa_steer_setup(priv);
+}
@@ -0,0 +1,383 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2018 Mellanox Technologies, Ltd
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/virtio_net.h>
+
+#include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_io.h>
+
+#include "mlx5_utils.h"
+#include "mlx5_vdpa.h"
+
+/**
+ * Kick relay: forward a guest notification to the virtq doorbell.
+ *
+ * @param cb_arg
+ *   The virtq structure.
+ */
+static void
+mlx5_vdpa_virtq_handler(void *cb_arg)
+{
+	struct mlx5_vdpa_virtq *virtq = cb_arg;
+	struct mlx5_vdpa_priv *priv = virtq->priv;
+	uint64_t buf;
+	int nbytes;
+
+	do {
+		nbytes = read(virtq->intr_handle.fd, &buf, 8);
+		if (nbytes < 0) {
+			if (errno == EINTR ||
+			    errno == EWOULDBLOCK ||
+			    errno == EAGAIN)
+				continue;
+			DRV_LOG(ERR, "failed to read kickfd of virtq %d: %s",
+				virtq->index, strerror(errno));
+		}
+		break;
+	} while (1);
+	rte_write32(virtq->index, priv->virtq_db_addr);
+	virtq->kicks++;
+	DRV_LOG(DEBUG, "ring virtq %u doorbell", virtq->index);
+}
+
+static int
+mlx5_vdpa_virtq_unset(struct mlx5_vdpa_virtq *virtq)
+{
+	int retries = MLX5_VDPA_INTR_RETRIES;
+	int ret = -EAGAIN;
+	unsigned int i;
+
+	if (virtq->intr_handle.fd) {
+		while (retries-- && ret == -EAGAIN) {
+			ret = rte_intr_callback_unregister(&virtq->intr_handle,
+							mlx5_vdpa_virtq_handler,
+							virtq);
+			if (ret == -EAGAIN) {
+				DRV_LOG(DEBUG, "try again to unregister fd %d "
+					"of virtq %d interrupt, retries = %d",
+					virtq->intr_handle.fd,
+					(int)virtq->index, retries);
+				usleep(MLX5_VDPA_INTR_RETRIES_USEC);
+			}
+		}
+		virtq->intr_handle.fd = 0;
+	}
+	if (virtq->virtq) {
+		claim_zero(mlx5_devx_cmd_destroy(virtq->virtq));
+		virtq->virtq = NULL;
+	}
+	for (i = 0; i < RTE_DIM(virtq->umems); ++i) {
+		if (virtq->umems[i].obj)
+			claim_zero(mlx5_glue->devx_umem_dereg
+							 (virtq->umems[i].obj));
+		if (virtq->umems[i].buf)
+			rte_free(virtq->umems[i].buf);
+	}
+	memset(&virtq->umems, 0, sizeof(virtq->umems));
+	if (virtq->eqp.fw_qp)
+		mlx5_vdpa_event_qp_destroy(&virtq->eqp);
+	virtq->enable = 0;
+	return 0;
+}
+
+/**
+ * Release all the virtqs of a device.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ */
+void
+mlx5_vdpa_virtqs_release(struct mlx5_vdpa_priv *priv)
+{
+	unsigned int i;
+
+	for (i = 0; i < priv->nr_virtqs; i++)
+		mlx5_vdpa_virtq_unset(&priv->virtqs[i]);
+	priv->features = 0;
+	priv->nr_virtqs = 0;
+}
+
+/**
+ * Move a virtq between the ready and the suspended states.
+ *
+ * @param[in] virtq
+ *   The virtq to modify.
+ * @param[in] enable
+ *   Non-zero to move the virtq to the ready state, suspend it otherwise.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_virtq_enable(struct mlx5_vdpa_virtq *virtq, int enable)
+{
+	struct mlx5_devx_virtq_attr attr = {
+		.type = MLX5_VIRTQ_MODIFY_TYPE_STATE,
+		.state = enable ? MLX5_VIRTQ_STATE_RDY :
+				  MLX5_VIRTQ_STATE_SUSPEND,
+		.queue_index = virtq->index,
+	};
+	int ret;
+
+	ret = mlx5_devx_cmd_modify_virtq(virtq->virtq, &attr);
+	if (ret)
+		return ret;
+	virtq->enable = !!enable;
+	return 0;
+}
+
+/**
+ * Move all the created virtqs to the current guest memory mkey, after the
+ * memory table of the guest has changed.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_virtqs_mkey_update(struct mlx5_vdpa_priv *priv)
+{
+	struct mlx5_devx_virtq_attr attr = {
+		.type = MLX5_VIRTQ_MODIFY_TYPE_Q_MKEY,
+		.mkey = priv->gpa_mkey_index,
+	};
+	uint16_t i;
+	int ret;
+
+	for (i = 0; i < priv->nr_virtqs; i++) {
+		if (!priv->virtqs[i].virtq)
+			continue;
+		attr.queue_index = i;
+		ret = mlx5_devx_cmd_modify_virtq(priv->virtqs[i].virtq, &attr);
+		if (ret) {
+			DRV_LOG(ERR, "failed to update mkey of virtq %u", i);
+			return ret;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Translate a host virtual address of the guest memory to its guest
+ * physical address.
+ *
+ * @return
+ *   The guest physical address, 0 if @p hva is not in the guest memory.
+ */
+static uint64_t
+mlx5_vdpa_hva_to_gpa(struct rte_vhost_memory *mem, uint64_t hva)
+{
+	struct rte_vhost_mem_region *reg;
+	uint32_t i;
+
+	for (i = 0; i < mem->nregions; i++) {
+		reg = &mem->regions[i];
+		if (hva >= reg->host_user_addr &&
+		    hva < reg->host_user_addr + reg->size)
+			return hva - reg->host_user_addr +
+			       reg->guest_phys_addr;
+	}
+	return 0;
+}
+
+static int
+mlx5_vdpa_virtq_setup(struct mlx5_vdpa_priv *priv, int index)
+{
+	struct mlx5_vdpa_virtq *virtq = &priv->virtqs[index];
+	struct rte_vhost_vring vq;
+	struct mlx5_devx_virtq_attr attr = {0};
+	const uint32_t umem_params[MLX5_VDPA_VIRTQ_UMEMS_N][2] = {
+		{ priv->caps.umem_1_buffer_param_a,
+		  priv->caps.umem_1_buffer_param_b },
+		{ priv->caps.umem_2_buffer_param_a,
+		  priv->caps.umem_2_buffer_param_b },
+		{ priv->caps.umem_3_buffer_param_a,
+		  priv->caps.umem_3_buffer_param_b },
+	};
+	uint16_t last_avail_idx;
+	uint16_t last_used_idx;
+	uint64_t gpa;
+	unsigned int i;
+	int ret;
+
+	ret = rte_vhost_get_vhost_vring(priv->vid, index, &vq);
+	if (ret) {
+		rte_errno = EINVAL;
+		return -rte_errno;
+	}
+	virtq->index = index;
+	virtq->vq_size = vq.size;
+	virtq->kickfd = vq.kickfd;
+	virtq->priv = priv;
+	attr.tso_ipv4 = !!(priv->features & (1ULL << VIRTIO_NET_F_HOST_TSO4));
+	attr.tso_ipv6 = !!(priv->features & (1ULL << VIRTIO_NET_F_HOST_TSO6));
+	attr.tx_csum = !!(priv->features & (1ULL << VIRTIO_NET_F_CSUM));
+	attr.rx_csum = !!(priv->features & (1ULL << VIRTIO_NET_F_GUEST_CSUM));
+	attr.virtio_version_1_0 = !!(priv->features &
+				     (1ULL << VIRTIO_F_VERSION_1));
+	attr.type = MLX5_VIRTQ_TYPE_SPLIT;
+	/*
+	 * There is no need for an event QP when the guest is in poll mode
+	 * and the device is able to work without one.
+	 */
+	attr.event_mode = vq.callfd != -1 ||
+			  !(priv->caps.event_mode &
+			    (1 << MLX5_VIRTQ_EVENT_MODE_NO_MSIX)) ?
+			  MLX5_VIRTQ_EVENT_MODE_QP :
+			  MLX5_VIRTQ_EVENT_MODE_NO_MSIX;
+	if (attr.event_mode == MLX5_VIRTQ_EVENT_MODE_QP) {
+		ret = mlx5_vdpa_event_qp_create(priv, vq.size, vq.callfd,
+						&virtq->eqp);
+		if (ret) {
+			DRV_LOG(ERR, "failed to create event QPs for virtq %d",
+				index);
+			return -rte_errno;
+		}
+		attr.qp_id = virtq->eqp.fw_qp->id;
+	} else {
+		DRV_LOG(INFO, "virtq %d is in poll mode, no event QP needed",
+			index);
+	}
+	/* Each virtq needs 3 umems sized by the device capabilities. */
+	for (i = 0; i < RTE_DIM(virtq->umems); ++i) {
+		virtq->umems[i].size = umem_params[i][0] * vq.size +
+				       umem_params[i][1];
+		virtq->umems[i].buf = rte_zmalloc(__func__,
+						  virtq->umems[i].size, 4096);
+		if (!virtq->umems[i].buf) {
+			DRV_LOG(ERR, "cannot allocate umem %u memory for virtq"
+				" %u", i, index);
+			rte_errno = ENOMEM;
+			goto error;
+		}
+		virtq->umems[i].obj = mlx5_glue->devx_umem_reg(priv->ctx,
+							virtq->umems[i].buf,
+							virtq->umems[i].size,
+							IBV_ACCESS_LOCAL_WRITE);
+		if (!virtq->umems[i].obj) {
+			DRV_LOG(ERR, "failed to register umem %u for virtq %u",
+				i, index);
+			rte_errno = errno ? errno : ENOMEM;
+			goto error;
+		}
+		attr.umems[i].id = virtq->umems[i].obj->umem_id;
+		attr.umems[i].offset = 0;
+		attr.umems[i].size = virtq->umems[i].size;
+	}
+	gpa = mlx5_vdpa_hva_to_gpa(priv->vmem,
+				   (uint64_t)(uintptr_t)vq.desc);
+	if (!gpa) {
+		DRV_LOG(ERR, "failed to get descriptor ring GPA");
+		rte_errno = EINVAL;
+		goto error;
+	}
+	attr.desc_addr = gpa;
+	gpa = mlx5_vdpa_hva_to_gpa(priv->vmem,
+				   (uint64_t)(uintptr_t)vq.used);
+	if (!gpa) {
+		DRV_LOG(ERR, "failed to get GPA for used ring");
+		rte_errno = EINVAL;
+		goto error;
+	}
+	attr.used_addr = gpa;
+	gpa = mlx5_vdpa_hva_to_gpa(priv->vmem,
+				   (uint64_t)(uintptr_t)vq.avail);
+	if (!gpa) {
+		DRV_LOG(ERR, "failed to get GPA for available ring");
+		rte_errno = EINVAL;
+		goto error;
+	}
+	attr.available_addr = gpa;
+	ret = rte_vhost_get_vring_base(priv->vid, index, &last_avail_idx,
+				       &last_used_idx);
+	if (ret) {
+		last_avail_idx = 0;
+		last_used_idx = 0;
+		DRV_LOG(WARNING, "could not get virtq %d indexes, using 0",
+			index);
+	} else {
+		DRV_LOG(INFO, "virtq %d: last_avail_idx=%d, last_used_idx=%d",
+			index, last_avail_idx, last_used_idx);
+	}
+	attr.hw_available_index = last_avail_idx;
+	attr.hw_used_index = last_used_idx;
+	attr.queue_size = vq.size;
+	attr.mkey = priv->gpa_mkey_index;
+	attr.tis_id = priv->tis->id;
+	attr.queue_index = index;
+	virtq->virtq = mlx5_devx_cmd_create_virtq(priv->ctx, &attr);
+	if (!virtq->virtq)
+		goto error;
+	if (mlx5_vdpa_virtq_enable(virtq, 1))
+		goto error;
+	if (virtq->kickfd >= 0) {
+		virtq->intr_handle.fd = virtq->kickfd;
+		virtq->intr_handle.type = RTE_INTR_HANDLE_EXT;
+		if (rte_intr_callback_register(&virtq->intr_handle,
+					       mlx5_vdpa_virtq_handler,
+					       virtq)) {
+			virtq->intr_handle.fd = 0;
+			DRV_LOG(ERR, "failed to register virtq %d interrupt",
+				index);
+			goto error;
+		}
+		DRV_LOG(DEBUG, "register fd %d interrupt for virtq %d",
+			virtq->intr_handle.fd, index);
+	}
+	return 0;
+error:
+	mlx5_vdpa_virtq_unset(virtq);
+	return -rte_errno;
+}
+
+/**
+ * Create all the hardware virtqs of the negotiated vhost device.
+ *
+ * @param[in] priv
+ *   The vdpa driver private structure.
+ *
+ * @return
+ *   0 on success, a negative errno value otherwise and rte_errno is set.
+ */
+int
+mlx5_vdpa_virtqs_prepare(struct mlx5_vdpa_priv *priv)
+{
+	uint32_t i;
+	uint16_t nr_vring = rte_vhost_get_vring_num(priv->vid);
+	int ret = rte_vhost_get_negotiated_features(priv->vid,
+						    &priv->features);
+
+	if (ret || !nr_vring) {
+		DRV_LOG(ERR, "failed to get negotiated features or vrings");
+		rte_errno = EINVAL;
+		return -rte_errno;
+	}
+	if (priv->features & (1ULL << VIRTIO_F_RING_PACKED)) {
+		DRV_LOG(ERR, "failed to configure PACKED virtq, "
+			"not supported by the driver");
+		rte_errno = ENOTSUP;
+		return -rte_errno;
+	}
+	if (nr_vring > priv->caps.max_num_virtio_queues * 2) {
+		DRV_LOG(ERR, "do not support more than %d virtqs(%d)",
+			(int)priv->caps.max_num_virtio_queues * 2,
+			(int)nr_vring);
+		rte_errno = E2BIG;
+		return -rte_errno;
+	}
+	priv->nr_virtqs = nr_vring;
+	for (i = 0; i < nr_vring; i++)
+		if (mlx5_vdpa_virtq_setup(priv, i))
+			goto error;
+	return 0;
+error:
+	mlx5_vdpa_virtqs_release(priv);
+	return -rte_errno;
+}
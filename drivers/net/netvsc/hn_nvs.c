@@ -455,9 +455,10 @@ hn_nvs_detach(struct hn_data *hv __rte_unused)
 /*
  * Ack the consumed RXBUF associated w/ this channel packet,
  * so that this RXBUF can be recycled by the hypervisor.
+ * If need_sig is not NULL, the caller signals the host later if needed.
  */
 void
-hn_nvs_ack_rxbuf(struct vmbus_channel *chan, uint64_t tid)
+hn_nvs_ack_rxbuf(struct vmbus_channel *chan, uint64_t tid, bool *need_sig)
 {
 	unsigned int retries = 0;
 	struct hn_nvs_rndis_ack ack = {
@@ -471,7 +472,7 @@ hn_nvs_ack_rxbuf(struct vmbus_channel *chan, uint64_t tid)
  again:
 	error = rte_vmbus_chan_send(chan, VMBUS_CHANPKT_TYPE_COMP,
 				    &ack, sizeof(ack), tid,
-				    VMBUS_CHANPKT_FLAG_NONE, NULL);
+				    VMBUS_CHANPKT_FLAG_NONE, need_sig);
 
 	if (error == 0)
 		return;
@@ -26,6 +26,7 @@
 #include <rte_eal.h>
 #include <rte_dev.h>
 #include <rte_net.h>
+#include <rte_prefetch.h>
 #include <rte_bus_vmbus.h>
 #include <rte_spinlock.h>
 
@@ -406,20 +407,20 @@ hn_rndis_rxinfo(const void *info_data, unsigned int info_dlen,
  * Ack the consumed RXBUF associated w/ this channel packet,
  * so that this RXBUF can be recycled by the hypervisor.
  */
-static void hn_rx_buf_release(struct hn_rx_bufinfo *rxb)
+static void hn_rx_buf_release(struct hn_rx_bufinfo *rxb, bool *need_sig)
 {
 	struct rte_mbuf_ext_shared_info *shinfo = &rxb->shinfo;
 	struct hn_data *hv = rxb->hv;
 
 	if (rte_mbuf_ext_refcnt_update(shinfo, -1) == 0) {
-		hn_nvs_ack_rxbuf(rxb->chan, rxb->xactid);
+		hn_nvs_ack_rxbuf(rxb->chan, rxb->xactid, need_sig);
 		--hv->rxbuf_outstanding;
 	}
 }
 
 static void hn_rx_buf_free_cb(void *buf __rte_unused, void *opaque)
 {
-	hn_rx_buf_release(opaque);
+	hn_rx_buf_release(opaque, NULL);
 }
 
 static struct hn_rx_bufinfo *hn_rx_buf_init(const struct hn_rx_queue *rxq,
@@ -438,6 +439,36 @@ static struct hn_rx_bufinfo *hn_rx_buf_init(const struct hn_rx_queue *rxq,
 	return rxb;
 }
 
+/* Get a mbuf from the ones allocated in bulk, refilling them if needed */
+static struct rte_mbuf *hn_rx_mbuf_get(struct hn_rx_queue *rxq)
+{
+	if (unlikely(rxq->mbuf_avail == 0)) {
+		if (rte_pktmbuf_alloc_bulk(rxq->mb_pool, rxq->mbufs,
+					   HN_RX_BULK) != 0)
+			return NULL;
+		rxq->mbuf_avail = HN_RX_BULK;
+	}
+	return rxq->mbufs[--rxq->mbuf_avail];
+}
+
+/* Put the staged packets on the staging ring */
+static void hn_rx_flush(struct hn_rx_queue *rxq)
+{
+	unsigned int n;
+
+	if (rxq->pkt_staged == 0)
+		return;
+
+	n = rte_ring_sp_enqueue_burst(rxq->rx_ring, (void **)rxq->pkts,
+				      rxq->pkt_staged, NULL);
+	if (unlikely(n < rxq->pkt_staged)) {
+		rxq->stats.ring_full += rxq->pkt_staged - n;
+		while (n < rxq->pkt_staged)
+			rte_pktmbuf_free(rxq->pkts[n++]);
+	}
+	rxq->pkt_staged = 0;
+}
+
 static void hn_rxpkt(struct hn_rx_queue *rxq, struct hn_rx_bufinfo *rxb,
 		     uint8_t *data, unsigned int headroom, unsigned int dlen,
 		     const struct hn_rxinfo *info)
@@ -445,7 +476,7 @@ static void hn_rxpkt(struct hn_rx_queue *rxq, struct hn_rx_bufinfo *rxb,
 	struct hn_data *hv = rxq->hv;
 	struct rte_mbuf *m;
 
-	m = rte_pktmbuf_alloc(rxq->mb_pool);
+	m = hn_rx_mbuf_get(rxq);
 	if (unlikely(!m)) {
 		struct rte_eth_dev *dev =
 			&rte_eth_devices[rxq->port_id];
@@ -529,10 +560,9 @@ static void hn_rxpkt(struct hn_rx_queue *rxq, struct hn_rx_bufinfo *rxb,
 	rxq->stats.bytes += m->pkt_len;
 	hn_update_packet_stats(&rxq->stats, m);
 
-	if (unlikely(rte_ring_sp_enqueue(rxq->rx_ring, m) != 0)) {
-		++rxq->stats.ring_full;
-		rte_pktmbuf_free(m);
-	}
+	rxq->pkts[rxq->pkt_staged++] = m;
+	if (rxq->pkt_staged == HN_RX_BULK)
+		hn_rx_flush(rxq);
 }
 
 static void hn_rndis_rx_data(struct hn_rx_queue *rxq,
@@ -577,6 +607,9 @@ static void hn_rndis_rx_data(struct hn_rx_queue *rxq,
 	pktinfo_off = RNDIS_PACKET_MSG_OFFSET_ABS(pkt->pktinfooffset);
 	pktinfo_len = pkt->pktinfolen;
 
+	/* Packet headers are parsed for ptype while pktinfo is decoded */
+	rte_prefetch0((const uint8_t *)pkt + data_off);
+
 	if (likely(pktinfo_len > 0)) {
 		err = hn_rndis_rxinfo((const uint8_t *)pkt + pktinfo_off,
 				      pktinfo_len, &info);
@@ -631,7 +664,7 @@ hn_nvs_handle_rxbuf(struct rte_eth_dev *dev,
 		    struct hn_data *hv,
 		    struct hn_rx_queue *rxq,
 		    const struct vmbus_chanpkt_hdr *hdr,
-		    const void *buf)
+		    const void *buf, bool *need_sig)
 {
 	const struct vmbus_chanpkt_rxbuf *pkt;
 	const struct hn_nvs_hdr *nvs_hdr = buf;
@@ -689,6 +722,10 @@ hn_nvs_handle_rxbuf(struct rte_eth_dev *dev,
 		ofs = pkt->rxbuf[i].ofs;
 		len = pkt->rxbuf[i].len;
 
+		/* Fetch next RNDIS header while this one is parsed */
+		if (i + 1 < count && pkt->rxbuf[i + 1].ofs < rxbuf_sz)
+			rte_prefetch0(rxbuf + pkt->rxbuf[i + 1].ofs);
+
 		if (unlikely(ofs + len > rxbuf_sz)) {
 			PMD_RX_LOG(ERR,
 				   "%uth RNDIS msg overflow ofs %u, len %u",
@@ -705,8 +742,10 @@ hn_nvs_handle_rxbuf(struct rte_eth_dev *dev,
 				 rxbuf + ofs, len);
 	}
 
+	hn_rx_flush(rxq);
+
 	/* Send ACK now if external mbuf not used */
-	hn_rx_buf_release(rxb);
+	hn_rx_buf_release(rxb, need_sig);
 }
 
 /*
@@ -833,6 +872,8 @@ hn_dev_rx_queue_release(void *arg)
 
 	rte_ring_free(rxq->rx_ring);
 	rxq->rx_ring = NULL;
+	while (rxq->mbuf_avail > 0)
+		rte_pktmbuf_free(rxq->mbufs[--rxq->mbuf_avail]);
 	rxq->mb_pool = NULL;
 
 	hn_vf_rx_queue_release(rxq->hv, rxq->queue_id);
@@ -863,6 +904,7 @@ uint32_t hn_process_events(struct hn_data *hv, uint16_t queue_id,
 	struct hn_rx_queue *rxq;
 	uint32_t bytes_read = 0;
 	uint32_t tx_done = 0;
+	bool need_sig = false;
 	int ret = 0;
 
 	rxq = queue_id == 0 ? hv->primary : dev->data->rx_queues[queue_id];
@@ -920,7 +962,8 @@ uint32_t hn_process_events(struct hn_data *hv, uint16_t queue_id,
 			break;
 
 		case VMBUS_CHANPKT_TYPE_RXBUF:
-			hn_nvs_handle_rxbuf(dev, hv, rxq, pkt, data);
+			hn_nvs_handle_rxbuf(dev, hv, rxq, pkt, data,
+					    &need_sig);
 			break;
 
 		case VMBUS_CHANPKT_TYPE_INBAND:
@@ -942,6 +985,10 @@ uint32_t hn_process_events(struct hn_data *hv, uint16_t queue_id,
 	if (bytes_read > 0)
 		rte_vmbus_chan_signal_read(rxq->chan, bytes_read);
 
+	/* Signal the host once for all the RXBUF acks */
+	if (need_sig)
+		rte_vmbus_chan_signal_tx(rxq->chan);
+
 	rte_spinlock_unlock(&rxq->ring_lock);
 
 	return tx_done;
@@ -23,6 +23,9 @@
 /* Host monitor interval */
 #define HN_CHAN_LATENCY_NS	50000
 
+/* Number of mbufs allocated and of packets staged at once on receive */
+#define HN_RX_BULK		32
+
 /* Buffers need to be aligned */
 #ifndef PAGE_SIZE
 #define PAGE_SIZE 4096
@@ -80,6 +83,13 @@ struct hn_rx_queue {
 	struct hn_stats stats;
 
 	void *event_buf;
+
+	/* Mbufs allocated in bulk, used from the end */
+	uint16_t	mbuf_avail;
+	/* Received packets staged before being put on rx_ring */
+	uint16_t	pkt_staged;
+	struct rte_mbuf *mbufs[HN_RX_BULK];
+	struct rte_mbuf *pkts[HN_RX_BULK];
 };
 
 
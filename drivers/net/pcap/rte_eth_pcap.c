@@ -6,9 +6,12 @@
 
 #include <time.h>
 
+#include <fcntl.h>
 #include <net/if.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #if defined(RTE_EXEC_ENV_BSDAPP)
@@ -26,6 +29,7 @@
 #include <rte_mbuf.h>
 #include <rte_bus_vdev.h>
 #include <rte_string_fns.h>
+#include <rte_byteorder.h>
 
 #define RTE_ETH_PCAP_SNAPSHOT_LEN 65535
 #define RTE_ETH_PCAP_SNAPLEN ETHER_MAX_JUMBO_FRAME_LEN
@@ -39,6 +43,8 @@
 #define ETH_PCAP_TX_IFACE_ARG "tx_iface"
 #define ETH_PCAP_IFACE_ARG    "iface"
 #define ETH_PCAP_PHY_MAC_ARG  "phy_mac"
+#define ETH_PCAP_INFINITE_RX_ARG "infinite_rx"
+#define ETH_PCAP_RX_PACE_ARG  "rx_pace"
 
 #define ETH_PCAP_ARG_MAXLEN	64
 
@@ -84,7 +90,28 @@ struct pmd_internals {
 	int phy_mac;
 };
 
+/* Packet of a pcap file replayed from memory */
+struct pcap_replay_pkt {
+	const u_char *data;
+	uint32_t len;
+	uint64_t tsc; /* time to send, relative to the first packet */
+};
+
+/* Pcap file memory mapped and indexed for its replay */
+struct pcap_replay {
+	void *map;
+	size_t map_len;
+	struct pcap_replay_pkt *pkts;
+	uint32_t nb_pkts;
+	uint32_t next;
+	int infinite;
+	int paced;
+	uint64_t period; /* duration of a pass, in TSC cycles */
+	uint64_t base; /* TSC of the start of the current pass */
+};
+
 struct pmd_process_private {
+	struct pcap_replay *rx_replay[RTE_PMD_PCAP_MAX_QUEUES];
 	pcap_t *rx_pcap[RTE_PMD_PCAP_MAX_QUEUES];
 	pcap_t *tx_pcap[RTE_PMD_PCAP_MAX_QUEUES];
 	pcap_dumper_t *tx_dumper[RTE_PMD_PCAP_MAX_QUEUES];
@@ -99,6 +126,8 @@ struct pmd_devargs {
 		const char *type;
 	} queue[RTE_PMD_PCAP_MAX_QUEUES];
 	int phy_mac;
+	int infinite_rx;
+	double rx_pace;
 };
 
 static const char *valid_arguments[] = {
@@ -109,6 +138,8 @@ static const char *valid_arguments[] = {
 	ETH_PCAP_TX_IFACE_ARG,
 	ETH_PCAP_IFACE_ARG,
 	ETH_PCAP_PHY_MAC_ARG,
+	ETH_PCAP_INFINITE_RX_ARG,
+	ETH_PCAP_RX_PACE_ARG,
 	NULL
 };
 
@@ -178,6 +209,68 @@ eth_pcap_gather_data(unsigned char *data, struct rte_mbuf *mbuf)
 	}
 }
 
+/*
+ * Receive the packets of a replayed pcap file, from memory. When paced,
+ * a packet is received once the time elapsed since the start of the pass
+ * reaches its recorded time.
+ */
+static uint16_t
+eth_pcap_rx_replay(struct pcap_rx_queue *pcap_q, struct pcap_replay *replay,
+		struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	const struct pcap_replay_pkt *pkt;
+	struct rte_mbuf *mbuf;
+	uint16_t num_rx = 0;
+	uint16_t buf_size;
+	uint32_t rx_bytes = 0;
+	uint64_t now = 0;
+
+	if (replay->paced)
+		now = rte_rdtsc();
+
+	buf_size = rte_pktmbuf_data_room_size(pcap_q->mb_pool) -
+			RTE_PKTMBUF_HEADROOM;
+
+	while (num_rx < nb_pkts) {
+		if (unlikely(replay->next == replay->nb_pkts)) {
+			if (!replay->infinite)
+				break;
+			replay->next = 0;
+			replay->base += replay->period;
+		}
+
+		pkt = &replay->pkts[replay->next];
+		if (replay->paced &&
+				(int64_t)(now - replay->base) <
+				(int64_t)pkt->tsc)
+			break;
+
+		mbuf = rte_pktmbuf_alloc(pcap_q->mb_pool);
+		if (unlikely(mbuf == NULL))
+			break;
+
+		if (pkt->len <= buf_size) {
+			rte_memcpy(rte_pktmbuf_mtod(mbuf, void *), pkt->data,
+					pkt->len);
+			mbuf->data_len = (uint16_t)pkt->len;
+		} else if (unlikely(eth_pcap_rx_jumbo(pcap_q->mb_pool, mbuf,
+				pkt->data, pkt->len) == -1)) {
+			rte_pktmbuf_free(mbuf);
+			break;
+		}
+
+		mbuf->pkt_len = pkt->len;
+		mbuf->port = pcap_q->port_id;
+		bufs[num_rx++] = mbuf;
+		rx_bytes += pkt->len;
+		replay->next++;
+	}
+	pcap_q->rx_stat.pkts += num_rx;
+	pcap_q->rx_stat.bytes += rx_bytes;
+
+	return num_rx;
+}
+
 static uint16_t
 eth_pcap_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 {
@@ -193,6 +286,10 @@ eth_pcap_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	pcap_t *pcap;
 
 	pp = rte_eth_devices[pcap_q->port_id].process_private;
+	if (pp->rx_replay[pcap_q->queue_id] != NULL)
+		return eth_pcap_rx_replay(pcap_q,
+				pp->rx_replay[pcap_q->queue_id], bufs, nb_pkts);
+
 	pcap = pp->rx_pcap[pcap_q->queue_id];
 
 	if (unlikely(pcap == NULL || nb_pkts == 0))
@@ -447,12 +544,181 @@ open_single_rx_pcap(const char *pcap_filename, pcap_t **pcap)
 	return 0;
 }
 
+/* Headers of the pcap file format */
+struct replay_file_hdr {
+	uint32_t magic;
+	uint16_t version_major;
+	uint16_t version_minor;
+	int32_t thiszone;
+	uint32_t sigfigs;
+	uint32_t snaplen;
+	uint32_t linktype;
+};
+
+struct replay_pkt_hdr {
+	uint32_t ts_sec;
+	uint32_t ts_frac;
+	uint32_t caplen;
+	uint32_t len;
+};
+
+#define REPLAY_MAGIC_USEC 0xa1b2c3d4
+#define REPLAY_MAGIC_NSEC 0xa1b23c4d
+#define REPLAY_NS_PER_S 1000000000ULL
+
+static void
+close_rx_replay(struct pcap_replay *replay)
+{
+	if (replay == NULL)
+		return;
+	munmap(replay->map, replay->map_len);
+	rte_free(replay->pkts);
+	rte_free(replay);
+}
+
+/*
+ * Memory map a pcap file and index its packets, with their time to be
+ * received in TSC cycles when paced at rx_pace times the recorded rate.
+ */
+static int
+open_rx_replay(const char *pcap_filename, int infinite, double pace,
+		struct pcap_replay **replay_out)
+{
+	const struct replay_file_hdr *fhdr;
+	const struct replay_pkt_hdr *phdr;
+	struct pcap_replay *replay;
+	struct stat st;
+	const u_char *cur, *end;
+	uint64_t ns, first_ns = 0, last_tsc = 0;
+	uint32_t caplen, frac_ns, nb_pkts;
+	double tsc_per_ns;
+	int swapped;
+	int fd;
+
+	replay = rte_zmalloc(NULL, sizeof(*replay), 0);
+	if (replay == NULL)
+		return -1;
+	replay->map = MAP_FAILED;
+	replay->infinite = infinite;
+	replay->paced = pace > 0;
+
+	fd = open(pcap_filename, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0 ||
+			(size_t)st.st_size < sizeof(*fhdr)) {
+		PMD_LOG(ERR, "Couldn't open %s for replay", pcap_filename);
+		goto error;
+	}
+
+	replay->map_len = st.st_size;
+	replay->map = mmap(NULL, replay->map_len, PROT_READ,
+#ifdef MAP_POPULATE
+			MAP_PRIVATE | MAP_POPULATE,
+#else
+			MAP_PRIVATE,
+#endif
+			fd, 0);
+	close(fd);
+	fd = -1;
+	if (replay->map == MAP_FAILED) {
+		PMD_LOG(ERR, "Couldn't map %s", pcap_filename);
+		goto error;
+	}
+
+	fhdr = replay->map;
+	swapped = fhdr->magic == rte_bswap32(REPLAY_MAGIC_USEC) ||
+		fhdr->magic == rte_bswap32(REPLAY_MAGIC_NSEC);
+	switch (swapped ? rte_bswap32(fhdr->magic) : fhdr->magic) {
+	case REPLAY_MAGIC_USEC:
+		frac_ns = 1000;
+		break;
+	case REPLAY_MAGIC_NSEC:
+		frac_ns = 1;
+		break;
+	default:
+		PMD_LOG(ERR, "%s is not a pcap file, cannot be replayed",
+			pcap_filename);
+		goto error;
+	}
+
+	/* count the packets, then index them */
+	end = (const u_char *)replay->map + replay->map_len;
+	nb_pkts = 0;
+	for (cur = (const u_char *)(fhdr + 1);
+			cur + sizeof(*phdr) <= end;
+			cur += sizeof(*phdr) + caplen) {
+		phdr = (const struct replay_pkt_hdr *)cur;
+		caplen = swapped ? rte_bswap32(phdr->caplen) : phdr->caplen;
+		if (caplen > RTE_ETH_PCAP_SNAPSHOT_LEN ||
+				cur + sizeof(*phdr) + caplen > end)
+			break;
+		nb_pkts++;
+	}
+	if (nb_pkts == 0) {
+		PMD_LOG(ERR, "No packet to replay in %s", pcap_filename);
+		goto error;
+	}
+
+	replay->pkts = rte_malloc(NULL, nb_pkts * sizeof(*replay->pkts), 0);
+	if (replay->pkts == NULL)
+		goto error;
+
+	tsc_per_ns = replay->paced ? (double)rte_get_tsc_hz() / 1E9 / pace : 0;
+	cur = (const u_char *)(fhdr + 1);
+	for (replay->nb_pkts = 0; replay->nb_pkts < nb_pkts;
+			replay->nb_pkts++) {
+		struct pcap_replay_pkt *pkt = &replay->pkts[replay->nb_pkts];
+
+		phdr = (const struct replay_pkt_hdr *)cur;
+		if (swapped) {
+			caplen = rte_bswap32(phdr->caplen);
+			ns = rte_bswap32(phdr->ts_sec) * REPLAY_NS_PER_S +
+				(uint64_t)rte_bswap32(phdr->ts_frac) * frac_ns;
+		} else {
+			caplen = phdr->caplen;
+			ns = phdr->ts_sec * REPLAY_NS_PER_S +
+				(uint64_t)phdr->ts_frac * frac_ns;
+		}
+		if (replay->nb_pkts == 0)
+			first_ns = ns;
+
+		pkt->data = cur + sizeof(*phdr);
+		pkt->len = caplen;
+		/* out of order timestamps are sent without delay */
+		pkt->tsc = ns > first_ns ? (uint64_t)((ns - first_ns) *
+				tsc_per_ns) : 0;
+		pkt->tsc = RTE_MAX(pkt->tsc, last_tsc);
+		last_tsc = pkt->tsc;
+		cur += sizeof(*phdr) + caplen;
+	}
+
+	/* the next pass starts an average gap after the last packet */
+	replay->period = last_tsc +
+		(nb_pkts > 1 ? last_tsc / (nb_pkts - 1) : 1);
+
+	PMD_LOG(INFO, "Replaying %u packets of %s%s", nb_pkts, pcap_filename,
+		infinite ? " in loop" : "");
+	*replay_out = replay;
+	return 0;
+
+error:
+	if (fd >= 0)
+		close(fd);
+	if (replay->map == MAP_FAILED)
+		replay->map_len = 0;
+	if (replay->map_len != 0)
+		munmap(replay->map, replay->map_len);
+	rte_free(replay->pkts);
+	rte_free(replay);
+	return -1;
+}
+
 static int
 eth_dev_start(struct rte_eth_dev *dev)
 {
 	unsigned int i;
 	struct pmd_internals *internals = dev->data->dev_private;
 	struct pmd_process_private *pp = dev->process_private;
+	struct pcap_replay *replay;
 	struct pcap_tx_queue *tx;
 	struct pcap_rx_queue *rx;
 
@@ -504,8 +770,16 @@ eth_dev_start(struct rte_eth_dev *dev)
 	}
 
 status_up:
-	for (i = 0; i < dev->data->nb_rx_queues; i++)
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		replay = pp->rx_replay[i];
+		/* pacing restarts from the next packet */
+		if (replay != NULL)
+			replay->base = rte_rdtsc() -
+				(replay->next < replay->nb_pkts ?
+				 replay->pkts[replay->next].tsc :
+				 replay->period);
 		dev->data->rx_queue_state[i] = RTE_ETH_QUEUE_STATE_STARTED;
+	}
 
 	for (i = 0; i < dev->data->nb_tx_queues; i++)
 		dev->data->tx_queue_state[i] = RTE_ETH_QUEUE_STATE_STARTED;
@@ -908,6 +1182,37 @@ select_phy_mac(const char *key __rte_unused, const char *value,
 	return 0;
 }
 
+static int
+get_infinite_rx_arg(const char *key __rte_unused, const char *value,
+		void *extra_args)
+{
+	int *infinite_rx = extra_args;
+
+	*infinite_rx = atoi(value);
+	if (*infinite_rx < 0 || *infinite_rx > 1) {
+		PMD_LOG(ERR, "Invalid %s value, must be 0 or 1",
+			ETH_PCAP_INFINITE_RX_ARG);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+get_rx_pace_arg(const char *key __rte_unused, const char *value,
+		void *extra_args)
+{
+	double *rx_pace = extra_args;
+	char *end;
+
+	*rx_pace = strtod(value, &end);
+	if (*end != '\0' || !(*rx_pace > 0)) {
+		PMD_LOG(ERR, "Invalid %s value, must be a positive speed factor",
+			ETH_PCAP_RX_PACE_ARG);
+		return -1;
+	}
+	return 0;
+}
+
 static struct rte_vdev_driver pmd_pcap_drv;
 
 static int
@@ -1086,6 +1391,13 @@ eth_from_pcaps_common(struct rte_vdev_device *vdev,
 		pp->rx_pcap[i] = queue->pcap;
 		snprintf(rx->name, sizeof(rx->name), "%s", queue->name);
 		snprintf(rx->type, sizeof(rx->type), "%s", queue->type);
+
+		if ((rx_queues->infinite_rx || rx_queues->rx_pace > 0) &&
+				strcmp(rx->type, ETH_PCAP_RX_PCAP_ARG) == 0 &&
+				open_rx_replay(rx->name, rx_queues->infinite_rx,
+					rx_queues->rx_pace,
+					&pp->rx_replay[i]) < 0)
+			goto error;
 	}
 
 	for (i = 0; i < nb_tx_queues; i++) {
@@ -1099,6 +1411,16 @@ eth_from_pcaps_common(struct rte_vdev_device *vdev,
 	}
 
 	return 0;
+
+error:
+	for (i = 0; i < nb_rx_queues; i++)
+		close_rx_replay(pp->rx_replay[i]);
+	rte_free(pp);
+	(*eth_dev)->process_private = NULL;
+	/* not dynamically allocated, must not be freed */
+	(*eth_dev)->data->mac_addrs = NULL;
+	rte_eth_dev_release_port(*eth_dev);
+	return -1;
 }
 
 static int
@@ -1227,6 +1549,25 @@ pmd_pcap_probe(struct rte_vdev_device *dev)
 	if (ret < 0)
 		goto free_kvlist;
 
+	/* Replay of the Rx pcap files from memory */
+	ret = rte_kvargs_process(kvlist, ETH_PCAP_INFINITE_RX_ARG,
+			&get_infinite_rx_arg, &pcaps.infinite_rx);
+	if (ret < 0)
+		goto free_kvlist;
+
+	ret = rte_kvargs_process(kvlist, ETH_PCAP_RX_PACE_ARG,
+			&get_rx_pace_arg, &pcaps.rx_pace);
+	if (ret < 0)
+		goto free_kvlist;
+
+	if ((pcaps.infinite_rx || pcaps.rx_pace > 0) && !is_rx_pcap) {
+		PMD_LOG(ERR, "%s and %s require %s",
+			ETH_PCAP_INFINITE_RX_ARG, ETH_PCAP_RX_PACE_ARG,
+			ETH_PCAP_RX_PCAP_ARG);
+		ret = -1;
+		goto free_kvlist;
+	}
+
 	/*
 	 * We check whether we want to open a TX stream to a real NIC or a
 	 * pcap file
@@ -1317,6 +1658,13 @@ pmd_pcap_remove(struct rte_vdev_device *dev)
 			eth_dev->data->mac_addrs = NULL;
 	}
 
+	if (eth_dev->process_private != NULL) {
+		struct pmd_process_private *pp = eth_dev->process_private;
+		unsigned int i;
+
+		for (i = 0; i < RTE_PMD_PCAP_MAX_QUEUES; i++)
+			close_rx_replay(pp->rx_replay[i]);
+	}
 	rte_free(eth_dev->process_private);
 	rte_eth_dev_release_port(eth_dev);
 
@@ -1337,7 +1685,9 @@ RTE_PMD_REGISTER_PARAM_STRING(net_pcap,
 	ETH_PCAP_RX_IFACE_IN_ARG "=<ifc> "
 	ETH_PCAP_TX_IFACE_ARG "=<ifc> "
 	ETH_PCAP_IFACE_ARG "=<ifc> "
-	ETH_PCAP_PHY_MAC_ARG "=<int>");
+	ETH_PCAP_PHY_MAC_ARG "=<int> "
+	ETH_PCAP_INFINITE_RX_ARG "=<0|1> "
+	ETH_PCAP_RX_PACE_ARG "=<float>");
 
 RTE_INIT(eth_pcap_init_log)
 {
@@ -164,10 +164,12 @@ pmd_dev_stop(struct rte_eth_dev *dev)
 	dev->data->dev_link.link_status = ETH_LINK_DOWN;
 
 	/* Firmware */
+	softnic_thread_autoscale_config(p, 0, 0, 0);
 	softnic_pipeline_disable_all(p);
 	softnic_pipeline_free(p);
 	softnic_table_action_profile_free(p);
 	softnic_port_in_action_profile_free(p);
+	softnic_vhost_free(p);
 	softnic_tap_free(p);
 	softnic_tmgr_free(p);
 	softnic_link_free(p);
@@ -222,6 +224,94 @@ pmd_mtr_ops_get(struct rte_eth_dev *dev __rte_unused, void *arg)
 	return 0;
 }
 
+/* Pipeline load xstats, per pipeline */
+static const char * const pmd_xstats_pipeline_names[] = {
+	"load_pkts",
+	"load_cycles",
+	"load_cycles_busy",
+};
+
+#define PMD_XSTATS_PIPELINE_N RTE_DIM(pmd_xstats_pipeline_names)
+
+static int
+pmd_xstats_get_names(struct rte_eth_dev *dev,
+	struct rte_eth_xstat_name *xstats_names,
+	unsigned int size)
+{
+	struct pmd_internals *p = dev->data->dev_private;
+	struct pipeline *pipeline;
+	unsigned int n = 1, i;
+
+	TAILQ_FOREACH(pipeline, &p->pipeline_list, node)
+		n += PMD_XSTATS_PIPELINE_N;
+
+	if (xstats_names == NULL || size < n)
+		return n;
+
+	n = 0;
+	snprintf(xstats_names[n++].name, RTE_ETH_XSTATS_NAME_SIZE,
+		"autoscale_moves");
+	TAILQ_FOREACH(pipeline, &p->pipeline_list, node)
+		for (i = 0; i < PMD_XSTATS_PIPELINE_N; i++)
+			snprintf(xstats_names[n++].name,
+				RTE_ETH_XSTATS_NAME_SIZE, "%s_%s",
+				pipeline->name, pmd_xstats_pipeline_names[i]);
+
+	return n;
+}
+
+static int
+pmd_xstats_get(struct rte_eth_dev *dev,
+	struct rte_eth_xstat *xstats,
+	unsigned int n)
+{
+	struct pmd_internals *p = dev->data->dev_private;
+	struct pipeline *pipeline;
+	unsigned int count = 1;
+
+	TAILQ_FOREACH(pipeline, &p->pipeline_list, node)
+		count += PMD_XSTATS_PIPELINE_N;
+
+	if (xstats == NULL || n < count)
+		return count;
+
+	count = 0;
+	xstats[count].id = count;
+	xstats[count++].value = p->autoscale.n_moves;
+	TAILQ_FOREACH(pipeline, &p->pipeline_list, node) {
+		struct softnic_pipeline_load load;
+		uint64_t n_cycles_elapsed;
+
+		softnic_pipeline_load_read(pipeline, &load, &n_cycles_elapsed,
+			0);
+
+		xstats[count].id = count;
+		xstats[count++].value = load.n_pkts;
+		xstats[count].id = count;
+		xstats[count++].value = load.n_cycles;
+		xstats[count].id = count;
+		xstats[count++].value = load.n_cycles_busy;
+	}
+
+	return count;
+}
+
+static void
+pmd_xstats_reset(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *p = dev->data->dev_private;
+	struct pipeline *pipeline;
+
+	p->autoscale.n_moves = 0;
+	TAILQ_FOREACH(pipeline, &p->pipeline_list, node) {
+		struct softnic_pipeline_load load;
+		uint64_t n_cycles_elapsed;
+
+		softnic_pipeline_load_read(pipeline, &load, &n_cycles_elapsed,
+			1);
+	}
+}
+
 static const struct eth_dev_ops pmd_ops = {
 	.dev_configure = pmd_dev_configure,
 	.dev_start = pmd_dev_start,
@@ -231,6 +321,9 @@ static const struct eth_dev_ops pmd_ops = {
 	.dev_infos_get = pmd_dev_infos_get,
 	.rx_queue_setup = pmd_rx_queue_setup,
 	.tx_queue_setup = pmd_tx_queue_setup,
+	.xstats_get = pmd_xstats_get,
+	.xstats_get_names = pmd_xstats_get_names,
+	.xstats_reset = pmd_xstats_reset,
 	.filter_ctrl = pmd_filter_ctrl,
 	.tm_ops_get = pmd_tm_ops_get,
 	.mtr_ops_get = pmd_mtr_ops_get,
@@ -283,6 +376,7 @@ pmd_init(struct pmd_params *params)
 	softnic_link_init(p);
 	softnic_tmgr_init(p);
 	softnic_tap_init(p);
+	softnic_vhost_init(p);
 	softnic_cryptodev_init(p);
 	softnic_port_in_action_profile_init(p);
 	softnic_table_action_profile_init(p);
@@ -325,6 +419,7 @@ pmd_free(struct pmd_internals *p)
 	softnic_pipeline_free(p);
 	softnic_table_action_profile_free(p);
 	softnic_port_in_action_profile_free(p);
+	softnic_vhost_free(p);
 	softnic_tap_free(p);
 	softnic_tmgr_free(p);
 	softnic_link_free(p);
@@ -603,5 +698,7 @@ rte_pmd_softnic_manage(uint16_t port_id)
 
 	softnic_conn_poll_for_msg(softnic->conn);
 
+	softnic_thread_autoscale(softnic);
+
 	return 0;
 }
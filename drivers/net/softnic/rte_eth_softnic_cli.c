@@ -1090,6 +1090,51 @@ cmd_tap(struct pmd_internals *softnic,
 	}
 }
 
+/**
+ * vhost <vhost_name> path <socket_path> [client]
+ */
+static void
+cmd_vhost(struct pmd_internals *softnic,
+	char **tokens,
+	uint32_t n_tokens,
+	char *out,
+	size_t out_size)
+{
+	struct softnic_vhost_params p;
+	char *name;
+	struct softnic_vhost *vhost;
+
+	memset(&p, 0, sizeof(p));
+	if (n_tokens != 4 && n_tokens != 5) {
+		snprintf(out, out_size, MSG_ARG_MISMATCH, tokens[0]);
+		return;
+	}
+
+	name = tokens[1];
+
+	if (strcmp(tokens[2], "path") != 0) {
+		snprintf(out, out_size, MSG_ARG_NOT_FOUND, "path");
+		return;
+	}
+
+	p.path = tokens[3];
+
+	if (n_tokens == 5) {
+		if (strcmp(tokens[4], "client") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND, "client");
+			return;
+		}
+
+		p.client = 1;
+	}
+
+	vhost = softnic_vhost_create(softnic, name, &p);
+	if (vhost == NULL) {
+		snprintf(out, out_size, MSG_CMD_FAIL, tokens[0]);
+		return;
+	}
+}
+
 /**
  * cryptodev <tap_name> dev <device_name> | dev_id <device_id>
  * queue <n_queues> <queue_size>
@@ -1812,6 +1857,7 @@ cmd_pipeline(struct pmd_internals *softnic,
  *  | tap <tap_name> mempool <mempool_name> mtu <mtu>
  *  | source mempool <mempool_name> file <file_name> bpp <n_bytes_per_pkt>
  *  | cryptodev <cryptodev_name> rxq <queue_id>
+ *  | vhost <vhost_name> queue <queue_id> mempool <mempool_name>
  *  [action <port_in_action_profile_name>]
  *  [disabled]
  */
@@ -1997,6 +2043,38 @@ cmd_pipeline_port_in(struct pmd_internals *softnic,
 		p.cryptodev.f_callback = NULL;
 
 		t0 += 4;
+	} else if (strcmp(tokens[t0], "vhost") == 0) {
+		if (n_tokens < t0 + 6) {
+			snprintf(out, out_size, MSG_ARG_MISMATCH,
+				"pipeline port in vhost");
+			return;
+		}
+
+		p.type = PORT_IN_VHOST;
+
+		strlcpy(p.dev_name, tokens[t0 + 1], sizeof(p.dev_name));
+
+		if (strcmp(tokens[t0 + 2], "queue") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND, "queue");
+			return;
+		}
+
+		if (softnic_parser_read_uint16(&p.vhost.queue_id,
+				tokens[t0 + 3]) != 0) {
+			snprintf(out, out_size, MSG_ARG_INVALID,
+				"queue_id");
+			return;
+		}
+
+		if (strcmp(tokens[t0 + 4], "mempool") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND,
+				"mempool");
+			return;
+		}
+
+		p.vhost.mempool_name = tokens[t0 + 5];
+
+		t0 += 6;
 	} else {
 		snprintf(out, out_size, MSG_ARG_INVALID, tokens[0]);
 		return;
@@ -2047,6 +2125,7 @@ cmd_pipeline_port_in(struct pmd_internals *softnic,
  *  | tap <tap_name>
  *  | sink [file <file_name> pkts <max_n_pkts>]
  *  | cryptodev <cryptodev_name> txq <txq_id> offset <crypto_op_offset>
+ *  | vhost <vhost_name> queue <queue_id>
  */
 static void
 cmd_pipeline_port_out(struct pmd_internals *softnic,
@@ -2205,6 +2284,27 @@ cmd_pipeline_port_out(struct pmd_internals *softnic,
 			snprintf(out, out_size, MSG_ARG_INVALID, "queue_id");
 			return;
 		}
+	} else if (strcmp(tokens[6], "vhost") == 0) {
+		if (n_tokens != 10) {
+			snprintf(out, out_size, MSG_ARG_MISMATCH,
+				"pipeline port out vhost");
+			return;
+		}
+
+		p.type = PORT_OUT_VHOST;
+
+		strlcpy(p.dev_name, tokens[7], sizeof(p.dev_name));
+
+		if (strcmp(tokens[8], "queue") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND, "queue");
+			return;
+		}
+
+		if (softnic_parser_read_uint16(&p.vhost.queue_id,
+				tokens[9]) != 0) {
+			snprintf(out, out_size, MSG_ARG_INVALID, "queue_id");
+			return;
+		}
 	} else {
 		snprintf(out, out_size, MSG_ARG_INVALID, tokens[0]);
 		return;
@@ -2560,6 +2660,72 @@ cmd_pipeline_port_in_table(struct pmd_internals *softnic,
 	}
 }
 
+/**
+ * pipeline <pipeline_name> load read [clear]
+ */
+
+#define MSG_PIPELINE_LOAD                                  \
+	"Thread: %u\n"                                     \
+	"Pkts in: %" PRIu64 "\n"                           \
+	"Cycles: %" PRIu64 "\n"                            \
+	"Cycles busy: %" PRIu64 "\n"                       \
+	"Load: %" PRIu64 " %%\n"
+
+static void
+cmd_pipeline_load(struct pmd_internals *softnic,
+	char **tokens,
+	uint32_t n_tokens,
+	char *out,
+	size_t out_size)
+{
+	struct softnic_pipeline_load load;
+	struct pipeline *p;
+	uint64_t n_cycles_elapsed;
+	int clear;
+
+	if (n_tokens != 4 &&
+		n_tokens != 5) {
+		snprintf(out, out_size, MSG_ARG_MISMATCH, tokens[0]);
+		return;
+	}
+
+	p = softnic_pipeline_find(softnic, tokens[1]);
+	if (p == NULL) {
+		snprintf(out, out_size, MSG_ARG_INVALID, "pipeline_name");
+		return;
+	}
+
+	if (strcmp(tokens[2], "load") != 0) {
+		snprintf(out, out_size, MSG_ARG_NOT_FOUND, "load");
+		return;
+	}
+
+	if (strcmp(tokens[3], "read") != 0) {
+		snprintf(out, out_size, MSG_ARG_NOT_FOUND, "read");
+		return;
+	}
+
+	clear = 0;
+	if (n_tokens == 5) {
+		if (strcmp(tokens[4], "clear") != 0) {
+			snprintf(out, out_size, MSG_ARG_INVALID, "clear");
+			return;
+		}
+
+		clear = 1;
+	}
+
+	softnic_pipeline_load_read(p, &load, &n_cycles_elapsed, clear);
+
+	snprintf(out, out_size, MSG_PIPELINE_LOAD,
+		p->thread_id,
+		load.n_pkts,
+		load.n_cycles,
+		load.n_cycles_busy,
+		n_cycles_elapsed ?
+			(load.n_cycles_busy * 100) / n_cycles_elapsed : 0);
+}
+
 /**
  * pipeline <pipeline_name> port in <port_id> stats read [clear]
  */
@@ -5552,6 +5718,59 @@ cmd_softnic_thread_pipeline_disable(struct pmd_internals *softnic,
 	}
 }
 
+/**
+ * thread autoscale threshold <load_diff_percent> period <period_ms>
+ * thread autoscale off
+ */
+static void
+cmd_softnic_thread_autoscale(struct pmd_internals *softnic,
+	char **tokens,
+	uint32_t n_tokens,
+	char *out,
+	size_t out_size)
+{
+	uint32_t threshold, period_ms;
+	int status;
+
+	if (n_tokens == 3 &&
+		(strcmp(tokens[2], "off") == 0)) {
+		softnic_thread_autoscale_config(softnic, 0, 0, 0);
+		return;
+	}
+
+	if (n_tokens != 6) {
+		snprintf(out, out_size, MSG_ARG_MISMATCH, tokens[0]);
+		return;
+	}
+
+	if (strcmp(tokens[2], "threshold") != 0) {
+		snprintf(out, out_size, MSG_ARG_NOT_FOUND, "threshold");
+		return;
+	}
+
+	if (softnic_parser_read_uint32(&threshold, tokens[3]) != 0) {
+		snprintf(out, out_size, MSG_ARG_INVALID, "load_diff_percent");
+		return;
+	}
+
+	if (strcmp(tokens[4], "period") != 0) {
+		snprintf(out, out_size, MSG_ARG_NOT_FOUND, "period");
+		return;
+	}
+
+	if (softnic_parser_read_uint32(&period_ms, tokens[5]) != 0) {
+		snprintf(out, out_size, MSG_ARG_INVALID, "period_ms");
+		return;
+	}
+
+	status = softnic_thread_autoscale_config(softnic, 1, threshold,
+		period_ms);
+	if (status) {
+		snprintf(out, out_size, MSG_CMD_FAIL, "thread autoscale");
+		return;
+	}
+}
+
 /**
  * flowapi map
  *  group <group_id>
@@ -5707,6 +5926,11 @@ softnic_cli_process(char *in, char *out, size_t out_size, void *arg)
 		return;
 	}
 
+	if (strcmp(tokens[0], "vhost") == 0) {
+		cmd_vhost(softnic, tokens, n_tokens, out, out_size);
+		return;
+	}
+
 	if (strcmp(tokens[0], "cryptodev") == 0) {
 		cmd_cryptodev(softnic, tokens, n_tokens, out, out_size);
 		return;
@@ -5729,6 +5953,12 @@ softnic_cli_process(char *in, char *out, size_t out_size, void *arg)
 			return;
 		}
 
+		if (n_tokens >= 3 &&
+			(strcmp(tokens[2], "load") == 0)) {
+			cmd_pipeline_load(softnic, tokens, n_tokens, out, out_size);
+			return;
+		}
+
 		if (n_tokens >= 5 &&
 			(strcmp(tokens[2], "port") == 0) &&
 			(strcmp(tokens[3], "in") == 0) &&
@@ -5909,6 +6139,13 @@ softnic_cli_process(char *in, char *out, size_t out_size, void *arg)
 	}
 
 	if (strcmp(tokens[0], "thread") == 0) {
+		if (n_tokens >= 2 &&
+			(strcmp(tokens[1], "autoscale") == 0)) {
+			cmd_softnic_thread_autoscale(softnic, tokens, n_tokens,
+				out, out_size);
+			return;
+		}
+
 		if (n_tokens >= 5 &&
 			(strcmp(tokens[4], "enable") == 0)) {
 			cmd_softnic_thread_pipeline_enable(softnic, tokens, n_tokens,
@@ -8,6 +8,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <sys/queue.h>
+#include <linux/limits.h>
 
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
@@ -278,6 +279,25 @@ struct softnic_tap {
 
 TAILQ_HEAD(softnic_tap_list, softnic_tap);
 
+/**
+ * vhost
+ */
+struct softnic_vhost_params {
+	const char *path;
+	int client;
+};
+
+struct softnic_vhost {
+	TAILQ_ENTRY(softnic_vhost) node;
+	TAILQ_ENTRY(softnic_vhost) node_all;
+	char name[NAME_SIZE];
+	char path[PATH_MAX];
+	struct pmd_internals *softnic;
+	volatile int vid;
+};
+
+TAILQ_HEAD(softnic_vhost_list, softnic_vhost);
+
 /**
  * Cryptodev
  */
@@ -364,6 +384,7 @@ enum softnic_port_in_type {
 	PORT_IN_TAP,
 	PORT_IN_SOURCE,
 	PORT_IN_CRYPTODEV,
+	PORT_IN_VHOST,
 };
 
 struct softnic_port_in_params {
@@ -391,6 +412,11 @@ struct softnic_port_in_params {
 			void *f_callback;
 			void *arg_callback;
 		} cryptodev;
+
+		struct {
+			uint16_t queue_id;
+			const char *mempool_name;
+		} vhost;
 	};
 	uint32_t burst_size;
 
@@ -405,6 +431,7 @@ enum softnic_port_out_type {
 	PORT_OUT_TAP,
 	PORT_OUT_SINK,
 	PORT_OUT_CRYPTODEV,
+	PORT_OUT_VHOST,
 };
 
 struct softnic_port_out_params {
@@ -424,6 +451,10 @@ struct softnic_port_out_params {
 			uint16_t queue_id;
 			uint32_t op_offset;
 		} cryptodev;
+
+		struct {
+			uint16_t queue_id;
+		} vhost;
 	};
 	uint32_t burst_size;
 	int retry;
@@ -501,6 +532,15 @@ struct softnic_table {
 	struct softnic_table_meter_profile_list meter_profiles;
 };
 
+/**
+ * Pipeline load, updated by the data plane thread running the pipeline
+ */
+struct softnic_pipeline_load {
+	uint64_t n_pkts; /* Packets read from the input ports. */
+	uint64_t n_cycles; /* CPU cycles spent running the pipeline. */
+	uint64_t n_cycles_busy; /* Of which for the runs reading packets. */
+};
+
 struct pipeline {
 	TAILQ_ENTRY(pipeline) node;
 	char name[NAME_SIZE];
@@ -521,6 +561,12 @@ struct pipeline {
 	int enabled;
 	uint32_t thread_id;
 	uint32_t cpu_id;
+
+	struct softnic_pipeline_load load;
+	struct softnic_pipeline_load load_ref; /* Load at last clear. */
+	uint64_t load_time_ref; /* Time of last clear. */
+	uint64_t autoscale_busy_ref;
+	uint64_t autoscale_busy; /* Busy cycles over the last period. */
 };
 
 TAILQ_HEAD(pipeline_list, pipeline);
@@ -548,6 +594,24 @@ struct softnic_thread {
 	struct rte_ring *msgq_rsp;
 
 	uint32_t enabled;
+	uint64_t autoscale_iter_ref;
+};
+
+/**
+ * Master thread: pipeline autoscaling, moving a pipeline from the most to
+ * the least loaded data plane thread when their load differs by more than
+ * the threshold
+ */
+#ifndef AUTOSCALE_PERIOD_MS
+#define AUTOSCALE_PERIOD_MS                                1000
+#endif
+
+struct softnic_autoscale {
+	int enabled;
+	uint32_t threshold; /* Load difference, in percent. */
+	uint64_t period; /* Measured in CPU cycles. */
+	uint64_t time_ref;
+	uint64_t n_moves;
 };
 
 /**
@@ -565,6 +629,7 @@ struct pipeline_data {
 	struct rte_pipeline *p;
 	struct softnic_table_data table_data[RTE_PIPELINE_TABLE_MAX];
 	uint32_t n_tables;
+	struct softnic_pipeline_load *load;
 
 	struct rte_ring *msgq_req;
 	struct rte_ring *msgq_rsp;
@@ -607,12 +672,14 @@ struct pmd_internals {
 	struct softnic_link_list link_list;
 	struct softnic_tmgr_port_list tmgr_port_list;
 	struct softnic_tap_list tap_list;
+	struct softnic_vhost_list vhost_list;
 	struct softnic_cryptodev_list cryptodev_list;
 	struct softnic_port_in_action_profile_list port_in_action_profile_list;
 	struct softnic_table_action_profile_list table_action_profile_list;
 	struct pipeline_list pipeline_list;
 	struct softnic_thread thread[RTE_MAX_LCORE];
 	struct softnic_thread_data thread_data[RTE_MAX_LCORE];
+	struct softnic_autoscale autoscale;
 };
 
 static inline struct rte_eth_dev *
@@ -774,6 +841,24 @@ struct softnic_tap *
 softnic_tap_create(struct pmd_internals *p,
 	const char *name);
 
+/**
+ * vhost
+ */
+int
+softnic_vhost_init(struct pmd_internals *p);
+
+void
+softnic_vhost_free(struct pmd_internals *p);
+
+struct softnic_vhost *
+softnic_vhost_find(struct pmd_internals *p,
+	const char *name);
+
+struct softnic_vhost *
+softnic_vhost_create(struct pmd_internals *p,
+	const char *name,
+	struct softnic_vhost_params *params);
+
 /**
  * Sym Crypto
  */
@@ -1086,6 +1171,9 @@ softnic_thread_init(struct pmd_internals *p);
 void
 softnic_thread_free(struct pmd_internals *p);
 
+void
+softnic_thread_quiesce(struct pmd_internals *p);
+
 int
 softnic_thread_pipeline_enable(struct pmd_internals *p,
 	uint32_t thread_id,
@@ -1096,6 +1184,21 @@ softnic_thread_pipeline_disable(struct pmd_internals *p,
 	uint32_t thread_id,
 	const char *pipeline_name);
 
+void
+softnic_pipeline_load_read(struct pipeline *p,
+	struct softnic_pipeline_load *load,
+	uint64_t *n_cycles_elapsed,
+	int clear);
+
+int
+softnic_thread_autoscale_config(struct pmd_internals *p,
+	int enable,
+	uint32_t threshold,
+	uint32_t period_ms);
+
+void
+softnic_thread_autoscale(struct pmd_internals *p);
+
 /**
  * CLI
  */
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <rte_common.h>
+#include <rte_cycles.h>
 #include <rte_ip.h>
 #include <rte_tcp.h>
 
@@ -16,6 +17,9 @@
 #include <rte_port_fd.h>
 #include <rte_port_sched.h>
 #include <rte_port_sym_crypto.h>
+#ifdef RTE_LIBRTE_VHOST
+#include <rte_port_vhost.h>
+#endif
 
 #include <rte_table_acl.h>
 #include <rte_table_array.h>
@@ -204,6 +208,7 @@ softnic_pipeline_create(struct pmd_internals *softnic,
 	pipeline->timer_period_ms = params->timer_period_ms;
 	pipeline->enabled = 0;
 	pipeline->cpu_id = softnic->params.cpu_id;
+	pipeline->load_time_ref = rte_get_tsc_cycles();
 
 	/* Node add to list */
 	TAILQ_INSERT_TAIL(&softnic->pipeline_list, pipeline, node);
@@ -226,6 +231,9 @@ softnic_pipeline_port_in_create(struct pmd_internals *softnic,
 		struct rte_port_fd_reader_params fd;
 		struct rte_port_source_params source;
 		struct rte_port_sym_crypto_reader_params cryptodev;
+#ifdef RTE_LIBRTE_VHOST
+		struct rte_port_vhost_reader_params vhost;
+#endif
 	} pp;
 
 	struct pipeline *pipeline;
@@ -360,6 +368,28 @@ softnic_pipeline_port_in_create(struct pmd_internals *softnic,
 		break;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	case PORT_IN_VHOST:
+	{
+		struct softnic_vhost *vhost;
+		struct softnic_mempool *mempool;
+
+		vhost = softnic_vhost_find(softnic, params->dev_name);
+		mempool = softnic_mempool_find(softnic,
+			params->vhost.mempool_name);
+		if (vhost == NULL || mempool == NULL)
+			return -1;
+
+		pp.vhost.vid = &vhost->vid;
+		pp.vhost.queue_id = params->vhost.queue_id;
+		pp.vhost.mempool = mempool->m;
+
+		p.ops = &rte_port_vhost_reader_ops;
+		p.arg_create = &pp.vhost;
+		break;
+	}
+#endif
+
 	default:
 		return -1;
 	}
@@ -447,6 +477,9 @@ softnic_pipeline_port_out_create(struct pmd_internals *softnic,
 		struct rte_port_fd_writer_params fd;
 		struct rte_port_sink_params sink;
 		struct rte_port_sym_crypto_writer_params cryptodev;
+#ifdef RTE_LIBRTE_VHOST
+		struct rte_port_vhost_writer_params vhost;
+#endif
 	} pp;
 
 	union {
@@ -454,6 +487,9 @@ softnic_pipeline_port_out_create(struct pmd_internals *softnic,
 		struct rte_port_ring_writer_nodrop_params ring;
 		struct rte_port_fd_writer_nodrop_params fd;
 		struct rte_port_sym_crypto_writer_nodrop_params cryptodev;
+#ifdef RTE_LIBRTE_VHOST
+		struct rte_port_vhost_writer_nodrop_params vhost;
+#endif
 	} pp_nodrop;
 
 	struct pipeline *pipeline;
@@ -617,6 +653,35 @@ softnic_pipeline_port_out_create(struct pmd_internals *softnic,
 		break;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	case PORT_OUT_VHOST:
+	{
+		struct softnic_vhost *vhost;
+
+		vhost = softnic_vhost_find(softnic, params->dev_name);
+		if (vhost == NULL)
+			return -1;
+
+		pp.vhost.vid = &vhost->vid;
+		pp.vhost.queue_id = params->vhost.queue_id;
+		pp.vhost.tx_burst_sz = params->burst_size;
+
+		pp_nodrop.vhost.vid = &vhost->vid;
+		pp_nodrop.vhost.queue_id = params->vhost.queue_id;
+		pp_nodrop.vhost.tx_burst_sz = params->burst_size;
+		pp_nodrop.vhost.n_retries = params->n_retries;
+
+		if (params->retry == 0) {
+			p.ops = &rte_port_vhost_writer_ops;
+			p.arg_create = &pp.vhost;
+		} else {
+			p.ops = &rte_port_vhost_writer_nodrop_ops;
+			p.arg_create = &pp_nodrop.vhost;
+		}
+		break;
+	}
+#endif
+
 	default:
 		return -1;
 	}
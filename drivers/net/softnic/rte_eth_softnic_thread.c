@@ -7,6 +7,7 @@
 #include <rte_common.h>
 #include <rte_cycles.h>
 #include <rte_lcore.h>
+#include <rte_pause.h>
 #include <rte_ring.h>
 
 #include <rte_table_acl.h>
@@ -118,6 +119,32 @@ pipeline_is_running(struct pipeline *p)
 	return thread_is_running(p->thread_id);
 }
 
+/**
+ * Wait until every running data plane thread with pipelines has started a new
+ * rte_pmd_softnic_run() iteration, so that none of them still uses a value
+ * changed by the caller.
+ */
+void
+softnic_thread_quiesce(struct pmd_internals *softnic)
+{
+	uint64_t iter[RTE_MAX_LCORE];
+	uint32_t i;
+
+	rte_smp_mb();
+
+	RTE_LCORE_FOREACH_SLAVE(i)
+		iter[i] = *(volatile uint64_t *)&softnic->thread_data[i].iter;
+
+	RTE_LCORE_FOREACH_SLAVE(i) {
+		struct softnic_thread_data *t = &softnic->thread_data[i];
+
+		while (t->n_pipelines &&
+			thread_is_running(i) &&
+			*(volatile uint64_t *)&t->iter == iter[i])
+			rte_pause();
+	}
+}
+
 /**
  * Master thread & data plane threads: message passing
  */
@@ -140,6 +167,7 @@ struct thread_msg_req {
 			struct rte_ring *msgq_rsp;
 			uint32_t timer_period_ms;
 			uint32_t n_tables;
+			struct softnic_pipeline_load *load;
 		} pipeline_enable;
 
 		struct {
@@ -234,6 +262,7 @@ softnic_thread_pipeline_enable(struct pmd_internals *softnic,
 			tdp->table_data[i].a =
 				p->table[i].a;
 		tdp->n_tables = p->n_tables;
+		tdp->load = &p->load;
 
 		tdp->msgq_req = p->msgq_req;
 		tdp->msgq_rsp = p->msgq_rsp;
@@ -264,6 +293,7 @@ softnic_thread_pipeline_enable(struct pmd_internals *softnic,
 	req->pipeline_enable.msgq_rsp = p->msgq_rsp;
 	req->pipeline_enable.timer_period_ms = p->timer_period_ms;
 	req->pipeline_enable.n_tables = p->n_tables;
+	req->pipeline_enable.load = &p->load;
 
 	/* Send request and wait for response */
 	rsp = thread_msg_send_recv(softnic, thread_id, req);
@@ -373,6 +403,170 @@ softnic_thread_pipeline_disable(struct pmd_internals *softnic,
 	return 0;
 }
 
+/**
+ * Master thread: pipeline load
+ */
+void
+softnic_pipeline_load_read(struct pipeline *p,
+	struct softnic_pipeline_load *load,
+	uint64_t *n_cycles_elapsed,
+	int clear)
+{
+	struct softnic_pipeline_load snapshot;
+	uint64_t time = rte_get_tsc_cycles();
+
+	/* Written by the data plane thread only, read as it runs */
+	snapshot.n_pkts = *(volatile uint64_t *)&p->load.n_pkts;
+	snapshot.n_cycles = *(volatile uint64_t *)&p->load.n_cycles;
+	snapshot.n_cycles_busy = *(volatile uint64_t *)&p->load.n_cycles_busy;
+
+	load->n_pkts = snapshot.n_pkts - p->load_ref.n_pkts;
+	load->n_cycles = snapshot.n_cycles - p->load_ref.n_cycles;
+	load->n_cycles_busy = snapshot.n_cycles_busy - p->load_ref.n_cycles_busy;
+	*n_cycles_elapsed = time - p->load_time_ref;
+
+	if (clear) {
+		p->load_ref = snapshot;
+		p->load_time_ref = time;
+	}
+}
+
+/**
+ * Master thread: pipeline autoscaling
+ */
+int
+softnic_thread_autoscale_config(struct pmd_internals *softnic,
+	int enable,
+	uint32_t threshold,
+	uint32_t period_ms)
+{
+	struct softnic_autoscale *as = &softnic->autoscale;
+	struct pipeline *p;
+	uint32_t i;
+
+	/* Check input params */
+	if (enable && (threshold == 0 || threshold > 100 || period_ms == 0))
+		return -1;
+
+	as->enabled = enable;
+	if (enable == 0)
+		return 0;
+
+	as->threshold = threshold;
+	as->period = (rte_get_tsc_hz() * period_ms) / 1000;
+	as->time_ref = rte_get_tsc_cycles();
+
+	TAILQ_FOREACH(p, &softnic->pipeline_list, node)
+		p->autoscale_busy_ref = p->load.n_cycles_busy;
+
+	RTE_LCORE_FOREACH_SLAVE(i)
+		softnic->thread[i].autoscale_iter_ref =
+			softnic->thread_data[i].iter;
+
+	return 0;
+}
+
+void
+softnic_thread_autoscale(struct pmd_internals *softnic)
+{
+	struct softnic_autoscale *as = &softnic->autoscale;
+	uint64_t load[RTE_MAX_LCORE];
+	int active[RTE_MAX_LCORE];
+	uint64_t time, n_cycles, diff, best;
+	uint32_t thread_max, thread_min, i;
+	struct pipeline *p, *p_move;
+
+	if (as->enabled == 0)
+		return;
+
+	time = rte_get_tsc_cycles();
+	n_cycles = time - as->time_ref;
+	if (n_cycles < as->period)
+		return;
+	as->time_ref = time;
+
+	/*
+	 * Candidate threads: the ones which ran rte_pmd_softnic_run() over the
+	 * last period. Thread load: busy time of its pipelines.
+	 */
+	RTE_LCORE_FOREACH_SLAVE(i) {
+		struct softnic_thread *t = &softnic->thread[i];
+		uint64_t iter =
+			*(volatile uint64_t *)&softnic->thread_data[i].iter;
+
+		active[i] = t->enabled && thread_is_running(i) &&
+			(iter != t->autoscale_iter_ref);
+		t->autoscale_iter_ref = iter;
+		load[i] = 0;
+	}
+
+	TAILQ_FOREACH(p, &softnic->pipeline_list, node) {
+		uint64_t busy = *(volatile uint64_t *)&p->load.n_cycles_busy;
+
+		p->autoscale_busy = busy - p->autoscale_busy_ref;
+		p->autoscale_busy_ref = busy;
+		if (p->enabled)
+			load[p->thread_id] += p->autoscale_busy;
+	}
+
+	thread_max = RTE_MAX_LCORE;
+	thread_min = RTE_MAX_LCORE;
+	RTE_LCORE_FOREACH_SLAVE(i) {
+		if (active[i] == 0)
+			continue;
+
+		if ((thread_max == RTE_MAX_LCORE) ||
+			(load[i] > load[thread_max]))
+			thread_max = i;
+		if ((thread_min == RTE_MAX_LCORE) ||
+			(load[i] < load[thread_min]))
+			thread_min = i;
+	}
+
+	if ((thread_max == thread_min) ||
+		((load[thread_max] - load[thread_min]) * 100 <=
+			as->threshold * n_cycles))
+		return;
+
+	/*
+	 * Move the pipeline with its busy time closest to half the load
+	 * difference, provided this difference decreases.
+	 */
+	diff = load[thread_max] - load[thread_min];
+	best = diff;
+	p_move = NULL;
+	TAILQ_FOREACH(p, &softnic->pipeline_list, node) {
+		uint64_t busy = p->autoscale_busy;
+		uint64_t d;
+
+		if ((p->enabled == 0) ||
+			(p->thread_id != thread_max) ||
+			(busy == 0) ||
+			(busy >= diff))
+			continue;
+
+		d = (2 * busy > diff) ? 2 * busy - diff : diff - 2 * busy;
+		if (d < best) {
+			best = d;
+			p_move = p;
+		}
+	}
+
+	if (p_move == NULL)
+		return;
+
+	if (softnic_thread_pipeline_disable(softnic, thread_max, p_move->name))
+		return;
+
+	if (softnic_thread_pipeline_enable(softnic, thread_min, p_move->name)) {
+		/* Give it back to its thread */
+		softnic_thread_pipeline_enable(softnic, thread_max, p_move->name);
+		return;
+	}
+
+	as->n_moves++;
+}
+
 /**
  * Data plane threads: message handling
  */
@@ -422,6 +616,7 @@ thread_msg_handle_pipeline_enable(struct softnic_thread_data *t,
 			req->pipeline_enable.table[i].a;
 
 	p->n_tables = req->pipeline_enable.n_tables;
+	p->load = req->pipeline_enable.load;
 
 	p->msgq_req = req->pipeline_enable.msgq_req;
 	p->msgq_rsp = req->pipeline_enable.msgq_rsp;
@@ -2944,6 +3139,7 @@ rte_pmd_softnic_run(uint16_t port_id)
 	struct rte_eth_dev *dev = &rte_eth_devices[port_id];
 	struct pmd_internals *softnic;
 	struct softnic_thread_data *t;
+	uint64_t time_start;
 	uint32_t thread_id, j;
 
 #ifdef RTE_LIBRTE_ETHDEV_DEBUG
@@ -2956,8 +3152,22 @@ rte_pmd_softnic_run(uint16_t port_id)
 	t->iter++;
 
 	/* Data Plane */
-	for (j = 0; j < t->n_pipelines; j++)
-		rte_pipeline_run(t->p[j]);
+	time_start = rte_rdtsc();
+	for (j = 0; j < t->n_pipelines; j++) {
+		struct softnic_pipeline_load *load = t->pipeline_data[j].load;
+		uint64_t time_end;
+		int n_pkts;
+
+		n_pkts = rte_pipeline_run(t->p[j]);
+		time_end = rte_rdtsc();
+
+		load->n_cycles += time_end - time_start;
+		if (n_pkts > 0) {
+			load->n_pkts += n_pkts;
+			load->n_cycles_busy += time_end - time_start;
+		}
+		time_start = time_end;
+	}
 
 	/* Control Plane */
 	if ((t->iter & 0xFLLU) == 0) {
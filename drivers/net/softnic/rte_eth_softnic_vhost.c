@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_string_fns.h>
+#ifdef RTE_LIBRTE_VHOST
+#include <rte_spinlock.h>
+#include <rte_vhost.h>
+#endif
+
+#include "rte_eth_softnic_internals.h"
+
+int
+softnic_vhost_init(struct pmd_internals *p)
+{
+	TAILQ_INIT(&p->vhost_list);
+
+	return 0;
+}
+
+struct softnic_vhost *
+softnic_vhost_find(struct pmd_internals *p,
+	const char *name)
+{
+	struct softnic_vhost *vhost;
+
+	if (name == NULL)
+		return NULL;
+
+	TAILQ_FOREACH(vhost, &p->vhost_list, node)
+		if (strcmp(vhost->name, name) == 0)
+			return vhost;
+
+	return NULL;
+}
+
+#ifndef RTE_LIBRTE_VHOST
+
+void
+softnic_vhost_free(struct pmd_internals *p __rte_unused)
+{
+}
+
+struct softnic_vhost *
+softnic_vhost_create(struct pmd_internals *p __rte_unused,
+	const char *name __rte_unused,
+	struct softnic_vhost_params *params __rte_unused)
+{
+	return NULL;
+}
+
+#else
+
+/*
+ * The vhost library callbacks only provide the device ID, so the objects of
+ * all the softnic devices are also kept on a global list, searched by the
+ * socket path of the device.
+ */
+static struct softnic_vhost_list vhost_all =
+	TAILQ_HEAD_INITIALIZER(vhost_all);
+static rte_spinlock_t vhost_all_lock = RTE_SPINLOCK_INITIALIZER;
+
+static struct softnic_vhost *
+vhost_find_by_vid(int vid)
+{
+	char path[PATH_MAX];
+	struct softnic_vhost *vhost;
+
+	if (rte_vhost_get_ifname(vid, path, sizeof(path)) != 0)
+		return NULL;
+
+	TAILQ_FOREACH(vhost, &vhost_all, node_all)
+		if (strcmp(vhost->path, path) == 0)
+			return vhost;
+
+	return NULL;
+}
+
+static int
+vhost_new_device(int vid)
+{
+	struct softnic_vhost *vhost;
+
+	rte_spinlock_lock(&vhost_all_lock);
+	vhost = vhost_find_by_vid(vid);
+	if (vhost)
+		vhost->vid = vid;
+	rte_spinlock_unlock(&vhost_all_lock);
+
+	return (vhost == NULL) ? -1 : 0;
+}
+
+static void
+vhost_destroy_device(int vid)
+{
+	struct softnic_vhost *vhost;
+
+	rte_spinlock_lock(&vhost_all_lock);
+	vhost = vhost_find_by_vid(vid);
+	if (vhost)
+		vhost->vid = -1;
+	rte_spinlock_unlock(&vhost_all_lock);
+
+	/* The pipeline ports read the device ID on each burst. */
+	if (vhost)
+		softnic_thread_quiesce(vhost->softnic);
+}
+
+static const struct vhost_device_ops vhost_ops = {
+	.new_device = vhost_new_device,
+	.destroy_device = vhost_destroy_device,
+};
+
+void
+softnic_vhost_free(struct pmd_internals *p)
+{
+	for ( ; ; ) {
+		struct softnic_vhost *vhost;
+
+		vhost = TAILQ_FIRST(&p->vhost_list);
+		if (vhost == NULL)
+			break;
+
+		/* May call destroy_device(), do not hold the lock. */
+		rte_vhost_driver_unregister(vhost->path);
+
+		rte_spinlock_lock(&vhost_all_lock);
+		TAILQ_REMOVE(&vhost_all, vhost, node_all);
+		rte_spinlock_unlock(&vhost_all_lock);
+
+		TAILQ_REMOVE(&p->vhost_list, vhost, node);
+		free(vhost);
+	}
+}
+
+struct softnic_vhost *
+softnic_vhost_create(struct pmd_internals *p,
+	const char *name,
+	struct softnic_vhost_params *params)
+{
+	struct softnic_vhost *vhost;
+	uint64_t flags;
+
+	/* Check input params */
+	if (name == NULL ||
+		softnic_vhost_find(p, name) ||
+		params == NULL ||
+		params->path == NULL)
+		return NULL;
+
+	/* Node allocation */
+	vhost = calloc(1, sizeof(struct softnic_vhost));
+	if (vhost == NULL)
+		return NULL;
+
+	/* Node fill in */
+	strlcpy(vhost->name, name, sizeof(vhost->name));
+	strlcpy(vhost->path, params->path, sizeof(vhost->path));
+	vhost->softnic = p;
+	vhost->vid = -1;
+
+	rte_spinlock_lock(&vhost_all_lock);
+	TAILQ_INSERT_TAIL(&vhost_all, vhost, node_all);
+	rte_spinlock_unlock(&vhost_all_lock);
+
+	/* Resource create */
+	flags = params->client ? RTE_VHOST_USER_CLIENT : 0;
+
+	if (rte_vhost_driver_register(vhost->path, flags))
+		goto error;
+
+	if (rte_vhost_driver_callback_register(vhost->path, &vhost_ops) ||
+		rte_vhost_driver_start(vhost->path)) {
+		rte_vhost_driver_unregister(vhost->path);
+		goto error;
+	}
+
+	/* Node add to list */
+	TAILQ_INSERT_TAIL(&p->vhost_list, vhost, node);
+
+	return vhost;
+
+error:
+	rte_spinlock_lock(&vhost_all_lock);
+	TAILQ_REMOVE(&vhost_all, vhost, node_all);
+	rte_spinlock_unlock(&vhost_all_lock);
+	free(vhost);
+	return NULL;
+}
+
+#endif
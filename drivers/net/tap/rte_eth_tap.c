@@ -13,6 +13,7 @@
 #include <rte_bus_vdev.h>
 #include <rte_kvargs.h>
 #include <rte_net.h>
+#include <rte_net_cksum.h>
 #include <rte_debug.h>
 #include <rte_ip.h>
 #include <rte_string_fns.h>
@@ -135,9 +136,7 @@ static int
 tun_alloc(struct pmd_internals *pmd, int is_keepalive)
 {
 	struct ifreq ifr;
-#ifdef IFF_MULTI_QUEUE
 	unsigned int features;
-#endif
 	int fd;
 
 	memset(&ifr, 0, sizeof(struct ifreq));
@@ -158,7 +157,6 @@ tun_alloc(struct pmd_internals *pmd, int is_keepalive)
 		goto error;
 	}
 
-#ifdef IFF_MULTI_QUEUE
 	/* Grab the TUN features to verify we can work multi-queue */
 	if (ioctl(fd, TUNGETFEATURES, &features) < 0) {
 		TAP_LOG(ERR, "%s unable to get TUN/TAP features",
@@ -167,6 +165,18 @@ tun_alloc(struct pmd_internals *pmd, int is_keepalive)
 	}
 	TAP_LOG(DEBUG, "%s Features %08x", tuntap_name, features);
 
+	/*
+	 * All the queues must agree on the virtio-net header, the decision
+	 * is taken once with the keep-alive queue.
+	 */
+	if (is_keepalive)
+		pmd->vnet_hdr = !!(features & IFF_VNET_HDR);
+	if (pmd->vnet_hdr) {
+		TAP_LOG(DEBUG, "  virtio-net header support");
+		ifr.ifr_flags |= IFF_VNET_HDR;
+	}
+
+#ifdef IFF_MULTI_QUEUE
 	if (features & IFF_MULTI_QUEUE) {
 		TAP_LOG(DEBUG, "  Multi-queue support for %d queues",
 			RTE_PMD_TAP_MAX_QUEUES);
@@ -307,6 +317,38 @@ tap_verify_csum(struct rte_mbuf *mbuf)
 	}
 }
 
+/*
+ * Translate the virtio-net header written by the kernel into mbuf offload
+ * flags. Return 1 when the header tells the L4 checksum status, so that it
+ * does not have to be verified in software.
+ */
+static int
+tap_rx_vnet_offload(struct rte_mbuf *mbuf, const struct virtio_net_hdr *hdr)
+{
+	uint32_t l4 = mbuf->packet_type & RTE_PTYPE_L4_MASK;
+
+	if (hdr->gso_type == VIRTIO_NET_HDR_GSO_TCPV4 ||
+	    hdr->gso_type == VIRTIO_NET_HDR_GSO_TCPV6) {
+		/* Coalesced by the kernel, segments are tso_segsz long */
+		mbuf->ol_flags |= PKT_RX_LRO;
+		mbuf->tso_segsz = hdr->gso_size;
+	}
+	if (hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+		/* Only the pseudo-header checksum is in the L4 header */
+		if (l4 != RTE_PTYPE_L4_TCP && l4 != RTE_PTYPE_L4_UDP)
+			return 0;
+		mbuf->ol_flags |= PKT_RX_L4_CKSUM_NONE;
+	} else if (hdr->flags & VIRTIO_NET_HDR_F_DATA_VALID) {
+		mbuf->ol_flags |= PKT_RX_L4_CKSUM_GOOD;
+	} else {
+		return 0;
+	}
+	/* Local or already verified by the kernel */
+	if (RTE_ETH_IS_IPV4_HDR(mbuf->packet_type))
+		mbuf->ol_flags |= PKT_RX_IP_CKSUM_GOOD;
+	return 1;
+}
+
 static uint64_t
 tap_rx_offload_get_port_capa(void)
 {
@@ -322,7 +364,8 @@ tap_rx_offload_get_queue_capa(void)
 	return DEV_RX_OFFLOAD_SCATTER |
 	       DEV_RX_OFFLOAD_IPV4_CKSUM |
 	       DEV_RX_OFFLOAD_UDP_CKSUM |
-	       DEV_RX_OFFLOAD_TCP_CKSUM;
+	       DEV_RX_OFFLOAD_TCP_CKSUM |
+	       DEV_RX_OFFLOAD_TCP_LRO;
 }
 
 /* Callback to handle the rx burst of packets to the correct interface and
@@ -348,13 +391,15 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 		struct rte_mbuf *seg = NULL;
 		struct rte_mbuf *new_tail = NULL;
 		uint16_t data_off = rte_pktmbuf_headroom(mbuf);
+		/* packet info, followed by the virtio-net header if any */
+		int hdr_len = (*rxq->iovecs)[0].iov_len;
 		int len;
 
 		len = readv(process_private->rxq_fds[rxq->queue_id],
 			*rxq->iovecs,
 			1 + (rxq->rxmode->offloads & DEV_RX_OFFLOAD_SCATTER ?
 			     rxq->nb_rx_desc : 1));
-		if (len < (int)sizeof(struct tun_pi))
+		if (len < hdr_len)
 			break;
 
 		/* Packet couldn't fit in the provided mbuf */
@@ -363,7 +408,7 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 			continue;
 		}
 
-		len -= sizeof(struct tun_pi);
+		len -= hdr_len;
 
 		mbuf->pkt_len = len;
 		mbuf->port = rxq->in_port;
@@ -389,7 +434,10 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 			new_tail = buf;
 			new_tail->next = seg->next;
 
-			/* iovecs[0] is reserved for packet info (pi) */
+			/*
+			 * iovecs[0] is reserved for packet info (pi) and
+			 * virtio-net header
+			 */
 			(*rxq->iovecs)[mbuf->nb_segs].iov_len =
 				buf->buf_len - data_off;
 			(*rxq->iovecs)[mbuf->nb_segs].iov_base =
@@ -408,7 +456,9 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 		seg->next = NULL;
 		mbuf->packet_type = rte_net_get_ptype(mbuf, NULL,
 						      RTE_PTYPE_ALL_MASK);
-		if (rxq->rxmode->offloads & DEV_RX_OFFLOAD_CHECKSUM)
+		if ((hdr_len == sizeof(struct tun_pi) ||
+		     !tap_rx_vnet_offload(mbuf, &rxq->vnet_hdr)) &&
+		    rxq->rxmode->offloads & DEV_RX_OFFLOAD_CHECKSUM)
 			tap_verify_csum(mbuf);
 
 		/* account for the receive frame */
@@ -468,7 +518,7 @@ tap_tx_l4_add_rcksum(char *l4_data, unsigned int l4_len, uint16_t *l4_cksum,
 	if (l4_cksum == NULL)
 		return;
 
-	*l4_raw_cksum = __rte_raw_cksum(l4_data, l4_len, *l4_raw_cksum);
+	*l4_raw_cksum = rte_net_raw_cksum(l4_data, l4_len, *l4_raw_cksum);
 }
 
 /* L3 and L4 pseudo headers checksum offloads */
@@ -506,6 +556,51 @@ tap_tx_l3_cksum(char *packet, uint64_t ol_flags, unsigned int l2_len,
 	}
 }
 
+/*
+ * Checksum and segmentation offloads left to the kernel through the
+ * virtio-net header, only the IPv4 header checksum is done here.
+ */
+static void
+tap_tx_vnet_offload(char *packet, struct rte_mbuf *mbuf,
+		    struct virtio_net_hdr *hdr)
+{
+	uint64_t ol_flags = mbuf->ol_flags;
+	void *l3_hdr = packet + mbuf->l2_len;
+	void *l4_hdr = (char *)l3_hdr + mbuf->l3_len;
+	uint16_t *l4_cksum;
+
+	if (ol_flags & (PKT_TX_IP_CKSUM | PKT_TX_IPV4)) {
+		struct ipv4_hdr *iph = l3_hdr;
+		uint16_t cksum;
+
+		iph->hdr_checksum = 0;
+		cksum = rte_raw_cksum(iph, mbuf->l3_len);
+		iph->hdr_checksum = (cksum == 0xffff) ? cksum : ~cksum;
+	}
+	if ((ol_flags & PKT_TX_L4_MASK) == PKT_TX_UDP_CKSUM) {
+		l4_cksum = &((struct udp_hdr *)l4_hdr)->dgram_cksum;
+		hdr->csum_offset = offsetof(struct udp_hdr, dgram_cksum);
+	} else if ((ol_flags & PKT_TX_L4_MASK) == PKT_TX_TCP_CKSUM) {
+		l4_cksum = &((struct tcp_hdr *)l4_hdr)->cksum;
+		hdr->csum_offset = offsetof(struct tcp_hdr, cksum);
+	} else {
+		return;
+	}
+	hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+	hdr->csum_start = mbuf->l2_len + mbuf->l3_len;
+	/* The kernel expects the length in the pseudo-header, even for TSO */
+	if (ol_flags & PKT_TX_IPV4)
+		*l4_cksum = rte_ipv4_phdr_cksum(l3_hdr, 0);
+	else
+		*l4_cksum = rte_ipv6_phdr_cksum(l3_hdr, 0);
+	if (ol_flags & PKT_TX_TCP_SEG) {
+		hdr->gso_type = (ol_flags & PKT_TX_IPV4) ?
+			VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+		hdr->gso_size = mbuf->tso_segsz;
+		hdr->hdr_len = hdr->csum_start + mbuf->l4_len;
+	}
+}
+
 static inline void
 tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 			struct rte_mbuf **pmbufs,
@@ -519,8 +614,9 @@ tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 
 	for (i = 0; i < num_mbufs; i++) {
 		struct rte_mbuf *mbuf = pmbufs[i];
-		struct iovec iovecs[mbuf->nb_segs + 2];
+		struct iovec iovecs[mbuf->nb_segs + 3];
 		struct tun_pi pi = { .flags = 0, .proto = 0x00 };
+		struct virtio_net_hdr vnet_hdr = { .flags = 0 };
 		struct rte_mbuf *seg = mbuf;
 		char m_copy[mbuf->data_len];
 		int proto;
@@ -559,9 +655,14 @@ tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 		iovecs[k].iov_base = &pi;
 		iovecs[k].iov_len = sizeof(pi);
 		k++;
+		if (txq->vnet_hdr) {
+			iovecs[k].iov_base = &vnet_hdr;
+			iovecs[k].iov_len = sizeof(vnet_hdr);
+			k++;
+		}
 
-		nb_segs = mbuf->nb_segs;
-		if (txq->csum &&
+		nb_segs = mbuf->nb_segs + k - 1;
+		if ((txq->csum || mbuf->ol_flags & PKT_TX_TCP_SEG) &&
 		    ((mbuf->ol_flags & (PKT_TX_IP_CKSUM | PKT_TX_IPV4) ||
 		     (mbuf->ol_flags & PKT_TX_L4_MASK) == PKT_TX_UDP_CKSUM ||
 		     (mbuf->ol_flags & PKT_TX_L4_MASK) == PKT_TX_TCP_CKSUM))) {
@@ -580,10 +681,13 @@ tap_write_mbufs(struct tx_queue *txq, uint16_t num_mbufs,
 			 */
 			rte_memcpy(m_copy, rte_pktmbuf_mtod(mbuf, void *),
 					l234_hlen);
-			tap_tx_l3_cksum(m_copy, mbuf->ol_flags,
-				       mbuf->l2_len, mbuf->l3_len, mbuf->l4_len,
-				       &l4_cksum, &l4_phdr_cksum,
-				       &l4_raw_cksum);
+			if (txq->vnet_hdr)
+				tap_tx_vnet_offload(m_copy, mbuf, &vnet_hdr);
+			else
+				tap_tx_l3_cksum(m_copy, mbuf->ol_flags,
+					mbuf->l2_len, mbuf->l3_len,
+					mbuf->l4_len, &l4_cksum,
+					&l4_phdr_cksum, &l4_raw_cksum);
 			iovecs[k].iov_base = m_copy;
 			iovecs[k].iov_len = l234_hlen;
 			k++;
@@ -654,10 +758,6 @@ pmd_tx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 
 		tso = mbuf_in->ol_flags & PKT_TX_TCP_SEG;
 		if (tso) {
-			struct rte_gso_ctx *gso_ctx = &txq->gso_ctx;
-
-			assert(gso_ctx != NULL);
-
 			/* TCP segmentation implies TCP checksum offload */
 			mbuf_in->ol_flags |= PKT_TX_TCP_CKSUM;
 
@@ -670,6 +770,17 @@ pmd_tx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 				txq->stats.errs++;
 				break;
 			}
+		}
+		if (tso && txq->vnet_hdr) {
+			/* Segmented by the kernel, see tap_tx_vnet_offload() */
+			ret = 0;
+			mbuf = &mbuf_in;
+			num_mbufs = 1;
+		} else if (tso) {
+			struct rte_gso_ctx *gso_ctx = &txq->gso_ctx;
+
+			assert(gso_ctx != NULL);
+
 			gso_ctx->gso_size = tso_segsz;
 			ret = rte_gso_segment(mbuf_in, /* packet to segment */
 				gso_ctx, /* gso control block */
@@ -836,6 +947,41 @@ tap_dev_stop(struct rte_eth_dev *dev)
 	tap_link_set_down(dev);
 }
 
+/*
+ * Let the kernel hand out packets with partial checksums and coalesced TCP
+ * segments, as described in their virtio-net header.
+ */
+static int
+tap_vnet_offload_set(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *pmd = dev->data->dev_private;
+	uint64_t offloads = dev->data->dev_conf.rxmode.offloads;
+	unsigned int tun_offloads = 0;
+
+	if (!pmd->vnet_hdr)
+		return 0;
+	/* TSO requires the checksum offload in the kernel */
+	if (offloads & (DEV_RX_OFFLOAD_UDP_CKSUM |
+			DEV_RX_OFFLOAD_TCP_CKSUM |
+			DEV_RX_OFFLOAD_TCP_LRO))
+		tun_offloads |= TUN_F_CSUM;
+	if (offloads & DEV_RX_OFFLOAD_TCP_LRO) {
+		if (!(offloads & DEV_RX_OFFLOAD_SCATTER))
+			TAP_LOG(WARNING,
+				"%s: LRO without scatter truncates packets",
+				dev->device->name);
+		tun_offloads |= TUN_F_TSO4 | TUN_F_TSO6;
+	}
+	if (ioctl(pmd->ka_fd, TUNSETOFFLOAD, tun_offloads) < 0) {
+		TAP_LOG(ERR, "%s: unable to set TUN/TAP offloads %#x: %s",
+			dev->device->name, tun_offloads, strerror(errno));
+		return -1;
+	}
+	TAP_LOG(DEBUG, "%s: TUN/TAP offloads %#x",
+		dev->device->name, tun_offloads);
+	return 0;
+}
+
 static int
 tap_dev_configure(struct rte_eth_dev *dev)
 {
@@ -856,6 +1002,9 @@ tap_dev_configure(struct rte_eth_dev *dev)
 		return -1;
 	}
 
+	if (tap_vnet_offload_set(dev) < 0)
+		return -1;
+
 	TAP_LOG(INFO, "%s: %p: TX configured queues number: %u",
 		dev->device->name, (void *)dev, dev->data->nb_tx_queues);
 
@@ -1293,6 +1442,7 @@ tap_setup_queue(struct rte_eth_dev *dev,
 	}
 
 	tx->type = pmd->type;
+	tx->vnet_hdr = pmd->vnet_hdr;
 
 	return *fd;
 }
@@ -1346,7 +1496,11 @@ tap_rx_queue_setup(struct rte_eth_dev *dev,
 		goto error;
 	}
 
-	(*rxq->iovecs)[0].iov_len = sizeof(struct tun_pi);
+	/* The kernel writes the virtio-net header right after pi */
+	RTE_BUILD_BUG_ON(offsetof(struct rx_queue, vnet_hdr) !=
+			 offsetof(struct rx_queue, pi) + sizeof(struct tun_pi));
+	(*rxq->iovecs)[0].iov_len = sizeof(struct tun_pi) +
+		(internals->vnet_hdr ? sizeof(struct virtio_net_hdr) : 0);
 	(*rxq->iovecs)[0].iov_base = &rxq->pi;
 
 	for (i = 1; i <= nb_desc; i++) {
@@ -5,12 +5,19 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <poll.h>
+#include <time.h>
+#include <linux/virtio_net.h>
 
 #include <rte_mbuf.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
 #include <rte_ethdev_driver.h>
 #include <rte_ethdev_vdev.h>
 #include <rte_malloc.h>
 #include <rte_memcpy.h>
+#include <rte_cycles.h>
 #include <rte_bus_vdev.h>
 #include <rte_kvargs.h>
 #include <rte_vhost.h>
@@ -31,7 +38,15 @@ enum {VIRTIO_RXQ, VIRTIO_TXQ, VIRTIO_QNUM};
 #define ETH_VHOST_DEQUEUE_ZERO_COPY	"dequeue-zero-copy"
 #define ETH_VHOST_IOMMU_SUPPORT		"iommu-support"
 #define ETH_VHOST_POSTCOPY_SUPPORT	"postcopy-support"
+#define ETH_VHOST_ADAPTIVE_POLL		"adaptive-poll"
+#define ETH_VHOST_ADAPTIVE_SLEEP	"adaptive-sleep-us"
+#define ETH_VHOST_BURST_SIZE		"burst-size"
+#define ETH_VHOST_VRINGS_PER_QUEUE	"vrings-per-queue"
+#define ETH_VHOST_SHARED_MEM		"shared-mem"
+/* the vhost library moves at most that many packets per call */
 #define VHOST_MAX_PKT_BURST 32
+#define VHOST_MAX_VRINGS_PER_QUEUE 8
+#define VHOST_ADAPTIVE_SLEEP_US 1000
 
 static const char *valid_arguments[] = {
 	ETH_VHOST_IFACE_ARG,
@@ -40,6 +55,11 @@ static const char *valid_arguments[] = {
 	ETH_VHOST_DEQUEUE_ZERO_COPY,
 	ETH_VHOST_IOMMU_SUPPORT,
 	ETH_VHOST_POSTCOPY_SUPPORT,
+	ETH_VHOST_ADAPTIVE_POLL,
+	ETH_VHOST_ADAPTIVE_SLEEP,
+	ETH_VHOST_BURST_SIZE,
+	ETH_VHOST_VRINGS_PER_QUEUE,
+	ETH_VHOST_SHARED_MEM,
 	NULL
 };
 
@@ -78,6 +98,9 @@ struct vhost_stats {
 	uint64_t bytes;
 	uint64_t missed_pkts;
 	uint64_t xstats[VHOST_XSTATS_MAX];
+	uint64_t sleeps; /* Adaptive polling: times the queue went asleep */
+	uint64_t sleep_us; /* time spent asleep */
+	uint64_t poll_us; /* time spent polling before going asleep */
 };
 
 struct vhost_queue {
@@ -87,7 +110,16 @@ struct vhost_queue {
 	struct pmd_internal *internal;
 	struct rte_mempool *mb_pool;
 	uint16_t port;
-	uint16_t virtqueue_id;
+	uint16_t virtqueue_id; /* first of the vrings of the queue */
+	uint16_t nb_vrings; /* vrings of the guest the queue serves */
+	uint16_t next_vring; /* round robin among them */
+	uint16_t burst; /* packets per vhost library call */
+	/* Adaptive polling of Rx queues, see vhost_rx_adaptive_wait() */
+	uint32_t adaptive_polls; /* 0 when disabled */
+	uint32_t sleep_us;
+	uint32_t empty_polls;
+	bool sleeping;
+	uint64_t state_tsc;
 	struct vhost_stats stats;
 };
 
@@ -99,6 +131,11 @@ struct pmd_internal {
 	int vid;
 	rte_atomic32_t started;
 	uint8_t vlan_strip;
+	uint32_t adaptive_polls;
+	uint32_t adaptive_sleep_us;
+	uint16_t burst;
+	uint16_t vrings_per_queue;
+	uint64_t features; /* negotiated with the guest */
 };
 
 struct internal_list {
@@ -174,6 +211,12 @@ static const struct vhost_xstats_name_off vhost_rxport_stat_strings[] = {
 	 offsetof(struct vhost_queue, stats.xstats[VHOST_ERRORS_JABBER])},
 	{"unknown_protos_packets",
 	 offsetof(struct vhost_queue, stats.xstats[VHOST_UNKNOWN_PROTOCOL])},
+	{"adaptive_sleeps",
+	 offsetof(struct vhost_queue, stats.sleeps)},
+	{"adaptive_sleep_us",
+	 offsetof(struct vhost_queue, stats.sleep_us)},
+	{"adaptive_poll_us",
+	 offsetof(struct vhost_queue, stats.poll_us)},
 };
 
 /* [tx]_ is prepended to the name string here */
@@ -367,12 +410,232 @@ vhost_update_packet_xstats(struct vhost_queue *vq,
 	}
 }
 
+static inline uint64_t
+vhost_tsc_to_us(uint64_t cycles)
+{
+	return cycles * US_PER_S / rte_get_tsc_hz();
+}
+
+/* The index of the i-th vring of a queue, past the first one. */
+static inline uint16_t
+vhost_queue_vring(struct vhost_queue *vq, uint16_t i)
+{
+	return vq->virtqueue_id + i * VIRTIO_QNUM;
+}
+
+/*
+ * Dequeue from one vring. A burst the vhost library takes whole is a
+ * single call, larger ones go by chunks until the vring runs dry.
+ */
+static inline uint16_t
+vhost_rx_vring(struct vhost_queue *r, uint16_t vring,
+	       struct rte_mbuf **bufs, uint16_t nb_bufs)
+{
+	uint16_t nb_rx = 0;
+	uint16_t nb_pkts;
+	uint16_t num;
+
+	if (likely(nb_bufs <= r->burst))
+		return rte_vhost_dequeue_burst(r->vid, vring, r->mb_pool,
+					       bufs, nb_bufs);
+
+	do {
+		num = RTE_MIN(nb_bufs - nb_rx, r->burst);
+		nb_pkts = rte_vhost_dequeue_burst(r->vid, vring, r->mb_pool,
+						  &bufs[nb_rx], num);
+		nb_rx += nb_pkts;
+	} while (nb_pkts == num && nb_rx < nb_bufs);
+
+	return nb_rx;
+}
+
+/*
+ * Dequeue from the vrings of the queue, starting from the next one at
+ * each call so that a busy vring does not starve the others.
+ */
+static inline uint16_t
+vhost_rx_burst(struct vhost_queue *r, struct rte_mbuf **bufs,
+	       uint16_t nb_bufs)
+{
+	uint16_t nb_rx = 0;
+	uint16_t i, idx;
+
+	if (likely(r->nb_vrings == 1))
+		return vhost_rx_vring(r, r->virtqueue_id, bufs, nb_bufs);
+
+	idx = r->next_vring;
+	for (i = 0; i < r->nb_vrings && nb_rx < nb_bufs; i++) {
+		nb_rx += vhost_rx_vring(r, vhost_queue_vring(r, idx),
+					&bufs[nb_rx], nb_bufs - nb_rx);
+		if (++idx == r->nb_vrings)
+			idx = 0;
+	}
+	if (++r->next_vring >= r->nb_vrings)
+		r->next_vring = 0;
+
+	return nb_rx;
+}
+
+/*
+ * Enqueue to one vring by chunks like vhost_rx_vring(), the packet data
+ * of the next chunk is prefetched while the current one is copied.
+ */
+static inline uint16_t
+vhost_tx_vring(struct vhost_queue *r, uint16_t vring,
+	       struct rte_mbuf **bufs, uint16_t nb_bufs)
+{
+	uint16_t nb_tx = 0;
+	uint16_t nb_pkts;
+	uint16_t num;
+	uint16_t i, end;
+
+	if (likely(nb_bufs <= r->burst))
+		return rte_vhost_enqueue_burst(r->vid, vring, bufs, nb_bufs);
+
+	do {
+		num = RTE_MIN(nb_bufs - nb_tx, r->burst);
+
+		end = RTE_MIN(nb_bufs, nb_tx + 2 * num);
+		for (i = nb_tx + num; i < end; i++)
+			rte_prefetch0(rte_pktmbuf_mtod(bufs[i], void *));
+
+		nb_pkts = rte_vhost_enqueue_burst(r->vid, vring,
+						  &bufs[nb_tx], num);
+		nb_tx += nb_pkts;
+	} while (nb_pkts == num && nb_tx < nb_bufs);
+
+	return nb_tx;
+}
+
+/*
+ * Enqueue to the next vring of the queue at each call, the packets it
+ * has no room for spill over to the following ones.
+ */
+static inline uint16_t
+vhost_tx_burst(struct vhost_queue *r, struct rte_mbuf **bufs,
+	       uint16_t nb_bufs)
+{
+	uint16_t nb_tx = 0;
+	uint16_t i, idx;
+
+	if (likely(r->nb_vrings == 1))
+		return vhost_tx_vring(r, r->virtqueue_id, bufs, nb_bufs);
+
+	idx = r->next_vring;
+	for (i = 0; i < r->nb_vrings && nb_tx < nb_bufs; i++) {
+		nb_tx += vhost_tx_vring(r, vhost_queue_vring(r, idx),
+					&bufs[nb_tx], nb_bufs - nb_tx);
+		if (++idx == r->nb_vrings)
+			idx = 0;
+	}
+	if (++r->next_vring >= r->nb_vrings)
+		r->next_vring = 0;
+
+	return nb_tx;
+}
+
+static void
+vhost_rx_notify(struct vhost_queue *r, int enable)
+{
+	uint16_t i;
+
+	for (i = 0; i < r->nb_vrings; i++)
+		rte_vhost_enable_guest_notification(r->vid,
+			vhost_queue_vring(r, i), enable);
+}
+
+/* Leave the adaptive polling sleep, traffic is back. */
+static void
+vhost_rx_adaptive_wake(struct vhost_queue *r)
+{
+	uint64_t now = rte_rdtsc();
+
+	vhost_rx_notify(r, 0);
+	r->stats.sleep_us += vhost_tsc_to_us(now - r->state_tsc);
+	r->state_tsc = now;
+	r->sleeping = false;
+	r->empty_polls = 0;
+}
+
+/*
+ * Called on an empty poll of a queue in adaptive polling mode. Past
+ * adaptive_polls empty polls, the guest notifications are enabled and the
+ * queue sleeps on the kicks of the guest, for at most sleep_us per call so
+ * the other queues of the lcore still get polled. It goes back to busy
+ * polling once packets come.
+ */
+static uint16_t
+vhost_rx_adaptive_wait(struct vhost_queue *r, struct rte_mbuf **bufs,
+		       uint16_t nb_bufs)
+{
+	struct rte_vhost_vring vring;
+	struct pollfd pfd[VHOST_MAX_VRINGS_PER_QUEUE];
+	struct timespec ts;
+	unsigned int nfds = 0;
+	unsigned int kicked = 0;
+	uint64_t kick;
+	uint64_t now;
+	uint16_t nb_rx;
+	uint16_t i;
+
+	if (++r->empty_polls < r->adaptive_polls)
+		return 0;
+
+	if (!r->sleeping) {
+		now = rte_rdtsc();
+		r->stats.poll_us += vhost_tsc_to_us(now - r->state_tsc);
+		r->stats.sleeps++;
+		r->state_tsc = now;
+		r->sleeping = true;
+
+		vhost_rx_notify(r, 1);
+		rte_smp_mb();
+
+		/* Packets may have come before the guest saw the flag. */
+		nb_rx = vhost_rx_burst(r, bufs, nb_bufs);
+		if (nb_rx) {
+			vhost_rx_adaptive_wake(r);
+			return nb_rx;
+		}
+	}
+
+	for (i = 0; i < r->nb_vrings; i++) {
+		if (rte_vhost_get_vhost_vring(r->vid, vhost_queue_vring(r, i),
+					      &vring) < 0 || vring.kickfd < 0)
+			continue;
+		pfd[nfds].fd = vring.kickfd;
+		pfd[nfds].events = POLLIN;
+		nfds++;
+	}
+	if (nfds == 0)
+		return 0;
+
+	ts.tv_sec = r->sleep_us / US_PER_S;
+	ts.tv_nsec = (r->sleep_us % US_PER_S) * 1000;
+	if (ppoll(pfd, nfds, &ts, NULL) <= 0)
+		return 0;
+
+	/* Clear the kicks, the counters are not needed. */
+	for (i = 0; i < nfds; i++) {
+		if (!(pfd[i].revents & POLLIN))
+			continue;
+		kicked++;
+		if (read(pfd[i].fd, &kick, sizeof(kick)) < 0)
+			VHOST_LOG(DEBUG, "Failed to read kick of rxq vring\n");
+	}
+	if (!kicked)
+		return 0;
+
+	vhost_rx_adaptive_wake(r);
+
+	return vhost_rx_burst(r, bufs, nb_bufs);
+}
+
 static uint16_t
 eth_vhost_rx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 {
 	struct vhost_queue *r = q;
 	uint16_t i, nb_rx = 0;
-	uint16_t nb_receive = nb_bufs;
 
 	if (unlikely(rte_atomic32_read(&r->allow_queuing) == 0))
 		return 0;
@@ -383,19 +646,15 @@ eth_vhost_rx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 		goto out;
 
 	/* Dequeue packets from guest TX queue */
-	while (nb_receive) {
-		uint16_t nb_pkts;
-		uint16_t num = (uint16_t)RTE_MIN(nb_receive,
-						 VHOST_MAX_PKT_BURST);
+	nb_rx = vhost_rx_burst(r, bufs, nb_bufs);
 
-		nb_pkts = rte_vhost_dequeue_burst(r->vid, r->virtqueue_id,
-						  r->mb_pool, &bufs[nb_rx],
-						  num);
-
-		nb_rx += nb_pkts;
-		nb_receive -= nb_pkts;
-		if (nb_pkts < num)
-			break;
+	if (unlikely(r->adaptive_polls)) {
+		if (nb_rx == 0)
+			nb_rx = vhost_rx_adaptive_wait(r, bufs, nb_bufs);
+		else if (r->sleeping)
+			vhost_rx_adaptive_wake(r);
+		else
+			r->empty_polls = 0;
 	}
 
 	r->stats.pkts += nb_rx;
@@ -443,6 +702,10 @@ eth_vhost_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 				rte_pktmbuf_free(m);
 				continue;
 			}
+			/* the offloads locate the headers after the tag */
+			if (m->ol_flags & (PKT_TX_L4_MASK | PKT_TX_TCP_SEG |
+					PKT_TX_IP_CKSUM))
+				m->l2_len += sizeof(struct vlan_hdr);
 		}
 
 		bufs[nb_send] = m;
@@ -450,19 +713,7 @@ eth_vhost_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 	}
 
 	/* Enqueue packets to guest RX queue */
-	while (nb_send) {
-		uint16_t nb_pkts;
-		uint16_t num = (uint16_t)RTE_MIN(nb_send,
-						 VHOST_MAX_PKT_BURST);
-
-		nb_pkts = rte_vhost_enqueue_burst(r->vid, r->virtqueue_id,
-						  &bufs[nb_tx], num);
-
-		nb_tx += nb_pkts;
-		nb_send -= nb_pkts;
-		if (nb_pkts < num)
-			break;
-	}
+	nb_tx = vhost_tx_burst(r, bufs, nb_send);
 
 	r->stats.pkts += nb_tx;
 	r->stats.missed_pkts += nb_bufs - nb_tx;
@@ -487,12 +738,107 @@ eth_vhost_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 	return nb_tx;
 }
 
+/*
+ * Completes the L4 checksum of a packet in software, for a guest which
+ * can't take it partial.
+ */
+static int
+vhost_sw_cksum(struct rte_mbuf *m)
+{
+	uint32_t l4_off = m->l2_len + m->l3_len;
+	uint32_t cksum_off, sum;
+	uint16_t *cksum, raw;
+	void *l3_hdr;
+
+	switch (m->ol_flags & PKT_TX_L4_MASK) {
+	case PKT_TX_TCP_CKSUM:
+		cksum_off = offsetof(struct tcp_hdr, cksum);
+		break;
+	case PKT_TX_UDP_CKSUM:
+		cksum_off = offsetof(struct udp_hdr, dgram_cksum);
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	if (unlikely(rte_pktmbuf_data_len(m) < l4_off + cksum_off +
+		     sizeof(*cksum)))
+		return -EINVAL;
+
+	l3_hdr = rte_pktmbuf_mtod_offset(m, void *, m->l2_len);
+	cksum = rte_pktmbuf_mtod_offset(m, uint16_t *, l4_off + cksum_off);
+	*cksum = 0;
+	if (rte_raw_cksum_mbuf(m, l4_off, m->pkt_len - l4_off, &raw) < 0)
+		return -EINVAL;
+
+	if (m->ol_flags & PKT_TX_IPV4)
+		sum = rte_ipv4_phdr_cksum(l3_hdr, 0);
+	else
+		sum = rte_ipv6_phdr_cksum(l3_hdr, 0);
+	sum += raw;
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (~sum) & 0xffff;
+	*cksum = sum == 0 ? 0xffff : (uint16_t)sum;
+
+	m->ol_flags &= ~PKT_TX_L4_MASK;
+
+	return 0;
+}
+
+/*
+ * The vhost library maps the Tx offloads of a packet onto the virtio-net
+ * header of the guest: a TSO packet is delivered as a whole segment, with
+ * its GSO type set, and never segmented. This checks the guest negotiated
+ * the offloads it would get, TSO packets it can't take are refused so
+ * that the application segments them, and checksums are completed here.
+ */
+static uint16_t
+eth_vhost_tx_prepare(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
+{
+	struct vhost_queue *r = q;
+	uint64_t features = r->internal->features;
+	uint64_t tso_feature;
+	struct rte_mbuf *m;
+	uint16_t i;
+	int ret;
+
+	for (i = 0; i < nb_bufs; i++) {
+		m = bufs[i];
+
+		if (m->ol_flags & PKT_TX_TCP_SEG) {
+			tso_feature = (m->ol_flags & PKT_TX_IPV4) ?
+				VIRTIO_NET_F_GUEST_TSO4 :
+				VIRTIO_NET_F_GUEST_TSO6;
+			if (!(features & (1ULL << tso_feature))) {
+				rte_errno = -ENOTSUP;
+				return i;
+			}
+		} else if ((m->ol_flags & PKT_TX_L4_MASK) &&
+			   !(features & (1ULL << VIRTIO_NET_F_GUEST_CSUM))) {
+			ret = vhost_sw_cksum(m);
+			if (ret != 0) {
+				rte_errno = ret;
+				return i;
+			}
+		}
+	}
+
+	return i;
+}
+
 static int
 eth_dev_configure(struct rte_eth_dev *dev __rte_unused)
 {
 	struct pmd_internal *internal = dev->data->dev_private;
 	const struct rte_eth_rxmode *rxmode = &dev->data->dev_conf.rxmode;
 
+	if (dev->data->dev_conf.intr_conf.rxq &&
+	    internal->vrings_per_queue > 1) {
+		VHOST_LOG(ERR, "Rx interrupts need one vring per queue\n");
+		return -ENOTSUP;
+	}
+
 	internal->vlan_strip = !!(rxmode->offloads & DEV_RX_OFFLOAD_VLAN_STRIP);
 
 	return 0;
@@ -691,12 +1037,30 @@ update_queuing_status(struct rte_eth_dev *dev)
 	}
 }
 
+/* The vrings of a queue the guest did set up, there may be none. */
+static uint16_t
+queue_nb_vrings(struct vhost_queue *vq, struct pmd_internal *internal,
+		uint32_t nr_vring)
+{
+	uint16_t n;
+
+	for (n = 0; n < internal->vrings_per_queue; n++)
+		if (vhost_queue_vring(vq, n) >= nr_vring)
+			break;
+
+	return n;
+}
+
 static void
 queue_setup(struct rte_eth_dev *eth_dev, struct pmd_internal *internal)
 {
 	struct vhost_queue *vq;
+	uint32_t nr_vring = 0;
 	int i;
 
+	if (internal->vid >= 0)
+		nr_vring = rte_vhost_get_vring_num(internal->vid);
+
 	for (i = 0; i < eth_dev->data->nb_rx_queues; i++) {
 		vq = eth_dev->data->rx_queues[i];
 		if (!vq)
@@ -704,6 +1068,12 @@ queue_setup(struct rte_eth_dev *eth_dev, struct pmd_internal *internal)
 		vq->vid = internal->vid;
 		vq->internal = internal;
 		vq->port = eth_dev->data->port_id;
+		vq->nb_vrings = queue_nb_vrings(vq, internal, nr_vring);
+		vq->next_vring = 0;
+		/* New vrings start with the guest notifications disabled */
+		vq->sleeping = false;
+		vq->empty_polls = 0;
+		vq->state_tsc = rte_rdtsc();
 	}
 	for (i = 0; i < eth_dev->data->nb_tx_queues; i++) {
 		vq = eth_dev->data->tx_queues[i];
@@ -712,6 +1082,8 @@ queue_setup(struct rte_eth_dev *eth_dev, struct pmd_internal *internal)
 		vq->vid = internal->vid;
 		vq->internal = internal;
 		vq->port = eth_dev->data->port_id;
+		vq->nb_vrings = queue_nb_vrings(vq, internal, nr_vring);
+		vq->next_vring = 0;
 	}
 }
 
@@ -746,6 +1118,7 @@ new_device(int vid)
 #endif
 
 	internal->vid = vid;
+	rte_vhost_get_negotiated_features(vid, &internal->features);
 	if (rte_atomic32_read(&internal->started) == 1) {
 		queue_setup(eth_dev, internal);
 
@@ -874,6 +1247,7 @@ rte_eth_vhost_get_queue_event(uint16_t port_id,
 		struct rte_eth_vhost_queue_event *event)
 {
 	struct rte_vhost_vring_state *state;
+	struct pmd_internal *internal;
 	unsigned int i;
 	int idx;
 
@@ -888,13 +1262,16 @@ rte_eth_vhost_get_queue_event(uint16_t port_id,
 		return -1;
 	}
 
+	internal = rte_eth_devices[port_id].data->dev_private;
+
 	rte_spinlock_lock(&state->lock);
 	for (i = 0; i <= state->max_vring; i++) {
 		idx = state->index++ % (state->max_vring + 1);
 
 		if (state->cur[idx] != state->seen[idx]) {
 			state->seen[idx] = state->cur[idx];
-			event->queue_id = idx / 2;
+			/* the queue that serves the queue pair of the guest */
+			event->queue_id = idx / 2 / internal->vrings_per_queue;
 			event->rx = idx & 1;
 			event->enable = state->cur[idx];
 			rte_spinlock_unlock(&state->lock);
@@ -906,6 +1283,51 @@ rte_eth_vhost_get_queue_event(uint16_t port_id,
 	return -1;
 }
 
+int __rte_experimental
+rte_eth_vhost_set_rxq_adaptive_poll(uint16_t port_id, uint16_t queue_id,
+		uint32_t empty_polls, uint32_t sleep_us)
+{
+	struct internal_list *list;
+	struct rte_eth_dev *eth_dev = NULL;
+	struct vhost_queue *vq;
+
+	if (!rte_eth_dev_is_valid_port(port_id))
+		return -ENODEV;
+
+	pthread_mutex_lock(&internal_list_lock);
+	TAILQ_FOREACH(list, &internal_list, next) {
+		if (list->eth_dev->data->port_id == port_id) {
+			eth_dev = list->eth_dev;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&internal_list_lock);
+
+	if (!eth_dev)
+		return -ENODEV;
+
+	if (queue_id >= eth_dev->data->nb_rx_queues)
+		return -EINVAL;
+
+	vq = eth_dev->data->rx_queues[queue_id];
+	if (!vq) {
+		VHOST_LOG(ERR, "rxq%d is not setup yet\n", queue_id);
+		return -EINVAL;
+	}
+
+	if (eth_dev->data->dev_conf.intr_conf.rxq && empty_polls) {
+		VHOST_LOG(ERR, "rxq%d uses Rx interrupts\n", queue_id);
+		return -ENOTSUP;
+	}
+
+	if (vq->sleeping)
+		vhost_rx_adaptive_wake(vq);
+	vq->adaptive_polls = empty_polls;
+	vq->sleep_us = sleep_us;
+
+	return 0;
+}
+
 int
 rte_eth_vhost_get_vid_from_port_id(uint16_t port_id)
 {
@@ -1015,6 +1437,7 @@ eth_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 		   const struct rte_eth_rxconf *rx_conf __rte_unused,
 		   struct rte_mempool *mb_pool)
 {
+	struct pmd_internal *internal = dev->data->dev_private;
 	struct vhost_queue *vq;
 
 	vq = rte_zmalloc_socket(NULL, sizeof(struct vhost_queue),
@@ -1025,7 +1448,16 @@ eth_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 	}
 
 	vq->mb_pool = mb_pool;
-	vq->virtqueue_id = rx_queue_id * VIRTIO_QNUM + VIRTIO_TXQ;
+	vq->virtqueue_id = rx_queue_id * internal->vrings_per_queue *
+		VIRTIO_QNUM + VIRTIO_TXQ;
+	vq->nb_vrings = internal->vrings_per_queue;
+	vq->burst = internal->burst;
+	/* Rx interrupts let the application manage the notifications. */
+	if (!dev->data->dev_conf.intr_conf.rxq) {
+		vq->adaptive_polls = internal->adaptive_polls;
+		vq->sleep_us = internal->adaptive_sleep_us;
+	}
+	vq->state_tsc = rte_rdtsc();
 	dev->data->rx_queues[rx_queue_id] = vq;
 
 	return 0;
@@ -1037,6 +1469,7 @@ eth_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 		   unsigned int socket_id,
 		   const struct rte_eth_txconf *tx_conf __rte_unused)
 {
+	struct pmd_internal *internal = dev->data->dev_private;
 	struct vhost_queue *vq;
 
 	vq = rte_zmalloc_socket(NULL, sizeof(struct vhost_queue),
@@ -1046,7 +1479,10 @@ eth_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 		return -ENOMEM;
 	}
 
-	vq->virtqueue_id = tx_queue_id * VIRTIO_QNUM + VIRTIO_RXQ;
+	vq->virtqueue_id = tx_queue_id * internal->vrings_per_queue *
+		VIRTIO_QNUM + VIRTIO_RXQ;
+	vq->nb_vrings = internal->vrings_per_queue;
+	vq->burst = internal->burst;
 	dev->data->tx_queues[tx_queue_id] = vq;
 
 	return 0;
@@ -1071,7 +1507,11 @@ eth_dev_info(struct rte_eth_dev *dev,
 	dev_info->min_rx_bufsize = 0;
 
 	dev_info->tx_offload_capa = DEV_TX_OFFLOAD_MULTI_SEGS |
-				DEV_TX_OFFLOAD_VLAN_INSERT;
+				DEV_TX_OFFLOAD_VLAN_INSERT |
+				DEV_TX_OFFLOAD_IPV4_CKSUM |
+				DEV_TX_OFFLOAD_TCP_CKSUM |
+				DEV_TX_OFFLOAD_UDP_CKSUM |
+				DEV_TX_OFFLOAD_TCP_TSO;
 	dev_info->rx_offload_capa = DEV_RX_OFFLOAD_VLAN_STRIP;
 }
 
@@ -1167,12 +1607,18 @@ static uint32_t
 eth_rx_queue_count(struct rte_eth_dev *dev, uint16_t rx_queue_id)
 {
 	struct vhost_queue *vq;
+	uint32_t count = 0;
+	uint16_t i;
 
 	vq = dev->data->rx_queues[rx_queue_id];
 	if (vq == NULL)
 		return 0;
 
-	return rte_vhost_rx_queue_count(vq->vid, vq->virtqueue_id);
+	for (i = 0; i < vq->nb_vrings; i++)
+		count += rte_vhost_rx_queue_count(vq->vid,
+						  vhost_queue_vring(vq, i));
+
+	return count;
 }
 
 static const struct eth_dev_ops ops = {
@@ -1201,7 +1647,9 @@ static struct rte_vdev_driver pmd_vhost_drv;
 
 static int
 eth_dev_vhost_create(struct rte_vdev_device *dev, char *iface_name,
-	int16_t queues, const unsigned int numa_node, uint64_t flags)
+	int16_t queues, const unsigned int numa_node, uint64_t flags,
+	uint16_t adaptive_polls, uint16_t adaptive_sleep_us, uint16_t burst,
+	uint16_t vrings_per_queue)
 {
 	const char *name = rte_vdev_device_name(dev);
 	struct rte_eth_dev_data *data;
@@ -1261,6 +1709,10 @@ eth_dev_vhost_create(struct rte_vdev_device *dev, char *iface_name,
 	data->nb_tx_queues = queues;
 	internal->max_queues = queues;
 	internal->vid = -1;
+	internal->adaptive_polls = adaptive_polls;
+	internal->adaptive_sleep_us = adaptive_sleep_us;
+	internal->burst = burst;
+	internal->vrings_per_queue = vrings_per_queue;
 	data->dev_link = pmd_link;
 	data->dev_flags = RTE_ETH_DEV_INTR_LSC;
 
@@ -1269,6 +1721,7 @@ eth_dev_vhost_create(struct rte_vdev_device *dev, char *iface_name,
 	/* finally assign rx and tx ops */
 	eth_dev->rx_pkt_burst = eth_vhost_rx;
 	eth_dev->tx_pkt_burst = eth_vhost_tx;
+	eth_dev->tx_pkt_prepare = eth_vhost_tx_prepare;
 
 	if (rte_vhost_driver_register(iface_name, flags))
 		goto error;
@@ -1339,6 +1792,11 @@ rte_pmd_vhost_probe(struct rte_vdev_device *dev)
 	int dequeue_zero_copy = 0;
 	int iommu_support = 0;
 	int postcopy_support = 0;
+	int shared_mem = 0;
+	uint16_t adaptive_polls = 0;
+	uint16_t adaptive_sleep_us = VHOST_ADAPTIVE_SLEEP_US;
+	uint16_t burst = VHOST_MAX_PKT_BURST;
+	uint16_t vrings_per_queue = 1;
 	struct rte_eth_dev *eth_dev;
 	const char *name = rte_vdev_device_name(dev);
 
@@ -1420,11 +1878,63 @@ rte_pmd_vhost_probe(struct rte_vdev_device *dev)
 			flags |= RTE_VHOST_USER_POSTCOPY_SUPPORT;
 	}
 
+	if (rte_kvargs_count(kvlist, ETH_VHOST_SHARED_MEM) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_SHARED_MEM,
+					 &open_int, &shared_mem);
+		if (ret < 0)
+			goto out_free;
+
+		if (shared_mem)
+			flags |= RTE_VHOST_USER_SHARED_MEM;
+	}
+
+	if (rte_kvargs_count(kvlist, ETH_VHOST_ADAPTIVE_POLL) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_ADAPTIVE_POLL,
+					 &open_int, &adaptive_polls);
+		if (ret < 0)
+			goto out_free;
+	}
+
+	if (rte_kvargs_count(kvlist, ETH_VHOST_ADAPTIVE_SLEEP) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_ADAPTIVE_SLEEP,
+					 &open_int, &adaptive_sleep_us);
+		if (ret < 0)
+			goto out_free;
+	}
+
+	if (rte_kvargs_count(kvlist, ETH_VHOST_BURST_SIZE) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_BURST_SIZE,
+					 &open_int, &burst);
+		if (ret < 0)
+			goto out_free;
+		if (burst == 0 || burst > VHOST_MAX_PKT_BURST) {
+			VHOST_LOG(ERR, "burst-size must be 1 to %d\n",
+				VHOST_MAX_PKT_BURST);
+			ret = -EINVAL;
+			goto out_free;
+		}
+	}
+
+	if (rte_kvargs_count(kvlist, ETH_VHOST_VRINGS_PER_QUEUE) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_VRINGS_PER_QUEUE,
+					 &open_int, &vrings_per_queue);
+		if (ret < 0)
+			goto out_free;
+		if (vrings_per_queue == 0 ||
+		    vrings_per_queue > VHOST_MAX_VRINGS_PER_QUEUE) {
+			VHOST_LOG(ERR, "vrings-per-queue must be 1 to %d\n",
+				VHOST_MAX_VRINGS_PER_QUEUE);
+			ret = -EINVAL;
+			goto out_free;
+		}
+	}
+
 	if (dev->device.numa_node == SOCKET_ID_ANY)
 		dev->device.numa_node = rte_socket_id();
 
 	eth_dev_vhost_create(dev, iface_name, queues, dev->device.numa_node,
-		flags);
+		flags, adaptive_polls, adaptive_sleep_us, burst,
+		vrings_per_queue);
 
 out_free:
 	rte_kvargs_free(kvlist);
@@ -1471,7 +1981,12 @@ RTE_PMD_REGISTER_PARAM_STRING(net_vhost,
 	"client=<0|1> "
 	"dequeue-zero-copy=<0|1> "
 	"iommu-support=<0|1> "
-	"postcopy-support=<0|1>");
+	"postcopy-support=<0|1> "
+	"shared-mem=<0|1> "
+	"adaptive-poll=<int> "
+	"adaptive-sleep-us=<int> "
+	"burst-size=<int> "
+	"vrings-per-queue=<int>");
 
 RTE_INIT(vhost_init_log)
 {
@@ -12,6 +12,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <rte_compat.h>
 #include <rte_vhost.h>
 
 /*
@@ -52,6 +53,172 @@ int rte_eth_vhost_get_queue_event(uint16_t port_id,
  */
 int rte_eth_vhost_get_vid_from_port_id(uint16_t port_id);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Tune the adaptive polling of an Rx queue. After empty_polls consecutive
+ * empty receive bursts, the queue enables the guest notifications and each
+ * receive burst sleeps on the guest kick for at most sleep_us. The queue
+ * goes back to busy polling as soon as packets come. Time spent in each
+ * state is reported in the rx_adaptive_* xstats. Not available with Rx
+ * interrupts.
+ *
+ * @param port_id
+ *  Port id.
+ * @param queue_id
+ *  Rx queue id, the queue must be set up.
+ * @param empty_polls
+ *  Empty bursts before sleeping, 0 disables adaptive polling.
+ * @param sleep_us
+ *  Longest sleep of one receive burst, in microseconds.
+ * @return
+ *  - On success, zero.
+ *  - On failure, a negative value.
+ */
+int __rte_experimental
+rte_eth_vhost_set_rxq_adaptive_poll(uint16_t port_id, uint16_t queue_id,
+		uint32_t empty_polls, uint32_t sleep_us);
+
+/**
+ * Tx arbiter: shares a Tx queue between the Rx queues of vhost ports, one
+ * per VM, with deficit round robin. Each visit of an input receives one
+ * burst, which is charged to the deficit of the input: the inputs get the
+ * link in proportion to their weights whatever their polling order, and
+ * what they cannot send stays in their vrings.
+ */
+struct rte_eth_vhost_arb;
+
+/** Tx arbiter parameters */
+struct rte_eth_vhost_arb_params {
+	uint16_t port_id;	/**< Output port */
+	uint16_t queue_id;	/**< Output Tx queue */
+	/** Bytes credited to an input of weight 1 at each round */
+	uint32_t quantum;
+	/** Packets received at most per input visit, up to 32 */
+	uint16_t burst_size;
+	int socket_id;		/**< Socket of the arbiter memory */
+};
+
+/** Tx arbiter statistics of an input */
+struct rte_eth_vhost_arb_stats {
+	uint64_t packets;	/**< Packets received from the input */
+	uint64_t bytes;		/**< Bytes of these packets */
+	uint64_t throttled;	/**< Visits skipped by the rate cap */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a Tx arbiter.
+ *
+ * @param params
+ *  Arbiter parameters.
+ * @return
+ *  The arbiter on success, NULL with rte_errno set on failure.
+ */
+struct rte_eth_vhost_arb * __rte_experimental
+rte_eth_vhost_arb_create(const struct rte_eth_vhost_arb_params *params);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free a Tx arbiter, and the packets it still holds.
+ *
+ * @param arb
+ *  Arbiter.
+ */
+void __rte_experimental
+rte_eth_vhost_arb_free(struct rte_eth_vhost_arb *arb);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add an Rx queue of a vhost port to the inputs of a Tx arbiter, or update
+ * its weight and rate cap. Must not be called while the arbiter runs.
+ *
+ * @param arb
+ *  Arbiter.
+ * @param port_id
+ *  Vhost port id.
+ * @param queue_id
+ *  Rx queue id.
+ * @param weight
+ *  Quanta credited to the input at each round, at least 1.
+ * @param rate
+ *  Rate cap of the input in bytes per second, 0 for none.
+ * @return
+ *  - On success, zero.
+ *  - On failure, a negative value.
+ */
+int __rte_experimental
+rte_eth_vhost_arb_input_add(struct rte_eth_vhost_arb *arb, uint16_t port_id,
+		uint16_t queue_id, uint32_t weight, uint64_t rate);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Remove an input of a Tx arbiter. Must not be called while the arbiter
+ * runs.
+ *
+ * @param arb
+ *  Arbiter.
+ * @param port_id
+ *  Vhost port id.
+ * @param queue_id
+ *  Rx queue id.
+ * @return
+ *  - On success, zero.
+ *  - On failure, a negative value.
+ */
+int __rte_experimental
+rte_eth_vhost_arb_input_remove(struct rte_eth_vhost_arb *arb,
+		uint16_t port_id, uint16_t queue_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Run a round of a Tx arbiter: visit the inputs which have credit, then
+ * transmit what they gave. The packets the Tx queue did not take are sent
+ * first at the next round, and the round stops early while they fill the
+ * arbiter, so a congested link pushes back on the vrings. Meant to be
+ * called in the polling loop of the lcore owning the output Tx queue.
+ *
+ * @param arb
+ *  Arbiter.
+ * @return
+ *  Number of packets transmitted.
+ */
+uint16_t __rte_experimental
+rte_eth_vhost_arb_run(struct rte_eth_vhost_arb *arb);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the statistics of an input of a Tx arbiter.
+ *
+ * @param arb
+ *  Arbiter.
+ * @param port_id
+ *  Vhost port id.
+ * @param queue_id
+ *  Rx queue id.
+ * @param stats
+ *  Statistics of the input.
+ * @return
+ *  - On success, zero.
+ *  - On failure, a negative value.
+ */
+int __rte_experimental
+rte_eth_vhost_arb_stats_get(struct rte_eth_vhost_arb *arb, uint16_t port_id,
+		uint16_t queue_id, struct rte_eth_vhost_arb_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,297 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_errno.h>
+#include <rte_ether.h>
+#include <rte_ethdev.h>
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+#include <rte_cycles.h>
+
+#include "rte_eth_vhost.h"
+
+#define VHOST_ARB_MAX_BURST	32
+/* Packets held between two rounds, the Tx queue pushes back beyond */
+#define VHOST_ARB_MAX_PKTS	(4 * VHOST_ARB_MAX_BURST)
+#define VHOST_ARB_MAX_INPUTS	RTE_MAX_ETHPORTS
+/* Shortest rate cap bucket, in ms of the rate */
+#define VHOST_ARB_TB_MS		1
+
+struct vhost_arb_input {
+	uint16_t port_id;
+	uint16_t queue_id;
+	uint32_t weight;
+	/* Bytes the input may still send in this round, negative if owed */
+	int64_t deficit;
+
+	/* Token bucket of the rate cap, in bytes, no cap if rate is 0 */
+	uint64_t rate;
+	int64_t tokens;
+	int64_t tb_size;
+	uint64_t tb_fill_cycles;
+	uint64_t tb_time;
+
+	struct rte_eth_vhost_arb_stats stats;
+} __rte_cache_aligned;
+
+struct rte_eth_vhost_arb {
+	uint16_t port_id;
+	uint16_t queue_id;
+	uint32_t quantum;
+	uint16_t burst_size;
+	uint16_t nb_inputs;
+	/* Input visited first by the next round */
+	uint16_t next;
+	/* The next input got its quantum, its visit was cut short */
+	uint8_t resume;
+	uint16_t nb_pkts;
+	uint64_t hz;
+	struct rte_mbuf *pkts[VHOST_ARB_MAX_PKTS];
+	struct vhost_arb_input inputs[VHOST_ARB_MAX_INPUTS];
+};
+
+struct rte_eth_vhost_arb * __rte_experimental
+rte_eth_vhost_arb_create(const struct rte_eth_vhost_arb_params *params)
+{
+	struct rte_eth_vhost_arb *arb;
+
+	if (params == NULL || !rte_eth_dev_is_valid_port(params->port_id) ||
+			params->quantum == 0 || params->burst_size == 0 ||
+			params->burst_size > VHOST_ARB_MAX_BURST) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	arb = rte_zmalloc_socket("vhost_arb", sizeof(*arb),
+			RTE_CACHE_LINE_SIZE, params->socket_id);
+	if (arb == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	arb->port_id = params->port_id;
+	arb->queue_id = params->queue_id;
+	arb->quantum = params->quantum;
+	arb->burst_size = params->burst_size;
+	arb->hz = rte_get_tsc_hz();
+
+	return arb;
+}
+
+void __rte_experimental
+rte_eth_vhost_arb_free(struct rte_eth_vhost_arb *arb)
+{
+	uint16_t i;
+
+	if (arb == NULL)
+		return;
+
+	for (i = 0; i < arb->nb_pkts; i++)
+		rte_pktmbuf_free(arb->pkts[i]);
+	rte_free(arb);
+}
+
+static struct vhost_arb_input *
+vhost_arb_input_find(struct rte_eth_vhost_arb *arb, uint16_t port_id,
+		uint16_t queue_id)
+{
+	uint16_t i;
+
+	for (i = 0; i < arb->nb_inputs; i++)
+		if (arb->inputs[i].port_id == port_id &&
+				arb->inputs[i].queue_id == queue_id)
+			return &arb->inputs[i];
+
+	return NULL;
+}
+
+int __rte_experimental
+rte_eth_vhost_arb_input_add(struct rte_eth_vhost_arb *arb, uint16_t port_id,
+		uint16_t queue_id, uint32_t weight, uint64_t rate)
+{
+	struct rte_eth_dev_info dev_info;
+	struct vhost_arb_input *in;
+
+	if (arb == NULL || weight == 0 || !rte_eth_dev_is_valid_port(port_id))
+		return -EINVAL;
+
+	rte_eth_dev_info_get(port_id, &dev_info);
+	if (dev_info.driver_name == NULL ||
+			strcmp(dev_info.driver_name, "net_vhost") != 0 ||
+			queue_id >= dev_info.nb_rx_queues)
+		return -EINVAL;
+
+	in = vhost_arb_input_find(arb, port_id, queue_id);
+	if (in == NULL) {
+		if (arb->nb_inputs == VHOST_ARB_MAX_INPUTS)
+			return -ENOSPC;
+		in = &arb->inputs[arb->nb_inputs++];
+		memset(in, 0, sizeof(*in));
+		in->port_id = port_id;
+		in->queue_id = queue_id;
+	}
+
+	in->weight = weight;
+	in->rate = rate;
+	if (rate) {
+		/* Room for a full burst of the largest frames at least */
+		in->tb_size = RTE_MAX(rate * VHOST_ARB_TB_MS / 1000,
+			(uint64_t)arb->burst_size * ETHER_MAX_LEN);
+		in->tb_fill_cycles = in->tb_size * arb->hz / rate;
+		in->tokens = in->tb_size;
+		in->tb_time = rte_rdtsc();
+	}
+
+	return 0;
+}
+
+int __rte_experimental
+rte_eth_vhost_arb_input_remove(struct rte_eth_vhost_arb *arb,
+		uint16_t port_id, uint16_t queue_id)
+{
+	struct vhost_arb_input *in;
+	uint16_t pos;
+
+	if (arb == NULL)
+		return -EINVAL;
+
+	in = vhost_arb_input_find(arb, port_id, queue_id);
+	if (in == NULL)
+		return -ENOENT;
+
+	pos = in - arb->inputs;
+	memmove(in, in + 1, (arb->nb_inputs - pos - 1) * sizeof(*in));
+	arb->nb_inputs--;
+	if (arb->next > pos)
+		arb->next--;
+	else if (arb->next == pos)
+		arb->resume = 0;
+	if (arb->next >= arb->nb_inputs)
+		arb->next = 0;
+
+	return 0;
+}
+
+static inline void
+vhost_arb_refill(struct vhost_arb_input *in, uint64_t now, uint64_t hz)
+{
+	uint64_t elapsed = now - in->tb_time;
+	uint64_t credit;
+
+	if (elapsed >= in->tb_fill_cycles) {
+		in->tokens = in->tb_size;
+		in->tb_time = now;
+		return;
+	}
+
+	credit = elapsed * in->rate / hz;
+	if (credit == 0)
+		return;
+	/* Only the time which gave the credit, not to lose the remainder */
+	in->tb_time += credit * hz / in->rate;
+	in->tokens = RTE_MIN(in->tokens + (int64_t)credit, in->tb_size);
+}
+
+/*
+ * Receive bursts from the input until its deficit or its tokens run out,
+ * it is drained, or the arbiter is full. Returns 0 in that last case.
+ */
+static inline int
+vhost_arb_visit(struct rte_eth_vhost_arb *arb, struct vhost_arb_input *in)
+{
+	uint32_t bytes;
+	uint16_t i, n;
+
+	while (in->deficit > 0 && (in->rate == 0 || in->tokens > 0)) {
+		if (arb->nb_pkts + arb->burst_size > VHOST_ARB_MAX_PKTS)
+			return 0;
+
+		n = rte_eth_rx_burst(in->port_id, in->queue_id,
+			&arb->pkts[arb->nb_pkts], arb->burst_size);
+		for (i = 0, bytes = 0; i < n; i++)
+			bytes += arb->pkts[arb->nb_pkts + i]->pkt_len;
+		arb->nb_pkts += n;
+
+		in->deficit -= bytes;
+		in->tokens -= bytes;
+		in->stats.packets += n;
+		in->stats.bytes += bytes;
+
+		/* Drained: as in DRR, an empty input keeps no credit */
+		if (n < arb->burst_size) {
+			in->deficit = 0;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+uint16_t __rte_experimental
+rte_eth_vhost_arb_run(struct rte_eth_vhost_arb *arb)
+{
+	struct vhost_arb_input *in;
+	uint64_t now = 0;
+	uint16_t visits, sent;
+
+	for (visits = 0; visits < arb->nb_inputs; visits++) {
+		in = &arb->inputs[arb->next];
+
+		if (!arb->resume) {
+			if (in->rate) {
+				if (now == 0)
+					now = rte_rdtsc();
+				vhost_arb_refill(in, now, arb->hz);
+				if (in->tokens <= 0) {
+					in->stats.throttled++;
+					goto next;
+				}
+			}
+			in->deficit += (int64_t)arb->quantum * in->weight;
+		}
+
+		/* Full, the visit goes on at the next round */
+		if (!vhost_arb_visit(arb, in)) {
+			arb->resume = 1;
+			break;
+		}
+next:
+		arb->resume = 0;
+		if (++arb->next == arb->nb_inputs)
+			arb->next = 0;
+	}
+
+	if (arb->nb_pkts == 0)
+		return 0;
+
+	sent = rte_eth_tx_burst(arb->port_id, arb->queue_id, arb->pkts,
+		arb->nb_pkts);
+	if (sent < arb->nb_pkts)
+		memmove(arb->pkts, &arb->pkts[sent],
+			(arb->nb_pkts - sent) * sizeof(arb->pkts[0]));
+	arb->nb_pkts -= sent;
+
+	return sent;
+}
+
+int __rte_experimental
+rte_eth_vhost_arb_stats_get(struct rte_eth_vhost_arb *arb, uint16_t port_id,
+		uint16_t queue_id, struct rte_eth_vhost_arb_stats *stats)
+{
+	struct vhost_arb_input *in;
+
+	if (arb == NULL || stats == NULL)
+		return -EINVAL;
+
+	in = vhost_arb_input_find(arb, port_id, queue_id);
+	if (in == NULL)
+		return -ENOENT;
+
+	*stats = in->stats;
+
+	return 0;
+}
@@ -70,6 +70,16 @@ static int virtio_mac_addr_add(struct rte_eth_dev *dev,
 static void virtio_mac_addr_remove(struct rte_eth_dev *dev, uint32_t index);
 static int virtio_mac_addr_set(struct rte_eth_dev *dev,
 				struct ether_addr *mac_addr);
+static int virtio_dev_rss_hash_update(struct rte_eth_dev *dev,
+				struct rte_eth_rss_conf *rss_conf);
+static int virtio_dev_rss_hash_conf_get(struct rte_eth_dev *dev,
+				struct rte_eth_rss_conf *rss_conf);
+static int virtio_dev_rss_reta_update(struct rte_eth_dev *dev,
+				struct rte_eth_rss_reta_entry64 *reta_conf,
+				uint16_t reta_size);
+static int virtio_dev_rss_reta_query(struct rte_eth_dev *dev,
+				struct rte_eth_rss_reta_entry64 *reta_conf,
+				uint16_t reta_size);
 
 static int virtio_intr_enable(struct rte_eth_dev *dev);
 static int virtio_intr_disable(struct rte_eth_dev *dev);
@@ -115,6 +125,9 @@ static const struct rte_virtio_xstats_name_off rte_virtio_rxq_stat_strings[] = {
 	{"size_512_1023_packets",  offsetof(struct virtnet_rx, stats.size_bins[5])},
 	{"size_1024_1518_packets", offsetof(struct virtnet_rx, stats.size_bins[6])},
 	{"size_1519_max_packets",  offsetof(struct virtnet_rx, stats.size_bins[7])},
+	{"kicks",                  offsetof(struct virtnet_rx, stats.kicks)},
+	{"refill_failures",        offsetof(struct virtnet_rx, stats.refill_failed)},
+	{"interrupt_enables",      offsetof(struct virtnet_rx, stats.intr_enable)},
 };
 
 /* [rt]x_qX_ is prepended to the name string here */
@@ -132,6 +145,12 @@ static const struct rte_virtio_xstats_name_off rte_virtio_txq_stat_strings[] = {
 	{"size_512_1023_packets",  offsetof(struct virtnet_tx, stats.size_bins[5])},
 	{"size_1024_1518_packets", offsetof(struct virtnet_tx, stats.size_bins[6])},
 	{"size_1519_max_packets",  offsetof(struct virtnet_tx, stats.size_bins[7])},
+	{"kicks",                  offsetof(struct virtnet_tx, stats.kicks)},
+	{"ring_full_events",       offsetof(struct virtnet_tx, stats.ring_full)},
+	{"bursts",                 offsetof(struct virtnet_tx, stats.bursts)},
+	{"free_descriptors",       offsetof(struct virtnet_tx, stats.free_desc)},
+	{"indirect_packets",       offsetof(struct virtnet_tx, stats.indirect)},
+	{"direct_packets",         offsetof(struct virtnet_tx, stats.direct)},
 };
 
 #define VIRTIO_NB_RXQ_XSTATS (sizeof(rte_virtio_rxq_stat_strings) / \
@@ -141,38 +160,77 @@ static const struct rte_virtio_xstats_name_off rte_virtio_txq_stat_strings[] = {
 
 struct virtio_hw_internal virtio_hw_internal[RTE_MAX_ETHPORTS];
 
-static int
-virtio_send_command(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
-		int *dlen, int pkt_num)
+/* Command slot in the header memzone of the control queue */
+static inline struct virtio_pmd_ctrl *
+virtio_ctrl_slot(struct virtnet_ctl *cvq, uint16_t slot)
 {
-	uint32_t head, i;
+	return RTE_PTR_ADD(cvq->virtio_net_hdr_mz->addr,
+		slot * VIRTIO_CTRL_SLOT_SIZE);
+}
+
+static void
+virtio_ctrl_enqueue_packed(struct virtnet_ctl *cvq, uint16_t slot,
+			   int *dlen, int pkt_num)
+{
+	struct virtqueue *vq = cvq->vq;
+	struct vring_packed_desc *desc = vq->vq_ring_packed.desc_packed;
+	rte_iova_t mem = cvq->virtio_net_hdr_mem + slot * VIRTIO_CTRL_SLOT_SIZE;
+	uint16_t head, idx, head_flags;
 	int k, sum = 0;
-	virtio_net_ctrl_ack status = ~0;
-	struct virtio_pmd_ctrl *result;
-	struct virtqueue *vq;
+	int nb_descs = 0;
 
-	ctrl->status = status;
+	/*
+	 * Format is enforced in qemu code:
+	 * One TX packet for header;
+	 * At least one TX packet per argument;
+	 * One RX packet for ACK.
+	 * The flags of the head are written once the whole chain is set.
+	 */
+	head = vq->vq_avail_idx;
+	head_flags = VRING_DESC_F_NEXT | vq->vq_avail_used_flags;
+	desc[head].addr = mem;
+	desc[head].len = sizeof(struct virtio_net_ctrl_hdr);
+	nb_descs++;
+	vq_avail_idx_inc_packed(vq);
 
-	if (!cvq || !cvq->vq) {
-		PMD_INIT_LOG(ERR, "Control queue is not supported.");
-		return -1;
+	for (k = 0; k < pkt_num; k++) {
+		idx = vq->vq_avail_idx;
+		desc[idx].addr = mem
+			+ sizeof(struct virtio_net_ctrl_hdr)
+			+ sizeof(virtio_net_ctrl_ack) + sizeof(uint8_t) * sum;
+		desc[idx].len = dlen[k];
+		desc[idx].flags = VRING_DESC_F_NEXT | vq->vq_avail_used_flags;
+		sum += dlen[k];
+		nb_descs++;
+		vq_avail_idx_inc_packed(vq);
 	}
 
-	rte_spinlock_lock(&cvq->lock);
-	vq = cvq->vq;
-	head = vq->vq_desc_head_idx;
+	idx = vq->vq_avail_idx;
+	desc[idx].addr = mem + sizeof(struct virtio_net_ctrl_hdr);
+	desc[idx].len = sizeof(virtio_net_ctrl_ack);
+	desc[idx].flags = VRING_DESC_F_WRITE | vq->vq_avail_used_flags;
+	nb_descs++;
+	vq_avail_idx_inc_packed(vq);
 
-	PMD_INIT_LOG(DEBUG, "vq->vq_desc_head_idx = %d, status = %d, "
-		"vq->hw->cvq = %p vq = %p",
-		vq->vq_desc_head_idx, status, vq->hw->cvq, vq);
+	vq->vq_descx[head].cookie = virtio_ctrl_slot(cvq, slot);
+	vq->vq_descx[head].ndescs = nb_descs;
 
-	if (vq->vq_free_cnt < pkt_num + 2 || pkt_num < 1) {
-		rte_spinlock_unlock(&cvq->lock);
-		return -1;
-	}
+	desc[head].id = head;
+	virtio_wmb();
+	desc[head].flags = head_flags;
+	vq->vq_free_cnt -= nb_descs;
+}
 
-	memcpy(cvq->virtio_net_hdr_mz->addr, ctrl,
-		sizeof(struct virtio_pmd_ctrl));
+static void
+virtio_ctrl_enqueue_split(struct virtnet_ctl *cvq, uint16_t slot,
+			  int *dlen, int pkt_num)
+{
+	struct virtqueue *vq = cvq->vq;
+	rte_iova_t mem = cvq->virtio_net_hdr_mem + slot * VIRTIO_CTRL_SLOT_SIZE;
+	uint32_t head, i;
+	int k, sum = 0;
+
+	head = vq->vq_desc_head_idx;
 
 	/*
 	 * Format is enforced in qemu code:
@@ -181,16 +239,16 @@ virtio_send_command(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
 	 * One RX packet for ACK.
 	 */
 	vq->vq_ring.desc[head].flags = VRING_DESC_F_NEXT;
-	vq->vq_ring.desc[head].addr = cvq->virtio_net_hdr_mem;
+	vq->vq_ring.desc[head].addr = mem;
 	vq->vq_ring.desc[head].len = sizeof(struct virtio_net_ctrl_hdr);
 	vq->vq_free_cnt--;
 	i = vq->vq_ring.desc[head].next;
 
 	for (k = 0; k < pkt_num; k++) {
 		vq->vq_ring.desc[i].flags = VRING_DESC_F_NEXT;
-		vq->vq_ring.desc[i].addr = cvq->virtio_net_hdr_mem
+		vq->vq_ring.desc[i].addr = mem
 			+ sizeof(struct virtio_net_ctrl_hdr)
-			+ sizeof(ctrl->status) + sizeof(uint8_t)*sum;
+			+ sizeof(virtio_net_ctrl_ack) + sizeof(uint8_t)*sum;
 		vq->vq_ring.desc[i].len = dlen[k];
 		sum += dlen[k];
 		vq->vq_free_cnt--;
@@ -198,30 +256,68 @@ virtio_send_command(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
 	}
 
 	vq->vq_ring.desc[i].flags = VRING_DESC_F_WRITE;
-	vq->vq_ring.desc[i].addr = cvq->virtio_net_hdr_mem
-			+ sizeof(struct virtio_net_ctrl_hdr);
-	vq->vq_ring.desc[i].len = sizeof(ctrl->status);
+	vq->vq_ring.desc[i].addr = mem + sizeof(struct virtio_net_ctrl_hdr);
+	vq->vq_ring.desc[i].len = sizeof(virtio_net_ctrl_ack);
 	vq->vq_free_cnt--;
 
 	vq->vq_desc_head_idx = vq->vq_ring.desc[i].next;
+	vq->vq_descx[head].cookie = virtio_ctrl_slot(cvq, slot);
 
 	vq_update_avail_ring(vq, head);
 	vq_update_avail_idx(vq);
+}
 
-	PMD_INIT_LOG(DEBUG, "vq->vq_queue_index = %d", vq->vq_queue_index);
+/* Release the slot of an acked command */
+static void
+virtio_ctrl_complete(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl)
+{
+	uint16_t slot = RTE_PTR_DIFF(ctrl, cvq->virtio_net_hdr_mz->addr) /
+		VIRTIO_CTRL_SLOT_SIZE;
 
-	virtqueue_notify(vq);
+	/* nobody waits for the asynchronous commands, report them here */
+	if ((cvq->async_slots & (1u << slot)) && ctrl->status != VIRTIO_NET_OK)
+		PMD_DRV_LOG(ERR, "control command class %u cmd %u failed",
+			ctrl->hdr.class, ctrl->hdr.cmd);
 
-	rte_rmb();
-	while (VIRTQUEUE_NUSED(vq) == 0) {
-		rte_rmb();
-		usleep(100);
-	}
+	cvq->free_slots |= 1u << slot;
+	cvq->nb_pending--;
+}
+
+static void
+virtio_ctrl_dequeue_packed(struct virtnet_ctl *cvq)
+{
+	struct virtqueue *vq = cvq->vq;
+	struct vring_packed_desc *desc = vq->vq_ring_packed.desc_packed;
+	struct vq_desc_extra *dxp;
+	uint16_t id;
+
+	while (desc_is_used(&desc[vq->vq_used_cons_idx], vq)) {
+		virtio_rmb();
+		id = desc[vq->vq_used_cons_idx].id;
+		dxp = &vq->vq_descx[id];
+
+		vq->vq_free_cnt += dxp->ndescs;
+		vq_used_idx_add_packed(vq, dxp->ndescs);
+		virtio_ctrl_complete(cvq, dxp->cookie);
+		dxp->cookie = NULL;
+	}
+
+	PMD_INIT_LOG(DEBUG, "vq->vq_free_cnt=%d\nvq->vq_avail_idx=%d\n"
+			"vq->vq_used_cons_idx=%d\nvq->vq_used_wrap_counter=%d",
+			vq->vq_free_cnt, vq->vq_avail_idx,
+			vq->vq_used_cons_idx, vq->vq_used_wrap_counter);
+}
+
+static void
+virtio_ctrl_dequeue_split(struct virtnet_ctl *cvq)
+{
+	struct virtqueue *vq = cvq->vq;
 
 	while (VIRTQUEUE_NUSED(vq)) {
 		uint32_t idx, desc_idx, used_idx;
 		struct vring_used_elem *uep;
 
+		virtio_rmb();
 		used_idx = (uint32_t)(vq->vq_used_cons_idx
 				& (vq->vq_nentries - 1));
 		uep = &vq->vq_ring.used->ring[used_idx];
@@ -238,15 +334,152 @@ virtio_send_command(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
 
 		vq->vq_used_cons_idx++;
 		vq->vq_free_cnt++;
+
+		virtio_ctrl_complete(cvq, vq->vq_descx[idx].cookie);
+		vq->vq_descx[idx].cookie = NULL;
 	}
 
 	PMD_INIT_LOG(DEBUG, "vq->vq_free_cnt=%d\nvq->vq_desc_head_idx=%d",
 			vq->vq_free_cnt, vq->vq_desc_head_idx);
+}
+
+/*
+ * Collect the acked commands, without waiting for the others.
+ * It returns the number of commands still pending.
+ */
+static uint16_t
+virtio_ctrl_poll(struct virtnet_ctl *cvq)
+{
+	if (cvq->nb_pending == 0)
+		return 0;
 
-	result = cvq->virtio_net_hdr_mz->addr;
+	if (vtpci_packed_queue(cvq->vq->hw))
+		virtio_ctrl_dequeue_packed(cvq);
+	else
+		virtio_ctrl_dequeue_split(cvq);
+
+	return cvq->nb_pending;
+}
+
+/*
+ * Post a command in a free slot of the control queue, without notifying
+ * the device: several commands may be posted before a single kick. When
+ * the queue is full, it first waits for the oldest commands to be acked.
+ * It returns the slot of the command, or -1 on error.
+ */
+static int
+virtio_ctrl_enqueue(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
+		    int *dlen, int pkt_num, bool async)
+{
+	struct virtqueue *vq = cvq->vq;
+	uint16_t slot;
+
+	if (pkt_num < 1 || pkt_num + 2 > vq->vq_nentries)
+		return -1;
+
+	while (cvq->free_slots == 0 || vq->vq_free_cnt < pkt_num + 2) {
+		if (virtio_ctrl_poll(cvq) == 0 &&
+		    vq->vq_free_cnt < pkt_num + 2)
+			return -1;
+		usleep(100);
+	}
+
+	PMD_INIT_LOG(DEBUG, "vq->vq_desc_head_idx = %d, "
+		"vq->hw->cvq = %p vq = %p",
+		vq->vq_desc_head_idx, vq->hw->cvq, vq);
+
+	slot = rte_bsf32(cvq->free_slots);
+	cvq->free_slots &= ~(1u << slot);
+	if (async)
+		cvq->async_slots |= 1u << slot;
+	else
+		cvq->async_slots &= ~(1u << slot);
+	cvq->nb_pending++;
+
+	ctrl->status = (virtio_net_ctrl_ack)~0;
+	memcpy(virtio_ctrl_slot(cvq, slot), ctrl,
+		sizeof(struct virtio_pmd_ctrl));
+
+	if (vtpci_packed_queue(vq->hw))
+		virtio_ctrl_enqueue_packed(cvq, slot, dlen, pkt_num);
+	else
+		virtio_ctrl_enqueue_split(cvq, slot, dlen, pkt_num);
+
+	return slot;
+}
+
+/* Notify the device of the posted commands */
+static inline void
+virtio_ctrl_kick(struct virtnet_ctl *cvq)
+{
+	PMD_INIT_LOG(DEBUG, "vq->vq_queue_index = %d",
+		cvq->vq->vq_queue_index);
+
+	virtqueue_notify(cvq->vq);
+}
+
+/* Send a command and wait for its ack, it returns the ack status */
+static int
+virtio_send_command(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
+		int *dlen, int pkt_num)
+{
+	int status;
+	int slot;
+
+	if (!cvq || !cvq->vq) {
+		PMD_INIT_LOG(ERR, "Control queue is not supported.");
+		return -1;
+	}
+
+	rte_spinlock_lock(&cvq->lock);
+
+	slot = virtio_ctrl_enqueue(cvq, ctrl, dlen, pkt_num, false);
+	if (slot < 0) {
+		rte_spinlock_unlock(&cvq->lock);
+		return -1;
+	}
+
+	virtio_ctrl_kick(cvq);
+
+	/* wait for used descriptors in virtqueue */
+	for (;;) {
+		virtio_ctrl_poll(cvq);
+		if (cvq->free_slots & (1u << slot))
+			break;
+		usleep(100);
+	}
+
+	status = virtio_ctrl_slot(cvq, slot)->status;
 
 	rte_spinlock_unlock(&cvq->lock);
-	return result->status;
+	return status;
+}
+
+/*
+ * Send a command without waiting for its ack: the acks are collected by
+ * the next commands, and an error is only logged. The queue is kicked for
+ * each command, the device may still process several of them at once.
+ */
+static int
+virtio_send_command_async(struct virtnet_ctl *cvq,
+		struct virtio_pmd_ctrl *ctrl, int *dlen, int pkt_num)
+{
+	int slot;
+
+	if (!cvq || !cvq->vq) {
+		PMD_INIT_LOG(ERR, "Control queue is not supported.");
+		return -1;
+	}
+
+	rte_spinlock_lock(&cvq->lock);
+
+	virtio_ctrl_poll(cvq);
+	slot = virtio_ctrl_enqueue(cvq, ctrl, dlen, pkt_num, true);
+	if (slot >= 0)
+		virtio_ctrl_kick(cvq);
+
+	rte_spinlock_unlock(&cvq->lock);
+	return slot < 0 ? -1 : 0;
 }
 
 static int
@@ -273,6 +506,181 @@ virtio_set_multiple_queues(struct rte_eth_dev *dev, uint16_t nb_queues)
 	return 0;
 }
 
+/* ETH_RSS_* flow types of each VIRTIO_NET_HASH_TYPE_* */
+static const struct {
+	uint32_t hash_type;
+	uint64_t rss_hf;
+} virtio_rss_hash_types[] = {
+	{ VIRTIO_NET_HASH_TYPE_IPV4,
+	  ETH_RSS_IPV4 | ETH_RSS_FRAG_IPV4 | ETH_RSS_NONFRAG_IPV4_OTHER },
+	{ VIRTIO_NET_HASH_TYPE_TCPV4, ETH_RSS_NONFRAG_IPV4_TCP },
+	{ VIRTIO_NET_HASH_TYPE_UDPV4, ETH_RSS_NONFRAG_IPV4_UDP },
+	{ VIRTIO_NET_HASH_TYPE_IPV6,
+	  ETH_RSS_IPV6 | ETH_RSS_FRAG_IPV6 | ETH_RSS_NONFRAG_IPV6_OTHER },
+	{ VIRTIO_NET_HASH_TYPE_TCPV6, ETH_RSS_NONFRAG_IPV6_TCP },
+	{ VIRTIO_NET_HASH_TYPE_UDPV6, ETH_RSS_NONFRAG_IPV6_UDP },
+	{ VIRTIO_NET_HASH_TYPE_IP_EX, ETH_RSS_IPV6_EX },
+	{ VIRTIO_NET_HASH_TYPE_TCP_EX, ETH_RSS_IPV6_TCP_EX },
+	{ VIRTIO_NET_HASH_TYPE_UDP_EX, ETH_RSS_IPV6_UDP_EX },
+};
+
+/* Toeplitz key used when the application does not give one */
+static const uint8_t virtio_rss_default_key[VIRTIO_NET_RSS_KEY_SIZE] = {
+	0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+	0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+	0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+	0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+	0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+};
+
+static uint32_t
+virtio_rss_hf_to_hash_types(uint64_t rss_hf)
+{
+	uint32_t hash_types = 0;
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(virtio_rss_hash_types); i++)
+		if (rss_hf & virtio_rss_hash_types[i].rss_hf)
+			hash_types |= virtio_rss_hash_types[i].hash_type;
+
+	return hash_types;
+}
+
+static uint64_t
+virtio_hash_types_to_rss_hf(uint32_t hash_types)
+{
+	uint64_t rss_hf = 0;
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(virtio_rss_hash_types); i++)
+		if (hash_types & virtio_rss_hash_types[i].hash_type)
+			rss_hf |= virtio_rss_hash_types[i].rss_hf;
+
+	return rss_hf;
+}
+
+/*
+ * Send the hash types, the key and the indirection table to the device:
+ * an RSS configuration with VIRTIO_NET_F_RSS, which also sets the number
+ * of queue pairs, or else only the hash one for VIRTIO_NET_F_HASH_REPORT.
+ */
+static int
+virtio_set_rss(struct rte_eth_dev *dev)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct virtio_net_ctrl_rss_key *key;
+	struct virtio_net_ctrl_rss *rss;
+	struct virtio_pmd_ctrl ctrl;
+	uint16_t reta_size = 1;
+	int dlen[1];
+	int ret;
+
+	rss = (struct virtio_net_ctrl_rss *)ctrl.data;
+	memset(rss, 0, sizeof(*rss) + sizeof(hw->rss_reta) + sizeof(*key));
+
+	ctrl.hdr.class = VIRTIO_NET_CTRL_MQ;
+	rss->hash_types = hw->rss_hf_types;
+	key = (struct virtio_net_ctrl_rss_key *)&rss->indirection_table[1];
+
+	if (vtpci_with_feature(hw, VIRTIO_NET_F_RSS)) {
+		ctrl.hdr.cmd = VIRTIO_NET_CTRL_MQ_RSS_CONFIG;
+		reta_size = hw->rss_reta_size;
+		rss->indirection_table_mask = reta_size - 1;
+		memcpy(rss->indirection_table, hw->rss_reta,
+			reta_size * sizeof(uint16_t));
+		key = (struct virtio_net_ctrl_rss_key *)
+			&rss->indirection_table[reta_size];
+		key->max_tx_vq = RTE_MAX(dev->data->nb_rx_queues,
+			dev->data->nb_tx_queues);
+	} else {
+		ctrl.hdr.cmd = VIRTIO_NET_CTRL_MQ_HASH_CONFIG;
+	}
+
+	key->hash_key_length = VIRTIO_NET_RSS_KEY_SIZE;
+	memcpy(key->hash_key_data, hw->rss_key, VIRTIO_NET_RSS_KEY_SIZE);
+
+	dlen[0] = sizeof(*rss) + reta_size * sizeof(uint16_t) + sizeof(*key);
+
+	ret = virtio_send_command(hw->cvq, &ctrl, dlen, 1);
+	if (ret) {
+		PMD_INIT_LOG(ERR, "RSS configuration failed");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Read the RSS limits and the hash types of the device: they are reported
+ * when offered, before the configuration negotiates them.
+ */
+static void
+virtio_get_rss_caps(struct virtio_hw *hw)
+{
+	uint64_t host_features = VTPCI_OPS(hw)->get_features(hw);
+	uint32_t hash_types;
+	uint16_t reta_size;
+
+	hw->rss_hash_types = 0;
+	hw->rss_reta_size = 0;
+
+	if (!(host_features & ((1ULL << VIRTIO_NET_F_RSS) |
+			       (1ULL << VIRTIO_NET_F_HASH_REPORT))))
+		return;
+
+	vtpci_read_dev_config(hw,
+		offsetof(struct virtio_net_config, supported_hash_types),
+		&hash_types, sizeof(hash_types));
+	hw->rss_hash_types = hash_types & VIRTIO_NET_HASH_TYPE_MASK;
+
+	if (!(host_features & (1ULL << VIRTIO_NET_F_RSS)))
+		return;
+
+	vtpci_read_dev_config(hw,
+		offsetof(struct virtio_net_config,
+			 rss_max_indirection_table_length),
+		&reta_size, sizeof(reta_size));
+	hw->rss_reta_size = rte_align32prevpow2(RTE_MIN(reta_size,
+		VIRTIO_NET_RSS_RETA_SIZE));
+}
+
+/* Hash types, key and default indirection table of the port configuration */
+static int
+virtio_dev_rss_init(struct rte_eth_dev *dev)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_rss_conf *rss_conf =
+		&dev->data->dev_conf.rx_adv_conf.rss_conf;
+	uint16_t nb_rx_queues = RTE_MAX(dev->data->nb_rx_queues, 1);
+	uint16_t i;
+
+	if (rss_conf->rss_hf & ~virtio_hash_types_to_rss_hf(hw->rss_hash_types)) {
+		PMD_INIT_LOG(ERR, "RSS hash functions 0x%" PRIx64
+			" not supported by the device", rss_conf->rss_hf);
+		return -EINVAL;
+	}
+
+	if (rss_conf->rss_key != NULL) {
+		if (rss_conf->rss_key_len != VIRTIO_NET_RSS_KEY_SIZE) {
+			PMD_INIT_LOG(ERR, "RSS key length must be %u",
+				VIRTIO_NET_RSS_KEY_SIZE);
+			return -EINVAL;
+		}
+		memcpy(hw->rss_key, rss_conf->rss_key,
+			VIRTIO_NET_RSS_KEY_SIZE);
+	} else {
+		memcpy(hw->rss_key, virtio_rss_default_key,
+			VIRTIO_NET_RSS_KEY_SIZE);
+	}
+
+	hw->rss_hf_types = virtio_rss_hf_to_hash_types(rss_conf->rss_hf);
+
+	for (i = 0; i < hw->rss_reta_size; i++)
+		hw->rss_reta[i] = i % nb_rx_queues;
+
+	return 0;
+}
+
 static void
 virtio_dev_queue_release(void *queue __rte_unused)
 {
@@ -303,15 +711,28 @@ virtio_init_vring(struct virtqueue *vq)
 	 * Reinitialise since virtio port might have been stopped and restarted
 	 */
 	memset(ring_mem, 0, vq->vq_ring_size);
-	vring_init(vr, size, ring_mem, VIRTIO_PCI_VRING_ALIGN);
+
 	vq->vq_used_cons_idx = 0;
 	vq->vq_desc_head_idx = 0;
 	vq->vq_avail_idx = 0;
+	vq->vq_kick_idx = 0;
+	vq->vq_kick_wrap_counter = 1;
 	vq->vq_desc_tail_idx = (uint16_t)(vq->vq_nentries - 1);
 	vq->vq_free_cnt = vq->vq_nentries;
 	memset(vq->vq_descx, 0, sizeof(struct vq_desc_extra) * vq->vq_nentries);
 
-	vring_desc_init(vr->desc, size);
+	if (vtpci_packed_queue(vq->hw)) {
+		vring_init_packed(&vq->vq_ring_packed, size, ring_mem,
+				  VIRTIO_PCI_VRING_ALIGN);
+		vq->vq_avail_used_flags = VRING_DESC_F_AVAIL(1);
+		vq->vq_used_wrap_counter = 1;
+		/* the event areas were just zeroed, i.e. enabled */
+		vq->vq_event_flags_shadow = RING_EVENT_FLAGS_ENABLE;
+		vring_desc_init_packed(vq, size);
+	} else {
+		vring_init(vr, size, ring_mem, VIRTIO_PCI_VRING_ALIGN);
+		vring_desc_init(vr->desc, size);
+	}
 
 	/*
 	 * Disable device(host) interrupting guest
@@ -369,8 +790,8 @@ virtio_init_queue(struct rte_eth_dev *dev, uint16_t vtpci_queue_idx)
 		 */
 		sz_hdr_mz = vq_size * sizeof(struct virtio_tx_region);
 	} else if (queue_type == VTNET_CQ) {
-		/* Allocate a page for control vq command, data and status */
-		sz_hdr_mz = PAGE_SIZE;
+		/* Allocate the slots of the commands, data and status */
+		sz_hdr_mz = VIRTIO_MAX_CTRL_CMDS * VIRTIO_CTRL_SLOT_SIZE;
 	}
 
 	vq = rte_zmalloc_socket(vq_name, size, RTE_CACHE_LINE_SIZE,
@@ -388,7 +809,10 @@ virtio_init_queue(struct rte_eth_dev *dev, uint16_t vtpci_queue_idx)
 	/*
 	 * Reserve a memzone for vring elements
 	 */
-	size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	if (vtpci_packed_queue(hw))
+		size = vring_size_packed(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	else
+		size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
 	vq->vq_ring_size = RTE_ALIGN_CEIL(size, VIRTIO_PCI_VRING_ALIGN);
 	PMD_INIT_LOG(DEBUG, "vring_size: %d, rounded_vring_size: %d",
 		     size, vq->vq_ring_size);
@@ -462,7 +886,8 @@ virtio_init_queue(struct rte_eth_dev *dev, uint16_t vtpci_queue_idx)
 		cvq->mz = mz;
 		cvq->virtio_net_hdr_mz = hdr_mz;
 		cvq->virtio_net_hdr_mem = hdr_mz->iova;
-		memset(cvq->virtio_net_hdr_mz->addr, 0, PAGE_SIZE);
+		memset(cvq->virtio_net_hdr_mz->addr, 0, sz_hdr_mz);
+		cvq->free_slots = RTE_LEN2MASK(VIRTIO_MAX_CTRL_CMDS, uint32_t);
 
 		hw->cvq = cvq;
 	}
@@ -488,7 +913,21 @@ virtio_init_queue(struct rte_eth_dev *dev, uint16_t vtpci_queue_idx)
 
 		txr = hdr_mz->addr;
 		memset(txr, 0, vq_size * sizeof(*txr));
-		for (i = 0; i < vq_size; i++) {
+		for (i = 0; i < vq_size && vtpci_packed_queue(hw); i++) {
+			struct vring_packed_desc *start_dp =
+				txr[i].tx_packed_indir;
+
+			vring_desc_init_indirect_packed(start_dp,
+					RTE_DIM(txr[i].tx_packed_indir));
+
+			/* first indirect descriptor is always the tx header */
+			start_dp->addr = txvq->virtio_net_hdr_mem
+				+ i * sizeof(*txr)
+				+ offsetof(struct virtio_tx_region, tx_hdr);
+
+			start_dp->len = hw->vtnet_hdr_size;
+		}
+		for (i = 0; i < vq_size && !vtpci_packed_queue(hw); i++) {
 			struct vring_desc *start_dp = txr[i].tx_indir;
 
 			vring_desc_init(start_dp, RTE_DIM(txr[i].tx_indir));
@@ -594,6 +1033,8 @@ virtio_dev_close(struct rte_eth_dev *dev)
 		return;
 	hw->opened = false;
 
+	virtio_standby_close(dev);
+
 	/* reset the NIC */
 	if (dev->data->dev_flags & RTE_ETH_DEV_INTR_LSC)
 		VTPCI_OPS(hw)->set_config_irq(hw, VIRTIO_MSI_NO_VECTOR);
@@ -620,6 +1061,8 @@ virtio_dev_promiscuous_enable(struct rte_eth_dev *dev)
 	int dlen[1];
 	int ret;
 
+	virtio_standby_promiscuous_enable(dev);
+
 	if (!vtpci_with_feature(hw, VIRTIO_NET_F_CTRL_RX)) {
 		PMD_INIT_LOG(INFO, "host does not support rx control");
 		return;
@@ -643,6 +1086,8 @@ virtio_dev_promiscuous_disable(struct rte_eth_dev *dev)
 	int dlen[1];
 	int ret;
 
+	virtio_standby_promiscuous_disable(dev);
+
 	if (!vtpci_with_feature(hw, VIRTIO_NET_F_CTRL_RX)) {
 		PMD_INIT_LOG(INFO, "host does not support rx control");
 		return;
@@ -666,6 +1111,8 @@ virtio_dev_allmulticast_enable(struct rte_eth_dev *dev)
 	int dlen[1];
 	int ret;
 
+	virtio_standby_allmulticast_enable(dev);
+
 	if (!vtpci_with_feature(hw, VIRTIO_NET_F_CTRL_RX)) {
 		PMD_INIT_LOG(INFO, "host does not support rx control");
 		return;
@@ -689,6 +1136,8 @@ virtio_dev_allmulticast_disable(struct rte_eth_dev *dev)
 	int dlen[1];
 	int ret;
 
+	virtio_standby_allmulticast_disable(dev);
+
 	if (!vtpci_with_feature(hw, VIRTIO_NET_F_CTRL_RX)) {
 		PMD_INIT_LOG(INFO, "host does not support rx control");
 		return;
@@ -731,6 +1180,7 @@ virtio_dev_rx_queue_intr_enable(struct rte_eth_dev *dev, uint16_t queue_id)
 	struct virtqueue *vq = rxvq->vq;
 
 	virtqueue_enable_intr(vq);
+	rxvq->stats.intr_enable++;
 	return 0;
 }
 
@@ -778,6 +1228,10 @@ static const struct eth_dev_ops virtio_eth_dev_ops = {
 	.mac_addr_add            = virtio_mac_addr_add,
 	.mac_addr_remove         = virtio_mac_addr_remove,
 	.mac_addr_set            = virtio_mac_addr_set,
+	.rss_hash_update         = virtio_dev_rss_hash_update,
+	.rss_hash_conf_get       = virtio_dev_rss_hash_conf_get,
+	.reta_update             = virtio_dev_rss_reta_update,
+	.reta_query              = virtio_dev_rss_reta_query,
 };
 
 static void
@@ -928,13 +1382,7 @@ virtio_dev_stats_reset(struct rte_eth_dev *dev)
 		if (txvq == NULL)
 			continue;
 
-		txvq->stats.packets = 0;
-		txvq->stats.bytes = 0;
-		txvq->stats.errors = 0;
-		txvq->stats.multicast = 0;
-		txvq->stats.broadcast = 0;
-		memset(txvq->stats.size_bins, 0,
-		       sizeof(txvq->stats.size_bins[0]) * 8);
+		memset(&txvq->stats, 0, sizeof(txvq->stats));
 	}
 
 	for (i = 0; i < dev->data->nb_rx_queues; i++) {
@@ -942,13 +1390,7 @@ virtio_dev_stats_reset(struct rte_eth_dev *dev)
 		if (rxvq == NULL)
 			continue;
 
-		rxvq->stats.packets = 0;
-		rxvq->stats.bytes = 0;
-		rxvq->stats.errors = 0;
-		rxvq->stats.multicast = 0;
-		rxvq->stats.broadcast = 0;
-		memset(rxvq->stats.size_bins, 0,
-		       sizeof(rxvq->stats.size_bins[0]) * 8);
+		memset(&rxvq->stats, 0, sizeof(rxvq->stats));
 	}
 }
 
@@ -1104,7 +1546,7 @@ virtio_vlan_filter_set(struct rte_eth_dev *dev, uint16_t vlan_id, int on)
 	memcpy(ctrl.data, &vlan_id, sizeof(vlan_id));
 	len = sizeof(vlan_id);
 
-	return virtio_send_command(hw->cvq, &ctrl, &len, 1);
+	return virtio_send_command_async(hw->cvq, &ctrl, &len, 1);
 }
 
 static int
@@ -1328,15 +1770,46 @@ set_rxtx_funcs(struct rte_eth_dev *eth_dev)
 {
 	struct virtio_hw *hw = eth_dev->data->dev_private;
 
-	if (hw->use_simple_rx) {
-		PMD_INIT_LOG(INFO, "virtio: using simple Rx path on port %u",
-			eth_dev->data->port_id);
-		eth_dev->rx_pkt_burst = virtio_recv_pkts_vec;
+	if (vtpci_packed_queue(hw)) {
+		if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF)) {
+			PMD_INIT_LOG(INFO,
+				"virtio: using packed ring mergeable buffer Rx path on port %u",
+				eth_dev->data->port_id);
+			eth_dev->rx_pkt_burst =
+				&virtio_recv_mergeable_pkts_packed;
+		} else {
+			PMD_INIT_LOG(INFO,
+				"virtio: using packed ring standard Rx path on port %u",
+				eth_dev->data->port_id);
+			eth_dev->rx_pkt_burst = &virtio_recv_pkts_packed;
+		}
+	} else if (hw->use_simple_rx) {
+#ifdef CC_AVX2_SUPPORT
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2)) {
+			PMD_INIT_LOG(INFO,
+				"virtio: using AVX2 simple Rx path on port %u",
+				eth_dev->data->port_id);
+			eth_dev->rx_pkt_burst = virtio_recv_pkts_vec_avx2;
+		} else
+#endif
+		{
+			PMD_INIT_LOG(INFO,
+				"virtio: using simple Rx path on port %u",
+				eth_dev->data->port_id);
+			eth_dev->rx_pkt_burst = virtio_recv_pkts_vec;
+		}
 	} else if (hw->use_inorder_rx) {
+#ifdef RTE_ARCH_X86
+		PMD_INIT_LOG(INFO,
+			"virtio: using vectorized inorder mergeable buffer Rx path on port %u",
+			eth_dev->data->port_id);
+		eth_dev->rx_pkt_burst = &virtio_recv_mergeable_pkts_inorder_vec;
+#else
 		PMD_INIT_LOG(INFO,
 			"virtio: using inorder mergeable buffer Rx path on port %u",
 			eth_dev->data->port_id);
 		eth_dev->rx_pkt_burst = &virtio_recv_mergeable_pkts_inorder;
+#endif
 	} else if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF)) {
 		PMD_INIT_LOG(INFO,
 			"virtio: using mergeable buffer Rx path on port %u",
@@ -1348,15 +1821,42 @@ set_rxtx_funcs(struct rte_eth_dev *eth_dev)
 		eth_dev->rx_pkt_burst = &virtio_recv_pkts;
 	}
 
-	if (hw->use_inorder_tx) {
-		PMD_INIT_LOG(INFO, "virtio: using inorder Tx path on port %u",
+	if (vtpci_packed_queue(hw)) {
+		PMD_INIT_LOG(INFO, "virtio: using packed ring %sTx path on port %u",
+			hw->use_inorder_tx ? "inorder " : "",
 			eth_dev->data->port_id);
-		eth_dev->tx_pkt_burst = virtio_xmit_pkts_inorder;
+		eth_dev->tx_pkt_burst = virtio_xmit_pkts_packed;
+	} else if (hw->use_inorder_tx) {
+#ifdef CC_AVX2_SUPPORT
+		if (!hw->has_tx_offload &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2)) {
+			PMD_INIT_LOG(INFO,
+				"virtio: using AVX2 inorder Tx path on port %u",
+				eth_dev->data->port_id);
+			eth_dev->tx_pkt_burst = virtio_xmit_pkts_inorder_avx2;
+		} else
+#endif
+		{
+			PMD_INIT_LOG(INFO,
+				"virtio: using inorder Tx path on port %u",
+				eth_dev->data->port_id);
+			eth_dev->tx_pkt_burst = virtio_xmit_pkts_inorder;
+		}
 	} else {
 		PMD_INIT_LOG(INFO, "virtio: using standard Tx path on port %u",
 			eth_dev->data->port_id);
 		eth_dev->tx_pkt_burst = virtio_xmit_pkts;
 	}
+
+	/* In standby mode, go over the primary device when it is present */
+	if (vtpci_with_feature(hw, VIRTIO_NET_F_STANDBY)) {
+		virtio_hw_internal[hw->port_id].rx_pkt_burst =
+			eth_dev->rx_pkt_burst;
+		virtio_hw_internal[hw->port_id].tx_pkt_burst =
+			eth_dev->tx_pkt_burst;
+		eth_dev->rx_pkt_burst = virtio_standby_recv_pkts;
+		eth_dev->tx_pkt_burst = virtio_standby_xmit_pkts;
+	}
 }
 
 /* Only support 1:1 queue/interrupt mapping so far.
@@ -1487,12 +1987,16 @@ virtio_init_device(struct rte_eth_dev *eth_dev, uint64_t req_features)
 		eth_dev->data->dev_flags &= ~RTE_ETH_DEV_INTR_LSC;
 
 	/* Setting up rx_header size for the device */
-	if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF) ||
+	if (vtpci_with_feature(hw, VIRTIO_NET_F_HASH_REPORT))
+		hw->vtnet_hdr_size = sizeof(struct virtio_net_hdr_hash_report);
+	else if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF) ||
 	    vtpci_with_feature(hw, VIRTIO_F_VERSION_1))
 		hw->vtnet_hdr_size = sizeof(struct virtio_net_hdr_mrg_rxbuf);
 	else
 		hw->vtnet_hdr_size = sizeof(struct virtio_net_hdr);
 
+	virtio_get_rss_caps(hw);
+
 	/* Copy the permanent MAC address to: virtio_hw */
 	virtio_get_hwaddr(hw);
 	ether_addr_copy((struct ether_addr *) hw->mac_addr,
@@ -1640,6 +2144,73 @@ virtio_set_vtpci_ops(struct virtio_hw *hw)
 		VTPCI_OPS(hw) = &legacy_ops;
 }
 
+static int
+virtio_dev_uint_arg(const char *key __rte_unused, const char *value,
+		void *extra_args)
+{
+	char *end;
+
+	errno = 0;
+	*(uint64_t *)extra_args = strtoull(value, &end, 0);
+	if (errno != 0 || *value == '\0' || *end != '\0')
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Devargs common to virtio PCI and virtio-user, the others are ignored:
+ * tx_kick_batch=<n> defers the Tx kick of the bursts until n packets are
+ * pending, tx_kick_delay=<us> bounds the deferral, 0 for no deadline.
+ */
+static int
+virtio_dev_devargs_parse(struct rte_devargs *devargs, struct virtio_hw *hw)
+{
+	struct rte_kvargs *kvlist;
+	uint64_t batch = 0;
+	uint64_t delay = VIRTIO_TX_KICK_DELAY_DEF;
+	int ret = 0;
+
+	hw->tx_kick_batch = 0;
+	hw->tx_kick_delay = 0;
+
+	if (devargs == NULL)
+		return 0;
+
+	kvlist = rte_kvargs_parse(devargs->args, NULL);
+	if (kvlist == NULL)
+		return 0;
+
+	if (rte_kvargs_process(kvlist, VIRTIO_ARG_TX_KICK_BATCH,
+				virtio_dev_uint_arg, &batch) < 0 ||
+			batch > UINT16_MAX) {
+		PMD_INIT_LOG(ERR, "invalid %s", VIRTIO_ARG_TX_KICK_BATCH);
+		ret = -EINVAL;
+		goto exit;
+	}
+
+	if (rte_kvargs_process(kvlist, VIRTIO_ARG_TX_KICK_DELAY,
+				virtio_dev_uint_arg, &delay) < 0 ||
+			delay > UINT32_MAX) {
+		PMD_INIT_LOG(ERR, "invalid %s", VIRTIO_ARG_TX_KICK_DELAY);
+		ret = -EINVAL;
+		goto exit;
+	}
+
+	/* a batch of one packet is a kick per burst, as without deferral */
+	if (batch > 1) {
+		hw->tx_kick_batch = batch;
+		hw->tx_kick_delay = delay * rte_get_tsc_hz() / 1000000;
+		PMD_INIT_LOG(INFO,
+			"deferred Tx kick after %"PRIu64" packets or %"PRIu64" us",
+			batch, delay);
+	}
+
+exit:
+	rte_kvargs_free(kvlist);
+	return ret;
+}
+
 /*
  * This function is based on probe() function in virtio_pci.c
  * It returns 0 on success.
@@ -1650,7 +2221,8 @@ eth_virtio_dev_init(struct rte_eth_dev *eth_dev)
 	struct virtio_hw *hw = eth_dev->data->dev_private;
 	int ret;
 
-	RTE_BUILD_BUG_ON(RTE_PKTMBUF_HEADROOM < sizeof(struct virtio_net_hdr_mrg_rxbuf));
+	RTE_BUILD_BUG_ON(RTE_PKTMBUF_HEADROOM <
+		sizeof(struct virtio_net_hdr_hash_report));
 
 	eth_dev->dev_ops = &virtio_eth_dev_ops;
 
@@ -1677,6 +2249,11 @@ eth_virtio_dev_init(struct rte_eth_dev *eth_dev)
 	}
 
 	hw->port_id = eth_dev->data->port_id;
+
+	ret = virtio_dev_devargs_parse(eth_dev->device->devargs, hw);
+	if (ret < 0)
+		goto out;
+
 	/* For virtio_user case the hw->virtio_user_dev is populated by
 	 * virtio_user_eth_dev_alloc() before eth_virtio_dev_init() is called.
 	 */
@@ -1691,6 +2268,14 @@ eth_virtio_dev_init(struct rte_eth_dev *eth_dev)
 	if (ret < 0)
 		goto out;
 
+	/* pair the primary device the host provides along with this one */
+	if (!hw->virtio_user_dev &&
+	    vtpci_with_feature(hw, VIRTIO_NET_F_STANDBY)) {
+		ret = virtio_standby_init(eth_dev);
+		if (ret < 0)
+			goto out;
+	}
+
 	return 0;
 
 out:
@@ -1708,6 +2293,7 @@ eth_virtio_dev_uninit(struct rte_eth_dev *eth_dev)
 
 	virtio_dev_stop(eth_dev);
 	virtio_dev_close(eth_dev);
+	virtio_standby_uninit(eth_dev);
 
 	eth_dev->dev_ops = NULL;
 	eth_dev->tx_pkt_burst = NULL;
@@ -1854,6 +2440,12 @@ virtio_dev_configure(struct rte_eth_dev *dev)
 			(1ULL << VIRTIO_NET_F_HOST_TSO4) |
 			(1ULL << VIRTIO_NET_F_HOST_TSO6);
 
+	/* the hash report makes the Rx header longer, only ask for it here */
+	if (rxmode->mq_mode & ETH_MQ_RX_RSS_FLAG)
+		req_features |=
+			(1ULL << VIRTIO_NET_F_RSS) |
+			(1ULL << VIRTIO_NET_F_HASH_REPORT);
+
 	/* if request features changed, reinit the device */
 	if (req_features != hw->req_guest_features) {
 		ret = virtio_init_device(dev, req_features);
@@ -1877,6 +2469,17 @@ virtio_dev_configure(struct rte_eth_dev *dev)
 		return -ENOTSUP;
 	}
 
+	/*
+	 * Without mergeable buffers, each Rx buffer must hold a whole 64KB
+	 * receive, more than the room of an mbuf.
+	 */
+	if ((rx_offloads & DEV_RX_OFFLOAD_TCP_LRO) &&
+		!vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF)) {
+		PMD_DRV_LOG(ERR,
+			"Large Receive Offload needs mergeable Rx buffers");
+		return -ENOTSUP;
+	}
+
 	/* start control queue */
 	if (vtpci_with_feature(hw, VIRTIO_NET_F_CTRL_VQ))
 		virtio_dev_cq_start(dev);
@@ -1893,6 +2496,13 @@ virtio_dev_configure(struct rte_eth_dev *dev)
 
 	hw->has_tx_offload = tx_offload_enabled(hw);
 	hw->has_rx_offload = rx_offload_enabled(hw);
+	hw->has_rx_hash = vtpci_with_feature(hw, VIRTIO_NET_F_HASH_REPORT);
+
+	if (vtpci_with_feature(hw, VIRTIO_NET_F_RSS) || hw->has_rx_hash) {
+		ret = virtio_dev_rss_init(dev);
+		if (ret < 0)
+			return ret;
+	}
 
 	if (dev->data->dev_flags & RTE_ETH_DEV_INTR_LSC)
 		/* Enable vector (0) for Link State Intrerrupt */
@@ -1931,9 +2541,22 @@ virtio_dev_configure(struct rte_eth_dev *dev)
 			   DEV_RX_OFFLOAD_VLAN_STRIP))
 		hw->use_simple_rx = 0;
 
+	/* the vector Rx paths do not report the hash */
+	if (hw->has_rx_hash)
+		hw->use_simple_rx = 0;
+
+	/*
+	 * There is no vector path for packed rings, and in order they still
+	 * get one used descriptor per Rx buffer: the packed Rx paths do.
+	 */
+	if (vtpci_packed_queue(hw)) {
+		hw->use_simple_rx = 0;
+		hw->use_inorder_rx = 0;
+	}
+
 	hw->opened = true;
 
-	return 0;
+	return virtio_standby_configure(dev);
 }
 
 
@@ -1991,11 +2614,17 @@ virtio_dev_start(struct rte_eth_dev *dev)
 	 *vhost backend will have no chance to be waked up
 	 */
 	nb_queues = RTE_MAX(dev->data->nb_rx_queues, dev->data->nb_tx_queues);
-	if (hw->max_queue_pairs > 1) {
+	if (hw->max_queue_pairs > 1 &&
+	    !vtpci_with_feature(hw, VIRTIO_NET_F_RSS)) {
 		if (virtio_set_multiple_queues(dev, nb_queues) != 0)
 			return -EINVAL;
 	}
 
+	/* With RSS, the number of queue pairs comes with its configuration */
+	if ((vtpci_with_feature(hw, VIRTIO_NET_F_RSS) || hw->has_rx_hash) &&
+	    virtio_set_rss(dev) != 0)
+		return -EINVAL;
+
 	PMD_INIT_LOG(DEBUG, "nb_queues=%d", nb_queues);
 
 	for (i = 0; i < dev->data->nb_rx_queues; i++) {
@@ -2028,7 +2657,7 @@ virtio_dev_start(struct rte_eth_dev *dev)
 	/* Initialize Link state */
 	virtio_dev_link_update(dev, 0);
 
-	return 0;
+	return virtio_standby_start(dev);
 }
 
 static void virtio_dev_free_mbufs(struct rte_eth_dev *dev)
@@ -2088,6 +2717,8 @@ virtio_dev_stop(struct rte_eth_dev *dev)
 
 	PMD_INIT_LOG(DEBUG, "stop");
 
+	virtio_standby_stop(dev);
+
 	rte_spinlock_lock(&hw->state_lock);
 	if (!hw->started)
 		goto out_unlock;
@@ -2195,7 +2826,8 @@ virtio_dev_info_get(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
 	if (host_features & (1ULL << VIRTIO_NET_F_CTRL_VLAN))
 		dev_info->rx_offload_capa |= DEV_RX_OFFLOAD_VLAN_FILTER;
 	tso_mask = (1ULL << VIRTIO_NET_F_GUEST_TSO4) |
-		(1ULL << VIRTIO_NET_F_GUEST_TSO6);
+		(1ULL << VIRTIO_NET_F_GUEST_TSO6) |
+		(1ULL << VIRTIO_NET_F_MRG_RXBUF);
 	if ((host_features & tso_mask) == tso_mask)
 		dev_info->rx_offload_capa |= DEV_RX_OFFLOAD_TCP_LRO;
 
@@ -2210,6 +2842,133 @@ virtio_dev_info_get(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
 		(1ULL << VIRTIO_NET_F_HOST_TSO6);
 	if ((host_features & tso_mask) == tso_mask)
 		dev_info->tx_offload_capa |= DEV_TX_OFFLOAD_TCP_TSO;
+
+	if (hw->rss_hash_types) {
+		dev_info->flow_type_rss_offloads =
+			virtio_hash_types_to_rss_hf(hw->rss_hash_types);
+		dev_info->hash_key_size = VIRTIO_NET_RSS_KEY_SIZE;
+	}
+	dev_info->reta_size = hw->rss_reta_size;
+
+	virtio_standby_info_get(dev, dev_info);
+}
+
+static int
+virtio_dev_rss_hash_update(struct rte_eth_dev *dev,
+			   struct rte_eth_rss_conf *rss_conf)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	uint8_t old_key[VIRTIO_NET_RSS_KEY_SIZE];
+	uint32_t old_hf_types = hw->rss_hf_types;
+
+	if (!vtpci_with_feature(hw, VIRTIO_NET_F_RSS) && !hw->has_rx_hash)
+		return -ENOTSUP;
+
+	if (rss_conf->rss_hf & ~virtio_hash_types_to_rss_hf(hw->rss_hash_types))
+		return -EINVAL;
+
+	if (rss_conf->rss_key != NULL &&
+	    rss_conf->rss_key_len != VIRTIO_NET_RSS_KEY_SIZE)
+		return -EINVAL;
+
+	memcpy(old_key, hw->rss_key, VIRTIO_NET_RSS_KEY_SIZE);
+	if (rss_conf->rss_key != NULL)
+		memcpy(hw->rss_key, rss_conf->rss_key,
+			VIRTIO_NET_RSS_KEY_SIZE);
+	hw->rss_hf_types = virtio_rss_hf_to_hash_types(rss_conf->rss_hf);
+
+	/* otherwise it is sent at start */
+	if (hw->started && virtio_set_rss(dev) != 0) {
+		memcpy(hw->rss_key, old_key, VIRTIO_NET_RSS_KEY_SIZE);
+		hw->rss_hf_types = old_hf_types;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+virtio_dev_rss_hash_conf_get(struct rte_eth_dev *dev,
+			     struct rte_eth_rss_conf *rss_conf)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+
+	if (!vtpci_with_feature(hw, VIRTIO_NET_F_RSS) && !hw->has_rx_hash)
+		return -ENOTSUP;
+
+	if (rss_conf->rss_key != NULL)
+		memcpy(rss_conf->rss_key, hw->rss_key,
+			VIRTIO_NET_RSS_KEY_SIZE);
+	rss_conf->rss_key_len = VIRTIO_NET_RSS_KEY_SIZE;
+	rss_conf->rss_hf = virtio_hash_types_to_rss_hf(hw->rss_hf_types);
+
+	return 0;
+}
+
+static int
+virtio_dev_rss_reta_update(struct rte_eth_dev *dev,
+			   struct rte_eth_rss_reta_entry64 *reta_conf,
+			   uint16_t reta_size)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	uint16_t old_reta[VIRTIO_NET_RSS_RETA_SIZE];
+	uint16_t i, idx, shift;
+
+	if (!vtpci_with_feature(hw, VIRTIO_NET_F_RSS))
+		return -ENOTSUP;
+
+	if (reta_size != hw->rss_reta_size) {
+		PMD_DRV_LOG(ERR, "RETA size must be %u", hw->rss_reta_size);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < reta_size; i++) {
+		idx = i / RTE_RETA_GROUP_SIZE;
+		shift = i % RTE_RETA_GROUP_SIZE;
+		if ((reta_conf[idx].mask & (1ULL << shift)) &&
+		    reta_conf[idx].reta[shift] >= dev->data->nb_rx_queues)
+			return -EINVAL;
+	}
+
+	memcpy(old_reta, hw->rss_reta, sizeof(old_reta));
+	for (i = 0; i < reta_size; i++) {
+		idx = i / RTE_RETA_GROUP_SIZE;
+		shift = i % RTE_RETA_GROUP_SIZE;
+		if (reta_conf[idx].mask & (1ULL << shift))
+			hw->rss_reta[i] = reta_conf[idx].reta[shift];
+	}
+
+	/* otherwise it is sent at start */
+	if (hw->started && virtio_set_rss(dev) != 0) {
+		memcpy(hw->rss_reta, old_reta, sizeof(old_reta));
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+virtio_dev_rss_reta_query(struct rte_eth_dev *dev,
+			  struct rte_eth_rss_reta_entry64 *reta_conf,
+			  uint16_t reta_size)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	uint16_t i, idx, shift;
+
+	if (!vtpci_with_feature(hw, VIRTIO_NET_F_RSS))
+		return -ENOTSUP;
+
+	if (reta_size != hw->rss_reta_size)
+		return -EINVAL;
+
+	for (i = 0; i < reta_size; i++) {
+		idx = i / RTE_RETA_GROUP_SIZE;
+		shift = i % RTE_RETA_GROUP_SIZE;
+		if (reta_conf[idx].mask & (1ULL << shift))
+			reta_conf[idx].reta[shift] = hw->rss_reta[i];
+	}
+
+	return 0;
 }
 
 /*
@@ -2226,6 +2985,9 @@ __rte_unused uint8_t is_rx)
 RTE_PMD_EXPORT_NAME(net_virtio, __COUNTER__);
 RTE_PMD_REGISTER_PCI_TABLE(net_virtio, pci_id_virtio_map);
 RTE_PMD_REGISTER_KMOD_DEP(net_virtio, "* igb_uio | uio_pci_generic | vfio-pci");
+RTE_PMD_REGISTER_PARAM_STRING(net_virtio,
+	VIRTIO_ARG_TX_KICK_BATCH "=<int> "
+	VIRTIO_ARG_TX_KICK_DELAY "=<int>");
 
 RTE_INIT(virtio_init_log)
 {
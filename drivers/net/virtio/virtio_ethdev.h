@@ -19,6 +19,13 @@
 #define VIRTIO_MIN_RX_BUFSIZE 64
 #define VIRTIO_MAX_RX_PKTLEN  9728U
 
+/* Devargs of the virtio PCI and virtio-user ports */
+#define VIRTIO_ARG_TX_KICK_BATCH	"tx_kick_batch"
+#define VIRTIO_ARG_TX_KICK_DELAY	"tx_kick_delay"
+
+/* Deadline of a deferred Tx kick by default, in us */
+#define VIRTIO_TX_KICK_DELAY_DEF	10
+
 /* Features desired/implemented by this driver. */
 #define VIRTIO_PMD_DEFAULT_GUEST_FEATURES	\
 	(1u << VIRTIO_NET_F_MAC		  |	\
@@ -32,9 +39,12 @@
 	 1u << VIRTIO_NET_F_MTU	| \
 	 1ULL << VIRTIO_NET_F_GUEST_ANNOUNCE |	\
 	 1u << VIRTIO_RING_F_INDIRECT_DESC |    \
+	 1u << VIRTIO_RING_F_EVENT_IDX     |	\
 	 1ULL << VIRTIO_F_VERSION_1       |	\
 	 1ULL << VIRTIO_F_IN_ORDER        |	\
-	 1ULL << VIRTIO_F_IOMMU_PLATFORM)
+	 1ULL << VIRTIO_F_RING_PACKED     |	\
+	 1ULL << VIRTIO_F_IOMMU_PLATFORM  |	\
+	 1ULL << VIRTIO_NET_F_STANDBY)
 
 #define VIRTIO_PMD_SUPPORTED_GUEST_FEATURES	\
 	(VIRTIO_PMD_DEFAULT_GUEST_FEATURES |	\
@@ -79,6 +89,14 @@ uint16_t virtio_recv_mergeable_pkts(void *rx_queue, struct rte_mbuf **rx_pkts,
 
 uint16_t virtio_recv_mergeable_pkts_inorder(void *rx_queue,
 		struct rte_mbuf **rx_pkts, uint16_t nb_pkts);
+uint16_t virtio_recv_mergeable_pkts_inorder_vec(void *rx_queue,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts);
+
+uint16_t virtio_recv_pkts_packed(void *rx_queue, struct rte_mbuf **rx_pkts,
+		uint16_t nb_pkts);
+
+uint16_t virtio_recv_mergeable_pkts_packed(void *rx_queue,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts);
 
 uint16_t virtio_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts,
 		uint16_t nb_pkts);
@@ -86,9 +104,18 @@ uint16_t virtio_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts,
 uint16_t virtio_xmit_pkts_inorder(void *tx_queue, struct rte_mbuf **tx_pkts,
 		uint16_t nb_pkts);
 
+uint16_t virtio_xmit_pkts_packed(void *tx_queue, struct rte_mbuf **tx_pkts,
+		uint16_t nb_pkts);
+
 uint16_t virtio_recv_pkts_vec(void *rx_queue, struct rte_mbuf **rx_pkts,
 		uint16_t nb_pkts);
 
+uint16_t virtio_recv_pkts_vec_avx2(void *rx_queue, struct rte_mbuf **rx_pkts,
+		uint16_t nb_pkts);
+
+uint16_t virtio_xmit_pkts_inorder_avx2(void *tx_queue,
+		struct rte_mbuf **tx_pkts, uint16_t nb_pkts);
+
 uint16_t virtio_xmit_pkts_simple(void *tx_queue, struct rte_mbuf **tx_pkts,
 		uint16_t nb_pkts);
 
@@ -101,4 +128,30 @@ void virtio_dev_resume(struct rte_eth_dev *dev);
 int virtio_inject_pkts(struct rte_eth_dev *dev, struct rte_mbuf **tx_pkts,
 		int nb_pkts);
 
+/*
+ * Standby mode: datapath over the primary device paired by MAC address
+ */
+int virtio_standby_init(struct rte_eth_dev *dev);
+void virtio_standby_uninit(struct rte_eth_dev *dev);
+void virtio_standby_info_get(struct rte_eth_dev *dev,
+		struct rte_eth_dev_info *info);
+int virtio_standby_configure(struct rte_eth_dev *dev);
+int virtio_standby_rx_queue_setup(struct rte_eth_dev *dev, uint16_t queue_idx,
+		unsigned int socket_id, const struct rte_eth_rxconf *rx_conf,
+		struct rte_mempool *mp);
+int virtio_standby_tx_queue_setup(struct rte_eth_dev *dev, uint16_t queue_idx,
+		unsigned int socket_id, const struct rte_eth_txconf *tx_conf);
+int virtio_standby_start(struct rte_eth_dev *dev);
+void virtio_standby_stop(struct rte_eth_dev *dev);
+void virtio_standby_close(struct rte_eth_dev *dev);
+void virtio_standby_promiscuous_enable(struct rte_eth_dev *dev);
+void virtio_standby_promiscuous_disable(struct rte_eth_dev *dev);
+void virtio_standby_allmulticast_enable(struct rte_eth_dev *dev);
+void virtio_standby_allmulticast_disable(struct rte_eth_dev *dev);
+
+uint16_t virtio_standby_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts,
+		uint16_t nb_pkts);
+uint16_t virtio_standby_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts,
+		uint16_t nb_pkts);
+
 #endif /* _VIRTIO_ETHDEV_H_ */
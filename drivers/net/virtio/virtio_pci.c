@@ -370,10 +370,21 @@ modern_setup_queue(struct virtio_hw *hw, struct virtqueue *vq)
 		return -1;
 
 	desc_addr = vq->vq_ring_mem;
-	avail_addr = desc_addr + vq->vq_nentries * sizeof(struct vring_desc);
-	used_addr = RTE_ALIGN_CEIL(avail_addr + offsetof(struct vring_avail,
-							 ring[vq->vq_nentries]),
-				   VIRTIO_PCI_VRING_ALIGN);
+	if (vtpci_packed_queue(hw)) {
+		/* the driver and device event suppression areas */
+		avail_addr = desc_addr +
+			vq->vq_nentries * sizeof(struct vring_packed_desc);
+		used_addr = RTE_ALIGN_CEIL(avail_addr +
+				sizeof(struct vring_packed_desc_event),
+				VIRTIO_PCI_VRING_ALIGN);
+	} else {
+		avail_addr = desc_addr +
+			vq->vq_nentries * sizeof(struct vring_desc);
+		used_addr = RTE_ALIGN_CEIL(avail_addr +
+				offsetof(struct vring_avail,
+					 ring[vq->vq_nentries]),
+				VIRTIO_PCI_VRING_ALIGN);
+	}
 
 	rte_write16(vq->vq_queue_index, &hw->common_cfg->queue_select);
 
@@ -113,6 +113,7 @@ struct virtnet_ctl;
 
 #define VIRTIO_F_VERSION_1		32
 #define VIRTIO_F_IOMMU_PLATFORM	33
+#define VIRTIO_F_RING_PACKED	34
 
 /*
  * Some VirtIO feature bits (currently bits 28 through 31) are
@@ -128,6 +129,10 @@ struct virtnet_ctl;
  */
 #define VIRTIO_F_IN_ORDER 35
 
+#define VIRTIO_NET_F_HASH_REPORT 57	/* Device reports the Rx hash */
+#define VIRTIO_NET_F_RSS	60	/* Device supports RSS steering */
+#define VIRTIO_NET_F_STANDBY	62	/* Standby of a primary device */
+
 /* The Guest publishes the used index for which it expects an interrupt
  * at the end of the avail ring. Host should ignore the avail->flags field. */
 /* The Host publishes the avail index for which it expects a kick
@@ -143,6 +148,13 @@ struct virtnet_ctl;
 #define VIRTIO_MAX_VIRTQUEUE_PAIRS 8
 #define VIRTIO_MAX_VIRTQUEUES (VIRTIO_MAX_VIRTQUEUE_PAIRS * 2 + 1)
 
+/*
+ * RSS key and indirection table sizes kept by the driver, the device
+ * limits are at least those of the key and at most those of the table.
+ */
+#define VIRTIO_NET_RSS_KEY_SIZE		40
+#define VIRTIO_NET_RSS_RETA_SIZE	128
+
 /* Common configuration */
 #define VIRTIO_PCI_CAP_COMMON_CFG	1
 /* Notifications */
@@ -242,6 +254,14 @@ struct virtio_hw {
 	uint8_t     use_inorder_tx;
 	bool        has_tx_offload;
 	bool        has_rx_offload;
+	uint16_t    tx_kick_batch; /**< deferred Tx kick threshold, 0 if off */
+	uint64_t    tx_kick_delay; /**< deferred Tx kick deadline, in cycles */
+	bool        has_rx_hash;   /**< Rx header carries the packet hash */
+	uint16_t    rss_reta_size;
+	uint32_t    rss_hash_types; /**< VIRTIO_NET_HASH_TYPE_* of the device */
+	uint32_t    rss_hf_types;   /**< VIRTIO_NET_HASH_TYPE_* configured */
+	uint8_t     rss_key[VIRTIO_NET_RSS_KEY_SIZE];
+	uint16_t    rss_reta[VIRTIO_NET_RSS_RETA_SIZE];
 	uint16_t    port_id;
 	uint8_t     mac_addr[ETHER_ADDR_LEN];
 	uint32_t    notify_off_multiplier;
@@ -259,6 +279,12 @@ struct virtio_hw {
 	struct rte_mbuf **inject_pkts;
 	bool        opened;
 
+	/* Primary device paired by VIRTIO_NET_F_STANDBY, NULL if none */
+	struct rte_eth_dev *vf_dev;
+	rte_spinlock_t vf_lock;
+	struct rte_eth_dev_owner owner;
+	uint16_t    vf_removed_port; /**< primary device being detached */
+
 	struct virtqueue **vqs;
 };
 
@@ -271,6 +297,8 @@ struct virtio_hw {
 struct virtio_hw_internal {
 	const struct virtio_pci_ops *vtpci_ops;
 	struct rte_pci_ioport io;
+	eth_rx_burst_t rx_pkt_burst; /**< virtio Rx path behind the standby */
+	eth_tx_burst_t tx_pkt_burst; /**< virtio Tx path behind the standby */
 };
 
 #define VTPCI_OPS(hw)	(virtio_hw_internal[(hw)->port_id].vtpci_ops)
@@ -291,8 +319,26 @@ struct virtio_net_config {
 	uint16_t   status;
 	uint16_t   max_virtqueue_pairs;
 	uint16_t   mtu;
+	uint32_t   speed;
+	uint8_t    duplex;
+	/* See VIRTIO_NET_F_RSS and VIRTIO_NET_F_HASH_REPORT */
+	uint8_t    rss_max_key_size;
+	uint16_t   rss_max_indirection_table_length;
+	uint32_t   supported_hash_types;
 } __attribute__((packed));
 
+/* Hash types of the RSS and hash report configuration */
+#define VIRTIO_NET_HASH_TYPE_IPV4	(1 << 0)
+#define VIRTIO_NET_HASH_TYPE_TCPV4	(1 << 1)
+#define VIRTIO_NET_HASH_TYPE_UDPV4	(1 << 2)
+#define VIRTIO_NET_HASH_TYPE_IPV6	(1 << 3)
+#define VIRTIO_NET_HASH_TYPE_TCPV6	(1 << 4)
+#define VIRTIO_NET_HASH_TYPE_UDPV6	(1 << 5)
+#define VIRTIO_NET_HASH_TYPE_IP_EX	(1 << 6)
+#define VIRTIO_NET_HASH_TYPE_TCP_EX	(1 << 7)
+#define VIRTIO_NET_HASH_TYPE_UDP_EX	(1 << 8)
+#define VIRTIO_NET_HASH_TYPE_MASK	((1 << 9) - 1)
+
 /*
  * How many bits to shift physical queue address written to QUEUE_PFN.
  * 12 is historical, and due to x86 page size.
@@ -314,6 +360,12 @@ vtpci_with_feature(struct virtio_hw *hw, uint64_t bit)
 	return (hw->guest_features & (1ULL << bit)) != 0;
 }
 
+static inline int
+vtpci_packed_queue(struct virtio_hw *hw)
+{
+	return vtpci_with_feature(hw, VIRTIO_F_RING_PACKED);
+}
+
 /*
  * Function declaration from virtio_pci.c
  */
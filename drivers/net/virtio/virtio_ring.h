@@ -16,6 +16,11 @@
 /* This means the buffer contains a list of buffer descriptors. */
 #define VRING_DESC_F_INDIRECT   4
 
+/* Packed ring: the descriptor was made available by the driver, or used by
+ * the device, when the bit matches the wrap counter of its side. */
+#define VRING_DESC_F_AVAIL(b)   ((uint16_t)(b) << 7)
+#define VRING_DESC_F_USED(b)    ((uint16_t)(b) << 15)
+
 /* The Host uses this in used->flags to advise the Guest: don't kick me
  * when you add a buffer.  It's unreliable, so it's simply an
  * optimization.  Guest will still kick if it's out of buffers. */
@@ -25,6 +30,13 @@
  * simply an optimization.  */
 #define VRING_AVAIL_F_NO_INTERRUPT  1
 
+/* Packed ring event suppression flags, in the driver and device areas. */
+#define RING_EVENT_FLAGS_ENABLE  0x0
+#define RING_EVENT_FLAGS_DISABLE 0x1
+#define RING_EVENT_FLAGS_DESC    0x2
+/* Bit of the wrap counter in desc_event_off_wrap, with the event index */
+#define RING_EVENT_WRAP_COUNTER_SHIFT 15
+
 /* VirtIO ring descriptors: 16 bytes.
  * These can chain together via "next". */
 struct vring_desc {
@@ -61,6 +73,26 @@ struct vring {
 	struct vring_used  *used;
 };
 
+/* VirtIO packed ring descriptors: 16 bytes, used in place by the device. */
+struct vring_packed_desc {
+	uint64_t addr;
+	uint32_t len;
+	uint16_t id;
+	uint16_t flags;
+};
+
+struct vring_packed_desc_event {
+	uint16_t desc_event_off_wrap;
+	uint16_t desc_event_flags;
+};
+
+struct vring_packed {
+	unsigned int num;
+	struct vring_packed_desc *desc_packed;
+	struct vring_packed_desc_event *driver_event;
+	struct vring_packed_desc_event *device_event;
+};
+
 /* The standard layout for the ring is a continuous chunk of memory which
  * looks like this.  We assume num is a power of 2.
  *
@@ -92,7 +124,9 @@ struct vring {
  * versa. They are at the end for backwards compatibility.
  */
 #define vring_used_event(vr)  ((vr)->avail->ring[(vr)->num])
-#define vring_avail_event(vr) (*(uint16_t *)&(vr)->used->ring[(vr)->num])
+#define vring_avail_event(vr) \
+	(*(volatile uint16_t *)((uintptr_t)(vr)->used->ring + \
+		(vr)->num * sizeof(struct vring_used_elem)))
 
 static inline size_t
 vring_size(unsigned int num, unsigned long align)
@@ -119,6 +153,34 @@ vring_init(struct vring *vr, unsigned int num, uint8_t *p,
 		RTE_ALIGN_CEIL((uintptr_t)(&vr->avail->ring[num]), align);
 }
 
+/*
+ * The packed ring is the descriptors followed by the driver event
+ * suppression area, then the device one on the next align boundary.
+ */
+static inline size_t
+vring_size_packed(unsigned int num, unsigned long align)
+{
+	size_t size;
+
+	size = num * sizeof(struct vring_packed_desc);
+	size += sizeof(struct vring_packed_desc_event);
+	size = RTE_ALIGN_CEIL(size, align);
+	size += sizeof(struct vring_packed_desc_event);
+	return size;
+}
+
+static inline void
+vring_init_packed(struct vring_packed *vr, unsigned int num, uint8_t *p,
+	unsigned long align)
+{
+	vr->num = num;
+	vr->desc_packed = (struct vring_packed_desc *)p;
+	vr->driver_event = (struct vring_packed_desc_event *)(p +
+		num * sizeof(struct vring_packed_desc));
+	vr->device_event = (struct vring_packed_desc_event *)
+		RTE_ALIGN_CEIL((uintptr_t)(vr->driver_event + 1), align);
+}
+
 /*
  * The following is used with VIRTIO_RING_F_EVENT_IDX.
  * Assuming a given event_idx value from the other size, if we have
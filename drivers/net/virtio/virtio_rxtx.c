@@ -44,6 +44,31 @@ virtio_dev_rx_queue_done(void *rxq, uint16_t offset)
 	struct virtnet_rx *rxvq = rxq;
 	struct virtqueue *vq = rxvq->vq;
 
+	if (vtpci_packed_queue(vq->hw)) {
+		struct vring_packed_desc *desc;
+		uint16_t idx, used, avail;
+		bool wrap_counter;
+
+		/* Rx buffers are a single descriptor each */
+		if (offset == 0)
+			return 1;
+		if (offset > vq->vq_nentries)
+			return 0;
+
+		idx = vq->vq_used_cons_idx + offset - 1;
+		wrap_counter = vq->vq_used_wrap_counter;
+		if (idx >= vq->vq_nentries) {
+			idx -= vq->vq_nentries;
+			wrap_counter ^= 1;
+		}
+
+		desc = &vq->vq_ring_packed.desc_packed[idx];
+		used = !!(desc->flags & VRING_DESC_F_USED(1));
+		avail = !!(desc->flags & VRING_DESC_F_AVAIL(1));
+
+		return avail == used && used == wrap_counter;
+	}
+
 	return VIRTQUEUE_NUSED(vq) >= offset;
 }
 
@@ -88,6 +113,36 @@ vq_ring_free_chain(struct virtqueue *vq, uint16_t desc_idx)
 	dp->next = VQ_RING_DESC_CHAIN_END;
 }
 
+/* Give the descriptors of a packed ring buffer back, and its id. */
+void
+vq_ring_free_id_packed(struct virtqueue *vq, uint16_t id)
+{
+	struct vq_desc_extra *dxp = &vq->vq_descx[id];
+
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt + dxp->ndescs);
+	dxp->ndescs = 0;
+	dxp->next = VQ_RING_DESC_CHAIN_END;
+
+	if (vq->vq_desc_tail_idx == VQ_RING_DESC_CHAIN_END)
+		vq->vq_desc_head_idx = id;
+	else
+		vq->vq_descx[vq->vq_desc_tail_idx].next = id;
+	vq->vq_desc_tail_idx = id;
+}
+
+/* Take a free buffer id of a packed ring, the caller checks vq_free_cnt. */
+static inline uint16_t
+vq_ring_get_id_packed(struct virtqueue *vq)
+{
+	uint16_t id = vq->vq_desc_head_idx;
+
+	vq->vq_desc_head_idx = vq->vq_descx[id].next;
+	if (vq->vq_desc_head_idx == VQ_RING_DESC_CHAIN_END)
+		vq->vq_desc_tail_idx = VQ_RING_DESC_CHAIN_END;
+
+	return id;
+}
+
 static uint16_t
 virtqueue_dequeue_burst_rx(struct virtqueue *vq, struct rte_mbuf **rx_pkts,
 			   uint32_t *len, uint16_t num)
@@ -160,15 +215,70 @@ virtqueue_dequeue_rx_inorder(struct virtqueue *vq,
 	return i;
 }
 
+static uint16_t
+virtqueue_dequeue_burst_rx_packed(struct virtqueue *vq,
+			struct rte_mbuf **rx_pkts,
+			uint32_t *len,
+			uint16_t num)
+{
+	struct vring_packed_desc *desc = vq->vq_ring_packed.desc_packed;
+	struct rte_mbuf *cookie;
+	uint16_t used_idx, id;
+	uint16_t i;
+
+	for (i = 0; i < num; i++) {
+		used_idx = vq->vq_used_cons_idx;
+		if (!desc_is_used(&desc[used_idx], vq))
+			break;
+		virtio_rmb();
+
+		len[i] = desc[used_idx].len;
+		id = desc[used_idx].id;
+		cookie = (struct rte_mbuf *)vq->vq_descx[id].cookie;
+
+		if (unlikely(cookie == NULL)) {
+			PMD_DRV_LOG(ERR, "vring descriptor with no mbuf cookie at %u",
+				vq->vq_used_cons_idx);
+			break;
+		}
+
+		rte_prefetch0(cookie);
+		rte_packet_prefetch(rte_pktmbuf_mtod(cookie, void *));
+		rx_pkts[i] = cookie;
+		vq->vq_descx[id].cookie = NULL;
+		vq_used_idx_add_packed(vq, vq->vq_descx[id].ndescs);
+		vq_ring_free_id_packed(vq, id);
+	}
+
+	return i;
+}
+
 #ifndef DEFAULT_TX_FREE_THRESH
 #define DEFAULT_TX_FREE_THRESH 32
 #endif
 
+/* Number of transmitted mbufs freed at once by the cleanup functions */
+#define VIRTIO_TX_FREE_BULK 64
+
+/* Queue a transmitted mbuf to be freed, freeing the queue when full. */
+static inline void
+virtio_xmit_free_mbuf(struct rte_mbuf **free_pkts, uint16_t *nb_free,
+		struct rte_mbuf *m)
+{
+	free_pkts[(*nb_free)++] = m;
+	if (*nb_free == VIRTIO_TX_FREE_BULK) {
+		rte_pktmbuf_free_bulk(free_pkts, *nb_free);
+		*nb_free = 0;
+	}
+}
+
 /* Cleanup from completed transmits. */
 static void
 virtio_xmit_cleanup(struct virtqueue *vq, uint16_t num)
 {
-	uint16_t i, used_idx, desc_idx;
+	struct rte_mbuf *free_pkts[VIRTIO_TX_FREE_BULK];
+	uint16_t i, used_idx, desc_idx, nb_free = 0;
+
 	for (i = 0; i < num; i++) {
 		struct vring_used_elem *uep;
 		struct vq_desc_extra *dxp;
@@ -182,17 +292,21 @@ virtio_xmit_cleanup(struct virtqueue *vq, uint16_t num)
 		vq_ring_free_chain(vq, desc_idx);
 
 		if (dxp->cookie != NULL) {
-			rte_pktmbuf_free(dxp->cookie);
+			virtio_xmit_free_mbuf(free_pkts, &nb_free, dxp->cookie);
 			dxp->cookie = NULL;
 		}
 	}
+
+	if (nb_free > 0)
+		rte_pktmbuf_free_bulk(free_pkts, nb_free);
 }
 
 /* Cleanup from completed inorder transmits. */
 static void
 virtio_xmit_cleanup_inorder(struct virtqueue *vq, uint16_t num)
 {
-	uint16_t i, used_idx, desc_idx = 0, last_idx;
+	struct rte_mbuf *free_pkts[VIRTIO_TX_FREE_BULK];
+	uint16_t i, used_idx, desc_idx = 0, last_idx, nb_free = 0;
 	int16_t free_cnt = 0;
 	struct vq_desc_extra *dxp = NULL;
 
@@ -210,11 +324,14 @@ virtio_xmit_cleanup_inorder(struct virtqueue *vq, uint16_t num)
 		vq->vq_used_cons_idx++;
 
 		if (dxp->cookie != NULL) {
-			rte_pktmbuf_free(dxp->cookie);
+			virtio_xmit_free_mbuf(free_pkts, &nb_free, dxp->cookie);
 			dxp->cookie = NULL;
 		}
 	}
 
+	if (nb_free > 0)
+		rte_pktmbuf_free_bulk(free_pkts, nb_free);
+
 	last_idx = desc_idx + dxp->ndescs - 1;
 	free_cnt = last_idx - vq->vq_desc_tail_idx;
 	if (free_cnt <= 0)
@@ -223,6 +340,48 @@ virtio_xmit_cleanup_inorder(struct virtqueue *vq, uint16_t num)
 	vq_ring_free_inorder(vq, last_idx, free_cnt);
 }
 
+/*
+ * Cleanup up to num completed transmits of a packed ring.
+ * In order, the buffer ids are their head slots and the device may write
+ * back only the last buffer of a batch: all the buffers up to it are done.
+ */
+static void
+virtio_xmit_cleanup_packed(struct virtqueue *vq, int num, int in_order)
+{
+	struct vring_packed_desc *desc = vq->vq_ring_packed.desc_packed;
+	struct rte_mbuf *free_pkts[VIRTIO_TX_FREE_BULK];
+	struct vq_desc_extra *dxp;
+	uint16_t id, curr_id, nb_free = 0;
+
+	while (num > 0 && desc_is_used(&desc[vq->vq_used_cons_idx], vq)) {
+		virtio_rmb();
+		id = desc[vq->vq_used_cons_idx].id;
+
+		do {
+			curr_id = in_order ? vq->vq_used_cons_idx : id;
+			dxp = &vq->vq_descx[curr_id];
+			vq_used_idx_add_packed(vq, dxp->ndescs);
+
+			if (in_order) {
+				vq->vq_free_cnt += dxp->ndescs;
+				dxp->ndescs = 0;
+			} else {
+				vq_ring_free_id_packed(vq, curr_id);
+			}
+
+			if (dxp->cookie != NULL) {
+				virtio_xmit_free_mbuf(free_pkts, &nb_free,
+						dxp->cookie);
+				dxp->cookie = NULL;
+			}
+			num--;
+		} while (curr_id != id);
+	}
+
+	if (nb_free > 0)
+		rte_pktmbuf_free_bulk(free_pkts, nb_free);
+}
+
 static inline int
 virtqueue_enqueue_refill_inorder(struct virtqueue *vq,
 			struct rte_mbuf **cookies,
@@ -306,6 +465,46 @@ virtqueue_enqueue_recv_refill(struct virtqueue *vq, struct rte_mbuf *cookie)
 	return 0;
 }
 
+static inline int
+virtqueue_enqueue_recv_refill_packed(struct virtqueue *vq,
+				     struct rte_mbuf **cookies, uint16_t num)
+{
+	struct vring_packed_desc *start_dp = vq->vq_ring_packed.desc_packed;
+	struct virtio_hw *hw = vq->hw;
+	struct vq_desc_extra *dxp;
+	uint16_t idx, id, i;
+
+	if (unlikely(vq->vq_free_cnt == 0))
+		return -ENOSPC;
+	if (unlikely(vq->vq_free_cnt < num))
+		return -EMSGSIZE;
+
+	for (i = 0; i < num; i++) {
+		idx = vq->vq_avail_idx;
+		id = vq_ring_get_id_packed(vq);
+		dxp = &vq->vq_descx[id];
+		dxp->cookie = (void *)cookies[i];
+		dxp->ndescs = 1;
+
+		start_dp[idx].addr =
+			VIRTIO_MBUF_ADDR(cookies[i], vq) +
+			RTE_PKTMBUF_HEADROOM - hw->vtnet_hdr_size;
+		start_dp[idx].len =
+			cookies[i]->buf_len - RTE_PKTMBUF_HEADROOM +
+			hw->vtnet_hdr_size;
+		start_dp[idx].id = id;
+
+		/* the flags make the descriptor available, write them last */
+		virtio_wmb();
+		start_dp[idx].flags = VRING_DESC_F_WRITE |
+			vq->vq_avail_used_flags;
+		vq_avail_idx_inc_packed(vq);
+	}
+
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt - num);
+	return 0;
+}
+
 /* When doing TSO, the IP length is not included in the pseudo header
  * checksum of the packet given to the PMD, but for virtio it is
  * expected.
@@ -456,6 +655,22 @@ virtqueue_enqueue_xmit_inorder(struct virtnet_tx *txvq,
 	vq->vq_desc_head_idx = idx & (vq->vq_nentries - 1);
 }
 
+static __rte_always_inline void
+virtqueue_enqueue_xmit_inorder_burst(struct virtnet_tx *txvq,
+			struct rte_mbuf **cookies,
+			uint16_t num, int vec)
+{
+#ifdef CC_AVX2_SUPPORT
+	if (vec) {
+		virtqueue_enqueue_xmit_inorder_avx2(txvq, cookies, num);
+		return;
+	}
+#else
+	RTE_SET_USED(vec);
+#endif
+	virtqueue_enqueue_xmit_inorder(txvq, cookies, num);
+}
+
 static inline void
 virtqueue_enqueue_xmit(struct virtnet_tx *txvq, struct rte_mbuf *cookie,
 			uint16_t needed, int use_indirect, int can_push,
@@ -548,6 +763,107 @@ virtqueue_enqueue_xmit(struct virtnet_tx *txvq, struct rte_mbuf *cookie,
 	}
 }
 
+/*
+ * The head descriptor flags are written last, once the whole chain and
+ * the header are in place.
+ */
+static inline void
+virtqueue_enqueue_xmit_packed(struct virtnet_tx *txvq, struct rte_mbuf *cookie,
+			uint16_t needed, int use_indirect, int can_push,
+			int in_order)
+{
+	struct virtio_tx_region *txr = txvq->virtio_net_hdr_mz->addr;
+	struct virtqueue *vq = txvq->vq;
+	struct vring_packed_desc *start_dp, *head_dp, *dp;
+	struct vq_desc_extra *dxp;
+	uint16_t head_size = vq->hw->vtnet_hdr_size;
+	uint16_t id, head_flags, flags;
+	struct virtio_net_hdr *hdr;
+
+	id = in_order ? vq->vq_avail_idx : vq_ring_get_id_packed(vq);
+	dxp = &vq->vq_descx[id];
+	dxp->cookie = (void *)cookie;
+	dxp->ndescs = needed;
+
+	start_dp = vq->vq_ring_packed.desc_packed;
+	head_dp = &start_dp[vq->vq_avail_idx];
+	head_flags = vq->vq_avail_used_flags;
+
+	if (can_push) {
+		/* prepend cannot fail, checked by caller */
+		hdr = (struct virtio_net_hdr *)
+			rte_pktmbuf_prepend(cookie, head_size);
+		/* rte_pktmbuf_prepend() counts the hdr size to the pkt length,
+		 * which is wrong. Below subtract restores correct pkt size.
+		 */
+		cookie->pkt_len -= head_size;
+
+		/* if offload disabled, it is not zeroed below, do it now */
+		if (!vq->hw->has_tx_offload) {
+			ASSIGN_UNLESS_EQUAL(hdr->csum_start, 0);
+			ASSIGN_UNLESS_EQUAL(hdr->csum_offset, 0);
+			ASSIGN_UNLESS_EQUAL(hdr->flags, 0);
+			ASSIGN_UNLESS_EQUAL(hdr->gso_type, 0);
+			ASSIGN_UNLESS_EQUAL(hdr->gso_size, 0);
+			ASSIGN_UNLESS_EQUAL(hdr->hdr_len, 0);
+		}
+	} else {
+		hdr = (struct virtio_net_hdr *)&txr[id].tx_hdr;
+	}
+
+	virtqueue_xmit_offload(hdr, cookie, vq->hw->has_tx_offload);
+
+	if (use_indirect) {
+		/* setup tx ring slot to point to indirect
+		 * descriptor table stored in reserved region.
+		 *
+		 * the first entry of the table is already preset
+		 * to point to the header in reserved region
+		 */
+		dp = &txr[id].tx_packed_indir[1];
+		do {
+			dp->addr = VIRTIO_MBUF_DATA_DMA_ADDR(cookie, vq);
+			dp->len = cookie->data_len;
+			dp++;
+		} while ((cookie = cookie->next) != NULL);
+
+		head_dp->addr = txvq->virtio_net_hdr_mem +
+			RTE_PTR_DIFF(&txr[id].tx_packed_indir, txr);
+		head_dp->len = RTE_PTR_DIFF(dp, txr[id].tx_packed_indir);
+		head_flags |= VRING_DESC_F_INDIRECT;
+		vq_avail_idx_inc_packed(vq);
+	} else {
+		if (!can_push) {
+			/* first slot points to the header in reserved region */
+			head_dp->addr = txvq->virtio_net_hdr_mem +
+				RTE_PTR_DIFF(&txr[id].tx_hdr, txr);
+			head_dp->len = head_size;
+			head_flags |= VRING_DESC_F_NEXT;
+			vq_avail_idx_inc_packed(vq);
+		}
+
+		do {
+			dp = &start_dp[vq->vq_avail_idx];
+			dp->addr = VIRTIO_MBUF_DATA_DMA_ADDR(cookie, vq);
+			dp->len = cookie->data_len;
+			flags = cookie->next ? VRING_DESC_F_NEXT : 0;
+			if (dp == head_dp) {
+				head_flags |= flags;
+			} else {
+				dp->id = id;
+				dp->flags = flags | vq->vq_avail_used_flags;
+			}
+			vq_avail_idx_inc_packed(vq);
+		} while ((cookie = cookie->next) != NULL);
+	}
+
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt - needed);
+
+	head_dp->id = id;
+	virtio_wmb();
+	head_dp->flags = head_flags;
+}
+
 void
 virtio_dev_cq_start(struct rte_eth_dev *dev)
 {
@@ -563,8 +879,8 @@ int
 virtio_dev_rx_queue_setup(struct rte_eth_dev *dev,
 			uint16_t queue_idx,
 			uint16_t nb_desc,
-			unsigned int socket_id __rte_unused,
-			const struct rte_eth_rxconf *rx_conf __rte_unused,
+			unsigned int socket_id,
+			const struct rte_eth_rxconf *rx_conf,
 			struct rte_mempool *mp)
 {
 	uint16_t vtpci_queue_idx = 2 * queue_idx + VTNET_SQ_RQ_QUEUE_IDX;
@@ -588,7 +904,8 @@ virtio_dev_rx_queue_setup(struct rte_eth_dev *dev,
 
 	dev->data->rx_queues[queue_idx] = rxvq;
 
-	return 0;
+	return virtio_standby_rx_queue_setup(dev, queue_idx, socket_id,
+					     rx_conf, mp);
 }
 
 int
@@ -614,10 +931,11 @@ virtio_dev_rx_queue_setup_finish(struct rte_eth_dev *dev, uint16_t queue_idx)
 			vq->vq_ring.desc[desc_idx].flags =
 				VRING_DESC_F_WRITE;
 		}
-
-		virtio_rxq_vec_setup(rxvq);
 	}
 
+	/* rearm value of the refilled mbufs, also used by the scalar paths */
+	virtio_rxq_vec_setup(rxvq);
+
 	memset(&rxvq->fake_mbuf, 0, sizeof(rxvq->fake_mbuf));
 	for (desc_idx = 0; desc_idx < RTE_PMD_VIRTIO_RX_MAX_BURST;
 	     desc_idx++) {
@@ -630,13 +948,28 @@ virtio_dev_rx_queue_setup_finish(struct rte_eth_dev *dev, uint16_t queue_idx)
 			virtio_rxq_rearm_vec(rxvq);
 			nbufs += RTE_VIRTIO_VPMD_RX_REARM_THRESH;
 		}
+	} else if (vtpci_packed_queue(hw)) {
+		uint16_t free_cnt = vq->vq_free_cnt;
+		struct rte_mbuf *pkts[free_cnt];
+
+		if (free_cnt && !rte_pktmbuf_alloc_bulk_rearm(rxvq->mpool,
+				pkts, free_cnt, rxvq->mbuf_initializer)) {
+			error = virtqueue_enqueue_recv_refill_packed(vq, pkts,
+					free_cnt);
+			if (unlikely(error)) {
+				for (i = 0; i < free_cnt; i++)
+					rte_pktmbuf_free(pkts[i]);
+			} else {
+				nbufs += free_cnt;
+			}
+		}
 	} else if (hw->use_inorder_rx) {
 		if ((!virtqueue_full(vq))) {
 			uint16_t free_cnt = vq->vq_free_cnt;
 			struct rte_mbuf *pkts[free_cnt];
 
-			if (!rte_pktmbuf_alloc_bulk(rxvq->mpool, pkts,
-				free_cnt)) {
+			if (!rte_pktmbuf_alloc_bulk_rearm(rxvq->mpool, pkts,
+				free_cnt, rxvq->mbuf_initializer)) {
 				error = virtqueue_enqueue_refill_inorder(vq,
 						pkts,
 						free_cnt);
@@ -685,7 +1018,7 @@ int
 virtio_dev_tx_queue_setup(struct rte_eth_dev *dev,
 			uint16_t queue_idx,
 			uint16_t nb_desc,
-			unsigned int socket_id __rte_unused,
+			unsigned int socket_id,
 			const struct rte_eth_txconf *tx_conf)
 {
 	uint8_t vtpci_queue_idx = 2 * queue_idx + VTNET_SQ_TQ_QUEUE_IDX;
@@ -720,7 +1053,9 @@ virtio_dev_tx_queue_setup(struct rte_eth_dev *dev,
 	vq->vq_free_thresh = tx_free_thresh;
 
 	dev->data->tx_queues[queue_idx] = txvq;
-	return 0;
+
+	return virtio_standby_tx_queue_setup(dev, queue_idx, socket_id,
+					     tx_conf);
 }
 
 int
@@ -733,9 +1068,11 @@ virtio_dev_tx_queue_setup_finish(struct rte_eth_dev *dev,
 
 	PMD_INIT_FUNC_TRACE();
 
-	if (hw->use_inorder_tx)
+	if (!vtpci_packed_queue(hw) && hw->use_inorder_tx)
 		vq->vq_ring.desc[vq->vq_nentries - 1].next = 0;
 
+	vq->txq.kick_pending = 0;
+
 	VIRTQUEUE_DUMP(vq);
 
 	return 0;
@@ -757,6 +1094,18 @@ virtio_discard_rxbuf(struct virtqueue *vq, struct rte_mbuf *m)
 	}
 }
 
+static void
+virtio_discard_rxbuf_packed(struct virtqueue *vq, struct rte_mbuf *m)
+{
+	int error;
+
+	error = virtqueue_enqueue_recv_refill_packed(vq, &m, 1);
+	if (unlikely(error)) {
+		RTE_LOG(ERR, PMD, "cannot requeue discarded mbuf");
+		rte_pktmbuf_free(m);
+	}
+}
+
 static void
 virtio_discard_rxbuf_inorder(struct virtqueue *vq, struct rte_mbuf *m)
 {
@@ -883,6 +1232,19 @@ virtio_rx_offload(struct rte_mbuf *m, struct virtio_net_hdr *hdr)
 	return 0;
 }
 
+/* Report the packet hash of the device, with VIRTIO_NET_F_HASH_REPORT */
+static inline void
+virtio_rx_hash(struct rte_mbuf *m, struct virtio_net_hdr *hdr)
+{
+	struct virtio_net_hdr_hash_report *hash_hdr =
+		(struct virtio_net_hdr_hash_report *)hdr;
+
+	if (hash_hdr->hash_report != VIRTIO_NET_HASH_REPORT_NONE) {
+		m->hash.rss = hash_hdr->hash_value;
+		m->ol_flags |= PKT_RX_RSS_HASH;
+	}
+}
+
 #define VIRTIO_MBUF_BURST_SZ 64
 #define DESC_PER_CACHELINE (RTE_CACHE_LINE_SIZE / sizeof(struct vring_desc))
 uint16_t
@@ -947,6 +1309,9 @@ virtio_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 		if (hw->vlan_strip)
 			rte_vlan_strip(rxm);
 
+		if (hw->has_rx_hash)
+			virtio_rx_hash(rxm, hdr);
+
 		if (hw->has_rx_offload && virtio_rx_offload(rxm, hdr) < 0) {
 			virtio_discard_rxbuf(vq, rxm);
 			rxvq->stats.errors++;
@@ -967,6 +1332,7 @@ virtio_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 			struct rte_eth_dev *dev
 				= &rte_eth_devices[rxvq->port_id];
 			dev->data->rx_mbuf_alloc_failed++;
+			rxvq->stats.refill_failed++;
 			break;
 		}
 		error = virtqueue_enqueue_recv_refill(vq, new_mbuf);
@@ -982,6 +1348,7 @@ virtio_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 
 		if (unlikely(virtqueue_kick_prepare(vq))) {
 			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
 			PMD_RX_LOG(DEBUG, "Notified");
 		}
 	}
@@ -1064,6 +1431,9 @@ virtio_recv_mergeable_pkts_inorder(void *rx_queue,
 		rx_pkts[nb_rx] = rxm;
 		prev = rxm;
 
+		if (hw->has_rx_hash)
+			virtio_rx_hash(rxm, &header->hdr);
+
 		if (vq->hw->has_rx_offload &&
 				virtio_rx_offload(rxm, &header->hdr) < 0) {
 			virtio_discard_rxbuf_inorder(vq, rxm);
@@ -1149,7 +1519,8 @@ virtio_recv_mergeable_pkts_inorder(void *rx_queue,
 		uint16_t free_cnt = vq->vq_free_cnt;
 		struct rte_mbuf *new_pkts[free_cnt];
 
-		if (!rte_pktmbuf_alloc_bulk(rxvq->mpool, new_pkts, free_cnt)) {
+		if (!rte_pktmbuf_alloc_bulk_rearm(rxvq->mpool, new_pkts,
+				free_cnt, rxvq->mbuf_initializer)) {
 			error = virtqueue_enqueue_refill_inorder(vq, new_pkts,
 					free_cnt);
 			if (unlikely(error)) {
@@ -1161,6 +1532,7 @@ virtio_recv_mergeable_pkts_inorder(void *rx_queue,
 			struct rte_eth_dev *dev =
 				&rte_eth_devices[rxvq->port_id];
 			dev->data->rx_mbuf_alloc_failed += free_cnt;
+			rxvq->stats.refill_failed++;
 		}
 	}
 
@@ -1169,6 +1541,7 @@ virtio_recv_mergeable_pkts_inorder(void *rx_queue,
 
 		if (unlikely(virtqueue_kick_prepare(vq))) {
 			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
 			PMD_RX_LOG(DEBUG, "Notified");
 		}
 	}
@@ -1176,6 +1549,38 @@ virtio_recv_mergeable_pkts_inorder(void *rx_queue,
 	return nb_rx;
 }
 
+/*
+ * In-order mergeable Rx with the single buffer packets at the head of the
+ * used ring taken by groups of eight in virtio_rxq_recv_mrg_inorder_vec().
+ * The scalar path then takes the multi-buffer packets and the remaining
+ * ones, refills the ring and kicks. Rx offloads and VLAN stripping need
+ * the header of each packet, so they keep to the scalar path.
+ */
+uint16_t
+virtio_recv_mergeable_pkts_inorder_vec(void *rx_queue,
+			struct rte_mbuf **rx_pkts,
+			uint16_t nb_pkts)
+{
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtio_hw *hw = rxvq->vq->hw;
+	uint16_t nb_rx, i;
+
+	if (unlikely(hw->started == 0))
+		return 0;
+
+	if (hw->has_rx_offload || hw->has_rx_hash || hw->vlan_strip)
+		return virtio_recv_mergeable_pkts_inorder(rx_queue, rx_pkts,
+				nb_pkts);
+
+	nb_rx = virtio_rxq_recv_mrg_inorder_vec(rxvq, rx_pkts, nb_pkts);
+	for (i = 0; i < nb_rx; i++)
+		virtio_rx_stats_updated(rxvq, rx_pkts[i]);
+	rxvq->stats.packets += nb_rx;
+
+	return nb_rx + virtio_recv_mergeable_pkts_inorder(rx_queue,
+			rx_pkts + nb_rx, nb_pkts - nb_rx);
+}
+
 uint16_t
 virtio_recv_mergeable_pkts(void *rx_queue,
 			struct rte_mbuf **rx_pkts,
@@ -1256,6 +1661,9 @@ virtio_recv_mergeable_pkts(void *rx_queue,
 		rx_pkts[nb_rx] = rxm;
 		prev = rxm;
 
+		if (hw->has_rx_hash)
+			virtio_rx_hash(rxm, &header->hdr);
+
 		if (hw->has_rx_offload &&
 				virtio_rx_offload(rxm, &header->hdr) < 0) {
 			virtio_discard_rxbuf(vq, rxm);
@@ -1324,6 +1732,7 @@ virtio_recv_mergeable_pkts(void *rx_queue,
 			struct rte_eth_dev *dev
 				= &rte_eth_devices[rxvq->port_id];
 			dev->data->rx_mbuf_alloc_failed++;
+			rxvq->stats.refill_failed++;
 			break;
 		}
 		error = virtqueue_enqueue_recv_refill(vq, new_mbuf);
@@ -1339,6 +1748,7 @@ virtio_recv_mergeable_pkts(void *rx_queue,
 
 		if (unlikely(virtqueue_kick_prepare(vq))) {
 			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
 			PMD_RX_LOG(DEBUG, "Notified");
 		}
 	}
@@ -1347,48 +1757,386 @@ virtio_recv_mergeable_pkts(void *rx_queue,
 }
 
 uint16_t
-virtio_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+virtio_recv_pkts_packed(void *rx_queue, struct rte_mbuf **rx_pkts,
+			uint16_t nb_pkts)
 {
-	struct virtnet_tx *txvq = tx_queue;
-	struct virtqueue *vq = txvq->vq;
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtqueue *vq = rxvq->vq;
 	struct virtio_hw *hw = vq->hw;
-	uint16_t hdr_size = hw->vtnet_hdr_size;
-	uint16_t nb_used, nb_tx = 0;
+	struct rte_mbuf *rxm;
+	uint16_t num, nb_rx;
+	uint32_t len[VIRTIO_MBUF_BURST_SZ];
+	struct rte_mbuf *rcv_pkts[VIRTIO_MBUF_BURST_SZ];
 	int error;
+	uint32_t i, nb_enqueued;
+	uint32_t hdr_size;
+	struct virtio_net_hdr *hdr;
 
-	if (unlikely(hw->started == 0 && tx_pkts != hw->inject_pkts))
-		return nb_tx;
+	nb_rx = 0;
+	if (unlikely(hw->started == 0))
+		return nb_rx;
 
-	if (unlikely(nb_pkts < 1))
-		return nb_pkts;
+	num = RTE_MIN(VIRTIO_MBUF_BURST_SZ, nb_pkts);
+	if (likely(num > DESC_PER_CACHELINE))
+		num = num - ((vq->vq_used_cons_idx + num) % DESC_PER_CACHELINE);
 
-	PMD_TX_LOG(DEBUG, "%d packets to xmit", nb_pkts);
-	nb_used = VIRTQUEUE_NUSED(vq);
+	num = virtqueue_dequeue_burst_rx_packed(vq, rcv_pkts, len, num);
+	PMD_RX_LOG(DEBUG, "dequeue:%d", num);
 
-	virtio_rmb();
-	if (likely(nb_used > vq->vq_nentries - vq->vq_free_thresh))
-		virtio_xmit_cleanup(vq, nb_used);
+	nb_enqueued = 0;
+	hdr_size = hw->vtnet_hdr_size;
 
-	for (nb_tx = 0; nb_tx < nb_pkts; nb_tx++) {
-		struct rte_mbuf *txm = tx_pkts[nb_tx];
-		int can_push = 0, use_indirect = 0, slots, need;
+	for (i = 0; i < num; i++) {
+		rxm = rcv_pkts[i];
 
-		/* Do VLAN tag insertion */
-		if (unlikely(txm->ol_flags & PKT_TX_VLAN_PKT)) {
-			error = rte_vlan_insert(&txm);
-			if (unlikely(error)) {
-				rte_pktmbuf_free(txm);
-				continue;
-			}
+		PMD_RX_LOG(DEBUG, "packet len:%d", len[i]);
+
+		if (unlikely(len[i] < hdr_size + ETHER_HDR_LEN)) {
+			PMD_RX_LOG(ERR, "Packet drop");
+			nb_enqueued++;
+			virtio_discard_rxbuf_packed(vq, rxm);
+			rxvq->stats.errors++;
+			continue;
 		}
 
-		/* optimize ring usage */
-		if ((vtpci_with_feature(hw, VIRTIO_F_ANY_LAYOUT) ||
-		      vtpci_with_feature(hw, VIRTIO_F_VERSION_1)) &&
-		    rte_mbuf_refcnt_read(txm) == 1 &&
-		    RTE_MBUF_DIRECT(txm) &&
-		    txm->nb_segs == 1 &&
-		    rte_pktmbuf_headroom(txm) >= hdr_size &&
+		rxm->port = rxvq->port_id;
+		rxm->data_off = RTE_PKTMBUF_HEADROOM;
+		rxm->ol_flags = 0;
+		rxm->vlan_tci = 0;
+
+		rxm->pkt_len = (uint32_t)(len[i] - hdr_size);
+		rxm->data_len = (uint16_t)(len[i] - hdr_size);
+
+		hdr = (struct virtio_net_hdr *)((char *)rxm->buf_addr +
+			RTE_PKTMBUF_HEADROOM - hdr_size);
+
+		if (hw->vlan_strip)
+			rte_vlan_strip(rxm);
+
+		if (hw->has_rx_hash)
+			virtio_rx_hash(rxm, hdr);
+
+		if (hw->has_rx_offload && virtio_rx_offload(rxm, hdr) < 0) {
+			virtio_discard_rxbuf_packed(vq, rxm);
+			rxvq->stats.errors++;
+			continue;
+		}
+
+		virtio_rx_stats_updated(rxvq, rxm);
+
+		rx_pkts[nb_rx++] = rxm;
+	}
+
+	rxvq->stats.packets += nb_rx;
+
+	/* Allocate new mbufs for the used descriptors */
+	if (likely(vq->vq_free_cnt)) {
+		uint16_t free_cnt = vq->vq_free_cnt;
+		struct rte_mbuf *new_pkts[free_cnt];
+
+		if (likely(!rte_pktmbuf_alloc_bulk_rearm(rxvq->mpool,
+				new_pkts, free_cnt, rxvq->mbuf_initializer))) {
+			error = virtqueue_enqueue_recv_refill_packed(vq,
+					new_pkts, free_cnt);
+			if (unlikely(error)) {
+				for (i = 0; i < free_cnt; i++)
+					rte_pktmbuf_free(new_pkts[i]);
+			} else {
+				nb_enqueued += free_cnt;
+			}
+		} else {
+			struct rte_eth_dev *dev =
+				&rte_eth_devices[rxvq->port_id];
+			dev->data->rx_mbuf_alloc_failed += free_cnt;
+			rxvq->stats.refill_failed++;
+		}
+	}
+
+	if (likely(nb_enqueued)) {
+		if (unlikely(virtqueue_kick_prepare_packed(vq))) {
+			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
+			PMD_RX_LOG(DEBUG, "Notified");
+		}
+	}
+
+	return nb_rx;
+}
+
+/*
+ * Offloads, VLAN strip and stats of a complete mergeable packet,
+ * the packet is freed on error.
+ */
+static inline int
+virtio_rx_mrg_finish_packed(struct virtnet_rx *rxvq, struct rte_mbuf *rxm)
+{
+	struct virtio_hw *hw = rxvq->vq->hw;
+	struct virtio_net_hdr *hdr;
+
+	hdr = (struct virtio_net_hdr *)((char *)rxm->buf_addr +
+		RTE_PKTMBUF_HEADROOM - hw->vtnet_hdr_size);
+
+	if (hw->has_rx_hash)
+		virtio_rx_hash(rxm, hdr);
+
+	if (hw->has_rx_offload && virtio_rx_offload(rxm, hdr) < 0) {
+		rte_pktmbuf_free(rxm);
+		rxvq->stats.errors++;
+		return -1;
+	}
+
+	if (hw->vlan_strip)
+		rte_vlan_strip(rxm);
+
+	virtio_rx_stats_updated(rxvq, rxm);
+
+	return 0;
+}
+
+uint16_t
+virtio_recv_mergeable_pkts_packed(void *rx_queue,
+			struct rte_mbuf **rx_pkts,
+			uint16_t nb_pkts)
+{
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtqueue *vq = rxvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	struct rte_mbuf *rxm;
+	struct rte_mbuf *prev = NULL;
+	uint16_t num, nb_rx;
+	uint32_t len[VIRTIO_MBUF_BURST_SZ];
+	struct rte_mbuf *rcv_pkts[VIRTIO_MBUF_BURST_SZ];
+	int error;
+	uint32_t i, nb_enqueued;
+	uint32_t seg_num;
+	uint32_t seg_res;
+	uint32_t hdr_size;
+
+	nb_rx = 0;
+	if (unlikely(hw->started == 0))
+		return nb_rx;
+
+	num = RTE_MIN(VIRTIO_MBUF_BURST_SZ, nb_pkts);
+	num = virtqueue_dequeue_burst_rx_packed(vq, rcv_pkts, len, num);
+	PMD_RX_LOG(DEBUG, "dequeue:%d", num);
+
+	nb_enqueued = 0;
+	seg_res = 0;
+	hdr_size = hw->vtnet_hdr_size;
+
+	for (i = 0; i < num; i++) {
+		struct virtio_net_hdr_mrg_rxbuf *header;
+
+		PMD_RX_LOG(DEBUG, "packet len:%d", len[i]);
+
+		rxm = rcv_pkts[i];
+
+		if (seg_res != 0) {
+			/* Merge remaining segments */
+			rxm->data_off = RTE_PKTMBUF_HEADROOM - hdr_size;
+			rxm->pkt_len = (uint32_t)(len[i]);
+			rxm->data_len = (uint16_t)(len[i]);
+
+			rx_pkts[nb_rx]->pkt_len += (uint32_t)(len[i]);
+			prev->next = rxm;
+			prev = rxm;
+			seg_res--;
+		} else {
+			if (unlikely(len[i] < hdr_size + ETHER_HDR_LEN)) {
+				PMD_RX_LOG(ERR, "Packet drop");
+				nb_enqueued++;
+				virtio_discard_rxbuf_packed(vq, rxm);
+				rxvq->stats.errors++;
+				continue;
+			}
+
+			header = (struct virtio_net_hdr_mrg_rxbuf *)
+				((char *)rxm->buf_addr + RTE_PKTMBUF_HEADROOM -
+				 hdr_size);
+			seg_num = header->num_buffers;
+			if (seg_num == 0)
+				seg_num = 1;
+
+			rxm->data_off = RTE_PKTMBUF_HEADROOM;
+			rxm->nb_segs = seg_num;
+			rxm->ol_flags = 0;
+			rxm->vlan_tci = 0;
+			rxm->pkt_len = (uint32_t)(len[i] - hdr_size);
+			rxm->data_len = (uint16_t)(len[i] - hdr_size);
+
+			rxm->port = rxvq->port_id;
+
+			rx_pkts[nb_rx] = rxm;
+			prev = rxm;
+			seg_res = seg_num - 1;
+		}
+
+		if (seg_res == 0 &&
+				virtio_rx_mrg_finish_packed(rxvq,
+					rx_pkts[nb_rx]) == 0)
+			nb_rx++;
+	}
+
+	/*
+	 * Last packet still need merge segments, the device makes all the
+	 * buffers of a packet used at once so they are already there.
+	 */
+	while (seg_res != 0) {
+		uint16_t rcv_cnt = RTE_MIN((uint16_t)seg_res,
+					VIRTIO_MBUF_BURST_SZ);
+
+		num = virtqueue_dequeue_burst_rx_packed(vq, rcv_pkts, len,
+							rcv_cnt);
+		if (unlikely(num == 0)) {
+			PMD_RX_LOG(ERR, "No enough segments for packet.");
+			rte_pktmbuf_free(rx_pkts[nb_rx]);
+			rxvq->stats.errors++;
+			break;
+		}
+
+		for (i = 0; i < num; i++) {
+			rxm = rcv_pkts[i];
+			rxm->data_off = RTE_PKTMBUF_HEADROOM - hdr_size;
+			rxm->pkt_len = (uint32_t)(len[i]);
+			rxm->data_len = (uint16_t)(len[i]);
+			prev->next = rxm;
+			prev = rxm;
+			rx_pkts[nb_rx]->pkt_len += len[i];
+		}
+		seg_res -= num;
+
+		if (seg_res == 0 &&
+				virtio_rx_mrg_finish_packed(rxvq,
+					rx_pkts[nb_rx]) == 0)
+			nb_rx++;
+	}
+
+	rxvq->stats.packets += nb_rx;
+
+	/* Allocate new mbufs for the used descriptors */
+	if (likely(vq->vq_free_cnt)) {
+		uint16_t free_cnt = vq->vq_free_cnt;
+		struct rte_mbuf *new_pkts[free_cnt];
+
+		if (likely(!rte_pktmbuf_alloc_bulk_rearm(rxvq->mpool,
+				new_pkts, free_cnt, rxvq->mbuf_initializer))) {
+			error = virtqueue_enqueue_recv_refill_packed(vq,
+					new_pkts, free_cnt);
+			if (unlikely(error)) {
+				for (i = 0; i < free_cnt; i++)
+					rte_pktmbuf_free(new_pkts[i]);
+			} else {
+				nb_enqueued += free_cnt;
+			}
+		} else {
+			struct rte_eth_dev *dev =
+				&rte_eth_devices[rxvq->port_id];
+			dev->data->rx_mbuf_alloc_failed += free_cnt;
+			rxvq->stats.refill_failed++;
+		}
+	}
+
+	if (likely(nb_enqueued)) {
+		if (unlikely(virtqueue_kick_prepare_packed(vq))) {
+			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
+			PMD_RX_LOG(DEBUG, "Notified");
+		}
+	}
+
+	return nb_rx;
+}
+
+/*
+ * Kick the backend for the packets of a burst. With the tx_kick_batch
+ * devarg, the kick is deferred until that many packets are pending, or
+ * until a burst comes tx_kick_delay after the first pending one. An empty
+ * burst, or one that cannot enqueue anything, flushes the deferred kick.
+ * The avail index is updated by each burst, so a polling backend does
+ * not wait for the kick.
+ */
+static __rte_always_inline void
+virtio_xmit_kick(struct virtnet_tx *txvq, uint16_t nb_tx, int packed)
+{
+	struct virtqueue *vq = txvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	uint64_t now;
+
+	if (likely(hw->tx_kick_batch == 0)) {
+		if (nb_tx == 0)
+			return;
+	} else if (nb_tx == 0 || unlikely(hw->inject_pkts != NULL)) {
+		if (nb_tx == 0 && txvq->kick_pending == 0)
+			return;
+		txvq->kick_pending = 0;
+	} else {
+		now = rte_rdtsc();
+		if (txvq->kick_pending == 0)
+			txvq->kick_tsc = now;
+		txvq->kick_pending += nb_tx;
+		if (txvq->kick_pending < hw->tx_kick_batch &&
+				(hw->tx_kick_delay == 0 ||
+				 now - txvq->kick_tsc < hw->tx_kick_delay))
+			return;
+		txvq->kick_pending = 0;
+	}
+
+	if (unlikely(packed ? virtqueue_kick_prepare_packed(vq) :
+			virtqueue_kick_prepare(vq))) {
+		virtqueue_notify(vq);
+		txvq->stats.kicks++;
+		PMD_TX_LOG(DEBUG, "Notified backend after xmit");
+	}
+}
+
+uint16_t
+virtio_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+{
+	struct virtnet_tx *txvq = tx_queue;
+	struct virtqueue *vq = txvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	uint16_t hdr_size = hw->vtnet_hdr_size;
+	uint16_t nb_used, nb_tx = 0, nb_indirect = 0;
+	int error;
+
+	if (unlikely(hw->started == 0 && tx_pkts != hw->inject_pkts))
+		return nb_tx;
+
+	if (unlikely(nb_pkts < 1)) {
+		virtio_xmit_kick(txvq, 0, 0);
+		return nb_pkts;
+	}
+
+	PMD_TX_LOG(DEBUG, "%d packets to xmit", nb_pkts);
+	nb_used = VIRTQUEUE_NUSED(vq);
+
+	virtio_rmb();
+	if (likely(nb_used > vq->vq_nentries - vq->vq_free_thresh))
+		virtio_xmit_cleanup(vq, nb_used);
+
+	txvq->stats.bursts++;
+	txvq->stats.free_desc += vq->vq_free_cnt;
+
+	for (nb_tx = 0; nb_tx < nb_pkts; nb_tx++) {
+		struct rte_mbuf *txm = tx_pkts[nb_tx];
+		int can_push = 0, use_indirect = 0, slots, need;
+
+		/* Do VLAN tag insertion */
+		if (unlikely(txm->ol_flags & PKT_TX_VLAN_PKT)) {
+			error = rte_vlan_insert(&txm);
+			if (unlikely(error)) {
+				rte_pktmbuf_free(txm);
+				continue;
+			}
+		}
+
+		/* optimize ring usage */
+		if ((vtpci_with_feature(hw, VIRTIO_F_ANY_LAYOUT) ||
+		      vtpci_with_feature(hw, VIRTIO_F_VERSION_1)) &&
+		    rte_mbuf_refcnt_read(txm) == 1 &&
+		    RTE_MBUF_DIRECT(txm) &&
+		    txm->nb_segs == 1 &&
+		    rte_pktmbuf_headroom(txm) >= hdr_size &&
 		    rte_is_aligned(rte_pktmbuf_mtod(txm, char *),
 				   __alignof__(struct virtio_net_hdr_mrg_rxbuf)))
 			can_push = 1;
@@ -1422,28 +2170,33 @@ virtio_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
 		/* Enqueue Packet buffers */
 		virtqueue_enqueue_xmit(txvq, txm, slots, use_indirect,
 			can_push, 0);
+		nb_indirect += use_indirect;
 
 		virtio_update_packet_stats(&txvq->stats, txm);
 	}
 
 	txvq->stats.packets += nb_tx;
+	txvq->stats.indirect += nb_indirect;
+	txvq->stats.direct += nb_tx - nb_indirect;
+	if (unlikely(nb_tx < nb_pkts))
+		txvq->stats.ring_full++;
 
-	if (likely(nb_tx)) {
+	if (likely(nb_tx))
 		vq_update_avail_idx(vq);
 
-		if (unlikely(virtqueue_kick_prepare(vq))) {
-			virtqueue_notify(vq);
-			PMD_TX_LOG(DEBUG, "Notified backend after xmit");
-		}
-	}
+	virtio_xmit_kick(txvq, nb_tx, 0);
 
 	return nb_tx;
 }
 
-uint16_t
-virtio_xmit_pkts_inorder(void *tx_queue,
+/*
+ * vec: the packets with room for the header are enqueued by the AVX2
+ * version, which has no Tx offloads.
+ */
+static __rte_always_inline uint16_t
+virtio_xmit_pkts_inorder_common(void *tx_queue,
 			struct rte_mbuf **tx_pkts,
-			uint16_t nb_pkts)
+			uint16_t nb_pkts, int vec)
 {
 	struct virtnet_tx *txvq = tx_queue;
 	struct virtqueue *vq = txvq->vq;
@@ -1456,8 +2209,10 @@ virtio_xmit_pkts_inorder(void *tx_queue,
 	if (unlikely(hw->started == 0 && tx_pkts != hw->inject_pkts))
 		return nb_tx;
 
-	if (unlikely(nb_pkts < 1))
+	if (unlikely(nb_pkts < 1)) {
+		virtio_xmit_kick(txvq, 0, 0);
 		return nb_pkts;
+	}
 
 	VIRTQUEUE_DUMP(vq);
 	PMD_TX_LOG(DEBUG, "%d packets to xmit", nb_pkts);
@@ -1470,6 +2225,9 @@ virtio_xmit_pkts_inorder(void *tx_queue,
 	if (unlikely(!vq->vq_free_cnt))
 		virtio_xmit_cleanup_inorder(vq, nb_used);
 
+	txvq->stats.bursts++;
+	txvq->stats.free_desc += vq->vq_free_cnt;
+
 	nb_avail = RTE_MIN(vq->vq_free_cnt, nb_pkts);
 
 	for (nb_tx = 0; nb_tx < nb_avail; nb_tx++) {
@@ -1502,8 +2260,8 @@ virtio_xmit_pkts_inorder(void *tx_queue,
 		}
 
 		if (nb_inorder_pkts) {
-			virtqueue_enqueue_xmit_inorder(txvq, inorder_pkts,
-							nb_inorder_pkts);
+			virtqueue_enqueue_xmit_inorder_burst(txvq,
+					inorder_pkts, nb_inorder_pkts, vec);
 			nb_inorder_pkts = 0;
 		}
 
@@ -1532,21 +2290,132 @@ virtio_xmit_pkts_inorder(void *tx_queue,
 
 	/* Transmit all inorder packets */
 	if (nb_inorder_pkts)
-		virtqueue_enqueue_xmit_inorder(txvq, inorder_pkts,
-						nb_inorder_pkts);
+		virtqueue_enqueue_xmit_inorder_burst(txvq, inorder_pkts,
+						nb_inorder_pkts, vec);
 
 	txvq->stats.packets += nb_tx;
+	txvq->stats.direct += nb_tx;
+	if (unlikely(nb_tx < nb_pkts))
+		txvq->stats.ring_full++;
 
-	if (likely(nb_tx)) {
+	if (likely(nb_tx))
 		vq_update_avail_idx(vq);
 
-		if (unlikely(virtqueue_kick_prepare(vq))) {
-			virtqueue_notify(vq);
-			PMD_TX_LOG(DEBUG, "Notified backend after xmit");
+	virtio_xmit_kick(txvq, nb_tx, 0);
+
+	VIRTQUEUE_DUMP(vq);
+
+	return nb_tx;
+}
+
+uint16_t
+virtio_xmit_pkts_packed(void *tx_queue, struct rte_mbuf **tx_pkts,
+			uint16_t nb_pkts)
+{
+	struct virtnet_tx *txvq = tx_queue;
+	struct virtqueue *vq = txvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	uint16_t hdr_size = hw->vtnet_hdr_size;
+	uint16_t nb_tx = 0, nb_indirect = 0;
+	int in_order = hw->use_inorder_tx;
+	int error;
+
+	if (unlikely(hw->started == 0 && tx_pkts != hw->inject_pkts))
+		return nb_tx;
+
+	if (unlikely(nb_pkts < 1)) {
+		virtio_xmit_kick(txvq, 0, 1);
+		return nb_pkts;
+	}
+
+	PMD_TX_LOG(DEBUG, "%d packets to xmit", nb_pkts);
+
+	if (likely(vq->vq_free_cnt <= vq->vq_free_thresh))
+		virtio_xmit_cleanup_packed(vq,
+			vq->vq_nentries - vq->vq_free_cnt, in_order);
+
+	txvq->stats.bursts++;
+	txvq->stats.free_desc += vq->vq_free_cnt;
+
+	for (nb_tx = 0; nb_tx < nb_pkts; nb_tx++) {
+		struct rte_mbuf *txm = tx_pkts[nb_tx];
+		int can_push = 0, use_indirect = 0, slots, need;
+
+		/* Do VLAN tag insertion */
+		if (unlikely(txm->ol_flags & PKT_TX_VLAN_PKT)) {
+			error = rte_vlan_insert(&txm);
+			if (unlikely(error)) {
+				rte_pktmbuf_free(txm);
+				continue;
+			}
+		}
+
+		/* optimize ring usage */
+		if ((vtpci_with_feature(hw, VIRTIO_F_ANY_LAYOUT) ||
+		      vtpci_with_feature(hw, VIRTIO_F_VERSION_1)) &&
+		    rte_mbuf_refcnt_read(txm) == 1 &&
+		    RTE_MBUF_DIRECT(txm) &&
+		    txm->nb_segs == 1 &&
+		    rte_pktmbuf_headroom(txm) >= hdr_size &&
+		    rte_is_aligned(rte_pktmbuf_mtod(txm, char *),
+				   __alignof__(struct virtio_net_hdr_mrg_rxbuf)))
+			can_push = 1;
+		else if (vtpci_with_feature(hw, VIRTIO_RING_F_INDIRECT_DESC) &&
+			 txm->nb_segs < VIRTIO_MAX_TX_INDIRECT)
+			use_indirect = 1;
+
+		/* How many main ring entries are needed to this Tx?
+		 * any_layout => number of segments
+		 * indirect   => 1
+		 * default    => number of segments + 1
+		 */
+		slots = use_indirect ? 1 : (txm->nb_segs + !can_push);
+		need = slots - vq->vq_free_cnt;
+
+		/* Positive value indicates it need free vring descriptors */
+		if (unlikely(need > 0)) {
+			virtio_xmit_cleanup_packed(vq, need, in_order);
+			need = slots - vq->vq_free_cnt;
+			if (unlikely(need > 0)) {
+				PMD_TX_LOG(ERR,
+					   "No free tx descriptors to transmit");
+				break;
+			}
 		}
+
+		/* Enqueue Packet buffers */
+		virtqueue_enqueue_xmit_packed(txvq, txm, slots, use_indirect,
+			can_push, in_order);
+		nb_indirect += use_indirect;
+
+		virtio_update_packet_stats(&txvq->stats, txm);
 	}
 
-	VIRTQUEUE_DUMP(vq);
+	txvq->stats.packets += nb_tx;
+	txvq->stats.indirect += nb_indirect;
+	txvq->stats.direct += nb_tx - nb_indirect;
+	if (unlikely(nb_tx < nb_pkts))
+		txvq->stats.ring_full++;
+
+	virtio_xmit_kick(txvq, nb_tx, 1);
 
 	return nb_tx;
 }
+
+uint16_t
+virtio_xmit_pkts_inorder(void *tx_queue,
+			struct rte_mbuf **tx_pkts,
+			uint16_t nb_pkts)
+{
+	return virtio_xmit_pkts_inorder_common(tx_queue, tx_pkts, nb_pkts, 0);
+}
+
+#ifdef CC_AVX2_SUPPORT
+uint16_t
+virtio_xmit_pkts_inorder_avx2(void *tx_queue,
+			struct rte_mbuf **tx_pkts,
+			uint16_t nb_pkts)
+{
+	return virtio_xmit_pkts_inorder_common(tx_queue, tx_pkts, nb_pkts, 1);
+}
+#endif
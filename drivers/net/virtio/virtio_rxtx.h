@@ -15,6 +15,14 @@ struct virtnet_stats {
 	uint64_t	broadcast;
 	/* Size bins in array as RFC 2819, undersized [0], 64 [1], etc */
 	uint64_t	size_bins[8];
+	uint64_t	kicks;		/**< notifications of the device */
+	uint64_t	ring_full;	/**< Tx bursts cut short by a full ring */
+	uint64_t	refill_failed;	/**< Rx refills without mbufs */
+	uint64_t	bursts;		/**< Tx bursts with packets */
+	uint64_t	free_desc;	/**< free Tx descriptors of the bursts */
+	uint64_t	indirect;	/**< packets sent with an indirect table */
+	uint64_t	direct;		/**< packets sent in the main ring */
+	uint64_t	intr_enable;	/**< Rx interrupts enabled */
 };
 
 struct virtnet_rx {
@@ -45,6 +53,9 @@ struct virtnet_tx {
 	/* Statistics */
 	struct virtnet_stats stats;
 
+	uint32_t    kick_pending;        /**< packets of the deferred kick */
+	uint64_t    kick_tsc;            /**< TSC of the first of them */
+
 	const struct rte_memzone *mz;    /**< mem zone to populate TX ring. */
 };
 
@@ -56,6 +67,9 @@ struct virtnet_ctl {
 	uint16_t port_id;               /**< Device port identifier. */
 	const struct rte_memzone *mz;   /**< mem zone to populate CTL ring. */
 	rte_spinlock_t lock;              /**< spinlock for control queue. */
+	uint32_t free_slots;    /**< bitmap of the free command slots */
+	uint32_t async_slots;   /**< commands nobody waits for */
+	uint16_t nb_pending;    /**< commands posted and not acked yet */
 };
 
 int virtio_rxq_vec_setup(struct virtnet_rx *rxvq);
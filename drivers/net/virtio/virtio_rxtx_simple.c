@@ -55,3 +55,12 @@ virtio_recv_pkts_vec(void *rx_queue __rte_unused,
 	rte_panic("Wrong weak function linked by linker\n");
 	return 0;
 }
+
+/* No vector in-order Rx: the whole burst goes to the scalar path */
+__rte_weak uint16_t
+virtio_rxq_recv_mrg_inorder_vec(struct virtnet_rx *rxvq __rte_unused,
+		struct rte_mbuf **rx_pkts __rte_unused,
+		uint16_t nb_pkts __rte_unused)
+{
+	return 0;
+}
@@ -15,6 +15,11 @@
 #define RTE_VIRTIO_VPMD_RX_BURST 32
 #define RTE_VIRTIO_VPMD_RX_REARM_THRESH RTE_VIRTIO_VPMD_RX_BURST
 
+uint16_t virtio_rxq_recv_mrg_inorder_vec(struct virtnet_rx *rxvq,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts);
+void virtqueue_enqueue_xmit_inorder_avx2(struct virtnet_tx *txvq,
+		struct rte_mbuf **cookies, uint16_t num);
+
 static inline void
 virtio_rxq_rearm_vec(struct virtnet_rx *rxvq)
 {
@@ -34,6 +39,7 @@ virtio_rxq_rearm_vec(struct virtnet_rx *rxvq)
 	if (unlikely(ret)) {
 		rte_eth_devices[rxvq->port_id].data->rx_mbuf_alloc_failed +=
 			RTE_VIRTIO_VPMD_RX_REARM_THRESH;
+		rxvq->stats.refill_failed++;
 		return;
 	}
 
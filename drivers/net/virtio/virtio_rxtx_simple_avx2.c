@@ -0,0 +1,246 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2018 Intel Corporation
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <immintrin.h>
+
+#include <rte_byteorder.h>
+#include <rte_branch_prediction.h>
+#include <rte_cycles.h>
+#include <rte_ether.h>
+#include <rte_ethdev_driver.h>
+#include <rte_errno.h>
+#include <rte_memory.h>
+#include <rte_mempool.h>
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+#include <rte_prefetch.h>
+#include <rte_string_fns.h>
+
+#include "virtio_rxtx_simple.h"
+
+#define RTE_VIRTIO_DESC_PER_LOOP 8
+
+/* Store the Rx descriptor fields of the packets in the two lanes. */
+static __rte_always_inline void
+virtio_rx_store_fields(struct rte_mbuf *mb_lo, struct rte_mbuf *mb_hi,
+		__m256i fields)
+{
+	_mm_storeu_si128((void *)&mb_lo->rx_descriptor_fields1,
+		_mm256_castsi256_si128(fields));
+	_mm_storeu_si128((void *)&mb_hi->rx_descriptor_fields1,
+		_mm256_extracti128_si256(fields, 1));
+}
+
+/* virtio vPMD receive routine, only accept(nb_pkts >= RTE_VIRTIO_DESC_PER_LOOP)
+ *
+ * Same as virtio_recv_pkts_vec(), with the 8 used elements and mbuf
+ * pointers of a loop read in 256-bit loads. The rearm through
+ * virtio_rxq_rearm_vec() is built for AVX2 here as well.
+ *
+ * - nb_pkts < RTE_VIRTIO_DESC_PER_LOOP, just return no packet
+ */
+uint16_t
+virtio_recv_pkts_vec_avx2(void *rx_queue, struct rte_mbuf **rx_pkts,
+	uint16_t nb_pkts)
+{
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtqueue *vq = rxvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	uint16_t nb_used;
+	uint16_t desc_idx;
+	struct vring_used_elem *rused;
+	struct rte_mbuf **sw_ring;
+	struct rte_mbuf **sw_ring_end;
+	uint16_t nb_pkts_received = 0;
+	__m128i msk;
+	__m256i shuf_msk1, shuf_msk2, len_adjust;
+
+	/* the shuffles work per 128-bit lane, i.e. per two used elements */
+	msk = _mm_set_epi8(
+		0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF,		/* vlan tci */
+		5, 4,			/* dat len */
+		0xFF, 0xFF, 5, 4,	/* pkt len */
+		0xFF, 0xFF, 0xFF, 0xFF	/* packet type */
+	);
+	shuf_msk1 = _mm256_inserti128_si256(_mm256_castsi128_si256(msk),
+		msk, 1);
+
+	msk = _mm_set_epi8(
+		0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF,		/* vlan tci */
+		13, 12,			/* dat len */
+		0xFF, 0xFF, 13, 12,	/* pkt len */
+		0xFF, 0xFF, 0xFF, 0xFF	/* packet type */
+	);
+	shuf_msk2 = _mm256_inserti128_si256(_mm256_castsi128_si256(msk),
+		msk, 1);
+
+	/* Subtract the header length. */
+	len_adjust = _mm256_set_epi16(
+		0, 0,
+		0,
+		(uint16_t)-vq->hw->vtnet_hdr_size,
+		0, (uint16_t)-vq->hw->vtnet_hdr_size,
+		0, 0,
+		0, 0,
+		0,
+		(uint16_t)-vq->hw->vtnet_hdr_size,
+		0, (uint16_t)-vq->hw->vtnet_hdr_size,
+		0, 0);
+
+	if (unlikely(hw->started == 0))
+		return nb_pkts_received;
+
+	if (unlikely(nb_pkts < RTE_VIRTIO_DESC_PER_LOOP))
+		return 0;
+
+	nb_used = VIRTQUEUE_NUSED(vq);
+
+	rte_compiler_barrier();
+
+	if (unlikely(nb_used == 0))
+		return 0;
+
+	nb_pkts = RTE_ALIGN_FLOOR(nb_pkts, RTE_VIRTIO_DESC_PER_LOOP);
+	nb_used = RTE_MIN(nb_used, nb_pkts);
+
+	desc_idx = (uint16_t)(vq->vq_used_cons_idx & (vq->vq_nentries - 1));
+	rused = &vq->vq_ring.used->ring[desc_idx];
+	sw_ring  = &vq->sw_ring[desc_idx];
+	sw_ring_end = &vq->sw_ring[vq->vq_nentries];
+
+	rte_prefetch0(rused);
+
+	if (vq->vq_free_cnt >= RTE_VIRTIO_VPMD_RX_REARM_THRESH) {
+		virtio_rxq_rearm_vec(rxvq);
+		if (unlikely(virtqueue_kick_prepare(vq))) {
+			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
+		}
+	}
+
+	for (nb_pkts_received = 0;
+		nb_pkts_received < nb_used;) {
+		__m256i desc[RTE_VIRTIO_DESC_PER_LOOP / 4];
+		__m256i mbp[RTE_VIRTIO_DESC_PER_LOOP / 4];
+		__m256i pkt_mb[RTE_VIRTIO_DESC_PER_LOOP / 2];
+
+		mbp[0] = _mm256_loadu_si256((void *)(sw_ring + 0));
+		desc[0] = _mm256_loadu_si256((void *)(rused + 0));
+		_mm256_storeu_si256((void *)&rx_pkts[0], mbp[0]);
+
+		mbp[1] = _mm256_loadu_si256((void *)(sw_ring + 4));
+		desc[1] = _mm256_loadu_si256((void *)(rused + 4));
+		_mm256_storeu_si256((void *)&rx_pkts[4], mbp[1]);
+
+		/* lanes of pkt_mb[0]: packets 0 and 2, pkt_mb[1]: 1 and 3 */
+		pkt_mb[0] = _mm256_shuffle_epi8(desc[0], shuf_msk1);
+		pkt_mb[1] = _mm256_shuffle_epi8(desc[0], shuf_msk2);
+		pkt_mb[0] = _mm256_add_epi16(pkt_mb[0], len_adjust);
+		pkt_mb[1] = _mm256_add_epi16(pkt_mb[1], len_adjust);
+		virtio_rx_store_fields(rx_pkts[0], rx_pkts[2], pkt_mb[0]);
+		virtio_rx_store_fields(rx_pkts[1], rx_pkts[3], pkt_mb[1]);
+
+		pkt_mb[2] = _mm256_shuffle_epi8(desc[1], shuf_msk1);
+		pkt_mb[3] = _mm256_shuffle_epi8(desc[1], shuf_msk2);
+		pkt_mb[2] = _mm256_add_epi16(pkt_mb[2], len_adjust);
+		pkt_mb[3] = _mm256_add_epi16(pkt_mb[3], len_adjust);
+		virtio_rx_store_fields(rx_pkts[4], rx_pkts[6], pkt_mb[2]);
+		virtio_rx_store_fields(rx_pkts[5], rx_pkts[7], pkt_mb[3]);
+
+		if (unlikely(nb_used <= RTE_VIRTIO_DESC_PER_LOOP)) {
+			if (sw_ring + nb_used <= sw_ring_end)
+				nb_pkts_received += nb_used;
+			else
+				nb_pkts_received += sw_ring_end - sw_ring;
+			break;
+		} else {
+			if (unlikely(sw_ring + RTE_VIRTIO_DESC_PER_LOOP >=
+				sw_ring_end)) {
+				nb_pkts_received += sw_ring_end - sw_ring;
+				break;
+			} else {
+				nb_pkts_received += RTE_VIRTIO_DESC_PER_LOOP;
+
+				rx_pkts += RTE_VIRTIO_DESC_PER_LOOP;
+				sw_ring += RTE_VIRTIO_DESC_PER_LOOP;
+				rused   += RTE_VIRTIO_DESC_PER_LOOP;
+				nb_used -= RTE_VIRTIO_DESC_PER_LOOP;
+			}
+		}
+	}
+
+	vq->vq_used_cons_idx += nb_pkts_received;
+	vq->vq_free_cnt += nb_pkts_received;
+	rxvq->stats.packets += nb_pkts_received;
+	return nb_pkts_received;
+}
+
+/*
+ * In-order enqueue of single segment packets with room for the header,
+ * without Tx offloads.
+ * In order the descriptors stay chained to the next slot, so two of them
+ * are written in one 256-bit store, flags and next included.
+ */
+void
+virtqueue_enqueue_xmit_inorder_avx2(struct virtnet_tx *txvq,
+			struct rte_mbuf **cookies,
+			uint16_t num)
+{
+	struct virtqueue *vq = txvq->vq;
+	struct vring_desc *start_dp = vq->vq_ring.desc;
+	uint16_t head_size = vq->hw->vtnet_hdr_size;
+	uint16_t mask = vq->vq_nentries - 1;
+	uint16_t idx = vq->vq_desc_head_idx;
+	struct vq_desc_extra *dxp;
+	struct virtio_net_hdr *hdr;
+	uint16_t i, slot;
+	__m256i descs;
+
+	for (i = 0; i < num; i++) {
+		slot = (idx + i) & mask;
+		dxp = &vq->vq_descx[slot];
+		dxp->cookie = (void *)cookies[i];
+		dxp->ndescs = 1;
+
+		hdr = (struct virtio_net_hdr *)
+			rte_pktmbuf_prepend(cookies[i], head_size);
+		cookies[i]->pkt_len -= head_size;
+		memset(hdr, 0, sizeof(*hdr));
+
+		vq_update_avail_ring(vq, slot);
+	}
+
+	i = 0;
+	while (i < num) {
+		slot = (idx + i) & mask;
+		if (likely(i + 1 < num && slot != mask)) {
+			descs = _mm256_set_epi64x(
+				(int64_t)((uint64_t)((slot + 2) & mask) << 48 |
+					  cookies[i + 1]->data_len),
+				VIRTIO_MBUF_DATA_DMA_ADDR(cookies[i + 1], vq),
+				(int64_t)((uint64_t)(slot + 1) << 48 |
+					  cookies[i]->data_len),
+				VIRTIO_MBUF_DATA_DMA_ADDR(cookies[i], vq));
+			_mm256_storeu_si256((void *)&start_dp[slot], descs);
+			i += 2;
+		} else {
+			start_dp[slot].addr =
+				VIRTIO_MBUF_DATA_DMA_ADDR(cookies[i], vq);
+			start_dp[slot].len = cookies[i]->data_len;
+			start_dp[slot].flags = 0;
+			i++;
+		}
+	}
+
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt - num);
+	vq->vq_desc_head_idx = (idx + num) & mask;
+}
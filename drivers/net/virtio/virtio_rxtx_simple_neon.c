@@ -101,8 +101,10 @@ virtio_recv_pkts_vec(void *rx_queue, struct rte_mbuf **rx_pkts,
 
 	if (vq->vq_free_cnt >= RTE_VIRTIO_VPMD_RX_REARM_THRESH) {
 		virtio_rxq_rearm_vec(rxvq);
-		if (unlikely(virtqueue_kick_prepare(vq)))
+		if (unlikely(virtqueue_kick_prepare(vq))) {
 			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
+		}
 	}
 
 	for (nb_pkts_received = 0;
@@ -103,8 +103,10 @@ virtio_recv_pkts_vec(void *rx_queue, struct rte_mbuf **rx_pkts,
 
 	if (vq->vq_free_cnt >= RTE_VIRTIO_VPMD_RX_REARM_THRESH) {
 		virtio_rxq_rearm_vec(rxvq);
-		if (unlikely(virtqueue_kick_prepare(vq)))
+		if (unlikely(virtqueue_kick_prepare(vq))) {
 			virtqueue_notify(vq);
+			rxvq->stats.kicks++;
+		}
 	}
 
 	for (nb_pkts_received = 0;
@@ -192,3 +194,129 @@ virtio_recv_pkts_vec(void *rx_queue, struct rte_mbuf **rx_pkts,
 	rxvq->stats.packets += nb_pkts_received;
 	return nb_pkts_received;
 }
+
+/*
+ * Vector part of the in-order mergeable Rx: dequeue the used elements
+ * eight at a time while all the packets of a group fit in one buffer.
+ * In order the used and the descriptor indexes are the same, so the mbufs
+ * are taken from vq_descx. The group with a multi-buffer or a short packet
+ * is left to the caller for virtio_recv_mergeable_pkts_inorder(), as well
+ * as the refill of the ring.
+ */
+uint16_t
+virtio_rxq_recv_mrg_inorder_vec(struct virtnet_rx *rxvq,
+	struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
+{
+	struct virtqueue *vq = rxvq->vq;
+	uint16_t hdr_size = vq->hw->vtnet_hdr_size;
+	struct virtio_net_hdr_mrg_rxbuf *hdr;
+	struct vring_used_elem *rused;
+	struct vq_desc_extra *dxp;
+	uint16_t nb_used, used_idx, nb_rx, i;
+	__m128i shuf_msk1, shuf_msk2, len_adjust, min_len, rearm;
+
+	/* rearm_data and ol_flags are set in one 128-bit store */
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, ol_flags) !=
+		offsetof(struct rte_mbuf, rearm_data) + 8);
+
+	shuf_msk1 = _mm_set_epi8(
+		0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF,		/* vlan tci */
+		5, 4,			/* dat len */
+		0xFF, 0xFF, 5, 4,	/* pkt len */
+		0xFF, 0xFF, 0xFF, 0xFF	/* packet type */
+	);
+
+	shuf_msk2 = _mm_set_epi8(
+		0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF,		/* vlan tci */
+		13, 12,			/* dat len */
+		0xFF, 0xFF, 13, 12,	/* pkt len */
+		0xFF, 0xFF, 0xFF, 0xFF	/* packet type */
+	);
+
+	len_adjust = _mm_set_epi16(
+		0, 0,
+		0,
+		(uint16_t)-hdr_size,
+		0, (uint16_t)-hdr_size,
+		0, 0);
+
+	min_len = _mm_set1_epi32(hdr_size + ETHER_HDR_LEN);
+	rearm = _mm_set_epi64x(0, rxvq->mbuf_initializer);
+
+	nb_used = VIRTQUEUE_NUSED(vq);
+
+	virtio_rmb();
+
+	/* a group does not wrap around the ring */
+	used_idx = vq->vq_used_cons_idx & (vq->vq_nentries - 1);
+	nb_used = RTE_MIN(nb_used, nb_pkts);
+	nb_used = RTE_MIN(nb_used, vq->vq_nentries - used_idx);
+	nb_used = RTE_ALIGN_FLOOR(nb_used, RTE_VIRTIO_DESC_PER_LOOP);
+
+	for (nb_rx = 0; nb_rx < nb_used; nb_rx += RTE_VIRTIO_DESC_PER_LOOP) {
+		__m128i desc[RTE_VIRTIO_DESC_PER_LOOP / 2];
+		__m128i lens[RTE_VIRTIO_DESC_PER_LOOP / 4];
+		__m128i pkt_mb;
+		struct rte_mbuf *mb[RTE_VIRTIO_DESC_PER_LOOP];
+
+		rused = &vq->vq_ring.used->ring[used_idx];
+		dxp = &vq->vq_descx[used_idx];
+
+		for (i = 0; i < RTE_VIRTIO_DESC_PER_LOOP / 2; i++)
+			desc[i] = _mm_loadu_si128((void *)(rused + 2 * i));
+
+		/* the len of the used elements, four per register */
+		for (i = 0; i < RTE_VIRTIO_DESC_PER_LOOP / 4; i++)
+			lens[i] = _mm_castps_si128(_mm_shuffle_ps(
+				_mm_castsi128_ps(desc[2 * i]),
+				_mm_castsi128_ps(desc[2 * i + 1]),
+				_MM_SHUFFLE(3, 1, 3, 1)));
+		if (_mm_movemask_epi8(_mm_or_si128(
+				_mm_cmplt_epi32(lens[0], min_len),
+				_mm_cmplt_epi32(lens[1], min_len))))
+			break;
+
+		for (i = 0; i < RTE_VIRTIO_DESC_PER_LOOP; i++) {
+			mb[i] = dxp[i].cookie;
+			if (unlikely(mb[i] == NULL))
+				break;
+			hdr = (struct virtio_net_hdr_mrg_rxbuf *)
+				((char *)mb[i]->buf_addr +
+				 RTE_PKTMBUF_HEADROOM - hdr_size);
+			if (hdr->num_buffers > 1)
+				break;
+		}
+		if (i < RTE_VIRTIO_DESC_PER_LOOP)
+			break;
+
+		for (i = 0; i < RTE_VIRTIO_DESC_PER_LOOP; i += 2) {
+			pkt_mb = _mm_shuffle_epi8(desc[i / 2], shuf_msk1);
+			pkt_mb = _mm_add_epi16(pkt_mb, len_adjust);
+			_mm_storeu_si128((void *)&mb[i]->rx_descriptor_fields1,
+				pkt_mb);
+
+			pkt_mb = _mm_shuffle_epi8(desc[i / 2], shuf_msk2);
+			pkt_mb = _mm_add_epi16(pkt_mb, len_adjust);
+			_mm_storeu_si128(
+				(void *)&mb[i + 1]->rx_descriptor_fields1,
+				pkt_mb);
+		}
+
+		for (i = 0; i < RTE_VIRTIO_DESC_PER_LOOP; i++) {
+			_mm_storeu_si128((void *)&mb[i]->rearm_data, rearm);
+			rx_pkts[nb_rx + i] = mb[i];
+			dxp[i].cookie = NULL;
+		}
+
+		used_idx += RTE_VIRTIO_DESC_PER_LOOP;
+	}
+
+	if (nb_rx) {
+		vq->vq_used_cons_idx += nb_rx;
+		vq_ring_free_inorder(vq, vq->vq_used_cons_idx - 1, nb_rx);
+	}
+
+	return nb_rx;
+}
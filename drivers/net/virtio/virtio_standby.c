@@ -0,0 +1,527 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include <rte_alarm.h>
+#include <rte_common.h>
+#include <rte_dev.h>
+#include <rte_ether.h>
+#include <rte_ethdev_driver.h>
+#include <rte_spinlock.h>
+#include <rte_string_fns.h>
+
+#include "virtio_ethdev.h"
+#include "virtio_pci.h"
+#include "virtio_logs.h"
+#include "virtqueue.h"
+#include "virtio_rxtx.h"
+
+/*
+ * With VIRTIO_NET_F_STANDBY, the host provides a primary device, usually
+ * an SR-IOV VF, with the MAC address of the virtio device, and unplugs it
+ * before a live migration. While it is present, the virtio port sends and
+ * receives over the primary device, falling back to the virtio queues when
+ * it is removed.
+ */
+
+/* Time for the bursts in flight to leave a removed primary device, in us */
+#define VIRTIO_STANDBY_DETACH_DELAY	100000
+
+/* Check whether a port is the primary device of a standby virtio port */
+static bool
+virtio_standby_match(const struct rte_eth_dev *dev, uint16_t port_id)
+{
+	const struct rte_eth_dev *vf_dev = &rte_eth_devices[port_id];
+
+	if (vf_dev == dev || vf_dev->device == NULL ||
+	    vf_dev->device->driver == dev->device->driver)
+		return false;
+
+	return is_same_ether_addr(dev->data->mac_addrs,
+				  vf_dev->data->mac_addrs);
+}
+
+static int
+virtio_standby_rmv_event(uint16_t port_id, enum rte_eth_event_type event,
+			 void *cb_arg, void *out);
+
+static int
+_virtio_standby_configure(struct rte_eth_dev *dev,
+			  struct rte_eth_dev *vf_dev)
+{
+	struct rte_eth_conf vf_conf = dev->data->dev_conf;
+	uint16_t vf_port = vf_dev->data->port_id;
+	int ret;
+
+	/* The link state reported is the one of the virtio device */
+	vf_conf.intr_conf.lsc = 0;
+	vf_conf.intr_conf.rxq = 0;
+	vf_conf.intr_conf.rmv =
+		!!(vf_dev->data->dev_flags & RTE_ETH_DEV_INTR_RMV);
+
+	ret = rte_eth_dev_configure(vf_port,
+				    dev->data->nb_rx_queues,
+				    dev->data->nb_tx_queues,
+				    &vf_conf);
+	if (ret)
+		PMD_DRV_LOG(ERR, "primary port %u configuration failed: %d",
+			    vf_port, ret);
+	return ret;
+}
+
+/*
+ * Bring a primary device plugged after the virtio port was configured
+ * to the state of the port.
+ */
+static int
+virtio_standby_replay(struct rte_eth_dev *dev, struct rte_eth_dev *vf_dev)
+{
+	uint16_t vf_port = vf_dev->data->port_id;
+	struct virtnet_rx *rxvq;
+	uint16_t i;
+	int ret;
+
+	ret = _virtio_standby_configure(dev, vf_dev);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		rxvq = dev->data->rx_queues[i];
+		if (rxvq == NULL)
+			continue;
+		ret = rte_eth_rx_queue_setup(vf_port, i, 0,
+					     dev->data->numa_node, NULL,
+					     rxvq->mpool);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < dev->data->nb_tx_queues; i++) {
+		if (dev->data->tx_queues[i] == NULL)
+			continue;
+		ret = rte_eth_tx_queue_setup(vf_port, i, 0,
+					     dev->data->numa_node, NULL);
+		if (ret)
+			return ret;
+	}
+
+	if (dev->data->dev_started)
+		return rte_eth_dev_start(vf_port);
+	return 0;
+}
+
+/* Take the primary device and switch the datapath to it */
+static int
+virtio_standby_attach(struct rte_eth_dev *dev, uint16_t port_id)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev_owner owner = { .id = RTE_ETH_DEV_NO_OWNER };
+	struct rte_eth_dev *vf_dev = &rte_eth_devices[port_id];
+	int ret;
+
+	ret = rte_eth_dev_owner_get(port_id, &owner);
+	if (ret < 0) {
+		PMD_DRV_LOG(ERR, "Can not find owner for port %u", port_id);
+		return ret;
+	}
+
+	if (owner.id != RTE_ETH_DEV_NO_OWNER) {
+		PMD_DRV_LOG(ERR, "Port %u already owned by other device %s",
+			    port_id, owner.name);
+		return -EBUSY;
+	}
+
+	ret = rte_eth_dev_owner_set(port_id, &hw->owner);
+	if (ret < 0) {
+		PMD_DRV_LOG(ERR, "Can not set owner for port %u", port_id);
+		return ret;
+	}
+
+	ret = rte_eth_dev_callback_register(port_id, RTE_ETH_EVENT_INTR_RMV,
+					    virtio_standby_rmv_event, dev);
+	if (ret)
+		goto unset_owner;
+
+	if (dev->data->nb_rx_queues > 0 || dev->data->nb_tx_queues > 0) {
+		ret = virtio_standby_replay(dev, vf_dev);
+		if (ret)
+			goto unregister;
+	}
+
+	/* Only expose the primary device to the datapath once it is ready */
+	rte_smp_wmb();
+	hw->vf_dev = vf_dev;
+
+	PMD_DRV_LOG(INFO, "port %u: datapath switched to primary port %u",
+		    dev->data->port_id, port_id);
+	return 0;
+
+unregister:
+	rte_eth_dev_callback_unregister(port_id, RTE_ETH_EVENT_INTR_RMV,
+					virtio_standby_rmv_event, dev);
+unset_owner:
+	rte_eth_dev_owner_unset(port_id, hw->owner.id);
+	return ret;
+}
+
+static int
+virtio_standby_add(struct rte_eth_dev *dev, uint16_t port_id)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	int ret;
+
+	rte_spinlock_lock(&hw->vf_lock);
+	if (hw->vf_dev) {
+		PMD_DRV_LOG(ERR, "port %u: primary device already attached",
+			    dev->data->port_id);
+		ret = -EBUSY;
+	} else {
+		ret = virtio_standby_attach(dev, port_id);
+	}
+	rte_spinlock_unlock(&hw->vf_lock);
+
+	return ret;
+}
+
+/* Detach a removed primary device once its last bursts are done */
+static void
+virtio_standby_detach(void *arg)
+{
+	struct rte_eth_dev *dev = arg;
+	struct virtio_hw *hw = dev->data->dev_private;
+	uint16_t port_id = hw->vf_removed_port;
+	struct rte_device *vf_device = rte_eth_devices[port_id].device;
+
+	rte_eth_dev_callback_unregister(port_id, RTE_ETH_EVENT_INTR_RMV,
+					virtio_standby_rmv_event, dev);
+	rte_eth_dev_stop(port_id);
+	rte_eth_dev_close(port_id);
+
+	if (vf_device != NULL && rte_dev_remove(vf_device) < 0)
+		PMD_DRV_LOG(ERR, "Failed to detach primary port %u", port_id);
+}
+
+/* Called when the host unplugs the primary device */
+static int
+virtio_standby_rmv_event(uint16_t port_id,
+			 enum rte_eth_event_type event __rte_unused,
+			 void *cb_arg, void *out __rte_unused)
+{
+	struct rte_eth_dev *dev = cb_arg;
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev *vf_dev;
+
+	rte_spinlock_lock(&hw->vf_lock);
+	vf_dev = hw->vf_dev;
+	if (vf_dev == NULL || vf_dev->data->port_id != port_id) {
+		rte_spinlock_unlock(&hw->vf_lock);
+		return 0;
+	}
+
+	/* Send and receive over the virtio queues from now on */
+	hw->vf_dev = NULL;
+	rte_smp_wmb();
+	rte_eth_dev_owner_unset(port_id, hw->owner.id);
+	hw->vf_removed_port = port_id;
+	rte_spinlock_unlock(&hw->vf_lock);
+
+	PMD_DRV_LOG(NOTICE, "port %u: primary port %u removed, using virtio",
+		    dev->data->port_id, port_id);
+
+	/* The callback can't unregister itself, detach from an alarm */
+	if (rte_eal_alarm_set(VIRTIO_STANDBY_DETACH_DELAY,
+			      virtio_standby_detach, dev) < 0)
+		PMD_DRV_LOG(ERR, "Can not schedule detach of port %u",
+			    port_id);
+	return 0;
+}
+
+/* Called when a port is probed, like a primary device being plugged */
+static int
+virtio_standby_new_event(uint16_t port_id,
+			 enum rte_eth_event_type event __rte_unused,
+			 void *cb_arg, void *out __rte_unused)
+{
+	struct rte_eth_dev *dev = cb_arg;
+
+	if (virtio_standby_match(dev, port_id))
+		virtio_standby_add(dev, port_id);
+	return 0;
+}
+
+int
+virtio_standby_init(struct rte_eth_dev *dev)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	uint16_t port_id;
+	int ret;
+
+	rte_spinlock_init(&hw->vf_lock);
+	hw->vf_dev = NULL;
+
+	strlcpy(hw->owner.name, dev->device->name, sizeof(hw->owner.name));
+	ret = rte_eth_dev_owner_new(&hw->owner.id);
+	if (ret) {
+		PMD_INIT_LOG(ERR, "Can not get owner id");
+		return ret;
+	}
+
+	ret = rte_eth_dev_callback_register(RTE_ETH_ALL, RTE_ETH_EVENT_NEW,
+					    virtio_standby_new_event, dev);
+	if (ret) {
+		PMD_INIT_LOG(ERR, "Can not register hot-plug callback");
+		rte_eth_dev_owner_delete(hw->owner.id);
+		hw->owner.id = RTE_ETH_DEV_NO_OWNER;
+		return ret;
+	}
+
+	/* The primary device may have been probed before the virtio one */
+	RTE_ETH_FOREACH_DEV(port_id) {
+		if (virtio_standby_match(dev, port_id) &&
+		    virtio_standby_add(dev, port_id) == 0)
+			break;
+	}
+
+	return 0;
+}
+
+void
+virtio_standby_uninit(struct rte_eth_dev *dev)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev *vf_dev;
+
+	if (hw->owner.id == RTE_ETH_DEV_NO_OWNER)
+		return;
+
+	rte_eth_dev_callback_unregister(RTE_ETH_ALL, RTE_ETH_EVENT_NEW,
+					virtio_standby_new_event, dev);
+	rte_eal_alarm_cancel(virtio_standby_detach, dev);
+
+	rte_spinlock_lock(&hw->vf_lock);
+	vf_dev = hw->vf_dev;
+	hw->vf_dev = NULL;
+	if (vf_dev) {
+		rte_eth_dev_callback_unregister(vf_dev->data->port_id,
+						RTE_ETH_EVENT_INTR_RMV,
+						virtio_standby_rmv_event, dev);
+		/* Give back ownership */
+		rte_eth_dev_owner_unset(vf_dev->data->port_id, hw->owner.id);
+	}
+	rte_spinlock_unlock(&hw->vf_lock);
+
+	rte_eth_dev_owner_delete(hw->owner.id);
+	hw->owner.id = RTE_ETH_DEV_NO_OWNER;
+}
+
+/*
+ * Merge the info of the primary device and of the virtio one, so that
+ * the configuration of the port suits both datapaths.
+ */
+void
+virtio_standby_info_get(struct rte_eth_dev *dev,
+			struct rte_eth_dev_info *info)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev_info vf_info;
+	struct rte_eth_dev *vf_dev;
+
+	rte_spinlock_lock(&hw->vf_lock);
+	vf_dev = hw->vf_dev;
+	if (vf_dev) {
+		rte_eth_dev_info_get(vf_dev->data->port_id, &vf_info);
+
+		info->speed_capa = vf_info.speed_capa;
+		info->max_rx_queues = RTE_MIN(vf_info.max_rx_queues,
+					      info->max_rx_queues);
+		info->rx_offload_capa &= vf_info.rx_offload_capa;
+		info->rx_queue_offload_capa &= vf_info.rx_queue_offload_capa;
+		info->flow_type_rss_offloads &= vf_info.flow_type_rss_offloads;
+		info->max_tx_queues = RTE_MIN(vf_info.max_tx_queues,
+					      info->max_tx_queues);
+		info->tx_offload_capa &= vf_info.tx_offload_capa;
+		info->tx_queue_offload_capa &= vf_info.tx_queue_offload_capa;
+		info->min_rx_bufsize = RTE_MAX(vf_info.min_rx_bufsize,
+					       info->min_rx_bufsize);
+		info->max_rx_pktlen = RTE_MIN(vf_info.max_rx_pktlen,
+					      info->max_rx_pktlen);
+	}
+	rte_spinlock_unlock(&hw->vf_lock);
+}
+
+/* Force the primary device to have the queues of the virtio one */
+int
+virtio_standby_configure(struct rte_eth_dev *dev)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev *vf_dev;
+	int ret = 0;
+
+	rte_spinlock_lock(&hw->vf_lock);
+	vf_dev = hw->vf_dev;
+	if (vf_dev)
+		ret = _virtio_standby_configure(dev, vf_dev);
+	rte_spinlock_unlock(&hw->vf_lock);
+
+	return ret;
+}
+
+/*
+ * The queues of the primary device get its default number of descriptors,
+ * whether it is plugged before or after the virtio port is set up.
+ */
+int
+virtio_standby_rx_queue_setup(struct rte_eth_dev *dev, uint16_t queue_idx,
+			      unsigned int socket_id,
+			      const struct rte_eth_rxconf *rx_conf,
+			      struct rte_mempool *mp)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev *vf_dev;
+	int ret = 0;
+
+	rte_spinlock_lock(&hw->vf_lock);
+	vf_dev = hw->vf_dev;
+	if (vf_dev)
+		ret = rte_eth_rx_queue_setup(vf_dev->data->port_id,
+					     queue_idx, 0,
+					     socket_id, rx_conf, mp);
+	rte_spinlock_unlock(&hw->vf_lock);
+
+	return ret;
+}
+
+int
+virtio_standby_tx_queue_setup(struct rte_eth_dev *dev, uint16_t queue_idx,
+			      unsigned int socket_id,
+			      const struct rte_eth_txconf *tx_conf)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev *vf_dev;
+	int ret = 0;
+
+	rte_spinlock_lock(&hw->vf_lock);
+	vf_dev = hw->vf_dev;
+	if (vf_dev)
+		ret = rte_eth_tx_queue_setup(vf_dev->data->port_id,
+					     queue_idx, 0,
+					     socket_id, tx_conf);
+	rte_spinlock_unlock(&hw->vf_lock);
+
+	return ret;
+}
+
+int
+virtio_standby_start(struct rte_eth_dev *dev)
+{
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct rte_eth_dev *vf_dev;
+	int ret = 0;
+
+	rte_spinlock_lock(&hw->vf_lock);
+	vf_dev = hw->vf_dev;
+	if (vf_dev)
+		ret = rte_eth_dev_start(vf_dev->data->port_id);
+	rte_spinlock_unlock(&hw->vf_lock);
+
+	return ret;
+}
+
+/* If the primary device is present, then cascade the operation down */
+#define VIRTIO_STANDBY_FUNC(dev, func)				\
+	{							\
+		struct virtio_hw *hw = (dev)->data->dev_private;	\
+		struct rte_eth_dev *vf_dev;			\
+		rte_spinlock_lock(&hw->vf_lock);		\
+		vf_dev = hw->vf_dev;				\
+		if (vf_dev)					\
+			func(vf_dev->data->port_id);		\
+		rte_spinlock_unlock(&hw->vf_lock);		\
+	}
+
+void
+virtio_standby_stop(struct rte_eth_dev *dev)
+{
+	VIRTIO_STANDBY_FUNC(dev, rte_eth_dev_stop);
+}
+
+void
+virtio_standby_close(struct rte_eth_dev *dev)
+{
+	VIRTIO_STANDBY_FUNC(dev, rte_eth_dev_close);
+}
+
+void
+virtio_standby_promiscuous_enable(struct rte_eth_dev *dev)
+{
+	VIRTIO_STANDBY_FUNC(dev, rte_eth_promiscuous_enable);
+}
+
+void
+virtio_standby_promiscuous_disable(struct rte_eth_dev *dev)
+{
+	VIRTIO_STANDBY_FUNC(dev, rte_eth_promiscuous_disable);
+}
+
+void
+virtio_standby_allmulticast_enable(struct rte_eth_dev *dev)
+{
+	VIRTIO_STANDBY_FUNC(dev, rte_eth_allmulticast_enable);
+}
+
+void
+virtio_standby_allmulticast_disable(struct rte_eth_dev *dev)
+{
+	VIRTIO_STANDBY_FUNC(dev, rte_eth_allmulticast_disable);
+}
+
+uint16_t
+virtio_standby_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts,
+			 uint16_t nb_pkts)
+{
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtio_hw *hw = rxvq->vq->hw;
+	struct rte_eth_dev *vf_dev;
+	uint16_t nb_rx = 0;
+
+	vf_dev = hw->vf_dev;
+	rte_compiler_barrier();
+
+	if (vf_dev && vf_dev->data->dev_started)
+		nb_rx = rte_eth_rx_burst(vf_dev->data->port_id,
+					 rxvq->queue_id, rx_pkts, nb_pkts);
+
+	/*
+	 * Also drain the virtio queue, which receives the packets while the
+	 * host moves the traffic from one device to the other.
+	 */
+	if (nb_rx < nb_pkts)
+		nb_rx += virtio_hw_internal[hw->port_id].rx_pkt_burst(rx_queue,
+				rx_pkts + nb_rx, nb_pkts - nb_rx);
+
+	return nb_rx;
+}
+
+uint16_t
+virtio_standby_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts,
+			 uint16_t nb_pkts)
+{
+	struct virtnet_tx *txvq = tx_queue;
+	struct virtio_hw *hw = txvq->vq->hw;
+	struct rte_eth_dev *vf_dev;
+
+	/* Transmit over the primary device if present and up */
+	vf_dev = hw->vf_dev;
+	rte_compiler_barrier();
+
+	if (vf_dev && vf_dev->data->dev_started)
+		return rte_eth_tx_burst(vf_dev->data->port_id,
+					txvq->queue_id, tx_pkts, nb_pkts);
+
+	return virtio_hw_internal[hw->port_id].tx_pkt_burst(tx_queue,
+			tx_pkts, nb_pkts);
+}
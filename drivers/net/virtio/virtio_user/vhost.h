@@ -64,9 +64,20 @@ enum vhost_user_request {
 	VHOST_USER_SET_PROTOCOL_FEATURES = 16,
 	VHOST_USER_GET_QUEUE_NUM = 17,
 	VHOST_USER_SET_VRING_ENABLE = 18,
+	VHOST_USER_GET_MAX_MEM_SLOTS = 36,
+	VHOST_USER_ADD_MEM_REG = 37,
+	VHOST_USER_REM_MEM_REG = 38,
 	VHOST_USER_MAX
 };
 
+#define VHOST_USER_F_PROTOCOL_FEATURES	30
+
+#define VHOST_USER_PROTOCOL_F_REPLY_ACK			3
+#define VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS	15
+
+/* Regions tracked when they are added to the backend one by one */
+#define VHOST_USER_MAX_MEM_SLOTS 32
+
 const char * const vhost_msg_strings[VHOST_USER_MAX];
 
 struct vhost_memory_region {
@@ -76,6 +87,12 @@ struct vhost_memory_region {
 	uint64_t mmap_offset;
 };
 
+/* A memory region added or removed alone, with the fd to map it */
+struct vhost_memory_region_fd {
+	struct vhost_memory_region region;
+	int fd;
+};
+
 struct virtio_user_dev;
 
 struct virtio_user_backend_ops {
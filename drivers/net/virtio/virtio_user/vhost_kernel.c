@@ -330,14 +330,26 @@ vhost_kernel_enable_queue_pair(struct virtio_user_dev *dev,
 	int req_mq = (dev->max_queue_pairs > 1);
 
 	vhostfd = dev->vhostfds[pair_idx];
+	tapfd = dev->tapfds[pair_idx];
 
+	/* With multi-queue, the tap queue of a disabled pair is only
+	 * detached, which keeps the tap interface and its other queues.
+	 */
 	if (!enable) {
-		if (dev->tapfds[pair_idx] >= 0) {
-			close(dev->tapfds[pair_idx]);
+		if (vhost_kernel_set_backend(vhostfd, -1) < 0)
+			return -1;
+		if (tapfd < 0 || !dev->tap_attached[pair_idx])
+			return 0;
+		if (req_mq) {
+			if (vhost_kernel_tap_set_queue(tapfd, false) < 0)
+				return -1;
+		} else {
+			close(tapfd);
 			dev->tapfds[pair_idx] = -1;
 		}
-		return vhost_kernel_set_backend(vhostfd, -1);
-	} else if (dev->tapfds[pair_idx] >= 0) {
+		dev->tap_attached[pair_idx] = false;
+		return 0;
+	} else if (tapfd >= 0 && dev->tap_attached[pair_idx]) {
 		return 0;
 	}
 
@@ -347,6 +359,23 @@ vhost_kernel_enable_queue_pair(struct virtio_user_dev *dev,
 	else
 		hdr_size = sizeof(struct virtio_net_hdr);
 
+	if (tapfd >= 0) {
+		/* features may have been renegotiated since the detach */
+		if (vhost_kernel_tap_set_queue(tapfd, true) < 0)
+			return -1;
+		if (ioctl(tapfd, TUNSETVNETHDRSZ, &hdr_size) < 0)
+			PMD_DRV_LOG(ERR, "TUNSETVNETHDRSZ failed: %s",
+				    strerror(errno));
+		if (vhost_kernel_tap_set_offload(tapfd, dev->features) < 0)
+			PMD_DRV_LOG(WARNING, "fail to set tap offloads");
+		if (vhost_kernel_set_backend(vhostfd, tapfd) < 0) {
+			vhost_kernel_tap_set_queue(tapfd, false);
+			return -1;
+		}
+		dev->tap_attached[pair_idx] = true;
+		return 0;
+	}
+
 	tapfd = vhost_kernel_open_tap(&dev->ifname, hdr_size, req_mq,
 			 (char *)dev->mac_addr, dev->features);
 	if (tapfd < 0) {
@@ -361,6 +390,7 @@ vhost_kernel_enable_queue_pair(struct virtio_user_dev *dev,
 	}
 
 	dev->tapfds[pair_idx] = tapfd;
+	dev->tap_attached[pair_idx] = true;
 	return 0;
 }
 
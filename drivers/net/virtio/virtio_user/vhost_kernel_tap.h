@@ -2,6 +2,8 @@
  * Copyright(c) 2016 Intel Corporation
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <sys/ioctl.h>
 
 /* TUN ioctls */
@@ -37,3 +39,5 @@
 
 int vhost_kernel_open_tap(char **p_ifname, int hdr_size, int req_mq,
 			 const char *mac, uint64_t features);
+int vhost_kernel_tap_set_offload(int fd, uint64_t features);
+int vhost_kernel_tap_set_queue(int fd, bool attach);
@@ -27,11 +27,17 @@ struct vhost_memory {
 	struct vhost_memory_region regions[VHOST_MEMORY_MAX_NREGIONS];
 };
 
+struct vhost_memory_single {
+	uint64_t padding;
+	struct vhost_memory_region region;
+};
+
 struct vhost_user_msg {
 	enum vhost_user_request request;
 
 #define VHOST_USER_VERSION_MASK     0x3
 #define VHOST_USER_REPLY_MASK       (0x1 << 2)
+#define VHOST_USER_NEED_REPLY       (0x1 << 3)
 	uint32_t flags;
 	uint32_t size; /* the following payload size */
 	union {
@@ -41,6 +47,7 @@ struct vhost_user_msg {
 		struct vhost_vring_state state;
 		struct vhost_vring_addr addr;
 		struct vhost_memory memory;
+		struct vhost_memory_single memory_single;
 	} payload;
 	int fds[VHOST_MEMORY_MAX_NREGIONS];
 } __attribute((packed));
@@ -77,7 +84,7 @@ vhost_user_write(int fd, void *buf, int len, int *fds, int fd_num)
 	memcpy(CMSG_DATA(cmsg), fds, fd_size);
 
 	do {
-		r = sendmsg(fd, &msgh, 0);
+		r = sendmsg(fd, &msgh, MSG_NOSIGNAL);
 	} while (r < 0 && errno == EINTR);
 
 	return r;
@@ -241,6 +248,11 @@ const char * const vhost_msg_strings[] = {
 	[VHOST_USER_SET_VRING_KICK] = "VHOST_SET_VRING_KICK",
 	[VHOST_USER_SET_MEM_TABLE] = "VHOST_SET_MEM_TABLE",
 	[VHOST_USER_SET_VRING_ENABLE] = "VHOST_SET_VRING_ENABLE",
+	[VHOST_USER_GET_PROTOCOL_FEATURES] = "VHOST_GET_PROTOCOL_FEATURES",
+	[VHOST_USER_SET_PROTOCOL_FEATURES] = "VHOST_SET_PROTOCOL_FEATURES",
+	[VHOST_USER_GET_MAX_MEM_SLOTS] = "VHOST_GET_MAX_MEM_SLOTS",
+	[VHOST_USER_ADD_MEM_REG] = "VHOST_ADD_MEM_REG",
+	[VHOST_USER_REM_MEM_REG] = "VHOST_REM_MEM_REG",
 };
 
 static int
@@ -250,7 +262,9 @@ vhost_user_sock(struct virtio_user_dev *dev,
 {
 	struct vhost_user_msg msg;
 	struct vhost_vring_file *file = 0;
+	struct vhost_memory_region_fd *reg;
 	int need_reply = 0;
+	int need_sync = 0;
 	int fds[VHOST_MEMORY_MAX_NREGIONS];
 	int fd_num = 0;
 	int len;
@@ -269,10 +283,13 @@ vhost_user_sock(struct virtio_user_dev *dev,
 
 	switch (req) {
 	case VHOST_USER_GET_FEATURES:
+	case VHOST_USER_GET_PROTOCOL_FEATURES:
+	case VHOST_USER_GET_MAX_MEM_SLOTS:
 		need_reply = 1;
 		break;
 
 	case VHOST_USER_SET_FEATURES:
+	case VHOST_USER_SET_PROTOCOL_FEATURES:
 	case VHOST_USER_SET_LOG_BASE:
 		msg.payload.u64 = *((__u64 *)arg);
 		msg.size = sizeof(m.payload.u64);
@@ -291,6 +308,24 @@ vhost_user_sock(struct virtio_user_dev *dev,
 		msg.size += fd_num * sizeof(struct vhost_memory_region);
 		break;
 
+	case VHOST_USER_ADD_MEM_REG:
+	case VHOST_USER_REM_MEM_REG:
+		reg = arg;
+		msg.payload.memory_single.padding = 0;
+		msg.payload.memory_single.region = reg->region;
+		msg.size = sizeof(m.payload.memory_single);
+		if (reg->fd >= 0)
+			fds[fd_num++] = reg->fd;
+		/* the region must be known by the backend once we return */
+		if (dev->protocol_features &
+		    (1ULL << VHOST_USER_PROTOCOL_F_REPLY_ACK)) {
+			msg.flags |= VHOST_USER_NEED_REPLY;
+			need_reply = 1;
+		} else {
+			need_sync = 1;
+		}
+		break;
+
 	case VHOST_USER_SET_LOG_FD:
 		fds[fd_num++] = *((int *)arg);
 		break;
@@ -337,6 +372,12 @@ vhost_user_sock(struct virtio_user_dev *dev,
 		return -1;
 	}
 
+	if (req == VHOST_USER_SET_MEM_TABLE) {
+		memcpy(dev->mem_regions, msg.payload.memory.regions,
+		       fd_num * sizeof(struct vhost_memory_region));
+		dev->nr_mem_regions = fd_num;
+	}
+
 	if (need_reply) {
 		if (vhost_user_read(vhostfd, &msg) < 0) {
 			PMD_DRV_LOG(ERR, "Received msg failed: %s",
@@ -351,6 +392,8 @@ vhost_user_sock(struct virtio_user_dev *dev,
 
 		switch (req) {
 		case VHOST_USER_GET_FEATURES:
+		case VHOST_USER_GET_PROTOCOL_FEATURES:
+		case VHOST_USER_GET_MAX_MEM_SLOTS:
 			if (msg.size != sizeof(m.payload.u64)) {
 				PMD_DRV_LOG(ERR, "Received bad msg size");
 				return -1;
@@ -365,12 +408,36 @@ vhost_user_sock(struct virtio_user_dev *dev,
 			memcpy(arg, &msg.payload.state,
 			       sizeof(struct vhost_vring_state));
 			break;
+		case VHOST_USER_ADD_MEM_REG:
+		case VHOST_USER_REM_MEM_REG:
+			if (msg.size != sizeof(m.payload.u64)) {
+				PMD_DRV_LOG(ERR, "Received bad msg size");
+				return -1;
+			}
+			if (msg.payload.u64 != 0) {
+				PMD_DRV_LOG(ERR, "%s failed in the backend",
+					    vhost_msg_strings[req]);
+				return -1;
+			}
+			break;
 		default:
 			PMD_DRV_LOG(ERR, "Received unexpected msg type");
 			return -1;
 		}
 	}
 
+	/*
+	 * Without REPLY_ACK, the reply of a later request tells that the
+	 * backend is done with this one, as it handles them in order.
+	 */
+	if (need_sync) {
+		uint64_t features;
+
+		if (vhost_user_sock(dev, VHOST_USER_GET_FEATURES,
+				    &features) < 0)
+			return -1;
+	}
+
 	return 0;
 }
 
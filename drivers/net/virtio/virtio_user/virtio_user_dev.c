@@ -14,6 +14,7 @@
 #include <sys/stat.h>
 
 #include <rte_eal_memconfig.h>
+#include <rte_fbarray.h>
 
 #include "vhost.h"
 #include "virtio_user_dev.h"
@@ -37,27 +38,81 @@ virtio_user_create_queue(struct virtio_user_dev *dev, uint32_t queue_sel)
 	return 0;
 }
 
+/*
+ * The ring position the backend resumes from, where it stopped using the
+ * descriptors. A backend reconnecting in server mode goes on with the
+ * rings as the driver left them, the descriptors it had taken but not
+ * used yet are processed again.
+ */
+static uint16_t
+virtio_user_vring_base(struct virtio_user_dev *dev, uint32_t queue_sel)
+{
+	struct virtio_hw *hw = rte_eth_devices[dev->port_id].data->dev_private;
+	struct virtqueue *vq = hw->vqs[queue_sel];
+	struct vring_packed_desc *desc;
+	uint16_t idx, flags, num;
+	bool wrap;
+
+	if (!(dev->features & (1ULL << VIRTIO_F_RING_PACKED)))
+		return dev->vrings[queue_sel].used->idx;
+
+	/* skip the used descriptors not seen by the driver yet */
+	desc = dev->packed_vrings[queue_sel].desc_packed;
+	idx = vq->vq_used_cons_idx;
+	wrap = vq->vq_used_wrap_counter;
+	for (;;) {
+		flags = desc[idx].flags;
+		if (!!(flags & VRING_DESC_F_AVAIL(1)) != wrap ||
+		    !!(flags & VRING_DESC_F_USED(1)) != wrap)
+			break;
+
+		num = vq->vq_descx[desc[idx].id].ndescs;
+		if (num == 0)
+			break;
+
+		idx += num;
+		if (idx >= vq->vq_nentries) {
+			idx -= vq->vq_nentries;
+			wrap ^= 1;
+		}
+	}
+
+	/* the wrap counter goes in bit 15 */
+	return idx | (uint16_t)wrap << 15;
+}
+
 static int
 virtio_user_kick_queue(struct virtio_user_dev *dev, uint32_t queue_sel)
 {
 	struct vhost_vring_file file;
 	struct vhost_vring_state state;
 	struct vring *vring = &dev->vrings[queue_sel];
+	struct vring_packed *pq_vring = &dev->packed_vrings[queue_sel];
 	struct vhost_vring_addr addr = {
 		.index = queue_sel,
-		.desc_user_addr = (uint64_t)(uintptr_t)vring->desc,
-		.avail_user_addr = (uint64_t)(uintptr_t)vring->avail,
-		.used_user_addr = (uint64_t)(uintptr_t)vring->used,
 		.log_guest_addr = 0,
 		.flags = 0, /* disable log */
 	};
 
+	if (dev->features & (1ULL << VIRTIO_F_RING_PACKED)) {
+		addr.desc_user_addr =
+			(uint64_t)(uintptr_t)pq_vring->desc_packed;
+		addr.avail_user_addr =
+			(uint64_t)(uintptr_t)pq_vring->driver_event;
+		addr.used_user_addr =
+			(uint64_t)(uintptr_t)pq_vring->device_event;
+	} else {
+		addr.desc_user_addr = (uint64_t)(uintptr_t)vring->desc;
+		addr.avail_user_addr = (uint64_t)(uintptr_t)vring->avail;
+		addr.used_user_addr = (uint64_t)(uintptr_t)vring->used;
+	}
+
 	state.index = queue_sel;
 	state.num = vring->num;
 	dev->ops->send_request(dev, VHOST_USER_SET_VRING_NUM, &state);
 
 	state.index = queue_sel;
-	state.num = 0; /* no reservation */
+	state.num = virtio_user_vring_base(dev, queue_sel);
 	dev->ops->send_request(dev, VHOST_USER_SET_VRING_BASE, &state);
 
 	dev->ops->send_request(dev, VHOST_USER_SET_VRING_ADDR, &addr);
@@ -108,6 +163,185 @@ is_vhost_user_by_type(const char *path)
 	return S_ISSOCK(sb.st_mode);
 }
 
+static int
+virtio_user_add_mem_region(struct virtio_user_dev *dev,
+			   struct vhost_memory_region_fd *reg)
+{
+	if (dev->nr_mem_regions >= dev->max_mem_slots) {
+		PMD_DRV_LOG(INFO, "No memory slot left in the backend");
+		return -1;
+	}
+
+	if (dev->ops->send_request(dev, VHOST_USER_ADD_MEM_REG, reg) < 0)
+		return -1;
+
+	dev->mem_regions[dev->nr_mem_regions++] = reg->region;
+
+	return 0;
+}
+
+static int
+virtio_user_remove_mem_region(struct virtio_user_dev *dev, uint32_t idx)
+{
+	struct vhost_memory_region_fd reg = {
+		.region = dev->mem_regions[idx],
+		.fd = -1,
+	};
+
+	if (dev->ops->send_request(dev, VHOST_USER_REM_MEM_REG, &reg) < 0)
+		return -1;
+
+	dev->mem_regions[idx] = dev->mem_regions[--dev->nr_mem_regions];
+
+	return 0;
+}
+
+/*
+ * Add the memory of [start, end) to the backend, as one region per run
+ * of pages contiguous both in the address space and in their file.
+ */
+static int
+virtio_user_add_mem_range(struct virtio_user_dev *dev, uint64_t start,
+			  uint64_t end)
+{
+	struct vhost_memory_region_fd reg = { .fd = -1 };
+	struct rte_memseg_list *msl;
+	struct rte_memseg *ms;
+	uint64_t addr;
+	size_t offset;
+	int fd, idx;
+
+	for (addr = start; addr < end; addr += msl->page_sz) {
+		msl = rte_mem_virt2memseg_list((void *)(uintptr_t)addr);
+		if (msl == NULL || msl->external)
+			return -1;
+
+		idx = (addr - (uint64_t)(uintptr_t)msl->base_va) /
+			msl->page_sz;
+		if (!rte_fbarray_is_used(&msl->memseg_arr, idx)) {
+			if (reg.fd >= 0 &&
+			    virtio_user_add_mem_region(dev, &reg) < 0)
+				return -1;
+			reg.fd = -1;
+			continue;
+		}
+
+		ms = rte_fbarray_get(&msl->memseg_arr, idx);
+		fd = rte_memseg_get_fd_thread_unsafe(ms);
+		if (fd < 0 ||
+		    rte_memseg_get_fd_offset_thread_unsafe(ms, &offset) < 0) {
+			PMD_DRV_LOG(ERR, "Failed to get fd, ms=%p rte_errno=%d",
+				ms, rte_errno);
+			return -1;
+		}
+
+		if (reg.fd == fd && reg.region.userspace_addr +
+				reg.region.memory_size == addr &&
+		    reg.region.mmap_offset + reg.region.memory_size ==
+				offset) {
+			reg.region.memory_size += ms->len;
+			continue;
+		}
+
+		if (reg.fd >= 0 && virtio_user_add_mem_region(dev, &reg) < 0)
+			return -1;
+
+		reg.fd = fd;
+		reg.region.guest_phys_addr = addr;
+		reg.region.userspace_addr = addr;
+		reg.region.memory_size = ms->len;
+		reg.region.mmap_offset = offset;
+	}
+
+	if (reg.fd >= 0)
+		return virtio_user_add_mem_region(dev, &reg);
+
+	return 0;
+}
+
+/*
+ * Remove the regions overlapping [start, end) from the backend. What a
+ * region has out of the range is still in use, it is added back with
+ * the queues paused as the backend can't reach it in between.
+ */
+static int
+virtio_user_remove_mem_range(struct virtio_user_dev *dev, uint64_t start,
+			     uint64_t end)
+{
+	struct vhost_memory_region mr;
+	uint64_t mr_start, mr_end;
+	bool paused = false;
+	uint32_t i = 0;
+	uint16_t q;
+	int ret = 0;
+
+	while (i < dev->nr_mem_regions) {
+		mr = dev->mem_regions[i];
+		mr_start = mr.userspace_addr;
+		mr_end = mr_start + mr.memory_size;
+
+		if (mr_end <= start || mr_start >= end) {
+			i++;
+			continue;
+		}
+
+		if (!paused && (mr_start < start || mr_end > end)) {
+			for (q = 0; q < dev->queue_pairs; q++)
+				dev->ops->enable_qp(dev, q, 0);
+			paused = true;
+		}
+
+		ret = virtio_user_remove_mem_region(dev, i);
+		if (ret < 0)
+			break;
+
+		if (mr_start < start) {
+			ret = virtio_user_add_mem_range(dev, mr_start, start);
+			if (ret < 0)
+				break;
+		}
+
+		if (mr_end > end) {
+			ret = virtio_user_add_mem_range(dev, end, mr_end);
+			if (ret < 0)
+				break;
+		}
+	}
+
+	for (q = 0; paused && q < dev->queue_pairs; q++)
+		dev->ops->enable_qp(dev, q, 1);
+
+	return ret;
+}
+
+static int
+virtio_user_add_mem_contig(const struct rte_memseg_list *msl,
+			   const struct rte_memseg *ms, size_t len, void *arg)
+{
+	uint64_t start = (uint64_t)(uintptr_t)ms->addr;
+
+	if (msl->external)
+		return 0;
+
+	return virtio_user_add_mem_range(arg, start, start + len);
+}
+
+/*
+ * Share the memory adding the regions one by one, so that the memory
+ * events can update them the same way.
+ */
+static int
+virtio_user_add_mem_table(struct virtio_user_dev *dev)
+{
+	while (dev->nr_mem_regions > 0)
+		if (virtio_user_remove_mem_region(dev,
+					dev->nr_mem_regions - 1) < 0)
+			return -1;
+
+	return rte_memseg_contig_walk_thread_unsafe(virtio_user_add_mem_contig,
+						    dev);
+}
+
 int
 virtio_user_start_device(struct virtio_user_dev *dev)
 {
@@ -151,9 +385,14 @@ virtio_user_start_device(struct virtio_user_dev *dev)
 	PMD_DRV_LOG(INFO, "set features: %" PRIx64, features);
 
 	/* Step 2: share memory regions */
-	ret = dev->ops->send_request(dev, VHOST_USER_SET_MEM_TABLE, NULL);
-	if (ret < 0)
-		goto error;
+	if (!(dev->protocol_features &
+	      (1ULL << VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS)) ||
+	    virtio_user_add_mem_table(dev) < 0) {
+		ret = dev->ops->send_request(dev, VHOST_USER_SET_MEM_TABLE,
+					     NULL);
+		if (ret < 0)
+			goto error;
+	}
 
 	/* Step 3: kick queues */
 	if (virtio_user_queue_setup(dev, virtio_user_kick_queue) < 0)
@@ -305,14 +544,16 @@ virtio_user_fill_intr_handle(struct virtio_user_dev *dev)
 }
 
 static void
-virtio_user_mem_event_cb(enum rte_mem_event type __rte_unused,
-						 const void *addr __rte_unused,
-						 size_t len __rte_unused,
+virtio_user_mem_event_cb(enum rte_mem_event type,
+						 const void *addr,
+						 size_t len,
 						 void *arg)
 {
 	struct virtio_user_dev *dev = arg;
 	struct rte_memseg_list *msl;
+	uint64_t start = (uint64_t)(uintptr_t)addr;
 	uint16_t i;
+	int ret;
 
 	/* ignore externally allocated memory */
 	msl = rte_mem_virt2memseg_list(addr);
@@ -324,6 +565,27 @@ virtio_user_mem_event_cb(enum rte_mem_event type __rte_unused,
 	if (dev->started == false)
 		goto exit;
 
+	if (!dev->mem_event_noticed) {
+		PMD_DRV_LOG(NOTICE, "Memory hotplug while the device is started,"
+			" preallocate the memory with --socket-mem to avoid it");
+		dev->mem_event_noticed = true;
+	}
+
+	/* Update the backend with only the changed regions */
+	if (dev->protocol_features &
+	    (1ULL << VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS)) {
+		if (type == RTE_MEM_EVENT_ALLOC)
+			ret = virtio_user_add_mem_range(dev, start,
+							start + len);
+		else
+			ret = virtio_user_remove_mem_range(dev, start,
+							   start + len);
+		if (ret == 0)
+			goto exit;
+
+		PMD_DRV_LOG(INFO, "Falling back to a full memory table update");
+	}
+
 	/* Step 1: pause the active queues */
 	for (i = 0; i < dev->queue_pairs; i++)
 		dev->ops->enable_qp(dev, i, 0);
@@ -347,6 +609,7 @@ virtio_user_dev_setup(struct virtio_user_dev *dev)
 	dev->vhostfd = -1;
 	dev->vhostfds = NULL;
 	dev->tapfds = NULL;
+	dev->tap_attached = NULL;
 
 	if (dev->is_server) {
 		if (access(dev->path, F_OK) == 0 &&
@@ -365,7 +628,10 @@ virtio_user_dev_setup(struct virtio_user_dev *dev)
 					       sizeof(int));
 			dev->tapfds = malloc(dev->max_queue_pairs *
 					     sizeof(int));
-			if (!dev->vhostfds || !dev->tapfds) {
+			dev->tap_attached = calloc(dev->max_queue_pairs,
+						   sizeof(bool));
+			if (!dev->vhostfds || !dev->tapfds ||
+			    !dev->tap_attached) {
 				PMD_INIT_LOG(ERR, "Failed to malloc");
 				return -1;
 			}
@@ -403,16 +669,64 @@ virtio_user_dev_setup(struct virtio_user_dev *dev)
 	 1ULL << VIRTIO_NET_F_HOST_TSO6		|	\
 	 1ULL << VIRTIO_NET_F_MRG_RXBUF		|	\
 	 1ULL << VIRTIO_RING_F_INDIRECT_DESC	|	\
+	 1ULL << VIRTIO_RING_F_EVENT_IDX	|	\
 	 1ULL << VIRTIO_NET_F_GUEST_CSUM	|	\
 	 1ULL << VIRTIO_NET_F_GUEST_TSO4	|	\
 	 1ULL << VIRTIO_NET_F_GUEST_TSO6	|	\
 	 1ULL << VIRTIO_F_IN_ORDER		|	\
+	 1ULL << VIRTIO_F_RING_PACKED		|	\
 	 1ULL << VIRTIO_F_VERSION_1)
 
+/* Use below macro to filter protocol features from vhost-user backend */
+#define VIRTIO_USER_SUPPORTED_PROTOCOL_FEATURES			\
+	(1ULL << VHOST_USER_PROTOCOL_F_REPLY_ACK		|	\
+	 1ULL << VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS)
+
+/*
+ * Negotiate the protocol features of a vhost-user backend, right after
+ * getting its features.
+ */
+int
+virtio_user_dev_set_protocol_features(struct virtio_user_dev *dev)
+{
+	uint64_t features, slots;
+
+	dev->protocol_features = 0;
+	dev->max_mem_slots = 0;
+	dev->nr_mem_regions = 0;
+
+	if (dev->ops != &virtio_ops_user ||
+	    !(dev->device_features & (1ULL << VHOST_USER_F_PROTOCOL_FEATURES)))
+		return 0;
+
+	if (dev->ops->send_request(dev, VHOST_USER_GET_PROTOCOL_FEATURES,
+				   &features) < 0)
+		return -1;
+
+	features &= VIRTIO_USER_SUPPORTED_PROTOCOL_FEATURES;
+	if (dev->ops->send_request(dev, VHOST_USER_SET_PROTOCOL_FEATURES,
+				   &features) < 0)
+		return -1;
+
+	dev->protocol_features = features;
+
+	if (features & (1ULL << VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS)) {
+		if (dev->ops->send_request(dev, VHOST_USER_GET_MAX_MEM_SLOTS,
+					   &slots) < 0)
+			return -1;
+		dev->max_mem_slots = RTE_MIN(slots,
+					     (uint64_t)VHOST_USER_MAX_MEM_SLOTS);
+	}
+
+	PMD_DRV_LOG(INFO, "set protocol features: %" PRIx64, features);
+
+	return 0;
+}
+
 int
 virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
 		     int cq, int queue_size, const char *mac, char **ifname,
-		     int mrg_rxbuf, int in_order)
+		     int mrg_rxbuf, int in_order, int packed_vq)
 {
 	pthread_mutex_init(&dev->mutex, NULL);
 	snprintf(dev->path, PATH_MAX, "%s", path);
@@ -449,6 +763,12 @@ virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
 				     strerror(errno));
 			return -1;
 		}
+
+		if (virtio_user_dev_set_protocol_features(dev) < 0) {
+			PMD_INIT_LOG(ERR, "set_protocol_features failed: %s",
+				     strerror(errno));
+			return -1;
+		}
 	} else {
 		/* We just pretend vhost-user can support all these features.
 		 * Note that this could be problematic that if some feature is
@@ -464,6 +784,9 @@ virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
 	if (!in_order)
 		dev->unsupported_features |= (1ull << VIRTIO_F_IN_ORDER);
 
+	if (!packed_vq)
+		dev->unsupported_features |= (1ull << VIRTIO_F_RING_PACKED);
+
 	if (dev->mac_specified)
 		dev->frontend_features |= (1ull << VIRTIO_NET_F_MAC);
 	else
@@ -531,10 +854,15 @@ virtio_user_dev_uninit(struct virtio_user_dev *dev)
 	}
 
 	if (dev->vhostfds) {
-		for (i = 0; i < dev->max_queue_pairs; ++i)
+		for (i = 0; i < dev->max_queue_pairs; ++i) {
 			close(dev->vhostfds[i]);
+			/* the detached tap queues of multi-queue */
+			if (dev->tapfds[i] >= 0)
+				close(dev->tapfds[i]);
+		}
 		free(dev->vhostfds);
 		free(dev->tapfds);
+		free(dev->tap_attached);
 	}
 
 	free(dev->ifname);
@@ -624,9 +952,91 @@ virtio_user_handle_cq(struct virtio_user_dev *dev, uint16_t queue_idx)
 
 		/* Update used ring */
 		uep = &vring->used->ring[avail_idx];
-		uep->id = avail_idx;
+		uep->id = desc_idx;
 		uep->len = n_descs;
 
 		vring->used->idx++;
 	}
 }
+
+static inline int
+desc_is_avail(struct vring_packed_desc *desc, bool wrap_counter)
+{
+	uint16_t flags = desc->flags;
+
+	return wrap_counter == !!(flags & VRING_DESC_F_AVAIL(1)) &&
+		wrap_counter != !!(flags & VRING_DESC_F_USED(1));
+}
+
+static uint32_t
+virtio_user_handle_ctrl_msg_packed(struct virtio_user_dev *dev,
+				   struct vring_packed *vring,
+				   uint16_t idx_hdr)
+{
+	struct virtio_net_ctrl_hdr *hdr;
+	virtio_net_ctrl_ack status = ~0;
+	uint16_t idx_data, idx_status;
+	/* initialize to one, header is first */
+	uint32_t n_descs = 1;
+
+	/* locate desc for header, data, and status */
+	idx_data = idx_hdr + 1;
+	if (idx_data >= vring->num)
+		idx_data -= vring->num;
+
+	n_descs++;
+
+	idx_status = idx_data;
+	while (vring->desc_packed[idx_status].flags & VRING_DESC_F_NEXT) {
+		idx_status++;
+		if (idx_status >= vring->num)
+			idx_status -= vring->num;
+		n_descs++;
+	}
+
+	hdr = (void *)(uintptr_t)vring->desc_packed[idx_hdr].addr;
+	if (hdr->class == VIRTIO_NET_CTRL_MQ &&
+	    hdr->cmd == VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET) {
+		uint16_t queues;
+
+		queues = *(uint16_t *)(uintptr_t)
+				vring->desc_packed[idx_data].addr;
+		status = virtio_user_handle_mq(dev, queues);
+	}
+
+	/* Update status */
+	*(virtio_net_ctrl_ack *)(uintptr_t)
+		vring->desc_packed[idx_status].addr = status;
+
+	return n_descs;
+}
+
+void
+virtio_user_handle_cq_packed(struct virtio_user_dev *dev, uint16_t queue_idx)
+{
+	struct virtio_user_queue *vq = &dev->packed_queues[queue_idx];
+	struct vring_packed *vring = &dev->packed_vrings[queue_idx];
+	uint16_t id, n_descs;
+
+	while (desc_is_avail(&vring->desc_packed[vq->used_idx],
+			     vq->used_wrap_counter)) {
+		id = vring->desc_packed[vq->used_idx].id;
+
+		n_descs = virtio_user_handle_ctrl_msg_packed(dev, vring,
+				vq->used_idx);
+
+		/* the descriptor is in place, hand it back with its flags */
+		vring->desc_packed[vq->used_idx].id = id;
+		rte_smp_wmb();
+		vring->desc_packed[vq->used_idx].flags =
+			VRING_DESC_F_WRITE |
+			VRING_DESC_F_AVAIL(vq->used_wrap_counter) |
+			VRING_DESC_F_USED(vq->used_wrap_counter);
+
+		vq->used_idx += n_descs;
+		if (vq->used_idx >= vring->num) {
+			vq->used_idx -= vring->num;
+			vq->used_wrap_counter ^= 1;
+		}
+	}
+}
@@ -11,16 +11,28 @@
 #include "../virtio_ring.h"
 #include "vhost.h"
 
+/* driver side state of a packed ring, as seen by the control queue */
+struct virtio_user_queue {
+	uint16_t used_idx;
+	bool used_wrap_counter;
+};
+
 struct virtio_user_dev {
 	/* for vhost_user backend */
 	int		vhostfd;
 	int		listenfd;   /* listening fd */
 	bool		is_server;  /* server or client mode */
+	uint64_t	protocol_features; /* negotiated protocol features */
+	uint32_t	max_mem_slots;
+	uint32_t	nr_mem_regions;
+	/* regions known by the backend, when they are added one by one */
+	struct vhost_memory_region mem_regions[VHOST_USER_MAX_MEM_SLOTS];
 
 	/* for vhost_kernel backend */
 	char		*ifname;
 	int		*vhostfds;
 	int		*tapfds;
+	bool		*tap_attached; /* tap queue attached to its pair */
 
 	/* for both vhost_user and vhost_kernel */
 	int		callfds[VIRTIO_MAX_VIRTQUEUES];
@@ -39,19 +51,27 @@ struct virtio_user_dev {
 	uint16_t	port_id;
 	uint8_t		mac_addr[ETHER_ADDR_LEN];
 	char		path[PATH_MAX];
-	struct vring	vrings[VIRTIO_MAX_VIRTQUEUES];
+	union {
+		struct vring		vrings[VIRTIO_MAX_VIRTQUEUES];
+		struct vring_packed	packed_vrings[VIRTIO_MAX_VIRTQUEUES];
+	};
+	struct virtio_user_queue packed_queues[VIRTIO_MAX_VIRTQUEUES];
 	struct virtio_user_backend_ops *ops;
 	pthread_mutex_t	mutex;
 	bool		started;
+	bool		mem_event_noticed; /* memory hotplug while started */
 };
 
 int is_vhost_user_by_type(const char *path);
 int virtio_user_start_device(struct virtio_user_dev *dev);
 int virtio_user_stop_device(struct virtio_user_dev *dev);
+int virtio_user_dev_set_protocol_features(struct virtio_user_dev *dev);
 int virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
 			 int cq, int queue_size, const char *mac, char **ifname,
-			 int mrg_rxbuf, int in_order);
+			 int mrg_rxbuf, int in_order, int packed_vq);
 void virtio_user_dev_uninit(struct virtio_user_dev *dev);
 void virtio_user_handle_cq(struct virtio_user_dev *dev, uint16_t queue_idx);
+void virtio_user_handle_cq_packed(struct virtio_user_dev *dev,
+				  uint16_t queue_idx);
 uint8_t virtio_user_handle_mq(struct virtio_user_dev *dev, uint16_t q_pairs);
 #endif
@@ -36,6 +36,8 @@ virtio_user_server_reconnect(struct virtio_user_dev *dev)
 		return -1;
 
 	dev->vhostfd = connectfd;
+	/* The new backend has none of the regions of the previous one */
+	dev->nr_mem_regions = 0;
 	if (dev->ops->send_request(dev, VHOST_USER_GET_FEATURES,
 				   &dev->device_features) < 0) {
 		PMD_INIT_LOG(ERR, "get_features failed: %s",
@@ -43,6 +45,12 @@ virtio_user_server_reconnect(struct virtio_user_dev *dev)
 		return -1;
 	}
 
+	if (virtio_user_dev_set_protocol_features(dev) < 0) {
+		PMD_INIT_LOG(ERR, "set_protocol_features failed: %s",
+			     strerror(errno));
+		return -1;
+	}
+
 	dev->device_features |= dev->frontend_features;
 
 	/* umask vhost-user unsupported features */
@@ -88,6 +96,17 @@ virtio_user_delayed_handler(void *param)
 	struct virtio_hw *hw = (struct virtio_hw *)param;
 	struct rte_eth_dev *eth_dev = &rte_eth_devices[hw->port_id];
 	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+	char buf;
+	int r;
+
+	/* The link may have been polled by another thread, which already
+	 * reconnected on an fd that must be left alone.
+	 */
+	if (dev->is_server && dev->vhostfd >= 0) {
+		r = recv(dev->vhostfd, &buf, 1, MSG_PEEK | MSG_DONTWAIT);
+		if (r > 0 || (r < 0 && errno == EAGAIN))
+			return;
+	}
 
 	if (rte_intr_disable(eth_dev->intr_handle) < 0) {
 		PMD_DRV_LOG(ERR, "interrupt disable failed");
@@ -100,6 +119,10 @@ virtio_user_delayed_handler(void *param)
 			close(dev->vhostfd);
 			dev->vhostfd = -1;
 		}
+		/* Down until a reconnection has set the backend up again */
+		pthread_mutex_lock(&dev->mutex);
+		dev->started = false;
+		pthread_mutex_unlock(&dev->mutex);
 		eth_dev->intr_handle->fd = dev->listenfd;
 		rte_intr_callback_register(eth_dev->intr_handle,
 					   virtio_interrupt_handler, eth_dev);
@@ -110,6 +133,25 @@ virtio_user_delayed_handler(void *param)
 	}
 }
 
+/*
+ * Accept a connection of the backend from the interrupt thread, a link
+ * status read only schedules it. The ports of a process are then all
+ * connected by that thread as their backends come, the lcores polling
+ * the link never wait on a vhost-user handshake.
+ */
+static void
+virtio_user_server_reconnect_handler(void *param)
+{
+	struct virtio_hw *hw = (struct virtio_hw *)param;
+	struct rte_eth_dev *eth_dev = &rte_eth_devices[hw->port_id];
+	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
+
+	if (dev->vhostfd >= 0 || virtio_user_server_reconnect(dev) < 0)
+		return;
+
+	_rte_eth_dev_callback_process(eth_dev, RTE_ETH_EVENT_INTR_LSC, NULL);
+}
+
 static void
 virtio_user_read_dev_config(struct virtio_hw *hw, size_t offset,
 		     void *dst, int length)
@@ -129,15 +171,12 @@ virtio_user_read_dev_config(struct virtio_hw *hw, size_t offset,
 
 		if (dev->vhostfd >= 0) {
 			int r;
-			int flags;
 
-			flags = fcntl(dev->vhostfd, F_GETFL);
-			if (fcntl(dev->vhostfd, F_SETFL,
-					flags | O_NONBLOCK) == -1) {
-				PMD_DRV_LOG(ERR, "error setting O_NONBLOCK flag");
-				return;
-			}
-			r = recv(dev->vhostfd, buf, 128, MSG_PEEK);
+			/* Not switching the fd to non-blocking, a reconnection
+			 * may wait for a reply on it in another thread.
+			 */
+			r = recv(dev->vhostfd, buf, 128,
+				 MSG_PEEK | MSG_DONTWAIT);
 			if (r == 0 || (r < 0 && errno != EAGAIN)) {
 				dev->status &= (~VIRTIO_NET_S_LINK_UP);
 				PMD_DRV_LOG(ERR, "virtio-user port %u is down",
@@ -146,22 +185,23 @@ virtio_user_read_dev_config(struct virtio_hw *hw, size_t offset,
 				/* This function could be called in the process
 				 * of interrupt handling, callback cannot be
 				 * unregistered here, set an alarm to do it.
+				 * Only one, another one left pending would close
+				 * the fd of the next connection.
 				 */
+				rte_eal_alarm_cancel(virtio_user_delayed_handler,
+						     (void *)hw);
 				rte_eal_alarm_set(1,
 						  virtio_user_delayed_handler,
 						  (void *)hw);
-			} else {
+			} else if (dev->started) {
 				dev->status |= VIRTIO_NET_S_LINK_UP;
 			}
-			if (fcntl(dev->vhostfd, F_SETFL,
-					flags & ~O_NONBLOCK) == -1) {
-				PMD_DRV_LOG(ERR, "error clearing O_NONBLOCK flag");
-				return;
-			}
 		} else if (dev->is_server) {
 			dev->status &= (~VIRTIO_NET_S_LINK_UP);
-			if (virtio_user_server_reconnect(dev) >= 0)
-				dev->status |= VIRTIO_NET_S_LINK_UP;
+			rte_eal_alarm_cancel(virtio_user_server_reconnect_handler,
+					     (void *)hw);
+			rte_eal_alarm_set(1, virtio_user_server_reconnect_handler,
+					  (void *)hw);
 		}
 
 		*(uint16_t *)dst = dev->status;
@@ -279,6 +319,27 @@ virtio_user_setup_queue(struct virtio_hw *hw, struct virtqueue *vq)
 	uint64_t desc_addr, avail_addr, used_addr;
 
 	desc_addr = (uintptr_t)vq->vq_ring_virt_mem;
+
+	if (vtpci_packed_queue(hw)) {
+		avail_addr = desc_addr +
+			vq->vq_nentries * sizeof(struct vring_packed_desc);
+		used_addr = RTE_ALIGN_CEIL(avail_addr +
+				sizeof(struct vring_packed_desc_event),
+				VIRTIO_PCI_VRING_ALIGN);
+
+		dev->packed_vrings[queue_idx].num = vq->vq_nentries;
+		dev->packed_vrings[queue_idx].desc_packed =
+			(void *)(uintptr_t)desc_addr;
+		dev->packed_vrings[queue_idx].driver_event =
+			(void *)(uintptr_t)avail_addr;
+		dev->packed_vrings[queue_idx].device_event =
+			(void *)(uintptr_t)used_addr;
+		dev->packed_queues[queue_idx].used_idx = 0;
+		dev->packed_queues[queue_idx].used_wrap_counter = true;
+
+		return 0;
+	}
+
 	avail_addr = desc_addr + vq->vq_nentries * sizeof(struct vring_desc);
 	used_addr = RTE_ALIGN_CEIL(avail_addr + offsetof(struct vring_avail,
 							 ring[vq->vq_nentries]),
@@ -317,7 +378,10 @@ virtio_user_notify_queue(struct virtio_hw *hw, struct virtqueue *vq)
 	struct virtio_user_dev *dev = virtio_user_get_dev(hw);
 
 	if (hw->cvq && (hw->cvq->vq == vq)) {
-		virtio_user_handle_cq(dev, vq->vq_queue_index);
+		if (vtpci_packed_queue(vq->hw))
+			virtio_user_handle_cq_packed(dev, vq->vq_queue_index);
+		else
+			virtio_user_handle_cq(dev, vq->vq_queue_index);
 		return;
 	}
 
@@ -361,6 +425,11 @@ static const char *valid_args[] = {
 	VIRTIO_USER_ARG_MRG_RXBUF,
 #define VIRTIO_USER_ARG_IN_ORDER       "in_order"
 	VIRTIO_USER_ARG_IN_ORDER,
+#define VIRTIO_USER_ARG_PACKED_VQ      "packed_vq"
+	VIRTIO_USER_ARG_PACKED_VQ,
+	/* parsed by eth_virtio_dev_init() */
+	VIRTIO_ARG_TX_KICK_BATCH,
+	VIRTIO_ARG_TX_KICK_DELAY,
 	NULL
 };
 
@@ -464,6 +533,7 @@ virtio_user_pmd_probe(struct rte_vdev_device *dev)
 	uint64_t server_mode = VIRTIO_USER_DEF_SERVER_MODE;
 	uint64_t mrg_rxbuf = 1;
 	uint64_t in_order = 1;
+	uint64_t packed_vq = 0;
 	char *path = NULL;
 	char *ifname = NULL;
 	char *mac_addr = NULL;
@@ -581,6 +651,15 @@ virtio_user_pmd_probe(struct rte_vdev_device *dev)
 		}
 	}
 
+	if (rte_kvargs_count(kvlist, VIRTIO_USER_ARG_PACKED_VQ) == 1) {
+		if (rte_kvargs_process(kvlist, VIRTIO_USER_ARG_PACKED_VQ,
+				       &get_integer_arg, &packed_vq) < 0) {
+			PMD_INIT_LOG(ERR, "error to parse %s",
+				     VIRTIO_USER_ARG_PACKED_VQ);
+			goto end;
+		}
+	}
+
 	if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
 		struct virtio_user_dev *vu_dev;
 
@@ -598,7 +677,7 @@ virtio_user_pmd_probe(struct rte_vdev_device *dev)
 			vu_dev->is_server = false;
 		if (virtio_user_dev_init(hw->virtio_user_dev, path, queues, cq,
 				 queue_size, mac_addr, &ifname, mrg_rxbuf,
-				 in_order) < 0) {
+				 in_order, packed_vq) < 0) {
 			PMD_INIT_LOG(ERR, "virtio_user_dev_init fails");
 			virtio_user_eth_dev_free(eth_dev);
 			goto end;
@@ -654,6 +733,8 @@ virtio_user_pmd_remove(struct rte_vdev_device *vdev)
 
 	hw = eth_dev->data->dev_private;
 	dev = hw->virtio_user_dev;
+	rte_eal_alarm_cancel(virtio_user_server_reconnect_handler, (void *)hw);
+	rte_eal_alarm_cancel(virtio_user_delayed_handler, (void *)hw);
 	virtio_user_dev_uninit(dev);
 
 	rte_eth_dev_release_port(eth_dev);
@@ -677,4 +758,7 @@ RTE_PMD_REGISTER_PARAM_STRING(net_virtio_user,
 	"iface=<string> "
 	"server=<0|1> "
 	"mrg_rxbuf=<0|1> "
-	"in_order=<0|1>");
+	"in_order=<0|1> "
+	"packed_vq=<0|1> "
+	VIRTIO_ARG_TX_KICK_BATCH "=<int> "
+	VIRTIO_ARG_TX_KICK_DELAY "=<int>");
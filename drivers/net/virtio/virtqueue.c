@@ -54,6 +54,29 @@ virtqueue_detach_unused(struct virtqueue *vq)
 	return NULL;
 }
 
+static void
+virtqueue_rxvq_flush_packed(struct virtqueue *vq)
+{
+	struct vring_packed_desc *descs = vq->vq_ring_packed.desc_packed;
+	struct vq_desc_extra *dxp;
+	uint16_t i, id;
+
+	for (i = 0; i < vq->vq_nentries; i++) {
+		if (!desc_is_used(&descs[vq->vq_used_cons_idx], vq))
+			break;
+		virtio_rmb();
+
+		id = descs[vq->vq_used_cons_idx].id;
+		dxp = &vq->vq_descx[id];
+		if (dxp->cookie != NULL) {
+			rte_pktmbuf_free(dxp->cookie);
+			dxp->cookie = NULL;
+		}
+		vq_used_idx_add_packed(vq, dxp->ndescs);
+		vq_ring_free_id_packed(vq, id);
+	}
+}
+
 /* Flush the elements in the used ring. */
 void
 virtqueue_rxvq_flush(struct virtqueue *vq)
@@ -65,6 +88,11 @@ virtqueue_rxvq_flush(struct virtqueue *vq)
 	uint16_t used_idx, desc_idx;
 	uint16_t nb_used, i;
 
+	if (vtpci_packed_queue(hw)) {
+		virtqueue_rxvq_flush_packed(vq);
+		return;
+	}
+
 	nb_used = VIRTQUEUE_NUSED(vq);
 
 	for (i = 0; i < nb_used; i++) {
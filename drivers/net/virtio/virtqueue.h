@@ -158,17 +158,28 @@ struct virtio_pmd_ctrl {
 	uint8_t data[VIRTIO_MAX_CTRL_DATA];
 };
 
+/* Commands in flight on the control queue, each one in its own slot */
+#define VIRTIO_MAX_CTRL_CMDS 16
+#define VIRTIO_CTRL_SLOT_SIZE \
+	RTE_ALIGN_CEIL(sizeof(struct virtio_pmd_ctrl), RTE_CACHE_LINE_SIZE)
+
 struct vq_desc_extra {
 	void *cookie;
 	uint16_t ndescs;
+	uint16_t next; /**< next free buffer id, packed ring only */
 };
 
 struct virtqueue {
 	struct virtio_hw  *hw; /**< virtio_hw structure pointer. */
-	struct vring vq_ring;  /**< vring keeping desc, used and avail */
+	union {
+		struct vring vq_ring;  /**< vring keeping desc, used and avail */
+		/** packed vring keeping desc and the event areas */
+		struct vring_packed vq_ring_packed;
+	};
 	/**
 	 * Last consumed descriptor in the used table,
 	 * trails vq_ring.used->idx.
+	 * On a packed ring, the next descriptor the device will write back.
 	 */
 	uint16_t vq_used_cons_idx;
 	uint16_t vq_nentries;  /**< vring desc numbers */
@@ -176,6 +187,14 @@ struct virtqueue {
 	uint16_t vq_avail_idx; /**< sync until needed */
 	uint16_t vq_free_thresh; /**< free threshold */
 
+	/* Packed ring: AVAIL/USED flags of the next descriptor made available */
+	uint16_t vq_avail_used_flags;
+	bool vq_used_wrap_counter;
+	uint16_t vq_event_flags_shadow; /**< driver event flags, packed ring */
+	/* With the event index: vq_avail_idx at the last kick check */
+	uint16_t vq_kick_idx;
+	bool vq_kick_wrap_counter; /**< avail wrap counter of vq_kick_idx */
+
 	void *vq_ring_virt_mem;  /**< linear address of vring*/
 	unsigned int vq_ring_size;
 
@@ -192,6 +211,7 @@ struct virtqueue {
 	 * Head of the free chain in the descriptor table. If
 	 * there are no free descriptors, this will be set to
 	 * VQ_RING_DESC_CHAIN_END.
+	 * On a packed ring, the free buffer ids are chained in vq_descx.
 	 */
 	uint16_t  vq_desc_head_idx;
 	uint16_t  vq_desc_tail_idx;
@@ -208,6 +228,32 @@ struct virtqueue {
 #define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MIN        1
 #define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MAX        0x8000
 
+/*
+ * With VIRTIO_NET_F_RSS, the receive queue of a packet is selected from
+ * its hash, with VIRTIO_NET_F_HASH_REPORT the hash is reported in the
+ * Rx header. The configuration sets the hash types and the key for both.
+ */
+#define VIRTIO_NET_CTRL_MQ_RSS_CONFIG          1
+#define VIRTIO_NET_CTRL_MQ_HASH_CONFIG         2
+
+struct virtio_net_ctrl_rss {
+	uint32_t hash_types;
+	uint16_t indirection_table_mask;
+	uint16_t unclassified_queue;
+	uint16_t indirection_table[]; /**< indirection_table_mask + 1 */
+} __attribute__((packed));
+
+/*
+ * Follows the indirection table. The hash configuration has the same
+ * layout as an RSS one with a table of one entry: the fields before the
+ * key are reserved and left to zero.
+ */
+struct virtio_net_ctrl_rss_key {
+	uint16_t max_tx_vq;
+	uint8_t hash_key_length;
+	uint8_t hash_key_data[VIRTIO_NET_RSS_KEY_SIZE];
+} __attribute__((packed));
+
 /**
  * This is the first element of the scatter-gather list.  If you don't
  * specify GSO or CSUM features, you can simply ignore the header.
@@ -237,12 +283,28 @@ struct virtio_net_hdr_mrg_rxbuf {
 	uint16_t num_buffers; /**< Number of merged rx buffers */
 };
 
+/**
+ * This is the header with VIRTIO_NET_F_HASH_REPORT. The hash is only
+ * written by the device, it is ignored on transmit.
+ */
+struct virtio_net_hdr_hash_report {
+	struct   virtio_net_hdr_mrg_rxbuf hdr;
+	uint32_t hash_value;
+	uint16_t hash_report; /**< VIRTIO_NET_HASH_REPORT_* */
+	uint16_t padding;
+};
+
+#define VIRTIO_NET_HASH_REPORT_NONE 0
+
 /* Region reserved to allow for transmit header and indirect ring */
 #define VIRTIO_MAX_TX_INDIRECT 8
 struct virtio_tx_region {
-	struct virtio_net_hdr_mrg_rxbuf tx_hdr;
-	struct vring_desc tx_indir[VIRTIO_MAX_TX_INDIRECT]
-			   __attribute__((__aligned__(16)));
+	struct virtio_net_hdr_hash_report tx_hdr;
+	union {
+		struct vring_desc tx_indir[VIRTIO_MAX_TX_INDIRECT];
+		struct vring_packed_desc
+			tx_packed_indir[VIRTIO_MAX_TX_INDIRECT];
+	} __attribute__((__aligned__(16)));
 };
 
 /* Chain all the descriptors in the ring with an END */
@@ -256,22 +318,90 @@ vring_desc_init(struct vring_desc *dp, uint16_t n)
 	dp[i].next = VQ_RING_DESC_CHAIN_END;
 }
 
+/* Chain all the buffer ids of a packed ring in the free list */
+static inline void
+vring_desc_init_packed(struct virtqueue *vq, uint16_t n)
+{
+	uint16_t i;
+
+	for (i = 0; i < n - 1; i++) {
+		vq->vq_ring_packed.desc_packed[i].id = i;
+		vq->vq_descx[i].next = (uint16_t)(i + 1);
+	}
+	vq->vq_ring_packed.desc_packed[i].id = i;
+	vq->vq_descx[i].next = VQ_RING_DESC_CHAIN_END;
+}
+
+/* Indirect tables of a packed ring are read in sequence, without next */
+static inline void
+vring_desc_init_indirect_packed(struct vring_packed_desc *dp, uint16_t n)
+{
+	uint16_t i;
+
+	for (i = 0; i < n; i++) {
+		dp[i].id = i;
+		dp[i].flags = 0;
+	}
+}
+
 /**
  * Tell the backend not to interrupt us.
+ * With the event index on a split ring the flags are left to 0: the used
+ * event is moved just behind the used entries already seen, so it is not
+ * crossed again before the used index wraps around.
  */
 static inline void
 virtqueue_disable_intr(struct virtqueue *vq)
 {
-	vq->vq_ring.avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
+	if (vtpci_packed_queue(vq->hw)) {
+		if (vq->vq_event_flags_shadow != RING_EVENT_FLAGS_DISABLE) {
+			vq->vq_event_flags_shadow = RING_EVENT_FLAGS_DISABLE;
+			vq->vq_ring_packed.driver_event->desc_event_flags =
+				vq->vq_event_flags_shadow;
+		}
+		return;
+	}
+
+	if (vtpci_with_feature(vq->hw, VIRTIO_RING_F_EVENT_IDX))
+		vring_used_event(&vq->vq_ring) =
+			(uint16_t)(vq->vq_used_cons_idx - 1);
+	else
+		vq->vq_ring.avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
 }
 
 /**
  * Tell the backend to interrupt us.
+ * With the event index, only once the next used entry is written: a single
+ * interrupt until the next call, however many bursts the backend completes.
  */
 static inline void
 virtqueue_enable_intr(struct virtqueue *vq)
 {
-	vq->vq_ring.avail->flags &= (~VRING_AVAIL_F_NO_INTERRUPT);
+	if (vtpci_packed_queue(vq->hw)) {
+		uint16_t flags = RING_EVENT_FLAGS_ENABLE;
+
+		if (vtpci_with_feature(vq->hw, VIRTIO_RING_F_EVENT_IDX)) {
+			vq->vq_ring_packed.driver_event->desc_event_off_wrap =
+				vq->vq_used_cons_idx |
+				(uint16_t)vq->vq_used_wrap_counter <<
+					RING_EVENT_WRAP_COUNTER_SHIFT;
+			flags = RING_EVENT_FLAGS_DESC;
+			/* the event offset is valid once the flags are seen */
+			virtio_wmb();
+		}
+
+		if (vq->vq_event_flags_shadow != flags) {
+			vq->vq_event_flags_shadow = flags;
+			vq->vq_ring_packed.driver_event->desc_event_flags =
+				vq->vq_event_flags_shadow;
+		}
+		return;
+	}
+
+	if (vtpci_with_feature(vq->hw, VIRTIO_RING_F_EVENT_IDX))
+		vring_used_event(&vq->vq_ring) = vq->vq_used_cons_idx;
+	else
+		vq->vq_ring.avail->flags &= (~VRING_AVAIL_F_NO_INTERRUPT);
 }
 
 /**
@@ -308,6 +438,46 @@ virtio_get_queue_type(struct virtio_hw *hw, uint16_t vtpci_queue_idx)
 void vq_ring_free_chain(struct virtqueue *vq, uint16_t desc_idx);
 void vq_ring_free_inorder(struct virtqueue *vq, uint16_t desc_idx,
 			  uint16_t num);
+void vq_ring_free_id_packed(struct virtqueue *vq, uint16_t id);
+
+/*
+ * A packed descriptor is used once the device has set both its AVAIL and
+ * USED flags to the wrap counter of the used side.
+ * The other fields must only be read after this check.
+ */
+static inline int
+desc_is_used(struct vring_packed_desc *desc, struct virtqueue *vq)
+{
+	uint16_t used, avail, flags;
+
+	flags = desc->flags;
+	used = !!(flags & VRING_DESC_F_USED(1));
+	avail = !!(flags & VRING_DESC_F_AVAIL(1));
+
+	return avail == used && used == vq->vq_used_wrap_counter;
+}
+
+/* Move to the next slot made available, flipping the avail wrap counter */
+static inline void
+vq_avail_idx_inc_packed(struct virtqueue *vq)
+{
+	if (++vq->vq_avail_idx >= vq->vq_nentries) {
+		vq->vq_avail_idx -= vq->vq_nentries;
+		vq->vq_avail_used_flags ^=
+			VRING_DESC_F_AVAIL(1) | VRING_DESC_F_USED(1);
+	}
+}
+
+/* Skip the slots of a used buffer, flipping the used wrap counter */
+static inline void
+vq_used_idx_add_packed(struct virtqueue *vq, uint16_t num)
+{
+	vq->vq_used_cons_idx += num;
+	if (vq->vq_used_cons_idx >= vq->vq_nentries) {
+		vq->vq_used_cons_idx -= vq->vq_nentries;
+		vq->vq_used_wrap_counter ^= 1;
+	}
+}
 
 static inline void
 vq_update_avail_idx(struct virtqueue *vq)
@@ -333,10 +503,65 @@ vq_update_avail_ring(struct virtqueue *vq, uint16_t desc_idx)
 	vq->vq_avail_idx++;
 }
 
+/*
+ * With the event index, kick only if the avail event of the backend is
+ * among the entries made available since the last check: a backend that
+ * is still polling has not asked for one yet.
+ */
 static inline int
 virtqueue_kick_prepare(struct virtqueue *vq)
 {
-	return !(vq->vq_ring.used->flags & VRING_USED_F_NO_NOTIFY);
+	uint16_t old, new;
+
+	if (!vtpci_with_feature(vq->hw, VIRTIO_RING_F_EVENT_IDX))
+		return !(vq->vq_ring.used->flags & VRING_USED_F_NO_NOTIFY);
+
+	/* Ensure the new avail index is seen before reading the event */
+	virtio_mb();
+	old = vq->vq_kick_idx;
+	new = vq->vq_avail_idx;
+	vq->vq_kick_idx = new;
+
+	return vring_need_event(vring_avail_event(&vq->vq_ring), new, old);
+}
+
+static inline int
+virtqueue_kick_prepare_packed(struct virtqueue *vq)
+{
+	struct vring_packed_desc_event *event;
+	uint16_t flags, off_wrap, event_idx, old, new;
+	bool wrap_counter;
+
+	/* Ensure the made available descriptors are seen before the flags */
+	virtio_mb();
+	event = vq->vq_ring_packed.device_event;
+	flags = event->desc_event_flags;
+
+	if (!vtpci_with_feature(vq->hw, VIRTIO_RING_F_EVENT_IDX))
+		return flags != RING_EVENT_FLAGS_DISABLE;
+
+	/*
+	 * The indexes restart at every lap of the ring: put the old one and
+	 * the event in the lap of the new one, as vring_need_event() expects.
+	 */
+	old = vq->vq_kick_idx;
+	new = vq->vq_avail_idx;
+	wrap_counter = !!(vq->vq_avail_used_flags & VRING_DESC_F_AVAIL(1));
+	if (wrap_counter != vq->vq_kick_wrap_counter)
+		old -= vq->vq_nentries;
+	vq->vq_kick_idx = new;
+	vq->vq_kick_wrap_counter = wrap_counter;
+
+	if (flags != RING_EVENT_FLAGS_DESC)
+		return flags != RING_EVENT_FLAGS_DISABLE;
+
+	virtio_rmb();
+	off_wrap = event->desc_event_off_wrap;
+	event_idx = off_wrap & ~(1 << RING_EVENT_WRAP_COUNTER_SHIFT);
+	if ((off_wrap >> RING_EVENT_WRAP_COUNTER_SHIFT) != wrap_counter)
+		event_idx -= vq->vq_nentries;
+
+	return vring_need_event(event_idx, new, old);
 }
 
 static inline void
@@ -353,6 +578,18 @@ virtqueue_notify(struct virtqueue *vq)
 #ifdef RTE_LIBRTE_VIRTIO_DEBUG_DUMP
 #define VIRTQUEUE_DUMP(vq) do { \
 	uint16_t used_idx, nused; \
+	if (vtpci_packed_queue((vq)->hw)) { \
+		PMD_INIT_LOG(DEBUG, \
+		  "VQ: - size=%d; free=%d; desc_head_idx=%d;" \
+		  " avail_idx=%d; used_cons_idx=%d; used_wrap_counter=%d;" \
+		  " driver_event.flags=0x%x; device_event.flags=0x%x", \
+		  (vq)->vq_nentries, (vq)->vq_free_cnt, \
+		  (vq)->vq_desc_head_idx, (vq)->vq_avail_idx, \
+		  (vq)->vq_used_cons_idx, (vq)->vq_used_wrap_counter, \
+		  (vq)->vq_ring_packed.driver_event->desc_event_flags, \
+		  (vq)->vq_ring_packed.device_event->desc_event_flags); \
+		break; \
+	} \
 	used_idx = (vq)->vq_ring.used->idx; \
 	nused = (uint16_t)(used_idx - (vq)->vq_used_cons_idx); \
 	PMD_INIT_LOG(DEBUG, \
@@ -60,6 +60,9 @@
 
 static const uint32_t rxprod_reg[2] = {VMXNET3_REG_RXPROD, VMXNET3_REG_RXPROD2};
 
+/* Number of mbufs allocated on Rx, or freed on Tx completion, at once. */
+#define VMXNET3_MBUF_BULK	32
+
 static int vmxnet3_post_rx_bufs(vmxnet3_rx_queue_t*, uint8_t);
 static void vmxnet3_tq_tx_complete(vmxnet3_tx_queue_t *);
 #ifdef RTE_LIBRTE_VMXNET3_DEBUG_DRIVER_NOT_USED
@@ -296,18 +299,17 @@ vmxnet3_dev_clear_queues(struct rte_eth_dev *dev)
 }
 
 static int
-vmxnet3_unmap_pkt(uint16_t eop_idx, vmxnet3_tx_queue_t *txq)
+vmxnet3_unmap_pkt(uint16_t eop_idx, vmxnet3_tx_queue_t *txq,
+		  struct rte_mbuf **mbuf)
 {
 	int completed = 0;
-	struct rte_mbuf *mbuf;
 
-	/* Release cmd_ring descriptor and free mbuf */
+	/* Release cmd_ring descriptor, mbuf is freed by the caller */
 	RTE_ASSERT(txq->cmd_ring.base[eop_idx].txd.eop == 1);
 
-	mbuf = txq->cmd_ring.buf_info[eop_idx].m;
-	if (mbuf == NULL)
+	*mbuf = txq->cmd_ring.buf_info[eop_idx].m;
+	if (*mbuf == NULL)
 		rte_panic("EOP desc does not point to a valid mbuf");
-	rte_pktmbuf_free(mbuf);
 
 	txq->cmd_ring.buf_info[eop_idx].m = NULL;
 
@@ -331,15 +333,38 @@ vmxnet3_tq_tx_complete(vmxnet3_tx_queue_t *txq)
 	vmxnet3_comp_ring_t *comp_ring = &txq->comp_ring;
 	struct Vmxnet3_TxCompDesc *tcd = (struct Vmxnet3_TxCompDesc *)
 		(comp_ring->base + comp_ring->next2proc);
+	struct rte_mbuf *free[VMXNET3_MBUF_BULK];
+	struct rte_mbuf *mbuf;
+	unsigned int nb_free = 0;
 
 	while (tcd->gen == comp_ring->gen) {
-		completed += vmxnet3_unmap_pkt(tcd->txdIdx, txq);
+		completed += vmxnet3_unmap_pkt(tcd->txdIdx, txq, &mbuf);
+
+		/* Put single segment mbufs back to their pool in bulk */
+		if (likely(mbuf->nb_segs == 1)) {
+			mbuf = rte_pktmbuf_prefree_seg(mbuf);
+		} else {
+			rte_pktmbuf_free(mbuf);
+			mbuf = NULL;
+		}
+		if (likely(mbuf != NULL)) {
+			if (nb_free == VMXNET3_MBUF_BULK ||
+			    (nb_free > 0 && free[0]->pool != mbuf->pool)) {
+				rte_mempool_put_bulk(free[0]->pool,
+						     (void **)free, nb_free);
+				nb_free = 0;
+			}
+			free[nb_free++] = mbuf;
+		}
 
 		vmxnet3_comp_ring_adv_next2proc(comp_ring);
 		tcd = (struct Vmxnet3_TxCompDesc *)(comp_ring->base +
 						    comp_ring->next2proc);
 	}
 
+	if (nb_free > 0)
+		rte_mempool_put_bulk(free[0]->pool, (void **)free, nb_free);
+
 	PMD_TX_LOG(DEBUG, "Processed %d tx comps & command descs.", completed);
 }
 
@@ -563,13 +588,18 @@ vmxnet3_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts,
 		rte_compiler_barrier();
 		gdesc->dword[2] ^= VMXNET3_TXD_GEN;
 
-		txq_ctrl->txNumDeferred = rte_cpu_to_le_32(deferred);
 		nb_tx++;
 	}
 
 	PMD_TX_LOG(DEBUG, "vmxnet3 txThreshold: %u", rte_le_to_cpu_32(txq_ctrl->txThreshold));
 
-	if (deferred >= rte_le_to_cpu_32(txq_ctrl->txThreshold)) {
+	/*
+	 * The shared deferred count and the doorbell, whose write is a VM
+	 * exit, are updated once for the whole burst.
+	 */
+	if (deferred < rte_le_to_cpu_32(txq_ctrl->txThreshold)) {
+		txq_ctrl->txNumDeferred = rte_cpu_to_le_32(deferred);
+	} else {
 		txq_ctrl->txNumDeferred = 0;
 		/* Notify vSwitch that packets are available. */
 		VMXNET3_WRITE_BAR0_REG(hw, (VMXNET3_REG_TXPROD + txq->queue_id * VMXNET3_REG_ALIGN),
@@ -827,6 +857,10 @@ vmxnet3_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 	Vmxnet3_RxDesc *rxd;
 	struct rte_mbuf *rxm = NULL;
 	struct vmxnet3_hw *hw;
+	struct rte_mbuf *newms[VMXNET3_MBUF_BULK];
+	unsigned int newm_idx = 0, newm_n = 0;
+	uint8_t renewed[VMXNET3_RX_CMDRING_SIZE] = { 0 };
+	uintptr_t p;
 
 	nb_rx = 0;
 	ring_idx = 0;
@@ -849,12 +883,24 @@ vmxnet3_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 		if (nb_rx >= nb_pkts)
 			break;
 
-		newm = rte_mbuf_raw_alloc(rxq->mp);
-		if (unlikely(newm == NULL)) {
-			PMD_RX_LOG(ERR, "Error allocating mbuf");
-			rxq->stats.rx_buf_alloc_failure++;
-			break;
+		/* Allocate the replacement mbufs in bulk, or one if short */
+		if (newm_idx == newm_n) {
+			newm_idx = 0;
+			newm_n = RTE_MIN(nb_pkts - nb_rx, VMXNET3_MBUF_BULK);
+			if (unlikely(rte_mempool_get_bulk(rxq->mp,
+							  (void **)newms,
+							  newm_n) != 0)) {
+				newm_n = 1;
+				newms[0] = rte_mbuf_raw_alloc(rxq->mp);
+				if (unlikely(newms[0] == NULL)) {
+					newm_n = 0;
+					PMD_RX_LOG(ERR, "Error allocating mbuf");
+					rxq->stats.rx_buf_alloc_failure++;
+					break;
+				}
+			}
 		}
+		newm = newms[newm_idx++];
 
 		idx = rcd->rxdIdx;
 		ring_idx = vmxnet3_get_ring_idx(hw, rcd->rqID);
@@ -900,12 +946,11 @@ vmxnet3_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 		}
 
 		/* Initialize newly received packet buffer */
-		rxm->port = rxq->port_id;
-		rxm->nb_segs = 1;
+		p = (uintptr_t)&rxm->rearm_data;
+		*(uint64_t *)p = rxq->mbuf_initializer;
 		rxm->next = NULL;
 		rxm->pkt_len = (uint16_t)rcd->len;
 		rxm->data_len = (uint16_t)rcd->len;
-		rxm->data_off = RTE_PKTMBUF_HEADROOM;
 		rxm->ol_flags = 0;
 		rxm->vlan_tci = 0;
 		rxm->packet_type = 0;
@@ -973,15 +1018,13 @@ vmxnet3_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 
 		/* It's time to renew descriptors */
 		vmxnet3_renew_desc(rxq, ring_idx, newm);
-		if (unlikely(rxq->shared->ctrl.updateRxProd)) {
-			VMXNET3_WRITE_BAR0_REG(hw, rxprod_reg[ring_idx] + (rxq->queue_id * VMXNET3_REG_ALIGN),
-					       rxq->cmd_ring[ring_idx].next2fill);
-		}
+		renewed[ring_idx] = 1;
 
 		/* Advance to the next descriptor in comp_ring */
 		vmxnet3_comp_ring_adv_next2proc(&rxq->comp_ring);
 
 		rcd = &rxq->comp_ring.base[rxq->comp_ring.next2proc].rcd;
+		rte_prefetch0(rcd);
 		nb_rxd++;
 		if (nb_rxd > rxq->cmd_ring[0].size) {
 			PMD_RX_LOG(ERR, "Used up quota of receiving packets,"
@@ -990,6 +1033,21 @@ vmxnet3_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 		}
 	}
 
+	/* Give back the replacement mbufs allocated in excess */
+	if (newm_idx != newm_n)
+		rte_mempool_put_bulk(rxq->mp, (void **)&newms[newm_idx],
+				     newm_n - newm_idx);
+
+	/* Notify the device once per ring of the renewed descriptors */
+	if (unlikely(rxq->shared->ctrl.updateRxProd)) {
+		for (ring_idx = 0; ring_idx < VMXNET3_RX_CMDRING_SIZE; ring_idx++) {
+			if (!renewed[ring_idx])
+				continue;
+			VMXNET3_WRITE_BAR0_REG(hw, rxprod_reg[ring_idx] + (rxq->queue_id * VMXNET3_REG_ALIGN),
+					       rxq->cmd_ring[ring_idx].next2fill);
+		}
+	}
+
 	if (unlikely(nb_rxd == 0)) {
 		uint32_t avail;
 		for (ring_idx = 0; ring_idx < VMXNET3_RX_CMDRING_SIZE; ring_idx++) {
@@ -1123,6 +1181,8 @@ vmxnet3_dev_rx_queue_setup(struct rte_eth_dev *dev,
 	struct vmxnet3_cmd_ring *ring0, *ring1, *ring;
 	struct vmxnet3_comp_ring *comp_ring;
 	struct vmxnet3_rx_data_ring *data_ring;
+	struct rte_mbuf mb_def = { .buf_addr = 0 };
+	uintptr_t p;
 	int size;
 	uint8_t i;
 	char mem_name[32];
@@ -1147,6 +1207,16 @@ vmxnet3_dev_rx_queue_setup(struct rte_eth_dev *dev,
 	rxq->data_desc_size = hw->rxdata_desc_size;
 	rxq->stopped = TRUE;
 
+	/* Default rearm_data written to the received mbufs at once */
+	mb_def.nb_segs = 1;
+	mb_def.data_off = RTE_PKTMBUF_HEADROOM;
+	mb_def.port = rxq->port_id;
+	rte_mbuf_refcnt_set(&mb_def, 1);
+	/* prevent compiler reordering: rearm_data covers previous fields */
+	rte_compiler_barrier();
+	p = (uintptr_t)&mb_def.rearm_data;
+	rxq->mbuf_initializer = *(uint64_t *)p;
+
 	ring0 = &rxq->cmd_ring[0];
 	ring1 = &rxq->cmd_ring[1];
 	comp_ring = &rxq->comp_ring;
@@ -708,6 +708,9 @@ rte_qdma_vq_destroy(uint16_t vq_id)
 
 	rte_spinlock_lock(&qdma_dev.lock);
 
+	rte_free(qdma_vq->dma_jobs);
+	rte_free(qdma_vq->dma_free_jobs);
+
 	if (qdma_vq->exclusive_hw_queue)
 		free_hw_queue(qdma_vq->hw_queue);
 	else {
@@ -740,7 +743,117 @@ rte_qdma_destroy(void)
 	rte_qdma_reset();
 }
 
-static const struct rte_rawdev_ops dpaa2_qdma_ops;
+static int
+dpaa2_qdma_vq_alloc_dma_jobs(struct qdma_virt_queue *qdma_vq)
+{
+	int i;
+
+	qdma_vq->dma_jobs = rte_zmalloc(NULL,
+			QDMA_DMA_COPY_JOBS * sizeof(struct rte_qdma_job), 0);
+	qdma_vq->dma_free_jobs = rte_zmalloc(NULL,
+			QDMA_DMA_COPY_JOBS * sizeof(struct rte_qdma_job *), 0);
+	if (!qdma_vq->dma_jobs || !qdma_vq->dma_free_jobs) {
+		DPAA2_QDMA_ERR("Memory allocation failed for DMA copy jobs");
+		rte_free(qdma_vq->dma_jobs);
+		rte_free(qdma_vq->dma_free_jobs);
+		qdma_vq->dma_jobs = NULL;
+		qdma_vq->dma_free_jobs = NULL;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < QDMA_DMA_COPY_JOBS; i++)
+		qdma_vq->dma_free_jobs[i] = &qdma_vq->dma_jobs[i];
+	qdma_vq->dma_nb_free = QDMA_DMA_COPY_JOBS;
+
+	return 0;
+}
+
+/*
+ * rawdev DMA copy API, whose queues are the VQs created by
+ * rte_qdma_vq_create(). The copies are started at enqueue.
+ */
+static int
+dpaa2_qdma_dma_enqueue(struct rte_rawdev *rawdev __rte_unused,
+		       uint16_t queue_id,
+		       const struct rte_rawdev_dma_copy *copies,
+		       uint16_t nb_copies)
+{
+	struct qdma_virt_queue *qdma_vq;
+	struct rte_qdma_job *job;
+	int i, ret = 0;
+
+	if (queue_id >= qdma_dev.max_vqs || !qdma_vqs[queue_id].in_use)
+		return -EINVAL;
+	qdma_vq = &qdma_vqs[queue_id];
+
+	if (unlikely(!qdma_vq->dma_jobs)) {
+		ret = dpaa2_qdma_vq_alloc_dma_jobs(qdma_vq);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < nb_copies && qdma_vq->dma_nb_free > 0; i++) {
+		job = qdma_vq->dma_free_jobs[qdma_vq->dma_nb_free - 1];
+		job->src = copies[i].src;
+		job->dest = copies[i].dst;
+		job->len = copies[i].length;
+		job->flags = RTE_QDMA_JOB_SRC_PHY | RTE_QDMA_JOB_DEST_PHY;
+		job->cnxt = copies[i].user_data;
+		job->status = 0;
+
+		ret = rte_qdma_vq_enqueue(queue_id, job);
+		if (ret < 0)
+			break;
+		qdma_vq->dma_nb_free--;
+	}
+
+	/* An empty FLE pool means that the device is full */
+	if (i == 0 && ret < 0 && ret != -ENOENT)
+		return ret;
+
+	return i;
+}
+
+static int
+dpaa2_qdma_dma_submit(struct rte_rawdev *rawdev __rte_unused,
+		      uint16_t queue_id)
+{
+	if (queue_id >= qdma_dev.max_vqs || !qdma_vqs[queue_id].in_use)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int
+dpaa2_qdma_dma_completed(struct rte_rawdev *rawdev __rte_unused,
+			 uint16_t queue_id,
+			 struct rte_rawdev_dma_completion *cpls,
+			 uint16_t nb_cpls)
+{
+	struct rte_qdma_job *jobs[QDMA_DEQUEUE_BUDGET];
+	struct qdma_virt_queue *qdma_vq;
+	int i, nb_jobs;
+
+	if (queue_id >= qdma_dev.max_vqs || !qdma_vqs[queue_id].in_use)
+		return -EINVAL;
+	qdma_vq = &qdma_vqs[queue_id];
+
+	nb_jobs = rte_qdma_vq_dequeue_multi(queue_id, jobs,
+			RTE_MIN(nb_cpls, QDMA_DEQUEUE_BUDGET));
+	for (i = 0; i < nb_jobs; i++) {
+		cpls[i].user_data = jobs[i]->cnxt;
+		cpls[i].status = jobs[i]->status ? -EIO : 0;
+		qdma_vq->dma_free_jobs[qdma_vq->dma_nb_free++] = jobs[i];
+	}
+
+	return nb_jobs;
+}
+
+static const struct rte_rawdev_ops dpaa2_qdma_ops = {
+	.dma_enqueue = dpaa2_qdma_dma_enqueue,
+	.dma_submit = dpaa2_qdma_dma_submit,
+	.dma_completed = dpaa2_qdma_dma_completed,
+};
 
 static int
 add_hw_queues_to_list(struct dpaa2_dpdmai_dev *dpdmai_dev)
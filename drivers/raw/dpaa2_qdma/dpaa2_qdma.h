@@ -44,6 +44,9 @@ struct qdma_io_meta;
  */
 #define QDMA_DEQUEUE_BUDGET		64
 
+/** Maximum number of in flight copies of a VQ through the rawdev DMA API */
+#define QDMA_DMA_COPY_JOBS		1024
+
 /**
  * Represents a QDMA device.
  * A single QDMA device exists which is combination of multiple DPDMAI rawdev's.
@@ -100,6 +103,12 @@ struct qdma_virt_queue {
 	uint64_t num_enqueues;
 	/* Total number of dequeues from this VQ */
 	uint64_t num_dequeues;
+	/** Jobs of the rawdev DMA copy API, allocated on first use */
+	struct rte_qdma_job *dma_jobs;
+	/** Stack of the free jobs of the rawdev DMA copy API */
+	struct rte_qdma_job **dma_free_jobs;
+	/** Number of free jobs of the rawdev DMA copy API */
+	uint16_t dma_nb_free;
 };
 
 /** Represents a QDMA per core hw queues allocation in virtual mode */
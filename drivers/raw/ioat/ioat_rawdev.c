@@ -0,0 +1,456 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_dev.h>
+#include <rte_io.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_memory.h>
+#include <rte_memzone.h>
+#include <rte_prefetch.h>
+#include <rte_bus_pci.h>
+
+#include <rte_rawdev.h>
+#include <rte_rawdev_pmd.h>
+
+#include "rte_ioat_rawdev.h"
+#include "ioat_spec.h"
+
+/* Dynamic log type identifier */
+static int ioat_pmd_logtype;
+
+#define IOAT_PMD_LOG(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, ioat_pmd_logtype, "%s(): " fmt "\n", \
+		__func__, ##args)
+
+#define IOAT_PMD_DEBUG(fmt, args...) IOAT_PMD_LOG(DEBUG, fmt, ## args)
+#define IOAT_PMD_INFO(fmt, args...) IOAT_PMD_LOG(INFO, fmt, ## args)
+#define IOAT_PMD_ERR(fmt, args...) IOAT_PMD_LOG(ERR, fmt, ## args)
+
+#define IOAT_DEF_RING_SIZE 512
+#define IOAT_RESET_RETRIES 200
+/* The completion address is updated at least every 16 descriptors */
+#define IOAT_COMPLETION_UPDATE_MASK 0xF
+
+/* Private data of an I/OAT channel */
+struct ioat_rawdev {
+	/* Completion writeback: address of the last completed descriptor and
+	 * channel state in the low bits, written by the hardware.
+	 */
+	volatile uint64_t status __rte_cache_aligned;
+	rte_iova_t status_addr;
+
+	volatile struct ioat_registers *regs;
+	struct rte_pci_device *pci_dev;
+
+	/* Ring of descriptors, chained in a loop */
+	const struct rte_memzone *desc_mz;
+	struct ioat_desc *desc_ring;
+	rte_iova_t desc_ring_iova;
+	/* User data of the copies, indexed as the descriptors */
+	uint64_t *user_data;
+	unsigned short ring_size;
+
+	/* Free running indexes of the ring */
+	unsigned short next_read;
+	unsigned short next_write;
+	unsigned short next_submit;
+
+	uint64_t enqueued;
+	uint64_t enqueue_failed;
+	uint64_t started;
+	uint64_t completed;
+};
+
+static inline struct ioat_rawdev *
+ioat_rawdev_get_priv(const struct rte_rawdev *rawdev)
+{
+	return rawdev->dev_private;
+}
+
+/* Reset the channel, dropping all its descriptors */
+static int
+ioat_reset_channel(struct ioat_rawdev *ioat)
+{
+	int retry = 0;
+
+	ioat->regs->chancmd = IOAT_CHANCMD_SUSPEND;
+	rte_delay_ms(1);
+	ioat->regs->chancmd = IOAT_CHANCMD_RESET;
+	rte_delay_ms(1);
+	while (ioat->regs->chancmd & IOAT_CHANCMD_RESET) {
+		ioat->regs->chainaddr = 0;
+		rte_delay_ms(1);
+		if (++retry >= IOAT_RESET_RETRIES) {
+			IOAT_PMD_ERR("Channel reset timeout, chansts %#" PRIx64,
+				     ioat->regs->chansts);
+			return -EIO;
+		}
+	}
+
+	ioat->regs->chanctrl = IOAT_CHANCTRL_ANY_ERR_ABORT_EN |
+			IOAT_CHANCTRL_ERR_COMPLETION_EN;
+
+	return 0;
+}
+
+static void
+ioat_rawdev_info_get(struct rte_rawdev *dev, rte_rawdev_obj_t dev_info)
+{
+	struct rte_ioat_rawdev_config *cfg = dev_info;
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+
+	if (cfg != NULL)
+		cfg->ring_size = ioat->ring_size;
+}
+
+static int
+ioat_rawdev_configure(const struct rte_rawdev *dev, rte_rawdev_obj_t config)
+{
+	struct rte_ioat_rawdev_config *cfg = config;
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+	unsigned short ring_size = IOAT_DEF_RING_SIZE;
+	char mz_name[RTE_MEMZONE_NAMESIZE];
+	unsigned short i;
+
+	if (cfg != NULL)
+		ring_size = cfg->ring_size;
+	if (!rte_is_power_of_2(ring_size) ||
+	    ring_size > RTE_IOAT_RING_SIZE_MAX) {
+		IOAT_PMD_ERR("Invalid ring size %u, must be a power of 2 <= %u",
+			     ring_size, RTE_IOAT_RING_SIZE_MAX);
+		return -EINVAL;
+	}
+
+	rte_memzone_free(ioat->desc_mz);
+	rte_free(ioat->user_data);
+	ioat->desc_mz = NULL;
+	ioat->ring_size = 0;
+
+	snprintf(mz_name, sizeof(mz_name), "ioat_%u_desc", dev->dev_id);
+	ioat->desc_mz = rte_memzone_reserve_aligned(mz_name,
+			ring_size * sizeof(*ioat->desc_ring), dev->socket_id,
+			RTE_MEMZONE_IOVA_CONTIG, sizeof(*ioat->desc_ring));
+	ioat->user_data = rte_zmalloc_socket(NULL,
+			ring_size * sizeof(*ioat->user_data),
+			RTE_CACHE_LINE_SIZE, dev->socket_id);
+	if (ioat->desc_mz == NULL || ioat->user_data == NULL) {
+		IOAT_PMD_ERR("Unable to allocate ring of %u descriptors",
+			     ring_size);
+		rte_memzone_free(ioat->desc_mz);
+		rte_free(ioat->user_data);
+		ioat->desc_mz = NULL;
+		ioat->user_data = NULL;
+		return -ENOMEM;
+	}
+
+	ioat->desc_ring = ioat->desc_mz->addr;
+	ioat->desc_ring_iova = ioat->desc_mz->iova;
+	ioat->ring_size = ring_size;
+
+	/* Chain the descriptors in a loop */
+	memset(ioat->desc_ring, 0, ring_size * sizeof(*ioat->desc_ring));
+	for (i = 0; i < ring_size; i++)
+		ioat->desc_ring[i].next = ioat->desc_ring_iova +
+			((i + 1) & (ring_size - 1)) * sizeof(*ioat->desc_ring);
+
+	return 0;
+}
+
+static int
+ioat_rawdev_start(struct rte_rawdev *dev)
+{
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+	int ret;
+
+	if (ioat->ring_size == 0) {
+		ret = ioat_rawdev_configure(dev, NULL);
+		if (ret != 0)
+			return ret;
+	}
+
+	ret = ioat_reset_channel(ioat);
+	if (ret != 0)
+		return ret;
+
+	ioat->next_read = 0;
+	ioat->next_write = 0;
+	ioat->next_submit = 0;
+
+	/* Nothing is completed: the last completed descriptor is the one
+	 * preceding the first one.
+	 */
+	ioat->status = ioat->desc_ring_iova +
+			(ioat->ring_size - 1) * sizeof(*ioat->desc_ring);
+
+	ioat->regs->chainaddr = ioat->desc_ring_iova;
+	ioat->regs->chancmp = ioat->status_addr;
+
+	return 0;
+}
+
+static void
+ioat_rawdev_stop(struct rte_rawdev *dev)
+{
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+
+	ioat->regs->chancmd = IOAT_CHANCMD_SUSPEND;
+}
+
+static int
+ioat_rawdev_close(struct rte_rawdev *dev)
+{
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+
+	rte_memzone_free(ioat->desc_mz);
+	rte_free(ioat->user_data);
+	ioat->desc_mz = NULL;
+	ioat->user_data = NULL;
+	ioat->ring_size = 0;
+
+	return 0;
+}
+
+static uint16_t
+ioat_rawdev_queue_count(struct rte_rawdev *dev __rte_unused)
+{
+	return 1;
+}
+
+static int
+ioat_rawdev_dump(struct rte_rawdev *dev, FILE *f)
+{
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+
+	fprintf(f, "ring size: %u\n", ioat->ring_size);
+	fprintf(f, "chansts: %#" PRIx64 ", chanerr: %#x\n",
+		ioat->regs->chansts, ioat->regs->chanerr);
+	fprintf(f, "enqueued: %" PRIu64 ", enqueue failed: %" PRIu64 "\n",
+		ioat->enqueued, ioat->enqueue_failed);
+	fprintf(f, "started: %" PRIu64 ", completed: %" PRIu64 "\n",
+		ioat->started, ioat->completed);
+
+	return 0;
+}
+
+static int
+ioat_rawdev_dma_enqueue(struct rte_rawdev *dev, uint16_t queue_id,
+			const struct rte_rawdev_dma_copy *copies,
+			uint16_t nb_copies)
+{
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+	unsigned short mask = ioat->ring_size - 1;
+	unsigned short write = ioat->next_write;
+	unsigned short space;
+	struct ioat_desc *desc;
+	uint16_t i;
+
+	if (queue_id != 0)
+		return -EINVAL;
+
+	/* One descriptor is kept free, to tell a full ring from an empty one
+	 * in the completion address.
+	 */
+	space = (unsigned short)(mask - (write - ioat->next_read));
+	if (nb_copies > space) {
+		ioat->enqueue_failed += nb_copies - space;
+		nb_copies = space;
+	}
+
+	for (i = 0; i < nb_copies; i++, write++) {
+		desc = &ioat->desc_ring[write & mask];
+		desc->size = copies[i].length;
+		desc->u.control_raw = (write & IOAT_COMPLETION_UPDATE_MASK) ?
+				0 : IOAT_DESC_CTRL_COMPLETION_UPDATE;
+		desc->src_addr = copies[i].src;
+		desc->dest_addr = copies[i].dst;
+		ioat->user_data[write & mask] = copies[i].user_data;
+	}
+	rte_prefetch0(&ioat->desc_ring[write & mask]);
+
+	ioat->next_write = write;
+	ioat->enqueued += nb_copies;
+
+	return nb_copies;
+}
+
+static int
+ioat_rawdev_dma_submit(struct rte_rawdev *dev, uint16_t queue_id)
+{
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+	unsigned short mask = ioat->ring_size - 1;
+	unsigned short write = ioat->next_write;
+
+	if (queue_id != 0)
+		return -EINVAL;
+	if (write == ioat->next_submit)
+		return 0;
+
+	/* Report the completion of the last copy of the batch */
+	ioat->desc_ring[(unsigned short)(write - 1) & mask].u.control_raw |=
+			IOAT_DESC_CTRL_COMPLETION_UPDATE;
+
+	/* The descriptors must be visible before the doorbell */
+	rte_io_wmb();
+	ioat->regs->dmacount = write;
+
+	ioat->started += (unsigned short)(write - ioat->next_submit);
+	ioat->next_submit = write;
+
+	return 0;
+}
+
+static int
+ioat_rawdev_dma_completed(struct rte_rawdev *dev, uint16_t queue_id,
+			  struct rte_rawdev_dma_completion *cpls,
+			  uint16_t nb_cpls)
+{
+	struct ioat_rawdev *ioat = ioat_rawdev_get_priv(dev);
+	unsigned short mask = ioat->ring_size - 1;
+	unsigned short read = ioat->next_read;
+	unsigned short end_read, count, i;
+	uint64_t status = ioat->status;
+
+	if (queue_id != 0)
+		return -EINVAL;
+
+	if ((status & IOAT_CHANSTS_STATUS) == IOAT_CHANSTS_HALTED) {
+		IOAT_PMD_ERR("Channel halted, chanerr %#x",
+			     ioat->regs->chanerr);
+		return -EIO;
+	}
+
+	end_read = (((status - ioat->desc_ring_iova) /
+			sizeof(*ioat->desc_ring)) + 1) & mask;
+	count = (end_read - (read & mask)) & mask;
+	count = RTE_MIN(count, nb_cpls);
+
+	for (i = 0; i < count; i++) {
+		cpls[i].user_data = ioat->user_data[(read + i) & mask];
+		cpls[i].status = 0;
+	}
+
+	ioat->next_read = read + count;
+	ioat->completed += count;
+
+	return count;
+}
+
+static const struct rte_rawdev_ops ioat_rawdev_ops = {
+	.dev_info_get = ioat_rawdev_info_get,
+	.dev_configure = ioat_rawdev_configure,
+	.dev_start = ioat_rawdev_start,
+	.dev_stop = ioat_rawdev_stop,
+	.dev_close = ioat_rawdev_close,
+	.queue_count = ioat_rawdev_queue_count,
+	.dump = ioat_rawdev_dump,
+	.dma_enqueue = ioat_rawdev_dma_enqueue,
+	.dma_submit = ioat_rawdev_dma_submit,
+	.dma_completed = ioat_rawdev_dma_completed,
+};
+
+static int
+ioat_rawdev_probe(struct rte_pci_driver *drv, struct rte_pci_device *dev)
+{
+	char name[RTE_RAWDEV_NAME_MAX_LEN];
+	struct rte_rawdev *rawdev;
+	struct ioat_rawdev *ioat;
+	int ret;
+
+	rte_pci_device_name(&dev->addr, name, sizeof(name));
+	IOAT_PMD_INFO("Init %s on NUMA node %d", name, dev->device.numa_node);
+
+	rawdev = rte_rawdev_pmd_allocate(name, sizeof(struct ioat_rawdev),
+					 dev->device.numa_node);
+	if (rawdev == NULL) {
+		IOAT_PMD_ERR("Unable to allocate rawdevice");
+		return -ENOMEM;
+	}
+
+	rawdev->dev_ops = &ioat_rawdev_ops;
+	rawdev->device = &dev->device;
+	rawdev->driver_name = drv->driver.name;
+
+	ioat = ioat_rawdev_get_priv(rawdev);
+	ioat->pci_dev = dev;
+	ioat->regs = dev->mem_resource[0].addr;
+	ioat->status_addr = rte_malloc_virt2iova(ioat) +
+			offsetof(struct ioat_rawdev, status);
+
+	if (ioat->regs->cbver < IOAT_VER_3_0) {
+		IOAT_PMD_ERR("Unsupported I/OAT version %#x",
+			     ioat->regs->cbver);
+		ret = -ENODEV;
+		goto cleanup;
+	}
+
+	ret = ioat_reset_channel(ioat);
+	if (ret != 0)
+		goto cleanup;
+
+	return 0;
+
+cleanup:
+	rte_rawdev_pmd_release(rawdev);
+	return ret;
+}
+
+static int
+ioat_rawdev_remove(struct rte_pci_device *dev)
+{
+	char name[RTE_RAWDEV_NAME_MAX_LEN];
+	struct rte_rawdev *rawdev;
+
+	rte_pci_device_name(&dev->addr, name, sizeof(name));
+	IOAT_PMD_INFO("Closing %s on NUMA node %d",
+		      name, dev->device.numa_node);
+
+	rawdev = rte_rawdev_pmd_get_named_dev(name);
+	if (rawdev == NULL)
+		return -EINVAL;
+
+	/* rte_rawdev_close is called by pmd_release */
+	return rte_rawdev_pmd_release(rawdev);
+}
+
+static const struct rte_pci_id pci_id_ioat_map[] = {
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_SKX) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX0) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX1) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX2) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX3) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX4) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX5) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX6) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDX7) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDXE) },
+	{ RTE_PCI_DEVICE(IOAT_VENDOR_ID, IOAT_DEVICE_ID_BDXF) },
+	{ .vendor_id = 0, /* sentinel */ },
+};
+
+static struct rte_pci_driver ioat_pmd_drv = {
+	.id_table = pci_id_ioat_map,
+	.drv_flags = RTE_PCI_DRV_NEED_MAPPING,
+	.probe = ioat_rawdev_probe,
+	.remove = ioat_rawdev_remove,
+};
+
+RTE_PMD_REGISTER_PCI(IOAT_PMD_RAWDEV_NAME, ioat_pmd_drv);
+RTE_PMD_REGISTER_PCI_TABLE(IOAT_PMD_RAWDEV_NAME, pci_id_ioat_map);
+RTE_PMD_REGISTER_KMOD_DEP(IOAT_PMD_RAWDEV_NAME, "* igb_uio | uio_pci_generic | vfio-pci");
+
+RTE_INIT(ioat_pmd_init_log)
+{
+	ioat_pmd_logtype = rte_log_register("rawdev.ioat");
+	if (ioat_pmd_logtype >= 0)
+		rte_log_set_level(ioat_pmd_logtype, RTE_LOG_INFO);
+}
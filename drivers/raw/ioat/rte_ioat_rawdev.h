@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_IOAT_RAWDEV_H_
+#define _RTE_IOAT_RAWDEV_H_
+
+/**
+ * @file rte_ioat_rawdev.h
+ *
+ * Definitions for using the I/OAT (QuickData/CBDMA) rawdev device driver,
+ * whose copies are performed through the DMA copy API of rte_rawdev_dma.h
+ * on queue 0, the single channel of the device.
+ *
+ * @warning
+ * @b EXPERIMENTAL: these structures and APIs may change without prior notice
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Name of the I/OAT rawdev driver */
+#define IOAT_PMD_RAWDEV_NAME rawdev_ioat
+
+/** Maximum number of descriptors of an I/OAT channel */
+#define RTE_IOAT_RING_SIZE_MAX 4096
+
+/**
+ * Configuration of an I/OAT rawdev, given as the dev_private field of the
+ * rte_rawdev_info structure passed to rte_rawdev_configure().
+ */
+struct rte_ioat_rawdev_config {
+	/** Number of descriptors, a power of 2 up to RTE_IOAT_RING_SIZE_MAX */
+	unsigned short ring_size;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_IOAT_RAWDEV_H_ */
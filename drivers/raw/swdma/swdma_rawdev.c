@@ -0,0 +1,320 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_dev.h>
+#include <rte_eal.h>
+#include <rte_kvargs.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_memory.h>
+#include <rte_memcpy.h>
+#include <rte_bus_vdev.h>
+
+#include <rte_rawdev.h>
+#include <rte_rawdev_pmd.h>
+
+#include "swdma_rawdev.h"
+
+/* Dynamic log type identifier */
+int swdma_pmd_logtype;
+
+/**< Software DMA rawdev driver name */
+#define SWDMA_PMD_RAWDEV_NAME rawdev_swdma
+
+static void
+swdma_rawdev_info_get(struct rte_rawdev *dev __rte_unused,
+		      rte_rawdev_obj_t dev_info __rte_unused)
+{
+}
+
+static int
+swdma_rawdev_start(struct rte_rawdev *dev __rte_unused)
+{
+	return 0;
+}
+
+static void
+swdma_rawdev_stop(struct rte_rawdev *dev __rte_unused)
+{
+}
+
+static uint16_t
+swdma_rawdev_queue_count(struct rte_rawdev *dev)
+{
+	return swdma_rawdev_get_priv(dev)->nb_queues;
+}
+
+static int
+swdma_rawdev_dump(struct rte_rawdev *dev, FILE *f)
+{
+	struct swdma_rawdev *swdma = swdma_rawdev_get_priv(dev);
+	struct swdma_queue *q;
+	uint16_t i;
+
+	for (i = 0; i < swdma->nb_queues; i++) {
+		q = &swdma->queues[i];
+		fprintf(f, "queue %u: size %u, enqueued %u, done %u\n", i,
+			q->mask + 1, q->head - q->submitted,
+			q->submitted - q->tail);
+	}
+
+	return 0;
+}
+
+/* Translate an IO address of a copy, NULL if it is not known */
+static inline void *
+swdma_iova2virt(rte_iova_t iova)
+{
+	if (rte_eal_iova_mode() == RTE_IOVA_VA)
+		return (void *)(uintptr_t)iova;
+	return rte_mem_iova2virt(iova);
+}
+
+static int
+swdma_rawdev_dma_enqueue(struct rte_rawdev *dev, uint16_t queue_id,
+			 const struct rte_rawdev_dma_copy *copies,
+			 uint16_t nb_copies)
+{
+	struct swdma_rawdev *swdma = swdma_rawdev_get_priv(dev);
+	struct swdma_queue *q;
+	uint32_t space;
+	uint16_t i;
+
+	if (queue_id >= swdma->nb_queues)
+		return -EINVAL;
+	q = &swdma->queues[queue_id];
+
+	space = q->mask + 1 - (q->head - q->tail);
+	nb_copies = RTE_MIN(nb_copies, space);
+
+	for (i = 0; i < nb_copies; i++)
+		q->ring[(q->head + i) & q->mask].copy = copies[i];
+	q->head += nb_copies;
+
+	return nb_copies;
+}
+
+static int
+swdma_rawdev_dma_submit(struct rte_rawdev *dev, uint16_t queue_id)
+{
+	struct swdma_rawdev *swdma = swdma_rawdev_get_priv(dev);
+	struct swdma_queue *q;
+	struct swdma_slot *slot;
+	void *src, *dst;
+
+	if (queue_id >= swdma->nb_queues)
+		return -EINVAL;
+	q = &swdma->queues[queue_id];
+
+	for (; q->submitted != q->head; q->submitted++) {
+		slot = &q->ring[q->submitted & q->mask];
+		src = swdma_iova2virt(slot->copy.src);
+		dst = swdma_iova2virt(slot->copy.dst);
+		if (src == NULL || dst == NULL) {
+			slot->status = -EFAULT;
+			continue;
+		}
+		rte_memcpy(dst, src, slot->copy.length);
+		slot->status = 0;
+	}
+
+	return 0;
+}
+
+static int
+swdma_rawdev_dma_completed(struct rte_rawdev *dev, uint16_t queue_id,
+			   struct rte_rawdev_dma_completion *cpls,
+			   uint16_t nb_cpls)
+{
+	struct swdma_rawdev *swdma = swdma_rawdev_get_priv(dev);
+	struct swdma_queue *q;
+	struct swdma_slot *slot;
+	uint16_t i;
+
+	if (queue_id >= swdma->nb_queues)
+		return -EINVAL;
+	q = &swdma->queues[queue_id];
+
+	nb_cpls = RTE_MIN(nb_cpls, q->submitted - q->tail);
+	for (i = 0; i < nb_cpls; i++) {
+		slot = &q->ring[(q->tail + i) & q->mask];
+		cpls[i].user_data = slot->copy.user_data;
+		cpls[i].status = slot->status;
+	}
+	q->tail += nb_cpls;
+
+	return nb_cpls;
+}
+
+static const struct rte_rawdev_ops swdma_rawdev_ops = {
+	.dev_info_get = swdma_rawdev_info_get,
+	.dev_start = swdma_rawdev_start,
+	.dev_stop = swdma_rawdev_stop,
+	.queue_count = swdma_rawdev_queue_count,
+	.dump = swdma_rawdev_dump,
+	.dev_selftest = test_rawdev_swdma,
+	.dma_enqueue = swdma_rawdev_dma_enqueue,
+	.dma_submit = swdma_rawdev_dma_submit,
+	.dma_completed = swdma_rawdev_dma_completed,
+};
+
+static void
+swdma_rawdev_free_queues(struct swdma_rawdev *swdma)
+{
+	uint16_t i;
+
+	for (i = 0; i < swdma->nb_queues; i++)
+		rte_free(swdma->queues[i].ring);
+}
+
+static int
+swdma_rawdev_create(const char *name, struct rte_vdev_device *vdev,
+		    int socket_id, uint16_t nb_queues, uint32_t ring_size)
+{
+	struct rte_rawdev *rawdev;
+	struct swdma_rawdev *swdma;
+	struct swdma_queue *q;
+	uint16_t i;
+
+	rawdev = rte_rawdev_pmd_allocate(name, sizeof(struct swdma_rawdev),
+					 socket_id);
+	if (rawdev == NULL) {
+		SWDMA_PMD_ERR("Unable to allocate rawdevice");
+		return -EINVAL;
+	}
+
+	rawdev->dev_ops = &swdma_rawdev_ops;
+	rawdev->device = &vdev->device;
+	rawdev->driver_name = vdev->device.driver->name;
+
+	swdma = swdma_rawdev_get_priv(rawdev);
+	for (i = 0; i < nb_queues; i++) {
+		q = &swdma->queues[i];
+		q->ring = rte_zmalloc_socket(name, ring_size * sizeof(*q->ring),
+					     RTE_CACHE_LINE_SIZE, socket_id);
+		if (q->ring == NULL) {
+			SWDMA_PMD_ERR("Unable to allocate queue %u ring", i);
+			swdma_rawdev_free_queues(swdma);
+			rte_rawdev_pmd_release(rawdev);
+			return -ENOMEM;
+		}
+		q->mask = ring_size - 1;
+		swdma->nb_queues = i + 1;
+	}
+
+	return 0;
+}
+
+static int
+swdma_get_u32(const char *key __rte_unused, const char *value, void *opaque)
+{
+	uint32_t *u32 = opaque;
+	char *end;
+	unsigned long v;
+
+	errno = 0;
+	v = strtoul(value, &end, 0);
+	if (errno != 0 || *end != '\0' || v > UINT32_MAX)
+		return -EINVAL;
+	*u32 = v;
+
+	return 0;
+}
+
+static int
+swdma_rawdev_probe(struct rte_vdev_device *vdev)
+{
+	static const char *const args[] = {
+		SWDMA_QUEUES_ARG,
+		SWDMA_RING_SIZE_ARG,
+		NULL
+	};
+	uint32_t nb_queues = 1, ring_size = SWDMA_DEF_RING_SIZE;
+	struct rte_kvargs *kvlist;
+	const char *params;
+	const char *name;
+
+	name = rte_vdev_device_name(vdev);
+	params = rte_vdev_device_args(vdev);
+	if (params != NULL && params[0] != '\0') {
+		kvlist = rte_kvargs_parse(params, args);
+		if (kvlist == NULL) {
+			SWDMA_PMD_ERR("%s: Invalid parameters '%s'",
+				      name, params);
+			return -EINVAL;
+		}
+		if (rte_kvargs_process(kvlist, SWDMA_QUEUES_ARG,
+				       swdma_get_u32, &nb_queues) != 0 ||
+		    rte_kvargs_process(kvlist, SWDMA_RING_SIZE_ARG,
+				       swdma_get_u32, &ring_size) != 0) {
+			SWDMA_PMD_ERR("%s: Error in parsing args", name);
+			rte_kvargs_free(kvlist);
+			return -EINVAL;
+		}
+		rte_kvargs_free(kvlist);
+	}
+
+	if (nb_queues == 0 || nb_queues > SWDMA_MAX_QUEUES) {
+		SWDMA_PMD_ERR("%s: Invalid number of queues %u, must be <= %u",
+			      name, nb_queues, SWDMA_MAX_QUEUES);
+		return -EINVAL;
+	}
+	if (!rte_is_power_of_2(ring_size) ||
+	    ring_size > SWDMA_MAX_RING_SIZE) {
+		SWDMA_PMD_ERR("%s: Invalid ring size %u, must be a power of 2 <= %u",
+			      name, ring_size, SWDMA_MAX_RING_SIZE);
+		return -EINVAL;
+	}
+
+	SWDMA_PMD_INFO("Init %s on NUMA node %d", name, rte_socket_id());
+
+	return swdma_rawdev_create(name, vdev, rte_socket_id(), nb_queues,
+				   ring_size);
+}
+
+static int
+swdma_rawdev_remove(struct rte_vdev_device *vdev)
+{
+	struct rte_rawdev *rawdev;
+	const char *name;
+
+	name = rte_vdev_device_name(vdev);
+	if (name == NULL)
+		return -EINVAL;
+
+	SWDMA_PMD_INFO("Closing %s on NUMA node %d", name, rte_socket_id());
+
+	rawdev = rte_rawdev_pmd_get_named_dev(name);
+	if (rawdev == NULL)
+		return -EINVAL;
+
+	swdma_rawdev_free_queues(swdma_rawdev_get_priv(rawdev));
+
+	return rte_rawdev_pmd_release(rawdev);
+}
+
+static struct rte_vdev_driver swdma_pmd_drv = {
+	.probe = swdma_rawdev_probe,
+	.remove = swdma_rawdev_remove
+};
+
+RTE_PMD_REGISTER_VDEV(SWDMA_PMD_RAWDEV_NAME, swdma_pmd_drv);
+RTE_PMD_REGISTER_PARAM_STRING(SWDMA_PMD_RAWDEV_NAME,
+	SWDMA_QUEUES_ARG "=<int> "
+	SWDMA_RING_SIZE_ARG "=<int>");
+
+RTE_INIT(swdma_pmd_init_log)
+{
+	swdma_pmd_logtype = rte_log_register("rawdev.swdma");
+	if (swdma_pmd_logtype >= 0)
+		rte_log_set_level(swdma_pmd_logtype, RTE_LOG_INFO);
+}
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef __SWDMA_RAWDEV_H__
+#define __SWDMA_RAWDEV_H__
+
+#include <rte_rawdev.h>
+#include <rte_rawdev_dma.h>
+
+extern int swdma_pmd_logtype;
+
+#define SWDMA_PMD_LOG(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, swdma_pmd_logtype, "%s(): " fmt "\n", \
+		__func__, ##args)
+
+#define SWDMA_PMD_DEBUG(fmt, args...) \
+	SWDMA_PMD_LOG(DEBUG, fmt, ## args)
+#define SWDMA_PMD_INFO(fmt, args...) \
+	SWDMA_PMD_LOG(INFO, fmt, ## args)
+#define SWDMA_PMD_ERR(fmt, args...) \
+	SWDMA_PMD_LOG(ERR, fmt, ## args)
+
+#define SWDMA_QUEUES_ARG	"queues"
+#define SWDMA_RING_SIZE_ARG	"ring_size"
+
+#define SWDMA_MAX_QUEUES	16
+#define SWDMA_DEF_RING_SIZE	1024
+#define SWDMA_MAX_RING_SIZE	(1 << 16)
+
+/** Copy slot of a queue ring */
+struct swdma_slot {
+	struct rte_rawdev_dma_copy copy;
+	int status;
+};
+
+/**
+ * Queue of copies: the copies between tail and submitted are done and wait
+ * for their completion to be read, the copies between submitted and head
+ * are enqueued and wait for the doorbell.
+ */
+struct swdma_queue {
+	struct swdma_slot *ring;
+	uint32_t mask;
+	uint32_t head;
+	uint32_t submitted;
+	uint32_t tail;
+} __rte_cache_aligned;
+
+struct swdma_rawdev {
+	uint16_t nb_queues;
+	struct swdma_queue queues[SWDMA_MAX_QUEUES];
+};
+
+static inline struct swdma_rawdev *
+swdma_rawdev_get_priv(const struct rte_rawdev *rawdev)
+{
+	return rawdev->dev_private;
+}
+
+int test_rawdev_swdma(void);
+
+#endif /* __SWDMA_RAWDEV_H__ */
@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_malloc.h>
+#include <rte_memory.h>
+#include <rte_rawdev.h>
+#include <rte_rawdev_dma.h>
+#include <rte_test.h>
+
+/* Using relative path as swdma_rawdev is not part of exported headers */
+#include "swdma_rawdev.h"
+
+#define TEST_DEV_NAME "rawdev_swdma"
+#define TEST_NB_COPIES 64
+#define TEST_COPY_LEN 1500
+
+/* Copy buffers in a batch, then check the data and the completions */
+static int
+test_swdma_copies(uint16_t dev_id, char *src, char *dst)
+{
+	struct rte_rawdev_dma_copy copies[TEST_NB_COPIES];
+	struct rte_rawdev_dma_completion cpls[TEST_NB_COPIES];
+	unsigned int i;
+	int n, done = 0;
+
+	for (i = 0; i < TEST_NB_COPIES * TEST_COPY_LEN; i++)
+		src[i] = (char)(i * 7);
+	memset(dst, 0, TEST_NB_COPIES * TEST_COPY_LEN);
+
+	for (i = 0; i < TEST_NB_COPIES; i++) {
+		copies[i].src = rte_malloc_virt2iova(src + i * TEST_COPY_LEN);
+		copies[i].dst = rte_malloc_virt2iova(dst + i * TEST_COPY_LEN);
+		/* Vary the length to cover the tails of the copies */
+		copies[i].length = TEST_COPY_LEN - i;
+		copies[i].user_data = i;
+	}
+
+	n = rte_rawdev_dma_enqueue(dev_id, 0, copies, TEST_NB_COPIES);
+	RTE_TEST_ASSERT_EQUAL(n, TEST_NB_COPIES, "Enqueue failed: %d", n);
+
+	n = rte_rawdev_dma_completed(dev_id, 0, cpls, TEST_NB_COPIES);
+	RTE_TEST_ASSERT_EQUAL(n, 0, "Copies completed before submit");
+
+	RTE_TEST_ASSERT_SUCCESS(rte_rawdev_dma_submit(dev_id, 0),
+				"Submit failed");
+
+	while (done < TEST_NB_COPIES) {
+		n = rte_rawdev_dma_completed(dev_id, 0, &cpls[done],
+					     TEST_NB_COPIES - done);
+		RTE_TEST_ASSERT(n >= 0, "Completion polling failed: %d", n);
+		done += n;
+	}
+
+	for (i = 0; i < TEST_NB_COPIES; i++) {
+		RTE_TEST_ASSERT_EQUAL(cpls[i].status, 0,
+				      "Copy %u failed", i);
+		RTE_TEST_ASSERT_EQUAL(cpls[i].user_data, i,
+				      "Copy %u completed out of order", i);
+		RTE_TEST_ASSERT_SUCCESS(memcmp(dst + i * TEST_COPY_LEN,
+					       src + i * TEST_COPY_LEN,
+					       TEST_COPY_LEN - i),
+					"Copy %u data mismatch", i);
+		if (i > 0)
+			RTE_TEST_ASSERT_EQUAL(dst[(i + 1) * TEST_COPY_LEN - i],
+					      0, "Copy %u overflowed", i);
+	}
+
+	return 0;
+}
+
+int
+test_rawdev_swdma(void)
+{
+	uint16_t dev_id = rte_rawdev_get_dev_id(TEST_DEV_NAME);
+	char *src, *dst;
+	int ret;
+
+	RTE_TEST_ASSERT(rte_rawdev_dma_supported(dev_id),
+			"%s doesn't support the DMA copy API", TEST_DEV_NAME);
+
+	src = rte_malloc(NULL, TEST_NB_COPIES * TEST_COPY_LEN, 0);
+	dst = rte_malloc(NULL, TEST_NB_COPIES * TEST_COPY_LEN, 0);
+	if (src == NULL || dst == NULL) {
+		rte_free(src);
+		rte_free(dst);
+		return -ENOMEM;
+	}
+
+	ret = test_swdma_copies(dev_id, src, dst);
+
+	rte_free(src);
+	rte_free(dst);
+
+	return ret;
+}
@@ -33,6 +33,8 @@
 
 /* mask of enabled ports */
 static uint32_t enabled_port_mask;
+/* use the ring mode of the distributor */
+static int dist_alg_ring;
 volatile uint8_t quit_signal;
 volatile uint8_t quit_signal_rx;
 volatile uint8_t quit_signal_dist;
@@ -582,8 +584,9 @@ lcore_worker(struct lcore_params *p)
 static void
 print_usage(const char *prgname)
 {
-	printf("%s [EAL options] -- -p PORTMASK\n"
-			"  -p PORTMASK: hexadecimal bitmask of ports to configure\n",
+	printf("%s [EAL options] -- -p PORTMASK [--ring]\n"
+			"  -p PORTMASK: hexadecimal bitmask of ports to configure\n"
+			"  --ring: pass packets to the workers through rings\n",
 			prgname);
 }
 
@@ -613,6 +616,7 @@ parse_args(int argc, char **argv)
 	int option_index;
 	char *prgname = argv[0];
 	static struct option lgopts[] = {
+		{"ring", no_argument, &dist_alg_ring, 1},
 		{NULL, 0, 0, 0}
 	};
 
@@ -632,6 +636,10 @@ parse_args(int argc, char **argv)
 			}
 			break;
 
+		/* long options */
+		case 0:
+			break;
+
 		default:
 			print_usage(prgname);
 			return -1;
@@ -724,7 +732,7 @@ main(int argc, char *argv[])
 
 	d = rte_distributor_create("PKT_DIST", rte_socket_id(),
 			rte_lcore_count() - 4,
-			RTE_DIST_ALG_BURST);
+			dist_alg_ring ? RTE_DIST_ALG_RING : RTE_DIST_ALG_BURST);
 	if (d == NULL)
 		rte_exit(EXIT_FAILURE, "Cannot create distributor\n");
 
@@ -40,6 +40,9 @@
 #include <rte_mbuf.h>
 #include <rte_string_fns.h>
 #include <rte_cycles.h>
+#ifdef RTE_LIBRTE_PORT
+#include <rte_port_virtio_user.h>
+#endif
 
 #ifndef APP_MAX_LCORE
 #if (RTE_MAX_LCORE > 64)
@@ -78,6 +81,12 @@
 /* Number of TX ring descriptors */
 #define NB_TXD                  1024
 
+/* Max number of queues of each port in virtio-user mode */
+#define MAX_QUEUES              8
+
+/* Number of descriptors of each virtio-user queue */
+#define VIRTIO_USER_QUEUE_SZ    1024
+
 /*
  * RX and TX Prefetch, Host, and Write-back threshold values should be
  * carefully set for optimal performance. Consult the network
@@ -107,6 +116,15 @@ static uint64_t output_cores_mask = 0;
 /* Array storing port_id that is associated with each lcore */
 static uint16_t port_ids[APP_MAX_LCORE];
 
+/* Exchange packets with the kernel through virtio-user devices, not taps */
+static int virtio_user_mode = 0;
+
+/* Number of queues of each port, more than one in virtio-user mode only */
+static uint16_t nb_queues = 1;
+
+/* Array storing the virtio-user device that is associated with each port */
+static uint16_t vu_port_ids[RTE_MAX_ETHPORTS];
+
 /* Structure type for recording lcore-specific stats */
 struct stats {
 	uint64_t rx;
@@ -213,6 +231,126 @@ static int tap_create(char *name)
 }
 #endif
 
+#ifdef RTE_LIBRTE_PORT
+/*
+ * Create the virtio-user device of a port. Its kernel interface gets the
+ * offloads which the port can complete in Tx: checksums and TCP
+ * segmentation of the packets sent by the kernel are left to the NIC.
+ */
+static void
+virtio_user_create(uint16_t port, uint64_t nic_tx_offloads)
+{
+	struct rte_port_virtio_user_dev_params params;
+	char name[RTE_ETH_NAME_MAX_LEN];
+	char iface[IFNAMSIZ];
+	int ret;
+
+	snprintf(name, sizeof(name), "virtio_user%u", port);
+	snprintf(iface, sizeof(iface), "vu_dpdk_%.2u", port);
+
+	memset(&params, 0, sizeof(params));
+	params.name = name;
+	params.iface = iface;
+	params.n_queues = nb_queues;
+	params.queue_size = VIRTIO_USER_QUEUE_SZ;
+	params.mempool = pktmbuf_pool;
+	params.socket_id = rte_eth_dev_socket_id(port);
+	params.tx_offloads = DEV_TX_OFFLOAD_TCP_CKSUM |
+		DEV_TX_OFFLOAD_UDP_CKSUM | DEV_TX_OFFLOAD_TCP_TSO |
+		DEV_TX_OFFLOAD_MULTI_SEGS;
+	if ((nic_tx_offloads & DEV_TX_OFFLOAD_TCP_CKSUM) &&
+			(nic_tx_offloads & DEV_TX_OFFLOAD_UDP_CKSUM))
+		params.rx_offloads |= DEV_RX_OFFLOAD_TCP_CKSUM |
+			DEV_RX_OFFLOAD_UDP_CKSUM;
+	if ((nic_tx_offloads & DEV_TX_OFFLOAD_TCP_TSO) &&
+			(nic_tx_offloads & DEV_TX_OFFLOAD_MULTI_SEGS) &&
+			(nic_tx_offloads & DEV_TX_OFFLOAD_IPV4_CKSUM))
+		params.rx_offloads |= DEV_RX_OFFLOAD_TCP_LRO;
+
+	ret = rte_port_virtio_user_dev_create(&params, &vu_port_ids[port]);
+	if (ret < 0)
+		FATAL_ERROR("Could not create virtio-user device for port%u (%d)",
+			    port, ret);
+	PRINT_INFO("Port %u is exchanging packets with %s", port, iface);
+}
+
+/* Processing loop of an lcore in virtio-user mode */
+static int
+virtio_user_loop(unsigned lcore_id)
+{
+	const uint16_t port = port_ids[lcore_id];
+	const uint16_t vu_port = vu_port_ids[port];
+	struct rte_mbuf *pkts_burst[PKT_BURST_SZ];
+	unsigned i, nb_rx, nb_tx;
+	uint16_t q;
+
+	if ((1ULL << lcore_id) & input_cores_mask) {
+		PRINT_INFO("Lcore %u is reading from port %u and writing to port %u",
+			   lcore_id, (unsigned)port, (unsigned)vu_port);
+		fflush(stdout);
+		/*
+		 * Loop forever reading from NIC and writing to virtio-user,
+		 * the same queue on both sides to keep the RSS flow affinity
+		 */
+		for (;;) {
+			for (q = 0; q < nb_queues; q++) {
+				nb_rx = rte_eth_rx_burst(port, q, pkts_burst,
+					PKT_BURST_SZ);
+				if (nb_rx == 0)
+					continue;
+				lcore_stats[lcore_id].rx += nb_rx;
+				nb_tx = rte_eth_tx_burst(vu_port, q, pkts_burst,
+					nb_rx);
+				lcore_stats[lcore_id].tx += nb_tx;
+				lcore_stats[lcore_id].dropped += nb_rx - nb_tx;
+				for (i = nb_tx; i < nb_rx; i++)
+					rte_pktmbuf_free(pkts_burst[i]);
+			}
+		}
+	} else {
+		struct rte_port_virtio_user_reader_params params;
+		void *readers[MAX_QUEUES];
+
+		/*
+		 * The reader ports request the Tx offloads of the packets
+		 * whose checksum or segmentation is left to the NIC
+		 */
+		for (q = 0; q < nb_queues; q++) {
+			params.port_id = vu_port;
+			params.queue_id = q;
+			params.tx_offload = 1;
+			readers[q] = rte_port_virtio_user_reader_ops.f_create(
+				&params, rte_socket_id());
+			if (readers[q] == NULL)
+				FATAL_ERROR("Could not create reader of port %u",
+					    (unsigned)vu_port);
+		}
+
+		PRINT_INFO("Lcore %u is reading from port %u and writing to port %u",
+			   lcore_id, (unsigned)vu_port, (unsigned)port);
+		fflush(stdout);
+		/* Loop forever reading from virtio-user and writing to NIC */
+		for (;;) {
+			for (q = 0; q < nb_queues; q++) {
+				nb_rx = rte_port_virtio_user_reader_ops.f_rx(
+					readers[q], pkts_burst, PKT_BURST_SZ);
+				if (nb_rx == 0)
+					continue;
+				lcore_stats[lcore_id].rx += nb_rx;
+				nb_tx = rte_eth_tx_burst(port, q, pkts_burst,
+					nb_rx);
+				lcore_stats[lcore_id].tx += nb_tx;
+				lcore_stats[lcore_id].dropped += nb_rx - nb_tx;
+				for (i = nb_tx; i < nb_rx; i++)
+					rte_pktmbuf_free(pkts_burst[i]);
+			}
+		}
+	}
+
+	return 0;
+}
+#endif
+
 /* Main processing loop */
 static int
 main_loop(__attribute__((unused)) void *arg)
@@ -221,6 +359,12 @@ main_loop(__attribute__((unused)) void *arg)
 	char tap_name[IFNAMSIZ];
 	int tap_fd;
 
+#ifdef RTE_LIBRTE_PORT
+	if (virtio_user_mode &&
+	    ((1ULL << lcore_id) & (input_cores_mask | output_cores_mask)))
+		return virtio_user_loop(lcore_id);
+#endif
+
 	if ((1ULL << lcore_id) & input_cores_mask) {
 		/* Create new tap interface */
 		snprintf(tap_name, IFNAMSIZ, "tap_dpdk_%.2u", lcore_id);
@@ -307,10 +451,14 @@ main_loop(__attribute__((unused)) void *arg)
 static void
 print_usage(const char *prgname)
 {
-	PRINT_INFO("\nUsage: %s [EAL options] -- -p PORTMASK -i IN_CORES -o OUT_CORES\n"
+	PRINT_INFO("\nUsage: %s [EAL options] -- -p PORTMASK -i IN_CORES -o OUT_CORES"
+		   " [-v [-q NQUEUES]]\n"
 	           "    -p PORTMASK: hex bitmask of ports to use\n"
 	           "    -i IN_CORES: hex bitmask of cores which read from NIC\n"
-	           "    -o OUT_CORES: hex bitmask of cores which write to NIC",
+	           "    -o OUT_CORES: hex bitmask of cores which write to NIC\n"
+		   "    -v: use virtio-user devices instead of tap interfaces\n"
+		   "    -q NQUEUES: number of queues of each port with -v"
+		   " (default 1)",
 	           prgname);
 }
 
@@ -383,7 +531,7 @@ parse_args(int argc, char **argv)
 	opterr = 0;
 
 	/* Parse command line */
-	while ((opt = getopt(argc, argv, "i:o:p:")) != EOF) {
+	while ((opt = getopt(argc, argv, "i:o:p:vq:")) != EOF) {
 		switch (opt) {
 		case 'i':
 			input_cores_mask = parse_unsigned(optarg);
@@ -394,6 +542,12 @@ parse_args(int argc, char **argv)
 		case 'p':
 			ports_mask = parse_unsigned(optarg);
 			break;
+		case 'v':
+			virtio_user_mode = 1;
+			break;
+		case 'q':
+			nb_queues = (uint16_t)strtoul(optarg, NULL, 10);
+			break;
 		default:
 			print_usage(prgname);
 			FATAL_ERROR("Invalid option specified");
@@ -413,6 +567,15 @@ parse_args(int argc, char **argv)
 		print_usage(prgname);
 		FATAL_ERROR("PORTMASK not specified correctly");
 	}
+#ifndef RTE_LIBRTE_PORT
+	if (virtio_user_mode)
+		FATAL_ERROR("virtio-user mode needs the port library");
+#endif
+	if ((nb_queues == 0) || (nb_queues > MAX_QUEUES) ||
+	    ((nb_queues > 1) && !virtio_user_mode)) {
+		print_usage(prgname);
+		FATAL_ERROR("NQUEUES not specified correctly");
+	}
 
 	setup_port_lcore_affinities();
 }
@@ -428,6 +591,7 @@ init_port(uint16_t port)
 	struct rte_eth_rxconf rxq_conf;
 	struct rte_eth_txconf txq_conf;
 	struct rte_eth_conf local_port_conf = port_conf;
+	uint16_t q;
 
 	/* Initialise device and RX/TX queues */
 	PRINT_INFO("Initialising port %u ...", port);
@@ -436,7 +600,27 @@ init_port(uint16_t port)
 	if (dev_info.tx_offload_capa & DEV_TX_OFFLOAD_MBUF_FAST_FREE)
 		local_port_conf.txmode.offloads |=
 			DEV_TX_OFFLOAD_MBUF_FAST_FREE;
-	ret = rte_eth_dev_configure(port, 1, 1, &local_port_conf);
+	if (virtio_user_mode) {
+		/*
+		 * The packets of the kernel carry multiple segments, and the
+		 * checksum and segmentation offloads are given to the NIC
+		 */
+		local_port_conf.txmode.offloads &=
+			~DEV_TX_OFFLOAD_MBUF_FAST_FREE;
+		local_port_conf.txmode.offloads |= dev_info.tx_offload_capa &
+			(DEV_TX_OFFLOAD_IPV4_CKSUM | DEV_TX_OFFLOAD_TCP_CKSUM |
+			 DEV_TX_OFFLOAD_UDP_CKSUM | DEV_TX_OFFLOAD_TCP_TSO |
+			 DEV_TX_OFFLOAD_MULTI_SEGS);
+		local_port_conf.rxmode.offloads |= dev_info.rx_offload_capa &
+			DEV_RX_OFFLOAD_CHECKSUM;
+	}
+	if (nb_queues > 1) {
+		local_port_conf.rxmode.mq_mode = ETH_MQ_RX_RSS;
+		local_port_conf.rx_adv_conf.rss_conf.rss_hf = ETH_RSS_IP &
+			dev_info.flow_type_rss_offloads;
+	}
+	ret = rte_eth_dev_configure(port, nb_queues, nb_queues,
+				&local_port_conf);
 	if (ret < 0)
 		FATAL_ERROR("Could not configure port%u (%d)", port, ret);
 
@@ -447,28 +631,35 @@ init_port(uint16_t port)
 
 	rxq_conf = dev_info.default_rxconf;
 	rxq_conf.offloads = local_port_conf.rxmode.offloads;
-	ret = rte_eth_rx_queue_setup(port, 0, nb_rxd,
-				rte_eth_dev_socket_id(port),
-				&rxq_conf,
-				pktmbuf_pool);
-	if (ret < 0)
-		FATAL_ERROR("Could not setup up RX queue for port%u (%d)",
-				port, ret);
-
 	txq_conf = dev_info.default_txconf;
 	txq_conf.offloads = local_port_conf.txmode.offloads;
-	ret = rte_eth_tx_queue_setup(port, 0, nb_txd,
-				rte_eth_dev_socket_id(port),
-				&txq_conf);
-	if (ret < 0)
-		FATAL_ERROR("Could not setup up TX queue for port%u (%d)",
-				port, ret);
+	for (q = 0; q < nb_queues; q++) {
+		ret = rte_eth_rx_queue_setup(port, q, nb_rxd,
+					rte_eth_dev_socket_id(port),
+					&rxq_conf,
+					pktmbuf_pool);
+		if (ret < 0)
+			FATAL_ERROR("Could not setup up RX queue for port%u (%d)",
+					port, ret);
+
+		ret = rte_eth_tx_queue_setup(port, q, nb_txd,
+					rte_eth_dev_socket_id(port),
+					&txq_conf);
+		if (ret < 0)
+			FATAL_ERROR("Could not setup up TX queue for port%u (%d)",
+					port, ret);
+	}
 
 	ret = rte_eth_dev_start(port);
 	if (ret < 0)
 		FATAL_ERROR("Could not start port%u (%d)", port, ret);
 
 	rte_eth_promiscuous_enable(port);
+
+#ifdef RTE_LIBRTE_PORT
+	if (virtio_user_mode)
+		virtio_user_create(port, local_port_conf.txmode.offloads);
+#endif
 }
 
 /* Check the link status of all ports in up to 9s, and print them finally */
@@ -549,7 +740,7 @@ main(int argc, char** argv)
 	parse_args(argc, argv);
 
 	/* Create the mbuf pool */
-	pktmbuf_pool = rte_pktmbuf_pool_create("mbuf_pool", NB_MBUF,
+	pktmbuf_pool = rte_pktmbuf_pool_create("mbuf_pool", NB_MBUF * nb_queues,
 			MEMPOOL_CACHE_SZ, 0, MBUF_DATA_SZ, rte_socket_id());
 	if (pktmbuf_pool == NULL) {
 		FATAL_ERROR("Could not initialise mbuf pool");
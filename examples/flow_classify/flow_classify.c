@@ -821,6 +821,7 @@ main(int argc, char *argv[])
 	cls_table_params.ops = &rte_table_acl_ops;
 	cls_table_params.arg_create = &table_acl_params;
 	cls_table_params.type = RTE_FLOW_CLASSIFY_TABLE_ACL_IP4_5TUPLE;
+	cls_table_params.cache_size = 0;
 
 	ret = rte_flow_classify_table_create(cls_app->cls, &cls_table_params);
 	if (ret) {
@@ -23,6 +23,7 @@
 #include "tap.h"
 #include "thread.h"
 #include "tmgr.h"
+#include "vhost.h"
 
 #ifndef CMD_MAX_TOKENS
 #define CMD_MAX_TOKENS     256
@@ -787,6 +788,53 @@ cmd_kni(char **tokens,
 	}
 }
 
+static const char cmd_vhost_help[] =
+"vhost <vhost_name>\n"
+"   path <socket_path>\n"
+"   [client]\n";
+
+static void
+cmd_vhost(char **tokens,
+	uint32_t n_tokens,
+	char *out,
+	size_t out_size)
+{
+	struct vhost_params p;
+	char *name;
+	struct vhost *vhost;
+
+	memset(&p, 0, sizeof(p));
+	if ((n_tokens != 4) && (n_tokens != 5)) {
+		snprintf(out, out_size, MSG_ARG_MISMATCH, tokens[0]);
+		return;
+	}
+
+	name = tokens[1];
+
+	if (strcmp(tokens[2], "path") != 0) {
+		snprintf(out, out_size, MSG_ARG_NOT_FOUND, "path");
+		return;
+	}
+
+	p.path = tokens[3];
+
+	if (n_tokens == 5) {
+		if (strcmp(tokens[4], "client") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND, "client");
+			return;
+		}
+
+		p.client = 1;
+	} else
+		p.client = 0;
+
+	vhost = vhost_create(name, &p);
+	if (vhost == NULL) {
+		snprintf(out, out_size, MSG_CMD_FAIL, tokens[0]);
+		return;
+	}
+}
+
 static const char cmd_cryptodev_help[] =
 "cryptodev <cryptodev_name>\n"
 "   dev <device_name> | dev_id <device_id>\n"
@@ -1545,6 +1593,7 @@ static const char cmd_pipeline_port_in_help[] =
 "   | kni <kni_name>\n"
 "   | source mempool <mempool_name> file <file_name> bpp <n_bytes_per_pkt>\n"
 "   | cryptodev <cryptodev_name> rxq <queue_id>\n"
+"   | vhost <vhost_name> queue <queue_id> mempool <mempool_name>\n"
 "   [action <port_in_action_profile_name>]\n"
 "   [disabled]\n";
 
@@ -1737,6 +1786,38 @@ cmd_pipeline_port_in(char **tokens,
 		p.cryptodev.f_callback = NULL;
 
 		t0 += 4;
+	} else if (strcmp(tokens[t0], "vhost") == 0) {
+		if (n_tokens < t0 + 6) {
+			snprintf(out, out_size, MSG_ARG_MISMATCH,
+				"pipeline port in vhost");
+			return;
+		}
+
+		p.type = PORT_IN_VHOST;
+
+		p.dev_name = tokens[t0 + 1];
+
+		if (strcmp(tokens[t0 + 2], "queue") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND, "queue");
+			return;
+		}
+
+		if (parser_read_uint16(&p.vhost.queue_id,
+			tokens[t0 + 3]) != 0) {
+			snprintf(out, out_size, MSG_ARG_INVALID,
+				"queue_id");
+			return;
+		}
+
+		if (strcmp(tokens[t0 + 4], "mempool") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND,
+				"mempool");
+			return;
+		}
+
+		p.vhost.mempool_name = tokens[t0 + 5];
+
+		t0 += 6;
 	} else {
 		snprintf(out, out_size, MSG_ARG_INVALID, tokens[0]);
 		return;
@@ -1784,7 +1865,8 @@ static const char cmd_pipeline_port_out_help[] =
 "   | tap <tap_name>\n"
 "   | kni <kni_name>\n"
 "   | sink [file <file_name> pkts <max_n_pkts>]\n"
-"   | cryptodev <cryptodev_name> txq <txq_id> offset <crypto_op_offset>\n";
+"   | cryptodev <cryptodev_name> txq <txq_id> offset <crypto_op_offset>\n"
+"   | vhost <vhost_name> queue <queue_id>\n";
 
 static void
 cmd_pipeline_port_out(char **tokens,
@@ -1953,6 +2035,26 @@ cmd_pipeline_port_out(char **tokens,
 			snprintf(out, out_size, MSG_ARG_INVALID, "queue_id");
 			return;
 		}
+	} else if (strcmp(tokens[6], "vhost") == 0) {
+		if (n_tokens != 10) {
+			snprintf(out, out_size, MSG_ARG_MISMATCH,
+				"pipeline port out vhost");
+			return;
+		}
+
+		p.type = PORT_OUT_VHOST;
+
+		p.dev_name = tokens[7];
+
+		if (strcmp(tokens[8], "queue") != 0) {
+			snprintf(out, out_size, MSG_ARG_NOT_FOUND, "queue");
+			return;
+		}
+
+		if (parser_read_uint16(&p.vhost.queue_id, tokens[9]) != 0) {
+			snprintf(out, out_size, MSG_ARG_INVALID, "queue_id");
+			return;
+		}
 	} else {
 		snprintf(out, out_size, MSG_ARG_INVALID, tokens[0]);
 		return;
@@ -6014,6 +6116,7 @@ cmd_help(char **tokens, uint32_t n_tokens, char *out, size_t out_size)
 			"\ttmgr subport pipe\n"
 			"\ttap\n"
 			"\tkni\n"
+			"\tvhost\n"
 			"\tport in action profile\n"
 			"\ttable action profile\n"
 			"\tpipeline\n"
@@ -6104,6 +6207,11 @@ cmd_help(char **tokens, uint32_t n_tokens, char *out, size_t out_size)
 		return;
 	}
 
+	if (strcmp(tokens[0], "vhost") == 0) {
+		snprintf(out, out_size, "\n%s\n", cmd_vhost_help);
+		return;
+	}
+
 	if (strcmp(tokens[0], "cryptodev") == 0) {
 		snprintf(out, out_size, "\n%s\n", cmd_cryptodev_help);
 		return;
@@ -6416,6 +6524,11 @@ cli_process(char *in, char *out, size_t out_size)
 		return;
 	}
 
+	if (strcmp(tokens[0], "vhost") == 0) {
+		cmd_vhost(tokens, n_tokens, out, out_size);
+		return;
+	}
+
 	if (strcmp(tokens[0], "cryptodev") == 0) {
 		cmd_cryptodev(tokens, n_tokens, out, out_size);
 		return;
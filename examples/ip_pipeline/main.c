@@ -22,6 +22,7 @@
 #include "tap.h"
 #include "thread.h"
 #include "tmgr.h"
+#include "vhost.h"
 
 static const char usage[] =
 	"%s EAL_ARGS -- [-h HOST] [-p PORT] [-s SCRIPT]\n";
@@ -211,6 +212,13 @@ main(int argc, char **argv)
 		return status;
 	}
 
+	/* vhost */
+	status = vhost_init();
+	if (status) {
+		printf("Error: vhost initialization failed (%d)\n", status);
+		return status;
+	}
+
 	/* Sym Crypto */
 	status = cryptodev_init();
 	if (status) {
@@ -19,6 +19,9 @@
 #include <rte_port_fd.h>
 #include <rte_port_sched.h>
 #include <rte_port_sym_crypto.h>
+#ifdef RTE_LIBRTE_VHOST
+#include <rte_port_vhost.h>
+#endif
 
 #include <rte_table_acl.h>
 #include <rte_table_array.h>
@@ -38,6 +41,7 @@
 #include "tmgr.h"
 #include "swq.h"
 #include "cryptodev.h"
+#include "vhost.h"
 
 #ifndef PIPELINE_MSGQ_SIZE
 #define PIPELINE_MSGQ_SIZE                                 64
@@ -165,6 +169,9 @@ pipeline_port_in_create(const char *pipeline_name,
 #endif
 		struct rte_port_source_params source;
 		struct rte_port_sym_crypto_reader_params sym_crypto;
+#ifdef RTE_LIBRTE_VHOST
+		struct rte_port_vhost_reader_params vhost;
+#endif
 	} pp;
 
 	struct pipeline *pipeline;
@@ -319,6 +326,30 @@ pipeline_port_in_create(const char *pipeline_name,
 		break;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	case PORT_IN_VHOST:
+	{
+		struct vhost *vhost;
+		struct mempool *mempool;
+
+		vhost = vhost_find(params->dev_name);
+		if (vhost == NULL)
+			return -1;
+
+		mempool = mempool_find(params->vhost.mempool_name);
+		if (mempool == NULL)
+			return -1;
+
+		pp.vhost.vid = &vhost->vid;
+		pp.vhost.queue_id = params->vhost.queue_id;
+		pp.vhost.mempool = mempool->m;
+
+		p.ops = &rte_port_vhost_reader_ops;
+		p.arg_create = &pp.vhost;
+		break;
+	}
+#endif
+
 	default:
 		return -1;
 	}
@@ -409,6 +440,9 @@ pipeline_port_out_create(const char *pipeline_name,
 #endif
 		struct rte_port_sink_params sink;
 		struct rte_port_sym_crypto_writer_params sym_crypto;
+#ifdef RTE_LIBRTE_VHOST
+		struct rte_port_vhost_writer_params vhost;
+#endif
 	} pp;
 
 	union {
@@ -419,6 +453,9 @@ pipeline_port_out_create(const char *pipeline_name,
 		struct rte_port_kni_writer_nodrop_params kni;
 #endif
 		struct rte_port_sym_crypto_writer_nodrop_params sym_crypto;
+#ifdef RTE_LIBRTE_VHOST
+		struct rte_port_vhost_writer_nodrop_params vhost;
+#endif
 	} pp_nodrop;
 
 	struct pipeline *pipeline;
@@ -608,6 +645,35 @@ pipeline_port_out_create(const char *pipeline_name,
 		break;
 	}
 
+#ifdef RTE_LIBRTE_VHOST
+	case PORT_OUT_VHOST:
+	{
+		struct vhost *vhost;
+
+		vhost = vhost_find(params->dev_name);
+		if (vhost == NULL)
+			return -1;
+
+		pp.vhost.vid = &vhost->vid;
+		pp.vhost.queue_id = params->vhost.queue_id;
+		pp.vhost.tx_burst_sz = params->burst_size;
+
+		pp_nodrop.vhost.vid = &vhost->vid;
+		pp_nodrop.vhost.queue_id = params->vhost.queue_id;
+		pp_nodrop.vhost.tx_burst_sz = params->burst_size;
+		pp_nodrop.vhost.n_retries = params->n_retries;
+
+		if (params->retry == 0) {
+			p.ops = &rte_port_vhost_writer_ops;
+			p.arg_create = &pp.vhost;
+		} else {
+			p.ops = &rte_port_vhost_writer_nodrop_ops;
+			p.arg_create = &pp_nodrop.vhost;
+		}
+		break;
+	}
+#endif
+
 	default:
 		return -1;
 	}
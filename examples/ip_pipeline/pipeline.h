@@ -28,6 +28,7 @@ enum port_in_type {
 	PORT_IN_KNI,
 	PORT_IN_SOURCE,
 	PORT_IN_CRYPTODEV,
+	PORT_IN_VHOST,
 };
 
 struct port_in_params {
@@ -55,6 +56,11 @@ struct port_in_params {
 			void *f_callback;
 			void *arg_callback;
 		} cryptodev;
+
+		struct {
+			uint16_t queue_id;
+			const char *mempool_name;
+		} vhost;
 	};
 	uint32_t burst_size;
 
@@ -70,6 +76,7 @@ enum port_out_type {
 	PORT_OUT_KNI,
 	PORT_OUT_SINK,
 	PORT_OUT_CRYPTODEV,
+	PORT_OUT_VHOST,
 };
 
 struct port_out_params {
@@ -89,6 +96,10 @@ struct port_out_params {
 			uint16_t queue_id;
 			uint32_t op_offset;
 		} cryptodev;
+
+		struct {
+			uint16_t queue_id;
+		} vhost;
 	};
 	uint32_t burst_size;
 	int retry;
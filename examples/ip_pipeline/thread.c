@@ -7,6 +7,7 @@
 #include <rte_common.h>
 #include <rte_cycles.h>
 #include <rte_lcore.h>
+#include <rte_pause.h>
 #include <rte_ring.h>
 
 #include <rte_table_acl.h>
@@ -73,6 +74,7 @@ struct thread_data {
 	uint64_t timer_period; /* Measured in CPU cycles. */
 	uint64_t time_next;
 	uint64_t time_next_min;
+	volatile uint64_t iter; /* Dispatch loop iteration, read by master. */
 } __rte_cache_aligned;
 
 static struct thread_data thread_data[RTE_MAX_LCORE];
@@ -178,6 +180,26 @@ pipeline_is_running(struct pipeline *p)
 	return thread_is_running(p->thread_id);
 }
 
+/**
+ * Wait until every running data plane thread has started a new dispatch loop
+ * iteration, so that none of them still uses a value changed by the caller.
+ */
+void
+thread_quiesce(void)
+{
+	uint64_t iter[RTE_MAX_LCORE];
+	uint32_t i;
+
+	rte_smp_mb();
+
+	RTE_LCORE_FOREACH_SLAVE(i)
+		iter[i] = thread_data[i].iter;
+
+	RTE_LCORE_FOREACH_SLAVE(i)
+		while (thread_is_running(i) && thread_data[i].iter == iter[i])
+			rte_pause();
+}
+
 /**
  * Master thread & data plane threads: message passing
  */
@@ -3139,6 +3161,8 @@ thread_main(void *arg __rte_unused)
 	for (i = 0; ; i++) {
 		uint32_t j;
 
+		t->iter = i;
+
 		/* Data Plane */
 		for (j = 0; j < t->n_pipelines; j++)
 			rte_pipeline_run(t->p[j]);
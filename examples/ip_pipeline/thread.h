@@ -18,6 +18,9 @@ thread_pipeline_disable(uint32_t thread_id,
 int
 thread_init(void);
 
+void
+thread_quiesce(void);
+
 int
 thread_main(void *arg);
 
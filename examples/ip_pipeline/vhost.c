@@ -0,0 +1,147 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_string_fns.h>
+#ifdef RTE_LIBRTE_VHOST
+#include <rte_vhost.h>
+#endif
+
+#include "vhost.h"
+#include "thread.h"
+
+static struct vhost_list vhost_list;
+
+int
+vhost_init(void)
+{
+	TAILQ_INIT(&vhost_list);
+
+	return 0;
+}
+
+struct vhost *
+vhost_find(const char *name)
+{
+	struct vhost *vhost;
+
+	if (name == NULL)
+		return NULL;
+
+	TAILQ_FOREACH(vhost, &vhost_list, node)
+		if (strcmp(vhost->name, name) == 0)
+			return vhost;
+
+	return NULL;
+}
+
+#ifndef RTE_LIBRTE_VHOST
+
+struct vhost *
+vhost_create(const char *name __rte_unused,
+	struct vhost_params *params __rte_unused)
+{
+	return NULL;
+}
+
+#else
+
+static struct vhost *
+vhost_find_by_vid(int vid)
+{
+	char path[PATH_MAX];
+	struct vhost *vhost;
+
+	if (rte_vhost_get_ifname(vid, path, sizeof(path)) != 0)
+		return NULL;
+
+	TAILQ_FOREACH(vhost, &vhost_list, node)
+		if (strcmp(vhost->path, path) == 0)
+			return vhost;
+
+	return NULL;
+}
+
+static int
+vhost_new_device(int vid)
+{
+	struct vhost *vhost;
+
+	vhost = vhost_find_by_vid(vid);
+	if (vhost == NULL)
+		return -1;
+
+	vhost->vid = vid;
+
+	return 0;
+}
+
+static void
+vhost_destroy_device(int vid)
+{
+	struct vhost *vhost;
+
+	vhost = vhost_find_by_vid(vid);
+	if (vhost == NULL)
+		return;
+
+	/* The pipeline ports read the device ID on each burst. */
+	vhost->vid = -1;
+	thread_quiesce();
+}
+
+static const struct vhost_device_ops vhost_ops = {
+	.new_device = vhost_new_device,
+	.destroy_device = vhost_destroy_device,
+};
+
+struct vhost *
+vhost_create(const char *name, struct vhost_params *params)
+{
+	struct vhost *vhost;
+	uint64_t flags;
+
+	/* Check input params */
+	if ((name == NULL) ||
+		vhost_find(name) ||
+		(params == NULL) ||
+		(params->path == NULL))
+		return NULL;
+
+	/* Node allocation */
+	vhost = calloc(1, sizeof(struct vhost));
+	if (vhost == NULL)
+		return NULL;
+
+	strlcpy(vhost->name, name, sizeof(vhost->name));
+	strlcpy(vhost->path, params->path, sizeof(vhost->path));
+	vhost->vid = -1;
+
+	/* Node add to list */
+	TAILQ_INSERT_TAIL(&vhost_list, vhost, node);
+
+	/* Resource create */
+	flags = params->client ? RTE_VHOST_USER_CLIENT : 0;
+
+	if (rte_vhost_driver_register(vhost->path, flags))
+		goto error;
+
+	if (rte_vhost_driver_callback_register(vhost->path, &vhost_ops) ||
+		rte_vhost_driver_start(vhost->path)) {
+		rte_vhost_driver_unregister(vhost->path);
+		goto error;
+	}
+
+	return vhost;
+
+error:
+	TAILQ_REMOVE(&vhost_list, vhost, node);
+	free(vhost);
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _INCLUDE_VHOST_H_
+#define _INCLUDE_VHOST_H_
+
+#include <stdint.h>
+#include <sys/queue.h>
+#include <linux/limits.h>
+
+#include "common.h"
+
+struct vhost {
+	TAILQ_ENTRY(vhost) node;
+	char name[NAME_SIZE];
+	char path[PATH_MAX];
+	volatile int vid;
+};
+
+TAILQ_HEAD(vhost_list, vhost);
+
+int
+vhost_init(void);
+
+struct vhost *
+vhost_find(const char *name);
+
+struct vhost_params {
+	const char *path;
+	int client;
+};
+
+struct vhost *
+vhost_create(const char *name, struct vhost_params *params);
+
+#endif /* _INCLUDE_VHOST_H_ */
@@ -152,7 +152,7 @@ static int32_t promiscuous_on = 1;
 static int32_t numa_on = 1; /**< NUMA is enabled by default. */
 static uint32_t nb_lcores;
 static uint32_t single_sa;
-static uint32_t single_sa_idx;
+static uint32_t single_sa_spi;
 static uint32_t frame_size;
 
 struct lcore_rx_queue {
@@ -413,7 +413,7 @@ inbound_sp_sa(struct sp_ctx *sp, struct sa_ctx *sa, struct traffic_type *ip,
 		uint16_t lim)
 {
 	struct rte_mbuf *m;
-	uint32_t i, j, res, sa_idx;
+	uint32_t i, j, res, spi;
 
 	if (ip->num == 0 || sp == NULL)
 		return;
@@ -440,9 +440,8 @@ inbound_sp_sa(struct sp_ctx *sp, struct sa_ctx *sa, struct traffic_type *ip,
 			continue;
 		}
 
-		sa_idx = ip->res[i] & PROTECT_MASK;
-		if (sa_idx >= IPSEC_SA_MAX_ENTRIES ||
-				!inbound_sa_check(sa, m, sa_idx)) {
+		spi = ip->res[i] & PROTECT_MASK;
+		if (!inbound_sa_check(sa, m, spi)) {
 			rte_pktmbuf_free(m);
 			continue;
 		}
@@ -495,7 +494,7 @@ outbound_sp(struct sp_ctx *sp, struct traffic_type *ip,
 		struct traffic_type *ipsec)
 {
 	struct rte_mbuf *m;
-	uint32_t i, j, sa_idx;
+	uint32_t i, j, spi;
 
 	if (ip->num == 0 || sp == NULL)
 		return;
@@ -506,15 +505,16 @@ outbound_sp(struct sp_ctx *sp, struct traffic_type *ip,
 	j = 0;
 	for (i = 0; i < ip->num; i++) {
 		m = ip->pkts[i];
-		sa_idx = ip->res[i] & PROTECT_MASK;
+		spi = ip->res[i] & PROTECT_MASK;
 		if (ip->res[i] & DISCARD)
 			rte_pktmbuf_free(m);
 		else if (ip->res[i] & BYPASS)
 			ip->pkts[j++] = m;
-		else if (sa_idx < IPSEC_SA_MAX_ENTRIES) {
-			ipsec->res[ipsec->num] = sa_idx;
+		else if (spi != INVALID_SPI) {
+			/* packets of unknown SPIs are dropped by SA lookup */
+			ipsec->res[ipsec->num] = spi;
 			ipsec->pkts[ipsec->num++] = m;
-		} else /* invalid SA idx */
+		} else /* invalid SPI */
 			rte_pktmbuf_free(m);
 	}
 	ip->num = j;
@@ -604,10 +604,10 @@ process_pkts_outbound_nosp(struct ipsec_ctx *ipsec_ctx,
 	traffic->ipsec.num = 0;
 
 	for (i = 0; i < traffic->ip4.num; i++)
-		traffic->ip4.res[i] = single_sa_idx;
+		traffic->ip4.res[i] = single_sa_spi;
 
 	for (i = 0; i < traffic->ip6.num; i++)
-		traffic->ip6.res[i] = single_sa_idx;
+		traffic->ip6.res[i] = single_sa_spi;
 
 	nb_pkts_out = ipsec_outbound(ipsec_ctx, traffic->ip4.pkts,
 			traffic->ip4.res, traffic->ip4.num,
@@ -962,8 +962,8 @@ print_usage(const char *prgname)
 		"                packet size\n"
 		"  -f CONFIG_FILE: Configuration file\n"
 		"  --config (port,queue,lcore): Rx queue configuration\n"
-		"  --single-sa SAIDX: Use single SA index for outbound traffic,\n"
-		"                     bypassing the SP\n"
+		"  --single-sa SAIDX: Use the SA of SPI SAIDX for outbound\n"
+		"                     traffic, bypassing the SP\n"
 		"  --cryptodev_mask MASK: Hexadecimal bitmask of the crypto\n"
 		"                         devices to configure\n"
 		"\n",
@@ -1133,17 +1133,17 @@ parse_args(int32_t argc, char **argv)
 			break;
 		case CMD_LINE_OPT_SINGLE_SA_NUM:
 			ret = parse_decimal(optarg);
-			if (ret == -1) {
-				printf("Invalid argument[sa_idx]\n");
+			if (ret == -1 || ret == INVALID_SPI) {
+				printf("Invalid argument[sa_spi]\n");
 				print_usage(prgname);
 				return -1;
 			}
 
 			/* else */
 			single_sa = 1;
-			single_sa_idx = ret;
-			printf("Configured with single SA index %u\n",
-					single_sa_idx);
+			single_sa_spi = ret;
+			printf("Configured with single SA SPI %u\n",
+					single_sa_spi);
 			break;
 		case CMD_LINE_OPT_CRYPTODEV_MASK_NUM:
 			ret = parse_portmask(optarg);
@@ -362,6 +362,46 @@ enqueue_cop(struct cdev_qp *cqp, struct rte_crypto_op *cop)
 	}
 }
 
+/*
+ * Reorder a burst so that the packets of each SA are contiguous, keeping
+ * the order of the packets of an SA. The crypto ops of an SA then reach the
+ * crypto device together and its session stays warm in the caches.
+ */
+static inline void
+group_by_sa(struct rte_mbuf *pkts[], struct ipsec_sa *sas[], uint16_t nb_pkts)
+{
+	struct rte_mbuf *gpkts[nb_pkts];
+	struct ipsec_sa *gsas[nb_pkts];
+	struct ipsec_sa *sa;
+	uint64_t left;
+	uint32_t i, j, k;
+
+	RTE_BUILD_BUG_ON(MAX_PKT_BURST > 64);
+
+	/* nothing to do when the SAs are already grouped, the common case */
+	for (i = 1; i < nb_pkts && sas[i] == sas[i - 1]; i++)
+		;
+	if (i >= nb_pkts)
+		return;
+
+	left = RTE_LEN2MASK(nb_pkts, uint64_t);
+	k = 0;
+	while (left != 0) {
+		i = __builtin_ctzll(left);
+		sa = sas[i];
+		for (j = i; j < nb_pkts; j++) {
+			if ((left & (1ULL << j)) == 0 || sas[j] != sa)
+				continue;
+			gpkts[k] = pkts[j];
+			gsas[k++] = sa;
+			left &= ~(1ULL << j);
+		}
+	}
+
+	memcpy(pkts, gpkts, nb_pkts * sizeof(pkts[0]));
+	memcpy(sas, gsas, nb_pkts * sizeof(sas[0]));
+}
+
 static inline void
 ipsec_enqueue(ipsec_xform_fn xform_func, struct ipsec_ctx *ipsec_ctx,
 		struct rte_mbuf *pkts[], struct ipsec_sa *sas[],
@@ -543,6 +583,8 @@ ipsec_inbound(struct ipsec_ctx *ctx, struct rte_mbuf *pkts[],
 
 	inbound_sa_lookup(ctx->sa_ctx, pkts, sas, nb_pkts);
 
+	group_by_sa(pkts, sas, nb_pkts);
+
 	ipsec_enqueue(esp_inbound, ctx, pkts, sas, nb_pkts);
 
 	return ipsec_dequeue(esp_inbound_post, ctx, pkts, len);
@@ -550,11 +592,13 @@ ipsec_inbound(struct ipsec_ctx *ctx, struct rte_mbuf *pkts[],
 
 uint16_t
 ipsec_outbound(struct ipsec_ctx *ctx, struct rte_mbuf *pkts[],
-		uint32_t sa_idx[], uint16_t nb_pkts, uint16_t len)
+		uint32_t spi[], uint16_t nb_pkts, uint16_t len)
 {
 	struct ipsec_sa *sas[nb_pkts];
 
-	outbound_sa_lookup(ctx->sa_ctx, sa_idx, sas, nb_pkts);
+	outbound_sa_lookup(ctx->sa_ctx, spi, sas, nb_pkts);
+
+	group_by_sa(pkts, sas, nb_pkts);
 
 	ipsec_enqueue(esp_outbound, ctx, pkts, sas, nb_pkts);
 
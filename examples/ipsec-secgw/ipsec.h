@@ -36,14 +36,13 @@
 
 #define DEFAULT_MAX_CATEGORIES	1
 
-#define IPSEC_SA_MAX_ENTRIES (128) /* must be power of 2, max 2 power 30 */
-#define SPI2IDX(spi) (spi & (IPSEC_SA_MAX_ENTRIES - 1))
+#define IPSEC_SA_MAX_ENTRIES (1 << 17) /* per direction */
 #define INVALID_SPI (0)
 
 #define DISCARD (0x80000000)
 #define BYPASS (0x40000000)
 #define PROTECT_MASK (0x3fffffff)
-#define PROTECT(sa_idx) (SPI2IDX(sa_idx) & PROTECT_MASK) /* SA idx 30 bits */
+#define PROTECT(spi) ((spi) & PROTECT_MASK) /* SPI 30 bits */
 
 #define IPSEC_XFORM_MAX 2
 
@@ -180,7 +179,7 @@ ipsec_inbound(struct ipsec_ctx *ctx, struct rte_mbuf *pkts[],
 
 uint16_t
 ipsec_outbound(struct ipsec_ctx *ctx, struct rte_mbuf *pkts[],
-		uint32_t sa_idx[], uint16_t nb_pkts, uint16_t len);
+		uint32_t spi[], uint16_t nb_pkts, uint16_t len);
 
 static inline uint16_t
 ipsec_metadata_size(void)
@@ -217,14 +216,14 @@ get_sym_cop(struct rte_crypto_op *cop)
 }
 
 int
-inbound_sa_check(struct sa_ctx *sa_ctx, struct rte_mbuf *m, uint32_t sa_idx);
+inbound_sa_check(struct sa_ctx *sa_ctx, struct rte_mbuf *m, uint32_t spi);
 
 void
 inbound_sa_lookup(struct sa_ctx *sa_ctx, struct rte_mbuf *pkts[],
 		struct ipsec_sa *sa[], uint16_t nb_pkts);
 
 void
-outbound_sa_lookup(struct sa_ctx *sa_ctx, uint32_t sa_idx[],
+outbound_sa_lookup(struct sa_ctx *sa_ctx, uint32_t spi[],
 		struct ipsec_sa *sa[], uint16_t nb_pkts);
 
 void
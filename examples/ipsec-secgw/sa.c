@@ -11,6 +11,9 @@
 #include <netinet/ip6.h>
 
 #include <rte_memzone.h>
+#include <rte_malloc.h>
+#include <rte_hash.h>
+#include <rte_jhash.h>
 #include <rte_crypto.h>
 #include <rte_security.h>
 #include <rte_cryptodev.h>
@@ -125,11 +128,40 @@ const struct supported_aead_algo aead_algos[] = {
 	}
 };
 
-struct ipsec_sa sa_out[IPSEC_SA_MAX_ENTRIES];
+#define SA_RULES_INIT_NUM 128
+#define SA_HASH_MIN_ENTRIES 64U
+
+struct ipsec_sa *sa_out;
 uint32_t nb_sa_out;
+static uint32_t sa_out_sz;
 
-struct ipsec_sa sa_in[IPSEC_SA_MAX_ENTRIES];
+struct ipsec_sa *sa_in;
 uint32_t nb_sa_in;
+static uint32_t sa_in_sz;
+
+/*
+ * Return the rule following the nb parsed ones, growing the array when it
+ * is full, so that only the memory of the configured rules is used.
+ */
+static struct ipsec_sa *
+sa_rule_get(struct ipsec_sa **rules, uint32_t nb, uint32_t *sz)
+{
+	struct ipsec_sa *r;
+	uint32_t n;
+
+	if (nb == *sz) {
+		n = (*sz == 0) ? SA_RULES_INIT_NUM : *sz * 2;
+		r = rte_realloc(*rules, n * sizeof(*r), RTE_CACHE_LINE_SIZE);
+		if (r == NULL)
+			return NULL;
+		*rules = r;
+		*sz = n;
+	}
+
+	r = &(*rules)[nb];
+	memset(r, 0, sizeof(*r));
+	return r;
+}
 
 static const struct supported_cipher_algo *
 find_match_cipher_algo(const char *cipher_keyword)
@@ -238,7 +270,7 @@ parse_sa_tokens(char **tokens, uint32_t n_tokens,
 		if (status->status < 0)
 			return;
 
-		rule = &sa_in[*ri];
+		rule = sa_rule_get(&sa_in, *ri, &sa_in_sz);
 	} else {
 		ri = &nb_sa_out;
 
@@ -247,9 +279,14 @@ parse_sa_tokens(char **tokens, uint32_t n_tokens,
 		if (status->status < 0)
 			return;
 
-		rule = &sa_out[*ri];
+		rule = sa_rule_get(&sa_out, *ri, &sa_out_sz);
 	}
 
+	APP_CHECK(rule != NULL, status,
+		"failed to allocate sa rule, abort insertion\n");
+	if (status->status < 0)
+		return;
+
 	/* spi number */
 	APP_CHECK_TOKEN_IS_NUM(tokens, 1, status);
 	if (status->status < 0)
@@ -257,6 +294,10 @@ parse_sa_tokens(char **tokens, uint32_t n_tokens,
 	if (atoi(tokens[1]) == INVALID_SPI)
 		return;
 	rule->spi = atoi(tokens[1]);
+	APP_CHECK(rule->spi <= PROTECT_MASK, status,
+		"SPI %u is out of range, max %u\n", rule->spi, PROTECT_MASK);
+	if (status->status < 0)
+		return;
 
 	for (ti = 2; ti < n_tokens; ti++) {
 		if (strcmp(tokens[ti], "mode") == 0) {
@@ -693,31 +734,39 @@ print_one_sa_rule(const struct ipsec_sa *sa, int inbound)
 	printf("\n");
 }
 
+/*
+ * The SAs are stored in a dense array sized from the number of rules, and
+ * found from their SPI through a hash table. Its lookups are lock-free, so
+ * that the table can be updated while the lcores read it.
+ */
 struct sa_ctx {
-	struct ipsec_sa sa[IPSEC_SA_MAX_ENTRIES];
+	struct rte_hash *spi_hash;
+	uint32_t nb_sa;
 	union {
 		struct {
 			struct rte_crypto_sym_xform a;
 			struct rte_crypto_sym_xform b;
 		};
-	} xf[IPSEC_SA_MAX_ENTRIES];
+	} *xf;
+	struct ipsec_sa sa[];
 };
 
 static struct sa_ctx *
-sa_create(const char *name, int32_t socket_id)
+sa_create(const char *name, int32_t socket_id, uint32_t nb_entries)
 {
 	char s[PATH_MAX];
 	struct sa_ctx *sa_ctx;
-	uint32_t mz_size;
+	size_t mz_size;
 	const struct rte_memzone *mz;
+	struct rte_hash_parameters params = { 0 };
 
 	snprintf(s, sizeof(s), "%s_%u", name, socket_id);
 
 	/* Create SA array table */
-	printf("Creating SA context with %u maximum entries\n",
-			IPSEC_SA_MAX_ENTRIES);
+	printf("Creating SA context with %u entries\n", nb_entries);
 
-	mz_size = sizeof(struct sa_ctx);
+	mz_size = sizeof(struct sa_ctx) + nb_entries *
+		(sizeof(sa_ctx->sa[0]) + sizeof(sa_ctx->xf[0]));
 	mz = rte_memzone_reserve(s, mz_size, socket_id,
 			RTE_MEMZONE_1GB | RTE_MEMZONE_SIZE_HINT_ONLY);
 	if (mz == NULL) {
@@ -727,6 +776,26 @@ sa_create(const char *name, int32_t socket_id)
 	}
 
 	sa_ctx = (struct sa_ctx *)mz->addr;
+	sa_ctx->nb_sa = 0;
+	sa_ctx->xf = (void *)&sa_ctx->sa[nb_entries];
+
+	snprintf(s, sizeof(s), "%s_hash_%u", name, socket_id);
+
+	/* twice as many entries as SAs keeps the buckets lightly loaded */
+	params.name = s;
+	params.entries = RTE_MAX(nb_entries * 2, SA_HASH_MIN_ENTRIES);
+	params.key_len = sizeof(uint32_t);
+	params.hash_func = rte_jhash;
+	params.hash_func_init_val = 0;
+	params.socket_id = socket_id;
+	params.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+
+	sa_ctx->spi_hash = rte_hash_create(&params);
+	if (sa_ctx->spi_hash == NULL) {
+		printf("Failed to create SA hash table\n");
+		rte_memzone_free(mz);
+		return NULL;
+	}
 
 	return sa_ctx;
 }
@@ -765,15 +834,15 @@ sa_add_rules(struct sa_ctx *sa_ctx, const struct ipsec_sa entries[],
 	struct ipsec_sa *sa;
 	uint32_t i, idx;
 	uint16_t iv_length;
+	int32_t ret;
 
 	for (i = 0; i < nb_entries; i++) {
-		idx = SPI2IDX(entries[i].spi);
-		sa = &sa_ctx->sa[idx];
-		if (sa->spi != 0) {
-			printf("Index %u already in use by SPI %u\n",
-					idx, sa->spi);
+		if (rte_hash_lookup(sa_ctx->spi_hash, &entries[i].spi) >= 0) {
+			printf("SPI %u already in use\n", entries[i].spi);
 			return -EINVAL;
 		}
+		idx = sa_ctx->nb_sa;
+		sa = &sa_ctx->sa[idx];
 		*sa = entries[i];
 		sa->seq = 0;
 
@@ -882,6 +951,15 @@ sa_add_rules(struct sa_ctx *sa_ctx, const struct ipsec_sa entries[],
 
 			print_one_sa_rule(sa, inbound);
 		}
+
+		/* the SA is complete before the lcores can find it */
+		ret = rte_hash_add_key_data(sa_ctx->spi_hash, &sa->spi, sa);
+		if (ret < 0) {
+			printf("Failed to add SPI %u to the SA hash\n",
+					sa->spi);
+			return ret;
+		}
+		sa_ctx->nb_sa++;
 	}
 
 	return 0;
@@ -919,63 +997,56 @@ sa_init(struct socket_ctx *ctx, int32_t socket_id)
 
 	if (nb_sa_in > 0) {
 		name = "sa_in";
-		ctx->sa_in = sa_create(name, socket_id);
+		ctx->sa_in = sa_create(name, socket_id, nb_sa_in);
 		if (ctx->sa_in == NULL)
 			rte_exit(EXIT_FAILURE, "Error [%d] creating SA "
 				"context %s in socket %d\n", rte_errno,
 				name, socket_id);
 
-		sa_in_add_rules(ctx->sa_in, sa_in, nb_sa_in);
+		if (sa_in_add_rules(ctx->sa_in, sa_in, nb_sa_in) < 0)
+			rte_exit(EXIT_FAILURE, "Error adding SA rules to "
+				"context %s in socket %d\n", name, socket_id);
 	} else
 		RTE_LOG(WARNING, IPSEC, "No SA Inbound rule specified\n");
 
 	if (nb_sa_out > 0) {
 		name = "sa_out";
-		ctx->sa_out = sa_create(name, socket_id);
+		ctx->sa_out = sa_create(name, socket_id, nb_sa_out);
 		if (ctx->sa_out == NULL)
 			rte_exit(EXIT_FAILURE, "Error [%d] creating SA "
 				"context %s in socket %d\n", rte_errno,
 				name, socket_id);
 
-		sa_out_add_rules(ctx->sa_out, sa_out, nb_sa_out);
+		if (sa_out_add_rules(ctx->sa_out, sa_out, nb_sa_out) < 0)
+			rte_exit(EXIT_FAILURE, "Error adding SA rules to "
+				"context %s in socket %d\n", name, socket_id);
 	} else
 		RTE_LOG(WARNING, IPSEC, "No SA Outbound rule "
 			"specified\n");
 }
 
 int
-inbound_sa_check(struct sa_ctx *sa_ctx, struct rte_mbuf *m, uint32_t sa_idx)
+inbound_sa_check(struct sa_ctx *sa_ctx __rte_unused, struct rte_mbuf *m,
+		uint32_t spi)
 {
 	struct ipsec_mbuf_metadata *priv;
 
 	priv = get_priv(m);
 
-	return (sa_ctx->sa[sa_idx].spi == priv->sa->spi);
+	return (priv->sa->spi == spi);
 }
 
 static inline void
-single_inbound_lookup(struct ipsec_sa *sadb, struct rte_mbuf *pkt,
+single_inbound_lookup(struct ipsec_sa *sa, void *ip_hdr,
 		struct ipsec_sa **sa_ret)
 {
-	struct esp_hdr *esp;
-	struct ip *ip;
+	struct ip *ip = ip_hdr;
 	uint32_t *src4_addr;
 	uint8_t *src6_addr;
-	struct ipsec_sa *sa;
 
 	*sa_ret = NULL;
 
-	ip = rte_pktmbuf_mtod(pkt, struct ip *);
-	if (ip->ip_v == IPVERSION)
-		esp = (struct esp_hdr *)(ip + 1);
-	else
-		esp = (struct esp_hdr *)(((struct ip6_hdr *)ip) + 1);
-
-	if (esp->spi == INVALID_SPI)
-		return;
-
-	sa = &sadb[SPI2IDX(rte_be_to_cpu_32(esp->spi))];
-	if (rte_be_to_cpu_32(esp->spi) != sa->spi)
+	if (sa == NULL)
 		return;
 
 	switch (sa->flags) {
@@ -998,22 +1069,62 @@ single_inbound_lookup(struct ipsec_sa *sadb, struct rte_mbuf *pkt,
 	}
 }
 
+/*
+ * Look up the SAs of a burst with a single bulk lookup, which hides the
+ * cache misses of the hash buckets of up to RTE_HASH_LOOKUP_BULK_MAX SPIs.
+ */
+static inline void
+sa_spi_lookup(struct sa_ctx *sa_ctx, const uint32_t spi[],
+		struct ipsec_sa *sa[], uint16_t nb_spi)
+{
+	const void *keys[RTE_HASH_LOOKUP_BULK_MAX];
+	void *data[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t hits;
+	uint32_t i, j, n;
+
+	for (i = 0; i < nb_spi; i += n) {
+		n = RTE_MIN(nb_spi - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		for (j = 0; j != n; j++)
+			keys[j] = &spi[i + j];
+
+		hits = 0;
+		rte_hash_lookup_bulk_data(sa_ctx->spi_hash, keys, n, &hits,
+				data);
+
+		/* data of the misses is left unset by the lookup */
+		for (j = 0; j != n; j++)
+			sa[i + j] = (hits & (1ULL << j)) ? data[j] : NULL;
+	}
+}
+
 void
 inbound_sa_lookup(struct sa_ctx *sa_ctx, struct rte_mbuf *pkts[],
 		struct ipsec_sa *sa[], uint16_t nb_pkts)
 {
+	uint32_t spi[nb_pkts];
+	struct esp_hdr *esp;
+	struct ip *ip;
 	uint32_t i;
 
+	for (i = 0; i < nb_pkts; i++) {
+		ip = rte_pktmbuf_mtod(pkts[i], struct ip *);
+		if (ip->ip_v == IPVERSION)
+			esp = (struct esp_hdr *)(ip + 1);
+		else
+			esp = (struct esp_hdr *)(((struct ip6_hdr *)ip) + 1);
+		spi[i] = rte_be_to_cpu_32(esp->spi);
+	}
+
+	sa_spi_lookup(sa_ctx, spi, sa, nb_pkts);
+
 	for (i = 0; i < nb_pkts; i++)
-		single_inbound_lookup(sa_ctx->sa, pkts[i], &sa[i]);
+		single_inbound_lookup(sa[i],
+			rte_pktmbuf_mtod(pkts[i], void *), &sa[i]);
 }
 
 void
-outbound_sa_lookup(struct sa_ctx *sa_ctx, uint32_t sa_idx[],
+outbound_sa_lookup(struct sa_ctx *sa_ctx, uint32_t spi[],
 		struct ipsec_sa *sa[], uint16_t nb_pkts)
 {
-	uint32_t i;
-
-	for (i = 0; i < nb_pkts; i++)
-		sa[i] = &sa_ctx->sa[sa_idx[i]];
+	sa_spi_lookup(sa_ctx, spi, sa, nb_pkts);
 }
@@ -63,6 +63,15 @@ static uint32_t l2fwd_dst_ports[RTE_MAX_ETHPORTS];
 #define UPDATE_STEP_UP 1
 #define UPDATE_STEP_DOWN 32
 
+/* Adaptive polling: the load of the lcores is checked every ~10ms. Below
+ * LOAD_LOW the forward jobs may poll up to IDLE_PERIOD_FACTOR times less
+ * often than the TX drain period, above LOAD_HIGH they poll at least once
+ * per TX drain period again. */
+#define LOAD_PERIOD_US 10000
+#define LOAD_LOW 250 /* per mille */
+#define LOAD_HIGH 750 /* per mille */
+#define IDLE_PERIOD_FACTOR 8
+
 static unsigned int l2fwd_rx_queue_per_lcore = 1;
 
 #define MAX_RX_QUEUE_PER_LCORE 16
@@ -74,11 +83,13 @@ struct lcore_queue_conf {
 
 	struct rte_timer rx_timers[MAX_RX_QUEUE_PER_LCORE];
 	struct rte_jobstats port_fwd_jobs[MAX_RX_QUEUE_PER_LCORE];
+	struct rte_jobstats_hist port_fwd_hists[MAX_RX_QUEUE_PER_LCORE];
 
 	struct rte_timer flush_timer;
 	struct rte_jobstats flush_job;
 	struct rte_jobstats idle_job;
 	struct rte_jobstats_context jobs_context;
+	uint64_t next_load_time;
 
 	rte_atomic16_t stats_read_pending;
 	rte_spinlock_t lock;
@@ -114,6 +125,8 @@ static int64_t timer_period = 10;
 static double hz;
 /* BURST_TX_DRAIN_US converted to cycles */
 uint64_t drain_tsc;
+/* LOAD_PERIOD_US converted to cycles */
+static uint64_t load_tsc;
 /* Convert cycles to ns */
 static inline double
 cycles_to_ns(uint64_t cycles)
@@ -125,6 +138,22 @@ cycles_to_ns(uint64_t cycles)
 	return t;
 }
 
+/* Print the non empty buckets of a job execute time histogram */
+static void
+show_job_hist(const struct rte_jobstats_hist *hist)
+{
+	unsigned int i;
+
+	printf("\n%-18s", "Exec histogram");
+	for (i = 0; i < RTE_JOBSTATS_HIST_BUCKETS; i++) {
+		if (hist->count[i] == 0)
+			continue;
+		printf(" >=%.0fns: %" PRIu64,
+				i == 0 ? 0 : cycles_to_ns(UINT64_C(1) << i),
+				hist->count[i]);
+	}
+}
+
 static void
 show_lcore_stats(unsigned lcore_id)
 {
@@ -144,6 +173,8 @@ show_lcore_stats(unsigned lcore_id)
 	uint64_t jobs_exec_cnt[port_cnt], jobs_period[port_cnt];
 	uint64_t jobs_exec[port_cnt], jobs_exec_min[port_cnt],
 				jobs_exec_max[port_cnt];
+	struct rte_jobstats_hist jobs_hist[port_cnt];
+	uint64_t load;
 
 	uint64_t flush_exec_cnt, flush_period;
 	uint64_t flush_exec, flush_exec_min, flush_exec_max;
@@ -169,6 +200,8 @@ show_lcore_stats(unsigned lcore_id)
 	management_min = ctx->min_management_time;
 	management_max = ctx->max_management_time;
 
+	load = ctx->load;
+
 	rte_jobstats_context_reset(ctx);
 
 	for (i = 0; i < port_cnt; i++) {
@@ -180,6 +213,7 @@ show_lcore_stats(unsigned lcore_id)
 		jobs_exec[i] = job->exec_time;
 		jobs_exec_min[i] = job->min_exec_time;
 		jobs_exec_max[i] = job->max_exec_time;
+		jobs_hist[i] = qconf->port_fwd_hists[i];
 
 		rte_jobstats_reset(job);
 	}
@@ -214,6 +248,7 @@ show_lcore_stats(unsigned lcore_id)
 			"\n%-18s %14s %7s %10s %10s %10s "
 			"\n%-18s %'14.0f"
 			"\n%-18s %'14" PRIu64
+			"\n%-18s %14.1f%%"
 			STAT_FMT /* Exec */
 			STAT_FMT /* Management */
 			STAT_FMT /* Busy */
@@ -222,6 +257,7 @@ show_lcore_stats(unsigned lcore_id)
 			"Stat type", "total", "%total", "avg", "min", "max",
 			"Stats duration:", cycles_to_ns(stats_period),
 			"Loop count:", loop_count,
+			"Load:", load / 10.0,
 			"Exec time",
 			cycles_to_ns(exec), exec * 100.0 / stats_period,
 			cycles_to_ns(loop_count  ? exec / loop_count : 0),
@@ -258,6 +294,7 @@ show_lcore_stats(unsigned lcore_id)
 						: 0),
 				cycles_to_ns(jobs_exec_min[i]),
 				cycles_to_ns(jobs_exec_max[i]));
+		show_job_hist(&jobs_hist[i]);
 	}
 
 	if (qconf->n_rx_port > 0) {
@@ -422,6 +459,26 @@ l2fwd_fwd_job(__rte_unused struct rte_timer *timer, void *arg)
 	}
 }
 
+/* Let the forward jobs poll less often while the lcore is mostly idle */
+static void
+l2fwd_adapt_polling(struct lcore_queue_conf *qconf)
+{
+	uint64_t load, max_period;
+	unsigned i;
+
+	load = rte_jobstats_context_load(&qconf->jobs_context,
+			&qconf->idle_job);
+	if (load < LOAD_LOW)
+		max_period = drain_tsc * IDLE_PERIOD_FACTOR;
+	else if (load > LOAD_HIGH)
+		max_period = drain_tsc;
+	else
+		return;
+
+	for (i = 0; i < qconf->n_rx_port; i++)
+		rte_jobstats_set_max(&qconf->port_fwd_jobs[i], max_period);
+}
+
 static void
 l2fwd_flush_job(__rte_unused struct rte_timer *timer, __rte_unused void *arg)
 {
@@ -456,6 +513,11 @@ l2fwd_flush_job(__rte_unused struct rte_timer *timer, __rte_unused void *arg)
 		qconf->next_flush_time[portid] = rte_get_timer_cycles() + drain_tsc;
 	}
 
+	if (qconf->next_load_time <= now) {
+		l2fwd_adapt_polling(qconf);
+		qconf->next_load_time = now + load_tsc;
+	}
+
 	/* Pass target to indicate that this job is happy of time interwal
 	 * in which it was called. */
 	rte_jobstats_finish(&qconf->flush_job, qconf->flush_job.target);
@@ -489,6 +551,7 @@ l2fwd_main_loop(void)
 	}
 
 	rte_jobstats_init(&qconf->idle_job, "idle", 0, 0, 0, 0);
+	rte_jobstats_register(&qconf->idle_job, lcore_id);
 
 	for (;;) {
 		rte_spinlock_lock(&qconf->lock);
@@ -933,6 +996,7 @@ main(int argc, char **argv)
 	check_all_ports_link_status(l2fwd_enabled_port_mask);
 
 	drain_tsc = (hz + US_PER_S - 1) / US_PER_S * BURST_TX_DRAIN_US;
+	load_tsc = (hz + US_PER_S - 1) / US_PER_S * LOAD_PERIOD_US;
 
 	RTE_LCORE_FOREACH(lcore_id) {
 		qconf = &lcore_queue_conf[lcore_id];
@@ -954,6 +1018,10 @@ main(int argc, char **argv)
 		rte_jobstats_init(&qconf->flush_job, "flush", drain_tsc, drain_tsc,
 				drain_tsc, 0);
 
+		/* Export the jobs of this lcore, e.g. through telemetry. */
+		rte_jobstats_context_register(&qconf->jobs_context, lcore_id);
+		rte_jobstats_register(&qconf->flush_job, lcore_id);
+
 		rte_timer_init(&qconf->flush_timer);
 		ret = rte_timer_reset(&qconf->flush_timer, drain_tsc, PERIODICAL,
 				lcore_id, &l2fwd_flush_job, NULL);
@@ -975,6 +1043,9 @@ main(int argc, char **argv)
 			 * this is desired optimal RX/TX burst size. */
 			rte_jobstats_init(job, name, 0, drain_tsc, 0, MAX_PKT_BURST);
 			rte_jobstats_set_update_period_function(job, l2fwd_job_update_cb);
+			rte_jobstats_set_histogram(job,
+					&qconf->port_fwd_hists[i]);
+			rte_jobstats_register(job, lcore_id);
 
 			rte_timer_init(&qconf->rx_timers[i]);
 			ret = rte_timer_reset(&qconf->rx_timers[i], 0, PERIODICAL, lcore_id,
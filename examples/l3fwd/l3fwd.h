@@ -56,6 +56,7 @@ struct mbuf_table {
 struct lcore_rx_queue {
 	uint16_t port_id;
 	uint8_t queue_id;
+	uint16_t burst; /**< Rx burst size of the port */
 } __rte_cache_aligned;
 
 struct lcore_conf {
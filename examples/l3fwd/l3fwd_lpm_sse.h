@@ -77,6 +77,48 @@ processx4_step2(const struct lcore_conf *qconf,
 	}
 }
 
+#ifdef RTE_MACHINE_CPUFLAG_AVX2
+/*
+ * Lookup into LPM for destination port of 8 packets at once.
+ * If lookup fails, use incoming port (portid) as destination port.
+ */
+static inline void
+processx8_step2(const struct lcore_conf *qconf,
+		const __m128i dip[2],
+		const uint32_t ipv4_flag[2],
+		uint16_t portid,
+		struct rte_mbuf *pkt[2 * FWDSTEP],
+		uint16_t dprt[2 * FWDSTEP])
+{
+	rte_ymm_t dst;
+	__m256i dipx8;
+	const __m256i bswap_mask = _mm256_set_epi8(12, 13, 14, 15,
+						8, 9, 10, 11, 4, 5, 6, 7,
+						0, 1, 2, 3, 12, 13, 14, 15,
+						8, 9, 10, 11, 4, 5, 6, 7,
+						0, 1, 2, 3);
+
+	/* if not all 8 packets are IPV4, handle them 4 by 4. */
+	if (unlikely(!ipv4_flag[0] || !ipv4_flag[1])) {
+		processx4_step2(qconf, dip[0], ipv4_flag[0], portid, pkt, dprt);
+		processx4_step2(qconf, dip[1], ipv4_flag[1], portid,
+				pkt + FWDSTEP, dprt + FWDSTEP);
+		return;
+	}
+
+	/* Byte swap 8 IPV4 addresses. */
+	dipx8 = _mm256_inserti128_si256(_mm256_castsi128_si256(dip[0]),
+			dip[1], 1);
+	dipx8 = _mm256_shuffle_epi8(dipx8, bswap_mask);
+
+	rte_lpm_lookupx8(qconf->ipv4_lookup_struct, dipx8, dst.u32, portid);
+	/* get rid of unused upper 16 bit for each dport. */
+	dst.y = _mm256_packs_epi32(dst.y, dst.y);
+	*(uint64_t *)dprt = dst.u64[0];
+	*(uint64_t *)(dprt + FWDSTEP) = dst.u64[2];
+}
+#endif
+
 /*
  * Buffer optimized handling of packets, invoked
  * from main_loop.
@@ -95,7 +137,14 @@ l3fwd_lpm_send_packets(int nb_rx, struct rte_mbuf **pkts_burst,
 		processx4_step1(&pkts_burst[j], &dip[j / FWDSTEP],
 				&ipv4_flag[j / FWDSTEP]);
 
-	for (j = 0; j != k; j += FWDSTEP)
+#ifdef RTE_MACHINE_CPUFLAG_AVX2
+	for (j = 0; j + 2 * FWDSTEP <= k; j += 2 * FWDSTEP)
+		processx8_step2(qconf, &dip[j / FWDSTEP],
+				&ipv4_flag[j / FWDSTEP], portid, &pkts_burst[j], &dst_port[j]);
+#else
+	j = 0;
+#endif
+	for (; j != k; j += FWDSTEP)
 		processx4_step2(qconf, dip[j / FWDSTEP],
 				ipv4_flag[j / FWDSTEP], portid, &pkts_burst[j], &dst_port[j]);
 
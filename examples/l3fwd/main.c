@@ -73,6 +73,9 @@ static int numa_on = 1; /**< NUMA is enabled by default. */
 static int parse_ptype; /**< Parse packet type using rx callback, and */
 			/**< disabled by default */
 
+/* Rx burst size of the ports, 0 for the driver preference */
+static uint16_t rx_burst_size[RTE_MAX_ETHPORTS];
+
 /* Global variables. */
 
 volatile bool force_quit;
@@ -285,7 +288,8 @@ print_usage(const char *prgname)
 		" [--no-numa]"
 		" [--hash-entry-num]"
 		" [--ipv6]"
-		" [--parse-ptype]\n\n"
+		" [--parse-ptype]"
+		" [--burst=X,N]\n\n"
 
 		"  -p PORTMASK: Hexadecimal bitmask of ports to configure\n"
 		"  -P : Enable promiscuous mode\n"
@@ -299,8 +303,9 @@ print_usage(const char *prgname)
 		"  --no-numa: Disable numa awareness\n"
 		"  --hash-entry-num: Specify the hash entry number in hexadecimal to be setup\n"
 		"  --ipv6: Set if running ipv6 packets\n"
-		"  --parse-ptype: Set to use software to analyze packet type\n\n",
-		prgname);
+		"  --parse-ptype: Set to use software to analyze packet type\n"
+		"  --burst=X,N: Rx burst size N of port X, up to %d\n\n",
+		prgname, MAX_PKT_BURST);
 }
 
 static int
@@ -435,6 +440,30 @@ parse_eth_dest(const char *optarg)
 	*(uint64_t *)(val_eth + portid) = dest_eth_addr[portid];
 }
 
+static void
+parse_burst(const char *optarg)
+{
+	unsigned long burst;
+	uint16_t portid;
+	char *end;
+
+	errno = 0;
+	portid = strtoul(optarg, &end, 10);
+	if (errno != 0 || end == optarg || *end++ != ',')
+		rte_exit(EXIT_FAILURE, "Invalid burst: %s\n", optarg);
+	if (portid >= RTE_MAX_ETHPORTS)
+		rte_exit(EXIT_FAILURE,
+		"burst: port %d >= RTE_MAX_ETHPORTS(%d)\n",
+		portid, RTE_MAX_ETHPORTS);
+
+	burst = strtoul(end, &end, 10);
+	if (errno != 0 || *end != '\0' || burst == 0 ||
+			burst > MAX_PKT_BURST)
+		rte_exit(EXIT_FAILURE,
+		"burst: size must be between 1 and %d\n", MAX_PKT_BURST);
+	rx_burst_size[portid] = burst;
+}
+
 #define MAX_JUMBO_PKT_LEN  9600
 #define MEMPOOL_CACHE_SIZE 256
 
@@ -452,6 +481,7 @@ static const char short_options[] =
 #define CMD_LINE_OPT_ENABLE_JUMBO "enable-jumbo"
 #define CMD_LINE_OPT_HASH_ENTRY_NUM "hash-entry-num"
 #define CMD_LINE_OPT_PARSE_PTYPE "parse-ptype"
+#define CMD_LINE_OPT_BURST "burst"
 enum {
 	/* long options mapped to a short option */
 
@@ -465,6 +495,7 @@ enum {
 	CMD_LINE_OPT_ENABLE_JUMBO_NUM,
 	CMD_LINE_OPT_HASH_ENTRY_NUM_NUM,
 	CMD_LINE_OPT_PARSE_PTYPE_NUM,
+	CMD_LINE_OPT_BURST_NUM,
 };
 
 static const struct option lgopts[] = {
@@ -475,6 +506,7 @@ static const struct option lgopts[] = {
 	{CMD_LINE_OPT_ENABLE_JUMBO, 0, 0, CMD_LINE_OPT_ENABLE_JUMBO_NUM},
 	{CMD_LINE_OPT_HASH_ENTRY_NUM, 1, 0, CMD_LINE_OPT_HASH_ENTRY_NUM_NUM},
 	{CMD_LINE_OPT_PARSE_PTYPE, 0, 0, CMD_LINE_OPT_PARSE_PTYPE_NUM},
+	{CMD_LINE_OPT_BURST, 1, 0, CMD_LINE_OPT_BURST_NUM},
 	{NULL, 0, 0, 0}
 };
 
@@ -594,6 +626,10 @@ parse_args(int argc, char **argv)
 			parse_ptype = 1;
 			break;
 
+		case CMD_LINE_OPT_BURST_NUM:
+			parse_burst(optarg);
+			break;
+
 		default:
 			print_usage(prgname);
 			return -1;
@@ -776,8 +812,14 @@ prepare_ptype_parser(uint16_t portid, uint16_t queueid)
 	if (l3fwd_lkp.check_ptype(portid))
 		return 1;
 
-	printf("port %d cannot parse packet type, please add --%s\n",
-	       portid, CMD_LINE_OPT_PARSE_PTYPE);
+	/* Virtual ports like vhost and virtio don't set the packet type */
+	printf("Port %d: softly parse packet type info\n", portid);
+	if (rte_eth_add_rx_callback(portid, queueid,
+				    l3fwd_lkp.cb_parse_ptype,
+				    NULL))
+		return 1;
+
+	printf("Failed to add rx callback: port=%d\n", portid);
 	return 0;
 }
 
@@ -870,6 +912,31 @@ main(int argc, char **argv)
 				port_conf.rx_adv_conf.rss_conf.rss_hf,
 				local_port_conf.rx_adv_conf.rss_conf.rss_hf);
 		}
+		/*
+		 * The queues of vhost and virtio ports are filled by the
+		 * peer, which spreads the flows itself.
+		 */
+		if (local_port_conf.rx_adv_conf.rss_conf.rss_hf == 0)
+			local_port_conf.rxmode.mq_mode = ETH_MQ_RX_NONE;
+
+		/* Packets of virtual ports are checked in software */
+		local_port_conf.rxmode.offloads &= dev_info.rx_offload_capa;
+		if (local_port_conf.rxmode.offloads !=
+				port_conf.rxmode.offloads) {
+			printf("Port %u modified Rx offloads based on hardware support,"
+				"requested:%#"PRIx64" configured:%#"PRIx64"\n",
+				portid,
+				port_conf.rxmode.offloads,
+				local_port_conf.rxmode.offloads);
+		}
+
+		if (rx_burst_size[portid] == 0)
+			rx_burst_size[portid] =
+				dev_info.default_rxportconf.burst_size;
+		if (rx_burst_size[portid] == 0 ||
+				rx_burst_size[portid] > MAX_PKT_BURST)
+			rx_burst_size[portid] = MAX_PKT_BURST;
+		printf("rx_burst=%u ", rx_burst_size[portid]);
 
 		ret = rte_eth_dev_configure(portid, nb_rx_queue,
 					(uint16_t)n_tx_queue, &local_port_conf);
@@ -951,6 +1018,8 @@ main(int argc, char **argv)
 
 			portid = qconf->rx_queue_list[queue].port_id;
 			queueid = qconf->rx_queue_list[queue].queue_id;
+			qconf->rx_queue_list[queue].burst =
+				rx_burst_size[portid];
 			dev = &rte_eth_devices[portid];
 			conf = &dev->data->dev_conf;
 
@@ -80,7 +80,10 @@ static const char usage[] =
 "           F = I/O TX lcore write burst size to NIC TX (default value is %u)   \n"
 "    --pos-lb POS : Position of the 1-byte field within the input packet used by\n"
 "           the I/O RX lcores to identify the worker lcore for the current      \n"
-"           packet (default value is %u)                                        \n";
+"           packet (default value is %u)                                        \n"
+"    --lb-flow : Identify the worker lcore from a hash of the flow of the packet\n"
+"           (the RSS hash, or the IPv4 addresses and TCP/UDP ports) instead of  \n"
+"           the field at --pos-lb, for ports such as vhost without RSS          \n";
 
 void
 app_print_usage(void)
@@ -603,6 +606,7 @@ app_parse_args(int argc, char **argv)
 		{"rsz", 1, 0, 0},
 		{"bsz", 1, 0, 0},
 		{"pos-lb", 1, 0, 0},
+		{"lb-flow", 0, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 	uint32_t arg_w = 0;
@@ -677,6 +681,9 @@ app_parse_args(int argc, char **argv)
 					return -1;
 				}
 			}
+			if (!strcmp(lgopts[option_index].name, "lb-flow")) {
+				app.lb_flow = 1;
+			}
 			break;
 
 		default:
@@ -38,6 +38,7 @@
 #include <rte_ip.h>
 #include <rte_tcp.h>
 #include <rte_lpm.h>
+#include <rte_metrics.h>
 
 #include "main.h"
 
@@ -322,6 +323,41 @@ app_init_rings_tx(void)
 	}
 }
 
+static void
+app_init_metrics(void)
+{
+	static const char * const suffixes[APP_WORKER_N_METRICS] = {
+		"rx_packets", "tx_packets", "drop_packets", "lpm_misses",
+	};
+	uint32_t lcore, i;
+
+	rte_metrics_init(rte_socket_id());
+
+	/* One set of metrics per worker, updated by the worker itself */
+	for (lcore = 0; lcore < APP_MAX_LCORES; lcore ++) {
+		struct app_lcore_params_worker *lp_worker = &app.lcore_params[lcore].worker;
+		char names[APP_WORKER_N_METRICS][RTE_METRICS_MAX_NAME_LEN];
+		const char *name_ptrs[APP_WORKER_N_METRICS];
+
+		if (app.lcore_params[lcore].type != e_APP_LCORE_WORKER) {
+			continue;
+		}
+
+		for (i = 0; i < APP_WORKER_N_METRICS; i ++) {
+			snprintf(names[i], sizeof(names[i]), "lb_worker%u_%s",
+				lp_worker->worker_id, suffixes[i]);
+			name_ptrs[i] = names[i];
+		}
+
+		lp_worker->metrics_key = rte_metrics_reg_names(name_ptrs,
+			APP_WORKER_N_METRICS);
+		if (lp_worker->metrics_key < 0) {
+			printf("Cannot register the metrics of worker %u (%d)\n",
+				lp_worker->worker_id, lp_worker->metrics_key);
+		}
+	}
+}
+
 /* Check the link status of all ports in up to 9s, and print them finally */
 static void
 check_all_ports_link_status(uint16_t port_num, uint32_t port_mask)
@@ -416,6 +452,17 @@ app_init_nics(void)
 			local_port_conf.txmode.offloads |=
 				DEV_TX_OFFLOAD_MBUF_FAST_FREE;
 
+		/* vhost ports for instance have no checksum offload */
+		local_port_conf.rxmode.offloads &= dev_info.rx_offload_capa;
+		if (local_port_conf.rxmode.offloads !=
+				port_conf.rxmode.offloads) {
+			printf("Port %u modified RX offloads based on hardware support,"
+				"requested:%#"PRIx64" configured:%#"PRIx64"\n",
+				port,
+				port_conf.rxmode.offloads,
+				local_port_conf.rxmode.offloads);
+		}
+
 		local_port_conf.rx_adv_conf.rss_conf.rss_hf &=
 			dev_info.flow_type_rss_offloads;
 		if (local_port_conf.rx_adv_conf.rss_conf.rss_hf !=
@@ -515,6 +562,7 @@ app_init(void)
 	app_init_rings_rx();
 	app_init_rings_tx();
 	app_init_nics();
+	app_init_metrics();
 
 	printf("Initialization completed.\n");
 }
@@ -203,6 +203,9 @@
 #error "APP_DEFAULT_IO_RX_LB_POS is too big"
 #endif
 
+/* Worker metrics: packets in, packets out, packets dropped, LPM misses */
+#define APP_WORKER_N_METRICS 4
+
 struct app_mbuf_array {
 	struct rte_mbuf *array[APP_MBUF_ARRAY_SIZE];
 	uint32_t n_mbufs;
@@ -281,6 +284,13 @@ struct app_lcore_params_worker {
 	uint32_t rings_in_iters[APP_MAX_IO_LCORES];
 	uint32_t rings_out_count[APP_MAX_NIC_PORTS];
 	uint32_t rings_out_iters[APP_MAX_NIC_PORTS];
+
+	/* Metrics, published for telemetry */
+	int metrics_key;
+	uint64_t pkts_in;
+	uint64_t pkts_out;
+	uint64_t pkts_drop;
+	uint64_t lpm_misses;
 };
 
 struct app_lcore_params {
@@ -330,6 +340,7 @@ struct app_params {
 
 	/* load balancing */
 	uint8_t pos_lb;
+	uint8_t lb_flow;
 } __rte_cache_aligned;
 
 extern struct app_params app;
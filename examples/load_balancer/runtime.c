@@ -37,6 +37,8 @@
 #include <rte_ip.h>
 #include <rte_tcp.h>
 #include <rte_lpm.h>
+#include <rte_hash_crc.h>
+#include <rte_metrics.h>
 
 #include "main.h"
 
@@ -92,6 +94,63 @@
 #define APP_IO_TX_PREFETCH1(p)
 #endif
 
+/*
+ * Hash of the flow of the packet: the RSS hash when the NIC computed it,
+ * otherwise a hash of the IPv4 addresses and, for the packets which are
+ * not fragments, of the TCP or UDP ports. The other packets, such as the
+ * ones from the vhost ports, are hashed on their MAC addresses.
+ */
+static inline uint32_t
+app_flow_hash(struct rte_mbuf *mbuf, uint8_t *data)
+{
+	struct ether_hdr *eth = (struct ether_hdr *) data;
+	struct ipv4_hdr *ip;
+	uint32_t hash;
+
+	if (mbuf->ol_flags & PKT_RX_RSS_HASH)
+		return mbuf->hash.rss;
+
+	if (eth->ether_type != rte_cpu_to_be_16(ETHER_TYPE_IPv4))
+		return rte_hash_crc(data, 2 * ETHER_ADDR_LEN, 0);
+
+	ip = (struct ipv4_hdr *) (eth + 1);
+	hash = rte_hash_crc_4byte(ip->src_addr, ip->next_proto_id);
+	hash = rte_hash_crc_4byte(ip->dst_addr, hash);
+
+	/* The ports are only in the first fragment */
+	if ((ip->fragment_offset & rte_cpu_to_be_16(IPV4_HDR_OFFSET_MASK |
+			IPV4_HDR_MF_FLAG)) == 0 &&
+			(ip->next_proto_id == IPPROTO_TCP ||
+			 ip->next_proto_id == IPPROTO_UDP)) {
+		uint32_t *ports = (uint32_t *) ((uint8_t *) ip +
+			((ip->version_ihl & IPV4_HDR_IHL_MASK) *
+			 IPV4_IHL_MULTIPLIER));
+
+		hash = rte_hash_crc_4byte(*ports, hash);
+	}
+
+	return hash;
+}
+
+/*
+ * Worker for the packet. Either way, all the packets of a flow go to the
+ * same worker, through the same ring, so they stay in order.
+ */
+static inline uint32_t
+app_lcore_io_rx_worker(
+	struct rte_mbuf *mbuf,
+	uint8_t *data,
+	uint32_t n_workers,
+	uint8_t pos_lb,
+	uint8_t lb_flow)
+{
+	/* The high bits of the hash, the NIC used its low bits for RSS */
+	if (lb_flow)
+		return ((uint64_t) app_flow_hash(mbuf, data) * n_workers) >> 32;
+
+	return data[pos_lb] & (n_workers - 1);
+}
+
 static inline void
 app_lcore_io_rx_buffer_to_send (
 	struct app_lcore_params_io *lp,
@@ -150,7 +209,8 @@ app_lcore_io_rx(
 	uint32_t n_workers,
 	uint32_t bsz_rd,
 	uint32_t bsz_wr,
-	uint8_t pos_lb)
+	uint8_t pos_lb,
+	uint8_t lb_flow)
 {
 	struct rte_mbuf *mbuf_1_0, *mbuf_1_1, *mbuf_2_0, *mbuf_2_1;
 	uint8_t *data_1_0, *data_1_1 = NULL;
@@ -233,8 +293,10 @@ app_lcore_io_rx(
 			APP_IO_RX_PREFETCH0(mbuf_2_0);
 			APP_IO_RX_PREFETCH0(mbuf_2_1);
 
-			worker_0 = data_0_0[pos_lb] & (n_workers - 1);
-			worker_1 = data_0_1[pos_lb] & (n_workers - 1);
+			worker_0 = app_lcore_io_rx_worker(mbuf_0_0, data_0_0,
+				n_workers, pos_lb, lb_flow);
+			worker_1 = app_lcore_io_rx_worker(mbuf_0_1, data_0_1,
+				n_workers, pos_lb, lb_flow);
 
 			app_lcore_io_rx_buffer_to_send(lp, worker_0, mbuf_0_0, bsz_wr);
 			app_lcore_io_rx_buffer_to_send(lp, worker_1, mbuf_0_1, bsz_wr);
@@ -255,7 +317,8 @@ app_lcore_io_rx(
 
 			APP_IO_RX_PREFETCH0(mbuf_1_0);
 
-			worker = data[pos_lb] & (n_workers - 1);
+			worker = app_lcore_io_rx_worker(mbuf, data, n_workers,
+				pos_lb, lb_flow);
 
 			app_lcore_io_rx_buffer_to_send(lp, worker, mbuf, bsz_wr);
 		}
@@ -433,6 +496,7 @@ app_lcore_main_loop_io(void)
 	uint32_t bsz_tx_wr = app.burst_size_io_tx_write;
 
 	uint8_t pos_lb = app.pos_lb;
+	uint8_t lb_flow = app.lb_flow;
 
 	for ( ; ; ) {
 		if (APP_LCORE_IO_FLUSH && (unlikely(i == APP_LCORE_IO_FLUSH))) {
@@ -448,7 +512,8 @@ app_lcore_main_loop_io(void)
 		}
 
 		if (likely(lp->rx.n_nic_queues > 0)) {
-			app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr, pos_lb);
+			app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr,
+				pos_lb, lb_flow);
 		}
 
 		if (likely(lp->tx.n_nic_ports > 0)) {
@@ -460,102 +525,141 @@ app_lcore_main_loop_io(void)
 }
 
 static inline void
-app_lcore_worker(
+app_lcore_worker_pkts(
 	struct app_lcore_params_worker *lp,
-	uint32_t bsz_rd,
+	struct rte_mbuf **pkts,
+	uint32_t n_pkts,
 	uint32_t bsz_wr)
 {
-	uint32_t i;
+	uint32_t j;
+	int ret;
 
-	for (i = 0; i < lp->n_rings_in; i ++) {
-		struct rte_ring *ring_in = lp->rings_in[i];
-		uint32_t j;
-		int ret;
+	APP_WORKER_PREFETCH1(rte_pktmbuf_mtod(pkts[0], unsigned char *));
+	if (likely(n_pkts > 1)) {
+		APP_WORKER_PREFETCH0(pkts[1]);
+	}
 
-		ret = rte_ring_sc_dequeue_bulk(
-			ring_in,
-			(void **) lp->mbuf_in.array,
-			bsz_rd,
-			NULL);
+	for (j = 0; j < n_pkts; j ++) {
+		struct rte_mbuf *pkt;
+		struct ipv4_hdr *ipv4_hdr;
+		uint32_t ipv4_dst, pos;
+		uint32_t port;
 
-		if (unlikely(ret == 0))
-			continue;
+		if (likely(j + 1 < n_pkts)) {
+			APP_WORKER_PREFETCH1(rte_pktmbuf_mtod(pkts[j+1], unsigned char *));
+		}
+		if (likely(j + 2 < n_pkts)) {
+			APP_WORKER_PREFETCH0(pkts[j+2]);
+		}
 
-#if APP_WORKER_DROP_ALL_PACKETS
-		for (j = 0; j < bsz_rd; j ++) {
-			struct rte_mbuf *pkt = lp->mbuf_in.array[j];
-			rte_pktmbuf_free(pkt);
+		pkt = pkts[j];
+		ipv4_hdr = rte_pktmbuf_mtod_offset(pkt,
+						   struct ipv4_hdr *,
+						   sizeof(struct ether_hdr));
+		ipv4_dst = rte_be_to_cpu_32(ipv4_hdr->dst_addr);
+
+		if (unlikely(rte_lpm_lookup(lp->lpm_table, ipv4_dst, &port) != 0)) {
+			port = pkt->port;
+			lp->lpm_misses ++;
 		}
 
-		continue;
-#endif
+		pos = lp->mbuf_out[port].n_mbufs;
 
-		APP_WORKER_PREFETCH1(rte_pktmbuf_mtod(lp->mbuf_in.array[0], unsigned char *));
-		APP_WORKER_PREFETCH0(lp->mbuf_in.array[1]);
+		lp->mbuf_out[port].array[pos ++] = pkt;
+		if (likely(pos < bsz_wr)) {
+			lp->mbuf_out[port].n_mbufs = pos;
+			continue;
+		}
 
-		for (j = 0; j < bsz_rd; j ++) {
-			struct rte_mbuf *pkt;
-			struct ipv4_hdr *ipv4_hdr;
-			uint32_t ipv4_dst, pos;
-			uint32_t port;
+		ret = rte_ring_sp_enqueue_bulk(
+			lp->rings_out[port],
+			(void **) lp->mbuf_out[port].array,
+			bsz_wr,
+			NULL);
 
-			if (likely(j < bsz_rd - 1)) {
-				APP_WORKER_PREFETCH1(rte_pktmbuf_mtod(lp->mbuf_in.array[j+1], unsigned char *));
-			}
-			if (likely(j < bsz_rd - 2)) {
-				APP_WORKER_PREFETCH0(lp->mbuf_in.array[j+2]);
+#if APP_STATS
+		lp->rings_out_iters[port] ++;
+		if (ret > 0) {
+			lp->rings_out_count[port] += 1;
+		}
+		if (lp->rings_out_iters[port] == APP_STATS){
+			printf("\t\tWorker %u out (NIC port %u): enq success rate = %.2f\n",
+				(unsigned) lp->worker_id,
+				port,
+				((double) lp->rings_out_count[port]) / ((double) lp->rings_out_iters[port]));
+			lp->rings_out_iters[port] = 0;
+			lp->rings_out_count[port] = 0;
+		}
+#endif
+
+		if (unlikely(ret == 0)) {
+			uint32_t k;
+			for (k = 0; k < bsz_wr; k ++) {
+				struct rte_mbuf *pkt_to_free = lp->mbuf_out[port].array[k];
+				rte_pktmbuf_free(pkt_to_free);
 			}
+			lp->pkts_drop += bsz_wr;
+		} else {
+			lp->pkts_out += bsz_wr;
+		}
 
-			pkt = lp->mbuf_in.array[j];
-			ipv4_hdr = rte_pktmbuf_mtod_offset(pkt,
-							   struct ipv4_hdr *,
-							   sizeof(struct ether_hdr));
-			ipv4_dst = rte_be_to_cpu_32(ipv4_hdr->dst_addr);
+		lp->mbuf_out[port].n_mbufs = 0;
+		lp->mbuf_out_flush[port] = 0;
+	}
+}
 
-			if (unlikely(rte_lpm_lookup(lp->lpm_table, ipv4_dst, &port) != 0)) {
-				port = pkt->port;
-			}
+/*
+ * The packets are read in place from the input rings, which may return
+ * them in two parts when they wrap around the end of the ring storage.
+ * Their ring entries are only given back to the I/O RX lcore once they
+ * are all buffered for the output rings.
+ */
+static inline void
+app_lcore_worker(
+	struct app_lcore_params_worker *lp,
+	uint32_t bsz_rd,
+	uint32_t bsz_wr)
+{
+	uint32_t i;
 
-			pos = lp->mbuf_out[port].n_mbufs;
+	for (i = 0; i < lp->n_rings_in; i ++) {
+		struct rte_ring *ring_in = lp->rings_in[i];
+		struct rte_ring_zc_data zcd;
+		uint32_t n_pkts;
 
-			lp->mbuf_out[port].array[pos ++] = pkt;
-			if (likely(pos < bsz_wr)) {
-				lp->mbuf_out[port].n_mbufs = pos;
-				continue;
-			}
+		n_pkts = rte_ring_sc_dequeue_zc_burst_start(
+			ring_in,
+			bsz_rd,
+			&zcd,
+			NULL);
 
-			ret = rte_ring_sp_enqueue_bulk(
-				lp->rings_out[port],
-				(void **) lp->mbuf_out[port].array,
-				bsz_wr,
-				NULL);
+		if (unlikely(n_pkts == 0))
+			continue;
 
-#if APP_STATS
-			lp->rings_out_iters[port] ++;
-			if (ret > 0) {
-				lp->rings_out_count[port] += 1;
-			}
-			if (lp->rings_out_iters[port] == APP_STATS){
-				printf("\t\tWorker %u out (NIC port %u): enq success rate = %.2f\n",
-					(unsigned) lp->worker_id,
-					port,
-					((double) lp->rings_out_count[port]) / ((double) lp->rings_out_iters[port]));
-				lp->rings_out_iters[port] = 0;
-				lp->rings_out_count[port] = 0;
-			}
-#endif
+		lp->pkts_in += n_pkts;
 
-			if (unlikely(ret == 0)) {
-				uint32_t k;
-				for (k = 0; k < bsz_wr; k ++) {
-					struct rte_mbuf *pkt_to_free = lp->mbuf_out[port].array[k];
-					rte_pktmbuf_free(pkt_to_free);
-				}
+#if APP_WORKER_DROP_ALL_PACKETS
+		{
+			uint32_t j;
+
+			for (j = 0; j < n_pkts; j ++) {
+				void *pkt = (j < zcd.n1) ?
+					zcd.ptr1[j] : zcd.ptr2[j - zcd.n1];
+				rte_pktmbuf_free((struct rte_mbuf *) pkt);
 			}
 
-			lp->mbuf_out[port].n_mbufs = 0;
-			lp->mbuf_out_flush[port] = 0;
+			rte_ring_sc_dequeue_zc_finish(ring_in, n_pkts);
+			continue;
 		}
+#endif
+
+		app_lcore_worker_pkts(lp, (struct rte_mbuf **) zcd.ptr1,
+			zcd.n1, bsz_wr);
+		if (unlikely(n_pkts > zcd.n1))
+			app_lcore_worker_pkts(lp, (struct rte_mbuf **) zcd.ptr2,
+				n_pkts - zcd.n1, bsz_wr);
+
+		rte_ring_sc_dequeue_zc_finish(ring_in, n_pkts);
 	}
 }
 
@@ -589,6 +693,9 @@ app_lcore_worker_flush(struct app_lcore_params_worker *lp)
 				struct rte_mbuf *pkt_to_free = lp->mbuf_out[port].array[k];
 				rte_pktmbuf_free(pkt_to_free);
 			}
+			lp->pkts_drop += lp->mbuf_out[port].n_mbufs;
+		} else {
+			lp->pkts_out += lp->mbuf_out[port].n_mbufs;
 		}
 
 		lp->mbuf_out[port].n_mbufs = 0;
@@ -596,6 +703,24 @@ app_lcore_worker_flush(struct app_lcore_params_worker *lp)
 	}
 }
 
+/* Written into the metrics store of the lcore, no lock is taken */
+static inline void
+app_lcore_worker_metrics(struct app_lcore_params_worker *lp)
+{
+	uint64_t values[APP_WORKER_N_METRICS];
+
+	if (lp->metrics_key < 0)
+		return;
+
+	values[0] = lp->pkts_in;
+	values[1] = lp->pkts_out;
+	values[2] = lp->pkts_drop;
+	values[3] = lp->lpm_misses;
+
+	rte_metrics_update_values(RTE_METRICS_GLOBAL, lp->metrics_key,
+		values, APP_WORKER_N_METRICS);
+}
+
 static void
 app_lcore_main_loop_worker(void) {
 	uint32_t lcore = rte_lcore_id();
@@ -608,6 +733,7 @@ app_lcore_main_loop_worker(void) {
 	for ( ; ; ) {
 		if (APP_LCORE_WORKER_FLUSH && (unlikely(i == APP_LCORE_WORKER_FLUSH))) {
 			app_lcore_worker_flush(lp);
+			app_lcore_worker_metrics(lp);
 			i = 0;
 		}
 
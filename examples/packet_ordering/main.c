@@ -31,6 +31,7 @@
 
 unsigned int portmask;
 unsigned int disable_reorder;
+unsigned int mp_reorder;
 volatile uint8_t quit_signal;
 
 static struct rte_mempool *mbuf_pool;
@@ -40,11 +41,13 @@ static struct rte_eth_conf port_conf_default;
 struct worker_thread_args {
 	struct rte_ring *ring_in;
 	struct rte_ring *ring_out;
+	struct rte_reorder_mp_buffer *mp_buffer;
 };
 
 struct send_thread_args {
 	struct rte_ring *ring_in;
 	struct rte_reorder_buffer *buffer;
+	struct rte_reorder_mp_buffer *mp_buffer;
 };
 
 volatile struct app_stats {
@@ -120,8 +123,12 @@ pktmbuf_free_bulk(struct rte_mbuf *mbuf_table[], unsigned n)
 static void
 print_usage(const char *prgname)
 {
-	printf("%s [EAL options] -- -p PORTMASK\n"
-			"  -p PORTMASK: hexadecimal bitmask of ports to configure\n",
+	printf("%s [EAL options] -- -p PORTMASK [--disable-reorder] "
+			"[--mp-reorder]\n"
+			"  -p PORTMASK: hexadecimal bitmask of ports to configure\n"
+			"  --disable-reorder: do not reorder packets\n"
+			"  --mp-reorder: workers insert packets in the reorder "
+			"buffer\n",
 			prgname);
 }
 
@@ -152,6 +159,7 @@ parse_args(int argc, char **argv)
 	char *prgname = argv[0];
 	static struct option lgopts[] = {
 		{"disable-reorder", 0, 0, 0},
+		{"mp-reorder", 0, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 
@@ -175,6 +183,10 @@ parse_args(int argc, char **argv)
 				printf("reorder disabled\n");
 				disable_reorder = 1;
 			}
+			if (!strcmp(lgopts[option_index].name, "mp-reorder")) {
+				printf("multi-producer reorder enabled\n");
+				mp_reorder = 1;
+			}
 			break;
 		default:
 			print_usage(prgname);
@@ -431,11 +443,13 @@ worker_thread(void *args_ptr)
 	struct worker_thread_args *args;
 	struct rte_mbuf *burst_buffer[MAX_PKTS_BURST] = { NULL };
 	struct rte_ring *ring_in, *ring_out;
+	struct rte_reorder_mp_buffer *mp_buffer;
 	const unsigned xor_val = (nb_ports > 1);
 
 	args = (struct worker_thread_args *) args_ptr;
 	ring_in  = args->ring_in;
 	ring_out = args->ring_out;
+	mp_buffer = args->mp_buffer;
 
 	RTE_LOG(INFO, REORDERAPP, "%s() started on lcore %u\n", __func__,
 							rte_lcore_id());
@@ -454,6 +468,28 @@ worker_thread(void *args_ptr)
 		for (i = 0; i < burst_size;)
 			burst_buffer[i++]->port ^= xor_val;
 
+		if (mp_buffer != NULL) {
+			/* insert the modified mbufs in the reorder buffer */
+			ret = 0;
+			while (ret < burst_size && !quit_signal) {
+				ret += rte_reorder_mp_insert_burst(mp_buffer,
+						&burst_buffer[ret],
+						burst_size - ret);
+				if (ret < burst_size && rte_errno == ERANGE) {
+					/* Too late pkts are dropped */
+					__sync_fetch_and_add(
+						&app_stats.wkr.enqueue_failed_pkts,
+						1);
+					rte_pktmbuf_free(burst_buffer[ret++]);
+				}
+			}
+			__sync_fetch_and_add(&app_stats.wkr.enqueue_pkts, ret);
+			if (unlikely(ret < burst_size))
+				pktmbuf_free_bulk(&burst_buffer[ret],
+						burst_size - ret);
+			continue;
+		}
+
 		/* enqueue the modified mbufs to workers_to_tx ring */
 		ret = rte_ring_enqueue_burst(ring_out, (void *)burst_buffer,
 				burst_size, NULL);
@@ -468,6 +504,53 @@ worker_thread(void *args_ptr)
 	return 0;
 }
 
+/**
+ * Drain the mbufs the workers inserted in the multi-producer reorder
+ * buffer, and transmit them.
+ */
+static int
+mp_send_thread(struct send_thread_args *args)
+{
+	unsigned int i, dret;
+	unsigned sent;
+	struct rte_mbuf *rombufs[MAX_PKTS_BURST] = {NULL};
+	static struct rte_eth_dev_tx_buffer *tx_buffer[RTE_MAX_ETHPORTS];
+
+	RTE_LOG(INFO, REORDERAPP, "%s() started on lcore %u\n", __func__,
+							rte_lcore_id());
+
+	configure_tx_buffers(tx_buffer);
+
+	while (!quit_signal) {
+
+		dret = rte_reorder_mp_drain(args->mp_buffer, rombufs,
+				MAX_PKTS_BURST);
+		app_stats.tx.dequeue_pkts += dret;
+
+		for (i = 0; i < dret; i++) {
+
+			struct rte_eth_dev_tx_buffer *outbuf;
+			uint8_t outp1;
+
+			outp1 = rombufs[i]->port;
+			/* skip ports that are not enabled */
+			if ((portmask & (1 << outp1)) == 0) {
+				rte_pktmbuf_free(rombufs[i]);
+				continue;
+			}
+
+			outbuf = tx_buffer[outp1];
+			sent = rte_eth_tx_buffer(outp1, 0, outbuf, rombufs[i]);
+			if (sent)
+				app_stats.tx.ro_tx_pkts += sent;
+		}
+	}
+
+	free_tx_buffers(tx_buffer);
+
+	return 0;
+}
+
 /**
  * Dequeue mbufs from the workers_to_tx ring and reorder them before
  * transmitting.
@@ -610,8 +693,8 @@ main(int argc, char **argv)
 	unsigned int lcore_id, last_lcore_id, master_lcore_id;
 	uint16_t port_id;
 	uint16_t nb_ports_available;
-	struct worker_thread_args worker_args = {NULL, NULL};
-	struct send_thread_args send_args = {NULL, NULL};
+	struct worker_thread_args worker_args = {NULL, NULL, NULL};
+	struct send_thread_args send_args = {NULL, NULL, NULL};
 	struct rte_ring *rx_to_workers;
 	struct rte_ring *workers_to_tx;
 
@@ -686,7 +769,12 @@ main(int argc, char **argv)
 	if (workers_to_tx == NULL)
 		rte_exit(EXIT_FAILURE, "%s\n", rte_strerror(rte_errno));
 
-	if (!disable_reorder) {
+	if (!disable_reorder && mp_reorder) {
+		send_args.mp_buffer = rte_reorder_mp_create("PKT_RO",
+				rte_socket_id(), REORDER_BUFFER_SIZE);
+		if (send_args.mp_buffer == NULL)
+			rte_exit(EXIT_FAILURE, "%s\n", rte_strerror(rte_errno));
+	} else if (!disable_reorder) {
 		send_args.buffer = rte_reorder_create("PKT_RO", rte_socket_id(),
 				REORDER_BUFFER_SIZE);
 		if (send_args.buffer == NULL)
@@ -698,6 +786,7 @@ main(int argc, char **argv)
 
 	worker_args.ring_in  = rx_to_workers;
 	worker_args.ring_out = workers_to_tx;
+	worker_args.mp_buffer = send_args.mp_buffer;
 
 	/* Start worker_thread() on all the available slave cores but the last 1 */
 	for (lcore_id = 0; lcore_id <= get_previous_lcore_id(last_lcore_id); lcore_id++)
@@ -709,6 +798,10 @@ main(int argc, char **argv)
 		/* Start tx_thread() on the last slave core */
 		rte_eal_remote_launch((lcore_function_t *)tx_thread, workers_to_tx,
 				last_lcore_id);
+	} else if (send_args.mp_buffer != NULL) {
+		/* Start mp_send_thread() on the last slave core */
+		rte_eal_remote_launch((lcore_function_t *)mp_send_thread,
+				(void *)&send_args, last_lcore_id);
 	} else {
 		send_args.ring_in = workers_to_tx;
 		/* Start send_thread() on the last slave core */
@@ -129,6 +129,8 @@ _lthread_init(struct lthread *lt,
 	lt->birth = _sched_now();
 	lt->state = BIT(ST_LT_INIT);
 	lt->join = LT_JOIN_INITIAL;
+	lt->stealable = 0;
+	lt->pending_steal = 0;
 }
 
 /*
@@ -337,10 +339,20 @@ void lthread_yield(void)
 
 	DIAG_EVENT(lt, LT_DIAG_LTHREAD_YIELD, 0, 0);
 
-	_ready_queue_insert(THIS_SCHED, lt);
+	_ready_queue_requeue(lt);
 	ctx_switch(&(THIS_SCHED)->ctx, &lt->ctx);
 }
 
+/*
+ * Allow idle schedulers to run the current lthread
+ */
+void lthread_set_stealable(int stealable)
+{
+	struct lthread *lt = THIS_LTHREAD;
+
+	lt->stealable = stealable;
+}
+
 /*
  * Exit the current lthread
  * If a thread is joining pass the user pointer to it
@@ -350,6 +350,24 @@ void lthread_yield(void);
   */
 int lthread_set_affinity(unsigned lcore);
 
+/**
+  * Allow idle schedulers to steal the current thread
+  *
+  *  By default a thread runs on the scheduler it was created on, or
+  *  migrated to. A stealable thread is requeued, when it yields, on a
+  *  deque where schedulers with nothing else to run take it from, which
+  *  balances skewed loads. Threads using per lcore resources, like the
+  *  rx and tx threads polling queues, must not be stealable.
+  *  lthread_set_affinity() pins the thread again.
+  *
+  * @param stealable
+  *	1 to let other schedulers run the thread, 0 to pin it
+  *
+  * @return
+  *  none
+  */
+void lthread_set_stealable(int stealable);
+
 /**
   * Return the current lthread
   *
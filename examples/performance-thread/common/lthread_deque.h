@@ -0,0 +1,140 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2019 Intel Corporation.
+ */
+
+#ifndef LTHREAD_DEQUE_H_
+#define LTHREAD_DEQUE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <rte_malloc.h>
+#include <rte_lcore.h>
+
+#include "lthread_int.h"
+
+/*
+ * This file implements a bounded work stealing deque, as described by
+ * Chase and Lev, with the memory ordering of Le et al. (PPoPP 2013).
+ *
+ * The owner scheduler pushes and pops lthreads at the bottom, without
+ * locked operations unless the deque holds a single lthread. Idle
+ * schedulers steal the oldest lthreads at the top.
+ *
+ * The deque holds the stealable lthreads, see lthread_set_stealable().
+ */
+
+#define LTHREAD_DEQUE_SIZE 1024
+#define LTHREAD_DEQUE_MASK (LTHREAD_DEQUE_SIZE - 1)
+
+struct lthread_deque {
+	int64_t top;					/* stealers end */
+	int64_t bottom __rte_cache_aligned;		/* owner end */
+	struct lthread *lts[LTHREAD_DEQUE_SIZE] __rte_cache_aligned;
+} __rte_cache_aligned;
+
+static inline struct lthread_deque *
+_lthread_deque_create(void)
+{
+	return rte_zmalloc_socket(NULL, sizeof(struct lthread_deque),
+				  RTE_CACHE_LINE_SIZE, rte_socket_id());
+}
+
+static inline void
+_lthread_deque_destroy(struct lthread_deque *d)
+{
+	rte_free(d);
+}
+
+/**
+ * Return true if the deque is empty
+ */
+static __rte_always_inline int
+_lthread_deque_empty(struct lthread_deque *d)
+{
+	return __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) <=
+		__atomic_load_n(&d->top, __ATOMIC_RELAXED);
+}
+
+/*
+ * Push an lthread at the bottom, by the owner only
+ * Fails if the deque is full
+ */
+static __rte_always_inline int
+_lthread_deque_push(struct lthread_deque *d, struct lthread *lt)
+{
+	int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+	int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+
+	if (b - t >= LTHREAD_DEQUE_SIZE)
+		return -1;
+
+	__atomic_store_n(&d->lts[b & LTHREAD_DEQUE_MASK], lt,
+			 __ATOMIC_RELAXED);
+	__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/*
+ * Pop the newest lthread at the bottom, by the owner only
+ */
+static __rte_always_inline struct lthread *
+_lthread_deque_pop(struct lthread_deque *d)
+{
+	int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+	struct lthread *lt = NULL;
+	int64_t t;
+
+	__atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+	if (t <= b) {
+		lt = __atomic_load_n(&d->lts[b & LTHREAD_DEQUE_MASK],
+				     __ATOMIC_RELAXED);
+		if (t != b)
+			return lt;
+
+		/* last lthread, race with the stealers */
+		if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0,
+						 __ATOMIC_SEQ_CST,
+						 __ATOMIC_RELAXED))
+			lt = NULL;
+	}
+	__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+	return lt;
+}
+
+/*
+ * Steal the oldest lthread at the top, by any scheduler
+ * Returns NULL if the deque is empty or another stealer won
+ */
+static __rte_always_inline struct lthread *
+_lthread_deque_steal(struct lthread_deque *d)
+{
+	int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+	struct lthread *lt;
+	int64_t b;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+	if (t >= b)
+		return NULL;
+
+	lt = __atomic_load_n(&d->lts[t & LTHREAD_DEQUE_MASK],
+			     __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0,
+					 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return NULL;
+	return lt;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif				/* LTHREAD_DEQUE_H_ */
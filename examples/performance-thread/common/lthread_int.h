@@ -39,6 +39,7 @@ struct lthread_key;
 struct key_pool;
 struct qnode;
 struct qnode_pool;
+struct lthread_deque;
 struct lthread_sched;
 struct lthread_tls;
 
@@ -69,6 +70,8 @@ struct lthread_sched {
 	uint64_t nb_blocked_threads;	/* blocked threads */
 	struct lthread_queue *ready;			/* local ready queue */
 	struct lthread_queue *pready;			/* peer ready queue */
+	struct lthread_deque *deque;			/* stealable lthreads */
+	unsigned steal_next;				/* next lcore to rob */
 	struct lthread_objcache *lthread_cache;		/* free lthreads */
 	struct lthread_objcache *stack_cache;		/* free stacks */
 	struct lthread_objcache *per_lthread_cache;	/* free per lthread */
@@ -133,6 +136,8 @@ struct lthread {
 	lthread_exit_func exit_handler;		/* called when thread exits */
 	uint64_t birth;				/* time lthread was born */
 	struct lthread_queue *pending_wr_queue;	/* deferred  queue to write */
+	int stealable;				/* may move to idle scheds */
+	int pending_steal;			/* deferred deque push */
 	struct lthread *lt_join;		/* lthread to join on */
 	uint64_t join;				/* state for joining */
 	void **lt_exit_ptr;			/* exit ptr for lthread_join */
@@ -77,6 +77,7 @@ enum sched_alloc_phase {
 	SCHED_ALLOC_QNODE_POOL,
 	SCHED_ALLOC_READY_QUEUE,
 	SCHED_ALLOC_PREADY_QUEUE,
+	SCHED_ALLOC_DEQUE,
 	SCHED_ALLOC_LTHREAD_CACHE,
 	SCHED_ALLOC_STACK_CACHE,
 	SCHED_ALLOC_PERLT_CACHE,
@@ -110,6 +111,12 @@ _lthread_sched_alloc_resources(struct lthread_sched *new_sched)
 		if (new_sched->pready == NULL)
 			break;
 
+		/* Initialize per scheduler deque of stealable lthreads */
+		alloc_status = SCHED_ALLOC_DEQUE;
+		new_sched->deque = _lthread_deque_create();
+		if (new_sched->deque == NULL)
+			break;
+
 		/* Initialize per scheduler local free lthread cache */
 		alloc_status = SCHED_ALLOC_LTHREAD_CACHE;
 		new_sched->lthread_cache =
@@ -185,6 +192,9 @@ _lthread_sched_alloc_resources(struct lthread_sched *new_sched)
 		_lthread_objcache_destroy(new_sched->lthread_cache);
 		/* fall through */
 	case SCHED_ALLOC_LTHREAD_CACHE:
+		_lthread_deque_destroy(new_sched->deque);
+		/* fall through */
+	case SCHED_ALLOC_DEQUE:
 		_lthread_queue_destroy(new_sched->pready);
 		/* fall through */
 	case SCHED_ALLOC_PREADY_QUEUE:
@@ -244,6 +254,7 @@ struct lthread_sched *_lthread_sched_create(size_t stack_size)
 	bzero(&new_sched->ctx, sizeof(struct ctx));
 
 	new_sched->lcore_id = lcoreid;
+	new_sched->steal_next = lcoreid + 1;
 
 	schedcore[lcoreid] = new_sched;
 
@@ -371,6 +382,12 @@ static inline void _lthread_resume(struct lthread *lt)
 
 		/* queue the current thread to the specified queue */
 		_lthread_queue_insert_mp(dest, lt);
+	} else if (lt->pending_steal) {
+		lt->pending_steal = 0;
+
+		/* publish the thread to the idle schedulers */
+		if (_lthread_deque_push(sched->deque, lt) != 0)
+			_ready_queue_insert(sched, lt);
 	}
 
 	sched->current_lthread = NULL;
@@ -407,9 +424,36 @@ static inline int _lthread_sched_isdone(struct lthread_sched *sched)
 	return (sched->run_flag == 0) &&
 			(_lthread_queue_empty(sched->ready)) &&
 			(_lthread_queue_empty(sched->pready)) &&
+			(_lthread_deque_empty(sched->deque)) &&
 			(sched->nb_blocked_threads == 0);
 }
 
+/*
+ * Steal a stealable lthread from another scheduler, trying one per call
+ * so that the idle loop keeps checking its own queues
+ */
+static inline struct lthread *_lthread_steal(struct lthread_sched *sched)
+{
+	struct lthread_sched *victim;
+	struct lthread *lt;
+	unsigned i;
+
+	for (i = 0; i < LTHREAD_MAX_LCORES; i++) {
+		victim = schedcore[sched->steal_next++ % LTHREAD_MAX_LCORES];
+		if (victim == NULL || victim == sched)
+			continue;
+
+		lt = _lthread_deque_steal(victim->deque);
+		if (lt != NULL) {
+			DIAG_EVENT(lt, LT_DIAG_LTHREAD_AFFINITY,
+				   sched->lcore_id, 0);
+			lt->sched = sched;
+		}
+		return lt;
+	}
+	return NULL;
+}
+
 /*
  * Wait for all schedulers to start
  */
@@ -472,20 +516,37 @@ void lthread_run(void)
 	 * We check for:-
 	 *   expired timers,
 	 *   the local ready queue,
-	 *   and the peer ready queue,
+	 *   the peer ready queue,
+	 *   the deque of stealable lthreads,
+	 *   and when idle the deques of the other schedulers,
 	 *
 	 * and resume lthreads ad infinitum.
 	 */
 	while (!_lthread_sched_isdone(sched)) {
+		int idle = 1;
 
 		rte_timer_manage();
 
 		lt = _lthread_queue_poll(sched->ready);
-		if (lt != NULL)
+		if (lt != NULL) {
 			_lthread_resume(lt);
+			idle = 0;
+		}
 		lt = _lthread_queue_poll(sched->pready);
-		if (lt != NULL)
+		if (lt != NULL) {
 			_lthread_resume(lt);
+			idle = 0;
+		}
+		lt = _lthread_deque_pop(sched->deque);
+		if (lt != NULL) {
+			_lthread_resume(lt);
+			idle = 0;
+		}
+		if (idle) {
+			lt = _lthread_steal(sched);
+			if (lt != NULL)
+				_lthread_resume(lt);
+		}
 	}
 
 
@@ -534,6 +595,9 @@ int lthread_set_affinity(unsigned lcoreid)
 	if (unlikely(dest_sched == NULL))
 		return POSIX_ERRNO(EINVAL);
 
+	/* an explicit affinity pins the thread */
+	lt->stealable = 0;
+
 	if (likely(dest_sched != THIS_SCHED)) {
 		lt->sched = dest_sched;
 		lt->pending_wr_queue = dest_sched->pready;
@@ -13,6 +13,7 @@ extern "C" {
 
 #include "lthread_int.h"
 #include "lthread_queue.h"
+#include "lthread_deque.h"
 #include "lthread_objcache.h"
 #include "lthread_diag.h"
 #include "ctx.h"
@@ -29,6 +30,20 @@ _ready_queue_insert(struct lthread_sched *sched, struct lthread *lt)
 		_lthread_queue_insert_mp(sched->pready, lt);
 }
 
+/*
+ * requeue the current lthread on its scheduler
+ * a stealable lthread is pushed to the deque only once its context is
+ * saved, by _lthread_resume(), as another scheduler may resume it
+ */
+static inline void
+_ready_queue_requeue(struct lthread *lt)
+{
+	if (lt->stealable)
+		lt->pending_steal = 1;
+	else
+		_ready_queue_insert(THIS_SCHED, lt);
+}
+
 /*
  * remove an lthread from a queue
  */
@@ -89,7 +104,7 @@ _reschedule(void)
 	struct lthread *lt = THIS_LTHREAD;
 
 	DIAG_EVENT(lt, LT_DIAG_LTHREAD_RESCHEDULED, 0, 0);
-	_ready_queue_insert(THIS_SCHED, lt);
+	_ready_queue_requeue(lt);
 	ctx_switch(&(THIS_SCHED)->ctx, &lt->ctx);
 }
 
@@ -90,6 +90,7 @@
 #define CMD_LINE_OPT_FILTER_TYPE "filter-type"
 #define CMD_LINE_OPT_ENCAP "encap"
 #define CMD_LINE_OPT_DECAP "decap"
+#define CMD_LINE_OPT_RX_GRO "rx-gro"
 #define CMD_LINE_OPT_RX_RETRY "rx-retry"
 #define CMD_LINE_OPT_RX_RETRY_DELAY "rx-retry-delay"
 #define CMD_LINE_OPT_RX_RETRY_NUM "rx-retry-num"
@@ -129,6 +130,9 @@ uint8_t rx_decap = 1;
 /* enable/disable encapsulation */
 uint8_t tx_encap = 1;
 
+/* enable/disable GRO of the decapsulated packets */
+uint8_t rx_gro = 0;
+
 /* RX filter type for tunneling packet */
 uint8_t filter_idx = 1;
 
@@ -252,6 +256,7 @@ tep_termination_usage(const char *prgname)
 	"               --tso-segsz [0-N]: TCP segment size\n"
 	"               --decap [0|1]: tunneling packet decapsulation\n"
 	"               --encap [0|1]: tunneling packet encapsulation\n"
+	"               --rx-gro [0|1]: GRO of decapsulated TCP packets\n"
 	"               --filter-type[1-3]: filter type for tunneling packet\n"
 	"                   1: Inner MAC and tenent ID\n"
 	"                   2: Inner MAC and VLAN, and tenent ID\n"
@@ -285,6 +290,7 @@ tep_termination_parse_args(int argc, char **argv)
 		{CMD_LINE_OPT_TSO_SEGSZ, required_argument, NULL, 0},
 		{CMD_LINE_OPT_DECAP, required_argument, NULL, 0},
 		{CMD_LINE_OPT_ENCAP, required_argument, NULL, 0},
+		{CMD_LINE_OPT_RX_GRO, required_argument, NULL, 0},
 		{CMD_LINE_OPT_FILTER_TYPE, required_argument, NULL, 0},
 		{CMD_LINE_OPT_RX_RETRY, required_argument, NULL, 0},
 		{CMD_LINE_OPT_RX_RETRY_DELAY, required_argument, NULL, 0},
@@ -445,6 +451,20 @@ tep_termination_parse_args(int argc, char **argv)
 					tx_encap = ret;
 			}
 
+			/* Enable/disable GRO on RX. */
+			if (!strncmp(long_option[option_index].name,
+				CMD_LINE_OPT_RX_GRO,
+				sizeof(CMD_LINE_OPT_RX_GRO))) {
+				ret = parse_num_opt(optarg, 1);
+				if (ret == -1) {
+					RTE_LOG(INFO, VHOST_CONFIG,
+						"Invalid argument for rx-gro [0|1]\n");
+					tep_termination_usage(prgname);
+					return -1;
+				} else
+					rx_gro = ret;
+			}
+
 			/* Enable/disable stats. */
 			if (!strncmp(long_option[option_index].name,
 				CMD_LINE_OPT_STATS,
@@ -686,6 +706,7 @@ switch_worker(__rte_unused void *arg)
 						}
 					}
 
+					/* the packets are consumed by the handler */
 					ret_count = overlay_options.rx_handle(vdev->vid, pkts_burst, rx_count);
 					if (enable_stats) {
 						rte_atomic64_add(
@@ -694,11 +715,6 @@ switch_worker(__rte_unused void *arg)
 						rte_atomic64_add(
 						&dev_statistics[vdev->vid].rx_atomic, ret_count);
 					}
-					while (likely(rx_count)) {
-						rx_count--;
-						rte_pktmbuf_free(pkts_burst[rx_count]);
-					}
-
 				}
 			}
 
@@ -173,32 +173,29 @@ encapsulation(struct rte_mbuf *m, uint8_t queue_id)
 	uint32_t old_len = m->pkt_len, hash;
 	union tunnel_offload_info tx_offload = { .data = 0 };
 	struct ether_hdr *phdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
+	struct vxlan_encap_hdr *hdr;
 
 	/*Allocate space for new ethernet, IPv4, UDP and VXLAN headers*/
-	struct ether_hdr *pneth = (struct ether_hdr *) rte_pktmbuf_prepend(m,
-		sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr)
-		+ sizeof(struct udp_hdr) + sizeof(struct vxlan_hdr));
-
-	struct ipv4_hdr *ip = (struct ipv4_hdr *) &pneth[1];
-	struct udp_hdr *udp = (struct udp_hdr *) &ip[1];
-	struct vxlan_hdr *vxlan = (struct vxlan_hdr *) &udp[1];
+	hdr = (struct vxlan_encap_hdr *)rte_pktmbuf_prepend(m, sizeof(*hdr));
 
 	/* convert TX queue ID to vport ID */
 	vport_id = queue_id - 1;
 
-	/* replace original Ethernet header with ours */
-	pneth = rte_memcpy(pneth, &app_l2_hdr[vport_id],
-		sizeof(struct ether_hdr));
-
-	/* copy in IP header */
-	ip = rte_memcpy(ip, &app_ip_hdr[vport_id],
-		sizeof(struct ipv4_hdr));
-	ip->total_length = rte_cpu_to_be_16(m->pkt_len
+	/*
+	 * Copy in the prebuilt outer headers at once, only the lengths and
+	 * the UDP source port differ from a packet to another.
+	 */
+	rte_memcpy(hdr, &app_encap_hdr[vport_id], sizeof(*hdr));
+	hdr->ip.total_length = rte_cpu_to_be_16(m->pkt_len
 				- sizeof(struct ether_hdr));
+	hdr->udp.dgram_len = rte_cpu_to_be_16(old_len + ETHER_VXLAN_HLEN);
+
+	hash = rte_hash_crc(phdr, 2 * ETHER_ADDR_LEN, phdr->ether_type);
+	hdr->udp.src_port = rte_cpu_to_be_16((((uint64_t) hash * PORT_RANGE)
+				>> 32) + PORT_MIN);
 
 	/* outer IP checksum */
-	ol_flags |= PKT_TX_OUTER_IP_CKSUM;
-	ip->hdr_checksum = 0;
+	ol_flags |= PKT_TX_OUTER_IPV4 | PKT_TX_OUTER_IP_CKSUM;
 
 	/* inner IP checksum offload */
 	if (tx_checksum) {
@@ -216,21 +213,4 @@ encapsulation(struct rte_mbuf *m, uint8_t queue_id)
 
 	m->ol_flags |= ol_flags;
 	m->tso_segsz = tx_offload.tso_segsz;
-
-	/*VXLAN HEADER*/
-	vxlan->vx_flags = rte_cpu_to_be_32(VXLAN_HF_VNI);
-	vxlan->vx_vni = rte_cpu_to_be_32(vxdev.out_key << 8);
-
-	/*UDP HEADER*/
-	udp->dgram_cksum = 0;
-	udp->dgram_len = rte_cpu_to_be_16(old_len
-				+ sizeof(struct udp_hdr)
-				+ sizeof(struct vxlan_hdr));
-
-	udp->dst_port = rte_cpu_to_be_16(vxdev.dst_port);
-	hash = rte_hash_crc(phdr, 2 * ETHER_ADDR_LEN, phdr->ether_type);
-	udp->src_port = rte_cpu_to_be_16((((uint64_t) hash * PORT_RANGE) >> 32)
-					+ PORT_MIN);
-
-	return;
 }
@@ -7,6 +7,7 @@
 
 #include <rte_ether.h>
 #include <rte_ip.h>
+#include <rte_udp.h>
 
 #define PORT_MIN	49152
 #define PORT_MAX	65535
@@ -16,8 +17,15 @@
 #define VXLAN_HF_VNI 0x08000000
 #define DEFAULT_VXLAN_PORT 4789
 
-extern struct ipv4_hdr app_ip_hdr[VXLAN_N_PORTS];
-extern struct ether_hdr app_l2_hdr[VXLAN_N_PORTS];
+/* Outer headers of a VXLAN packet, in wire order */
+struct vxlan_encap_hdr {
+	struct ether_hdr eth;
+	struct ipv4_hdr ip;
+	struct udp_hdr udp;
+	struct vxlan_hdr vxlan;
+} __rte_packed;
+
+extern struct vxlan_encap_hdr app_encap_hdr[VXLAN_N_PORTS];
 extern uint8_t tx_checksum;
 extern uint16_t tso_segsz;
 
@@ -26,6 +34,7 @@ struct vxlan_port {
 	uint32_t peer_ip;            /**< remote VTEP IP address */
 	struct ether_addr peer_mac;  /**< remote VTEP MAC address */
 	struct ether_addr vport_mac; /**< VirtIO port MAC address */
+	uint8_t rx_gro;              /**< merge TCP packets to the guest */
 } __rte_cache_aligned;
 
 struct vxlan_conf {
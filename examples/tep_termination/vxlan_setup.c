@@ -11,6 +11,8 @@
 #include <unistd.h>
 
 #include <rte_ethdev.h>
+#include <rte_gro.h>
+#include <rte_gso.h>
 #include <rte_log.h>
 #include <rte_string_fns.h>
 #include <rte_mbuf.h>
@@ -18,6 +20,8 @@
 #include <rte_ip.h>
 #include <rte_udp.h>
 #include <rte_tcp.h>
+#include <rte_net.h>
+#include <rte_prefetch.h>
 
 #include "main.h"
 #include "rte_vhost.h"
@@ -45,11 +49,29 @@
 /* Default inner VLAN ID */
 #define INNER_VLAN_ID 100
 
+/* Number of packets ahead of the one processed to prefetch */
+#define PREFETCH_OFFSET 3
+
+/* Max number of segments of a TSO packet segmented in software */
+#define GSO_MAX_SEGS 64
+#define GSO_INDIRECT_MBUFS 8192
+#define GSO_MBUF_CACHE_SIZE 128
+
 /* VXLAN device */
 struct vxlan_conf vxdev;
 
-struct ipv4_hdr app_ip_hdr[VXLAN_N_PORTS];
-struct ether_hdr app_l2_hdr[VXLAN_N_PORTS];
+struct vxlan_encap_hdr app_encap_hdr[VXLAN_N_PORTS];
+
+/* Software GSO, when the port can't segment VXLAN packets itself */
+static uint8_t tx_gso;
+static struct rte_gso_ctx gso_ctx;
+
+/* GRO of the decapsulated packets */
+static struct rte_gro_param gro_param = {
+	.gro_types = RTE_GRO_TCP_IPV4,
+	.max_flow_num = MAX_PKT_BURST,
+	.max_item_per_flow = MAX_PKT_BURST,
+};
 
 /* local VTEP IP address */
 uint8_t vxlan_multicast_ips[2][4] = { {239, 1, 1, 1 }, {239, 1, 2, 1 } };
@@ -98,6 +120,26 @@ const uint16_t tenant_id_conf[] = {
 	1028, 1028, 1029, 1029, 1030, 1030, 1031, 1031,
 };
 
+static int
+vxlan_gso_init(struct rte_mempool *mbuf_pool)
+{
+	if (gso_ctx.indirect_pool != NULL)
+		return 0;
+
+	gso_ctx.indirect_pool = rte_pktmbuf_pool_create("GSO_INDIRECT_POOL",
+			GSO_INDIRECT_MBUFS * rte_lcore_count(),
+			GSO_MBUF_CACHE_SIZE, 0, 0, rte_socket_id());
+	if (gso_ctx.indirect_pool == NULL)
+		return -1;
+
+	gso_ctx.direct_pool = mbuf_pool;
+	gso_ctx.gso_types = DEV_TX_OFFLOAD_VXLAN_TNL_TSO;
+	gso_ctx.flag = 0;
+	tx_gso = 1;
+
+	return 0;
+}
+
 /**
  * Initialises a given port using global settings and with the rx buffers
  * coming from the mbuf_pool passed as parameter
@@ -137,6 +179,15 @@ vxlan_port_init(uint16_t port, struct rte_mempool *mbuf_pool)
 	if (dev_info.tx_offload_capa & DEV_TX_OFFLOAD_MBUF_FAST_FREE)
 		local_port_conf.txmode.offloads |=
 			DEV_TX_OFFLOAD_MBUF_FAST_FREE;
+	if (tso_segsz != 0 &&
+	    !(dev_info.tx_offload_capa & DEV_TX_OFFLOAD_VXLAN_TNL_TSO)) {
+		RTE_LOG(INFO, PORT,
+			"no hardware VXLAN TSO offload, segmenting in software\n");
+		local_port_conf.txmode.offloads &= ~(DEV_TX_OFFLOAD_TCP_TSO |
+				DEV_TX_OFFLOAD_VXLAN_TNL_TSO);
+		if (vxlan_gso_init(mbuf_pool) != 0)
+			return -1;
+	}
 	/* Configure ethernet device. */
 	retval = rte_eth_dev_configure(port, rx_rings, tx_rings,
 				       &local_port_conf);
@@ -189,36 +240,9 @@ vxlan_port_init(uint16_t port, struct rte_mempool *mbuf_pool)
 			ports_eth_addr[port].addr_bytes[4],
 			ports_eth_addr[port].addr_bytes[5]);
 
-	if (tso_segsz != 0) {
-		struct rte_eth_dev_info dev_info;
-		rte_eth_dev_info_get(port, &dev_info);
-		if ((dev_info.tx_offload_capa & DEV_TX_OFFLOAD_TCP_TSO) == 0)
-			RTE_LOG(WARNING, PORT,
-				"hardware TSO offload is not supported\n");
-	}
 	return 0;
 }
 
-static int
-vxlan_rx_process(struct rte_mbuf *pkt)
-{
-	int ret = 0;
-
-	if (rx_decap)
-		ret = decapsulation(pkt);
-
-	return ret;
-}
-
-static void
-vxlan_tx_process(uint8_t queue_id, struct rte_mbuf *pkt)
-{
-	if (tx_encap)
-		encapsulation(pkt, queue_id);
-
-	return;
-}
-
 /*
  * This function learns the MAC address of the device and set init
  * L2 header and L3 header info.
@@ -229,6 +253,8 @@ vxlan_link(struct vhost_dev *vdev, struct rte_mbuf *m)
 	int i, ret;
 	struct ether_hdr *pkt_hdr;
 	uint64_t portid = vdev->vid;
+	uint64_t features;
+	struct vxlan_encap_hdr *hdr;
 	struct ipv4_hdr *ip;
 
 	struct rte_eth_tunnel_filter_conf tunnel_filter_conf;
@@ -308,14 +334,20 @@ vxlan_link(struct vhost_dev *vdev, struct rte_mbuf *m)
 			vxlan_overlay_ips[portid][i] << (8 * i);
 	}
 
+	/* the guest takes merged packets only as TSO ones */
+	vxdev.port[portid].rx_gro = rx_gro &&
+		rte_vhost_get_negotiated_features(vdev->vid, &features) == 0 &&
+		(features & (1ULL << VIRTIO_NET_F_GUEST_TSO4)) != 0;
+
 	vxdev.out_key = tenant_id_conf[vdev->rx_q];
-	ether_addr_copy(&vxdev.port[portid].peer_mac,
-			&app_l2_hdr[portid].d_addr);
-	ether_addr_copy(&ports_eth_addr[0],
-			&app_l2_hdr[portid].s_addr);
-	app_l2_hdr[portid].ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
 
-	ip = &app_ip_hdr[portid];
+	/* Build the outer headers encapsulation prepends */
+	hdr = &app_encap_hdr[portid];
+	ether_addr_copy(&vxdev.port[portid].peer_mac, &hdr->eth.d_addr);
+	ether_addr_copy(&ports_eth_addr[0], &hdr->eth.s_addr);
+	hdr->eth.ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+
+	ip = &hdr->ip;
 	ip->version_ihl = IP_VHL_DEF;
 	ip->type_of_service = 0;
 	ip->total_length = 0;
@@ -327,6 +359,11 @@ vxlan_link(struct vhost_dev *vdev, struct rte_mbuf *m)
 	ip->src_addr = vxdev.port_ip;
 	ip->dst_addr = vxdev.port[portid].peer_ip;
 
+	hdr->udp.dst_port = rte_cpu_to_be_16(vxdev.dst_port);
+	hdr->udp.dgram_cksum = 0;
+	hdr->vxlan.vx_flags = rte_cpu_to_be_32(VXLAN_HF_VNI);
+	hdr->vxlan.vx_vni = rte_cpu_to_be_32(vxdev.out_key << 8);
+
 	/* Set device as ready for RX. */
 	vdev->ready = DEVICE_RX;
 
@@ -391,22 +428,155 @@ vxlan_unlink(struct vhost_dev *vdev)
 	}
 }
 
-/* Transmit packets after encapsulating */
+/*
+ * Segments an encapsulated TSO packet for a port without VXLAN TSO.
+ * Returns the number of segments in @segs, the packet is consumed.
+ */
+static uint16_t
+vxlan_gso(struct rte_mbuf *m, struct rte_mbuf **segs)
+{
+	struct rte_gso_ctx ctx = gso_ctx;
+	struct ipv4_hdr *ipv4_hdr;
+	struct tcp_hdr *tcp_hdr;
+	uint32_t l4_off;
+	int i, nb_segs;
+
+	if (!(m->ol_flags & PKT_TX_TCP_SEG)) {
+		segs[0] = m;
+		return 1;
+	}
+
+	l4_off = m->outer_l2_len + m->outer_l3_len + m->l2_len + m->l3_len;
+	ctx.gso_size = l4_off + m->l4_len + m->tso_segsz;
+	nb_segs = rte_gso_segment(m, &ctx, segs, GSO_MAX_SEGS);
+	if (unlikely(nb_segs < 0)) {
+		rte_pktmbuf_free(m);
+		return 0;
+	}
+
+	/* not an inner TCP/IPv4 packet, the port can't send it */
+	if (unlikely(segs[0]->ol_flags & PKT_TX_TCP_SEG)) {
+		rte_pktmbuf_free(segs[0]);
+		return 0;
+	}
+
+	/*
+	 * GSO doesn't update the checksums, and the inner TCP pseudo-header
+	 * checksum of a segment covers its length, unlike a TSO one.
+	 */
+	for (i = 0; i < nb_segs; i++) {
+		m = segs[i];
+		ipv4_hdr = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+						   l4_off - m->l3_len);
+		tcp_hdr = rte_pktmbuf_mtod_offset(m, struct tcp_hdr *, l4_off);
+		tcp_hdr->cksum = rte_ipv4_phdr_cksum(ipv4_hdr, m->ol_flags);
+	}
+
+	return nb_segs;
+}
+
+static void
+vxlan_tx_flush(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	uint16_t ret;
+
+	ret = rte_eth_tx_burst(port_id, queue_id, pkts, nb_pkts);
+	while (unlikely(ret < nb_pkts))
+		rte_pktmbuf_free(pkts[ret++]);
+}
+
+/*
+ * Transmit packets after encapsulating. The packets are parsed a few
+ * ahead of the one encapsulated, so that their headers are in cache.
+ * With software GSO, all the packets are consumed.
+ */
 int
 vxlan_tx_pkts(uint16_t port_id, uint16_t queue_id,
 		struct rte_mbuf **tx_pkts, uint16_t nb_pkts) {
-	int ret = 0;
+	struct rte_mbuf *segs[MAX_PKT_BURST + GSO_MAX_SEGS];
+	uint16_t i, nb_segs = 0;
+
+	if (tx_encap) {
+		for (i = 0; i < PREFETCH_OFFSET && i < nb_pkts; i++)
+			rte_prefetch0(rte_pktmbuf_mtod(tx_pkts[i], void *));
+
+		for (i = 0; i < nb_pkts; i++) {
+			if (i + PREFETCH_OFFSET < nb_pkts)
+				rte_prefetch0(rte_pktmbuf_mtod(
+					tx_pkts[i + PREFETCH_OFFSET], void *));
+			encapsulation(tx_pkts[i], queue_id);
+		}
+	}
+
+	if (!tx_gso)
+		return rte_eth_tx_burst(port_id, queue_id, tx_pkts, nb_pkts);
+
+	for (i = 0; i < nb_pkts; i++) {
+		if (nb_segs > MAX_PKT_BURST) {
+			vxlan_tx_flush(port_id, queue_id, segs, nb_segs);
+			nb_segs = 0;
+		}
+		nb_segs += vxlan_gso(tx_pkts[i], &segs[nb_segs]);
+	}
+	vxlan_tx_flush(port_id, queue_id, segs, nb_segs);
+
+	return nb_pkts;
+}
+
+/*
+ * Merges the TCP/IPv4 packets of a decapsulated burst. The guest gets the
+ * merged packets with a partial checksum, and as TSO packets when they
+ * exceed the MTU.
+ */
+static uint16_t
+vxlan_rx_gro(struct rte_mbuf **pkts, uint16_t count)
+{
+	struct rte_net_hdr_lens hdr_lens;
+	struct ipv4_hdr *ipv4_hdr;
+	struct tcp_hdr *tcp_hdr;
+	struct rte_mbuf *m;
 	uint16_t i;
 
-	for (i = 0; i < nb_pkts; i++)
-		vxlan_tx_process(queue_id, tx_pkts[i]);
+	for (i = 0; i < count; i++) {
+		m = pkts[i];
+		m->packet_type = rte_net_get_ptype(m, &hdr_lens,
+						   RTE_PTYPE_ALL_MASK);
+		m->l2_len = hdr_lens.l2_len;
+		m->l3_len = hdr_lens.l3_len;
+		m->l4_len = hdr_lens.l4_len;
+	}
+
+	count = rte_gro_reassemble_burst(pkts, count, &gro_param);
 
-	ret = rte_eth_tx_burst(port_id, queue_id, tx_pkts, nb_pkts);
+	for (i = 0; i < count; i++) {
+		m = pkts[i];
+		/* GRO chains the packets it merges. */
+		if (m->nb_segs == 1 || !RTE_ETH_IS_IPV4_HDR(m->packet_type) ||
+		    (m->packet_type & RTE_PTYPE_L4_MASK) != RTE_PTYPE_L4_TCP)
+			continue;
 
-	return ret;
+		ipv4_hdr = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+						   m->l2_len);
+		tcp_hdr = rte_pktmbuf_mtod_offset(m, struct tcp_hdr *,
+						  m->l2_len + m->l3_len);
+		/* The IP checksum is computed on enqueue. */
+		ipv4_hdr->hdr_checksum = 0;
+		tcp_hdr->cksum = rte_ipv4_phdr_cksum(ipv4_hdr, 0);
+		m->ol_flags |= PKT_TX_IPV4 | PKT_TX_IP_CKSUM | PKT_TX_TCP_CKSUM;
+		if (m->pkt_len - m->l2_len > ETHER_MTU) {
+			m->ol_flags |= PKT_TX_TCP_SEG;
+			m->tso_segsz = ETHER_MTU - m->l3_len - m->l4_len;
+		}
+	}
+
+	return count;
 }
 
-/* Check for decapsulation and pass packets directly to VIRTIO device */
+/*
+ * Check for decapsulation and pass packets directly to VIRTIO device.
+ * All the packets are consumed.
+ */
 int
 vxlan_rx_pkts(int vid, struct rte_mbuf **pkts_burst, uint32_t rx_count)
 {
@@ -415,25 +585,39 @@ vxlan_rx_pkts(int vid, struct rte_mbuf **pkts_burst, uint32_t rx_count)
 	int ret;
 	struct rte_mbuf *pkts_valid[rx_count];
 
+	for (i = 0; i < PREFETCH_OFFSET && i < rx_count; i++)
+		rte_prefetch0(rte_pktmbuf_mtod(pkts_burst[i], void *));
+
 	for (i = 0; i < rx_count; i++) {
+		if (i + PREFETCH_OFFSET < rx_count)
+			rte_prefetch0(rte_pktmbuf_mtod(
+				pkts_burst[i + PREFETCH_OFFSET], void *));
+
 		if (enable_stats) {
 			rte_atomic64_add(
 				&dev_statistics[vid].rx_bad_ip_csum,
 				(pkts_burst[i]->ol_flags & PKT_RX_IP_CKSUM_BAD)
 				!= 0);
 			rte_atomic64_add(
-				&dev_statistics[vid].rx_bad_ip_csum,
+				&dev_statistics[vid].rx_bad_l4_csum,
 				(pkts_burst[i]->ol_flags & PKT_RX_L4_CKSUM_BAD)
 				!= 0);
 		}
-		ret = vxlan_rx_process(pkts_burst[i]);
-		if (unlikely(ret < 0))
+		if (rx_decap && unlikely(decapsulation(pkts_burst[i]) < 0)) {
+			rte_pktmbuf_free(pkts_burst[i]);
 			continue;
+		}
 
 		pkts_valid[count] = pkts_burst[i];
-			count++;
+		count++;
 	}
 
+	if (vxdev.port[vid].rx_gro)
+		count = vxlan_rx_gro(pkts_valid, count);
+
 	ret = rte_vhost_enqueue_burst(vid, VIRTIO_RXQ, pkts_valid, count);
+	for (i = 0; i < count; i++)
+		rte_pktmbuf_free(pkts_valid[i]);
+
 	return ret;
 }
@@ -14,6 +14,7 @@ extern uint32_t enable_stats;
 extern struct device_statistics dev_statistics[MAX_DEVICES];
 extern uint8_t rx_decap;
 extern uint8_t tx_encap;
+extern uint8_t rx_gro;
 
 typedef int (*ol_port_configure_t)(uint16_t port,
 				   struct rte_mempool *mbuf_pool);
@@ -5,9 +5,12 @@
 #include <getopt.h>
 #include <signal.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <rte_atomic.h>
+#include <rte_cycles.h>
 #include <rte_ethdev.h>
 #include <rte_malloc.h>
 #include <rte_vhost.h>
@@ -39,6 +42,34 @@ static int devcnt;
 static int interactive;
 static int client_mode;
 
+/* benchmark mode */
+enum {
+	BENCH_DRIVER_START,
+	BENCH_NEW_DEVICE,
+	BENCH_DEV_CONF,
+	BENCH_MEM_TABLE,
+	BENCH_BRING_UP,
+	BENCH_MAX,
+};
+
+static const char * const bench_names[BENCH_MAX] = {
+	[BENCH_DRIVER_START] = "rte_vhost_driver_start()",
+	[BENCH_NEW_DEVICE] = "start to new_device()",
+	[BENCH_DEV_CONF] = "dev_conf()",
+	[BENCH_MEM_TABLE] = "set_mem_table()",
+	[BENCH_BRING_UP] = "start to dev_conf() done",
+};
+
+static int bench_cycles;
+static int bench_timeout = 60;
+static uint32_t bench_max_samples;
+static uint64_t *bench_samples[BENCH_MAX];
+static uint32_t bench_nb_samples[BENCH_MAX];
+static uint64_t bench_start_tsc[MAX_VDPA_SAMPLE_PORTS];
+static struct rte_vdpa_dev_ops *bench_orig_ops[MAX_VDPA_SAMPLE_PORTS];
+static struct rte_vdpa_dev_ops bench_ops[MAX_VDPA_SAMPLE_PORTS];
+static rte_atomic32_t bench_ready;
+
 /* display usage */
 static void
 vdpa_usage(const char *prgname)
@@ -46,7 +77,9 @@ vdpa_usage(const char *prgname)
 	printf("Usage: %s [EAL options] -- "
 				 "	--interactive|-i: run in interactive mode.\n"
 				 "	--iface <path>: specify the path prefix of the socket files, e.g. /tmp/vhost-user-.\n"
-				 "	--client: register a vhost-user socket as client mode.\n",
+				 "	--client: register a vhost-user socket as client mode.\n"
+				 "	--bench <cycles>: time the bring-up of all the ports over <cycles> attach/detach cycles.\n"
+				 "	--bench-timeout <seconds>: max wait for the ports of a cycle to get configured, default 60.\n",
 				 prgname);
 }
 
@@ -58,6 +91,8 @@ parse_args(int argc, char **argv)
 		{"iface", required_argument, NULL, 0},
 		{"interactive", no_argument, &interactive, 1},
 		{"client", no_argument, &client_mode, 1},
+		{"bench", required_argument, NULL, 0},
+		{"bench-timeout", required_argument, NULL, 0},
 		{NULL, 0, 0, 0},
 	};
 	int opt, idx;
@@ -81,6 +116,20 @@ parse_args(int argc, char **argv)
 				printf("Interactive-mode selected\n");
 				interactive = 1;
 			}
+			if (!strcmp(long_option[idx].name, "bench")) {
+				bench_cycles = atoi(optarg);
+				if (bench_cycles <= 0) {
+					vdpa_usage(prgname);
+					return -1;
+				}
+			}
+			if (!strcmp(long_option[idx].name, "bench-timeout")) {
+				bench_timeout = atoi(optarg);
+				if (bench_timeout <= 0) {
+					vdpa_usage(prgname);
+					return -1;
+				}
+			}
 			break;
 
 		default:
@@ -94,9 +143,62 @@ parse_args(int argc, char **argv)
 		return -1;
 	}
 
+	if (bench_cycles && interactive) {
+		printf("benchmark mode is not interactive\n");
+		vdpa_usage(prgname);
+		return -1;
+	}
+
 	return 0;
 }
 
+static uint64_t
+bench_tsc_to_us(uint64_t tsc)
+{
+	return tsc * 1000000 / rte_get_timer_hz();
+}
+
+/* samples of a kind are only recorded by one thread */
+static void
+bench_record(int type, uint64_t tsc)
+{
+	if (bench_nb_samples[type] < bench_max_samples)
+		bench_samples[type][bench_nb_samples[type]++] =
+			bench_tsc_to_us(tsc);
+}
+
+static int
+bench_dev_conf(int vid)
+{
+	int did = rte_vhost_get_vdpa_device_id(vid);
+	uint64_t start, end;
+	int ret;
+
+	start = rte_get_timer_cycles();
+	ret = bench_orig_ops[did]->dev_conf(vid);
+	end = rte_get_timer_cycles();
+
+	bench_record(BENCH_DEV_CONF, end - start);
+	bench_record(BENCH_BRING_UP, end - bench_start_tsc[did]);
+	rte_atomic32_inc(&bench_ready);
+
+	return ret;
+}
+
+static int
+bench_set_mem_table(int vid)
+{
+	int did = rte_vhost_get_vdpa_device_id(vid);
+	uint64_t start;
+	int ret;
+
+	start = rte_get_timer_cycles();
+	ret = bench_orig_ops[did]->set_mem_table(vid);
+	bench_record(BENCH_MEM_TABLE, rte_get_timer_cycles() - start);
+
+	return ret;
+}
+
 static int
 new_device(int vid)
 {
@@ -109,6 +211,10 @@ new_device(int vid)
 			printf("\nnew port %s, did: %d\n",
 					ifname, vports[i].did);
 			vports[i].vid = vid;
+			if (bench_cycles)
+				bench_record(BENCH_NEW_DEVICE,
+					rte_get_timer_cycles() -
+					bench_start_tsc[vports[i].did]);
 			break;
 		}
 	}
@@ -146,6 +252,7 @@ start_vdpa(struct vdpa_port *vport)
 	int ret;
 	char *socket_path = vport->ifname;
 	int did = vport->did;
+	uint64_t start;
 
 	if (client_mode)
 		vport->flags |= RTE_VHOST_USER_CLIENT;
@@ -175,10 +282,16 @@ start_vdpa(struct vdpa_port *vport)
 			"attach vdpa device failed: %s\n",
 			socket_path);
 
+	start = rte_get_timer_cycles();
+	if (bench_cycles)
+		bench_start_tsc[did] = start;
 	if (rte_vhost_driver_start(socket_path) < 0)
 		rte_exit(EXIT_FAILURE,
 			"start vhost driver failed: %s\n",
 			socket_path);
+	if (bench_cycles)
+		bench_record(BENCH_DRIVER_START,
+				rte_get_timer_cycles() - start);
 	return 0;
 }
 
@@ -221,6 +334,106 @@ signal_handler(int signum)
 	}
 }
 
+static int
+bench_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void
+bench_report(void)
+{
+	uint64_t *v;
+	uint32_t n;
+	int i;
+
+	printf("\n%-28s %8s %10s %10s %10s %10s\n", "latency (us)",
+			"samples", "p50", "p90", "p99", "max");
+	for (i = 0; i < BENCH_MAX; i++) {
+		v = bench_samples[i];
+		n = bench_nb_samples[i];
+		if (n == 0) {
+			printf("%-28s %8u %10s %10s %10s %10s\n",
+					bench_names[i], n, "-", "-", "-", "-");
+			continue;
+		}
+		qsort(v, n, sizeof(*v), bench_cmp);
+		printf("%-28s %8u %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+				" %10" PRIu64 "\n", bench_names[i], n,
+				v[(n - 1) * 50 / 100], v[(n - 1) * 90 / 100],
+				v[(n - 1) * 99 / 100], v[n - 1]);
+	}
+}
+
+/*
+ * Wrap the dev_conf and set_mem_table ops of the vDPA devices to time
+ * them, then attach and detach all the ports bench_cycles times. A front-end
+ * has to connect to every socket in each cycle, a VM started with a
+ * reconnecting chardev or, in client mode, a vhost-user server.
+ */
+static void
+vdpa_bench(void)
+{
+	int nports = RTE_MIN(MAX_VDPA_SAMPLE_PORTS, dev_total);
+	struct rte_vdpa_device *vdev;
+	uint64_t deadline;
+	int cycle, ready;
+	int i;
+
+	bench_max_samples = bench_cycles * nports;
+	for (i = 0; i < BENCH_MAX; i++) {
+		bench_samples[i] = calloc(bench_max_samples,
+				sizeof(*bench_samples[i]));
+		if (bench_samples[i] == NULL)
+			rte_exit(EXIT_FAILURE,
+				"cannot allocate benchmark samples\n");
+	}
+
+	for (i = 0; i < nports; i++) {
+		vdev = rte_vdpa_get_device(i);
+		if (vdev == NULL || vdev->ops->dev_conf == NULL)
+			rte_exit(EXIT_FAILURE,
+				"vdpa device %d has no dev_conf op\n", i);
+		bench_orig_ops[i] = vdev->ops;
+		bench_ops[i] = *vdev->ops;
+		bench_ops[i].dev_conf = bench_dev_conf;
+		if (bench_ops[i].set_mem_table)
+			bench_ops[i].set_mem_table = bench_set_mem_table;
+		vdev->ops = &bench_ops[i];
+	}
+
+	for (cycle = 0; cycle < bench_cycles; cycle++) {
+		rte_atomic32_set(&bench_ready, 0);
+		for (i = 0; i < nports; i++) {
+			vports[i].did = i;
+			snprintf(vports[i].ifname, MAX_PATH_LEN, "%s%d",
+					iface, i);
+			start_vdpa(&vports[i]);
+		}
+
+		deadline = rte_get_timer_cycles() +
+			(uint64_t)bench_timeout * rte_get_timer_hz();
+		while ((ready = rte_atomic32_read(&bench_ready)) < nports &&
+				rte_get_timer_cycles() < deadline)
+			usleep(1000);
+		printf("cycle %d: %d of %d ports configured\n", cycle,
+				ready, nports);
+
+		vdpa_sample_quit();
+	}
+
+	for (i = 0; i < nports; i++)
+		rte_vdpa_get_device(i)->ops = bench_orig_ops[i];
+
+	bench_report();
+
+	for (i = 0; i < BENCH_MAX; i++)
+		free(bench_samples[i]);
+}
+
 /* interactive cmds */
 
 /* *** Help command with introduction. *** */
@@ -427,6 +640,8 @@ main(int argc, char *argv[])
 			rte_panic("Cannot create cmdline instance\n");
 		cmdline_interact(cl);
 		cmdline_stdin_exit(cl);
+	} else if (bench_cycles) {
+		vdpa_bench();
 	} else {
 		for (i = 0; i < RTE_MIN(MAX_VDPA_SAMPLE_PORTS, dev_total);
 				i++) {
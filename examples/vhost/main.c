@@ -17,6 +17,10 @@
 #include <rte_atomic.h>
 #include <rte_cycles.h>
 #include <rte_ethdev.h>
+#include <rte_gro.h>
+#include <rte_gso.h>
+#include <rte_hash.h>
+#include <rte_jhash.h>
 #include <rte_log.h>
 #include <rte_string_fns.h>
 #include <rte_malloc.h>
@@ -24,6 +28,8 @@
 #include <rte_ip.h>
 #include <rte_tcp.h>
 #include <rte_pause.h>
+#include <rte_net.h>
+#include <rte_spinlock.h>
 
 #include "main.h"
 
@@ -58,6 +64,15 @@
 /* Max number of devices. Limited by vmdq. */
 #define MAX_DEVICES 64
 
+/* Max number of devices in software switching mode. */
+#define MAX_SW_DEVICES 1024
+
+/* Max number of segments a TSO packet is split into by GSO. */
+#define MAX_GSO_SEGS 64
+
+/* Number of indirect mbufs GSO may use per switch core. */
+#define NUM_INDIRECT_MBUFS 8192
+
 /* Maximum long option length for option parsing. */
 #define MAX_LONG_OPT_SZ 64
 
@@ -99,6 +114,31 @@ static int dequeue_zero_copy;
 
 static int builtin_net_driver;
 
+/*
+ * Switch packets in software on a MAC table, rather than steering them
+ * with VMDQ pools of the NIC.
+ */
+static int sw_switch;
+
+/*
+ * MAC table of the software switch: lookups are lock free, the rare
+ * writers (MAC learning and device removal) are serialized by the lock.
+ */
+static struct rte_hash *mac_table;
+static rte_spinlock_t mac_table_lock = RTE_SPINLOCK_INITIALIZER;
+
+/* Tx offloads the port supports, in software switching mode. */
+static uint64_t port_tx_offloads;
+
+/* GRO on NIC Rx and GSO towards destinations without TSO. */
+static struct rte_mempool *indirect_pool;
+static struct rte_gso_ctx gso_ctx;
+static struct rte_gro_param gro_param = {
+	.gro_types = RTE_GRO_TCP_IPV4,
+	.max_flow_num = MAX_PKT_BURST,
+	.max_item_per_flow = MAX_PKT_BURST,
+};
+
 /* Specify timeout (in useconds) between retries on RX. */
 static uint32_t burst_rx_delay_time = BURST_RX_WAIT_US;
 /* Specify the number of retries on RX. */
@@ -214,6 +254,33 @@ get_eth_conf(struct rte_eth_conf *eth_conf, uint32_t num_devices)
 	return 0;
 }
 
+/*
+ * Builds up the port configuration of the software switching mode: no
+ * VMDQ pools, and RSS spreads the traffic on one Rx queue per switch core.
+ */
+static inline void
+get_sw_eth_conf(struct rte_eth_conf *eth_conf,
+		const struct rte_eth_dev_info *dev_info, uint16_t nb_rx_queues)
+{
+	(void)(rte_memcpy(eth_conf, &vmdq_conf_default, sizeof(*eth_conf)));
+	memset(&eth_conf->rx_adv_conf, 0, sizeof(eth_conf->rx_adv_conf));
+
+	/* There are no pool VLAN tags to strip or insert. */
+	eth_conf->rxmode.offloads &= ~DEV_RX_OFFLOAD_VLAN_STRIP;
+	eth_conf->rxmode.offloads &= dev_info->rx_offload_capa;
+	eth_conf->txmode.offloads &= ~DEV_TX_OFFLOAD_VLAN_INSERT;
+	eth_conf->txmode.offloads &= dev_info->tx_offload_capa;
+
+	if (nb_rx_queues > 1) {
+		eth_conf->rxmode.mq_mode = ETH_MQ_RX_RSS;
+		eth_conf->rx_adv_conf.rss_conf.rss_hf =
+			(ETH_RSS_IP | ETH_RSS_TCP | ETH_RSS_UDP) &
+			dev_info->flow_type_rss_offloads;
+	} else {
+		eth_conf->rxmode.mq_mode = ETH_MQ_RX_NONE;
+	}
+}
+
 /*
  * Validate the device number according to the max pool number gotten form
  * dev_info. If the device number is invalid, give the error message and
@@ -252,9 +319,6 @@ port_init(uint16_t port)
 	txconf = &dev_info.default_txconf;
 	rxconf->rx_drop_en = 1;
 
-	/*configure the number of supported virtio devices based on VMDQ limits */
-	num_devices = dev_info.max_vmdq_pools;
-
 	rx_ring_size = RTE_TEST_RX_DESC_DEFAULT;
 	tx_ring_size = RTE_TEST_TX_DESC_DEFAULT;
 
@@ -270,28 +334,44 @@ port_init(uint16_t port)
 
 	tx_rings = (uint16_t)rte_lcore_count();
 
-	retval = validate_num_devices(MAX_DEVICES);
-	if (retval < 0)
-		return retval;
+	if (sw_switch) {
+		/* Devices are only limited by the size of the MAC table. */
+		num_devices = MAX_SW_DEVICES;
+		/* One Rx queue per switch core. */
+		rx_rings = RTE_MAX(rte_lcore_count() - 1, 1U);
+		get_sw_eth_conf(&port_conf, &dev_info, rx_rings);
+		port_tx_offloads = port_conf.txmode.offloads;
+	} else {
+		/*
+		 * configure the number of supported virtio devices based on
+		 * VMDQ limits
+		 */
+		num_devices = dev_info.max_vmdq_pools;
 
-	/* Get port configuration. */
-	retval = get_eth_conf(&port_conf, num_devices);
-	if (retval < 0)
-		return retval;
-	/* NIC queues are divided into pf queues and vmdq queues.  */
-	num_pf_queues = dev_info.max_rx_queues - dev_info.vmdq_queue_num;
-	queues_per_pool = dev_info.vmdq_queue_num / dev_info.max_vmdq_pools;
-	num_vmdq_queues = num_devices * queues_per_pool;
-	num_queues = num_pf_queues + num_vmdq_queues;
-	vmdq_queue_base = dev_info.vmdq_queue_base;
-	vmdq_pool_base  = dev_info.vmdq_pool_base;
-	printf("pf queue num: %u, configured vmdq pool num: %u, each vmdq pool has %u queues\n",
-		num_pf_queues, num_devices, queues_per_pool);
+		retval = validate_num_devices(MAX_DEVICES);
+		if (retval < 0)
+			return retval;
+
+		/* Get port configuration. */
+		retval = get_eth_conf(&port_conf, num_devices);
+		if (retval < 0)
+			return retval;
+		/* NIC queues are divided into pf queues and vmdq queues.  */
+		num_pf_queues = dev_info.max_rx_queues - dev_info.vmdq_queue_num;
+		queues_per_pool = dev_info.vmdq_queue_num / dev_info.max_vmdq_pools;
+		num_vmdq_queues = num_devices * queues_per_pool;
+		num_queues = num_pf_queues + num_vmdq_queues;
+		vmdq_queue_base = dev_info.vmdq_queue_base;
+		vmdq_pool_base  = dev_info.vmdq_pool_base;
+		printf("pf queue num: %u, configured vmdq pool num: %u, each vmdq pool has %u queues\n",
+			num_pf_queues, num_devices, queues_per_pool);
+
+		rx_rings = (uint16_t)dev_info.max_rx_queues;
+	}
 
 	if (!rte_eth_dev_is_valid_port(port))
 		return -1;
 
-	rx_rings = (uint16_t)dev_info.max_rx_queues;
 	if (dev_info.tx_offload_capa & DEV_TX_OFFLOAD_MBUF_FAST_FREE)
 		port_conf.txmode.offloads |=
 			DEV_TX_OFFLOAD_MBUF_FAST_FREE;
@@ -454,7 +534,8 @@ us_vhost_usage(const char *prgname)
 	"		--tx-csum [0|1] disable/enable TX checksum offload.\n"
 	"		--tso [0|1] disable/enable TCP segment offload.\n"
 	"		--client register a vhost-user socket as client mode.\n"
-	"		--dequeue-zero-copy enables dequeue zero copy\n",
+	"		--dequeue-zero-copy enables dequeue zero copy\n"
+	"		--sw-switch switch packets in software instead of with VMDQ\n",
 	       prgname);
 }
 
@@ -481,6 +562,7 @@ us_vhost_parse_args(int argc, char **argv)
 		{"client", no_argument, &client_mode, 1},
 		{"dequeue-zero-copy", no_argument, &dequeue_zero_copy, 1},
 		{"builtin-net-driver", no_argument, &builtin_net_driver, 1},
+		{"sw-switch", no_argument, &sw_switch, 1},
 		{NULL, 0, 0, 0},
 	};
 
@@ -632,6 +714,13 @@ us_vhost_parse_args(int argc, char **argv)
 		}
 	}
 
+	if (sw_switch && vm2vm_mode == VM2VM_HARDWARE) {
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"Hardware vm2vm needs VMDQ, it can't be used with sw-switch\n");
+		us_vhost_usage(prgname);
+		return -1;
+	}
+
 	for (i = 0; i < RTE_MAX_ETHPORTS; i++) {
 		if (enabled_port_mask & (1 << i))
 			ports[num_ports++] = i;
@@ -1027,42 +1116,45 @@ drain_mbuf_table(struct mbuf_table *tx_q)
 	}
 }
 
-static __rte_always_inline void
-drain_eth_rx(struct vhost_dev *vdev)
+static __rte_always_inline uint16_t
+enqueue_pkts(struct vhost_dev *vdev, struct rte_mbuf **pkts, uint16_t count)
 {
-	uint16_t rx_count, enqueue_count;
-	struct rte_mbuf *pkts[MAX_PKT_BURST];
-
-	rx_count = rte_eth_rx_burst(ports[0], vdev->vmdq_rx_q,
-				    pkts, MAX_PKT_BURST);
-	if (!rx_count)
-		return;
-
 	/*
 	 * When "enable_retry" is set, here we wait and retry when there
-	 * is no enough free slots in the queue to hold @rx_count packets,
+	 * is no enough free slots in the queue to hold @count packets,
 	 * to diminish packet loss.
 	 */
 	if (enable_retry &&
-	    unlikely(rx_count > rte_vhost_avail_entries(vdev->vid,
+	    unlikely(count > rte_vhost_avail_entries(vdev->vid,
 			VIRTIO_RXQ))) {
 		uint32_t retry;
 
 		for (retry = 0; retry < burst_rx_retry_num; retry++) {
 			rte_delay_us(burst_rx_delay_time);
-			if (rx_count <= rte_vhost_avail_entries(vdev->vid,
+			if (count <= rte_vhost_avail_entries(vdev->vid,
 					VIRTIO_RXQ))
 				break;
 		}
 	}
 
-	if (builtin_net_driver) {
-		enqueue_count = vs_enqueue_pkts(vdev, VIRTIO_RXQ,
-						pkts, rx_count);
-	} else {
-		enqueue_count = rte_vhost_enqueue_burst(vdev->vid, VIRTIO_RXQ,
-						pkts, rx_count);
-	}
+	if (builtin_net_driver)
+		return vs_enqueue_pkts(vdev, VIRTIO_RXQ, pkts, count);
+
+	return rte_vhost_enqueue_burst(vdev->vid, VIRTIO_RXQ, pkts, count);
+}
+
+static __rte_always_inline void
+drain_eth_rx(struct vhost_dev *vdev)
+{
+	uint16_t rx_count, enqueue_count;
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+
+	rx_count = rte_eth_rx_burst(ports[0], vdev->vmdq_rx_q,
+				    pkts, MAX_PKT_BURST);
+	if (!rx_count)
+		return;
+
+	enqueue_count = enqueue_pkts(vdev, pkts, rx_count);
 	if (enable_stats) {
 		rte_atomic64_add(&vdev->stats.rx_total_atomic, rx_count);
 		rte_atomic64_add(&vdev->stats.rx_atomic, enqueue_count);
@@ -1088,14 +1180,487 @@ drain_virtio_tx(struct vhost_dev *vdev)
 
 	/* setup VMDq for the first packet */
 	if (unlikely(vdev->ready == DEVICE_MAC_LEARNING) && count) {
-		if (vdev->remove || link_vmdq(vdev, pkts[0]) == -1)
+		if (vdev->remove || link_vmdq(vdev, pkts[0]) == -1) {
 			free_pkts(pkts, count);
+			return;
+		}
 	}
 
 	for (i = 0; i < count; ++i)
 		virtio_tx_route(vdev, pkts[i], vlan_tags[vdev->vid]);
 }
 
+/*
+ * Learns the MAC address of the device from its first packet, and adds
+ * it to the MAC table of the software switch.
+ */
+static int
+link_sw_switch(struct vhost_dev *vdev, struct rte_mbuf *m)
+{
+	struct ether_hdr *pkt_hdr;
+	int ret;
+
+	pkt_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
+	if (!is_valid_assigned_ether_addr(&pkt_hdr->s_addr)) {
+		RTE_LOG(ERR, VHOST_DATA,
+			"(%d) device is using an invalid MAC!\n", vdev->vid);
+		return -1;
+	}
+
+	rte_spinlock_lock(&mac_table_lock);
+	if (rte_hash_lookup(mac_table, &pkt_hdr->s_addr) >= 0) {
+		rte_spinlock_unlock(&mac_table_lock);
+		RTE_LOG(ERR, VHOST_DATA,
+			"(%d) device is using a registered MAC!\n",
+			vdev->vid);
+		return -1;
+	}
+	ether_addr_copy(&pkt_hdr->s_addr, &vdev->mac_address);
+	ret = rte_hash_add_key_data(mac_table, &vdev->mac_address, vdev);
+	rte_spinlock_unlock(&mac_table_lock);
+	if (ret < 0) {
+		RTE_LOG(ERR, VHOST_DATA,
+			"(%d) failed to add device MAC address to the MAC table\n",
+			vdev->vid);
+		return -1;
+	}
+
+	RTE_LOG(INFO, VHOST_DATA,
+		"(%d) mac %02x:%02x:%02x:%02x:%02x:%02x registered\n",
+		vdev->vid,
+		vdev->mac_address.addr_bytes[0], vdev->mac_address.addr_bytes[1],
+		vdev->mac_address.addr_bytes[2], vdev->mac_address.addr_bytes[3],
+		vdev->mac_address.addr_bytes[4], vdev->mac_address.addr_bytes[5]);
+
+	/* Let the NIC receive for the device, or fall back to promiscuous. */
+	if (!promiscuous &&
+	    rte_eth_dev_mac_addr_add(ports[0], &vdev->mac_address, 0) != 0) {
+		RTE_LOG(INFO, VHOST_DATA,
+			"(%d) failed to add device MAC address to the port, "
+			"enabling promiscuous mode\n", vdev->vid);
+		rte_eth_promiscuous_enable(ports[0]);
+	}
+
+	/* Set device as ready for RX. */
+	vdev->ready = DEVICE_RX;
+
+	return 0;
+}
+
+/*
+ * Removes the MAC address of the device from the MAC table. Its key slot
+ * is only freed in destroy_device(), once no core may still hold the
+ * device from an earlier lookup.
+ */
+static inline void
+unlink_sw_switch(struct vhost_dev *vdev)
+{
+	if (vdev->ready != DEVICE_RX)
+		return;
+
+	if (!promiscuous)
+		rte_eth_dev_mac_addr_remove(ports[0], &vdev->mac_address);
+
+	rte_spinlock_lock(&mac_table_lock);
+	vdev->mac_key_pos = rte_hash_del_key(mac_table, &vdev->mac_address);
+	rte_spinlock_unlock(&mac_table_lock);
+
+	memset(&vdev->mac_address, 0, sizeof(vdev->mac_address));
+	vdev->ready = DEVICE_MAC_LEARNING;
+}
+
+/*
+ * Looks up the destination devices of a burst in the MAC table. Entries
+ * are left NULL for unknown destinations, and for devices being removed.
+ */
+static __rte_always_inline void
+sw_switch_lookup(struct rte_mbuf **pkts, uint16_t count,
+		 struct vhost_dev **dst)
+{
+	const void *keys[MAX_PKT_BURST];
+	uint64_t hit_mask = 0;
+	uint16_t i;
+
+	for (i = 0; i < count; i++)
+		keys[i] = &rte_pktmbuf_mtod(pkts[i], struct ether_hdr *)->d_addr;
+
+	rte_hash_lookup_bulk_data(mac_table, keys, count, &hit_mask,
+				  (void **)dst);
+
+	for (i = 0; i < count; i++) {
+		if (!(hit_mask & (1ULL << i)) || unlikely(dst[i]->remove))
+			dst[i] = NULL;
+	}
+}
+
+/*
+ * Fills in the checksums of a TCP/IPv4 packet, or leaves them to the NIC
+ * when @hw_cksum is set.
+ */
+static void
+sw_switch_cksum(struct rte_mbuf *m, int hw_cksum)
+{
+	struct ipv4_hdr *ipv4_hdr;
+	struct tcp_hdr *tcp_hdr;
+	uint32_t l4_off = m->l2_len + m->l3_len;
+	uint32_t sum;
+	uint16_t raw;
+
+	ipv4_hdr = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+	tcp_hdr = rte_pktmbuf_mtod_offset(m, struct tcp_hdr *, l4_off);
+	ipv4_hdr->hdr_checksum = 0;
+
+	if (hw_cksum) {
+		m->ol_flags |= PKT_TX_IPV4 | PKT_TX_IP_CKSUM | PKT_TX_TCP_CKSUM;
+		tcp_hdr->cksum = get_psd_sum(ipv4_hdr, m->ol_flags);
+		return;
+	}
+
+	m->ol_flags &= ~(PKT_TX_IP_CKSUM | PKT_TX_L4_MASK);
+	ipv4_hdr->hdr_checksum = rte_ipv4_cksum(ipv4_hdr);
+
+	tcp_hdr->cksum = 0;
+	if (rte_raw_cksum_mbuf(m, l4_off, m->pkt_len - l4_off, &raw) < 0)
+		return;
+	sum = (uint32_t)raw + rte_ipv4_phdr_cksum(ipv4_hdr, 0);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (~sum) & 0xffff;
+	tcp_hdr->cksum = sum == 0 ? 0xffff : (uint16_t)sum;
+}
+
+/*
+ * Segments a TSO packet for a destination which can't take it. With
+ * @keep set the caller still owns @m afterwards, otherwise it's consumed.
+ * Returns the number of segments in @segs.
+ */
+static int
+sw_switch_gso(struct rte_mbuf *m, struct rte_mbuf **segs, int keep,
+	      int hw_cksum)
+{
+	struct rte_mbuf *seg;
+	int i, nb_segs;
+
+	if (keep) {
+		for (seg = m; seg != NULL; seg = seg->next)
+			rte_mbuf_refcnt_update(seg, 1);
+	}
+
+	nb_segs = rte_gso_segment(m, &gso_ctx, segs, MAX_GSO_SEGS);
+	if (unlikely(nb_segs < 0)) {
+		if (keep) {
+			for (seg = m; seg != NULL; seg = seg->next)
+				rte_mbuf_refcnt_update(seg, -1);
+		} else {
+			rte_pktmbuf_free(m);
+		}
+		return 0;
+	}
+
+	/* GSO doesn't update the checksums of the segments. */
+	if (nb_segs > 1) {
+		for (i = 0; i < nb_segs; i++)
+			sw_switch_cksum(segs[i], hw_cksum);
+	}
+
+	return nb_segs;
+}
+
+/*
+ * Merges the TCP/IPv4 packets of a NIC Rx burst. The merged packets that
+ * exceed the MTU are passed on as TSO packets, the guest takes them as is
+ * or they are segmented again on delivery.
+ */
+static uint16_t
+sw_switch_gro(struct rte_mbuf **pkts, uint16_t count)
+{
+	struct rte_net_hdr_lens hdr_lens;
+	struct ipv4_hdr *ipv4_hdr;
+	struct tcp_hdr *tcp_hdr;
+	struct rte_mbuf *m;
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		m = pkts[i];
+		m->packet_type = rte_net_get_ptype(m, &hdr_lens,
+						   RTE_PTYPE_ALL_MASK);
+		m->l2_len = hdr_lens.l2_len;
+		m->l3_len = hdr_lens.l3_len;
+		m->l4_len = hdr_lens.l4_len;
+	}
+
+	count = rte_gro_reassemble_burst(pkts, count, &gro_param);
+
+	for (i = 0; i < count; i++) {
+		m = pkts[i];
+		/* GRO chains the packets it merges. */
+		if (m->nb_segs == 1 || !RTE_ETH_IS_IPV4_HDR(m->packet_type) ||
+		    (m->packet_type & RTE_PTYPE_L4_MASK) != RTE_PTYPE_L4_TCP)
+			continue;
+
+		if (m->pkt_len - m->l2_len <= ETHER_MTU) {
+			sw_switch_cksum(m, 0);
+			continue;
+		}
+
+		ipv4_hdr = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+						   m->l2_len);
+		tcp_hdr = rte_pktmbuf_mtod_offset(m, struct tcp_hdr *,
+						  m->l2_len + m->l3_len);
+		/* The IP checksum is computed on enqueue. */
+		ipv4_hdr->hdr_checksum = 0;
+		tcp_hdr->cksum = rte_ipv4_phdr_cksum(ipv4_hdr, 0);
+		m->ol_flags |= PKT_TX_IPV4 | PKT_TX_IP_CKSUM | PKT_TX_TCP_SEG;
+		m->tso_segsz = ETHER_MTU - m->l3_len - m->l4_len;
+	}
+
+	return count;
+}
+
+/*
+ * Delivers a burst to one device in a single enqueue. TSO packets are
+ * segmented first if the guest hasn't negotiated TSO. The caller keeps
+ * the ownership of the packets.
+ */
+static void
+sw_switch_xmit(struct vhost_dev *dst_vdev, struct vhost_dev *src_vdev,
+	       struct rte_mbuf **pkts, uint16_t count)
+{
+	struct rte_mbuf *segs[MAX_GSO_SEGS];
+	uint16_t i, start = 0, total = 0, ret = 0;
+	int nb_segs;
+
+	if (indirect_pool != NULL &&
+	    !(dst_vdev->features & (1ULL << VIRTIO_NET_F_GUEST_TSO4))) {
+		for (i = 0; i < count; i++) {
+			if (!(pkts[i]->ol_flags & PKT_TX_TCP_SEG))
+				continue;
+
+			if (i > start) {
+				ret += enqueue_pkts(dst_vdev, &pkts[start],
+						    i - start);
+				total += i - start;
+			}
+			start = i + 1;
+
+			nb_segs = sw_switch_gso(pkts[i], segs, 1, 0);
+			if (nb_segs > 0) {
+				ret += enqueue_pkts(dst_vdev, segs, nb_segs);
+				free_pkts(segs, nb_segs);
+			}
+			total += nb_segs;
+		}
+	}
+
+	if (count > start) {
+		ret += enqueue_pkts(dst_vdev, &pkts[start], count - start);
+		total += count - start;
+	}
+
+	if (enable_stats) {
+		rte_atomic64_add(&dst_vdev->stats.rx_total_atomic, total);
+		rte_atomic64_add(&dst_vdev->stats.rx_atomic, ret);
+		if (src_vdev != NULL) {
+			src_vdev->stats.tx_total += total;
+			src_vdev->stats.tx += ret;
+		}
+	}
+}
+
+/*
+ * Delivers the packets of a burst to their destination devices, one
+ * enqueue per destination. @dst is cleared on return.
+ */
+static __rte_always_inline void
+sw_switch_forward(struct vhost_dev *src_vdev, struct rte_mbuf **pkts,
+		  struct vhost_dev **dst, uint16_t count)
+{
+	struct rte_mbuf *batch[MAX_PKT_BURST];
+	struct vhost_dev *dst_vdev;
+	uint16_t i, j, n;
+
+	for (i = 0; i < count; i++) {
+		dst_vdev = dst[i];
+		if (dst_vdev == NULL)
+			continue;
+
+		n = 0;
+		for (j = i; j < count; j++) {
+			if (dst[j] == dst_vdev) {
+				batch[n++] = pkts[j];
+				dst[j] = NULL;
+			}
+		}
+		sw_switch_xmit(dst_vdev, src_vdev, batch, n);
+	}
+}
+
+/* Delivers broadcast and multicast packets to every other device. */
+static __rte_always_inline void
+sw_switch_flood(struct vhost_dev *src_vdev, struct rte_mbuf **pkts,
+		uint16_t count)
+{
+	struct vhost_dev *vdev;
+
+	TAILQ_FOREACH(vdev, &vhost_dev_list, global_vdev_entry) {
+		if (vdev != src_vdev && vdev->ready == DEVICE_RX &&
+		    !vdev->remove)
+			sw_switch_xmit(vdev, src_vdev, pkts, count);
+	}
+}
+
+static __rte_always_inline void
+sw_switch_queue2nic(struct mbuf_table *tx_q, struct vhost_dev *vdev,
+		    struct rte_mbuf *m)
+{
+	tx_q->m_table[tx_q->len++] = m;
+	if (enable_stats) {
+		vdev->stats.tx_total++;
+		vdev->stats.tx++;
+	}
+
+	if (unlikely(tx_q->len == MAX_PKT_BURST))
+		do_drain_mbuf_table(tx_q);
+}
+
+/*
+ * Sends a packet of a device to the physical port, doing in software the
+ * offloads the port lacks.
+ */
+static __rte_always_inline void
+sw_switch_tx_nic(struct vhost_dev *vdev, struct rte_mbuf *m)
+{
+	struct mbuf_table *tx_q = &lcore_tx_queue[rte_lcore_id()];
+	struct rte_mbuf *segs[MAX_GSO_SEGS];
+	const uint64_t cksum_offloads = DEV_TX_OFFLOAD_IPV4_CKSUM |
+					DEV_TX_OFFLOAD_TCP_CKSUM;
+	int hw_cksum = (port_tx_offloads & cksum_offloads) == cksum_offloads;
+	int i, nb_segs;
+
+	if (m->ol_flags & PKT_TX_TCP_SEG) {
+		if (port_tx_offloads & DEV_TX_OFFLOAD_TCP_TSO ||
+		    indirect_pool == NULL) {
+			virtio_tx_offload(m);
+		} else {
+			nb_segs = sw_switch_gso(m, segs, 0, hw_cksum);
+			for (i = 0; i < nb_segs; i++)
+				sw_switch_queue2nic(tx_q, vdev, segs[i]);
+			return;
+		}
+	} else if ((m->ol_flags & PKT_TX_L4_MASK) == PKT_TX_TCP_CKSUM &&
+		   (m->ol_flags & PKT_TX_IPV4) && !hw_cksum) {
+		sw_switch_cksum(m, 0);
+	}
+
+	sw_switch_queue2nic(tx_q, vdev, m);
+}
+
+/*
+ * Switches a burst of a device: local destinations get one batched
+ * enqueue each, without going through the NIC, and unknown or multicast
+ * destinations go out of the physical port.
+ */
+static __rte_always_inline void
+sw_switch_virtio_tx(struct vhost_dev *vdev)
+{
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	struct rte_mbuf *nic_pkts[MAX_PKT_BURST];
+	struct rte_mbuf *flood_pkts[MAX_PKT_BURST];
+	struct rte_mbuf *local_pkts[MAX_PKT_BURST];
+	struct vhost_dev *dst[MAX_PKT_BURST];
+	uint16_t nb_nic = 0, nb_flood = 0, nb_local = 0;
+	struct ether_hdr *nh;
+	uint16_t count;
+	uint16_t i;
+
+	if (builtin_net_driver) {
+		count = vs_dequeue_pkts(vdev, VIRTIO_TXQ, mbuf_pool,
+					pkts, MAX_PKT_BURST);
+	} else {
+		count = rte_vhost_dequeue_burst(vdev->vid, VIRTIO_TXQ,
+					mbuf_pool, pkts, MAX_PKT_BURST);
+	}
+	if (!count)
+		return;
+
+	/* learn the MAC address from the first packet */
+	if (unlikely(vdev->ready == DEVICE_MAC_LEARNING)) {
+		if (vdev->remove || link_sw_switch(vdev, pkts[0]) == -1) {
+			free_pkts(pkts, count);
+			return;
+		}
+	}
+
+	if (vm2vm_mode == VM2VM_SOFTWARE)
+		sw_switch_lookup(pkts, count, dst);
+	else
+		memset(dst, 0, count * sizeof(dst[0]));
+
+	for (i = 0; i < count; i++) {
+		if (dst[i] != NULL) {
+			if (unlikely(dst[i] == vdev)) {
+				RTE_LOG_DP(DEBUG, VHOST_DATA,
+					"(%d) TX: src and dst MAC is same. Dropping packet.\n",
+					vdev->vid);
+				dst[i] = NULL;
+			}
+			local_pkts[nb_local++] = pkts[i];
+			continue;
+		}
+
+		nh = rte_pktmbuf_mtod(pkts[i], struct ether_hdr *);
+		if (unlikely(is_multicast_ether_addr(&nh->d_addr)) &&
+		    vm2vm_mode == VM2VM_SOFTWARE)
+			flood_pkts[nb_flood++] = pkts[i];
+		nic_pkts[nb_nic++] = pkts[i];
+	}
+
+	/* Local deliveries copy the packets, they are freed afterwards. */
+	if (nb_local)
+		sw_switch_forward(vdev, pkts, dst, count);
+	if (nb_flood)
+		sw_switch_flood(vdev, flood_pkts, nb_flood);
+	free_pkts(local_pkts, nb_local);
+
+	for (i = 0; i < nb_nic; i++)
+		sw_switch_tx_nic(vdev, nic_pkts[i]);
+}
+
+/*
+ * Drains the NIC Rx queue of the core: its packets are delivered to their
+ * destination devices, whichever core polls them.
+ */
+static __rte_always_inline void
+sw_switch_eth_rx(uint16_t rxq)
+{
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	struct rte_mbuf *flood_pkts[MAX_PKT_BURST];
+	struct vhost_dev *dst[MAX_PKT_BURST];
+	uint16_t rx_count, nb_flood = 0, i;
+	struct ether_hdr *nh;
+
+	rx_count = rte_eth_rx_burst(ports[0], rxq, pkts, MAX_PKT_BURST);
+	if (!rx_count)
+		return;
+
+	if (indirect_pool != NULL)
+		rx_count = sw_switch_gro(pkts, rx_count);
+
+	sw_switch_lookup(pkts, rx_count, dst);
+	for (i = 0; i < rx_count; i++) {
+		nh = rte_pktmbuf_mtod(pkts[i], struct ether_hdr *);
+		if (dst[i] == NULL &&
+		    unlikely(is_multicast_ether_addr(&nh->d_addr)))
+			flood_pkts[nb_flood++] = pkts[i];
+	}
+
+	sw_switch_forward(NULL, pkts, dst, rx_count);
+	if (nb_flood)
+		sw_switch_flood(NULL, flood_pkts, nb_flood);
+
+	free_pkts(pkts, rx_count);
+}
+
 /*
  * Main function of vhost-switch. It basically does:
  *
@@ -1163,6 +1728,69 @@ switch_worker(void *arg __rte_unused)
 	return 0;
 }
 
+/*
+ * Main function of the software switching mode. Each core owns one Rx
+ * queue of the physical port and the vhost devices added to it:
+ *
+ * - sw_switch_eth_rx() delivers the NIC Rx queue to the devices found in
+ *   the MAC table.
+ *
+ * - sw_switch_virtio_tx() drains the guest Tx queues of the core, to
+ *   other devices or to the physical port.
+ */
+static int
+sw_switch_worker(void *arg __rte_unused)
+{
+	unsigned i;
+	unsigned lcore_id = rte_lcore_id();
+	uint16_t rxq = 0;
+	struct vhost_dev *vdev;
+	struct mbuf_table *tx_q;
+
+	RTE_LOG(INFO, VHOST_DATA, "Procesing on Core %u started\n", lcore_id);
+
+	tx_q = &lcore_tx_queue[lcore_id];
+	for (i = 0; i < rte_lcore_count(); i++) {
+		if (lcore_ids[i] == lcore_id) {
+			tx_q->txq_id = i;
+			break;
+		}
+	}
+
+	/* The Rx queues are numbered after the switch cores. */
+	RTE_LCORE_FOREACH_SLAVE(i) {
+		if (i == lcore_id)
+			break;
+		rxq++;
+	}
+
+	while (1) {
+		drain_mbuf_table(tx_q);
+
+		/*
+		 * Inform the configuration core that we have exited the
+		 * linked list and that no devices are in use if requested.
+		 */
+		if (lcore_info[lcore_id].dev_removal_flag == REQUEST_DEV_REMOVAL)
+			lcore_info[lcore_id].dev_removal_flag = ACK_DEV_REMOVAL;
+
+		sw_switch_eth_rx(rxq);
+
+		TAILQ_FOREACH(vdev, &lcore_info[lcore_id].vdev_list,
+			      lcore_vdev_entry) {
+			if (unlikely(vdev->remove)) {
+				unlink_sw_switch(vdev);
+				vdev->ready = DEVICE_SAFE_REMOVE;
+				continue;
+			}
+
+			sw_switch_virtio_tx(vdev);
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Remove a device from the specific data core linked list and from the
  * main linked list. Synchonization  occurs through the use of the
@@ -1209,6 +1837,13 @@ destroy_device(int vid)
 			rte_pause();
 	}
 
+	/* No core may look up the device anymore, free its MAC table slot. */
+	if (sw_switch && vdev->mac_key_pos >= 0) {
+		rte_spinlock_lock(&mac_table_lock);
+		rte_hash_free_key_with_position(mac_table, vdev->mac_key_pos);
+		rte_spinlock_unlock(&mac_table_lock);
+	}
+
 	lcore_info[vdev->coreid].device_num--;
 
 	RTE_LOG(INFO, VHOST_DATA,
@@ -1237,6 +1872,8 @@ new_device(int vid)
 		return -1;
 	}
 	vdev->vid = vid;
+	vdev->mac_key_pos = -1;
+	rte_vhost_get_negotiated_features(vid, &vdev->features);
 
 	if (builtin_net_driver)
 		vs_vhost_net_setup(vdev);
@@ -1405,6 +2042,43 @@ create_mbuf_pool(uint16_t nr_port, uint32_t nr_switch_core, uint32_t mbuf_size,
 		rte_exit(EXIT_FAILURE, "Cannot create mbuf pool\n");
 }
 
+/*
+ * Creates the MAC table of the software switch, and the indirect mbuf
+ * pool GSO needs when TSO is enabled.
+ */
+static void
+sw_switch_init(uint32_t nr_switch_core)
+{
+	struct rte_hash_parameters params = {
+		.name = "vhost_mac_table",
+		.entries = MAX_SW_DEVICES,
+		.key_len = sizeof(struct ether_addr),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF,
+	};
+
+	mac_table = rte_hash_create(&params);
+	if (mac_table == NULL)
+		rte_exit(EXIT_FAILURE, "Cannot create MAC table\n");
+
+	if (!enable_tso)
+		return;
+
+	indirect_pool = rte_pktmbuf_pool_create("INDIRECT_POOL",
+			NUM_INDIRECT_MBUFS * RTE_MAX(nr_switch_core, 1U),
+			MBUF_CACHE_SIZE, 0, 0, rte_socket_id());
+	if (indirect_pool == NULL)
+		rte_exit(EXIT_FAILURE, "Cannot create indirect mbuf pool\n");
+
+	gso_ctx.direct_pool = mbuf_pool;
+	gso_ctx.indirect_pool = indirect_pool;
+	gso_ctx.gso_types = DEV_TX_OFFLOAD_TCP_TSO;
+	gso_ctx.gso_size = ETHER_MAX_LEN - ETHER_CRC_LEN;
+	gso_ctx.flag = 0;
+}
+
 /*
  * Main function, does initialisation and calls the per-lcore functions.
  */
@@ -1466,6 +2140,9 @@ main(int argc, char *argv[])
 	create_mbuf_pool(valid_num_ports, rte_lcore_count() - 1, MBUF_DATA_SIZE,
 			 MAX_QUEUES, RTE_TEST_RX_DESC_DEFAULT, MBUF_CACHE_SIZE);
 
+	if (sw_switch)
+		sw_switch_init(rte_lcore_count() - 1);
+
 	if (vm2vm_mode == VM2VM_HARDWARE) {
 		/* Enable VT loop back to let L2 switch to do it. */
 		vmdq_conf_default.rx_adv_conf.vmdq_rx_conf.enable_loop_back = 1;
@@ -1497,7 +2174,8 @@ main(int argc, char *argv[])
 
 	/* Launch all data cores. */
 	RTE_LCORE_FOREACH_SLAVE(lcore_id)
-		rte_eal_remote_launch(switch_worker, NULL, lcore_id);
+		rte_eal_remote_launch(sw_switch ? sw_switch_worker :
+				      switch_worker, NULL, lcore_id);
 
 	if (client_mode)
 		flags |= RTE_VHOST_USER_CLIENT;
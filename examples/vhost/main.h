@@ -40,6 +40,8 @@ struct vhost_dev {
 	uint16_t vmdq_rx_q;
 	/**< Vlan tag assigned to the pool */
 	uint32_t vlan_tag;
+	/**< Position of the MAC address in the software switch MAC table. */
+	int32_t mac_key_pos;
 	/**< Data core that the device is added to. */
 	uint16_t coreid;
 	/**< A device is set as ready if the MAC address has been set. */
@@ -78,8 +80,16 @@ struct lcore_info {
 	struct vhost_dev_tailq_list vdev_list;
 };
 
-/* we implement non-extra virtio net features */
-#define VIRTIO_NET_FEATURES	0
+/*
+ * we implement non-extra virtio net features but checksum offload and
+ * TSO, which the options may disable
+ */
+#define VIRTIO_NET_FEATURES	((1ULL << VIRTIO_NET_F_CSUM) | \
+				 (1ULL << VIRTIO_NET_F_GUEST_CSUM) | \
+				 (1ULL << VIRTIO_NET_F_HOST_TSO4) | \
+				 (1ULL << VIRTIO_NET_F_HOST_TSO6) | \
+				 (1ULL << VIRTIO_NET_F_GUEST_TSO4) | \
+				 (1ULL << VIRTIO_NET_F_GUEST_TSO6))
 
 void vs_vhost_net_setup(struct vhost_dev *dev);
 void vs_vhost_net_remove(struct vhost_dev *dev);
@@ -6,15 +6,20 @@
 #include <stdbool.h>
 #include <linux/virtio_net.h>
 
+#include <rte_ip.h>
 #include <rte_mbuf.h>
 #include <rte_memcpy.h>
+#include <rte_net.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
 #include <rte_vhost.h>
 
 #include "main.h"
 
 /*
  * A very simple vhost-user net driver implementation, without
- * any extra features being enabled, such as TSO and mrg-Rx.
+ * any extra features being enabled but checksum offload and TSO:
+ * no mrg-Rx for instance.
  */
 
 void
@@ -51,6 +56,98 @@ vs_vhost_net_remove(struct vhost_dev *dev)
 	free(dev->mem);
 }
 
+/*
+ * Maps the Tx offloads of a packet onto the virtio-net header of the
+ * receiving guest, so that a TSO packet from another guest is delivered
+ * as a whole segment rather than segmented on the way.
+ */
+static __rte_always_inline void
+virtio_enqueue_offload(struct rte_mbuf *m, struct virtio_net_hdr *hdr)
+{
+	uint64_t csum_l4 = m->ol_flags & PKT_TX_L4_MASK;
+
+	if (m->ol_flags & PKT_TX_TCP_SEG)
+		csum_l4 |= PKT_TX_TCP_CKSUM;
+
+	if (csum_l4 == PKT_TX_TCP_CKSUM || csum_l4 == PKT_TX_UDP_CKSUM) {
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		hdr->csum_start = m->l2_len + m->l3_len;
+		hdr->csum_offset = csum_l4 == PKT_TX_TCP_CKSUM ?
+			offsetof(struct tcp_hdr, cksum) :
+			offsetof(struct udp_hdr, dgram_cksum);
+	}
+
+	/* IP cksum verification cannot be bypassed, then calculate here */
+	if (m->ol_flags & PKT_TX_IP_CKSUM) {
+		struct ipv4_hdr *ipv4_hdr;
+
+		ipv4_hdr = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+						   m->l2_len);
+		ipv4_hdr->hdr_checksum = 0;
+		ipv4_hdr->hdr_checksum = rte_ipv4_cksum(ipv4_hdr);
+	}
+
+	if (m->ol_flags & PKT_TX_TCP_SEG) {
+		hdr->gso_type = (m->ol_flags & PKT_TX_IPV4) ?
+			VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+		hdr->gso_size = m->tso_segsz;
+		hdr->hdr_len = m->l2_len + m->l3_len + m->l4_len;
+	}
+}
+
+/*
+ * Sets the Tx offloads of a packet from the virtio-net header the guest
+ * has sent it with.
+ */
+static __rte_always_inline void
+virtio_dequeue_offload(const struct virtio_net_hdr *hdr, struct rte_mbuf *m)
+{
+	struct rte_net_hdr_lens hdr_lens;
+	uint32_t ptype;
+
+	if (hdr->flags == 0 && hdr->gso_type == VIRTIO_NET_HDR_GSO_NONE)
+		return;
+
+	ptype = rte_net_get_ptype(m, &hdr_lens, RTE_PTYPE_ALL_MASK);
+	m->l2_len = hdr_lens.l2_len;
+	m->l3_len = hdr_lens.l3_len;
+	m->l4_len = hdr_lens.l4_len;
+
+	if (RTE_ETH_IS_IPV4_HDR(ptype))
+		m->ol_flags |= PKT_TX_IPV4;
+	else if (RTE_ETH_IS_IPV6_HDR(ptype))
+		m->ol_flags |= PKT_TX_IPV6;
+	else
+		return;
+
+	if (hdr->flags == VIRTIO_NET_HDR_F_NEEDS_CSUM &&
+	    hdr->csum_start == m->l2_len + m->l3_len) {
+		if ((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_TCP &&
+		    hdr->csum_offset == offsetof(struct tcp_hdr, cksum))
+			m->ol_flags |= PKT_TX_TCP_CKSUM;
+		else if ((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_UDP &&
+			 hdr->csum_offset == offsetof(struct udp_hdr,
+						      dgram_cksum))
+			m->ol_flags |= PKT_TX_UDP_CKSUM;
+	}
+
+	switch (hdr->gso_type & ~VIRTIO_NET_HDR_GSO_ECN) {
+	case VIRTIO_NET_HDR_GSO_NONE:
+		break;
+	case VIRTIO_NET_HDR_GSO_TCPV4:
+	case VIRTIO_NET_HDR_GSO_TCPV6:
+		if ((ptype & RTE_PTYPE_L4_MASK) != RTE_PTYPE_L4_TCP)
+			break;
+		m->ol_flags |= PKT_TX_TCP_SEG;
+		m->tso_segsz = hdr->gso_size;
+		break;
+	default:
+		RTE_LOG(WARNING, VHOST_DATA,
+			"unsupported gso type %u.\n", hdr->gso_type);
+		break;
+	}
+}
+
 static __rte_always_inline int
 enqueue_pkt(struct vhost_dev *dev, struct rte_vhost_vring *vr,
 	    struct rte_mbuf *m, uint16_t desc_idx)
@@ -80,6 +177,8 @@ enqueue_pkt(struct vhost_dev *dev, struct rte_vhost_vring *vr,
 
 	rte_prefetch0((void *)(uintptr_t)desc_addr);
 
+	virtio_enqueue_offload(m, &virtio_hdr);
+
 	/* write virtio-net header */
 	if (likely(desc_chunck_len >= dev->hdr_len)) {
 		*(struct virtio_net_hdr *)(uintptr_t)desc_addr = virtio_hdr;
@@ -246,6 +345,7 @@ dequeue_pkt(struct vhost_dev *dev, struct rte_vhost_vring *vr,
 	uint32_t mbuf_avail, mbuf_offset;
 	uint32_t cpy_len;
 	struct rte_mbuf *cur = m, *prev = m;
+	struct virtio_net_hdr virtio_hdr;
 	/* A counter to avoid desc dead loop chain */
 	uint32_t nr_desc = 1;
 
@@ -267,9 +367,13 @@ dequeue_pkt(struct vhost_dev *dev, struct rte_vhost_vring *vr,
 	 * the first for storing the header and the others for
 	 * storing the data.
 	 *
-	 * And since we don't support TSO, we could simply skip the
-	 * header.
+	 * The header is only kept for the offloads it requests.
 	 */
+	if (likely(desc_chunck_len >= sizeof(virtio_hdr)))
+		virtio_hdr = *(struct virtio_net_hdr *)(uintptr_t)desc_addr;
+	else
+		memset(&virtio_hdr, 0, sizeof(virtio_hdr));
+
 	desc = &vr->desc[desc->next];
 	desc_chunck_len = desc->len;
 	desc_gaddr = desc->addr;
@@ -356,6 +460,8 @@ dequeue_pkt(struct vhost_dev *dev, struct rte_vhost_vring *vr,
 	prev->data_len = mbuf_offset;
 	m->pkt_len    += mbuf_offset;
 
+	virtio_dequeue_offload(&virtio_hdr, m);
+
 	return 0;
 }
 
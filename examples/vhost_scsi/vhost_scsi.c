@@ -7,12 +7,13 @@
 #include <stdbool.h>
 #include <signal.h>
 #include <assert.h>
-#include <semaphore.h>
 #include <linux/virtio_scsi.h>
 #include <linux/virtio_ring.h>
 
 #include <rte_atomic.h>
 #include <rte_cycles.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
 #include <rte_log.h>
 #include <rte_malloc.h>
 #include <rte_vhost.h>
@@ -22,14 +23,14 @@
 
 #define VIRTIO_SCSI_FEATURES ((1 << VIRTIO_F_NOTIFY_ON_EMPTY) |\
 			      (1 << VIRTIO_SCSI_F_INOUT) |\
-			      (1 << VIRTIO_SCSI_F_CHANGE))
+			      (1 << VIRTIO_SCSI_F_CHANGE) |\
+			      (1ULL << VIRTIO_F_VERSION_1) |\
+			      (1ULL << VIRTIO_F_RING_PACKED))
 
 /* Path to folder where character device will be created. Can be set by user. */
 static char dev_pathname[PATH_MAX] = "";
 
 static struct vhost_scsi_ctrlr *g_vhost_ctrlr;
-static int g_should_stop;
-static sem_t exit_sem;
 
 static struct vhost_scsi_ctrlr *
 vhost_scsi_ctrlr_find(__rte_unused const char *ctrlr_name)
@@ -38,137 +39,183 @@ vhost_scsi_ctrlr_find(__rte_unused const char *ctrlr_name)
 	return g_vhost_ctrlr;
 }
 
-static uint64_t gpa_to_vva(int vid, uint64_t gpa, uint64_t *len)
+static void *
+gpa_to_vva(struct vhost_scsi_ctrlr *ctrlr, uint64_t gpa, uint32_t len)
 {
-	char path[PATH_MAX];
-	struct vhost_scsi_ctrlr *ctrlr;
-	int ret = 0;
-
-	ret = rte_vhost_get_ifname(vid, path, PATH_MAX);
-	if (ret) {
-		fprintf(stderr, "Cannot get socket name\n");
-		assert(ret != 0);
-	}
+	uint64_t chunck_len = len;
+	void *vva;
 
-	ctrlr = vhost_scsi_ctrlr_find(path);
-	if (!ctrlr) {
-		fprintf(stderr, "Controller is not ready\n");
-		assert(ctrlr != NULL);
+	vva = (void *)(uintptr_t)rte_vhost_va_from_guest_pa(ctrlr->mem, gpa,
+							    &chunck_len);
+	if (!vva || chunck_len != len) {
+		fprintf(stderr, "failed to translate desc address.\n");
+		return NULL;
 	}
-
-	assert(ctrlr->mem != NULL);
-
-	return rte_vhost_va_from_guest_pa(ctrlr->mem, gpa, len);
+	return vva;
 }
 
-static struct vring_desc *
-descriptor_get_next(struct vring_desc *vq_desc, struct vring_desc *cur_desc)
+/*
+ * Walk the descriptors of a chain, in the split ring descriptor table or
+ * in consecutive slots of the packed ring.
+ */
+struct desc_chain {
+	struct rte_vhost_vring *vq;
+	bool packed;
+	uint16_t idx;
+	uint16_t nb_descs;
+	uint64_t addr;
+	uint32_t len;
+	uint16_t flags;
+	uint16_t id;
+	uint16_t next;
+};
+
+static void
+desc_chain_load(struct desc_chain *c)
 {
-	return &vq_desc[cur_desc->next];
+	if (c->packed) {
+		struct vring_packed_desc *desc = &c->vq->desc_packed[c->idx];
+
+		c->addr = desc->addr;
+		c->len = desc->len;
+		c->flags = desc->flags;
+		c->id = desc->id;
+	} else {
+		struct vring_desc *desc = &c->vq->desc[c->idx];
+
+		c->addr = desc->addr;
+		c->len = desc->len;
+		c->flags = desc->flags;
+		c->next = desc->next;
+	}
+	c->nb_descs++;
 }
 
 static bool
-descriptor_has_next(struct vring_desc *cur_desc)
+descriptor_has_next(struct desc_chain *c)
 {
-	return !!(cur_desc->flags & VRING_DESC_F_NEXT);
+	/* a chain longer than the ring is a loop */
+	return !!(c->flags & VRING_DESC_F_NEXT) && c->nb_descs < c->vq->size;
 }
 
 static bool
-descriptor_is_wr(struct vring_desc *cur_desc)
+descriptor_is_wr(struct desc_chain *c)
 {
-	return !!(cur_desc->flags & VRING_DESC_F_WRITE);
+	return !!(c->flags & VRING_DESC_F_WRITE);
 }
 
 static void
-submit_completion(struct vhost_scsi_task *task, uint32_t q_idx)
+descriptor_get_next(struct desc_chain *c)
 {
-	struct rte_vhost_vring *vq;
-	struct vring_used *used;
+	if (c->packed)
+		c->idx = c->idx + 1 == c->vq->size ? 0 : c->idx + 1;
+	else
+		c->idx = c->next & (c->vq->size - 1);
+	desc_chain_load(c);
+}
 
-	vq = task->vq;
-	used = vq->used;
-	/* Fill out the next entry in the "used" ring.  id = the
-	 * index of the descriptor that contained the SCSI request.
-	 * len = the total amount of data transferred for the SCSI
-	 * request. We must report the correct len, for variable
-	 * length SCSI CDBs, where we may return less data than
-	 * allocated by the guest VM.
-	 */
-	used->ring[used->idx & (vq->size - 1)].id = task->req_idx;
-	used->ring[used->idx & (vq->size - 1)].len = task->data_len;
-	used->idx++;
+static int
+task_add_iov(struct vhost_scsi_task *task, struct desc_chain *c)
+{
+	void *data;
 
-	/* Send an interrupt back to the guest VM so that it knows
-	 * a completion is ready to be processed.
-	 */
-	rte_vhost_vring_call(task->bdev->vid, q_idx);
+	if (task->iovs_cnt == VHOST_SCSI_MAX_IOVS)
+		return -1;
+	data = gpa_to_vva(task->ctrlr, c->addr, c->len);
+	if (!data)
+		return -1;
+
+	task->iovs[task->iovs_cnt].iov_base = data;
+	task->iovs[task->iovs_cnt].iov_len = c->len;
+	task->data_len += c->len;
+	task->iovs_cnt++;
+	return 0;
 }
 
-static void
-vhost_process_read_payload_chain(struct vhost_scsi_task *task)
+static int
+vhost_process_read_payload_chain(struct vhost_scsi_task *task,
+				 struct desc_chain *c)
 {
-	void *data;
-	uint64_t chunck_len;
+	task->resp = gpa_to_vva(task->ctrlr, c->addr, c->len);
+	if (!task->resp)
+		return -1;
 
-	task->iovs_cnt = 0;
-	chunck_len = task->desc->len;
-	task->resp = (void *)(uintptr_t)gpa_to_vva(task->bdev->vid,
-						   task->desc->addr,
-						   &chunck_len);
-	if (!task->resp || chunck_len != task->desc->len) {
-		fprintf(stderr, "failed to translate desc address.\n");
-		return;
+	while (descriptor_has_next(c)) {
+		descriptor_get_next(c);
+		if (task_add_iov(task, c))
+			return -1;
 	}
+	return 0;
+}
 
-	while (descriptor_has_next(task->desc)) {
-		task->desc = descriptor_get_next(task->vq->desc, task->desc);
-		chunck_len = task->desc->len;
-		data = (void *)(uintptr_t)gpa_to_vva(task->bdev->vid,
-						     task->desc->addr,
-							 &chunck_len);
-		if (!data || chunck_len != task->desc->len) {
-			fprintf(stderr, "failed to translate desc address.\n");
-			return;
-		}
+static int
+vhost_process_write_payload_chain(struct vhost_scsi_task *task,
+				  struct desc_chain *c)
+{
+	do {
+		if (task_add_iov(task, c))
+			return -1;
+		descriptor_get_next(c);
+	} while (descriptor_has_next(c));
 
-		task->iovs[task->iovs_cnt].iov_base = data;
-		task->iovs[task->iovs_cnt].iov_len = task->desc->len;
-		task->data_len += task->desc->len;
-		task->iovs_cnt++;
-	}
+	task->resp = gpa_to_vva(task->ctrlr, c->addr, c->len);
+	if (!task->resp)
+		return -1;
+	return 0;
 }
 
+/*
+ * Translate the request, payload and response buffers of the chain
+ * starting at ring index idx. The whole chain is walked even when it is
+ * malformed, so that a packed ring keeps its position.
+ */
 static void
-vhost_process_write_payload_chain(struct vhost_scsi_task *task)
+vhost_scsi_task_init(struct vhost_scsi_task *task, struct vhost_scsi_queue *q,
+		     bool packed, uint16_t idx)
 {
-	void *data;
-	uint64_t chunck_len;
-
+	struct desc_chain c = {
+		.vq = &q->vq,
+		.packed = packed,
+		.idx = idx,
+	};
+	int ret = -1;
+
+	task->req = NULL;
+	task->resp = NULL;
 	task->iovs_cnt = 0;
+	task->data_len = 0;
+
+	desc_chain_load(&c);
+	/* does not support indirect descriptors */
+	if (c.flags & VRING_DESC_F_INDIRECT)
+		goto out;
+
+	task->req = gpa_to_vva(task->ctrlr, c.addr, c.len);
+	if (!task->req || !descriptor_has_next(&c))
+		goto out;
+
+	descriptor_get_next(&c);
+	if (!descriptor_has_next(&c)) {
+		task->dxfer_dir = SCSI_DIR_NONE;
+		task->resp = gpa_to_vva(task->ctrlr, c.addr, c.len);
+		ret = task->resp ? 0 : -1;
+	} else if (!descriptor_is_wr(&c)) {
+		task->dxfer_dir = SCSI_DIR_TO_DEV;
+		ret = vhost_process_write_payload_chain(task, &c);
+	} else {
+		task->dxfer_dir = SCSI_DIR_FROM_DEV;
+		ret = vhost_process_read_payload_chain(task, &c);
+	}
 
-	do {
-		chunck_len = task->desc->len;
-		data = (void *)(uintptr_t)gpa_to_vva(task->bdev->vid,
-						     task->desc->addr,
-							 &chunck_len);
-		if (!data || chunck_len != task->desc->len) {
-			fprintf(stderr, "failed to translate desc address.\n");
-			return;
-		}
-
-		task->iovs[task->iovs_cnt].iov_base = data;
-		task->iovs[task->iovs_cnt].iov_len = task->desc->len;
-		task->data_len += task->desc->len;
-		task->iovs_cnt++;
-		task->desc = descriptor_get_next(task->vq->desc, task->desc);
-	} while (descriptor_has_next(task->desc));
-
-	chunck_len = task->desc->len;
-	task->resp = (void *)(uintptr_t)gpa_to_vva(task->bdev->vid,
-						   task->desc->addr,
-						   &chunck_len);
-	if (!task->resp || chunck_len != task->desc->len)
-		fprintf(stderr, "failed to translate desc address.\n");
+out:
+	if (ret) {
+		task->req = NULL;
+		while (descriptor_has_next(&c))
+			descriptor_get_next(&c);
+	}
+	/* the buffer id of a packed chain is in its last descriptor */
+	task->req_idx = packed ? c.id : idx;
+	task->nb_descs = c.nb_descs;
 }
 
 static struct vhost_block_dev *
@@ -192,77 +239,163 @@ vhost_scsi_bdev_construct(const char *bdev_name, const char *bdev_serial,
 	bdev->data = rte_zmalloc(NULL, blk_cnt * blk_size, 0);
 	if (!bdev->data) {
 		fprintf(stderr, "no enough reseverd huge memory for disk\n");
+		rte_free(bdev);
 		return NULL;
 	}
 
 	return bdev;
 }
 
-static void
-process_requestq(struct vhost_scsi_ctrlr *ctrlr, uint32_t q_idx)
+static inline bool
+desc_is_avail(uint16_t flags, bool wrap_counter)
 {
-	int ret;
-	struct vhost_scsi_queue *scsi_vq;
-	struct rte_vhost_vring *vq;
+	return wrap_counter == !!(flags & VRING_DESC_F_AVAIL) &&
+		wrap_counter != !!(flags & VRING_DESC_F_USED);
+}
 
-	scsi_vq = &ctrlr->bdev->queues[q_idx];
-	vq = &scsi_vq->vq;
-	ret = rte_vhost_get_vhost_vring(ctrlr->bdev->vid, q_idx, vq);
-	assert(ret == 0);
-
-	while (vq->avail->idx != scsi_vq->last_used_idx) {
-		int req_idx;
-		uint16_t last_idx;
-		struct vhost_scsi_task *task;
-		uint64_t chunck_len;
-
-		last_idx = scsi_vq->last_used_idx & (vq->size - 1);
-		req_idx = vq->avail->ring[last_idx];
-
-		task = rte_zmalloc(NULL, sizeof(*task), 0);
-		assert(task != NULL);
-
-		task->ctrlr = ctrlr;
-		task->bdev = ctrlr->bdev;
-		task->vq = vq;
-		task->req_idx = req_idx;
-		task->desc = &task->vq->desc[task->req_idx];
-
-		/* does not support indirect descriptors */
-		assert((task->desc->flags & VRING_DESC_F_INDIRECT) == 0);
-		scsi_vq->last_used_idx++;
-
-		chunck_len = task->desc->len;
-		task->req = (void *)(uintptr_t)gpa_to_vva(task->bdev->vid,
-							  task->desc->addr,
-							  &chunck_len);
-		if (!task->req || chunck_len != task->desc->len) {
-			fprintf(stderr, "failed to translate desc address.\n");
-			return;
+static uint16_t
+fetch_requests_split(struct vhost_scsi_queue *q)
+{
+	struct rte_vhost_vring *vq = &q->vq;
+	uint16_t avail_idx, nb_reqs, i;
+
+	avail_idx = *(volatile uint16_t *)&vq->avail->idx;
+	nb_reqs = RTE_MIN((uint16_t)(avail_idx - q->last_avail_idx),
+			  (uint16_t)VHOST_SCSI_BURST);
+	if (nb_reqs == 0)
+		return 0;
+
+	/* read the ring entries after the index */
+	rte_smp_rmb();
+
+	for (i = 0; i < nb_reqs; i++)
+		vhost_scsi_task_init(&q->tasks[i], q, false,
+			vq->avail->ring[(q->last_avail_idx + i) &
+					(vq->size - 1)]);
+	q->last_avail_idx += nb_reqs;
+
+	return nb_reqs;
+}
+
+static uint16_t
+fetch_requests_packed(struct vhost_scsi_queue *q)
+{
+	struct rte_vhost_vring *vq = &q->vq;
+	struct vhost_scsi_task *task;
+	uint16_t flags, nb_reqs;
+
+	for (nb_reqs = 0; nb_reqs < VHOST_SCSI_BURST; nb_reqs++) {
+		flags = *(volatile uint16_t *)
+			&vq->desc_packed[q->last_avail_idx].flags;
+		if (!desc_is_avail(flags, q->avail_wrap_counter))
+			break;
+
+		/* read the chain after its head flags */
+		rte_smp_rmb();
+
+		task = &q->tasks[nb_reqs];
+		vhost_scsi_task_init(task, q, true, q->last_avail_idx);
+		q->last_avail_idx += task->nb_descs;
+		if (q->last_avail_idx >= vq->size) {
+			q->last_avail_idx -= vq->size;
+			q->avail_wrap_counter ^= 1;
 		}
+	}
 
-		task->desc = descriptor_get_next(task->vq->desc, task->desc);
-		if (!descriptor_has_next(task->desc)) {
-			task->dxfer_dir = SCSI_DIR_NONE;
-			chunck_len = task->desc->len;
-			task->resp = (void *)(uintptr_t)
-					      gpa_to_vva(task->bdev->vid,
-							 task->desc->addr,
-							 &chunck_len);
-			if (!task->resp || chunck_len != task->desc->len) {
-				fprintf(stderr, "failed to translate desc address.\n");
-				return;
-			}
-		} else if (!descriptor_is_wr(task->desc)) {
-			task->dxfer_dir = SCSI_DIR_TO_DEV;
-			vhost_process_write_payload_chain(task);
-		} else {
-			task->dxfer_dir = SCSI_DIR_FROM_DEV;
-			vhost_process_read_payload_chain(task);
+	return nb_reqs;
+}
+
+static void
+submit_completions_split(struct vhost_scsi_queue *q, uint16_t nb_reqs)
+{
+	struct rte_vhost_vring *vq = &q->vq;
+	struct vring_used_elem *elem;
+	uint16_t i;
+
+	/* Fill out the next entries in the "used" ring. id = the
+	 * index of the descriptor that contained the SCSI request.
+	 * len = the total amount of data transferred for the SCSI
+	 * request. We must report the correct len, for variable
+	 * length SCSI CDBs, where we may return less data than
+	 * allocated by the guest VM.
+	 */
+	for (i = 0; i < nb_reqs; i++) {
+		elem = &vq->used->ring[(q->last_used_idx + i) &
+				       (vq->size - 1)];
+		elem->id = q->tasks[i].req_idx;
+		elem->len = q->tasks[i].data_len;
+	}
+	q->last_used_idx += nb_reqs;
+
+	/* publish the entries before the index */
+	rte_smp_wmb();
+	*(volatile uint16_t *)&vq->used->idx = q->last_used_idx;
+}
+
+static void
+submit_completions_packed(struct vhost_scsi_queue *q, uint16_t nb_reqs)
+{
+	struct rte_vhost_vring *vq = &q->vq;
+	struct vring_packed_desc *desc;
+	uint16_t used_idx[VHOST_SCSI_BURST];
+	uint16_t flags[VHOST_SCSI_BURST];
+	uint16_t i;
+
+	for (i = 0; i < nb_reqs; i++) {
+		used_idx[i] = q->last_used_idx;
+		flags[i] = q->used_wrap_counter ?
+			VRING_DESC_F_AVAIL | VRING_DESC_F_USED : 0;
+		if (q->tasks[i].data_len)
+			flags[i] |= VRING_DESC_F_WRITE;
+
+		desc = &vq->desc_packed[used_idx[i]];
+		desc->id = q->tasks[i].req_idx;
+		desc->len = q->tasks[i].data_len;
+
+		q->last_used_idx += q->tasks[i].nb_descs;
+		if (q->last_used_idx >= vq->size) {
+			q->last_used_idx -= vq->size;
+			q->used_wrap_counter ^= 1;
 		}
+	}
+
+	/*
+	 * The driver stops at the first descriptor not used, so the head
+	 * flags are written last to make the whole batch used at once.
+	 */
+	rte_smp_wmb();
+	for (i = 1; i < nb_reqs; i++)
+		vq->desc_packed[used_idx[i]].flags = flags[i];
+	rte_smp_wmb();
+	vq->desc_packed[used_idx[0]].flags = flags[0];
+}
 
-		ret = vhost_bdev_process_scsi_commands(ctrlr->bdev, task);
-		if (ret) {
+/*
+ * Process a burst of requests: fetch the descriptor chains, run the SCSI
+ * commands, then complete them all with a single guest notification.
+ */
+static uint16_t
+process_requestq(struct vhost_scsi_ctrlr *ctrlr, uint32_t q_idx)
+{
+	struct vhost_block_dev *bdev = ctrlr->bdev;
+	struct vhost_scsi_queue *scsi_vq;
+	struct vhost_scsi_task *task;
+	uint16_t nb_reqs, i;
+
+	scsi_vq = &bdev->queues[q_idx];
+	if (bdev->packed_ring)
+		nb_reqs = fetch_requests_packed(scsi_vq);
+	else
+		nb_reqs = fetch_requests_split(scsi_vq);
+	if (nb_reqs == 0)
+		return 0;
+
+	for (i = 0; i < nb_reqs; i++) {
+		task = &scsi_vq->tasks[i];
+		if (!task->resp)
+			continue;
+		if (!task->req ||
+		    vhost_bdev_process_scsi_commands(bdev, task)) {
 			/* invalid response */
 			task->resp->response = VIRTIO_SCSI_S_BAD_TARGET;
 		} else {
@@ -271,45 +404,80 @@ process_requestq(struct vhost_scsi_ctrlr *ctrlr, uint32_t q_idx)
 			task->resp->status = 0;
 			task->resp->resid = 0;
 		}
-		submit_completion(task, q_idx);
-		rte_free(task);
 	}
+
+	if (bdev->packed_ring)
+		submit_completions_packed(scsi_vq, nb_reqs);
+	else
+		submit_completions_split(scsi_vq, nb_reqs);
+
+	/* Send an interrupt back to the guest VM so that it knows
+	 * completions are ready to be processed.
+	 */
+	rte_vhost_vring_call(bdev->vid, q_idx);
+
+	return nb_reqs;
 }
 
+/*
+ * The request queues are spread over the lcores: request queue n is
+ * polled by the worker n modulo the number of workers. A worker only
+ * touches the device between setting and clearing its busy flag, which
+ * destroy_device() waits for once it cleared started.
+ */
+struct ctrlr_worker {
+	volatile int busy;
+	unsigned int idx;
+} __rte_cache_aligned;
+
+static struct ctrlr_worker workers[RTE_MAX_LCORE];
+static unsigned int nb_workers;
+
 /* Main framework for processing IOs */
-static void *
-ctrlr_worker(void *arg)
+static int
+ctrlr_worker(void *arg __rte_unused)
 {
+	struct vhost_scsi_ctrlr *ctrlr = g_vhost_ctrlr;
+	struct ctrlr_worker *worker = &workers[rte_lcore_id()];
 	uint32_t idx, num;
-	struct vhost_scsi_ctrlr *ctrlr = (struct vhost_scsi_ctrlr *)arg;
-	cpu_set_t cpuset;
-	pthread_t thread;
-
-	thread = pthread_self();
-	CPU_ZERO(&cpuset);
-	CPU_SET(0, &cpuset);
-	pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
 
-	num =  rte_vhost_get_vring_num(ctrlr->bdev->vid);
-	fprintf(stdout, "Ctrlr Worker Thread Started with %u Vring\n", num);
+	fprintf(stdout, "Ctrlr Worker %u Started on lcore %u\n",
+		worker->idx, rte_lcore_id());
 
-	if (num != NUM_OF_SCSI_QUEUES) {
-		fprintf(stderr, "Only 1 IO queue are supported\n");
-		exit(0);
-	}
+	while (1) {
+		worker->busy = 1;
+		rte_smp_mb();
+		if (!ctrlr->started) {
+			worker->busy = 0;
+			rte_pause();
+			continue;
+		}
 
-	while (!g_should_stop && ctrlr->bdev != NULL) {
-		/* At least 3 vrings, currently only can support 1 IO queue
-		 * Queue 2 for IO queue, does not support TMF and hotplug
-		 * for the example application now
+		/* Queue 0 and 1 are the control and event queues, which
+		 * are not processed: does not support TMF and hotplug for
+		 * the example application now
 		 */
-		for (idx = 2; idx < num; idx++)
+		num = ctrlr->bdev->nb_queues;
+		for (idx = VHOST_SCSI_FIRST_REQ_QUEUE + worker->idx; idx < num;
+		     idx += nb_workers)
 			process_requestq(ctrlr, idx);
+
+		rte_smp_mb();
+		worker->busy = 0;
 	}
 
-	fprintf(stdout, "Ctrlr Worker Thread Exiting\n");
-	sem_post(&exit_sem);
-	return NULL;
+	return 0;
+}
+
+static void
+vhost_scsi_bdev_destroy(struct vhost_block_dev *bdev)
+{
+	uint32_t i;
+
+	for (i = 0; i < VHOST_SCSI_MAX_QUEUES; i++)
+		rte_free(bdev->queues[i].tasks);
+	rte_free(bdev->data);
+	rte_free(bdev);
 }
 
 static int
@@ -317,10 +485,12 @@ new_device(int vid)
 {
 	char path[PATH_MAX];
 	struct vhost_scsi_ctrlr *ctrlr;
+	struct vhost_block_dev *bdev;
 	struct vhost_scsi_queue *scsi_vq;
 	struct rte_vhost_vring *vq;
-	pthread_t tid;
-	int i, ret;
+	uint64_t features;
+	uint32_t i, num;
+	int ret;
 
 	ret = rte_vhost_get_ifname(vid, path, PATH_MAX);
 	if (ret) {
@@ -334,6 +504,18 @@ new_device(int vid)
 		return -1;
 	}
 
+	num = rte_vhost_get_vring_num(vid);
+	if (num <= VHOST_SCSI_FIRST_REQ_QUEUE || num > VHOST_SCSI_MAX_QUEUES) {
+		fprintf(stderr, "%u vrings, 1 to %u IO queues are supported\n",
+			num, VHOST_SCSI_MAX_REQ_QUEUES);
+		return -1;
+	}
+
+	if (rte_vhost_get_negotiated_features(vid, &features)) {
+		fprintf(stderr, "Cannot get negotiated features\n");
+		return -1;
+	}
+
 	ret = rte_vhost_get_mem_table(vid, &ctrlr->mem);
 	if (ret) {
 		fprintf(stderr, "Get Controller memory region failed\n");
@@ -342,33 +524,61 @@ new_device(int vid)
 	assert(ctrlr->mem != NULL);
 
 	/* hardcoded block device information with 128MiB */
-	ctrlr->bdev = vhost_scsi_bdev_construct("malloc0", "vhost_scsi_malloc0",
-						4096, 32768, 0);
-	if (!ctrlr->bdev)
-		return -1;
+	bdev = vhost_scsi_bdev_construct("malloc0", "vhost_scsi_malloc0",
+					 4096, 32768, 0);
+	if (!bdev)
+		goto err;
 
-	ctrlr->bdev->vid = vid;
+	bdev->vid = vid;
+	bdev->nb_queues = num;
+	bdev->packed_ring = !!(features & (1ULL << VIRTIO_F_RING_PACKED));
 
 	/* Disable Notifications */
-	for (i = 0; i < NUM_OF_SCSI_QUEUES; i++) {
+	for (i = 0; i < num; i++) {
 		rte_vhost_enable_guest_notification(vid, i, 0);
-		/* restore used index */
-		scsi_vq = &ctrlr->bdev->queues[i];
+		scsi_vq = &bdev->queues[i];
 		vq = &scsi_vq->vq;
-		ret = rte_vhost_get_vhost_vring(ctrlr->bdev->vid, i, vq);
+		ret = rte_vhost_get_vhost_vring(vid, i, vq);
 		assert(ret == 0);
-		scsi_vq->last_used_idx = vq->used->idx;
-		scsi_vq->last_avail_idx = vq->used->idx;
+		if (bdev->packed_ring) {
+			scsi_vq->last_used_idx = 0;
+			scsi_vq->last_avail_idx = 0;
+			scsi_vq->used_wrap_counter = true;
+			scsi_vq->avail_wrap_counter = true;
+		} else {
+			/* restore used index */
+			scsi_vq->last_used_idx = vq->used->idx;
+			scsi_vq->last_avail_idx = vq->used->idx;
+		}
+		if (i < VHOST_SCSI_FIRST_REQ_QUEUE)
+			continue;
+
+		scsi_vq->tasks = rte_zmalloc(NULL, VHOST_SCSI_BURST *
+					     sizeof(*scsi_vq->tasks),
+					     RTE_CACHE_LINE_SIZE);
+		if (!scsi_vq->tasks) {
+			vhost_scsi_bdev_destroy(bdev);
+			goto err;
+		}
+		for (ret = 0; ret < VHOST_SCSI_BURST; ret++) {
+			scsi_vq->tasks[ret].ctrlr = ctrlr;
+			scsi_vq->tasks[ret].bdev = bdev;
+		}
 	}
 
-	g_should_stop = 0;
-	fprintf(stdout, "New Device %s, Device ID %d\n", path, vid);
-	if (pthread_create(&tid, NULL, &ctrlr_worker, ctrlr) < 0) {
-		fprintf(stderr, "Worker Thread Started Failed\n");
-		return -1;
-	}
-	pthread_detach(tid);
+	ctrlr->bdev = bdev;
+	rte_smp_wmb();
+	ctrlr->started = 1;
+
+	fprintf(stdout, "New Device %s, Device ID %d, %u IO queues%s\n",
+		path, vid, num - VHOST_SCSI_FIRST_REQ_QUEUE,
+		bdev->packed_ring ? ", packed ring" : "");
 	return 0;
+
+err:
+	free(ctrlr->mem);
+	ctrlr->mem = NULL;
+	return -1;
 }
 
 static void
@@ -376,18 +586,28 @@ destroy_device(int vid)
 {
 	char path[PATH_MAX];
 	struct vhost_scsi_ctrlr *ctrlr;
+	unsigned int lcore_id;
 
 	rte_vhost_get_ifname(vid, path, PATH_MAX);
 	fprintf(stdout, "Destroy %s Device ID %d\n", path, vid);
 	ctrlr = vhost_scsi_ctrlr_find(path);
-	if (!ctrlr) {
+	if (!ctrlr || !ctrlr->bdev) {
 		fprintf(stderr, "Destroy Ctrlr Failed\n");
 		return;
 	}
-	ctrlr->bdev = NULL;
-	g_should_stop = 1;
 
-	sem_wait(&exit_sem);
+	/* wait for the workers to leave the device */
+	ctrlr->started = 0;
+	rte_smp_mb();
+	RTE_LCORE_FOREACH(lcore_id) {
+		while (workers[lcore_id].busy)
+			rte_pause();
+	}
+
+	vhost_scsi_bdev_destroy(ctrlr->bdev);
+	ctrlr->bdev = NULL;
+	free(ctrlr->mem);
+	ctrlr->mem = NULL;
 }
 
 static const struct vhost_device_ops vhost_scsi_device_ops = {
@@ -451,6 +671,7 @@ signal_handler(__rte_unused int signum)
 
 int main(int argc, char *argv[])
 {
+	unsigned int lcore_id;
 	int ret;
 
 	signal(SIGINT, signal_handler);
@@ -466,16 +687,13 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
-	if (sem_init(&exit_sem, 0, 0) < 0) {
-		fprintf(stderr, "Error init exit_sem\n");
-		return -1;
-	}
-
 	rte_vhost_driver_start(dev_pathname);
 
-	/* loop for exit the application */
-	while (1)
-		sleep(1);
+	/* every lcore, the master one included, polls request queues */
+	RTE_LCORE_FOREACH(lcore_id)
+		workers[lcore_id].idx = nb_workers++;
+	rte_eal_mp_remote_launch(ctrlr_worker, NULL, CALL_MASTER);
+	rte_eal_mp_wait_lcore();
 
 	return 0;
 }
@@ -7,24 +7,42 @@
 
 #include <sys/uio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <linux/virtio_scsi.h>
 #include <linux/virtio_ring.h>
 
 #include <rte_vhost.h>
 
+/* Request queue descriptor chains fetched and completed at once */
+#define VHOST_SCSI_BURST 32
+
+struct vhost_scsi_task;
+
 struct vhost_scsi_queue {
 	struct rte_vhost_vring vq;
 	uint16_t last_avail_idx;
 	uint16_t last_used_idx;
+	/* packed ring wrap counters */
+	bool avail_wrap_counter;
+	bool used_wrap_counter;
+	struct vhost_scsi_task *tasks;
 };
 
-#define NUM_OF_SCSI_QUEUES 3
+/* Control queue, event queue, then the request queues */
+#define VHOST_SCSI_FIRST_REQ_QUEUE 2
+#define VHOST_SCSI_MAX_REQ_QUEUES 16
+#define VHOST_SCSI_MAX_QUEUES \
+	(VHOST_SCSI_FIRST_REQ_QUEUE + VHOST_SCSI_MAX_REQ_QUEUES)
 
 struct vhost_block_dev {
 	/** ID for vhost library. */
 	int vid;
 	/** Queues for the block device */
-	struct vhost_scsi_queue queues[NUM_OF_SCSI_QUEUES];
+	struct vhost_scsi_queue queues[VHOST_SCSI_MAX_QUEUES];
+	/** Number of vrings negotiated */
+	uint32_t nb_queues;
+	/** Packed virtqueues negotiated */
+	bool packed_ring;
 	/** Unique name for this block device. */
 	char name[64];
 
@@ -49,6 +67,8 @@ struct vhost_scsi_ctrlr {
 	struct vhost_block_dev *bdev;
 	/** VM memory region */
 	struct rte_vhost_memory *mem;
+	/** Set once the device is ready for the workers */
+	volatile int started;
 } __rte_cache_aligned;
 
 #define VHOST_SCSI_MAX_IOVS 128
@@ -60,15 +80,16 @@ enum scsi_data_dir {
 };
 
 struct vhost_scsi_task {
-	int req_idx;
+	/** Head index of a split chain, or buffer id of a packed one */
+	uint16_t req_idx;
+	/** Number of ring descriptors of a packed chain */
+	uint16_t nb_descs;
 	uint32_t dxfer_dir;
 	uint32_t data_len;
 	struct virtio_scsi_cmd_req *req;
 	struct virtio_scsi_cmd_resp *resp;
 	struct iovec iovs[VHOST_SCSI_MAX_IOVS];
 	uint32_t iovs_cnt;
-	struct vring_desc *desc;
-	struct rte_vhost_vring *vq;
 	struct vhost_block_dev *bdev;
 	struct vhost_scsi_ctrlr *ctrlr;
 };
@@ -71,6 +71,9 @@
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 19, 0)
 #define HAVE_IOV_ITER_MSGHDR
+#define HAVE_NAPI_ALLOC_SKB
+#else
+#define napi_complete_done(n, work) napi_complete(n)
 #endif
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 1, 0)
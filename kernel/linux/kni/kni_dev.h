@@ -32,6 +32,9 @@
 /* Default carrier state for created KNI network interfaces */
 extern uint32_t dflt_carrier;
 
+/* Packets given to the kernel from NAPI polls instead of kernel threads */
+extern uint32_t napi_on;
+
 /**
  * A structure describing the private information for a kni device.
  */
@@ -88,6 +91,9 @@ struct kni_dev {
 	/* synchro for request processing */
 	unsigned long synchro;
 
+	/* NAPI context of the received packets, when napi_on */
+	struct napi_struct napi;
+
 	/* buffers */
 	void *pa[MBUF_BURST_SZ];
 	void *va[MBUF_BURST_SZ];
@@ -43,6 +43,10 @@ static uint32_t multiple_kthread_on;
 static char *carrier;
 uint32_t dflt_carrier;
 
+/* NAPI mode */
+static char *napi;
+uint32_t napi_on;
+
 #define KNI_DEV_IN_USE_BIT_NUM 0 /* Bit number for device in use */
 
 static int kni_net_id;
@@ -527,6 +531,55 @@ kni_ioctl_release(struct net *net, uint32_t ioctl_num,
 	return ret;
 }
 
+static int
+kni_ioctl_affinity(struct net *net, uint32_t ioctl_num,
+		unsigned long ioctl_param)
+{
+	struct kni_net *knet = net_generic(net, kni_net_id);
+	int ret = -EINVAL;
+	struct kni_dev *dev, *n;
+	struct rte_kni_device_info dev_info;
+	struct task_struct *task;
+	const struct cpumask *mask;
+
+	if (_IOC_SIZE(ioctl_num) > sizeof(dev_info))
+		return -EINVAL;
+
+	ret = copy_from_user(&dev_info, (void *)ioctl_param, sizeof(dev_info));
+	if (ret) {
+		pr_err("copy_from_user in kni_ioctl_affinity");
+		return -EIO;
+	}
+
+	if (dev_info.force_bind && !cpu_online(dev_info.core_id)) {
+		pr_err("cpu %u is not online\n", dev_info.core_id);
+		return -EINVAL;
+	}
+
+	/* Without binding, the kernel thread may run on any CPU */
+	mask = dev_info.force_bind ? cpumask_of(dev_info.core_id) :
+		cpu_possible_mask;
+
+	ret = -ENODEV;
+	mutex_lock(&knet->kni_kthread_lock);
+	down_read(&knet->kni_list_lock);
+	list_for_each_entry_safe(dev, n, &knet->kni_list_head, list) {
+		if (strncmp(dev->name, dev_info.name, RTE_KNI_NAMESIZE) != 0)
+			continue;
+
+		/* In single mode, the thread of all the devices is moved */
+		task = multiple_kthread_on ? dev->pthread : knet->kni_kthread;
+		ret = (task != NULL) ? set_cpus_allowed_ptr(task, mask) : 0;
+		if (ret == 0)
+			dev->core_id = dev_info.core_id;
+		break;
+	}
+	up_read(&knet->kni_list_lock);
+	mutex_unlock(&knet->kni_kthread_lock);
+
+	return ret;
+}
+
 static int
 kni_ioctl(struct inode *inode, uint32_t ioctl_num, unsigned long ioctl_param)
 {
@@ -548,6 +601,9 @@ kni_ioctl(struct inode *inode, uint32_t ioctl_num, unsigned long ioctl_param)
 	case _IOC_NR(RTE_KNI_IOCTL_RELEASE):
 		ret = kni_ioctl_release(net, ioctl_num, ioctl_param);
 		break;
+	case _IOC_NR(RTE_KNI_IOCTL_AFFINITY):
+		ret = kni_ioctl_affinity(net, ioctl_num, ioctl_param);
+		break;
 	default:
 		pr_debug("IOCTL default\n");
 		break;
@@ -614,6 +670,24 @@ kni_parse_carrier_state(void)
 	return 0;
 }
 
+static int __init
+kni_parse_napi_state(void)
+{
+	if (!napi) {
+		napi_on = 0;
+		return 0;
+	}
+
+	if (strcmp(napi, "off") == 0)
+		napi_on = 0;
+	else if (strcmp(napi, "on") == 0)
+		napi_on = 1;
+	else
+		return -1;
+
+	return 0;
+}
+
 static int __init
 kni_init(void)
 {
@@ -639,6 +713,11 @@ kni_init(void)
 	else
 		pr_debug("Default carrier state set to on.\n");
 
+	if (kni_parse_napi_state() < 0) {
+		pr_err("Invalid parameter for napi\n");
+		return -EINVAL;
+	}
+
 #ifdef HAVE_SIMPLIFIED_PERNET_OPERATIONS
 	rc = register_pernet_subsys(&kni_net_ops);
 #else
@@ -656,6 +735,9 @@ kni_init(void)
 	/* Configure the lo mode according to the input parameter */
 	kni_net_config_lo_mode(lo_mode);
 
+	if (napi_on)
+		pr_debug("NAPI mode enabled\n");
+
 	return 0;
 
 out:
@@ -698,6 +780,15 @@ MODULE_PARM_DESC(kthread_mode,
 "\t\t"
 );
 
+module_param(napi, charp, 0644);
+MODULE_PARM_DESC(napi,
+"NAPI mode, not available with loopback (default=off):\n"
+"\t\toff   Packets given to the kernel by the KNI kernel threads.\n"
+"\t\ton    Packets given to the kernel by NAPI polls with GRO,\n"
+"\t\t      scheduled by the KNI kernel threads.\n"
+"\t\t"
+);
+
 module_param(carrier, charp, 0644);
 MODULE_PARM_DESC(carrier,
 "Default carrier state for KNI interface (default=off):\n"
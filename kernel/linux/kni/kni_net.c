@@ -14,6 +14,7 @@
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h> /* eth_type_trans */
 #include <linux/skbuff.h>
+#include <linux/prefetch.h>
 #include <linux/kthread.h>
 #include <linux/delay.h>
 
@@ -132,6 +133,9 @@ kni_net_open(struct net_device *dev)
 	struct rte_kni_request req;
 	struct kni_dev *kni = netdev_priv(dev);
 
+	if (napi_on)
+		napi_enable(&kni->napi);
+
 	netif_start_queue(dev);
 	if (dflt_carrier == 1)
 		netif_carrier_on(dev);
@@ -158,6 +162,9 @@ kni_net_release(struct net_device *dev)
 	netif_stop_queue(dev); /* can't transmit any more */
 	netif_carrier_off(dev);
 
+	if (napi_on)
+		napi_disable(&kni->napi);
+
 	memset(&req, 0, sizeof(req));
 	req.req_id = RTE_KNI_REQ_CFG_NETWORK_IF;
 
@@ -305,14 +312,17 @@ kni_net_tx(struct sk_buff *skb, struct net_device *dev)
 }
 
 /*
- * RX: normal working mode
+ * RX: burst of up to num_max packets from rx_q, given to netif, or to GRO
+ * when called from the NAPI poll. Returns the number of packets dequeued.
  */
-static void
-kni_net_rx_normal(struct kni_dev *kni)
+static uint32_t
+kni_net_rx_burst(struct kni_dev *kni, uint32_t num_max,
+		struct napi_struct *napi)
 {
 	uint32_t ret;
 	uint32_t len;
 	uint32_t i, num_rx, num_fq;
+	uint32_t rx_bytes = 0, rx_packets = 0;
 	struct rte_kni_mbuf *kva;
 	void *data_kva;
 	struct sk_buff *skb;
@@ -322,16 +332,24 @@ kni_net_rx_normal(struct kni_dev *kni)
 	num_fq = kni_fifo_free_count(kni->free_q);
 	if (num_fq == 0) {
 		/* No room on the free_q, bail out */
-		return;
+		return 0;
 	}
 
 	/* Calculate the number of entries to dequeue from rx_q */
-	num_rx = min_t(uint32_t, num_fq, MBUF_BURST_SZ);
+	num_rx = min_t(uint32_t, num_fq, num_max);
 
 	/* Burst dequeue from rx_q */
 	num_rx = kni_fifo_get(kni->rx_q, kni->pa, num_rx);
 	if (num_rx == 0)
-		return;
+		return 0;
+
+	/*
+	 * Out of NAPI, the packets are queued to the backlog of the CPU and
+	 * the stack processes the whole burst once the bottom halves are
+	 * enabled again, instead of once per packet as with netif_rx_ni().
+	 */
+	if (!napi)
+		local_bh_disable();
 
 	/* Transfer received packets to netif */
 	for (i = 0; i < num_rx; i++) {
@@ -340,16 +358,23 @@ kni_net_rx_normal(struct kni_dev *kni)
 		data_kva = kva2data_kva(kva);
 		kni->va[i] = pa2va(kni->pa[i], kva);
 
-		skb = dev_alloc_skb(len + 2);
+		/* Fetch the next mbuf while copying this one */
+		if (i + 1 < num_rx)
+			prefetch(pa2kva(kni->pa[i + 1]));
+
+#ifdef HAVE_NAPI_ALLOC_SKB
+		/* Taken from the per CPU page fragment cache of NAPI */
+		skb = napi ? napi_alloc_skb(napi, len) :
+			netdev_alloc_skb_ip_align(dev, len);
+#else
+		skb = netdev_alloc_skb_ip_align(dev, len);
+#endif
 		if (!skb) {
 			/* Update statistics */
 			kni->stats.rx_dropped++;
 			continue;
 		}
 
-		/* Align IP on 16B boundary */
-		skb_reserve(skb, 2);
-
 		if (kva->nb_segs == 1) {
 			memcpy(skb_put(skb, len), data_kva, len);
 		} else {
@@ -373,18 +398,79 @@ kni_net_rx_normal(struct kni_dev *kni)
 		skb->ip_summed = CHECKSUM_UNNECESSARY;
 
 		/* Call netif interface */
-		netif_rx_ni(skb);
+		if (napi)
+			napi_gro_receive(napi, skb);
+		else
+			netif_rx(skb);
 
-		/* Update statistics */
-		kni->stats.rx_bytes += len;
-		kni->stats.rx_packets++;
+		rx_bytes += len;
+		rx_packets++;
 	}
 
+	if (!napi)
+		local_bh_enable();
+
+	/* Update statistics */
+	kni->stats.rx_bytes += rx_bytes;
+	kni->stats.rx_packets += rx_packets;
+
 	/* Burst enqueue mbufs into free_q */
 	ret = kni_fifo_put(kni->free_q, kni->va, num_rx);
 	if (ret != num_rx)
 		/* Failing should not happen */
 		pr_err("Fail to enqueue entries into free_q\n");
+
+	return num_rx;
+}
+
+/*
+ * RX: normal working mode
+ */
+static void
+kni_net_rx_normal(struct kni_dev *kni)
+{
+	kni_net_rx_burst(kni, MBUF_BURST_SZ, NULL);
+}
+
+/*
+ * RX: NAPI mode, the kernel thread only schedules the NAPI poll of the
+ * devices with pending packets, which runs on the CPU of the thread when
+ * the bottom halves are enabled again.
+ */
+static void
+kni_net_rx_napi(struct kni_dev *kni)
+{
+	if (kni_fifo_count(kni->rx_q) == 0)
+		return;
+
+	local_bh_disable();
+	napi_schedule(&kni->napi);
+	local_bh_enable();
+}
+
+/*
+ * NAPI poll: sweeps rx_q by bursts within the budget. The kernel thread
+ * schedules the poll again for the packets enqueued after its completion.
+ */
+static int
+kni_net_poll(struct napi_struct *napi, int budget)
+{
+	struct kni_dev *kni = container_of(napi, struct kni_dev, napi);
+	uint32_t num;
+	int work = 0;
+
+	while (work < budget) {
+		num = kni_net_rx_burst(kni,
+			min_t(uint32_t, budget - work, MBUF_BURST_SZ), napi);
+		if (num == 0)
+			break;
+		work += num;
+	}
+
+	if (work < budget)
+		napi_complete_done(napi, work);
+
+	return work;
 }
 
 /*
@@ -779,17 +865,18 @@ kni_net_init(struct net_device *dev)
 	dev->netdev_ops      = &kni_net_netdev_ops;
 	dev->header_ops      = &kni_net_header_ops;
 	dev->watchdog_timeo = WD_TIMEOUT;
+
+	/* Deleted by free_netdev() */
+	if (napi_on)
+		netif_napi_add(dev, &kni->napi, kni_net_poll, NAPI_POLL_WEIGHT);
 }
 
 void
 kni_net_config_lo_mode(char *lo_str)
 {
-	if (!lo_str) {
+	if (!lo_str)
 		pr_debug("loopback disabled");
-		return;
-	}
-
-	if (!strcmp(lo_str, "lo_mode_none"))
+	else if (!strcmp(lo_str, "lo_mode_none"))
 		pr_debug("loopback disabled");
 	else if (!strcmp(lo_str, "lo_mode_fifo")) {
 		pr_debug("loopback mode=lo_mode_fifo enabled");
@@ -799,4 +886,12 @@ kni_net_config_lo_mode(char *lo_str)
 		kni_net_rx_func = kni_net_rx_lo_fifo_skb;
 	} else
 		pr_debug("Incognizant parameter, loopback disabled");
+
+	/* The loopback modes don't give the packets to the kernel stack */
+	if (kni_net_rx_func != kni_net_rx_normal) {
+		if (napi_on)
+			pr_debug("NAPI disabled in loopback mode");
+		napi_on = 0;
+	} else if (napi_on)
+		kni_net_rx_func = kni_net_rx_napi;
 }
@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include "acl_run_sse.h"
+
+/* number of flows held by one ZMM register */
+#define ZMM_FLOWS	16
+
+/*
+ * Process 16 transitions in parallel.
+ * tr_lo contains low 32 bits for 16 transitions.
+ * tr_hi contains high 32 bits for 16 transitions.
+ * next_input contains up to 4 input bytes for 16 flows.
+ * Same address calculation as ACL_TR_CALC_ADDR(), using the AVX512
+ * mask registers instead of the byte blends.
+ */
+static __rte_always_inline __m512i
+transition16(__m512i next_input, const uint64_t *trans, __m512i *tr_lo,
+	__m512i *tr_hi)
+{
+	const int32_t *tr;
+	__m512i addr, in, node_type, r, t, dfa_ofs, quad_ofs;
+	__mmask64 quad_msk;
+	__mmask16 dfa_msk;
+
+	tr = (const int32_t *)(uintptr_t)trans;
+
+	in = _mm512_shuffle_epi8(next_input,
+		_mm512_broadcast_i32x4(xmm_shuffle_input.x));
+
+	/* Calc node type and node addr */
+	node_type = _mm512_andnot_si512(
+		_mm512_set1_epi32(RTE_ACL_NODE_INDEX), *tr_lo);
+	addr = _mm512_and_si512(_mm512_set1_epi32(RTE_ACL_NODE_INDEX),
+		*tr_lo);
+
+	/* mask for DFA type(0) nodes */
+	dfa_msk = _mm512_testn_epi32_mask(node_type, node_type);
+
+	/* DFA calculations. */
+	r = _mm512_srli_epi32(in, 30);
+	r = _mm512_add_epi8(r, _mm512_broadcast_i32x4(xmm_range_base.x));
+	t = _mm512_srli_epi32(in, 24);
+	r = _mm512_shuffle_epi8(*tr_hi, r);
+
+	dfa_ofs = _mm512_sub_epi32(t, r);
+
+	/* QUAD/SINGLE calculations: count boundaries below the input. */
+	quad_msk = _mm512_cmpgt_epi8_mask(in, *tr_hi);
+	t = _mm512_maskz_mov_epi8(quad_msk, _mm512_set1_epi8(1));
+	t = _mm512_maddubs_epi16(t, _mm512_set1_epi8(1));
+	quad_ofs = _mm512_madd_epi16(t, _mm512_set1_epi16(1));
+
+	/* blend DFA and QUAD/SINGLE and calculate the next addresses. */
+	t = _mm512_mask_blend_epi32(dfa_msk, quad_ofs, dfa_ofs);
+	addr = _mm512_add_epi32(addr, t);
+
+	/* load lower 32 bits of 16 transactions at once. */
+	*tr_lo = _mm512_i32gather_epi32(addr, tr, sizeof(trans[0]));
+
+	next_input = _mm512_srli_epi32(next_input, CHAR_BIT);
+
+	/* load high 32 bits of 16 transactions at once. */
+	*tr_hi = _mm512_i32gather_epi32(addr, tr + 1, sizeof(trans[0]));
+
+	return next_input;
+}
+
+/*
+ * Check for matches in 16 flows, and fill the slots of the completed
+ * traversals with the next tries.
+ */
+static inline void
+acl_match_check_avx512x16(const struct rte_acl_ctx *ctx, struct parms *parms,
+	struct acl_flow_data *flows, uint32_t slot,
+	__m512i *tr_lo, __m512i *tr_hi)
+{
+	uint32_t lo[ZMM_FLOWS], hi[ZMM_FLOWS];
+	uint64_t tr;
+	uint32_t i, msk;
+
+	msk = _mm512_test_epi32_mask(*tr_lo,
+		_mm512_set1_epi32(RTE_ACL_NODE_MATCH));
+
+	while (msk != 0) {
+
+		_mm512_storeu_si512(lo, *tr_lo);
+		_mm512_storeu_si512(hi, *tr_hi);
+
+		do {
+			i = __builtin_ctz(msk);
+			msk &= msk - 1;
+
+			tr = (uint64_t)hi[i] << 32 | lo[i];
+			tr = acl_match_check(tr, slot + i, ctx, parms, flows,
+				resolve_priority_sse);
+			lo[i] = (uint32_t)tr;
+			hi[i] = (uint32_t)(tr >> 32);
+		} while (msk != 0);
+
+		*tr_lo = _mm512_loadu_si512(lo);
+		*tr_hi = _mm512_loadu_si512(hi);
+
+		/* the new tries may start on a match node */
+		msk = _mm512_test_epi32_mask(*tr_lo,
+			_mm512_set1_epi32(RTE_ACL_NODE_MATCH));
+	}
+}
+
+/*
+ * Execute trie traversal for up to 16 * num_zmm flows in parallel,
+ * each ZMM register holding the transitions of 16 flows.
+ */
+static __rte_always_inline int
+search_avx512(const struct rte_acl_ctx *ctx, const uint8_t **data,
+	uint32_t *results, uint32_t total_packets, uint32_t categories,
+	uint32_t num_zmm)
+{
+	uint32_t i, j, n;
+	struct acl_flow_data flows;
+	uint64_t index_array[MAX_SEARCHES_AVX512];
+	struct completion cmplt[MAX_SEARCHES_AVX512];
+	struct parms parms[MAX_SEARCHES_AVX512];
+	__m512i input[MAX_SEARCHES_AVX512 / ZMM_FLOWS];
+	__m512i tr_lo[MAX_SEARCHES_AVX512 / ZMM_FLOWS];
+	__m512i tr_hi[MAX_SEARCHES_AVX512 / ZMM_FLOWS];
+	__m512i t0, t1;
+	uint32_t in[ZMM_FLOWS];
+	const __m512i lo_idx = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18,
+		16, 14, 12, 10, 8, 6, 4, 2, 0);
+	const __m512i hi_idx = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19,
+		17, 15, 13, 11, 9, 7, 5, 3, 1);
+
+	acl_set_flow(&flows, cmplt, num_zmm * ZMM_FLOWS, data, results,
+		total_packets, categories, ctx->trans_table);
+
+	for (n = 0; n != num_zmm * ZMM_FLOWS; n++) {
+		cmplt[n].count = 0;
+		index_array[n] = acl_start_next_trie(&flows, parms, n, ctx);
+	}
+
+	/* For each transition: put low 32 into tr_lo and high 32 into tr_hi */
+	for (i = 0; i != num_zmm; i++) {
+		t0 = _mm512_loadu_si512(&index_array[i * ZMM_FLOWS]);
+		t1 = _mm512_loadu_si512(&index_array[i * ZMM_FLOWS +
+			ZMM_FLOWS / 2]);
+		tr_lo[i] = _mm512_permutex2var_epi32(t0, lo_idx, t1);
+		tr_hi[i] = _mm512_permutex2var_epi32(t0, hi_idx, t1);
+	}
+
+	 /* Check for any matches. */
+	for (i = 0; i != num_zmm; i++)
+		acl_match_check_avx512x16(ctx, parms, &flows, i * ZMM_FLOWS,
+			&tr_lo[i], &tr_hi[i]);
+
+	while (flows.started > 0) {
+
+		/* Gather 4 bytes of input data for each flow. */
+		for (i = 0; i != num_zmm; i++) {
+			for (j = 0; j != ZMM_FLOWS; j++)
+				in[j] = GET_NEXT_4BYTES(parms,
+					i * ZMM_FLOWS + j);
+			input[i] = _mm512_loadu_si512(in);
+		}
+
+		/* Process the 4 bytes of input on each flow. */
+		for (j = 0; j != sizeof(in[0]); j++) {
+			for (i = 0; i != num_zmm; i++)
+				input[i] = transition16(input[i], flows.trans,
+					&tr_lo[i], &tr_hi[i]);
+		}
+
+		 /* Check for any matches. */
+		for (i = 0; i != num_zmm; i++)
+			acl_match_check_avx512x16(ctx, parms, &flows,
+				i * ZMM_FLOWS, &tr_lo[i], &tr_hi[i]);
+	}
+
+	return 0;
+}
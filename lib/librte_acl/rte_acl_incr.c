@@ -0,0 +1,672 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <rte_acl.h>
+#include "rte_acl_incr.h"
+
+/* slot of a rule not in the main context */
+#define	ACL_INCR_NO_SLOT	UINT32_MAX
+
+/* number of packets classified at once against both contexts */
+#define	ACL_INCR_BURST		64
+
+/* rule of a built context, its userdata in the context being its slot + 1 */
+struct acl_incr_rule {
+	uint32_t userdata;
+	int32_t  priority;
+};
+
+/* main context, shared by the generations until the next merge */
+struct acl_incr_main {
+	struct rte_acl_ctx   *ctx;   /* NULL if no rule */
+	uint32_t              num;
+	struct acl_incr_rule *rules;
+	uint8_t              *data;  /* copies of the rules, for the deletes */
+};
+
+/* set of contexts used by the classification */
+struct acl_incr_gen {
+	struct acl_incr_gen  *next;         /* retired generations */
+	struct acl_incr_main *main;
+	struct rte_acl_ctx   *delta;        /* NULL if no rule */
+	uint32_t              delta_num;
+	struct acl_incr_rule *delta_rules;
+	int                   free_main;    /* last generation of main */
+	uint8_t               main_deleted[]; /* deleted main rules */
+};
+
+struct rte_acl_incr_ctx {
+	char                 name[RTE_ACL_NAMESIZE];
+	int32_t              socket_id;
+	uint32_t             rule_size;
+	uint32_t             max_rules;
+	uint32_t             num_rules;
+	uint32_t             ctx_id;    /* to name the ACL contexts */
+	struct rte_acl_config cfg;
+	uint8_t             *rules;     /* current rules */
+	uint32_t            *rule_slot; /* main slot of each current rule */
+	uint8_t             *rule_del;  /* rules being deleted */
+	struct acl_incr_gen *gen;       /* published generation */
+	struct acl_incr_gen *retired;
+};
+
+static inline const struct rte_acl_rule *
+acl_incr_get_rule(const struct rte_acl_incr_ctx *ictx, const uint8_t *rules,
+	uint32_t i)
+{
+	return (const struct rte_acl_rule *)(rules + (size_t)i *
+		ictx->rule_size);
+}
+
+static uint64_t
+acl_incr_field_value(const union rte_acl_field_types *v, uint8_t size)
+{
+	switch (size) {
+	case sizeof(uint8_t):
+		return v->u8;
+	case sizeof(uint16_t):
+		return v->u16;
+	case sizeof(uint32_t):
+		return v->u32;
+	default:
+		return v->u64;
+	}
+}
+
+/*
+ * Check whether some input may match both rules in a common category.
+ */
+static int
+acl_incr_rules_overlap(const struct rte_acl_config *cfg,
+	const struct rte_acl_rule *a, const struct rte_acl_rule *b)
+{
+	const struct rte_acl_field_def *def;
+	uint64_t va, vb, ma, mb, m;
+	uint32_t i, bits;
+
+	if ((a->data.category_mask & b->data.category_mask) == 0)
+		return 0;
+
+	for (i = 0; i != cfg->num_fields; i++) {
+		def = &cfg->defs[i];
+		va = acl_incr_field_value(&a->field[def->field_index].value,
+			def->size);
+		vb = acl_incr_field_value(&b->field[def->field_index].value,
+			def->size);
+		ma = acl_incr_field_value(
+			&a->field[def->field_index].mask_range, def->size);
+		mb = acl_incr_field_value(
+			&b->field[def->field_index].mask_range, def->size);
+
+		switch (def->type) {
+		case RTE_ACL_FIELD_TYPE_MASK:
+			/* prefixes: compare the bits of the shortest one */
+			bits = def->size * CHAR_BIT;
+			m = RTE_MIN(RTE_MIN(ma, mb), bits);
+			m = (m == 0) ? 0 :
+				(UINT64_MAX << (64 - m)) >> (64 - bits);
+			if (((va ^ vb) & m) != 0)
+				return 0;
+			break;
+		case RTE_ACL_FIELD_TYPE_RANGE:
+			if (va > mb || vb > ma)
+				return 0;
+			break;
+		default:
+			if (((va ^ vb) & ma & mb) != 0)
+				return 0;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ * Create and build an ACL context from a set of rules, the userdata of
+ * each rule in the context being its index + 1.
+ */
+static int
+acl_incr_ctx_build(struct rte_acl_incr_ctx *ictx,
+	const struct rte_acl_rule **rules, uint32_t num,
+	struct acl_incr_rule *info, struct rte_acl_ctx **pctx)
+{
+	char name[RTE_ACL_NAMESIZE];
+	struct rte_acl_param prm;
+	struct rte_acl_rule *r;
+	struct rte_acl_ctx *ctx;
+	uint8_t *buf;
+	uint32_t i;
+	int ret;
+
+	*pctx = NULL;
+	if (num == 0)
+		return 0;
+
+	buf = rte_malloc(NULL, (size_t)num * ictx->rule_size, 0);
+	if (buf == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i != num; i++) {
+		r = (struct rte_acl_rule *)(buf + (size_t)i * ictx->rule_size);
+		memcpy(r, rules[i], ictx->rule_size);
+		info[i].userdata = r->data.userdata;
+		info[i].priority = r->data.priority;
+		r->data.userdata = i + 1;
+	}
+
+	snprintf(name, sizeof(name), "%.*s_%u", RTE_ACL_NAMESIZE - 12,
+		ictx->name, ictx->ctx_id++);
+	prm.name = name;
+	prm.socket_id = ictx->socket_id;
+	prm.rule_size = ictx->rule_size;
+	prm.max_rule_num = num;
+
+	ctx = rte_acl_create(&prm);
+	if (ctx == NULL) {
+		ret = -ENOMEM;
+	} else {
+		ret = rte_acl_add_rules(ctx, (const struct rte_acl_rule *)buf,
+			num);
+		if (ret == 0)
+			ret = rte_acl_build(ctx, &ictx->cfg);
+		if (ret != 0)
+			rte_acl_free(ctx);
+		else
+			*pctx = ctx;
+	}
+
+	rte_free(buf);
+	return ret;
+}
+
+static void
+acl_incr_main_free(struct acl_incr_main *mc)
+{
+	rte_acl_free(mc->ctx);
+	rte_free(mc->rules);
+	rte_free(mc->data);
+	rte_free(mc);
+}
+
+/* build a main context from all the current rules */
+static int
+acl_incr_main_build(struct rte_acl_incr_ctx *ictx,
+	struct acl_incr_main **pmain)
+{
+	const struct rte_acl_rule **rules;
+	struct acl_incr_main *mc;
+	uint32_t i, n;
+	int ret;
+
+	n = ictx->num_rules;
+
+	mc = rte_zmalloc(NULL, sizeof(*mc), 0);
+	if (mc == NULL)
+		return -ENOMEM;
+
+	mc->rules = rte_malloc(NULL, sizeof(mc->rules[0]) * RTE_MAX(n, 1U),
+		0);
+	mc->data = rte_malloc(NULL, (size_t)RTE_MAX(n, 1U) * ictx->rule_size,
+		0);
+	rules = rte_malloc(NULL, sizeof(rules[0]) * RTE_MAX(n, 1U), 0);
+
+	if (mc->rules == NULL || mc->data == NULL || rules == NULL) {
+		ret = -ENOMEM;
+	} else {
+		memcpy(mc->data, ictx->rules, (size_t)n * ictx->rule_size);
+		for (i = 0; i != n; i++)
+			rules[i] = acl_incr_get_rule(ictx, mc->data, i);
+		mc->num = n;
+		ret = acl_incr_ctx_build(ictx, rules, n, mc->rules,
+			&mc->ctx);
+	}
+
+	rte_free(rules);
+
+	if (ret != 0) {
+		acl_incr_main_free(mc);
+		return ret;
+	}
+
+	*pmain = mc;
+	return 0;
+}
+
+static struct acl_incr_gen *
+acl_incr_gen_alloc(struct acl_incr_main *mc, const uint8_t *deleted)
+{
+	struct acl_incr_gen *gen;
+
+	gen = rte_zmalloc(NULL, sizeof(*gen) + mc->num, RTE_CACHE_LINE_SIZE);
+	if (gen == NULL)
+		return NULL;
+
+	gen->main = mc;
+	if (deleted != NULL)
+		memcpy(gen->main_deleted, deleted, mc->num);
+
+	return gen;
+}
+
+static void
+acl_incr_gen_free(struct acl_incr_gen *gen)
+{
+	rte_acl_free(gen->delta);
+	rte_free(gen->delta_rules);
+	if (gen->free_main)
+		acl_incr_main_free(gen->main);
+	rte_free(gen);
+}
+
+/*
+ * Build the delta context of a generation: the rules not in the main
+ * context, and the main rules overlapping a deleted one, as they may be the
+ * best match of a packet for which the main context returns a deleted rule.
+ */
+static int
+acl_incr_delta_build(struct rte_acl_incr_ctx *ictx, struct acl_incr_gen *gen)
+{
+	const struct acl_incr_main *mc = gen->main;
+	const struct rte_acl_rule **rules, *r;
+	uint32_t *deleted;
+	uint32_t i, j, n, nb_del;
+	int ret;
+
+	rules = rte_malloc(NULL, sizeof(rules[0]) *
+		RTE_MAX(ictx->num_rules, 1U), 0);
+	deleted = rte_malloc(NULL, sizeof(deleted[0]) * RTE_MAX(mc->num, 1U),
+		0);
+	if (rules == NULL || deleted == NULL) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	nb_del = 0;
+	for (j = 0; j != mc->num; j++) {
+		if (gen->main_deleted[j])
+			deleted[nb_del++] = j;
+	}
+
+	n = 0;
+	for (i = 0; i != ictx->num_rules; i++) {
+		if (ictx->rule_del[i])
+			continue;
+
+		r = acl_incr_get_rule(ictx, ictx->rules, i);
+		if (ictx->rule_slot[i] == ACL_INCR_NO_SLOT) {
+			rules[n++] = r;
+			continue;
+		}
+
+		for (j = 0; j != nb_del; j++) {
+			if (acl_incr_rules_overlap(&ictx->cfg, r,
+					acl_incr_get_rule(ictx, mc->data,
+					deleted[j]))) {
+				rules[n++] = r;
+				break;
+			}
+		}
+	}
+
+	gen->delta_rules = rte_malloc(NULL, sizeof(gen->delta_rules[0]) *
+		RTE_MAX(n, 1U), 0);
+	if (gen->delta_rules == NULL) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	ret = acl_incr_ctx_build(ictx, rules, n, gen->delta_rules,
+		&gen->delta);
+	if (ret == 0)
+		gen->delta_num = n;
+
+exit:
+	rte_free(deleted);
+	rte_free(rules);
+	return ret;
+}
+
+/* switch the classification to a new generation, retiring the current one */
+static void
+acl_incr_publish(struct rte_acl_incr_ctx *ictx, struct acl_incr_gen *gen,
+	int new_main)
+{
+	struct acl_incr_gen *old = ictx->gen;
+
+	/* the contexts of the generation are built before it is visible */
+	__atomic_store_n(&ictx->gen, gen, __ATOMIC_RELEASE);
+
+	old->free_main = new_main;
+	old->next = ictx->retired;
+	ictx->retired = old;
+}
+
+static int
+acl_incr_find(const struct rte_acl_incr_ctx *ictx, uint32_t userdata)
+{
+	uint32_t i;
+
+	for (i = 0; i != ictx->num_rules; i++) {
+		if (acl_incr_get_rule(ictx, ictx->rules, i)->data.userdata ==
+				userdata)
+			return i;
+	}
+
+	return -ENOENT;
+}
+
+struct rte_acl_incr_ctx * __rte_experimental
+rte_acl_incr_create(const struct rte_acl_param *param,
+	const struct rte_acl_config *cfg)
+{
+	struct rte_acl_incr_ctx *ictx;
+	struct acl_incr_main *mc;
+
+	if (param == NULL || param->name == NULL || cfg == NULL ||
+			param->max_rule_num == 0 ||
+			param->rule_size < sizeof(struct rte_acl_rule) ||
+			cfg->num_categories == 0 ||
+			cfg->num_categories > RTE_ACL_MAX_CATEGORIES ||
+			cfg->num_fields == 0 ||
+			cfg->num_fields > RTE_ACL_MAX_FIELDS) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	ictx = rte_zmalloc_socket(NULL, sizeof(*ictx), RTE_CACHE_LINE_SIZE,
+		param->socket_id);
+	if (ictx == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	snprintf(ictx->name, sizeof(ictx->name), "%s", param->name);
+	ictx->socket_id = param->socket_id;
+	ictx->rule_size = param->rule_size;
+	ictx->max_rules = param->max_rule_num;
+	ictx->cfg = *cfg;
+
+	ictx->rules = rte_malloc_socket(NULL,
+		(size_t)ictx->max_rules * ictx->rule_size, 0,
+		param->socket_id);
+	ictx->rule_slot = rte_malloc_socket(NULL,
+		sizeof(ictx->rule_slot[0]) * ictx->max_rules, 0,
+		param->socket_id);
+	ictx->rule_del = rte_zmalloc_socket(NULL, ictx->max_rules, 0,
+		param->socket_id);
+	if (ictx->rules == NULL || ictx->rule_slot == NULL ||
+			ictx->rule_del == NULL)
+		goto fail;
+
+	/* start with an empty main context */
+	if (acl_incr_main_build(ictx, &mc) != 0)
+		goto fail;
+
+	ictx->gen = acl_incr_gen_alloc(mc, NULL);
+	if (ictx->gen == NULL) {
+		acl_incr_main_free(mc);
+		goto fail;
+	}
+	ictx->gen->free_main = 1;
+
+	return ictx;
+
+fail:
+	rte_free(ictx->rule_del);
+	rte_free(ictx->rule_slot);
+	rte_free(ictx->rules);
+	rte_free(ictx);
+	rte_errno = ENOMEM;
+	return NULL;
+}
+
+void __rte_experimental
+rte_acl_incr_free(struct rte_acl_incr_ctx *ictx)
+{
+	if (ictx == NULL)
+		return;
+
+	rte_acl_incr_reclaim(ictx);
+
+	ictx->gen->free_main = 1;
+	acl_incr_gen_free(ictx->gen);
+
+	rte_free(ictx->rule_del);
+	rte_free(ictx->rule_slot);
+	rte_free(ictx->rules);
+	rte_free(ictx);
+}
+
+int __rte_experimental
+rte_acl_incr_add_rules(struct rte_acl_incr_ctx *ictx,
+	const struct rte_acl_rule *rules, uint32_t num)
+{
+	const struct rte_acl_rule *r;
+	struct acl_incr_gen *gen;
+	uint32_t i, j;
+	int ret;
+
+	if (ictx == NULL || rules == NULL)
+		return -EINVAL;
+
+	if (num > ictx->max_rules - ictx->num_rules)
+		return -ENOMEM;
+
+	for (i = 0; i != num; i++) {
+		r = acl_incr_get_rule(ictx, (const uint8_t *)rules, i);
+		if (r->data.userdata == 0)
+			return -EINVAL;
+		if (acl_incr_find(ictx, r->data.userdata) >= 0)
+			return -EEXIST;
+		for (j = 0; j != i; j++) {
+			if (acl_incr_get_rule(ictx, (const uint8_t *)rules,
+					j)->data.userdata == r->data.userdata)
+				return -EEXIST;
+		}
+	}
+
+	if (num == 0)
+		return 0;
+
+	memcpy(ictx->rules + (size_t)ictx->num_rules * ictx->rule_size, rules,
+		(size_t)num * ictx->rule_size);
+	for (i = ictx->num_rules; i != ictx->num_rules + num; i++)
+		ictx->rule_slot[i] = ACL_INCR_NO_SLOT;
+	ictx->num_rules += num;
+
+	gen = acl_incr_gen_alloc(ictx->gen->main, ictx->gen->main_deleted);
+	if (gen == NULL) {
+		ret = -ENOMEM;
+	} else {
+		ret = acl_incr_delta_build(ictx, gen);
+		if (ret != 0)
+			acl_incr_gen_free(gen);
+	}
+
+	if (ret != 0) {
+		ictx->num_rules -= num;
+		return ret;
+	}
+
+	acl_incr_publish(ictx, gen, 0);
+	return 0;
+}
+
+int __rte_experimental
+rte_acl_incr_del_rules(struct rte_acl_incr_ctx *ictx,
+	const uint32_t *userdata, uint32_t num)
+{
+	struct acl_incr_gen *gen;
+	uint32_t i, j;
+	int idx, ret = 0;
+
+	if (ictx == NULL || (userdata == NULL && num != 0))
+		return -EINVAL;
+
+	if (num == 0)
+		return 0;
+
+	for (i = 0; i != num; i++) {
+		idx = acl_incr_find(ictx, userdata[i]);
+		if (idx < 0 || ictx->rule_del[idx]) {
+			ret = -ENOENT;
+			goto exit;
+		}
+		ictx->rule_del[idx] = 1;
+	}
+
+	gen = acl_incr_gen_alloc(ictx->gen->main, ictx->gen->main_deleted);
+	if (gen == NULL) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	for (i = 0; i != ictx->num_rules; i++) {
+		if (ictx->rule_del[i] &&
+				ictx->rule_slot[i] != ACL_INCR_NO_SLOT)
+			gen->main_deleted[ictx->rule_slot[i]] = 1;
+	}
+
+	ret = acl_incr_delta_build(ictx, gen);
+	if (ret != 0) {
+		acl_incr_gen_free(gen);
+		goto exit;
+	}
+
+	acl_incr_publish(ictx, gen, 0);
+
+	/* remove the deleted rules from the current ones */
+	for (i = 0, j = 0; i != ictx->num_rules; i++) {
+		if (ictx->rule_del[i])
+			continue;
+		if (i != j) {
+			memcpy(ictx->rules + (size_t)j * ictx->rule_size,
+				ictx->rules + (size_t)i * ictx->rule_size,
+				ictx->rule_size);
+			ictx->rule_slot[j] = ictx->rule_slot[i];
+		}
+		j++;
+	}
+	ictx->num_rules = j;
+
+exit:
+	memset(ictx->rule_del, 0, ictx->max_rules);
+	return ret;
+}
+
+int __rte_experimental
+rte_acl_incr_merge(struct rte_acl_incr_ctx *ictx)
+{
+	struct acl_incr_main *mc;
+	struct acl_incr_gen *gen;
+	uint32_t i;
+	int ret;
+
+	if (ictx == NULL)
+		return -EINVAL;
+
+	ret = acl_incr_main_build(ictx, &mc);
+	if (ret != 0)
+		return ret;
+
+	gen = acl_incr_gen_alloc(mc, NULL);
+	if (gen == NULL) {
+		acl_incr_main_free(mc);
+		return -ENOMEM;
+	}
+
+	acl_incr_publish(ictx, gen, 1);
+
+	for (i = 0; i != ictx->num_rules; i++)
+		ictx->rule_slot[i] = i;
+
+	return 0;
+}
+
+uint32_t __rte_experimental
+rte_acl_incr_delta_rules(const struct rte_acl_incr_ctx *ictx)
+{
+	return ictx->gen->delta_num;
+}
+
+void __rte_experimental
+rte_acl_incr_reclaim(struct rte_acl_incr_ctx *ictx)
+{
+	struct acl_incr_gen *gen;
+
+	while ((gen = ictx->retired) != NULL) {
+		ictx->retired = gen->next;
+		acl_incr_gen_free(gen);
+	}
+}
+
+int __rte_experimental
+rte_acl_incr_classify(const struct rte_acl_incr_ctx *ictx,
+	const uint8_t **data, uint32_t *results, uint32_t num,
+	uint32_t categories)
+{
+	uint32_t delta_res[ACL_INCR_BURST * RTE_ACL_MAX_CATEGORIES];
+	const struct acl_incr_rule *rule;
+	const struct acl_incr_gen *gen;
+	const struct acl_incr_main *mc;
+	uint32_t i, k, n, m, d, res;
+	uint32_t *main_res;
+	int32_t priority;
+
+	if (ictx == NULL || categories == 0 ||
+			categories > RTE_ACL_MAX_CATEGORIES ||
+			(categories != 1 && ((RTE_ACL_RESULTS_MULTIPLIER - 1) &
+			categories) != 0))
+		return -EINVAL;
+
+	gen = __atomic_load_n(&ictx->gen, __ATOMIC_ACQUIRE);
+	mc = gen->main;
+
+	for (i = 0; i != num; i += n) {
+		n = RTE_MIN(num - i, (uint32_t)ACL_INCR_BURST);
+		main_res = results + i * categories;
+
+		if (mc->ctx != NULL)
+			rte_acl_classify(mc->ctx, data + i, main_res, n,
+				categories);
+		else
+			memset(main_res, 0, sizeof(main_res[0]) * n *
+				categories);
+
+		if (gen->delta != NULL)
+			rte_acl_classify(gen->delta, data + i, delta_res, n,
+				categories);
+		else
+			memset(delta_res, 0, sizeof(delta_res[0]) * n *
+				categories);
+
+		/*
+		 * A deleted main rule is replaced by the delta result, which
+		 * holds the main rules that may match instead. Otherwise the
+		 * delta rule wins only with a higher priority.
+		 */
+		for (k = 0; k != n * categories; k++) {
+			m = main_res[k];
+			d = delta_res[k];
+			res = 0;
+			priority = 0;
+
+			if (m != 0 && gen->main_deleted[m - 1] == 0) {
+				rule = &mc->rules[m - 1];
+				res = rule->userdata;
+				priority = rule->priority;
+			}
+			if (d != 0) {
+				rule = &gen->delta_rules[d - 1];
+				if (res == 0 || rule->priority > priority)
+					res = rule->userdata;
+			}
+
+			main_res[k] = res;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,201 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_ACL_INCR_H_
+#define _RTE_ACL_INCR_H_
+
+/**
+ * @file
+ *
+ * RTE Classifier with incremental updates.
+ *
+ * An incremental context classifies against a main ACL context, built from
+ * the whole rule set at the last merge, and a small delta context holding
+ * the rules changed since:
+ *  - the rules added since the merge;
+ *  - the rules of the main context overlapping a deleted one, which may
+ *    become the best match of the packets matching the deleted rule.
+ * Adding or deleting a few rules only rebuilds the delta context.
+ * rte_acl_incr_merge() rebuilds the main context from all the rules and
+ * empties the delta, typically when the delta grows too large.
+ *
+ * The update functions are not multi-thread safe, but may run while other
+ * threads classify: each update publishes a new set of contexts. The
+ * replaced ones are freed by rte_acl_incr_reclaim(), to be called once no
+ * thread may still be classifying with them.
+ */
+
+#include <rte_compat.h>
+#include <rte_acl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Incremental ACL context. */
+struct rte_acl_incr_ctx;
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create an incremental ACL context.
+ *
+ * @param param
+ *   Parameters of the ACL contexts. max_rule_num is the maximum number of
+ *   rules of the incremental context.
+ * @param cfg
+ *   Build configuration of the ACL contexts.
+ * @return
+ *   Pointer to the incremental context, or NULL on error, with rte_errno
+ *   set:
+ *   - EINVAL - invalid parameter passed to function
+ *   - ENOMEM - no memory left for the context
+ */
+struct rte_acl_incr_ctx * __rte_experimental
+rte_acl_incr_create(const struct rte_acl_param *param,
+	const struct rte_acl_config *cfg);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * De-allocate all memory used by an incremental ACL context.
+ *
+ * @param ictx
+ *   Incremental context to free.
+ */
+void __rte_experimental
+rte_acl_incr_free(struct rte_acl_incr_ctx *ictx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add rules to an incremental ACL context, rebuilding its delta context.
+ * This function is not multi-thread safe.
+ *
+ * @param ictx
+ *   Incremental context to add rules to.
+ * @param rules
+ *   Array of rules, in the format of rte_acl_add_rules(). The userdata of
+ *   each rule identifies it and must be unique in the context.
+ * @param num
+ *   Number of rules.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -EEXIST if a userdata is already used.
+ *   - -ENOMEM if there is no space left for the rules.
+ *   - Zero if operation completed successfully.
+ *   No rule is added on error.
+ */
+int __rte_experimental
+rte_acl_incr_add_rules(struct rte_acl_incr_ctx *ictx,
+	const struct rte_acl_rule *rules, uint32_t num);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete rules from an incremental ACL context, rebuilding its delta
+ * context. This function is not multi-thread safe.
+ *
+ * @param ictx
+ *   Incremental context to delete rules from.
+ * @param userdata
+ *   Array of the userdata of the rules to delete.
+ * @param num
+ *   Number of rules.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOENT if a rule is not found.
+ *   - -ENOMEM if there is no memory left to build the delta context.
+ *   - Zero if operation completed successfully.
+ *   No rule is deleted on error.
+ */
+int __rte_experimental
+rte_acl_incr_del_rules(struct rte_acl_incr_ctx *ictx,
+	const uint32_t *userdata, uint32_t num);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Rebuild the main context of an incremental ACL context from all its
+ * rules, emptying the delta context. The classification keeps using the
+ * previous contexts during the build.
+ * This function is not multi-thread safe.
+ *
+ * @param ictx
+ *   Incremental context to merge.
+ * @return
+ *   - -ENOMEM if there is no memory left to build the main context.
+ *   - Zero if operation completed successfully.
+ */
+int __rte_experimental
+rte_acl_incr_merge(struct rte_acl_incr_ctx *ictx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the number of rules of the delta context of an incremental ACL
+ * context, to decide when to merge it.
+ *
+ * @param ictx
+ *   Incremental context.
+ * @return
+ *   Number of rules of the delta context.
+ */
+uint32_t __rte_experimental
+rte_acl_incr_delta_rules(const struct rte_acl_incr_ctx *ictx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free the contexts replaced by the updates of an incremental ACL context.
+ * To be called once all the threads classifying with the context went
+ * through a quiescent state since the updates.
+ * This function is not multi-thread safe.
+ *
+ * @param ictx
+ *   Incremental context.
+ */
+void __rte_experimental
+rte_acl_incr_reclaim(struct rte_acl_incr_ctx *ictx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Perform search for a matching rule for each input data buffer, as
+ * rte_acl_classify() does over the rules of the incremental context.
+ *
+ * @param ictx
+ *   Incremental context to search with.
+ * @param data
+ *   Array of pointers to input data buffers.
+ * @param results
+ *   Array of search results, *categories* results per each input data
+ *   buffer.
+ * @param num
+ *   Number of elements in the input data buffers array.
+ * @param categories
+ *   Number of maximum possible matches for each input buffer, one possible
+ *   match per category.
+ * @return
+ *   zero on successful completion.
+ *   -EINVAL for incorrect arguments.
+ */
+int __rte_experimental
+rte_acl_incr_classify(const struct rte_acl_incr_ctx *ictx,
+	const uint8_t **data, uint32_t *results, uint32_t num,
+	uint32_t categories);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_ACL_INCR_H_ */
@@ -15,6 +15,7 @@
 #include <rte_memory.h>
 #include <rte_eal.h>
 #include <rte_byteorder.h>
+#include <rte_prefetch.h>
 
 #include "bpf_impl.h"
 
@@ -432,8 +433,15 @@ rte_bpf_exec_burst(const struct rte_bpf *bpf, void *ctx[], uint64_t rc[],
 	uint64_t reg[EBPF_REG_NUM];
 	uint64_t stack[MAX_BPF_STACK_SIZE / sizeof(uint64_t)];
 
+	for (i = 0; i != RTE_MIN(num, (uint32_t)BPF_BURST_PREFETCH); i++)
+		rte_prefetch0(ctx[i]);
+
 	for (i = 0; i != num; i++) {
 
+		/* bring in the context of a next run */
+		if (i + BPF_BURST_PREFETCH < num)
+			rte_prefetch0(ctx[i + BPF_BURST_PREFETCH]);
+
 		reg[EBPF_REG_1] = (uintptr_t)ctx[i];
 		reg[EBPF_REG_10] = (uintptr_t)(stack + RTE_DIM(stack));
 
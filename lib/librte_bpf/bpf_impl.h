@@ -14,6 +14,9 @@ extern "C" {
 
 #define MAX_BPF_STACK_SIZE	0x200
 
+/* number of contexts prefetched ahead while running a burst */
+#define BPF_BURST_PREFETCH	4
+
 struct rte_bpf {
 	struct rte_bpf_prm prm;
 	struct rte_bpf_jit jit;
@@ -27,6 +30,8 @@ extern int bpf_jit(struct rte_bpf *bpf);
 
 #ifdef RTE_ARCH_X86_64
 extern int bpf_jit_x86(struct rte_bpf *);
+#elif defined(RTE_ARCH_ARM64)
+extern int bpf_jit_arm64(struct rte_bpf *);
 #endif
 
 extern int rte_bpf_logtype;
@@ -0,0 +1,1047 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdarg.h>
+#include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_log.h>
+#include <rte_debug.h>
+#include <rte_memory.h>
+#include <rte_eal.h>
+#include <rte_byteorder.h>
+
+#include "bpf_impl.h"
+
+#define A64_REG_MASK(r)		((r) & 0x1f)
+#define A64_INVALID_OP_CODE	(0xffffffff)
+
+/* arm64 general purpose registers */
+enum {
+	A64_R0 = 0,   /* scratch, 1st arg, return value */
+	A64_R1 = 1,   /* scratch, 2nd arg */
+	A64_R2 = 2,   /* scratch, 3rd arg */
+	A64_R3 = 3,   /* scratch, 4th arg */
+	A64_R4 = 4,   /* scratch, 5th arg */
+	A64_R7 = 7,   /* scratch */
+	A64_R9 = 9,   /* scratch */
+	A64_R10 = 10, /* scratch */
+	A64_R11 = 11, /* scratch */
+	A64_R19 = 19, /* callee saved */
+	A64_R20 = 20, /* callee saved */
+	A64_R21 = 21, /* callee saved */
+	A64_R22 = 22, /* callee saved */
+	A64_R25 = 25, /* callee saved */
+	A64_R26 = 26, /* callee saved */
+	A64_FP = 29,  /* frame pointer */
+	A64_LR = 30,  /* link register */
+	A64_SP = 31,  /* stack pointer, as base or destination register */
+	A64_ZR = 31,  /* zero register, as source register */
+};
+
+/* arm64 condition codes */
+enum {
+	A64_EQ = 0x0, /* == */
+	A64_NE = 0x1, /* != */
+	A64_HS = 0x2, /* unsigned >= */
+	A64_LO = 0x3, /* unsigned < */
+	A64_HI = 0x8, /* unsigned > */
+	A64_LS = 0x9, /* unsigned <= */
+	A64_GE = 0xa, /* signed >= */
+	A64_LT = 0xb, /* signed < */
+	A64_GT = 0xc, /* signed > */
+	A64_LE = 0xd, /* signed <= */
+};
+
+/*
+ * eBPF to arm64 register mappings.
+ * eBPF R1-R5 are the arguments of the calls, as x0-x4 in the arm64 ABI,
+ * eBPF R0 is moved to x0 on exit and from x0 after a call.
+ */
+static const uint32_t ebpf2a64[] = {
+	[EBPF_REG_0] = A64_R7,
+	[EBPF_REG_1] = A64_R0,
+	[EBPF_REG_2] = A64_R1,
+	[EBPF_REG_3] = A64_R2,
+	[EBPF_REG_4] = A64_R3,
+	[EBPF_REG_5] = A64_R4,
+	[EBPF_REG_6] = A64_R19,
+	[EBPF_REG_7] = A64_R20,
+	[EBPF_REG_8] = A64_R21,
+	[EBPF_REG_9] = A64_R22,
+	[EBPF_REG_10] = A64_R25,
+};
+
+/*
+ * x9, x10 and x11 are used as a scratch temporary registers.
+ */
+enum {
+	REG_TMP0 = A64_R9,
+	REG_TMP1 = A64_R10,
+	REG_TMP2 = A64_R11,
+};
+
+struct bpf_jit_state {
+	uint32_t idx;
+	size_t sz;
+	struct {
+		int32_t off;
+	} exit;
+	uint32_t reguse;
+	int32_t *off;
+	uint32_t *ins;
+	size_t burst; /* offset of the burst entry point */
+};
+
+#define	INUSE(v, r)	(((v) >> (r)) & 1)
+#define	USED(v, r)	((v) |= 1 << (r))
+
+/* callee saved registers the prolog saves, by pairs */
+#define SAVE_REGS_MASK	(1 << A64_R19 | 1 << A64_R20 | 1 << A64_R21 | \
+	1 << A64_R22 | 1 << A64_R25 | 1 << A64_LR)
+
+static int
+is_64(uint32_t op)
+{
+	return BPF_CLASS(op) == EBPF_ALU64 || BPF_CLASS(op) == BPF_JMP;
+}
+
+static void
+emit_insn(struct bpf_jit_state *st, uint32_t insn)
+{
+	if (st->ins != NULL)
+		st->ins[st->sz / sizeof(uint32_t)] = rte_cpu_to_le_32(insn);
+	st->sz += sizeof(uint32_t);
+}
+
+static void
+mark_reg(struct bpf_jit_state *st, uint32_t reg)
+{
+	if (reg != A64_SP)
+		USED(st->reguse, reg);
+}
+
+/*
+ * offset in instructions of the jump to the given byte offset.
+ */
+static int32_t
+jump_offset(const struct bpf_jit_state *st, int32_t to)
+{
+	return (to - (int32_t)st->sz) / (int32_t)sizeof(uint32_t);
+}
+
+/*
+ * emit mov of 16 bits chunks of an immediate value:
+ * movz/movn for the first non trivial chunk, then movk for the others.
+ */
+static void
+emit_mov_imm(struct bpf_jit_state *st, int is64, uint32_t rd, uint64_t val)
+{
+	uint32_t i, n, chunk, first, inv, sf;
+	uint64_t v;
+
+	mark_reg(st, rd);
+
+	n = is64 ? 4 : 2;
+	if (!is64)
+		val = (uint32_t)val;
+	sf = is64 ? 1U << 31 : 0;
+
+	/* count chunks with all bits set, to choose between movz and movn */
+	inv = 0;
+	for (i = 0; i != n; i++)
+		inv += ((val >> (i * 16)) & 0xffff) == 0xffff;
+
+	if (inv > n / 2) {
+		/* movn with the inverted value, then movk */
+		v = is64 ? ~val : (uint32_t)~val;
+		first = 1;
+		for (i = 0; i != n; i++) {
+			chunk = (val >> (i * 16)) & 0xffff;
+			if (chunk == 0xffff && (v != 0 || i != 0))
+				continue;
+			if (first) {
+				emit_insn(st, 0x12800000 | sf | i << 21 |
+					((v >> (i * 16)) & 0xffff) << 5 | rd);
+				first = 0;
+			} else
+				emit_insn(st, 0x72800000 | sf | i << 21 |
+					chunk << 5 | rd);
+		}
+		return;
+	}
+
+	/* movz, then movk */
+	first = 1;
+	for (i = 0; i != n; i++) {
+		chunk = (val >> (i * 16)) & 0xffff;
+		if (chunk == 0 && (val != 0 || i != 0))
+			continue;
+		if (first) {
+			emit_insn(st, 0x52800000 | sf | i << 21 | chunk << 5 |
+				rd);
+			first = 0;
+		} else
+			emit_insn(st, 0x72800000 | sf | i << 21 | chunk << 5 |
+				rd);
+	}
+}
+
+/*
+ * emit mov <rn>, <rd> (orr with the zero register).
+ */
+static void
+emit_mov_reg(struct bpf_jit_state *st, int is64, uint32_t rn, uint32_t rd)
+{
+	mark_reg(st, rn);
+	mark_reg(st, rd);
+	emit_insn(st, 0x2a0003e0 | (is64 ? 1U << 31 : 0) | rn << 16 | rd);
+}
+
+/*
+ * emit add/sub of a 12 bits unsigned immediate, also used for sp.
+ */
+static void
+emit_add_sub_imm(struct bpf_jit_state *st, int is64, int sub, uint32_t rn,
+	uint32_t rd, uint32_t imm12)
+{
+	mark_reg(st, rn);
+	mark_reg(st, rd);
+	emit_insn(st, 0x11000000 | (is64 ? 1U << 31 : 0) | (sub ? 1 << 30 : 0) |
+		imm12 << 10 | rn << 5 | rd);
+}
+
+/*
+ * emit three registers data processing instruction: <rd> = <rn> op <rm>
+ */
+static void
+emit_rrr(struct bpf_jit_state *st, uint32_t opcode, int is64, uint32_t rm,
+	uint32_t rn, uint32_t rd)
+{
+	mark_reg(st, rm);
+	mark_reg(st, rn);
+	mark_reg(st, rd);
+	emit_insn(st, opcode | (is64 ? 1U << 31 : 0) | rm << 16 | rn << 5 | rd);
+}
+
+static uint32_t
+alu_opcode(uint32_t op)
+{
+	switch (BPF_OP(op)) {
+	case BPF_ADD:
+		return 0x0b000000;
+	case BPF_SUB:
+		return 0x4b000000;
+	case BPF_AND:
+		return 0x0a000000;
+	case BPF_OR:
+		return 0x2a000000;
+	case BPF_XOR:
+		return 0x4a000000;
+	case BPF_LSH:
+		return 0x1ac02000;
+	case BPF_RSH:
+		return 0x1ac02400;
+	case EBPF_ARSH:
+		return 0x1ac02800;
+	case BPF_MUL:
+		/* madd with the zero register as addend */
+		return 0x1b007c00;
+	case BPF_DIV:
+		return 0x1ac00800;
+	}
+	return A64_INVALID_OP_CODE;
+}
+
+/*
+ * emit one of:
+ *   add/sub/and/or/xor/lsh/rsh/arsh/mul <sreg>, <dreg>
+ */
+static void
+emit_alu_reg(struct bpf_jit_state *st, uint32_t op, uint32_t sreg,
+	uint32_t dreg)
+{
+	emit_rrr(st, alu_opcode(op), is_64(op), sreg, dreg, dreg);
+}
+
+/*
+ * emit one of:
+ *   add/sub/and/or/xor/mul <imm>, <dreg>
+ */
+static void
+emit_alu_imm(struct bpf_jit_state *st, uint32_t op, uint32_t dreg,
+	int32_t imm)
+{
+	int is64 = is_64(op);
+
+	if ((BPF_OP(op) == BPF_ADD || BPF_OP(op) == BPF_SUB) &&
+			imm >= 0 && imm < 4096) {
+		emit_add_sub_imm(st, is64, BPF_OP(op) == BPF_SUB, dreg, dreg,
+			imm);
+		return;
+	}
+
+	emit_mov_imm(st, is64, REG_TMP0, (int64_t)imm);
+	emit_rrr(st, alu_opcode(op), is64, REG_TMP0, dreg, dreg);
+}
+
+/*
+ * emit lsh/rsh/arsh <imm>, <dreg> (ubfm/sbfm)
+ */
+static void
+emit_shift_imm(struct bpf_jit_state *st, uint32_t op, uint32_t dreg,
+	uint32_t imm)
+{
+	uint32_t bits, opcode, immr, imms;
+
+	mark_reg(st, dreg);
+
+	if (is_64(op)) {
+		bits = 64;
+		opcode = BPF_OP(op) == EBPF_ARSH ? 0x93400000 : 0xd3400000;
+	} else {
+		bits = 32;
+		opcode = BPF_OP(op) == EBPF_ARSH ? 0x13000000 : 0x53000000;
+	}
+
+	imm &= bits - 1;
+	if (BPF_OP(op) == BPF_LSH) {
+		immr = (bits - imm) & (bits - 1);
+		imms = bits - 1 - imm;
+	} else {
+		immr = imm;
+		imms = bits - 1;
+	}
+
+	emit_insn(st, opcode | immr << 16 | imms << 10 | dreg << 5 | dreg);
+}
+
+/*
+ * emit neg <dreg>
+ */
+static void
+emit_neg(struct bpf_jit_state *st, uint32_t op, uint32_t dreg)
+{
+	emit_rrr(st, 0x4b000000, is_64(op), dreg, A64_ZR, dreg);
+}
+
+/*
+ * emit zero extension of the low <bits> of <dreg> (ubfm)
+ */
+static void
+emit_zero_extend(struct bpf_jit_state *st, uint32_t dreg, uint32_t bits)
+{
+	mark_reg(st, dreg);
+	if (bits == 16)
+		emit_insn(st, 0x53003c00 | dreg << 5 | dreg);
+	else if (bits == 32)
+		emit_mov_reg(st, 0, dreg, dreg);
+}
+
+/*
+ * emit rev16/rev32/rev64 of <dreg> for a BE conversion, on LE arm64.
+ */
+static void
+emit_be(struct bpf_jit_state *st, uint32_t dreg, uint32_t imm)
+{
+	mark_reg(st, dreg);
+	switch (imm) {
+	case 16:
+		emit_insn(st, 0x5ac00400 | dreg << 5 | dreg);
+		emit_zero_extend(st, dreg, 16);
+		break;
+	case 32:
+		emit_insn(st, 0x5ac00800 | dreg << 5 | dreg);
+		break;
+	case 64:
+		emit_insn(st, 0xdac00c00 | dreg << 5 | dreg);
+		break;
+	}
+}
+
+static void
+emit_le(struct bpf_jit_state *st, uint32_t dreg, uint32_t imm)
+{
+	if (imm != 64)
+		emit_zero_extend(st, dreg, imm);
+}
+
+/*
+ * emit b <ofs>, where ofs is in instructions.
+ */
+static void
+emit_b(struct bpf_jit_state *st, int32_t ofs)
+{
+	emit_insn(st, 0x14000000 | (ofs & 0x3ffffff));
+}
+
+/*
+ * emit b.<cond> <ofs>, where ofs is in instructions.
+ */
+static void
+emit_b_cond(struct bpf_jit_state *st, uint32_t cond, int32_t ofs)
+{
+	emit_insn(st, 0x54000000 | (ofs & 0x7ffff) << 5 | cond);
+}
+
+/*
+ * emit cbz/cbnz <reg>, <ofs>, where ofs is in instructions.
+ */
+static void
+emit_cbz(struct bpf_jit_state *st, int is64, int nz, uint32_t reg,
+	int32_t ofs)
+{
+	mark_reg(st, reg);
+	emit_insn(st, 0x34000000 | (is64 ? 1U << 31 : 0) | (nz ? 1 << 24 : 0) |
+		(ofs & 0x7ffff) << 5 | reg);
+}
+
+/*
+ * emit jump to the epilog.
+ */
+static void
+emit_exit_jmp(struct bpf_jit_state *st)
+{
+	emit_b(st, jump_offset(st, st->exit.off));
+}
+
+/*
+ * emit one of:
+ *   div/mod <sreg>, <dreg>
+ *   div/mod <imm>, <dreg>
+ * for a zero divisor register, exit with return value zero.
+ */
+static void
+emit_div(struct bpf_jit_state *st, uint32_t op, uint32_t sreg, uint32_t dreg,
+	int32_t imm)
+{
+	int is64 = is_64(op);
+	uint32_t sr;
+
+	if (BPF_SRC(op) == BPF_X) {
+		sr = sreg;
+		emit_cbz(st, is64, 1, sr, 3);
+		emit_mov_imm(st, 1, ebpf2a64[EBPF_REG_0], 0);
+		emit_exit_jmp(st);
+	} else {
+		sr = REG_TMP1;
+		emit_mov_imm(st, is64, sr, (int64_t)imm);
+	}
+
+	if (BPF_OP(op) == BPF_DIV)
+		emit_rrr(st, 0x1ac00800, is64, sr, dreg, dreg);
+	else {
+		/* tmp = dreg / sr; dreg = dreg - tmp * sr (msub) */
+		emit_rrr(st, 0x1ac00800, is64, sr, dreg, REG_TMP0);
+		emit_rrr(st, 0x1b008000 | dreg << 10, is64, sr, REG_TMP0,
+			dreg);
+	}
+}
+
+/*
+ * check that the offset fits into the signed 9 bits unscaled offset of
+ * ldur/stur.
+ */
+static int
+mem_off_imm(int32_t ofs)
+{
+	return ofs >= -256 && ofs < 256;
+}
+
+static uint32_t
+mem_size_bits(uint32_t op)
+{
+	switch (BPF_SIZE(op)) {
+	case BPF_B:
+		return 0;
+	case BPF_H:
+		return 1;
+	case BPF_W:
+		return 2;
+	default:
+		return 3;
+	}
+}
+
+/*
+ * emit load/store of <rt> at [<rn> + <ofs>]:
+ * ldur/stur for small offsets, ldr/str with a register offset otherwise.
+ */
+static void
+emit_ldst(struct bpf_jit_state *st, uint32_t op, int load, uint32_t rt,
+	uint32_t rn, int32_t ofs)
+{
+	uint32_t size = mem_size_bits(op) << 30;
+
+	mark_reg(st, rt);
+	mark_reg(st, rn);
+
+	if (mem_off_imm(ofs)) {
+		emit_insn(st, 0x38000000 | size | (load ? 1 << 22 : 0) |
+			((uint32_t)ofs & 0x1ff) << 12 | rn << 5 | rt);
+		return;
+	}
+
+	emit_mov_imm(st, 1, REG_TMP2, (int64_t)ofs);
+	emit_insn(st, 0x38206800 | size | (load ? 1 << 22 : 0) |
+		REG_TMP2 << 16 | rn << 5 | rt);
+}
+
+/*
+ * emit ld <sreg + ofs>, <dreg>
+ */
+static void
+emit_ld_reg(struct bpf_jit_state *st, uint32_t op, uint32_t sreg,
+	uint32_t dreg, int32_t ofs)
+{
+	emit_ldst(st, op, 1, dreg, sreg, ofs);
+}
+
+/*
+ * emit st <sreg>, <dreg + ofs>
+ */
+static void
+emit_st_reg(struct bpf_jit_state *st, uint32_t op, uint32_t sreg,
+	uint32_t dreg, int32_t ofs)
+{
+	emit_ldst(st, op, 0, sreg, dreg, ofs);
+}
+
+/*
+ * emit st <imm>, <dreg + ofs>
+ */
+static void
+emit_st_imm(struct bpf_jit_state *st, uint32_t op, uint32_t dreg,
+	int32_t imm, int32_t ofs)
+{
+	emit_mov_imm(st, 1, REG_TMP1, (int64_t)imm);
+	emit_ldst(st, op, 0, REG_TMP1, dreg, ofs);
+}
+
+/*
+ * emit lock add <sreg>, <dreg + ofs>, as a load/store exclusive loop:
+ *   add tmp0, dreg, ofs
+ * 1: ldxr tmp1, [tmp0]
+ *   add tmp1, tmp1, sreg
+ *   stxr wtmp2, tmp1, [tmp0]
+ *   cbnz wtmp2, 1b
+ */
+static void
+emit_st_xadd(struct bpf_jit_state *st, uint32_t op, uint32_t sreg,
+	uint32_t dreg, int32_t ofs)
+{
+	int is64 = BPF_SIZE(op) == EBPF_DW;
+	uint32_t sz = is64 ? 1U << 30 : 0;
+
+	emit_mov_imm(st, 1, REG_TMP0, (int64_t)ofs);
+	emit_rrr(st, 0x0b000000, 1, dreg, REG_TMP0, REG_TMP0);
+
+	mark_reg(st, REG_TMP1);
+	mark_reg(st, REG_TMP2);
+	emit_insn(st, 0x885f7c00 | sz | REG_TMP0 << 5 | REG_TMP1);
+	emit_rrr(st, 0x0b000000, is64, sreg, REG_TMP1, REG_TMP1);
+	emit_insn(st, 0x88007c00 | sz | REG_TMP2 << 16 | REG_TMP0 << 5 |
+		REG_TMP1);
+	emit_cbz(st, 0, 1, REG_TMP2, -3);
+}
+
+static uint32_t
+jcc_cond(uint32_t op)
+{
+	switch (BPF_OP(op)) {
+	case BPF_JEQ:
+		return A64_EQ;
+	case EBPF_JNE:
+	case BPF_JSET:
+		return A64_NE;
+	case BPF_JGT:
+		return A64_HI;
+	case EBPF_JLT:
+		return A64_LO;
+	case BPF_JGE:
+		return A64_HS;
+	case EBPF_JLE:
+		return A64_LS;
+	case EBPF_JSGT:
+		return A64_GT;
+	case EBPF_JSLT:
+		return A64_LT;
+	case EBPF_JSGE:
+		return A64_GE;
+	case EBPF_JSLE:
+		return A64_LE;
+	}
+	return A64_EQ;
+}
+
+/*
+ * emit cmp/tst <sreg>, <dreg> followed by b.<cond> to the target
+ * instruction.
+ */
+static void
+emit_jcc_reg(struct bpf_jit_state *st, uint32_t op, uint32_t sreg,
+	uint32_t dreg, int32_t ofs)
+{
+	int32_t to = st->off[st->idx + ofs];
+
+	if (BPF_OP(op) == BPF_JSET)
+		/* ands xzr, dreg, sreg */
+		emit_rrr(st, 0x6a000000, 1, sreg, dreg, A64_ZR);
+	else
+		/* subs xzr, dreg, sreg */
+		emit_rrr(st, 0x6b000000, 1, sreg, dreg, A64_ZR);
+
+	emit_b_cond(st, jcc_cond(op), jump_offset(st, to));
+}
+
+static void
+emit_jcc_imm(struct bpf_jit_state *st, uint32_t op, uint32_t dreg,
+	int32_t imm, int32_t ofs)
+{
+	int32_t to = st->off[st->idx + ofs];
+
+	if (BPF_OP(op) != BPF_JSET && imm >= 0 && imm < 4096) {
+		/* subs xzr, dreg, #imm */
+		mark_reg(st, dreg);
+		emit_insn(st, 0xf100001f | (uint32_t)imm << 10 | dreg << 5);
+		emit_b_cond(st, jcc_cond(op), jump_offset(st, to));
+		return;
+	}
+
+	emit_mov_imm(st, 1, REG_TMP0, (int64_t)imm);
+	emit_jcc_reg(st, op, REG_TMP0, dreg, ofs);
+}
+
+/*
+ * emit jump to the target instruction.
+ */
+static void
+emit_jmp(struct bpf_jit_state *st, int32_t ofs)
+{
+	emit_b(st, jump_offset(st, st->off[st->idx + ofs]));
+}
+
+/*
+ * emit call to the external function, the return value is moved from
+ * x0 to the register of eBPF R0.
+ */
+static void
+emit_call(struct bpf_jit_state *st, uintptr_t trg)
+{
+	emit_mov_imm(st, 1, REG_TMP0, trg);
+	/* blr tmp0 */
+	emit_insn(st, 0xd63f0000 | REG_TMP0 << 5);
+	USED(st->reguse, A64_LR);
+	emit_mov_reg(st, 1, A64_R0, ebpf2a64[EBPF_REG_0]);
+}
+
+/*
+ * emit stp <r1>, <r2>, [sp, #-16]!
+ */
+static void
+emit_push_pair(struct bpf_jit_state *st, uint32_t r1, uint32_t r2)
+{
+	emit_insn(st, 0xa9800000 | (-2 & 0x7f) << 15 | r2 << 10 |
+		A64_SP << 5 | r1);
+}
+
+/*
+ * emit ldp <r1>, <r2>, [sp], #16
+ */
+static void
+emit_pop_pair(struct bpf_jit_state *st, uint32_t r1, uint32_t r2)
+{
+	emit_insn(st, 0xa8c00000 | 2 << 15 | r2 << 10 | A64_SP << 5 | r1);
+}
+
+static int
+need_frame(const struct bpf_jit_state *st)
+{
+	return (st->reguse & SAVE_REGS_MASK) != 0;
+}
+
+static void
+emit_prolog(struct bpf_jit_state *st, int32_t stack_size)
+{
+	/* we can avoid touching the stack at all */
+	if (!need_frame(st))
+		return;
+
+	emit_push_pair(st, A64_FP, A64_LR);
+	emit_add_sub_imm(st, 1, 0, A64_SP, A64_FP, 0);
+	emit_push_pair(st, A64_R19, A64_R20);
+	emit_push_pair(st, A64_R21, A64_R22);
+	emit_push_pair(st, A64_R25, A64_R26);
+
+	if (INUSE(st->reguse, A64_R25) != 0) {
+		emit_add_sub_imm(st, 1, 0, A64_SP, A64_R25, 0);
+		emit_add_sub_imm(st, 1, 1, A64_SP, A64_SP,
+			RTE_ALIGN_CEIL(stack_size, 16));
+	}
+}
+
+static void
+emit_epilog(struct bpf_jit_state *st)
+{
+	/* store offset of epilog block */
+	st->exit.off = st->sz;
+
+	if (need_frame(st)) {
+		if (INUSE(st->reguse, A64_R25) != 0)
+			emit_add_sub_imm(st, 1, 0, A64_R25, A64_SP, 0);
+
+		emit_pop_pair(st, A64_R25, A64_R26);
+		emit_pop_pair(st, A64_R21, A64_R22);
+		emit_pop_pair(st, A64_R19, A64_R20);
+		emit_pop_pair(st, A64_FP, A64_LR);
+	}
+
+	emit_mov_reg(st, 1, ebpf2a64[EBPF_REG_0], A64_R0);
+	/* ret */
+	emit_insn(st, 0xd65f03c0);
+}
+
+/*
+ * emit ldr/str <rt>, [<rn>, <rm>, lsl #3]
+ */
+static void
+emit_ldst_idx(struct bpf_jit_state *st, int load, uint32_t rt, uint32_t rn,
+	uint32_t rm)
+{
+	emit_insn(st, 0xf8207800 | (load ? 1 << 22 : 0) | rm << 16 | rn << 5 |
+		rt);
+}
+
+/*
+ * emit entry point to run the code for a burst of contexts:
+ * uint32_t burst(void *ctx[], uint64_t rc[], uint32_t num).
+ * Calls the code at offset zero for each context, while prefetching the
+ * context BPF_BURST_PREFETCH positions ahead.
+ */
+static void
+emit_burst(struct bpf_jit_state *st)
+{
+	uint32_t reguse;
+
+	/* number of instructions of the loop */
+	const int32_t lsz = 11;
+
+	/* registers used here don't need to be saved by the code itself */
+	reguse = st->reguse;
+	st->burst = st->sz;
+
+	emit_push_pair(st, A64_FP, A64_LR);
+	emit_add_sub_imm(st, 1, 0, A64_SP, A64_FP, 0);
+	emit_push_pair(st, A64_R19, A64_R20);
+	emit_push_pair(st, A64_R21, A64_R22);
+
+	/* x19 = ctx, x20 = rc, x21 = num, x22 = index */
+	emit_mov_reg(st, 1, A64_R0, A64_R19);
+	emit_mov_reg(st, 1, A64_R1, A64_R20);
+	emit_mov_reg(st, 0, A64_R2, A64_R21);
+	emit_mov_imm(st, 1, A64_R22, 0);
+	emit_cbz(st, 1, 0, A64_R21, lsz + 1);
+
+	/* prefetch ctx[index + BPF_BURST_PREFETCH], if any */
+	emit_add_sub_imm(st, 1, 0, A64_R22, REG_TMP0, BPF_BURST_PREFETCH);
+	emit_rrr(st, 0x6b000000, 1, A64_R21, REG_TMP0, A64_ZR);
+	emit_b_cond(st, A64_HS, 3);
+	emit_ldst_idx(st, 1, REG_TMP0, A64_R19, REG_TMP0);
+	/* prfm pldl1keep, [tmp0] */
+	emit_insn(st, 0xf9800000 | REG_TMP0 << 5);
+
+	/* rc[index] = code(ctx[index]) */
+	emit_ldst_idx(st, 1, A64_R0, A64_R19, A64_R22);
+	/* bl to the code */
+	emit_insn(st, 0x94000000 | (jump_offset(st, 0) & 0x3ffffff));
+	emit_ldst_idx(st, 0, A64_R0, A64_R20, A64_R22);
+
+	emit_add_sub_imm(st, 1, 0, A64_R22, A64_R22, 1);
+	emit_rrr(st, 0x6b000000, 1, A64_R21, A64_R22, A64_ZR);
+	emit_b_cond(st, A64_NE, -(lsz - 1));
+
+	emit_mov_reg(st, 0, A64_R21, A64_R0);
+	emit_pop_pair(st, A64_R21, A64_R22);
+	emit_pop_pair(st, A64_R19, A64_R20);
+	emit_pop_pair(st, A64_FP, A64_LR);
+	/* ret */
+	emit_insn(st, 0xd65f03c0);
+
+	st->reguse = reguse;
+}
+
+/*
+ * walk through bpf code and translate them arm64 one.
+ */
+static int
+emit(struct bpf_jit_state *st, const struct rte_bpf *bpf)
+{
+	uint32_t i, dr, op, sr;
+	const struct ebpf_insn *ins;
+
+	/* reset state fields */
+	st->sz = 0;
+
+	emit_prolog(st, bpf->stack_sz);
+
+	for (i = 0; i != bpf->prm.nb_ins; i++) {
+
+		st->idx = i;
+		st->off[i] = st->sz;
+
+		ins = bpf->prm.ins + i;
+
+		dr = ebpf2a64[ins->dst_reg];
+		sr = ebpf2a64[ins->src_reg];
+		op = ins->code;
+
+		switch (op) {
+		/* 32 bit ALU IMM operations */
+		case (BPF_ALU | BPF_ADD | BPF_K):
+		case (BPF_ALU | BPF_SUB | BPF_K):
+		case (BPF_ALU | BPF_AND | BPF_K):
+		case (BPF_ALU | BPF_OR | BPF_K):
+		case (BPF_ALU | BPF_XOR | BPF_K):
+		case (BPF_ALU | BPF_MUL | BPF_K):
+			emit_alu_imm(st, op, dr, ins->imm);
+			break;
+		case (BPF_ALU | BPF_LSH | BPF_K):
+		case (BPF_ALU | BPF_RSH | BPF_K):
+			emit_shift_imm(st, op, dr, ins->imm);
+			break;
+		case (BPF_ALU | EBPF_MOV | BPF_K):
+			emit_mov_imm(st, 0, dr, (uint32_t)ins->imm);
+			break;
+		/* 32 bit ALU REG operations */
+		case (BPF_ALU | BPF_ADD | BPF_X):
+		case (BPF_ALU | BPF_SUB | BPF_X):
+		case (BPF_ALU | BPF_AND | BPF_X):
+		case (BPF_ALU | BPF_OR | BPF_X):
+		case (BPF_ALU | BPF_XOR | BPF_X):
+		case (BPF_ALU | BPF_LSH | BPF_X):
+		case (BPF_ALU | BPF_RSH | BPF_X):
+		case (BPF_ALU | BPF_MUL | BPF_X):
+			emit_alu_reg(st, op, sr, dr);
+			break;
+		case (BPF_ALU | EBPF_MOV | BPF_X):
+			emit_mov_reg(st, 0, sr, dr);
+			break;
+		case (BPF_ALU | BPF_NEG):
+			emit_neg(st, op, dr);
+			break;
+		case (BPF_ALU | EBPF_END | EBPF_TO_BE):
+			emit_be(st, dr, ins->imm);
+			break;
+		case (BPF_ALU | EBPF_END | EBPF_TO_LE):
+			emit_le(st, dr, ins->imm);
+			break;
+		/* 64 bit ALU IMM operations */
+		case (EBPF_ALU64 | BPF_ADD | BPF_K):
+		case (EBPF_ALU64 | BPF_SUB | BPF_K):
+		case (EBPF_ALU64 | BPF_AND | BPF_K):
+		case (EBPF_ALU64 | BPF_OR | BPF_K):
+		case (EBPF_ALU64 | BPF_XOR | BPF_K):
+		case (EBPF_ALU64 | BPF_MUL | BPF_K):
+			emit_alu_imm(st, op, dr, ins->imm);
+			break;
+		case (EBPF_ALU64 | BPF_LSH | BPF_K):
+		case (EBPF_ALU64 | BPF_RSH | BPF_K):
+		case (EBPF_ALU64 | EBPF_ARSH | BPF_K):
+			emit_shift_imm(st, op, dr, ins->imm);
+			break;
+		case (EBPF_ALU64 | EBPF_MOV | BPF_K):
+			emit_mov_imm(st, 1, dr, (int64_t)ins->imm);
+			break;
+		/* 64 bit ALU REG operations */
+		case (EBPF_ALU64 | BPF_ADD | BPF_X):
+		case (EBPF_ALU64 | BPF_SUB | BPF_X):
+		case (EBPF_ALU64 | BPF_AND | BPF_X):
+		case (EBPF_ALU64 | BPF_OR | BPF_X):
+		case (EBPF_ALU64 | BPF_XOR | BPF_X):
+		case (EBPF_ALU64 | BPF_LSH | BPF_X):
+		case (EBPF_ALU64 | BPF_RSH | BPF_X):
+		case (EBPF_ALU64 | EBPF_ARSH | BPF_X):
+		case (EBPF_ALU64 | BPF_MUL | BPF_X):
+			emit_alu_reg(st, op, sr, dr);
+			break;
+		case (EBPF_ALU64 | EBPF_MOV | BPF_X):
+			emit_mov_reg(st, 1, sr, dr);
+			break;
+		case (EBPF_ALU64 | BPF_NEG):
+			emit_neg(st, op, dr);
+			break;
+		/* divide instructions */
+		case (BPF_ALU | BPF_DIV | BPF_K):
+		case (BPF_ALU | BPF_MOD | BPF_K):
+		case (BPF_ALU | BPF_DIV | BPF_X):
+		case (BPF_ALU | BPF_MOD | BPF_X):
+		case (EBPF_ALU64 | BPF_DIV | BPF_K):
+		case (EBPF_ALU64 | BPF_MOD | BPF_K):
+		case (EBPF_ALU64 | BPF_DIV | BPF_X):
+		case (EBPF_ALU64 | BPF_MOD | BPF_X):
+			emit_div(st, op, sr, dr, ins->imm);
+			break;
+		/* load instructions */
+		case (BPF_LDX | BPF_MEM | BPF_B):
+		case (BPF_LDX | BPF_MEM | BPF_H):
+		case (BPF_LDX | BPF_MEM | BPF_W):
+		case (BPF_LDX | BPF_MEM | EBPF_DW):
+			emit_ld_reg(st, op, sr, dr, ins->off);
+			break;
+		/* load 64 bit immediate value */
+		case (BPF_LD | BPF_IMM | EBPF_DW):
+			emit_mov_imm(st, 1, dr, (uint32_t)ins[0].imm |
+				(uint64_t)(uint32_t)ins[1].imm << 32);
+			i++;
+			break;
+		/* store instructions */
+		case (BPF_STX | BPF_MEM | BPF_B):
+		case (BPF_STX | BPF_MEM | BPF_H):
+		case (BPF_STX | BPF_MEM | BPF_W):
+		case (BPF_STX | BPF_MEM | EBPF_DW):
+			emit_st_reg(st, op, sr, dr, ins->off);
+			break;
+		case (BPF_ST | BPF_MEM | BPF_B):
+		case (BPF_ST | BPF_MEM | BPF_H):
+		case (BPF_ST | BPF_MEM | BPF_W):
+		case (BPF_ST | BPF_MEM | EBPF_DW):
+			emit_st_imm(st, op, dr, ins->imm, ins->off);
+			break;
+		/* atomic add instructions */
+		case (BPF_STX | EBPF_XADD | BPF_W):
+		case (BPF_STX | EBPF_XADD | EBPF_DW):
+			emit_st_xadd(st, op, sr, dr, ins->off);
+			break;
+		/* jump instructions */
+		case (BPF_JMP | BPF_JA):
+			emit_jmp(st, ins->off + 1);
+			break;
+		/* jump IMM instructions */
+		case (BPF_JMP | BPF_JEQ | BPF_K):
+		case (BPF_JMP | EBPF_JNE | BPF_K):
+		case (BPF_JMP | BPF_JGT | BPF_K):
+		case (BPF_JMP | EBPF_JLT | BPF_K):
+		case (BPF_JMP | BPF_JGE | BPF_K):
+		case (BPF_JMP | EBPF_JLE | BPF_K):
+		case (BPF_JMP | EBPF_JSGT | BPF_K):
+		case (BPF_JMP | EBPF_JSLT | BPF_K):
+		case (BPF_JMP | EBPF_JSGE | BPF_K):
+		case (BPF_JMP | EBPF_JSLE | BPF_K):
+		case (BPF_JMP | BPF_JSET | BPF_K):
+			emit_jcc_imm(st, op, dr, ins->imm, ins->off + 1);
+			break;
+		/* jump REG instructions */
+		case (BPF_JMP | BPF_JEQ | BPF_X):
+		case (BPF_JMP | EBPF_JNE | BPF_X):
+		case (BPF_JMP | BPF_JGT | BPF_X):
+		case (BPF_JMP | EBPF_JLT | BPF_X):
+		case (BPF_JMP | BPF_JGE | BPF_X):
+		case (BPF_JMP | EBPF_JLE | BPF_X):
+		case (BPF_JMP | EBPF_JSGT | BPF_X):
+		case (BPF_JMP | EBPF_JSLT | BPF_X):
+		case (BPF_JMP | EBPF_JSGE | BPF_X):
+		case (BPF_JMP | EBPF_JSLE | BPF_X):
+		case (BPF_JMP | BPF_JSET | BPF_X):
+			emit_jcc_reg(st, op, sr, dr, ins->off + 1);
+			break;
+		/* call instructions */
+		case (BPF_JMP | EBPF_CALL):
+			emit_call(st,
+				(uintptr_t)bpf->prm.xsym[ins->imm].func.val);
+			break;
+		/* return instruction */
+		case (BPF_JMP | EBPF_EXIT):
+			emit_exit_jmp(st);
+			break;
+		default:
+			RTE_BPF_LOG(ERR,
+				"%s(%p): invalid opcode %#x at pc: %u;\n",
+				__func__, bpf, ins->code, i);
+			return -EINVAL;
+		}
+	}
+
+	emit_epilog(st);
+	emit_burst(st);
+	return 0;
+}
+
+/*
+ * check that the branches of the generated code are within range:
+ * +/-1MB for the conditional branches.
+ */
+static int
+check_size(const struct bpf_jit_state *st)
+{
+	return st->sz < (1 << 20) ? 0 : -ERANGE;
+}
+
+/*
+ * produce a native ISA version of the given BPF code.
+ */
+int
+bpf_jit_arm64(struct rte_bpf *bpf)
+{
+	int32_t rc;
+	uint32_t i;
+	size_t sz;
+	struct bpf_jit_state st;
+
+	/* init state */
+	memset(&st, 0, sizeof(st));
+	st.off = malloc(bpf->prm.nb_ins * sizeof(st.off[0]));
+	if (st.off == NULL)
+		return -ENOMEM;
+
+	/* fill with fake offsets */
+	st.exit.off = INT32_MAX;
+	for (i = 0; i != bpf->prm.nb_ins; i++)
+		st.off[i] = INT32_MAX;
+
+	/*
+	 * dry runs, used to calculate total code size and valid jump offsets.
+	 * stop when the size, depending on the registers in use, is stable.
+	 */
+	do {
+		sz = st.sz;
+		rc = emit(&st, bpf);
+	} while (rc == 0 && sz != st.sz);
+
+	if (rc == 0)
+		rc = check_size(&st);
+
+	if (rc == 0) {
+
+		/* allocate memory needed */
+		st.ins = mmap(NULL, st.sz, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (st.ins == MAP_FAILED) {
+			st.ins = NULL;
+			rc = -ENOMEM;
+		} else
+			/* generate code */
+			rc = emit(&st, bpf);
+	}
+
+	if (rc == 0) {
+		__builtin___clear_cache((char *)st.ins,
+			(char *)st.ins + st.sz);
+		if (mprotect(st.ins, st.sz, PROT_READ | PROT_EXEC) != 0)
+			rc = -ENOMEM;
+	}
+
+	if (rc != 0) {
+		if (st.ins != NULL)
+			munmap(st.ins, st.sz);
+	} else {
+		bpf->jit.func = (void *)st.ins;
+		bpf->jit.burst = (void *)((uintptr_t)st.ins + st.burst);
+		bpf->jit.sz = st.sz;
+	}
+
+	free(st.off);
+	return rc;
+}
@@ -103,6 +103,7 @@ struct bpf_jit_state {
 	uint32_t reguse;
 	int32_t *off;
 	uint8_t *ins;
+	size_t burst; /* offset of the burst entry point */
 };
 
 #define	INUSE(v, r)	(((v) >> (r)) & 1)
@@ -1109,6 +1110,77 @@ emit_epilog(struct bpf_jit_state *st)
 	emit_ret(st);
 }
 
+/*
+ * emit entry point to run the code for a burst of contexts:
+ * uint32_t burst(void *ctx[], uint64_t rc[], uint32_t num).
+ * Calls the code at offset zero for each context, while prefetching the
+ * context BPF_BURST_PREFETCH positions ahead.
+ */
+static void
+emit_burst(struct bpf_jit_state *st)
+{
+	int32_t joff;
+	size_t loop;
+
+	static const uint8_t prolog[] = {
+		0x53,			/* push %rbx */
+		0x41, 0x54,		/* push %r12 */
+		0x41, 0x55,		/* push %r13 */
+		0x41, 0x56,		/* push %r14 */
+		0x41, 0x57,		/* push %r15, keeps %rsp 16B aligned */
+		0x48, 0x89, 0xfb,	/* mov %rdi, %rbx */
+		0x49, 0x89, 0xf4,	/* mov %rsi, %r12 */
+		0x41, 0x89, 0xd5,	/* mov %edx, %r13d */
+		0x45, 0x31, 0xf6,	/* xor %r14d, %r14d */
+		0x45, 0x85, 0xed,	/* test %r13d, %r13d */
+	};
+	static const uint8_t prefetch[] = {
+		0x49, 0x8d, 0x46, BPF_BURST_PREFETCH, /* lea ofs(%r14), %rax */
+		0x4c, 0x39, 0xe8,	/* cmp %r13, %rax */
+		0x73, 0x07,		/* jae 1f */
+		0x48, 0x8b, 0x04, 0xc3,	/* mov (%rbx,%rax,8), %rax */
+		0x0f, 0x18, 0x08,	/* prefetcht0 (%rax) */
+		0x4a, 0x8b, 0x3c, 0xf3,	/* 1: mov (%rbx,%r14,8), %rdi */
+	};
+	static const uint8_t next[] = {
+		0x4b, 0x89, 0x04, 0xf4,	/* mov %rax, (%r12,%r14,8) */
+		0x49, 0xff, 0xc6,	/* inc %r14 */
+		0x4d, 0x39, 0xee,	/* cmp %r13, %r14 */
+	};
+	static const uint8_t epilog[] = {
+		0x44, 0x89, 0xe8,	/* mov %r13d, %eax */
+		0x41, 0x5f,		/* pop %r15 */
+		0x41, 0x5e,		/* pop %r14 */
+		0x41, 0x5d,		/* pop %r13 */
+		0x41, 0x5c,		/* pop %r12 */
+		0x5b,			/* pop %rbx */
+		0xc3,			/* ret */
+	};
+	static const uint8_t jz = 0x74, jnz = 0x75, call = 0xE8;
+
+	/* size of the loop body, with its jnz rel8 */
+	const int32_t lsz = sizeof(prefetch) + sizeof(call) + sizeof(int32_t) +
+		sizeof(next) + 2;
+
+	st->burst = st->sz;
+
+	emit_bytes(st, prolog, sizeof(prolog));
+	emit_bytes(st, &jz, sizeof(jz));
+	emit_imm(st, lsz, sizeof(uint8_t));
+
+	loop = st->sz;
+	emit_bytes(st, prefetch, sizeof(prefetch));
+	emit_bytes(st, &call, sizeof(call));
+	joff = -(int32_t)(st->sz + sizeof(int32_t));
+	emit_imm(st, joff, sizeof(int32_t));
+	emit_bytes(st, next, sizeof(next));
+	emit_bytes(st, &jnz, sizeof(jnz));
+	joff = loop - (st->sz + sizeof(uint8_t));
+	emit_imm(st, joff, sizeof(uint8_t));
+
+	emit_bytes(st, epilog, sizeof(epilog));
+}
+
 /*
  * walk through bpf code and translate them x86_64 one.
  */
@@ -1307,6 +1379,7 @@ emit(struct bpf_jit_state *st, const struct rte_bpf *bpf)
 		}
 	}
 
+	emit_burst(st);
 	return 0;
 }
 
@@ -1360,6 +1433,7 @@ bpf_jit_x86(struct rte_bpf *bpf)
 		munmap(st.ins, st.sz);
 	else {
 		bpf->jit.func = (void *)st.ins;
+		bpf->jit.burst = (void *)(st.ins + st.burst);
 		bpf->jit.sz = st.sz;
 	}
 
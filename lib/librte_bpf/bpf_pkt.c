@@ -179,7 +179,13 @@ apply_filter(struct rte_mbuf *mb[], const uint64_t rc[], uint32_t num,
 	uint32_t i, j, k;
 	struct rte_mbuf *dr[num];
 
-	for (i = 0, j = 0, k = 0; i != num; i++) {
+	/* matching packets before the first filtered out one stay in place */
+	for (i = 0; i != num && rc[i] != 0; i++)
+		;
+	if (i == num)
+		return num;
+
+	for (j = i, k = 0; i != num; i++) {
 
 		/* filter matches */
 		if (rc[i] != 0)
@@ -221,21 +227,15 @@ static inline uint32_t
 pkt_filter_jit(const struct rte_bpf_jit *jit, struct rte_mbuf *mb[],
 	uint32_t num, uint32_t drop)
 {
-	uint32_t i, n;
-	void *dp;
+	uint32_t i;
+	void *dp[num];
 	uint64_t rc[num];
 
-	n = 0;
-	for (i = 0; i != num; i++) {
-		dp = rte_pktmbuf_mtod(mb[i], void *);
-		rc[i] = jit->func(dp);
-		n += (rc[i] == 0);
-	}
-
-	if (n != 0)
-		num = apply_filter(mb, rc, num, drop);
+	for (i = 0; i != num; i++)
+		dp[i] = rte_pktmbuf_mtod(mb[i], void *);
 
-	return num;
+	jit->burst(dp, rc, num);
+	return apply_filter(mb, rc, num, drop);
 }
 
 static inline uint32_t
@@ -252,19 +252,10 @@ static inline uint32_t
 pkt_filter_mb_jit(const struct rte_bpf_jit *jit, struct rte_mbuf *mb[],
 	uint32_t num, uint32_t drop)
 {
-	uint32_t i, n;
 	uint64_t rc[num];
 
-	n = 0;
-	for (i = 0; i != num; i++) {
-		rc[i] = jit->func(mb[i]);
-		n += (rc[i] == 0);
-	}
-
-	if (n != 0)
-		num = apply_filter(mb, rc, num, drop);
-
-	return num;
+	jit->burst((void **)mb, rc, num);
+	return apply_filter(mb, rc, num, drop);
 }
 
 /*
@@ -103,6 +103,11 @@ struct rte_bpf_prm {
 struct rte_bpf_jit {
 	uint64_t (*func)(void *); /**< JIT-ed native code */
 	size_t sz;                /**< size of JIT-ed code */
+	/**
+	 * JIT-ed native code running func() for each of the *num* contexts,
+	 * storing the return values into *rc*. Returns *num*.
+	 */
+	uint32_t (*burst)(void *ctx[], uint64_t rc[], uint32_t num);
 };
 
 struct rte_bpf;
@@ -14,6 +14,8 @@
 #include <rte_string_fns.h>
 #include <rte_eal_memconfig.h>
 #include <rte_pause.h>
+#include <rte_ring.h>
+#include <rte_cpuflags.h>
 
 #include "rte_distributor_private.h"
 #include "rte_distributor.h"
@@ -29,6 +31,61 @@ EAL_REGISTER_TAILQ(rte_dist_burst_tailq)
 
 /**** APIs called by workers ****/
 
+/**** Ring mode APIs called by workers ****/
+
+/*
+ * Completes the packets the worker got last, unpinning their flows once
+ * no packet of the flow remains in flight.
+ */
+static inline void
+ring_complete(struct rte_distributor *d, unsigned int worker_id)
+{
+	struct rte_distributor_ring_worker *rw = &d->dr->workers[worker_id];
+	unsigned int i;
+
+	for (i = 0; i < rw->last_count; i++)
+		rte_atomic16_dec(&d->dr->flows[rw->last_tags[i] >> 1].inflight);
+
+	rw->done += rw->last_count;
+	rw->last_count = 0;
+}
+
+/*
+ * Returns packets directly to the returns ring, without going through the
+ * distributor core. As with the returns array of the burst mode, packets
+ * which do not fit because the application does not get the returns are
+ * lost.
+ */
+static inline void
+ring_return(struct rte_distributor *d, struct rte_mbuf **oldpkt,
+		unsigned int count)
+{
+	if (count > 0)
+		rte_ring_mp_enqueue_burst(d->dr->returns, (void **)oldpkt,
+				count, NULL);
+}
+
+static inline int
+ring_poll(struct rte_distributor *d, unsigned int worker_id,
+		struct rte_mbuf **pkts)
+{
+	struct rte_distributor_ring_worker *rw = &d->dr->workers[worker_id];
+	unsigned int count;
+	unsigned int i;
+
+	/* The packets got last must be completed first */
+	if (rw->last_count != 0)
+		return -1;
+
+	count = rte_ring_sc_dequeue_burst(rw->ring, (void **)pkts,
+			RTE_DIST_BURST_SIZE, NULL);
+	for (i = 0; i < count; i++)
+		rw->last_tags[i] = (uint16_t)(pkts[i]->hash.usr) | 1;
+	rw->last_count = count;
+
+	return count;
+}
+
 /**** Burst Packet APIs called by workers ****/
 
 void
@@ -41,6 +98,12 @@ rte_distributor_request_pkt_v1705(struct rte_distributor *d,
 
 	volatile int64_t *retptr64;
 
+	if (d->alg_type == RTE_DIST_ALG_RING) {
+		ring_complete(d, worker_id);
+		ring_return(d, oldpkt, count);
+		return;
+	}
+
 	if (unlikely(d->alg_type == RTE_DIST_ALG_SINGLE)) {
 		rte_distributor_request_pkt_v20(d->d_v20,
 			worker_id, oldpkt[0]);
@@ -92,6 +155,9 @@ rte_distributor_poll_pkt_v1705(struct rte_distributor *d,
 	int count = 0;
 	unsigned int i;
 
+	if (d->alg_type == RTE_DIST_ALG_RING)
+		return ring_poll(d, worker_id, pkts);
+
 	if (unlikely(d->alg_type == RTE_DIST_ALG_SINGLE)) {
 		pkts[0] = rte_distributor_poll_pkt_v20(d->d_v20, worker_id);
 		return (pkts[0]) ? 1 : 0;
@@ -130,6 +196,13 @@ rte_distributor_get_pkt_v1705(struct rte_distributor *d,
 {
 	int count;
 
+	if (d->alg_type == RTE_DIST_ALG_RING) {
+		/* Do not wait, the worker ring may stay empty */
+		ring_complete(d, worker_id);
+		ring_return(d, oldpkt, return_count);
+		return ring_poll(d, worker_id, pkts);
+	}
+
 	if (unlikely(d->alg_type == RTE_DIST_ALG_SINGLE)) {
 		if (return_count <= 1) {
 			pkts[0] = rte_distributor_get_pkt_v20(d->d_v20,
@@ -165,6 +238,12 @@ rte_distributor_return_pkt_v1705(struct rte_distributor *d,
 	struct rte_distributor_buffer *buf = &d->bufs[worker_id];
 	unsigned int i;
 
+	if (d->alg_type == RTE_DIST_ALG_RING) {
+		ring_complete(d, worker_id);
+		ring_return(d, oldpkt, num);
+		return 0;
+	}
+
 	if (unlikely(d->alg_type == RTE_DIST_ALG_SINGLE)) {
 		if (num == 1)
 			return rte_distributor_return_pkt_v20(d->d_v20,
@@ -193,6 +272,90 @@ MAP_STATIC_SYMBOL(int rte_distributor_return_pkt(struct rte_distributor *d,
 
 /**** APIs called on distributor core ***/
 
+/* Number of packets given to a worker in ring mode and not completed yet */
+static inline unsigned int
+ring_worker_load(const struct rte_distributor_ring_worker *rw)
+{
+	return rw->sent - rw->done;
+}
+
+/*
+ * Pick the less loaded of the next two workers in turn for a flow not in
+ * flight, which keeps the choice constant-time whatever the number of
+ * workers.
+ */
+static inline unsigned int
+ring_pick_worker(struct rte_distributor *d)
+{
+	struct rte_distributor_ring *dr = d->dr;
+	unsigned int w1 = dr->next_worker;
+	unsigned int w2 = (w1 + 1 == d->num_workers) ? 0 : w1 + 1;
+
+	dr->next_worker = w2;
+
+	return ring_worker_load(&dr->workers[w2]) <
+		ring_worker_load(&dr->workers[w1]) ? w2 : w1;
+}
+
+/* Moves as many staged packets of a worker as fit to the worker ring */
+static inline unsigned int
+ring_release(struct rte_distributor_ring_worker *rw)
+{
+	unsigned int n;
+
+	if (rw->stage_count == 0)
+		return 0;
+
+	n = rte_ring_sp_enqueue_burst(rw->ring, (void **)rw->stage,
+			rw->stage_count, NULL);
+	if (n < rw->stage_count)
+		memmove(rw->stage, &rw->stage[n],
+			(rw->stage_count - n) * sizeof(rw->stage[0]));
+	rw->stage_count -= n;
+
+	return n;
+}
+
+/*
+ * Process a set of packets in ring mode. The flow of each packet is looked
+ * up in the flow table instead of being matched against the tags in flight
+ * on every worker, and no handshake with the workers is needed.
+ */
+static int
+ring_process(struct rte_distributor *d,
+		struct rte_mbuf **mbufs, unsigned int num_mbufs)
+{
+	struct rte_distributor_ring *dr = d->dr;
+	unsigned int i, wid;
+
+	for (i = 0; i < num_mbufs; i++) {
+		struct rte_mbuf *next_mb = mbufs[i];
+		/* flows MUST be non-zero */
+		uint16_t new_tag = (uint16_t)(next_mb->hash.usr) | 1;
+		struct rte_distributor_flow *flow = &dr->flows[new_tag >> 1];
+		struct rte_distributor_ring_worker *rw;
+
+		/* A flow with no packet in flight may move to any worker */
+		if (rte_atomic16_read(&flow->inflight) == 0)
+			flow->worker = ring_pick_worker(d);
+		rte_atomic16_inc(&flow->inflight);
+
+		rw = &dr->workers[flow->worker];
+		/* Wait for a worker lagging behind by a full ring */
+		while (unlikely(rw->stage_count == RTE_DIST_RING_STAGE_SIZE))
+			if (ring_release(rw) == 0)
+				rte_pause();
+
+		rw->stage[rw->stage_count++] = next_mb;
+		rw->sent++;
+	}
+
+	for (wid = 0; wid < d->num_workers; wid++)
+		ring_release(&dr->workers[wid]);
+
+	return num_mbufs;
+}
+
 /* stores a packet returned from a worker inside the returns array */
 static inline void
 store_return(uintptr_t oldbuf, struct rte_distributor *d,
@@ -351,6 +514,9 @@ rte_distributor_process_v1705(struct rte_distributor *d,
 		return rte_distributor_process_v20(d->d_v20, mbufs, num_mbufs);
 	}
 
+	if (d->alg_type == RTE_DIST_ALG_RING)
+		return ring_process(d, mbufs, num_mbufs);
+
 	if (unlikely(num_mbufs == 0)) {
 		/* Flush out all non-full cache-lines to workers. */
 		for (wid = 0 ; wid < d->num_workers; wid++) {
@@ -385,6 +551,11 @@ rte_distributor_process_v1705(struct rte_distributor *d,
 			flows[i] = 0;
 
 		switch (d->dist_match_fn) {
+#ifdef CC_AVX2_SUPPORT
+		case RTE_DIST_MATCH_VECTOR_AVX2:
+			find_match_avx2(d, &flows[0], &matches[0]);
+			break;
+#endif
 		case RTE_DIST_MATCH_VECTOR:
 			find_match_vec(d, &flows[0], &matches[0]);
 			break;
@@ -490,6 +661,10 @@ rte_distributor_returned_pkts_v1705(struct rte_distributor *d,
 				mbufs, max_mbufs);
 	}
 
+	if (d->alg_type == RTE_DIST_ALG_RING)
+		return rte_ring_sc_dequeue_burst(d->dr->returns,
+				(void **)mbufs, max_mbufs, NULL);
+
 	for (i = 0; i < retval; i++) {
 		unsigned int idx = (returns->start + i) &
 				RTE_DISTRIB_RETURNS_MASK;
@@ -515,6 +690,12 @@ total_outstanding(const struct rte_distributor *d)
 {
 	unsigned int wkr, total_outstanding = 0;
 
+	if (d->alg_type == RTE_DIST_ALG_RING) {
+		for (wkr = 0; wkr < d->num_workers; wkr++)
+			total_outstanding += d->dr->workers[wkr].stage_count;
+		return total_outstanding;
+	}
+
 	for (wkr = 0; wkr < d->num_workers; wkr++)
 		total_outstanding += d->backlog[wkr].count;
 
@@ -541,6 +722,10 @@ rte_distributor_flush_v1705(struct rte_distributor *d)
 	while (total_outstanding(d) > 0)
 		rte_distributor_process(d, NULL, 0);
 
+	/* The workers do not wait for packets in ring mode */
+	if (d->alg_type == RTE_DIST_ALG_RING)
+		return flushed;
+
 	/*
 	 * Send empty burst to all workers to allow them to exit
 	 * gracefully, should they need to.
@@ -568,6 +753,15 @@ rte_distributor_clear_returns_v1705(struct rte_distributor *d)
 		return;
 	}
 
+	if (d->alg_type == RTE_DIST_ALG_RING) {
+		struct rte_mbuf *mbufs[RTE_DIST_BURST_SIZE];
+
+		while (rte_ring_sc_dequeue_burst(d->dr->returns,
+				(void **)mbufs, RTE_DIST_BURST_SIZE, NULL) > 0)
+			;
+		return;
+	}
+
 	/* throw away returns, so workers can exit */
 	for (wkr = 0; wkr < d->num_workers; wkr++)
 		d->bufs[wkr].retptr64[0] = 0;
@@ -576,6 +770,56 @@ BIND_DEFAULT_SYMBOL(rte_distributor_clear_returns, _v1705, 17.05);
 MAP_STATIC_SYMBOL(void rte_distributor_clear_returns(struct rte_distributor *d),
 		rte_distributor_clear_returns_v1705);
 
+/* creates the per-worker rings and flow table of the ring mode */
+static int
+ring_create(struct rte_distributor *d, const char *name,
+		unsigned int socket_id)
+{
+	char mz_name[RTE_MEMZONE_NAMESIZE];
+	char ring_name[RTE_RING_NAMESIZE];
+	const struct rte_memzone *mz;
+	struct rte_distributor_ring *dr;
+	unsigned int i;
+
+	snprintf(mz_name, sizeof(mz_name), RTE_DISTRIB_RING_PREFIX"%s", name);
+	mz = rte_memzone_reserve(mz_name, sizeof(*dr), socket_id, NO_FLAGS);
+	if (mz == NULL) {
+		rte_errno = ENOMEM;
+		return -1;
+	}
+
+	dr = mz->addr;
+	memset(dr, 0, sizeof(*dr));
+
+	snprintf(ring_name, sizeof(ring_name), RTE_DISTRIB_RING_PREFIX"%s",
+			name);
+	dr->returns = rte_ring_create(ring_name, RTE_DIST_RING_RETURNS_SIZE,
+			socket_id, RING_F_SC_DEQ);
+	if (dr->returns == NULL)
+		goto error;
+
+	for (i = 0; i < d->num_workers; i++) {
+		snprintf(ring_name, sizeof(ring_name),
+				RTE_DISTRIB_RING_PREFIX"%s_%u", name, i);
+		dr->workers[i].ring = rte_ring_create(ring_name,
+				RTE_DIST_RING_SIZE, socket_id,
+				RING_F_SP_ENQ | RING_F_SC_DEQ);
+		if (dr->workers[i].ring == NULL)
+			goto error;
+	}
+
+	d->dr = dr;
+	return 0;
+
+error:
+	/* rte_errno will have been set */
+	for (i = 0; i < d->num_workers; i++)
+		rte_ring_free(dr->workers[i].ring);
+	rte_ring_free(dr->returns);
+	rte_memzone_free(mz);
+	return -1;
+}
+
 /* creates a distributor instance */
 struct rte_distributor *
 rte_distributor_create_v1705(const char *name,
@@ -612,7 +856,8 @@ rte_distributor_create_v1705(const char *name,
 		return d;
 	}
 
-	if (name == NULL || num_workers >= RTE_DISTRIB_MAX_WORKERS) {
+	if (name == NULL || num_workers >= RTE_DISTRIB_MAX_WORKERS ||
+			alg_type >= RTE_DIST_NUM_ALG_TYPES) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
@@ -633,6 +878,17 @@ rte_distributor_create_v1705(const char *name,
 #if defined(RTE_ARCH_X86)
 	d->dist_match_fn = RTE_DIST_MATCH_VECTOR;
 #endif
+#ifdef CC_AVX2_SUPPORT
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2))
+		d->dist_match_fn = RTE_DIST_MATCH_VECTOR_AVX2;
+#endif
+
+	d->dr = NULL;
+	if (alg_type == RTE_DIST_ALG_RING && ring_create(d, name, socket_id)) {
+		rte_memzone_free(mz);
+		/* rte_errno will have been set */
+		return NULL;
+	}
 
 	/*
 	 * Set up the backlog tags so they're pointing at the second cache
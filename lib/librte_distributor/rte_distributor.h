@@ -17,10 +17,12 @@
 extern "C" {
 #endif
 
-/* Type of distribution (burst/single) */
+/* Type of distribution (burst/single/ring) */
 enum rte_distributor_alg_type {
 	RTE_DIST_ALG_BURST = 0,
 	RTE_DIST_ALG_SINGLE,
+	RTE_DIST_ALG_RING,
+	/**< @warning @b EXPERIMENTAL: burst API over per-worker rings */
 	RTE_DIST_NUM_ALG_TYPES
 };
 
@@ -44,6 +46,12 @@ struct rte_mbuf;
  *   Call the legacy API, or use the new burst API. legacy uses 32-bit
  *   flow ID, and works on a single packet at a time. Latest uses 15-
  *   bit flow ID and works on up to 8 packets at a time to workers.
+ *   The ring mode (RTE_DIST_ALG_RING) uses the burst API, but passes the
+ *   packets to the workers through per-worker rings of 256 packets without
+ *   waiting for them, and the workers return packets to a ring without
+ *   going through the distributor lcore. In this mode, a worker does not
+ *   wait for packets in rte_distributor_get_pkt(), and a worker must not
+ *   stop while packets are queued to it.
  * @return
  *   The newly created distributor instance
  */
@@ -91,7 +99,8 @@ rte_distributor_process(struct rte_distributor *d,
 /**
  * Get a set of mbufs that have been returned to the distributor by workers
  *
- * This should only be called on the same lcore as rte_distributor_process()
+ * This should only be called on the same lcore as rte_distributor_process(),
+ * except in ring mode where it may be called on any single lcore.
  *
  * @param d
  *   The distributor instance to be used
@@ -160,7 +169,7 @@ rte_distributor_clear_returns(struct rte_distributor *d);
  *   The number of packets being returned
  *
  * @return
- *   The number of packets in the pkts array
+ *   The number of packets in the pkts array, possibly zero in ring mode
  */
 int
 rte_distributor_get_pkt(struct rte_distributor *d,
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <rte_mbuf.h>
+#include "rte_distributor_private.h"
+#include "rte_distributor.h"
+#include <immintrin.h>
+
+
+void
+find_match_avx2(struct rte_distributor *d,
+			uint16_t *data_ptr,
+			uint16_t *output_ptr)
+{
+	/* Setup */
+	__m256i incoming_fids;
+	__m256i worker_fids;
+	__m256i rotated_fids;
+	__m256i wkr;
+	__m256i mask;
+	__m256i output;
+	__m128i output_lanes;
+	uint16_t i, j;
+
+	/*
+	 * Function overview:
+	 * 1. Load the incoming flow ids into both 128-bit lanes of a ymm reg
+	 * 2. Loop through all worker ID's
+	 *  2a. Load the inflights (low lane) and the backlog (high lane) of
+	 *      that worker into a single ymm reg, as the backlog tags are the
+	 *      second half of the in_flight_tags row
+	 *  2b. Compare the incoming flow ids to each rotation of the tags,
+	 *      covering all the pairs of both lanes in 8 compares
+	 *  2c. Add any matches to the output
+	 * 3. Fold the two lanes of the output and write it (matching worker
+	 *    ids).
+	 */
+
+	output = _mm256_setzero_si256();
+	incoming_fids = _mm256_broadcastsi128_si256(
+			_mm_load_si128((__m128i *)data_ptr));
+
+	for (i = 0; i < d->num_workers; i++) {
+		worker_fids =
+			_mm256_load_si256((__m256i *)&(d->in_flight_tags[i]));
+
+		mask = _mm256_cmpeq_epi16(incoming_fids, worker_fids);
+		rotated_fids = worker_fids;
+		for (j = 1; j < RTE_DIST_BURST_SIZE; j++) {
+			rotated_fids = _mm256_alignr_epi8(rotated_fids,
+					rotated_fids, sizeof(uint16_t));
+			mask = _mm256_or_si256(mask,
+				_mm256_cmpeq_epi16(incoming_fids,
+						rotated_fids));
+		}
+
+		/*
+		 * Now mask contains 0xffff where there's a match, in either
+		 * lane. Next we need to store the worker_id in the relevant
+		 * position in the output.
+		 */
+		wkr = _mm256_set1_epi16(i+1);
+		mask = _mm256_and_si256(mask, wkr);
+		output = _mm256_or_si256(mask, output);
+	}
+
+	/*
+	 * At this stage, each lane of the output contains 8 16-bit values,
+	 * with each non-zero value containing the worker ID on which the
+	 * corresponding flow is pinned to.
+	 */
+	output_lanes = _mm_or_si128(_mm256_castsi256_si128(output),
+			_mm256_extracti128_si256(output, 1));
+	_mm_store_si128((__m128i *)output_ptr, output_lanes);
+}
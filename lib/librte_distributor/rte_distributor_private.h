@@ -19,6 +19,7 @@ extern "C" {
 
 #define NO_FLAGS 0
 #define RTE_DISTRIB_PREFIX "DT_"
+#define RTE_DISTRIB_RING_PREFIX "DR_"
 
 /*
  * We will use the bottom four bits of pointer for flags, shifting out
@@ -105,6 +106,7 @@ struct rte_distributor_v20 {
 enum rte_distributor_match_function {
 	RTE_DIST_MATCH_SCALAR = 0,
 	RTE_DIST_MATCH_VECTOR,
+	RTE_DIST_MATCH_VECTOR_AVX2,
 	RTE_DIST_NUM_MATCH_FNS
 };
 
@@ -130,6 +132,45 @@ struct rte_distributor_buffer {
 	int count __rte_cache_aligned;       /* <= number of current mbufs */
 };
 
+/*
+ * Ring mode: packets are passed to the workers through per-worker rings,
+ * without any handshake, and returned packets go to a multi-producer ring
+ * drained by rte_distributor_returned_pkts() on any core.
+ * Flows are pinned to a worker as long as some of their packets are in
+ * flight, tracked with a counter per flow tag.
+ */
+#define RTE_DIST_RING_SIZE 256          /**< Depth of each worker ring */
+#define RTE_DIST_RING_STAGE_SIZE 64     /**< Packets staged per worker */
+#define RTE_DIST_RING_RETURNS_SIZE 4096 /**< Depth of the returns ring */
+#define RTE_DIST_RING_FLOWS (1 << 15)   /**< Flow tags are odd 16-bit */
+
+struct rte_distributor_flow {
+	rte_atomic16_t inflight; /* packets of the flow not completed yet */
+	uint16_t worker;         /* worker the flow is pinned to */
+};
+
+struct rte_distributor_ring_worker {
+	struct rte_ring *ring;               /* <= outgoing to worker */
+
+	/* Written by the distributor. */
+	uint64_t sent;
+	unsigned int stage_count;
+	struct rte_mbuf *stage[RTE_DIST_RING_STAGE_SIZE];
+
+	/* Written by the worker. */
+	volatile uint64_t done __rte_cache_aligned;
+	unsigned int last_count;
+	uint16_t last_tags[RTE_DIST_BURST_SIZE];
+} __rte_cache_aligned;
+
+struct rte_distributor_ring {
+	struct rte_ring *returns;            /* <= incoming from workers */
+	unsigned int next_worker;
+	struct rte_distributor_ring_worker workers[RTE_DISTRIB_MAX_WORKERS];
+	struct rte_distributor_flow flows[RTE_DIST_RING_FLOWS]
+			__rte_cache_aligned;
+};
+
 struct rte_distributor {
 	TAILQ_ENTRY(rte_distributor) next;    /**< Next in list. */
 
@@ -155,6 +196,8 @@ struct rte_distributor {
 	enum rte_distributor_match_function dist_match_fn;
 
 	struct rte_distributor_v20 *d_v20;
+
+	struct rte_distributor_ring *dr;      /**< Ring mode state */
 };
 
 void
@@ -167,6 +210,11 @@ find_match_vec(struct rte_distributor *d,
 			uint16_t *data_ptr,
 			uint16_t *output_ptr);
 
+void
+find_match_avx2(struct rte_distributor *d,
+			uint16_t *data_ptr,
+			uint16_t *output_ptr);
+
 #ifdef __cplusplus
 }
 #endif
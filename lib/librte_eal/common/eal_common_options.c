@@ -63,6 +63,8 @@ eal_long_options[] = {
 	{OPT_LOG_LEVEL,         1, NULL, OPT_LOG_LEVEL_NUM        },
 	{OPT_MASTER_LCORE,      1, NULL, OPT_MASTER_LCORE_NUM     },
 	{OPT_MBUF_POOL_OPS_NAME, 1, NULL, OPT_MBUF_POOL_OPS_NAME_NUM},
+	{OPT_MEM_INIT_THREADS,  1, NULL, OPT_MEM_INIT_THREADS_NUM },
+	{OPT_MALLOC_LCORE_CACHE, 0, NULL, OPT_MALLOC_LCORE_CACHE_NUM},
 	{OPT_NO_HPET,           0, NULL, OPT_NO_HPET_NUM          },
 	{OPT_NO_HUGE,           0, NULL, OPT_NO_HUGE_NUM          },
 	{OPT_NO_PCI,            0, NULL, OPT_NO_PCI_NUM           },
@@ -193,6 +195,8 @@ eal_reset_internal_config(struct internal_config *internal_cfg)
 		internal_cfg->hugepage_info[i].lock_descriptor = -1;
 	}
 	internal_cfg->base_virtaddr = 0;
+	internal_cfg->mem_init_threads = 1;
+	internal_cfg->malloc_lcore_cache = 0;
 
 	internal_cfg->syslog_facility = LOG_DAEMON;
 
@@ -1302,6 +1306,9 @@ eal_parse_common_option(int opt, const char *optarg,
 	case OPT_SINGLE_FILE_SEGMENTS_NUM:
 		conf->single_file_segments = 1;
 		break;
+	case OPT_MALLOC_LCORE_CACHE_NUM:
+		conf->malloc_lcore_cache = 1;
+		break;
 	case OPT_IOVA_MODE_NUM:
 		if (eal_parse_iova_mode(optarg) < 0) {
 			RTE_LOG(ERR, EAL, "invalid parameters for --"
@@ -1411,6 +1418,11 @@ eal_check_common_options(struct internal_config *internal_cfg)
 		RTE_LOG(ERR, EAL, "Option --"OPT_SOCKET_LIMIT
 			" is only supported in non-legacy memory mode\n");
 	}
+	if (internal_cfg->mem_init_threads > 1 && internal_cfg->legacy_mem) {
+		RTE_LOG(ERR, EAL, "Option --"OPT_MEM_INIT_THREADS
+			" is only supported in non-legacy memory mode\n");
+		return -1;
+	}
 	if (internal_cfg->single_file_segments &&
 			internal_cfg->hugepage_unlink &&
 			!internal_cfg->in_memory) {
@@ -1476,6 +1488,8 @@ eal_common_usage(void)
 	       "  -h, --help          This help\n"
 	       "  --"OPT_IN_MEMORY"   Operate entirely in memory. This will\n"
 	       "                      disable secondary process support\n"
+	       "  --"OPT_MALLOC_LCORE_CACHE" Cache small rte_malloc() elements\n"
+	       "                      per lcore\n"
 	       "\nEAL options for DEBUG use only:\n"
 	       "  --"OPT_HUGE_UNLINK"       Unlink hugepage files after init\n"
 	       "  --"OPT_NO_HUGE"           Use malloc instead of hugetlbfs\n"
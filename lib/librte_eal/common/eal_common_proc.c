@@ -101,6 +101,28 @@ static struct {
 	/**< used in async requests only */
 };
 
+/*
+ * Messages and requests are run by a pool of workers, so that a slow
+ * callback does not hold the others, and callbacks may wait for the reply
+ * to their own requests, the replies being handled by the reading thread.
+ * The messages of a peer always go to the same worker, in order.
+ */
+#define MP_WORKERS 4
+
+struct mp_work {
+	TAILQ_ENTRY(mp_work) next;
+	struct mp_msg_internal m;
+	struct sockaddr_un sa;
+};
+
+TAILQ_HEAD(mp_work_list, mp_work);
+
+static struct mp_worker {
+	struct mp_work_list works;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} mp_workers[MP_WORKERS];
+
 /* forward declarations */
 static int
 mp_send(struct rte_mp_msg *msg, const char *peer, int type);
@@ -350,20 +372,101 @@ process_msg(struct mp_msg_internal *m, struct sockaddr_un *s)
 	}
 }
 
+static void *
+mp_worker_handle(void *arg)
+{
+	struct mp_worker *worker = arg;
+	struct mp_work *work;
+
+	while (1) {
+		pthread_mutex_lock(&worker->lock);
+		while (TAILQ_EMPTY(&worker->works))
+			pthread_cond_wait(&worker->cond, &worker->lock);
+		work = TAILQ_FIRST(&worker->works);
+		TAILQ_REMOVE(&worker->works, work, next);
+		pthread_mutex_unlock(&worker->lock);
+
+		process_msg(&work->m, &work->sa);
+		free(work);
+	}
+
+	return NULL;
+}
+
+/* pick the worker of a peer, by hashing its socket path */
+static struct mp_worker *
+mp_worker_get(const char *peer)
+{
+	uint32_t hash = 2166136261;
+
+	while (*peer != '\0')
+		hash = (hash ^ (uint8_t)*peer++) * 16777619;
+
+	return &mp_workers[hash % MP_WORKERS];
+}
+
 static void *
 mp_handle(void *arg __rte_unused)
 {
-	struct mp_msg_internal msg;
-	struct sockaddr_un sa;
+	struct mp_work *work = NULL;
+	struct mp_worker *worker;
 
 	while (1) {
-		if (read_msg(&msg, &sa) == 0)
-			process_msg(&msg, &sa);
+		if (work == NULL) {
+			work = malloc(sizeof(*work));
+			if (work == NULL) {
+				RTE_LOG(ERR, EAL, "Cannot allocate mp work\n");
+				sleep(1);
+				continue;
+			}
+		}
+
+		if (read_msg(&work->m, &work->sa) != 0)
+			continue;
+
+		/* replies wake up the requesters, they are never delayed */
+		if (work->m.type == MP_REP || work->m.type == MP_IGN) {
+			process_msg(&work->m, &work->sa);
+			continue;
+		}
+
+		worker = mp_worker_get(work->sa.sun_path);
+		pthread_mutex_lock(&worker->lock);
+		TAILQ_INSERT_TAIL(&worker->works, work, next);
+		pthread_cond_signal(&worker->cond);
+		pthread_mutex_unlock(&worker->lock);
+		work = NULL;
 	}
 
 	return NULL;
 }
 
+static int
+mp_workers_init(void)
+{
+	char name[RTE_MAX_THREAD_NAME_LEN];
+	struct mp_worker *worker;
+	pthread_t tid;
+	unsigned int i;
+
+	for (i = 0; i < MP_WORKERS; i++) {
+		worker = &mp_workers[i];
+		TAILQ_INIT(&worker->works);
+		pthread_mutex_init(&worker->lock, NULL);
+		pthread_cond_init(&worker->cond, NULL);
+
+		snprintf(name, sizeof(name), "rte_mp_work%u", i);
+		if (rte_ctrl_thread_create(&tid, name, NULL,
+				mp_worker_handle, worker) < 0) {
+			RTE_LOG(ERR, EAL, "failed to create mp worker: %s\n",
+				strerror(errno));
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 static int
 timespec_cmp(const struct timespec *a, const struct timespec *b)
 {
@@ -615,6 +718,14 @@ rte_mp_channel_init(void)
 		return -1;
 	}
 
+	/* the workers are left waiting on failure, they hold nothing */
+	if (mp_workers_init() < 0) {
+		close(mp_fd);
+		close(dir_fd);
+		mp_fd = -1;
+		return -1;
+	}
+
 	if (rte_ctrl_thread_create(&mp_handle_tid, "rte_mp_handle",
 			NULL, mp_handle, NULL) < 0) {
 		RTE_LOG(ERR, EAL, "failed to create mp thead: %s\n",
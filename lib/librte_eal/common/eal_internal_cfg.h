@@ -53,6 +53,10 @@ struct internal_config {
 	volatile unsigned force_socket_limits;
 	volatile uint64_t socket_limit[RTE_MAX_NUMA_NODES]; /**< limit amount of memory per socket */
 	uintptr_t base_virtaddr;          /**< base address to try and reserve memory from */
+	volatile unsigned int mem_init_threads;
+	/**< number of threads allocating the memory preallocated at init */
+	volatile unsigned int malloc_lcore_cache;
+	/**< true to cache small rte_malloc() elements per lcore */
 	volatile unsigned legacy_mem;
 	/**< true to enable legacy memory behavior (no dynamic allocation,
 	 * IOVA-contiguous segments).
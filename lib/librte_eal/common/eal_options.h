@@ -65,6 +65,10 @@ enum {
 	OPT_SINGLE_FILE_SEGMENTS_NUM,
 #define OPT_IOVA_MODE          "iova-mode"
 	OPT_IOVA_MODE_NUM,
+#define OPT_MEM_INIT_THREADS   "mem-init-threads"
+	OPT_MEM_INIT_THREADS_NUM,
+#define OPT_MALLOC_LCORE_CACHE "malloc-lcore-cache"
+	OPT_MALLOC_LCORE_CACHE_NUM,
 	OPT_LONG_MAX_NUM
 };
 
@@ -11,4 +11,10 @@
 #include <rte_memcpy_32.h>
 #endif
 
+static inline void *
+rte_memcpy_nt(void *dst, const void *src, size_t n)
+{
+	return rte_memcpy(dst, src, n);
+}
+
 #endif /* _RTE_MEMCPY_ARM_H_ */
@@ -219,6 +219,12 @@ rte_memcpy_func(void *dst, const void *src, size_t n)
 	return ret;
 }
 
+static inline void *
+rte_memcpy_nt(void *dst, const void *src, size_t n)
+{
+	return rte_memcpy(dst, src, n);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -869,6 +869,71 @@ rte_memcpy(void *dst, const void *src, size_t n)
 		return rte_memcpy_generic(dst, src, n);
 }
 
+/**
+ * Size below which rte_memcpy_nt() uses regular stores only.
+ */
+#define RTE_MEMCPY_NT_MIN 256
+
+/**
+ * Copy 64 bytes to a 64 bytes aligned destination with non-temporal stores.
+ */
+static __rte_always_inline void
+rte_mov64_nt(uint8_t *dst, const uint8_t *src)
+{
+#if defined RTE_MACHINE_CPUFLAG_AVX512F
+	_mm512_stream_si512((__m512i *)(void *)dst,
+		_mm512_loadu_si512((const void *)src));
+#elif defined RTE_MACHINE_CPUFLAG_AVX2
+	_mm256_stream_si256((__m256i *)(void *)dst,
+		_mm256_loadu_si256((const __m256i *)(const void *)src));
+	_mm256_stream_si256((__m256i *)(void *)(dst + 32),
+		_mm256_loadu_si256((const __m256i *)(const void *)(src + 32)));
+#else
+	_mm_stream_si128((__m128i *)(void *)dst,
+		_mm_loadu_si128((const __m128i *)(const void *)src));
+	_mm_stream_si128((__m128i *)(void *)(dst + 16),
+		_mm_loadu_si128((const __m128i *)(const void *)(src + 16)));
+	_mm_stream_si128((__m128i *)(void *)(dst + 32),
+		_mm_loadu_si128((const __m128i *)(const void *)(src + 32)));
+	_mm_stream_si128((__m128i *)(void *)(dst + 48),
+		_mm_loadu_si128((const __m128i *)(const void *)(src + 48)));
+#endif
+}
+
+static inline void *
+rte_memcpy_nt(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	size_t head;
+
+	if (n < RTE_MEMCPY_NT_MIN)
+		return rte_memcpy(dst, src, n);
+
+	/* regular stores up to the first cache line boundary */
+	head = (-(uintptr_t)d) & 0x3F;
+	if (head != 0) {
+		rte_memcpy(d, s, head);
+		d += head;
+		s += head;
+		n -= head;
+	}
+
+	for (; n >= 64; n -= 64) {
+		rte_mov64_nt(d, s);
+		d += 64;
+		s += 64;
+	}
+
+	if (n != 0)
+		rte_memcpy(d, s, n);
+
+	/* order the streaming stores before the following ones */
+	_mm_sfence();
+
+	return dst;
+}
+
 #ifdef __cplusplus
 }
 #endif
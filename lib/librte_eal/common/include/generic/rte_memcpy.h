@@ -107,6 +107,31 @@ rte_mov256(uint8_t *dst, const uint8_t *src);
 static void *
 rte_memcpy(void *dst, const void *src, size_t n);
 
+/**
+ * Copy bytes from one location to another, bypassing the cache for the
+ * destination where the architecture supports it. The locations must not
+ * overlap.
+ *
+ * It is meant for large copies to memory which is not read again soon by
+ * the calling lcore, e.g. into the buffers of another process or of a
+ * guest, saving the read for ownership of each destination cache line and
+ * the eviction of useful data. Short copies, and the unaligned head of the
+ * destination, use regular stores.
+ * The copied data are visible to other lcores in the same order as with
+ * rte_memcpy(). Architectures without non-temporal stores use rte_memcpy().
+ *
+ * @param dst
+ *   Pointer to the destination of the data.
+ * @param src
+ *   Pointer to the source data.
+ * @param n
+ *   Number of bytes to copy.
+ * @return
+ *   Pointer to the destination data.
+ */
+static void *
+rte_memcpy_nt(void *dst, const void *src, size_t n);
+
 #endif /* __DOXYGEN__ */
 
 #endif /* _RTE_MEMCPY_H_ */
@@ -40,6 +40,7 @@
 #define _KEEPALIVE_H_
 
 #include <rte_config.h>
+#include <rte_compat.h>
 #include <rte_memory.h>
 
 #ifndef RTE_KEEPALIVE_MAXCORES
@@ -167,4 +168,24 @@ rte_keepalive_register_relay_callback(struct rte_keepalive *keepcfg,
 	rte_keepalive_relay_callback_t callback,
 	void *data);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the last state of a core, as seen by the keepalive checks.
+ *
+ * @param *keepcfg
+ *   Keepalive structure pointer
+ * @param id_core
+ *   ID of the core.
+ * @param last_alive
+ *   If not NULL, set to the TSC of the last check which found the core
+ *   alive.
+ * @return
+ *   State of the core, RTE_KA_STATE_UNUSED if it is not registered.
+ */
+enum rte_keepalive_state __rte_experimental
+rte_keepalive_get_core_state(const struct rte_keepalive *keepcfg,
+	int id_core, uint64_t *last_alive);
+
 #endif /* _KEEPALIVE_H_ */
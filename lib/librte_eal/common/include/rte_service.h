@@ -419,6 +419,77 @@ rte_service_lcore_attr_get(uint32_t lcore, uint32_t attr_id,
 int32_t __rte_experimental
 rte_service_lcore_attr_reset_all(uint32_t lcore);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the utilization of a service, as the percentage of the time of one
+ * lcore spent in its callback over the last balancing period, see
+ * *rte_service_balance*.
+ *
+ * @param id The service to get the utilization of.
+ * @param [out] utilization Pointer to storage in which to write the value.
+ * @retval 0 Success, the utilization has been written to *utilization*.
+ *         -EINVAL Invalid id or utilization was NULL.
+ *         -ENODATA No balancing period has completed yet.
+ */
+int32_t __rte_experimental
+rte_service_utilization_get(uint32_t id, uint32_t *utilization);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the utilization of a service core, as the percentage of its time
+ * spent in service callbacks over the last balancing period, see
+ * *rte_service_balance*.
+ *
+ * @param lcore Id of the service core.
+ * @param [out] utilization Pointer to storage in which to write the value.
+ * @retval 0 Success, the utilization has been written to *utilization*.
+ *         -EINVAL Invalid lcore or utilization was NULL.
+ *         -ENOTSUP lcore is not a service core.
+ *         -ENODATA No balancing period has completed yet.
+ */
+int32_t __rte_experimental
+rte_service_lcore_utilization_get(uint32_t lcore, uint32_t *utilization);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Measure the utilization of the services and service cores since the
+ * previous call, and move at most one service from the busiest running
+ * service core to the least busy one when it makes their load more even.
+ *
+ * Only the services mapped to a single service core are moved. While the
+ * balancer is in use, the cycles spent in every service callback are
+ * accounted, whether statistics are enabled for the service or not. The
+ * first call only starts the measurement.
+ *
+ * This function must not be called concurrently with itself or with the
+ * functions changing the service core mappings.
+ *
+ * @retval 1 A service has been moved.
+ * @retval 0 No service has been moved.
+ */
+int32_t __rte_experimental
+rte_service_balance(void);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Call *rte_service_balance* periodically from the EAL alarm thread.
+ *
+ * @param period_ms The balancing period in milliseconds, zero to stop the
+ *        automatic balancing and the accounting of the service cycles.
+ * @retval 0 Success
+ * @retval <0 The alarm could not be set
+ */
+int32_t __rte_experimental
+rte_service_balance_enable(uint32_t period_ms);
+
 #ifdef __cplusplus
 }
 #endif
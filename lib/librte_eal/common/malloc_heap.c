@@ -730,6 +730,29 @@ malloc_heap_alloc(const char *type, size_t size, int socket_arg,
 	return NULL;
 }
 
+unsigned int
+malloc_heap_alloc_bulk(unsigned int heap_id, size_t size, void **objs,
+		unsigned int n)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_heap *heap = &mcfg->malloc_heaps[heap_id];
+	unsigned int i;
+
+	/* only take what is already in the heap, growing it is left to
+	 * malloc_heap_alloc() as it may need to talk to other processes.
+	 */
+	rte_spinlock_lock(&(heap->lock));
+	for (i = 0; i < n; i++) {
+		objs[i] = heap_alloc(heap, NULL, size, 0, RTE_CACHE_LINE_SIZE,
+				0, false);
+		if (objs[i] == NULL)
+			break;
+	}
+	rte_spinlock_unlock(&(heap->lock));
+
+	return i;
+}
+
 static void *
 heap_alloc_biggest_on_heap_id(const char *type, unsigned int heap_id,
 		unsigned int flags, size_t align, bool contig)
@@ -989,6 +1012,26 @@ malloc_heap_free(struct malloc_elem *elem)
 	return ret;
 }
 
+void
+malloc_heap_free_bulk(struct malloc_heap *heap, void * const *objs,
+		unsigned int n)
+{
+	struct malloc_elem *elem;
+	unsigned int i;
+
+	/* no memory is given back to the system from here, elements freed in
+	 * bulk are small and a later malloc_heap_free() will release the
+	 * pages they were merged into.
+	 */
+	rte_spinlock_lock(&(heap->lock));
+	for (i = 0; i < n; i++) {
+		elem = malloc_elem_from_data(objs[i]);
+		elem->state = ELEM_FREE;
+		malloc_elem_free(elem);
+	}
+	rte_spinlock_unlock(&(heap->lock));
+}
+
 int
 malloc_heap_resize(struct malloc_elem *elem, size_t size)
 {
@@ -160,3 +160,16 @@ rte_keepalive_mark_sleep(struct rte_keepalive *keepcfg)
 {
 	keepcfg->live_data[rte_lcore_id()].core_state = RTE_KA_STATE_DOZING;
 }
+
+enum rte_keepalive_state __rte_experimental
+rte_keepalive_get_core_state(const struct rte_keepalive *keepcfg,
+	int id_core, uint64_t *last_alive)
+{
+	if (id_core < 0 || id_core >= RTE_KEEPALIVE_MAXCORES ||
+			keepcfg->active_cores[id_core] == 0)
+		return RTE_KA_STATE_UNUSED;
+
+	if (last_alive != NULL)
+		*last_alive = keepcfg->last_alive[id_core];
+	return keepcfg->live_data[id_core].core_state;
+}
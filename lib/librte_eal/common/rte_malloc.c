@@ -2,9 +2,11 @@
  * Copyright(c) 2010-2014 Intel Corporation
  */
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/queue.h>
 
@@ -25,12 +27,174 @@
 #include "malloc_elem.h"
 #include "malloc_heap.h"
 #include "eal_memalloc.h"
+#include "eal_internal_cfg.h"
 
+/*
+ * Per-lcore cache of small elements, enabled with --malloc-lcore-cache.
+ *
+ * Elements of up to 4K are rounded up to a power of 2 size class and kept
+ * in a per-lcore, per-socket stack when freed, so that most allocations and
+ * frees of an lcore do not take the heap lock. Cached elements are still
+ * allocated from the heap point of view, they are given back to it in bulk
+ * when a stack overflows or when the heap runs out of memory.
+ */
+#define MALLOC_CACHE_MIN_LOG2 6
+#define MALLOC_CACHE_NUM_CLASSES 7
+#define MALLOC_CACHE_MAX_SIZE \
+	(1UL << (MALLOC_CACHE_MIN_LOG2 + MALLOC_CACHE_NUM_CLASSES - 1))
+#define MALLOC_CACHE_SIZE 32
+#define MALLOC_CACHE_BULK (MALLOC_CACHE_SIZE / 2)
+
+struct malloc_cache_class {
+	unsigned int len;
+	void *objs[MALLOC_CACHE_SIZE];
+};
+
+struct malloc_lcore_cache {
+	uint64_t hits;    /**< allocations served by the cache */
+	uint64_t misses;  /**< allocations that went to the heap */
+	uint64_t flushes; /**< bulks of elements given back to the heap */
+	struct malloc_cache_class
+		classes[RTE_MAX_NUMA_NODES][MALLOC_CACHE_NUM_CLASSES];
+};
+
+/* allocated by each lcore on first use, in process-local memory */
+static struct malloc_lcore_cache *malloc_lcore_caches[RTE_MAX_LCORE];
+
+static struct malloc_lcore_cache *
+malloc_cache_get(void)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct malloc_lcore_cache *cache;
+
+	if (!internal_config.malloc_lcore_cache || lcore_id >= RTE_MAX_LCORE)
+		return NULL;
+
+	cache = malloc_lcore_caches[lcore_id];
+	if (unlikely(cache == NULL)) {
+		cache = calloc(1, sizeof(*cache));
+		malloc_lcore_caches[lcore_id] = cache;
+	}
+	return cache;
+}
+
+static void
+malloc_cache_flush(struct malloc_lcore_cache *cache)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_cache_class *cls;
+	unsigned int heap_id, i;
+
+	for (heap_id = 0; heap_id < RTE_MAX_NUMA_NODES; heap_id++) {
+		for (i = 0; i < MALLOC_CACHE_NUM_CLASSES; i++) {
+			cls = &cache->classes[heap_id][i];
+			if (cls->len == 0)
+				continue;
+			malloc_heap_free_bulk(&mcfg->malloc_heaps[heap_id],
+					cls->objs, cls->len);
+			cls->len = 0;
+			cache->flushes++;
+		}
+	}
+}
+
+static void *
+malloc_cache_alloc(struct malloc_lcore_cache *cache, size_t size,
+		int socket_arg)
+{
+	struct malloc_cache_class *cls;
+	unsigned int class_id;
+	size_t class_size;
+	int heap_id;
+	void *ret;
+
+	heap_id = malloc_socket_to_heap_id(socket_arg == SOCKET_ID_ANY ?
+			malloc_get_numa_socket() : (unsigned int)socket_arg);
+	/* external heaps are not cached */
+	if (heap_id < 0 || heap_id >= (int)rte_socket_count())
+		return NULL;
+
+	class_id = size <= (1UL << MALLOC_CACHE_MIN_LOG2) ? 0 :
+		rte_log2_u32(size) - MALLOC_CACHE_MIN_LOG2;
+	class_size = 1UL << (class_id + MALLOC_CACHE_MIN_LOG2);
+	cls = &cache->classes[heap_id][class_id];
+
+	if (cls->len != 0) {
+		cache->hits++;
+		return cls->objs[--cls->len];
+	}
+
+	cache->misses++;
+	cls->len = malloc_heap_alloc_bulk(heap_id, class_size, cls->objs,
+			MALLOC_CACHE_BULK);
+	if (cls->len != 0)
+		return cls->objs[--cls->len];
+
+	/* the heap has to grow, or to fall back on another socket */
+	ret = malloc_heap_alloc(NULL, class_size, socket_arg, 0,
+			RTE_CACHE_LINE_SIZE, 0, false);
+	if (ret == NULL) {
+		/* give the memory held by this lcore a chance */
+		malloc_cache_flush(cache);
+		ret = malloc_heap_alloc(NULL, class_size, socket_arg, 0,
+				RTE_CACHE_LINE_SIZE, 0, false);
+	}
+	return ret;
+}
+
+static int
+malloc_cache_free(struct malloc_lcore_cache *cache, void *addr)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_elem *elem = malloc_elem_from_data(addr);
+	struct malloc_cache_class *cls;
+	unsigned int heap_id, class_id;
+	size_t data_len;
+
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY ||
+			elem->pad != 0)
+		return -1;
+
+	heap_id = elem->heap - mcfg->malloc_heaps;
+	if (heap_id >= rte_socket_count())
+		return -1;
+
+	data_len = elem->size - MALLOC_ELEM_OVERHEAD;
+	if (data_len < (1UL << MALLOC_CACHE_MIN_LOG2) ||
+			data_len >= 2 * MALLOC_CACHE_MAX_SIZE)
+		return -1;
+
+	/* round down, the element holds at least the class size */
+	class_id = sizeof(data_len) * 8 - 1 - __builtin_clzl(data_len) -
+		MALLOC_CACHE_MIN_LOG2;
+	cls = &cache->classes[heap_id][class_id];
+
+	if (cls->len == MALLOC_CACHE_SIZE) {
+		/* give the oldest half back to the heap */
+		malloc_heap_free_bulk(elem->heap, cls->objs,
+				MALLOC_CACHE_BULK);
+		memmove(cls->objs, &cls->objs[MALLOC_CACHE_BULK],
+			(MALLOC_CACHE_SIZE - MALLOC_CACHE_BULK) *
+			sizeof(cls->objs[0]));
+		cls->len -= MALLOC_CACHE_BULK;
+		cache->flushes++;
+	}
+
+	/* the heap hands out zeroed memory, see rte_zmalloc() */
+	memset(addr, 0, data_len);
+	cls->objs[cls->len++] = addr;
+	return 0;
+}
 
 /* Free the memory space back to heap */
 void rte_free(void *addr)
 {
+	struct malloc_lcore_cache *cache;
+
 	if (addr == NULL) return;
+	cache = malloc_cache_get();
+	if (cache != NULL && malloc_cache_free(cache, addr) == 0)
+		return;
 	if (malloc_heap_free(malloc_elem_from_data(addr)) < 0)
 		RTE_LOG(ERR, EAL, "Error: Invalid memory\n");
 }
@@ -42,6 +206,9 @@ void *
 rte_malloc_socket(const char *type, size_t size, unsigned int align,
 		int socket_arg)
 {
+	struct malloc_lcore_cache *cache;
+	void *ret;
+
 	/* return NULL if size is 0 or alignment is not power-of-2 */
 	if (size == 0 || (align && !rte_is_power_of_2(align)))
 		return NULL;
@@ -55,6 +222,15 @@ rte_malloc_socket(const char *type, size_t size, unsigned int align,
 				!rte_eal_has_hugepages())
 		socket_arg = SOCKET_ID_ANY;
 
+	if (size <= MALLOC_CACHE_MAX_SIZE && align <= RTE_CACHE_LINE_SIZE) {
+		cache = malloc_cache_get();
+		if (cache != NULL) {
+			ret = malloc_cache_alloc(cache, size, socket_arg);
+			if (ret != NULL)
+				return ret;
+		}
+	}
+
 	return malloc_heap_alloc(type, size, socket_arg, 0,
 			align == 0 ? 1 : align, 0, false);
 }
@@ -259,7 +435,7 @@ void
 rte_malloc_dump_stats(FILE *f, __rte_unused const char *type)
 {
 	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
-	unsigned int heap_id;
+	unsigned int heap_id, lcore_id;
 	struct rte_malloc_socket_stats sock_stats;
 
 	rte_rwlock_read_lock(&mcfg->memory_hotplug_lock);
@@ -280,6 +456,28 @@ rte_malloc_dump_stats(FILE *f, __rte_unused const char *type)
 		fprintf(f, "\tAlloc_count:%u,\n",sock_stats.alloc_count);
 		fprintf(f, "\tFree_count:%u,\n", sock_stats.free_count);
 	}
+
+	/* Lcore caches, their elements are counted as allocated above */
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		const struct malloc_lcore_cache *cache =
+			malloc_lcore_caches[lcore_id];
+		size_t cached_size = 0;
+		unsigned int i;
+
+		if (cache == NULL)
+			continue;
+
+		for (heap_id = 0; heap_id < RTE_MAX_NUMA_NODES; heap_id++)
+			for (i = 0; i < MALLOC_CACHE_NUM_CLASSES; i++)
+				cached_size += (size_t)cache->classes[heap_id][i].len <<
+					(i + MALLOC_CACHE_MIN_LOG2);
+
+		fprintf(f, "Lcore cache:%u\n", lcore_id);
+		fprintf(f, "\tHits:%" PRIu64 ",\n", cache->hits);
+		fprintf(f, "\tMisses:%" PRIu64 ",\n", cache->misses);
+		fprintf(f, "\tFlushes:%" PRIu64 ",\n", cache->flushes);
+		fprintf(f, "\tCached_size:%zu,\n", cached_size);
+	}
 	rte_rwlock_read_unlock(&mcfg->memory_hotplug_lock);
 	return;
 }
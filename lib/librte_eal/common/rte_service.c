@@ -3,6 +3,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <inttypes.h>
 #include <limits.h>
@@ -21,9 +22,16 @@
 #include <rte_atomic.h>
 #include <rte_memory.h>
 #include <rte_malloc.h>
+#include <rte_alarm.h>
+#include <rte_pause.h>
 
 #define RTE_SERVICE_NUM_MAX 64
 
+/* minimum difference of utilization between the busiest and the least busy
+ * service cores, in percent, for the balancer to move a service
+ */
+#define SERVICE_BALANCE_THRESHOLD 10
+
 #define SERVICE_F_REGISTERED    (1 << 0)
 #define SERVICE_F_STATS_ENABLED (1 << 1)
 #define SERVICE_F_START_CHECK   (1 << 2)
@@ -53,6 +61,10 @@ struct rte_service_spec_impl {
 	uint64_t calls;
 	uint64_t cycles_spent;
 	uint8_t active_on_lcore[RTE_MAX_LCORE];
+
+	/* utilization over the last balancing period */
+	uint64_t busy_cycles_prev;
+	uint32_t utilization;
 } __rte_cache_aligned;
 
 /* the internal values of a service core */
@@ -64,6 +76,11 @@ struct core_state {
 
 	uint64_t loops;
 	uint64_t calls_per_service[RTE_SERVICE_NUM_MAX];
+	uint64_t cycles_per_service[RTE_SERVICE_NUM_MAX];
+
+	/* utilization over the last balancing period */
+	uint64_t busy_cycles_prev;
+	uint32_t utilization;
 } __rte_cache_aligned;
 
 static uint32_t rte_service_count;
@@ -71,6 +88,14 @@ static struct rte_service_spec_impl *rte_services;
 static struct core_state *lcore_states;
 static uint32_t rte_service_library_initialized;
 
+/* balancer state: cycles are accounted for all services while it is used */
+static uint32_t service_cycles_accounting;
+static uint32_t service_balance_period_ms;
+static uint64_t service_balance_tsc;
+static uint32_t service_util_valid;
+
+static void service_balance_alarm(void *arg);
+
 int32_t rte_service_init(void)
 {
 	if (rte_service_library_initialized) {
@@ -122,6 +147,8 @@ rte_service_finalize(void)
 	if (!rte_service_library_initialized)
 		return;
 
+	rte_eal_alarm_cancel(service_balance_alarm, NULL);
+
 	if (rte_services)
 		rte_free(rte_services);
 
@@ -276,8 +303,10 @@ rte_service_component_unregister(uint32_t id)
 	s->internal_flags &= ~(SERVICE_F_REGISTERED);
 
 	/* clear the run-bit in all cores */
-	for (i = 0; i < RTE_MAX_LCORE; i++)
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
 		lcore_states[i].service_mask &= ~(UINT64_C(1) << id);
+		lcore_states[i].cycles_per_service[id] = 0;
+	}
 
 	memset(&rte_services[id], 0, sizeof(struct rte_service_spec_impl));
 
@@ -335,13 +364,16 @@ rte_service_runner_do_callback(struct rte_service_spec_impl *s,
 {
 	void *userdata = s->spec.callback_userdata;
 
-	if (service_stats_enabled(s)) {
+	if (service_stats_enabled(s) || service_cycles_accounting) {
 		uint64_t start = rte_rdtsc();
 		s->spec.callback(userdata);
-		uint64_t end = rte_rdtsc();
-		s->cycles_spent += end - start;
-		cs->calls_per_service[service_idx]++;
-		s->calls++;
+		uint64_t cycles = rte_rdtsc() - start;
+		cs->cycles_per_service[service_idx] += cycles;
+		if (service_stats_enabled(s)) {
+			s->cycles_spent += cycles;
+			cs->calls_per_service[service_idx]++;
+			s->calls++;
+		}
 	} else
 		s->spec.callback(userdata);
 }
@@ -777,6 +809,187 @@ rte_service_lcore_attr_get(uint32_t lcore, uint32_t attr_id,
 	}
 }
 
+/* compute the utilization of services and service cores since the previous
+ * call, from the cycles spent in the service callbacks
+ */
+static void
+service_utilization_update(void)
+{
+	uint64_t service_cycles[RTE_SERVICE_NUM_MAX] = {0};
+	uint64_t now = rte_rdtsc();
+	uint64_t period = now - service_balance_tsc;
+	uint32_t valid = (service_balance_tsc != 0 && period != 0);
+	uint32_t i, j;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		struct core_state *cs = &lcore_states[i];
+		uint64_t busy = 0;
+
+		for (j = 0; j < RTE_SERVICE_NUM_MAX; j++) {
+			service_cycles[j] += cs->cycles_per_service[j];
+			busy += cs->cycles_per_service[j];
+		}
+		if (valid)
+			cs->utilization = (busy - cs->busy_cycles_prev) * 100 /
+				period;
+		cs->busy_cycles_prev = busy;
+	}
+
+	for (j = 0; j < RTE_SERVICE_NUM_MAX; j++) {
+		struct rte_service_spec_impl *s = &rte_services[j];
+
+		if (valid)
+			s->utilization = (service_cycles[j] -
+				s->busy_cycles_prev) * 100 / period;
+		s->busy_cycles_prev = service_cycles[j];
+	}
+
+	service_balance_tsc = now;
+	service_util_valid = valid;
+}
+
+int32_t __rte_experimental
+rte_service_utilization_get(uint32_t id, uint32_t *utilization)
+{
+	struct rte_service_spec_impl *s;
+	SERVICE_VALID_GET_OR_ERR_RET(id, s, -EINVAL);
+
+	if (!utilization)
+		return -EINVAL;
+	if (!service_util_valid)
+		return -ENODATA;
+
+	*utilization = s->utilization;
+	return 0;
+}
+
+int32_t __rte_experimental
+rte_service_lcore_utilization_get(uint32_t lcore, uint32_t *utilization)
+{
+	struct core_state *cs;
+
+	if (lcore >= RTE_MAX_LCORE || !utilization)
+		return -EINVAL;
+
+	cs = &lcore_states[lcore];
+	if (!cs->is_service_core)
+		return -ENOTSUP;
+	if (!service_util_valid)
+		return -ENODATA;
+
+	*utilization = cs->utilization;
+	return 0;
+}
+
+/* move a service mapped to a single core to another one */
+static void
+service_migrate(uint32_t id, uint32_t from, uint32_t to)
+{
+	volatile struct core_state *cs = &lcore_states[from];
+	uint64_t loops;
+
+	/* the service must not run on both cores at once, wait for the
+	 * current loop of the old core to complete before mapping it on the
+	 * new one
+	 */
+	rte_service_map_lcore_set(id, from, 0);
+	loops = cs->loops;
+	while (cs->runstate == RUNSTATE_RUNNING && cs->loops == loops)
+		rte_pause();
+
+	rte_service_map_lcore_set(id, to, 1);
+}
+
+int32_t __rte_experimental
+rte_service_balance(void)
+{
+	uint32_t busiest = RTE_MAX_LCORE, idlest = RTE_MAX_LCORE;
+	uint32_t busy_util, idle_util, best_gap;
+	int32_t best = -1;
+	uint32_t i;
+
+	service_cycles_accounting = 1;
+	service_utilization_update();
+	if (!service_util_valid)
+		return 0;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		struct core_state *cs = &lcore_states[i];
+
+		if (!cs->is_service_core || cs->runstate != RUNSTATE_RUNNING)
+			continue;
+		if (busiest == RTE_MAX_LCORE ||
+				cs->utilization > lcore_states[busiest].utilization)
+			busiest = i;
+		if (idlest == RTE_MAX_LCORE ||
+				cs->utilization < lcore_states[idlest].utilization)
+			idlest = i;
+	}
+	if (busiest == idlest)
+		return 0;
+
+	busy_util = lcore_states[busiest].utilization;
+	idle_util = lcore_states[idlest].utilization;
+	if (busy_util - idle_util < SERVICE_BALANCE_THRESHOLD)
+		return 0;
+
+	/* pick the service leaving the two cores the most even, services
+	 * mapped to several cores are left where the application put them
+	 */
+	best_gap = busy_util - idle_util;
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++) {
+		struct rte_service_spec_impl *s = &rte_services[i];
+		uint32_t u = s->utilization;
+		int32_t gap;
+
+		if (!service_valid(i) || u == 0 ||
+				!(lcore_states[busiest].service_mask &
+					(UINT64_C(1) << i)) ||
+				rte_atomic32_read(&s->num_mapped_cores) != 1)
+			continue;
+
+		gap = (int32_t)(busy_util - u) - (int32_t)(idle_util + u);
+		if ((uint32_t)abs(gap) < best_gap) {
+			best_gap = abs(gap);
+			best = i;
+		}
+	}
+	if (best < 0)
+		return 0;
+
+	service_migrate(best, busiest, idlest);
+	return 1;
+}
+
+static void
+service_balance_alarm(void *arg __rte_unused)
+{
+	if (service_balance_period_ms == 0)
+		return;
+
+	rte_service_balance();
+	rte_eal_alarm_set((uint64_t)service_balance_period_ms * 1000,
+			service_balance_alarm, NULL);
+}
+
+int32_t __rte_experimental
+rte_service_balance_enable(uint32_t period_ms)
+{
+	rte_eal_alarm_cancel(service_balance_alarm, NULL);
+	service_balance_period_ms = period_ms;
+
+	if (period_ms == 0) {
+		service_cycles_accounting = 0;
+		service_balance_tsc = 0;
+		service_util_valid = 0;
+		return 0;
+	}
+
+	service_cycles_accounting = 1;
+	return rte_eal_alarm_set((uint64_t)period_ms * 1000,
+			service_balance_alarm, NULL);
+}
+
 static void
 rte_service_dump_one(FILE *f, struct rte_service_spec_impl *s,
 		     uint64_t all_cycles, uint32_t reset)
@@ -23,6 +23,7 @@
 #include <sys/time.h>
 #include <signal.h>
 #include <setjmp.h>
+#include <pthread.h>
 #ifdef RTE_EAL_NUMA_AWARE_HUGEPAGES
 #include <numa.h>
 #include <numaif.h>
@@ -88,6 +89,8 @@ static int fallocate_supported = -1; /* unknown */
  *
  * for file-per-page mode, each page will have its own fd, so 'memseg_list_fd'
  * will be invalid (set to -1), and we'll use 'fds' to keep track of page fd's.
+ * the exception is the memfd of --no-huge mode, which backs the whole list and
+ * is stored in 'memseg_list_fd' whatever the mode.
  *
  * we cannot know how many pages a system will have in advance, but we do know
  * that they come in lists, and we know lengths of these lists. so, simply store
@@ -106,7 +109,8 @@ static struct {
 /** local copy of a memory map, used to synchronize memory hotplug in MP */
 static struct rte_memseg_list local_memsegs[RTE_MAX_MEMSEG_LISTS];
 
-static sigjmp_buf huge_jmpenv;
+/* per thread, as segments can be allocated in parallel at init */
+static __thread sigjmp_buf huge_jmpenv;
 
 static void __rte_unused huge_sigbus_handler(int signo __rte_unused)
 {
@@ -863,6 +867,129 @@ struct alloc_walk_param {
 	int socket;
 	bool exact;
 };
+
+struct alloc_thread_param {
+	pthread_t thread;
+	bool started;
+	struct rte_memseg_list *msl;
+	struct hugepage_info *hi;
+	unsigned int msl_idx;
+	int socket;
+	int start_idx; /* first segment to allocate */
+	int end_idx; /* segment past the last one to allocate */
+	int n_alloc; /* segments allocated from start_idx */
+};
+
+static void *
+alloc_seg_thread(void *arg)
+{
+	struct alloc_thread_param *p = arg;
+	int idx;
+
+#ifdef RTE_EAL_NUMA_AWARE_HUGEPAGES
+	/* memory policy is per thread */
+	if (check_numa())
+		numa_set_preferred(p->socket);
+#endif
+
+	for (idx = p->start_idx; idx < p->end_idx; idx++) {
+		struct rte_memseg *cur;
+		void *map_addr;
+
+		cur = rte_fbarray_get(&p->msl->memseg_arr, idx);
+		map_addr = RTE_PTR_ADD(p->msl->base_va, idx * p->msl->page_sz);
+
+		if (alloc_seg(cur, map_addr, p->socket, p->hi, p->msl_idx, idx))
+			break;
+		p->n_alloc++;
+	}
+	return NULL;
+}
+
+/*
+ * Allocate the n_segs segments from start_idx with several threads, as
+ * mapping and zeroing the pages dominates the time to preallocate a large
+ * amount of memory. Either all the segments are allocated or none.
+ * Only used in file-per-page mode, where allocating a segment does not
+ * update any state shared with the other segments of the list.
+ */
+static int
+alloc_seg_bulk_parallel(struct rte_memseg_list *msl, unsigned int msl_idx,
+		int start_idx, struct alloc_walk_param *wa)
+{
+	struct alloc_thread_param *params;
+	unsigned int n_threads, t, n_alloc = 0;
+	int idx, ret = 0;
+
+	n_threads = RTE_MIN(internal_config.mem_init_threads, wa->n_segs);
+	params = calloc(n_threads, sizeof(*params));
+	if (params == NULL) {
+		RTE_LOG(ERR, EAL, "%s(): cannot allocate thread parameters\n",
+			__func__);
+		return -1;
+	}
+
+	RTE_LOG(DEBUG, EAL, "Allocating %u segments with %u threads\n",
+		wa->n_segs, n_threads);
+
+	for (t = 0; t < n_threads; t++) {
+		struct alloc_thread_param *p = &params[t];
+
+		p->msl = msl;
+		p->hi = wa->hi;
+		p->msl_idx = msl_idx;
+		p->socket = wa->socket;
+		p->start_idx = start_idx +
+			(uint64_t)wa->n_segs * t / n_threads;
+		p->end_idx = start_idx +
+			(uint64_t)wa->n_segs * (t + 1) / n_threads;
+
+		/* the calling thread takes the last share */
+		if (t == n_threads - 1)
+			break;
+		if (pthread_create(&p->thread, NULL, alloc_seg_thread, p) == 0)
+			p->started = true;
+		else
+			alloc_seg_thread(p);
+	}
+	alloc_seg_thread(&params[n_threads - 1]);
+
+	for (t = 0; t < n_threads; t++) {
+		if (params[t].started)
+			pthread_join(params[t].thread, NULL);
+		n_alloc += params[t].n_alloc;
+	}
+
+	if (n_alloc != wa->n_segs) {
+		RTE_LOG(DEBUG, EAL, "attempted to allocate %u segments, but only %u were allocated\n",
+			wa->n_segs, n_alloc);
+
+		/* clean up */
+		for (t = 0; t < n_threads; t++) {
+			for (idx = params[t].start_idx;
+					idx < params[t].start_idx +
+						params[t].n_alloc; idx++) {
+				struct rte_memseg *tmp;
+
+				tmp = rte_fbarray_get(&msl->memseg_arr, idx);
+				if (free_seg(tmp, wa->hi, msl_idx, idx))
+					RTE_LOG(DEBUG, EAL, "Cannot free page\n");
+			}
+		}
+		ret = -1;
+		goto out;
+	}
+
+	for (idx = start_idx; idx < start_idx + (int)wa->n_segs; idx++) {
+		if (wa->ms)
+			wa->ms[idx - start_idx] =
+				rte_fbarray_get(&msl->memseg_arr, idx);
+		rte_fbarray_set_used(&msl->memseg_arr, idx);
+	}
+out:
+	free(params);
+	return ret;
+}
 static int
 alloc_seg_walk(const struct rte_memseg_list *msl, void *arg)
 {
@@ -915,6 +1042,21 @@ alloc_seg_walk(const struct rte_memseg_list *msl, void *arg)
 		}
 	}
 
+	/* preallocation of many segments at init */
+	if (wa->exact && need > 1 && internal_config.mem_init_threads > 1 &&
+			!internal_config.init_complete &&
+			!internal_config.single_file_segments) {
+		if (alloc_seg_bulk_parallel(cur_msl, msl_idx, start_idx, wa)) {
+			if (wa->ms)
+				memset(wa->ms, 0, sizeof(*wa->ms) * wa->n_segs);
+			if (dir_fd >= 0)
+				close(dir_fd);
+			return -1;
+		}
+		i = need;
+		goto out;
+	}
+
 	for (i = 0; i < need; i++, cur_idx++) {
 		struct rte_memseg *cur;
 		void *map_addr;
@@ -1538,11 +1680,29 @@ eal_memalloc_set_seg_fd(int list_idx, int seg_idx, int fd)
 	return 0;
 }
 
+int
+eal_memalloc_set_seg_list_fd(int list_idx, int fd)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+
+	/* if list is not allocated, allocate it */
+	if (fd_list[list_idx].len == 0) {
+		int len = mcfg->memsegs[list_idx].memseg_arr.len;
+
+		if (alloc_list(list_idx, len) < 0)
+			return -ENOMEM;
+	}
+	fd_list[list_idx].memseg_list_fd = fd;
+
+	return 0;
+}
+
 int
 eal_memalloc_get_seg_fd(int list_idx, int seg_idx)
 {
 	int fd;
-	if (internal_config.single_file_segments) {
+	if (internal_config.single_file_segments ||
+			fd_list[list_idx].memseg_list_fd >= 0) {
 		fd = fd_list[list_idx].memseg_list_fd;
 	} else if (fd_list[list_idx].len == 0) {
 		/* list not initialized */
@@ -1592,7 +1752,8 @@ eal_memalloc_get_seg_fd_offset(int list_idx, int seg_idx, size_t *offset)
 	/* fd_list not initialized? */
 	if (fd_list[list_idx].len == 0)
 		return -ENODEV;
-	if (internal_config.single_file_segments) {
+	if (internal_config.single_file_segments ||
+			fd_list[list_idx].memseg_list_fd >= 0) {
 		size_t pgsz = mcfg->memsegs[list_idx].page_sz;
 
 		/* segment not active? */
@@ -47,6 +47,11 @@
 #include "eal_filesystem.h"
 #include "eal_hugepages.h"
 
+/* memfd_create() is declared along with its hugetlbfs flags */
+#ifdef MFD_HUGETLB
+#define MEMFD_SUPPORTED
+#endif
+
 #define PFN_MASK_SIZE	8
 
 /**
@@ -1342,7 +1347,7 @@ eal_legacy_hugepage_init(void)
 	if (internal_config.no_hugetlbfs) {
 		struct rte_memseg_list *msl;
 		uint64_t page_sz;
-		int n_segs, cur_seg;
+		int n_segs, cur_seg, fd, flags;
 
 		/* nohuge mode is legacy mode */
 		internal_config.legacy_mem = 1;
@@ -1359,13 +1364,44 @@ eal_legacy_hugepage_init(void)
 			return -1;
 		}
 
+		fd = -1;
+		flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MEMFD_SUPPORTED
+		/* back the memory with a memfd, so that it can be shared with
+		 * another process such as a vhost-user backend, as hugepages
+		 * are. fall back to anonymous memory if it can't be created.
+		 */
+		fd = memfd_create("nohuge", 0);
+		if (fd < 0) {
+			RTE_LOG(DEBUG, EAL, "Cannot create memfd: %s\n",
+					strerror(errno));
+		} else if (ftruncate(fd, internal_config.memory) < 0) {
+			RTE_LOG(DEBUG, EAL, "Cannot resize memfd: %s\n",
+					strerror(errno));
+			close(fd);
+			fd = -1;
+		} else {
+			flags = MAP_SHARED;
+		}
+#endif
 		addr = mmap(NULL, internal_config.memory, PROT_READ | PROT_WRITE,
-				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				flags, fd, 0);
 		if (addr == MAP_FAILED) {
 			RTE_LOG(ERR, EAL, "%s: mmap() failed: %s\n", __func__,
 					strerror(errno));
+			if (fd >= 0)
+				close(fd);
 			return -1;
 		}
+		if (fd >= 0) {
+			if (eal_memalloc_set_seg_list_fd(0, fd) < 0) {
+				/* the memory is usable, just not shareable */
+				RTE_LOG(ERR, EAL, "Cannot set memseg list fd\n");
+				close(fd);
+			} else {
+				RTE_LOG(DEBUG, EAL, "Using memfd for --no-huge memory\n");
+			}
+		}
 		msl->base_va = addr;
 		msl->page_sz = page_sz;
 		msl->socket_id = 0;
@@ -16,6 +16,7 @@
 #include <rte_prefetch.h>
 #include <rte_branch_prediction.h>
 #include <rte_memcpy.h>
+#include <rte_pause.h>
 #include <rte_ring.h>
 #include <rte_jhash.h>
 #include <rte_hash_crc.h>
@@ -256,6 +257,12 @@ struct rte_efd_table {
 	/**< Ring that stores all indexes of the free slots in the key table */
 
 	uint8_t *keys; /**< Dynamic array of size max_num_rules of keys */
+
+	uint32_t rw_concurrency_lf;
+	/**< Lookups retry when the table changed under them. */
+
+	uint32_t tbl_chng_cnt __rte_cache_aligned;
+	/**< Online table change counter, odd while an update is in progress. */
 };
 
 /**
@@ -493,6 +500,15 @@ efd_search_hash(struct rte_efd_table * const table,
 struct rte_efd_table *
 rte_efd_create(const char *name, uint32_t max_num_rules, uint32_t key_len,
 		uint8_t online_cpu_socket_bitmask, uint8_t offline_cpu_socket)
+{
+	return rte_efd_create_ext(name, max_num_rules, key_len,
+			online_cpu_socket_bitmask, offline_cpu_socket, 0);
+}
+
+struct rte_efd_table * __rte_experimental
+rte_efd_create_ext(const char *name, uint32_t max_num_rules, uint32_t key_len,
+		uint8_t online_cpu_socket_bitmask, uint8_t offline_cpu_socket,
+		uint32_t extra_flag)
 {
 	struct rte_efd_table *table = NULL;
 	uint8_t *key_array = NULL;
@@ -578,6 +594,8 @@ rte_efd_create(const char *name, uint32_t max_num_rules, uint32_t key_len,
 	table->num_chunks = num_chunks;
 	table->num_chunks_shift = num_chunks_shift;
 	table->key_len = key_len;
+	table->rw_concurrency_lf =
+		!!(extra_flag & RTE_EFD_EXTRA_FLAGS_RW_CONCURRENCY_LF);
 
 	/* key_array */
 	key_array = rte_zmalloc_socket(NULL,
@@ -753,6 +771,65 @@ rte_efd_free(struct rte_efd_table *table)
 	rte_free(table);
 }
 
+/*
+ * The online table is updated under a sequence counter when lock-free
+ * lookups are enabled: the counter is odd while an update is in progress,
+ * and the lookups retry until they read the same even value before and
+ * after reading the table.
+ */
+static inline void
+efd_write_begin(struct rte_efd_table * const table)
+{
+	if (!table->rw_concurrency_lf)
+		return;
+
+	__atomic_store_n(&table->tbl_chng_cnt, table->tbl_chng_cnt + 1,
+			__ATOMIC_RELAXED);
+	/* The stores to the online table should not move above the store
+	 * to tbl_chng_cnt.
+	 */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+efd_write_end(struct rte_efd_table * const table)
+{
+	if (!table->rw_concurrency_lf)
+		return;
+
+	__atomic_store_n(&table->tbl_chng_cnt, table->tbl_chng_cnt + 1,
+			__ATOMIC_RELEASE);
+}
+
+static inline uint32_t
+efd_read_begin(const struct rte_efd_table * const table)
+{
+	uint32_t cnt;
+
+	if (!table->rw_concurrency_lf)
+		return 0;
+
+	/* Wait for the update in progress to complete */
+	while ((cnt = __atomic_load_n(&table->tbl_chng_cnt,
+			__ATOMIC_ACQUIRE)) & 1)
+		rte_pause();
+
+	return cnt;
+}
+
+static inline int
+efd_read_retry(const struct rte_efd_table * const table, const uint32_t cnt)
+{
+	if (!table->rw_concurrency_lf)
+		return 0;
+
+	/* The loads from the online table should not move below the load
+	 * from tbl_chng_cnt.
+	 */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&table->tbl_chng_cnt, __ATOMIC_RELAXED) != cnt;
+}
+
 /**
  * Applies a previously computed table entry to the specified table for all
  * socket-local copies of the online table.
@@ -800,6 +877,7 @@ efd_apply_update(struct rte_efd_table * const table, const unsigned int socket_i
 			| ((new_bin_choice & 0x03) << offset);
 
 	/* Update the online table with the new data across all sockets */
+	efd_write_begin(table);
 	for (i = 0; i < RTE_MAX_NUMA_NODES; i++) {
 		if (table->chunks[i] != NULL) {
 			memcpy(&(table->chunks[i][chunk_id].groups[group_id]),
@@ -809,6 +887,7 @@ efd_apply_update(struct rte_efd_table * const table, const unsigned int socket_i
 					choice_chunk;
 		}
 	}
+	efd_write_end(table);
 }
 
 /*
@@ -1281,21 +1360,27 @@ efd_value_t
 rte_efd_lookup(const struct rte_efd_table * const table,
 		const unsigned int socket_id, const void *key)
 {
-	uint32_t chunk_id, group_id, bin_id;
+	uint32_t chunk_id, group_id, bin_id, cnt;
 	uint8_t bin_choice;
+	efd_value_t value;
 	const struct efd_online_group_entry *group;
 	const struct efd_online_chunk * const chunks = table->chunks[socket_id];
 
 	/* Determine the chunk and group location for the given key */
 	efd_compute_ids(table, key, &chunk_id, &bin_id);
-	bin_choice = efd_get_choice(table, socket_id, chunk_id, bin_id);
-	group_id = efd_bin_to_group[bin_choice][bin_id];
-	group = &chunks[chunk_id].groups[group_id];
-
-	return efd_lookup_internal(group,
-			EFD_HASHFUNCA(key, table),
-			EFD_HASHFUNCB(key, table),
-			table->lookup_fn);
+	do {
+		cnt = efd_read_begin(table);
+		bin_choice = efd_get_choice(table, socket_id, chunk_id, bin_id);
+		group_id = efd_bin_to_group[bin_choice][bin_id];
+		group = &chunks[chunk_id].groups[group_id];
+
+		value = efd_lookup_internal(group,
+				EFD_HASHFUNCA(key, table),
+				EFD_HASHFUNCB(key, table),
+				table->lookup_fn);
+	} while (efd_read_retry(table, cnt));
+
+	return value;
 }
 
 void rte_efd_lookup_bulk(const struct rte_efd_table * const table,
@@ -1303,6 +1388,7 @@ void rte_efd_lookup_bulk(const struct rte_efd_table * const table,
 		const void **key_list, efd_value_t * const value_list)
 {
 	int i;
+	uint32_t cnt;
 	uint32_t chunk_id_list[RTE_EFD_BURST_MAX];
 	uint32_t bin_id_list[RTE_EFD_BURST_MAX];
 	uint8_t bin_choice_list[RTE_EFD_BURST_MAX];
@@ -1317,20 +1403,26 @@ void rte_efd_lookup_bulk(const struct rte_efd_table * const table,
 		rte_prefetch0(&chunks[chunk_id_list[i]].bin_choice_list);
 	}
 
-	for (i = 0; i < num_keys; i++) {
-		bin_choice_list[i] = efd_get_choice(table, socket_id,
-				chunk_id_list[i], bin_id_list[i]);
-		group_id_list[i] =
-				efd_bin_to_group[bin_choice_list[i]][bin_id_list[i]];
-		group = &chunks[chunk_id_list[i]].groups[group_id_list[i]];
-		rte_prefetch0(group);
-	}
+	do {
+		cnt = efd_read_begin(table);
+
+		for (i = 0; i < num_keys; i++) {
+			bin_choice_list[i] = efd_get_choice(table, socket_id,
+					chunk_id_list[i], bin_id_list[i]);
+			group_id_list[i] = efd_bin_to_group[bin_choice_list[i]]
+					[bin_id_list[i]];
+			group = &chunks[chunk_id_list[i]]
+					.groups[group_id_list[i]];
+			rte_prefetch0(group);
+		}
 
-	for (i = 0; i < num_keys; i++) {
-		group = &chunks[chunk_id_list[i]].groups[group_id_list[i]];
-		value_list[i] = efd_lookup_internal(group,
-				EFD_HASHFUNCA(key_list[i], table),
-				EFD_HASHFUNCB(key_list[i], table),
-				table->lookup_fn);
-	}
+		for (i = 0; i < num_keys; i++) {
+			group = &chunks[chunk_id_list[i]]
+					.groups[group_id_list[i]];
+			value_list[i] = efd_lookup_internal(group,
+					EFD_HASHFUNCA(key_list[i], table),
+					EFD_HASHFUNCB(key_list[i], table),
+					table->lookup_fn);
+		}
+	} while (efd_read_retry(table, cnt));
 }
@@ -13,6 +13,8 @@
 
 #include <stdint.h>
 
+#include <rte_compat.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -102,6 +104,12 @@ extern "C" {
 /** Maximum number of characters in efd name.*/
 #define RTE_EFD_NAMESIZE			32
 
+/**
+ * Flag to enable lock-free lookups concurrent with the updates of a single
+ * writer: the lookups retry when the table changed under them.
+ */
+#define RTE_EFD_EXTRA_FLAGS_RW_CONCURRENCY_LF 0x01
+
 #if (RTE_EFD_VALUE_NUM_BITS > 0 && RTE_EFD_VALUE_NUM_BITS <= 8)
 typedef uint8_t efd_value_t;
 #elif (RTE_EFD_VALUE_NUM_BITS > 8 && RTE_EFD_VALUE_NUM_BITS <= 16)
@@ -141,6 +149,34 @@ struct rte_efd_table *
 rte_efd_create(const char *name, uint32_t max_num_rules, uint32_t key_len,
 	uint8_t online_cpu_socket_bitmask, uint8_t offline_cpu_socket);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Creates an EFD table as rte_efd_create() does, with extra flags.
+ * @param name
+ *   EFD table name
+ * @param max_num_rules
+ *   Minimum number of rules the table should be sized to hold.
+ *   Will be rounded up to the next smallest valid table size
+ * @param key_len
+ *   Length of the key
+ * @param online_cpu_socket_bitmask
+ *   Bitmask specifying which sockets should get a copy of the online table.
+ *   LSB = socket 0, etc.
+ * @param offline_cpu_socket
+ *   Identifies the socket where the offline table will be allocated
+ *   (and most efficiently accessed in the case of updates/insertions)
+ * @param extra_flag
+ *   Bitmask of RTE_EFD_EXTRA_FLAGS_* flags
+ * @return
+ *   EFD table, or NULL if table allocation failed or the bitmask is invalid
+ */
+struct rte_efd_table * __rte_experimental
+rte_efd_create_ext(const char *name, uint32_t max_num_rules, uint32_t key_len,
+	uint8_t online_cpu_socket_bitmask, uint8_t offline_cpu_socket,
+	uint32_t extra_flag);
+
 /**
  * Releases the resources from an EFD table
  *
@@ -173,6 +209,8 @@ rte_efd_find_existing(const char *name);
  * all socket-local copies of the chunks are updated.
  * This operation is not multi-thread safe
  * and should only be called one from thread.
+ * Lookups may run concurrently only if the table was created with
+ * RTE_EFD_EXTRA_FLAGS_RW_CONCURRENCY_LF.
  *
  * @param table
  *   EFD table to reference
@@ -224,7 +262,9 @@ rte_efd_delete(struct rte_efd_table *table, unsigned int socket_id,
 
 /**
  * Looks up the value associated with a key
- * This operation is multi-thread safe.
+ * This operation is multi-thread safe, and safe against a concurrent
+ * rte_efd_update() if the table was created with
+ * RTE_EFD_EXTRA_FLAGS_RW_CONCURRENCY_LF.
  *
  * NOTE: Lookups will *always* succeed - this is a property of
  * using a perfect hash table.
@@ -248,7 +288,9 @@ rte_efd_lookup(const struct rte_efd_table *table, unsigned int socket_id,
 
 /**
  * Looks up the value associated with several keys.
- * This operation is multi-thread safe.
+ * This operation is multi-thread safe, and safe against a concurrent
+ * rte_efd_update() if the table was created with
+ * RTE_EFD_EXTRA_FLAGS_RW_CONCURRENCY_LF.
  *
  * NOTE: Lookups will *always* succeed - this is a property of
  * using a perfect hash table.
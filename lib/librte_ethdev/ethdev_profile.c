@@ -2,6 +2,15 @@
  * Copyright(c) 2010-2018 Intel Corporation
  */
 
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_spinlock.h>
+
+#include "rte_ethdev_driver.h"
 #include "ethdev_profile.h"
 
 /**
@@ -60,3 +69,508 @@ __rte_eth_dev_profile_init(__rte_unused uint16_t port_id,
 #endif
 	return 0;
 }
+
+/* Burst profiling, measuring the calls to the burst functions of the PMDs */
+
+/** Number of entries of the queue lookup tables, a power of two */
+#define ETH_PROFILE_MAP_SIZE 4096
+
+/** Key of a removed entry of a lookup table */
+#define ETH_PROFILE_MAP_REMOVED ((void *)UINTPTR_MAX)
+
+/* Counters of a queue, only updated by the lcore polling it */
+struct eth_profile_queue {
+	struct rte_eth_queue_profile stats;
+} __rte_cache_aligned;
+
+/* Profiling state of a port, local to the process like the burst functions */
+struct eth_profile_port {
+	int enabled;
+	eth_rx_burst_t rx_pkt_burst; /**< PMD receive function. */
+	eth_tx_burst_t tx_pkt_burst; /**< PMD transmit function. */
+	struct eth_profile_queue *rxq; /**< RTE_MAX_QUEUES_PER_PORT entries. */
+	struct eth_profile_queue *txq; /**< RTE_MAX_QUEUES_PER_PORT entries. */
+};
+
+/*
+ * The burst functions only get the queue pointer: the wrappers find the
+ * port and the queue through an open addressing table keyed by it.
+ * Entries are only added by the control path, the key being written last,
+ * so that the lookups of the data path need no lock.
+ */
+struct eth_profile_entry {
+	void *queue;
+	uint32_t id; /**< Port ID in the upper 16 bits, queue ID below. */
+};
+
+static struct eth_profile_port eth_profile_ports[RTE_MAX_ETHPORTS];
+static struct eth_profile_entry eth_profile_rx_map[ETH_PROFILE_MAP_SIZE];
+static struct eth_profile_entry eth_profile_tx_map[ETH_PROFILE_MAP_SIZE];
+static rte_spinlock_t eth_profile_lock = RTE_SPINLOCK_INITIALIZER;
+
+static inline uint32_t
+eth_profile_hash(const void *queue)
+{
+	uint64_t h = (uintptr_t)queue;
+
+	h = (h >> RTE_CACHE_LINE_SIZE_LOG2) * 0x9e3779b97f4a7c15ULL;
+	return (uint32_t)(h >> 32) & (ETH_PROFILE_MAP_SIZE - 1);
+}
+
+static inline const struct eth_profile_entry *
+eth_profile_lookup(const struct eth_profile_entry *map, const void *queue)
+{
+	uint32_t idx = eth_profile_hash(queue);
+	uint32_t i;
+
+	for (i = 0; i < ETH_PROFILE_MAP_SIZE; i++) {
+		const struct eth_profile_entry *e = &map[idx];
+
+		if (e->queue == queue)
+			return e;
+		if (e->queue == NULL)
+			return NULL;
+		idx = (idx + 1) & (ETH_PROFILE_MAP_SIZE - 1);
+	}
+	return NULL;
+}
+
+static int
+eth_profile_map_add(struct eth_profile_entry *map, void *queue,
+	uint16_t port_id, uint16_t queue_id)
+{
+	uint32_t id = (uint32_t)port_id << 16 | queue_id;
+	uint32_t idx = eth_profile_hash(queue);
+	struct eth_profile_entry *free_entry = NULL;
+	uint32_t i;
+
+	for (i = 0; i < ETH_PROFILE_MAP_SIZE; i++) {
+		struct eth_profile_entry *e = &map[idx];
+
+		if (e->queue == queue) {
+			e->id = id;
+			return 0;
+		}
+		if (e->queue == ETH_PROFILE_MAP_REMOVED && free_entry == NULL)
+			free_entry = e;
+		if (e->queue == NULL) {
+			if (free_entry == NULL)
+				free_entry = e;
+			break;
+		}
+		idx = (idx + 1) & (ETH_PROFILE_MAP_SIZE - 1);
+	}
+	if (free_entry == NULL)
+		return -ENOSPC;
+
+	free_entry->id = id;
+	rte_smp_wmb();
+	free_entry->queue = queue;
+	return 0;
+}
+
+static void
+eth_profile_map_del(struct eth_profile_entry *map, uint16_t port_id)
+{
+	uint32_t i;
+
+	for (i = 0; i < ETH_PROFILE_MAP_SIZE; i++) {
+		struct eth_profile_entry *e = &map[i];
+
+		if (e->queue != NULL && e->queue != ETH_PROFILE_MAP_REMOVED &&
+				(e->id >> 16) == port_id)
+			e->queue = ETH_PROFILE_MAP_REMOVED;
+	}
+}
+
+static inline void
+eth_profile_account(struct eth_profile_queue *q, uint16_t nb_done,
+	uint64_t cycles)
+{
+	struct rte_eth_queue_profile *stats = &q->stats;
+	unsigned int bucket;
+
+	stats->calls++;
+	stats->cycles += cycles;
+	if (nb_done == 0) {
+		stats->empty_calls++;
+		stats->empty_cycles += cycles;
+		return;
+	}
+	stats->pkts += nb_done;
+	bucket = 31 - __builtin_clz(nb_done);
+	if (bucket >= RTE_ETH_PROFILE_HIST_NR)
+		bucket = RTE_ETH_PROFILE_HIST_NR - 1;
+	stats->hist[bucket]++;
+}
+
+/*
+ * Find the port of a queue missing from the lookup tables, e.g. set up since
+ * they were updated, so that its burst is passed to the PMD unprofiled.
+ */
+static struct eth_profile_port *
+eth_profile_port_find(const void *queue, int rx)
+{
+	const struct rte_eth_dev_data *data;
+	uint16_t port_id, nb_queues, q;
+	void **queues;
+
+	for (port_id = 0; port_id < RTE_MAX_ETHPORTS; port_id++) {
+		if (rte_eth_devices[port_id].state == RTE_ETH_DEV_UNUSED)
+			continue;
+		data = rte_eth_devices[port_id].data;
+		queues = rx ? data->rx_queues : data->tx_queues;
+		nb_queues = rx ? data->nb_rx_queues : data->nb_tx_queues;
+		for (q = 0; q < nb_queues; q++)
+			if (queues[q] == queue)
+				return &eth_profile_ports[port_id];
+	}
+	return NULL;
+}
+
+static uint16_t
+eth_profile_rx_burst(void *rxq, struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
+{
+	const struct eth_profile_entry *e;
+	struct eth_profile_port *port;
+	uint16_t nb_rx;
+	uint64_t start;
+
+	e = eth_profile_lookup(eth_profile_rx_map, rxq);
+	if (unlikely(e == NULL)) {
+		port = eth_profile_port_find(rxq, 1);
+		if (port == NULL || port->rx_pkt_burst == NULL)
+			return 0;
+		return port->rx_pkt_burst(rxq, rx_pkts, nb_pkts);
+	}
+	port = &eth_profile_ports[e->id >> 16];
+
+	start = rte_rdtsc();
+	nb_rx = port->rx_pkt_burst(rxq, rx_pkts, nb_pkts);
+	eth_profile_account(&port->rxq[e->id & UINT16_MAX], nb_rx,
+		rte_rdtsc() - start);
+
+	return nb_rx;
+}
+
+static uint16_t
+eth_profile_tx_burst(void *txq, struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+{
+	const struct eth_profile_entry *e;
+	struct eth_profile_port *port;
+	struct eth_profile_queue *q;
+	uint16_t nb_tx;
+	uint64_t start;
+
+	e = eth_profile_lookup(eth_profile_tx_map, txq);
+	if (unlikely(e == NULL)) {
+		port = eth_profile_port_find(txq, 0);
+		if (port == NULL || port->tx_pkt_burst == NULL)
+			return 0;
+		return port->tx_pkt_burst(txq, tx_pkts, nb_pkts);
+	}
+	port = &eth_profile_ports[e->id >> 16];
+	q = &port->txq[e->id & UINT16_MAX];
+
+	start = rte_rdtsc();
+	nb_tx = port->tx_pkt_burst(txq, tx_pkts, nb_pkts);
+	eth_profile_account(q, nb_tx, rte_rdtsc() - start);
+	if (nb_tx < nb_pkts)
+		q->stats.ring_full++;
+
+	return nb_tx;
+}
+
+/* Register the queues of a port and install the wrappers, lock held */
+static int
+eth_profile_install(struct rte_eth_dev *dev)
+{
+	uint16_t port_id = dev->data->port_id;
+	struct eth_profile_port *port = &eth_profile_ports[port_id];
+	uint16_t q;
+	int ret;
+
+	for (q = 0; q < dev->data->nb_rx_queues; q++) {
+		if (dev->data->rx_queues[q] == NULL)
+			continue;
+		ret = eth_profile_map_add(eth_profile_rx_map,
+			dev->data->rx_queues[q], port_id, q);
+		if (ret < 0)
+			return ret;
+	}
+	for (q = 0; q < dev->data->nb_tx_queues; q++) {
+		if (dev->data->tx_queues[q] == NULL)
+			continue;
+		ret = eth_profile_map_add(eth_profile_tx_map,
+			dev->data->tx_queues[q], port_id, q);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* The PMD may have replaced its burst functions since last time */
+	if (dev->rx_pkt_burst != eth_profile_rx_burst) {
+		port->rx_pkt_burst = dev->rx_pkt_burst;
+		rte_smp_wmb();
+		dev->rx_pkt_burst = eth_profile_rx_burst;
+	}
+	if (dev->tx_pkt_burst != eth_profile_tx_burst) {
+		port->tx_pkt_burst = dev->tx_pkt_burst;
+		rte_smp_wmb();
+		dev->tx_pkt_burst = eth_profile_tx_burst;
+	}
+	return 0;
+}
+
+/* Give the burst functions back to the PMD, lock held */
+static void
+eth_profile_uninstall(struct rte_eth_dev *dev)
+{
+	struct eth_profile_port *port = &eth_profile_ports[dev->data->port_id];
+
+	if (dev->rx_pkt_burst == eth_profile_rx_burst)
+		dev->rx_pkt_burst = port->rx_pkt_burst;
+	if (dev->tx_pkt_burst == eth_profile_tx_burst)
+		dev->tx_pkt_burst = port->tx_pkt_burst;
+	port->enabled = 0;
+}
+
+void
+__rte_eth_dev_profile_update(struct rte_eth_dev *dev)
+{
+	struct eth_profile_port *port = &eth_profile_ports[dev->data->port_id];
+	int ret;
+
+	if (!port->enabled)
+		return;
+
+	rte_spinlock_lock(&eth_profile_lock);
+	ret = eth_profile_install(dev);
+	if (ret < 0) {
+		RTE_ETHDEV_LOG(ERR,
+			"Port %u burst profiling disabled, too many queues\n",
+			dev->data->port_id);
+		eth_profile_uninstall(dev);
+	}
+	rte_spinlock_unlock(&eth_profile_lock);
+}
+
+void
+__rte_eth_dev_profile_release(struct rte_eth_dev *dev)
+{
+	uint16_t port_id = dev->data->port_id;
+	struct eth_profile_port *port = &eth_profile_ports[port_id];
+
+	rte_spinlock_lock(&eth_profile_lock);
+	eth_profile_uninstall(dev);
+	eth_profile_map_del(eth_profile_rx_map, port_id);
+	eth_profile_map_del(eth_profile_tx_map, port_id);
+	rte_free(port->rxq);
+	rte_free(port->txq);
+	memset(port, 0, sizeof(*port));
+	rte_spinlock_unlock(&eth_profile_lock);
+}
+
+int __rte_experimental
+rte_eth_dev_profile_enable(uint16_t port_id)
+{
+	struct eth_profile_port *port;
+	struct rte_eth_dev *dev;
+	int ret = 0;
+
+	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, -ENODEV);
+	dev = &rte_eth_devices[port_id];
+	port = &eth_profile_ports[port_id];
+
+	rte_spinlock_lock(&eth_profile_lock);
+	if (port->enabled)
+		goto out;
+
+	if (port->rxq == NULL)
+		port->rxq = rte_zmalloc("ethdev_profile_rxq",
+			sizeof(*port->rxq) * RTE_MAX_QUEUES_PER_PORT,
+			RTE_CACHE_LINE_SIZE);
+	if (port->txq == NULL)
+		port->txq = rte_zmalloc("ethdev_profile_txq",
+			sizeof(*port->txq) * RTE_MAX_QUEUES_PER_PORT,
+			RTE_CACHE_LINE_SIZE);
+	if (port->rxq == NULL || port->txq == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	port->enabled = 1;
+	ret = eth_profile_install(dev);
+	if (ret < 0)
+		eth_profile_uninstall(dev);
+out:
+	rte_spinlock_unlock(&eth_profile_lock);
+	return ret;
+}
+
+int __rte_experimental
+rte_eth_dev_profile_disable(uint16_t port_id)
+{
+	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, -ENODEV);
+
+	rte_spinlock_lock(&eth_profile_lock);
+	eth_profile_uninstall(&rte_eth_devices[port_id]);
+	rte_spinlock_unlock(&eth_profile_lock);
+	return 0;
+}
+
+static int
+eth_profile_queue_get(uint16_t port_id, uint16_t queue_id, int tx,
+	struct rte_eth_queue_profile *profile)
+{
+	struct eth_profile_port *port;
+	struct eth_profile_queue *q;
+	uint16_t nb_queues;
+
+	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, -ENODEV);
+	if (profile == NULL)
+		return -EINVAL;
+
+	nb_queues = tx ? rte_eth_devices[port_id].data->nb_tx_queues :
+		rte_eth_devices[port_id].data->nb_rx_queues;
+	if (queue_id >= nb_queues)
+		return -EINVAL;
+
+	port = &eth_profile_ports[port_id];
+	q = tx ? port->txq : port->rxq;
+	if (q == NULL)
+		memset(profile, 0, sizeof(*profile));
+	else
+		*profile = q[queue_id].stats;
+	return 0;
+}
+
+int __rte_experimental
+rte_eth_dev_profile_rx_queue_get(uint16_t port_id, uint16_t queue_id,
+	struct rte_eth_queue_profile *profile)
+{
+	return eth_profile_queue_get(port_id, queue_id, 0, profile);
+}
+
+int __rte_experimental
+rte_eth_dev_profile_tx_queue_get(uint16_t port_id, uint16_t queue_id,
+	struct rte_eth_queue_profile *profile)
+{
+	return eth_profile_queue_get(port_id, queue_id, 1, profile);
+}
+
+/* Extended statistics of the profiled queues */
+
+struct eth_profile_xstats_name_off {
+	const char *name;
+	unsigned int offset;
+};
+
+#define ETH_PROFILE_XSTAT(name, field) \
+	{ name, offsetof(struct rte_eth_queue_profile, field) }
+
+static const struct eth_profile_xstats_name_off eth_profile_xstats[] = {
+	ETH_PROFILE_XSTAT("calls", calls),
+	ETH_PROFILE_XSTAT("empty_calls", empty_calls),
+	ETH_PROFILE_XSTAT("cycles", cycles),
+	ETH_PROFILE_XSTAT("empty_cycles", empty_cycles),
+	ETH_PROFILE_XSTAT("burst_pkts", pkts),
+	ETH_PROFILE_XSTAT("burst_size_1", hist[0]),
+	ETH_PROFILE_XSTAT("burst_size_2_3", hist[1]),
+	ETH_PROFILE_XSTAT("burst_size_4_7", hist[2]),
+	ETH_PROFILE_XSTAT("burst_size_8_15", hist[3]),
+	ETH_PROFILE_XSTAT("burst_size_16_31", hist[4]),
+	ETH_PROFILE_XSTAT("burst_size_32_63", hist[5]),
+	ETH_PROFILE_XSTAT("burst_size_64_up", hist[6]),
+	ETH_PROFILE_XSTAT("ring_full", ring_full),
+};
+
+#define ETH_PROFILE_NB_XSTATS RTE_DIM(eth_profile_xstats)
+/* The Rx queues do not report the last one */
+#define ETH_PROFILE_NB_RXQ_XSTATS (ETH_PROFILE_NB_XSTATS - 1)
+
+static inline void
+eth_profile_xstats_queues(struct rte_eth_dev *dev, uint16_t *nb_rxqs,
+	uint16_t *nb_txqs)
+{
+	*nb_rxqs = RTE_MIN(dev->data->nb_rx_queues,
+		RTE_ETHDEV_QUEUE_STAT_CNTRS);
+	*nb_txqs = RTE_MIN(dev->data->nb_tx_queues,
+		RTE_ETHDEV_QUEUE_STAT_CNTRS);
+}
+
+int
+__rte_eth_dev_profile_xstats_count(struct rte_eth_dev *dev)
+{
+	uint16_t nb_rxqs, nb_txqs;
+
+	if (!eth_profile_ports[dev->data->port_id].enabled)
+		return 0;
+
+	eth_profile_xstats_queues(dev, &nb_rxqs, &nb_txqs);
+	return nb_rxqs * ETH_PROFILE_NB_RXQ_XSTATS +
+		nb_txqs * ETH_PROFILE_NB_XSTATS;
+}
+
+int
+__rte_eth_dev_profile_xstats_get_names(struct rte_eth_dev *dev,
+	struct rte_eth_xstat_name *xstats_names)
+{
+	uint16_t nb_rxqs, nb_txqs, q;
+	unsigned int i;
+	int count = 0;
+
+	if (!eth_profile_ports[dev->data->port_id].enabled)
+		return 0;
+
+	eth_profile_xstats_queues(dev, &nb_rxqs, &nb_txqs);
+	for (q = 0; q < nb_rxqs; q++)
+		for (i = 0; i < ETH_PROFILE_NB_RXQ_XSTATS; i++)
+			snprintf(xstats_names[count++].name,
+				sizeof(xstats_names[0].name), "rx_q%u_prof_%s",
+				q, eth_profile_xstats[i].name);
+	for (q = 0; q < nb_txqs; q++)
+		for (i = 0; i < ETH_PROFILE_NB_XSTATS; i++)
+			snprintf(xstats_names[count++].name,
+				sizeof(xstats_names[0].name), "tx_q%u_prof_%s",
+				q, eth_profile_xstats[i].name);
+	return count;
+}
+
+int
+__rte_eth_dev_profile_xstats_get(struct rte_eth_dev *dev,
+	struct rte_eth_xstat *xstats)
+{
+	struct eth_profile_port *port = &eth_profile_ports[dev->data->port_id];
+	uint16_t nb_rxqs, nb_txqs, q;
+	unsigned int i;
+	int count = 0;
+
+	if (!port->enabled)
+		return 0;
+
+	eth_profile_xstats_queues(dev, &nb_rxqs, &nb_txqs);
+	for (q = 0; q < nb_rxqs; q++)
+		for (i = 0; i < ETH_PROFILE_NB_RXQ_XSTATS; i++)
+			xstats[count++].value = *(uint64_t *)RTE_PTR_ADD(
+				&port->rxq[q].stats,
+				eth_profile_xstats[i].offset);
+	for (q = 0; q < nb_txqs; q++)
+		for (i = 0; i < ETH_PROFILE_NB_XSTATS; i++)
+			xstats[count++].value = *(uint64_t *)RTE_PTR_ADD(
+				&port->txq[q].stats,
+				eth_profile_xstats[i].offset);
+	return count;
+}
+
+void
+__rte_eth_dev_profile_xstats_reset(struct rte_eth_dev *dev)
+{
+	struct eth_profile_port *port = &eth_profile_ports[dev->data->port_id];
+
+	if (port->rxq != NULL)
+		memset(port->rxq, 0,
+			sizeof(*port->rxq) * RTE_MAX_QUEUES_PER_PORT);
+	if (port->txq != NULL)
+		memset(port->txq, 0,
+			sizeof(*port->txq) * RTE_MAX_QUEUES_PER_PORT);
+}
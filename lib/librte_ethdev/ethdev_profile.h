@@ -24,4 +24,75 @@
 int
 __rte_eth_dev_profile_init(uint16_t port_id, struct rte_eth_dev *dev);
 
+/**
+ * Install the burst profiling wrappers again if profiling is enabled on the
+ * port, after the PMD may have changed its burst functions or queues.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev of the port.
+ */
+void
+__rte_eth_dev_profile_update(struct rte_eth_dev *dev);
+
+/**
+ * Free the burst profiling resources of a port being released.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev of the port.
+ */
+void
+__rte_eth_dev_profile_release(struct rte_eth_dev *dev);
+
+/**
+ * Number of extended statistics of the burst profiling, zero when it is
+ * not enabled on the port.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev of the port.
+ *
+ * @return
+ *  The number of statistics.
+ */
+int
+__rte_eth_dev_profile_xstats_count(struct rte_eth_dev *dev);
+
+/**
+ * Fill the names of the extended statistics of the burst profiling.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev of the port.
+ * @param xstats_names
+ *  Array of __rte_eth_dev_profile_xstats_count() entries.
+ *
+ * @return
+ *  The number of entries filled.
+ */
+int
+__rte_eth_dev_profile_xstats_get_names(struct rte_eth_dev *dev,
+	struct rte_eth_xstat_name *xstats_names);
+
+/**
+ * Fill the values of the extended statistics of the burst profiling.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev of the port.
+ * @param xstats
+ *  Array of __rte_eth_dev_profile_xstats_count() entries.
+ *
+ * @return
+ *  The number of entries filled.
+ */
+int
+__rte_eth_dev_profile_xstats_get(struct rte_eth_dev *dev,
+	struct rte_eth_xstat *xstats);
+
+/**
+ * Reset the burst profiling counters of a port.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev of the port.
+ */
+void
+__rte_eth_dev_profile_xstats_reset(struct rte_eth_dev *dev);
+
 #endif
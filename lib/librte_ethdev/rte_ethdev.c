@@ -34,6 +34,7 @@
 #include <rte_mbuf.h>
 #include <rte_errno.h>
 #include <rte_spinlock.h>
+#include <rte_pause.h>
 #include <rte_string_fns.h>
 #include <rte_kvargs.h>
 #include <rte_class.h>
@@ -59,6 +60,17 @@ static rte_spinlock_t rte_eth_rx_cb_lock = RTE_SPINLOCK_INITIALIZER;
 /* spinlock for add/remove tx callbacks */
 static rte_spinlock_t rte_eth_tx_cb_lock = RTE_SPINLOCK_INITIALIZER;
 
+/*
+ * Quiescent state based reclamation of the RX/TX callbacks: each reader
+ * lcore copies the current token when quiescent, a writer bumps the token
+ * and waits until every online reader copied it. 0 is for offline.
+ */
+static uint64_t rte_eth_cb_token = 1;
+
+static struct {
+	uint64_t token;
+} __rte_cache_aligned rte_eth_cb_readers[RTE_MAX_LCORE];
+
 /* spinlock for shared data allocation */
 static rte_spinlock_t rte_eth_shared_data_lock = RTE_SPINLOCK_INITIALIZER;
 
@@ -517,6 +529,9 @@ rte_eth_dev_release_port(struct rte_eth_dev *eth_dev)
 		_rte_eth_dev_callback_process(eth_dev,
 				RTE_ETH_EVENT_DESTROY, NULL);
 
+	if (eth_dev->data != NULL)
+		__rte_eth_dev_profile_release(eth_dev);
+
 	rte_spinlock_lock(&rte_eth_dev_shared_data->ownership_lock);
 
 	eth_dev->state = RTE_ETH_DEV_UNUSED;
@@ -1408,6 +1423,7 @@ rte_eth_dev_start(uint16_t port_id)
 		return eth_err(port_id, diag);
 
 	rte_eth_dev_config_restore(dev, &dev_info, port_id);
+	__rte_eth_dev_profile_update(dev);
 
 	if (dev->data->dev_conf.intr_conf.lsc == 0) {
 		RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->link_update, -ENOTSUP);
@@ -1659,6 +1675,9 @@ rte_eth_rx_queue_setup(uint16_t port_id, uint16_t rx_queue_id,
 		if (!dev->data->min_rx_buf_size ||
 		    dev->data->min_rx_buf_size > mbp_buf_size)
 			dev->data->min_rx_buf_size = mbp_buf_size;
+		/* A queue set up at runtime must be known by the profiling */
+		if (dev->data->dev_started)
+			__rte_eth_dev_profile_update(dev);
 	}
 
 	return eth_err(port_id, ret);
@@ -1673,6 +1692,7 @@ rte_eth_tx_queue_setup(uint16_t port_id, uint16_t tx_queue_id,
 	struct rte_eth_dev_info dev_info;
 	struct rte_eth_txconf local_conf;
 	void **txq;
+	int ret;
 
 	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, -EINVAL);
 
@@ -1757,8 +1777,12 @@ rte_eth_tx_queue_setup(uint16_t port_id, uint16_t tx_queue_id,
 		return -EINVAL;
 	}
 
-	return eth_err(port_id, (*dev->dev_ops->tx_queue_setup)(dev,
-		       tx_queue_id, nb_tx_desc, socket_id, &local_conf));
+	ret = (*dev->dev_ops->tx_queue_setup)(dev, tx_queue_id, nb_tx_desc,
+					      socket_id, &local_conf);
+	if (!ret && dev->data->dev_started)
+		__rte_eth_dev_profile_update(dev);
+
+	return eth_err(port_id, ret);
 }
 
 void
@@ -1978,6 +2002,7 @@ get_xstats_basic_count(struct rte_eth_dev *dev)
 	count = RTE_NB_STATS;
 	count += nb_rxqs * RTE_NB_RXQ_STATS;
 	count += nb_txqs * RTE_NB_TXQ_STATS;
+	count += __rte_eth_dev_profile_xstats_count(dev);
 
 	return count;
 }
@@ -2089,6 +2114,8 @@ rte_eth_basic_stats_get_names(struct rte_eth_dev *dev,
 			cnt_used_entries++;
 		}
 	}
+	cnt_used_entries += __rte_eth_dev_profile_xstats_get_names(dev,
+		xstats_names + cnt_used_entries);
 	return cnt_used_entries;
 }
 
@@ -2287,6 +2314,7 @@ rte_eth_basic_stats_get(uint16_t port_id, struct rte_eth_xstat *xstats)
 			xstats[count++].value = val;
 		}
 	}
+	count += __rte_eth_dev_profile_xstats_get(dev, xstats + count);
 	return count;
 }
 
@@ -2390,19 +2418,14 @@ rte_eth_xstats_get(uint16_t port_id, struct rte_eth_xstat *xstats,
 	struct rte_eth_dev *dev;
 	unsigned int count = 0, i;
 	signed int xcount = 0;
-	uint16_t nb_rxqs, nb_txqs;
 	int ret;
 
 	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, -EINVAL);
 
 	dev = &rte_eth_devices[port_id];
 
-	nb_rxqs = RTE_MIN(dev->data->nb_rx_queues, RTE_ETHDEV_QUEUE_STAT_CNTRS);
-	nb_txqs = RTE_MIN(dev->data->nb_tx_queues, RTE_ETHDEV_QUEUE_STAT_CNTRS);
-
 	/* Return generic statistics */
-	count = RTE_NB_STATS + (nb_rxqs * RTE_NB_RXQ_STATS) +
-		(nb_txqs * RTE_NB_TXQ_STATS);
+	count = get_xstats_basic_count(dev);
 
 	/* implemented by the driver */
 	if (dev->dev_ops->xstats_get != NULL) {
@@ -2444,6 +2467,8 @@ rte_eth_xstats_reset(uint16_t port_id)
 	RTE_ETH_VALID_PORTID_OR_RET(port_id);
 	dev = &rte_eth_devices[port_id];
 
+	__rte_eth_dev_profile_xstats_reset(dev);
+
 	/* implemented by the driver */
 	if (dev->dev_ops->xstats_reset != NULL) {
 		(*dev->dev_ops->xstats_reset)(dev);
@@ -3816,6 +3841,8 @@ rte_eth_add_rx_callback(uint16_t port_id, uint16_t queue_id,
 	} else {
 		while (tail->next)
 			tail = tail->next;
+		/* Readers walk the list without the lock. */
+		rte_smp_wmb();
 		tail->next = cb;
 	}
 	rte_spinlock_unlock(&rte_eth_rx_cb_lock);
@@ -3894,6 +3921,8 @@ rte_eth_add_tx_callback(uint16_t port_id, uint16_t queue_id,
 	} else {
 		while (tail->next)
 			tail = tail->next;
+		/* Readers walk the list without the lock. */
+		rte_smp_wmb();
 		tail->next = cb;
 	}
 	rte_spinlock_unlock(&rte_eth_tx_cb_lock);
@@ -3969,6 +3998,68 @@ rte_eth_remove_tx_callback(uint16_t port_id, uint16_t queue_id,
 	return ret;
 }
 
+int __rte_experimental
+rte_eth_rxtx_callback_reader_register(unsigned int lcore_id)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	__atomic_store_n(&rte_eth_cb_readers[lcore_id].token,
+			 __atomic_load_n(&rte_eth_cb_token, __ATOMIC_ACQUIRE),
+			 __ATOMIC_RELEASE);
+	/* Be seen online before looking at the callbacks. */
+	rte_smp_mb();
+	return 0;
+}
+
+int __rte_experimental
+rte_eth_rxtx_callback_reader_unregister(unsigned int lcore_id)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	__atomic_store_n(&rte_eth_cb_readers[lcore_id].token, 0,
+			 __ATOMIC_RELEASE);
+	return 0;
+}
+
+int __rte_experimental
+rte_eth_rxtx_callback_quiescent(unsigned int lcore_id)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	__atomic_store_n(&rte_eth_cb_readers[lcore_id].token,
+			 __atomic_load_n(&rte_eth_cb_token, __ATOMIC_ACQUIRE),
+			 __ATOMIC_RELEASE);
+	return 0;
+}
+
+void __rte_experimental
+rte_eth_rxtx_callback_synchronize(void)
+{
+	unsigned int self = rte_lcore_id();
+	uint64_t token;
+	unsigned int i;
+
+	/* The callbacks were unlinked before the new token is published. */
+	token = __atomic_add_fetch(&rte_eth_cb_token, 1, __ATOMIC_SEQ_CST);
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		uint64_t seen;
+
+		if (i == self)
+			continue;
+		while (1) {
+			seen = __atomic_load_n(&rte_eth_cb_readers[i].token,
+					       __ATOMIC_ACQUIRE);
+			if (seen == 0 || seen >= token)
+				break;
+			rte_pause();
+		}
+	}
+}
+
 int
 rte_eth_rx_queue_info_get(uint16_t port_id, uint16_t queue_id,
 	struct rte_eth_rxq_info *qinfo)
@@ -3299,6 +3299,9 @@ rte_eth_add_tx_callback(uint16_t port_id, uint16_t queue_id,
  * - After a short delay - where the delay is sufficient to allow any
  *   in-flight callbacks to complete.
  *
+ * - After rte_eth_rxtx_callback_synchronize() - if the lcores doing RX/TX
+ *   report their quiescent states with rte_eth_rxtx_callback_quiescent().
+ *
  * @param port_id
  *   The port identifier of the Ethernet device.
  * @param queue_id
@@ -3332,6 +3335,9 @@ int rte_eth_remove_rx_callback(uint16_t port_id, uint16_t queue_id,
  * - After a short delay - where the delay is sufficient to allow any
  *   in-flight callbacks to complete.
  *
+ * - After rte_eth_rxtx_callback_synchronize() - if the lcores doing RX/TX
+ *   report their quiescent states with rte_eth_rxtx_callback_quiescent().
+ *
  * @param port_id
  *   The port identifier of the Ethernet device.
  * @param queue_id
@@ -3348,6 +3354,182 @@ int rte_eth_remove_rx_callback(uint16_t port_id, uint16_t queue_id,
 int rte_eth_remove_tx_callback(uint16_t port_id, uint16_t queue_id,
 		const struct rte_eth_rxtx_callback *user_cb);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Register an lcore calling rte_eth_rx_burst() or rte_eth_tx_burst() as a
+ * reader of the RX/TX callback lists, which rte_eth_rxtx_callback_synchronize()
+ * waits for. A registered lcore must report its quiescent states with
+ * rte_eth_rxtx_callback_quiescent(), or be unregistered while it does not
+ * poll, e.g. before it sleeps.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The lcore identifier is out of range.
+ */
+int __rte_experimental
+rte_eth_rxtx_callback_reader_register(unsigned int lcore_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Unregister an lcore registered by rte_eth_rxtx_callback_reader_register(),
+ * rte_eth_rxtx_callback_synchronize() stops waiting for it. It must not be
+ * in a burst, nor hold a callback, when unregistered.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The lcore identifier is out of range.
+ */
+int __rte_experimental
+rte_eth_rxtx_callback_reader_unregister(unsigned int lcore_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Report a quiescent state of a registered lcore: it is not in a burst and
+ * holds no RX/TX callback, typically once per iteration of its polling
+ * loop. This is a single store, which costs nothing when no callback is
+ * being removed.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The lcore identifier is out of range.
+ */
+int __rte_experimental
+rte_eth_rxtx_callback_quiescent(unsigned int lcore_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Wait until each registered lcore went through a quiescent state, after
+ * which the callbacks removed before the call are no longer used by any
+ * of them and can be freed with rte_free(). The calling lcore, if
+ * registered, is not waited for.
+ *
+ * Removing the callbacks of all the queues of a port, then synchronizing
+ * once, disables a diagnostic at runtime without stopping the traffic.
+ */
+void __rte_experimental
+rte_eth_rxtx_callback_synchronize(void);
+
+/** Number of buckets of the burst size histogram of a profiled queue */
+#define RTE_ETH_PROFILE_HIST_NR 7
+
+/**
+ * Counters of the burst calls of a queue, see rte_eth_dev_profile_enable().
+ */
+struct rte_eth_queue_profile {
+	uint64_t calls; /**< Number of calls of the PMD burst function. */
+	uint64_t empty_calls; /**< Calls which got or sent no packet. */
+	uint64_t cycles; /**< TSC cycles spent in the PMD burst function. */
+	uint64_t empty_cycles; /**< Part of the cycles spent in empty calls. */
+	uint64_t pkts; /**< Number of packets received or sent. */
+	/**
+	 * Non-empty calls by number of packets: 1, 2-3, 4-7, 8-15, 16-31,
+	 * 32-63 and 64 or more.
+	 */
+	uint64_t hist[RTE_ETH_PROFILE_HIST_NR];
+	/** TX calls which could not send all the packets, ring being full. */
+	uint64_t ring_full;
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enable the burst profiling of a port in the calling process.
+ *
+ * The burst functions of the PMD are replaced by wrappers counting the
+ * calls, the packets and the TSC cycles of each RX and TX queue, so that
+ * the polling of idle queues can be measured uniformly across the PMDs.
+ * The counters are reported by rte_eth_dev_profile_rx_queue_get(),
+ * rte_eth_dev_profile_tx_queue_get() and as extended statistics named
+ * "rx_q<N>_prof_*" and "tx_q<N>_prof_*", reset by rte_eth_xstats_reset().
+ * Nothing is added to the data path while profiling is disabled.
+ *
+ * It can be enabled before or after the port is started. The lcores
+ * already in a burst finish it with the PMD functions.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @return
+ *   - 0: Success
+ *   - -ENODEV: *port_id* is invalid.
+ *   - -ENOMEM: The counters could not be allocated.
+ *   - -ENOSPC: Too many queues are profiled.
+ */
+int __rte_experimental
+rte_eth_dev_profile_enable(uint16_t port_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Disable the burst profiling of a port, giving the burst functions back
+ * to the PMD. The counters are kept until the port is released.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @return
+ *   - 0: Success
+ *   - -ENODEV: *port_id* is invalid.
+ */
+int __rte_experimental
+rte_eth_dev_profile_disable(uint16_t port_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Read the burst profiling counters of an RX queue.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The RX queue identifier.
+ * @param profile
+ *   Filled with the counters, all zero if profiling was never enabled.
+ * @return
+ *   - 0: Success
+ *   - -ENODEV: *port_id* is invalid.
+ *   - -EINVAL: *queue_id* is invalid or *profile* is NULL.
+ */
+int __rte_experimental
+rte_eth_dev_profile_rx_queue_get(uint16_t port_id, uint16_t queue_id,
+	struct rte_eth_queue_profile *profile);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Read the burst profiling counters of a TX queue.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The TX queue identifier.
+ * @param profile
+ *   Filled with the counters, all zero if profiling was never enabled.
+ * @return
+ *   - 0: Success
+ *   - -ENODEV: *port_id* is invalid.
+ *   - -EINVAL: *queue_id* is invalid or *profile* is NULL.
+ */
+int __rte_experimental
+rte_eth_dev_profile_tx_queue_get(uint16_t port_id, uint16_t queue_id,
+	struct rte_eth_queue_profile *profile);
+
 /**
  * Retrieve information about given port's RX queue.
  *
@@ -6,6 +6,7 @@
 #include <sys/epoll.h>
 #endif
 #include <unistd.h>
+#include <sys/queue.h>
 
 #include <rte_cycles.h>
 #include <rte_common.h>
@@ -14,6 +15,7 @@
 #include <rte_ethdev.h>
 #include <rte_log.h>
 #include <rte_malloc.h>
+#include <rte_mempool.h>
 #include <rte_service_component.h>
 #include <rte_thash.h>
 #include <rte_interrupts.h>
@@ -21,6 +23,10 @@
 #include "rte_eventdev.h"
 #include "rte_eventdev_pmd.h"
 #include "rte_event_eth_rx_adapter.h"
+#ifdef RTE_LIBRTE_VHOST
+#include <rte_vhost.h>
+#include "rte_event_eth_rx_adapter_vhost.h"
+#endif
 
 #define BATCH_SIZE		32
 #define BLOCK_CNT_THRESHOLD	10
@@ -30,10 +36,16 @@
 #define ETH_RX_ADAPTER_MEM_NAME_LEN	32
 
 #define RSS_KEY_SIZE	40
+/* Event vectors being built per Rx queue, the flows are hashed over them */
+#define RXA_VECTOR_FLOWS	8
 /* value written to intr thread pipe to signal thread exit */
 #define ETH_BRIDGE_INTR_THREAD_EXIT	1
 /* Sentinel value to detect initialized file handle */
 #define INIT_FD		-1
+/* Initial size of the external Rx source array */
+#define RXA_SRC_ARRAY_SIZE	64
+/* Number of external Rx source identifiers */
+#define RXA_MAX_SRCS		((uint32_t)UINT16_MAX)
 
 /*
  * Used to store port and queue ID of interrupting Rx queue
@@ -58,6 +70,23 @@ struct eth_rx_poll_entry {
 	uint16_t eth_rx_qid;
 };
 
+/*
+ * Event vector being built for the flows of a Rx queue hashed to it
+ */
+struct eth_rx_vector_data {
+	TAILQ_ENTRY(eth_rx_vector_data) next;
+	/* Vector being built, NULL if none */
+	struct rte_event_vector *vector;
+	/* Rx queue of the vector */
+	struct eth_rx_queue_info *queue_info;
+	/* Timestamp of the first mbuf of the vector */
+	uint64_t ts;
+	/* Flow identifier of the mbufs of the vector */
+	uint32_t flow_id;
+};
+
+TAILQ_HEAD(eth_rx_vector_list, eth_rx_vector_data);
+
 /* Instance per adapter */
 struct rte_eth_event_enqueue_buffer {
 	/* Count of events in this buffer */
@@ -91,6 +120,26 @@ struct rte_event_eth_rx_adapter {
 	uint32_t wrr_pos;
 	/* Event burst buffer */
 	struct rte_eth_event_enqueue_buffer event_enqueue_buffer;
+	/* External Rx sources indexed by source id, NULL if free */
+	struct rxa_src **srcs;
+	/* Size of the srcs and src_poll arrays */
+	uint32_t src_array_size;
+	/* Count of external Rx sources */
+	uint32_t num_srcs;
+	/* External Rx sources that need to be polled */
+	struct rxa_src **src_poll;
+	/* Count of entries in src_poll */
+	uint32_t num_src_polled;
+	/* Next entry in src_poll to begin polling */
+	uint32_t src_poll_pos;
+	/* Count of interrupt driven external Rx sources */
+	uint32_t num_src_intr;
+	/* Event vectors being built */
+	struct eth_rx_vector_list vector_list;
+	/* Smallest vector timeout of the Rx queues, in TSC cycles */
+	uint64_t vector_tmo_ticks;
+	/* Timestamp of the last check of the vector timeouts */
+	uint64_t prev_expiry_ts;
 	/* Per adapter stats */
 	struct rte_event_eth_rx_adapter_stats stats;
 	/* Block count, counts up to BLOCK_CNT_THRESHOLD */
@@ -203,6 +252,29 @@ struct eth_rx_queue_info {
 	uint8_t priority;	/* Event priority */
 	uint32_t flow_id;	/* App provided flow identifier */
 	uint32_t flow_id_mask;	/* Set to ~0 if app provides flow id else 0 */
+	int ena_vector;		/* True if the mbufs are aggregated in vectors */
+	uint16_t port;		/* Eth port of the queue */
+	uint16_t queue;		/* Eth Rx queue index */
+	uint16_t vector_sz;	/* Maximum number of mbufs per vector */
+	uint64_t vector_tmo_ticks; /* Vector timeout in TSC cycles */
+	struct rte_mempool *vector_mp; /* Mempool of the vectors */
+	/* Vectors being built, indexed by flow id */
+	struct eth_rx_vector_data vector_data[RXA_VECTOR_FLOWS];
+};
+
+/* Per external Rx source */
+struct rxa_src {
+	/* Event configuration, wt == 0 for interrupt driven sources */
+	struct eth_rx_queue_info queue_info;
+	/* Receive function and its argument */
+	rte_event_eth_rx_adapter_src_rx_t rx_fn;
+	void *rx_arg;
+	/* Notification control function, may be NULL */
+	rte_event_eth_rx_adapter_src_intr_ctl_t intr_ctl;
+	/* Notification fd, -1 for polled sources */
+	int intr_fd;
+	/* Epoll event of intr_fd, referenced by the EAL until deleted */
+	struct rte_epoll_event epoll_event;
 };
 
 static struct rte_event_eth_rx_adapter **event_eth_rx_adapter;
@@ -223,7 +295,8 @@ rxa_validate_id(uint8_t id)
 static inline int
 rxa_sw_adapter_queue_count(struct rte_event_eth_rx_adapter *rx_adapter)
 {
-	return rx_adapter->num_rx_polled + rx_adapter->num_rx_intr;
+	return rx_adapter->num_rx_polled + rx_adapter->num_rx_intr +
+		rx_adapter->num_src_polled + rx_adapter->num_src_intr;
 }
 
 /* Greatest common divisor */
@@ -755,20 +828,167 @@ rxa_flush_event_buffer(struct rte_event_eth_rx_adapter *rx_adapter)
 	return n;
 }
 
+/* Add an event vector to the event buffer, free space check is done prior
+ * to calling this function
+ */
 static inline void
-rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
-		uint16_t eth_dev_id,
-		uint16_t rx_queue_id,
+rxa_vector_enq(struct rte_event_eth_rx_adapter *rx_adapter,
+		struct eth_rx_vector_data *vd)
+{
+	struct eth_rx_queue_info *queue_info = vd->queue_info;
+	struct rte_event ev;
+
+	ev.event = 0;
+	ev.flow_id = vd->flow_id;
+	ev.op = RTE_EVENT_OP_NEW;
+	ev.sched_type = queue_info->sched_type;
+	ev.queue_id = queue_info->event_queue_id;
+	ev.event_type = RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR;
+	ev.sub_event_type = 0;
+	ev.priority = queue_info->priority;
+	ev.vec = vd->vector;
+
+	rxa_buffer_event(rx_adapter, &ev);
+	vd->vector = NULL;
+	TAILQ_REMOVE(&rx_adapter->vector_list, vd, next);
+}
+
+/* Add a mbuf to the event vector of its flow, the event buffer must have
+ * space for one event
+ */
+static inline int
+rxa_vector_add(struct rte_event_eth_rx_adapter *rx_adapter,
+		struct eth_rx_queue_info *queue_info,
+		struct rte_mbuf *m,
+		uint32_t flow_id,
+		uint64_t ts)
+{
+	struct eth_rx_vector_data *vd =
+		&queue_info->vector_data[flow_id & (RXA_VECTOR_FLOWS - 1)];
+	struct rte_event_vector *vec = vd->vector;
+
+	if (vec == NULL || vd->flow_id != flow_id) {
+		if (unlikely(rte_mempool_get(queue_info->vector_mp,
+					(void **)&vec) < 0))
+			return -ENOBUFS;
+
+		/* Another flow hashed to the same vector, enqueue it. As the
+		 * new vector is not full, at most one event is buffered per
+		 * mbuf.
+		 */
+		if (vd->vector != NULL)
+			rxa_vector_enq(rx_adapter, vd);
+
+		vec->nb_elem = 0;
+		vec->port = queue_info->port;
+		vec->queue = queue_info->queue;
+		vd->vector = vec;
+		vd->queue_info = queue_info;
+		vd->flow_id = flow_id;
+		vd->ts = ts;
+		TAILQ_INSERT_TAIL(&rx_adapter->vector_list, vd, next);
+	}
+
+	vec->mbufs[vec->nb_elem++] = m;
+	if (vec->nb_elem == queue_info->vector_sz)
+		rxa_vector_enq(rx_adapter, vd);
+
+	return 0;
+}
+
+/* Enqueue the event vectors whose timeout expired */
+static void
+rxa_vector_expire(struct rte_event_eth_rx_adapter *rx_adapter)
+{
+	struct rte_eth_event_enqueue_buffer *buf =
+					&rx_adapter->event_enqueue_buffer;
+	struct eth_rx_vector_data *vd, *vd_next;
+	uint64_t now = rte_get_tsc_cycles();
+	uint16_t count = buf->count;
+
+	if (now - rx_adapter->prev_expiry_ts < rx_adapter->vector_tmo_ticks)
+		return;
+
+	rx_adapter->prev_expiry_ts = now;
+	for (vd = TAILQ_FIRST(&rx_adapter->vector_list); vd != NULL;
+			vd = vd_next) {
+		vd_next = TAILQ_NEXT(vd, next);
+		if (now - vd->ts < vd->queue_info->vector_tmo_ticks)
+			continue;
+
+		if (buf->count == ETH_EVENT_BUFFER_SIZE) {
+			rxa_flush_event_buffer(rx_adapter);
+			if (buf->count == ETH_EVENT_BUFFER_SIZE)
+				return;
+		}
+		rxa_vector_enq(rx_adapter, vd);
+	}
+
+	/* The timeout bounds the latency, don't wait for a full batch */
+	if (buf->count != count)
+		rxa_flush_event_buffer(rx_adapter);
+}
+
+/* Enqueue the event vectors being built for a Rx queue, before it is
+ * reconfigured or deleted. If the event buffer is full, the mbufs are
+ * dropped.
+ */
+static void
+rxa_vector_queue_flush(struct rte_event_eth_rx_adapter *rx_adapter,
+		struct eth_rx_queue_info *queue_info)
+{
+	struct rte_eth_event_enqueue_buffer *buf =
+					&rx_adapter->event_enqueue_buffer;
+	struct eth_rx_vector_data *vd;
+	uint16_t i;
+
+	for (i = 0; i < RXA_VECTOR_FLOWS; i++) {
+		vd = &queue_info->vector_data[i];
+		if (vd->vector == NULL)
+			continue;
+
+		if (buf->count == ETH_EVENT_BUFFER_SIZE)
+			rxa_flush_event_buffer(rx_adapter);
+		if (buf->count < ETH_EVENT_BUFFER_SIZE) {
+			rxa_vector_enq(rx_adapter, vd);
+			continue;
+		}
+
+		rte_pktmbuf_free_bulk(vd->vector->mbufs, vd->vector->nb_elem);
+		rte_mempool_put(queue_info->vector_mp, vd->vector);
+		vd->vector = NULL;
+		TAILQ_REMOVE(&rx_adapter->vector_list, vd, next);
+	}
+
+	if (buf->count)
+		rxa_flush_event_buffer(rx_adapter);
+}
+
+static inline void
+rxa_timestamp_mbufs(struct rte_mbuf **mbufs, uint16_t num)
+{
+	uint32_t i;
+	uint64_t ts;
+
+	if ((mbufs[0]->ol_flags & PKT_RX_TIMESTAMP) == 0) {
+		ts = rte_get_tsc_cycles();
+		for (i = 0; i < num; i++) {
+			struct rte_mbuf *m = mbufs[i];
+
+			m->timestamp = ts;
+			m->ol_flags |= PKT_RX_TIMESTAMP;
+		}
+	}
+}
+
+/* Buffer the events of mbufs received from the queue of queue_info */
+static inline void
+rxa_buffer_queue_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
+		struct eth_rx_queue_info *eth_rx_queue_info,
 		struct rte_mbuf **mbufs,
 		uint16_t num)
 {
 	uint32_t i;
-	struct eth_device_info *dev_info =
-					&rx_adapter->eth_devices[eth_dev_id];
-	struct eth_rx_queue_info *eth_rx_queue_info =
-					&dev_info->rx_queue[rx_queue_id];
-	struct rte_eth_event_enqueue_buffer *buf =
-					&rx_adapter->event_enqueue_buffer;
 	int32_t qid = eth_rx_queue_info->event_queue_id;
 	uint8_t sched_type = eth_rx_queue_info->sched_type;
 	uint8_t priority = eth_rx_queue_info->priority;
@@ -778,36 +998,14 @@ rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
 	uint32_t rss_mask;
 	uint32_t rss;
 	int do_rss;
-	uint64_t ts;
-	struct rte_mbuf *cb_mbufs[BATCH_SIZE];
-	uint16_t nb_cb;
+	uint64_t now = 0;
 
 	/* 0xffff ffff if PKT_RX_RSS_HASH is set, otherwise 0 */
 	rss_mask = ~(((m->ol_flags & PKT_RX_RSS_HASH) != 0) - 1);
 	do_rss = !rss_mask && !eth_rx_queue_info->flow_id_mask;
 
-	if ((m->ol_flags & PKT_RX_TIMESTAMP) == 0) {
-		ts = rte_get_tsc_cycles();
-		for (i = 0; i < num; i++) {
-			m = mbufs[i];
-
-			m->timestamp = ts;
-			m->ol_flags |= PKT_RX_TIMESTAMP;
-		}
-	}
-
-
-	nb_cb = dev_info->cb_fn ? dev_info->cb_fn(eth_dev_id, rx_queue_id,
-						ETH_EVENT_BUFFER_SIZE,
-						buf->count, mbufs,
-						num,
-						dev_info->cb_arg,
-						cb_mbufs) :
-						num;
-	if (nb_cb < num) {
-		mbufs = cb_mbufs;
-		num = nb_cb;
-	}
+	if (eth_rx_queue_info->ena_vector)
+		now = rte_get_tsc_cycles();
 
 	for (i = 0; i < num; i++) {
 		m = mbufs[i];
@@ -820,6 +1018,13 @@ rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
 		    eth_rx_queue_info->flow_id &
 				eth_rx_queue_info->flow_id_mask;
 		flow_id |= rss & ~eth_rx_queue_info->flow_id_mask;
+
+		/* Enqueue a single event if no vector is available */
+		if (eth_rx_queue_info->ena_vector &&
+			rxa_vector_add(rx_adapter, eth_rx_queue_info, m,
+				flow_id, now) == 0)
+			continue;
+
 		ev->flow_id = flow_id;
 		ev->op = RTE_EVENT_OP_NEW;
 		ev->sched_type = sched_type;
@@ -833,6 +1038,41 @@ rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
 	}
 }
 
+static inline void
+rxa_buffer_mbufs(struct rte_event_eth_rx_adapter *rx_adapter,
+		uint16_t eth_dev_id,
+		uint16_t rx_queue_id,
+		struct rte_mbuf **mbufs,
+		uint16_t num)
+{
+	struct eth_device_info *dev_info =
+					&rx_adapter->eth_devices[eth_dev_id];
+	struct eth_rx_queue_info *eth_rx_queue_info =
+					&dev_info->rx_queue[rx_queue_id];
+	struct rte_eth_event_enqueue_buffer *buf =
+					&rx_adapter->event_enqueue_buffer;
+	struct rte_mbuf *cb_mbufs[BATCH_SIZE];
+	uint16_t nb_cb;
+
+	rxa_timestamp_mbufs(mbufs, num);
+
+	nb_cb = dev_info->cb_fn ? dev_info->cb_fn(eth_dev_id, rx_queue_id,
+						ETH_EVENT_BUFFER_SIZE,
+						buf->count, mbufs,
+						num,
+						dev_info->cb_arg,
+						cb_mbufs) :
+						num;
+	if (nb_cb < num) {
+		mbufs = cb_mbufs;
+		num = nb_cb;
+	}
+
+	if (num)
+		rxa_buffer_queue_mbufs(rx_adapter, eth_rx_queue_info, mbufs,
+				num);
+}
+
 /* Enqueue packets from  <port, q>  to event buffer */
 static inline uint32_t
 rxa_eth_rx(struct rte_event_eth_rx_adapter *rx_adapter,
@@ -878,6 +1118,87 @@ rxa_eth_rx(struct rte_event_eth_rx_adapter *rx_adapter,
 	return nb_rx;
 }
 
+/* Enqueue packets from an external Rx source to event buffer, nb_bursts
+ * bounds the number of calls to the receive function of the source
+ */
+static inline uint32_t
+rxa_src_rx(struct rte_event_eth_rx_adapter *rx_adapter,
+	struct rxa_src *src,
+	uint32_t rx_count,
+	uint32_t max_rx,
+	uint32_t nb_bursts,
+	int *rxq_empty)
+{
+	struct rte_mbuf *mbufs[BATCH_SIZE];
+	struct rte_eth_event_enqueue_buffer *buf =
+					&rx_adapter->event_enqueue_buffer;
+	struct rte_event_eth_rx_adapter_stats *stats =
+					&rx_adapter->stats;
+	uint16_t n;
+	uint32_t nb_rx = 0;
+
+	if (rxq_empty)
+		*rxq_empty = 0;
+	while (nb_bursts-- &&
+		BATCH_SIZE <= (RTE_DIM(buf->events) - buf->count)) {
+		if (buf->count >= BATCH_SIZE)
+			rxa_flush_event_buffer(rx_adapter);
+
+		stats->rx_poll_count++;
+		n = src->rx_fn(src->rx_arg, mbufs, BATCH_SIZE);
+		if (unlikely(!n)) {
+			if (rxq_empty)
+				*rxq_empty = 1;
+			break;
+		}
+		rxa_timestamp_mbufs(mbufs, n);
+		rxa_buffer_queue_mbufs(rx_adapter, &src->queue_info, mbufs, n);
+		nb_rx += n;
+		if (rx_count + nb_rx > max_rx)
+			break;
+	}
+
+	if (buf->count >= BATCH_SIZE)
+		rxa_flush_event_buffer(rx_adapter);
+
+	return nb_rx;
+}
+
+/* Called from the interrupt thread with the intr_ring_lock held */
+static inline void
+rxa_src_intr_ring_enqueue(struct rte_event_eth_rx_adapter *rx_adapter,
+		void *data)
+{
+	union queue_data qd;
+	struct rxa_src *src;
+	int err;
+
+	qd.ptr = data;
+	src = rx_adapter->srcs[qd.queue];
+	/* The source may have been deleted since the epoll wait */
+	if (src == NULL || !src->queue_info.intr_enabled)
+		return;
+
+	src->queue_info.intr_enabled = 0;
+	err = rte_ring_enqueue(rx_adapter->intr_ring, data);
+	if (err)
+		RTE_EDEV_LOG_ERR("Failed to enqueue interrupt"
+			" to ring: %s", strerror(err));
+	else if (src->intr_ctl)
+		src->intr_ctl(src->rx_arg, 0);
+}
+
+/* Called from the service function with the intr_ring_lock held, the
+ * source is then polled until empty
+ */
+static inline void
+rxa_src_intr_enable(struct rxa_src *src)
+{
+	src->queue_info.intr_enabled = 1;
+	if (src->intr_ctl)
+		src->intr_ctl(src->rx_arg, 1);
+}
+
 static inline void
 rxa_intr_ring_enqueue(struct rte_event_eth_rx_adapter *rx_adapter,
 		void *data)
@@ -894,6 +1215,13 @@ rxa_intr_ring_enqueue(struct rte_event_eth_rx_adapter *rx_adapter,
 	port_id = qd.port;
 	queue = qd.queue;
 
+	if (port_id == RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT) {
+		rte_spinlock_lock(&rx_adapter->intr_ring_lock);
+		rxa_src_intr_ring_enqueue(rx_adapter, data);
+		rte_spinlock_unlock(&rx_adapter->intr_ring_lock);
+		return;
+	}
+
 	dev_info = &rx_adapter->eth_devices[port_id];
 	queue_info = &dev_info->rx_queue[queue];
 	rte_spinlock_lock(&rx_adapter->intr_ring_lock);
@@ -1003,7 +1331,7 @@ rxa_intr_ring_dequeue(struct rte_event_eth_rx_adapter *rx_adapter)
 	rte_spinlock_t *ring_lock;
 	uint8_t max_done = 0;
 
-	if (rx_adapter->num_rx_intr == 0)
+	if (rx_adapter->num_rx_intr == 0 && rx_adapter->num_src_intr == 0)
 		return 0;
 
 	if (rte_ring_count(rx_adapter->intr_ring) == 0
@@ -1037,22 +1365,36 @@ rxa_intr_ring_dequeue(struct rte_event_eth_rx_adapter *rx_adapter)
 			queue = qd.queue;
 			rx_adapter->qd = qd;
 			rx_adapter->qd_valid = 1;
-			dev_info = &rx_adapter->eth_devices[port];
-			if (rxa_shared_intr(dev_info, queue))
-				dev_info->shared_intr_enabled = 1;
-			else {
-				queue_info = &dev_info->rx_queue[queue];
-				queue_info->intr_enabled = 1;
+			if (port == RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT) {
+				rxa_src_intr_enable(rx_adapter->srcs[queue]);
+			} else {
+				dev_info = &rx_adapter->eth_devices[port];
+				if (rxa_shared_intr(dev_info, queue))
+					dev_info->shared_intr_enabled = 1;
+				else {
+					queue_info = &dev_info->rx_queue[queue];
+					queue_info->intr_enabled = 1;
+				}
+				rte_eth_dev_rx_intr_enable(port, queue);
 			}
-			rte_eth_dev_rx_intr_enable(port, queue);
 			rte_spinlock_unlock(ring_lock);
 		} else {
 			port = qd.port;
 			queue = qd.queue;
+		}
 
-			dev_info = &rx_adapter->eth_devices[port];
+		if (port == RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT) {
+			n = rxa_src_rx(rx_adapter, rx_adapter->srcs[queue],
+				nb_rx, rx_adapter->max_nb_rx, UINT32_MAX,
+				&rxq_empty);
+			rx_adapter->qd_valid = !rxq_empty;
+			nb_rx += n;
+			if (nb_rx > rx_adapter->max_nb_rx)
+				break;
+			continue;
 		}
 
+		dev_info = &rx_adapter->eth_devices[port];
 		if (rxa_shared_intr(dev_info, queue)) {
 			uint16_t i;
 			uint16_t nb_queues;
@@ -1156,6 +1498,43 @@ rxa_poll(struct rte_event_eth_rx_adapter *rx_adapter)
 	return nb_rx;
 }
 
+/*
+ * Polls the external Rx sources added to the event adapter, a source is
+ * polled for up to its servicing weight bursts per round.
+ */
+static inline uint32_t
+rxa_src_poll(struct rte_event_eth_rx_adapter *rx_adapter)
+{
+	struct rte_eth_event_enqueue_buffer *buf;
+	uint32_t num_src;
+	uint32_t nb_rx = 0;
+	uint32_t pos;
+	uint32_t max_nb_rx;
+
+	pos = rx_adapter->src_poll_pos;
+	max_nb_rx = rx_adapter->max_nb_rx;
+	buf = &rx_adapter->event_enqueue_buffer;
+
+	for (num_src = 0; num_src < rx_adapter->num_src_polled; num_src++) {
+		struct rxa_src *src = rx_adapter->src_poll[pos];
+
+		if (buf->count >= BATCH_SIZE)
+			rxa_flush_event_buffer(rx_adapter);
+		if (BATCH_SIZE > (ETH_EVENT_BUFFER_SIZE - buf->count))
+			break;
+
+		if (++pos == rx_adapter->num_src_polled)
+			pos = 0;
+		nb_rx += rxa_src_rx(rx_adapter, src, nb_rx, max_nb_rx,
+				src->queue_info.wt, NULL);
+		if (nb_rx > max_nb_rx)
+			break;
+	}
+
+	rx_adapter->src_poll_pos = pos;
+	return nb_rx;
+}
+
 static int
 rxa_service_func(void *args)
 {
@@ -1172,6 +1551,10 @@ rxa_service_func(void *args)
 	stats = &rx_adapter->stats;
 	stats->rx_packets += rxa_intr_ring_dequeue(rx_adapter);
 	stats->rx_packets += rxa_poll(rx_adapter);
+	if (rx_adapter->num_src_polled)
+		stats->rx_packets += rxa_src_poll(rx_adapter);
+	if (!TAILQ_EMPTY(&rx_adapter->vector_list))
+		rxa_vector_expire(rx_adapter);
 	rte_spinlock_unlock(&rx_adapter->rx_lock);
 	return 0;
 }
@@ -1355,7 +1738,7 @@ rxa_free_intr_resources(struct rte_event_eth_rx_adapter *rx_adapter)
 {
 	int ret;
 
-	if (rx_adapter->num_rx_intr == 0)
+	if (rx_adapter->intr_ring == NULL)
 		return 0;
 
 	ret = rxa_destroy_intr_thread(rx_adapter);
@@ -1598,6 +1981,169 @@ rxa_add_intr_queue(struct rte_event_eth_rx_adapter *rx_adapter,
 	return err;
 }
 
+/* EAL callback clearing the notification fd of an external Rx source */
+static void
+rxa_src_intr_cb(int fd, void *arg __rte_unused)
+{
+	uint64_t count;
+	ssize_t n;
+
+	n = read(fd, &count, sizeof(count));
+	RTE_SET_USED(n);
+}
+
+static int
+rxa_src_config_intr(struct rte_event_eth_rx_adapter *rx_adapter,
+	struct rxa_src *src,
+	uint16_t src_id)
+{
+#if defined(LINUX)
+	struct rte_epoll_data *epdata = &src->epoll_event.epdata;
+	union queue_data qd;
+	int init_fd;
+	int err;
+
+	init_fd = rx_adapter->epd;
+	err = rxa_init_epd(rx_adapter);
+	if (err)
+		return err;
+
+	qd.port = RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT;
+	qd.queue = src_id;
+	epdata->event = EPOLLIN | EPOLLPRI | EPOLLET;
+	epdata->data = qd.ptr;
+	epdata->cb_fun = rxa_src_intr_cb;
+	epdata->cb_arg = NULL;
+
+	err = rte_epoll_ctl(rx_adapter->epd, EPOLL_CTL_ADD, src->intr_fd,
+			&src->epoll_event);
+	if (err) {
+		RTE_EDEV_LOG_ERR("Failed to add interrupt event for"
+			" Rx source %u fd %d", src_id, src->intr_fd);
+		err = -EINVAL;
+		goto err_del_fd;
+	}
+
+	err = rxa_create_intr_thread(rx_adapter);
+	if (!err)
+		return 0;
+
+	rte_epoll_ctl(rx_adapter->epd, EPOLL_CTL_DEL, src->intr_fd,
+			&src->epoll_event);
+err_del_fd:
+	if (init_fd == INIT_FD) {
+		close(rx_adapter->epd);
+		rx_adapter->epd = INIT_FD;
+	}
+	return err;
+#else
+	RTE_SET_USED(rx_adapter);
+	RTE_SET_USED(src);
+	RTE_SET_USED(src_id);
+	return -ENOTSUP;
+#endif
+}
+
+static void
+rxa_src_del_intr(struct rte_event_eth_rx_adapter *rx_adapter,
+	struct rxa_src *src,
+	uint16_t src_id)
+{
+	union queue_data qd;
+	int i, n;
+
+#if defined(LINUX)
+	if (rte_epoll_ctl(rx_adapter->epd, EPOLL_CTL_DEL, src->intr_fd,
+			&src->epoll_event))
+		RTE_EDEV_LOG_ERR("Could not delete event for"
+			" Rx source %u fd %d", src_id, src->intr_fd);
+#endif
+
+	/* Unpublish the source, then drop its pending interrupts */
+	rte_spinlock_lock(&rx_adapter->intr_ring_lock);
+	rx_adapter->srcs[src_id] = NULL;
+	n = rte_ring_count(rx_adapter->intr_ring);
+	for (i = 0; i < n; i++) {
+		rte_ring_dequeue(rx_adapter->intr_ring, &qd.ptr);
+		if (qd.port == RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT &&
+			qd.queue == src_id)
+			continue;
+		rte_ring_enqueue(rx_adapter->intr_ring, qd.ptr);
+	}
+	rte_spinlock_unlock(&rx_adapter->intr_ring_lock);
+
+	qd = rx_adapter->qd;
+	if (rx_adapter->qd_valid &&
+		qd.port == RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT &&
+		qd.queue == src_id)
+		rx_adapter->qd_valid = 0;
+}
+
+/* Double the size of the external Rx source arrays */
+static int
+rxa_src_array_grow(struct rte_event_eth_rx_adapter *rx_adapter)
+{
+	struct rxa_src **srcs;
+	struct rxa_src **src_poll;
+	struct rxa_src **old_srcs = rx_adapter->srcs;
+	struct rxa_src **old_src_poll = rx_adapter->src_poll;
+	uint32_t size;
+
+	if (rx_adapter->src_array_size == RXA_MAX_SRCS)
+		return -ENOSPC;
+
+	size = rx_adapter->src_array_size ?
+		RTE_MIN(rx_adapter->src_array_size * 2, RXA_MAX_SRCS) :
+		RXA_SRC_ARRAY_SIZE;
+	srcs = rte_zmalloc_socket(rx_adapter->mem_name,
+				size * sizeof(*srcs),
+				RTE_CACHE_LINE_SIZE,
+				rx_adapter->socket_id);
+	src_poll = rte_zmalloc_socket(rx_adapter->mem_name,
+				size * sizeof(*src_poll),
+				RTE_CACHE_LINE_SIZE,
+				rx_adapter->socket_id);
+	if (srcs == NULL || src_poll == NULL) {
+		rte_free(srcs);
+		rte_free(src_poll);
+		return -ENOMEM;
+	}
+
+	if (old_srcs != NULL) {
+		memcpy(srcs, old_srcs,
+			rx_adapter->src_array_size * sizeof(*srcs));
+		memcpy(src_poll, old_src_poll,
+			rx_adapter->num_src_polled * sizeof(*src_poll));
+	}
+
+	/* The interrupt thread looks up the sources with the lock held */
+	rte_spinlock_lock(&rx_adapter->intr_ring_lock);
+	rx_adapter->srcs = srcs;
+	rx_adapter->src_poll = src_poll;
+	rx_adapter->src_array_size = size;
+	rte_spinlock_unlock(&rx_adapter->intr_ring_lock);
+
+	rte_free(old_srcs);
+	rte_free(old_src_poll);
+	return 0;
+}
+
+/* Rebuild the array of the polled external Rx sources */
+static void
+rxa_calc_src_poll(struct rte_event_eth_rx_adapter *rx_adapter)
+{
+	uint32_t i;
+	uint32_t n = 0;
+
+	for (i = 0; i < rx_adapter->src_array_size; i++) {
+		struct rxa_src *src = rx_adapter->srcs[i];
+
+		if (src != NULL && src->queue_info.wt != 0)
+			rx_adapter->src_poll[n++] = src;
+	}
+	rx_adapter->num_src_polled = n;
+	rx_adapter->src_poll_pos = 0;
+}
 
 static int
 rxa_init_service(struct rte_event_eth_rx_adapter *rx_adapter, uint8_t id)
@@ -1698,6 +2244,8 @@ rxa_sw_del(struct rte_event_eth_rx_adapter *rx_adapter,
 	pollq = rxa_polled_queue(dev_info, rx_queue_id);
 	intrq = rxa_intr_queue(dev_info, rx_queue_id);
 	sintrq = rxa_shared_intr(dev_info, rx_queue_id);
+	rxa_vector_queue_flush(rx_adapter, &dev_info->rx_queue[rx_queue_id]);
+	dev_info->rx_queue[rx_queue_id].ena_vector = 0;
 	rxa_update_queue(rx_adapter, dev_info, rx_queue_id, 0);
 	rx_adapter->num_rx_polled -= pollq;
 	dev_info->nb_rx_poll -= pollq;
@@ -1706,6 +2254,46 @@ rxa_sw_del(struct rte_event_eth_rx_adapter *rx_adapter,
 	dev_info->nb_shared_intr -= intrq && sintrq;
 }
 
+/* Set the event configuration of the Rx queue or source of queue_info */
+static void
+rxa_set_queue_info(struct rte_event_eth_rx_adapter *rx_adapter,
+	struct eth_rx_queue_info *queue_info,
+	uint16_t port,
+	uint16_t queue,
+	const struct rte_event_eth_rx_adapter_queue_conf *conf)
+{
+	const struct rte_event *ev = &conf->ev;
+
+	rxa_vector_queue_flush(rx_adapter, queue_info);
+	queue_info->event_queue_id = ev->queue_id;
+	queue_info->sched_type = ev->sched_type;
+	queue_info->priority = ev->priority;
+	queue_info->wt = conf->servicing_weight;
+
+	if (conf->rx_queue_flags &
+			RTE_EVENT_ETH_RX_ADAPTER_QUEUE_FLOW_ID_VALID) {
+		queue_info->flow_id = ev->flow_id;
+		queue_info->flow_id_mask = ~0;
+	}
+
+	queue_info->ena_vector = !!(conf->rx_queue_flags &
+			RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR);
+	if (queue_info->ena_vector) {
+		queue_info->port = port;
+		queue_info->queue = queue;
+		queue_info->vector_sz = conf->vector_sz;
+		queue_info->vector_mp = conf->vector_mp;
+		queue_info->vector_tmo_ticks = RTE_MAX(UINT64_C(1),
+			(uint64_t)(conf->vector_timeout_ns *
+				(rte_get_tsc_hz() / 1E9)));
+		if (rx_adapter->vector_tmo_ticks == 0 ||
+			queue_info->vector_tmo_ticks <
+				rx_adapter->vector_tmo_ticks)
+			rx_adapter->vector_tmo_ticks =
+				queue_info->vector_tmo_ticks;
+	}
+}
+
 static void
 rxa_add_queue(struct rte_event_eth_rx_adapter *rx_adapter,
 	struct eth_device_info *dev_info,
@@ -1713,7 +2301,6 @@ rxa_add_queue(struct rte_event_eth_rx_adapter *rx_adapter,
 	const struct rte_event_eth_rx_adapter_queue_conf *conf)
 {
 	struct eth_rx_queue_info *queue_info;
-	const struct rte_event *ev = &conf->ev;
 	int pollq;
 	int intrq;
 	int sintrq;
@@ -1733,16 +2320,8 @@ rxa_add_queue(struct rte_event_eth_rx_adapter *rx_adapter,
 	sintrq = rxa_shared_intr(dev_info, rx_queue_id);
 
 	queue_info = &dev_info->rx_queue[rx_queue_id];
-	queue_info->event_queue_id = ev->queue_id;
-	queue_info->sched_type = ev->sched_type;
-	queue_info->priority = ev->priority;
-	queue_info->wt = conf->servicing_weight;
-
-	if (conf->rx_queue_flags &
-			RTE_EVENT_ETH_RX_ADAPTER_QUEUE_FLOW_ID_VALID) {
-		queue_info->flow_id = ev->flow_id;
-		queue_info->flow_id_mask = ~0;
-	}
+	rxa_set_queue_info(rx_adapter, queue_info,
+			dev_info->dev->data->port_id, rx_queue_id, conf);
 
 	rxa_update_queue(rx_adapter, dev_info, rx_queue_id, 1);
 	if (rxa_polled_queue(dev_info, rx_queue_id)) {
@@ -1769,6 +2348,18 @@ rxa_add_queue(struct rte_event_eth_rx_adapter *rx_adapter,
 	}
 }
 
+static int
+rxa_vector_conf_valid(
+	const struct rte_event_eth_rx_adapter_queue_conf *queue_conf)
+{
+	return queue_conf->vector_sz != 0 &&
+		queue_conf->vector_timeout_ns != 0 &&
+		queue_conf->vector_mp != NULL &&
+		queue_conf->vector_mp->elt_size >=
+			sizeof(struct rte_event_vector) +
+			queue_conf->vector_sz * sizeof(uintptr_t);
+}
+
 static int rxa_sw_add(struct rte_event_eth_rx_adapter *rx_adapter,
 		uint16_t eth_dev_id,
 		int rx_queue_id,
@@ -1853,7 +2444,7 @@ static int rxa_sw_add(struct rte_event_eth_rx_adapter *rx_adapter,
 		}
 	}
 
-	if (nb_rx_intr == 0) {
+	if (nb_rx_intr == 0 && rx_adapter->num_src_intr == 0) {
 		ret = rxa_free_intr_resources(rx_adapter);
 		if (ret)
 			goto err_free_rxqueue;
@@ -1933,6 +2524,7 @@ rxa_ctrl(uint8_t id, int start)
 						&rte_eth_devices[i]);
 	}
 
+	use_service |= rx_adapter->num_srcs != 0;
 	if (use_service) {
 		rte_spinlock_lock(&rx_adapter->rx_lock);
 		rx_adapter->rxa_started = start;
@@ -2010,6 +2602,7 @@ rte_event_eth_rx_adapter_create_ext(uint8_t id, uint8_t dev_id,
 		return -ENOMEM;
 	}
 	rte_spinlock_init(&rx_adapter->rx_lock);
+	TAILQ_INIT(&rx_adapter->vector_list);
 	for (i = 0; i < RTE_MAX_ETHPORTS; i++)
 		rx_adapter->eth_devices[i].dev = &rte_eth_devices[i];
 
@@ -2059,8 +2652,16 @@ rte_event_eth_rx_adapter_free(uint8_t id)
 		return -EBUSY;
 	}
 
+	if (rx_adapter->num_srcs) {
+		RTE_EDEV_LOG_ERR("%" PRIu32 " Rx sources not deleted",
+				rx_adapter->num_srcs);
+		return -EBUSY;
+	}
+
 	if (rx_adapter->default_cb_arg)
 		rte_free(rx_adapter->conf_arg);
+	rte_free(rx_adapter->srcs);
+	rte_free(rx_adapter->src_poll);
 	rte_free(rx_adapter->eth_devices);
 	rte_free(rx_adapter);
 	event_eth_rx_adapter[id] = NULL;
@@ -2106,6 +2707,23 @@ rte_event_eth_rx_adapter_queue_add(uint8_t id,
 		return -EINVAL;
 	}
 
+	if (queue_conf->rx_queue_flags &
+			RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR) {
+		if (cap & RTE_EVENT_ETH_RX_ADAPTER_CAP_INTERNAL_PORT) {
+			RTE_EDEV_LOG_ERR("Event vectorization is not supported,"
+				" eth port: %" PRIu16 " adapter id: %" PRIu8,
+				eth_dev_id, id);
+			return -ENOTSUP;
+		}
+
+		if (!rxa_vector_conf_valid(queue_conf)) {
+			RTE_EDEV_LOG_ERR("Invalid event vector configuration,"
+				" eth port: %" PRIu16 " adapter id: %" PRIu8,
+				eth_dev_id, id);
+			return -EINVAL;
+		}
+	}
+
 	if ((cap & RTE_EVENT_ETH_RX_ADAPTER_CAP_MULTI_EVENTQ) == 0 &&
 		(rx_queue_id != -1)) {
 		RTE_EDEV_LOG_ERR("Rx queues can only be connected to single "
@@ -2243,7 +2861,7 @@ rte_event_eth_rx_adapter_queue_del(uint8_t id, uint16_t eth_dev_id,
 				goto unlock_ret;
 		}
 
-		if (nb_rx_intr == 0) {
+		if (nb_rx_intr == 0 && rx_adapter->num_src_intr == 0) {
 			ret = rxa_free_intr_resources(rx_adapter);
 			if (ret)
 				goto unlock_ret;
@@ -2426,3 +3044,209 @@ int rte_event_eth_rx_adapter_cb_register(uint8_t id,
 
 	return 0;
 }
+
+int __rte_experimental
+rte_event_eth_rx_adapter_src_add(uint8_t id,
+			const struct rte_event_eth_rx_adapter_src_conf *conf,
+			uint16_t *src_id)
+{
+	struct rte_event_eth_rx_adapter *rx_adapter;
+	const struct rte_event_eth_rx_adapter_queue_conf *queue_conf;
+	struct rxa_src *src;
+	union queue_data qd;
+	uint32_t i;
+	int ret;
+
+	RTE_EVENT_ETH_RX_ADAPTER_ID_VALID_OR_ERR_RET(id, -EINVAL);
+
+	rx_adapter = rxa_id_to_adapter(id);
+	if (rx_adapter == NULL || conf == NULL || conf->rx_fn == NULL ||
+		src_id == NULL)
+		return -EINVAL;
+
+	queue_conf = &conf->queue_conf;
+	if (queue_conf->servicing_weight == 0 && conf->intr_fd < 0) {
+		RTE_EDEV_LOG_ERR("No notification fd for interrupt driven"
+				" Rx source, adapter id: %" PRIu8, id);
+		return -EINVAL;
+	}
+
+	if ((queue_conf->rx_queue_flags &
+			RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR) &&
+		!rxa_vector_conf_valid(queue_conf)) {
+		RTE_EDEV_LOG_ERR("Invalid event vector configuration,"
+				" adapter id: %" PRIu8, id);
+		return -EINVAL;
+	}
+
+	src = rte_zmalloc_socket(rx_adapter->mem_name, sizeof(*src),
+				RTE_CACHE_LINE_SIZE, rx_adapter->socket_id);
+	if (src == NULL)
+		return -ENOMEM;
+
+	src->rx_fn = conf->rx_fn;
+	src->rx_arg = conf->rx_arg;
+	src->intr_ctl = conf->intr_ctl;
+	src->intr_fd = queue_conf->servicing_weight == 0 ? conf->intr_fd : -1;
+
+	rte_spinlock_lock(&rx_adapter->rx_lock);
+	ret = rxa_init_service(rx_adapter, id);
+	if (ret)
+		goto unlock_ret;
+
+	for (i = 0; i < rx_adapter->src_array_size; i++)
+		if (rx_adapter->srcs[i] == NULL)
+			break;
+	if (i == rx_adapter->src_array_size) {
+		ret = rxa_src_array_grow(rx_adapter);
+		if (ret)
+			goto unlock_ret;
+	}
+
+	if (src->intr_fd >= 0) {
+		ret = rxa_intr_ring_check_avail(rx_adapter, 1);
+		if (ret)
+			goto unlock_ret;
+	}
+
+	rxa_set_queue_info(rx_adapter, &src->queue_info,
+			RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT, i, queue_conf);
+	src->queue_info.queue_enabled = 1;
+
+	/* The interrupts of the source stay disabled until it is first
+	 * polled, which drains the mbufs received before it was added
+	 */
+	rte_spinlock_lock(&rx_adapter->intr_ring_lock);
+	rx_adapter->srcs[i] = src;
+	rte_spinlock_unlock(&rx_adapter->intr_ring_lock);
+
+	if (src->intr_fd >= 0) {
+		ret = rxa_src_config_intr(rx_adapter, src, i);
+		if (ret) {
+			rte_spinlock_lock(&rx_adapter->intr_ring_lock);
+			rx_adapter->srcs[i] = NULL;
+			rte_spinlock_unlock(&rx_adapter->intr_ring_lock);
+			goto unlock_ret;
+		}
+
+		qd.port = RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT;
+		qd.queue = i;
+		rte_spinlock_lock(&rx_adapter->intr_ring_lock);
+		if (rte_ring_enqueue(rx_adapter->intr_ring, qd.ptr))
+			rxa_src_intr_enable(src);
+		rte_spinlock_unlock(&rx_adapter->intr_ring_lock);
+		rx_adapter->num_src_intr++;
+		rx_adapter->num_intr_vec++;
+	}
+
+	rx_adapter->num_srcs++;
+	rxa_calc_src_poll(rx_adapter);
+	rte_service_component_runstate_set(rx_adapter->service_id,
+			rxa_sw_adapter_queue_count(rx_adapter));
+	*src_id = i;
+
+unlock_ret:
+	rte_spinlock_unlock(&rx_adapter->rx_lock);
+	if (ret)
+		rte_free(src);
+	return ret;
+}
+
+int __rte_experimental
+rte_event_eth_rx_adapter_src_del(uint8_t id, uint16_t src_id)
+{
+	struct rte_event_eth_rx_adapter *rx_adapter;
+	struct rxa_src *src;
+
+	RTE_EVENT_ETH_RX_ADAPTER_ID_VALID_OR_ERR_RET(id, -EINVAL);
+
+	rx_adapter = rxa_id_to_adapter(id);
+	if (rx_adapter == NULL)
+		return -EINVAL;
+
+	rte_spinlock_lock(&rx_adapter->rx_lock);
+	if (src_id >= rx_adapter->src_array_size ||
+		rx_adapter->srcs[src_id] == NULL) {
+		rte_spinlock_unlock(&rx_adapter->rx_lock);
+		return -EINVAL;
+	}
+
+	src = rx_adapter->srcs[src_id];
+	rxa_vector_queue_flush(rx_adapter, &src->queue_info);
+	if (src->intr_fd >= 0) {
+		rxa_src_del_intr(rx_adapter, src, src_id);
+		rx_adapter->num_src_intr--;
+		rx_adapter->num_intr_vec--;
+		if (rx_adapter->num_rx_intr == 0 &&
+			rx_adapter->num_src_intr == 0)
+			rxa_free_intr_resources(rx_adapter);
+	} else {
+		rte_spinlock_lock(&rx_adapter->intr_ring_lock);
+		rx_adapter->srcs[src_id] = NULL;
+		rte_spinlock_unlock(&rx_adapter->intr_ring_lock);
+	}
+
+	rx_adapter->num_srcs--;
+	rxa_calc_src_poll(rx_adapter);
+	rte_service_component_runstate_set(rx_adapter->service_id,
+			rxa_sw_adapter_queue_count(rx_adapter));
+	rte_spinlock_unlock(&rx_adapter->rx_lock);
+
+	rte_free(src);
+	return 0;
+}
+
+#ifdef RTE_LIBRTE_VHOST
+uint16_t __rte_experimental
+rte_event_eth_rx_adapter_vhost_rx(void *rx_arg, struct rte_mbuf **mbufs,
+				uint16_t nb_mbufs)
+{
+	struct rte_event_eth_rx_adapter_vhost_queue *vq = rx_arg;
+
+	return rte_vhost_dequeue_burst(vq->vid, vq->queue_id, vq->mbuf_pool,
+				mbufs, nb_mbufs);
+}
+
+int __rte_experimental
+rte_event_eth_rx_adapter_vhost_intr_ctl(void *rx_arg, int enable)
+{
+	struct rte_event_eth_rx_adapter_vhost_queue *vq = rx_arg;
+
+	return rte_vhost_enable_guest_notification(vq->vid, vq->queue_id,
+						enable);
+}
+
+int __rte_experimental
+rte_event_eth_rx_adapter_vhost_queue_add(uint8_t id,
+		struct rte_event_eth_rx_adapter_vhost_queue *vq,
+		const struct rte_event_eth_rx_adapter_queue_conf *queue_conf,
+		uint16_t *src_id)
+{
+	struct rte_event_eth_rx_adapter_src_conf conf;
+	struct rte_vhost_vring vring;
+
+	if (vq == NULL || queue_conf == NULL)
+		return -EINVAL;
+
+	memset(&conf, 0, sizeof(conf));
+	conf.rx_fn = rte_event_eth_rx_adapter_vhost_rx;
+	conf.intr_ctl = rte_event_eth_rx_adapter_vhost_intr_ctl;
+	conf.rx_arg = vq;
+	conf.intr_fd = -1;
+	conf.queue_conf = *queue_conf;
+
+	if (queue_conf->servicing_weight == 0) {
+		if (rte_vhost_get_vhost_vring(vq->vid, vq->queue_id, &vring))
+			return -EINVAL;
+		conf.intr_fd = vring.kickfd;
+	}
+
+	return rte_event_eth_rx_adapter_src_add(id, &conf, src_id);
+}
+
+int __rte_experimental
+rte_event_eth_rx_adapter_vhost_queue_del(uint8_t id, uint16_t src_id)
+{
+	return rte_event_eth_rx_adapter_src_del(id, src_id);
+}
+#endif
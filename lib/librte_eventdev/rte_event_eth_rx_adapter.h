@@ -37,6 +37,8 @@
  *  - rte_event_eth_rx_adapter_stop()
  *  - rte_event_eth_rx_adapter_stats_get()
  *  - rte_event_eth_rx_adapter_stats_reset()
+ *  - rte_event_eth_rx_adapter_src_add()
+ *  - rte_event_eth_rx_adapter_src_del()
  *
  * The application creates an ethernet to event adapter using
  * rte_event_eth_rx_adapter_create_ext() or rte_event_eth_rx_adapter_create()
@@ -55,6 +57,20 @@
  * interrupt is enabled when configuring the device, the receive queue is
  * interrupt driven; else, the queue is assigned a servicing weight of one.
  *
+ * With the RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR flag, the SW adapter
+ * aggregates the mbufs of the same flow received from the queue into event
+ * vectors, so the event device schedules one event per vector instead of one
+ * per mbuf. A vector is enqueued once full or once its timeout expired.
+ *
+ * Besides the ethernet Rx queues, the SW adapter can receive mbufs from
+ * external Rx sources added with rte_event_eth_rx_adapter_src_add(), such as
+ * vhost virtqueues (see rte_event_eth_rx_adapter_vhost.h). A source is
+ * polled through an application provided receive function, with the same
+ * servicing weight semantic as the Rx queues. A source with a servicing
+ * weight of zero is interrupt driven: the adapter waits for its notification
+ * file descriptor to be readable before polling it until it is empty, so
+ * idle sources cost no polling.
+ *
  * The application can start/stop the adapter using the
  * rte_event_eth_rx_adapter_start() and the rte_event_eth_rx_adapter_stop()
  * functions. If the adapter uses a rte_service function, then the application
@@ -95,6 +111,21 @@ extern "C" {
 /**< This flag indicates the flow identifier is valid
  * @see rte_event_eth_rx_adapter_queue_conf::rx_queue_flags
  */
+#define RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR	0x2
+/**< This flag indicates that the adapter aggregates the mbufs received from
+ * the queue into event vectors, of type
+ * RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR, instead of enqueueing one event per
+ * mbuf. Only supported by the SW adapter.
+ * @see rte_event_eth_rx_adapter_queue_conf::rx_queue_flags
+ * @see rte_event_eth_rx_adapter_queue_conf::vector_sz
+ */
+
+#define RTE_EVENT_ETH_RX_ADAPTER_SRC_PORT	UINT16_MAX
+/**< Port identifier reported for the mbufs of the external Rx sources,
+ * e.g. in the port field of the event vectors, whose queue field holds the
+ * source identifier.
+ * @see rte_event_eth_rx_adapter_src_add()
+ */
 
 /**
  * @warning
@@ -179,6 +210,24 @@ struct rte_event_eth_rx_adapter_queue_conf {
 	 * The event adapter sets ev.event_type to RTE_EVENT_TYPE_ETHDEV in the
 	 * enqueued event.
 	 */
+	uint16_t vector_sz;
+	/**< Maximum number of mbufs per event vector, valid if the
+	 * RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR bit is set in
+	 * rx_queue_flags. The adapter aggregates the mbufs of the same flow,
+	 * i.e. with the same flow ID, into a vector, which is enqueued when
+	 * it holds vector_sz mbufs or when vector_timeout_ns have elapsed
+	 * since its first mbuf was received.
+	 */
+	uint64_t vector_timeout_ns;
+	/**< Maximum time the adapter waits for vector_sz mbufs before
+	 * enqueueing an incomplete event vector, in nanoseconds.
+	 */
+	struct rte_mempool *vector_mp;
+	/**< Mempool of the event vectors, created by
+	 * rte_event_vector_pool_create() with at least vector_sz elements per
+	 * vector. When the mempool is empty, the adapter enqueues one event
+	 * per mbuf.
+	 */
 };
 
 /**
@@ -253,6 +302,70 @@ typedef uint16_t (*rte_event_eth_rx_adapter_cb_fn)(uint16_t eth_dev_id,
 						void *cb_arg,
 						struct rte_mbuf **enq_buf);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Receive function of an external Rx source, called by the SW adapter to
+ * dequeue mbufs from the source.
+ *
+ * @param rx_arg
+ *  Argument of the source.
+ * @param mbufs
+ *  Array to store the received mbufs in.
+ * @param nb_mbufs
+ *  Maximum number of mbufs to receive.
+ * @return
+ *  Number of mbufs received.
+ */
+typedef uint16_t (*rte_event_eth_rx_adapter_src_rx_t)(void *rx_arg,
+						struct rte_mbuf **mbufs,
+						uint16_t nb_mbufs);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Notification control function of an interrupt driven external Rx source.
+ * The SW adapter disables the notifications of the source while it polls it
+ * and enables them again before it checks the source is empty.
+ *
+ * @param rx_arg
+ *  Argument of the source.
+ * @param enable
+ *  Non-zero to enable the notifications, zero to disable them.
+ * @return
+ *  - 0: Success
+ *  - <0: Error code on failure.
+ */
+typedef int (*rte_event_eth_rx_adapter_src_intr_ctl_t)(void *rx_arg,
+						int enable);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Configuration of an external Rx source.
+ * @see rte_event_eth_rx_adapter_src_add()
+ */
+struct rte_event_eth_rx_adapter_src_conf {
+	rte_event_eth_rx_adapter_src_rx_t rx_fn;
+	/**< Receive function of the source */
+	rte_event_eth_rx_adapter_src_intr_ctl_t intr_ctl;
+	/**< Notification control function of the source, may be NULL */
+	void *rx_arg;
+	/**< Argument of rx_fn and intr_ctl */
+	int intr_fd;
+	/**< File descriptor readable when the source has mbufs to receive,
+	 * e.g. an eventfd, or -1. Required if the servicing weight of
+	 * queue_conf is zero. The adapter reads it to clear the notification.
+	 */
+	struct rte_event_eth_rx_adapter_queue_conf queue_conf;
+	/**< Event configuration of the mbufs of the source, as for an Rx
+	 * queue. A servicing weight of zero makes the source interrupt driven.
+	 */
+};
+
 /**
  * @warning
  * @b EXPERIMENTAL: this API may change without prior notice
@@ -503,6 +616,52 @@ rte_event_eth_rx_adapter_cb_register(uint8_t id,
 				rte_event_eth_rx_adapter_cb_fn cb_fn,
 				void *cb_arg);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add an external Rx source to the adapter, this is supported for SW based
+ * packet transfers. The adapter service function polls the source through
+ * its receive function, or waits for its notification file descriptor if
+ * the servicing weight of the source is zero.
+ *
+ * @param id
+ *  Adapter identifier.
+ * @param conf
+ *  Configuration of the source, rx_arg must remain valid until the source
+ *  is deleted.
+ * @param[out] src_id
+ *  Identifier of the source.
+ * @return
+ *  - 0: Success
+ *  - -EINVAL: Invalid configuration.
+ *  - -ENOSPC: No interrupt ring slot left for an interrupt driven source.
+ *  - -ENOMEM: No memory left for the source.
+ *  - <0: Other error code on failure.
+ */
+int __rte_experimental
+rte_event_eth_rx_adapter_src_add(uint8_t id,
+			const struct rte_event_eth_rx_adapter_src_conf *conf,
+			uint16_t *src_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete an external Rx source from the adapter. The adapter no longer
+ * calls the functions of the source once this function returns.
+ *
+ * @param id
+ *  Adapter identifier.
+ * @param src_id
+ *  Identifier of the source.
+ * @return
+ *  - 0: Success
+ *  - -EINVAL: Invalid adapter or source identifier.
+ */
+int __rte_experimental
+rte_event_eth_rx_adapter_src_del(uint8_t id, uint16_t src_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,127 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_EVENT_ETH_RX_ADAPTER_VHOST_
+#define _RTE_EVENT_ETH_RX_ADAPTER_VHOST_
+
+/**
+ * @file
+ *
+ * RTE Event Ethernet Rx Adapter vhost sources
+ *
+ * Helpers adding the virtqueues of vhost devices to an ethernet Rx event
+ * adapter as external Rx sources, without going through the vhost PMD. The
+ * adapter dequeues the packets sent by the guest from the virtqueue with
+ * rte_vhost_dequeue_burst().
+ *
+ * A virtqueue added with a servicing weight of zero is interrupt driven: the
+ * adapter waits for the kick file descriptor of the virtqueue, with the
+ * guest notifications enabled, and disables them while it polls the
+ * virtqueue, so that an idle virtqueue is not polled at all.
+ *
+ * The kick file descriptor of a virtqueue changes when the guest
+ * reconfigures it, the application deletes the virtqueues of a device from
+ * the adapter in the destroy_device() and vring_state_changed() callbacks
+ * of the vhost device, and adds them back in the new_device() callback.
+ *
+ * These helpers are built in the eventdev library when the vhost library is
+ * enabled.
+ */
+
+#include <stdint.h>
+
+#include <rte_compat.h>
+#include <rte_mbuf.h>
+
+#include "rte_event_eth_rx_adapter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this structure may change without prior notice
+ *
+ * Virtqueue of a vhost device added to an Rx adapter, owned by the
+ * application until the virtqueue is deleted from the adapter.
+ */
+struct rte_event_eth_rx_adapter_vhost_queue {
+	int vid;
+	/**< vhost device identifier */
+	uint16_t queue_id;
+	/**< Index of the virtqueue the guest transmits on */
+	struct rte_mempool *mbuf_pool;
+	/**< Mempool of the mbufs the packets are copied to */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Receive function of a vhost virtqueue source.
+ * @see rte_event_eth_rx_adapter_src_rx_t
+ */
+uint16_t __rte_experimental
+rte_event_eth_rx_adapter_vhost_rx(void *rx_arg, struct rte_mbuf **mbufs,
+				uint16_t nb_mbufs);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Notification control function of a vhost virtqueue source.
+ * @see rte_event_eth_rx_adapter_src_intr_ctl_t
+ */
+int __rte_experimental
+rte_event_eth_rx_adapter_vhost_intr_ctl(void *rx_arg, int enable);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add a virtqueue of a vhost device to an Rx adapter.
+ *
+ * @param id
+ *  Adapter identifier.
+ * @param vq
+ *  Virtqueue to add, must remain valid until it is deleted.
+ * @param queue_conf
+ *  Event configuration of the packets of the virtqueue. A servicing weight
+ *  of zero makes the virtqueue interrupt driven.
+ * @param[out] src_id
+ *  Source identifier of the virtqueue in the adapter.
+ * @return
+ *  - 0: Success
+ *  - -EINVAL: Invalid parameters or virtqueue.
+ *  - <0: Error code of rte_event_eth_rx_adapter_src_add().
+ */
+int __rte_experimental
+rte_event_eth_rx_adapter_vhost_queue_add(uint8_t id,
+		struct rte_event_eth_rx_adapter_vhost_queue *vq,
+		const struct rte_event_eth_rx_adapter_queue_conf *queue_conf,
+		uint16_t *src_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete a virtqueue of a vhost device from an Rx adapter.
+ *
+ * @param id
+ *  Adapter identifier.
+ * @param src_id
+ *  Source identifier of the virtqueue in the adapter.
+ * @return
+ *  - 0: Success
+ *  - -EINVAL: Invalid adapter or source identifier.
+ */
+int __rte_experimental
+rte_event_eth_rx_adapter_vhost_queue_del(uint8_t id, uint16_t src_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* _RTE_EVENT_ETH_RX_ADAPTER_VHOST_ */
@@ -19,6 +19,7 @@
 #include <rte_timer.h>
 #include <rte_service_component.h>
 #include <rte_cycles.h>
+#include <rte_pause.h>
 
 #include "rte_eventdev.h"
 #include "rte_eventdev_pmd.h"
@@ -512,6 +513,10 @@ struct rte_event_timer_adapter_sw_data {
 	rte_spinlock_t msgs_tailq_sl;
 	/* Identifier of service executing timer management logic. */
 	uint32_t service_id;
+	/* Identifier of the timer data instance holding the adapter timers,
+	 * so that they are not delayed by the other users of rte_timer.
+	 */
+	uint32_t timer_data_id;
 	/* The cycle count at which the adapter should next tick */
 	uint64_t next_tick_cycles;
 	/* Incremented as the service moves through phases of an iteration */
@@ -565,8 +570,10 @@ sw_event_timer_cb(struct rte_timer *tim, void *arg)
 		 * immediate expiry value, so that we process it again on the
 		 * next iteration.
 		 */
-		rte_timer_reset_sync(tim, 0, SINGLE, rte_lcore_id(),
-				     sw_event_timer_cb, evtim);
+		while (rte_timer_alt_reset(sw_data->timer_data_id, tim, 0,
+					   SINGLE, rte_lcore_id(),
+					   sw_event_timer_cb, evtim) != 0)
+			rte_pause();
 
 		sw_data->stats.evtim_retry_count++;
 		EVTIM_LOG_DBG("event buffer full, resetting rte_timer with "
@@ -733,10 +740,11 @@ sw_event_timer_adapter_service_func(void *arg)
 				rte_timer_init(tim);
 				cycles = get_timeout_cycles(evtim,
 							    adapter);
-				ret = rte_timer_reset(tim, cycles, SINGLE,
-						      rte_lcore_id(),
-						      sw_event_timer_cb,
-						      evtim);
+				ret = rte_timer_alt_reset(
+						sw_data->timer_data_id,
+						tim, cycles, SINGLE,
+						rte_lcore_id(),
+						sw_event_timer_cb, evtim);
 				RTE_ASSERT(ret == 0);
 
 				evtim->impl_opaque[0] = (uintptr_t)tim;
@@ -753,7 +761,8 @@ sw_event_timer_adapter_service_func(void *arg)
 				tim = (struct rte_timer *)(uintptr_t)opaque;
 				RTE_ASSERT(tim != NULL);
 
-				ret = rte_timer_stop(tim);
+				ret = rte_timer_alt_stop(
+						sw_data->timer_data_id, tim);
 				RTE_ASSERT(ret == 0);
 
 				/* Free the msg object for the original arm
@@ -780,7 +789,7 @@ sw_event_timer_adapter_service_func(void *arg)
 	rte_smp_wmb();
 
 	if (adapter_did_tick(adapter)) {
-		rte_timer_manage();
+		rte_timer_alt_manage(sw_data->timer_data_id);
 
 		event_buffer_flush(&sw_data->buffer,
 				   adapter->data->event_dev_id,
@@ -838,7 +847,6 @@ sw_event_timer_adapter_init(struct rte_event_timer_adapter *adapter)
 	uint64_t nb_timers;
 	unsigned int flags;
 	struct rte_service_spec service;
-	static bool timer_subsystem_inited; // static initialized to false
 
 	/* Allocate storage for SW implementation data */
 	char priv_data_name[RTE_RING_NAMESIZE];
@@ -917,6 +925,13 @@ sw_event_timer_adapter_init(struct rte_event_timer_adapter *adapter)
 
 	event_buffer_init(&sw_data->buffer);
 
+	ret = rte_timer_data_alloc(&sw_data->timer_data_id);
+	if (ret < 0) {
+		EVTIM_LOG_ERR("failed to allocate timer data instance");
+		rte_errno = -ret;
+		goto free_msg_pool;
+	}
+
 	/* Register a service component to run adapter logic */
 	memset(&service, 0, sizeof(service));
 	snprintf(service.name, RTE_SERVICE_NAME_MAX,
@@ -932,7 +947,7 @@ sw_event_timer_adapter_init(struct rte_event_timer_adapter *adapter)
 			      ret);
 
 		rte_errno = ENOSPC;
-		goto free_msg_pool;
+		goto free_timer_data;
 	}
 
 	EVTIM_LOG_DBG("registered service %s with id %"PRIu32, service.name,
@@ -941,13 +956,10 @@ sw_event_timer_adapter_init(struct rte_event_timer_adapter *adapter)
 	adapter->data->service_id = sw_data->service_id;
 	adapter->data->service_inited = 1;
 
-	if (!timer_subsystem_inited) {
-		rte_timer_subsystem_init();
-		timer_subsystem_inited = true;
-	}
-
 	return 0;
 
+free_timer_data:
+	rte_timer_data_dealloc(sw_data->timer_data_id);
 free_msg_pool:
 	rte_mempool_free(sw_data->msg_pool);
 free_msg_ring:
@@ -973,7 +985,9 @@ sw_event_timer_adapter_uninit(struct rte_event_timer_adapter *adapter)
 		EVTIM_LOG_DBG("freeing outstanding timer");
 		m2 = TAILQ_NEXT(m1, msgs);
 
-		rte_timer_stop_sync(&m1->tim);
+		while (rte_timer_alt_stop(sw_data->timer_data_id,
+					  &m1->tim) != 0)
+			rte_pause();
 		rte_mempool_put(sw_data->msg_pool, m1);
 
 		m1 = m2;
@@ -987,6 +1001,7 @@ sw_event_timer_adapter_uninit(struct rte_event_timer_adapter *adapter)
 		return ret;
 	}
 
+	rte_timer_data_dealloc(sw_data->timer_data_id);
 	rte_ring_free(sw_data->msg_ring);
 	rte_mempool_free(sw_data->msg_pool);
 	rte_free(adapter->data->adapter_priv);
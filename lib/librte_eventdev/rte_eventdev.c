@@ -28,6 +28,7 @@
 #include <rte_common.h>
 #include <rte_malloc.h>
 #include <rte_errno.h>
+#include <rte_mempool.h>
 #include <rte_ethdev.h>
 #include <rte_cryptodev.h>
 #include <rte_cryptodev_pmd.h>
@@ -1277,6 +1278,21 @@ rte_event_dev_close(uint8_t dev_id)
 	return (*dev->dev_ops->dev_close)(dev);
 }
 
+struct rte_mempool * __rte_experimental
+rte_event_vector_pool_create(const char *name, unsigned int n,
+			     unsigned int cache_size, uint16_t nb_elem,
+			     int socket_id)
+{
+	if (name == NULL || n == 0 || nb_elem == 0) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return rte_mempool_create(name, n, sizeof(struct rte_event_vector) +
+			nb_elem * sizeof(uintptr_t), cache_size, 0, NULL, NULL,
+			NULL, NULL, socket_id, 0);
+}
+
 static inline int
 rte_eventdev_data_alloc(uint8_t dev_id, struct rte_eventdev_data **data,
 		int socket_id)
@@ -217,6 +217,7 @@ extern "C" {
 #include <rte_errno.h>
 
 struct rte_mbuf; /* we just use mbuf pointers; no need to include rte_mbuf.h */
+struct rte_mempool;
 struct rte_event;
 
 /* Event device capability bitmap flags */
@@ -877,6 +878,35 @@ rte_event_dev_stop_flush_callback_register(uint8_t dev_id,
 int
 rte_event_dev_close(uint8_t dev_id);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a mempool of event vectors, i.e. of struct rte_event_vector
+ * holding up to *nb_elem* elements.
+ *
+ * @param name
+ *   The name of the mempool.
+ * @param n
+ *   The number of vectors in the mempool.
+ * @param cache_size
+ *   Size of the per-core object cache, see rte_mempool_create().
+ * @param nb_elem
+ *   The maximum number of elements of each vector.
+ * @param socket_id
+ *   The socket identifier where the memory should be allocated, or
+ *   SOCKET_ID_ANY.
+ * @return
+ *   The pointer to the new mempool on success, NULL on error with rte_errno
+ *   set appropriately:
+ *   - EINVAL - invalid parameter passed to function
+ *   - the errors of rte_mempool_create()
+ */
+struct rte_mempool * __rte_experimental
+rte_event_vector_pool_create(const char *name, unsigned int n,
+			     unsigned int cache_size, uint16_t nb_elem,
+			     int socket_id);
+
 /* Scheduler type definitions */
 #define RTE_SCHED_TYPE_ORDERED          0
 /**< Ordered scheduling
@@ -950,6 +980,16 @@ rte_event_dev_close(uint8_t dev_id);
  */
 #define RTE_EVENT_TYPE_ETH_RX_ADAPTER   0x4
 /**< The event generated from event eth Rx adapter */
+#define RTE_EVENT_TYPE_VECTOR           0x8
+/**< Indicates that the event is a vector.
+ * All vector event types should be a logical OR of RTE_EVENT_TYPE_VECTOR
+ * with the event type of its elements, the *vec* member of the event then
+ * points to a struct rte_event_vector.
+ * @see struct rte_event_vector
+ */
+#define RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR                                   \
+	(RTE_EVENT_TYPE_VECTOR | RTE_EVENT_TYPE_ETH_RX_ADAPTER)
+/**< The event vector generated from event eth Rx adapter. */
 #define RTE_EVENT_TYPE_MAX              0x10
 /**< Maximum number of event types */
 
@@ -999,6 +1039,42 @@ rte_event_dev_close(uint8_t dev_id);
  *
  */
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this structure may change without prior notice
+ *
+ * Event vector structure, aggregating several objects into one event.
+ * The vectors are allocated from a mempool created by
+ * rte_event_vector_pool_create(). The consumer of the event frees the
+ * vector back to its mempool, e.g. with rte_mempool_put(), after processing
+ * its elements.
+ */
+struct rte_event_vector {
+	uint16_t nb_elem;
+	/**< Number of elements in this event vector. */
+	uint16_t port;
+	/**< Ethernet device port of the mbufs, for
+	 * RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR events.
+	 */
+	uint16_t queue;
+	/**< Ethernet device Rx queue of the mbufs, for
+	 * RTE_EVENT_TYPE_ETH_RX_ADAPTER_VECTOR events.
+	 */
+	uint16_t rsvd;
+	/**< Reserved for future use */
+	uint64_t impl_opaque;
+	/**< Implementation specific opaque value. */
+	union {
+		struct rte_mbuf *mbufs[0];
+		void *ptrs[0];
+		uint64_t u64s[0];
+	} __rte_aligned(16);
+	/**< Start of the vector array union. Depending upon the event type the
+	 * vector array can be an array of mbufs or pointers or opaque u64
+	 * values.
+	 */
+};
+
 /**
  * The generic *rte_event* structure to hold the event attributes
  * for dequeue and enqueue operation
@@ -1072,6 +1148,10 @@ struct rte_event {
 		/**< Opaque event pointer */
 		struct rte_mbuf *mbuf;
 		/**< mbuf pointer if dequeued event is associated with mbuf */
+		struct rte_event_vector *vec;
+		/**< Event vector pointer, if the event type is a logical OR
+		 * of RTE_EVENT_TYPE_VECTOR and the type of the vector elements
+		 */
 	};
 };
 
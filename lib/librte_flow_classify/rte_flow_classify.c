@@ -7,6 +7,8 @@
 #include "rte_flow_classify_parse.h"
 #include <rte_flow_driver.h>
 #include <rte_table_acl.h>
+#include <rte_hash.h>
+#include <rte_jhash.h>
 #include <stdbool.h>
 
 int librte_flow_classify_logtype;
@@ -24,6 +26,12 @@ struct rte_flow_classify_table_entry {
 	struct classify_action action;
 };
 
+/* Packet field of the flow cache key */
+struct rte_cls_cache_field {
+	uint32_t offset;
+	uint32_t size;
+};
+
 struct rte_cls_table {
 	/* Input parameters */
 	struct rte_table_ops ops;
@@ -32,6 +40,12 @@ struct rte_cls_table {
 
 	/* Handle to the low-level table object */
 	void *h_table;
+
+	/* Flow cache, NULL if none: key to table entry, NULL on miss */
+	struct rte_hash *cache;
+	struct rte_cls_cache_field cache_fields[RTE_ACL_MAX_FIELDS];
+	uint32_t cache_n_fields;
+	struct rte_flow_classify_cache_stats cache_stats;
 };
 
 #define RTE_FLOW_CLASSIFIER_MAX_NAME_SZ 256
@@ -51,6 +65,7 @@ struct rte_flow_classifier {
 	uint32_t num_tables;
 
 	uint16_t nb_pkts;
+	uint64_t hit_mask;
 	struct rte_flow_classify_table_entry
 		*entries[RTE_PORT_IN_BURST_SIZE_MAX];
 } __rte_cache_aligned;
@@ -296,6 +311,7 @@ rte_flow_classifier_create(struct rte_flow_classifier_params *params)
 static void
 rte_flow_classify_table_free(struct rte_cls_table *table)
 {
+	rte_hash_free(table->cache);
 	if (table->ops.f_free != NULL)
 		table->ops.f_free(table->h_table);
 }
@@ -372,11 +388,73 @@ rte_table_check_params(struct rte_flow_classifier *cls,
 	return 0;
 }
 
+/*
+ * The flow cache key is made of the packet fields looked up by the ACL
+ * table, so that the packets of a flow always get the same result.
+ */
+static struct rte_hash *
+rte_flow_classify_cache_create(struct rte_flow_classifier *cls,
+		struct rte_cls_table *table,
+		struct rte_flow_classify_table_params *params)
+{
+	struct rte_table_acl_params *acl_params = params->arg_create;
+	struct rte_hash_parameters hash_params;
+	char name[RTE_HASH_NAMESIZE];
+	uint32_t i, key_len = 0;
+
+	if (!(params->type & (RTE_FLOW_CLASSIFY_TABLE_ACL_IP4_5TUPLE |
+			RTE_FLOW_CLASSIFY_TABLE_ACL_VLAN_IP4_5TUPLE |
+			RTE_FLOW_CLASSIFY_TABLE_ACL_QINQ_IP4_5TUPLE)) ||
+			acl_params == NULL ||
+			acl_params->n_rule_fields > RTE_ACL_MAX_FIELDS) {
+		RTE_FLOW_CLASSIFY_LOG(ERR,
+			"%s: flow cache needs an ACL table\n", __func__);
+		return NULL;
+	}
+
+	for (i = 0; i < acl_params->n_rule_fields; i++) {
+		table->cache_fields[i].offset =
+			acl_params->field_format[i].offset;
+		table->cache_fields[i].size =
+			acl_params->field_format[i].size;
+		key_len += acl_params->field_format[i].size;
+	}
+	table->cache_n_fields = acl_params->n_rule_fields;
+	if (key_len == 0 || key_len > RTE_FLOW_CLASSIFY_CACHE_KEY_MAX) {
+		RTE_FLOW_CLASSIFY_LOG(ERR,
+			"%s: flow cache key of %u bytes not supported\n",
+			__func__, key_len);
+		return NULL;
+	}
+
+	snprintf(name, sizeof(name), "fcls_cache_%p", table);
+	memset(&hash_params, 0, sizeof(hash_params));
+	hash_params.name = name;
+	hash_params.entries = params->cache_size;
+	hash_params.key_len = key_len;
+	hash_params.hash_func = rte_jhash;
+	hash_params.socket_id = cls->socket_id;
+
+	return rte_hash_create(&hash_params);
+}
+
+/* Rules changed, the flows may now match another one */
+static void
+rte_flow_classify_cache_invalidate(struct rte_cls_table *table)
+{
+	if (table->cache == NULL)
+		return;
+
+	rte_hash_reset(table->cache);
+	table->cache_stats.invalidations++;
+}
+
 int __rte_experimental
 rte_flow_classify_table_create(struct rte_flow_classifier *cls,
 	struct rte_flow_classify_table_params *params)
 {
 	struct rte_cls_table *table;
+	struct rte_hash *cache = NULL;
 	void *h_table;
 	uint32_t entry_size;
 	int ret;
@@ -386,6 +464,16 @@ rte_flow_classify_table_create(struct rte_flow_classifier *cls,
 	if (ret != 0)
 		return ret;
 
+	table = &cls->tables[cls->num_tables];
+	if (params->cache_size) {
+		cache = rte_flow_classify_cache_create(cls, table, params);
+		if (cache == NULL) {
+			RTE_FLOW_CLASSIFY_LOG(ERR,
+				"%s: Flow cache creation failed\n", __func__);
+			return -EINVAL;
+		}
+	}
+
 	/* calculate table entry size */
 	entry_size = sizeof(struct rte_flow_classify_table_entry);
 
@@ -395,12 +483,14 @@ rte_flow_classify_table_create(struct rte_flow_classifier *cls,
 	if (h_table == NULL) {
 		RTE_FLOW_CLASSIFY_LOG(ERR, "%s: Table creation failed\n",
 			__func__);
+		rte_hash_free(cache);
 		return -EINVAL;
 	}
 
 	/* Commit current table to the classifier */
-	table = &cls->tables[cls->num_tables];
 	table->type = params->type;
+	table->cache = cache;
+	memset(&table->cache_stats, 0, sizeof(table->cache_stats));
 	cls->num_tables++;
 
 	/* Save input parameters */
@@ -556,6 +646,7 @@ rte_flow_classify_table_entry_add(struct rte_flow_classifier *cls,
 
 			*key_found = rule->key_found;
 			}
+			rte_flow_classify_cache_invalidate(table);
 
 			return rule;
 		}
@@ -584,6 +675,7 @@ rte_flow_classify_table_entry_delete(struct rte_flow_classifier *cls,
 						&rule->u.key.key_del,
 						&rule->key_found,
 						&rule->entry);
+				rte_flow_classify_cache_invalidate(table);
 
 				return ret;
 			}
@@ -593,25 +685,125 @@ rte_flow_classify_table_entry_delete(struct rte_flow_classifier *cls,
 	return ret;
 }
 
+static inline void
+flow_cache_key(struct rte_cls_table *table, struct rte_mbuf *pkt,
+		uint8_t *key)
+{
+	const uint8_t *data = rte_pktmbuf_mtod(pkt, const uint8_t *);
+	uint32_t i;
+
+	for (i = 0; i < table->cache_n_fields; i++) {
+		memcpy(key, data + table->cache_fields[i].offset,
+			table->cache_fields[i].size);
+		key += table->cache_fields[i].size;
+	}
+}
+
+/*
+ * Look up the packets in the flow cache, then the missed ones in the
+ * table, and remember the result of the table for their flows.
+ */
+static int
+flow_cache_lookup(struct rte_flow_classifier *cls,
+		struct rte_cls_table *table,
+		struct rte_mbuf **pkts,
+		const uint16_t nb_pkts,
+		uint64_t *lookup_hit_mask)
+{
+	uint8_t keys[RTE_PORT_IN_BURST_SIZE_MAX]
+		[RTE_FLOW_CLASSIFY_CACHE_KEY_MAX];
+	const void *key_ptrs[RTE_PORT_IN_BURST_SIZE_MAX];
+	void *data[RTE_PORT_IN_BURST_SIZE_MAX];
+	struct rte_mbuf *miss_pkts[RTE_PORT_IN_BURST_SIZE_MAX];
+	struct rte_flow_classify_table_entry
+		*miss_entries[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint16_t miss_pos[RTE_PORT_IN_BURST_SIZE_MAX];
+	struct rte_flow_classify_table_entry *entry;
+	uint64_t cache_hit_mask = 0, miss_hit_mask = 0;
+	uint16_t i, nb_miss = 0;
+	int ret;
+
+	for (i = 0; i < nb_pkts; i++) {
+		flow_cache_key(table, pkts[i], keys[i]);
+		key_ptrs[i] = keys[i];
+	}
+
+	rte_hash_lookup_bulk_data(table->cache, key_ptrs, nb_pkts,
+		&cache_hit_mask, data);
+	table->cache_stats.lookups += nb_pkts;
+	table->cache_stats.hits += __builtin_popcountll(cache_hit_mask);
+
+	*lookup_hit_mask = 0;
+	for (i = 0; i < nb_pkts; i++) {
+		if (!(cache_hit_mask & (1LLU << i))) {
+			miss_pos[nb_miss] = i;
+			miss_pkts[nb_miss++] = pkts[i];
+			continue;
+		}
+		cls->entries[i] = data[i];
+		if (data[i] != NULL)
+			*lookup_hit_mask |= 1LLU << i;
+	}
+	if (nb_miss == 0)
+		return 0;
+
+	ret = table->ops.f_lookup(table->h_table, miss_pkts,
+		RTE_LEN2MASK(nb_miss, uint64_t), &miss_hit_mask,
+		(void **)miss_entries);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < nb_miss; i++) {
+		entry = (miss_hit_mask & (1LLU << i)) ? miss_entries[i] : NULL;
+		cls->entries[miss_pos[i]] = entry;
+		if (entry != NULL)
+			*lookup_hit_mask |= 1LLU << miss_pos[i];
+
+		/* Full: start over, the live flows come back first */
+		ret = rte_hash_add_key_data(table->cache, keys[miss_pos[i]],
+			entry);
+		if (ret == -ENOSPC) {
+			rte_hash_reset(table->cache);
+			table->cache_stats.flushes++;
+			ret = rte_hash_add_key_data(table->cache,
+				keys[miss_pos[i]], entry);
+		}
+		if (ret == 0)
+			table->cache_stats.inserts++;
+	}
+
+	return 0;
+}
+
 static int
 flow_classifier_lookup(struct rte_flow_classifier *cls,
 		struct rte_cls_table *table,
 		struct rte_mbuf **pkts,
-		const uint16_t nb_pkts)
+		uint16_t nb_pkts)
 {
 	int ret = -EINVAL;
 	uint64_t pkts_mask;
 	uint64_t lookup_hit_mask;
 
-	pkts_mask = RTE_LEN2MASK(nb_pkts, uint64_t);
-	ret = table->ops.f_lookup(table->h_table,
-		pkts, pkts_mask, &lookup_hit_mask,
-		(void **)cls->entries);
+	nb_pkts = RTE_MIN(nb_pkts, (uint16_t)RTE_PORT_IN_BURST_SIZE_MAX);
+	if (table->cache != NULL) {
+		ret = flow_cache_lookup(cls, table, pkts, nb_pkts,
+			&lookup_hit_mask);
+	} else {
+		pkts_mask = RTE_LEN2MASK(nb_pkts, uint64_t);
+		ret = table->ops.f_lookup(table->h_table,
+			pkts, pkts_mask, &lookup_hit_mask,
+			(void **)cls->entries);
+	}
 
-	if (!ret && lookup_hit_mask)
+	/* The entries of the missed packets are left as they were */
+	if (!ret && lookup_hit_mask) {
 		cls->nb_pkts = nb_pkts;
-	else
+		cls->hit_mask = lookup_hit_mask;
+	} else {
 		cls->nb_pkts = 0;
+		cls->hit_mask = 0;
+	}
 
 	return ret;
 }
@@ -629,7 +821,8 @@ action_apply(struct rte_flow_classifier *cls,
 
 	if (action_mask & (1LLU << RTE_FLOW_ACTION_TYPE_COUNT)) {
 		for (i = 0; i < cls->nb_pkts; i++) {
-			if (rule->id == cls->entries[i]->rule_id)
+			if ((cls->hit_mask & (1LLU << i)) &&
+					rule->id == cls->entries[i]->rule_id)
 				count++;
 		}
 		if (count) {
@@ -672,6 +865,33 @@ rte_flow_classifier_query(struct rte_flow_classifier *cls,
 	return ret;
 }
 
+int __rte_experimental
+rte_flow_classifier_cache_stats_read(struct rte_flow_classifier *cls,
+		struct rte_flow_classify_cache_stats *stats,
+		int clear)
+{
+	uint32_t i;
+
+	if (!cls || !stats)
+		return -EINVAL;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < cls->num_tables; i++) {
+		struct rte_flow_classify_cache_stats *s =
+			&cls->tables[i].cache_stats;
+
+		stats->lookups += s->lookups;
+		stats->hits += s->hits;
+		stats->inserts += s->inserts;
+		stats->flushes += s->flushes;
+		stats->invalidations += s->invalidations;
+		if (clear)
+			memset(s, 0, sizeof(*s));
+	}
+
+	return 0;
+}
+
 RTE_INIT(librte_flow_classify_init_log)
 {
 	librte_flow_classify_logtype =
@@ -37,6 +37,8 @@
  *  - application calls rte_flow_classifier_query() in a polling manner,
  *    preferably after rte_eth_rx_burst(). This will cause the library to
  *    match packet information to flow information with some measurements.
+ *  - application calls rte_flow_classifier_cache_stats_read() to get the
+ *    hit rate of the flow caches, when the tables have one.
  *  - rte_flow_classifier object can be destroyed when it is no longer needed
  *    with rte_flow_classifier_free()
  */
@@ -66,6 +68,9 @@ extern int librte_flow_classify_logtype;
 #define RTE_FLOW_CLASSIFY_TABLE_MAX		32
 #endif
 
+/** Maximum size of the flow cache key, the packet fields of the table. */
+#define RTE_FLOW_CLASSIFY_CACHE_KEY_MAX		32
+
 /** Opaque data type for flow classifier */
 struct rte_flow_classifier;
 
@@ -113,6 +118,29 @@ struct rte_flow_classify_table_params {
 
 	/** Classifier table type */
 	enum rte_flow_classify_table_type type;
+
+	/**
+	 * Number of flows of the exact match cache in front of the table,
+	 * 0 for no cache. The flows are keyed by the packet fields of the
+	 * ACL table, the cache remembers the rule matched by each flow, or
+	 * that it matched none, and is flushed when a rule is added or
+	 * deleted, or when it is full.
+	 */
+	uint32_t cache_size;
+};
+
+/** Flow cache statistics, for all the tables of a classifier */
+struct rte_flow_classify_cache_stats {
+	/** Packets looked up in the flow caches */
+	uint64_t lookups;
+	/** Packets classified by the flow caches, without table lookup */
+	uint64_t hits;
+	/** Table results stored in the flow caches */
+	uint64_t inserts;
+	/** Flushes of full flow caches */
+	uint64_t flushes;
+	/** Flushes of the flow caches on rule addition or deletion */
+	uint64_t invalidations;
 };
 
 /** IPv4 5-tuple data */
@@ -272,6 +300,24 @@ rte_flow_classifier_query(struct rte_flow_classifier *cls,
 		struct rte_flow_classify_rule *rule,
 		struct rte_flow_classify_stats *stats);
 
+/**
+ * Read the flow cache statistics of the classifier tables.
+ *
+ * @param[in] cls
+ *   Flow classifier handle
+ * @param[out] stats
+ *   Flow cache statistics, summed over the tables
+ * @param[in] clear
+ *   Reset the statistics once read if not 0
+ *
+ * @return
+ *   0 on success, error code otherwise.
+ */
+int __rte_experimental
+rte_flow_classifier_cache_stats_read(struct rte_flow_classifier *cls,
+		struct rte_flow_classify_cache_stats *stats,
+		int clear);
+
 #ifdef __cplusplus
 }
 #endif
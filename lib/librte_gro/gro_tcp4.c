@@ -6,17 +6,61 @@
 #include <rte_mbuf.h>
 #include <rte_cycles.h>
 #include <rte_ethdev.h>
+#include <rte_hash_crc.h>
 
 #include "gro_tcp4.h"
 
+#define GRO_TCP4_HASH_INIT 0xeaad8e31
+
+void
+gro_tcp4_tbl_init(struct gro_tcp4_tbl *tbl,
+		struct gro_tcp4_flow *flows,
+		uint32_t max_flow_num,
+		struct gro_tcp4_item *items,
+		uint32_t max_item_num,
+		uint32_t *buckets,
+		uint32_t nb_buckets)
+{
+	uint32_t i;
+
+	/* Chain all the flows and items into the empty lists */
+	for (i = 0; i < max_flow_num; i++) {
+		/* INVALID_ARRAY_INDEX indicates an empty flow */
+		flows[i].start_index = INVALID_ARRAY_INDEX;
+		flows[i].next_flow_idx = i + 1 < max_flow_num ? i + 1 :
+			INVALID_ARRAY_INDEX;
+	}
+
+	for (i = 0; i < max_item_num; i++)
+		items[i].next_pkt_idx = i + 1 < max_item_num ? i + 1 :
+			INVALID_ARRAY_INDEX;
+
+	for (i = 0; i < nb_buckets; i++)
+		buckets[i] = INVALID_ARRAY_INDEX;
+
+	tbl->flows = flows;
+	tbl->items = items;
+	tbl->buckets = buckets;
+	tbl->flow_num = 0;
+	tbl->item_num = 0;
+	tbl->max_flow_num = max_flow_num;
+	tbl->max_item_num = max_item_num;
+	tbl->bucket_mask = nb_buckets - 1;
+	tbl->free_flow_idx = max_flow_num > 0 ? 0 : INVALID_ARRAY_INDEX;
+	tbl->free_item_idx = max_item_num > 0 ? 0 : INVALID_ARRAY_INDEX;
+}
+
 void *
 gro_tcp4_tbl_create(uint16_t socket_id,
 		uint16_t max_flow_num,
 		uint16_t max_item_per_flow)
 {
 	struct gro_tcp4_tbl *tbl;
+	struct gro_tcp4_item *items;
+	struct gro_tcp4_flow *flows;
+	uint32_t *buckets;
 	size_t size;
-	uint32_t entries_num, i;
+	uint32_t entries_num, nb_buckets;
 
 	entries_num = max_flow_num * max_item_per_flow;
 	entries_num = RTE_MIN(entries_num, GRO_TCP4_TBL_MAX_ITEM_NUM);
@@ -32,30 +76,41 @@ gro_tcp4_tbl_create(uint16_t socket_id,
 		return NULL;
 
 	size = sizeof(struct gro_tcp4_item) * entries_num;
-	tbl->items = rte_zmalloc_socket(__func__,
+	items = rte_zmalloc_socket(__func__,
 			size,
 			RTE_CACHE_LINE_SIZE,
 			socket_id);
-	if (tbl->items == NULL) {
+	if (items == NULL) {
 		rte_free(tbl);
 		return NULL;
 	}
-	tbl->max_item_num = entries_num;
 
 	size = sizeof(struct gro_tcp4_flow) * entries_num;
-	tbl->flows = rte_zmalloc_socket(__func__,
+	flows = rte_zmalloc_socket(__func__,
 			size,
 			RTE_CACHE_LINE_SIZE,
 			socket_id);
-	if (tbl->flows == NULL) {
-		rte_free(tbl->items);
+	if (flows == NULL) {
+		rte_free(items);
 		rte_free(tbl);
 		return NULL;
 	}
-	/* INVALID_ARRAY_INDEX indicates an empty flow */
-	for (i = 0; i < entries_num; i++)
-		tbl->flows[i].start_index = INVALID_ARRAY_INDEX;
-	tbl->max_flow_num = entries_num;
+
+	nb_buckets = rte_align32pow2(entries_num);
+	size = sizeof(uint32_t) * nb_buckets;
+	buckets = rte_malloc_socket(__func__,
+			size,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (buckets == NULL) {
+		rte_free(flows);
+		rte_free(items);
+		rte_free(tbl);
+		return NULL;
+	}
+
+	gro_tcp4_tbl_init(tbl, flows, entries_num, items, entries_num,
+			buckets, nb_buckets);
 
 	return tbl;
 }
@@ -68,32 +123,41 @@ gro_tcp4_tbl_destroy(void *tbl)
 	if (tcp_tbl) {
 		rte_free(tcp_tbl->items);
 		rte_free(tcp_tbl->flows);
+		rte_free(tcp_tbl->buckets);
 	}
 	rte_free(tcp_tbl);
 }
 
+static inline uint32_t
+tcp4_flow_hash(const struct tcp4_flow_key *key)
+{
+	uint32_t v;
+
+	v = rte_hash_crc_4byte(key->ip_src_addr, GRO_TCP4_HASH_INIT);
+	v = rte_hash_crc_4byte(key->ip_dst_addr, v);
+	v = rte_hash_crc_4byte(((uint32_t)key->src_port << 16) |
+			key->dst_port, v);
+	return v;
+}
+
 static inline uint32_t
 find_an_empty_item(struct gro_tcp4_tbl *tbl)
 {
-	uint32_t i;
-	uint32_t max_item_num = tbl->max_item_num;
+	uint32_t item_idx = tbl->free_item_idx;
 
-	for (i = 0; i < max_item_num; i++)
-		if (tbl->items[i].firstseg == NULL)
-			return i;
-	return INVALID_ARRAY_INDEX;
+	if (item_idx != INVALID_ARRAY_INDEX)
+		tbl->free_item_idx = tbl->items[item_idx].next_pkt_idx;
+	return item_idx;
 }
 
 static inline uint32_t
 find_an_empty_flow(struct gro_tcp4_tbl *tbl)
 {
-	uint32_t i;
-	uint32_t max_flow_num = tbl->max_flow_num;
+	uint32_t flow_idx = tbl->free_flow_idx;
 
-	for (i = 0; i < max_flow_num; i++)
-		if (tbl->flows[i].start_index == INVALID_ARRAY_INDEX)
-			return i;
-	return INVALID_ARRAY_INDEX;
+	if (flow_idx != INVALID_ARRAY_INDEX)
+		tbl->free_flow_idx = tbl->flows[flow_idx].next_flow_idx;
+	return flow_idx;
 }
 
 static inline uint32_t
@@ -139,6 +203,8 @@ delete_item(struct gro_tcp4_tbl *tbl, uint32_t item_idx,
 
 	/* NULL indicates an empty item */
 	tbl->items[item_idx].firstseg = NULL;
+	tbl->items[item_idx].next_pkt_idx = tbl->free_item_idx;
+	tbl->free_item_idx = item_idx;
 	tbl->item_num--;
 	if (prev_item_idx != INVALID_ARRAY_INDEX)
 		tbl->items[prev_item_idx].next_pkt_idx = next_idx;
@@ -149,10 +215,11 @@ delete_item(struct gro_tcp4_tbl *tbl, uint32_t item_idx,
 static inline uint32_t
 insert_new_flow(struct gro_tcp4_tbl *tbl,
 		struct tcp4_flow_key *src,
+		uint32_t hash,
 		uint32_t item_idx)
 {
 	struct tcp4_flow_key *dst;
-	uint32_t flow_idx;
+	uint32_t flow_idx, bucket;
 
 	flow_idx = find_an_empty_flow(tbl);
 	if (unlikely(flow_idx == INVALID_ARRAY_INDEX))
@@ -169,11 +236,35 @@ insert_new_flow(struct gro_tcp4_tbl *tbl,
 	dst->dst_port = src->dst_port;
 
 	tbl->flows[flow_idx].start_index = item_idx;
+	tbl->flows[flow_idx].hash = hash;
+
+	/* Chain the flow at the head of its hash bucket */
+	bucket = hash & tbl->bucket_mask;
+	tbl->flows[flow_idx].next_flow_idx = tbl->buckets[bucket];
+	tbl->buckets[bucket] = flow_idx;
 	tbl->flow_num++;
 
 	return flow_idx;
 }
 
+static inline void
+delete_flow(struct gro_tcp4_tbl *tbl, uint32_t flow_idx)
+{
+	struct gro_tcp4_flow *flow = &tbl->flows[flow_idx];
+	uint32_t *prev_idx;
+
+	/* Unchain the flow from its hash bucket */
+	prev_idx = &tbl->buckets[flow->hash & tbl->bucket_mask];
+	while (*prev_idx != flow_idx)
+		prev_idx = &tbl->flows[*prev_idx].next_flow_idx;
+	*prev_idx = flow->next_flow_idx;
+
+	flow->start_index = INVALID_ARRAY_INDEX;
+	flow->next_flow_idx = tbl->free_flow_idx;
+	tbl->free_flow_idx = flow_idx;
+	tbl->flow_num--;
+}
+
 /*
  * update the packet length for the flushed packet.
  */
@@ -203,9 +294,8 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 
 	struct tcp4_flow_key key;
 	uint32_t cur_idx, prev_idx, item_idx;
-	uint32_t i, max_flow_num, remaining_flow_num;
+	uint32_t i, hash;
 	int cmp;
-	uint8_t find;
 
 	eth_hdr = rte_pktmbuf_mtod(pkt, struct ether_hdr *);
 	ipv4_hdr = (struct ipv4_hdr *)((char *)eth_hdr + pkt->l2_len);
@@ -243,31 +333,27 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 	key.dst_port = tcp_hdr->dst_port;
 	key.recv_ack = tcp_hdr->recv_ack;
 
-	/* Search for a matched flow. */
-	max_flow_num = tbl->max_flow_num;
-	remaining_flow_num = tbl->flow_num;
-	find = 0;
-	for (i = 0; i < max_flow_num && remaining_flow_num; i++) {
-		if (tbl->flows[i].start_index != INVALID_ARRAY_INDEX) {
-			if (is_same_tcp4_flow(tbl->flows[i].key, key)) {
-				find = 1;
-				break;
-			}
-			remaining_flow_num--;
-		}
+	/* Search for a matched flow in its hash bucket. */
+	hash = tcp4_flow_hash(&key);
+	for (i = tbl->buckets[hash & tbl->bucket_mask];
+			i != INVALID_ARRAY_INDEX;
+			i = tbl->flows[i].next_flow_idx) {
+		if (tbl->flows[i].hash == hash &&
+				is_same_tcp4_flow(tbl->flows[i].key, key))
+			break;
 	}
 
 	/*
 	 * Fail to find a matched flow. Insert a new flow and store the
 	 * packet into the flow.
 	 */
-	if (find == 0) {
+	if (i == INVALID_ARRAY_INDEX) {
 		item_idx = insert_new_item(tbl, pkt, start_time,
 				INVALID_ARRAY_INDEX, sent_seq, ip_id,
 				is_atomic);
 		if (item_idx == INVALID_ARRAY_INDEX)
 			return -1;
-		if (insert_new_flow(tbl, &key, item_idx) ==
+		if (insert_new_flow(tbl, &key, hash, item_idx) ==
 				INVALID_ARRAY_INDEX) {
 			/*
 			 * Fail to insert a new flow, so delete the
@@ -343,7 +429,7 @@ gro_tcp4_tbl_timeout_flush(struct gro_tcp4_tbl *tbl,
 				j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
 				tbl->flows[i].start_index = j;
 				if (j == INVALID_ARRAY_INDEX)
-					tbl->flow_num--;
+					delete_flow(tbl, i);
 
 				if (unlikely(k == nb_out))
 					return k;
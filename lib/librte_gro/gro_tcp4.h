@@ -36,6 +36,13 @@ struct gro_tcp4_flow {
 	 * INVALID_ARRAY_INDEX indicates an empty flow.
 	 */
 	uint32_t start_index;
+	/* Hash of the flow key, compared before the key itself */
+	uint32_t hash;
+	/*
+	 * The index of the next flow in the same hash bucket, or of
+	 * the next empty flow if the flow is empty.
+	 */
+	uint32_t next_flow_idx;
 };
 
 struct gro_tcp4_item {
@@ -55,7 +62,8 @@ struct gro_tcp4_item {
 	/*
 	 * next_pkt_idx is used to chain the packets that
 	 * are in the same flow but can't be merged together
-	 * (e.g. caused by packet reordering).
+	 * (e.g. caused by packet reordering). For an empty
+	 * item, it is the index of the next empty item.
 	 */
 	uint32_t next_pkt_idx;
 	/* TCP sequence number of the packet */
@@ -84,8 +92,43 @@ struct gro_tcp4_tbl {
 	uint32_t max_item_num;
 	/* flow array size */
 	uint32_t max_flow_num;
+	/* hash bucket array, indexes of the first flow of each bucket */
+	uint32_t *buckets;
+	/* hash bucket array size minus one, a power of two minus one */
+	uint32_t bucket_mask;
+	/* index of the first empty flow */
+	uint32_t free_flow_idx;
+	/* index of the first empty item */
+	uint32_t free_item_idx;
 };
 
+/**
+ * This function initializes a TCP/IPv4 reassembly table over the given
+ * flow, item and hash bucket arrays.
+ *
+ * @param tbl
+ *  TCP/IPv4 reassembly table to initialize
+ * @param flows
+ *  Flow array of the table
+ * @param max_flow_num
+ *  The number of flows in the flow array
+ * @param items
+ *  Zeroed item array of the table
+ * @param max_item_num
+ *  The number of items in the item array
+ * @param buckets
+ *  Hash bucket array of the table
+ * @param nb_buckets
+ *  The number of hash buckets, a non-zero power of two
+ */
+void gro_tcp4_tbl_init(struct gro_tcp4_tbl *tbl,
+		struct gro_tcp4_flow *flows,
+		uint32_t max_flow_num,
+		struct gro_tcp4_item *items,
+		uint32_t max_item_num,
+		uint32_t *buckets,
+		uint32_t nb_buckets);
+
 /**
  * This function creates a TCP/IPv4 reassembly table.
  *
@@ -31,6 +31,25 @@
 		(PKT_TX_TCP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV4 | \
 		 PKT_TX_TUNNEL_GRE))
 
+#define IS_IPV4_GENEVE_TCP4(flag) (((flag) & (PKT_TX_TCP_SEG | PKT_TX_IPV4 | \
+				PKT_TX_OUTER_IPV4 | PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_TCP_SEG | PKT_TX_IPV4 | PKT_TX_OUTER_IPV4 | \
+		 PKT_TX_TUNNEL_GENEVE))
+
+#define IS_IPV6_TCP(flag) (((flag) & (PKT_TX_TCP_SEG | PKT_TX_IPV6 | \
+				PKT_TX_TUNNEL_MASK)) == \
+		(PKT_TX_TCP_SEG | PKT_TX_IPV6))
+
+/* Tunnel packet whose outer L4 header is UDP. */
+#define IS_UDP_TUNNEL(flag) \
+	(((flag) & PKT_TX_TUNNEL_MASK) == PKT_TX_TUNNEL_VXLAN || \
+	 ((flag) & PKT_TX_TUNNEL_MASK) == PKT_TX_TUNNEL_GENEVE)
+
+/* Tunnel packet with an outer or an inner IPv6 header. */
+#define IS_TUNNEL_TCP_IPV6(flag) (((flag) & PKT_TX_TCP_SEG) && \
+		((flag) & PKT_TX_TUNNEL_MASK) != 0 && \
+		((flag) & (PKT_TX_OUTER_IPV6 | PKT_TX_IPV6)) != 0)
+
 #define IS_IPV4_UDP(flag) (((flag) & (PKT_TX_UDP_SEG | PKT_TX_IPV4)) == \
 		(PKT_TX_UDP_SEG | PKT_TX_IPV4))
 
@@ -53,6 +72,43 @@ update_udp_header(struct rte_mbuf *pkt, uint16_t udp_offset)
 	udp_hdr->dgram_len = rte_cpu_to_be_16(pkt->pkt_len - udp_offset);
 }
 
+/**
+ * Internal function which updates the outer UDP header of a tunnel packet,
+ * following segmentation. Besides the datagram length, when the outer UDP
+ * checksum is offloaded (PKT_TX_OUTER_UDP_CKSUM), the checksum field is
+ * set to the pseudo-header checksum of the segment, as the NIC expects it.
+ * Therefore, the outer IP header must be updated first.
+ *
+ * @param pkt
+ *  The packet containing the UDP header.
+ * @param outer_l3_offset
+ *  The offset of the outer IP header from the start of the packet.
+ * @param udp_offset
+ *  The offset of the UDP header from the start of the packet.
+ */
+static inline void
+update_tunnel_udp_header(struct rte_mbuf *pkt, uint16_t outer_l3_offset,
+		uint16_t udp_offset)
+{
+	struct udp_hdr *udp_hdr;
+	char *outer_l3_hdr;
+
+	update_udp_header(pkt, udp_offset);
+
+	if ((pkt->ol_flags & PKT_TX_OUTER_UDP_CKSUM) == 0)
+		return;
+
+	udp_hdr = (struct udp_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			udp_offset);
+	outer_l3_hdr = rte_pktmbuf_mtod(pkt, char *) + outer_l3_offset;
+	if (pkt->ol_flags & PKT_TX_OUTER_IPV6)
+		udp_hdr->dgram_cksum = rte_ipv6_phdr_cksum(
+				(struct ipv6_hdr *)outer_l3_hdr, 0);
+	else
+		udp_hdr->dgram_cksum = rte_ipv4_phdr_cksum(
+				(struct ipv4_hdr *)outer_l3_hdr, 0);
+}
+
 /**
  * Internal function which updates the TCP header of a packet, following
  * segmentation. This is required to update the header's 'sent' sequence
@@ -106,6 +162,27 @@ update_ipv4_header(struct rte_mbuf *pkt, uint16_t l3_offset, uint16_t id)
 	ipv4_hdr->packet_id = rte_cpu_to_be_16(id);
 }
 
+/**
+ * Internal function which updates the IPv6 header of a packet, following
+ * segmentation. This is required to update the header's 'payload_len'
+ * field, to reflect the reduced length of the now-segmented packet.
+ *
+ * @param pkt
+ *  The packet containing the IPv6 header.
+ * @param l3_offset
+ *  The offset of the IPv6 header from the start of the packet.
+ */
+static inline void
+update_ipv6_header(struct rte_mbuf *pkt, uint16_t l3_offset)
+{
+	struct ipv6_hdr *ipv6_hdr;
+
+	ipv6_hdr = (struct ipv6_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			l3_offset);
+	ipv6_hdr->payload_len = rte_cpu_to_be_16(pkt->pkt_len - l3_offset -
+			sizeof(struct ipv6_hdr));
+}
+
 /**
  * Internal function which divides the input packet into small segments.
  * Each of the newly-created segments is organized as a two-segment MBUF,
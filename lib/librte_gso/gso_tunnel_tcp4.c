@@ -36,13 +36,14 @@ update_tunnel_ipv4_tcp_headers(struct rte_mbuf *pkt, uint8_t ipid_delta,
 	sent_seq = rte_be_to_cpu_32(tcp_hdr->sent_seq);
 	tail_idx = nb_segs - 1;
 
-	/* Only update UDP header for VxLAN packets. */
-	update_udp_hdr = (pkt->ol_flags & PKT_TX_TUNNEL_VXLAN) ? 1 : 0;
+	/* Only update UDP header for VxLAN and Geneve packets. */
+	update_udp_hdr = IS_UDP_TUNNEL(pkt->ol_flags);
 
 	for (i = 0; i < nb_segs; i++) {
 		update_ipv4_header(segs[i], outer_ipv4_offset, outer_id);
 		if (update_udp_hdr)
-			update_udp_header(segs[i], udp_gre_offset);
+			update_tunnel_udp_header(segs[i], outer_ipv4_offset,
+					udp_gre_offset);
 		update_ipv4_header(segs[i], inner_ipv4_offset, inner_id);
 		update_tcp_header(segs[i], tcp_offset, sent_seq, i < tail_idx);
 		outer_id++;
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include "gso_common.h"
+#include "gso_tunnel_tcp6.h"
+
+static void
+update_tunnel_ipv6_tcp_headers(struct rte_mbuf *pkt, uint8_t ipid_delta,
+		struct rte_mbuf **segs, uint16_t nb_segs)
+{
+	struct ipv4_hdr *ipv4_hdr;
+	struct tcp_hdr *tcp_hdr;
+	uint32_t sent_seq;
+	uint16_t outer_id, inner_id, tail_idx, i;
+	uint16_t outer_l3_offset, inner_l3_offset;
+	uint16_t udp_gre_offset, tcp_offset;
+	uint8_t outer_ipv4, inner_ipv4, update_udp_hdr;
+
+	outer_l3_offset = pkt->outer_l2_len;
+	udp_gre_offset = outer_l3_offset + pkt->outer_l3_len;
+	inner_l3_offset = udp_gre_offset + pkt->l2_len;
+	tcp_offset = inner_l3_offset + pkt->l3_len;
+
+	outer_ipv4 = (pkt->ol_flags & PKT_TX_OUTER_IPV6) ? 0 : 1;
+	inner_ipv4 = (pkt->ol_flags & PKT_TX_IPV6) ? 0 : 1;
+	outer_id = 0;
+	inner_id = 0;
+
+	/* Outer IPv4 header. */
+	if (outer_ipv4) {
+		ipv4_hdr = (struct ipv4_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+				outer_l3_offset);
+		outer_id = rte_be_to_cpu_16(ipv4_hdr->packet_id);
+	}
+
+	/* Inner IPv4 header. */
+	if (inner_ipv4) {
+		ipv4_hdr = (struct ipv4_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+				inner_l3_offset);
+		inner_id = rte_be_to_cpu_16(ipv4_hdr->packet_id);
+	}
+
+	tcp_hdr = (struct tcp_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			tcp_offset);
+	sent_seq = rte_be_to_cpu_32(tcp_hdr->sent_seq);
+	tail_idx = nb_segs - 1;
+
+	/* Only update UDP header for VxLAN and Geneve packets. */
+	update_udp_hdr = IS_UDP_TUNNEL(pkt->ol_flags);
+
+	for (i = 0; i < nb_segs; i++) {
+		if (outer_ipv4)
+			update_ipv4_header(segs[i], outer_l3_offset, outer_id);
+		else
+			update_ipv6_header(segs[i], outer_l3_offset);
+		if (update_udp_hdr)
+			update_tunnel_udp_header(segs[i], outer_l3_offset,
+					udp_gre_offset);
+		if (inner_ipv4)
+			update_ipv4_header(segs[i], inner_l3_offset, inner_id);
+		else
+			update_ipv6_header(segs[i], inner_l3_offset);
+		update_tcp_header(segs[i], tcp_offset, sent_seq, i < tail_idx);
+		outer_id++;
+		inner_id += ipid_delta;
+		sent_seq += (segs[i]->pkt_len - segs[i]->data_len);
+	}
+}
+
+int
+gso_tunnel_tcp6_segment(struct rte_mbuf *pkt,
+		uint16_t gso_size,
+		uint8_t ipid_delta,
+		struct rte_mempool *direct_pool,
+		struct rte_mempool *indirect_pool,
+		struct rte_mbuf **pkts_out,
+		uint16_t nb_pkts_out)
+{
+	struct ipv4_hdr *inner_ipv4_hdr;
+	uint16_t pyld_unit_size, hdr_offset, frag_off;
+	int ret = 1;
+
+	hdr_offset = pkt->outer_l2_len + pkt->outer_l3_len + pkt->l2_len;
+
+	/*
+	 * Don't process the packet whose MF bit or offset in the inner
+	 * IPv4 header are non-zero.
+	 */
+	if ((pkt->ol_flags & PKT_TX_IPV6) == 0) {
+		inner_ipv4_hdr = (struct ipv4_hdr *)(rte_pktmbuf_mtod(pkt,
+					char *) + hdr_offset);
+		frag_off = rte_be_to_cpu_16(inner_ipv4_hdr->fragment_offset);
+		if (unlikely(IS_FRAGMENTED(frag_off))) {
+			pkts_out[0] = pkt;
+			return 1;
+		}
+	}
+
+	hdr_offset += pkt->l3_len + pkt->l4_len;
+	/* Don't process the packet without data */
+	if (hdr_offset >= pkt->pkt_len) {
+		pkts_out[0] = pkt;
+		return 1;
+	}
+	pyld_unit_size = gso_size - hdr_offset;
+
+	/* Segment the payload */
+	ret = gso_do_segment(pkt, hdr_offset, pyld_unit_size, direct_pool,
+			indirect_pool, pkts_out, nb_pkts_out);
+	if (ret <= 1)
+		return ret;
+
+	update_tunnel_ipv6_tcp_headers(pkt, ipid_delta, pkts_out, ret);
+
+	return ret;
+}
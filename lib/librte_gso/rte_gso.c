@@ -10,7 +10,9 @@
 #include "rte_gso.h"
 #include "gso_common.h"
 #include "gso_tcp4.h"
+#include "gso_tcp6.h"
 #include "gso_tunnel_tcp4.h"
+#include "gso_tunnel_tcp6.h"
 #include "gso_udp4.h"
 
 #define ILLEGAL_UDP_GSO_CTX(ctx) \
@@ -20,9 +22,26 @@
 #define ILLEGAL_TCP_GSO_CTX(ctx) \
 	((((ctx)->gso_types & (DEV_TX_OFFLOAD_TCP_TSO | \
 		DEV_TX_OFFLOAD_VXLAN_TNL_TSO | \
-		DEV_TX_OFFLOAD_GRE_TNL_TSO)) == 0) || \
+		DEV_TX_OFFLOAD_GRE_TNL_TSO | \
+		DEV_TX_OFFLOAD_GENEVE_TNL_TSO)) == 0) || \
 		(ctx)->gso_size < RTE_GSO_SEG_SIZE_MIN)
 
+/* Tx offload capability needed to segment a packet of a tunnel type. */
+static inline uint64_t
+gso_tunnel_tso_capa(uint64_t ol_flags)
+{
+	switch (ol_flags & PKT_TX_TUNNEL_MASK) {
+	case PKT_TX_TUNNEL_VXLAN:
+		return DEV_TX_OFFLOAD_VXLAN_TNL_TSO;
+	case PKT_TX_TUNNEL_GRE:
+		return DEV_TX_OFFLOAD_GRE_TNL_TSO;
+	case PKT_TX_TUNNEL_GENEVE:
+		return DEV_TX_OFFLOAD_GENEVE_TNL_TSO;
+	default:
+		return 0;
+	}
+}
+
 int
 rte_gso_segment(struct rte_mbuf *pkt,
 		const struct rte_gso_ctx *gso_ctx,
@@ -57,17 +76,32 @@ rte_gso_segment(struct rte_mbuf *pkt,
 	if ((IS_IPV4_VXLAN_TCP4(pkt->ol_flags) &&
 			(gso_ctx->gso_types & DEV_TX_OFFLOAD_VXLAN_TNL_TSO)) ||
 			((IS_IPV4_GRE_TCP4(pkt->ol_flags) &&
-			 (gso_ctx->gso_types & DEV_TX_OFFLOAD_GRE_TNL_TSO)))) {
+			 (gso_ctx->gso_types & DEV_TX_OFFLOAD_GRE_TNL_TSO))) ||
+			((IS_IPV4_GENEVE_TCP4(pkt->ol_flags) &&
+			 (gso_ctx->gso_types &
+			  DEV_TX_OFFLOAD_GENEVE_TNL_TSO)))) {
 		pkt->ol_flags &= (~PKT_TX_TCP_SEG);
 		ret = gso_tunnel_tcp4_segment(pkt, gso_size, ipid_delta,
 				direct_pool, indirect_pool,
 				pkts_out, nb_pkts_out);
+	} else if (IS_TUNNEL_TCP_IPV6(pkt->ol_flags) &&
+			(gso_ctx->gso_types &
+			 gso_tunnel_tso_capa(pkt->ol_flags))) {
+		pkt->ol_flags &= (~PKT_TX_TCP_SEG);
+		ret = gso_tunnel_tcp6_segment(pkt, gso_size, ipid_delta,
+				direct_pool, indirect_pool,
+				pkts_out, nb_pkts_out);
 	} else if (IS_IPV4_TCP(pkt->ol_flags) &&
 			(gso_ctx->gso_types & DEV_TX_OFFLOAD_TCP_TSO)) {
 		pkt->ol_flags &= (~PKT_TX_TCP_SEG);
 		ret = gso_tcp4_segment(pkt, gso_size, ipid_delta,
 				direct_pool, indirect_pool,
 				pkts_out, nb_pkts_out);
+	} else if (IS_IPV6_TCP(pkt->ol_flags) &&
+			(gso_ctx->gso_types & DEV_TX_OFFLOAD_TCP_TSO)) {
+		pkt->ol_flags &= (~PKT_TX_TCP_SEG);
+		ret = gso_tcp6_segment(pkt, gso_size, direct_pool,
+				indirect_pool, pkts_out, nb_pkts_out);
 	} else if (IS_IPV4_UDP(pkt->ol_flags) &&
 			(gso_ctx->gso_types & DEV_TX_OFFLOAD_UDP_TSO)) {
 		pkt->ol_flags &= (~PKT_TX_UDP_SEG);
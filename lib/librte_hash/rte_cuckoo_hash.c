@@ -119,6 +119,29 @@ get_alt_bucket_index(const struct rte_hash *h,
 	return (cur_bkt_idx ^ sig) & h->bucket_bitmask;
 }
 
+/* Time of the last access, at the end of the entries of an aging table */
+static inline uint64_t *
+get_entry_time(const struct rte_hash *h, const struct rte_hash_key *k)
+{
+	return RTE_PTR_ADD(k, h->key_entry_size - sizeof(uint64_t));
+}
+
+/* Record an access to an entry, if the table has aging enabled */
+static inline void
+__hash_age_touch(const struct rte_hash *h, const struct rte_hash_key *k)
+{
+	uint64_t now, *last;
+
+	if (likely(!h->aging_support))
+		return;
+
+	now = __atomic_load_n(&h->age_now, __ATOMIC_RELAXED);
+	last = get_entry_time(h, k);
+	/* Do not dirty the entries already accessed at this time */
+	if (__atomic_load_n(last, __ATOMIC_RELAXED) != now)
+		__atomic_store_n(last, now, __ATOMIC_RELAXED);
+}
+
 struct rte_hash *
 rte_hash_create(const struct rte_hash_parameters *params)
 {
@@ -142,6 +165,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	unsigned int no_free_on_del = 0;
 	uint32_t *tbl_chng_cnt = NULL;
 	unsigned int readwrite_concur_lf_support = 0;
+	unsigned int aging_support = 0;
 
 	rte_hash_function default_hash_func = (rte_hash_function)rte_jhash;
 
@@ -205,6 +229,9 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		no_free_on_del = 1;
 	}
 
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_AGING)
+		aging_support = 1;
+
 	/* Store all keys and leave the first entry as a dummy entry for lookup_bulk */
 	if (use_local_cache)
 		/*
@@ -304,8 +331,10 @@ rte_hash_create(const struct rte_hash_parameters *params)
 			rte_ring_sp_enqueue(r_ext, (void *)((uintptr_t) i));
 	}
 
+	/* With aging, the time of the last access follows the key */
 	const uint32_t key_entry_size =
-		RTE_ALIGN(sizeof(struct rte_hash_key) + params->key_len,
+		RTE_ALIGN(sizeof(struct rte_hash_key) + params->key_len +
+			  (aging_support ? sizeof(uint64_t) : 0),
 			  KEY_ALIGNMENT);
 	const uint64_t key_tbl_size = (uint64_t) key_entry_size * num_key_slots;
 
@@ -332,6 +361,9 @@ rte_hash_create(const struct rte_hash_parameters *params)
 #if defined(RTE_ARCH_X86) || defined(RTE_ARCH_ARM64)
 	/* Select function to compare keys */
 	switch (params->key_len) {
+	case 8:
+		h->cmp_jump_table_idx = KEY_8_BYTES;
+		break;
 	case 16:
 		h->cmp_jump_table_idx = KEY_16_BYTES;
 		break;
@@ -357,7 +389,7 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		h->cmp_jump_table_idx = KEY_128_BYTES;
 		break;
 	default:
-		/* If key is not multiple of 16, use generic memcmp */
+		/* If key is not 8 or a multiple of 16, use generic memcmp */
 		h->cmp_jump_table_idx = KEY_OTHER_BYTES;
 	}
 #else
@@ -402,8 +434,14 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->writer_takes_lock = writer_takes_lock;
 	h->no_free_on_del = no_free_on_del;
 	h->readwrite_concur_lf_support = readwrite_concur_lf_support;
+	h->aging_support = aging_support;
 
 #if defined(RTE_ARCH_X86)
+#ifdef RTE_MACHINE_CPUFLAG_AVX512BW
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW))
+		h->sig_cmp_fn = RTE_HASH_COMPARE_AVX512;
+	else
+#endif
 	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE2))
 		h->sig_cmp_fn = RTE_HASH_COMPARE_SSE;
 	else
@@ -556,6 +594,21 @@ __hash_rw_reader_unlock(const struct rte_hash *h)
 		rte_rwlock_read_unlock(h->readwrite_lock);
 }
 
+/* Writer lock of a single add or delete, already held by the bulk ones */
+static inline void
+__hash_rw_writer_lock_cond(const struct rte_hash *h, int locked)
+{
+	if (!locked)
+		__hash_rw_writer_lock(h);
+}
+
+static inline void
+__hash_rw_writer_unlock_cond(const struct rte_hash *h, int locked)
+{
+	if (!locked)
+		__hash_rw_writer_unlock(h);
+}
+
 void
 rte_hash_reset(struct rte_hash *h)
 {
@@ -646,6 +699,7 @@ search_and_update(const struct rte_hash *h, void *data, const void *key,
 				__atomic_store_n(&k->pdata,
 					data,
 					__ATOMIC_RELEASE);
+				__hash_age_touch(h, k);
 				/*
 				 * Return index where key is stored,
 				 * subtracting the first dummy index
@@ -668,19 +722,19 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 		struct rte_hash_bucket *sec_bkt,
 		const struct rte_hash_key *key, void *data,
 		uint16_t sig, uint32_t new_idx,
-		int32_t *ret_val)
+		int32_t *ret_val, int locked)
 {
 	unsigned int i;
 	struct rte_hash_bucket *cur_bkt;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	__hash_rw_writer_lock_cond(h, locked);
 	/* Check if key was inserted after last check but before this
 	 * protected region in case of inserting duplicated keys.
 	 */
 	ret = search_and_update(h, data, key, prim_bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_writer_unlock_cond(h, locked);
 		*ret_val = ret;
 		return 1;
 	}
@@ -688,7 +742,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_rw_writer_unlock_cond(h, locked);
 			*ret_val = ret;
 			return 1;
 		}
@@ -713,7 +767,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 			break;
 		}
 	}
-	__hash_rw_writer_unlock(h);
+	__hash_rw_writer_unlock_cond(h, locked);
 
 	if (i != RTE_HASH_BUCKET_ENTRIES)
 		return 0;
@@ -734,7 +788,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			const struct rte_hash_key *key, void *data,
 			struct queue_node *leaf, uint32_t leaf_slot,
 			uint16_t sig, uint32_t new_idx,
-			int32_t *ret_val)
+			int32_t *ret_val, int locked)
 {
 	uint32_t prev_alt_bkt_idx;
 	struct rte_hash_bucket *cur_bkt;
@@ -743,11 +797,11 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	uint32_t prev_slot, curr_slot = leaf_slot;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	__hash_rw_writer_lock_cond(h, locked);
 
 	/* In case empty slot was gone before entering protected region */
 	if (curr_bkt->key_idx[curr_slot] != EMPTY_SLOT) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_writer_unlock_cond(h, locked);
 		return -1;
 	}
 
@@ -756,7 +810,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	 */
 	ret = search_and_update(h, data, key, bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_writer_unlock_cond(h, locked);
 		*ret_val = ret;
 		return 1;
 	}
@@ -764,7 +818,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, alt_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_rw_writer_unlock_cond(h, locked);
 			*ret_val = ret;
 			return 1;
 		}
@@ -785,7 +839,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			__atomic_store_n(&curr_bkt->key_idx[curr_slot],
 				EMPTY_SLOT,
 				__ATOMIC_RELEASE);
-			__hash_rw_writer_unlock(h);
+			__hash_rw_writer_unlock_cond(h, locked);
 			return -1;
 		}
 
@@ -843,7 +897,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			 new_idx,
 			 __ATOMIC_RELEASE);
 
-	__hash_rw_writer_unlock(h);
+	__hash_rw_writer_unlock_cond(h, locked);
 
 	return 0;
 
@@ -859,7 +913,7 @@ rte_hash_cuckoo_make_space_mw(const struct rte_hash *h,
 			struct rte_hash_bucket *sec_bkt,
 			const struct rte_hash_key *key, void *data,
 			uint16_t sig, uint32_t bucket_idx,
-			uint32_t new_idx, int32_t *ret_val)
+			uint32_t new_idx, int32_t *ret_val, int locked)
 {
 	unsigned int i;
 	struct queue_node queue[RTE_HASH_BFS_QUEUE_MAX_LEN];
@@ -885,7 +939,7 @@ rte_hash_cuckoo_make_space_mw(const struct rte_hash *h,
 				int32_t ret = rte_hash_cuckoo_move_insert_mw(h,
 						bkt, sec_bkt, key, data,
 						tail, i, sig,
-						new_idx, ret_val);
+						new_idx, ret_val, locked);
 				if (likely(ret != -1))
 					return ret;
 			}
@@ -908,7 +962,7 @@ rte_hash_cuckoo_make_space_mw(const struct rte_hash *h,
 
 static inline int32_t
 __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
-						hash_sig_t sig, void *data)
+						hash_sig_t sig, void *data, int locked)
 {
 	uint16_t short_sig;
 	uint32_t prim_bucket_idx, sec_bucket_idx;
@@ -934,10 +988,10 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	rte_prefetch0(sec_bkt);
 
 	/* Check if key is already inserted in primary location */
-	__hash_rw_writer_lock(h);
+	__hash_rw_writer_lock_cond(h, locked);
 	ret = search_and_update(h, data, key, prim_bkt, short_sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_writer_unlock_cond(h, locked);
 		return ret;
 	}
 
@@ -945,12 +999,12 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, short_sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_rw_writer_unlock_cond(h, locked);
 			return ret;
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_rw_writer_unlock_cond(h, locked);
 
 	/* Did not find a match, so get a new slot for storing the new key */
 	if (h->use_local_cache) {
@@ -982,6 +1036,8 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	new_idx = (uint32_t)((uintptr_t) slot_id);
 	/* Copy key */
 	memcpy(new_k->key, key, h->key_len);
+	if (h->aging_support)
+		*get_entry_time(h, new_k) = h->age_now;
 	/* Key can be of arbitrary length, so it is not possible to store
 	 * it atomically. Hence the new key element's memory stores
 	 * (key as well as data) should be complete before it is referenced.
@@ -994,7 +1050,7 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 
 	/* Find an empty slot and insert */
 	ret = rte_hash_cuckoo_insert_mw(h, prim_bkt, sec_bkt, key, data,
-					short_sig, new_idx, &ret_val);
+					short_sig, new_idx, &ret_val, locked);
 	if (ret == 0)
 		return new_idx - 1;
 	else if (ret == 1) {
@@ -1004,7 +1060,8 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 
 	/* Primary bucket full, need to make space for new entry */
 	ret = rte_hash_cuckoo_make_space_mw(h, prim_bkt, sec_bkt, key, data,
-				short_sig, prim_bucket_idx, new_idx, &ret_val);
+				short_sig, prim_bucket_idx, new_idx, &ret_val,
+				locked);
 	if (ret == 0)
 		return new_idx - 1;
 	else if (ret == 1) {
@@ -1014,7 +1071,8 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 
 	/* Also search secondary bucket to get better occupancy */
 	ret = rte_hash_cuckoo_make_space_mw(h, sec_bkt, prim_bkt, key, data,
-				short_sig, sec_bucket_idx, new_idx, &ret_val);
+				short_sig, sec_bucket_idx, new_idx, &ret_val,
+				locked);
 
 	if (ret == 0)
 		return new_idx - 1;
@@ -1032,7 +1090,7 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	/* Now we need to go through the extendable bucket. Protection is needed
 	 * to protect all extendable bucket processes.
 	 */
-	__hash_rw_writer_lock(h);
+	__hash_rw_writer_lock_cond(h, locked);
 	/* We check for duplicates again since could be inserted before the lock */
 	ret = search_and_update(h, data, key, prim_bkt, short_sig);
 	if (ret != -1) {
@@ -1055,7 +1113,7 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 			if (likely(cur_bkt->key_idx[i] == EMPTY_SLOT)) {
 				cur_bkt->sig_current[i] = short_sig;
 				cur_bkt->key_idx[i] = new_idx;
-				__hash_rw_writer_unlock(h);
+				__hash_rw_writer_unlock_cond(h, locked);
 				return new_idx - 1;
 			}
 		}
@@ -1076,11 +1134,11 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	/* Link the new bucket to sec bucket linked list */
 	last = rte_hash_get_last_bkt(sec_bkt);
 	last->next = &h->buckets_ext[bkt_id];
-	__hash_rw_writer_unlock(h);
+	__hash_rw_writer_unlock_cond(h, locked);
 	return new_idx - 1;
 
 failure:
-	__hash_rw_writer_unlock(h);
+	__hash_rw_writer_unlock_cond(h, locked);
 	return ret;
 
 }
@@ -1090,14 +1148,14 @@ rte_hash_add_key_with_hash(const struct rte_hash *h,
 			const void *key, hash_sig_t sig)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_add_key_with_hash(h, key, sig, 0);
+	return __rte_hash_add_key_with_hash(h, key, sig, 0, 0);
 }
 
 int32_t
 rte_hash_add_key(const struct rte_hash *h, const void *key)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), 0);
+	return __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), 0, 0);
 }
 
 int
@@ -1107,7 +1165,7 @@ rte_hash_add_key_with_hash_data(const struct rte_hash *h,
 	int ret;
 
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	ret = __rte_hash_add_key_with_hash(h, key, sig, data);
+	ret = __rte_hash_add_key_with_hash(h, key, sig, data, 0);
 	if (ret >= 0)
 		return 0;
 	else
@@ -1121,7 +1179,7 @@ rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
 
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
 
-	ret = __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), data);
+	ret = __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key), data, 0);
 	if (ret >= 0)
 		return 0;
 	else
@@ -1146,6 +1204,7 @@ search_one_bucket_l(const struct rte_hash *h, const void *key,
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
 				if (data != NULL)
 					*data = k->pdata;
+				__hash_age_touch(h, k);
 				/*
 				 * Return index where key is stored,
 				 * subtracting the first dummy index
@@ -1179,6 +1238,7 @@ search_one_bucket_lf(const struct rte_hash *h, const void *key, uint16_t sig,
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
 				if (data != NULL)
 					*data = pdata;
+				__hash_age_touch(h, k);
 				/*
 				 * Return index where key is stored,
 				 * subtracting the first dummy index
@@ -1428,7 +1488,7 @@ search_and_remove(const struct rte_hash *h, const void *key,
 
 static inline int32_t
 __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
-						hash_sig_t sig)
+						hash_sig_t sig, int locked)
 {
 	uint32_t prim_bucket_idx, sec_bucket_idx;
 	struct rte_hash_bucket *prim_bkt, *sec_bkt, *prev_bkt, *last_bkt;
@@ -1442,7 +1502,7 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
 	prim_bkt = &h->buckets[prim_bucket_idx];
 
-	__hash_rw_writer_lock(h);
+	__hash_rw_writer_lock_cond(h, locked);
 	/* look for key in primary bucket */
 	ret = search_and_remove(h, key, prim_bkt, short_sig, &pos);
 	if (ret != -1) {
@@ -1465,13 +1525,13 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_rw_writer_unlock_cond(h, locked);
 	return -ENOENT;
 
 /* Search last bucket to see if empty to be recycled */
 return_bkt:
 	if (!last_bkt) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_writer_unlock_cond(h, locked);
 		return ret;
 	}
 	while (last_bkt->next) {
@@ -1490,7 +1550,7 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		rte_ring_sp_enqueue(h->free_ext_bkts, (void *)(uintptr_t)index);
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_rw_writer_unlock_cond(h, locked);
 	return ret;
 }
 
@@ -1499,14 +1559,91 @@ rte_hash_del_key_with_hash(const struct rte_hash *h,
 			const void *key, hash_sig_t sig)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_del_key_with_hash(h, key, sig);
+	return __rte_hash_del_key_with_hash(h, key, sig, 0);
 }
 
 int32_t
 rte_hash_del_key(const struct rte_hash *h, const void *key)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_del_key_with_hash(h, key, rte_hash_hash(h, key));
+	return __rte_hash_del_key_with_hash(h, key, rte_hash_hash(h, key), 0);
+}
+
+/* Compute the hashes of the keys to write, and prefetch their buckets */
+static inline void
+__bulk_write_prefetch(const struct rte_hash *h, const void **keys,
+			uint32_t num_keys, hash_sig_t *sig)
+{
+	uint32_t i, prim_index;
+
+	for (i = 0; i < num_keys; i++) {
+		sig[i] = rte_hash_hash(h, keys[i]);
+		prim_index = get_prim_bucket_index(h, sig[i]);
+		rte_prefetch0(&h->buckets[prim_index]);
+		rte_prefetch0(&h->buckets[get_alt_bucket_index(h, prim_index,
+				get_short_sig(sig[i]))]);
+	}
+}
+
+int __rte_experimental
+rte_hash_add_key_bulk(const struct rte_hash *h, const void **keys,
+		void *data[], uint32_t num_keys, int32_t *positions)
+{
+	hash_sig_t sig[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t i, j, n;
+	int added = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) ||
+			(positions == NULL)), -EINVAL);
+
+	/*
+	 * The writer lock is taken once per chunk of keys, so that the
+	 * readers are not held back by a whole table load.
+	 */
+	for (i = 0; i < num_keys; i += n) {
+		n = RTE_MIN(num_keys - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		__bulk_write_prefetch(h, &keys[i], n, sig);
+
+		__hash_rw_writer_lock(h);
+		for (j = 0; j < n; j++) {
+			positions[i + j] = __rte_hash_add_key_with_hash(h,
+					keys[i + j], sig[j],
+					data != NULL ? data[i + j] : NULL, 1);
+			if (positions[i + j] >= 0)
+				added++;
+		}
+		__hash_rw_writer_unlock(h);
+	}
+
+	return added;
+}
+
+int __rte_experimental
+rte_hash_del_key_bulk(const struct rte_hash *h, const void **keys,
+		uint32_t num_keys, int32_t *positions)
+{
+	hash_sig_t sig[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t i, j, n;
+	int deleted = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) ||
+			(positions == NULL)), -EINVAL);
+
+	for (i = 0; i < num_keys; i += n) {
+		n = RTE_MIN(num_keys - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		__bulk_write_prefetch(h, &keys[i], n, sig);
+
+		__hash_rw_writer_lock(h);
+		for (j = 0; j < n; j++) {
+			positions[i + j] = __rte_hash_del_key_with_hash(h,
+					keys[i + j], sig[j], 1);
+			if (positions[i + j] >= 0)
+				deleted++;
+		}
+		__hash_rw_writer_unlock(h);
+	}
+
+	return deleted;
 }
 
 int
@@ -1578,6 +1715,9 @@ compare_signatures(uint32_t *prim_hash_matches, uint32_t *sec_hash_matches,
 	/* For match mask the first bit of every two bits indicates the match */
 	switch (sig_cmp_fn) {
 #ifdef RTE_MACHINE_CPUFLAG_SSE2
+#ifdef RTE_MACHINE_CPUFLAG_AVX512BW
+	case RTE_HASH_COMPARE_AVX512:
+#endif
 	case RTE_HASH_COMPARE_SSE:
 		/* Compare all signatures in the bucket */
 		*prim_hash_matches = _mm_movemask_epi8(_mm_cmpeq_epi16(
@@ -1601,24 +1741,77 @@ compare_signatures(uint32_t *prim_hash_matches, uint32_t *sec_hash_matches,
 	}
 }
 
+#ifdef RTE_MACHINE_CPUFLAG_AVX512BW
+/*
+ * Compare the primary and secondary buckets of two keys at once, the four
+ * buckets signatures filling a 512-bit register. The match masks have the
+ * same layout as with SSE.
+ */
+static inline void
+compare_signatures_x2(uint32_t *prim_hash_matches, uint32_t *sec_hash_matches,
+			const struct rte_hash_bucket **prim_bkt,
+			const struct rte_hash_bucket **sec_bkt,
+			const uint16_t *sig)
+{
+	__m256i bkt0 = _mm256_inserti128_si256(_mm256_castsi128_si256(
+			_mm_load_si128((__m128i const *)prim_bkt[0]->sig_current)),
+			_mm_load_si128((__m128i const *)sec_bkt[0]->sig_current),
+			1);
+	__m256i bkt1 = _mm256_inserti128_si256(_mm256_castsi128_si256(
+			_mm_load_si128((__m128i const *)prim_bkt[1]->sig_current)),
+			_mm_load_si128((__m128i const *)sec_bkt[1]->sig_current),
+			1);
+	__m512i sigs = _mm512_inserti64x4(_mm512_castsi256_si512(
+			_mm256_set1_epi16(sig[0])), _mm256_set1_epi16(sig[1]), 1);
+	__mmask32 eq;
+	uint64_t matches;
+
+	eq = _mm512_cmpeq_epi16_mask(_mm512_inserti64x4(
+			_mm512_castsi256_si512(bkt0), bkt1, 1), sigs);
+	/* two bits per matching entry, as _mm_movemask_epi8() gives */
+	matches = _mm512_movepi8_mask(_mm512_movm_epi16(eq));
+
+	prim_hash_matches[0] = (uint16_t)matches;
+	sec_hash_matches[0] = (uint16_t)(matches >> 16);
+	prim_hash_matches[1] = (uint16_t)(matches >> 32);
+	sec_hash_matches[1] = (uint16_t)(matches >> 48);
+}
+#endif
+
+static inline void
+compare_signatures_bulk(uint32_t *prim_hash_matches,
+			uint32_t *sec_hash_matches,
+			const struct rte_hash_bucket **prim_bkt,
+			const struct rte_hash_bucket **sec_bkt,
+			const uint16_t *sig, int32_t num_keys,
+			enum rte_hash_sig_compare_function sig_cmp_fn)
+{
+	int32_t i = 0;
+
+#ifdef RTE_MACHINE_CPUFLAG_AVX512BW
+	if (sig_cmp_fn == RTE_HASH_COMPARE_AVX512)
+		for (; i + 1 < num_keys; i += 2)
+			compare_signatures_x2(&prim_hash_matches[i],
+				&sec_hash_matches[i], &prim_bkt[i],
+				&sec_bkt[i], &sig[i]);
+#endif
+	for (; i < num_keys; i++)
+		compare_signatures(&prim_hash_matches[i], &sec_hash_matches[i],
+			prim_bkt[i], sec_bkt[i], sig[i], sig_cmp_fn);
+}
+
 #define PREFETCH_OFFSET 4
+/* Compute the signatures and buckets of the keys, and prefetch them */
 static inline void
-__rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
-			int32_t num_keys, int32_t *positions,
-			uint64_t *hit_mask, void *data[])
+__bulk_lookup_prefetch(const struct rte_hash *h, const void **keys,
+			int32_t num_keys, uint16_t *sig,
+			const struct rte_hash_bucket **primary_bkt,
+			const struct rte_hash_bucket **secondary_bkt)
 {
-	uint64_t hits = 0;
 	int32_t i;
-	int32_t ret;
 	uint32_t prim_hash[RTE_HASH_LOOKUP_BULK_MAX];
 	uint32_t prim_index[RTE_HASH_LOOKUP_BULK_MAX];
 	uint32_t sec_index[RTE_HASH_LOOKUP_BULK_MAX];
-	uint16_t sig[RTE_HASH_LOOKUP_BULK_MAX];
-	const struct rte_hash_bucket *primary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
-	const struct rte_hash_bucket *secondary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
-	uint32_t prim_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
-	uint32_t sec_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
-	struct rte_hash_bucket *cur_bkt, *next_bkt;
 
 	/* Prefetch first keys */
 	for (i = 0; i < PREFETCH_OFFSET && i < num_keys; i++)
@@ -1658,15 +1851,30 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 		rte_prefetch0(primary_bkt[i]);
 		rte_prefetch0(secondary_bkt[i]);
 	}
+}
+
+static inline void
+__rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
+			const uint16_t *sig,
+			const struct rte_hash_bucket **primary_bkt,
+			const struct rte_hash_bucket **secondary_bkt,
+			int32_t num_keys, int32_t *positions,
+			uint64_t *hit_mask, void *data[])
+{
+	uint64_t hits = 0;
+	int32_t i;
+	int32_t ret;
+	uint32_t prim_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
+	uint32_t sec_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
+	struct rte_hash_bucket *cur_bkt, *next_bkt;
 
 	__hash_rw_reader_lock(h);
 
-	/* Compare signatures and prefetch key slot of first hit */
-	for (i = 0; i < num_keys; i++) {
-		compare_signatures(&prim_hitmask[i], &sec_hitmask[i],
-			primary_bkt[i], secondary_bkt[i],
-			sig[i], h->sig_cmp_fn);
+	compare_signatures_bulk(prim_hitmask, sec_hitmask, primary_bkt,
+			secondary_bkt, sig, num_keys, h->sig_cmp_fn);
 
+	/* Prefetch key slot of first hit */
+	for (i = 0; i < num_keys; i++) {
 		if (prim_hitmask[i]) {
 			uint32_t first_hit =
 					__builtin_ctzl(prim_hitmask[i])
@@ -1718,6 +1926,7 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 					key_slot->key, keys[i], h)) {
 				if (data != NULL)
 					data[i] = key_slot->pdata;
+				__hash_age_touch(h, key_slot);
 
 				hits |= 1ULL << i;
 				positions[i] = key_idx - 1;
@@ -1747,6 +1956,7 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 					key_slot->key, keys[i], h)) {
 				if (data != NULL)
 					data[i] = key_slot->pdata;
+				__hash_age_touch(h, key_slot);
 
 				hits |= 1ULL << i;
 				positions[i] = key_idx - 1;
@@ -1794,63 +2004,21 @@ __rte_hash_lookup_bulk_l(const struct rte_hash *h, const void **keys,
 
 static inline void
 __rte_hash_lookup_bulk_lf(const struct rte_hash *h, const void **keys,
+			const uint16_t *sig,
+			const struct rte_hash_bucket **primary_bkt,
+			const struct rte_hash_bucket **secondary_bkt,
 			int32_t num_keys, int32_t *positions,
 			uint64_t *hit_mask, void *data[])
 {
 	uint64_t hits = 0;
 	int32_t i;
 	int32_t ret;
-	uint32_t prim_hash[RTE_HASH_LOOKUP_BULK_MAX];
-	uint32_t prim_index[RTE_HASH_LOOKUP_BULK_MAX];
-	uint32_t sec_index[RTE_HASH_LOOKUP_BULK_MAX];
-	uint16_t sig[RTE_HASH_LOOKUP_BULK_MAX];
-	const struct rte_hash_bucket *primary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
-	const struct rte_hash_bucket *secondary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
 	uint32_t prim_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
 	uint32_t sec_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
 	struct rte_hash_bucket *cur_bkt, *next_bkt;
 	void *pdata[RTE_HASH_LOOKUP_BULK_MAX];
 	uint32_t cnt_b, cnt_a;
 
-	/* Prefetch first keys */
-	for (i = 0; i < PREFETCH_OFFSET && i < num_keys; i++)
-		rte_prefetch0(keys[i]);
-
-	/*
-	 * Prefetch rest of the keys, calculate primary and
-	 * secondary bucket and prefetch them
-	 */
-	for (i = 0; i < (num_keys - PREFETCH_OFFSET); i++) {
-		rte_prefetch0(keys[i + PREFETCH_OFFSET]);
-
-		prim_hash[i] = rte_hash_hash(h, keys[i]);
-
-		sig[i] = get_short_sig(prim_hash[i]);
-		prim_index[i] = get_prim_bucket_index(h, prim_hash[i]);
-		sec_index[i] = get_alt_bucket_index(h, prim_index[i], sig[i]);
-
-		primary_bkt[i] = &h->buckets[prim_index[i]];
-		secondary_bkt[i] = &h->buckets[sec_index[i]];
-
-		rte_prefetch0(primary_bkt[i]);
-		rte_prefetch0(secondary_bkt[i]);
-	}
-
-	/* Calculate and prefetch rest of the buckets */
-	for (; i < num_keys; i++) {
-		prim_hash[i] = rte_hash_hash(h, keys[i]);
-
-		sig[i] = get_short_sig(prim_hash[i]);
-		prim_index[i] = get_prim_bucket_index(h, prim_hash[i]);
-		sec_index[i] = get_alt_bucket_index(h, prim_index[i], sig[i]);
-
-		primary_bkt[i] = &h->buckets[prim_index[i]];
-		secondary_bkt[i] = &h->buckets[sec_index[i]];
-
-		rte_prefetch0(primary_bkt[i]);
-		rte_prefetch0(secondary_bkt[i]);
-	}
-
 	do {
 		/* Load the table change counter before the lookup
 		 * starts. Acquire semantics will make sure that
@@ -1859,12 +2027,12 @@ __rte_hash_lookup_bulk_lf(const struct rte_hash *h, const void **keys,
 		cnt_b = __atomic_load_n(h->tbl_chng_cnt,
 					__ATOMIC_ACQUIRE);
 
-		/* Compare signatures and prefetch key slot of first hit */
-		for (i = 0; i < num_keys; i++) {
-			compare_signatures(&prim_hitmask[i], &sec_hitmask[i],
-				primary_bkt[i], secondary_bkt[i],
-				sig[i], h->sig_cmp_fn);
+		compare_signatures_bulk(prim_hitmask, sec_hitmask,
+				primary_bkt, secondary_bkt, sig, num_keys,
+				h->sig_cmp_fn);
 
+		/* Prefetch key slot of first hit */
+		for (i = 0; i < num_keys; i++) {
 			if (prim_hitmask[i]) {
 				uint32_t first_hit =
 						__builtin_ctzl(prim_hitmask[i])
@@ -1922,6 +2090,7 @@ __rte_hash_lookup_bulk_lf(const struct rte_hash *h, const void **keys,
 						key_slot->key, keys[i], h)) {
 					if (data != NULL)
 						data[i] = pdata[i];
+					__hash_age_touch(h, key_slot);
 
 					hits |= 1ULL << i;
 					positions[i] = key_idx - 1;
@@ -1957,6 +2126,7 @@ __rte_hash_lookup_bulk_lf(const struct rte_hash *h, const void **keys,
 						key_slot->key, keys[i], h)) {
 					if (data != NULL)
 						data[i] = pdata[i];
+					__hash_age_touch(h, key_slot);
 
 					hits |= 1ULL << i;
 					positions[i] = key_idx - 1;
@@ -2017,16 +2187,36 @@ __rte_hash_lookup_bulk_lf(const struct rte_hash *h, const void **keys,
 }
 
 static inline void
-__rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
+__rte_hash_lookup_bulk_prefetched(const struct rte_hash *h, const void **keys,
+			const uint16_t *sig,
+			const struct rte_hash_bucket **primary_bkt,
+			const struct rte_hash_bucket **secondary_bkt,
 			int32_t num_keys, int32_t *positions,
 			uint64_t *hit_mask, void *data[])
 {
 	if (h->readwrite_concur_lf_support)
-		return __rte_hash_lookup_bulk_lf(h, keys, num_keys,
-						positions, hit_mask, data);
+		return __rte_hash_lookup_bulk_lf(h, keys, sig, primary_bkt,
+				secondary_bkt, num_keys, positions, hit_mask,
+				data);
 	else
-		return __rte_hash_lookup_bulk_l(h, keys, num_keys,
-						positions, hit_mask, data);
+		return __rte_hash_lookup_bulk_l(h, keys, sig, primary_bkt,
+				secondary_bkt, num_keys, positions, hit_mask,
+				data);
+}
+
+static inline void
+__rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
+			int32_t num_keys, int32_t *positions,
+			uint64_t *hit_mask, void *data[])
+{
+	uint16_t sig[RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_bucket *primary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_bucket *secondary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+
+	__bulk_lookup_prefetch(h, keys, num_keys, sig, primary_bkt,
+			secondary_bkt);
+	__rte_hash_lookup_bulk_prefetched(h, keys, sig, primary_bkt,
+			secondary_bkt, num_keys, positions, hit_mask, data);
 }
 
 int
@@ -2057,6 +2247,54 @@ rte_hash_lookup_bulk_data(const struct rte_hash *h, const void **keys,
 	return __builtin_popcountl(*hit_mask);
 }
 
+int __rte_experimental
+rte_hash_lookup_bulk_n(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, int32_t *positions, void *data[])
+{
+	uint16_t sig[2][RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_bucket *primary_bkt[2][RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash_bucket *secondary_bkt[2][RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t n, next_n, cur = 0;
+	uint64_t hit_mask;
+	int hits = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(positions == NULL)), -EINVAL);
+
+	n = RTE_MIN(num_keys, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+	__bulk_lookup_prefetch(h, keys, n, sig[cur], primary_bkt[cur],
+			secondary_bkt[cur]);
+
+	while (num_keys != 0) {
+		/*
+		 * Hash the next keys and prefetch their buckets before
+		 * comparing the current ones, so that the bucket loads of a
+		 * chunk overlap with the key compares of the previous one.
+		 */
+		next_n = RTE_MIN(num_keys - n,
+				(uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		if (next_n != 0)
+			__bulk_lookup_prefetch(h, keys + n, next_n,
+					sig[cur ^ 1], primary_bkt[cur ^ 1],
+					secondary_bkt[cur ^ 1]);
+
+		__rte_hash_lookup_bulk_prefetched(h, keys, sig[cur],
+				primary_bkt[cur], secondary_bkt[cur], n,
+				positions, &hit_mask, data);
+		hits += __builtin_popcountll(hit_mask);
+
+		keys += n;
+		positions += n;
+		if (data != NULL)
+			data += n;
+		num_keys -= n;
+		n = next_n;
+		cur ^= 1;
+	}
+
+	return hits;
+}
+
 int32_t
 rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32_t *next)
 {
@@ -2132,3 +2370,76 @@ rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32
 	(*next)++;
 	return position - 1;
 }
+
+void __rte_experimental
+rte_hash_age_set_time(struct rte_hash *h, uint64_t now)
+{
+	__atomic_store_n(&h->age_now, now, __ATOMIC_RELAXED);
+}
+
+int __rte_experimental
+rte_hash_age_scan(const struct rte_hash *h, uint64_t expiry, uint32_t *next,
+		uint32_t num_buckets, const void **keys, int32_t *positions,
+		uint32_t max_keys)
+{
+	const struct rte_hash_bucket *bkt;
+	const struct rte_hash_key *k;
+	uint32_t key_idx[RTE_HASH_BUCKET_ENTRIES];
+	uint32_t total_buckets, bkt_idx, i;
+	int n = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (next == NULL) || (keys == NULL) ||
+			(positions == NULL)), -EINVAL);
+
+	/* All the expired entries of a bucket are returned at once */
+	if (!h->aging_support || max_keys < RTE_HASH_BUCKET_ENTRIES)
+		return -EINVAL;
+
+	/* The extendable buckets are scanned after the main ones */
+	total_buckets = h->num_buckets;
+	if (h->ext_table_support)
+		total_buckets += h->num_buckets;
+	bkt_idx = *next < total_buckets ? *next : 0;
+
+	__hash_rw_reader_lock(h);
+
+	for (; num_buckets != 0 && max_keys - n >= RTE_HASH_BUCKET_ENTRIES;
+			num_buckets--) {
+		if (bkt_idx < h->num_buckets)
+			bkt = &h->buckets[bkt_idx];
+		else
+			bkt = &h->buckets_ext[bkt_idx - h->num_buckets];
+
+		/* Prefetch the entries of the bucket before checking them */
+		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+			key_idx[i] = __atomic_load_n(&bkt->key_idx[i],
+					__ATOMIC_ACQUIRE);
+			if (key_idx[i] != EMPTY_SLOT)
+				rte_prefetch0((const char *)h->key_store +
+					key_idx[i] * h->key_entry_size);
+		}
+
+		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+			if (key_idx[i] == EMPTY_SLOT)
+				continue;
+			k = (const struct rte_hash_key *)(
+				(const char *)h->key_store +
+				key_idx[i] * h->key_entry_size);
+			if (__atomic_load_n(get_entry_time(h, k),
+					__ATOMIC_RELAXED) < expiry) {
+				keys[n] = k->key;
+				positions[n] = key_idx[i] - 1;
+				n++;
+			}
+		}
+
+		if (++bkt_idx == total_buckets)
+			bkt_idx = 0;
+	}
+
+	__hash_rw_reader_unlock(h);
+
+	*next = bkt_idx;
+
+	return n;
+}
@@ -39,6 +39,7 @@
  */
 enum cmp_jump_table_case {
 	KEY_CUSTOM = 0,
+	KEY_8_BYTES,
 	KEY_16_BYTES,
 	KEY_32_BYTES,
 	KEY_48_BYTES,
@@ -57,6 +58,7 @@ enum cmp_jump_table_case {
  */
 const rte_hash_cmp_eq_t cmp_jump_table[NUM_KEY_CMP_CASES] = {
 	NULL,
+	rte_hash_k8_cmp_eq,
 	rte_hash_k16_cmp_eq,
 	rte_hash_k32_cmp_eq,
 	rte_hash_k48_cmp_eq,
@@ -130,6 +132,7 @@ struct rte_hash_key {
 enum rte_hash_sig_compare_function {
 	RTE_HASH_COMPARE_SCALAR = 0,
 	RTE_HASH_COMPARE_SSE,
+	RTE_HASH_COMPARE_AVX512,
 	RTE_HASH_COMPARE_NUM
 };
 
@@ -179,6 +182,8 @@ struct rte_hash {
 	/**< If read-write concurrency lock free support is enabled */
 	uint8_t writer_takes_lock;
 	/**< Indicates if the writer threads need to take lock */
+	uint8_t aging_support;
+	/**< If the key entries end with their last access time */
 	rte_hash_function hash_func;    /**< Function used to calculate hash. */
 	uint32_t hash_func_init_val;    /**< Init value used by hash_func. */
 	rte_hash_cmp_eq_t rte_hash_custom_cmp_eq;
@@ -190,6 +195,8 @@ struct rte_hash {
 	uint32_t bucket_bitmask;
 	/**< Bitmask for getting bucket index from hash signature. */
 	uint32_t key_entry_size;         /**< Size of each key entry. */
+	uint64_t age_now;
+	/**< Time stored in the entries accessed, if aging is enabled. */
 
 	void *key_store;                /**< Table storing all keys and data */
 	struct rte_hash_bucket *buckets;
@@ -56,6 +56,11 @@ extern "C" {
  */
 #define RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF 0x20
 
+/** Flag to store the last access time of each entry, for aging.
+ * Refer to rte_hash_age_set_time and rte_hash_age_scan for more details.
+ */
+#define RTE_HASH_EXTRA_FLAGS_AGING 0x40
+
 /**
  * The type of hash value of a key.
  * It should be a value of at least 32bit with fully random pattern.
@@ -290,6 +295,65 @@ rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key, hash_sig_t
 int32_t
 rte_hash_del_key(const struct rte_hash *h, const void *key);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add multiple keys to an existing hash table, with their data.
+ * The keys are hashed and their buckets prefetched by chunks of
+ * RTE_HASH_LOOKUP_BULK_MAX, the writer lock, if any, being taken once per
+ * chunk instead of once per key. A key already in the table has its data
+ * updated, like with rte_hash_add_key_data().
+ * Thread safety is the same as for rte_hash_add_key_data().
+ *
+ * @param h
+ *   Hash table to add the keys to.
+ * @param keys
+ *   A pointer to a list of keys to add.
+ * @param data
+ *   The data of each key, or NULL to add the keys without data.
+ * @param num_keys
+ *   How many keys are in the keys list.
+ * @param positions
+ *   Output containing the result of each key: the position of the key, as
+ *   returned by rte_hash_add_key(), or -ENOSPC if there is no space left
+ *   for the key.
+ * @return
+ *   -EINVAL if the parameters are invalid, otherwise the number of keys
+ *   added or updated.
+ */
+int __rte_experimental
+rte_hash_add_key_bulk(const struct rte_hash *h, const void **keys,
+		void *data[], uint32_t num_keys, int32_t *positions);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Remove multiple keys from an existing hash table.
+ * The keys are hashed and their buckets prefetched by chunks of
+ * RTE_HASH_LOOKUP_BULK_MAX, the writer lock, if any, being taken once per
+ * chunk instead of once per key. The freeing of the key positions follows
+ * rte_hash_del_key().
+ * Thread safety is the same as for rte_hash_del_key().
+ *
+ * @param h
+ *   Hash table to remove the keys from.
+ * @param keys
+ *   A pointer to a list of keys to remove.
+ * @param num_keys
+ *   How many keys are in the keys list.
+ * @param positions
+ *   Output containing the result of each key: the position the key had, as
+ *   returned by rte_hash_del_key(), or -ENOENT if the key was not found.
+ * @return
+ *   -EINVAL if the parameters are invalid, otherwise the number of keys
+ *   removed.
+ */
+int __rte_experimental
+rte_hash_del_key_bulk(const struct rte_hash *h, const void **keys,
+		uint32_t num_keys, int32_t *positions);
+
 /**
  * Remove a key from an existing hash table.
  * This operation is not multi-thread safe
@@ -523,6 +587,37 @@ int
 rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 		      uint32_t num_keys, int32_t *positions);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Find any number of keys in the hash table.
+ * The keys are looked up by chunks of RTE_HASH_LOOKUP_BULK_MAX, the buckets
+ * of a chunk being prefetched while the keys of the previous one are
+ * compared, so that large batches keep the memory loads in flight.
+ * This operation is multi-thread safe with regarding to other lookup threads.
+ * Read-write concurrency can be enabled by setting flag during
+ * table creation.
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param num_keys
+ *   How many keys are in the keys list, with no upper bound.
+ * @param positions
+ *   Output containing a list of values, corresponding to the list of keys,
+ *   as returned by rte_hash_lookup_bulk(): -ENOENT for a key not found.
+ * @param data
+ *   Output containing array of data returned from all the successful lookups,
+ *   or NULL.
+ * @return
+ *   -EINVAL if there's an error, otherwise number of successful lookups.
+ */
+int __rte_experimental
+rte_hash_lookup_bulk_n(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, int32_t *positions, void *data[]);
+
 /**
  * Iterate through the hash table, returning key-value pairs.
  *
@@ -544,6 +639,66 @@ rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
  */
 int32_t
 rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32_t *next);
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Set the current time of a hash table created with
+ * RTE_HASH_EXTRA_FLAGS_AGING. The time is in any unit chosen by the
+ * application, and must not go backwards. The entries added, updated or
+ * found by a lookup store this time as their last access time; an entry
+ * already holding it is not written again, so the time is to be updated
+ * at a coarse granularity, e.g. once per second.
+ *
+ * @param h
+ *   Hash table with aging enabled.
+ * @param now
+ *   Current time.
+ */
+void __rte_experimental
+rte_hash_age_set_time(struct rte_hash *h, uint64_t now);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Scan some buckets of a hash table created with RTE_HASH_EXTRA_FLAGS_AGING,
+ * and return the keys not accessed since a given time. The scan resumes
+ * where the previous one stopped and wraps around the table, so that the
+ * whole table is swept by periodic calls with a small number of buckets.
+ * The scan stops early when the output arrays have no room for the keys of
+ * another bucket. The keys are not removed: the application deletes them,
+ * e.g. with rte_hash_del_key_bulk(), or they are returned again by the next
+ * sweep of the table.
+ * This operation is thread safe like a lookup, the returned key pointers
+ * remaining valid until the keys are deleted and their positions freed.
+ *
+ * @param h
+ *   Hash table with aging enabled.
+ * @param expiry
+ *   Keys with a last access time before this time are returned.
+ * @param next
+ *   Bucket to start from, 0 for the first call. It is updated with the
+ *   bucket to start the next call from.
+ * @param num_buckets
+ *   Maximum number of buckets to scan.
+ * @param keys
+ *   Output containing pointers to the expired keys, in the key table.
+ * @param positions
+ *   Output containing the positions of the expired keys, as returned by
+ *   rte_hash_add_key().
+ * @param max_keys
+ *   Size of the output arrays, at least 8, the number of entries of a
+ *   bucket.
+ * @return
+ *   -EINVAL if the table has no aging or the parameters are invalid,
+ *   otherwise the number of expired keys returned.
+ */
+int __rte_experimental
+rte_hash_age_scan(const struct rte_hash *h, uint64_t expiry, uint32_t *next,
+		uint32_t num_buckets, const void **keys, int32_t *positions,
+		uint32_t max_keys);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,6 +5,8 @@
 #ifndef _IP_FRAG_COMMON_H_
 #define _IP_FRAG_COMMON_H_
 
+#include <rte_spinlock.h>
+
 #include "rte_ip_frag.h"
 
 /* logging macros. */
@@ -31,6 +33,33 @@
 #define	IP_FRAG_TBL_STAT_UPDATE(s, f, v)	do {} while (0)
 #endif /* IP_FRAG_TBL_STAT */
 
+#ifdef RTE_LIBRTE_IP_FRAG_TBL_STAT
+#define	IP_FRAG_SHARED_TBL_STAT_UPDATE(s, f, v)	\
+	__atomic_fetch_add(&(s)->f, (v), __ATOMIC_RELAXED)
+#else
+#define	IP_FRAG_SHARED_TBL_STAT_UPDATE(s, f, v)	do {} while (0)
+#endif /* IP_FRAG_TBL_STAT */
+
+/**
+ * Fragmentation table shared by several lcores. It has the layout of the
+ * local table, without the LRU list, and a spinlock per bucket: an entry is
+ * only accessed with the lock of its bucket held.
+ */
+struct rte_ip_frag_shared_tbl {
+	uint64_t             max_cycles;      /**< ttl for table entries. */
+	uint32_t             entry_mask;      /**< hash value mask. */
+	uint32_t             max_entries;     /**< max entries allowed. */
+	uint32_t             use_entries;     /**< entries in use (atomic). */
+	uint32_t             bucket_entries;  /**< hash associativity. */
+	uint32_t             bucket_shift;    /**< log2 of bucket_entries. */
+	uint32_t             nb_entries;      /**< total size of the table. */
+	uint32_t             nb_buckets;      /**< num of associativity lines. */
+	uint32_t             expire_pos;      /**< next bucket to expire. */
+	rte_spinlock_t      *locks;           /**< one lock per bucket. */
+	struct ip_frag_tbl_stat stat;     /**< statistics counters. */
+	__extension__ struct ip_frag_pkt pkt[0]; /**< hash table. */
+};
+
 /* internal functions declarations */
 struct rte_mbuf * ip_frag_process(struct ip_frag_pkt *fp,
 		struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb,
@@ -44,6 +73,11 @@ struct ip_frag_pkt * ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 	const struct ip_frag_key *key, uint64_t tms,
 	struct ip_frag_pkt **free, struct ip_frag_pkt **stale);
 
+struct rte_mbuf *ip_frag_shared_process(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, const struct ip_frag_key *key,
+	struct rte_mbuf *mb, uint64_t tms, uint16_t ofs, uint16_t len,
+	uint16_t more_frags);
+
 /* these functions need to be declared here as ip_frag_process relies on them */
 struct rte_mbuf *ipv4_frag_reassemble(struct ip_frag_pkt *fp);
 struct rte_mbuf *ipv6_frag_reassemble(struct ip_frag_pkt *fp);
@@ -162,4 +196,15 @@ ip_frag_tbl_del(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 	IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, del_num, 1);
 }
 
+/*
+ * Make room on the death row for the mbufs a fragment may release:
+ * the fragments of a reused entry and the fragment itself.
+ */
+static inline void
+ip_frag_dr_reserve(struct rte_ip_frag_death_row *dr)
+{
+	if (IP_FRAG_DEATH_ROW_MBUF_LEN - dr->cnt < IP_MAX_FRAG_NUM + 1)
+		rte_ip_frag_free_death_row(dr, 0);
+}
+
 #endif /* _IP_FRAG_COMMON_H_ */
@@ -367,3 +367,150 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 	*stale = old;
 	return NULL;
 }
+
+/* lock the two buckets of a key, in bucket order to avoid deadlocks. */
+static inline void
+ip_frag_shared_lock(struct rte_ip_frag_shared_tbl *tbl, uint32_t b1,
+	uint32_t b2)
+{
+	rte_spinlock_lock(&tbl->locks[RTE_MIN(b1, b2)]);
+	if (b1 != b2)
+		rte_spinlock_lock(&tbl->locks[RTE_MAX(b1, b2)]);
+}
+
+static inline void
+ip_frag_shared_unlock(struct rte_ip_frag_shared_tbl *tbl, uint32_t b1,
+	uint32_t b2)
+{
+	if (b1 != b2)
+		rte_spinlock_unlock(&tbl->locks[b2]);
+	rte_spinlock_unlock(&tbl->locks[b1]);
+}
+
+/*
+ * Find an entry in the two locked buckets of a shared table.
+ * If such entry is not present, then take an empty one, if the table
+ * limit allows it, or reuse a stale one.
+ */
+static struct ip_frag_pkt *
+ip_frag_shared_find(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, const struct ip_frag_key *key,
+	uint64_t tms, uint32_t b1, uint32_t b2)
+{
+	struct ip_frag_pkt *p1, *p2, *pkt, *empty, *old;
+	uint64_t max_cycles;
+	uint32_t i, assoc;
+
+	pkt = NULL;
+	empty = NULL;
+	old = NULL;
+
+	max_cycles = tbl->max_cycles;
+	assoc = tbl->bucket_entries;
+
+	p1 = tbl->pkt + (b1 << tbl->bucket_shift);
+	p2 = tbl->pkt + (b2 << tbl->bucket_shift);
+
+	IP_FRAG_SHARED_TBL_STAT_UPDATE(&tbl->stat, find_num, 1);
+
+	for (i = 0; i != assoc; i++) {
+		if (ip_frag_key_cmp(key, &p1[i].key) == 0) {
+			pkt = p1 + i;
+			break;
+		} else if (ip_frag_key_is_empty(&p1[i].key))
+			empty = (empty == NULL) ? (p1 + i) : empty;
+		else if (max_cycles + p1[i].start < tms)
+			old = (old == NULL) ? (p1 + i) : old;
+
+		if (ip_frag_key_cmp(key, &p2[i].key) == 0) {
+			pkt = p2 + i;
+			break;
+		} else if (ip_frag_key_is_empty(&p2[i].key))
+			empty = (empty == NULL) ? (p2 + i) : empty;
+		else if (max_cycles + p2[i].start < tms)
+			old = (old == NULL) ? (p2 + i) : old;
+	}
+
+	/*
+	 * we found the flow, but it is already timed out,
+	 * so free associated resources and reuse it.
+	 */
+	if (pkt != NULL) {
+		if (max_cycles + pkt->start < tms) {
+			ip_frag_free(pkt, dr);
+			ip_frag_reset(pkt, tms);
+			IP_FRAG_SHARED_TBL_STAT_UPDATE(&tbl->stat, reuse_num, 1);
+		}
+		return pkt;
+	}
+
+	/* timed-out entry, free it and store the new key in it. */
+	if (old != NULL) {
+		ip_frag_free(old, dr);
+		IP_FRAG_SHARED_TBL_STAT_UPDATE(&tbl->stat, del_num, 1);
+		pkt = old;
+
+	/* empty entry, check that the table is not full. */
+	} else if (empty != NULL) {
+		if (__atomic_add_fetch(&tbl->use_entries, 1,
+				__ATOMIC_RELAXED) <= tbl->max_entries)
+			pkt = empty;
+		else {
+			__atomic_sub_fetch(&tbl->use_entries, 1,
+				__ATOMIC_RELAXED);
+			IP_FRAG_SHARED_TBL_STAT_UPDATE(&tbl->stat,
+				fail_nospace, 1);
+		}
+	}
+
+	if (pkt != NULL) {
+		pkt->key = key[0];
+		ip_frag_reset(pkt, tms);
+		IP_FRAG_SHARED_TBL_STAT_UPDATE(&tbl->stat, add_num, 1);
+	} else
+		IP_FRAG_SHARED_TBL_STAT_UPDATE(&tbl->stat, fail_total, 1);
+
+	return pkt;
+}
+
+/*
+ * Add a fragment to the entry of its datagram in a shared table, and
+ * reassemble the datagram once complete. Only the two buckets the key
+ * hashes to are locked meanwhile.
+ */
+struct rte_mbuf *
+ip_frag_shared_process(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, const struct ip_frag_key *key,
+	struct rte_mbuf *mb, uint64_t tms, uint16_t ofs, uint16_t len,
+	uint16_t more_frags)
+{
+	struct ip_frag_pkt *fp;
+	uint32_t b1, b2, sig1, sig2;
+
+	/* different hashing methods for IPv4 and IPv6 */
+	if (key->key_len == IPV4_KEYLEN)
+		ipv4_frag_hash(key, &sig1, &sig2);
+	else
+		ipv6_frag_hash(key, &sig1, &sig2);
+
+	b1 = (sig1 & tbl->entry_mask) >> tbl->bucket_shift;
+	b2 = (sig2 & tbl->entry_mask) >> tbl->bucket_shift;
+
+	ip_frag_shared_lock(tbl, b1, b2);
+
+	fp = ip_frag_shared_find(tbl, dr, key, tms, b1, b2);
+	if (fp == NULL) {
+		IP_FRAG_MBUF2DR(dr, mb);
+		mb = NULL;
+	} else {
+		mb = ip_frag_process(fp, dr, mb, ofs, len, more_frags);
+		/* the entry is released once reassembled or invalid. */
+		if (ip_frag_key_is_empty(&fp->key))
+			__atomic_sub_fetch(&tbl->use_entries, 1,
+				__ATOMIC_RELAXED);
+	}
+
+	ip_frag_shared_unlock(tbl, b1, b2);
+
+	return mb;
+}
@@ -110,6 +110,12 @@ struct rte_ip_frag_tbl {
 	__extension__ struct ip_frag_pkt pkt[0]; /**< hash table. */
 };
 
+/**
+ * Fragmentation table shared by several lcores, so that the fragments of a
+ * datagram may be processed by any of them.
+ */
+struct rte_ip_frag_shared_tbl;
+
 /** IPv6 fragment extension header */
 #define	RTE_IPV6_EHDR_MF_SHIFT			0
 #define	RTE_IPV6_EHDR_MF_MASK			1
@@ -350,6 +356,152 @@ void __rte_experimental
 rte_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
 	struct rte_ip_frag_death_row *dr, uint64_t tms);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a new IP fragmentation table shared by several lcores.
+ *
+ * The lookups and updates of the table are multi-thread safe: each lcore
+ * only locks the two buckets the datagram hashes to, so that lcores
+ * reassembling different datagrams seldom contend. Each lcore passes its
+ * own death row to the table functions.
+ * Unlike the local table, the shared table has no LRU list: when no entry
+ * is free in the buckets of a datagram, an expired entry of these buckets
+ * is reused.
+ *
+ * @param bucket_num
+ *   Number of buckets in the hash table.
+ * @param bucket_entries
+ *   Number of entries per bucket (e.g. hash associativity).
+ *   Should be power of two.
+ * @param max_entries
+ *   Maximum number of entries that could be stored in the table.
+ *   The value should be less or equal then bucket_num * bucket_entries.
+ * @param max_cycles
+ *   Maximum TTL in cycles for each fragmented packet.
+ * @param socket_id
+ *   The *socket_id* argument is the socket identifier in the case of
+ *   NUMA. The value can be *SOCKET_ID_ANY* if there is no NUMA constraints.
+ * @return
+ *   The pointer to the new allocated fragmentation table, on success. NULL on error.
+ */
+struct rte_ip_frag_shared_tbl * __rte_experimental
+rte_ip_frag_shared_table_create(uint32_t bucket_num,
+		uint32_t bucket_entries, uint32_t max_entries,
+		uint64_t max_cycles, int socket_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free allocated shared IP fragmentation table, and the fragments it holds.
+ * No lcore may use the table anymore.
+ *
+ * @param tbl
+ *   Fragmentation table to free.
+ */
+void __rte_experimental
+rte_ip_frag_shared_table_destroy(struct rte_ip_frag_shared_tbl *tbl);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Reassemble a burst of IPv4 packets with a shared fragmentation table.
+ * Incoming mbufs should have their l2_len/l3_len fields setup correctly.
+ *
+ * The fragments of a datagram may be processed by different lcores: the
+ * lcore adding its last missing fragment returns the reassembled packet.
+ * The packets that are not fragmented are returned as is.
+ * Mbufs released by the table are put on the death row, which is emptied
+ * by the function whenever it runs short of space.
+ *
+ * @param tbl
+ *   Shared table where to lookup/add the fragmented packets.
+ * @param dr
+ *   Death row of the calling lcore to free buffers to.
+ * @param mbufs
+ *   Incoming mbufs with IPv4 packets.
+ * @param nb_pkts
+ *   Number of incoming mbufs.
+ * @param tms
+ *   Fragments arrival timestamp.
+ * @param out
+ *   Array of at least nb_pkts mbufs, for the reassembled and not fragmented
+ *   packets, in arrival order. May be the *mbufs* array.
+ * @return
+ *   Number of packets stored in *out*.
+ */
+uint16_t __rte_experimental
+rte_ipv4_frag_reassemble_burst(struct rte_ip_frag_shared_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, struct rte_mbuf **mbufs,
+		uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **out);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Reassemble a burst of IPv6 packets with a shared fragmentation table.
+ * Incoming mbufs should have their l2_len/l3_len fields setup correctly.
+ * @see rte_ipv4_frag_reassemble_burst()
+ *
+ * @param tbl
+ *   Shared table where to lookup/add the fragmented packets.
+ * @param dr
+ *   Death row of the calling lcore to free buffers to.
+ * @param mbufs
+ *   Incoming mbufs with IPv6 packets.
+ * @param nb_pkts
+ *   Number of incoming mbufs.
+ * @param tms
+ *   Fragments arrival timestamp.
+ * @param out
+ *   Array of at least nb_pkts mbufs, for the reassembled and not fragmented
+ *   packets, in arrival order. May be the *mbufs* array.
+ * @return
+ *   Number of packets stored in *out*.
+ */
+uint16_t __rte_experimental
+rte_ipv6_frag_reassemble_burst(struct rte_ip_frag_shared_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, struct rte_mbuf **mbufs,
+		uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **out);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dump shared fragmentation table statistics to file.
+ *
+ * @param f
+ *   File to dump statistics to
+ * @param tbl
+ *   Shared fragmentation table to dump statistics from
+ */
+void __rte_experimental
+rte_ip_frag_shared_table_statistics_dump(FILE *f,
+		const struct rte_ip_frag_shared_tbl *tbl);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete expired fragments of a shared table. Each call resumes the scan
+ * of the table where the previous one stopped, because the death row ran
+ * short of space. Buckets in use by other lcores are skipped.
+ *
+ * @param tbl
+ *   Shared table to delete expired fragments from
+ * @param dr
+ *   Death row to free buffers to
+ * @param tms
+ *   Current timestamp
+ */
+void __rte_experimental
+rte_ip_frag_shared_table_del_expired_entries(
+		struct rte_ip_frag_shared_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, uint64_t tms);
+
 #ifdef __cplusplus
 }
 #endif
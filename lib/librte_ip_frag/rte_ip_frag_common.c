@@ -93,14 +93,14 @@ rte_ip_frag_table_destroy(struct rte_ip_frag_tbl *tbl)
 	rte_free(tbl);
 }
 
-/* dump frag table statistics to file */
-void
-rte_ip_frag_table_statistics_dump(FILE *f, const struct rte_ip_frag_tbl *tbl)
+static void
+ip_frag_tbl_stat_dump(FILE *f, uint32_t max_entries, uint32_t use_entries,
+	const struct ip_frag_tbl_stat *stat)
 {
 	uint64_t fail_total, fail_nospace;
 
-	fail_total = tbl->stat.fail_total;
-	fail_nospace = tbl->stat.fail_nospace;
+	fail_total = stat->fail_total;
+	fail_nospace = stat->fail_nospace;
 
 	fprintf(f, "max entries:\t%u;\n"
 		"entries in use:\t%u;\n"
@@ -111,17 +111,25 @@ rte_ip_frag_table_statistics_dump(FILE *f, const struct rte_ip_frag_tbl *tbl)
 		"total add failures:\t%" PRIu64 ";\n"
 		"add no-space failures:\t%" PRIu64 ";\n"
 		"add hash-collisions failures:\t%" PRIu64 ";\n",
-		tbl->max_entries,
-		tbl->use_entries,
-		tbl->stat.find_num,
-		tbl->stat.add_num,
-		tbl->stat.del_num,
-		tbl->stat.reuse_num,
+		max_entries,
+		use_entries,
+		stat->find_num,
+		stat->add_num,
+		stat->del_num,
+		stat->reuse_num,
 		fail_total,
 		fail_nospace,
 		fail_total - fail_nospace);
 }
 
+/* dump frag table statistics to file */
+void
+rte_ip_frag_table_statistics_dump(FILE *f, const struct rte_ip_frag_tbl *tbl)
+{
+	ip_frag_tbl_stat_dump(f, tbl->max_entries, tbl->use_entries,
+		&tbl->stat);
+}
+
 /* Delete expired fragments */
 void __rte_experimental
 rte_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
@@ -142,3 +150,129 @@ rte_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
 		} else
 			return;
 }
+
+/* create shared fragmentation table */
+struct rte_ip_frag_shared_tbl * __rte_experimental
+rte_ip_frag_shared_table_create(uint32_t bucket_num, uint32_t bucket_entries,
+	uint32_t max_entries, uint64_t max_cycles, int socket_id)
+{
+	struct rte_ip_frag_shared_tbl *tbl;
+	size_t sz, lock_ofs;
+	uint64_t nb_entries;
+	uint32_t i, nb_locks;
+
+	nb_entries = rte_align32pow2(bucket_num);
+	nb_entries *= bucket_entries;
+	nb_entries *= IP_FRAG_HASH_FNUM;
+
+	/* check input parameters. */
+	if (rte_is_power_of_2(bucket_entries) == 0 ||
+			nb_entries > UINT32_MAX || nb_entries == 0 ||
+			nb_entries < max_entries) {
+		RTE_LOG(ERR, USER1, "%s: invalid input parameter\n", __func__);
+		return NULL;
+	}
+
+	nb_locks = nb_entries / bucket_entries;
+	lock_ofs = sizeof(*tbl) + nb_entries * sizeof(tbl->pkt[0]);
+	sz = lock_ofs + nb_locks * sizeof(tbl->locks[0]);
+	tbl = rte_zmalloc_socket(__func__, sz, RTE_CACHE_LINE_SIZE, socket_id);
+	if (tbl == NULL) {
+		RTE_LOG(ERR, USER1,
+			"%s: allocation of %zu bytes at socket %d failed do\n",
+			__func__, sz, socket_id);
+		return NULL;
+	}
+
+	RTE_LOG(INFO, USER1, "%s: allocated of %zu bytes at socket %d\n",
+		__func__, sz, socket_id);
+
+	tbl->max_cycles = max_cycles;
+	tbl->max_entries = max_entries;
+	tbl->nb_entries = (uint32_t)nb_entries;
+	tbl->nb_buckets = bucket_num;
+	tbl->bucket_entries = bucket_entries;
+	tbl->bucket_shift = rte_bsf32(bucket_entries);
+	tbl->entry_mask = (tbl->nb_entries - 1) & ~(tbl->bucket_entries  - 1);
+
+	tbl->locks = (rte_spinlock_t *)((uintptr_t)tbl + lock_ofs);
+	for (i = 0; i != nb_locks; i++)
+		rte_spinlock_init(&tbl->locks[i]);
+
+	return tbl;
+}
+
+/* delete shared fragmentation table */
+void __rte_experimental
+rte_ip_frag_shared_table_destroy(struct rte_ip_frag_shared_tbl *tbl)
+{
+	uint32_t i;
+
+	if (tbl == NULL)
+		return;
+
+	for (i = 0; i != tbl->nb_entries; i++)
+		if (!ip_frag_key_is_empty(&tbl->pkt[i].key))
+			ip_frag_free_immediate(&tbl->pkt[i]);
+
+	rte_free(tbl);
+}
+
+/* dump shared frag table statistics to file */
+void __rte_experimental
+rte_ip_frag_shared_table_statistics_dump(FILE *f,
+	const struct rte_ip_frag_shared_tbl *tbl)
+{
+	ip_frag_tbl_stat_dump(f, tbl->max_entries,
+		__atomic_load_n(&tbl->use_entries, __ATOMIC_RELAXED),
+		&tbl->stat);
+}
+
+/*
+ * Delete expired fragments of a shared table, resuming the scan of the
+ * buckets where the previous call stopped. Buckets locked by other
+ * lcores are skipped until the next scan.
+ */
+void __rte_experimental
+rte_ip_frag_shared_table_del_expired_entries(
+	struct rte_ip_frag_shared_tbl *tbl, struct rte_ip_frag_death_row *dr,
+	uint64_t tms)
+{
+	struct ip_frag_pkt *fp;
+	uint64_t max_cycles;
+	uint32_t b, i, j, nb_locks, pos;
+
+	max_cycles = tbl->max_cycles;
+	nb_locks = tbl->nb_entries >> tbl->bucket_shift;
+	pos = __atomic_load_n(&tbl->expire_pos, __ATOMIC_RELAXED);
+
+	for (i = 0; i != nb_locks; i++) {
+		/* check that death row has enough space */
+		if (IP_FRAG_DEATH_ROW_MBUF_LEN - dr->cnt < IP_MAX_FRAG_NUM)
+			break;
+
+		b = (pos + i) & (nb_locks - 1);
+		if (rte_spinlock_trylock(&tbl->locks[b]) == 0)
+			continue;
+
+		fp = tbl->pkt + (b << tbl->bucket_shift);
+		for (j = 0; j != tbl->bucket_entries; j++) {
+			if (ip_frag_key_is_empty(&fp[j].key) ||
+					max_cycles + fp[j].start >= tms ||
+					IP_FRAG_DEATH_ROW_MBUF_LEN - dr->cnt <
+					fp[j].last_idx)
+				continue;
+
+			ip_frag_free(&fp[j], dr);
+			ip_frag_key_invalidate(&fp[j].key);
+			__atomic_sub_fetch(&tbl->use_entries, 1,
+				__ATOMIC_RELAXED);
+			IP_FRAG_SHARED_TBL_STAT_UPDATE(&tbl->stat, del_num, 1);
+		}
+
+		rte_spinlock_unlock(&tbl->locks[b]);
+	}
+
+	__atomic_store_n(&tbl->expire_pos, (pos + i) & (nb_locks - 1),
+		__ATOMIC_RELAXED);
+}
@@ -169,3 +169,67 @@ rte_ipv4_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 
 	return mb;
 }
+
+/*
+ * Process a burst of mbufs with IPV4 fragments, using a table shared
+ * with other lcores.
+ */
+uint16_t __rte_experimental
+rte_ipv4_frag_reassemble_burst(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf **mbufs,
+	uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **out)
+{
+	struct rte_mbuf *mb;
+	struct ipv4_hdr *ip_hdr;
+	struct ip_frag_key key;
+	const unaligned_uint64_t *psd;
+	uint16_t flag_offset, ip_ofs, ip_flag;
+	uint16_t i, nb_out;
+	int32_t ip_len;
+
+	nb_out = 0;
+
+	for (i = 0; i != nb_pkts; i++) {
+		mb = mbufs[i];
+		ip_hdr = rte_pktmbuf_mtod_offset(mb, struct ipv4_hdr *,
+			mb->l2_len);
+
+		if (i + 1 != nb_pkts)
+			rte_prefetch0(rte_pktmbuf_mtod_offset(mbufs[i + 1],
+				void *, mbufs[i + 1]->l2_len));
+
+		/* not fragmented, nothing to reassemble. */
+		if (!rte_ipv4_frag_pkt_is_fragmented(ip_hdr)) {
+			out[nb_out++] = mb;
+			continue;
+		}
+
+		ip_frag_dr_reserve(dr);
+
+		flag_offset = rte_be_to_cpu_16(ip_hdr->fragment_offset);
+		ip_ofs = (uint16_t)(flag_offset & IPV4_HDR_OFFSET_MASK);
+		ip_flag = (uint16_t)(flag_offset & IPV4_HDR_MF_FLAG);
+
+		psd = (unaligned_uint64_t *)&ip_hdr->src_addr;
+		/* use first 8 bytes only */
+		key.src_dst[0] = psd[0];
+		key.id = ip_hdr->packet_id;
+		key.key_len = IPV4_KEYLEN;
+
+		ip_ofs *= IPV4_HDR_OFFSET_UNITS;
+		ip_len = rte_be_to_cpu_16(ip_hdr->total_length) - mb->l3_len;
+
+		/* check that fragment length is greater then zero. */
+		if (ip_len <= 0) {
+			IP_FRAG_MBUF2DR(dr, mb);
+			continue;
+		}
+
+		mb = ip_frag_shared_process(tbl, dr, &key, mb, tms, ip_ofs,
+			ip_len, ip_flag);
+		if (mb != NULL)
+			out[nb_out++] = mb;
+	}
+
+	return nb_out;
+}
@@ -214,3 +214,66 @@ rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 
 	return mb;
 }
+
+/*
+ * Process a burst of mbufs with IPV6 fragments, using a table shared
+ * with other lcores.
+ */
+uint16_t __rte_experimental
+rte_ipv6_frag_reassemble_burst(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf **mbufs,
+	uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **out)
+{
+	struct rte_mbuf *mb;
+	struct ipv6_hdr *ip_hdr;
+	struct ipv6_extension_fragment *frag_hdr;
+	struct ip_frag_key key;
+	uint16_t i, ip_ofs, nb_out;
+	int32_t ip_len;
+
+	nb_out = 0;
+
+	for (i = 0; i != nb_pkts; i++) {
+		mb = mbufs[i];
+		ip_hdr = rte_pktmbuf_mtod_offset(mb, struct ipv6_hdr *,
+			mb->l2_len);
+
+		if (i + 1 != nb_pkts)
+			rte_prefetch0(rte_pktmbuf_mtod_offset(mbufs[i + 1],
+				void *, mbufs[i + 1]->l2_len));
+
+		/* not fragmented, nothing to reassemble. */
+		frag_hdr = rte_ipv6_frag_get_ipv6_fragment_header(ip_hdr);
+		if (frag_hdr == NULL) {
+			out[nb_out++] = mb;
+			continue;
+		}
+
+		ip_frag_dr_reserve(dr);
+
+		rte_memcpy(&key.src_dst[0], ip_hdr->src_addr, 16);
+		rte_memcpy(&key.src_dst[2], ip_hdr->dst_addr, 16);
+
+		key.id = frag_hdr->id;
+		key.key_len = IPV6_KEYLEN;
+
+		ip_ofs = FRAG_OFFSET(frag_hdr->frag_data) * 8;
+
+		/* frag header is the only extension header supported. */
+		ip_len = rte_be_to_cpu_16(ip_hdr->payload_len) -
+			sizeof(*frag_hdr);
+
+		/* check that fragment length is greater then zero. */
+		if (ip_len <= 0) {
+			IP_FRAG_MBUF2DR(dr, mb);
+			continue;
+		}
+
+		mb = ip_frag_shared_process(tbl, dr, &key, mb, tms, ip_ofs,
+			ip_len, MORE_FRAGS(frag_hdr->frag_data));
+		if (mb != NULL)
+			out[nb_out++] = mb;
+	}
+
+	return nb_out;
+}
@@ -11,6 +11,7 @@
 #include <rte_eal.h>
 #include <rte_log.h>
 #include <rte_cycles.h>
+#include <rte_lcore.h>
 #include <rte_branch_prediction.h>
 
 #include "rte_jobstats.h"
@@ -37,6 +38,25 @@ get_time(void)
 	return rte_get_timer_cycles();
 }
 
+/* Contexts and jobs registered for the monitoring threads, per lcore. */
+static struct {
+	struct rte_jobstats_context *ctx;
+	struct rte_jobstats *jobs[RTE_JOBSTATS_MAX_JOBS];
+	unsigned int nb_jobs;
+} registry[RTE_MAX_LCORE];
+
+/* Histogram bucket of an execute time, log2 of the cycles. */
+static inline unsigned int
+hist_bucket(uint64_t cycles)
+{
+	unsigned int b;
+
+	if (cycles < 2)
+		return 0;
+	b = 63 - __builtin_clzll(cycles);
+	return RTE_MIN(b, RTE_JOBSTATS_HIST_BUCKETS - 1U);
+}
+
 /* Those are steps used to adjust job period.
  * Experiments show that for forwarding apps the up step must be less than down
  * step to achieve optimal performance.
@@ -113,6 +133,32 @@ rte_jobstats_context_reset(struct rte_jobstats_context *ctx)
 	ctx->state_time = ctx->start_time;
 	ctx->job_exec_cnt = 0;
 	ctx->loop_cnt = 0;
+	ctx->period_start = ctx->start_time;
+	ctx->period_exec_time = 0;
+	ctx->period_idle_time = 0;
+}
+
+uint64_t __rte_experimental
+rte_jobstats_context_load(struct rte_jobstats_context *ctx,
+		const struct rte_jobstats *idle_job)
+{
+	uint64_t now = get_time();
+	uint64_t elapsed = now - ctx->period_start;
+	uint64_t exec = ctx->exec_time - ctx->period_exec_time;
+	uint64_t idle = 0;
+
+	if (idle_job != NULL) {
+		idle = idle_job->exec_time - ctx->period_idle_time;
+		ctx->period_idle_time = idle_job->exec_time;
+	}
+
+	if (elapsed != 0)
+		ctx->load = RTE_MIN((exec - RTE_MIN(idle, exec)) * 1000 /
+				elapsed, (uint64_t)1000);
+	ctx->period_start = now;
+	ctx->period_exec_time = ctx->exec_time;
+
+	return ctx->load;
 }
 
 void
@@ -184,6 +230,8 @@ rte_jobstats_finish(struct rte_jobstats *job, int64_t job_value)
 	exec_time = now - ctx->state_time;
 	ADD_TIME_MIN_MAX(job, exec, exec_time);
 	ADD_TIME_MIN_MAX(ctx, exec, exec_time);
+	if (job->hist != NULL)
+		job->hist->count[hist_bucket(exec_time)]++;
 
 	ctx->state_time = now;
 
@@ -239,6 +287,7 @@ rte_jobstats_init(struct rte_jobstats *job, const char *name,
 	job->max_period = max_period;
 	job->target = target;
 	job->update_period_cb = &default_update_function;
+	job->hist = NULL;
 	rte_jobstats_reset(job);
 	snprintf(job->name, RTE_DIM(job->name), "%s", name == NULL ? "" : name);
 	job->context = NULL;
@@ -261,4 +310,66 @@ rte_jobstats_reset(struct rte_jobstats *job)
 {
 	RESET_TIME_MIN_MAX(job, exec);
 	job->exec_cnt = 0;
+	if (job->hist != NULL)
+		memset(job->hist, 0, sizeof(*job->hist));
+}
+
+void __rte_experimental
+rte_jobstats_set_histogram(struct rte_jobstats *job,
+		struct rte_jobstats_hist *hist)
+{
+	job->hist = hist;
+	if (hist != NULL)
+		memset(hist, 0, sizeof(*hist));
+}
+
+int __rte_experimental
+rte_jobstats_context_register(struct rte_jobstats_context *ctx,
+		unsigned int lcore_id)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	registry[lcore_id].nb_jobs = 0;
+	registry[lcore_id].ctx = ctx;
+
+	return 0;
+}
+
+int __rte_experimental
+rte_jobstats_register(struct rte_jobstats *job, unsigned int lcore_id)
+{
+	unsigned int n;
+
+	if (job == NULL || lcore_id >= RTE_MAX_LCORE ||
+			registry[lcore_id].ctx == NULL)
+		return -EINVAL;
+
+	n = registry[lcore_id].nb_jobs;
+	if (n == RTE_JOBSTATS_MAX_JOBS)
+		return -ENOSPC;
+
+	registry[lcore_id].jobs[n] = job;
+	registry[lcore_id].nb_jobs = n + 1;
+
+	return 0;
+}
+
+struct rte_jobstats_context * __rte_experimental
+rte_jobstats_context_lookup(unsigned int lcore_id, struct rte_jobstats **jobs,
+		unsigned int *nb_jobs)
+{
+	unsigned int i, n;
+
+	if (lcore_id >= RTE_MAX_LCORE || registry[lcore_id].ctx == NULL) {
+		*nb_jobs = 0;
+		return NULL;
+	}
+
+	n = RTE_MIN(*nb_jobs, registry[lcore_id].nb_jobs);
+	for (i = 0; i < n; i++)
+		jobs[i] = registry[lcore_id].jobs[i];
+	*nb_jobs = n;
+
+	return registry[lcore_id].ctx;
 }
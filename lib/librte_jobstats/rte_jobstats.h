@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+#include <rte_compat.h>
 #include <rte_memory.h>
 #include <rte_memcpy.h>
 
@@ -16,6 +17,12 @@ extern "C" {
 
 #define RTE_JOBSTATS_NAMESIZE 32
 
+/** Number of buckets of a job execute time histogram. */
+#define RTE_JOBSTATS_HIST_BUCKETS 32
+
+/** Maximum number of jobs registered per lcore. */
+#define RTE_JOBSTATS_MAX_JOBS 32
+
 /* Forward declarations. */
 struct rte_jobstats_context;
 struct rte_jobstats;
@@ -33,6 +40,16 @@ struct rte_jobstats;
 typedef void (*rte_job_update_period_cb_t)(struct rte_jobstats *job,
 		int64_t job_result);
 
+/**
+ * Histogram of the execute times of a job. Bucket 0 counts the executions
+ * shorter than 2 cycles, bucket i > 0 the ones in [2^i, 2^(i+1)) cycles,
+ * the last bucket also counts all the longer executions.
+ */
+struct rte_jobstats_hist {
+	uint64_t count[RTE_JOBSTATS_HIST_BUCKETS];
+	/**< Execute count per bucket. */
+};
+
 struct rte_jobstats {
 	uint64_t period;
 	/**< Estimated period of execution. */
@@ -66,6 +83,9 @@ struct rte_jobstats {
 
 	struct rte_jobstats_context *context;
 	/**< Job stats context object that is executing this job. */
+
+	struct rte_jobstats_hist *hist;
+	/**< Optional execute time histogram. */
 } __rte_cache_aligned;
 
 struct rte_jobstats_context {
@@ -112,6 +132,18 @@ struct rte_jobstats_context {
 
 	uint64_t loop_cnt;
 	/**< Total count of executed loops with at least one executed job. */
+
+	uint64_t period_start;
+	/**< Start time of the current load period. */
+
+	uint64_t period_exec_time;
+	/**< Execute time at the start of the current load period. */
+
+	uint64_t period_idle_time;
+	/**< Idle job execute time at the start of the current load period. */
+
+	uint64_t load;
+	/**< Load of the last period, see rte_jobstats_context_load(). */
 } __rte_cache_aligned;
 
 /**
@@ -300,6 +332,104 @@ rte_jobstats_set_update_period_function(struct rte_jobstats *job,
 void
 rte_jobstats_reset(struct rte_jobstats *job);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Set the histogram in which the execute times of *job* are counted. The
+ * histogram is cleared, and it is cleared again by rte_jobstats_reset().
+ *
+ * @param job
+ *  Job object.
+ * @param hist
+ *  Histogram owned by the application, or NULL to stop counting.
+ */
+void __rte_experimental
+rte_jobstats_set_histogram(struct rte_jobstats *job,
+		struct rte_jobstats_hist *hist);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Compute the load of *ctx* since the previous call, or since the last reset
+ * of its statistics, and start a new load period. The load is also stored
+ * in the *load* field of *ctx*.
+ *
+ * The execute time of *idle_job*, a job polling for work, is not part of
+ * the load. Its statistics must be reset along with the ones of *ctx*.
+ *
+ * @param ctx
+ *  Job stats context.
+ * @param idle_job
+ *  Idle job executed in *ctx*, or NULL if there is none.
+ * @return
+ *  Share of the period spent executing jobs, in per mille.
+ */
+uint64_t __rte_experimental
+rte_jobstats_context_load(struct rte_jobstats_context *ctx,
+		const struct rte_jobstats *idle_job);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Register the job stats context executing the jobs of an lcore, so that
+ * its statistics can be looked up by a monitoring thread, e.g. telemetry.
+ * The jobs previously registered for this lcore are unregistered.
+ *
+ * @param ctx
+ *  Job stats context, or NULL to unregister the context of the lcore.
+ * @param lcore_id
+ *  Lcore executing the jobs of *ctx*.
+ * @return
+ *  0 on success
+ *  -EINVAL if *lcore_id* is invalid
+ */
+int __rte_experimental
+rte_jobstats_context_register(struct rte_jobstats_context *ctx,
+		unsigned int lcore_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Register a job executed in the context registered for an lcore.
+ *
+ * @param job
+ *  Job object.
+ * @param lcore_id
+ *  Lcore executing *job*.
+ * @return
+ *  0 on success
+ *  -EINVAL if *job* is NULL or no context is registered for *lcore_id*
+ *  -ENOSPC if RTE_JOBSTATS_MAX_JOBS jobs are already registered
+ */
+int __rte_experimental
+rte_jobstats_register(struct rte_jobstats *job, unsigned int lcore_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Look up the context and the jobs registered for an lcore.
+ *
+ * The objects are updated by their lcore without synchronization, so the
+ * statistics read through them may be slightly inconsistent.
+ *
+ * @param lcore_id
+ *  Lcore to look up.
+ * @param jobs
+ *  Array filled with the registered jobs, may be NULL if *nb_jobs* is 0.
+ * @param nb_jobs
+ *  Size of *jobs* on input, number of jobs stored in *jobs* on output.
+ * @return
+ *  The registered context, or NULL if there is none.
+ */
+struct rte_jobstats_context * __rte_experimental
+rte_jobstats_context_lookup(unsigned int lcore_id, struct rte_jobstats **jobs,
+		unsigned int *nb_jobs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,7 +24,7 @@
 #include <exec-env/rte_kni_common.h>
 #include "rte_kni_fifo.h"
 
-#define MAX_MBUF_BURST_NUM            32
+#define MAX_MBUF_BURST_NUM            64
 
 /* Maximum number of ring entries */
 #define KNI_FIFO_COUNT_MAX     1024
@@ -575,11 +575,19 @@ rte_kni_rx_burst(struct rte_kni *kni, struct rte_mbuf **mbufs, unsigned num)
 static void
 kni_free_mbufs(struct rte_kni *kni)
 {
-	int i, ret;
+	int i, ret, n;
 	struct rte_mbuf *pkts[MAX_MBUF_BURST_NUM];
 
-	ret = kni_fifo_get(kni->free_q, (void **)pkts, MAX_MBUF_BURST_NUM);
-	if (likely(ret > 0)) {
+	/*
+	 * Drain free_q by bursts, as the kernel may have consumed several
+	 * bursts since the previous call
+	 */
+	for (n = 0; n < KNI_FIFO_COUNT_MAX / MAX_MBUF_BURST_NUM; n++) {
+		ret = kni_fifo_get(kni->free_q, (void **)pkts,
+			MAX_MBUF_BURST_NUM);
+		if (ret == 0)
+			break;
+
 		for (i = 0; i < ret; i++)
 			rte_pktmbuf_free(pkts[i]);
 	}
@@ -614,21 +622,21 @@ kni_allocate_mbufs(struct rte_kni *kni)
 		return;
 	}
 
-	allocq_free = (kni->alloc_q->read - kni->alloc_q->write - 1) \
-			& (MAX_MBUF_BURST_NUM - 1);
-	for (i = 0; i < allocq_free; i++) {
-		pkts[i] = rte_pktmbuf_alloc(kni->pktmbuf_pool);
-		if (unlikely(pkts[i] == NULL)) {
-			/* Out of memory */
-			RTE_LOG(ERR, KNI, "Out of memory\n");
-			break;
-		}
-		phys[i] = va2pa(pkts[i]);
-	}
+	allocq_free = RTE_MIN(kni_fifo_free_count(kni->alloc_q),
+			(uint32_t)MAX_MBUF_BURST_NUM);
+	if (allocq_free == 0)
+		return;
 
-	/* No pkt mbuf allocated */
-	if (i <= 0)
+	/* One access to the mempool for the whole burst */
+	if (unlikely(rte_pktmbuf_alloc_bulk(kni->pktmbuf_pool, pkts,
+			allocq_free) != 0)) {
+		/* Out of memory */
+		RTE_LOG(ERR, KNI, "Out of memory\n");
 		return;
+	}
+
+	for (i = 0; i < allocq_free; i++)
+		phys[i] = va2pa(pkts[i]);
 
 	ret = kni_fifo_put(kni->alloc_q, phys, i);
 
@@ -758,6 +766,28 @@ rte_kni_update_link(struct rte_kni *kni, unsigned int linkup)
 	return old_linkup;
 }
 
+int __rte_experimental
+rte_kni_update_affinity(struct rte_kni *kni, uint32_t core_id,
+		uint8_t force_bind)
+{
+	struct rte_kni_device_info dev_info;
+
+	if (kni == NULL)
+		return -1;
+
+	memset(&dev_info, 0, sizeof(dev_info));
+	snprintf(dev_info.name, sizeof(dev_info.name), "%s", kni->name);
+	dev_info.core_id = core_id;
+	dev_info.force_bind = force_bind ? 1 : 0;
+
+	if (ioctl(kni_fd, RTE_KNI_IOCTL_AFFINITY, &dev_info) < 0) {
+		RTE_LOG(ERR, KNI, "Fail to update affinity of kni device\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 void
 rte_kni_close(void)
 {
@@ -252,6 +252,31 @@ int rte_kni_unregister_handlers(struct rte_kni *kni);
 int __rte_experimental
 rte_kni_update_link(struct rte_kni *kni, unsigned int linkup);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Update the CPU affinity of the kernel thread of a KNI interface.
+ *
+ * In the single kernel thread mode of the KNI module, the thread serves all
+ * the KNI interfaces, which all follow the new affinity. When the module
+ * gives the packets to the kernel in NAPI mode, the stack processes them on
+ * the CPU of the thread.
+ *
+ * @param kni
+ *  pointer to struct rte_kni.
+ * @param core_id
+ *  CPU to run the kernel thread on, when force_bind is set.
+ * @param force_bind
+ *  0 to let the kernel thread run on any CPU, non-zero to bind it to core_id.
+ *
+ * @return
+ *  0 on success, -1 on failure.
+ */
+int __rte_experimental
+rte_kni_update_affinity(struct rte_kni *kni, uint32_t core_id,
+		uint8_t force_bind);
+
 /**
  *  Close KNI device.
  */
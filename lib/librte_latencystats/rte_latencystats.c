@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 
 #include <rte_mbuf.h>
@@ -31,10 +32,11 @@ latencystat_cycles_per_ns(void)
 #define RTE_LOGTYPE_LATENCY_STATS RTE_LOGTYPE_USER1
 
 static const char *MZ_RTE_LATENCY_STATS = "rte_latencystats";
+static const char *MZ_RTE_LATENCY_HIST = "rte_latencystats_hist";
 static int latency_stats_index;
+static int latency_pct_index;
 static uint64_t samp_intvl;
-static uint64_t timer_tsc;
-static uint64_t prev_tsc;
+static rte_latency_stats_flow_type_fn flow_type_cb;
 
 struct rte_latency_stats {
 	float min_latency; /**< Minimum latency in nano seconds */
@@ -45,8 +47,45 @@ struct rte_latency_stats {
 
 static struct rte_latency_stats *glob_stats;
 
+/*
+ * Log-linear histogram of the latencies in TSC cycles: the values below
+ * 2^LATENCY_HIST_SUB_BITS have a bucket each, then every power of two is
+ * split into 2^LATENCY_HIST_SUB_BITS buckets, bounding the relative error
+ * of a percentile to 1/2^LATENCY_HIST_SUB_BITS. Latencies of 2^36 cycles
+ * and more are recorded in the last bucket.
+ */
+#define LATENCY_HIST_SUB_BITS 4
+#define LATENCY_HIST_SUB_COUNT (1U << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_MAX_BIT 36
+#define LATENCY_HIST_BUCKETS \
+	((LATENCY_HIST_MAX_BIT - LATENCY_HIST_SUB_BITS + 1) * \
+	 LATENCY_HIST_SUB_COUNT)
+
+/*
+ * Histogram of a Tx queue. It is only written by the lcore transmitting on
+ * the queue, so it is updated without lock nor atomic operation, and the
+ * histograms of the queues are merged on read.
+ */
+struct latency_hist {
+	uint64_t count;
+	uint64_t buckets[LATENCY_HIST_BUCKETS];
+} __rte_cache_aligned;
+
+struct latency_hist_tbl {
+	uint64_t tsc_hz; /**< TSC frequency, for the secondary processes */
+	uint32_t nb_hists;
+	uint32_t first_hist[RTE_MAX_ETHPORTS];
+	uint16_t nb_queues[RTE_MAX_ETHPORTS];
+	struct latency_hist hists[] __rte_cache_aligned;
+};
+
+static struct latency_hist_tbl *hist_tbl;
+
 struct rxtx_cbs {
 	const struct rte_eth_rxtx_callback *cb;
+	uint64_t timer_tsc; /**< Rx: cycles elapsed since the last sample */
+	uint64_t prev_tsc; /**< Rx: TSC of the previous packet */
+	struct latency_hist *hist; /**< Tx: histogram of the queue */
 };
 
 static struct rxtx_cbs rx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
@@ -67,12 +106,134 @@ static const struct latency_stats_nameoff lat_stats_strings[] = {
 #define NUM_LATENCY_STATS (sizeof(lat_stats_strings) / \
 				sizeof(lat_stats_strings[0]))
 
+struct latency_pct_name {
+	char name[RTE_ETH_XSTATS_NAME_SIZE];
+	double pct;
+};
+
+/* Percentiles exported globally and per port through rte_metrics */
+static const struct latency_pct_name lat_pct_strings[] = {
+	{"p50_latency_ns", 50.0},
+	{"p90_latency_ns", 90.0},
+	{"p99_latency_ns", 99.0},
+	{"p999_latency_ns", 99.9},
+};
+
+#define NUM_LATENCY_PCT (sizeof(lat_pct_strings) / \
+				sizeof(lat_pct_strings[0]))
+
+#define NUM_LATENCY_ALL_STATS (NUM_LATENCY_STATS + NUM_LATENCY_PCT)
+
+static inline unsigned int
+latency_hist_bucket(uint64_t cycles)
+{
+	unsigned int msb;
+
+	if (cycles < LATENCY_HIST_SUB_COUNT)
+		return cycles;
+
+	msb = 63 - __builtin_clzll(cycles);
+	if (msb >= LATENCY_HIST_MAX_BIT)
+		return LATENCY_HIST_BUCKETS - 1;
+
+	return (msb - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_COUNT +
+		((cycles >> (msb - LATENCY_HIST_SUB_BITS)) &
+		 (LATENCY_HIST_SUB_COUNT - 1));
+}
+
+/* Highest latency in cycles recorded in a bucket */
+static inline uint64_t
+latency_hist_bucket_max(unsigned int idx)
+{
+	unsigned int shift;
+
+	if (idx < LATENCY_HIST_SUB_COUNT)
+		return idx;
+
+	shift = idx / LATENCY_HIST_SUB_COUNT - 1;
+	return (((uint64_t)LATENCY_HIST_SUB_COUNT +
+		 idx % LATENCY_HIST_SUB_COUNT + 1) << shift) - 1;
+}
+
+static struct latency_hist_tbl *
+latency_hist_tbl_get(void)
+{
+	const struct rte_memzone *mz;
+
+	if (hist_tbl == NULL &&
+			rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		mz = rte_memzone_lookup(MZ_RTE_LATENCY_HIST);
+		if (mz != NULL)
+			hist_tbl = mz->addr;
+	}
+
+	return hist_tbl;
+}
+
+/*
+ * Merge the histograms of the Tx queues [first, first + n) and compute
+ * the percentiles of the merged histogram, in nano seconds.
+ */
+static void
+latency_hist_percentiles(const struct latency_hist_tbl *tbl, uint32_t first,
+		uint32_t n, const double *pct, uint64_t *values,
+		unsigned int nb_pct)
+{
+	uint64_t buckets[LATENCY_HIST_BUCKETS] = {0};
+	uint64_t count = 0, sum, rank;
+	unsigned int i, j;
+
+	for (i = first; i < first + n; i++) {
+		const struct latency_hist *hist = &tbl->hists[i];
+
+		for (j = 0; j < LATENCY_HIST_BUCKETS; j++) {
+			buckets[j] += hist->buckets[j];
+			count += hist->buckets[j];
+		}
+	}
+
+	for (i = 0; i < nb_pct; i++) {
+		values[i] = 0;
+		if (count == 0)
+			continue;
+
+		rank = (uint64_t)ceil(pct[i] / 100.0 * count);
+		if (rank == 0)
+			rank = 1;
+		sum = 0;
+		for (j = 0; j < LATENCY_HIST_BUCKETS; j++) {
+			sum += buckets[j];
+			if (sum >= rank)
+				break;
+		}
+		if (j == LATENCY_HIST_BUCKETS)
+			j--;
+		values[i] = (uint64_t)((double)latency_hist_bucket_max(j) *
+				NS_PER_SEC / tbl->tsc_hz);
+	}
+}
+
+static void
+latency_pct_fill(const struct latency_hist_tbl *tbl, uint32_t first,
+		uint32_t n, uint64_t *values)
+{
+	double pct[NUM_LATENCY_PCT];
+	unsigned int i;
+
+	for (i = 0; i < NUM_LATENCY_PCT; i++)
+		pct[i] = lat_pct_strings[i].pct;
+
+	latency_hist_percentiles(tbl, first, n, pct, values, NUM_LATENCY_PCT);
+}
+
 int32_t
 rte_latencystats_update(void)
 {
 	unsigned int i;
 	float *stats_ptr = NULL;
 	uint64_t values[NUM_LATENCY_STATS] = {0};
+	uint64_t pct_values[NUM_LATENCY_PCT];
+	uint16_t pid;
 	int ret;
 
 	for (i = 0; i < NUM_LATENCY_STATS; i++) {
@@ -85,8 +246,35 @@ rte_latencystats_update(void)
 	ret = rte_metrics_update_values(RTE_METRICS_GLOBAL,
 					latency_stats_index,
 					values, NUM_LATENCY_STATS);
-	if (ret < 0)
+	if (ret < 0) {
 		RTE_LOG(INFO, LATENCY_STATS, "Failed to push the stats\n");
+		return ret;
+	}
+
+	if (hist_tbl == NULL)
+		return ret;
+
+	latency_pct_fill(hist_tbl, 0, hist_tbl->nb_hists, pct_values);
+	ret = rte_metrics_update_values(RTE_METRICS_GLOBAL, latency_pct_index,
+					pct_values, NUM_LATENCY_PCT);
+	if (ret < 0) {
+		RTE_LOG(INFO, LATENCY_STATS, "Failed to push the stats\n");
+		return ret;
+	}
+
+	for (pid = 0; pid < RTE_MAX_ETHPORTS; pid++) {
+		if (hist_tbl->nb_queues[pid] == 0)
+			continue;
+		latency_pct_fill(hist_tbl, hist_tbl->first_hist[pid],
+				hist_tbl->nb_queues[pid], pct_values);
+		ret = rte_metrics_update_values(pid, latency_pct_index,
+						pct_values, NUM_LATENCY_PCT);
+		if (ret < 0) {
+			RTE_LOG(INFO, LATENCY_STATS,
+				"Failed to push the stats of port %u\n", pid);
+			return ret;
+		}
+	}
 
 	return ret;
 }
@@ -96,6 +284,8 @@ rte_latencystats_fill_values(struct rte_metric_value *values)
 {
 	unsigned int i;
 	float *stats_ptr = NULL;
+	const struct latency_hist_tbl *tbl;
+	uint64_t pct_values[NUM_LATENCY_PCT] = {0};
 
 	for (i = 0; i < NUM_LATENCY_STATS; i++) {
 		stats_ptr = RTE_PTR_ADD(glob_stats,
@@ -104,6 +294,14 @@ rte_latencystats_fill_values(struct rte_metric_value *values)
 		values[i].value = (uint64_t)floor((*stats_ptr)/
 						latencystat_cycles_per_ns());
 	}
+
+	tbl = latency_hist_tbl_get();
+	if (tbl != NULL)
+		latency_pct_fill(tbl, 0, tbl->nb_hists, pct_values);
+	for (i = 0; i < NUM_LATENCY_PCT; i++) {
+		values[NUM_LATENCY_STATS + i].key = NUM_LATENCY_STATS + i;
+		values[NUM_LATENCY_STATS + i].value = pct_values[i];
+	}
 }
 
 static uint16_t
@@ -112,27 +310,31 @@ add_time_stamps(uint16_t pid __rte_unused,
 		struct rte_mbuf **pkts,
 		uint16_t nb_pkts,
 		uint16_t max_pkts __rte_unused,
-		void *user_cb __rte_unused)
+		void *user_param)
 {
+	struct rxtx_cbs *cbs = user_param;
 	unsigned int i;
 	uint64_t diff_tsc, now;
 
 	/*
 	 * For every sample interval,
-	 * time stamp is marked on one received packet.
+	 * time stamp is marked on one received packet of the queue,
+	 * of the flows selected by the user callback if any.
 	 */
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		diff_tsc = now - prev_tsc;
-		timer_tsc += diff_tsc;
+		diff_tsc = now - cbs->prev_tsc;
+		cbs->timer_tsc += diff_tsc;
 
 		if ((pkts[i]->ol_flags & PKT_RX_TIMESTAMP) == 0
-				&& (timer_tsc >= samp_intvl)) {
+				&& (cbs->timer_tsc >= samp_intvl)
+				&& (flow_type_cb == NULL ||
+				    flow_type_cb(pkts[i], NULL) != 0)) {
 			pkts[i]->timestamp = now;
 			pkts[i]->ol_flags |= PKT_RX_TIMESTAMP;
-			timer_tsc = 0;
+			cbs->timer_tsc = 0;
 		}
-		prev_tsc = now;
+		cbs->prev_tsc = now;
 		now = rte_rdtsc();
 	}
 
@@ -144,8 +346,9 @@ calc_latency(uint16_t pid __rte_unused,
 		uint16_t qid __rte_unused,
 		struct rte_mbuf **pkts,
 		uint16_t nb_pkts,
-		void *_ __rte_unused)
+		void *user_param)
 {
+	struct latency_hist *hist = ((struct rxtx_cbs *)user_param)->hist;
 	unsigned int i, cnt = 0;
 	uint64_t now;
 	float latency[nb_pkts];
@@ -159,8 +362,15 @@ calc_latency(uint16_t pid __rte_unused,
 
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		if (pkts[i]->ol_flags & PKT_RX_TIMESTAMP)
-			latency[cnt++] = now - pkts[i]->timestamp;
+		if (pkts[i]->ol_flags & PKT_RX_TIMESTAMP) {
+			uint64_t cycles = now - pkts[i]->timestamp;
+
+			latency[cnt++] = cycles;
+			if (hist != NULL) {
+				hist->buckets[latency_hist_bucket(cycles)]++;
+				hist->count++;
+			}
+		}
 	}
 
 	for (i = 0; i < cnt; i++) {
@@ -205,8 +415,10 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	uint16_t qid;
 	struct rxtx_cbs *cbs = NULL;
 	const char *ptr_strings[NUM_LATENCY_STATS] = {0};
+	const char *pct_strings[NUM_LATENCY_PCT] = {0};
 	const struct rte_memzone *mz = NULL;
 	const unsigned int flags = 0;
+	uint32_t nb_hists = 0;
 
 	if (rte_memzone_lookup(MZ_RTE_LATENCY_STATS))
 		return -EEXIST;
@@ -222,6 +434,38 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 
 	glob_stats = mz->addr;
 	samp_intvl = app_samp_intvl * latencystat_cycles_per_ns();
+	flow_type_cb = user_cb;
+
+	/** Allocate a histogram per Tx queue in shared memory */
+	RTE_ETH_FOREACH_DEV(pid) {
+		struct rte_eth_dev_info dev_info;
+		rte_eth_dev_info_get(pid, &dev_info);
+		nb_hists += dev_info.nb_tx_queues;
+	}
+
+	mz = rte_memzone_reserve_aligned(MZ_RTE_LATENCY_HIST,
+			sizeof(*hist_tbl) + nb_hists * sizeof(struct latency_hist),
+			rte_socket_id(), flags, RTE_CACHE_LINE_SIZE);
+	if (mz == NULL) {
+		RTE_LOG(ERR, LATENCY_STATS, "Cannot reserve memory: %s:%d\n",
+			__func__, __LINE__);
+		rte_memzone_free(rte_memzone_lookup(MZ_RTE_LATENCY_STATS));
+		glob_stats = NULL;
+		return -ENOMEM;
+	}
+
+	hist_tbl = mz->addr;
+	memset(hist_tbl, 0, mz->len);
+	hist_tbl->tsc_hz = rte_get_tsc_hz();
+	hist_tbl->nb_hists = nb_hists;
+	nb_hists = 0;
+	RTE_ETH_FOREACH_DEV(pid) {
+		struct rte_eth_dev_info dev_info;
+		rte_eth_dev_info_get(pid, &dev_info);
+		hist_tbl->first_hist[pid] = nb_hists;
+		hist_tbl->nb_queues[pid] = dev_info.nb_tx_queues;
+		nb_hists += dev_info.nb_tx_queues;
+	}
 
 	/** Register latency stats with stats library */
 	for (i = 0; i < NUM_LATENCY_STATS; i++)
@@ -235,14 +479,27 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 		return -1;
 	}
 
+	for (i = 0; i < NUM_LATENCY_PCT; i++)
+		pct_strings[i] = lat_pct_strings[i].name;
+
+	latency_pct_index = rte_metrics_reg_names(pct_strings,
+						NUM_LATENCY_PCT);
+	if (latency_pct_index < 0) {
+		RTE_LOG(DEBUG, LATENCY_STATS,
+			"Failed to register latency percentile names\n");
+		return -1;
+	}
+
 	/** Register Rx/Tx callbacks */
 	RTE_ETH_FOREACH_DEV(pid) {
 		struct rte_eth_dev_info dev_info;
 		rte_eth_dev_info_get(pid, &dev_info);
 		for (qid = 0; qid < dev_info.nb_rx_queues; qid++) {
 			cbs = &rx_cbs[pid][qid];
+			cbs->timer_tsc = 0;
+			cbs->prev_tsc = rte_rdtsc();
 			cbs->cb = rte_eth_add_first_rx_callback(pid, qid,
-					add_time_stamps, user_cb);
+					add_time_stamps, cbs);
 			if (!cbs->cb)
 				RTE_LOG(INFO, LATENCY_STATS, "Failed to "
 					"register Rx callback for pid=%d, "
@@ -250,8 +507,10 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 		}
 		for (qid = 0; qid < dev_info.nb_tx_queues; qid++) {
 			cbs = &tx_cbs[pid][qid];
+			cbs->hist = &hist_tbl->hists[
+					hist_tbl->first_hist[pid] + qid];
 			cbs->cb =  rte_eth_add_tx_callback(pid, qid,
-					calc_latency, user_cb);
+					calc_latency, cbs);
 			if (!cbs->cb)
 				RTE_LOG(INFO, LATENCY_STATS, "Failed to "
 					"register Tx callback for pid=%d, "
@@ -292,11 +551,16 @@ rte_latencystats_uninit(void)
 		}
 	}
 
-	/* free up the memzone */
+	/* free up the memzones */
 	mz = rte_memzone_lookup(MZ_RTE_LATENCY_STATS);
 	if (mz)
 		rte_memzone_free(mz);
 
+	mz = rte_memzone_lookup(MZ_RTE_LATENCY_HIST);
+	if (mz)
+		rte_memzone_free(mz);
+	hist_tbl = NULL;
+
 	return 0;
 }
 
@@ -305,21 +569,25 @@ rte_latencystats_get_names(struct rte_metric_name *names, uint16_t size)
 {
 	unsigned int i;
 
-	if (names == NULL || size < NUM_LATENCY_STATS)
-		return NUM_LATENCY_STATS;
+	if (names == NULL || size < NUM_LATENCY_ALL_STATS)
+		return NUM_LATENCY_ALL_STATS;
 
 	for (i = 0; i < NUM_LATENCY_STATS; i++)
 		snprintf(names[i].name, sizeof(names[i].name),
 				"%s", lat_stats_strings[i].name);
+	for (i = 0; i < NUM_LATENCY_PCT; i++)
+		snprintf(names[NUM_LATENCY_STATS + i].name,
+				sizeof(names[NUM_LATENCY_STATS + i].name),
+				"%s", lat_pct_strings[i].name);
 
-	return NUM_LATENCY_STATS;
+	return NUM_LATENCY_ALL_STATS;
 }
 
 int
 rte_latencystats_get(struct rte_metric_value *values, uint16_t size)
 {
-	if (size < NUM_LATENCY_STATS || values == NULL)
-		return NUM_LATENCY_STATS;
+	if (size < NUM_LATENCY_ALL_STATS || values == NULL)
+		return NUM_LATENCY_ALL_STATS;
 
 	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
 		const struct rte_memzone *mz;
@@ -335,5 +603,50 @@ rte_latencystats_get(struct rte_metric_value *values, uint16_t size)
 	/* Retrieve latency stats */
 	rte_latencystats_fill_values(values);
 
-	return NUM_LATENCY_STATS;
+	return NUM_LATENCY_ALL_STATS;
+}
+
+int __rte_experimental
+rte_latencystats_percentiles_get(uint16_t port_id, uint16_t queue_id,
+		const double *pct, uint64_t *values, uint16_t n)
+{
+	const struct latency_hist_tbl *tbl;
+	uint32_t first, nb;
+	uint16_t i;
+
+	if ((pct == NULL || values == NULL) && n != 0)
+		return -EINVAL;
+
+	for (i = 0; i < n; i++)
+		if (pct[i] < 0 || pct[i] > 100)
+			return -EINVAL;
+
+	tbl = latency_hist_tbl_get();
+	if (tbl == NULL) {
+		RTE_LOG(ERR, LATENCY_STATS,
+			"Latency stats memzone not found\n");
+		return -ENOMEM;
+	}
+
+	if (port_id == RTE_LATENCYSTATS_ALL) {
+		if (queue_id != RTE_LATENCYSTATS_ALL)
+			return -EINVAL;
+		first = 0;
+		nb = tbl->nb_hists;
+	} else {
+		if (port_id >= RTE_MAX_ETHPORTS)
+			return -EINVAL;
+		first = tbl->first_hist[port_id];
+		nb = tbl->nb_queues[port_id];
+		if (queue_id != RTE_LATENCYSTATS_ALL) {
+			if (queue_id >= nb)
+				return -EINVAL;
+			first += queue_id;
+			nb = 1;
+		}
+	}
+
+	latency_hist_percentiles(tbl, first, nb, pct, values, n);
+
+	return n;
 }
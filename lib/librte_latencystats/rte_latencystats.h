@@ -13,6 +13,7 @@
  */
 
 #include <stdint.h>
+#include <rte_compat.h>
 #include <rte_metrics.h>
 #include <rte_mbuf.h>
 
@@ -20,22 +21,22 @@
 extern "C" {
 #endif
 
+/** Port or queue identifier selecting all the ports or queues */
+#define RTE_LATENCYSTATS_ALL UINT16_MAX
+
 /**
- *  Note: This function pointer is for future flow based latency stats
- *  implementation.
- *
  * Function type used for identifting flow types of a Rx packet.
  *
- * The callback function is called on Rx for each packet.
- * This function is used for flow based latency calculations.
+ * The callback function is called on Rx for each packet that is due to be
+ * sampled. This function is used for flow based latency calculations.
  *
  * @param pkt
  *   Packet that has to be identified with its flow types.
  * @param user_param
- *   The arbitrary user parameter passed in by the application when
- *   the callback was originally configured.
+ *   Always NULL.
  * @return
  *   The flow_mask, representing the multiple flow types of a packet.
+ *   The packet is sampled only if it is not 0.
  */
 typedef uint16_t (*rte_latency_stats_flow_type_fn)(struct rte_mbuf *pkt,
 							void *user_param);
@@ -47,13 +48,11 @@ typedef uint16_t (*rte_latency_stats_flow_type_fn)(struct rte_mbuf *pkt,
  *  Sampling time period in nano seconds, at which packet
  *  should be marked with time stamp.
  * @param user_cb
- *  Note: This param is for future flow based latency stats
- *  implementation.
  *  User callback to be called to get flow types of a packet.
  *  Used for flow based latency calculation.
  *  If the value is NULL, global stats will be calculated,
- *  else flow based latency stats will be calculated.
- *  For now just pass on the NULL value to this param.
+ *  else the stats and histograms only cover the packets of the flows
+ *  the callback returns a non-zero flow mask for.
  *  @return
  *   -1     : On error
  *   -ENOMEM: On error
@@ -121,6 +120,37 @@ int rte_latencystats_get_names(struct rte_metric_name *names,
 int rte_latencystats_get(struct rte_metric_value *values,
 			uint16_t size);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Retrieve percentiles of the latency of a Tx queue, a port or all ports.
+ *
+ * The latencies are recorded in a log-linear histogram per Tx queue, with a
+ * relative error bounded to 1/16, and the histograms of the queues of a port
+ * are merged on read.
+ *
+ * @param port_id
+ *   Port identifier, or RTE_LATENCYSTATS_ALL for all ports.
+ * @param queue_id
+ *   Tx queue identifier, or RTE_LATENCYSTATS_ALL for all the queues of the
+ *   port. Must be RTE_LATENCYSTATS_ALL when port_id is.
+ * @param pct
+ *   Table of n percentiles to retrieve, between 0 and 100 (e.g. 99.9).
+ * @param values
+ *   Table of n entries filled with the latencies in nano seconds of the
+ *   percentiles, or 0 when no latency was recorded.
+ * @param n
+ *   Number of percentiles.
+ * @return
+ *   - n: on success.
+ *   - -EINVAL: invalid parameters.
+ *   - -ENOMEM: latency stats memzone not found.
+ */
+int __rte_experimental
+rte_latencystats_percentiles_get(uint16_t port_id, uint16_t queue_id,
+		const double *pct, uint64_t *values, uint16_t n);
+
 #ifdef __cplusplus
 }
 #endif
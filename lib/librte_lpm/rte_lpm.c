@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -305,9 +306,28 @@ rte_lpm_create_v1604(const char *name, int socket_id,
 		goto exit;
 	}
 
+	if (config->flags & RTE_LPM_TBL8_DEFER_FREE) {
+		lpm->tbl8_pending = rte_zmalloc_socket(NULL,
+				sizeof(uint32_t) * config->number_tbl8s,
+				RTE_CACHE_LINE_SIZE, socket_id);
+
+		if (lpm->tbl8_pending == NULL) {
+			RTE_LOG(ERR, LPM,
+				"LPM tbl8 pending list allocation failed\n");
+			rte_free(lpm->tbl8);
+			rte_free(lpm->rules_tbl);
+			rte_free(lpm);
+			lpm = NULL;
+			rte_free(te);
+			rte_errno = ENOMEM;
+			goto exit;
+		}
+	}
+
 	/* Save user arguments. */
 	lpm->max_rules = config->max_rules;
 	lpm->number_tbl8s = config->number_tbl8s;
+	lpm->flags = config->flags;
 	snprintf(lpm->name, sizeof(lpm->name), "%s", name);
 
 	te->data = lpm;
@@ -380,6 +400,7 @@ rte_lpm_free_v1604(struct rte_lpm *lpm)
 
 	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
 
+	rte_free(lpm->tbl8_pending);
 	rte_free(lpm->tbl8);
 	rte_free(lpm->rules_tbl);
 	rte_free(lpm);
@@ -670,14 +691,20 @@ tbl8_alloc_v20(struct rte_lpm_tbl_entry_v20 *tbl8)
 }
 
 static inline int32_t
-tbl8_alloc_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t number_tbl8s)
+tbl8_alloc_v1604(struct rte_lpm *lpm)
 {
 	uint32_t group_idx; /* tbl8 group index. */
 	struct rte_lpm_tbl_entry *tbl8_entry;
 
-	/* Scan through tbl8 to find a free (i.e. INVALID) tbl8 group. */
-	for (group_idx = 0; group_idx < number_tbl8s; group_idx++) {
-		tbl8_entry = &tbl8[group_idx * RTE_LPM_TBL8_GROUP_NUM_ENTRIES];
+	/*
+	 * Scan through tbl8 to find a free (i.e. INVALID) tbl8 group. The
+	 * groups below the hint are all in use, so that filling the table
+	 * does not rescan them.
+	 */
+	for (group_idx = lpm->tbl8_hint; group_idx < lpm->number_tbl8s;
+			group_idx++) {
+		tbl8_entry = &lpm->tbl8[group_idx *
+				RTE_LPM_TBL8_GROUP_NUM_ENTRIES];
 		/* If a free tbl8 group is found clean it and set as VALID. */
 		if (!tbl8_entry->valid_group) {
 			memset(&tbl8_entry[0], 0,
@@ -685,6 +712,7 @@ tbl8_alloc_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t number_tbl8s)
 					sizeof(tbl8_entry[0]));
 
 			tbl8_entry->valid_group = VALID;
+			lpm->tbl8_hint = group_idx + 1;
 
 			/* Return group index for allocated tbl8 group. */
 			return group_idx;
@@ -703,10 +731,22 @@ tbl8_free_v20(struct rte_lpm_tbl_entry_v20 *tbl8, uint32_t tbl8_group_start)
 }
 
 static inline void
-tbl8_free_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t tbl8_group_start)
+tbl8_free_v1604(struct rte_lpm *lpm, uint32_t tbl8_group_start)
 {
+	/*
+	 * Readers may still walk the group, keep it allocated until
+	 * rte_lpm_tbl8_reclaim().
+	 */
+	if (lpm->flags & RTE_LPM_TBL8_DEFER_FREE) {
+		lpm->tbl8_pending[lpm->tbl8_pending_count++] =
+				tbl8_group_start;
+		return;
+	}
+
 	/* Set tbl8 group invalid*/
-	tbl8[tbl8_group_start].valid_group = INVALID;
+	lpm->tbl8[tbl8_group_start].valid_group = INVALID;
+	lpm->tbl8_hint = RTE_MIN(lpm->tbl8_hint,
+			tbl8_group_start / RTE_LPM_TBL8_GROUP_NUM_ENTRIES);
 }
 
 static inline int32_t
@@ -985,7 +1025,7 @@ add_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 
 	if (!lpm->tbl24[tbl24_index].valid) {
 		/* Search for a free tbl8 group. */
-		tbl8_group_index = tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+		tbl8_group_index = tbl8_alloc_v1604(lpm);
 
 		/* Check tbl8 allocation was successful. */
 		if (tbl8_group_index < 0) {
@@ -1017,12 +1057,14 @@ add_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 			.depth = 0,
 		};
 
-		lpm->tbl24[tbl24_index] = new_tbl24_entry;
+		/* The tbl8 group must be complete before readers reach it. */
+		__atomic_store(&lpm->tbl24[tbl24_index], &new_tbl24_entry,
+				__ATOMIC_RELEASE);
 
 	} /* If valid entry but not extended calculate the index into Table8. */
 	else if (lpm->tbl24[tbl24_index].valid_group == 0) {
 		/* Search for free tbl8 group. */
-		tbl8_group_index = tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+		tbl8_group_index = tbl8_alloc_v1604(lpm);
 
 		if (tbl8_group_index < 0) {
 			return tbl8_group_index;
@@ -1063,7 +1105,9 @@ add_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 				.depth = 0,
 		};
 
-		lpm->tbl24[tbl24_index] = new_tbl24_entry;
+		/* The tbl8 group must be complete before readers reach it. */
+		__atomic_store(&lpm->tbl24[tbl24_index], &new_tbl24_entry,
+				__ATOMIC_RELEASE);
 
 	} else { /*
 		* If it is valid, extended entry calculate the index into tbl8.
@@ -1185,6 +1229,216 @@ BIND_DEFAULT_SYMBOL(rte_lpm_add, _v1604, 16.04);
 MAP_STATIC_SYMBOL(int rte_lpm_add(struct rte_lpm *lpm, uint32_t ip,
 		uint8_t depth, uint32_t next_hop), rte_lpm_add_v1604);
 
+/* Route of a bulk add. */
+struct lpm_bulk_route {
+	uint32_t ip;           /* Masked IP address. */
+	uint32_t next_hop;
+	uint32_t old_next_hop; /* Next hop of the existing rule. */
+	uint32_t rule_offset;  /* Offset of the existing rule in its group. */
+	uint32_t idx;          /* Position in the batch. */
+	uint8_t depth;
+	uint8_t exists;        /* Already in the rules table. */
+};
+
+static int
+bulk_route_cmp(const void *p1, const void *p2)
+{
+	const struct lpm_bulk_route *r1 = p1, *r2 = p2;
+
+	if (r1->depth != r2->depth)
+		return r1->depth < r2->depth ? -1 : 1;
+	if (r1->ip != r2->ip)
+		return r1->ip < r2->ip ? -1 : 1;
+	return r1->idx < r2->idx ? -1 : r1->idx > r2->idx;
+}
+
+static int
+rule_ip_cmp(const void *p1, const void *p2)
+{
+	const struct rte_lpm_rule *r1 = p1, *r2 = p2;
+
+	if (r1->ip != r2->ip)
+		return r1->ip < r2->ip ? -1 : 1;
+	return 0;
+}
+
+int __rte_experimental
+rte_lpm_add_bulk(struct rte_lpm *lpm, const uint32_t *ips,
+		const uint8_t *depths, const uint32_t *next_hops, uint32_t n)
+{
+	uint32_t new_rules[RTE_LPM_MAX_DEPTH] = { 0 };
+	struct rte_lpm_rule_info *info;
+	struct lpm_bulk_route *routes, *route;
+	struct rte_lpm_rule key, *rule;
+	uint32_t i, j, total, pos;
+	int32_t rule_index, status;
+	int d, ret = 0;
+
+	/* Check user arguments. */
+	if (lpm == NULL || (n > 0 && (ips == NULL || depths == NULL ||
+			next_hops == NULL)))
+		return -EINVAL;
+
+	for (i = 0; i < n; i++) {
+		if (depths[i] < 1 || depths[i] > RTE_LPM_MAX_DEPTH)
+			return -EINVAL;
+	}
+
+	if (n == 0)
+		return 0;
+
+	routes = rte_malloc("LPM_BULK", sizeof(*routes) * n, 0);
+	if (routes == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < n; i++) {
+		routes[i].ip = ips[i] & depth_to_mask(depths[i]);
+		routes[i].depth = depths[i];
+		routes[i].next_hop = next_hops[i];
+		routes[i].idx = i;
+	}
+
+	/* Sort by depth then address, keeping the last of the duplicates. */
+	qsort(routes, n, sizeof(*routes), bulk_route_cmp);
+	for (i = 0, j = 0; i < n; i++) {
+		if (i + 1 < n && routes[i + 1].depth == routes[i].depth &&
+				routes[i + 1].ip == routes[i].ip)
+			continue;
+		routes[j++] = routes[i];
+	}
+	n = j;
+
+	/*
+	 * Look the routes up in the rules table, each rule group being
+	 * sorted by address once instead of scanned for every route.
+	 */
+	for (i = 0; i < n; i++) {
+		route = &routes[i];
+		info = &lpm->rule_info[route->depth - 1];
+
+		if (i == 0 || routes[i - 1].depth != route->depth)
+			qsort(&lpm->rules_tbl[info->first_rule],
+					info->used_rules,
+					sizeof(lpm->rules_tbl[0]), rule_ip_cmp);
+
+		key.ip = route->ip;
+		rule = bsearch(&key, &lpm->rules_tbl[info->first_rule],
+				info->used_rules, sizeof(lpm->rules_tbl[0]),
+				rule_ip_cmp);
+		route->exists = rule != NULL;
+		if (rule != NULL) {
+			route->old_next_hop = rule->next_hop;
+			route->rule_offset = rule -
+					&lpm->rules_tbl[info->first_rule];
+		} else {
+			new_rules[route->depth - 1]++;
+		}
+	}
+
+	total = 0;
+	for (d = 0; d < RTE_LPM_MAX_DEPTH; d++)
+		total += lpm->rule_info[d].used_rules + new_rules[d];
+
+	if (total > lpm->max_rules) {
+		rte_free(routes);
+		return -ENOSPC;
+	}
+
+	/*
+	 * Make room for the new rules at the end of their group, moving
+	 * each group once, deepest first as the groups only move up.
+	 */
+	pos = total;
+	for (d = RTE_LPM_MAX_DEPTH - 1; d >= 0; d--) {
+		info = &lpm->rule_info[d];
+		if (info->used_rules + new_rules[d] == 0)
+			continue;
+
+		pos -= info->used_rules + new_rules[d];
+		if (info->used_rules > 0 && pos != info->first_rule)
+			memmove(&lpm->rules_tbl[pos],
+					&lpm->rules_tbl[info->first_rule],
+					sizeof(lpm->rules_tbl[0]) *
+					info->used_rules);
+		info->first_rule = pos;
+	}
+
+	for (i = 0; i < n; i++) {
+		route = &routes[i];
+		info = &lpm->rule_info[route->depth - 1];
+
+		if (route->exists) {
+			lpm->rules_tbl[info->first_rule +
+					route->rule_offset].next_hop =
+					route->next_hop;
+		} else {
+			rule = &lpm->rules_tbl[info->first_rule +
+					info->used_rules];
+			rule->ip = route->ip;
+			rule->next_hop = route->next_hop;
+			info->used_rules++;
+		}
+	}
+
+	/*
+	 * Update the lookup tables, shorter prefixes first so that they are
+	 * overwritten only once by the longer ones.
+	 */
+	for (i = 0; i < n; i++) {
+		route = &routes[i];
+
+		if (route->exists && route->old_next_hop == route->next_hop)
+			continue;
+
+		if (route->depth <= MAX_DEPTH_TBL24) {
+			status = add_depth_small_v1604(lpm, route->ip,
+					route->depth, route->next_hop);
+		} else { /* If depth > RTE_LPM_MAX_DEPTH_TBL24 */
+			status = add_depth_big_v1604(lpm, route->ip,
+					route->depth, route->next_hop);
+		}
+
+		/*
+		 * If add fails due to exhaustion of tbl8 extensions revert
+		 * the rule table and go on with the other routes.
+		 */
+		if (status < 0) {
+			rule_index = rule_find_v1604(lpm, route->ip,
+					route->depth);
+			if (route->exists)
+				lpm->rules_tbl[rule_index].next_hop =
+						route->old_next_hop;
+			else
+				rule_delete_v1604(lpm, rule_index,
+						route->depth);
+			ret = status;
+		}
+	}
+
+	rte_free(routes);
+
+	return ret;
+}
+
+uint32_t __rte_experimental
+rte_lpm_tbl8_reclaim(struct rte_lpm *lpm)
+{
+	uint32_t i, n;
+
+	if (lpm == NULL)
+		return 0;
+
+	n = lpm->tbl8_pending_count;
+	for (i = 0; i < n; i++) {
+		lpm->tbl8[lpm->tbl8_pending[i]].valid_group = INVALID;
+		lpm->tbl8_hint = RTE_MIN(lpm->tbl8_hint, lpm->tbl8_pending[i] /
+				RTE_LPM_TBL8_GROUP_NUM_ENTRIES);
+	}
+	lpm->tbl8_pending_count = 0;
+
+	return n;
+}
+
 /*
  * Look for a rule in the high-level rules table
  */
@@ -1715,7 +1969,7 @@ delete_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked,
 	if (tbl8_recycle_index == -EINVAL) {
 		/* Set tbl24 before freeing tbl8 to avoid race condition. */
 		lpm->tbl24[tbl24_index].valid = 0;
-		tbl8_free_v1604(lpm->tbl8, tbl8_group_start);
+		tbl8_free_v1604(lpm, tbl8_group_start);
 	} else if (tbl8_recycle_index > -1) {
 		/* Update tbl24 entry. */
 		struct rte_lpm_tbl_entry new_tbl24_entry = {
@@ -1727,7 +1981,7 @@ delete_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked,
 
 		/* Set tbl24 before freeing tbl8 to avoid race condition. */
 		lpm->tbl24[tbl24_index] = new_tbl24_entry;
-		tbl8_free_v1604(lpm->tbl8, tbl8_group_start);
+		tbl8_free_v1604(lpm, tbl8_group_start);
 	}
 #undef group_idx
 	return 0;
@@ -1878,6 +2132,8 @@ rte_lpm_delete_all_v1604(struct rte_lpm *lpm)
 	/* Zero tbl8. */
 	memset(lpm->tbl8, 0, sizeof(lpm->tbl8[0])
 			* RTE_LPM_TBL8_GROUP_NUM_ENTRIES * lpm->number_tbl8s);
+	lpm->tbl8_hint = 0;
+	lpm->tbl8_pending_count = 0;
 
 	/* Delete all rules form the rules table. */
 	memset(lpm->rules_tbl, 0, sizeof(lpm->rules_tbl[0]) * lpm->max_rules);
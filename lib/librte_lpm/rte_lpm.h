@@ -134,11 +134,18 @@ struct rte_lpm_tbl_entry {
 
 #endif
 
+/**
+ * LPM creation flag: the tbl8 groups freed by a delete are not reused until
+ * rte_lpm_tbl8_reclaim() is called, so that lock-free readers still walking
+ * them never see them rewritten.
+ */
+#define RTE_LPM_TBL8_DEFER_FREE         0x1
+
 /** LPM configuration structure. */
 struct rte_lpm_config {
 	uint32_t max_rules;      /**< Max number of rules. */
 	uint32_t number_tbl8s;   /**< Number of tbl8s to allocate. */
-	int flags;               /**< This field is currently unused. */
+	int flags;               /**< RTE_LPM_* creation flags, or 0. */
 };
 
 /** @internal Rule structure. */
@@ -186,6 +193,10 @@ struct rte_lpm {
 			__rte_cache_aligned; /**< LPM tbl24 table. */
 	struct rte_lpm_tbl_entry *tbl8; /**< LPM tbl8 table. */
 	struct rte_lpm_rule *rules_tbl; /**< LPM rules. */
+	int flags; /**< Creation flags. */
+	uint32_t tbl8_hint; /**< First tbl8 group possibly free. */
+	uint32_t tbl8_pending_count; /**< Number of tbl8 groups to reclaim. */
+	uint32_t *tbl8_pending; /**< tbl8 groups freed, to reclaim. */
 };
 
 /**
@@ -328,6 +339,57 @@ rte_lpm_delete_all_v20(struct rte_lpm_v20 *lpm);
 void
 rte_lpm_delete_all_v1604(struct rte_lpm *lpm);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add a batch of routes to an LPM table.
+ *
+ * The rules table is updated once for the whole batch, then the routes are
+ * written to the lookup tables by increasing depth. A new tbl8 group is
+ * filled before the tbl24 entry pointing to it is written, so that
+ * concurrent lookups see each route either fully added or not at all.
+ * When a route appears several times in the batch, the last next hop wins.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ips
+ *   Array of IP addresses of the routes
+ * @param depths
+ *   Array of depths of the routes
+ * @param next_hops
+ *   Array of next hops of the routes
+ * @param n
+ *   Number of routes
+ * @return
+ *   0 on success, -EINVAL on invalid parameters and -ENOSPC if the rules
+ *   table is too small, no route being added in both cases. -ENOSPC is
+ *   also returned when the tbl8 groups are exhausted, the routes needing
+ *   no new tbl8 group being added anyway. -ENOMEM if no memory is left to
+ *   sort the batch.
+ */
+int __rte_experimental
+rte_lpm_add_bulk(struct rte_lpm *lpm, const uint32_t *ips,
+		const uint8_t *depths, const uint32_t *next_hops, uint32_t n);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Make the tbl8 groups freed since the previous call available again.
+ *
+ * With RTE_LPM_TBL8_DEFER_FREE, it must only be called once all the
+ * lookups started before the freeing deletes have completed, e.g. after
+ * each reader lcore went through a quiescent state.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @return
+ *   The number of tbl8 groups reclaimed.
+ */
+uint32_t __rte_experimental
+rte_lpm_tbl8_reclaim(struct rte_lpm *lpm);
+
 /**
  * Lookup an IP into the LPM table.
  *
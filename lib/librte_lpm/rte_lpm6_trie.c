@@ -0,0 +1,655 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include <rte_log.h>
+#include <rte_branch_prediction.h>
+#include <rte_common.h>
+#include <rte_memory.h>
+#include <rte_malloc.h>
+#include <rte_prefetch.h>
+#include <rte_errno.h>
+#include <rte_hash.h>
+#include <rte_jhash.h>
+
+#include "rte_lpm6_trie.h"
+
+#define TRIE_TBL24_BITS                 24
+#define TRIE_TBL24_NUM_ENTRIES          (1 << TRIE_TBL24_BITS)
+#define TRIE_TBL8_BITS                  8
+#define TRIE_TBL8_GROUP_NUM_ENTRIES     (1 << TRIE_TBL8_BITS)
+/* byte of the address indexing the first tbl8 level */
+#define TRIE_TBL8_FIRST_BYTE            (TRIE_TBL24_BITS / 8)
+
+/*
+ * A lookup entry holds a next hop or the index of the tbl8 group of the
+ * next level, in the bits above the flags.
+ */
+#define TRIE_ENTRY_EXT                  0x1
+#define TRIE_ENTRY_VALID                0x2
+#define TRIE_ENTRY_SHIFT                2
+
+/* number of addresses walked in lockstep by the bulk lookup */
+#define TRIE_LOOKUP_BULK                32
+
+#define RULE_HASH_TABLE_EXTRA_SPACE     64
+
+/** Rules table key. */
+struct lpm6_trie_rule_key {
+	uint8_t ip[RTE_LPM6_TRIE_IPV6_ADDR_SIZE]; /**< Masked IP address. */
+	uint8_t depth; /**< Rule depth. */
+};
+
+/** IPv6 LPM trie. */
+struct rte_lpm6_trie {
+	char name[RTE_LPM6_TRIE_NAMESIZE];  /**< Name of the trie. */
+	uint32_t max_rules;                 /**< Max number of rules. */
+	uint32_t used_rules;                /**< Used rules so far. */
+	uint32_t number_tbl8s;              /**< Number of tbl8 groups. */
+	uint32_t tbl8_pool_pos;             /**< Next free group in pool. */
+	/** Number of rules of each depth. */
+	uint32_t depth_rules[RTE_LPM6_TRIE_MAX_DEPTH + 1];
+	struct rte_hash *rules_tbl;         /**< Rules, with next hops. */
+	uint32_t *tbl8_pool;                /**< Stack of free tbl8 groups. */
+	/* Depth of the route of each entry, for updates only. */
+	uint8_t *tbl24_depth;               /**< Depths of tbl24. */
+	uint8_t *tbl8_depth;                /**< Depths of tbl8. */
+	uint32_t *tbl8;                     /**< tbl8 groups. */
+	uint32_t tbl24[TRIE_TBL24_NUM_ENTRIES]
+			__rte_cache_aligned;        /**< First level table. */
+};
+
+/* Update of the entries covered by a route. */
+struct trie_update {
+	const uint8_t *ip;   /* masked address of the route */
+	uint8_t depth;       /* depth of the route */
+	uint8_t del;         /* rewrite the entries of the route only */
+	uint8_t new_depth;   /* depth written to the entries */
+	uint32_t new_entry;  /* entry written */
+};
+
+static inline void
+ip6_mask_addr(uint8_t *dst, const uint8_t *ip, uint8_t depth)
+{
+	unsigned int i;
+
+	for (i = 0; i < RTE_LPM6_TRIE_IPV6_ADDR_SIZE; i++) {
+		if (depth >= 8)
+			dst[i] = ip[i];
+		else if (depth > 0)
+			dst[i] = ip[i] & (uint8_t)(UINT8_MAX << (8 - depth));
+		else
+			dst[i] = 0;
+		depth -= RTE_MIN(depth, 8);
+	}
+}
+
+static inline void
+rule_key_init(struct lpm6_trie_rule_key *key, const uint8_t *ip,
+		uint8_t depth)
+{
+	ip6_mask_addr(key->ip, ip, depth);
+	key->depth = depth;
+}
+
+static inline uint32_t
+tbl24_index(const uint8_t *ip)
+{
+	return (uint32_t)ip[0] << 16 | (uint32_t)ip[1] << 8 | ip[2];
+}
+
+/* level of the trie holding the last bits of a prefix, 0 being tbl24 */
+static inline unsigned int
+depth_to_level(uint8_t depth)
+{
+	if (depth <= TRIE_TBL24_BITS)
+		return 0;
+	return (depth - TRIE_TBL24_BITS + TRIE_TBL8_BITS - 1) / TRIE_TBL8_BITS;
+}
+
+/* number of bits of the address consumed once a level is indexed */
+static inline unsigned int
+level_end_bits(unsigned int level)
+{
+	return TRIE_TBL24_BITS + level * TRIE_TBL8_BITS;
+}
+
+static inline uint32_t *
+tbl8_group(const struct rte_lpm6_trie *lpm, uint32_t group)
+{
+	return &lpm->tbl8[(size_t)group * TRIE_TBL8_GROUP_NUM_ENTRIES];
+}
+
+static inline uint8_t *
+tbl8_group_depth(const struct rte_lpm6_trie *lpm, uint32_t group)
+{
+	return &lpm->tbl8_depth[(size_t)group * TRIE_TBL8_GROUP_NUM_ENTRIES];
+}
+
+static void
+tbl8_pool_init(struct rte_lpm6_trie *lpm)
+{
+	uint32_t i;
+
+	for (i = 0; i < lpm->number_tbl8s; i++)
+		lpm->tbl8_pool[i] = i;
+	lpm->tbl8_pool_pos = 0;
+}
+
+/*
+ * Replace a lookup entry by a new group holding 256 copies of it. The
+ * group is filled before it is published.
+ */
+static int
+tbl8_expand(struct rte_lpm6_trie *lpm, uint32_t *ent, uint8_t *dep)
+{
+	uint32_t group, new_ent, i;
+	uint32_t *tbl;
+	uint8_t *tbl_depth;
+
+	if (lpm->tbl8_pool_pos == lpm->number_tbl8s)
+		return -ENOSPC;
+	group = lpm->tbl8_pool[lpm->tbl8_pool_pos++];
+
+	tbl = tbl8_group(lpm, group);
+	tbl_depth = tbl8_group_depth(lpm, group);
+	for (i = 0; i < TRIE_TBL8_GROUP_NUM_ENTRIES; i++)
+		tbl[i] = *ent;
+	memset(tbl_depth, *dep, TRIE_TBL8_GROUP_NUM_ENTRIES);
+
+	new_ent = group << TRIE_ENTRY_SHIFT | TRIE_ENTRY_EXT;
+	__atomic_store_n(ent, new_ent, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+/*
+ * Fold a group back into the entry pointing to it if all its entries are
+ * the same route.
+ */
+static void
+tbl8_fold(struct rte_lpm6_trie *lpm, uint32_t *ent, uint8_t *dep)
+{
+	uint32_t group = *ent >> TRIE_ENTRY_SHIFT;
+	const uint32_t *tbl = tbl8_group(lpm, group);
+	const uint8_t *tbl_depth = tbl8_group_depth(lpm, group);
+	uint32_t i;
+
+	if (tbl[0] & TRIE_ENTRY_EXT)
+		return;
+	for (i = 1; i < TRIE_TBL8_GROUP_NUM_ENTRIES; i++) {
+		if (tbl[i] != tbl[0] || tbl_depth[i] != tbl_depth[0])
+			return;
+	}
+
+	*dep = tbl_depth[0];
+	__atomic_store_n(ent, tbl[0], __ATOMIC_RELEASE);
+	lpm->tbl8_pool[--lpm->tbl8_pool_pos] = group;
+}
+
+static inline int
+update_match(const struct trie_update *u, uint8_t depth)
+{
+	return u->del ? depth == u->depth : depth <= u->depth;
+}
+
+static void update_range(struct rte_lpm6_trie *lpm, uint32_t *tbl,
+		uint8_t *tbl_depth, uint32_t n, const struct trie_update *u);
+
+/* update the entries of a whole group */
+static void
+update_group(struct rte_lpm6_trie *lpm, uint32_t group,
+		const struct trie_update *u)
+{
+	update_range(lpm, tbl8_group(lpm, group), tbl8_group_depth(lpm, group),
+			TRIE_TBL8_GROUP_NUM_ENTRIES, u);
+}
+
+/* update a range of entries fully covered by the route */
+static void
+update_range(struct rte_lpm6_trie *lpm, uint32_t *tbl, uint8_t *tbl_depth,
+		uint32_t n, const struct trie_update *u)
+{
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		if (tbl[i] & TRIE_ENTRY_EXT) {
+			update_group(lpm, tbl[i] >> TRIE_ENTRY_SHIFT, u);
+			tbl8_fold(lpm, &tbl[i], &tbl_depth[i]);
+		} else if (update_match(u, tbl_depth[i])) {
+			tbl_depth[i] = u->new_depth;
+			__atomic_store_n(&tbl[i], u->new_entry,
+					__ATOMIC_RELEASE);
+		}
+	}
+}
+
+/*
+ * Update the entries of a route below an entry of the previous level,
+ * splitting the entry into a group if needed.
+ */
+static int
+update_level(struct rte_lpm6_trie *lpm, uint32_t *ent, uint8_t *dep,
+		unsigned int level, const struct trie_update *u)
+{
+	uint32_t group, idx;
+	uint32_t *tbl;
+	uint8_t *tbl_depth;
+	int ret = 0;
+
+	if (!(*ent & TRIE_ENTRY_EXT)) {
+		/* a longer route covers the entry, or not the deleted one */
+		if (!update_match(u, *dep))
+			return 0;
+		ret = tbl8_expand(lpm, ent, dep);
+		if (ret < 0)
+			return ret;
+	}
+
+	group = *ent >> TRIE_ENTRY_SHIFT;
+	tbl = tbl8_group(lpm, group);
+	tbl_depth = tbl8_group_depth(lpm, group);
+	idx = u->ip[TRIE_TBL8_FIRST_BYTE + level - 1];
+
+	if (level == depth_to_level(u->depth))
+		update_range(lpm, &tbl[idx], &tbl_depth[idx],
+			1 << (level_end_bits(level) - u->depth), u);
+	else
+		ret = update_level(lpm, &tbl[idx], &tbl_depth[idx],
+				level + 1, u);
+
+	tbl8_fold(lpm, ent, dep);
+
+	return ret;
+}
+
+static int
+trie_update(struct rte_lpm6_trie *lpm, const struct trie_update *u)
+{
+	uint32_t idx = tbl24_index(u->ip);
+
+	if (u->depth <= TRIE_TBL24_BITS) {
+		update_range(lpm, &lpm->tbl24[idx], &lpm->tbl24_depth[idx],
+			1 << (TRIE_TBL24_BITS - u->depth), u);
+		return 0;
+	}
+
+	return update_level(lpm, &lpm->tbl24[idx], &lpm->tbl24_depth[idx], 1,
+			u);
+}
+
+static void
+trie_free(struct rte_lpm6_trie *lpm)
+{
+	if (lpm == NULL)
+		return;
+
+	rte_free(lpm->tbl8_depth);
+	rte_free(lpm->tbl24_depth);
+	rte_free(lpm->tbl8);
+	rte_free(lpm->tbl8_pool);
+	rte_hash_free(lpm->rules_tbl);
+	rte_free(lpm);
+}
+
+static int
+trie_add(struct rte_lpm6_trie *lpm, const uint8_t *ip, uint8_t depth,
+	uint32_t next_hop)
+{
+	struct lpm6_trie_rule_key key;
+	struct trie_update u;
+	void *old_next_hop;
+	int exists, ret;
+
+	/* Check user arguments. */
+	if (lpm == NULL || ip == NULL || depth < 1 ||
+			depth > RTE_LPM6_TRIE_MAX_DEPTH ||
+			next_hop > RTE_LPM6_TRIE_MAX_NEXT_HOP)
+		return -EINVAL;
+
+	rule_key_init(&key, ip, depth);
+
+	exists = rte_hash_lookup_data(lpm->rules_tbl, &key,
+			&old_next_hop) >= 0;
+	if (!exists && lpm->used_rules == lpm->max_rules)
+		return -ENOSPC;
+
+	ret = rte_hash_add_key_data(lpm->rules_tbl, &key,
+			(void *)(uintptr_t)next_hop);
+	if (ret < 0)
+		return ret;
+
+	u.ip = key.ip;
+	u.depth = depth;
+	u.del = 0;
+	u.new_depth = depth;
+	u.new_entry = next_hop << TRIE_ENTRY_SHIFT | TRIE_ENTRY_VALID;
+
+	ret = trie_update(lpm, &u);
+	if (ret < 0) {
+		/* no tbl8 group left, leave the rules table as it was */
+		if (exists)
+			rte_hash_add_key_data(lpm->rules_tbl, &key,
+					old_next_hop);
+		else
+			rte_hash_del_key(lpm->rules_tbl, &key);
+		return ret;
+	}
+
+	if (!exists) {
+		lpm->used_rules++;
+		lpm->depth_rules[depth]++;
+	}
+
+	return 0;
+}
+
+struct rte_lpm6_trie * __rte_experimental
+rte_lpm6_trie_create(const char *name, int socket_id,
+		const struct rte_lpm6_trie_config *config)
+{
+	char mem_name[RTE_LPM6_TRIE_NAMESIZE];
+	struct rte_lpm6_trie *lpm;
+	size_t tbl8_entries;
+
+	/* Check user arguments. */
+	if (name == NULL || socket_id < -1 || config == NULL ||
+			config->max_rules == 0 ||
+			config->number_tbl8s > RTE_LPM6_TRIE_MAX_TBL8S) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	snprintf(mem_name, sizeof(mem_name), "LPM6T_%s", name);
+	lpm = rte_zmalloc_socket(mem_name, sizeof(*lpm), RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (lpm == NULL) {
+		RTE_LOG(ERR, LPM, "LPM6 trie memory allocation failed\n");
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	snprintf(mem_name, sizeof(mem_name), "LTH_%s", name);
+	struct rte_hash_parameters rule_hash_tbl_params = {
+		.entries = config->max_rules * 1.2 +
+			RULE_HASH_TABLE_EXTRA_SPACE,
+		.key_len = sizeof(struct lpm6_trie_rule_key),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.name = mem_name,
+		.socket_id = socket_id,
+	};
+
+	lpm->rules_tbl = rte_hash_create(&rule_hash_tbl_params);
+	if (lpm->rules_tbl == NULL) {
+		RTE_LOG(ERR, LPM, "LPM6 trie rules table allocation failed\n");
+		goto fail;
+	}
+
+	tbl8_entries = (size_t)config->number_tbl8s *
+			TRIE_TBL8_GROUP_NUM_ENTRIES;
+	lpm->tbl8_pool = rte_malloc_socket(NULL,
+			sizeof(uint32_t) * config->number_tbl8s,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	lpm->tbl8 = rte_zmalloc_socket(NULL, sizeof(uint32_t) * tbl8_entries,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	lpm->tbl24_depth = rte_zmalloc_socket(NULL, TRIE_TBL24_NUM_ENTRIES,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	lpm->tbl8_depth = rte_zmalloc_socket(NULL, tbl8_entries,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if ((config->number_tbl8s != 0 && (lpm->tbl8_pool == NULL ||
+			lpm->tbl8 == NULL || lpm->tbl8_depth == NULL)) ||
+			lpm->tbl24_depth == NULL) {
+		RTE_LOG(ERR, LPM, "LPM6 trie tables allocation failed\n");
+		rte_errno = ENOMEM;
+		goto fail;
+	}
+
+	lpm->max_rules = config->max_rules;
+	lpm->number_tbl8s = config->number_tbl8s;
+	snprintf(lpm->name, sizeof(lpm->name), "%s", name);
+	tbl8_pool_init(lpm);
+
+	return lpm;
+
+fail:
+	trie_free(lpm);
+	return NULL;
+}
+
+void __rte_experimental
+rte_lpm6_trie_free(struct rte_lpm6_trie *lpm)
+{
+	trie_free(lpm);
+}
+
+int __rte_experimental
+rte_lpm6_trie_add(struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint8_t depth, uint32_t next_hop)
+{
+	return trie_add(lpm, ip, depth, next_hop);
+}
+
+
+int __rte_experimental
+rte_lpm6_trie_add_bulk(struct rte_lpm6_trie *lpm,
+		uint8_t ips[][RTE_LPM6_TRIE_IPV6_ADDR_SIZE],
+		const uint8_t *depths, const uint32_t *next_hops,
+		unsigned int n)
+{
+	uint32_t first[RTE_LPM6_TRIE_MAX_DEPTH + 2] = { 0 };
+	uint32_t *order;
+	unsigned int i;
+	int ret = 0, status;
+
+	/* Check user arguments. */
+	if (lpm == NULL || (n > 0 && (ips == NULL || depths == NULL ||
+			next_hops == NULL)))
+		return -EINVAL;
+
+	for (i = 0; i < n; i++) {
+		if (depths[i] < 1 || depths[i] > RTE_LPM6_TRIE_MAX_DEPTH ||
+				next_hops[i] > RTE_LPM6_TRIE_MAX_NEXT_HOP)
+			return -EINVAL;
+	}
+
+	if (n == 0)
+		return 0;
+
+	order = rte_malloc("LPM6T_BULK", sizeof(*order) * n, 0);
+	if (order == NULL)
+		return -ENOMEM;
+
+	/* Sort the routes by depth, keeping their order within a depth. */
+	for (i = 0; i < n; i++)
+		first[depths[i] + 1]++;
+	for (i = 1; i <= RTE_LPM6_TRIE_MAX_DEPTH + 1; i++)
+		first[i] += first[i - 1];
+	for (i = 0; i < n; i++)
+		order[first[depths[i]]++] = i;
+
+	for (i = 0; i < n; i++) {
+		status = trie_add(lpm, ips[order[i]],
+				depths[order[i]], next_hops[order[i]]);
+		if (status < 0)
+			ret = status;
+	}
+
+	rte_free(order);
+
+	return ret;
+}
+
+int __rte_experimental
+rte_lpm6_trie_delete(struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint8_t depth)
+{
+	struct lpm6_trie_rule_key key, parent;
+	struct trie_update u;
+	void *next_hop;
+	int ret;
+
+	/* Check user arguments. */
+	if (lpm == NULL || ip == NULL || depth < 1 ||
+			depth > RTE_LPM6_TRIE_MAX_DEPTH)
+		return -EINVAL;
+
+	rule_key_init(&key, ip, depth);
+	if (rte_hash_lookup(lpm->rules_tbl, &key) < 0)
+		return -ENOENT;
+
+	u.ip = key.ip;
+	u.depth = depth;
+	u.del = 1;
+	u.new_depth = 0;
+	u.new_entry = 0;
+
+	/* The entries of the route go to the longest route covering it. */
+	for (parent.depth = depth - 1; parent.depth > 0; parent.depth--) {
+		if (lpm->depth_rules[parent.depth] == 0)
+			continue;
+		ip6_mask_addr(parent.ip, key.ip, parent.depth);
+		if (rte_hash_lookup_data(lpm->rules_tbl, &parent,
+				&next_hop) >= 0) {
+			u.new_depth = parent.depth;
+			u.new_entry = (uint32_t)(uintptr_t)next_hop <<
+					TRIE_ENTRY_SHIFT | TRIE_ENTRY_VALID;
+			break;
+		}
+	}
+
+	ret = trie_update(lpm, &u);
+	if (ret < 0)
+		return ret;
+
+	rte_hash_del_key(lpm->rules_tbl, &key);
+	lpm->used_rules--;
+	lpm->depth_rules[depth]--;
+
+	return 0;
+}
+
+void __rte_experimental
+rte_lpm6_trie_delete_all(struct rte_lpm6_trie *lpm)
+{
+	size_t tbl8_entries;
+
+	if (lpm == NULL)
+		return;
+
+	tbl8_entries = (size_t)lpm->number_tbl8s *
+			TRIE_TBL8_GROUP_NUM_ENTRIES;
+
+	memset(lpm->tbl24, 0, sizeof(lpm->tbl24));
+	memset(lpm->tbl24_depth, 0, TRIE_TBL24_NUM_ENTRIES);
+	memset(lpm->tbl8, 0, sizeof(lpm->tbl8[0]) * tbl8_entries);
+	memset(lpm->tbl8_depth, 0, tbl8_entries);
+	tbl8_pool_init(lpm);
+
+	rte_hash_reset(lpm->rules_tbl);
+	lpm->used_rules = 0;
+	memset(lpm->depth_rules, 0, sizeof(lpm->depth_rules));
+}
+
+int __rte_experimental
+rte_lpm6_trie_is_rule_present(struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint8_t depth, uint32_t *next_hop)
+{
+	struct lpm6_trie_rule_key key;
+	void *data;
+
+	/* Check user arguments. */
+	if (lpm == NULL || ip == NULL || next_hop == NULL || depth < 1 ||
+			depth > RTE_LPM6_TRIE_MAX_DEPTH)
+		return -EINVAL;
+
+	rule_key_init(&key, ip, depth);
+	if (rte_hash_lookup_data(lpm->rules_tbl, &key, &data) < 0)
+		return 0;
+
+	*next_hop = (uint32_t)(uintptr_t)data;
+
+	return 1;
+}
+
+int __rte_experimental
+rte_lpm6_trie_lookup(const struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint32_t *next_hop)
+{
+	unsigned int byte = TRIE_TBL8_FIRST_BYTE;
+	uint32_t ent;
+
+	/* DEBUG: Check user input arguments. */
+	if (lpm == NULL || ip == NULL || next_hop == NULL)
+		return -EINVAL;
+
+	ent = lpm->tbl24[tbl24_index(ip)];
+	while (ent & TRIE_ENTRY_EXT)
+		ent = tbl8_group(lpm, ent >> TRIE_ENTRY_SHIFT)[ip[byte++]];
+
+	if (!(ent & TRIE_ENTRY_VALID))
+		return -ENOENT;
+
+	*next_hop = ent >> TRIE_ENTRY_SHIFT;
+
+	return 0;
+}
+
+int __rte_experimental
+rte_lpm6_trie_lookup_bulk(const struct rte_lpm6_trie *lpm,
+		uint8_t ips[][RTE_LPM6_TRIE_IPV6_ADDR_SIZE],
+		int32_t *next_hops, unsigned int n)
+{
+	const uint32_t *ptr[TRIE_LOOKUP_BULK];
+	uint32_t ent[TRIE_LOOKUP_BULK];
+	unsigned int i, j, m, byte;
+	uint64_t pending;
+
+	/* DEBUG: Check user input arguments. */
+	if (lpm == NULL || ips == NULL || next_hops == NULL)
+		return -EINVAL;
+
+	for (i = 0; i < n; i += m) {
+		m = RTE_MIN(n - i, (unsigned int)TRIE_LOOKUP_BULK);
+
+		/* Walk each level for the whole batch before the next one. */
+		for (j = 0; j < m; j++) {
+			ptr[j] = &lpm->tbl24[tbl24_index(ips[i + j])];
+			rte_prefetch0(ptr[j]);
+		}
+		pending = 0;
+		for (j = 0; j < m; j++) {
+			ent[j] = *ptr[j];
+			if (ent[j] & TRIE_ENTRY_EXT)
+				pending |= UINT64_C(1) << j;
+		}
+
+		for (byte = TRIE_TBL8_FIRST_BYTE; pending != 0; byte++) {
+			uint64_t p;
+
+			for (p = pending; p != 0; p &= p - 1) {
+				j = __builtin_ctzll(p);
+				ptr[j] = &tbl8_group(lpm, ent[j] >>
+					TRIE_ENTRY_SHIFT)[ips[i + j][byte]];
+				rte_prefetch0(ptr[j]);
+			}
+			for (p = pending; p != 0; p &= p - 1) {
+				j = __builtin_ctzll(p);
+				ent[j] = *ptr[j];
+				if (!(ent[j] & TRIE_ENTRY_EXT))
+					pending &= ~(UINT64_C(1) << j);
+			}
+		}
+
+		for (j = 0; j < m; j++)
+			next_hops[i + j] = (ent[j] & TRIE_ENTRY_VALID) ?
+				(int32_t)(ent[j] >> TRIE_ENTRY_SHIFT) : -1;
+	}
+
+	return 0;
+}
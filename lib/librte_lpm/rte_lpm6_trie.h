@@ -0,0 +1,242 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_LPM6_TRIE_H_
+#define _RTE_LPM6_TRIE_H_
+
+/**
+ * @file
+ * RTE IPv6 Longest Prefix Match (LPM) trie
+ *
+ * Alternative IPv6 LPM engine: a 24-bit first level (tbl24) followed by
+ * 8-bit stride groups (tbl8), one per level down to the longest prefix.
+ * The lookup entries only hold a next hop or the index of the next group,
+ * the prefix depths being kept aside for the control plane. Groups whose
+ * entries become identical are folded back into their parent entry.
+ *
+ * Routes are added and deleted incrementally: only the entries covered by
+ * the prefix are rewritten, using the rules table to find the prefix that
+ * a deleted one was hiding. Bulk lookups walk the levels of a batch of
+ * addresses in lockstep, so that the cache misses of the batch overlap.
+ *
+ * The functions updating the table are not multi-thread safe. A new group
+ * is filled before the entry pointing to it is written, so that lookups
+ * running concurrently with an update see each route either fully added
+ * or not at all.
+ */
+
+#include <stdint.h>
+
+#include <rte_compat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Max depth of a prefix. */
+#define RTE_LPM6_TRIE_MAX_DEPTH              128
+/** Size of an IPv6 address. */
+#define RTE_LPM6_TRIE_IPV6_ADDR_SIZE          16
+/** Max number of characters in a trie name. */
+#define RTE_LPM6_TRIE_NAMESIZE                32
+/** Max next hop value. */
+#define RTE_LPM6_TRIE_MAX_NEXT_HOP    ((1 << 30) - 1)
+/** Max number of tbl8 groups. */
+#define RTE_LPM6_TRIE_MAX_TBL8S         (1 << 24)
+
+/** IPv6 LPM trie. */
+struct rte_lpm6_trie;
+
+/** IPv6 LPM trie configuration. */
+struct rte_lpm6_trie_config {
+	uint32_t max_rules;      /**< Max number of rules. */
+	uint32_t number_tbl8s;   /**< Number of tbl8 groups to allocate. */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create an IPv6 LPM trie.
+ *
+ * @param name
+ *   Trie name
+ * @param socket_id
+ *   NUMA socket ID for the trie memory allocation
+ * @param config
+ *   Structure containing the configuration
+ * @return
+ *   Handle to the trie on success, NULL otherwise with rte_errno set:
+ *    - EINVAL - invalid parameter passed to function
+ *    - EEXIST - a trie with the same name already exists
+ *    - ENOMEM - no memory left for the trie
+ */
+struct rte_lpm6_trie * __rte_experimental
+rte_lpm6_trie_create(const char *name, int socket_id,
+		const struct rte_lpm6_trie_config *config);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free an IPv6 LPM trie.
+ *
+ * @param lpm
+ *   Trie handle, or NULL
+ */
+void __rte_experimental
+rte_lpm6_trie_free(struct rte_lpm6_trie *lpm);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add a route to the trie, or update its next hop if already present.
+ *
+ * @param lpm
+ *   Trie handle
+ * @param ip
+ *   IP address of the route
+ * @param depth
+ *   Depth of the route, 1 to RTE_LPM6_TRIE_MAX_DEPTH
+ * @param next_hop
+ *   Next hop of the route, up to RTE_LPM6_TRIE_MAX_NEXT_HOP
+ * @return
+ *   0 on success, -EINVAL on invalid parameters, -ENOSPC if the rules table
+ *   or the tbl8 groups are exhausted.
+ */
+int __rte_experimental
+rte_lpm6_trie_add(struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint8_t depth, uint32_t next_hop);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add a batch of routes to the trie. The routes are added by increasing
+ * depth, so that the entries of the shorter prefixes are written before
+ * the groups of the longer ones are created.
+ *
+ * @param lpm
+ *   Trie handle
+ * @param ips
+ *   Array of IP addresses of the routes
+ * @param depths
+ *   Array of depths of the routes
+ * @param next_hops
+ *   Array of next hops of the routes
+ * @param n
+ *   Number of routes
+ * @return
+ *   0 on success, -EINVAL on invalid parameters, no route being added,
+ *   -ENOMEM if no memory is left to sort the batch, -ENOSPC if the rules
+ *   table or the tbl8 groups are exhausted, the other routes being added.
+ */
+int __rte_experimental
+rte_lpm6_trie_add_bulk(struct rte_lpm6_trie *lpm,
+		uint8_t ips[][RTE_LPM6_TRIE_IPV6_ADDR_SIZE],
+		const uint8_t *depths, const uint32_t *next_hops,
+		unsigned int n);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete a route from the trie.
+ *
+ * @param lpm
+ *   Trie handle
+ * @param ip
+ *   IP address of the route
+ * @param depth
+ *   Depth of the route
+ * @return
+ *   0 on success, -EINVAL on invalid parameters, -ENOENT if the route is
+ *   not in the trie, -ENOSPC if no tbl8 group is left to split an entry
+ *   shared with other routes.
+ */
+int __rte_experimental
+rte_lpm6_trie_delete(struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint8_t depth);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Delete all the routes of the trie.
+ *
+ * @param lpm
+ *   Trie handle
+ */
+void __rte_experimental
+rte_lpm6_trie_delete_all(struct rte_lpm6_trie *lpm);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Check whether a route is in the trie.
+ *
+ * @param lpm
+ *   Trie handle
+ * @param ip
+ *   IP address of the route
+ * @param depth
+ *   Depth of the route
+ * @param next_hop
+ *   Next hop of the route, set if found
+ * @return
+ *   1 if the route is found, 0 if not, -EINVAL on invalid parameters.
+ */
+int __rte_experimental
+rte_lpm6_trie_is_rule_present(struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint8_t depth, uint32_t *next_hop);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Lookup an IP address in the trie.
+ *
+ * @param lpm
+ *   Trie handle
+ * @param ip
+ *   IP address to look up
+ * @param next_hop
+ *   Next hop of the most specific route matching the address, set on hit
+ * @return
+ *   0 on lookup hit, -ENOENT on lookup miss, -EINVAL on invalid parameters.
+ */
+int __rte_experimental
+rte_lpm6_trie_lookup(const struct rte_lpm6_trie *lpm, const uint8_t *ip,
+		uint32_t *next_hop);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Lookup a batch of IP addresses in the trie.
+ *
+ * @param lpm
+ *   Trie handle
+ * @param ips
+ *   Array of IP addresses to look up
+ * @param next_hops
+ *   Next hop of the most specific route matching each address, or -1 on
+ *   lookup miss
+ * @param n
+ *   Number of addresses
+ * @return
+ *   0 on success, -EINVAL on invalid parameters.
+ */
+int __rte_experimental
+rte_lpm6_trie_lookup_bulk(const struct rte_lpm6_trie *lpm,
+		uint8_t ips[][RTE_LPM6_TRIE_IPV6_ADDR_SIZE],
+		int32_t *next_hops, unsigned int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_LPM6_TRIE_H_ */
@@ -115,6 +115,109 @@ rte_lpm_lookupx4(const struct rte_lpm *lpm, xmm_t ip, uint32_t hop[4],
 	hop[3] = (tbl[3] & RTE_LPM_LOOKUP_SUCCESS) ? tbl[3] & 0x00FFFFFF : defv;
 }
 
+#ifdef RTE_MACHINE_CPUFLAG_AVX2
+
+/**
+ * Lookup eight IP addresses in an LPM table, using AVX2 gathers.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ip
+ *   Eight IPs to be looked up in the LPM table
+ * @param hop
+ *   Next hop of the most specific rule found for each IP, or defv if the
+ *   lookup failed for this IP.
+ * @param defv
+ *   Default value to populate into corresponding element of hop[] array,
+ *   if lookup would fail.
+ */
+static inline void
+rte_lpm_lookupx8(const struct rte_lpm *lpm, __m256i ip, uint32_t hop[8],
+	uint32_t defv)
+{
+	__m256i i8, tbl, ext, hit;
+
+	const __m256i mask8 = _mm256_set1_epi32(UINT8_MAX);
+	const __m256i mask_xv =
+		_mm256_set1_epi32(RTE_LPM_VALID_EXT_ENTRY_BITMASK);
+	const __m256i mask_v = _mm256_set1_epi32(RTE_LPM_LOOKUP_SUCCESS);
+	const __m256i mask_res = _mm256_set1_epi32(0x00FFFFFF);
+
+	/* extract values from tbl24[], all misses being in flight at once. */
+	tbl = _mm256_i32gather_epi32((const int *)lpm->tbl24,
+			_mm256_srli_epi32(ip, CHAR_BIT), sizeof(uint32_t));
+
+	/* extract values from tbl8[] for the extended entries only. */
+	ext = _mm256_cmpeq_epi32(_mm256_and_si256(tbl, mask_xv), mask_xv);
+	if (unlikely(!_mm256_testz_si256(ext, ext))) {
+		i8 = _mm256_add_epi32(_mm256_and_si256(ip, mask8),
+			_mm256_slli_epi32(_mm256_and_si256(tbl, mask_res),
+				CHAR_BIT));
+		tbl = _mm256_mask_i32gather_epi32(tbl,
+				(const int *)lpm->tbl8, i8, ext,
+				sizeof(uint32_t));
+	}
+
+	hit = _mm256_cmpeq_epi32(_mm256_and_si256(tbl, mask_v), mask_v);
+	_mm256_storeu_si256((__m256i *)hop,
+		_mm256_blendv_epi8(_mm256_set1_epi32(defv),
+			_mm256_and_si256(tbl, mask_res), hit));
+}
+
+#endif /* RTE_MACHINE_CPUFLAG_AVX2 */
+
+#ifdef RTE_MACHINE_CPUFLAG_AVX512F
+
+/**
+ * Lookup sixteen IP addresses in an LPM table, using AVX512 gathers.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ip
+ *   Sixteen IPs to be looked up in the LPM table
+ * @param hop
+ *   Next hop of the most specific rule found for each IP, or defv if the
+ *   lookup failed for this IP.
+ * @param defv
+ *   Default value to populate into corresponding element of hop[] array,
+ *   if lookup would fail.
+ */
+static inline void
+rte_lpm_lookupx16(const struct rte_lpm *lpm, __m512i ip, uint32_t hop[16],
+	uint32_t defv)
+{
+	__m512i i8, tbl;
+	__mmask16 ext, hit;
+
+	const __m512i mask8 = _mm512_set1_epi32(UINT8_MAX);
+	const __m512i mask_xv =
+		_mm512_set1_epi32(RTE_LPM_VALID_EXT_ENTRY_BITMASK);
+	const __m512i mask_v = _mm512_set1_epi32(RTE_LPM_LOOKUP_SUCCESS);
+	const __m512i mask_res = _mm512_set1_epi32(0x00FFFFFF);
+
+	/* extract values from tbl24[], all misses being in flight at once. */
+	tbl = _mm512_i32gather_epi32(_mm512_srli_epi32(ip, CHAR_BIT),
+			(const void *)lpm->tbl24, sizeof(uint32_t));
+
+	/* extract values from tbl8[] for the extended entries only. */
+	ext = _mm512_cmpeq_epi32_mask(_mm512_and_si512(tbl, mask_xv),
+			mask_xv);
+	if (unlikely(ext != 0)) {
+		i8 = _mm512_add_epi32(_mm512_and_si512(ip, mask8),
+			_mm512_slli_epi32(_mm512_and_si512(tbl, mask_res),
+				CHAR_BIT));
+		tbl = _mm512_mask_i32gather_epi32(tbl, ext, i8,
+				(const void *)lpm->tbl8, sizeof(uint32_t));
+	}
+
+	hit = _mm512_test_epi32_mask(tbl, mask_v);
+	_mm512_storeu_si512(hop, _mm512_mask_blend_epi32(hit,
+			_mm512_set1_epi32(defv),
+			_mm512_and_si512(tbl, mask_res)));
+}
+
+#endif /* RTE_MACHINE_CPUFLAG_AVX512F */
+
 #ifdef __cplusplus
 }
 #endif
@@ -603,6 +603,7 @@ struct rte_mbuf {
 
 	uint16_t buf_len;         /**< Length of segment buffer. */
 
+#ifndef RTE_MBUF_TX_OFFLOAD_CACHELINE0
 	/** Valid if PKT_RX_TIMESTAMP is set. The unit and time reference
 	 * are not normalized but are always the same for a given port.
 	 */
@@ -619,8 +620,14 @@ struct rte_mbuf {
 
 	struct rte_mempool *pool; /**< Pool from which mbuf was allocated. */
 	struct rte_mbuf *next;    /**< Next segment of scattered packet. */
+#endif
 
-	/* fields to support TX offloads */
+	/*
+	 * Fields to support TX offloads. With RTE_MBUF_TX_OFFLOAD_CACHELINE0,
+	 * they are swapped with the timestamp, so that the datapaths reading
+	 * or writing both the Rx and Tx offload fields, like vhost and
+	 * virtio, find them on the first cache line.
+	 */
 	RTE_STD_C11
 	union {
 		uint64_t tx_offload;       /**< combined for easy fetch */
@@ -642,6 +649,25 @@ struct rte_mbuf {
 		};
 	};
 
+#ifdef RTE_MBUF_TX_OFFLOAD_CACHELINE0
+	/* second cache line - fields only used in slow path */
+	MARKER cacheline1 __rte_cache_min_aligned;
+
+	RTE_STD_C11
+	union {
+		void *userdata;   /**< Can be used for external metadata */
+		uint64_t udata64; /**< Allow 8-byte userdata on 32-bit */
+	};
+
+	struct rte_mempool *pool; /**< Pool from which mbuf was allocated. */
+	struct rte_mbuf *next;    /**< Next segment of scattered packet. */
+
+	/** Valid if PKT_RX_TIMESTAMP is set. The unit and time reference
+	 * are not normalized but are always the same for a given port.
+	 */
+	uint64_t timestamp;
+#endif
+
 	/** Size of the application private data. In case of an indirect
 	 * mbuf, it stores the direct mbuf private data size. */
 	uint16_t priv_size;
@@ -850,8 +876,45 @@ rte_mbuf_to_priv(struct rte_mbuf *m)
 struct rte_pktmbuf_pool_private {
 	uint16_t mbuf_data_room_size; /**< Size of data space in each mbuf. */
 	uint16_t mbuf_priv_size;      /**< Size of private area in each mbuf. */
+	uint32_t flags; /**< RTE_PKTMBUF_POOL_F_* flags of the pool. */
 };
 
+/**
+ * The mbufs of the pool are attached to pinned external buffers,
+ * see rte_pktmbuf_pool_create_extbuf().
+ */
+#define RTE_PKTMBUF_POOL_F_PINNED_EXT_BUF (1 << 0)
+
+/**
+ * Get the flags of a packet mbuf pool.
+ *
+ * @param mp
+ *   The packet mbuf pool.
+ * @return
+ *   The RTE_PKTMBUF_POOL_F_* flags of the pool.
+ */
+static inline uint32_t
+rte_pktmbuf_priv_flags(struct rte_mempool *mp)
+{
+	struct rte_pktmbuf_pool_private *mbp_priv;
+
+	mbp_priv = (struct rte_pktmbuf_pool_private *)rte_mempool_get_priv(mp);
+	return mbp_priv->flags;
+}
+
+/**
+ * Returns TRUE if given mbuf has a pinned external buffer, or FALSE
+ * otherwise.
+ *
+ * A pinned external buffer is attached to the mbuf at pool creation and
+ * stays attached when the mbuf is freed: it is the data buffer of the
+ * mbuf, like the data room of a direct mbuf.
+ */
+#define RTE_MBUF_HAS_PINNED_EXTBUF(mb) \
+	(RTE_MBUF_HAS_EXTBUF(mb) && \
+	 (rte_pktmbuf_priv_flags((mb)->pool) & \
+	  RTE_PKTMBUF_POOL_F_PINNED_EXT_BUF))
+
 #ifdef RTE_LIBRTE_MBUF_DEBUG
 
 /**  check mbuf type in debug mode */
@@ -1080,9 +1143,9 @@ static inline struct rte_mbuf *rte_mbuf_raw_alloc(struct rte_mempool *mp)
 /**
  * Put mbuf back into its original mempool.
  *
- * The caller must ensure that the mbuf is direct and properly
- * reinitialized (refcnt=1, next=NULL, nb_segs=1), as done by
- * rte_pktmbuf_prefree_seg().
+ * The caller must ensure that the mbuf is direct, or has a pinned
+ * external buffer, and is properly reinitialized (refcnt=1, next=NULL,
+ * nb_segs=1), as done by rte_pktmbuf_prefree_seg().
  *
  * This function should be used with care, when optimization is
  * required. For standard needs, prefer rte_pktmbuf_free() or
@@ -1094,7 +1157,7 @@ static inline struct rte_mbuf *rte_mbuf_raw_alloc(struct rte_mempool *mp)
 static __rte_always_inline void
 rte_mbuf_raw_free(struct rte_mbuf *m)
 {
-	RTE_ASSERT(RTE_MBUF_DIRECT(m));
+	RTE_ASSERT(RTE_MBUF_DIRECT(m) || RTE_MBUF_HAS_PINNED_EXTBUF(m));
 	RTE_ASSERT(rte_mbuf_refcnt_read(m) == 1);
 	RTE_ASSERT(m->next == NULL);
 	RTE_ASSERT(m->nb_segs == 1);
@@ -1225,6 +1288,78 @@ rte_pktmbuf_pool_create_by_ops(const char *name, unsigned int n,
 	unsigned int cache_size, uint16_t priv_size, uint16_t data_room_size,
 	int socket_id, const char *ops_name);
 
+/**
+ * A memory area holding the pinned external buffers of a packet mbuf pool,
+ * see rte_pktmbuf_pool_create_extbuf().
+ */
+struct rte_pktmbuf_extmem {
+	void *buf_ptr;       /**< Virtual address of the memory area. */
+	rte_iova_t buf_iova; /**< IO address of the area, or RTE_BAD_IOVA. */
+	size_t buf_len;      /**< Length of the area in bytes. */
+	uint16_t elt_size;   /**< Size of each buffer in the area in bytes. */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Create a packet mbuf pool with pinned external buffers.
+ *
+ * The data buffers of the mbufs are not allocated after the rte_mbuf
+ * structures, but split from the memory areas given by the application:
+ * each mbuf is attached at creation to a buffer of elt_size bytes and
+ * stays attached to it, so allocating and freeing the mbufs does not
+ * involve any shared info management or free callback. This allows
+ * large buffers, or buffers in a memory registered to a device or
+ * shared with another process, to be used as any packet mbuf.
+ *
+ * The mbufs have the EXT_ATTACHED_MBUF flag set. They can be cloned into
+ * a regular packet mbuf pool: a mbuf freed while its buffer is still
+ * referenced by clones goes back to the pool when the last clone is
+ * freed. They cannot be attached to another buffer.
+ *
+ * The application must keep the memory areas valid until the pool is
+ * freed.
+ *
+ * @param name
+ *   The name of the mbuf pool.
+ * @param n
+ *   The number of elements in the mbuf pool, the areas must hold at
+ *   least n buffers.
+ * @param cache_size
+ *   Size of the per-core object cache. See rte_mempool_create() for
+ *   details.
+ * @param priv_size
+ *   Size of application private are between the rte_mbuf structure
+ *   and the shared info of the buffer. This value must be aligned to
+ *   RTE_MBUF_PRIV_ALIGN.
+ * @param data_room_size
+ *   Size of data buffer in each mbuf, including RTE_PKTMBUF_HEADROOM.
+ *   It must not be larger than the elt_size of the areas.
+ * @param socket_id
+ *   The socket identifier where the memory should be allocated. The
+ *   value can be *SOCKET_ID_ANY* if there is no NUMA constraint for the
+ *   reserved zone.
+ * @param ext_mem
+ *   Array of memory areas holding the external buffers.
+ * @param ext_num
+ *   Number of memory areas in the array.
+ * @return
+ *   The pointer to the new allocated mempool, on success. NULL on error
+ *   with rte_errno set appropriately. Possible rte_errno values include:
+ *    - EINVAL - cache size provided is too large, priv_size is not
+ *      aligned or a memory area is invalid.
+ *    - ENOMEM - not enough buffers in the memory areas, or no
+ *      appropriate memory area found in which to create memzone
+ *    - ENOSPC - the maximum number of memzones has already been allocated
+ *    - EEXIST - a memzone with the same name already exists
+ */
+struct rte_mempool * __rte_experimental
+rte_pktmbuf_pool_create_extbuf(const char *name, unsigned int n,
+	unsigned int cache_size, uint16_t priv_size, uint16_t data_room_size,
+	int socket_id, const struct rte_pktmbuf_extmem *ext_mem,
+	unsigned int ext_num);
+
 /**
  * Get the data room size of mbufs stored in a pktmbuf_pool
  *
@@ -1300,7 +1435,8 @@ static inline void rte_pktmbuf_reset(struct rte_mbuf *m)
 	m->nb_segs = 1;
 	m->port = MBUF_INVALID_PORT;
 
-	m->ol_flags = 0;
+	/* a pinned external buffer stays attached */
+	m->ol_flags &= EXT_ATTACHED_MBUF;
 	m->packet_type = 0;
 	rte_pktmbuf_reset_headroom(m);
 
@@ -1385,6 +1521,82 @@ static inline int rte_pktmbuf_alloc_bulk(struct rte_mempool *pool,
 	return 0;
 }
 
+/** Number of mbufs prefetched ahead by rte_pktmbuf_alloc_bulk_rearm(). */
+#define RTE_PKTMBUF_ALLOC_PREFETCH 4
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: This API may change without prior notice.
+ *
+ * Allocate a bulk of mbufs for an Rx refill, initializing the fields of
+ * their first cache line from a rearm value instead of resetting them one
+ * by one.
+ *
+ * The 8 bytes at rearm_data (data_off, refcnt, nb_segs and port) are set
+ * to rearm, and the following 24 bytes (ol_flags, packet_type, pkt_len,
+ * data_len, vlan_tci and hash.rss) are zeroed, which the compilers turn
+ * into a few vector stores. As in rte_pktmbuf_reset(), ol_flags keeps
+ * EXT_ATTACHED_MBUF in a pool with pinned external buffers. The mbufs are
+ * prefetched a few entries ahead, as the objects at the bottom of a
+ * mempool cache may be cold. Unlike rte_pktmbuf_alloc_bulk(),
+ * vlan_tci_outer and the Tx offload fields are not reset, so the mbufs
+ * must not be transmitted as they are.
+ *
+ * The rearm value is usually read from the rearm_data marker of a template
+ * mbuf with refcnt and nb_segs set to 1, data_off set to the headroom and
+ * port set to the Rx port, as done by the vector Rx PMDs.
+ *
+ * @param pool
+ *   The mempool from which mbufs are allocated.
+ * @param mbufs
+ *   Array of pointers to mbufs.
+ * @param count
+ *   Array size.
+ * @param rearm
+ *   Value of the rearm_data marker of the mbufs.
+ * @return
+ *   - 0: Success
+ *   - -ENOENT: Not enough entries in the mempool; no mbufs are retrieved.
+ */
+static inline int __rte_experimental
+rte_pktmbuf_alloc_bulk_rearm(struct rte_mempool *pool,
+	struct rte_mbuf **mbufs, unsigned int count, uint64_t rearm)
+{
+	uint64_t ol_flags = 0;
+	unsigned int i;
+	uint64_t *p;
+	int rc;
+
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, ol_flags) !=
+			offsetof(struct rte_mbuf, rearm_data) + 8);
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, rx_descriptor_fields1) !=
+			offsetof(struct rte_mbuf, rearm_data) + 16);
+
+	rc = rte_mempool_get_bulk(pool, (void **)mbufs, count);
+	if (unlikely(rc))
+		return rc;
+
+	if (rte_pktmbuf_priv_flags(pool) & RTE_PKTMBUF_POOL_F_PINNED_EXT_BUF)
+		ol_flags = EXT_ATTACHED_MBUF;
+
+	for (i = 0; i < count && i < RTE_PKTMBUF_ALLOC_PREFETCH; i++)
+		rte_prefetch0(mbufs[i]);
+
+	for (i = 0; i < count; i++) {
+		if (i + RTE_PKTMBUF_ALLOC_PREFETCH < count)
+			rte_prefetch0(mbufs[i + RTE_PKTMBUF_ALLOC_PREFETCH]);
+		MBUF_RAW_ALLOC_CHECK(mbufs[i]);
+		p = (uint64_t *)&mbufs[i]->rearm_data;
+		p[0] = rearm;
+		p[1] = ol_flags;
+		p[2] = 0;
+		p[3] = 0;
+		__rte_mbuf_sanity_check(mbufs[i], 1);
+	}
+
+	return 0;
+}
+
 /**
  * Initialize shared data at the end of an external buffer before attaching
  * to a mbuf by ``rte_pktmbuf_attach_extbuf()``. This is not a mandatory
@@ -1649,10 +1861,15 @@ static inline void rte_pktmbuf_detach(struct rte_mbuf *m)
 	uint32_t mbuf_size, buf_len;
 	uint16_t priv_size;
 
-	if (RTE_MBUF_HAS_EXTBUF(m))
+	if (RTE_MBUF_HAS_EXTBUF(m)) {
+		/* a pinned external buffer is never detached from its mbuf */
+		if (rte_pktmbuf_priv_flags(mp) &
+				RTE_PKTMBUF_POOL_F_PINNED_EXT_BUF)
+			return;
 		__rte_pktmbuf_free_extbuf(m);
-	else
+	} else {
 		__rte_pktmbuf_free_direct(m);
+	}
 
 	priv_size = rte_pktmbuf_priv_size(mp);
 	mbuf_size = (uint32_t)(sizeof(struct rte_mbuf) + priv_size);
@@ -1667,6 +1884,38 @@ static inline void rte_pktmbuf_detach(struct rte_mbuf *m)
 	m->ol_flags = 0;
 }
 
+/**
+ * @internal Release the reference of a freed mbuf on its pinned external
+ * buffer; used by rte_pktmbuf_prefree_seg().
+ *
+ * If the buffer is still referenced by clones, the mbuf is returned to
+ * its pool by the free callback of the buffer when the last clone is
+ * freed.
+ *
+ * @param m
+ *   The mbuf with a pinned external buffer.
+ * @return
+ *   - (0) if the mbuf can be recycled or freed.
+ *   - (1) if the buffer is still referenced by clones.
+ */
+static inline int
+__rte_pktmbuf_pinned_extbuf_decref(struct rte_mbuf *m)
+{
+	struct rte_mbuf_ext_shared_info *shinfo = m->shinfo;
+
+	/* the mbuf is being freed, only keep the buffer attached */
+	m->ol_flags = EXT_ATTACHED_MBUF;
+
+	if (likely(rte_mbuf_ext_refcnt_read(shinfo) == 1))
+		return 0;
+
+	if (rte_mbuf_ext_refcnt_update(shinfo, -1) != 0)
+		return 1;
+
+	rte_mbuf_ext_refcnt_set(shinfo, 1);
+	return 0;
+}
+
 /**
  * Decrease reference counter and unlink a mbuf segment
  *
@@ -1688,8 +1937,12 @@ rte_pktmbuf_prefree_seg(struct rte_mbuf *m)
 
 	if (likely(rte_mbuf_refcnt_read(m) == 1)) {
 
-		if (!RTE_MBUF_DIRECT(m))
+		if (!RTE_MBUF_DIRECT(m)) {
 			rte_pktmbuf_detach(m);
+			if (RTE_MBUF_HAS_PINNED_EXTBUF(m) &&
+			    __rte_pktmbuf_pinned_extbuf_decref(m))
+				return NULL;
+		}
 
 		if (m->next != NULL) {
 			m->next = NULL;
@@ -1700,14 +1953,20 @@ rte_pktmbuf_prefree_seg(struct rte_mbuf *m)
 
 	} else if (__rte_mbuf_refcnt_update(m, -1) == 0) {
 
-		if (!RTE_MBUF_DIRECT(m))
+		/* before a pinned buffer may defer the free to its last clone */
+		rte_mbuf_refcnt_set(m, 1);
+
+		if (!RTE_MBUF_DIRECT(m)) {
 			rte_pktmbuf_detach(m);
+			if (RTE_MBUF_HAS_PINNED_EXTBUF(m) &&
+			    __rte_pktmbuf_pinned_extbuf_decref(m))
+				return NULL;
+		}
 
 		if (m->next != NULL) {
 			m->next = NULL;
 			m->nb_segs = 1;
 		}
-		rte_mbuf_refcnt_set(m, 1);
 
 		return m;
 	}
@@ -1754,6 +2013,27 @@ static inline void rte_pktmbuf_free(struct rte_mbuf *m)
 	}
 }
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Free a bulk of packet mbufs back into their original mempools.
+ *
+ * Free the mbufs of the array and all their segments, like
+ * rte_pktmbuf_free() would do for each of them, but return the
+ * segments to their mempool by bulks: consecutive segments from the
+ * same mempool are put with a single rte_mempool_put_bulk() call.
+ * As with rte_pktmbuf_free(), the reference counter of a segment is
+ * only updated atomically if it is shared.
+ *
+ * @param mbufs
+ *   Array of pointers to packet mbufs. NULL pointers are skipped.
+ * @param count
+ *   Number of pointers in the array.
+ */
+void __rte_experimental
+rte_pktmbuf_free_bulk(struct rte_mbuf **mbufs, unsigned int count);
+
 /**
  * Creates a "clone" of the given packet mbuf.
  *
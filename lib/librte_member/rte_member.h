@@ -66,6 +66,12 @@ typedef uint16_t member_set_t;
 #define RTE_MEMBER_BUCKET_ENTRIES 16
 /** Maximum number of characters in setsum name. */
 #define RTE_MEMBER_NAMESIZE 32
+/**
+ * Flag to enable lock-free lookups of a HT setsummary concurrent with the
+ * updates of a single writer: the lookups retry when the table changed
+ * under them.
+ */
+#define RTE_MEMBER_EXTRA_FLAGS_RW_CONCURRENCY_LF 0x01
 
 /** @internal Hash function used by membership library. */
 #if defined(RTE_ARCH_X86) || defined(RTE_MACHINE_CPUFLAG_CRC32)
@@ -128,6 +134,7 @@ struct rte_member_setsum {
 	/* For runtime selecting AVX, scalar, etc for signature comparison. */
 	enum rte_member_sig_compare_function sig_cmp_fn;
 	uint8_t cache;			/* If it is cache mode for ht based. */
+	uint8_t rw_concurrency_lf;	/* If lock-free lookups for ht based. */
 
 	/* Vector bloom filter. */
 	uint32_t num_set;		/* Number of set (bf) in vbf. */
@@ -144,6 +151,8 @@ struct rte_member_setsum {
 	/* Second cache line should start here. */
 	uint32_t socket_id;          /* NUMA Socket ID for memory. */
 	char name[RTE_MEMBER_NAMESIZE]; /* Name of this set summary. */
+	/* Table change counter, odd while an update is in progress. */
+	uint32_t *tbl_chng_cnt;
 } __rte_cache_aligned;
 
 /**
@@ -263,6 +272,16 @@ struct rte_member_parameters {
 	uint32_t sec_hash_seed;
 
 	int socket_id;			/**< NUMA Socket ID for memory. */
+
+	/**
+	 * Bitmask of RTE_MEMBER_EXTRA_FLAGS_* flags.
+	 *
+	 * With RTE_MEMBER_EXTRA_FLAGS_RW_CONCURRENCY_LF, the lookups of a HT
+	 * setsummary may run concurrently with the adds, deletes and resets
+	 * of a single writer thread. vBF lookups are always safe against
+	 * concurrent adds, as an add only sets bits.
+	 */
+	uint32_t extra_flag;
 };
 
 /**
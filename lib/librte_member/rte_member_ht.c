@@ -4,6 +4,7 @@
 
 #include <rte_errno.h>
 #include <rte_malloc.h>
+#include <rte_pause.h>
 #include <rte_prefetch.h>
 #include <rte_random.h>
 #include <rte_log.h>
@@ -15,6 +16,66 @@
 #include "rte_member_x86.h"
 #endif
 
+/*
+ * With lock-free lookups, the writer updates the table under a sequence
+ * counter: the counter is odd while an update is in progress, and the
+ * lookups retry until they read the same even value before and after
+ * reading the buckets. This also hides the entries transiently flagged or
+ * duplicated by the cuckoo displacements.
+ */
+static inline void
+write_begin(const struct rte_member_setsum *ss)
+{
+	if (!ss->rw_concurrency_lf)
+		return;
+
+	__atomic_store_n(ss->tbl_chng_cnt, *ss->tbl_chng_cnt + 1,
+			__ATOMIC_RELAXED);
+	/* The stores to the buckets should not move above the store to
+	 * tbl_chng_cnt.
+	 */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+write_end(const struct rte_member_setsum *ss)
+{
+	if (!ss->rw_concurrency_lf)
+		return;
+
+	__atomic_store_n(ss->tbl_chng_cnt, *ss->tbl_chng_cnt + 1,
+			__ATOMIC_RELEASE);
+}
+
+static inline uint32_t
+read_begin(const struct rte_member_setsum *ss)
+{
+	uint32_t cnt;
+
+	if (!ss->rw_concurrency_lf)
+		return 0;
+
+	/* Wait for the update in progress to complete */
+	while ((cnt = __atomic_load_n(ss->tbl_chng_cnt,
+			__ATOMIC_ACQUIRE)) & 1)
+		rte_pause();
+
+	return cnt;
+}
+
+static inline int
+read_retry(const struct rte_member_setsum *ss, uint32_t cnt)
+{
+	if (!ss->rw_concurrency_lf)
+		return 0;
+
+	/* The loads from the buckets should not move below the load from
+	 * tbl_chng_cnt.
+	 */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(ss->tbl_chng_cnt, __ATOMIC_RELAXED) != cnt;
+}
+
 /* Search bucket for entry with tmp_sig and update set_id */
 static inline int
 update_entry_search(uint32_t bucket_id, member_sig_t tmp_sig,
@@ -102,6 +163,18 @@ rte_member_create_ht(struct rte_member_setsum *ss,
 		return -ENOMEM;
 	}
 
+	if (params->extra_flag & RTE_MEMBER_EXTRA_FLAGS_RW_CONCURRENCY_LF) {
+		ss->tbl_chng_cnt = rte_zmalloc_socket(NULL, sizeof(uint32_t),
+				RTE_CACHE_LINE_SIZE, ss->socket_id);
+		if (ss->tbl_chng_cnt == NULL) {
+			RTE_MEMBER_LOG(ERR, "memory allocation failed for HT "
+						"setsummary\n");
+			rte_free(buckets);
+			return -ENOMEM;
+		}
+		ss->rw_concurrency_lf = 1;
+	}
+
 	ss->table = buckets;
 	ss->bucket_cnt = num_buckets;
 	ss->bucket_mask = num_buckets - 1;
@@ -164,17 +237,13 @@ get_buckets_index(const struct rte_member_setsum *ss, const void *key,
 	}
 }
 
-int
-rte_member_lookup_ht(const struct rte_member_setsum *ss,
-		const void *key, member_set_t *set_id)
+static inline int
+search_buckets_single(const struct rte_member_setsum *ss,
+		uint32_t prim_bucket, uint32_t sec_bucket,
+		member_sig_t tmp_sig, member_set_t *set_id)
 {
-	uint32_t prim_bucket, sec_bucket;
-	member_sig_t tmp_sig;
 	struct member_ht_bucket *buckets = ss->table;
 
-	*set_id = RTE_MEMBER_NO_MATCH;
-	get_buckets_index(ss, key, &prim_bucket, &sec_bucket, &tmp_sig);
-
 	switch (ss->sig_cmp_fn) {
 #if defined(RTE_ARCH_X86) && defined(RTE_MACHINE_CPUFLAG_AVX2)
 	case RTE_MEMBER_COMPARE_AVX2:
@@ -196,12 +265,32 @@ rte_member_lookup_ht(const struct rte_member_setsum *ss,
 	return 0;
 }
 
+int
+rte_member_lookup_ht(const struct rte_member_setsum *ss,
+		const void *key, member_set_t *set_id)
+{
+	uint32_t prim_bucket, sec_bucket, cnt;
+	member_sig_t tmp_sig;
+	int ret;
+
+	get_buckets_index(ss, key, &prim_bucket, &sec_bucket, &tmp_sig);
+
+	do {
+		cnt = read_begin(ss);
+		*set_id = RTE_MEMBER_NO_MATCH;
+		ret = search_buckets_single(ss, prim_bucket, sec_bucket,
+				tmp_sig, set_id);
+	} while (read_retry(ss, cnt));
+
+	return ret;
+}
+
 uint32_t
 rte_member_lookup_bulk_ht(const struct rte_member_setsum *ss,
 		const void **keys, uint32_t num_keys, member_set_t *set_id)
 {
-	uint32_t i;
-	uint32_t num_matches = 0;
+	uint32_t i, cnt;
+	uint32_t num_matches;
 	struct member_ht_bucket *buckets = ss->table;
 	member_sig_t tmp_sig[RTE_MEMBER_LOOKUP_BULK_MAX];
 	uint32_t prim_buckets[RTE_MEMBER_LOOKUP_BULK_MAX];
@@ -214,44 +303,32 @@ rte_member_lookup_bulk_ht(const struct rte_member_setsum *ss,
 		rte_prefetch0(&buckets[sec_buckets[i]]);
 	}
 
-	for (i = 0; i < num_keys; i++) {
-		switch (ss->sig_cmp_fn) {
-#if defined(RTE_ARCH_X86) && defined(RTE_MACHINE_CPUFLAG_AVX2)
-		case RTE_MEMBER_COMPARE_AVX2:
-			if (search_bucket_single_avx(prim_buckets[i],
-					tmp_sig[i], buckets, &set_id[i]) ||
-				search_bucket_single_avx(sec_buckets[i],
-					tmp_sig[i], buckets, &set_id[i]))
-				num_matches++;
-			else
-				set_id[i] = RTE_MEMBER_NO_MATCH;
-			break;
-#endif
-		default:
-			if (search_bucket_single(prim_buckets[i], tmp_sig[i],
-					buckets, &set_id[i]) ||
-					search_bucket_single(sec_buckets[i],
-					tmp_sig[i], buckets, &set_id[i]))
+	do {
+		cnt = read_begin(ss);
+		num_matches = 0;
+
+		for (i = 0; i < num_keys; i++) {
+			if (search_buckets_single(ss, prim_buckets[i],
+					sec_buckets[i], tmp_sig[i],
+					&set_id[i]))
 				num_matches++;
 			else
 				set_id[i] = RTE_MEMBER_NO_MATCH;
 		}
-	}
+	} while (read_retry(ss, cnt));
+
 	return num_matches;
 }
 
-uint32_t
-rte_member_lookup_multi_ht(const struct rte_member_setsum *ss,
-		const void *key, uint32_t match_per_key,
+static inline uint32_t
+search_buckets_multi(const struct rte_member_setsum *ss,
+		uint32_t prim_bucket, uint32_t sec_bucket,
+		member_sig_t tmp_sig, uint32_t match_per_key,
 		member_set_t *set_id)
 {
 	uint32_t num_matches = 0;
-	uint32_t prim_bucket, sec_bucket;
-	member_sig_t tmp_sig;
 	struct member_ht_bucket *buckets = ss->table;
 
-	get_buckets_index(ss, key, &prim_bucket, &sec_bucket, &tmp_sig);
-
 	switch (ss->sig_cmp_fn) {
 #if defined(RTE_ARCH_X86) && defined(RTE_MACHINE_CPUFLAG_AVX2)
 	case RTE_MEMBER_COMPARE_AVX2:
@@ -272,16 +349,35 @@ rte_member_lookup_multi_ht(const struct rte_member_setsum *ss,
 	}
 }
 
+uint32_t
+rte_member_lookup_multi_ht(const struct rte_member_setsum *ss,
+		const void *key, uint32_t match_per_key,
+		member_set_t *set_id)
+{
+	uint32_t num_matches;
+	uint32_t prim_bucket, sec_bucket, cnt;
+	member_sig_t tmp_sig;
+
+	get_buckets_index(ss, key, &prim_bucket, &sec_bucket, &tmp_sig);
+
+	do {
+		cnt = read_begin(ss);
+		num_matches = search_buckets_multi(ss, prim_bucket,
+				sec_bucket, tmp_sig, match_per_key, set_id);
+	} while (read_retry(ss, cnt));
+
+	return num_matches;
+}
+
 uint32_t
 rte_member_lookup_multi_bulk_ht(const struct rte_member_setsum *ss,
 		const void **keys, uint32_t num_keys, uint32_t match_per_key,
 		uint32_t *match_count,
 		member_set_t *set_ids)
 {
-	uint32_t i;
-	uint32_t num_matches = 0;
+	uint32_t i, cnt;
+	uint32_t num_matches;
 	struct member_ht_bucket *buckets = ss->table;
-	uint32_t match_cnt_tmp;
 	member_sig_t tmp_sig[RTE_MEMBER_LOOKUP_BULK_MAX];
 	uint32_t prim_buckets[RTE_MEMBER_LOOKUP_BULK_MAX];
 	uint32_t sec_buckets[RTE_MEMBER_LOOKUP_BULK_MAX];
@@ -292,38 +388,21 @@ rte_member_lookup_multi_bulk_ht(const struct rte_member_setsum *ss,
 		rte_prefetch0(&buckets[prim_buckets[i]]);
 		rte_prefetch0(&buckets[sec_buckets[i]]);
 	}
-	for (i = 0; i < num_keys; i++) {
-		match_cnt_tmp = 0;
 
-		switch (ss->sig_cmp_fn) {
-#if defined(RTE_ARCH_X86) && defined(RTE_MACHINE_CPUFLAG_AVX2)
-		case RTE_MEMBER_COMPARE_AVX2:
-			search_bucket_multi_avx(prim_buckets[i], tmp_sig[i],
-				buckets, &match_cnt_tmp, match_per_key,
-				&set_ids[i*match_per_key]);
-			if (match_cnt_tmp < match_per_key)
-				search_bucket_multi_avx(sec_buckets[i],
-					tmp_sig[i], buckets, &match_cnt_tmp,
-					match_per_key,
-					&set_ids[i*match_per_key]);
-			match_count[i] = match_cnt_tmp;
-			if (match_cnt_tmp != 0)
-				num_matches++;
-			break;
-#endif
-		default:
-			search_bucket_multi(prim_buckets[i], tmp_sig[i],
-				buckets, &match_cnt_tmp, match_per_key,
-				&set_ids[i*match_per_key]);
-			if (match_cnt_tmp < match_per_key)
-				search_bucket_multi(sec_buckets[i], tmp_sig[i],
-					buckets, &match_cnt_tmp, match_per_key,
-					&set_ids[i*match_per_key]);
-			match_count[i] = match_cnt_tmp;
-			if (match_cnt_tmp != 0)
+	do {
+		cnt = read_begin(ss);
+		num_matches = 0;
+
+		for (i = 0; i < num_keys; i++) {
+			match_count[i] = search_buckets_multi(ss,
+					prim_buckets[i], sec_buckets[i],
+					tmp_sig[i], match_per_key,
+					&set_ids[i * match_per_key]);
+			if (match_count[i] != 0)
 				num_matches++;
 		}
-	}
+	} while (read_retry(ss, cnt));
+
 	return num_matches;
 }
 
@@ -453,21 +532,13 @@ make_space_bucket(const struct rte_member_setsum *ss, uint32_t bkt_idx,
 		return ret;
 }
 
-int
-rte_member_add_ht(const struct rte_member_setsum *ss,
-		const void *key, member_set_t set_id)
+static inline int
+add_entry(const struct rte_member_setsum *ss, uint32_t prim_bucket,
+		uint32_t sec_bucket, member_sig_t tmp_sig, member_set_t set_id)
 {
 	int ret;
 	unsigned int nr_pushes = 0;
-	uint32_t prim_bucket, sec_bucket;
-	member_sig_t tmp_sig;
 	struct member_ht_bucket *buckets = ss->table;
-	member_set_t flag_mask = 1U << (sizeof(member_set_t) * 8 - 1);
-
-	if (set_id == RTE_MEMBER_NO_MATCH || (set_id & flag_mask) != 0)
-		return -EINVAL;
-
-	get_buckets_index(ss, key, &prim_bucket, &sec_bucket, &tmp_sig);
 
 	/*
 	 * If it is cache based setsummary, we try overwriting (updating)
@@ -509,9 +580,31 @@ rte_member_add_ht(const struct rte_member_setsum *ss,
 	return ret;
 }
 
+int
+rte_member_add_ht(const struct rte_member_setsum *ss,
+		const void *key, member_set_t set_id)
+{
+	int ret;
+	uint32_t prim_bucket, sec_bucket;
+	member_sig_t tmp_sig;
+	member_set_t flag_mask = 1U << (sizeof(member_set_t) * 8 - 1);
+
+	if (set_id == RTE_MEMBER_NO_MATCH || (set_id & flag_mask) != 0)
+		return -EINVAL;
+
+	get_buckets_index(ss, key, &prim_bucket, &sec_bucket, &tmp_sig);
+
+	write_begin(ss);
+	ret = add_entry(ss, prim_bucket, sec_bucket, tmp_sig, set_id);
+	write_end(ss);
+
+	return ret;
+}
+
 void
 rte_member_free_ht(struct rte_member_setsum *ss)
 {
+	rte_free(ss->tbl_chng_cnt);
 	rte_free(ss->table);
 }
 
@@ -529,7 +622,9 @@ rte_member_delete_ht(const struct rte_member_setsum *ss, const void *key,
 	for (i = 0; i < RTE_MEMBER_BUCKET_ENTRIES; i++) {
 		if (tmp_sig == buckets[prim_bucket].sigs[i] &&
 				set_id == buckets[prim_bucket].sets[i]) {
+			write_begin(ss);
 			buckets[prim_bucket].sets[i] = RTE_MEMBER_NO_MATCH;
+			write_end(ss);
 			return 0;
 		}
 	}
@@ -537,7 +632,9 @@ rte_member_delete_ht(const struct rte_member_setsum *ss, const void *key,
 	for (i = 0; i < RTE_MEMBER_BUCKET_ENTRIES; i++) {
 		if (tmp_sig == buckets[sec_bucket].sigs[i] &&
 				set_id == buckets[sec_bucket].sets[i]) {
+			write_begin(ss);
 			buckets[sec_bucket].sets[i] = RTE_MEMBER_NO_MATCH;
+			write_end(ss);
 			return 0;
 		}
 	}
@@ -550,8 +647,10 @@ rte_member_reset_ht(const struct rte_member_setsum *ss)
 	uint32_t i, j;
 	struct member_ht_bucket *buckets = ss->table;
 
+	write_begin(ss);
 	for (i = 0; i < ss->bucket_cnt; i++) {
 		for (j = 0; j < RTE_MEMBER_BUCKET_ENTRIES; j++)
 			buckets[i].sets[j] = RTE_MEMBER_NO_MATCH;
 	}
+	write_end(ss);
 }
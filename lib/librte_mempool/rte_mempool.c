@@ -735,6 +735,72 @@ mempool_cache_init(struct rte_mempool_cache *cache, uint32_t size)
 	cache->size = size;
 	cache->flushthresh = CALC_CACHE_FLUSHTHRESH(size);
 	cache->len = 0;
+	cache->size_min = 0;
+	cache->size_max = 0;
+	cache->win_ops = 0;
+	cache->win_misses = 0;
+	memset(&cache->stats, 0, sizeof(cache->stats));
+}
+
+/* Make the default caches of a mempool adaptive */
+int __rte_experimental
+rte_mempool_cache_adaptive_set(struct rte_mempool *mp, uint32_t min_size,
+	uint32_t max_size)
+{
+	struct rte_mempool_cache *cache;
+	unsigned int lcore_id;
+	uint32_t size;
+
+	if (mp->cache_size == 0 || min_size == 0 || min_size > max_size ||
+	    max_size > RTE_MEMPOOL_CACHE_MAX_SIZE ||
+	    CALC_CACHE_FLUSHTHRESH(max_size) > mp->size)
+		return -EINVAL;
+
+	size = RTE_MIN(RTE_MAX(mp->cache_size, min_size), max_size);
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		cache = &mp->local_cache[lcore_id];
+		cache->size = size;
+		cache->flushthresh = CALC_CACHE_FLUSHTHRESH(size);
+		cache->size_min = min_size;
+		cache->size_max = min_size == max_size ? 0 : max_size;
+		cache->win_ops = 0;
+		cache->win_misses = 0;
+	}
+
+	return 0;
+}
+
+/* Resize an adaptive cache from the common pool accesses of the window */
+void
+__rte_mempool_cache_adapt(struct rte_mempool *mp,
+	struct rte_mempool_cache *cache)
+{
+	uint32_t size = cache->size;
+
+	if (cache->win_misses * 16 > cache->win_ops) {
+		size = RTE_MIN(size * 2, cache->size_max);
+		if (size != cache->size)
+			cache->stats.grows++;
+	} else if (cache->win_misses * 64 < cache->win_ops) {
+		size = RTE_MAX(size / 2, cache->size_min);
+		if (size != cache->size)
+			cache->stats.shrinks++;
+	}
+
+	cache->win_ops = 0;
+	cache->win_misses = 0;
+
+	if (size == cache->size)
+		return;
+
+	cache->size = size;
+	cache->flushthresh = CALC_CACHE_FLUSHTHRESH(size);
+	if (cache->len > size) {
+		rte_mempool_ops_enqueue_bulk(mp, &cache->objs[size],
+				cache->len - size);
+		cache->len = size;
+	}
 }
 
 /*
@@ -1008,10 +1074,37 @@ rte_mempool_dump_cache(FILE *f, const struct rte_mempool *mp)
 		return count;
 
 	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
-		cache_count = mp->local_cache[lcore_id].len;
+		const struct rte_mempool_cache *cache;
+		uint64_t hits, total;
+
+		cache = &mp->local_cache[lcore_id];
+		cache_count = cache->len;
 		fprintf(f, "    cache_count[%u]=%"PRIu32"\n",
 			lcore_id, cache_count);
 		count += cache_count;
+
+		hits = cache->stats.get_hits + cache->stats.put_hits;
+		total = hits + cache->stats.get_misses +
+			cache->stats.put_misses;
+		if (total == 0)
+			continue;
+		fprintf(f, "    cache_size[%u]=%"PRIu32"\n",
+			lcore_id, cache->size);
+		fprintf(f, "    cache_hit_rate[%u]=%.2f%%\n",
+			lcore_id, (double)hits * 100 / total);
+		fprintf(f, "    cache_get_hits[%u]=%"PRIu64" "
+			"cache_get_misses[%u]=%"PRIu64"\n",
+			lcore_id, cache->stats.get_hits,
+			lcore_id, cache->stats.get_misses);
+		fprintf(f, "    cache_put_hits[%u]=%"PRIu64" "
+			"cache_put_misses[%u]=%"PRIu64"\n",
+			lcore_id, cache->stats.put_hits,
+			lcore_id, cache->stats.put_misses);
+		if (cache->size_max != 0)
+			fprintf(f, "    cache_grows[%u]=%"PRIu64" "
+				"cache_shrinks[%u]=%"PRIu64"\n",
+				lcore_id, cache->stats.grows,
+				lcore_id, cache->stats.shrinks);
 	}
 	fprintf(f, "    total_cache_count=%u\n", count);
 	return count;
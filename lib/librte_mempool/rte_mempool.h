@@ -77,6 +77,25 @@ struct rte_mempool_debug_stats {
 } __rte_cache_aligned;
 #endif
 
+/**
+ * A structure that stores the statistics of a mempool cache, only
+ * maintained for an adaptive cache.
+ */
+struct rte_mempool_cache_stats {
+	uint64_t get_hits;   /**< Gets served from the cache. */
+	uint64_t get_misses; /**< Gets that refilled the cache from the pool. */
+	uint64_t put_hits;   /**< Puts absorbed by the cache. */
+	uint64_t put_misses; /**< Puts that flushed the cache to the pool. */
+	uint64_t grows;      /**< Size increases of an adaptive cache. */
+	uint64_t shrinks;    /**< Size decreases of an adaptive cache. */
+};
+
+/**
+ * Number of cache accesses after which an adaptive cache is resized,
+ * see rte_mempool_cache_adaptive_set().
+ */
+#define RTE_MEMPOOL_CACHE_ADAPT_WINDOW 256
+
 /**
  * A structure that stores a per-core object cache.
  */
@@ -84,6 +103,11 @@ struct rte_mempool_cache {
 	uint32_t size;	      /**< Size of the cache */
 	uint32_t flushthresh; /**< Threshold before we flush excess elements */
 	uint32_t len;	      /**< Current cache count */
+	uint32_t size_min;    /**< Minimum size if adaptive */
+	uint32_t size_max;    /**< Maximum size if adaptive, 0 if fixed */
+	uint32_t win_ops;     /**< Accesses in the current adaptation window */
+	uint32_t win_misses;  /**< Common pool accesses in the window */
+	struct rte_mempool_cache_stats stats; /**< Cache statistics */
 	/*
 	 * Cache is allocated to this size to allow it to overflow in certain
 	 * cases to avoid needless emptying of cache.
@@ -1164,6 +1188,80 @@ rte_mempool_cache_create(uint32_t size, int socket_id);
 void
 rte_mempool_cache_free(struct rte_mempool_cache *cache);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Make the per-lcore default caches of a mempool adaptive.
+ *
+ * The size of an adaptive cache is adjusted by the lcore using it,
+ * between the given bounds, every RTE_MEMPOOL_CACHE_ADAPT_WINDOW cache
+ * accesses. It doubles when more than 1/16 of the accesses had to get
+ * objects from or flush objects to the common pool, which happens when
+ * the gets and puts of the lcore are unbalanced, and it is halved, the
+ * excess objects being flushed, when less than 1/64 of the accesses did.
+ * This limits the contention on the common pool of the lcores with
+ * bursty traffic, without sizing every cache for the worst case.
+ *
+ * The caches start with the cache size given at mempool creation,
+ * clamped to the bounds. The function must be called before the
+ * mempool is used, as it does not flush the caches.
+ *
+ * @param mp
+ *   A pointer to the mempool structure, created with a non-zero cache size.
+ * @param min_size
+ *   The minimum size of the caches, must be non-zero.
+ * @param max_size
+ *   The maximum size of the caches. Same limits as the cache_size
+ *   parameter of rte_mempool_create(). If it is equal to min_size,
+ *   the caches have a fixed size.
+ * @return
+ *   0 on success, -EINVAL if the mempool has no cache or the bounds
+ *   are invalid.
+ */
+int __rte_experimental
+rte_mempool_cache_adaptive_set(struct rte_mempool *mp, uint32_t min_size,
+	uint32_t max_size);
+
+/**
+ * @internal Resize an adaptive cache at the end of an adaptation window;
+ * used internally.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param cache
+ *   A pointer to the mempool cache.
+ */
+void
+__rte_mempool_cache_adapt(struct rte_mempool *mp,
+	struct rte_mempool_cache *cache);
+
+/**
+ * @internal Account for a cache access; used internally.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param cache
+ *   A pointer to the mempool cache.
+ * @param stat
+ *   A pointer to the cache statistics counter of the access.
+ * @param miss
+ *   1 if the access went to the common pool, 0 otherwise.
+ */
+static __rte_always_inline void
+__mempool_cache_access(struct rte_mempool *mp,
+		       struct rte_mempool_cache *cache, uint64_t *stat,
+		       uint32_t miss)
+{
+	if (likely(cache->size_max == 0))
+		return;
+
+	(*stat)++;
+	cache->win_misses += miss;
+	if (unlikely(++cache->win_ops >= RTE_MEMPOOL_CACHE_ADAPT_WINDOW))
+		__rte_mempool_cache_adapt(mp, cache);
+}
+
 /**
  * Get a pointer to the per-lcore default mempool cache.
  *
@@ -1249,6 +1347,9 @@ __mempool_generic_put(struct rte_mempool *mp, void * const *obj_table,
 		rte_mempool_ops_enqueue_bulk(mp, &cache->objs[cache->size],
 				cache->len - cache->size);
 		cache->len = cache->size;
+		__mempool_cache_access(mp, cache, &cache->stats.put_misses, 1);
+	} else {
+		__mempool_cache_access(mp, cache, &cache->stats.put_hits, 0);
 	}
 
 	return;
@@ -1345,7 +1446,7 @@ __mempool_generic_get(struct rte_mempool *mp, void **obj_table,
 		      unsigned int n, struct rte_mempool_cache *cache)
 {
 	int ret;
-	uint32_t index, len;
+	uint32_t index, len, miss = 0;
 	void **cache_objs;
 
 	/* No cache provided or cannot be satisfied from cache */
@@ -1373,6 +1474,7 @@ __mempool_generic_get(struct rte_mempool *mp, void **obj_table,
 		}
 
 		cache->len += req;
+		miss = 1;
 	}
 
 	/* Now fill in the response ... */
@@ -1381,6 +1483,9 @@ __mempool_generic_get(struct rte_mempool *mp, void **obj_table,
 
 	cache->len -= n;
 
+	__mempool_cache_access(mp, cache, miss ? &cache->stats.get_misses :
+			       &cache->stats.get_hits, miss);
+
 	__MEMPOOL_STAT_ADD(mp, get_success, n);
 
 	return 0;
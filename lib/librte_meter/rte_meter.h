@@ -21,11 +21,19 @@ extern "C" {
 
 #include <stdint.h>
 
+#include <rte_compat.h>
+#include <rte_prefetch.h>
+
 /*
  * Application Programmer's Interface (API)
  *
  ***/
 
+/** Number of meters prefetched ahead by the bulk traffic metering functions */
+#ifndef RTE_METER_BULK_PREFETCH
+#define RTE_METER_BULK_PREFETCH 4
+#endif
+
 /** Packet Color Set */
 enum rte_meter_color {
 	e_RTE_METER_GREEN = 0, /**< Green */
@@ -170,6 +178,124 @@ rte_meter_srtcm_color_aware_check(struct rte_meter_srtcm *m,
 	uint32_t pkt_len,
 	enum rte_meter_color pkt_color);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * srTCM color blind traffic metering of a burst of packets, each packet
+ * being metered by its own srTCM instance, possibly the same as for other
+ * packets of the burst. The instances are prefetched ahead of their use.
+ *
+ * @param m
+ *    Array of handles to srTCM instances, one per packet
+ * @param p
+ *    Array of srTCM profiles specified at srTCM object creation time, one per
+ *    packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array where the colors assigned to the IP packets are stored
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_srtcm_color_blind_check_bulk(struct rte_meter_srtcm **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * srTCM color aware traffic metering of a burst of packets, each packet
+ * being metered by its own srTCM instance, possibly the same as for other
+ * packets of the burst. The instances are prefetched ahead of their use.
+ *
+ * @param m
+ *    Array of handles to srTCM instances, one per packet
+ * @param p
+ *    Array of srTCM profiles specified at srTCM object creation time, one per
+ *    packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array of input colors of the IP packets, replaced by the colors assigned
+ *    to them
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_srtcm_color_aware_check_bulk(struct rte_meter_srtcm **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * srTCM color blind traffic metering of a burst of packets by the same srTCM
+ * instance, whose token buckets are updated once for the burst.
+ *
+ * @param m
+ *    Handle to srTCM instance
+ * @param p
+ *    srTCM profile specified at srTCM object creation time
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array where the colors assigned to the IP packets are stored
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_srtcm_color_blind_check_burst(struct rte_meter_srtcm *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * srTCM color aware traffic metering of a burst of packets by the same srTCM
+ * instance, whose token buckets are updated once for the burst.
+ *
+ * @param m
+ *    Handle to srTCM instance
+ * @param p
+ *    srTCM profile specified at srTCM object creation time
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array of input colors of the IP packets, replaced by the colors assigned
+ *    to them
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_srtcm_color_aware_check_burst(struct rte_meter_srtcm *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
 /**
  * trTCM color blind traffic metering
  *
@@ -213,6 +339,124 @@ rte_meter_trtcm_color_aware_check(struct rte_meter_trtcm *m,
 	uint32_t pkt_len,
 	enum rte_meter_color pkt_color);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * trTCM color blind traffic metering of a burst of packets, each packet
+ * being metered by its own trTCM instance, possibly the same as for other
+ * packets of the burst. The instances are prefetched ahead of their use.
+ *
+ * @param m
+ *    Array of handles to trTCM instances, one per packet
+ * @param p
+ *    Array of trTCM profiles specified at trTCM object creation time, one per
+ *    packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array where the colors assigned to the IP packets are stored
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_trtcm_color_blind_check_bulk(struct rte_meter_trtcm **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * trTCM color aware traffic metering of a burst of packets, each packet
+ * being metered by its own trTCM instance, possibly the same as for other
+ * packets of the burst. The instances are prefetched ahead of their use.
+ *
+ * @param m
+ *    Array of handles to trTCM instances, one per packet
+ * @param p
+ *    Array of trTCM profiles specified at trTCM object creation time, one per
+ *    packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array of input colors of the IP packets, replaced by the colors assigned
+ *    to them
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_trtcm_color_aware_check_bulk(struct rte_meter_trtcm **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * trTCM color blind traffic metering of a burst of packets by the same trTCM
+ * instance, whose token buckets are updated once for the burst.
+ *
+ * @param m
+ *    Handle to trTCM instance
+ * @param p
+ *    trTCM profile specified at trTCM object creation time
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array where the colors assigned to the IP packets are stored
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_trtcm_color_blind_check_burst(struct rte_meter_trtcm *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * trTCM color aware traffic metering of a burst of packets by the same trTCM
+ * instance, whose token buckets are updated once for the burst.
+ *
+ * @param m
+ *    Handle to trTCM instance
+ * @param p
+ *    trTCM profile specified at trTCM object creation time
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of lengths of the IP packets (measured in bytes)
+ * @param pkt_color
+ *    Array of input colors of the IP packets, replaced by the colors assigned
+ *    to them
+ * @param n_pkts
+ *    Number of packets
+ */
+static inline void __rte_experimental
+rte_meter_trtcm_color_aware_check_burst(struct rte_meter_trtcm *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
 /*
  * Inline implementation of run-time methods
  *
@@ -434,6 +678,308 @@ rte_meter_trtcm_color_aware_check(struct rte_meter_trtcm *m,
 	return e_RTE_METER_GREEN;
 }
 
+/* Number of bucket update periods elapsed, without dividing for none */
+static inline uint64_t
+__rte_meter_n_periods(uint64_t time_diff, uint64_t period)
+{
+	if (time_diff < period)
+		return 0;
+
+	return time_diff / period;
+}
+
+static inline void
+__rte_meter_srtcm_update(struct rte_meter_srtcm *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	uint64_t *tc,
+	uint64_t *te)
+{
+	uint64_t n_periods;
+
+	/* Bucket update */
+	n_periods = __rte_meter_n_periods(time - m->time, p->cir_period);
+	m->time += n_periods * p->cir_period;
+
+	/* Put the tokens overflowing from tc into te bucket */
+	*tc = m->tc + n_periods * p->cir_bytes_per_period;
+	*te = m->te;
+	if (*tc > p->cbs) {
+		*te += (*tc - p->cbs);
+		if (*te > p->ebs)
+			*te = p->ebs;
+		*tc = p->cbs;
+	}
+}
+
+/* Color logic without branches, color blind for a green input color */
+static inline enum rte_meter_color
+__rte_meter_srtcm_color(uint64_t *tc,
+	uint64_t *te,
+	uint32_t pkt_len,
+	enum rte_meter_color pkt_color)
+{
+	uint64_t green, yellow;
+
+	green = (pkt_color == e_RTE_METER_GREEN) & (*tc >= pkt_len);
+	yellow = (green ^ 1) & (pkt_color != e_RTE_METER_RED) &
+		(*te >= pkt_len);
+
+	*tc -= (-green) & pkt_len;
+	*te -= (-yellow) & pkt_len;
+
+	return (enum rte_meter_color)(e_RTE_METER_RED - 2 * green - yellow);
+}
+
+static inline void
+__rte_meter_srtcm_check_bulk(struct rte_meter_srtcm **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts,
+	int color_aware)
+{
+	uint32_t i;
+
+	for (i = 0; i < n_pkts && i < RTE_METER_BULK_PREFETCH; i++)
+		rte_prefetch0(m[i]);
+
+	for (i = 0; i < n_pkts; i++) {
+		enum rte_meter_color color =
+			color_aware ? pkt_color[i] : e_RTE_METER_GREEN;
+		uint64_t tc, te;
+
+		if (i + RTE_METER_BULK_PREFETCH < n_pkts)
+			rte_prefetch0(m[i + RTE_METER_BULK_PREFETCH]);
+
+		__rte_meter_srtcm_update(m[i], p[i], time, &tc, &te);
+		pkt_color[i] = __rte_meter_srtcm_color(&tc, &te, pkt_len[i],
+			color);
+		m[i]->tc = tc;
+		m[i]->te = te;
+	}
+}
+
+static inline void
+__rte_meter_srtcm_check_burst(struct rte_meter_srtcm *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts,
+	int color_aware)
+{
+	uint64_t tc, te;
+	uint32_t i;
+
+	if (n_pkts == 0)
+		return;
+
+	__rte_meter_srtcm_update(m, p, time, &tc, &te);
+
+	for (i = 0; i < n_pkts; i++) {
+		enum rte_meter_color color =
+			color_aware ? pkt_color[i] : e_RTE_METER_GREEN;
+
+		pkt_color[i] = __rte_meter_srtcm_color(&tc, &te, pkt_len[i],
+			color);
+	}
+
+	m->tc = tc;
+	m->te = te;
+}
+
+static inline void __rte_experimental
+rte_meter_srtcm_color_blind_check_bulk(struct rte_meter_srtcm **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_srtcm_check_bulk(m, p, time, pkt_len, pkt_color, n_pkts, 0);
+}
+
+static inline void __rte_experimental
+rte_meter_srtcm_color_aware_check_bulk(struct rte_meter_srtcm **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_srtcm_check_bulk(m, p, time, pkt_len, pkt_color, n_pkts, 1);
+}
+
+static inline void __rte_experimental
+rte_meter_srtcm_color_blind_check_burst(struct rte_meter_srtcm *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_srtcm_check_burst(m, p, time, pkt_len, pkt_color, n_pkts, 0);
+}
+
+static inline void __rte_experimental
+rte_meter_srtcm_color_aware_check_burst(struct rte_meter_srtcm *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_srtcm_check_burst(m, p, time, pkt_len, pkt_color, n_pkts, 1);
+}
+
+static inline void
+__rte_meter_trtcm_update(struct rte_meter_trtcm *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	uint64_t *tc,
+	uint64_t *tp)
+{
+	uint64_t n_periods_tc, n_periods_tp;
+
+	/* Bucket update */
+	n_periods_tc = __rte_meter_n_periods(time - m->time_tc, p->cir_period);
+	n_periods_tp = __rte_meter_n_periods(time - m->time_tp, p->pir_period);
+	m->time_tc += n_periods_tc * p->cir_period;
+	m->time_tp += n_periods_tp * p->pir_period;
+
+	*tc = m->tc + n_periods_tc * p->cir_bytes_per_period;
+	if (*tc > p->cbs)
+		*tc = p->cbs;
+
+	*tp = m->tp + n_periods_tp * p->pir_bytes_per_period;
+	if (*tp > p->pbs)
+		*tp = p->pbs;
+}
+
+/* Color logic without branches, color blind for a green input color */
+static inline enum rte_meter_color
+__rte_meter_trtcm_color(uint64_t *tc,
+	uint64_t *tp,
+	uint32_t pkt_len,
+	enum rte_meter_color pkt_color)
+{
+	uint64_t red, yellow;
+
+	red = (pkt_color == e_RTE_METER_RED) | (*tp < pkt_len);
+	yellow = (red ^ 1) &
+		((pkt_color == e_RTE_METER_YELLOW) | (*tc < pkt_len));
+
+	*tc -= (-((red | yellow) ^ 1)) & pkt_len;
+	*tp -= (-(red ^ 1)) & pkt_len;
+
+	return (enum rte_meter_color)(2 * red + yellow);
+}
+
+static inline void
+__rte_meter_trtcm_check_bulk(struct rte_meter_trtcm **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts,
+	int color_aware)
+{
+	uint32_t i;
+
+	for (i = 0; i < n_pkts && i < RTE_METER_BULK_PREFETCH; i++)
+		rte_prefetch0(m[i]);
+
+	for (i = 0; i < n_pkts; i++) {
+		enum rte_meter_color color =
+			color_aware ? pkt_color[i] : e_RTE_METER_GREEN;
+		uint64_t tc, tp;
+
+		if (i + RTE_METER_BULK_PREFETCH < n_pkts)
+			rte_prefetch0(m[i + RTE_METER_BULK_PREFETCH]);
+
+		__rte_meter_trtcm_update(m[i], p[i], time, &tc, &tp);
+		pkt_color[i] = __rte_meter_trtcm_color(&tc, &tp, pkt_len[i],
+			color);
+		m[i]->tc = tc;
+		m[i]->tp = tp;
+	}
+}
+
+static inline void
+__rte_meter_trtcm_check_burst(struct rte_meter_trtcm *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts,
+	int color_aware)
+{
+	uint64_t tc, tp;
+	uint32_t i;
+
+	if (n_pkts == 0)
+		return;
+
+	__rte_meter_trtcm_update(m, p, time, &tc, &tp);
+
+	for (i = 0; i < n_pkts; i++) {
+		enum rte_meter_color color =
+			color_aware ? pkt_color[i] : e_RTE_METER_GREEN;
+
+		pkt_color[i] = __rte_meter_trtcm_color(&tc, &tp, pkt_len[i],
+			color);
+	}
+
+	m->tc = tc;
+	m->tp = tp;
+}
+
+static inline void __rte_experimental
+rte_meter_trtcm_color_blind_check_bulk(struct rte_meter_trtcm **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_trtcm_check_bulk(m, p, time, pkt_len, pkt_color, n_pkts, 0);
+}
+
+static inline void __rte_experimental
+rte_meter_trtcm_color_aware_check_bulk(struct rte_meter_trtcm **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_trtcm_check_bulk(m, p, time, pkt_len, pkt_color, n_pkts, 1);
+}
+
+static inline void __rte_experimental
+rte_meter_trtcm_color_blind_check_burst(struct rte_meter_trtcm *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_trtcm_check_burst(m, p, time, pkt_len, pkt_color, n_pkts, 0);
+}
+
+static inline void __rte_experimental
+rte_meter_trtcm_color_aware_check_burst(struct rte_meter_trtcm *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	__rte_meter_trtcm_check_burst(m, p, time, pkt_len, pkt_color, n_pkts, 1);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,9 @@
 #include <sys/queue.h>
 
 #include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_pause.h>
 #include <rte_string_fns.h>
 #include <rte_malloc.h>
 #include <rte_metrics.h>
@@ -15,6 +18,7 @@
 
 #define RTE_METRICS_MAX_METRICS 256
 #define RTE_METRICS_MEMZONE_NAME "RTE_METRICS"
+#define RTE_METRICS_SHARD_MEMZONE_NAME "RTE_METRICS_%u"
 
 /**
  * Internal stats metadata and value entry.
@@ -28,6 +32,10 @@ struct rte_metrics_meta_s {
 	uint64_t value[RTE_MAX_ETHPORTS];
 	/** Used for global metrics */
 	uint64_t global_value;
+	/** TSC of the last update of value */
+	uint64_t stamp[RTE_MAX_ETHPORTS];
+	/** TSC of the last update of global_value */
+	uint64_t global_stamp;
 	/** Index of next root element (zero for none) */
 	uint16_t idx_next_set;
 	/** Index of next metric in set (zero for none) */
@@ -53,8 +61,139 @@ struct rte_metrics_data_s {
 	struct rte_metrics_meta_s metadata[RTE_METRICS_MAX_METRICS];
 	/** Metric data access lock */
 	rte_spinlock_t lock;
+	/** Non-zero for the lcores whose shard is allocated. */
+	uint8_t shard_used[RTE_MAX_LCORE];
 };
 
+/**
+ * Value of a metric in a shard.
+ *
+ * @internal
+ */
+struct rte_metrics_slot_s {
+	uint64_t value;
+	/** TSC of the update, zero if never updated by the lcore */
+	uint64_t stamp;
+};
+
+/**
+ * Per-lcore metric store.
+ *
+ * @internal
+ * The metrics updated by an lcore of the primary process are written
+ * without lock into the shard of the lcore, and the shards are merged
+ * with the central store at read time, keeping the most recent value.
+ * The writes are enclosed in a sequence lock, for the readers to get a
+ * consistent snapshot of the values updated together.
+ */
+struct rte_metrics_shard_s {
+	/** Sequence number, odd while the lcore updates the values */
+	uint32_t seq;
+	/** Values per metric, for the global metrics then per port */
+	struct rte_metrics_slot_s
+		slot[RTE_METRICS_MAX_METRICS][RTE_MAX_ETHPORTS + 1];
+} __rte_cache_aligned;
+
+/* Shards mapped in this process, looked up on first use. */
+static struct rte_metrics_shard_s *metrics_shards[RTE_MAX_LCORE];
+
+static struct rte_metrics_shard_s *
+metrics_shard_lookup(struct rte_metrics_data_s *stats, unsigned int lcore_id)
+{
+	char name[RTE_MEMZONE_NAMESIZE];
+	const struct rte_memzone *memzone;
+
+	if (metrics_shards[lcore_id] != NULL)
+		return metrics_shards[lcore_id];
+	if (!__atomic_load_n(&stats->shard_used[lcore_id], __ATOMIC_ACQUIRE))
+		return NULL;
+
+	snprintf(name, sizeof(name), RTE_METRICS_SHARD_MEMZONE_NAME, lcore_id);
+	memzone = rte_memzone_lookup(name);
+	if (memzone == NULL)
+		return NULL;
+	metrics_shards[lcore_id] = memzone->addr;
+	return memzone->addr;
+}
+
+/*
+ * Shard of the calling lcore, allocated on its first update. Only the
+ * EAL threads of the primary process own a shard, as the lcore ids of
+ * the secondary processes overlap with them.
+ */
+static struct rte_metrics_shard_s *
+metrics_shard_get(struct rte_metrics_data_s *stats)
+{
+	char name[RTE_MEMZONE_NAMESIZE];
+	const struct rte_memzone *memzone;
+	unsigned int lcore_id = rte_lcore_id();
+
+	if (lcore_id >= RTE_MAX_LCORE ||
+			rte_eal_process_type() != RTE_PROC_PRIMARY)
+		return NULL;
+	if (likely(metrics_shards[lcore_id] != NULL))
+		return metrics_shards[lcore_id];
+
+	snprintf(name, sizeof(name), RTE_METRICS_SHARD_MEMZONE_NAME, lcore_id);
+	memzone = rte_memzone_lookup(name);
+	if (memzone == NULL) {
+		memzone = rte_memzone_reserve(name,
+			sizeof(struct rte_metrics_shard_s), rte_socket_id(), 0);
+		if (memzone == NULL)
+			return NULL;
+		memset(memzone->addr, 0, sizeof(struct rte_metrics_shard_s));
+	}
+	metrics_shards[lcore_id] = memzone->addr;
+	__atomic_store_n(&stats->shard_used[lcore_id], 1, __ATOMIC_RELEASE);
+	return memzone->addr;
+}
+
+/*
+ * Merge into values the metrics [0, cnt_stats) of a port updated in the
+ * shards after the stamps, updating the stamps.
+ */
+static void
+metrics_shards_merge(struct rte_metrics_data_s *stats, int port_id,
+	struct rte_metric_value *values, uint64_t *stamps, uint16_t cnt_stats)
+{
+	struct rte_metrics_shard_s *shard;
+	struct rte_metrics_slot_s snap[RTE_METRICS_MAX_METRICS];
+	unsigned int lcore_id;
+	uint32_t seq;
+	uint16_t idx_name;
+	uint16_t idx_port = port_id + 1;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		shard = metrics_shard_lookup(stats, lcore_id);
+		if (shard == NULL)
+			continue;
+
+		do {
+			seq = __atomic_load_n(&shard->seq, __ATOMIC_ACQUIRE);
+			if (seq & 1) {
+				rte_pause();
+				continue;
+			}
+			for (idx_name = 0; idx_name < cnt_stats; idx_name++) {
+				snap[idx_name].value = __atomic_load_n(
+					&shard->slot[idx_name][idx_port].value,
+					__ATOMIC_RELAXED);
+				snap[idx_name].stamp = __atomic_load_n(
+					&shard->slot[idx_name][idx_port].stamp,
+					__ATOMIC_RELAXED);
+			}
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		} while ((seq & 1) ||
+			seq != __atomic_load_n(&shard->seq, __ATOMIC_RELAXED));
+
+		for (idx_name = 0; idx_name < cnt_stats; idx_name++)
+			if (snap[idx_name].stamp > stamps[idx_name]) {
+				stamps[idx_name] = snap[idx_name].stamp;
+				values[idx_name].value = snap[idx_name].value;
+			}
+	}
+}
+
 void
 rte_metrics_init(int socket_id)
 {
@@ -119,11 +258,13 @@ rte_metrics_reg_names(const char * const *names, uint16_t cnt_names)
 		entry = &stats->metadata[idx_name + stats->cnt_stats];
 		strlcpy(entry->name, names[idx_name], RTE_METRICS_MAX_NAME_LEN);
 		memset(entry->value, 0, sizeof(entry->value));
+		memset(entry->stamp, 0, sizeof(entry->stamp));
 		entry->idx_next_stat = idx_name + stats->cnt_stats + 1;
 	}
 	entry->idx_next_stat = 0;
 	entry->idx_next_set = 0;
-	stats->cnt_stats += cnt_names;
+	__atomic_store_n(&stats->cnt_stats, stats->cnt_stats + cnt_names,
+		__ATOMIC_RELEASE);
 
 	rte_spinlock_unlock(&stats->lock);
 
@@ -142,12 +283,16 @@ rte_metrics_update_values(int port_id,
 	const uint64_t *values,
 	uint32_t count)
 {
+	static const struct rte_memzone *memzone;
 	struct rte_metrics_meta_s *entry;
 	struct rte_metrics_data_s *stats;
-	const struct rte_memzone *memzone;
+	struct rte_metrics_shard_s *shard;
+	struct rte_metrics_slot_s *slot;
 	uint16_t idx_metric;
 	uint16_t idx_value;
 	uint16_t cnt_setsize;
+	uint16_t cnt_stats;
+	uint64_t stamp;
 
 	if (port_id != RTE_METRICS_GLOBAL &&
 			(port_id < 0 || port_id >= RTE_MAX_ETHPORTS))
@@ -156,20 +301,20 @@ rte_metrics_update_values(int port_id,
 	if (values == NULL)
 		return -EINVAL;
 
-	memzone = rte_memzone_lookup(RTE_METRICS_MEMZONE_NAME);
-	if (memzone == NULL)
-		return -EIO;
+	if (unlikely(memzone == NULL)) {
+		memzone = rte_memzone_lookup(RTE_METRICS_MEMZONE_NAME);
+		if (memzone == NULL)
+			return -EIO;
+	}
 	stats = memzone->addr;
 
-	rte_spinlock_lock(&stats->lock);
-
-	if (key >= stats->cnt_stats) {
-		rte_spinlock_unlock(&stats->lock);
+	/* The metrics below cnt_stats are no longer modified */
+	cnt_stats = __atomic_load_n(&stats->cnt_stats, __ATOMIC_ACQUIRE);
+	if (key >= cnt_stats)
 		return -EINVAL;
-	}
 	idx_metric = key;
 	cnt_setsize = 1;
-	while (idx_metric < stats->cnt_stats) {
+	while (idx_metric < cnt_stats) {
 		entry = &stats->metadata[idx_metric];
 		if (entry->idx_next_stat == 0)
 			break;
@@ -177,22 +322,40 @@ rte_metrics_update_values(int port_id,
 		idx_metric++;
 	}
 	/* Check update does not cross set border */
-	if (count > cnt_setsize) {
-		rte_spinlock_unlock(&stats->lock);
+	if (count > cnt_setsize)
 		return -ERANGE;
+
+	stamp = rte_rdtsc();
+	shard = metrics_shard_get(stats);
+	if (likely(shard != NULL)) {
+		/* Only this lcore writes its shard */
+		__atomic_store_n(&shard->seq, shard->seq + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		for (idx_value = 0; idx_value < count; idx_value++) {
+			slot = &shard->slot[key + idx_value][port_id + 1];
+			__atomic_store_n(&slot->value, values[idx_value],
+				__ATOMIC_RELAXED);
+			__atomic_store_n(&slot->stamp, stamp,
+				__ATOMIC_RELAXED);
+		}
+		__atomic_store_n(&shard->seq, shard->seq + 1, __ATOMIC_RELEASE);
+		return 0;
 	}
 
+	rte_spinlock_lock(&stats->lock);
 	if (port_id == RTE_METRICS_GLOBAL)
 		for (idx_value = 0; idx_value < count; idx_value++) {
 			idx_metric = key + idx_value;
 			stats->metadata[idx_metric].global_value =
 				values[idx_value];
+			stats->metadata[idx_metric].global_stamp = stamp;
 		}
 	else
 		for (idx_value = 0; idx_value < count; idx_value++) {
 			idx_metric = key + idx_value;
 			stats->metadata[idx_metric].value[port_id] =
 				values[idx_value];
+			stats->metadata[idx_metric].stamp[port_id] = stamp;
 		}
 	rte_spinlock_unlock(&stats->lock);
 	return 0;
@@ -237,6 +400,7 @@ rte_metrics_get_values(int port_id,
 	struct rte_metrics_meta_s *entry;
 	struct rte_metrics_data_s *stats;
 	const struct rte_memzone *memzone;
+	uint64_t stamps[RTE_METRICS_MAX_METRICS];
 	uint16_t idx_name;
 	int return_value;
 
@@ -264,6 +428,7 @@ rte_metrics_get_values(int port_id,
 				entry = &stats->metadata[idx_name];
 				values[idx_name].key = idx_name;
 				values[idx_name].value = entry->global_value;
+				stamps[idx_name] = entry->global_stamp;
 			}
 		else
 			for (idx_name = 0;
@@ -272,7 +437,10 @@ rte_metrics_get_values(int port_id,
 				entry = &stats->metadata[idx_name];
 				values[idx_name].key = idx_name;
 				values[idx_name].value = entry->value[port_id];
+				stamps[idx_name] = entry->stamp[port_id];
 			}
+		metrics_shards_merge(stats, port_id, values, stamps,
+			stats->cnt_stats);
 	}
 	return_value = stats->cnt_stats;
 	rte_spinlock_unlock(&stats->lock);
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _NET_CKSUM_H_
+#define _NET_CKSUM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * The vector implementations add the 16-bit words to 32-bit lanes, which
+ * take at most 2 * 0xffff per iteration: they are emptied into a 64-bit
+ * sum before they overflow.
+ */
+#define NET_CKSUM_VEC_ITERS 0x7fff
+
+/* Fold a 64-bit sum to 16 bits, 2^16 being 1 in one's complement */
+static inline uint32_t
+net_cksum_fold(uint64_t sum)
+{
+	sum = (sum >> 32) + (sum & 0xffffffff);
+	sum = (sum >> 32) + (sum & 0xffffffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+	return (uint32_t)sum;
+}
+
+/* Sum 32-bit words, then the remaining 16-bit word and odd byte */
+static inline uint32_t
+net_cksum_scalar_tail(const uint8_t *buf, size_t len, uint64_t sum)
+{
+	uint32_t u32;
+	uint16_t u16;
+
+	while (len >= sizeof(u32)) {
+		memcpy(&u32, buf, sizeof(u32));
+		sum += u32;
+		buf += sizeof(u32);
+		len -= sizeof(u32);
+	}
+	if (len >= sizeof(u16)) {
+		memcpy(&u16, buf, sizeof(u16));
+		sum += u16;
+		buf += sizeof(u16);
+		len -= sizeof(u16);
+	}
+	/* if length is in odd bytes, as __rte_raw_cksum() */
+	if (len == 1)
+		sum += *buf;
+
+	return net_cksum_fold(sum);
+}
+
+static inline uint32_t
+net_cksum_copy_scalar_tail(uint8_t *dst, const uint8_t *src, size_t len,
+	uint64_t sum)
+{
+	memcpy(dst, src, len);
+	return net_cksum_scalar_tail(dst, len, sum);
+}
+
+uint32_t
+net_cksum_avx2(const void *buf, size_t len, uint32_t sum);
+uint32_t
+net_cksum_copy_avx2(void *dst, const void *src, size_t len, uint32_t sum);
+
+uint32_t
+net_cksum_avx512(const void *buf, size_t len, uint32_t sum);
+uint32_t
+net_cksum_copy_avx512(void *dst, const void *src, size_t len, uint32_t sum);
+
+uint32_t
+net_cksum_neon(const void *buf, size_t len, uint32_t sum);
+uint32_t
+net_cksum_copy_neon(void *dst, const void *src, size_t len, uint32_t sum);
+
+#endif /* _NET_CKSUM_H_ */
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <rte_common.h>
+#include <rte_vect.h>
+
+#include "net_cksum.h"
+
+/*
+ * Each 32-bit lane receives the sum of its low and high 16-bit words,
+ * the lanes are added to the 64-bit sum before they can overflow.
+ */
+static __rte_always_inline uint64_t
+net_cksum_avx2_lanes(__m256i vsum)
+{
+	uint32_t lanes[8];
+	uint64_t sum = 0;
+	unsigned int i;
+
+	_mm256_storeu_si256((__m256i *)lanes, vsum);
+	for (i = 0; i < RTE_DIM(lanes); i++)
+		sum += lanes[i];
+	return sum;
+}
+
+static __rte_always_inline __m256i
+net_cksum_avx2_add(__m256i vsum, __m256i v)
+{
+	const __m256i mask = _mm256_set1_epi32(0xffff);
+
+	vsum = _mm256_add_epi32(vsum, _mm256_and_si256(v, mask));
+	return _mm256_add_epi32(vsum, _mm256_srli_epi32(v, 16));
+}
+
+uint32_t
+net_cksum_avx2(const void *buf, size_t len, uint32_t sum)
+{
+	const uint8_t *p = buf;
+	uint64_t acc = sum;
+
+	while (len >= sizeof(__m256i)) {
+		size_t n = RTE_MIN(len / sizeof(__m256i),
+				   (size_t)NET_CKSUM_VEC_ITERS);
+		__m256i vsum = _mm256_setzero_si256();
+
+		len -= n * sizeof(__m256i);
+		while (n--) {
+			vsum = net_cksum_avx2_add(vsum,
+				_mm256_loadu_si256((const __m256i *)p));
+			p += sizeof(__m256i);
+		}
+		acc += net_cksum_avx2_lanes(vsum);
+	}
+
+	return net_cksum_scalar_tail(p, len, acc);
+}
+
+uint32_t
+net_cksum_copy_avx2(void *dst, const void *src, size_t len, uint32_t sum)
+{
+	const uint8_t *s = src;
+	uint8_t *d = dst;
+	uint64_t acc = sum;
+
+	while (len >= sizeof(__m256i)) {
+		size_t n = RTE_MIN(len / sizeof(__m256i),
+				   (size_t)NET_CKSUM_VEC_ITERS);
+		__m256i vsum = _mm256_setzero_si256();
+
+		len -= n * sizeof(__m256i);
+		while (n--) {
+			__m256i v = _mm256_loadu_si256((const __m256i *)s);
+
+			_mm256_storeu_si256((__m256i *)d, v);
+			vsum = net_cksum_avx2_add(vsum, v);
+			s += sizeof(__m256i);
+			d += sizeof(__m256i);
+		}
+		acc += net_cksum_avx2_lanes(vsum);
+	}
+
+	return net_cksum_copy_scalar_tail(d, s, len, acc);
+}
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <rte_common.h>
+#include <rte_vect.h>
+
+#include "net_cksum.h"
+
+/*
+ * Each 32-bit lane receives the sum of its low and high 16-bit words,
+ * the lanes are added to the 64-bit sum before they can overflow.
+ */
+static __rte_always_inline uint64_t
+net_cksum_avx512_lanes(__m512i vsum)
+{
+	uint32_t lanes[16];
+	uint64_t sum = 0;
+	unsigned int i;
+
+	_mm512_storeu_si512((__m512i *)lanes, vsum);
+	for (i = 0; i < RTE_DIM(lanes); i++)
+		sum += lanes[i];
+	return sum;
+}
+
+static __rte_always_inline __m512i
+net_cksum_avx512_add(__m512i vsum, __m512i v)
+{
+	const __m512i mask = _mm512_set1_epi32(0xffff);
+
+	vsum = _mm512_add_epi32(vsum, _mm512_and_si512(v, mask));
+	return _mm512_add_epi32(vsum, _mm512_srli_epi32(v, 16));
+}
+
+uint32_t
+net_cksum_avx512(const void *buf, size_t len, uint32_t sum)
+{
+	const uint8_t *p = buf;
+	uint64_t acc = sum;
+
+	while (len >= sizeof(__m512i)) {
+		size_t n = RTE_MIN(len / sizeof(__m512i),
+				   (size_t)NET_CKSUM_VEC_ITERS);
+		__m512i vsum = _mm512_setzero_si512();
+
+		len -= n * sizeof(__m512i);
+		while (n--) {
+			vsum = net_cksum_avx512_add(vsum,
+				_mm512_loadu_si512((const __m512i *)p));
+			p += sizeof(__m512i);
+		}
+		acc += net_cksum_avx512_lanes(vsum);
+	}
+
+	return net_cksum_scalar_tail(p, len, acc);
+}
+
+uint32_t
+net_cksum_copy_avx512(void *dst, const void *src, size_t len, uint32_t sum)
+{
+	const uint8_t *s = src;
+	uint8_t *d = dst;
+	uint64_t acc = sum;
+
+	while (len >= sizeof(__m512i)) {
+		size_t n = RTE_MIN(len / sizeof(__m512i),
+				   (size_t)NET_CKSUM_VEC_ITERS);
+		__m512i vsum = _mm512_setzero_si512();
+
+		len -= n * sizeof(__m512i);
+		while (n--) {
+			__m512i v = _mm512_loadu_si512((const __m512i *)s);
+
+			_mm512_storeu_si512((__m512i *)d, v);
+			vsum = net_cksum_avx512_add(vsum, v);
+			s += sizeof(__m512i);
+			d += sizeof(__m512i);
+		}
+		acc += net_cksum_avx512_lanes(vsum);
+	}
+
+	return net_cksum_copy_scalar_tail(d, s, len, acc);
+}
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <rte_common.h>
+#include <rte_vect.h>
+
+#include "net_cksum.h"
+
+/*
+ * Each 32-bit lane receives the sum of a pair of 16-bit words, the lanes
+ * are added to the 64-bit sum before they can overflow.
+ */
+static __rte_always_inline uint64_t
+net_cksum_neon_lanes(uint32x4_t vsum)
+{
+	uint64x2_t v = vpaddlq_u32(vsum);
+
+	return vgetq_lane_u64(v, 0) + vgetq_lane_u64(v, 1);
+}
+
+uint32_t
+net_cksum_neon(const void *buf, size_t len, uint32_t sum)
+{
+	const uint8_t *p = buf;
+	uint64_t acc = sum;
+
+	while (len >= sizeof(uint8x16_t)) {
+		size_t n = RTE_MIN(len / sizeof(uint8x16_t),
+				   (size_t)NET_CKSUM_VEC_ITERS);
+		uint32x4_t vsum = vdupq_n_u32(0);
+
+		len -= n * sizeof(uint8x16_t);
+		while (n--) {
+			vsum = vpadalq_u16(vsum,
+				vreinterpretq_u16_u8(vld1q_u8(p)));
+			p += sizeof(uint8x16_t);
+		}
+		acc += net_cksum_neon_lanes(vsum);
+	}
+
+	return net_cksum_scalar_tail(p, len, acc);
+}
+
+uint32_t
+net_cksum_copy_neon(void *dst, const void *src, size_t len, uint32_t sum)
+{
+	const uint8_t *s = src;
+	uint8_t *d = dst;
+	uint64_t acc = sum;
+
+	while (len >= sizeof(uint8x16_t)) {
+		size_t n = RTE_MIN(len / sizeof(uint8x16_t),
+				   (size_t)NET_CKSUM_VEC_ITERS);
+		uint32x4_t vsum = vdupq_n_u32(0);
+
+		len -= n * sizeof(uint8x16_t);
+		while (n--) {
+			uint8x16_t v = vld1q_u8(s);
+
+			vst1q_u8(d, v);
+			vsum = vpadalq_u16(vsum, vreinterpretq_u16_u8(v));
+			s += sizeof(uint8x16_t);
+			d += sizeof(uint8x16_t);
+		}
+		acc += net_cksum_neon_lanes(vsum);
+	}
+
+	return net_cksum_copy_scalar_tail(d, s, len, acc);
+}
@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cpuflags.h>
+#include <rte_net_cksum.h>
+
+#include "net_cksum.h"
+
+#if defined(RTE_ARCH_ARM64)
+#define CC_NEON_SUPPORT 1
+#endif
+
+typedef uint32_t
+(*net_cksum_handler)(const void *buf, size_t len, uint32_t sum);
+
+typedef uint32_t
+(*net_cksum_copy_handler)(void *dst, const void *src, size_t len,
+	uint32_t sum);
+
+struct net_cksum_handlers {
+	net_cksum_handler cksum;
+	net_cksum_copy_handler copy;
+};
+
+static uint32_t
+net_cksum_scalar(const void *buf, size_t len, uint32_t sum)
+{
+	const uint8_t *p = buf;
+	uint64_t acc = sum;
+	uint64_t u64;
+
+	while (len >= sizeof(u64)) {
+		memcpy(&u64, p, sizeof(u64));
+		acc += u64 & 0xffffffff;
+		acc += u64 >> 32;
+		p += sizeof(u64);
+		len -= sizeof(u64);
+	}
+
+	return net_cksum_scalar_tail(p, len, acc);
+}
+
+static uint32_t
+net_cksum_copy_scalar(void *dst, const void *src, size_t len, uint32_t sum)
+{
+	const uint8_t *s = src;
+	uint8_t *d = dst;
+	uint64_t acc = sum;
+	uint64_t u64;
+
+	while (len >= sizeof(u64)) {
+		memcpy(&u64, s, sizeof(u64));
+		memcpy(d, &u64, sizeof(u64));
+		acc += u64 & 0xffffffff;
+		acc += u64 >> 32;
+		s += sizeof(u64);
+		d += sizeof(u64);
+		len -= sizeof(u64);
+	}
+
+	return net_cksum_copy_scalar_tail(d, s, len, acc);
+}
+
+static const struct net_cksum_handlers handlers_scalar = {
+	.cksum = net_cksum_scalar,
+	.copy = net_cksum_copy_scalar,
+};
+
+#ifdef CC_AVX2_SUPPORT
+static const struct net_cksum_handlers handlers_avx2 = {
+	.cksum = net_cksum_avx2,
+	.copy = net_cksum_copy_avx2,
+};
+#endif
+
+#ifdef CC_AVX512_SUPPORT
+static const struct net_cksum_handlers handlers_avx512 = {
+	.cksum = net_cksum_avx512,
+	.copy = net_cksum_copy_avx512,
+};
+#endif
+
+#ifdef CC_NEON_SUPPORT
+static const struct net_cksum_handlers handlers_neon = {
+	.cksum = net_cksum_neon,
+	.copy = net_cksum_copy_neon,
+};
+#endif
+
+static const struct net_cksum_handlers *handlers = &handlers_scalar;
+static enum rte_net_cksum_alg cksum_alg = RTE_NET_CKSUM_SCALAR;
+
+int __rte_experimental
+rte_net_cksum_set_alg(enum rte_net_cksum_alg alg)
+{
+	const struct net_cksum_handlers *h = NULL;
+
+	switch (alg) {
+	case RTE_NET_CKSUM_SCALAR:
+		h = &handlers_scalar;
+		break;
+#ifdef CC_AVX2_SUPPORT
+	case RTE_NET_CKSUM_AVX2:
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2))
+			h = &handlers_avx2;
+		break;
+#endif
+#ifdef CC_AVX512_SUPPORT
+	case RTE_NET_CKSUM_AVX512:
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F))
+			h = &handlers_avx512;
+		break;
+#endif
+#ifdef CC_NEON_SUPPORT
+	case RTE_NET_CKSUM_NEON:
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_NEON))
+			h = &handlers_neon;
+		break;
+#endif
+	default:
+		break;
+	}
+
+	if (h == NULL)
+		return -ENOTSUP;
+
+	handlers = h;
+	cksum_alg = alg;
+	return 0;
+}
+
+enum rte_net_cksum_alg __rte_experimental
+rte_net_cksum_get_alg(void)
+{
+	return cksum_alg;
+}
+
+uint32_t __rte_experimental
+rte_net_raw_cksum(const void *buf, size_t len, uint32_t sum)
+{
+	return handlers->cksum(buf, len, sum);
+}
+
+uint32_t __rte_experimental
+rte_net_raw_cksum_copy(void *dst, const void *src, size_t len, uint32_t sum)
+{
+	return handlers->copy(dst, src, len, sum);
+}
+
+/* Select highest available checksum algorithm as default one */
+RTE_INIT(rte_net_cksum_init)
+{
+	if (rte_net_cksum_set_alg(RTE_NET_CKSUM_AVX512) == 0)
+		return;
+	if (rte_net_cksum_set_alg(RTE_NET_CKSUM_AVX2) == 0)
+		return;
+	rte_net_cksum_set_alg(RTE_NET_CKSUM_NEON);
+}
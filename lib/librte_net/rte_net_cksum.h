@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_NET_CKSUM_H_
+#define _RTE_NET_CKSUM_H_
+
+/**
+ * @file
+ *
+ * Internet checksum of large buffers, with vector implementations selected
+ * at runtime. The inline helpers of rte_ip.h remain the best choice for
+ * headers; these functions are meant for the payloads checksummed by the
+ * software offload paths.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rte_compat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Checksum compute algorithm */
+enum rte_net_cksum_alg {
+	RTE_NET_CKSUM_SCALAR = 0,
+	RTE_NET_CKSUM_AVX2,
+	RTE_NET_CKSUM_AVX512,
+	RTE_NET_CKSUM_NEON,
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Set the checksum computation algorithm. The best one supported by the
+ * CPU is selected at startup.
+ *
+ * @param alg
+ *   This parameter is used to select the checksum implementation version.
+ *   - RTE_NET_CKSUM_SCALAR
+ *   - RTE_NET_CKSUM_AVX2 (Use AVX2 intrinsic)
+ *   - RTE_NET_CKSUM_AVX512 (Use AVX512F intrinsic)
+ *   - RTE_NET_CKSUM_NEON (Use ARM Neon intrinsic)
+ * @return
+ *   0 on success, -ENOTSUP if the algorithm is not supported by the
+ *   build or by the CPU, the current one being kept.
+ */
+int __rte_experimental
+rte_net_cksum_set_alg(enum rte_net_cksum_alg alg);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the checksum computation algorithm in use.
+ *
+ * @return
+ *   The current algorithm.
+ */
+enum rte_net_cksum_alg __rte_experimental
+rte_net_cksum_get_alg(void);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add the 16-bit words of a buffer to a sum, as __rte_raw_cksum() does:
+ * the result can be chained with the other helpers of rte_ip.h and is
+ * reduced by __rte_raw_cksum_reduce().
+ *
+ * @param buf
+ *   Pointer to the buffer.
+ * @param len
+ *   Length of the buffer.
+ * @param sum
+ *   Initial value of the sum.
+ * @return
+ *   The sum, not reduced.
+ */
+uint32_t __rte_experimental
+rte_net_raw_cksum(const void *buf, size_t len, uint32_t sum);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Copy a buffer and add its 16-bit words to a sum in a single pass, to
+ * checksum the payloads while they are copied into mbufs.
+ *
+ * @param dst
+ *   Pointer to the destination, which must not overlap the source.
+ * @param src
+ *   Pointer to the source.
+ * @param len
+ *   Number of bytes to copy.
+ * @param sum
+ *   Initial value of the sum.
+ * @return
+ *   The sum of the copied data, not reduced, as rte_net_raw_cksum().
+ */
+uint32_t __rte_experimental
+rte_net_raw_cksum_copy(void *dst, const void *src, size_t len, uint32_t sum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_NET_CKSUM_H_ */
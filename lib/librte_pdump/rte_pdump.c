@@ -9,6 +9,9 @@
 #include <rte_log.h>
 #include <rte_errno.h>
 #include <rte_string_fns.h>
+#include <rte_memzone.h>
+#include <rte_cycles.h>
+#include <rte_bpf.h>
 
 #include "rte_pdump.h"
 
@@ -19,6 +22,9 @@
 /* Used for the multi-process communication */
 #define PDUMP_MP	"mp_pdump"
 
+/* Memzone of the capture statistics, shared with the secondary processes */
+#define PDUMP_STATS_MZ	"rte_pdump_stats"
+
 enum pdump_operation {
 	DISABLE = 1,
 	ENABLE = 2
@@ -39,6 +45,8 @@ struct pdump_request {
 			struct rte_ring *ring;
 			struct rte_mempool *mp;
 			void *filter;
+			uint32_t snaplen;
+			const struct rte_bpf_prm *prm;
 		} en_v1;
 		struct disable_v1 {
 			char device[DEVICE_ID_SIZE];
@@ -61,13 +69,31 @@ static struct pdump_rxtx_cbs {
 	struct rte_mempool *mp;
 	const struct rte_eth_rxtx_callback *cb;
 	void *filter;
+	struct rte_bpf *bpf;
+	struct rte_bpf_jit jit;
+	uint8_t bpf_mbuf; /* the filter program takes the mbuf */
+	uint32_t flags;
+	uint32_t snaplen;
+	struct rte_pdump_stats *stats;
 } rx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT],
 tx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 
+/* Capture statistics of all the queues, in the PDUMP_STATS_MZ memzone */
+struct pdump_stats {
+	struct rte_pdump_stats rx[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
+	struct rte_pdump_stats tx[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
+};
+
+static struct pdump_stats *pdump_stats;
+
+#define PDUMP_STATS_INC(stats, field, n) \
+	__atomic_fetch_add(&(stats)->field, (n), __ATOMIC_RELAXED)
+
 static inline int
-pdump_pktmbuf_copy_data(struct rte_mbuf *seg, const struct rte_mbuf *m)
+pdump_pktmbuf_copy_data(struct rte_mbuf *seg, const struct rte_mbuf *m,
+		uint16_t len)
 {
-	if (rte_pktmbuf_tailroom(seg) < m->data_len) {
+	if (rte_pktmbuf_tailroom(seg) < len) {
 		RTE_LOG(ERR, PDUMP,
 			"User mempool: insufficient data_len of mbuf\n");
 		return -EINVAL;
@@ -80,7 +106,7 @@ pdump_pktmbuf_copy_data(struct rte_mbuf *seg, const struct rte_mbuf *m)
 	seg->ol_flags = m->ol_flags;
 	seg->packet_type = m->packet_type;
 	seg->vlan_tci_outer = m->vlan_tci_outer;
-	seg->data_len = m->data_len;
+	seg->data_len = len;
 	seg->pkt_len = seg->data_len;
 	rte_memcpy(rte_pktmbuf_mtod(seg, void *),
 			rte_pktmbuf_mtod(m, void *),
@@ -89,11 +115,13 @@ pdump_pktmbuf_copy_data(struct rte_mbuf *seg, const struct rte_mbuf *m)
 	return 0;
 }
 
+/* Copy the first snaplen bytes of a packet, the whole packet if 0. */
 static inline struct rte_mbuf *
-pdump_pktmbuf_copy(struct rte_mbuf *m, struct rte_mempool *mp)
+pdump_pktmbuf_copy(struct rte_mbuf *m, struct rte_mempool *mp,
+		uint32_t snaplen)
 {
 	struct rte_mbuf *m_dup, *seg, **prev;
-	uint32_t pktlen;
+	uint32_t pktlen, len;
 	uint16_t nseg;
 
 	m_dup = rte_pktmbuf_alloc(mp);
@@ -103,19 +131,24 @@ pdump_pktmbuf_copy(struct rte_mbuf *m, struct rte_mempool *mp)
 	seg = m_dup;
 	prev = &seg->next;
 	pktlen = m->pkt_len;
+	if (snaplen != 0 && snaplen < pktlen)
+		pktlen = snaplen;
+	len = pktlen;
 	nseg = 0;
 
 	do {
 		nseg++;
-		if (pdump_pktmbuf_copy_data(seg, m) < 0) {
+		if (pdump_pktmbuf_copy_data(seg, m,
+				RTE_MIN(len, m->data_len)) < 0) {
 			if (seg != m_dup)
 				rte_pktmbuf_free_seg(seg);
 			rte_pktmbuf_free(m_dup);
 			return NULL;
 		}
+		len -= seg->data_len;
 		*prev = seg;
 		prev = &seg->next;
-	} while ((m = m->next) != NULL &&
+	} while (len != 0 && (m = m->next) != NULL &&
 			(seg = rte_pktmbuf_alloc(mp)) != NULL);
 
 	*prev = NULL;
@@ -132,31 +165,127 @@ pdump_pktmbuf_copy(struct rte_mbuf *m, struct rte_mempool *mp)
 	return m_dup;
 }
 
+/*
+ * Clone the first snaplen bytes of a packet, the whole packet if 0. The
+ * clone is made of indirect mbufs attached to the packet segments.
+ */
+static inline struct rte_mbuf *
+pdump_pktmbuf_clone(struct rte_mbuf *m, struct rte_mempool *mp,
+		uint32_t snaplen)
+{
+	struct rte_mbuf *m_dup, *seg;
+	uint32_t len;
+	uint16_t nseg;
+
+	m_dup = rte_pktmbuf_clone(m, mp);
+	if (unlikely(m_dup == NULL))
+		return NULL;
+
+	if (snaplen == 0 || snaplen >= m_dup->pkt_len)
+		return m_dup;
+
+	/* Truncate the clone, releasing the segments past snaplen */
+	seg = m_dup;
+	len = snaplen;
+	nseg = 1;
+	while (len > seg->data_len) {
+		len -= seg->data_len;
+		seg = seg->next;
+		nseg++;
+	}
+	seg->data_len = len;
+	if (seg->next != NULL) {
+		rte_pktmbuf_free(seg->next);
+		seg->next = NULL;
+	}
+	m_dup->nb_segs = nseg;
+	m_dup->pkt_len = snaplen;
+
+	return m_dup;
+}
+
+/* Run the filter of the callback, returns the number of accepted packets. */
+static inline uint16_t
+pdump_filter(const struct pdump_rxtx_cbs *cbs, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, uint64_t rc[])
+{
+	void *ctx[nb_pkts];
+	uint16_t i, n;
+
+	for (i = 0; i < nb_pkts; i++)
+		ctx[i] = cbs->bpf_mbuf ? (void *)pkts[i] :
+			rte_pktmbuf_mtod(pkts[i], void *);
+
+	if (cbs->jit.func != NULL) {
+		for (i = 0; i < nb_pkts; i++)
+			rc[i] = cbs->jit.func(ctx[i]);
+	} else
+		rte_bpf_exec_burst(cbs->bpf, ctx, rc, nb_pkts);
+
+	n = 0;
+	for (i = 0; i < nb_pkts; i++)
+		n += (rc[i] != 0);
+
+	return n;
+}
+
 static inline void
-pdump_copy(struct rte_mbuf **pkts, uint16_t nb_pkts, void *user_params)
+pdump_copy(uint16_t port, uint16_t queue, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, void *user_params)
 {
 	unsigned i;
 	int ring_enq;
-	uint16_t d_pkts = 0;
+	uint16_t d_pkts = 0, nb_accepted;
 	struct rte_mbuf *dup_bufs[nb_pkts];
+	uint64_t rc[nb_pkts];
 	struct pdump_rxtx_cbs *cbs;
 	struct rte_ring *ring;
 	struct rte_mempool *mp;
 	struct rte_mbuf *p;
+	uint64_t tsc;
+
+	if (nb_pkts == 0)
+		return;
 
 	cbs  = user_params;
 	ring = cbs->ring;
 	mp = cbs->mp;
+
+	nb_accepted = nb_pkts;
+	if (cbs->bpf != NULL) {
+		nb_accepted = pdump_filter(cbs, pkts, nb_pkts, rc);
+		if (nb_accepted < nb_pkts)
+			PDUMP_STATS_INC(cbs->stats, filtered,
+					nb_pkts - nb_accepted);
+		if (nb_accepted == 0)
+			return;
+	}
+	PDUMP_STATS_INC(cbs->stats, accepted, nb_accepted);
+
+	tsc = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		p = pdump_pktmbuf_copy(pkts[i], mp);
-		if (p)
+		if (cbs->bpf != NULL && rc[i] == 0)
+			continue;
+		if (cbs->flags & RTE_PDUMP_FLAG_ZERO_COPY)
+			p = pdump_pktmbuf_clone(pkts[i], mp, cbs->snaplen);
+		else
+			p = pdump_pktmbuf_copy(pkts[i], mp, cbs->snaplen);
+		if (p) {
+			p->port = port;
+			p->timestamp = tsc;
+			p->udata64 = ((uint64_t)queue << 32) |
+				pkts[i]->pkt_len;
 			dup_bufs[d_pkts++] = p;
+		}
 	}
+	if (unlikely(d_pkts < nb_accepted))
+		PDUMP_STATS_INC(cbs->stats, nombuf, nb_accepted - d_pkts);
 
 	ring_enq = rte_ring_enqueue_burst(ring, (void *)dup_bufs, d_pkts, NULL);
 	if (unlikely(ring_enq < d_pkts)) {
 		RTE_LOG(DEBUG, PDUMP,
 			"only %d of packets enqueued to ring\n", ring_enq);
+		PDUMP_STATS_INC(cbs->stats, ringfull, d_pkts - ring_enq);
 		do {
 			rte_pktmbuf_free(dup_bufs[ring_enq]);
 		} while (++ring_enq < d_pkts);
@@ -164,28 +293,69 @@ pdump_copy(struct rte_mbuf **pkts, uint16_t nb_pkts, void *user_params)
 }
 
 static uint16_t
-pdump_rx(uint16_t port __rte_unused, uint16_t qidx __rte_unused,
+pdump_rx(uint16_t port, uint16_t qidx,
 	struct rte_mbuf **pkts, uint16_t nb_pkts,
 	uint16_t max_pkts __rte_unused,
 	void *user_params)
 {
-	pdump_copy(pkts, nb_pkts, user_params);
+	pdump_copy(port, qidx, pkts, nb_pkts, user_params);
 	return nb_pkts;
 }
 
 static uint16_t
-pdump_tx(uint16_t port __rte_unused, uint16_t qidx __rte_unused,
+pdump_tx(uint16_t port, uint16_t qidx,
 		struct rte_mbuf **pkts, uint16_t nb_pkts, void *user_params)
 {
-	pdump_copy(pkts, nb_pkts, user_params);
+	pdump_copy(port, qidx, pkts, nb_pkts, user_params);
 	return nb_pkts;
 }
 
+/*
+ * Set the capture parameters of a queue callback. The filter of the
+ * previous capture of the queue is only destroyed here, as its callback
+ * may still run for a while after its removal.
+ */
+static int
+pdump_setup_cbs(struct pdump_rxtx_cbs *cbs, struct rte_ring *ring,
+		struct rte_mempool *mp, uint32_t flags, uint32_t snaplen,
+		const struct rte_bpf_prm *prm, struct rte_pdump_stats *stats)
+{
+	if (cbs->bpf != NULL) {
+		rte_bpf_destroy(cbs->bpf);
+		cbs->bpf = NULL;
+	}
+	memset(&cbs->jit, 0, sizeof(cbs->jit));
+
+	if (prm != NULL) {
+		cbs->bpf = rte_bpf_load(prm);
+		if (cbs->bpf == NULL) {
+			RTE_LOG(ERR, PDUMP,
+				"failed to load bpf filter, errno=%d\n",
+				rte_errno);
+			return -rte_errno;
+		}
+		rte_bpf_get_jit(cbs->bpf, &cbs->jit);
+		cbs->bpf_mbuf = (prm->prog_arg.type == RTE_BPF_ARG_PTR_MBUF);
+	}
+
+	cbs->ring = ring;
+	cbs->mp = mp;
+	cbs->flags = flags;
+	cbs->snaplen = snaplen;
+	cbs->stats = stats;
+
+	return 0;
+}
+
 static int
 pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 				struct rte_ring *ring, struct rte_mempool *mp,
+				uint32_t flags, uint32_t snaplen,
+				const struct rte_bpf_prm *prm,
 				uint16_t operation)
 {
+	int ret;
+
 	uint16_t qid;
 	struct pdump_rxtx_cbs *cbs = NULL;
 
@@ -200,8 +370,10 @@ pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 					port, qid);
 				return -EEXIST;
 			}
-			cbs->ring = ring;
-			cbs->mp = mp;
+			ret = pdump_setup_cbs(cbs, ring, mp, flags, snaplen,
+					prm, &pdump_stats->rx[port][qid]);
+			if (ret < 0)
+				return ret;
 			cbs->cb = rte_eth_add_first_rx_callback(port, qid,
 								pdump_rx, cbs);
 			if (cbs->cb == NULL) {
@@ -212,8 +384,6 @@ pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 			}
 		}
 		if (cbs && operation == DISABLE) {
-			int ret;
-
 			if (cbs->cb == NULL) {
 				RTE_LOG(ERR, PDUMP,
 					"failed to delete non existing rx "
@@ -238,8 +408,11 @@ pdump_register_rx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 static int
 pdump_register_tx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 				struct rte_ring *ring, struct rte_mempool *mp,
+				uint32_t flags, uint32_t snaplen,
+				const struct rte_bpf_prm *prm,
 				uint16_t operation)
 {
+	int ret;
 
 	uint16_t qid;
 	struct pdump_rxtx_cbs *cbs = NULL;
@@ -255,8 +428,10 @@ pdump_register_tx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 					port, qid);
 				return -EEXIST;
 			}
-			cbs->ring = ring;
-			cbs->mp = mp;
+			ret = pdump_setup_cbs(cbs, ring, mp, flags, snaplen,
+					prm, &pdump_stats->tx[port][qid]);
+			if (ret < 0)
+				return ret;
 			cbs->cb = rte_eth_add_tx_callback(port, qid, pdump_tx,
 								cbs);
 			if (cbs->cb == NULL) {
@@ -267,8 +442,6 @@ pdump_register_tx_callbacks(uint16_t end_q, uint16_t port, uint16_t queue,
 			}
 		}
 		if (cbs && operation == DISABLE) {
-			int ret;
-
 			if (cbs->cb == NULL) {
 				RTE_LOG(ERR, PDUMP,
 					"failed to delete non existing tx "
@@ -300,6 +473,8 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	uint16_t operation;
 	struct rte_ring *ring;
 	struct rte_mempool *mp;
+	const struct rte_bpf_prm *prm = NULL;
+	uint32_t snaplen = 0;
 
 	flags = p->flags;
 	operation = p->op;
@@ -315,6 +490,8 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 		queue = p->data.en_v1.queue;
 		ring = p->data.en_v1.ring;
 		mp = p->data.en_v1.mp;
+		snaplen = p->data.en_v1.snaplen;
+		prm = p->data.en_v1.prm;
 	} else {
 		ret = rte_eth_dev_get_port_by_name(p->data.dis_v1.device,
 				&port);
@@ -347,7 +524,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 			return -EINVAL;
 		}
 		if ((nb_tx_q == 0 || nb_rx_q == 0) &&
-			flags == RTE_PDUMP_FLAG_RXTX) {
+			(flags & RTE_PDUMP_FLAG_RXTX) == RTE_PDUMP_FLAG_RXTX) {
 			RTE_LOG(ERR, PDUMP,
 				"both tx&rx queues must be non zero\n");
 			return -EINVAL;
@@ -358,7 +535,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	if (flags & RTE_PDUMP_FLAG_RX) {
 		end_q = (queue == RTE_PDUMP_ALL_QUEUES) ? nb_rx_q : queue + 1;
 		ret = pdump_register_rx_callbacks(end_q, port, queue, ring, mp,
-							operation);
+				flags, snaplen, prm, operation);
 		if (ret < 0)
 			return ret;
 	}
@@ -367,7 +544,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	if (flags & RTE_PDUMP_FLAG_TX) {
 		end_q = (queue == RTE_PDUMP_ALL_QUEUES) ? nb_tx_q : queue + 1;
 		ret = pdump_register_tx_callbacks(end_q, port, queue, ring, mp,
-							operation);
+				flags, snaplen, prm, operation);
 		if (ret < 0)
 			return ret;
 	}
@@ -408,6 +585,22 @@ pdump_server(const struct rte_mp_msg *mp_msg, const void *peer)
 int
 rte_pdump_init(const char *path __rte_unused)
 {
+	const struct rte_memzone *mz;
+
+	mz = rte_memzone_lookup(PDUMP_STATS_MZ);
+	if (mz == NULL) {
+		mz = rte_memzone_reserve(PDUMP_STATS_MZ,
+				sizeof(struct pdump_stats), rte_socket_id(), 0);
+		if (mz == NULL) {
+			RTE_LOG(ERR, PDUMP,
+				"cannot allocate pdump statistics\n");
+			rte_errno = ENOMEM;
+			return -1;
+		}
+		memset(mz->addr, 0, sizeof(struct pdump_stats));
+	}
+	pdump_stats = mz->addr;
+
 	return rte_mp_action_register(PDUMP_MP, pdump_server);
 }
 
@@ -447,6 +640,7 @@ pdump_validate_ring_mp(struct rte_ring *ring, struct rte_mempool *mp)
 static int
 pdump_validate_flags(uint32_t flags)
 {
+	flags &= ~RTE_PDUMP_FLAG_ZERO_COPY;
 	if (flags != RTE_PDUMP_FLAG_RX && flags != RTE_PDUMP_FLAG_TX &&
 		flags != RTE_PDUMP_FLAG_RXTX) {
 		RTE_LOG(ERR, PDUMP,
@@ -488,7 +682,9 @@ pdump_prepare_client_request(char *device, uint16_t queue,
 				uint16_t operation,
 				struct rte_ring *ring,
 				struct rte_mempool *mp,
-				void *filter)
+				void *filter,
+				uint32_t snaplen,
+				const struct rte_bpf_prm *prm)
 {
 	int ret = -1;
 	struct rte_mp_msg mp_req, *mp_rep;
@@ -507,6 +703,8 @@ pdump_prepare_client_request(char *device, uint16_t queue,
 		req->data.en_v1.ring = ring;
 		req->data.en_v1.mp = mp;
 		req->data.en_v1.filter = filter;
+		req->data.en_v1.snaplen = snaplen;
+		req->data.en_v1.prm = prm;
 	} else {
 		snprintf(req->data.dis_v1.device,
 			 sizeof(req->data.dis_v1.device), "%s", device);
@@ -555,7 +753,7 @@ rte_pdump_enable(uint16_t port, uint16_t queue, uint32_t flags,
 		return ret;
 
 	ret = pdump_prepare_client_request(name, queue, flags,
-						ENABLE, ring, mp, filter);
+						ENABLE, ring, mp, filter, 0, NULL);
 
 	return ret;
 }
@@ -577,7 +775,7 @@ rte_pdump_enable_by_deviceid(char *device_id, uint16_t queue,
 		return ret;
 
 	ret = pdump_prepare_client_request(device_id, queue, flags,
-						ENABLE, ring, mp, filter);
+						ENABLE, ring, mp, filter, 0, NULL);
 
 	return ret;
 }
@@ -596,7 +794,7 @@ rte_pdump_disable(uint16_t port, uint16_t queue, uint32_t flags)
 		return ret;
 
 	ret = pdump_prepare_client_request(name, queue, flags,
-						DISABLE, NULL, NULL, NULL);
+						DISABLE, NULL, NULL, NULL, 0, NULL);
 
 	return ret;
 }
@@ -612,11 +810,102 @@ rte_pdump_disable_by_deviceid(char *device_id, uint16_t queue,
 		return ret;
 
 	ret = pdump_prepare_client_request(device_id, queue, flags,
-						DISABLE, NULL, NULL, NULL);
+						DISABLE, NULL, NULL, NULL, 0, NULL);
+
+	return ret;
+}
+
+int __rte_experimental
+rte_pdump_enable_bpf(uint16_t port, uint16_t queue, uint32_t flags,
+		uint32_t snaplen,
+		struct rte_ring *ring,
+		struct rte_mempool *mp,
+		const struct rte_bpf_prm *prm)
+{
+	int ret = 0;
+	char name[DEVICE_ID_SIZE];
+
+	ret = pdump_validate_port(port, name);
+	if (ret < 0)
+		return ret;
+	ret = pdump_validate_ring_mp(ring, mp);
+	if (ret < 0)
+		return ret;
+	ret = pdump_validate_flags(flags);
+	if (ret < 0)
+		return ret;
+
+	ret = pdump_prepare_client_request(name, queue, flags,
+			ENABLE, ring, mp, NULL, snaplen, prm);
 
 	return ret;
 }
 
+int __rte_experimental
+rte_pdump_enable_bpf_by_deviceid(char *device_id, uint16_t queue,
+		uint32_t flags,
+		uint32_t snaplen,
+		struct rte_ring *ring,
+		struct rte_mempool *mp,
+		const struct rte_bpf_prm *prm)
+{
+	int ret = 0;
+
+	ret = pdump_validate_ring_mp(ring, mp);
+	if (ret < 0)
+		return ret;
+	ret = pdump_validate_flags(flags);
+	if (ret < 0)
+		return ret;
+
+	ret = pdump_prepare_client_request(device_id, queue, flags,
+			ENABLE, ring, mp, NULL, snaplen, prm);
+
+	return ret;
+}
+
+static inline void
+pdump_stats_add(struct rte_pdump_stats *sum, const struct rte_pdump_stats *s)
+{
+	sum->accepted += __atomic_load_n(&s->accepted, __ATOMIC_RELAXED);
+	sum->filtered += __atomic_load_n(&s->filtered, __ATOMIC_RELAXED);
+	sum->nombuf += __atomic_load_n(&s->nombuf, __ATOMIC_RELAXED);
+	sum->ringfull += __atomic_load_n(&s->ringfull, __ATOMIC_RELAXED);
+}
+
+int __rte_experimental
+rte_pdump_queue_stats_get(uint16_t port, uint16_t queue, uint32_t flags,
+		struct rte_pdump_stats *stats)
+{
+	const struct rte_memzone *mz;
+	const struct pdump_stats *ps;
+
+	if (port >= RTE_MAX_ETHPORTS || queue >= RTE_MAX_QUEUES_PER_PORT ||
+			stats == NULL || pdump_validate_flags(flags) < 0) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	ps = pdump_stats;
+	if (ps == NULL) {
+		mz = rte_memzone_lookup(PDUMP_STATS_MZ);
+		if (mz == NULL) {
+			RTE_LOG(ERR, PDUMP, "pdump statistics not found\n");
+			rte_errno = ENOENT;
+			return -1;
+		}
+		ps = mz->addr;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	if (flags & RTE_PDUMP_FLAG_RX)
+		pdump_stats_add(stats, &ps->rx[port][queue]);
+	if (flags & RTE_PDUMP_FLAG_TX)
+		pdump_stats_add(stats, &ps->tx[port][queue]);
+
+	return 0;
+}
+
 int
 rte_pdump_set_socket_dir(const char *path __rte_unused,
 			 enum rte_pdump_socktype type __rte_unused)
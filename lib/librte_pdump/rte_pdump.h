@@ -13,8 +13,10 @@
  */
 
 #include <stdint.h>
+#include <rte_compat.h>
 #include <rte_mempool.h>
 #include <rte_ring.h>
+#include <rte_bpf.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,7 +28,44 @@ enum {
 	RTE_PDUMP_FLAG_RX = 1,  /* receive direction */
 	RTE_PDUMP_FLAG_TX = 2,  /* transmit direction */
 	/* both receive and transmit directions */
-	RTE_PDUMP_FLAG_RXTX = (RTE_PDUMP_FLAG_RX|RTE_PDUMP_FLAG_TX)
+	RTE_PDUMP_FLAG_RXTX = (RTE_PDUMP_FLAG_RX|RTE_PDUMP_FLAG_TX),
+	/* mirror packets as clones attached to the original mbufs */
+	RTE_PDUMP_FLAG_ZERO_COPY = 4
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Queue a mirrored packet was captured on.
+ *
+ * The port field of the mirrored packets is the captured port, their
+ * timestamp field the TSC at capture time, and their udata64 field holds
+ * the captured queue and the packet length before the snap length
+ * truncation.
+ */
+#define RTE_PDUMP_MBUF_QUEUE(m) ((uint16_t)((m)->udata64 >> 32))
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Length of a mirrored packet before its truncation to the snap length.
+ */
+#define RTE_PDUMP_MBUF_ORIG_LEN(m) ((uint32_t)(m)->udata64)
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this structure may change without prior notice
+ *
+ * Packet capture statistics of a queue, counted by the callbacks of the
+ * target (primary) process since rte_pdump_init().
+ */
+struct rte_pdump_stats {
+	uint64_t accepted; /**< Number of packets accepted by the filter */
+	uint64_t filtered; /**< Number of packets rejected by the filter */
+	uint64_t nombuf;   /**< Number of mbuf allocation failures */
+	uint64_t ringfull; /**< Number of packets dropped on a full ring */
 };
 
 enum rte_pdump_socktype {
@@ -162,6 +201,111 @@ int
 rte_pdump_disable_by_deviceid(char *device_id, uint16_t queue,
 				uint32_t flags);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enables filtered packet capturing on given port and queue.
+ *
+ * @param port
+ *  port on which packet capturing should be enabled.
+ * @param queue
+ *  queue of a given port on which packet capturing should be enabled.
+ *  users should pass on value UINT16_MAX to enable packet capturing on all
+ *  queues of a given port.
+ * @param flags
+ *  flags specifies RTE_PDUMP_FLAG_RX/RTE_PDUMP_FLAG_TX/RTE_PDUMP_FLAG_RXTX
+ *  on which packet capturing should be enabled for a given port and queue,
+ *  optionally with RTE_PDUMP_FLAG_ZERO_COPY. In zero copy mode, the packets
+ *  are mirrored as indirect mbufs attached to the original ones, which
+ *  keeps them alive until the capture is done with them. The packet data
+ *  is then shared with the target process, which may still modify the
+ *  received packets.
+ * @param snaplen
+ *  maximum number of bytes captured of each packet, 0 for whole packets.
+ * @param ring
+ *  ring on which captured packets will be enqueued for user.
+ * @param mp
+ *  mempool on to which original packets will be mirrored or duplicated.
+ * @param prm
+ *  eBPF program the packets are filtered with, NULL for no filtering. The
+ *  packets for which the program returns zero are not captured. The program
+ *  gets the packet data or the mbuf, according to its argument type. The
+ *  program, its instructions and external symbols must be in memory shared
+ *  with the target process, e.g. allocated with rte_malloc().
+ *
+ * @return
+ *    0 on success, -1 on error, rte_errno is set accordingly.
+ */
+int __rte_experimental
+rte_pdump_enable_bpf(uint16_t port, uint16_t queue, uint32_t flags,
+		uint32_t snaplen,
+		struct rte_ring *ring,
+		struct rte_mempool *mp,
+		const struct rte_bpf_prm *prm);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enables filtered packet capturing on given device id and queue.
+ * device_id can be name or pci address of device.
+ * @see rte_pdump_enable_bpf
+ *
+ * @param device_id
+ *  device id on which packet capturing should be enabled.
+ * @param queue
+ *  queue of a given device id on which packet capturing should be enabled.
+ *  users should pass on value UINT16_MAX to enable packet capturing on all
+ *  queues of a given device id.
+ * @param flags
+ *  flags specifies RTE_PDUMP_FLAG_RX/RTE_PDUMP_FLAG_TX/RTE_PDUMP_FLAG_RXTX
+ *  on which packet capturing should be enabled for a given port and queue,
+ *  optionally with RTE_PDUMP_FLAG_ZERO_COPY.
+ * @param snaplen
+ *  maximum number of bytes captured of each packet, 0 for whole packets.
+ * @param ring
+ *  ring on which captured packets will be enqueued for user.
+ * @param mp
+ *  mempool on to which original packets will be mirrored or duplicated.
+ * @param prm
+ *  eBPF program the packets are filtered with, NULL for no filtering.
+ *
+ * @return
+ *    0 on success, -1 on error, rte_errno is set accordingly.
+ */
+int __rte_experimental
+rte_pdump_enable_bpf_by_deviceid(char *device_id, uint16_t queue,
+		uint32_t flags,
+		uint32_t snaplen,
+		struct rte_ring *ring,
+		struct rte_mempool *mp,
+		const struct rte_bpf_prm *prm);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the packet capture statistics of a queue. Can be called from any
+ * process once the target process called rte_pdump_init().
+ *
+ * @param port
+ *  port of the queue.
+ * @param queue
+ *  queue of the port.
+ * @param flags
+ *  RTE_PDUMP_FLAG_RX or RTE_PDUMP_FLAG_TX for the statistics of a
+ *  direction, RTE_PDUMP_FLAG_RXTX for their sum.
+ * @param stats
+ *  statistics of the queue.
+ *
+ * @return
+ *    0 on success, -1 on error, rte_errno is set accordingly.
+ */
+int __rte_experimental
+rte_pdump_queue_stats_get(uint16_t port, uint16_t queue, uint32_t flags,
+		struct rte_pdump_stats *stats);
+
 /**
  * @deprecated
  * Allows applications to set server and client socket paths.
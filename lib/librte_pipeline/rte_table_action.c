@@ -2831,7 +2831,8 @@ pkt_work(struct rte_mbuf *mbuf,
 	struct rte_pipeline_table_entry *table_entry,
 	uint64_t time,
 	struct rte_table_action *action,
-	struct ap_config *cfg)
+	struct ap_config *cfg,
+	uint64_t action_mask)
 {
 	uint64_t drop_mask = 0;
 
@@ -2854,7 +2855,7 @@ pkt_work(struct rte_mbuf *mbuf,
 			rte_ntohs(hdr->payload_len) + sizeof(struct ipv6_hdr);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_LB)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_LB)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_LB);
 
@@ -2862,7 +2863,7 @@ pkt_work(struct rte_mbuf *mbuf,
 			data,
 			&cfg->lb);
 	}
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_MTR)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_MTR)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_MTR);
 
@@ -2875,7 +2876,7 @@ pkt_work(struct rte_mbuf *mbuf,
 			total_length);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TM)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TM)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_TM);
 
@@ -2885,7 +2886,7 @@ pkt_work(struct rte_mbuf *mbuf,
 			dscp);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_DECAP)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_DECAP)) {
 		void *data = action_data_get(table_entry,
 			action,
 			RTE_TABLE_ACTION_DECAP);
@@ -2893,7 +2894,7 @@ pkt_work(struct rte_mbuf *mbuf,
 		pkt_work_decap(mbuf, data);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_ENCAP)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_ENCAP)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_ENCAP);
 
@@ -2905,7 +2906,7 @@ pkt_work(struct rte_mbuf *mbuf,
 			ip_offset);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_NAT)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_NAT)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_NAT);
 
@@ -2915,7 +2916,7 @@ pkt_work(struct rte_mbuf *mbuf,
 			pkt_ipv6_work_nat(ip, data, &cfg->nat);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TTL)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TTL)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_TTL);
 
@@ -2925,21 +2926,21 @@ pkt_work(struct rte_mbuf *mbuf,
 			drop_mask |= pkt_ipv6_work_ttl(ip, data);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_STATS)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_STATS)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_STATS);
 
 		pkt_work_stats(data, total_length);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TIME)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TIME)) {
 		void *data =
 			action_data_get(table_entry, action, RTE_TABLE_ACTION_TIME);
 
 		pkt_work_time(data, time);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_SYM_CRYPTO)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_SYM_CRYPTO)) {
 		void *data = action_data_get(table_entry, action,
 				RTE_TABLE_ACTION_SYM_CRYPTO);
 
@@ -2947,7 +2948,7 @@ pkt_work(struct rte_mbuf *mbuf,
 				ip_offset);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TAG)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TAG)) {
 		void *data = action_data_get(table_entry,
 			action,
 			RTE_TABLE_ACTION_TAG);
@@ -2963,7 +2964,8 @@ pkt4_work(struct rte_mbuf **mbufs,
 	struct rte_pipeline_table_entry **table_entries,
 	uint64_t time,
 	struct rte_table_action *action,
-	struct ap_config *cfg)
+	struct ap_config *cfg,
+	uint64_t action_mask)
 {
 	uint64_t drop_mask0 = 0;
 	uint64_t drop_mask1 = 0;
@@ -3025,7 +3027,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 			rte_ntohs(hdr3->payload_len) + sizeof(struct ipv6_hdr);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_LB)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_LB)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_LB);
 		void *data1 =
@@ -3052,7 +3054,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 			&cfg->lb);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_MTR)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_MTR)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_MTR);
 		void *data1 =
@@ -3095,7 +3097,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 			total_length3);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TM)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TM)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_TM);
 		void *data1 =
@@ -3126,7 +3128,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 			dscp3);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_DECAP)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_DECAP)) {
 		void *data0 = action_data_get(table_entry0,
 			action,
 			RTE_TABLE_ACTION_DECAP);
@@ -3144,7 +3146,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 			data0, data1, data2, data3);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_ENCAP)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_ENCAP)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_ENCAP);
 		void *data1 =
@@ -3183,7 +3185,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 			ip_offset);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_NAT)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_NAT)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_NAT);
 		void *data1 =
@@ -3206,7 +3208,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 		}
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TTL)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TTL)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_TTL);
 		void *data1 =
@@ -3229,7 +3231,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 		}
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_STATS)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_STATS)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_STATS);
 		void *data1 =
@@ -3245,7 +3247,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 		pkt_work_stats(data3, total_length3);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TIME)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TIME)) {
 		void *data0 =
 			action_data_get(table_entry0, action, RTE_TABLE_ACTION_TIME);
 		void *data1 =
@@ -3261,7 +3263,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 		pkt_work_time(data3, time);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_SYM_CRYPTO)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_SYM_CRYPTO)) {
 		void *data0 = action_data_get(table_entry0, action,
 				RTE_TABLE_ACTION_SYM_CRYPTO);
 		void *data1 = action_data_get(table_entry1, action,
@@ -3281,7 +3283,7 @@ pkt4_work(struct rte_mbuf **mbufs,
 				ip_offset);
 	}
 
-	if (cfg->action_mask & (1LLU << RTE_TABLE_ACTION_TAG)) {
+	if (action_mask & (1LLU << RTE_TABLE_ACTION_TAG)) {
 		void *data0 = action_data_get(table_entry0,
 			action,
 			RTE_TABLE_ACTION_TAG);
@@ -3311,12 +3313,13 @@ ah(struct rte_pipeline *p,
 	uint64_t pkts_mask,
 	struct rte_pipeline_table_entry **entries,
 	struct rte_table_action *action,
-	struct ap_config *cfg)
+	struct ap_config *cfg,
+	uint64_t action_mask)
 {
 	uint64_t pkts_drop_mask = 0;
 	uint64_t time = 0;
 
-	if (cfg->action_mask & ((1LLU << RTE_TABLE_ACTION_MTR) |
+	if (action_mask & ((1LLU << RTE_TABLE_ACTION_MTR) |
 		(1LLU << RTE_TABLE_ACTION_TIME)))
 		time = rte_rdtsc();
 
@@ -3331,7 +3334,8 @@ ah(struct rte_pipeline *p,
 				&entries[i],
 				time,
 				action,
-				cfg);
+				cfg,
+				action_mask);
 
 			pkts_drop_mask |= drop_mask << i;
 		}
@@ -3343,7 +3347,8 @@ ah(struct rte_pipeline *p,
 				entries[i],
 				time,
 				action,
-				cfg);
+				cfg,
+				action_mask);
 
 			pkts_drop_mask |= drop_mask << i;
 		}
@@ -3357,7 +3362,8 @@ ah(struct rte_pipeline *p,
 				entries[pos],
 				time,
 				action,
-				cfg);
+				cfg,
+				action_mask);
 
 			pkts_mask &= ~pkt_mask;
 			pkts_drop_mask |= drop_mask << pos;
@@ -3382,15 +3388,71 @@ ah_default(struct rte_pipeline *p,
 		pkts_mask,
 		entries,
 		action,
-		&action->cfg);
+		&action->cfg,
+		action->cfg.action_mask);
 }
 
+/*
+ * Action handlers specialized for the action masks of common pipelines, where
+ * the checks of the actions not in the mask are removed at build time.
+ */
+#define AM(type) (1LLU << RTE_TABLE_ACTION_##type)
+
+#define AH_SPEC_LIST							\
+	AH_SPEC(lb, AM(LB))						\
+	AH_SPEC(encap, AM(ENCAP))					\
+	AH_SPEC(stats, AM(STATS))					\
+	AH_SPEC(ttl_stats, AM(TTL) | AM(STATS))				\
+	AH_SPEC(encap_ttl_stats, AM(ENCAP) | AM(TTL) | AM(STATS))	\
+	AH_SPEC(nat_encap_ttl_stats,					\
+		AM(NAT) | AM(ENCAP) | AM(TTL) | AM(STATS))		\
+	AH_SPEC(mtr_tm_stats, AM(MTR) | AM(TM) | AM(STATS))		\
+	AH_SPEC(sym_crypto, AM(SYM_CRYPTO))
+
+#define AH_SPEC(name, mask)						\
+static int								\
+ah_##name(struct rte_pipeline *p,					\
+	struct rte_mbuf **pkts,						\
+	uint64_t pkts_mask,						\
+	struct rte_pipeline_table_entry **entries,			\
+	void *arg)							\
+{									\
+	struct rte_table_action *action = arg;				\
+									\
+	return ah(p,							\
+		pkts,							\
+		pkts_mask,						\
+		entries,						\
+		action,							\
+		&action->cfg,						\
+		(mask) | AM(FWD));					\
+}
+
+AH_SPEC_LIST
+
+#undef AH_SPEC
+#define AH_SPEC(name, mask) {(mask) | AM(FWD), ah_##name},
+
+static const struct {
+	uint64_t action_mask;
+	rte_pipeline_table_action_handler_hit f_action_hit;
+} ah_spec[] = {
+	AH_SPEC_LIST
+};
+
 static rte_pipeline_table_action_handler_hit
 ah_selector(struct rte_table_action *action)
 {
-	if (action->cfg.action_mask == (1LLU << RTE_TABLE_ACTION_FWD))
+	uint64_t action_mask = action->cfg.action_mask;
+	uint32_t i;
+
+	if (action_mask == AM(FWD))
 		return NULL;
 
+	for (i = 0; i < RTE_DIM(ah_spec); i++)
+		if (action_mask == ah_spec[i].action_mask)
+			return ah_spec[i].f_action_hit;
+
 	return ah_default;
 }
 
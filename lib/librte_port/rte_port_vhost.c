@@ -0,0 +1,577 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_malloc.h>
+#include <rte_vhost.h>
+
+#include "rte_port_vhost.h"
+
+/* Most packets moved by one call to the vhost library */
+#define VHOST_BURST_MAX 32
+
+/* Vrings of a queue pair, seen from the guest */
+#define VHOST_RXQ(queue_id) ((queue_id) * 2)
+#define VHOST_TXQ(queue_id) ((queue_id) * 2 + 1)
+
+/*
+ * Port vhost Reader
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_VHOST_READER_STATS_PKTS_IN_ADD(port, val) \
+	port->stats.n_pkts_in += val
+#define RTE_PORT_VHOST_READER_STATS_PKTS_DROP_ADD(port, val) \
+	port->stats.n_pkts_drop += val
+
+#else
+
+#define RTE_PORT_VHOST_READER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_VHOST_READER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_vhost_reader {
+	struct rte_port_in_stats stats;
+
+	volatile int *vid;
+	uint16_t vring_id;
+	struct rte_mempool *mempool;
+};
+
+static void *
+rte_port_vhost_reader_create(void *params, int socket_id)
+{
+	struct rte_port_vhost_reader_params *conf =
+			params;
+	struct rte_port_vhost_reader *port;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->vid == NULL) ||
+		(conf->mempool == NULL)) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->vid = conf->vid;
+	port->vring_id = VHOST_TXQ(conf->queue_id);
+	port->mempool = conf->mempool;
+
+	return port;
+}
+
+static int
+rte_port_vhost_reader_rx(void *port, struct rte_mbuf **pkts, uint32_t n_pkts)
+{
+	struct rte_port_vhost_reader *p =
+			port;
+	uint32_t rx_pkt_cnt = 0;
+	uint32_t n, n_rx;
+	int vid = *p->vid;
+
+	if (vid < 0)
+		return 0;
+
+	while (rx_pkt_cnt < n_pkts) {
+		n = RTE_MIN(n_pkts - rx_pkt_cnt, (uint32_t)VHOST_BURST_MAX);
+		n_rx = rte_vhost_dequeue_burst(vid, p->vring_id, p->mempool,
+			pkts + rx_pkt_cnt, n);
+		rx_pkt_cnt += n_rx;
+		if (n_rx < n)
+			break;
+	}
+
+	RTE_PORT_VHOST_READER_STATS_PKTS_IN_ADD(p, rx_pkt_cnt);
+	return rx_pkt_cnt;
+}
+
+static int
+rte_port_vhost_reader_free(void *port)
+{
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_vhost_reader_stats_read(void *port,
+	struct rte_port_in_stats *stats, int clear)
+{
+	struct rte_port_vhost_reader *p =
+			port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * The vhost library copies the packets to the guest, the mbufs are freed
+ * once the burst is done, whether sent or not. Returns the number of
+ * packets sent.
+ */
+static inline uint32_t
+vhost_enqueue(int vid, uint16_t vring_id, struct rte_mbuf **pkts,
+	uint32_t n_pkts)
+{
+	uint32_t nb_tx = 0;
+	uint32_t n, n_tx;
+
+	if (vid < 0)
+		return 0;
+
+	while (nb_tx < n_pkts) {
+		n = RTE_MIN(n_pkts - nb_tx, (uint32_t)VHOST_BURST_MAX);
+		n_tx = rte_vhost_enqueue_burst(vid, vring_id, pkts + nb_tx, n);
+		nb_tx += n_tx;
+		if (n_tx < n)
+			break;
+	}
+
+	return nb_tx;
+}
+
+static inline void
+vhost_free_pkts(struct rte_mbuf **pkts, uint32_t n_pkts)
+{
+	uint32_t i;
+
+	for (i = 0; i < n_pkts; i++)
+		rte_pktmbuf_free(pkts[i]);
+}
+
+/*
+ * Port vhost Writer
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_VHOST_WRITER_STATS_PKTS_IN_ADD(port, val) \
+	port->stats.n_pkts_in += val
+#define RTE_PORT_VHOST_WRITER_STATS_PKTS_DROP_ADD(port, val) \
+	port->stats.n_pkts_drop += val
+
+#else
+
+#define RTE_PORT_VHOST_WRITER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_VHOST_WRITER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_vhost_writer {
+	struct rte_port_out_stats stats;
+
+	struct rte_mbuf *tx_buf[2 * RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t tx_burst_sz;
+	uint32_t tx_buf_count;
+	uint64_t bsz_mask;
+	volatile int *vid;
+	uint16_t vring_id;
+};
+
+static void *
+rte_port_vhost_writer_create(void *params, int socket_id)
+{
+	struct rte_port_vhost_writer_params *conf =
+			params;
+	struct rte_port_vhost_writer *port;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->vid == NULL) ||
+		(conf->tx_burst_sz == 0) ||
+		(conf->tx_burst_sz > RTE_PORT_IN_BURST_SIZE_MAX) ||
+		(!rte_is_power_of_2(conf->tx_burst_sz))) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->vid = conf->vid;
+	port->vring_id = VHOST_RXQ(conf->queue_id);
+	port->tx_burst_sz = conf->tx_burst_sz;
+	port->tx_buf_count = 0;
+	port->bsz_mask = 1LLU << (conf->tx_burst_sz - 1);
+
+	return port;
+}
+
+static inline void
+send_burst(struct rte_port_vhost_writer *p)
+{
+	uint32_t nb_tx;
+
+	nb_tx = vhost_enqueue(*p->vid, p->vring_id, p->tx_buf,
+		p->tx_buf_count);
+
+	RTE_PORT_VHOST_WRITER_STATS_PKTS_DROP_ADD(p, p->tx_buf_count - nb_tx);
+	RTE_SET_USED(nb_tx);
+	vhost_free_pkts(p->tx_buf, p->tx_buf_count);
+
+	p->tx_buf_count = 0;
+}
+
+static int
+rte_port_vhost_writer_tx(void *port, struct rte_mbuf *pkt)
+{
+	struct rte_port_vhost_writer *p =
+			port;
+
+	p->tx_buf[p->tx_buf_count++] = pkt;
+	RTE_PORT_VHOST_WRITER_STATS_PKTS_IN_ADD(p, 1);
+	if (p->tx_buf_count >= p->tx_burst_sz)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_vhost_writer_tx_bulk(void *port,
+	struct rte_mbuf **pkts,
+	uint64_t pkts_mask)
+{
+	struct rte_port_vhost_writer *p =
+			port;
+	uint64_t bsz_mask = p->bsz_mask;
+	uint32_t tx_buf_count = p->tx_buf_count;
+	uint64_t expr = (pkts_mask & (pkts_mask + 1)) |
+					((pkts_mask & bsz_mask) ^ bsz_mask);
+
+	if (expr == 0) {
+		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
+		uint32_t n_pkts_ok;
+
+		if (tx_buf_count)
+			send_burst(p);
+
+		RTE_PORT_VHOST_WRITER_STATS_PKTS_IN_ADD(p, n_pkts);
+		n_pkts_ok = vhost_enqueue(*p->vid, p->vring_id, pkts, n_pkts);
+
+		RTE_PORT_VHOST_WRITER_STATS_PKTS_DROP_ADD(p, n_pkts - n_pkts_ok);
+		RTE_SET_USED(n_pkts_ok);
+		vhost_free_pkts(pkts, n_pkts);
+	} else {
+		for (; pkts_mask;) {
+			uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+			uint64_t pkt_mask = 1LLU << pkt_index;
+			struct rte_mbuf *pkt = pkts[pkt_index];
+
+			p->tx_buf[tx_buf_count++] = pkt;
+			RTE_PORT_VHOST_WRITER_STATS_PKTS_IN_ADD(p, 1);
+			pkts_mask &= ~pkt_mask;
+		}
+
+		p->tx_buf_count = tx_buf_count;
+		if (tx_buf_count >= p->tx_burst_sz)
+			send_burst(p);
+	}
+
+	return 0;
+}
+
+static int
+rte_port_vhost_writer_flush(void *port)
+{
+	struct rte_port_vhost_writer *p =
+			port;
+
+	if (p->tx_buf_count > 0)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_vhost_writer_free(void *port)
+{
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_port_vhost_writer_flush(port);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_vhost_writer_stats_read(void *port,
+	struct rte_port_out_stats *stats, int clear)
+{
+	struct rte_port_vhost_writer *p =
+			port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Port vhost Writer Nodrop
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_IN_ADD(port, val) \
+	port->stats.n_pkts_in += val
+#define RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_DROP_ADD(port, val) \
+	port->stats.n_pkts_drop += val
+
+#else
+
+#define RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_vhost_writer_nodrop {
+	struct rte_port_out_stats stats;
+
+	struct rte_mbuf *tx_buf[2 * RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t tx_burst_sz;
+	uint32_t tx_buf_count;
+	uint64_t bsz_mask;
+	uint64_t n_retries;
+	volatile int *vid;
+	uint16_t vring_id;
+};
+
+static void *
+rte_port_vhost_writer_nodrop_create(void *params, int socket_id)
+{
+	struct rte_port_vhost_writer_nodrop_params *conf =
+			params;
+	struct rte_port_vhost_writer_nodrop *port;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->vid == NULL) ||
+		(conf->tx_burst_sz == 0) ||
+		(conf->tx_burst_sz > RTE_PORT_IN_BURST_SIZE_MAX) ||
+		(!rte_is_power_of_2(conf->tx_burst_sz))) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->vid = conf->vid;
+	port->vring_id = VHOST_RXQ(conf->queue_id);
+	port->tx_burst_sz = conf->tx_burst_sz;
+	port->tx_buf_count = 0;
+	port->bsz_mask = 1LLU << (conf->tx_burst_sz - 1);
+
+	/*
+	 * When n_retries is 0 it means that we should wait for every packet to
+	 * send no matter how many retries should it take. To limit number of
+	 * branches in fast path, we use UINT64_MAX instead of branching.
+	 */
+	port->n_retries = (conf->n_retries == 0) ? UINT64_MAX : conf->n_retries;
+
+	return port;
+}
+
+static inline void
+send_burst_nodrop(struct rte_port_vhost_writer_nodrop *p)
+{
+	uint32_t nb_tx = 0;
+	uint64_t i;
+	int vid = *p->vid;
+
+	/* Retrying is useless without a device */
+	if (vid < 0)
+		goto drop;
+
+	nb_tx = vhost_enqueue(vid, p->vring_id, p->tx_buf, p->tx_buf_count);
+
+	for (i = 0; nb_tx < p->tx_buf_count && i < p->n_retries; i++)
+		nb_tx += vhost_enqueue(vid, p->vring_id, p->tx_buf + nb_tx,
+			p->tx_buf_count - nb_tx);
+
+drop:
+	/* We didn't send the packets in maximum allowed attempts */
+	RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_DROP_ADD(p,
+		p->tx_buf_count - nb_tx);
+	vhost_free_pkts(p->tx_buf, p->tx_buf_count);
+
+	p->tx_buf_count = 0;
+}
+
+static int
+rte_port_vhost_writer_nodrop_tx(void *port, struct rte_mbuf *pkt)
+{
+	struct rte_port_vhost_writer_nodrop *p =
+			port;
+
+	p->tx_buf[p->tx_buf_count++] = pkt;
+	RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_IN_ADD(p, 1);
+	if (p->tx_buf_count >= p->tx_burst_sz)
+		send_burst_nodrop(p);
+
+	return 0;
+}
+
+static int
+rte_port_vhost_writer_nodrop_tx_bulk(void *port,
+	struct rte_mbuf **pkts,
+	uint64_t pkts_mask)
+{
+	struct rte_port_vhost_writer_nodrop *p =
+			port;
+	uint64_t bsz_mask = p->bsz_mask;
+	uint32_t tx_buf_count = p->tx_buf_count;
+	uint64_t expr = (pkts_mask & (pkts_mask + 1)) |
+					((pkts_mask & bsz_mask) ^ bsz_mask);
+
+	if (expr == 0) {
+		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
+		uint32_t n_pkts_ok;
+
+		if (tx_buf_count)
+			send_burst_nodrop(p);
+
+		RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_IN_ADD(p, n_pkts);
+		n_pkts_ok = vhost_enqueue(*p->vid, p->vring_id, pkts, n_pkts);
+
+		if (n_pkts_ok >= n_pkts) {
+			vhost_free_pkts(pkts, n_pkts);
+			return 0;
+		}
+
+		/*
+		 * If we didn't manage to send all packets in single burst,
+		 * free the ones sent, move remaining packets to the buffer
+		 * and call send burst.
+		 */
+		vhost_free_pkts(pkts, n_pkts_ok);
+		for (; n_pkts_ok < n_pkts; n_pkts_ok++) {
+			struct rte_mbuf *pkt = pkts[n_pkts_ok];
+
+			p->tx_buf[p->tx_buf_count++] = pkt;
+		}
+		send_burst_nodrop(p);
+	} else {
+		for ( ; pkts_mask; ) {
+			uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+			uint64_t pkt_mask = 1LLU << pkt_index;
+			struct rte_mbuf *pkt = pkts[pkt_index];
+
+			p->tx_buf[tx_buf_count++] = pkt;
+			RTE_PORT_VHOST_WRITER_NODROP_STATS_PKTS_IN_ADD(p, 1);
+			pkts_mask &= ~pkt_mask;
+		}
+
+		p->tx_buf_count = tx_buf_count;
+		if (tx_buf_count >= p->tx_burst_sz)
+			send_burst_nodrop(p);
+	}
+
+	return 0;
+}
+
+static int
+rte_port_vhost_writer_nodrop_flush(void *port)
+{
+	struct rte_port_vhost_writer_nodrop *p =
+			port;
+
+	if (p->tx_buf_count > 0)
+		send_burst_nodrop(p);
+
+	return 0;
+}
+
+static int
+rte_port_vhost_writer_nodrop_free(void *port)
+{
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_port_vhost_writer_nodrop_flush(port);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_vhost_writer_nodrop_stats_read(void *port,
+	struct rte_port_out_stats *stats, int clear)
+{
+	struct rte_port_vhost_writer_nodrop *p =
+			port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+
+/*
+ * Summary of port operations
+ */
+struct rte_port_in_ops rte_port_vhost_reader_ops = {
+	.f_create = rte_port_vhost_reader_create,
+	.f_free = rte_port_vhost_reader_free,
+	.f_rx = rte_port_vhost_reader_rx,
+	.f_stats = rte_port_vhost_reader_stats_read,
+};
+
+struct rte_port_out_ops rte_port_vhost_writer_ops = {
+	.f_create = rte_port_vhost_writer_create,
+	.f_free = rte_port_vhost_writer_free,
+	.f_tx = rte_port_vhost_writer_tx,
+	.f_tx_bulk = rte_port_vhost_writer_tx_bulk,
+	.f_flush = rte_port_vhost_writer_flush,
+	.f_stats = rte_port_vhost_writer_stats_read,
+};
+
+struct rte_port_out_ops rte_port_vhost_writer_nodrop_ops = {
+	.f_create = rte_port_vhost_writer_nodrop_create,
+	.f_free = rte_port_vhost_writer_nodrop_free,
+	.f_tx = rte_port_vhost_writer_nodrop_tx,
+	.f_tx_bulk = rte_port_vhost_writer_nodrop_tx_bulk,
+	.f_flush = rte_port_vhost_writer_nodrop_flush,
+	.f_stats = rte_port_vhost_writer_nodrop_stats_read,
+};
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef __INCLUDE_RTE_PORT_VHOST_H__
+#define __INCLUDE_RTE_PORT_VHOST_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * RTE Port vhost Interface
+ *
+ * vhost_reader: input port built on top of a vhost device queue pair,
+ * receiving the packets sent by the guest
+ * vhost_writer: output port built on top of a vhost device queue pair,
+ * sending packets to the guest
+ *
+ * The ports call the vhost library directly. The vhost device ID is read
+ * through a pointer by each burst, so that the application can set it
+ * from the new_device() and destroy_device() callbacks of the vhost
+ * library: a negative ID means that the device is not ready, the reader
+ * then returns no packet and the writer drops the packets. Before its
+ * destroy_device() callback returns, the application must make sure that
+ * no burst of the ports is still using the previous ID.
+ *
+ ***/
+
+#include <stdint.h>
+
+#include <rte_mempool.h>
+
+#include "rte_port.h"
+
+/** vhost_reader port parameters */
+struct rte_port_vhost_reader_params {
+	/** Location of the vhost device ID, negative when not ready */
+	volatile int *vid;
+
+	/** Queue pair of the device, the reader takes from its Tx vring */
+	uint16_t queue_id;
+
+	/** Mempool of the received packets */
+	struct rte_mempool *mempool;
+};
+
+/** vhost_reader port operations */
+extern struct rte_port_in_ops rte_port_vhost_reader_ops;
+
+
+/** vhost_writer port parameters */
+struct rte_port_vhost_writer_params {
+	/** Location of the vhost device ID, negative when not ready */
+	volatile int *vid;
+
+	/** Queue pair of the device, the writer fills its Rx vring */
+	uint16_t queue_id;
+
+	/** Recommended burst size to vhost device. */
+	uint32_t tx_burst_sz;
+};
+
+/** vhost_writer port operations */
+extern struct rte_port_out_ops rte_port_vhost_writer_ops;
+
+/** vhost_writer_nodrop port parameters */
+struct rte_port_vhost_writer_nodrop_params {
+	/** Location of the vhost device ID, negative when not ready */
+	volatile int *vid;
+
+	/** Queue pair of the device, the writer fills its Rx vring */
+	uint16_t queue_id;
+
+	/** Recommended burst size to vhost device. */
+	uint32_t tx_burst_sz;
+
+	/** Maximum number of retries, 0 for no limit */
+	uint32_t n_retries;
+};
+
+/** vhost_writer_nodrop port operations */
+extern struct rte_port_out_ops rte_port_vhost_writer_nodrop_ops;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,706 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_dev.h>
+#include <rte_mbuf.h>
+#include <rte_ethdev.h>
+#include <rte_malloc.h>
+#include <rte_net.h>
+
+#include "rte_port_virtio_user.h"
+
+/* Room of the device arguments given to the virtio-user driver */
+#define VIRTIO_USER_DEVARGS_SIZE 256
+
+/*
+ * virtio-user device
+ */
+int __rte_experimental
+rte_port_virtio_user_dev_create(struct rte_port_virtio_user_dev_params *params,
+	uint16_t *port_id)
+{
+	struct rte_eth_conf conf;
+	struct rte_eth_dev_info dev_info;
+	struct rte_eth_rxconf rxconf;
+	struct rte_eth_txconf txconf;
+	char devargs[VIRTIO_USER_DEVARGS_SIZE];
+	const char *path;
+	uint16_t pid, q;
+	int n, ret;
+
+	/* Check input parameters */
+	if ((params == NULL) ||
+		(params->name == NULL) ||
+		(params->n_queues == 0) ||
+		(params->mempool == NULL) ||
+		(port_id == NULL)) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return -EINVAL;
+	}
+
+	path = (params->path != NULL) ? params->path :
+		RTE_PORT_VIRTIO_USER_PATH_DEFAULT;
+	n = snprintf(devargs, sizeof(devargs), "path=%s,queues=%u",
+		path, params->n_queues);
+	if (params->queue_size && (n > 0) && (n < (int)sizeof(devargs)))
+		n += snprintf(devargs + n, sizeof(devargs) - n,
+			",queue_size=%u", params->queue_size);
+	if (params->iface && (n > 0) && (n < (int)sizeof(devargs)))
+		n += snprintf(devargs + n, sizeof(devargs) - n,
+			",iface=%s", params->iface);
+	if ((n < 0) || (n >= (int)sizeof(devargs))) {
+		RTE_LOG(ERR, PORT, "%s: Device arguments too long\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	/* Device creation */
+	ret = rte_eal_hotplug_add("vdev", params->name, devargs);
+	if (ret) {
+		RTE_LOG(ERR, PORT, "%s: Cannot create device %s (%d)\n",
+			__func__, params->name, ret);
+		return ret;
+	}
+
+	ret = rte_eth_dev_get_port_by_name(params->name, &pid);
+	if (ret)
+		goto remove;
+
+	/* Device configuration, within the offloads negotiated with vhost-net */
+	rte_eth_dev_info_get(pid, &dev_info);
+
+	memset(&conf, 0, sizeof(conf));
+	conf.rxmode.offloads = params->rx_offloads & dev_info.rx_offload_capa;
+	conf.txmode.offloads = params->tx_offloads & dev_info.tx_offload_capa;
+
+	ret = rte_eth_dev_configure(pid, params->n_queues, params->n_queues,
+		&conf);
+	if (ret)
+		goto remove;
+
+	rxconf = dev_info.default_rxconf;
+	rxconf.offloads = conf.rxmode.offloads;
+	txconf = dev_info.default_txconf;
+	txconf.offloads = conf.txmode.offloads;
+
+	for (q = 0; q < params->n_queues; q++) {
+		ret = rte_eth_rx_queue_setup(pid, q, params->queue_size,
+			params->socket_id, &rxconf, params->mempool);
+		if (ret)
+			goto remove;
+
+		ret = rte_eth_tx_queue_setup(pid, q, params->queue_size,
+			params->socket_id, &txconf);
+		if (ret)
+			goto remove;
+	}
+
+	ret = rte_eth_dev_start(pid);
+	if (ret)
+		goto remove;
+
+	*port_id = pid;
+	return 0;
+
+remove:
+	RTE_LOG(ERR, PORT, "%s: Cannot set up device %s (%d)\n",
+		__func__, params->name, ret);
+	rte_eal_hotplug_remove("vdev", params->name);
+	return ret;
+}
+
+int __rte_experimental
+rte_port_virtio_user_dev_free(uint16_t port_id)
+{
+	char name[RTE_ETH_NAME_MAX_LEN];
+	int ret;
+
+	ret = rte_eth_dev_get_name_by_port(port_id, name);
+	if (ret) {
+		RTE_LOG(ERR, PORT, "%s: Invalid port %u\n", __func__, port_id);
+		return ret;
+	}
+
+	rte_eth_dev_stop(port_id);
+	rte_eth_dev_close(port_id);
+
+	return rte_eal_hotplug_remove("vdev", name);
+}
+
+/*
+ * Port virtio-user Reader
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_VIRTIO_USER_READER_STATS_PKTS_IN_ADD(port, val) \
+	port->stats.n_pkts_in += val
+#define RTE_PORT_VIRTIO_USER_READER_STATS_PKTS_DROP_ADD(port, val) \
+	port->stats.n_pkts_drop += val
+
+#else
+
+#define RTE_PORT_VIRTIO_USER_READER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_VIRTIO_USER_READER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_virtio_user_reader {
+	struct rte_port_in_stats stats;
+
+	int tx_offload;
+	uint16_t queue_id;
+	uint16_t port_id;
+};
+
+static void *
+rte_port_virtio_user_reader_create(void *params, int socket_id)
+{
+	struct rte_port_virtio_user_reader_params *conf =
+			params;
+	struct rte_port_virtio_user_reader *port;
+
+	/* Check input parameters */
+	if (conf == NULL) {
+		RTE_LOG(ERR, PORT, "%s: params is NULL\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->port_id = conf->port_id;
+	port->queue_id = conf->queue_id;
+	port->tx_offload = conf->tx_offload;
+
+	return port;
+}
+
+/*
+ * The kernel leaves the L4 checksum of a packet to its receiver, and
+ * gives the large TCP packets unsegmented, which the virtio-user driver
+ * reports as PKT_RX_L4_CKSUM_NONE and PKT_RX_LRO: turn them into the Tx
+ * offload requests of the NIC. The L4 checksum field already holds the
+ * pseudo-header checksum, as expected by the NICs.
+ */
+static inline void
+virtio_user_tx_offload_set(struct rte_mbuf *pkt)
+{
+	struct rte_net_hdr_lens hdr_lens;
+	uint64_t ol_flags = pkt->ol_flags;
+	uint32_t ptype;
+
+	if ((ol_flags & PKT_RX_L4_CKSUM_MASK) != PKT_RX_L4_CKSUM_NONE)
+		return;
+
+	ptype = rte_net_get_ptype(pkt, &hdr_lens,
+		RTE_PTYPE_L2_MASK | RTE_PTYPE_L3_MASK | RTE_PTYPE_L4_MASK);
+
+	if (RTE_ETH_IS_IPV4_HDR(ptype))
+		ol_flags |= PKT_TX_IPV4;
+	else if (RTE_ETH_IS_IPV6_HDR(ptype))
+		ol_flags |= PKT_TX_IPV6;
+	else
+		return;
+
+	switch (ptype & RTE_PTYPE_L4_MASK) {
+	case RTE_PTYPE_L4_TCP:
+		if (ol_flags & PKT_RX_LRO) {
+			ol_flags |= PKT_TX_TCP_SEG;
+			if (ol_flags & PKT_TX_IPV4)
+				ol_flags |= PKT_TX_IP_CKSUM;
+		} else
+			ol_flags |= PKT_TX_TCP_CKSUM;
+		break;
+	case RTE_PTYPE_L4_UDP:
+		ol_flags |= PKT_TX_UDP_CKSUM;
+		break;
+	default:
+		return;
+	}
+
+	pkt->l2_len = hdr_lens.l2_len;
+	pkt->l3_len = hdr_lens.l3_len;
+	pkt->l4_len = hdr_lens.l4_len;
+	pkt->ol_flags = ol_flags;
+}
+
+static int
+rte_port_virtio_user_reader_rx(void *port, struct rte_mbuf **pkts,
+	uint32_t n_pkts)
+{
+	struct rte_port_virtio_user_reader *p =
+		port;
+	uint16_t rx_pkt_cnt, i;
+
+	rx_pkt_cnt = rte_eth_rx_burst(p->port_id, p->queue_id, pkts, n_pkts);
+	RTE_PORT_VIRTIO_USER_READER_STATS_PKTS_IN_ADD(p, rx_pkt_cnt);
+
+	if (p->tx_offload)
+		for (i = 0; i < rx_pkt_cnt; i++)
+			virtio_user_tx_offload_set(pkts[i]);
+
+	return rx_pkt_cnt;
+}
+
+static int
+rte_port_virtio_user_reader_free(void *port)
+{
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_virtio_user_reader_stats_read(void *port,
+		struct rte_port_in_stats *stats, int clear)
+{
+	struct rte_port_virtio_user_reader *p =
+			port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Port virtio-user Writer
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_IN_ADD(port, val) \
+	port->stats.n_pkts_in += val
+#define RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_DROP_ADD(port, val) \
+	port->stats.n_pkts_drop += val
+
+#else
+
+#define RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_virtio_user_writer {
+	struct rte_port_out_stats stats;
+
+	struct rte_mbuf *tx_buf[2 * RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t tx_burst_sz;
+	uint16_t tx_buf_count;
+	uint64_t bsz_mask;
+	uint16_t queue_id;
+	uint16_t port_id;
+};
+
+static void *
+rte_port_virtio_user_writer_create(void *params, int socket_id)
+{
+	struct rte_port_virtio_user_writer_params *conf =
+			params;
+	struct rte_port_virtio_user_writer *port;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->tx_burst_sz == 0) ||
+		(conf->tx_burst_sz > RTE_PORT_IN_BURST_SIZE_MAX) ||
+		(!rte_is_power_of_2(conf->tx_burst_sz))) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->port_id = conf->port_id;
+	port->queue_id = conf->queue_id;
+	port->tx_burst_sz = conf->tx_burst_sz;
+	port->tx_buf_count = 0;
+	port->bsz_mask = 1LLU << (conf->tx_burst_sz - 1);
+
+	return port;
+}
+
+static inline void
+send_burst(struct rte_port_virtio_user_writer *p)
+{
+	uint32_t nb_tx;
+
+	nb_tx = rte_eth_tx_burst(p->port_id, p->queue_id,
+			 p->tx_buf, p->tx_buf_count);
+
+	RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_DROP_ADD(p,
+		p->tx_buf_count - nb_tx);
+	for ( ; nb_tx < p->tx_buf_count; nb_tx++)
+		rte_pktmbuf_free(p->tx_buf[nb_tx]);
+
+	p->tx_buf_count = 0;
+}
+
+static int
+rte_port_virtio_user_writer_tx(void *port, struct rte_mbuf *pkt)
+{
+	struct rte_port_virtio_user_writer *p =
+		port;
+
+	p->tx_buf[p->tx_buf_count++] = pkt;
+	RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_IN_ADD(p, 1);
+	if (p->tx_buf_count >= p->tx_burst_sz)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_virtio_user_writer_tx_bulk(void *port,
+		struct rte_mbuf **pkts,
+		uint64_t pkts_mask)
+{
+	struct rte_port_virtio_user_writer *p =
+		port;
+	uint64_t bsz_mask = p->bsz_mask;
+	uint32_t tx_buf_count = p->tx_buf_count;
+	uint64_t expr = (pkts_mask & (pkts_mask + 1)) |
+			((pkts_mask & bsz_mask) ^ bsz_mask);
+
+	if (expr == 0) {
+		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
+		uint32_t n_pkts_ok;
+
+		if (tx_buf_count)
+			send_burst(p);
+
+		RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_IN_ADD(p, n_pkts);
+		n_pkts_ok = rte_eth_tx_burst(p->port_id, p->queue_id, pkts,
+			n_pkts);
+
+		RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_DROP_ADD(p,
+			n_pkts - n_pkts_ok);
+		for ( ; n_pkts_ok < n_pkts; n_pkts_ok++) {
+			struct rte_mbuf *pkt = pkts[n_pkts_ok];
+
+			rte_pktmbuf_free(pkt);
+		}
+	} else {
+		for ( ; pkts_mask; ) {
+			uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+			uint64_t pkt_mask = 1LLU << pkt_index;
+			struct rte_mbuf *pkt = pkts[pkt_index];
+
+			p->tx_buf[tx_buf_count++] = pkt;
+			RTE_PORT_VIRTIO_USER_WRITER_STATS_PKTS_IN_ADD(p, 1);
+			pkts_mask &= ~pkt_mask;
+		}
+
+		p->tx_buf_count = tx_buf_count;
+		if (tx_buf_count >= p->tx_burst_sz)
+			send_burst(p);
+	}
+
+	return 0;
+}
+
+static int
+rte_port_virtio_user_writer_flush(void *port)
+{
+	struct rte_port_virtio_user_writer *p =
+		port;
+
+	if (p->tx_buf_count > 0)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_virtio_user_writer_free(void *port)
+{
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_port_virtio_user_writer_flush(port);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_virtio_user_writer_stats_read(void *port,
+		struct rte_port_out_stats *stats, int clear)
+{
+	struct rte_port_virtio_user_writer *p =
+		port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Port virtio-user Writer Nodrop
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_IN_ADD(port, val) \
+	port->stats.n_pkts_in += val
+#define RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_DROP_ADD(port, val) \
+	port->stats.n_pkts_drop += val
+
+#else
+
+#define RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_virtio_user_writer_nodrop {
+	struct rte_port_out_stats stats;
+
+	struct rte_mbuf *tx_buf[2 * RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t tx_burst_sz;
+	uint16_t tx_buf_count;
+	uint64_t bsz_mask;
+	uint64_t n_retries;
+	uint16_t queue_id;
+	uint16_t port_id;
+};
+
+static void *
+rte_port_virtio_user_writer_nodrop_create(void *params, int socket_id)
+{
+	struct rte_port_virtio_user_writer_nodrop_params *conf =
+			params;
+	struct rte_port_virtio_user_writer_nodrop *port;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->tx_burst_sz == 0) ||
+		(conf->tx_burst_sz > RTE_PORT_IN_BURST_SIZE_MAX) ||
+		(!rte_is_power_of_2(conf->tx_burst_sz))) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->port_id = conf->port_id;
+	port->queue_id = conf->queue_id;
+	port->tx_burst_sz = conf->tx_burst_sz;
+	port->tx_buf_count = 0;
+	port->bsz_mask = 1LLU << (conf->tx_burst_sz - 1);
+
+	/*
+	 * When n_retries is 0 it means that we should wait for every packet to
+	 * send no matter how many retries should it take. To limit number of
+	 * branches in fast path, we use UINT64_MAX instead of branching.
+	 */
+	port->n_retries = (conf->n_retries == 0) ? UINT64_MAX : conf->n_retries;
+
+	return port;
+}
+
+static inline void
+send_burst_nodrop(struct rte_port_virtio_user_writer_nodrop *p)
+{
+	uint32_t nb_tx = 0, i;
+
+	nb_tx = rte_eth_tx_burst(p->port_id, p->queue_id, p->tx_buf,
+			p->tx_buf_count);
+
+	/* We sent all the packets in a first try */
+	if (nb_tx >= p->tx_buf_count) {
+		p->tx_buf_count = 0;
+		return;
+	}
+
+	for (i = 0; i < p->n_retries; i++) {
+		nb_tx += rte_eth_tx_burst(p->port_id, p->queue_id,
+			p->tx_buf + nb_tx, p->tx_buf_count - nb_tx);
+
+		/* We sent all the packets in more than one try */
+		if (nb_tx >= p->tx_buf_count) {
+			p->tx_buf_count = 0;
+			return;
+		}
+	}
+
+	/* We didn't send the packets in maximum allowed attempts */
+	RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_DROP_ADD(p,
+		p->tx_buf_count - nb_tx);
+	for ( ; nb_tx < p->tx_buf_count; nb_tx++)
+		rte_pktmbuf_free(p->tx_buf[nb_tx]);
+
+	p->tx_buf_count = 0;
+}
+
+static int
+rte_port_virtio_user_writer_nodrop_tx(void *port, struct rte_mbuf *pkt)
+{
+	struct rte_port_virtio_user_writer_nodrop *p =
+		port;
+
+	p->tx_buf[p->tx_buf_count++] = pkt;
+	RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_IN_ADD(p, 1);
+	if (p->tx_buf_count >= p->tx_burst_sz)
+		send_burst_nodrop(p);
+
+	return 0;
+}
+
+static int
+rte_port_virtio_user_writer_nodrop_tx_bulk(void *port,
+		struct rte_mbuf **pkts,
+		uint64_t pkts_mask)
+{
+	struct rte_port_virtio_user_writer_nodrop *p =
+		port;
+
+	uint64_t bsz_mask = p->bsz_mask;
+	uint32_t tx_buf_count = p->tx_buf_count;
+	uint64_t expr = (pkts_mask & (pkts_mask + 1)) |
+			((pkts_mask & bsz_mask) ^ bsz_mask);
+
+	if (expr == 0) {
+		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
+		uint32_t n_pkts_ok;
+
+		if (tx_buf_count)
+			send_burst_nodrop(p);
+
+		RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_IN_ADD(p, n_pkts);
+		n_pkts_ok = rte_eth_tx_burst(p->port_id, p->queue_id, pkts,
+			n_pkts);
+
+		if (n_pkts_ok >= n_pkts)
+			return 0;
+
+		/*
+		 * If we did not manage to send all packets in single burst,
+		 * move remaining packets to the buffer and call send burst.
+		 */
+		for (; n_pkts_ok < n_pkts; n_pkts_ok++) {
+			struct rte_mbuf *pkt = pkts[n_pkts_ok];
+			p->tx_buf[p->tx_buf_count++] = pkt;
+		}
+		send_burst_nodrop(p);
+	} else {
+		for ( ; pkts_mask; ) {
+			uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+			uint64_t pkt_mask = 1LLU << pkt_index;
+			struct rte_mbuf *pkt = pkts[pkt_index];
+
+			p->tx_buf[tx_buf_count++] = pkt;
+			RTE_PORT_VIRTIO_USER_WRITER_NODROP_STATS_PKTS_IN_ADD(p, 1);
+			pkts_mask &= ~pkt_mask;
+		}
+
+		p->tx_buf_count = tx_buf_count;
+		if (tx_buf_count >= p->tx_burst_sz)
+			send_burst_nodrop(p);
+	}
+
+	return 0;
+}
+
+static int
+rte_port_virtio_user_writer_nodrop_flush(void *port)
+{
+	struct rte_port_virtio_user_writer_nodrop *p =
+		port;
+
+	if (p->tx_buf_count > 0)
+		send_burst_nodrop(p);
+
+	return 0;
+}
+
+static int
+rte_port_virtio_user_writer_nodrop_free(void *port)
+{
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_port_virtio_user_writer_nodrop_flush(port);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_virtio_user_writer_nodrop_stats_read(void *port,
+		struct rte_port_out_stats *stats, int clear)
+{
+	struct rte_port_virtio_user_writer_nodrop *p =
+		port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Summary of port operations
+ */
+struct rte_port_in_ops rte_port_virtio_user_reader_ops = {
+	.f_create = rte_port_virtio_user_reader_create,
+	.f_free = rte_port_virtio_user_reader_free,
+	.f_rx = rte_port_virtio_user_reader_rx,
+	.f_stats = rte_port_virtio_user_reader_stats_read,
+};
+
+struct rte_port_out_ops rte_port_virtio_user_writer_ops = {
+	.f_create = rte_port_virtio_user_writer_create,
+	.f_free = rte_port_virtio_user_writer_free,
+	.f_tx = rte_port_virtio_user_writer_tx,
+	.f_tx_bulk = rte_port_virtio_user_writer_tx_bulk,
+	.f_flush = rte_port_virtio_user_writer_flush,
+	.f_stats = rte_port_virtio_user_writer_stats_read,
+};
+
+struct rte_port_out_ops rte_port_virtio_user_writer_nodrop_ops = {
+	.f_create = rte_port_virtio_user_writer_nodrop_create,
+	.f_free = rte_port_virtio_user_writer_nodrop_free,
+	.f_tx = rte_port_virtio_user_writer_nodrop_tx,
+	.f_tx_bulk = rte_port_virtio_user_writer_nodrop_tx_bulk,
+	.f_flush = rte_port_virtio_user_writer_nodrop_flush,
+	.f_stats = rte_port_virtio_user_writer_nodrop_stats_read,
+};
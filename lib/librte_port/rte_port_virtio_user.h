@@ -0,0 +1,163 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef __INCLUDE_RTE_PORT_VIRTIO_USER_H__
+#define __INCLUDE_RTE_PORT_VIRTIO_USER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * RTE Port virtio-user Exception Path
+ *
+ * virtio_user_reader: input port built on top of a virtio-user device queue,
+ * receiving the packets sent by the kernel
+ * virtio_user_writer: output port built on top of a virtio-user device queue,
+ * sending packets to the kernel
+ *
+ * A virtio-user device backed by vhost-net exchanges packets with a kernel
+ * tap interface, without any out of tree kernel module: it is the
+ * replacement of the KNI ports for the exception path. Each queue of the
+ * device is served by its own vhost-net kernel thread, and the checksum and
+ * segmentation offloads are negotiated with the tap interface, so that the
+ * kernel neither computes checksums nor segments TCP packets.
+ *
+ * The device is created and started by rte_port_virtio_user_dev_create(),
+ * then its queues are given to the reader and writer ports.
+ *
+ ***/
+
+#include <stdint.h>
+
+#include <rte_compat.h>
+#include <rte_mempool.h>
+
+#include "rte_port.h"
+
+/** Default vhost-net character device */
+#define RTE_PORT_VIRTIO_USER_PATH_DEFAULT "/dev/vhost-net"
+
+/** virtio-user device parameters */
+struct rte_port_virtio_user_dev_params {
+	/** Device name, e.g. "virtio_user0" */
+	const char *name;
+
+	/** vhost-net character device, RTE_PORT_VIRTIO_USER_PATH_DEFAULT when
+	NULL */
+	const char *path;
+
+	/** Name of the kernel tap interface, assigned by the kernel when NULL */
+	const char *iface;
+
+	/** Number of queues, each of them used in both directions */
+	uint16_t n_queues;
+
+	/** Number of descriptors of each queue, 0 for the driver default */
+	uint16_t queue_size;
+
+	/** Rx offloads (DEV_RX_OFFLOAD_*), limited to the device capabilities */
+	uint64_t rx_offloads;
+
+	/** Tx offloads (DEV_TX_OFFLOAD_*), limited to the device capabilities */
+	uint64_t tx_offloads;
+
+	/** Mempool of the received packets */
+	struct rte_mempool *mempool;
+
+	/** NUMA socket of the queues */
+	int socket_id;
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create, configure and start a virtio-user device over vhost-net.
+ *
+ * @param params
+ *   Device parameters.
+ * @param port_id
+ *   Ethdev port ID of the device, set on success.
+ * @return
+ *   0 on success, negative error code otherwise.
+ */
+int __rte_experimental
+rte_port_virtio_user_dev_create(struct rte_port_virtio_user_dev_params *params,
+	uint16_t *port_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Stop and remove a virtio-user device created by
+ * rte_port_virtio_user_dev_create(), which removes its tap interface.
+ *
+ * @param port_id
+ *   Ethdev port ID of the device.
+ * @return
+ *   0 on success, negative error code otherwise.
+ */
+int __rte_experimental
+rte_port_virtio_user_dev_free(uint16_t port_id);
+
+/** virtio_user_reader port parameters */
+struct rte_port_virtio_user_reader_params {
+	/** virtio-user device port ID */
+	uint16_t port_id;
+
+	/** Device queue ID */
+	uint16_t queue_id;
+
+	/** When non-zero, the packets whose checksum or segmentation is left
+	to DPDK by the kernel are given the matching Tx offload requests
+	(PKT_TX_*_CKSUM, PKT_TX_TCP_SEG), so that they can be sent as is to a
+	NIC port with these Tx offloads enabled. */
+	int tx_offload;
+};
+
+/** virtio_user_reader port operations */
+extern struct rte_port_in_ops rte_port_virtio_user_reader_ops;
+
+/** virtio_user_writer port parameters */
+struct rte_port_virtio_user_writer_params {
+	/** virtio-user device port ID */
+	uint16_t port_id;
+
+	/** Device queue ID */
+	uint16_t queue_id;
+
+	/** Recommended burst size to the device queue. The actual burst size
+	can be bigger or smaller than this value. */
+	uint32_t tx_burst_sz;
+};
+
+/** virtio_user_writer port operations */
+extern struct rte_port_out_ops rte_port_virtio_user_writer_ops;
+
+/** virtio_user_writer_nodrop port parameters */
+struct rte_port_virtio_user_writer_nodrop_params {
+	/** virtio-user device port ID */
+	uint16_t port_id;
+
+	/** Device queue ID */
+	uint16_t queue_id;
+
+	/** Recommended burst size to the device queue. The actual burst size
+	can be bigger or smaller than this value. */
+	uint32_t tx_burst_sz;
+
+	/** Maximum number of retries, 0 for no limit */
+	uint32_t n_retries;
+};
+
+/** virtio_user_writer_nodrop port operations */
+extern struct rte_port_out_ops rte_port_virtio_user_writer_nodrop_ops;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
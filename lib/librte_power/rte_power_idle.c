@@ -0,0 +1,264 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/queue.h>
+
+#include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_spinlock.h>
+#include <rte_ethdev.h>
+
+#include "rte_power.h"
+#include "rte_power_idle.h"
+
+#define DEFAULT_SLEEP_THRESHOLD 512
+#define DEFAULT_SLEEP_US 10
+
+/* number of polls between two checks of the end of a scaling period */
+#define SCALE_CHECK_POLLS 64
+
+struct idle_lcore {
+	struct rte_power_idle_conf conf;
+	uint32_t enabled;
+
+	/* consecutive empty polls */
+	uint32_t empty_polls;
+
+	/* current scaling period */
+	uint64_t period_polls;
+	uint64_t period_empty_polls;
+	uint64_t period_end;
+	uint64_t period_cycles;
+
+	struct rte_power_idle_stats stats;
+} __rte_cache_aligned;
+
+struct idle_rx_queue {
+	TAILQ_ENTRY(idle_rx_queue) next;
+	uint16_t port_id;
+	uint16_t queue_id;
+	const struct rte_eth_rxtx_callback *cb;
+};
+
+static struct idle_lcore idle_lcores[RTE_MAX_LCORE];
+
+static TAILQ_HEAD(, idle_rx_queue) idle_rx_queues =
+	TAILQ_HEAD_INITIALIZER(idle_rx_queues);
+static rte_spinlock_t idle_rx_queues_lock = RTE_SPINLOCK_INITIALIZER;
+
+int __rte_experimental
+rte_power_idle_enable(unsigned int lcore_id,
+		const struct rte_power_idle_conf *conf)
+{
+	struct idle_lcore *s;
+
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+	if (conf != NULL && conf->scale_period_us != 0 &&
+			(conf->scale_down_percent > 100 ||
+			 conf->scale_up_percent > conf->scale_down_percent ||
+			 rte_power_freq_down == NULL))
+		return -EINVAL;
+
+	s = &idle_lcores[lcore_id];
+	s->enabled = 0;
+	rte_smp_wmb();
+
+	memset(s, 0, sizeof(*s));
+	if (conf != NULL) {
+		s->conf = *conf;
+	} else {
+		s->conf.sleep_threshold = DEFAULT_SLEEP_THRESHOLD;
+		s->conf.sleep_us = DEFAULT_SLEEP_US;
+	}
+	s->period_cycles = rte_get_tsc_hz() / 1000000 *
+		s->conf.scale_period_us;
+	s->period_end = rte_rdtsc() + s->period_cycles;
+
+	rte_smp_wmb();
+	s->enabled = 1;
+
+	return 0;
+}
+
+int __rte_experimental
+rte_power_idle_disable(unsigned int lcore_id)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	idle_lcores[lcore_id].enabled = 0;
+	rte_smp_wmb();
+
+	return 0;
+}
+
+/* end of a scaling period: lower the frequency if the lcore was mostly
+ * idle, raise it to the maximum if it was mostly busy
+ */
+static void
+idle_scale(unsigned int lcore_id, struct idle_lcore *s, uint64_t now)
+{
+	uint64_t empty_percent;
+
+	/* the lcore may have been enabled again under our feet */
+	if (s->period_polls == 0)
+		return;
+
+	empty_percent = s->period_empty_polls * 100 / s->period_polls;
+	if (empty_percent >= s->conf.scale_down_percent) {
+		if (rte_power_freq_down(lcore_id) == 1)
+			s->stats.freq_downs++;
+	} else if (empty_percent < s->conf.scale_up_percent) {
+		if (rte_power_freq_max(lcore_id) == 1)
+			s->stats.freq_ups++;
+	}
+
+	s->period_polls = 0;
+	s->period_empty_polls = 0;
+	s->period_end = now + s->period_cycles;
+}
+
+void __rte_experimental
+rte_power_idle_update(unsigned int lcore_id, uint16_t nb_pkts)
+{
+	struct idle_lcore *s;
+	uint64_t now;
+
+	if (lcore_id >= RTE_MAX_LCORE)
+		return;
+
+	s = &idle_lcores[lcore_id];
+	if (!s->enabled)
+		return;
+
+	s->stats.polls++;
+	s->period_polls++;
+
+	if (nb_pkts == 0) {
+		s->stats.empty_polls++;
+		s->period_empty_polls++;
+		if (s->conf.sleep_threshold != 0 &&
+				++s->empty_polls >= s->conf.sleep_threshold) {
+			/* keep sleeping at each poll until traffic resumes */
+			rte_delay_us_sleep(s->conf.sleep_us);
+			s->stats.sleeps++;
+		}
+	} else {
+		s->empty_polls = 0;
+	}
+
+	if (s->conf.scale_period_us == 0 ||
+			s->period_polls % SCALE_CHECK_POLLS != 0)
+		return;
+
+	now = rte_rdtsc();
+	if (now >= s->period_end)
+		idle_scale(lcore_id, s, now);
+}
+
+static uint16_t
+idle_rx_callback(uint16_t port_id __rte_unused,
+		uint16_t queue_id __rte_unused,
+		struct rte_mbuf **pkts __rte_unused, uint16_t nb_pkts,
+		uint16_t max_pkts __rte_unused, void *user_param)
+{
+	rte_power_idle_update((unsigned int)(uintptr_t)user_param, nb_pkts);
+
+	return nb_pkts;
+}
+
+static struct idle_rx_queue *
+idle_rx_queue_find(uint16_t port_id, uint16_t queue_id)
+{
+	struct idle_rx_queue *q;
+
+	TAILQ_FOREACH(q, &idle_rx_queues, next) {
+		if (q->port_id == port_id && q->queue_id == queue_id)
+			return q;
+	}
+	return NULL;
+}
+
+int __rte_experimental
+rte_power_idle_rx_queue_enable(unsigned int lcore_id, uint16_t port_id,
+		uint16_t queue_id)
+{
+	struct idle_rx_queue *q;
+	int ret = 0;
+
+	if (lcore_id >= RTE_MAX_LCORE || !rte_eth_dev_is_valid_port(port_id))
+		return -EINVAL;
+
+	rte_spinlock_lock(&idle_rx_queues_lock);
+
+	if (idle_rx_queue_find(port_id, queue_id) != NULL) {
+		ret = -EEXIST;
+		goto unlock;
+	}
+
+	q = rte_zmalloc(NULL, sizeof(*q), 0);
+	if (q == NULL) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	q->port_id = port_id;
+	q->queue_id = queue_id;
+	q->cb = rte_eth_add_rx_callback(port_id, queue_id, idle_rx_callback,
+			(void *)(uintptr_t)lcore_id);
+	if (q->cb == NULL) {
+		rte_free(q);
+		ret = -rte_errno;
+		goto unlock;
+	}
+
+	TAILQ_INSERT_TAIL(&idle_rx_queues, q, next);
+unlock:
+	rte_spinlock_unlock(&idle_rx_queues_lock);
+	return ret;
+}
+
+int __rte_experimental
+rte_power_idle_rx_queue_disable(uint16_t port_id, uint16_t queue_id)
+{
+	struct idle_rx_queue *q;
+	int ret;
+
+	rte_spinlock_lock(&idle_rx_queues_lock);
+
+	q = idle_rx_queue_find(port_id, queue_id);
+	if (q == NULL) {
+		ret = -ENOENT;
+		goto unlock;
+	}
+
+	ret = rte_eth_remove_rx_callback(port_id, queue_id, q->cb);
+	if (ret != 0)
+		goto unlock;
+
+	/* the callback is not freed by ethdev, the queue is not polled */
+	rte_free((void *)(uintptr_t)q->cb);
+	TAILQ_REMOVE(&idle_rx_queues, q, next);
+	rte_free(q);
+unlock:
+	rte_spinlock_unlock(&idle_rx_queues_lock);
+	return ret;
+}
+
+int __rte_experimental
+rte_power_idle_stats_get(unsigned int lcore_id,
+		struct rte_power_idle_stats *stats)
+{
+	if (lcore_id >= RTE_MAX_LCORE || stats == NULL)
+		return -EINVAL;
+
+	*stats = idle_lcores[lcore_id].stats;
+
+	return 0;
+}
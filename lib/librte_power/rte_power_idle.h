@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_POWER_IDLE_H
+#define _RTE_POWER_IDLE_H
+
+/**
+ * @file
+ * RTE Power Idle Detection
+ *
+ * Generic tracker of the empty polls of an lcore, fed with the number of
+ * packets returned by each burst it polls. From the observed empty polls,
+ * the tracker puts the lcore to sleep when it has been idle for a while,
+ * and scales its frequency down or up depending on the ratio of empty polls
+ * over a period.
+ *
+ * The tracker can be fed directly with *rte_power_idle_update*, for example
+ * after *rte_vhost_dequeue_burst*, or attached to ethdev Rx queues with
+ * *rte_power_idle_rx_queue_enable* so that the polling loop of the
+ * application is left unchanged.
+ */
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_compat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Idle detection parameters of an lcore */
+struct rte_power_idle_conf {
+	/** Consecutive empty polls before the lcore sleeps, 0 to never sleep */
+	uint32_t sleep_threshold;
+	/** Duration of each sleep, in microseconds */
+	uint32_t sleep_us;
+	/**
+	 * Period of the frequency decisions, in microseconds, 0 to not scale
+	 * the frequency. Scaling requires *rte_power_init* to be done for
+	 * the lcore.
+	 */
+	uint32_t scale_period_us;
+	/** Empty poll percentage over a period above which the frequency is
+	 * stepped down
+	 */
+	uint8_t scale_down_percent;
+	/** Empty poll percentage over a period below which the frequency is
+	 * set to the maximum
+	 */
+	uint8_t scale_up_percent;
+};
+
+/** Idle detection statistics of an lcore */
+struct rte_power_idle_stats {
+	uint64_t polls;       /**< Number of polls */
+	uint64_t empty_polls; /**< Number of polls returning no packet */
+	uint64_t sleeps;      /**< Number of sleeps */
+	uint64_t freq_downs;  /**< Number of frequency step downs */
+	uint64_t freq_ups;    /**< Number of frequency raises to maximum */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enable the idle detection of an lcore, and reset its statistics.
+ *
+ * @param lcore_id
+ *   The lcore polling the queues.
+ * @param conf
+ *   The idle detection parameters, NULL for the defaults: sleep 10us after
+ *   512 empty polls, and no frequency scaling.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL if the lcore or the parameters are invalid, or if scaling is
+ *     requested while the power management environment is not initialized.
+ */
+int __rte_experimental
+rte_power_idle_enable(unsigned int lcore_id,
+		const struct rte_power_idle_conf *conf);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Disable the idle detection of an lcore. The Rx queues attached to it
+ * keep their callback, which does nothing until it is enabled again.
+ *
+ * @param lcore_id
+ *   The lcore polling the queues.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL if the lcore is invalid.
+ */
+int __rte_experimental
+rte_power_idle_disable(unsigned int lcore_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Feed the idle detection of an lcore with the result of a poll. Must be
+ * called by the lcore itself, as it may sleep or change its frequency.
+ *
+ * @param lcore_id
+ *   The calling lcore.
+ * @param nb_pkts
+ *   The number of packets returned by the poll.
+ */
+void __rte_experimental
+rte_power_idle_update(unsigned int lcore_id, uint16_t nb_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Feed the idle detection of an lcore with every burst received from an
+ * ethdev Rx queue, through an Rx callback. This works with any PMD,
+ * including the virtio and vhost ones.
+ *
+ * @param lcore_id
+ *   The lcore polling the queue.
+ * @param port_id
+ *   The port of the queue.
+ * @param queue_id
+ *   The Rx queue.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL if a parameter is invalid.
+ *   - -EEXIST if the queue is already attached.
+ *   - -ENOMEM if the callback could not be added.
+ */
+int __rte_experimental
+rte_power_idle_rx_queue_enable(unsigned int lcore_id, uint16_t port_id,
+		uint16_t queue_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Detach an ethdev Rx queue from the idle detection. The queue must not be
+ * polled while the callback is removed.
+ *
+ * @param port_id
+ *   The port of the queue.
+ * @param queue_id
+ *   The Rx queue.
+ * @return
+ *   - 0 on success.
+ *   - -ENOENT if the queue is not attached.
+ */
+int __rte_experimental
+rte_power_idle_rx_queue_disable(uint16_t port_id, uint16_t queue_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the idle detection statistics of an lcore.
+ *
+ * @param lcore_id
+ *   The lcore.
+ * @param stats
+ *   The structure to fill.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL if a parameter is invalid.
+ */
+int __rte_experimental
+rte_power_idle_stats_get(unsigned int lcore_id,
+		struct rte_power_idle_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
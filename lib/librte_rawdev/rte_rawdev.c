@@ -380,6 +380,58 @@ rte_rawdev_selftest(uint16_t dev_id)
 	return (*dev->dev_ops->dev_selftest)();
 }
 
+int __rte_experimental
+rte_rawdev_dma_supported(uint16_t dev_id)
+{
+	struct rte_rawdev *dev;
+
+	if (!rte_rawdev_pmd_is_valid_dev(dev_id))
+		return 0;
+	dev = &rte_rawdevs[dev_id];
+
+	return dev->dev_ops->dma_enqueue != NULL &&
+		dev->dev_ops->dma_submit != NULL &&
+		dev->dev_ops->dma_completed != NULL;
+}
+
+int __rte_experimental
+rte_rawdev_dma_enqueue(uint16_t dev_id, uint16_t queue_id,
+		const struct rte_rawdev_dma_copy *copies, uint16_t nb_copies)
+{
+	struct rte_rawdev *dev;
+
+	RTE_RAWDEV_VALID_DEVID_OR_ERR_RET(dev_id, -EINVAL);
+	dev = &rte_rawdevs[dev_id];
+
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->dma_enqueue, -ENOTSUP);
+	return (*dev->dev_ops->dma_enqueue)(dev, queue_id, copies, nb_copies);
+}
+
+int __rte_experimental
+rte_rawdev_dma_submit(uint16_t dev_id, uint16_t queue_id)
+{
+	struct rte_rawdev *dev;
+
+	RTE_RAWDEV_VALID_DEVID_OR_ERR_RET(dev_id, -EINVAL);
+	dev = &rte_rawdevs[dev_id];
+
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->dma_submit, -ENOTSUP);
+	return (*dev->dev_ops->dma_submit)(dev, queue_id);
+}
+
+int __rte_experimental
+rte_rawdev_dma_completed(uint16_t dev_id, uint16_t queue_id,
+		struct rte_rawdev_dma_completion *cpls, uint16_t nb_cpls)
+{
+	struct rte_rawdev *dev;
+
+	RTE_RAWDEV_VALID_DEVID_OR_ERR_RET(dev_id, -EINVAL);
+	dev = &rte_rawdevs[dev_id];
+
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->dma_completed, -ENOTSUP);
+	return (*dev->dev_ops->dma_completed)(dev, queue_id, cpls, nb_cpls);
+}
+
 int
 rte_rawdev_start(uint16_t dev_id)
 {
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_RAWDEV_DMA_H_
+#define _RTE_RAWDEV_DMA_H_
+
+/**
+ * @file rte_rawdev_dma.h
+ *
+ * Memory copy API of the raw devices which are DMA engines.
+ *
+ * The copies are enqueued to a queue of the device, the doorbell of the
+ * queue is then rung once for the whole batch by rte_rawdev_dma_submit(),
+ * and the completed copies are polled by rte_rawdev_dma_completed(). This
+ * API offloads the copies of large buffers, such as the packets copied by
+ * vhost or between mempools, from the CPU to engines like Intel I/OAT or
+ * NXP qDMA, a software implementation being available when no engine is.
+ *
+ * A queue must be used by a single thread at a time.
+ *
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_compat.h>
+#include <rte_memory.h>
+
+/** Copy to be performed by a DMA engine */
+struct rte_rawdev_dma_copy {
+	rte_iova_t src;       /**< IO address of the source */
+	rte_iova_t dst;       /**< IO address of the destination */
+	uint32_t length;      /**< Number of bytes to copy */
+	uint64_t user_data;   /**< Returned with the completion of the copy */
+};
+
+/** Completion of a copy */
+struct rte_rawdev_dma_completion {
+	uint64_t user_data;   /**< User data of the copy */
+	int status;           /**< 0 on success, negative errno otherwise */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Check whether a raw device implements the DMA copy API.
+ *
+ * @param dev_id
+ *   The identifier of the device.
+ * @return
+ *   1 if the device implements the API, 0 otherwise.
+ */
+int __rte_experimental
+rte_rawdev_dma_supported(uint16_t dev_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue copies to a queue of a DMA raw device. The copies are not started
+ * before rte_rawdev_dma_submit() is called.
+ *
+ * @param dev_id
+ *   The identifier of the device.
+ * @param queue_id
+ *   The queue of the device.
+ * @param copies
+ *   Copies to enqueue.
+ * @param nb_copies
+ *   Number of copies.
+ * @return
+ *   - Number of copies enqueued, less than nb_copies when the queue is full.
+ *   - -ENOTSUP if the device doesn't implement the DMA copy API.
+ *   - other values < 0 on failure.
+ */
+int __rte_experimental
+rte_rawdev_dma_enqueue(uint16_t dev_id, uint16_t queue_id,
+		const struct rte_rawdev_dma_copy *copies, uint16_t nb_copies);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Start the copies enqueued to a queue of a DMA raw device, ringing its
+ * doorbell once for all of them.
+ *
+ * @param dev_id
+ *   The identifier of the device.
+ * @param queue_id
+ *   The queue of the device.
+ * @return
+ *   - 0 on success.
+ *   - -ENOTSUP if the device doesn't implement the DMA copy API.
+ *   - other values < 0 on failure.
+ */
+int __rte_experimental
+rte_rawdev_dma_submit(uint16_t dev_id, uint16_t queue_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the completed copies of a queue of a DMA raw device. The copies of a
+ * queue may complete out of order, their user data identifying them.
+ *
+ * @param dev_id
+ *   The identifier of the device.
+ * @param queue_id
+ *   The queue of the device.
+ * @param cpls
+ *   Array filled with the completions.
+ * @param nb_cpls
+ *   Size of the array.
+ * @return
+ *   - Number of completions returned.
+ *   - -ENOTSUP if the device doesn't implement the DMA copy API.
+ *   - other values < 0 on failure.
+ */
+int __rte_experimental
+rte_rawdev_dma_completed(uint16_t dev_id, uint16_t queue_id,
+		struct rte_rawdev_dma_completion *cpls, uint16_t nb_cpls);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_RAWDEV_DMA_H_ */
@@ -28,6 +28,7 @@ extern "C" {
 #include <rte_common.h>
 
 #include "rte_rawdev.h"
+#include "rte_rawdev_dma.h"
 
 extern int librawdev_logtype;
 
@@ -501,6 +502,56 @@ typedef int (*rawdev_firmware_unload_t)(struct rte_rawdev *dev);
  */
 typedef int (*rawdev_selftest_t)(void);
 
+/**
+ * Enqueue copies to a queue of a DMA device.
+ *
+ * @param dev
+ *   Raw device pointer
+ * @param queue_id
+ *   Queue of the device
+ * @param copies
+ *   Copies to enqueue
+ * @param nb_copies
+ *   Number of copies
+ * @return
+ *   Number of copies enqueued, <0 on failure
+ */
+typedef int (*rawdev_dma_enqueue_t)(struct rte_rawdev *dev,
+				    uint16_t queue_id,
+				    const struct rte_rawdev_dma_copy *copies,
+				    uint16_t nb_copies);
+
+/**
+ * Start the copies enqueued to a queue of a DMA device.
+ *
+ * @param dev
+ *   Raw device pointer
+ * @param queue_id
+ *   Queue of the device
+ * @return
+ *   0 on success, <0 on failure
+ */
+typedef int (*rawdev_dma_submit_t)(struct rte_rawdev *dev, uint16_t queue_id);
+
+/**
+ * Get the completed copies of a queue of a DMA device.
+ *
+ * @param dev
+ *   Raw device pointer
+ * @param queue_id
+ *   Queue of the device
+ * @param cpls
+ *   Array filled with the completions
+ * @param nb_cpls
+ *   Size of the array
+ * @return
+ *   Number of completions returned, <0 on failure
+ */
+typedef int (*rawdev_dma_completed_t)(struct rte_rawdev *dev,
+				      uint16_t queue_id,
+				      struct rte_rawdev_dma_completion *cpls,
+				      uint16_t nb_cpls);
+
 /** Rawdevice operations function pointer table */
 struct rte_rawdev_ops {
 	/**< Get device info. */
@@ -559,6 +610,13 @@ struct rte_rawdev_ops {
 
 	/**< Device selftest function */
 	rawdev_selftest_t dev_selftest;
+
+	/**< Enqueue copies to a DMA queue */
+	rawdev_dma_enqueue_t dma_enqueue;
+	/**< Start the copies enqueued to a DMA queue */
+	rawdev_dma_submit_t dma_submit;
+	/**< Get the completed copies of a DMA queue */
+	rawdev_dma_completed_t dma_completed;
 };
 
 /**
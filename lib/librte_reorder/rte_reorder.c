@@ -10,6 +10,7 @@
 #include <rte_eal_memconfig.h>
 #include <rte_errno.h>
 #include <rte_malloc.h>
+#include <rte_pause.h>
 
 #include "rte_reorder.h"
 
@@ -20,6 +21,11 @@ static struct rte_tailq_elem rte_reorder_tailq = {
 };
 EAL_REGISTER_TAILQ(rte_reorder_tailq)
 
+static struct rte_tailq_elem rte_reorder_mp_tailq = {
+	.name = "RTE_REORDER_MP",
+};
+EAL_REGISTER_TAILQ(rte_reorder_mp_tailq)
+
 #define NO_FLAGS 0
 #define RTE_REORDER_PREFIX "RO_"
 #define RTE_REORDER_NAMESIZE 32
@@ -46,6 +52,29 @@ struct rte_reorder_buffer {
 	int is_initialized;
 } __rte_cache_aligned;
 
+/*
+ * The multi-producer reorder buffer. Each sequence number has its own slot,
+ * which the producers fill with an atomic compare-and-swap, and the single
+ * consumer empties in order. Only the consumer moves the window.
+ */
+struct rte_reorder_mp_buffer {
+	char name[RTE_REORDER_NAMESIZE];
+	unsigned int size;   /**< Number of slots */
+	unsigned int mask;   /**< [size - 1]: used for wrap-around */
+	volatile int state;  /**< Set up by the first insert */
+	/** Lowest seq. number that can be in the buffer, set by the consumer */
+	volatile uint32_t min_seqn __rte_cache_aligned;
+	/** Window start requested by the producers of early mbufs */
+	volatile uint32_t skip_seqn __rte_cache_aligned;
+	struct rte_mbuf *entries[] __rte_cache_aligned;
+};
+
+enum {
+	REORDER_MP_UNINIT = 0,
+	REORDER_MP_INITIALIZING,
+	REORDER_MP_READY
+};
+
 static void
 rte_reorder_free_mbufs(struct rte_reorder_buffer *b);
 
@@ -379,3 +408,244 @@ rte_reorder_drain(struct rte_reorder_buffer *b, struct rte_mbuf **mbufs,
 
 	return drain_cnt;
 }
+
+struct rte_reorder_mp_buffer *
+rte_reorder_mp_create(const char *name, unsigned int socket_id,
+		unsigned int size)
+{
+	struct rte_reorder_mp_buffer *b = NULL;
+	struct rte_tailq_entry *te;
+	struct rte_reorder_list *reorder_list;
+	const unsigned int bufsize = sizeof(struct rte_reorder_mp_buffer) +
+					(size * sizeof(struct rte_mbuf *));
+
+	reorder_list = RTE_TAILQ_CAST(rte_reorder_mp_tailq.head,
+			rte_reorder_list);
+
+	/* Check user arguments. */
+	if (!rte_is_power_of_2(size)) {
+		RTE_LOG(ERR, REORDER, "Invalid reorder buffer size"
+				" - Not a power of 2\n");
+		rte_errno = EINVAL;
+		return NULL;
+	}
+	if (name == NULL) {
+		RTE_LOG(ERR, REORDER, "Invalid reorder buffer name ptr:"
+					" NULL\n");
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	/* guarantee there's no existing */
+	TAILQ_FOREACH(te, reorder_list, next) {
+		b = (struct rte_reorder_mp_buffer *) te->data;
+		if (strncmp(name, b->name, RTE_REORDER_NAMESIZE) == 0)
+			break;
+	}
+	if (te != NULL)
+		goto exit;
+
+	/* allocate tailq entry */
+	te = rte_zmalloc("REORDER_MP_TAILQ_ENTRY", sizeof(*te), 0);
+	if (te == NULL) {
+		RTE_LOG(ERR, REORDER, "Failed to allocate tailq entry\n");
+		rte_errno = ENOMEM;
+		b = NULL;
+		goto exit;
+	}
+
+	/* Allocate memory to store the reorder buffer structure. */
+	b = rte_zmalloc_socket("REORDER_MP_BUFFER", bufsize, 0, socket_id);
+	if (b == NULL) {
+		RTE_LOG(ERR, REORDER, "Memzone allocation failed\n");
+		rte_errno = ENOMEM;
+		rte_free(te);
+	} else {
+		snprintf(b->name, sizeof(b->name), "%s", name);
+		b->size = size;
+		b->mask = size - 1;
+		te->data = (void *)b;
+		TAILQ_INSERT_TAIL(reorder_list, te, next);
+	}
+
+exit:
+	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+	return b;
+}
+
+void
+rte_reorder_mp_free(struct rte_reorder_mp_buffer *b)
+{
+	struct rte_reorder_list *reorder_list;
+	struct rte_tailq_entry *te;
+	unsigned int i;
+
+	/* Check user arguments. */
+	if (b == NULL)
+		return;
+
+	reorder_list = RTE_TAILQ_CAST(rte_reorder_mp_tailq.head,
+			rte_reorder_list);
+
+	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	/* find our tailq entry */
+	TAILQ_FOREACH(te, reorder_list, next) {
+		if (te->data == (void *) b)
+			break;
+	}
+	if (te == NULL) {
+		rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+		return;
+	}
+
+	TAILQ_REMOVE(reorder_list, te, next);
+
+	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+
+	for (i = 0; i < b->size; i++)
+		if (b->entries[i])
+			rte_pktmbuf_free(b->entries[i]);
+
+	rte_free(b);
+	rte_free(te);
+}
+
+/* The first mbuf inserted sets the start of the window */
+static inline void
+rte_reorder_mp_setup(struct rte_reorder_mp_buffer *b, uint32_t seqn)
+{
+	int state = REORDER_MP_UNINIT;
+
+	if (__atomic_compare_exchange_n(&b->state, &state,
+			REORDER_MP_INITIALIZING, 0,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		b->min_seqn = seqn;
+		b->skip_seqn = seqn;
+		__atomic_store_n(&b->state, REORDER_MP_READY, __ATOMIC_RELEASE);
+		return;
+	}
+
+	while (__atomic_load_n(&b->state, __ATOMIC_ACQUIRE) !=
+			REORDER_MP_READY)
+		rte_pause();
+}
+
+static inline int
+rte_reorder_mp_insert_one(struct rte_reorder_mp_buffer *b,
+		struct rte_mbuf *mbuf, uint32_t min_seqn)
+{
+	struct rte_mbuf *expected = NULL;
+	uint32_t offset, skip_seqn;
+
+	/*
+	 * A stale min_seqn is only lower than the current one, so an mbuf
+	 * within its window is never too early. An mbuf which the consumer
+	 * went past in the meantime is found by the consumer with a sequence
+	 * number not matching the slot, and drained out of order.
+	 */
+	offset = mbuf->seqn - min_seqn;
+
+	if (offset < b->size) {
+		if (!__atomic_compare_exchange_n(&b->entries[mbuf->seqn &
+				b->mask], &expected, mbuf, 0,
+				__ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			/* slot not drained yet from the previous window */
+			rte_errno = ENOSPC;
+			return -1;
+		}
+	} else if (offset < 2 * b->size) {
+		/*
+		 * Let the consumer move the window past the missing mbufs,
+		 * as rte_reorder_insert() does for early mbufs.
+		 */
+		skip_seqn = __atomic_load_n(&b->skip_seqn, __ATOMIC_RELAXED);
+		while ((int32_t)(mbuf->seqn + 1 - b->size - skip_seqn) > 0 &&
+				!__atomic_compare_exchange_n(&b->skip_seqn,
+					&skip_seqn, mbuf->seqn + 1 - b->size, 0,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			;
+		rte_errno = ENOSPC;
+		return -1;
+	} else {
+		rte_errno = ERANGE;
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+rte_reorder_mp_insert(struct rte_reorder_mp_buffer *b, struct rte_mbuf *mbuf)
+{
+	if (unlikely(b->state != REORDER_MP_READY))
+		rte_reorder_mp_setup(b, mbuf->seqn);
+
+	return rte_reorder_mp_insert_one(b, mbuf,
+			__atomic_load_n(&b->min_seqn, __ATOMIC_ACQUIRE));
+}
+
+unsigned int
+rte_reorder_mp_insert_burst(struct rte_reorder_mp_buffer *b,
+		struct rte_mbuf **mbufs, unsigned int nb_mbufs)
+{
+	uint32_t min_seqn;
+	unsigned int i;
+
+	if (nb_mbufs == 0)
+		return 0;
+
+	if (unlikely(b->state != REORDER_MP_READY))
+		rte_reorder_mp_setup(b, mbufs[0]->seqn);
+
+	min_seqn = __atomic_load_n(&b->min_seqn, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < nb_mbufs; i++)
+		if (rte_reorder_mp_insert_one(b, mbufs[i], min_seqn) < 0)
+			break;
+
+	return i;
+}
+
+unsigned int
+rte_reorder_mp_drain(struct rte_reorder_mp_buffer *b, struct rte_mbuf **mbufs,
+		unsigned int max_mbufs)
+{
+	unsigned int drain_cnt = 0;
+	uint32_t min_seqn = b->min_seqn;
+	struct rte_mbuf **slot;
+	struct rte_mbuf *mbuf;
+
+	if (b->state != REORDER_MP_READY)
+		return 0;
+
+	while (drain_cnt < max_mbufs) {
+		slot = &b->entries[min_seqn & b->mask];
+		mbuf = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+		if (mbuf == NULL) {
+			/* skip the gaps producers of early mbufs wait on */
+			if ((int32_t)(__atomic_load_n(&b->skip_seqn,
+					__ATOMIC_RELAXED) - min_seqn) <= 0)
+				break;
+			min_seqn++;
+			continue;
+		}
+
+		mbufs[drain_cnt++] = mbuf;
+		__atomic_store_n(slot, NULL, __ATOMIC_RELAXED);
+
+		/* a late mbuf inserted after its slot was passed */
+		if (mbuf->seqn != min_seqn)
+			continue;
+
+		min_seqn++;
+	}
+
+	/* publish the emptied slots */
+	__atomic_store_n(&b->min_seqn, min_seqn, __ATOMIC_RELEASE);
+
+	return drain_cnt;
+}
@@ -15,6 +15,7 @@
  *
  */
 
+#include <rte_compat.h>
 #include <rte_mbuf.h>
 
 #ifdef __cplusplus
@@ -146,6 +147,126 @@ unsigned int
 rte_reorder_drain(struct rte_reorder_buffer *b, struct rte_mbuf **mbufs,
 		unsigned max_mbufs);
 
+/**
+ * Multi-producer reorder buffer.
+ *
+ * Several threads may insert mbufs into a multi-producer reorder buffer
+ * concurrently, each sequence number having its own slot updated
+ * atomically, while a single thread drains it without locking. Only the
+ * draining thread moves the window of sequence numbers.
+ */
+struct rte_reorder_mp_buffer;
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a new multi-producer reorder buffer instance
+ *
+ * @param name
+ *   The name to be given to the reorder buffer instance.
+ * @param socket_id
+ *   The NUMA node on which the memory for the reorder buffer
+ *   instance is to be reserved.
+ * @param size
+ *   Max number of elements that can be stored in the reorder buffer,
+ *   a power of 2.
+ * @return
+ *   The initialized reorder buffer instance, or NULL on error
+ *   On error case, rte_errno will be set appropriately:
+ *    - ENOMEM - no appropriate memory area found in which to create memzone
+ *    - EINVAL - invalid parameters
+ */
+struct rte_reorder_mp_buffer * __rte_experimental
+rte_reorder_mp_create(const char *name, unsigned int socket_id,
+		unsigned int size);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free multi-producer reorder buffer instance, and the mbufs it holds.
+ *
+ * @param b
+ *   reorder buffer instance
+ */
+void __rte_experimental
+rte_reorder_mp_free(struct rte_reorder_mp_buffer *b);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Insert given mbuf in multi-producer reorder buffer in its correct
+ * position. This function is multi-thread safe.
+ *
+ * The first mbuf inserted sets the start of the window of sequence
+ * numbers. Unlike rte_reorder_insert(), inserting an mbuf just beyond the
+ * window does not move it: the mbuf is refused, and the next drain skips
+ * the missing mbufs so that it fits.
+ *
+ * @param b
+ *   Reorder buffer where the mbuf has to be inserted.
+ * @param mbuf
+ *   mbuf of packet that needs to be inserted in reorder buffer.
+ * @return
+ *   0 on success
+ *   -1 on error
+ *   On error case, rte_errno will be set appropriately:
+ *    - ENOSPC - The mbuf is beyond the window, or its slot is still in use,
+ *      it can be accommodated by performing drain and then insert.
+ *    - ERANGE - Too early or late mbuf which is vastly out of range of expected
+ *      window should be ignored without any handling.
+ */
+int __rte_experimental
+rte_reorder_mp_insert(struct rte_reorder_mp_buffer *b, struct rte_mbuf *mbuf);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Insert a burst of mbufs in multi-producer reorder buffer, as
+ * rte_reorder_mp_insert() does for each of them, stopping at the first
+ * mbuf which cannot be inserted. This function is multi-thread safe.
+ *
+ * @param b
+ *   Reorder buffer where the mbufs have to be inserted.
+ * @param mbufs
+ *   Array of mbufs to insert.
+ * @param nb_mbufs
+ *   Number of mbufs in the array.
+ * @return
+ *   Number of mbufs inserted. If less than nb_mbufs, rte_errno is set
+ *   as by rte_reorder_mp_insert() for the first mbuf not inserted.
+ */
+unsigned int __rte_experimental
+rte_reorder_mp_insert_burst(struct rte_reorder_mp_buffer *b,
+		struct rte_mbuf **mbufs, unsigned int nb_mbufs);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Fetch reordered buffers from multi-producer reorder buffer
+ *
+ * Returns a set of in-order buffers, as rte_reorder_drain() does. An mbuf
+ * inserted while the window moves past its sequence number is returned out
+ * of order. This function must be called by a single thread at a time, but
+ * needs no lock against the inserting threads.
+ *
+ * @param b
+ *   Reorder buffer instance from which packets are to be drained
+ * @param mbufs
+ *   array of mbufs where reordered packets will be inserted from reorder buffer
+ * @param max_mbufs
+ *   the number of elements in the mbufs array.
+ * @return
+ *   number of mbuf pointers written to mbufs. 0 <= N <= max_mbufs.
+ */
+unsigned int __rte_experimental
+rte_reorder_mp_drain(struct rte_reorder_mp_buffer *b,
+		struct rte_mbuf **mbufs, unsigned int max_mbufs);
+
 #ifdef __cplusplus
 }
 #endif
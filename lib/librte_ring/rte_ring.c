@@ -32,6 +32,7 @@
 #include <rte_spinlock.h>
 
 #include "rte_ring.h"
+#include "rte_ring_elem.h"
 
 TAILQ_HEAD(rte_ring_list, rte_tailq_entry);
 
@@ -43,12 +44,19 @@ EAL_REGISTER_TAILQ(rte_ring_tailq)
 /* true if x is a power of 2 */
 #define POWEROF2(x) ((((x)-1) & (x)) == 0)
 
-/* return the size of memory occupied by a ring */
-ssize_t
-rte_ring_get_memsize(unsigned count)
+/* return the size of memory occupied by a ring of esize byte elements */
+static ssize_t
+ring_get_memsize(unsigned int esize, unsigned int count)
 {
 	ssize_t sz;
 
+	/* element size must be one of the supported ones */
+	if (esize != 4 && esize != 8 && esize != 16 && esize != 32) {
+		RTE_LOG(ERR, RING,
+			"Requested element size is invalid, must be 4, 8, 16 or 32\n");
+		return -EINVAL;
+	}
+
 	/* count must be a power of 2 */
 	if ((!POWEROF2(count)) || (count > RTE_RING_SZ_MASK )) {
 		RTE_LOG(ERR, RING,
@@ -57,11 +65,24 @@ rte_ring_get_memsize(unsigned count)
 		return -EINVAL;
 	}
 
-	sz = sizeof(struct rte_ring) + count * sizeof(void *);
+	sz = sizeof(struct rte_ring) + (ssize_t)count * esize;
 	sz = RTE_ALIGN(sz, RTE_CACHE_LINE_SIZE);
 	return sz;
 }
 
+/* return the size of memory occupied by a ring */
+ssize_t
+rte_ring_get_memsize(unsigned count)
+{
+	return ring_get_memsize(sizeof(void *), count);
+}
+
+ssize_t
+rte_ring_get_memsize_elem(unsigned int esize, unsigned int count)
+{
+	return ring_get_memsize(esize, count);
+}
+
 int
 rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
 	unsigned flags)
@@ -75,6 +96,15 @@ rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
 			  RTE_CACHE_LINE_MASK) != 0);
 	RTE_BUILD_BUG_ON((offsetof(struct rte_ring, prod) &
 			  RTE_CACHE_LINE_MASK) != 0);
+	RTE_BUILD_BUG_ON(offsetof(struct rte_ring, prod_lf.ht.single) !=
+			 offsetof(struct rte_ring, prod.single));
+	RTE_BUILD_BUG_ON(sizeof(struct rte_ring_lf_headtail) >
+			 RTE_CACHE_LINE_SIZE);
+
+#ifndef RTE_ARCH_X86_64
+	if (flags & RING_F_LF)
+		return -ENOTSUP;
+#endif
 
 	/* init the ring structure */
 	memset(r, 0, sizeof(*r));
@@ -103,13 +133,26 @@ rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
 	r->prod.head = r->cons.head = 0;
 	r->prod.tail = r->cons.tail = 0;
 
+	if (flags & RING_F_LF) {
+		struct rte_ring_lf_entry *ring =
+			(struct rte_ring_lf_entry *)&r[1];
+		uint32_t i;
+
+		r->prod_lf.head = r->cons_lf.head = 0;
+		r->prod_lf.tail = r->cons_lf.tail = 0;
+		for (i = 0; i < r->size; i++) {
+			ring[i].ptr = NULL;
+			ring[i].cnt = i;
+		}
+	}
+
 	return 0;
 }
 
-/* create the ring */
-struct rte_ring *
-rte_ring_create(const char *name, unsigned count, int socket_id,
-		unsigned flags)
+/* create the ring of esize byte elements */
+static struct rte_ring *
+ring_create(const char *name, unsigned int esize, unsigned int count,
+		int socket_id, unsigned int flags)
 {
 	char mz_name[RTE_MEMZONE_NAMESIZE];
 	struct rte_ring *r;
@@ -123,11 +166,19 @@ rte_ring_create(const char *name, unsigned count, int socket_id,
 
 	ring_list = RTE_TAILQ_CAST(rte_ring_tailq.head, rte_ring_list);
 
+	if (flags & RING_F_LF) {
+#ifndef RTE_ARCH_X86_64
+		rte_errno = ENOTSUP;
+		return NULL;
+#endif
+		esize = sizeof(struct rte_ring_lf_entry);
+	}
+
 	/* for an exact size ring, round up from count to a power of two */
 	if (flags & RING_F_EXACT_SZ)
 		count = rte_align32pow2(count + 1);
 
-	ring_size = rte_ring_get_memsize(count);
+	ring_size = ring_get_memsize(esize, count);
 	if (ring_size < 0) {
 		rte_errno = ring_size;
 		return NULL;
@@ -174,6 +225,27 @@ rte_ring_create(const char *name, unsigned count, int socket_id,
 	return r;
 }
 
+/* create the ring */
+struct rte_ring *
+rte_ring_create(const char *name, unsigned count, int socket_id,
+		unsigned flags)
+{
+	return ring_create(name, sizeof(void *), count, socket_id, flags);
+}
+
+struct rte_ring *
+rte_ring_create_elem(const char *name, unsigned int esize, unsigned int count,
+		int socket_id, unsigned int flags)
+{
+	/* the functions copying elements do not handle RING_F_LF */
+	if (flags & RING_F_LF) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return ring_create(name, esize, count, socket_id, flags);
+}
+
 /* free the ring */
 void
 rte_ring_free(struct rte_ring *r)
@@ -227,10 +299,16 @@ rte_ring_dump(FILE *f, const struct rte_ring *r)
 	fprintf(f, "  flags=%x\n", r->flags);
 	fprintf(f, "  size=%"PRIu32"\n", r->size);
 	fprintf(f, "  capacity=%"PRIu32"\n", r->capacity);
-	fprintf(f, "  ct=%"PRIu32"\n", r->cons.tail);
-	fprintf(f, "  ch=%"PRIu32"\n", r->cons.head);
-	fprintf(f, "  pt=%"PRIu32"\n", r->prod.tail);
-	fprintf(f, "  ph=%"PRIu32"\n", r->prod.head);
+	if (r->flags & RING_F_LF) {
+		fprintf(f, "  ch=%"PRIu64"\n", r->cons_lf.head);
+		fprintf(f, "  pt=%"PRIu64"\n", r->prod_lf.tail);
+		fprintf(f, "  ph=%"PRIu64"\n", r->prod_lf.head);
+	} else {
+		fprintf(f, "  ct=%"PRIu32"\n", r->cons.tail);
+		fprintf(f, "  ch=%"PRIu32"\n", r->cons.head);
+		fprintf(f, "  pt=%"PRIu32"\n", r->prod.tail);
+		fprintf(f, "  ph=%"PRIu32"\n", r->prod.head);
+	}
 	fprintf(f, "  used=%u\n", rte_ring_count(r));
 	fprintf(f, "  avail=%u\n", rte_ring_free_count(r));
 }
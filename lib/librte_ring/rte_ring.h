@@ -70,6 +70,13 @@ struct rte_ring_headtail {
 	uint32_t single;         /**< True if single prod/cons */
 };
 
+/* structure to hold the 64-bit head/tail of a RING_F_LF ring */
+struct rte_ring_lf_headtail {
+	struct rte_ring_headtail ht; /**< Only single is used. */
+	volatile uint64_t head;  /**< Prod/consumer head. */
+	volatile uint64_t tail;  /**< Producer tail, unused by consumers. */
+};
+
 /**
  * An RTE ring structure.
  *
@@ -97,11 +104,21 @@ struct rte_ring {
 	char pad0 __rte_cache_aligned; /**< empty cache line */
 
 	/** Ring producer status. */
-	struct rte_ring_headtail prod __rte_cache_aligned;
+	RTE_STD_C11
+	union {
+		struct rte_ring_headtail prod __rte_cache_aligned;
+		/** Ring producer status of a RING_F_LF ring. */
+		struct rte_ring_lf_headtail prod_lf __rte_cache_aligned;
+	};
 	char pad1 __rte_cache_aligned; /**< empty cache line */
 
 	/** Ring consumer status. */
-	struct rte_ring_headtail cons __rte_cache_aligned;
+	RTE_STD_C11
+	union {
+		struct rte_ring_headtail cons __rte_cache_aligned;
+		/** Ring consumer status of a RING_F_LF ring. */
+		struct rte_ring_lf_headtail cons_lf __rte_cache_aligned;
+	};
 	char pad2 __rte_cache_aligned; /**< empty cache line */
 };
 
@@ -116,6 +133,17 @@ struct rte_ring {
  * ring space will be wasted.
  */
 #define RING_F_EXACT_SZ 0x0004
+/**
+ * Ring is non-blocking: a thread preempted in the middle of an enqueue or a
+ * dequeue does not prevent the other threads from completing theirs. Each
+ * entry takes 16 bytes instead of a pointer and the multi-producer and
+ * multi-consumer operations are slower, so it is only worth it when the
+ * ring is shared with threads that can be preempted. Only supported on
+ * x86_64, and not with the zero copy functions or rte_ring_create_elem().
+ * A ring initialized with rte_ring_init() needs a memory size of
+ * rte_ring_get_memsize_elem(16, count).
+ */
+#define RING_F_LF 0x0008
 #define RTE_RING_SZ_MASK  (0x7fffffffU) /**< Ring size mask */
 
 /* @internal defines for passing to the enqueue dequeue worker functions */
@@ -171,6 +199,7 @@ ssize_t rte_ring_get_memsize(unsigned count);
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_LF: If this flag is set, the ring is non-blocking.
  * @return
  *   0 on success, or a negative value on error.
  */
@@ -206,12 +235,14 @@ int rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_LF: If this flag is set, the ring is non-blocking.
  * @return
  *   On success, the pointer to the new allocated ring. NULL on error with
  *    rte_errno set appropriately. Possible errno values include:
  *    - E_RTE_NO_CONFIG - function could not get pointer to rte_config structure
  *    - E_RTE_SECONDARY - function was called from a secondary process instance
  *    - EINVAL - count provided is not a power of 2
+ *    - ENOTSUP - RING_F_LF is not supported on this architecture
  *    - ENOSPC - the maximum number of memzones has already been allocated
  *    - EEXIST - a memzone with the same name already exists
  *    - ENOMEM - no appropriate memory area found in which to create memzone
@@ -313,6 +344,8 @@ void rte_ring_dump(FILE *f, const struct rte_ring *r);
 #include "rte_ring_generic.h"
 #endif
 
+#include "rte_ring_lf.h"
+
 /**
  * @internal Enqueue several objects on the ring
  *
@@ -341,6 +374,10 @@ __rte_ring_do_enqueue(struct rte_ring *r, void * const *obj_table,
 	uint32_t prod_head, prod_next;
 	uint32_t free_entries;
 
+	if (unlikely(r->flags & RING_F_LF))
+		return __rte_ring_lf_do_enqueue(r, obj_table, n, behavior,
+				is_sp, free_space);
+
 	n = __rte_ring_move_prod_head(r, is_sp, n, behavior,
 			&prod_head, &prod_next, &free_entries);
 	if (n == 0)
@@ -383,6 +420,10 @@ __rte_ring_do_dequeue(struct rte_ring *r, void **obj_table,
 	uint32_t cons_head, cons_next;
 	uint32_t entries;
 
+	if (unlikely(r->flags & RING_F_LF))
+		return __rte_ring_lf_do_dequeue(r, obj_table, n, behavior,
+				is_sc, available);
+
 	n = __rte_ring_move_cons_head(r, (int)is_sc, n, behavior,
 			&cons_head, &cons_next, &entries);
 	if (n == 0)
@@ -681,9 +722,16 @@ rte_ring_dequeue(struct rte_ring *r, void **obj_p)
 static inline unsigned
 rte_ring_count(const struct rte_ring *r)
 {
-	uint32_t prod_tail = r->prod.tail;
-	uint32_t cons_tail = r->cons.tail;
-	uint32_t count = (prod_tail - cons_tail) & r->mask;
+	uint32_t prod_tail, cons_tail, count;
+
+	if (r->flags & RING_F_LF) {
+		prod_tail = (uint32_t)r->prod_lf.tail;
+		cons_tail = (uint32_t)r->cons_lf.head;
+	} else {
+		prod_tail = r->prod.tail;
+		cons_tail = r->cons.tail;
+	}
+	count = (prod_tail - cons_tail) & r->mask;
 	return (count > r->capacity) ? r->capacity : count;
 }
 
@@ -938,6 +986,256 @@ rte_ring_dequeue_burst(struct rte_ring *r, void **obj_table,
 				r->cons.single, available);
 }
 
+/**
+ * Zero copy reference to ring entries, returned by the zero copy start
+ * functions. The entries may wrap around the end of the ring storage, in
+ * which case they are split in two contiguous areas.
+ */
+struct rte_ring_zc_data {
+	/** Pointer to the first entry. */
+	void **ptr1;
+	/** Pointer to the entry following the end of the ring storage, NULL
+	 *  when all the entries are in the first area.
+	 */
+	void **ptr2;
+	/** Number of entries in the first area, the rest is in the second. */
+	unsigned int n1;
+};
+
+/**
+ * @internal Fill the zero copy reference of n entries from index head.
+ */
+static __rte_always_inline void
+__rte_ring_zc_fill(struct rte_ring *r, uint32_t head, unsigned int n,
+		struct rte_ring_zc_data *zcd)
+{
+	void **ring = (void **)&r[1];
+	uint32_t idx = head & r->mask;
+
+	zcd->ptr1 = &ring[idx];
+	if (likely(idx + n <= r->size)) {
+		zcd->n1 = n;
+		zcd->ptr2 = NULL;
+	} else {
+		zcd->n1 = r->size - idx;
+		zcd->ptr2 = &ring[0];
+	}
+}
+
+/**
+ * @internal Reserve entries for zero copy enqueue (single producer).
+ */
+static __rte_always_inline unsigned int
+__rte_ring_sp_enqueue_zc_start(struct rte_ring *r, unsigned int n,
+		enum rte_ring_queue_behavior behavior,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	uint32_t prod_head, prod_next;
+	uint32_t free_entries;
+
+	n = __rte_ring_move_prod_head(r, __IS_SP, n, behavior,
+			&prod_head, &prod_next, &free_entries);
+	if (n != 0)
+		__rte_ring_zc_fill(r, prod_head, n, zcd);
+
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+/**
+ * @internal Reserve entries for zero copy dequeue (single consumer).
+ */
+static __rte_always_inline unsigned int
+__rte_ring_sc_dequeue_zc_start(struct rte_ring *r, unsigned int n,
+		enum rte_ring_queue_behavior behavior,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	uint32_t cons_head, cons_next;
+	uint32_t entries;
+
+	n = __rte_ring_move_cons_head(r, __IS_SC, n, behavior,
+			&cons_head, &cons_next, &entries);
+	if (n != 0)
+		__rte_ring_zc_fill(r, cons_head, n, zcd);
+
+	if (available != NULL)
+		*available = entries - n;
+	return n;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Start a zero copy enqueue of a fixed number of objects on a ring (NOT
+ * multi-producers safe).
+ *
+ * Instead of copying objects from a table, the caller writes them directly
+ * into the ring storage referenced by *zcd*, then completes the enqueue
+ * with rte_ring_sp_enqueue_zc_finish(). The objects are not visible to the
+ * consumer until then, and no other enqueue may run on the ring in between.
+ * Not supported on RING_F_LF rings.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of entries to reserve in the ring.
+ * @param zcd
+ *   Filled with the reserved ring entries when the return value is not 0.
+ * @param free_space
+ *   If non-NULL, returns the amount of space in the ring after the
+ *   reservation.
+ * @return
+ *   The number of entries reserved, either 0 or n
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sp_enqueue_zc_bulk_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	return __rte_ring_sp_enqueue_zc_start(r, n, RTE_RING_QUEUE_FIXED,
+			zcd, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Start a zero copy enqueue of up to n objects on a ring (NOT
+ * multi-producers safe).
+ *
+ * @see rte_ring_sp_enqueue_zc_bulk_start()
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of entries to reserve in the ring.
+ * @param zcd
+ *   Filled with the reserved ring entries when the return value is not 0.
+ * @param free_space
+ *   If non-NULL, returns the amount of space in the ring after the
+ *   reservation.
+ * @return
+ *   - n: Actual number of entries reserved.
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sp_enqueue_zc_burst_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *free_space)
+{
+	return __rte_ring_sp_enqueue_zc_start(r, n, RTE_RING_QUEUE_VARIABLE,
+			zcd, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Complete a zero copy enqueue started by
+ * rte_ring_sp_enqueue_zc_bulk_start() or
+ * rte_ring_sp_enqueue_zc_burst_start(), making the first n reserved
+ * objects visible to the consumer. The other reserved entries are
+ * released.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of objects written, at most the number of entries reserved.
+ */
+static __rte_always_inline void __rte_experimental
+rte_ring_sp_enqueue_zc_finish(struct rte_ring *r, unsigned int n)
+{
+	uint32_t prod_tail = r->prod.tail;
+
+	r->prod.head = prod_tail + n;
+	update_tail(&r->prod, prod_tail, prod_tail + n, __IS_SP, 1);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Start a zero copy dequeue of a fixed number of objects from a ring (NOT
+ * multi-consumers safe).
+ *
+ * Instead of copying objects to a table, the caller reads them directly
+ * from the ring storage referenced by *zcd*, then completes the dequeue
+ * with rte_ring_sc_dequeue_zc_finish(). The entries are not given back to
+ * the producer until then, and no other dequeue may run on the ring in
+ * between. Not supported on RING_F_LF rings.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of objects to reserve.
+ * @param zcd
+ *   Filled with the reserved ring entries when the return value is not 0.
+ * @param available
+ *   If non-NULL, returns the number of remaining ring entries after the
+ *   reservation.
+ * @return
+ *   The number of objects reserved, either 0 or n
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sc_dequeue_zc_bulk_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	return __rte_ring_sc_dequeue_zc_start(r, n, RTE_RING_QUEUE_FIXED,
+			zcd, available);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Start a zero copy dequeue of up to n objects from a ring (NOT
+ * multi-consumers safe).
+ *
+ * @see rte_ring_sc_dequeue_zc_bulk_start()
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of objects to reserve.
+ * @param zcd
+ *   Filled with the reserved ring entries when the return value is not 0.
+ * @param available
+ *   If non-NULL, returns the number of remaining ring entries after the
+ *   reservation.
+ * @return
+ *   - n: Actual number of objects reserved, 0 if ring is empty
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sc_dequeue_zc_burst_start(struct rte_ring *r, unsigned int n,
+		struct rte_ring_zc_data *zcd, unsigned int *available)
+{
+	return __rte_ring_sc_dequeue_zc_start(r, n, RTE_RING_QUEUE_VARIABLE,
+			zcd, available);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Complete a zero copy dequeue started by
+ * rte_ring_sc_dequeue_zc_bulk_start() or
+ * rte_ring_sc_dequeue_zc_burst_start(), giving the entries of the first n
+ * reserved objects back to the producer. The other reserved objects stay
+ * in the ring.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of objects consumed, at most the number of objects reserved.
+ */
+static __rte_always_inline void __rte_experimental
+rte_ring_sc_dequeue_zc_finish(struct rte_ring *r, unsigned int n)
+{
+	uint32_t cons_tail = r->cons.tail;
+
+	r->cons.head = cons_tail + n;
+	update_tail(&r->cons, cons_tail, cons_tail + n, __IS_SC, 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
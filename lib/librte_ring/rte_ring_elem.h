@@ -0,0 +1,614 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_RING_ELEM_H_
+#define _RTE_RING_ELEM_H_
+
+/**
+ * @file
+ * RTE Ring with user defined element size
+ *
+ * A variant of the ring storing fixed size elements of 4, 8, 16 or 32 bytes
+ * inline, instead of pointers to objects. Small messages can then be passed
+ * between lcores without allocating an object for each of them.
+ *
+ * The rings are created with rte_ring_create_elem() and are otherwise regular
+ * rte_ring: rte_ring_free(), rte_ring_lookup(), rte_ring_count() and the
+ * other functions not copying objects can be used on them. The element size
+ * given at creation must be passed again to each enqueue and dequeue call;
+ * as it is usually a constant, the copy is specialized at compile time.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_compat.h>
+
+#include "rte_ring.h"
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Calculate the memory size needed for a ring with given element size
+ *
+ * This function returns the number of bytes needed for a ring, given
+ * the element size and the number of elements in it. The value is aligned
+ * to a cache line size.
+ *
+ * @param esize
+ *   The size of ring element, in bytes: 4, 8, 16 or 32.
+ * @param count
+ *   The number of elements in the ring (must be a power of 2).
+ * @return
+ *   - The memory size needed for the ring on success.
+ *   - -EINVAL if esize is not supported or count is not a power of 2.
+ */
+ssize_t __rte_experimental
+rte_ring_get_memsize_elem(unsigned int esize, unsigned int count);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a new ring of elements of *esize* bytes named *name* in memory.
+ *
+ * Apart from the element size, this function behaves as rte_ring_create().
+ * The ring can be initialized in memory allocated by the caller with
+ * rte_ring_init(), using rte_ring_get_memsize_elem() to get the memory size.
+ *
+ * @param name
+ *   The name of the ring.
+ * @param esize
+ *   The size of ring element, in bytes: 4, 8, 16 or 32.
+ * @param count
+ *   The size of the ring (must be a power of 2, unless RING_F_EXACT_SZ is
+ *   set in flags).
+ * @param socket_id
+ *   The *socket_id* argument is the socket identifier in case of
+ *   NUMA. The value can be *SOCKET_ID_ANY* if there is no NUMA
+ *   constraint for the reserved zone.
+ * @param flags
+ *   An OR of the RING_F_* flags, see rte_ring_create().
+ * @return
+ *   On success, the pointer to the new allocated ring. NULL on error with
+ *    rte_errno set appropriately. In addition to the rte_ring_create()
+ *    values, EINVAL is set when esize is not supported.
+ */
+struct rte_ring * __rte_experimental
+rte_ring_create_elem(const char *name, unsigned int esize, unsigned int count,
+		int socket_id, unsigned int flags);
+
+/* @internal types used to copy the elements */
+struct __rte_ring_elem16 {
+	uint64_t u64[2];
+};
+
+struct __rte_ring_elem32 {
+	uint64_t u64[4];
+};
+
+#define __RTE_RING_ENQUEUE_ELEMS(r, prod_head, obj_table, n, type) do { \
+	const type *obj = (const type *)(obj_table); \
+	ENQUEUE_PTRS(r, &(r)[1], prod_head, obj, n, type); \
+} while (0)
+
+#define __RTE_RING_DEQUEUE_ELEMS(r, cons_head, obj_table, n, type) do { \
+	type *obj = (type *)(obj_table); \
+	DEQUEUE_PTRS(r, &(r)[1], cons_head, obj, n, type); \
+} while (0)
+
+/**
+ * @internal Copy n elements of esize bytes from obj_table to the ring
+ */
+static __rte_always_inline void
+__rte_ring_enqueue_elems(struct rte_ring *r, uint32_t prod_head,
+		const void *obj_table, unsigned int esize, unsigned int n)
+{
+	switch (esize) {
+	case 4:
+		__RTE_RING_ENQUEUE_ELEMS(r, prod_head, obj_table, n, uint32_t);
+		break;
+	case 8:
+		__RTE_RING_ENQUEUE_ELEMS(r, prod_head, obj_table, n, uint64_t);
+		break;
+	case 16:
+		__RTE_RING_ENQUEUE_ELEMS(r, prod_head, obj_table, n,
+			struct __rte_ring_elem16);
+		break;
+	case 32:
+		__RTE_RING_ENQUEUE_ELEMS(r, prod_head, obj_table, n,
+			struct __rte_ring_elem32);
+		break;
+	}
+}
+
+/**
+ * @internal Copy n elements of esize bytes from the ring to obj_table
+ */
+static __rte_always_inline void
+__rte_ring_dequeue_elems(struct rte_ring *r, uint32_t cons_head,
+		void *obj_table, unsigned int esize, unsigned int n)
+{
+	switch (esize) {
+	case 4:
+		__RTE_RING_DEQUEUE_ELEMS(r, cons_head, obj_table, n, uint32_t);
+		break;
+	case 8:
+		__RTE_RING_DEQUEUE_ELEMS(r, cons_head, obj_table, n, uint64_t);
+		break;
+	case 16:
+		__RTE_RING_DEQUEUE_ELEMS(r, cons_head, obj_table, n,
+			struct __rte_ring_elem16);
+		break;
+	case 32:
+		__RTE_RING_DEQUEUE_ELEMS(r, cons_head, obj_table, n,
+			struct __rte_ring_elem32);
+		break;
+	}
+}
+
+/**
+ * @internal Enqueue several elements on the ring
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of elements.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @param n
+ *   The number of elements to add in the ring from the obj_table.
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Enqueue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Enqueue as many items as possible from ring
+ * @param is_sp
+ *   Indicates whether to use single producer or multi-producer head update
+ * @param free_space
+ *   returns the amount of space after the enqueue operation has finished
+ * @return
+ *   Actual number of elements enqueued.
+ *   If behavior == RTE_RING_QUEUE_FIXED, this will be 0 or n only.
+ */
+static __rte_always_inline unsigned int
+__rte_ring_do_enqueue_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n,
+		enum rte_ring_queue_behavior behavior, unsigned int is_sp,
+		unsigned int *free_space)
+{
+	uint32_t prod_head, prod_next;
+	uint32_t free_entries;
+
+	n = __rte_ring_move_prod_head(r, is_sp, n, behavior,
+			&prod_head, &prod_next, &free_entries);
+	if (n == 0)
+		goto end;
+
+	__rte_ring_enqueue_elems(r, prod_head, obj_table, esize, n);
+
+	update_tail(&r->prod, prod_head, prod_next, is_sp, 1);
+end:
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+/**
+ * @internal Dequeue several elements from the ring
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of elements that will be filled.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @param n
+ *   The number of elements to pull from the ring.
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Dequeue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Dequeue as many items as possible from ring
+ * @param is_sc
+ *   Indicates whether to use single consumer or multi-consumer head update
+ * @param available
+ *   returns the number of remaining ring entries after the dequeue has finished
+ * @return
+ *   - Actual number of elements dequeued.
+ *     If behavior == RTE_RING_QUEUE_FIXED, this will be 0 or n only.
+ */
+static __rte_always_inline unsigned int
+__rte_ring_do_dequeue_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n,
+		enum rte_ring_queue_behavior behavior, unsigned int is_sc,
+		unsigned int *available)
+{
+	uint32_t cons_head, cons_next;
+	uint32_t entries;
+
+	n = __rte_ring_move_cons_head(r, (int)is_sc, n, behavior,
+			&cons_head, &cons_next, &entries);
+	if (n == 0)
+		goto end;
+
+	__rte_ring_dequeue_elems(r, cons_head, obj_table, esize, n);
+
+	update_tail(&r->cons, cons_head, cons_next, is_sc, 0);
+
+end:
+	if (available != NULL)
+		*available = entries - n;
+	return n;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue several elements on the ring (multi-producers safe).
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of elements.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @param n
+ *   The number of elements to add in the ring from the obj_table.
+ * @param free_space
+ *   if non-NULL, returns the amount of space in the ring after the
+ *   enqueue operation has finished.
+ * @return
+ *   The number of elements enqueued, either 0 or n
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_mp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, __IS_MP, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue several elements on a ring (NOT multi-producers safe).
+ *
+ * @see rte_ring_mp_enqueue_bulk_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, __IS_SP, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue several elements on a ring, using the producer mode specified
+ * at ring creation time (see flags).
+ *
+ * @see rte_ring_mp_enqueue_bulk_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, r->prod.single, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue one element on a ring (multi-producers safe).
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj
+ *   A pointer to the element to be added.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @return
+ *   - 0: Success; element enqueued.
+ *   - -ENOBUFS: Not enough room in the ring to enqueue; no element is
+ *     enqueued.
+ */
+static __rte_always_inline int __rte_experimental
+rte_ring_mp_enqueue_elem(struct rte_ring *r, const void *obj,
+		unsigned int esize)
+{
+	return __rte_ring_do_enqueue_elem(r, obj, esize, 1,
+			RTE_RING_QUEUE_FIXED, __IS_MP, NULL) ? 0 : -ENOBUFS;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue one element on a ring (NOT multi-producers safe).
+ *
+ * @see rte_ring_mp_enqueue_elem()
+ */
+static __rte_always_inline int __rte_experimental
+rte_ring_sp_enqueue_elem(struct rte_ring *r, const void *obj,
+		unsigned int esize)
+{
+	return __rte_ring_do_enqueue_elem(r, obj, esize, 1,
+			RTE_RING_QUEUE_FIXED, __IS_SP, NULL) ? 0 : -ENOBUFS;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue one element on a ring, using the producer mode specified at
+ * ring creation time (see flags).
+ *
+ * @see rte_ring_mp_enqueue_elem()
+ */
+static __rte_always_inline int __rte_experimental
+rte_ring_enqueue_elem(struct rte_ring *r, const void *obj,
+		unsigned int esize)
+{
+	return __rte_ring_do_enqueue_elem(r, obj, esize, 1,
+			RTE_RING_QUEUE_FIXED, r->prod.single, NULL) ?
+			0 : -ENOBUFS;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue several elements from a ring (multi-consumers safe).
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of elements that will be filled.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @param n
+ *   The number of elements to dequeue from the ring to the obj_table.
+ * @param available
+ *   If non-NULL, returns the number of remaining ring entries after the
+ *   dequeue has finished.
+ * @return
+ *   The number of elements dequeued, either 0 or n
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_mc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, __IS_MC, available);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue several elements from a ring (NOT multi-consumers safe).
+ *
+ * @see rte_ring_mc_dequeue_bulk_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, __IS_SC, available);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue several elements from a ring, using the consumer mode specified
+ * at ring creation time (see flags).
+ *
+ * @see rte_ring_mc_dequeue_bulk_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_dequeue_bulk_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_FIXED, r->cons.single, available);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue one element from a ring (multi-consumers safe).
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj
+ *   A pointer to the element that will be filled.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @return
+ *   - 0: Success; element dequeued.
+ *   - -ENOENT: Not enough entries in the ring to dequeue; no element is
+ *     dequeued.
+ */
+static __rte_always_inline int __rte_experimental
+rte_ring_mc_dequeue_elem(struct rte_ring *r, void *obj, unsigned int esize)
+{
+	return __rte_ring_do_dequeue_elem(r, obj, esize, 1,
+			RTE_RING_QUEUE_FIXED, __IS_MC, NULL) ? 0 : -ENOENT;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue one element from a ring (NOT multi-consumers safe).
+ *
+ * @see rte_ring_mc_dequeue_elem()
+ */
+static __rte_always_inline int __rte_experimental
+rte_ring_sc_dequeue_elem(struct rte_ring *r, void *obj, unsigned int esize)
+{
+	return __rte_ring_do_dequeue_elem(r, obj, esize, 1,
+			RTE_RING_QUEUE_FIXED, __IS_SC, NULL) ? 0 : -ENOENT;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue one element from a ring, using the consumer mode specified at
+ * ring creation time (see flags).
+ *
+ * @see rte_ring_mc_dequeue_elem()
+ */
+static __rte_always_inline int __rte_experimental
+rte_ring_dequeue_elem(struct rte_ring *r, void *obj, unsigned int esize)
+{
+	return __rte_ring_do_dequeue_elem(r, obj, esize, 1,
+			RTE_RING_QUEUE_FIXED, r->cons.single, NULL) ?
+			0 : -ENOENT;
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue several elements on the ring (multi-producers safe), as many as
+ * there is room for.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of elements.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @param n
+ *   The number of elements to add in the ring from the obj_table.
+ * @param free_space
+ *   if non-NULL, returns the amount of space in the ring after the
+ *   enqueue operation has finished.
+ * @return
+ *   - n: Actual number of elements enqueued.
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_mp_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, __IS_MP, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue several elements on a ring (NOT multi-producers safe), as many
+ * as there is room for.
+ *
+ * @see rte_ring_mp_enqueue_burst_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sp_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, __IS_SP, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enqueue several elements on a ring, as many as there is room for, using
+ * the producer mode specified at ring creation time (see flags).
+ *
+ * @see rte_ring_mp_enqueue_burst_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_enqueue_burst_elem(struct rte_ring *r, const void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *free_space)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, r->prod.single, free_space);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue several elements from a ring (multi-consumers safe), up to a
+ * maximum number.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of elements that will be filled.
+ * @param esize
+ *   The size of ring element, in bytes, as given at ring creation.
+ * @param n
+ *   The number of elements to dequeue from the ring to the obj_table.
+ * @param available
+ *   If non-NULL, returns the number of remaining ring entries after the
+ *   dequeue has finished.
+ * @return
+ *   - n: Actual number of elements dequeued, 0 if ring is empty
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_mc_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, __IS_MC, available);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue several elements from a ring (NOT multi-consumers safe), up to
+ * a maximum number.
+ *
+ * @see rte_ring_mc_dequeue_burst_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_sc_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, __IS_SC, available);
+}
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dequeue several elements from a ring, up to a maximum number, using the
+ * consumer mode specified at ring creation time (see flags).
+ *
+ * @see rte_ring_mc_dequeue_burst_elem()
+ */
+static __rte_always_inline unsigned int __rte_experimental
+rte_ring_dequeue_burst_elem(struct rte_ring *r, void *obj_table,
+		unsigned int esize, unsigned int n, unsigned int *available)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, esize, n,
+			RTE_RING_QUEUE_VARIABLE, r->cons.single, available);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_RING_ELEM_H_ */
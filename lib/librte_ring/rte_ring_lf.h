@@ -0,0 +1,242 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_RING_LF_H_
+#define _RTE_RING_LF_H_
+
+/**
+ * @file
+ * @internal Non-blocking ring, see RING_F_LF.
+ *
+ * Each entry holds the object pointer and a modification counter, updated
+ * together with a 128-bit compare-and-swap. The counter of the entry at
+ * index i is i when the entry can be written, and i + size once it has been.
+ *
+ * A producer reserves free space by moving the producer head, then writes
+ * its objects one by one at the producer tail, and moves the tail past each
+ * written entry. Several producers write at the tail concurrently: the one
+ * whose compare-and-swap fails finds the entry written, moves the tail on
+ * behalf of the winner and retries at the next entry. A preempted producer
+ * then only holds free space, without blocking the other ones.
+ *
+ * A consumer reads the objects between the consumer head and the producer
+ * tail, then moves the consumer head with a compare-and-swap, and reads
+ * them again if another consumer moved it first. Consumers do not write the
+ * entries, so the consumer head is also the consumer tail.
+ *
+ * The indexes are 64-bit, so that the counters never wrap.
+ */
+
+/* @internal ring entry of a RING_F_LF ring */
+struct rte_ring_lf_entry {
+	void *ptr;
+	uint64_t cnt;
+} __rte_aligned(16);
+
+#ifdef RTE_ARCH_X86_64
+
+/* @internal 128-bit compare-and-swap, updates *exp on failure */
+static __rte_always_inline int
+__rte_ring_lf_cas(struct rte_ring_lf_entry *dst,
+		struct rte_ring_lf_entry *exp,
+		const struct rte_ring_lf_entry *src)
+{
+	uint8_t res;
+
+	asm volatile (MPLOCKED
+			"cmpxchg16b %[dst];"
+			" sete %[res]"
+			: [dst] "+m" (*dst),
+			  "+a" (exp->ptr),
+			  "+d" (exp->cnt),
+			  [res] "=r" (res)
+			: "b" (src->ptr),
+			  "c" (src->cnt)
+			: "memory");
+
+	return res;
+}
+
+/**
+ * @internal Reserve free entries by moving the producer head
+ */
+static __rte_always_inline unsigned int
+__rte_ring_lf_move_prod_head(struct rte_ring *r, unsigned int is_sp,
+		unsigned int n, enum rte_ring_queue_behavior behavior,
+		uint32_t *free_entries)
+{
+	const unsigned int max = n;
+	uint64_t prod_head;
+	int success;
+
+	do {
+		n = max;
+
+		prod_head = r->prod_lf.head;
+		rte_smp_rmb();
+
+		*free_entries = (uint32_t)(r->capacity + r->cons_lf.head -
+				prod_head);
+
+		if (unlikely(n > *free_entries))
+			n = (behavior == RTE_RING_QUEUE_FIXED) ?
+					0 : *free_entries;
+
+		if (n == 0)
+			return 0;
+
+		if (is_sp) {
+			r->prod_lf.head = prod_head + n;
+			success = 1;
+		} else
+			success = __sync_bool_compare_and_swap(
+					&r->prod_lf.head,
+					prod_head, prod_head + n);
+	} while (unlikely(success == 0));
+
+	return n;
+}
+
+/**
+ * @internal Enqueue several objects on a RING_F_LF ring
+ */
+static __rte_always_inline unsigned int
+__rte_ring_lf_do_enqueue(struct rte_ring *r, void * const *obj_table,
+		unsigned int n, enum rte_ring_queue_behavior behavior,
+		unsigned int is_sp, unsigned int *free_space)
+{
+	struct rte_ring_lf_entry *ring = (struct rte_ring_lf_entry *)&r[1];
+	uint32_t free_entries;
+	uint64_t prod_tail;
+	unsigned int i;
+
+	n = __rte_ring_lf_move_prod_head(r, is_sp, n, behavior,
+			&free_entries);
+	if (n == 0)
+		goto end;
+
+	prod_tail = r->prod_lf.tail;
+
+	if (is_sp) {
+		for (i = 0; i < n; i++, prod_tail++) {
+			struct rte_ring_lf_entry *e =
+				&ring[prod_tail & r->mask];
+
+			e->ptr = obj_table[i];
+			e->cnt = prod_tail + r->size;
+		}
+
+		rte_smp_wmb();
+		r->prod_lf.tail = prod_tail;
+		goto end;
+	}
+
+	for (i = 0; i < n; ) {
+		struct rte_ring_lf_entry *e = &ring[prod_tail & r->mask];
+		struct rte_ring_lf_entry old_val, new_val;
+
+		old_val.cnt = e->cnt;
+		rte_smp_rmb();
+		old_val.ptr = e->ptr;
+
+		/* Not written yet at this tail, try to write it. */
+		if (old_val.cnt == prod_tail) {
+			new_val.ptr = obj_table[i];
+			new_val.cnt = prod_tail + r->size;
+
+			if (__rte_ring_lf_cas(e, &old_val, &new_val))
+				i++;
+		}
+
+		/* The entry is written by now, by this producer or another
+		 * one: move the tail past it, unless already done.
+		 */
+		__sync_bool_compare_and_swap(&r->prod_lf.tail,
+				prod_tail, prod_tail + 1);
+		prod_tail = r->prod_lf.tail;
+	}
+
+end:
+	if (free_space != NULL)
+		*free_space = free_entries - n;
+	return n;
+}
+
+/**
+ * @internal Dequeue several objects from a RING_F_LF ring
+ */
+static __rte_always_inline unsigned int
+__rte_ring_lf_do_dequeue(struct rte_ring *r, void **obj_table,
+		unsigned int n, enum rte_ring_queue_behavior behavior,
+		unsigned int is_sc, unsigned int *available)
+{
+	struct rte_ring_lf_entry *ring = (struct rte_ring_lf_entry *)&r[1];
+	const unsigned int max = n;
+	uint64_t cons_head;
+	uint32_t entries;
+	unsigned int i;
+	int success;
+
+	do {
+		n = max;
+
+		cons_head = r->cons_lf.head;
+		rte_smp_rmb();
+
+		entries = (uint32_t)(r->prod_lf.tail - cons_head);
+
+		if (n > entries)
+			n = (behavior == RTE_RING_QUEUE_FIXED) ? 0 : entries;
+
+		if (unlikely(n == 0))
+			break;
+
+		for (i = 0; i < n; i++)
+			obj_table[i] = ring[(cons_head + i) & r->mask].ptr;
+
+		rte_smp_rmb();
+
+		if (is_sc) {
+			r->cons_lf.head = cons_head + n;
+			success = 1;
+		} else
+			success = __sync_bool_compare_and_swap(
+					&r->cons_lf.head,
+					cons_head, cons_head + n);
+	} while (unlikely(success == 0));
+
+	if (available != NULL)
+		*available = entries - n;
+	return n;
+}
+
+#else
+
+/* RING_F_LF rings cannot be created on this architecture. */
+
+static __rte_always_inline unsigned int
+__rte_ring_lf_do_enqueue(struct rte_ring *r __rte_unused,
+		void * const *obj_table __rte_unused,
+		unsigned int n __rte_unused,
+		enum rte_ring_queue_behavior behavior __rte_unused,
+		unsigned int is_sp __rte_unused,
+		unsigned int *free_space __rte_unused)
+{
+	return 0;
+}
+
+static __rte_always_inline unsigned int
+__rte_ring_lf_do_dequeue(struct rte_ring *r __rte_unused,
+		void **obj_table __rte_unused,
+		unsigned int n __rte_unused,
+		enum rte_ring_queue_behavior behavior __rte_unused,
+		unsigned int is_sc __rte_unused,
+		unsigned int *available __rte_unused)
+{
+	return 0;
+}
+
+#endif /* RTE_ARCH_X86_64 */
+
+#endif /* _RTE_RING_LF_H_ */
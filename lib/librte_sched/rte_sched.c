@@ -15,6 +15,7 @@
 #include <rte_mbuf.h>
 #include <rte_bitmap.h>
 #include <rte_reciprocal.h>
+#include <rte_ring.h>
 
 #include "rte_sched.h"
 #include "rte_sched_common.h"
@@ -46,6 +47,19 @@
  */
 #define RTE_SCHED_TIME_SHIFT		      8
 
+/* Maximum number of pipe profile tables, grown by doubling their size */
+#define RTE_SCHED_PIPE_PROFILE_TABLES_MAX     16
+
+/* Subport configuration applied by the datapath */
+struct rte_sched_subport_update {
+	uint32_t tb_period;
+	uint32_t tb_credits_per_period;
+	uint32_t tb_size;
+	uint32_t tc_period;
+	uint32_t tc_credits_per_period[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t tc_ov_wm_max;
+};
+
 struct rte_sched_subport {
 	/* Token bucket (TB) */
 	uint64_t tb_time; /* time of last update */
@@ -71,6 +85,11 @@ struct rte_sched_subport {
 
 	/* Statistics */
 	struct rte_sched_subport_stats stats;
+
+	/* Pending configuration, applied at the next TC credit refresh */
+	uint32_t update_pending;
+	uint32_t update_seq;
+	struct rte_sched_subport_update update;
 };
 
 struct rte_sched_pipe_profile {
@@ -106,7 +125,10 @@ struct rte_sched_pipe {
 	/* TC oversubscription */
 	uint32_t tc_ov_credits;
 	uint8_t tc_ov_period_id;
-	uint8_t reserved[3];
+
+	/* Pending profile, applied at the next TC credit refresh */
+	uint8_t update_pending;
+	uint8_t reserved[2];
 } __rte_cache_aligned;
 
 struct rte_sched_queue {
@@ -191,6 +213,7 @@ struct rte_sched_port {
 	uint16_t qsize[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
 	uint32_t n_pipe_profiles;
 	uint32_t pipe_tc3_rate_max;
+	int socket;
 #ifdef RTE_SCHED_RED
 	struct rte_red_config red_config[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE][e_RTE_METER_COLORS];
 #endif
@@ -219,12 +242,31 @@ struct rte_sched_port {
 	uint32_t qsize_add[RTE_SCHED_QUEUES_PER_PIPE];
 	uint32_t qsize_sum;
 
+	/* Partition */
+	struct rte_sched_port *parent; /* NULL when not a partition */
+	uint32_t subport_base;         /* First subport of the partition */
+	uint32_t weight;
+	struct rte_ring *ring;         /* Packets waiting for the merge */
+	struct rte_mbuf *merge_pkt;    /* Packet waiting for merge credits */
+	uint64_t merge_quantum;
+	uint64_t merge_deficit;
+
+	/* Partitions of the port and their merge */
+	struct rte_sched_port *partitions[RTE_SCHED_PORT_N_PARTITIONS_MAX];
+	uint32_t n_partitions;
+	uint32_t merge_pos;
+
 	/* Large data structures */
 	struct rte_sched_subport *subport;
 	struct rte_sched_pipe *pipe;
+	uint32_t *pipe_update; /* Pending profile + 1 of each pipe, or 0 */
 	struct rte_sched_queue *queue;
 	struct rte_sched_queue_extra *queue_extra;
 	struct rte_sched_pipe_profile *pipe_profiles;
+	uint32_t n_pipe_profiles_max;
+	uint32_t n_pipe_profile_tables; /* Tables allocated when growing */
+	struct rte_sched_pipe_profile *
+		pipe_profile_tables[RTE_SCHED_PIPE_PROFILE_TABLES_MAX];
 	uint8_t *bmp_array;
 	struct rte_mbuf **queue_array;
 	uint8_t memory[0] __rte_cache_aligned;
@@ -233,6 +275,7 @@ struct rte_sched_port {
 enum rte_sched_port_array {
 	e_RTE_SCHED_PORT_ARRAY_SUBPORT = 0,
 	e_RTE_SCHED_PORT_ARRAY_PIPE,
+	e_RTE_SCHED_PORT_ARRAY_PIPE_UPDATE,
 	e_RTE_SCHED_PORT_ARRAY_QUEUE,
 	e_RTE_SCHED_PORT_ARRAY_QUEUE_EXTRA,
 	e_RTE_SCHED_PORT_ARRAY_PIPE_PROFILES,
@@ -389,6 +432,7 @@ rte_sched_port_get_array_base(struct rte_sched_port_params *params, enum rte_sch
 
 	uint32_t size_subport = n_subports_per_port * sizeof(struct rte_sched_subport);
 	uint32_t size_pipe = n_pipes_per_port * sizeof(struct rte_sched_pipe);
+	uint32_t size_pipe_update = n_pipes_per_port * sizeof(uint32_t);
 	uint32_t size_queue = n_queues_per_port * sizeof(struct rte_sched_queue);
 	uint32_t size_queue_extra
 		= n_queues_per_port * sizeof(struct rte_sched_queue_extra);
@@ -416,6 +460,10 @@ rte_sched_port_get_array_base(struct rte_sched_port_params *params, enum rte_sch
 		return base;
 	base += RTE_CACHE_LINE_ROUNDUP(size_pipe);
 
+	if (array == e_RTE_SCHED_PORT_ARRAY_PIPE_UPDATE)
+		return base;
+	base += RTE_CACHE_LINE_ROUNDUP(size_pipe_update);
+
 	if (array == e_RTE_SCHED_PORT_ARRAY_QUEUE)
 		return base;
 	base += RTE_CACHE_LINE_ROUNDUP(size_queue);
@@ -650,6 +698,8 @@ rte_sched_port_config(struct rte_sched_port_params *params)
 	port->frame_overhead = params->frame_overhead;
 	memcpy(port->qsize, params->qsize, sizeof(params->qsize));
 	port->n_pipe_profiles = params->n_pipe_profiles;
+	port->n_pipe_profiles_max = RTE_SCHED_PIPE_PROFILES_PER_PORT;
+	port->socket = params->socket;
 
 #ifdef RTE_SCHED_RED
 	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++) {
@@ -701,6 +751,9 @@ rte_sched_port_config(struct rte_sched_port_params *params)
 	port->pipe = (struct rte_sched_pipe *)
 		(port->memory + rte_sched_port_get_array_base(params,
 							      e_RTE_SCHED_PORT_ARRAY_PIPE));
+	port->pipe_update = (uint32_t *)
+		(port->memory + rte_sched_port_get_array_base(params,
+							      e_RTE_SCHED_PORT_ARRAY_PIPE_UPDATE));
 	port->queue = (struct rte_sched_queue *)
 		(port->memory + rte_sched_port_get_array_base(params,
 							      e_RTE_SCHED_PORT_ARRAY_QUEUE));
@@ -736,16 +789,186 @@ rte_sched_port_config(struct rte_sched_port_params *params)
 	return port;
 }
 
+static void
+rte_sched_port_merge_quantum_update(struct rte_sched_port *port)
+{
+	uint32_t weight_min, i;
+
+	weight_min = UINT32_MAX;
+	for (i = 0; i < port->n_partitions; i++)
+		weight_min = RTE_MIN(weight_min, port->partitions[i]->weight);
+
+	/* The partition with the lowest weight gets one frame per round */
+	for (i = 0; i < port->n_partitions; i++) {
+		struct rte_sched_port *p = port->partitions[i];
+
+		p->merge_quantum = (uint64_t)port->mtu * p->weight / weight_min;
+		p->merge_deficit = p->merge_quantum;
+	}
+}
+
+struct rte_sched_port * __rte_experimental
+rte_sched_port_partition_create(struct rte_sched_port *port,
+	struct rte_sched_port_partition_params *params)
+{
+	struct rte_sched_port *partition;
+	uint32_t mem_size, bmp_mem_size, n_queues, first_pipe, qindex, i;
+
+	/* Check user parameters */
+	if (port == NULL || port->parent != NULL ||
+	    params == NULL || params->name == NULL)
+		return NULL;
+
+	if (params->n_subports == 0 ||
+	    params->first_subport >= port->n_subports_per_port ||
+	    params->n_subports >
+			port->n_subports_per_port - params->first_subport)
+		return NULL;
+
+	if (params->weight == 0 ||
+	    port->n_partitions == RTE_SCHED_PORT_N_PARTITIONS_MAX)
+		return NULL;
+
+	for (i = 0; i < port->n_partitions; i++) {
+		struct rte_sched_port *p = port->partitions[i];
+
+		if (params->first_subport <
+				p->subport_base + p->n_subports_per_port &&
+		    p->subport_base <
+				params->first_subport + params->n_subports) {
+			RTE_LOG(ERR, SCHED,
+				"Partition %s overlaps another partition\n",
+				params->name);
+			return NULL;
+		}
+	}
+
+	/* Allocate memory to store the partition and its bitmap */
+	first_pipe = params->first_subport * port->n_pipes_per_subport;
+	n_queues = params->n_subports * port->n_pipes_per_subport *
+		RTE_SCHED_QUEUES_PER_PIPE;
+	bmp_mem_size = rte_bitmap_get_memory_footprint(n_queues);
+	mem_size = sizeof(struct rte_sched_port) + bmp_mem_size;
+
+	partition = rte_zmalloc_socket("qos_partition", mem_size,
+		RTE_CACHE_LINE_SIZE, params->socket);
+	if (partition == NULL)
+		return NULL;
+
+	/* User parameters, timing and queue base calculation of the port */
+	memcpy(partition, port, sizeof(*partition));
+
+	partition->parent = port;
+	partition->subport_base = params->first_subport;
+	partition->n_subports_per_port = params->n_subports;
+	partition->weight = params->weight;
+	partition->merge_pkt = NULL;
+	memset(partition->partitions, 0, sizeof(partition->partitions));
+	partition->n_partitions = 0;
+	partition->merge_pos = 0;
+	partition->n_pipe_profile_tables = 0;
+
+	/* Scheduling loop detection */
+	partition->pipe_loop = RTE_SCHED_PIPE_INVALID;
+	partition->pipe_exhaustion = 0;
+
+	/* Grinders */
+	memset(partition->grinder, 0, sizeof(partition->grinder));
+	partition->busy_grinders = 0;
+	partition->pkts_out = NULL;
+	partition->n_pkts_out = 0;
+	for (i = 0; i < RTE_SCHED_PORT_N_GRINDERS; i++)
+		partition->grinder_base_bmp_pos[i] = RTE_SCHED_PIPE_INVALID;
+
+	/* Large data structures, shared with the port */
+	partition->subport = port->subport + params->first_subport;
+	partition->pipe = port->pipe + first_pipe;
+	partition->pipe_update = port->pipe_update + first_pipe;
+	partition->queue = port->queue + first_pipe * RTE_SCHED_QUEUES_PER_PIPE;
+	partition->queue_extra = port->queue_extra +
+		first_pipe * RTE_SCHED_QUEUES_PER_PIPE;
+	partition->queue_array = port->queue_array +
+		first_pipe * port->qsize_sum;
+
+	/* Bitmap, with the queues which are not empty */
+	partition->bmp_array = partition->memory;
+	partition->bmp = rte_bitmap_init(n_queues, partition->bmp_array,
+		bmp_mem_size);
+	if (partition->bmp == NULL) {
+		RTE_LOG(ERR, SCHED, "Bitmap init error\n");
+		rte_free(partition);
+		return NULL;
+	}
+
+	for (qindex = 0; qindex < n_queues; qindex++) {
+		struct rte_sched_queue *queue = partition->queue + qindex;
+
+		if (queue->qr != queue->qw)
+			rte_bitmap_set(partition->bmp, qindex);
+	}
+
+	/* Ring to the merge */
+	partition->ring = rte_ring_create(params->name, params->ring_size,
+		params->socket, RING_F_SP_ENQ | RING_F_SC_DEQ);
+	if (partition->ring == NULL) {
+		RTE_LOG(ERR, SCHED, "Partition %s ring create error\n",
+			params->name);
+		rte_bitmap_free(partition->bmp);
+		rte_free(partition);
+		return NULL;
+	}
+
+	port->partitions[port->n_partitions++] = partition;
+	rte_sched_port_merge_quantum_update(port);
+
+	return partition;
+}
+
+static void
+rte_sched_port_partition_free(struct rte_sched_port *partition)
+{
+	struct rte_sched_port *port = partition->parent;
+	struct rte_mbuf *pkt;
+	uint32_t i;
+
+	for (i = 0; i < port->n_partitions; i++)
+		if (port->partitions[i] == partition)
+			break;
+	for (; i + 1 < port->n_partitions; i++)
+		port->partitions[i] = port->partitions[i + 1];
+	port->n_partitions--;
+	port->merge_pos = 0;
+	rte_sched_port_merge_quantum_update(port);
+
+	/* Free the packets not merged yet, the queues belong to the port */
+	rte_pktmbuf_free(partition->merge_pkt);
+	while (rte_ring_sc_dequeue(partition->ring, (void **)&pkt) == 0)
+		rte_pktmbuf_free(pkt);
+	rte_ring_free(partition->ring);
+
+	rte_bitmap_free(partition->bmp);
+	rte_free(partition);
+}
+
 void
 rte_sched_port_free(struct rte_sched_port *port)
 {
-	uint32_t qindex;
+	uint32_t qindex, i;
 	uint32_t n_queues_per_port;
 
 	/* Check user parameters */
 	if (port == NULL)
 		return;
 
+	if (port->parent != NULL) {
+		rte_sched_port_partition_free(port);
+		return;
+	}
+
+	while (port->n_partitions != 0)
+		rte_sched_port_partition_free(
+			port->partitions[port->n_partitions - 1]);
+
 	n_queues_per_port = rte_sched_port_queues_per_port(port);
 
 	/* Free enqueued mbufs */
@@ -760,6 +983,9 @@ rte_sched_port_free(struct rte_sched_port *port)
 			rte_pktmbuf_free(mbufs[qr]);
 	}
 
+	for (i = 0; i < port->n_pipe_profile_tables; i++)
+		rte_free(port->pipe_profile_tables[i]);
+
 	rte_bitmap_free(port->bmp);
 	rte_free(port);
 }
@@ -792,15 +1018,13 @@ rte_sched_port_log_subport_config(struct rte_sched_port *port, uint32_t i)
 		s->tc_ov_wm_max);
 }
 
-int
-rte_sched_subport_config(struct rte_sched_port *port,
+static int
+rte_sched_subport_check_params(struct rte_sched_port *port,
 	uint32_t subport_id,
 	struct rte_sched_subport_params *params)
 {
-	struct rte_sched_subport *s;
 	uint32_t i;
 
-	/* Check user parameters */
 	if (port == NULL ||
 	    subport_id >= port->n_subports_per_port ||
 	    params == NULL)
@@ -821,39 +1045,82 @@ rte_sched_subport_config(struct rte_sched_port *port,
 	if (params->tc_period == 0)
 		return -5;
 
-	s = port->subport + subport_id;
+	return 0;
+}
+
+static void
+rte_sched_subport_convert(struct rte_sched_port *port,
+	struct rte_sched_subport_params *params,
+	struct rte_sched_subport_update *u)
+{
+	uint32_t i;
 
 	/* Token Bucket (TB) */
 	if (params->tb_rate == port->rate) {
-		s->tb_credits_per_period = 1;
-		s->tb_period = 1;
+		u->tb_credits_per_period = 1;
+		u->tb_period = 1;
 	} else {
 		double tb_rate = ((double) params->tb_rate) / ((double) port->rate);
 		double d = RTE_SCHED_TB_RATE_CONFIG_ERR;
 
-		rte_approx(tb_rate, d, &s->tb_credits_per_period, &s->tb_period);
+		rte_approx(tb_rate, d, &u->tb_credits_per_period, &u->tb_period);
 	}
 
-	s->tb_size = params->tb_size;
-	s->tb_time = port->time;
-	s->tb_credits = s->tb_size / 2;
+	u->tb_size = params->tb_size;
 
 	/* Traffic Classes (TCs) */
-	s->tc_period = rte_sched_time_ms_to_bytes(params->tc_period, port->rate);
+	u->tc_period = rte_sched_time_ms_to_bytes(params->tc_period, port->rate);
 	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++) {
-		s->tc_credits_per_period[i]
+		u->tc_credits_per_period[i]
 			= rte_sched_time_ms_to_bytes(params->tc_period,
 						     params->tc_rate[i]);
 	}
+
+	/* TC oversubscription */
+	u->tc_ov_wm_max = rte_sched_time_ms_to_bytes(params->tc_period,
+						     port->pipe_tc3_rate_max);
+}
+
+int
+rte_sched_subport_config(struct rte_sched_port *port,
+	uint32_t subport_id,
+	struct rte_sched_subport_params *params)
+{
+	struct rte_sched_subport *s;
+	struct rte_sched_subport_update u;
+	uint32_t i;
+	int status;
+
+	/* Check user parameters */
+	status = rte_sched_subport_check_params(port, subport_id, params);
+	if (status != 0)
+		return status;
+
+	s = port->subport + subport_id;
+	rte_sched_subport_convert(port, params, &u);
+
+	/* Token Bucket (TB) */
+	s->tb_credits_per_period = u.tb_credits_per_period;
+	s->tb_period = u.tb_period;
+	s->tb_size = u.tb_size;
+	s->tb_time = port->time;
+	s->tb_credits = s->tb_size / 2;
+
+	/* Traffic Classes (TCs) */
+	s->tc_period = u.tc_period;
+	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++)
+		s->tc_credits_per_period[i] = u.tc_credits_per_period[i];
 	s->tc_time = port->time + s->tc_period;
 	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++)
 		s->tc_credits[i] = s->tc_credits_per_period[i];
 
+	/* Drop an update staged before the reconfiguration */
+	s->update_pending = 0;
+
 #ifdef RTE_SCHED_SUBPORT_TC_OV
 	/* TC oversubscription */
 	s->tc_ov_wm_min = port->mtu;
-	s->tc_ov_wm_max = rte_sched_time_ms_to_bytes(params->tc_period,
-						     port->pipe_tc3_rate_max);
+	s->tc_ov_wm_max = u.tc_ov_wm_max;
 	s->tc_ov_wm = s->tc_ov_wm_max;
 	s->tc_ov_period_id = 0;
 	s->tc_ov = 0;
@@ -918,8 +1185,10 @@ rte_sched_pipe_config(struct rte_sched_port *port,
 		}
 #endif
 
-		/* Reset the pipe */
+		/* Reset the pipe, with its pending update */
 		memset(p, 0, sizeof(struct rte_sched_pipe));
+		port->pipe_update[subport_id * port->n_pipes_per_subport +
+			pipe_id] = 0;
 	}
 
 	if (deactivate)
@@ -964,6 +1233,117 @@ rte_sched_pipe_config(struct rte_sched_port *port,
 	return 0;
 }
 
+int __rte_experimental
+rte_sched_subport_config_update(struct rte_sched_port *port,
+	uint32_t subport_id,
+	struct rte_sched_subport_params *params)
+{
+	struct rte_sched_subport *s;
+	struct rte_sched_subport_update u;
+	int status;
+
+	/* Check user parameters */
+	status = rte_sched_subport_check_params(port, subport_id, params);
+	if (status != 0)
+		return status;
+
+	/* Check that subport configuration is valid */
+	s = port->subport + subport_id;
+	if (s->tb_period == 0)
+		return -6;
+
+	rte_sched_subport_convert(port, params, &u);
+
+	/* Stage the update, the odd sequence numbers flag it as being written */
+	__atomic_store_n(&s->update_seq, s->update_seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	s->update = u;
+	__atomic_store_n(&s->update_seq, s->update_seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&s->update_pending, 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int __rte_experimental
+rte_sched_pipe_update_bulk(struct rte_sched_port *port,
+	const struct rte_sched_pipe_update *updates,
+	uint32_t n_updates)
+{
+	uint32_t i;
+
+	/* Check user parameters */
+	if (port == NULL || (updates == NULL && n_updates != 0))
+		return -1;
+
+	for (i = 0; i < n_updates; i++) {
+		const struct rte_sched_pipe_update *u = updates + i;
+		struct rte_sched_pipe *p;
+
+		if (u->subport_id >= port->n_subports_per_port ||
+		    u->pipe_id >= port->n_pipes_per_subport ||
+		    u->pipe_profile >= port->n_pipe_profiles)
+			return -1;
+
+		/* Check that pipe configuration is valid */
+		p = port->pipe +
+			(u->subport_id * port->n_pipes_per_subport + u->pipe_id);
+		if (p->tb_time == 0)
+			return -2;
+	}
+
+	/* Stage the updates, the profile is published before the flag */
+	for (i = 0; i < n_updates; i++) {
+		const struct rte_sched_pipe_update *u = updates + i;
+		uint32_t pindex = u->subport_id * port->n_pipes_per_subport +
+			u->pipe_id;
+
+		__atomic_store_n(port->pipe_update + pindex, u->pipe_profile + 1,
+			__ATOMIC_RELEASE);
+		__atomic_store_n(&port->pipe[pindex].update_pending, 1,
+			__ATOMIC_RELEASE);
+	}
+
+	return 0;
+}
+
+static int
+rte_sched_port_pipe_profiles_grow(struct rte_sched_port *port)
+{
+	struct rte_sched_pipe_profile *profiles;
+	uint32_t n_max, i;
+
+	if (port->n_pipe_profile_tables == RTE_SCHED_PIPE_PROFILE_TABLES_MAX)
+		return -1;
+
+	n_max = port->n_pipe_profiles_max * 2;
+	profiles = rte_zmalloc_socket("qos_pipe_profiles",
+		n_max * sizeof(struct rte_sched_pipe_profile),
+		RTE_CACHE_LINE_SIZE, port->socket);
+	if (profiles == NULL)
+		return -1;
+
+	memcpy(profiles, port->pipe_profiles,
+		port->n_pipe_profiles * sizeof(struct rte_sched_pipe_profile));
+
+	/*
+	 * The datapath may still read the previous table, which is only
+	 * freed with the port.
+	 */
+	port->pipe_profile_tables[port->n_pipe_profile_tables++] = profiles;
+	port->n_pipe_profiles_max = n_max;
+	__atomic_store_n(&port->pipe_profiles, profiles, __ATOMIC_RELEASE);
+
+	for (i = 0; i < port->n_partitions; i++) {
+		struct rte_sched_port *partition = port->partitions[i];
+
+		partition->n_pipe_profiles_max = n_max;
+		__atomic_store_n(&partition->pipe_profiles, profiles,
+			__ATOMIC_RELEASE);
+	}
+
+	return 0;
+}
+
 int __rte_experimental
 rte_sched_port_pipe_profile_add(struct rte_sched_port *port,
 	struct rte_sched_pipe_params *params,
@@ -973,19 +1353,20 @@ rte_sched_port_pipe_profile_add(struct rte_sched_port *port,
 	uint32_t i;
 	int status;
 
-	/* Port */
-	if (port == NULL)
+	/* Port, the profiles of the partitions are the ones of their port */
+	if (port == NULL || port->parent != NULL)
 		return -1;
 
-	/* Pipe profiles not exceeds the max limit */
-	if (port->n_pipe_profiles >= RTE_SCHED_PIPE_PROFILES_PER_PORT)
-		return -2;
-
 	/* Pipe params */
 	status = pipe_profile_check(params, port->rate);
 	if (status != 0)
 		return status;
 
+	/* Pipe profile table is full: grow it */
+	if (port->n_pipe_profiles == port->n_pipe_profiles_max &&
+	    rte_sched_port_pipe_profiles_grow(port) != 0)
+		return -2;
+
 	pp = &port->pipe_profiles[port->n_pipe_profiles];
 	rte_sched_pipe_profile_convert(params, pp, port->rate);
 
@@ -1001,6 +1382,11 @@ rte_sched_port_pipe_profile_add(struct rte_sched_port *port,
 	if (port->pipe_tc3_rate_max < params->tc_rate[3])
 		port->pipe_tc3_rate_max = params->tc_rate[3];
 
+	for (i = 0; i < port->n_partitions; i++) {
+		port->partitions[i]->n_pipe_profiles = port->n_pipe_profiles;
+		port->partitions[i]->pipe_tc3_rate_max = port->pipe_tc3_rate_max;
+	}
+
 	rte_sched_port_log_pipe_profile(port, *pipe_profile_id);
 
 	return 0;
@@ -1105,7 +1491,8 @@ rte_sched_port_qindex(struct rte_sched_port *port, uint32_t subport, uint32_t pi
 {
 	uint32_t result;
 
-	result = subport * port->n_pipes_per_subport + pipe;
+	result = (subport - port->subport_base) * port->n_pipes_per_subport +
+		pipe;
 	result = result * RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE + traffic_class;
 	result = result * RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS + queue;
 
@@ -1515,6 +1902,163 @@ rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
 	return result;
 }
 
+#ifdef SCHED_VECTOR_SSE4
+
+static inline void
+grinder_tc_credits_refill(uint32_t *tc_credits,
+	const uint32_t *tc_credits_per_period)
+{
+	_mm_storeu_si128((__m128i *)tc_credits,
+		_mm_loadu_si128((const __m128i *)tc_credits_per_period));
+}
+
+static inline int
+grinder_credits_enough(uint32_t pkt_len, uint32_t subport_tb_credits,
+	uint32_t subport_tc_credits, uint32_t pipe_tb_credits,
+	uint32_t pipe_tc_credits)
+{
+	__m128i credits = _mm_set_epi32(pipe_tc_credits, pipe_tb_credits,
+		subport_tc_credits, subport_tb_credits);
+	__m128i len = _mm_set1_epi32(pkt_len);
+
+	/* pkt_len <= credits, as unsigned values */
+	credits = _mm_cmpeq_epi32(_mm_max_epu32(credits, len), credits);
+
+	return _mm_test_all_ones(credits);
+}
+
+#elif defined(SCHED_VECTOR_NEON)
+
+static inline void
+grinder_tc_credits_refill(uint32_t *tc_credits,
+	const uint32_t *tc_credits_per_period)
+{
+	vst1q_u32(tc_credits, vld1q_u32(tc_credits_per_period));
+}
+
+static inline int
+grinder_credits_enough(uint32_t pkt_len, uint32_t subport_tb_credits,
+	uint32_t subport_tc_credits, uint32_t pipe_tb_credits,
+	uint32_t pipe_tc_credits)
+{
+	uint32_t c[4] = {subport_tb_credits, subport_tc_credits,
+		pipe_tb_credits, pipe_tc_credits};
+	uint32x4_t credits = vld1q_u32(c);
+
+	return vminvq_u32(vcgeq_u32(credits, vdupq_n_u32(pkt_len))) != 0;
+}
+
+#else
+
+static inline void
+grinder_tc_credits_refill(uint32_t *tc_credits,
+	const uint32_t *tc_credits_per_period)
+{
+	tc_credits[0] = tc_credits_per_period[0];
+	tc_credits[1] = tc_credits_per_period[1];
+	tc_credits[2] = tc_credits_per_period[2];
+	tc_credits[3] = tc_credits_per_period[3];
+}
+
+static inline int
+grinder_credits_enough(uint32_t pkt_len, uint32_t subport_tb_credits,
+	uint32_t subport_tc_credits, uint32_t pipe_tb_credits,
+	uint32_t pipe_tc_credits)
+{
+	return (pkt_len <= subport_tb_credits) &&
+		(pkt_len <= subport_tc_credits) &&
+		(pkt_len <= pipe_tb_credits) &&
+		(pkt_len <= pipe_tc_credits);
+}
+
+#endif /* SCHED_VECTOR_SSE4, SCHED_VECTOR_NEON */
+
+static void
+grinder_subport_update(struct rte_sched_subport *subport)
+{
+	struct rte_sched_subport_update u;
+	uint32_t seq;
+
+	/* Read the staged update, retried at the next refresh when torn */
+	if (__atomic_exchange_n(&subport->update_pending, 0,
+			__ATOMIC_ACQUIRE) == 0)
+		return;
+
+	seq = __atomic_load_n(&subport->update_seq, __ATOMIC_ACQUIRE);
+	u = subport->update;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if ((seq & 1) ||
+	    seq != __atomic_load_n(&subport->update_seq, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&subport->update_pending, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	/* Token Bucket (TB), the credits are kept */
+	subport->tb_period = u.tb_period;
+	subport->tb_credits_per_period = u.tb_credits_per_period;
+	subport->tb_size = u.tb_size;
+	subport->tb_credits = rte_sched_min_val_2_u32(subport->tb_credits,
+		subport->tb_size);
+
+	/* Traffic Classes (TCs) */
+	subport->tc_period = u.tc_period;
+	memcpy(subport->tc_credits_per_period, u.tc_credits_per_period,
+		sizeof(subport->tc_credits_per_period));
+
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+	/* TC oversubscription */
+	subport->tc_ov_wm_max = u.tc_ov_wm_max;
+	if (subport->tc_ov_wm > subport->tc_ov_wm_max)
+		subport->tc_ov_wm = subport->tc_ov_wm_max;
+	subport->tc_ov = subport->tc_ov_rate >
+		(double) subport->tc_credits_per_period[3] /
+		(double) subport->tc_period;
+#endif
+}
+
+static void
+grinder_pipe_update(struct rte_sched_port *port, uint32_t pos)
+{
+	struct rte_sched_grinder *grinder = port->grinder + pos;
+	struct rte_sched_pipe *pipe = grinder->pipe;
+	struct rte_sched_pipe_profile *params;
+	uint32_t profile;
+
+	/* The flag is cleared first, so that a later update sets it again */
+	__atomic_exchange_n(&pipe->update_pending, 0, __ATOMIC_ACQUIRE);
+	profile = __atomic_exchange_n(port->pipe_update + grinder->pindex, 0,
+		__ATOMIC_ACQUIRE);
+	if (profile == 0)
+		return;
+
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+	{
+		struct rte_sched_subport *subport = grinder->subport;
+		double subport_tc3_rate =
+			(double) subport->tc_credits_per_period[3] /
+			(double) subport->tc_period;
+
+		/* Move the pipe to its new TC3 rate within its subport */
+		params = port->pipe_profiles + pipe->profile;
+		subport->tc_ov_n -= params->tc_ov_weight;
+		subport->tc_ov_rate -= (double) params->tc_credits_per_period[3]
+			/ (double) params->tc_period;
+
+		params = port->pipe_profiles + profile - 1;
+		subport->tc_ov_n += params->tc_ov_weight;
+		subport->tc_ov_rate += (double) params->tc_credits_per_period[3]
+			/ (double) params->tc_period;
+		subport->tc_ov = subport->tc_ov_rate > subport_tc3_rate;
+	}
+#endif
+
+	/* Token Bucket (TB), the credits are kept */
+	pipe->profile = profile - 1;
+	params = port->pipe_profiles + pipe->profile;
+	pipe->tb_credits = rte_sched_min_val_2_u32(pipe->tb_credits,
+		params->tb_size);
+}
+
 #ifndef RTE_SCHED_SUBPORT_TC_OV
 
 static inline void
@@ -1540,19 +2084,18 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 
 	/* Subport TCs */
 	if (unlikely(port->time >= subport->tc_time)) {
-		subport->tc_credits[0] = subport->tc_credits_per_period[0];
-		subport->tc_credits[1] = subport->tc_credits_per_period[1];
-		subport->tc_credits[2] = subport->tc_credits_per_period[2];
-		subport->tc_credits[3] = subport->tc_credits_per_period[3];
+		if (unlikely(subport->update_pending))
+			grinder_subport_update(subport);
+
+		grinder_tc_credits_refill(subport->tc_credits,
+			subport->tc_credits_per_period);
 		subport->tc_time = port->time + subport->tc_period;
 	}
 
 	/* Pipe TCs */
 	if (unlikely(port->time >= pipe->tc_time)) {
-		pipe->tc_credits[0] = params->tc_credits_per_period[0];
-		pipe->tc_credits[1] = params->tc_credits_per_period[1];
-		pipe->tc_credits[2] = params->tc_credits_per_period[2];
-		pipe->tc_credits[3] = params->tc_credits_per_period[3];
+		grinder_tc_credits_refill(pipe->tc_credits,
+			params->tc_credits_per_period);
 		pipe->tc_time = port->time + params->tc_period;
 	}
 }
@@ -1619,10 +2162,11 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 	if (unlikely(port->time >= subport->tc_time)) {
 		subport->tc_ov_wm = grinder_tc_ov_credits_update(port, pos);
 
-		subport->tc_credits[0] = subport->tc_credits_per_period[0];
-		subport->tc_credits[1] = subport->tc_credits_per_period[1];
-		subport->tc_credits[2] = subport->tc_credits_per_period[2];
-		subport->tc_credits[3] = subport->tc_credits_per_period[3];
+		if (unlikely(subport->update_pending))
+			grinder_subport_update(subport);
+
+		grinder_tc_credits_refill(subport->tc_credits,
+			subport->tc_credits_per_period);
 
 		subport->tc_time = port->time + subport->tc_period;
 		subport->tc_ov_period_id++;
@@ -1630,10 +2174,8 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 
 	/* Pipe TCs */
 	if (unlikely(port->time >= pipe->tc_time)) {
-		pipe->tc_credits[0] = params->tc_credits_per_period[0];
-		pipe->tc_credits[1] = params->tc_credits_per_period[1];
-		pipe->tc_credits[2] = params->tc_credits_per_period[2];
-		pipe->tc_credits[3] = params->tc_credits_per_period[3];
+		grinder_tc_credits_refill(pipe->tc_credits,
+			params->tc_credits_per_period);
 		pipe->tc_time = port->time + params->tc_period;
 	}
 
@@ -1666,10 +2208,8 @@ grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
 	int enough_credits;
 
 	/* Check queue credits */
-	enough_credits = (pkt_len <= subport_tb_credits) &&
-		(pkt_len <= subport_tc_credits) &&
-		(pkt_len <= pipe_tb_credits) &&
-		(pkt_len <= pipe_tc_credits);
+	enough_credits = grinder_credits_enough(pkt_len, subport_tb_credits,
+		subport_tc_credits, pipe_tb_credits, pipe_tc_credits);
 
 	if (!enough_credits)
 		return 0;
@@ -1704,10 +2244,8 @@ grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
 	int enough_credits;
 
 	/* Check pipe and subport credits */
-	enough_credits = (pkt_len <= subport_tb_credits) &&
-		(pkt_len <= subport_tc_credits) &&
-		(pkt_len <= pipe_tb_credits) &&
-		(pkt_len <= pipe_tc_credits) &&
+	enough_credits = grinder_credits_enough(pkt_len, subport_tb_credits,
+		subport_tc_credits, pipe_tb_credits, pipe_tc_credits) &&
 		(pkt_len <= pipe_tc_ov_credits);
 
 	if (!enough_credits)
@@ -2118,6 +2656,10 @@ grinder_handle(struct rte_sched_port *port, uint32_t pos)
 	{
 		struct rte_sched_pipe *pipe = grinder->pipe;
 
+		if (unlikely(pipe->update_pending) &&
+		    port->time >= pipe->tc_time)
+			grinder_pipe_update(port, pos);
+
 		grinder->pipe_params = port->pipe_profiles + pipe->profile;
 		grinder_prefetch_tc_queue_arrays(port, pos);
 		grinder_credits_update(port, pos);
@@ -2241,3 +2783,83 @@ rte_sched_port_dequeue(struct rte_sched_port *port, struct rte_mbuf **pkts, uint
 
 	return count;
 }
+
+/* Maximum number of packets dequeued at once into a partition ring */
+#define RTE_SCHED_PARTITION_BURST_MAX         64U
+
+int __rte_experimental
+rte_sched_port_partition_dequeue(struct rte_sched_port *partition,
+	uint32_t n_pkts)
+{
+	struct rte_mbuf *pkts[RTE_SCHED_PARTITION_BURST_MAX];
+	uint32_t count, n_req, n;
+
+	/* Single producer: the free space of the ring can only grow */
+	n_pkts = RTE_MIN(n_pkts, rte_ring_free_count(partition->ring));
+
+	for (count = 0; count < n_pkts; count += n) {
+		n_req = RTE_MIN(n_pkts - count, RTE_SCHED_PARTITION_BURST_MAX);
+		n = rte_sched_port_dequeue(partition, pkts, n_req);
+		rte_ring_sp_enqueue_burst(partition->ring, (void **)pkts, n,
+			NULL);
+		if (n < n_req) {
+			count += n;
+			break;
+		}
+	}
+
+	return count;
+}
+
+static inline void
+rte_sched_port_merge_next(struct rte_sched_port *port)
+{
+	struct rte_sched_port *partition;
+
+	port->merge_pos++;
+	if (port->merge_pos == port->n_partitions)
+		port->merge_pos = 0;
+
+	partition = port->partitions[port->merge_pos];
+	partition->merge_deficit += partition->merge_quantum;
+}
+
+int __rte_experimental
+rte_sched_port_merge_dequeue(struct rte_sched_port *port,
+	struct rte_mbuf **pkts, uint32_t n_pkts)
+{
+	struct rte_sched_port *partition;
+	struct rte_mbuf *pkt;
+	uint32_t count, n_idle, pkt_len;
+
+	count = 0;
+	n_idle = 0;
+	while (count < n_pkts && n_idle < port->n_partitions) {
+		partition = port->partitions[port->merge_pos];
+
+		pkt = partition->merge_pkt;
+		if (pkt == NULL &&
+		    rte_ring_sc_dequeue(partition->ring, (void **)&pkt) != 0) {
+			/* Idle partition does not keep its credits */
+			partition->merge_deficit = 0;
+			rte_sched_port_merge_next(port);
+			n_idle++;
+			continue;
+		}
+
+		/* Keep the packet until the next round */
+		pkt_len = pkt->pkt_len + port->frame_overhead;
+		if (pkt_len > partition->merge_deficit) {
+			partition->merge_pkt = pkt;
+			rte_sched_port_merge_next(port);
+			continue;
+		}
+
+		partition->merge_pkt = NULL;
+		partition->merge_deficit -= pkt_len;
+		pkts[count++] = pkt;
+		n_idle = 0;
+	}
+
+	return count;
+}
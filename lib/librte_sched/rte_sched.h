@@ -79,7 +79,8 @@ extern "C" {
 	(RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE *     \
 	RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS)
 
-/** Maximum number of pipe profiles that can be defined per port.
+/** Maximum number of pipe profiles that can be defined per port at
+ * configuration time, the table grows when adding more profiles.
  * Compile-time configurable.
  */
 #ifndef RTE_SCHED_PIPE_PROFILES_PER_PORT
@@ -100,6 +101,9 @@ extern "C" {
 #define RTE_SCHED_FRAME_OVERHEAD_DEFAULT      24
 #endif
 
+/** Maximum number of partitions per port. */
+#define RTE_SCHED_PORT_N_PARTITIONS_MAX       16
+
 /*
  * Subport configuration parameters. The period and credits_per_period
  * parameters are measured in bytes, with one byte meaning the time
@@ -168,6 +172,13 @@ struct rte_sched_pipe_params {
 	uint8_t  wrr_weights[RTE_SCHED_QUEUES_PER_PIPE]; /**< WRR weights */
 };
 
+/** Pipe profile update, see rte_sched_pipe_update_bulk() */
+struct rte_sched_pipe_update {
+	uint32_t subport_id;   /**< Subport ID */
+	uint32_t pipe_id;      /**< Pipe ID within subport */
+	uint32_t pipe_profile; /**< ID of port-level pre-configured pipe profile */
+};
+
 /** Queue statistics */
 struct rte_sched_queue_stats {
 	/* Packets */
@@ -209,6 +220,21 @@ struct rte_sched_port_params {
 #endif
 };
 
+/** Port partition parameters. */
+struct rte_sched_port_partition_params {
+	const char *name;                /**< Name of the partition ring */
+	int socket;                      /**< CPU socket ID */
+	uint32_t first_subport;          /**< First subport of the partition */
+	uint32_t n_subports;             /**< Number of subports */
+	uint32_t ring_size;
+	/**< Size of the ring storing the packets dequeued from the partition
+	 * until they are merged, power of 2 */
+	uint32_t weight;
+	/**< Share of the port given to the partition by the merge, typically
+	 * the sum of the rates of its subports (measured in bytes per
+	 * second) */
+};
+
 /*
  * Configuration
  *
@@ -240,6 +266,9 @@ rte_sched_port_free(struct rte_sched_port *port);
  *
  * Hierarchical scheduler pipe profile add
  *
+ * Once all the profiles of the table are used, the table is replaced by a
+ * larger one, without stopping the scheduling.
+ *
  * @param port
  *   Handle to port scheduler instance
  * @param params
@@ -291,6 +320,56 @@ rte_sched_pipe_config(struct rte_sched_port *port,
 	uint32_t pipe_id,
 	int32_t pipe_profile);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Hierarchical scheduler subport reconfiguration while scheduling
+ *
+ * The new rates are applied atomically by the scheduler at the next traffic
+ * class credit refresh of the subport, keeping its credits, unlike
+ * rte_sched_subport_config() which resets the subport. It can be called by
+ * one control thread while another one runs the scheduler.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param subport_id
+ *   Subport ID, of a configured subport
+ * @param params
+ *   Subport configuration parameters
+ * @return
+ *   0 upon success, error code otherwise
+ */
+int __rte_experimental
+rte_sched_subport_config_update(struct rte_sched_port *port,
+	uint32_t subport_id,
+	struct rte_sched_subport_params *params);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Hierarchical scheduler pipe profile changes while scheduling
+ *
+ * Each pipe switches to its new profile at its next traffic class credit
+ * refresh, keeping its credits, unlike rte_sched_pipe_config() which resets
+ * the pipe. No update is staged when any of them is invalid. It can be
+ * called by one control thread while another one runs the scheduler.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param updates
+ *   Array of pipe profile updates, of configured pipes
+ * @param n_updates
+ *   Number of elements in the updates array
+ * @return
+ *   0 upon success, error code otherwise
+ */
+int __rte_experimental
+rte_sched_pipe_update_bulk(struct rte_sched_port *port,
+	const struct rte_sched_pipe_update *updates,
+	uint32_t n_updates);
+
 /**
  * Hierarchical scheduler memory footprint size per port
  *
@@ -440,6 +519,86 @@ rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts, uint
 int
 rte_sched_port_dequeue(struct rte_sched_port *port, struct rte_mbuf **pkts, uint32_t n_pkts);
 
+/*
+ * Partitions
+ *
+ ***/
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Hierarchical scheduler port partition create. A partition schedules a
+ * range of consecutive subports of the port, using its own queue bitmap,
+ * grinders and time, so that the partitions of a port can run their
+ * enqueue and dequeue operations on different cores. The subports, pipes
+ * and queues, along with their statistics, are shared with the port:
+ * the hierarchy is configured on the port before the partitions are
+ * created, and the port itself is no longer used for enqueue and
+ * dequeue. The partition is freed with rte_sched_port_free(), and the
+ * remaining partitions are freed with the port.
+ *
+ * A partition is a port handle, whose subport IDs are relative to its
+ * first subport: rte_sched_port_enqueue() and rte_sched_port_dequeue()
+ * apply to it, with packets whose subport, as written by
+ * rte_sched_port_pkt_write(), belongs to the partition.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param params
+ *   Partition parameters
+ * @return
+ *   Handle to the partition upon success or NULL otherwise.
+ */
+struct rte_sched_port * __rte_experimental
+rte_sched_port_partition_create(struct rte_sched_port *port,
+	struct rte_sched_port_partition_params *params);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Hierarchical scheduler port partition dequeue. Dequeues up to n_pkts
+ * from the partition, as rte_sched_port_dequeue(), into the partition
+ * ring, for rte_sched_port_merge_dequeue() to send them. No more packets
+ * than the free space of the ring are dequeued, so that the partition
+ * follows the pace of the output port.
+ *
+ * @param partition
+ *   Handle to port partition instance
+ * @param n_pkts
+ *   Number of packets to dequeue from the partition
+ * @return
+ *   Number of packets dequeued into the partition ring
+ */
+int __rte_experimental
+rte_sched_port_partition_dequeue(struct rte_sched_port *partition,
+	uint32_t n_pkts);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Hierarchical scheduler port merge dequeue. Reads up to n_pkts from the
+ * rings of the partitions of the port, with a deficit round robin
+ * weighted by the partition weights. It is the single consumer of the
+ * partition rings, typically the core writing to the TX queue of the
+ * output port.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param pkts
+ *   Pre-allocated packet descriptor array where the merged packets
+ *   should be stored
+ * @param n_pkts
+ *   Number of packets to merge
+ * @return
+ *   Number of packets merged and placed in the pkts array
+ */
+int __rte_experimental
+rte_sched_port_merge_dequeue(struct rte_sched_port *port,
+	struct rte_mbuf **pkts, uint32_t n_pkts);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,16 @@ extern "C" {
  *        4 keys, potentially until all keys in this bucket are examined. The
  *        extendible bucket logic requires maintaining specific data structures
  *        per table and per each bucket. Use-cases: flow table, etc.
+ *     c. Resizable: The bucket is extended as for the extendible bucket
+ *        tables, but the table grows instead of failing the key add
+ *        operation. The keys are allocated in chunks of n_keys keys, a new
+ *        chunk being added when all the keys are in use, and the number of
+ *        buckets is doubled when the average number of keys per bucket gets
+ *        above 2. The keys are migrated to the new buckets incrementally, a
+ *        few buckets on each table operation (lookup included), so the
+ *        lookup latency stays bounded while the table grows. The entries
+ *        never move in memory. Use-cases: flow table with a number of flows
+ *        varying a lot over time.
  * 2. Key size:
  *     a. Configurable key size
  *     b. Single key size (8-byte, 16-byte or 32-byte key size)
@@ -99,6 +109,14 @@ extern struct rte_table_ops rte_table_hash_key8_lru_ops;
 extern struct rte_table_ops rte_table_hash_key16_lru_ops;
 extern struct rte_table_ops rte_table_hash_key32_lru_ops;
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Resizable hash table operations
+ */
+extern struct rte_table_ops rte_table_hash_resizable_ops;
+
 #ifdef __cplusplus
 }
 #endif
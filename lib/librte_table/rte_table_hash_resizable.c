@@ -0,0 +1,720 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include <rte_common.h>
+#include <rte_mbuf.h>
+#include <rte_memory.h>
+#include <rte_malloc.h>
+#include <rte_prefetch.h>
+#include <rte_log.h>
+
+#include "rte_table_hash.h"
+
+#define KEYS_PER_BUCKET	4U
+
+/* Maximum number of key chunks, i.e. of table growths by n_keys */
+#define CHUNKS_MAX	1024U
+
+/* Number of old buckets migrated by each table operation during resize */
+#define RESIZE_BUCKETS_PER_OP	4
+
+/* End of the free key list */
+#define KEY_INDEX_INVALID	UINT32_MAX
+
+struct bucket {
+	uintptr_t next;
+	uint16_t sig[KEYS_PER_BUCKET];
+	uint32_t key_pos[KEYS_PER_BUCKET];
+};
+
+#define BUCKET_NEXT(bkt)						\
+	((struct bucket *) ((bkt)->next & (~1LU)))
+
+#define BUCKET_NEXT_SET(bucket, bucket_next)				\
+do									\
+	(bucket)->next = (((uintptr_t) ((void *) (bucket_next))) | 1LU);\
+while (0)
+
+#define BUCKET_NEXT_SET_NULL(bucket)					\
+do									\
+	(bucket)->next = 0;						\
+while (0)
+
+#ifdef RTE_TABLE_STATS_COLLECT
+
+#define RTE_TABLE_HASH_RESIZABLE_STATS_PKTS_IN_ADD(table, val) \
+	table->stats.n_pkts_in += val
+#define RTE_TABLE_HASH_RESIZABLE_STATS_PKTS_LOOKUP_MISS(table, val) \
+	table->stats.n_pkts_lookup_miss += val
+
+#else
+
+#define RTE_TABLE_HASH_RESIZABLE_STATS_PKTS_IN_ADD(table, val)
+#define RTE_TABLE_HASH_RESIZABLE_STATS_PKTS_LOOKUP_MISS(table, val)
+
+#endif
+
+struct rte_table_hash {
+	struct rte_table_stats stats;
+
+	/* Input parameters */
+	uint32_t key_size;
+	uint32_t entry_size;
+	rte_table_hash_op_hash f_hash;
+	uint64_t seed;
+	uint32_t key_offset;
+	int socket_id;
+
+	/* Internal */
+	uint32_t key_size_shl;
+	uint32_t data_size_shl;
+	uint32_t chunk_shl;
+	uint32_t chunk_mask;
+	uint32_t chunk_data_offset;
+	uint32_t chunk_bkt_ext_offset;
+	uint32_t chunk_size;
+	uint32_t n_bkt_ext_per_chunk;
+	uint32_t n_chunks;
+	uint32_t n_chunks_max;
+	uint32_t n_keys;
+	uint32_t key_free;
+
+	/* Buckets */
+	uint32_t n_buckets;
+	uint64_t bucket_mask;
+	struct bucket *buckets;
+	struct bucket *bkt_ext_free;
+
+	/* Resize in progress: buckets[0 .. resize_pos - 1] are migrated */
+	struct bucket *buckets_new;
+	uint64_t bucket_mask_new;
+	uint32_t resize_pos;
+
+	/* Key chunks: keys, then data, then bucket extensions */
+	uint8_t *chunks[CHUNKS_MAX];
+
+	/* Key mask */
+	uint64_t key_mask[0] __rte_cache_aligned;
+};
+
+static int
+keycmp(void *a, void *b, void *b_mask, uint32_t n_bytes)
+{
+	uint64_t *a64 = a, *b64 = b, *b_mask64 = b_mask;
+	uint32_t i;
+
+	for (i = 0; i < n_bytes / sizeof(uint64_t); i++)
+		if (a64[i] != (b64[i] & b_mask64[i]))
+			return 1;
+
+	return 0;
+}
+
+static void
+keycpy(void *dst, void *src, void *src_mask, uint32_t n_bytes)
+{
+	uint64_t *dst64 = dst, *src64 = src, *src_mask64 = src_mask;
+	uint32_t i;
+
+	for (i = 0; i < n_bytes / sizeof(uint64_t); i++)
+		dst64[i] = src64[i] & src_mask64[i];
+}
+
+static inline uint8_t *
+key_get(struct rte_table_hash *t, uint32_t key_index)
+{
+	return &t->chunks[key_index >> t->chunk_shl][
+		(key_index & t->chunk_mask) << t->key_size_shl];
+}
+
+static inline uint8_t *
+data_get(struct rte_table_hash *t, uint32_t key_index)
+{
+	return &t->chunks[key_index >> t->chunk_shl][t->chunk_data_offset +
+		((key_index & t->chunk_mask) << t->data_size_shl)];
+}
+
+static inline struct bucket *
+bucket_get(struct rte_table_hash *t, uint64_t sig)
+{
+	uint64_t bkt_index = sig & t->bucket_mask;
+
+	if (bkt_index < t->resize_pos)
+		return &t->buckets_new[sig & t->bucket_mask_new];
+
+	return &t->buckets[bkt_index];
+}
+
+static int
+check_params_create(struct rte_table_hash_params *params)
+{
+	/* name */
+	if (params->name == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: name invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	/* key_size */
+	if ((params->key_size < sizeof(uint64_t)) ||
+		(!rte_is_power_of_2(params->key_size))) {
+		RTE_LOG(ERR, TABLE, "%s: key_size invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	/* n_keys */
+	if ((params->n_keys == 0) || (params->n_keys > (1U << 31))) {
+		RTE_LOG(ERR, TABLE, "%s: n_keys invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	/* n_buckets */
+	if ((params->n_buckets == 0) ||
+		(!rte_is_power_of_2(params->n_buckets))) {
+		RTE_LOG(ERR, TABLE, "%s: n_buckets invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	/* f_hash */
+	if (params->f_hash == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: f_hash invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Add a chunk of free keys, with their data and enough bucket extensions
+ * for them. The chunks are never moved, so the entry pointers returned to
+ * the user stay valid while the table grows.
+ */
+static int
+chunk_add(struct rte_table_hash *t)
+{
+	uint8_t *chunk;
+	struct bucket *bkt_ext;
+	uint32_t key_index, i;
+
+	if (t->n_chunks == t->n_chunks_max)
+		return -ENOSPC;
+
+	chunk = rte_zmalloc_socket("TABLE", t->chunk_size, RTE_CACHE_LINE_SIZE,
+		t->socket_id);
+	if (chunk == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: Cannot allocate %u bytes for "
+			"hash table key chunk\n", __func__, t->chunk_size);
+		return -ENOMEM;
+	}
+
+	t->chunks[t->n_chunks] = chunk;
+	key_index = t->n_chunks << t->chunk_shl;
+	t->n_chunks++;
+
+	/* Free key list, linked through the first bytes of the free keys */
+	for (i = 0; i <= t->chunk_mask; i++) {
+		uint32_t *next = (uint32_t *)key_get(t, key_index + i);
+
+		*next = (i == t->chunk_mask) ? t->key_free : key_index + i + 1;
+	}
+	t->key_free = key_index;
+
+	/* Free bucket extension list */
+	bkt_ext = (struct bucket *) &chunk[t->chunk_bkt_ext_offset];
+	for (i = 0; i < t->n_bkt_ext_per_chunk; i++) {
+		bkt_ext[i].next = (uintptr_t) t->bkt_ext_free;
+		t->bkt_ext_free = &bkt_ext[i];
+	}
+
+	return 0;
+}
+
+static void *
+rte_table_hash_resizable_create(void *params, int socket_id,
+	uint32_t entry_size)
+{
+	struct rte_table_hash_params *p = params;
+	struct rte_table_hash *t;
+	uint64_t table_meta_sz, key_mask_sz, bucket_sz, key_sz, data_sz;
+	uint64_t bkt_ext_sz, chunk_sz;
+	uint32_t n_keys_chunk;
+
+	/* Check input parameters */
+	if ((check_params_create(p) != 0) ||
+		(!rte_is_power_of_2(entry_size)) ||
+		((sizeof(struct rte_table_hash) % RTE_CACHE_LINE_SIZE) != 0) ||
+		(sizeof(struct bucket) != (RTE_CACHE_LINE_SIZE / 2)))
+		return NULL;
+
+	/*
+	 * Chunk dimensioning
+	 *
+	 * The table starts with one chunk of n_keys keys (rounded up to a power
+	 * of 2) and gets one more chunk each time it runs out of keys.
+	 *
+	 * On key delete, the last key of the bucket chain is moved into the
+	 * freed position, so all the buckets of a chain but the last one are
+	 * full. A chain of n keys then uses (n - 1) / KEYS_PER_BUCKET bucket
+	 * extensions, and the chains of the table never use more than
+	 * n_keys / KEYS_PER_BUCKET bucket extensions in total. The extra
+	 * KEYS_PER_BUCKET bucket extensions per chunk cover the chain being
+	 * migrated during resize.
+	 */
+	n_keys_chunk = rte_align32pow2(RTE_MAX(p->n_keys, KEYS_PER_BUCKET));
+
+	key_sz = RTE_CACHE_LINE_ROUNDUP((uint64_t)n_keys_chunk * p->key_size);
+	data_sz = RTE_CACHE_LINE_ROUNDUP((uint64_t)n_keys_chunk * entry_size);
+	bkt_ext_sz = RTE_CACHE_LINE_ROUNDUP(
+		(n_keys_chunk / KEYS_PER_BUCKET + KEYS_PER_BUCKET) *
+		sizeof(struct bucket));
+	chunk_sz = key_sz + data_sz + bkt_ext_sz;
+
+	/* Memory allocation */
+	table_meta_sz = RTE_CACHE_LINE_ROUNDUP(sizeof(struct rte_table_hash));
+	key_mask_sz = RTE_CACHE_LINE_ROUNDUP(p->key_size);
+	bucket_sz = RTE_CACHE_LINE_ROUNDUP((uint64_t)p->n_buckets *
+		sizeof(struct bucket));
+
+	if ((chunk_sz > UINT32_MAX) || (bucket_sz > SIZE_MAX)) {
+		RTE_LOG(ERR, TABLE, "%s: Cannot allocate %" PRIu64 " bytes"
+			" for hash table %s\n",
+			__func__, chunk_sz + bucket_sz, p->name);
+		return NULL;
+	}
+
+	t = rte_zmalloc_socket(p->name,
+		(size_t)(table_meta_sz + key_mask_sz),
+		RTE_CACHE_LINE_SIZE,
+		socket_id);
+	if (t == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: Cannot allocate %" PRIu64 " bytes"
+			" for hash table %s\n",
+			__func__, table_meta_sz + key_mask_sz, p->name);
+		return NULL;
+	}
+
+	t->buckets = rte_zmalloc_socket(p->name,
+		(size_t)bucket_sz,
+		RTE_CACHE_LINE_SIZE,
+		socket_id);
+	if (t->buckets == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: Cannot allocate %" PRIu64 " bytes"
+			" for hash table %s\n",
+			__func__, bucket_sz, p->name);
+		rte_free(t);
+		return NULL;
+	}
+
+	/* Memory initialization */
+	t->key_size = p->key_size;
+	t->entry_size = entry_size;
+	t->f_hash = p->f_hash;
+	t->seed = p->seed;
+	t->key_offset = p->key_offset;
+	t->socket_id = socket_id;
+
+	/* Internal */
+	t->key_size_shl = __builtin_ctzl(p->key_size);
+	t->data_size_shl = __builtin_ctzl(entry_size);
+	t->chunk_shl = __builtin_ctz(n_keys_chunk);
+	t->chunk_mask = n_keys_chunk - 1;
+	t->chunk_data_offset = key_sz;
+	t->chunk_bkt_ext_offset = key_sz + data_sz;
+	t->chunk_size = chunk_sz;
+	t->n_bkt_ext_per_chunk = n_keys_chunk / KEYS_PER_BUCKET +
+		KEYS_PER_BUCKET;
+	t->n_chunks_max = RTE_MIN(CHUNKS_MAX, (1U << 31) >> t->chunk_shl);
+	t->key_free = KEY_INDEX_INVALID;
+
+	/* Buckets */
+	t->n_buckets = p->n_buckets;
+	t->bucket_mask = t->n_buckets - 1;
+
+	/* Key mask */
+	if (p->key_mask == NULL)
+		memset(t->key_mask, 0xFF, p->key_size);
+	else
+		memcpy(t->key_mask, p->key_mask, p->key_size);
+
+	/* Keys */
+	if (chunk_add(t) != 0) {
+		rte_free(t->buckets);
+		rte_free(t);
+		return NULL;
+	}
+
+	RTE_LOG(INFO, TABLE, "%s (%u-byte key): Hash table %s memory "
+		"footprint is %" PRIu64 " bytes, growing by %" PRIu64
+		" bytes per %u keys\n",
+		__func__, p->key_size, p->name,
+		table_meta_sz + key_mask_sz + bucket_sz + chunk_sz,
+		chunk_sz, n_keys_chunk);
+
+	return t;
+}
+
+static int
+rte_table_hash_resizable_free(void *table)
+{
+	struct rte_table_hash *t = table;
+	uint32_t i;
+
+	/* Check input parameters */
+	if (t == NULL)
+		return -EINVAL;
+
+	for (i = 0; i < t->n_chunks; i++)
+		rte_free(t->chunks[i]);
+	rte_free(t->buckets_new);
+	rte_free(t->buckets);
+	rte_free(t);
+	return 0;
+}
+
+/* Append a key to a bucket chain, in the first free position */
+static void
+bucket_append(struct rte_table_hash *t, struct bucket *bkt, uint16_t sig,
+	uint32_t key_index)
+{
+	struct bucket *bkt_prev;
+	uint32_t i;
+
+	for (bkt_prev = NULL; bkt != NULL; bkt_prev = bkt,
+		bkt = BUCKET_NEXT(bkt))
+		for (i = 0; i < KEYS_PER_BUCKET; i++)
+			if (bkt->sig[i] == 0) {
+				bkt->sig[i] = sig;
+				bkt->key_pos[i] = key_index;
+				return;
+			}
+
+	/* Bucket full: extend bucket, never fails as per chunk dimensioning */
+	bkt = t->bkt_ext_free;
+	t->bkt_ext_free = (struct bucket *) bkt->next;
+
+	BUCKET_NEXT_SET(bkt_prev, bkt);
+	BUCKET_NEXT_SET_NULL(bkt);
+	bkt->sig[0] = sig;
+	bkt->key_pos[0] = key_index;
+}
+
+static void
+bucket_ext_free(struct rte_table_hash *t, struct bucket *bkt)
+{
+	memset(bkt, 0, sizeof(struct bucket));
+	bkt->next = (uintptr_t) t->bkt_ext_free;
+	t->bkt_ext_free = bkt;
+}
+
+static void
+resize_start(struct rte_table_hash *t)
+{
+	uint64_t bucket_sz;
+
+	if (t->n_buckets >= (1U << 31))
+		return;
+
+	bucket_sz = 2 * (uint64_t)t->n_buckets * sizeof(struct bucket);
+	if (bucket_sz > SIZE_MAX)
+		return;
+
+	t->buckets_new = rte_zmalloc_socket("TABLE", (size_t)bucket_sz,
+		RTE_CACHE_LINE_SIZE, t->socket_id);
+	if (t->buckets_new == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: Cannot allocate %" PRIu64 " bytes "
+			"to resize hash table\n", __func__, bucket_sz);
+		return;
+	}
+
+	t->bucket_mask_new = 2 * (uint64_t)t->n_buckets - 1;
+	t->resize_pos = 0;
+}
+
+/*
+ * Migrate the next few buckets of the old bucket array to the new one.
+ * The work done per table operation is bounded, so the lookup latency
+ * stays bounded while the table is resized.
+ */
+static void
+resize_step(struct rte_table_hash *t)
+{
+	uint32_t n;
+
+	for (n = 0; n < RESIZE_BUCKETS_PER_OP; n++) {
+		struct bucket *bkt, *bkt_next;
+
+		for (bkt = &t->buckets[t->resize_pos]; bkt != NULL;
+			bkt = bkt_next) {
+			uint16_t sig[KEYS_PER_BUCKET];
+			uint32_t key_pos[KEYS_PER_BUCKET], i;
+
+			/* Empty the bucket before refilling the new chains */
+			memcpy(sig, bkt->sig, sizeof(sig));
+			memcpy(key_pos, bkt->key_pos, sizeof(key_pos));
+			bkt_next = BUCKET_NEXT(bkt);
+			if (bkt != &t->buckets[t->resize_pos])
+				bucket_ext_free(t, bkt);
+
+			for (i = 0; i < KEYS_PER_BUCKET; i++) {
+				uint64_t hash;
+
+				if (sig[i] == 0)
+					continue;
+
+				hash = t->f_hash(key_get(t, key_pos[i]),
+					t->key_mask, t->key_size, t->seed);
+				bucket_append(t,
+					&t->buckets_new[hash & t->bucket_mask_new],
+					sig[i], key_pos[i]);
+			}
+		}
+
+		t->resize_pos++;
+		if (t->resize_pos == t->n_buckets) {
+			rte_free(t->buckets);
+			t->buckets = t->buckets_new;
+			t->n_buckets *= 2;
+			t->bucket_mask = t->bucket_mask_new;
+			t->buckets_new = NULL;
+			t->resize_pos = 0;
+			return;
+		}
+	}
+}
+
+static int
+rte_table_hash_resizable_entry_add(void *table, void *key, void *entry,
+	int *key_found, void **entry_ptr)
+{
+	struct rte_table_hash *t = table;
+	struct bucket *bkt0, *bkt;
+	uint8_t *bkt_key, *data;
+	uint64_t sig;
+	uint32_t bkt_key_index, i;
+
+	if (t->buckets_new != NULL)
+		resize_step(t);
+
+	sig = t->f_hash(key, t->key_mask, t->key_size, t->seed);
+	bkt0 = bucket_get(t, sig);
+	sig = (sig >> 16) | 1LLU;
+
+	/* Key is present in the bucket */
+	for (bkt = bkt0; bkt != NULL; bkt = BUCKET_NEXT(bkt))
+		for (i = 0; i < KEYS_PER_BUCKET; i++) {
+			uint64_t bkt_sig = (uint64_t) bkt->sig[i];
+
+			bkt_key_index = bkt->key_pos[i];
+			if ((sig == bkt_sig) && (keycmp(key_get(t,
+				bkt_key_index), key, t->key_mask,
+				t->key_size) == 0)) {
+				data = data_get(t, bkt_key_index);
+
+				memcpy(data, entry, t->entry_size);
+				*key_found = 1;
+				*entry_ptr = (void *) data;
+				return 0;
+			}
+		}
+
+	/* Key is not present in the bucket: allocate new key */
+	if ((t->key_free == KEY_INDEX_INVALID) && (chunk_add(t) != 0))
+		return -ENOSPC;
+
+	bkt_key_index = t->key_free;
+	bkt_key = key_get(t, bkt_key_index);
+	t->key_free = *(uint32_t *)bkt_key;
+
+	/* Install new key */
+	data = data_get(t, bkt_key_index);
+	keycpy(bkt_key, key, t->key_mask, t->key_size);
+	memcpy(data, entry, t->entry_size);
+	bucket_append(t, bkt0, (uint16_t) sig, bkt_key_index);
+	t->n_keys++;
+
+	/* Grow the bucket array above 2 keys per bucket on average */
+	if ((t->buckets_new == NULL) &&
+		(t->n_keys > t->n_buckets * (KEYS_PER_BUCKET / 2)))
+		resize_start(t);
+
+	*key_found = 0;
+	*entry_ptr = (void *) data;
+	return 0;
+}
+
+static int
+rte_table_hash_resizable_entry_delete(void *table, void *key, int *key_found,
+	void *entry)
+{
+	struct rte_table_hash *t = table;
+	struct bucket *bkt0, *bkt;
+	uint64_t sig;
+	uint32_t i;
+
+	if (t->buckets_new != NULL)
+		resize_step(t);
+
+	sig = t->f_hash(key, t->key_mask, t->key_size, t->seed);
+	bkt0 = bucket_get(t, sig);
+	sig = (sig >> 16) | 1LLU;
+
+	/* Key is present in the bucket */
+	for (bkt = bkt0; bkt != NULL; bkt = BUCKET_NEXT(bkt))
+		for (i = 0; i < KEYS_PER_BUCKET; i++) {
+			uint64_t bkt_sig = (uint64_t) bkt->sig[i];
+			uint32_t bkt_key_index = bkt->key_pos[i];
+			uint8_t *bkt_key = key_get(t, bkt_key_index);
+			struct bucket *bkt_last, *bkt_last_prev;
+			uint32_t i_last;
+
+			if ((sig != bkt_sig) || (keycmp(bkt_key, key,
+				t->key_mask, t->key_size) != 0))
+				continue;
+
+			*key_found = 1;
+			if (entry)
+				memcpy(entry, data_get(t, bkt_key_index),
+					t->entry_size);
+
+			/* Free key */
+			*(uint32_t *)bkt_key = t->key_free;
+			t->key_free = bkt_key_index;
+			t->n_keys--;
+
+			/* Move the last key of the chain into its position */
+			for (bkt_last_prev = NULL, bkt_last = bkt;
+				BUCKET_NEXT(bkt_last) != NULL;
+				bkt_last_prev = bkt_last,
+				bkt_last = BUCKET_NEXT(bkt_last))
+				;
+
+			for (i_last = KEYS_PER_BUCKET - 1;
+				bkt_last->sig[i_last] == 0; i_last--)
+				;
+
+			bkt->sig[i] = bkt_last->sig[i_last];
+			bkt->key_pos[i] = bkt_last->key_pos[i_last];
+			bkt_last->sig[i_last] = 0;
+
+			/* Free the last bucket of the chain once unused */
+			if ((i_last == 0) && (bkt_last != bkt0)) {
+				if (bkt_last_prev == NULL)
+					bkt_last_prev = bkt0;
+				while (BUCKET_NEXT(bkt_last_prev) != bkt_last)
+					bkt_last_prev =
+						BUCKET_NEXT(bkt_last_prev);
+				BUCKET_NEXT_SET_NULL(bkt_last_prev);
+				bucket_ext_free(t, bkt_last);
+			}
+
+			return 0;
+		}
+
+	/* Key is not present in the bucket */
+	*key_found = 0;
+	return 0;
+}
+
+static int
+rte_table_hash_resizable_lookup(
+	void *table,
+	struct rte_mbuf **pkts,
+	uint64_t pkts_mask,
+	uint64_t *lookup_hit_mask,
+	void **entries)
+{
+	struct rte_table_hash *t = (struct rte_table_hash *) table;
+	struct bucket *bkts[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint16_t sigs[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint64_t pkts_mask_out = 0, mask;
+	__rte_unused uint32_t n_pkts_in = __builtin_popcountll(pkts_mask);
+
+	RTE_TABLE_HASH_RESIZABLE_STATS_PKTS_IN_ADD(t, n_pkts_in);
+
+	if (t->buckets_new != NULL)
+		resize_step(t);
+
+	/* Stage 0: compute the signatures and prefetch the buckets */
+	for (mask = pkts_mask; mask; ) {
+		uint32_t pkt_index = __builtin_ctzll(mask);
+		uint8_t *key;
+		uint64_t sig;
+
+		mask &= ~(1LLU << pkt_index);
+
+		key = RTE_MBUF_METADATA_UINT8_PTR(pkts[pkt_index],
+			t->key_offset);
+		sig = t->f_hash(key, t->key_mask, t->key_size, t->seed);
+
+		bkts[pkt_index] = bucket_get(t, sig);
+		sigs[pkt_index] = (uint16_t) ((sig >> 16) | 1LLU);
+		rte_prefetch0(bkts[pkt_index]);
+	}
+
+	/* Stage 1: search the bucket chains */
+	for (mask = pkts_mask; mask; ) {
+		uint32_t pkt_index = __builtin_ctzll(mask);
+		uint64_t pkt_mask = 1LLU << pkt_index;
+		struct bucket *bkt;
+		uint8_t *key;
+		uint32_t i;
+
+		mask &= ~pkt_mask;
+
+		key = RTE_MBUF_METADATA_UINT8_PTR(pkts[pkt_index],
+			t->key_offset);
+
+		for (bkt = bkts[pkt_index]; bkt != NULL;
+			bkt = BUCKET_NEXT(bkt)) {
+			for (i = 0; i < KEYS_PER_BUCKET; i++) {
+				uint32_t bkt_key_index = bkt->key_pos[i];
+
+				if ((sigs[pkt_index] == bkt->sig[i]) &&
+					(keycmp(key_get(t, bkt_key_index), key,
+					t->key_mask, t->key_size) == 0)) {
+					pkts_mask_out |= pkt_mask;
+					entries[pkt_index] = (void *)
+						data_get(t, bkt_key_index);
+					break;
+				}
+			}
+
+			if (pkts_mask_out & pkt_mask)
+				break;
+		}
+	}
+
+	*lookup_hit_mask = pkts_mask_out;
+	RTE_TABLE_HASH_RESIZABLE_STATS_PKTS_LOOKUP_MISS(t,
+		n_pkts_in - __builtin_popcountll(pkts_mask_out));
+	return 0;
+}
+
+static int
+rte_table_hash_resizable_stats_read(void *table,
+	struct rte_table_stats *stats, int clear)
+{
+	struct rte_table_hash *t = table;
+
+	if (stats != NULL)
+		memcpy(stats, &t->stats, sizeof(t->stats));
+
+	if (clear)
+		memset(&t->stats, 0, sizeof(t->stats));
+
+	return 0;
+}
+
+struct rte_table_ops rte_table_hash_resizable_ops = {
+	.f_create = rte_table_hash_resizable_create,
+	.f_free = rte_table_hash_resizable_free,
+	.f_add = rte_table_hash_resizable_entry_add,
+	.f_delete = rte_table_hash_resizable_entry_delete,
+	.f_add_bulk = NULL,
+	.f_delete_bulk = NULL,
+	.f_lookup = rte_table_hash_resizable_lookup,
+	.f_stats = rte_table_hash_resizable_stats_read,
+};
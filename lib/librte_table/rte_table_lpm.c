@@ -19,6 +19,9 @@
 #define RTE_TABLE_LPM_MAX_NEXT_HOPS                        65536
 #endif
 
+/* Lookup result of a miss, next hops being 24-bit values */
+#define RTE_TABLE_LPM_MISS                                 UINT32_MAX
+
 #ifdef RTE_TABLE_STATS_COLLECT
 
 #define RTE_TABLE_LPM_STATS_PKTS_IN_ADD(table, val) \
@@ -309,29 +312,49 @@ rte_table_lpm_lookup(
 {
 	struct rte_table_lpm *lpm = (struct rte_table_lpm *) table;
 	uint64_t pkts_out_mask = 0;
-	uint32_t i;
+	uint32_t ips[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t nht_pos[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint8_t pkt_idx[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t i, n_ips = 0;
 
 	__rte_unused uint32_t n_pkts_in = __builtin_popcountll(pkts_mask);
 	RTE_TABLE_LPM_STATS_PKTS_IN_ADD(lpm, n_pkts_in);
 
-	pkts_out_mask = 0;
 	for (i = 0; i < (uint32_t)(RTE_PORT_IN_BURST_SIZE_MAX -
 		__builtin_clzll(pkts_mask)); i++) {
 		uint64_t pkt_mask = 1LLU << i;
 
 		if (pkt_mask & pkts_mask) {
 			struct rte_mbuf *pkt = pkts[i];
-			uint32_t ip = rte_bswap32(
+
+			pkt_idx[n_ips] = i;
+			ips[n_ips++] = rte_bswap32(
 				RTE_MBUF_METADATA_UINT32(pkt, lpm->offset));
-			int status;
-			uint32_t nht_pos;
-
-			status = rte_lpm_lookup(lpm->lpm, ip, &nht_pos);
-			if (status == 0) {
-				pkts_out_mask |= pkt_mask;
-				entries[i] = (void *) &lpm->nht[nht_pos *
-					lpm->entry_size];
-			}
+		}
+	}
+
+	/* Look the addresses up by vectors, the rest one by one */
+	i = 0;
+#ifdef RTE_MACHINE_CPUFLAG_AVX512F
+	for ( ; i + 16 <= n_ips; i += 16)
+		rte_lpm_lookupx16(lpm->lpm, _mm512_loadu_si512(&ips[i]),
+			&nht_pos[i], RTE_TABLE_LPM_MISS);
+#endif
+#ifdef RTE_MACHINE_CPUFLAG_AVX2
+	for ( ; i + 8 <= n_ips; i += 8)
+		rte_lpm_lookupx8(lpm->lpm,
+			_mm256_loadu_si256((const __m256i *)&ips[i]),
+			&nht_pos[i], RTE_TABLE_LPM_MISS);
+#endif
+	for ( ; i < n_ips; i++)
+		if (rte_lpm_lookup(lpm->lpm, ips[i], &nht_pos[i]) != 0)
+			nht_pos[i] = RTE_TABLE_LPM_MISS;
+
+	for (i = 0; i < n_ips; i++) {
+		if (nht_pos[i] != RTE_TABLE_LPM_MISS) {
+			pkts_out_mask |= 1LLU << pkt_idx[i];
+			entries[pkt_idx[i]] = (void *) &lpm->nht[nht_pos[i] *
+				lpm->entry_size];
 		}
 	}
 
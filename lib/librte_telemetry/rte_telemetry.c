@@ -2,18 +2,29 @@
  * Copyright(c) 2018 Intel Corporation
  */
 
+#include <inttypes.h>
 #include <unistd.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <jansson.h>
 
+#include <rte_cycles.h>
 #include <rte_eal.h>
 #include <rte_ethdev.h>
+#include <rte_keepalive.h>
 #include <rte_metrics.h>
 #include <rte_option.h>
 #include <rte_string_fns.h>
+#ifdef RTE_LIBRTE_VHOST
+#include <rte_vhost.h>
+#include <rte_vdpa.h>
+#endif
+#ifdef RTE_LIBRTE_JOBSTATS
+#include <rte_jobstats.h>
+#endif
 
 #include "rte_telemetry.h"
 #include "rte_telemetry_internal.h"
@@ -22,14 +33,15 @@
 #include "rte_telemetry_socket_tests.h"
 
 #define BUF_SIZE 1024
-#define ACTION_POST 1
 #define SLEEP_TIME 10
+#define MS_PER_S 1000
 
 #define SELFTEST_VALID_CLIENT "/var/run/dpdk/valid_client"
 #define SELFTEST_INVALID_CLIENT "/var/run/dpdk/invalid_client"
 #define SOCKET_TEST_CLIENT_PATH "/var/run/dpdk/client"
 
 static telemetry_impl *static_telemetry;
+static struct rte_keepalive *telemetry_keepalive;
 
 struct telemetry_message_test {
 	char *test_name;
@@ -137,9 +149,9 @@ rte_telemetry_update_metrics_ethdev(struct telemetry_impl *telemetry,
 	return 0;
 }
 
-int32_t
-rte_telemetry_write_to_socket(struct telemetry_impl *telemetry,
-	const char *json_string)
+static int32_t
+rte_telemetry_write_buf_to_socket(struct telemetry_impl *telemetry,
+	const char *buf, size_t len)
 {
 	int ret;
 
@@ -153,13 +165,12 @@ rte_telemetry_write_to_socket(struct telemetry_impl *telemetry,
 		return -1;
 	}
 
-	if (json_string == NULL) {
-		TELEMETRY_LOG_ERR("Invalid JSON string!");
+	if (buf == NULL) {
+		TELEMETRY_LOG_ERR("Invalid buffer!");
 		return -1;
 	}
 
-	ret = send(telemetry->request_client->fd,
-			json_string, strlen(json_string), 0);
+	ret = send(telemetry->request_client->fd, buf, len, 0);
 	if (ret < 0) {
 		TELEMETRY_LOG_ERR("Failed to write to socket for client: %s",
 				telemetry->request_client->file_path);
@@ -169,6 +180,19 @@ rte_telemetry_write_to_socket(struct telemetry_impl *telemetry,
 	return 0;
 }
 
+int32_t
+rte_telemetry_write_to_socket(struct telemetry_impl *telemetry,
+	const char *json_string)
+{
+	if (json_string == NULL) {
+		TELEMETRY_LOG_ERR("Invalid JSON string!");
+		return -1;
+	}
+
+	return rte_telemetry_write_buf_to_socket(telemetry, json_string,
+			strlen(json_string));
+}
+
 int32_t
 rte_telemetry_send_error_response(struct telemetry_impl *telemetry,
 	int error_type)
@@ -221,60 +245,6 @@ rte_telemetry_send_error_response(struct telemetry_impl *telemetry,
 	return 0;
 }
 
-static int
-rte_telemetry_get_metrics(struct telemetry_impl *telemetry, uint32_t port_id,
-	struct rte_metric_value *metrics, struct rte_metric_name *names,
-	int num_metrics)
-{
-	int ret, num_values;
-
-	if (num_metrics < 0) {
-		TELEMETRY_LOG_ERR("Invalid metrics count");
-		goto einval_fail;
-	} else if (num_metrics == 0) {
-		TELEMETRY_LOG_ERR("No metrics to display (none have been registered)");
-		goto eperm_fail;
-	}
-
-	if (metrics == NULL) {
-		TELEMETRY_LOG_ERR("Metrics must be initialised.");
-		goto einval_fail;
-	}
-
-	if (names == NULL) {
-		TELEMETRY_LOG_ERR("Names must be initialised.");
-		goto einval_fail;
-	}
-
-	ret = rte_metrics_get_names(names, num_metrics);
-	if (ret < 0 || ret > num_metrics) {
-		TELEMETRY_LOG_ERR("Cannot get metrics names");
-		goto eperm_fail;
-	}
-
-	num_values = rte_metrics_get_values(port_id, NULL, 0);
-	ret = rte_metrics_get_values(port_id, metrics, num_values);
-	if (ret < 0 || ret > num_values) {
-		TELEMETRY_LOG_ERR("Cannot get metrics values");
-		goto eperm_fail;
-	}
-
-	return 0;
-
-eperm_fail:
-	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
-	if (ret < 0)
-		TELEMETRY_LOG_ERR("Could not send error");
-	return -1;
-
-einval_fail:
-	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
-	if (ret < 0)
-		TELEMETRY_LOG_ERR("Could not send error");
-	return -1;
-
-}
-
 static int32_t
 rte_telemetry_json_format_stat(struct telemetry_impl *telemetry, json_t *stats,
 	const char *metric_name, uint64_t metric_value)
@@ -315,47 +285,19 @@ rte_telemetry_json_format_stat(struct telemetry_impl *telemetry, json_t *stats,
 
 }
 
+/*
+ * Format the stats of a port whose value differs from the previous one,
+ * or all of them if prev_values is NULL.
+ */
 static int32_t
 rte_telemetry_json_format_port(struct telemetry_impl *telemetry,
 	uint32_t port_id, json_t *ports, uint32_t *metric_ids,
-	uint32_t num_metric_ids)
+	uint32_t num_metric_ids, struct rte_metric_name *names,
+	const uint64_t *values, const uint64_t *prev_values)
 {
-	struct rte_metric_value *metrics = 0;
-	struct rte_metric_name *names = 0;
-	int num_metrics, ret, err_ret;
 	json_t *port, *stats;
 	uint32_t i;
-
-	num_metrics = rte_metrics_get_names(NULL, 0);
-	if (num_metrics < 0) {
-		TELEMETRY_LOG_ERR("Cannot get metrics count");
-		goto einval_fail;
-	} else if (num_metrics == 0) {
-		TELEMETRY_LOG_ERR("No metrics to display (none have been registered)");
-		goto eperm_fail;
-	}
-
-	metrics = malloc(sizeof(struct rte_metric_value) * num_metrics);
-	names = malloc(sizeof(struct rte_metric_name) * num_metrics);
-	if (metrics == NULL || names == NULL) {
-		TELEMETRY_LOG_ERR("Cannot allocate memory");
-		free(metrics);
-		free(names);
-
-		err_ret = rte_telemetry_send_error_response(telemetry, -ENOMEM);
-		if (err_ret < 0)
-			TELEMETRY_LOG_ERR("Could not send error");
-		return -1;
-	}
-
-	ret  = rte_telemetry_get_metrics(telemetry, port_id, metrics, names,
-		num_metrics);
-	if (ret < 0) {
-		free(metrics);
-		free(names);
-		TELEMETRY_LOG_ERR("rte_telemetry_get_metrics failed");
-		return -1;
-	}
+	int ret;
 
 	port = json_object();
 	stats = json_array();
@@ -371,48 +313,22 @@ rte_telemetry_json_format_port(struct telemetry_impl *telemetry,
 	}
 
 	for (i = 0; i < num_metric_ids; i++) {
-		int metric_id = metric_ids[i];
-		int metric_index = -1;
-		int metric_name_key = -1;
-		int32_t j;
-		uint64_t metric_value;
-
-		if (metric_id >= num_metrics) {
-			TELEMETRY_LOG_ERR("Metric_id: %d is not valid",
-					metric_id);
-			goto einval_fail;
-		}
-
-		for (j = 0; j < num_metrics; j++) {
-			if (metrics[j].key == metric_id) {
-				metric_name_key = metrics[j].key;
-				metric_index = j;
-				break;
-			}
-		}
-
-		const char *metric_name = names[metric_name_key].name;
-		metric_value = metrics[metric_index].value;
-
-		if (metric_name_key < 0 || metric_index < 0) {
-			TELEMETRY_LOG_ERR("Could not get metric name/index");
-			goto eperm_fail;
-		}
+		if (prev_values != NULL && values[i] == prev_values[i])
+			continue;
 
 		ret = rte_telemetry_json_format_stat(telemetry, stats,
-			metric_name, metric_value);
+			names[metric_ids[i]].name, values[i]);
 		if (ret < 0) {
 			TELEMETRY_LOG_ERR("Format stat with id: %u failed",
-					metric_id);
-			free(metrics);
-			free(names);
+					metric_ids[i]);
 			return -1;
 		}
 	}
 
-	if (json_array_size(stats) == 0)
+	if (json_array_size(stats) == 0) {
+		json_decref(stats);
 		ret = json_object_set_new(port, "stats", json_null());
-	else
+	} else
 		ret = json_object_set_new(port, "stats", stats);
 
 	if (ret < 0) {
@@ -426,66 +342,73 @@ rte_telemetry_json_format_port(struct telemetry_impl *telemetry,
 		goto eperm_fail;
 	}
 
-	free(metrics);
-	free(names);
 	return 0;
 
 eperm_fail:
-	free(metrics);
-	free(names);
 	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
 	if (ret < 0)
 		TELEMETRY_LOG_ERR("Could not send error");
 	return -1;
-
-einval_fail:
-	free(metrics);
-	free(names);
-	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
-	if (ret < 0)
-		TELEMETRY_LOG_ERR("Could not send error");
-	return -1;
 }
 
 static int32_t
 rte_telemetry_encode_json_format(struct telemetry_impl *telemetry,
 	uint32_t *port_ids, uint32_t num_port_ids, uint32_t *metric_ids,
-	uint32_t num_metric_ids, char **json_buffer)
+	uint32_t num_metric_ids, const uint64_t *values,
+	const uint64_t *prev_values, char **json_buffer)
 {
-	int ret;
+	struct rte_metric_name *names;
+	int num_metrics, ret;
 	json_t *root, *ports;
 	uint32_t i;
 
-	if (num_port_ids <= 0 || num_metric_ids <= 0) {
-		TELEMETRY_LOG_ERR("Please provide port and metric ids to query");
-		goto einval_fail;
+	num_metrics = rte_metrics_get_names(NULL, 0);
+	if (num_metrics <= 0) {
+		TELEMETRY_LOG_ERR("Cannot get metrics count");
+		goto eperm_fail;
+	}
+
+	names = malloc(sizeof(struct rte_metric_name) * num_metrics);
+	if (names == NULL) {
+		TELEMETRY_LOG_ERR("Cannot allocate memory");
+		ret = rte_telemetry_send_error_response(telemetry, -ENOMEM);
+		if (ret < 0)
+			TELEMETRY_LOG_ERR("Could not send error");
+		return -1;
+	}
+
+	ret = rte_metrics_get_names(names, num_metrics);
+	if (ret < 0 || ret > num_metrics) {
+		TELEMETRY_LOG_ERR("Cannot get metrics names");
+		free(names);
+		goto eperm_fail;
 	}
 
 	ports = json_array();
 	if (ports == NULL) {
 		TELEMETRY_LOG_ERR("Could not create ports JSON array");
+		free(names);
 		goto eperm_fail;
 	}
 
-	for (i = 0; i < num_port_ids; i++) {
-		if (!rte_eth_dev_is_valid_port(port_ids[i])) {
-			TELEMETRY_LOG_ERR("Port: %d invalid", port_ids[i]);
-			goto einval_fail;
-		}
-	}
-
 	for (i = 0; i < num_port_ids; i++) {
 		ret = rte_telemetry_json_format_port(telemetry, port_ids[i],
-			ports, metric_ids, num_metric_ids);
+			ports, metric_ids, num_metric_ids, names,
+			&values[i * num_metric_ids], prev_values == NULL ?
+			NULL : &prev_values[i * num_metric_ids]);
 		if (ret < 0) {
 			TELEMETRY_LOG_ERR("Format port in JSON failed");
+			json_decref(ports);
+			free(names);
 			return -1;
 		}
 	}
+	free(names);
 
 	root = json_object();
 	if (root == NULL) {
 		TELEMETRY_LOG_ERR("Could not create root JSON object");
+		json_decref(ports);
 		goto eperm_fail;
 	}
 
@@ -493,12 +416,15 @@ rte_telemetry_encode_json_format(struct telemetry_impl *telemetry,
 		json_string("Status OK: 200"));
 	if (ret < 0) {
 		TELEMETRY_LOG_ERR("Status code field cannot be set");
+		json_decref(ports);
+		json_decref(root);
 		goto eperm_fail;
 	}
 
 	ret = json_object_set_new(root, "data", ports);
 	if (ret < 0) {
 		TELEMETRY_LOG_ERR("Data field cannot be set");
+		json_decref(root);
 		goto eperm_fail;
 	}
 
@@ -511,20 +437,185 @@ rte_telemetry_encode_json_format(struct telemetry_impl *telemetry,
 	if (ret < 0)
 		TELEMETRY_LOG_ERR("Could not send error");
 	return -1;
+}
 
-einval_fail:
-	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+/*
+ * Encode the stats whose value differs from the previous one, or all of
+ * them if prev_values is NULL, as a struct rte_telemetry_bin_hdr followed
+ * by a struct rte_telemetry_bin_stat per stat.
+ */
+static int32_t
+rte_telemetry_encode_binary_format(struct telemetry_impl *telemetry,
+	uint32_t num_port_ids, uint32_t *port_ids, uint32_t num_metric_ids,
+	const uint64_t *values, const uint64_t *prev_values, char **buffer,
+	size_t *len)
+{
+	struct rte_telemetry_bin_hdr *hdr;
+	struct rte_telemetry_bin_stat *stat;
+	uint32_t i, j, num_stats = 0;
+	int ret;
+
+	*buffer = malloc(sizeof(*hdr) +
+		sizeof(*stat) * num_port_ids * num_metric_ids);
+	if (*buffer == NULL) {
+		TELEMETRY_LOG_ERR("Cannot allocate memory");
+		ret = rte_telemetry_send_error_response(telemetry, -ENOMEM);
+		if (ret < 0)
+			TELEMETRY_LOG_ERR("Could not send error");
+		return -1;
+	}
+
+	hdr = (struct rte_telemetry_bin_hdr *)*buffer;
+	stat = (struct rte_telemetry_bin_stat *)(hdr + 1);
+	for (i = 0; i < num_port_ids; i++) {
+		for (j = 0; j < num_metric_ids; j++) {
+			uint32_t idx = i * num_metric_ids + j;
+
+			if (prev_values != NULL &&
+					values[idx] == prev_values[idx])
+				continue;
+			stat->port_id = port_ids[i];
+			stat->stat_index = j;
+			stat->reserved = 0;
+			stat->value = values[idx];
+			stat++;
+			num_stats++;
+		}
+	}
+
+	hdr->magic = RTE_TELEMETRY_BIN_MAGIC;
+	hdr->version = RTE_TELEMETRY_BIN_VERSION;
+	hdr->flags = prev_values != NULL ? RTE_TELEMETRY_BIN_F_DELTA : 0;
+	hdr->num_stats = num_stats;
+	hdr->reserved = 0;
+	*len = sizeof(*hdr) + sizeof(*stat) * num_stats;
+
+	return 0;
+}
+
+/*
+ * Read the values of the stats of the ports into a table of num_port_ids
+ * rows of num_metric_ids values, in the order of the ids.
+ */
+static int32_t
+rte_telemetry_get_ports_stats_values(struct telemetry_impl *telemetry,
+	uint32_t *metric_ids, uint32_t num_metric_ids, uint32_t *port_ids,
+	uint32_t num_port_ids, uint64_t *values)
+{
+	struct rte_metric_value *metrics;
+	int num_metrics, ret;
+	uint32_t i, j;
+
+	num_metrics = rte_metrics_get_values(RTE_METRICS_GLOBAL, NULL, 0);
+	if (num_metrics <= 0) {
+		TELEMETRY_LOG_ERR("No metrics to display (none have been registered)");
+		goto eperm_fail;
+	}
+
+	for (j = 0; j < num_metric_ids; j++) {
+		if (metric_ids[j] >= (uint32_t)num_metrics) {
+			TELEMETRY_LOG_ERR("Metric_id: %u is not valid",
+					metric_ids[j]);
+			ret = rte_telemetry_send_error_response(telemetry,
+				-EINVAL);
+			if (ret < 0)
+				TELEMETRY_LOG_ERR("Could not send error");
+			return -1;
+		}
+	}
+
+	metrics = malloc(sizeof(struct rte_metric_value) * num_metrics);
+	if (metrics == NULL) {
+		TELEMETRY_LOG_ERR("Cannot allocate memory");
+		ret = rte_telemetry_send_error_response(telemetry, -ENOMEM);
+		if (ret < 0)
+			TELEMETRY_LOG_ERR("Could not send error");
+		return -1;
+	}
+
+	for (i = 0; i < num_port_ids; i++) {
+		ret = rte_telemetry_update_metrics_ethdev(telemetry,
+				port_ids[i], telemetry->reg_index);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Failed to update ethdev metrics");
+			free(metrics);
+			return -1;
+		}
+
+		/* The values are indexed by their metric key */
+		ret = rte_metrics_get_values(port_ids[i], metrics,
+			num_metrics);
+		if (ret < 0 || ret > num_metrics) {
+			TELEMETRY_LOG_ERR("Cannot get metrics values");
+			free(metrics);
+			goto eperm_fail;
+		}
+
+		for (j = 0; j < num_metric_ids; j++)
+			values[i * num_metric_ids + j] =
+				metrics[metric_ids[j]].value;
+	}
+
+	free(metrics);
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
 	if (ret < 0)
 		TELEMETRY_LOG_ERR("Could not send error");
 	return -1;
 }
 
+/*
+ * Send the values of the stats in the format, only sending the values
+ * which differ from prev_values if not NULL.
+ */
+static int32_t
+rte_telemetry_send_stats_values(struct telemetry_impl *telemetry,
+	uint32_t *metric_ids, uint32_t num_metric_ids, uint32_t *port_ids,
+	uint32_t num_port_ids, const uint64_t *values,
+	const uint64_t *prev_values, int format)
+{
+	char *buffer = NULL;
+	size_t len;
+	int ret;
+
+	if (format == TELEMETRY_FORMAT_BINARY) {
+		ret = rte_telemetry_encode_binary_format(telemetry,
+			num_port_ids, port_ids, num_metric_ids, values,
+			prev_values, &buffer, &len);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Binary encode function failed");
+			return -1;
+		}
+	} else {
+		ret = rte_telemetry_encode_json_format(telemetry, port_ids,
+			num_port_ids, metric_ids, num_metric_ids, values,
+			prev_values, &buffer);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("JSON encode function failed");
+			return -1;
+		}
+		len = buffer == NULL ? 0 : strlen(buffer);
+	}
+
+	ret = rte_telemetry_write_buf_to_socket(telemetry, buffer, len);
+	free(buffer);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Could not write to socket");
+		return -1;
+	}
+
+	return 0;
+}
+
 int32_t
 rte_telemetry_send_ports_stats_values(uint32_t *metric_ids, int num_metric_ids,
-	uint32_t *port_ids, int num_port_ids, struct telemetry_impl *telemetry)
+	uint32_t *port_ids, int num_port_ids, int format,
+	struct telemetry_impl *telemetry)
 {
 	int ret, i;
-	char *json_buffer = NULL;
+	uint64_t *values;
 
 	if (telemetry == NULL) {
 		TELEMETRY_LOG_ERR("Invalid telemetry argument");
@@ -536,7 +627,7 @@ rte_telemetry_send_ports_stats_values(uint32_t *metric_ids, int num_metric_ids,
 		goto einval_fail;
 	}
 
-	if (num_metric_ids < 0) {
+	if (num_metric_ids <= 0) {
 		TELEMETRY_LOG_ERR("Invalid num_metric_ids, must be positive");
 		goto einval_fail;
 	}
@@ -546,7 +637,7 @@ rte_telemetry_send_ports_stats_values(uint32_t *metric_ids, int num_metric_ids,
 		goto einval_fail;
 	}
 
-	if (num_port_ids < 0) {
+	if (num_port_ids <= 0) {
 		TELEMETRY_LOG_ERR("Invalid num_port_ids, must be positive");
 		goto einval_fail;
 	}
@@ -556,29 +647,26 @@ rte_telemetry_send_ports_stats_values(uint32_t *metric_ids, int num_metric_ids,
 			TELEMETRY_LOG_ERR("Port: %d invalid", port_ids[i]);
 			goto einval_fail;
 		}
-
-		ret = rte_telemetry_update_metrics_ethdev(telemetry,
-				port_ids[i], telemetry->reg_index);
-		if (ret < 0) {
-			TELEMETRY_LOG_ERR("Failed to update ethdev metrics");
-			return -1;
-		}
 	}
 
-	ret = rte_telemetry_encode_json_format(telemetry, port_ids,
-		num_port_ids, metric_ids, num_metric_ids, &json_buffer);
-	if (ret < 0) {
-		TELEMETRY_LOG_ERR("JSON encode function failed");
+	values = malloc(sizeof(uint64_t) * num_port_ids * num_metric_ids);
+	if (values == NULL) {
+		TELEMETRY_LOG_ERR("Cannot allocate memory");
+		ret = rte_telemetry_send_error_response(telemetry, -ENOMEM);
+		if (ret < 0)
+			TELEMETRY_LOG_ERR("Could not send error");
 		return -1;
 	}
 
-	ret = rte_telemetry_write_to_socket(telemetry, json_buffer);
-	if (ret < 0) {
-		TELEMETRY_LOG_ERR("Could not write to socket");
-		return -1;
-	}
+	ret = rte_telemetry_get_ports_stats_values(telemetry, metric_ids,
+		num_metric_ids, port_ids, num_port_ids, values);
+	if (ret == 0)
+		ret = rte_telemetry_send_stats_values(telemetry, metric_ids,
+			num_metric_ids, port_ids, num_port_ids, values, NULL,
+			format);
+	free(values);
 
-	return 0;
+	return ret;
 
 einval_fail:
 	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
@@ -587,17 +675,169 @@ rte_telemetry_send_ports_stats_values(uint32_t *metric_ids, int num_metric_ids,
 	return -1;
 }
 
+static void
+rte_telemetry_subscription_free(struct telemetry_subscription *sub)
+{
+	if (sub == NULL)
+		return;
+
+	free(sub->port_ids);
+	free(sub->metric_ids);
+	free(sub->values);
+	free(sub->prev_values);
+	free(sub);
+}
 
-static int32_t
-rte_telemetry_reg_ethdev_to_metrics(uint16_t port_id)
+int32_t
+rte_telemetry_subscribe(struct telemetry_impl *telemetry, uint32_t *metric_ids,
+	int num_metric_ids, uint32_t *port_ids, int num_port_ids,
+	uint32_t interval_ms, int format)
 {
-	int ret, num_xstats, ret_val, i;
-	struct rte_eth_xstat *eth_xstats = NULL;
-	struct rte_eth_xstat_name *eth_xstats_names = NULL;
+	struct telemetry_subscription *sub;
+	size_t num_values;
+	int ret, i;
 
-	if (!rte_eth_dev_is_valid_port(port_id)) {
-		TELEMETRY_LOG_ERR("port_id: %d is invalid", port_id);
-		return -EINVAL;
+	if (telemetry == NULL || telemetry->request_client == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	if (metric_ids == NULL || num_metric_ids <= 0 || port_ids == NULL ||
+			num_port_ids <= 0 || interval_ms == 0) {
+		TELEMETRY_LOG_ERR("Invalid subscription arguments");
+		goto einval_fail;
+	}
+
+	for (i = 0; i < num_port_ids; i++) {
+		if (!rte_eth_dev_is_valid_port(port_ids[i])) {
+			TELEMETRY_LOG_ERR("Port: %d invalid", port_ids[i]);
+			goto einval_fail;
+		}
+	}
+
+	num_values = (size_t)num_port_ids * num_metric_ids;
+	sub = calloc(1, sizeof(*sub));
+	if (sub != NULL) {
+		sub->port_ids = malloc(sizeof(uint32_t) * num_port_ids);
+		sub->metric_ids = malloc(sizeof(uint32_t) * num_metric_ids);
+		sub->values = malloc(sizeof(uint64_t) * num_values);
+		sub->prev_values = malloc(sizeof(uint64_t) * num_values);
+	}
+	if (sub == NULL || sub->port_ids == NULL || sub->metric_ids == NULL ||
+			sub->values == NULL || sub->prev_values == NULL) {
+		TELEMETRY_LOG_ERR("Cannot allocate memory");
+		rte_telemetry_subscription_free(sub);
+		ret = rte_telemetry_send_error_response(telemetry, -ENOMEM);
+		if (ret < 0)
+			TELEMETRY_LOG_ERR("Could not send error");
+		return -1;
+	}
+
+	memcpy(sub->port_ids, port_ids, sizeof(uint32_t) * num_port_ids);
+	memcpy(sub->metric_ids, metric_ids, sizeof(uint32_t) * num_metric_ids);
+	sub->num_port_ids = num_port_ids;
+	sub->num_metric_ids = num_metric_ids;
+	sub->interval = rte_get_timer_hz() * interval_ms / MS_PER_S;
+	sub->next_tsc = rte_get_timer_cycles();
+	sub->format = format;
+
+	/* A new subscription starts with the values of all the stats */
+	rte_telemetry_subscription_free(telemetry->request_client->subscription);
+	telemetry->request_client->subscription = sub;
+
+	return 0;
+
+einval_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+int32_t
+rte_telemetry_unsubscribe(struct telemetry_impl *telemetry)
+{
+	int ret;
+
+	if (telemetry == NULL || telemetry->request_client == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	if (telemetry->request_client->subscription == NULL) {
+		TELEMETRY_LOG_WARN("Client has no subscription");
+		ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+		if (ret < 0)
+			TELEMETRY_LOG_ERR("Could not send error");
+		return -1;
+	}
+
+	rte_telemetry_subscription_free(telemetry->request_client->subscription);
+	telemetry->request_client->subscription = NULL;
+
+	return 0;
+}
+
+/*
+ * Push to the subscribed clients the stats which changed since the
+ * previous push, once per interval of their subscription.
+ */
+static int32_t
+rte_telemetry_push_subscriptions(struct telemetry_impl *telemetry)
+{
+	struct telemetry_subscription *sub;
+	telemetry_client *client;
+	uint64_t now, *tmp;
+	int ret, err = 0;
+
+	now = rte_get_timer_cycles();
+	TAILQ_FOREACH(client, &telemetry->client_list_head, client_list) {
+		sub = client->subscription;
+		if (sub == NULL || now < sub->next_tsc)
+			continue;
+
+		sub->next_tsc += sub->interval;
+		if (sub->next_tsc < now)
+			sub->next_tsc = now + sub->interval;
+
+		telemetry->request_client = client;
+		ret = rte_telemetry_get_ports_stats_values(telemetry,
+			sub->metric_ids, sub->num_metric_ids, sub->port_ids,
+			sub->num_port_ids, sub->values);
+		if (ret < 0) {
+			err = -1;
+			continue;
+		}
+
+		ret = rte_telemetry_send_stats_values(telemetry,
+			sub->metric_ids, sub->num_metric_ids, sub->port_ids,
+			sub->num_port_ids, sub->values,
+			sub->pushed ? sub->prev_values : NULL, sub->format);
+		if (ret < 0) {
+			err = -1;
+			continue;
+		}
+
+		tmp = sub->prev_values;
+		sub->prev_values = sub->values;
+		sub->values = tmp;
+		sub->pushed = 1;
+	}
+
+	return err;
+}
+
+
+static int32_t
+rte_telemetry_reg_ethdev_to_metrics(uint16_t port_id)
+{
+	int ret, num_xstats, ret_val, i;
+	struct rte_eth_xstat *eth_xstats = NULL;
+	struct rte_eth_xstat_name *eth_xstats_names = NULL;
+
+	if (!rte_eth_dev_is_valid_port(port_id)) {
+		TELEMETRY_LOG_ERR("port_id: %d is invalid", port_id);
+		return -EINVAL;
 	}
 
 	num_xstats = rte_eth_xstats_get(port_id, NULL, 0);
@@ -655,6 +895,706 @@ rte_telemetry_reg_ethdev_to_metrics(uint16_t port_id)
 	return ret_val;
 }
 
+#ifdef RTE_LIBRTE_VHOST
+/*
+ * Append the bucket counts of a struct rte_vhost_vring_stats histogram,
+ * named "<prefix>_le_<upper bound>" and "<prefix>_gt_<last bound>".
+ */
+static int32_t
+rte_telemetry_json_format_hist(struct telemetry_impl *telemetry,
+	json_t *stats, const char *prefix, const uint64_t *hist)
+{
+	char name[RTE_METRICS_MAX_NAME_LEN];
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < RTE_VHOST_STATS_HIST_NR; i++) {
+		if (i < RTE_VHOST_STATS_HIST_NR - 1)
+			snprintf(name, sizeof(name), "%s_le_%u", prefix,
+				1U << i);
+		else
+			snprintf(name, sizeof(name), "%s_gt_%u", prefix,
+				1U << (i - 1));
+
+		ret = rte_telemetry_json_format_stat(telemetry, stats, name,
+			hist[i]);
+		if (ret < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int32_t
+rte_telemetry_json_format_vring(struct telemetry_impl *telemetry, int vid,
+	uint16_t vring_idx, json_t *vrings)
+{
+	struct rte_vhost_vring_stats vs;
+	json_t *vring, *stats;
+	uint32_t i;
+	int ret;
+
+	ret = rte_vhost_vring_stats_get(vid, vring_idx, &vs);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Cannot get stats of vring %u of vid %d",
+				vring_idx, vid);
+		goto eperm_fail;
+	}
+
+	const struct {
+		const char *name;
+		uint64_t value;
+	} values[] = {
+		{ "packets", vs.packets },
+		{ "bytes", vs.bytes },
+		{ "empty_polls", vs.empty_polls },
+		{ "guest_notifications", vs.guest_notifications },
+		{ "iotlb_misses", vs.iotlb_misses },
+		{ "zcopy_fallbacks", vs.zcopy_fallbacks },
+		{ "batch_copy_bytes", vs.batch_copy_bytes },
+		{ "direct_copy_bytes", vs.direct_copy_bytes },
+		{ "dirty_pages", vs.dirty_pages },
+	};
+
+	vring = json_object();
+	stats = json_array();
+	if (vring == NULL || stats == NULL) {
+		TELEMETRY_LOG_ERR("Could not create vring/stats JSON objects");
+		goto eperm_fail;
+	}
+
+	ret = json_object_set_new(vring, "vring", json_integer(vring_idx));
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Vring field cannot be set");
+		goto eperm_fail;
+	}
+
+	for (i = 0; i < RTE_DIM(values); i++) {
+		ret = rte_telemetry_json_format_stat(telemetry, stats,
+			values[i].name, values[i].value);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format stat %s failed",
+					values[i].name);
+			return -1;
+		}
+	}
+
+	if (rte_telemetry_json_format_hist(telemetry, stats, "burst",
+				vs.burst_hist) < 0 ||
+			rte_telemetry_json_format_hist(telemetry, stats,
+				"chain", vs.chain_hist) < 0) {
+		TELEMETRY_LOG_ERR("Format histograms failed");
+		return -1;
+	}
+
+	ret = json_object_set_new(vring, "stats", stats);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Stats object cannot be set");
+		goto eperm_fail;
+	}
+
+	ret = json_array_append_new(vrings, vring);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Vring object cannot be added to vrings array");
+		goto eperm_fail;
+	}
+
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+static int32_t
+rte_telemetry_json_format_vhost_dev(struct telemetry_impl *telemetry, int vid,
+	json_t *devs)
+{
+	char ifname[PATH_MAX];
+	uint64_t features;
+	json_t *dev, *vrings;
+	uint16_t nr_vring, i;
+	int ret;
+
+	/* The device may have gone away since it was found. */
+	if (rte_vhost_get_ifname(vid, ifname, sizeof(ifname)) < 0 ||
+			rte_vhost_get_negotiated_features(vid, &features) < 0)
+		return 0;
+	nr_vring = rte_vhost_get_vring_num(vid);
+
+	dev = json_object();
+	vrings = json_array();
+	if (dev == NULL || vrings == NULL) {
+		TELEMETRY_LOG_ERR("Could not create device/vrings JSON objects");
+		goto eperm_fail;
+	}
+
+	if (json_object_set_new(dev, "vid", json_integer(vid)) < 0 ||
+			json_object_set_new(dev, "ifname",
+				json_string(ifname)) < 0 ||
+			json_object_set_new(dev, "numa_node",
+				json_integer(rte_vhost_get_numa_node(vid))) < 0 ||
+			json_object_set_new(dev, "features",
+				json_integer(features)) < 0 ||
+			json_object_set_new(dev, "vring_num",
+				json_integer(nr_vring)) < 0 ||
+			json_object_set_new(dev, "vdpa_device",
+				json_integer(rte_vhost_get_vdpa_device_id(vid)))
+				< 0) {
+		TELEMETRY_LOG_ERR("Device fields cannot be set");
+		goto eperm_fail;
+	}
+
+	for (i = 0; i < nr_vring; i++) {
+		ret = rte_telemetry_json_format_vring(telemetry, vid, i,
+			vrings);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format vring %u in JSON failed", i);
+			return -1;
+		}
+	}
+
+	ret = json_object_set_new(dev, "vrings", vrings);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Vrings object cannot be set");
+		goto eperm_fail;
+	}
+
+	ret = json_array_append_new(devs, dev);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Device object cannot be added to vhost array");
+		goto eperm_fail;
+	}
+
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+static int32_t
+rte_telemetry_json_format_vdpa_dev(struct telemetry_impl *telemetry, int did,
+	json_t *devs)
+{
+	struct rte_vdpa_device *vdpa_dev = rte_vdpa_get_device(did);
+	struct rte_pci_addr *pci_addr;
+	struct rte_vdpa_stats vs;
+	char addr[PCI_PRI_STR_SIZE];
+	uint32_t queue_num = 0;
+	uint64_t features = 0;
+	json_t *dev, *vrings, *vring;
+	uint32_t i;
+	int ret;
+
+	if (vdpa_dev == NULL)
+		return 0;
+
+	pci_addr = &vdpa_dev->addr.pci_addr;
+	snprintf(addr, sizeof(addr), PCI_PRI_FMT, pci_addr->domain,
+		pci_addr->bus, pci_addr->devid, pci_addr->function);
+	if (vdpa_dev->ops->get_queue_num != NULL)
+		vdpa_dev->ops->get_queue_num(did, &queue_num);
+	if (vdpa_dev->ops->get_features != NULL)
+		vdpa_dev->ops->get_features(did, &features);
+
+	dev = json_object();
+	vrings = json_array();
+	if (dev == NULL || vrings == NULL) {
+		TELEMETRY_LOG_ERR("Could not create device/vrings JSON objects");
+		goto eperm_fail;
+	}
+
+	if (json_object_set_new(dev, "did", json_integer(did)) < 0 ||
+			json_object_set_new(dev, "addr",
+				json_string(addr)) < 0 ||
+			json_object_set_new(dev, "features",
+				json_integer(features)) < 0 ||
+			json_object_set_new(dev, "queue_pairs",
+				json_integer(queue_num)) < 0) {
+		TELEMETRY_LOG_ERR("Device fields cannot be set");
+		goto eperm_fail;
+	}
+
+	for (i = 0; i < queue_num * 2; i++) {
+		ret = rte_vdpa_get_stats(did, i, &vs);
+		if (ret == -ENOTSUP)
+			break;
+		if (ret < 0)
+			continue;
+
+		vring = json_object();
+		if (vring == NULL ||
+				json_object_set_new(vring, "vring",
+					json_integer(i)) < 0 ||
+				json_object_set_new(vring, "packets",
+					json_integer(vs.packets)) < 0 ||
+				json_object_set_new(vring, "bytes",
+					json_integer(vs.bytes)) < 0 ||
+				json_object_set_new(vring, "errors",
+					json_integer(vs.errors)) < 0 ||
+				json_object_set_new(vring, "kicks",
+					json_integer(vs.kicks)) < 0 ||
+				json_array_append_new(vrings, vring) < 0) {
+			TELEMETRY_LOG_ERR("Vring object cannot be set");
+			goto eperm_fail;
+		}
+	}
+
+	ret = json_object_set_new(dev, "vrings", vrings);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Vrings object cannot be set");
+		goto eperm_fail;
+	}
+
+	ret = json_array_append_new(devs, dev);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Device object cannot be added to vdpa array");
+		goto eperm_fail;
+	}
+
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+int32_t
+rte_telemetry_send_vhost_values(struct telemetry_impl *telemetry)
+{
+	json_t *root, *data, *vhost_devs, *vdpa_devs;
+	char *json_buffer;
+	int id, ret;
+
+	if (telemetry == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	vhost_devs = json_array();
+	vdpa_devs = json_array();
+	if (vhost_devs == NULL || vdpa_devs == NULL) {
+		TELEMETRY_LOG_ERR("Could not create vhost/vdpa JSON arrays");
+		goto eperm_fail;
+	}
+
+	/*
+	 * Only lock free getters are used, the datapath of the devices is
+	 * never stalled by a scrape.
+	 */
+	for (id = rte_vhost_find_next(0); id >= 0;
+			id = rte_vhost_find_next(id + 1)) {
+		ret = rte_telemetry_json_format_vhost_dev(telemetry, id,
+			vhost_devs);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format vhost device in JSON failed");
+			return -1;
+		}
+	}
+
+	for (id = rte_vdpa_find_next(0); id >= 0;
+			id = rte_vdpa_find_next(id + 1)) {
+		ret = rte_telemetry_json_format_vdpa_dev(telemetry, id,
+			vdpa_devs);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format vdpa device in JSON failed");
+			return -1;
+		}
+	}
+
+	data = json_object();
+	root = json_object();
+	if (data == NULL || root == NULL) {
+		TELEMETRY_LOG_ERR("Could not create root/data JSON objects");
+		goto eperm_fail;
+	}
+
+	if (json_object_set_new(data, "vhost", vhost_devs) < 0 ||
+			json_object_set_new(data, "vdpa", vdpa_devs) < 0) {
+		TELEMETRY_LOG_ERR("Device arrays cannot be set");
+		goto eperm_fail;
+	}
+
+	ret = json_object_set_new(root, "status_code",
+		json_string("Status OK: 200"));
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Status code field cannot be set");
+		goto eperm_fail;
+	}
+
+	ret = json_object_set_new(root, "data", data);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Data field cannot be set");
+		goto eperm_fail;
+	}
+
+	json_buffer = json_dumps(root, JSON_INDENT(2));
+	json_decref(root);
+
+	ret = rte_telemetry_write_to_socket(telemetry, json_buffer);
+	free(json_buffer);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Could not write to socket");
+		return -1;
+	}
+
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+#endif
+
+/* Send a "Status OK: 200" response holding data, which is released */
+static int32_t
+rte_telemetry_send_data(struct telemetry_impl *telemetry, json_t *data)
+{
+	char *json_buffer;
+	json_t *root;
+	int ret;
+
+	root = json_object();
+	if (root == NULL) {
+		TELEMETRY_LOG_ERR("Could not create root JSON object");
+		json_decref(data);
+		goto eperm_fail;
+	}
+
+	ret = json_object_set_new(root, "status_code",
+		json_string("Status OK: 200"));
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Status code field cannot be set");
+		json_decref(data);
+		json_decref(root);
+		goto eperm_fail;
+	}
+
+	ret = json_object_set_new(root, "data", data);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Data field cannot be set");
+		json_decref(root);
+		goto eperm_fail;
+	}
+
+	json_buffer = json_dumps(root, JSON_INDENT(2));
+	json_decref(root);
+
+	ret = rte_telemetry_write_to_socket(telemetry, json_buffer);
+	free(json_buffer);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Could not write to socket");
+		return -1;
+	}
+
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+int32_t __rte_experimental
+rte_telemetry_register_keepalive(struct rte_keepalive *keepcfg)
+{
+	telemetry_keepalive = keepcfg;
+	return 0;
+}
+
+static const char *
+rte_telemetry_keepalive_state_name(enum rte_keepalive_state state)
+{
+	switch (state) {
+	case RTE_KA_STATE_UNUSED:
+		return "unused";
+	case RTE_KA_STATE_ALIVE:
+		return "alive";
+	case RTE_KA_STATE_MISSING:
+		return "missing";
+	case RTE_KA_STATE_DEAD:
+		return "dead";
+	case RTE_KA_STATE_GONE:
+		return "gone";
+	case RTE_KA_STATE_DOZING:
+		return "dozing";
+	case RTE_KA_STATE_SLEEP:
+		return "sleep";
+	}
+	return "unknown";
+}
+
+int32_t
+rte_telemetry_send_keepalive_values(struct telemetry_impl *telemetry)
+{
+	struct rte_keepalive *keepcfg = telemetry_keepalive;
+	enum rte_keepalive_state state;
+	uint64_t now, last_alive;
+	json_t *data, *cores, *core;
+	int ret, id_core;
+
+	if (telemetry == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	data = json_object();
+	cores = json_array();
+	if (data == NULL || cores == NULL) {
+		TELEMETRY_LOG_ERR("Could not create data/cores JSON objects");
+		goto eperm_fail;
+	}
+
+	now = rte_rdtsc();
+	for (id_core = 0; keepcfg != NULL && id_core < RTE_KEEPALIVE_MAXCORES;
+			id_core++) {
+		state = rte_keepalive_get_core_state(keepcfg, id_core,
+			&last_alive);
+		if (state == RTE_KA_STATE_UNUSED)
+			continue;
+
+		core = json_object();
+		if (core == NULL) {
+			TELEMETRY_LOG_ERR("Could not create core JSON object");
+			goto eperm_fail;
+		}
+
+		if (json_object_set_new(core, "core",
+					json_integer(id_core)) < 0 ||
+				json_object_set_new(core, "state", json_string(
+					rte_telemetry_keepalive_state_name(
+						state))) < 0 ||
+				json_object_set_new(core, "last_alive_ms",
+					json_integer((now - last_alive) *
+						MS_PER_S / rte_get_tsc_hz()))
+					< 0 ||
+				json_array_append_new(cores, core) < 0) {
+			TELEMETRY_LOG_ERR("Core object cannot be set");
+			goto eperm_fail;
+		}
+	}
+
+	ret = json_object_set_new(data, "cores", cores);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Cores array cannot be set");
+		goto eperm_fail;
+	}
+
+	return rte_telemetry_send_data(telemetry, data);
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+#ifdef RTE_LIBRTE_JOBSTATS
+static int32_t
+rte_telemetry_json_format_job(struct telemetry_impl *telemetry,
+	const struct rte_jobstats *job, json_t *jobs)
+{
+	char name[RTE_METRICS_MAX_NAME_LEN];
+	json_t *obj, *stats;
+	uint32_t i;
+	int ret;
+
+	const struct {
+		const char *name;
+		uint64_t value;
+	} values[] = {
+		{ "exec_cnt", job->exec_cnt },
+		{ "exec_cycles", job->exec_time },
+		{ "min_exec_cycles", job->exec_cnt ? job->min_exec_time : 0 },
+		{ "max_exec_cycles", job->max_exec_time },
+		{ "period_cycles", job->period },
+	};
+
+	obj = json_object();
+	stats = json_array();
+	if (obj == NULL || stats == NULL) {
+		TELEMETRY_LOG_ERR("Could not create job/stats JSON objects");
+		goto eperm_fail;
+	}
+
+	ret = json_object_set_new(obj, "name", json_string(job->name));
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Job name field cannot be set");
+		goto eperm_fail;
+	}
+
+	for (i = 0; i < RTE_DIM(values); i++) {
+		ret = rte_telemetry_json_format_stat(telemetry, stats,
+			values[i].name, values[i].value);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format stat %s failed",
+					values[i].name);
+			return -1;
+		}
+	}
+
+	/* Named after the lower bound of the buckets, in cycles */
+	for (i = 0; job->hist != NULL && i < RTE_JOBSTATS_HIST_BUCKETS; i++) {
+		snprintf(name, sizeof(name), "exec_cycles_ge_%" PRIu64,
+			i == 0 ? 0 : UINT64_C(1) << i);
+		ret = rte_telemetry_json_format_stat(telemetry, stats, name,
+			job->hist->count[i]);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format histogram failed");
+			return -1;
+		}
+	}
+
+	if (json_object_set_new(obj, "stats", stats) < 0 ||
+			json_array_append_new(jobs, obj) < 0) {
+		TELEMETRY_LOG_ERR("Job object cannot be set");
+		goto eperm_fail;
+	}
+
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+static int32_t
+rte_telemetry_json_format_jobstats_lcore(struct telemetry_impl *telemetry,
+	unsigned int lcore_id, json_t *lcores)
+{
+	struct rte_jobstats *jobs[RTE_JOBSTATS_MAX_JOBS];
+	struct rte_jobstats_context *ctx;
+	unsigned int nb_jobs = RTE_DIM(jobs);
+	json_t *lcore, *stats, *jobs_array;
+	uint32_t i;
+	int ret;
+
+	ctx = rte_jobstats_context_lookup(lcore_id, jobs, &nb_jobs);
+	if (ctx == NULL)
+		return 0;
+
+	const struct {
+		const char *name;
+		uint64_t value;
+	} values[] = {
+		{ "loop_cnt", ctx->loop_cnt },
+		{ "job_exec_cnt", ctx->job_exec_cnt },
+		{ "exec_cycles", ctx->exec_time },
+		{ "management_cycles", ctx->management_time },
+		{ "elapsed_cycles", ctx->state_time - ctx->start_time },
+		{ "load_permille", ctx->load },
+	};
+
+	lcore = json_object();
+	stats = json_array();
+	jobs_array = json_array();
+	if (lcore == NULL || stats == NULL || jobs_array == NULL) {
+		TELEMETRY_LOG_ERR("Could not create lcore JSON objects");
+		goto eperm_fail;
+	}
+
+	ret = json_object_set_new(lcore, "lcore", json_integer(lcore_id));
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Lcore field cannot be set");
+		goto eperm_fail;
+	}
+
+	for (i = 0; i < RTE_DIM(values); i++) {
+		ret = rte_telemetry_json_format_stat(telemetry, stats,
+			values[i].name, values[i].value);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format stat %s failed",
+					values[i].name);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < nb_jobs; i++) {
+		ret = rte_telemetry_json_format_job(telemetry, jobs[i],
+			jobs_array);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format job in JSON failed");
+			return -1;
+		}
+	}
+
+	if (json_object_set_new(lcore, "stats", stats) < 0 ||
+			json_object_set_new(lcore, "jobs", jobs_array) < 0 ||
+			json_array_append_new(lcores, lcore) < 0) {
+		TELEMETRY_LOG_ERR("Lcore object cannot be set");
+		goto eperm_fail;
+	}
+
+	return 0;
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+int32_t
+rte_telemetry_send_jobstats_values(struct telemetry_impl *telemetry)
+{
+	json_t *data, *lcores;
+	unsigned int lcore_id;
+	int ret;
+
+	if (telemetry == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	data = json_object();
+	lcores = json_array();
+	if (data == NULL || lcores == NULL) {
+		TELEMETRY_LOG_ERR("Could not create data/lcores JSON objects");
+		goto eperm_fail;
+	}
+
+	/*
+	 * The statistics are read while the lcores update them, like the
+	 * applications displaying them do, the datapath is never stalled.
+	 */
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		ret = rte_telemetry_json_format_jobstats_lcore(telemetry,
+			lcore_id, lcores);
+		if (ret < 0) {
+			TELEMETRY_LOG_ERR("Format lcore jobs in JSON failed");
+			return -1;
+		}
+	}
+
+	if (json_object_set_new(data, "timer_hz",
+				json_integer(rte_get_timer_hz())) < 0 ||
+			json_object_set_new(data, "lcores", lcores) < 0) {
+		TELEMETRY_LOG_ERR("Lcores array cannot be set");
+		goto eperm_fail;
+	}
+
+	return rte_telemetry_send_data(telemetry, data);
+
+eperm_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EPERM);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+#endif
+
 static int32_t
 rte_telemetry_initial_accept(struct telemetry_impl *telemetry)
 {
@@ -804,6 +1744,12 @@ rte_telemetry_run(void *userdata)
 		return -1;
 	}
 
+	ret = rte_telemetry_push_subscriptions(telemetry);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Subscription push failed");
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -945,6 +1891,7 @@ rte_telemetry_client_cleanup(struct telemetry_client *client)
 	int ret;
 
 	ret = close(client->fd);
+	rte_telemetry_subscription_free(client->subscription);
 	free(client->file_path);
 	free(client);
 
@@ -1079,6 +2026,7 @@ rte_telemetry_register_client(struct telemetry_impl *telemetry,
 	telemetry_client *new_client = malloc(sizeof(telemetry_client));
 	new_client->file_path = strdup(client_path);
 	new_client->fd = fd;
+	new_client->subscription = NULL;
 
 	if (connect(fd, (struct sockaddr *)&addrs, sizeof(addrs)) == -1) {
 		TELEMETRY_LOG_ERR("TELEMETRY client connect to %s didn't work",
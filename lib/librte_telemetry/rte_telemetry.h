@@ -14,8 +14,48 @@
  * The telemetry library provides a method to retrieve statistics from
  * DPDK by sending a JSON encoded message over a socket. DPDK will send
  * a JSON encoded response containing telemetry data.
+ *
+ * The port stats can also be requested in a binary encoding, a
+ * struct rte_telemetry_bin_hdr followed by a struct rte_telemetry_bin_stat
+ * per stat, in host byte order. The error responses are JSON encoded.
  ***/
 
+/** Magic number of the binary encoded responses, "TLMB" */
+#define RTE_TELEMETRY_BIN_MAGIC 0x424d4c54
+
+/** Version of the binary encoding */
+#define RTE_TELEMETRY_BIN_VERSION 1
+
+/** The response only holds the stats which changed since the previous one */
+#define RTE_TELEMETRY_BIN_F_DELTA 0x1
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this structure may change without prior notice
+ *
+ * Header of a binary encoded response.
+ */
+struct rte_telemetry_bin_hdr {
+	uint32_t magic; /**< RTE_TELEMETRY_BIN_MAGIC */
+	uint16_t version; /**< RTE_TELEMETRY_BIN_VERSION */
+	uint16_t flags; /**< RTE_TELEMETRY_BIN_F_* flags */
+	uint32_t num_stats; /**< Number of stats following the header */
+	uint32_t reserved;
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this structure may change without prior notice
+ *
+ * Stat of a binary encoded response.
+ */
+struct rte_telemetry_bin_stat {
+	uint16_t port_id; /**< Port of the stat */
+	uint16_t stat_index; /**< Index of the stat name in the request */
+	uint32_t reserved;
+	uint64_t value; /**< Value of the stat */
+};
+
 /**
  * @warning
  * @b EXPERIMENTAL: this API may change without prior notice
@@ -63,4 +103,22 @@ rte_telemetry_cleanup(void);
 int32_t __rte_experimental
 rte_telemetry_selftest(void);
 
+struct rte_keepalive;
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Export the core states of a keepalive instance through the 'keepalive'
+ * command.
+ *
+ * @param keepcfg
+ *  Keepalive instance, or NULL to stop exporting core states.
+ *
+ * @return
+ *  0 on success
+ */
+int32_t __rte_experimental
+rte_telemetry_register_keepalive(struct rte_keepalive *keepcfg);
+
 #endif
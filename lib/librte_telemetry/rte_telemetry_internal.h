@@ -24,9 +24,29 @@ extern int telemetry_log_level;
 #define TELEMETRY_LOG_INFO(fmt, args...) \
 	TELEMETRY_LOG(INFO, fmt, ## args)
 
+enum rte_telemetry_format {
+	TELEMETRY_FORMAT_JSON = 0,
+	TELEMETRY_FORMAT_BINARY
+};
+
+/* Stats pushed to a client at a set interval */
+typedef struct telemetry_subscription {
+	uint32_t *port_ids;
+	uint32_t num_port_ids;
+	uint32_t *metric_ids;
+	uint32_t num_metric_ids;
+	uint64_t *values; /* num_port_ids rows of num_metric_ids values */
+	uint64_t *prev_values; /* values of the previous push */
+	uint64_t interval; /* timer cycles between two pushes */
+	uint64_t next_tsc;
+	int format;
+	int pushed; /* non-zero once all the values have been pushed */
+} telemetry_subscription;
+
 typedef struct telemetry_client {
 	char *file_path;
 	int fd;
+	struct telemetry_subscription *subscription;
 	TAILQ_ENTRY(telemetry_client) client_list;
 } telemetry_client;
 
@@ -45,6 +65,7 @@ typedef struct telemetry_impl {
 
 enum rte_telemetry_parser_actions {
 	ACTION_GET = 0,
+	ACTION_POST = 1,
 	ACTION_DELETE = 2
 };
 
@@ -73,7 +94,46 @@ rte_telemetry_is_port_active(int port_id);
 
 int32_t
 rte_telemetry_send_ports_stats_values(uint32_t *metric_ids, int num_metric_ids,
-	uint32_t *port_ids, int num_port_ids, struct telemetry_impl *telemetry);
+	uint32_t *port_ids, int num_port_ids, int format,
+	struct telemetry_impl *telemetry);
+
+/**
+ * Subscribe the requesting client to the stats of the ports, replacing its
+ * previous subscription. All the values are pushed at once, then only the
+ * values which changed are pushed every interval_ms.
+ */
+int32_t
+rte_telemetry_subscribe(struct telemetry_impl *telemetry, uint32_t *metric_ids,
+	int num_metric_ids, uint32_t *port_ids, int num_port_ids,
+	uint32_t interval_ms, int format);
+
+/**
+ * Remove the subscription of the requesting client.
+ */
+int32_t
+rte_telemetry_unsubscribe(struct telemetry_impl *telemetry);
+
+#ifdef RTE_LIBRTE_VHOST
+/**
+ * Send the vhost and vdpa devices with the statistics of their vrings.
+ */
+int32_t
+rte_telemetry_send_vhost_values(struct telemetry_impl *telemetry);
+#endif
+
+/**
+ * Send the states of the cores checked by the registered keepalive instance.
+ */
+int32_t
+rte_telemetry_send_keepalive_values(struct telemetry_impl *telemetry);
+
+#ifdef RTE_LIBRTE_JOBSTATS
+/**
+ * Send the statistics of the job stats contexts and jobs registered per lcore.
+ */
+int32_t
+rte_telemetry_send_jobstats_values(struct telemetry_impl *telemetry);
+#endif
 
 int32_t
 rte_telemetry_socket_messaging_testing(int index, int socket);
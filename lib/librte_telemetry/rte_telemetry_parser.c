@@ -171,6 +171,118 @@ rte_telemetry_command_port_stats(struct telemetry_impl *telemetry, int action,
 	return -1;
 }
 
+#ifdef RTE_LIBRTE_VHOST
+static int32_t
+rte_telemetry_command_vhost_devices(struct telemetry_impl *telemetry,
+	int action, json_t *data)
+{
+	int ret;
+
+	if (telemetry == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	if (!json_is_null(data)) {
+		TELEMETRY_LOG_WARN("Data should be NULL JSON object for 'vhost_devices' command");
+		goto einval_fail;
+	}
+
+	if (action != ACTION_GET) {
+		TELEMETRY_LOG_WARN("Invalid action for this command");
+		goto einval_fail;
+	}
+
+	ret = rte_telemetry_send_vhost_values(telemetry);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Sending vhost values failed");
+		return -1;
+	}
+
+	return 0;
+
+einval_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+#endif
+
+static int32_t
+rte_telemetry_command_keepalive(struct telemetry_impl *telemetry,
+	int action, json_t *data)
+{
+	int ret;
+
+	if (telemetry == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	if (!json_is_null(data)) {
+		TELEMETRY_LOG_WARN("Data should be NULL JSON object for 'keepalive' command");
+		goto einval_fail;
+	}
+
+	if (action != ACTION_GET) {
+		TELEMETRY_LOG_WARN("Invalid action for this command");
+		goto einval_fail;
+	}
+
+	ret = rte_telemetry_send_keepalive_values(telemetry);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Sending keepalive values failed");
+		return -1;
+	}
+
+	return 0;
+
+einval_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
+#ifdef RTE_LIBRTE_JOBSTATS
+static int32_t
+rte_telemetry_command_jobstats(struct telemetry_impl *telemetry,
+	int action, json_t *data)
+{
+	int ret;
+
+	if (telemetry == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	if (!json_is_null(data)) {
+		TELEMETRY_LOG_WARN("Data should be NULL JSON object for 'jobstats' command");
+		goto einval_fail;
+	}
+
+	if (action != ACTION_GET) {
+		TELEMETRY_LOG_WARN("Invalid action for this command");
+		goto einval_fail;
+	}
+
+	ret = rte_telemetry_send_jobstats_values(telemetry);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Sending jobstats values failed");
+		return -1;
+	}
+
+	return 0;
+
+einval_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+#endif
+
 static int32_t
 rte_telemetry_stat_names_to_ids(struct telemetry_impl *telemetry,
 	const char * const *stat_names, uint32_t *stat_ids,
@@ -340,7 +452,7 @@ rte_telemetry_command_ports_all_stat_values(struct telemetry_impl *telemetry,
 	}
 
 	ret = rte_telemetry_send_ports_stats_values(stat_ids, num_metrics,
-		port_ids, num_port_ids, telemetry);
+		port_ids, num_port_ids, TELEMETRY_FORMAT_JSON, telemetry);
 	if (ret < 0) {
 		TELEMETRY_LOG_ERR("Sending ports stats values failed");
 		goto fail;
@@ -353,6 +465,84 @@ rte_telemetry_command_ports_all_stat_values(struct telemetry_impl *telemetry,
 	return -1;
 }
 
+/*
+ * Read the optional "format" field of the data of a command, "json" by
+ * default or "binary".
+ */
+static int32_t
+rte_telemetry_parse_format(json_t *data, int *format)
+{
+	json_t *format_json = json_object_get(data, "format");
+	const char *format_str;
+
+	*format = TELEMETRY_FORMAT_JSON;
+	if (format_json == NULL)
+		return 0;
+
+	if (!json_is_string(format_json)) {
+		TELEMETRY_LOG_WARN("Format value is not a string");
+		return -1;
+	}
+
+	format_str = json_string_value(format_json);
+	if (strcmp(format_str, "binary") == 0)
+		*format = TELEMETRY_FORMAT_BINARY;
+	else if (strcmp(format_str, "json") != 0) {
+		TELEMETRY_LOG_WARN("Invalid format: %s", format_str);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Read the "ports" and "stats" arrays of the data of a command into the
+ * port and stat ids.
+ */
+static int32_t
+rte_telemetry_parse_ports_stats(struct telemetry_impl *telemetry,
+	json_t *port_ids_json, json_t *stat_names_json, uint32_t *port_ids,
+	uint32_t *stat_ids, const char **stat_names)
+{
+	size_t index;
+	json_t *value;
+	int ret;
+
+	json_array_foreach(port_ids_json, index, value) {
+		if (!json_is_integer(value)) {
+			TELEMETRY_LOG_WARN("Port ID given is not valid");
+			goto einval_fail;
+		}
+		port_ids[index] = json_integer_value(value);
+		ret = rte_telemetry_is_port_active(port_ids[index]);
+		if (ret < 1)
+			goto einval_fail;
+	}
+
+	json_array_foreach(stat_names_json, index, value) {
+		if (!json_is_string(value)) {
+			TELEMETRY_LOG_WARN("Stat Name given is not a string");
+			goto einval_fail;
+		}
+		stat_names[index] = json_string_value(value);
+	}
+
+	ret = rte_telemetry_stat_names_to_ids(telemetry, stat_names, stat_ids,
+		json_array_size(stat_names_json));
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Could not convert stat names to IDs");
+		return -1;
+	}
+
+	return 0;
+
+einval_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
+}
+
 int32_t
 rte_telemetry_command_ports_stats_values_by_name(struct telemetry_impl
 	*telemetry, int action, json_t *data)
@@ -364,8 +554,7 @@ rte_telemetry_command_ports_stats_values_by_name(struct telemetry_impl
 	uint64_t num_stat_names = json_array_size(stat_names_json);
 	const char *stat_names[num_stat_names];
 	uint32_t port_ids[num_port_ids], stat_ids[num_stat_names];
-	size_t index;
-	json_t *value;
+	int format;
 
 	if (telemetry == NULL) {
 		TELEMETRY_LOG_ERR("Invalid telemetry argument");
@@ -397,55 +586,102 @@ rte_telemetry_command_ports_stats_values_by_name(struct telemetry_impl
 		return -1;
 	}
 
-	json_array_foreach(port_ids_json, index, value) {
-		if (!json_is_integer(value)) {
-			TELEMETRY_LOG_WARN("Port ID given is not valid");
-			ret = rte_telemetry_send_error_response(telemetry,
-				-EINVAL);
-			if (ret < 0)
-				TELEMETRY_LOG_ERR("Could not send error");
-			return -1;
-		}
-		port_ids[index] = json_integer_value(value);
-		ret = rte_telemetry_is_port_active(port_ids[index]);
-		if (ret < 1) {
-			ret = rte_telemetry_send_error_response(telemetry,
-				-EINVAL);
-			if (ret < 0)
-				TELEMETRY_LOG_ERR("Could not send error");
-			return -1;
-		}
+	ret = rte_telemetry_parse_format(data, &format);
+	if (ret < 0) {
+		ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+		if (ret < 0)
+			TELEMETRY_LOG_ERR("Could not send error");
+		return -1;
 	}
 
-	json_array_foreach(stat_names_json, index, value) {
-		if (!json_is_string(value)) {
-			TELEMETRY_LOG_WARN("Stat Name given is not a string");
+	ret = rte_telemetry_parse_ports_stats(telemetry, port_ids_json,
+		stat_names_json, port_ids, stat_ids, stat_names);
+	if (ret < 0)
+		return -1;
 
-			ret = rte_telemetry_send_error_response(telemetry,
-					-EINVAL);
-			if (ret < 0)
-				TELEMETRY_LOG_ERR("Could not send error");
+	ret = rte_telemetry_send_ports_stats_values(stat_ids, num_stat_names,
+		port_ids, num_port_ids, format, telemetry);
+	if (ret < 0) {
+		TELEMETRY_LOG_ERR("Sending ports stats values failed");
+		return -1;
+	}
 
-			return -1;
+	return 0;
+}
+
+static int32_t
+rte_telemetry_command_ports_stats_subscription(struct telemetry_impl
+	*telemetry, int action, json_t *data)
+{
+	int ret, format;
+	json_t *port_ids_json = json_object_get(data, "ports");
+	json_t *stat_names_json = json_object_get(data, "stats");
+	json_t *interval_json = json_object_get(data, "interval_ms");
+	uint64_t num_port_ids = json_array_size(port_ids_json);
+	uint64_t num_stat_names = json_array_size(stat_names_json);
+	const char *stat_names[num_stat_names];
+	uint32_t port_ids[num_port_ids], stat_ids[num_stat_names];
+
+	if (telemetry == NULL) {
+		TELEMETRY_LOG_ERR("Invalid telemetry argument");
+		return -1;
+	}
+
+	if (action == ACTION_DELETE) {
+		if (!json_is_null(data)) {
+			TELEMETRY_LOG_WARN("Data should be NULL JSON object for deleting a subscription");
+			goto einval_fail;
 		}
-		stat_names[index] = json_string_value(value);
+		return rte_telemetry_unsubscribe(telemetry);
 	}
 
-	ret = rte_telemetry_stat_names_to_ids(telemetry, stat_names, stat_ids,
-		num_stat_names);
-	if (ret < 0) {
-		TELEMETRY_LOG_ERR("Could not convert stat names to IDs");
-		return -1;
+	if (action != ACTION_POST) {
+		TELEMETRY_LOG_WARN("Invalid action for this command");
+		goto einval_fail;
 	}
 
-	ret = rte_telemetry_send_ports_stats_values(stat_ids, num_stat_names,
-		port_ids, num_port_ids, telemetry);
+	if (!json_is_object(data)) {
+		TELEMETRY_LOG_WARN("Invalid data provided for this command");
+		goto einval_fail;
+	}
+
+	if (!json_is_array(port_ids_json) ||
+		 !json_is_array(stat_names_json)) {
+		TELEMETRY_LOG_WARN("Invalid input data array(s)");
+		goto einval_fail;
+	}
+
+	if (!json_is_integer(interval_json) ||
+			json_integer_value(interval_json) <= 0 ||
+			json_integer_value(interval_json) > UINT32_MAX) {
+		TELEMETRY_LOG_WARN("Invalid interval_ms value");
+		goto einval_fail;
+	}
+
+	ret = rte_telemetry_parse_format(data, &format);
+	if (ret < 0)
+		goto einval_fail;
+
+	ret = rte_telemetry_parse_ports_stats(telemetry, port_ids_json,
+		stat_names_json, port_ids, stat_ids, stat_names);
+	if (ret < 0)
+		return -1;
+
+	ret = rte_telemetry_subscribe(telemetry, stat_ids, num_stat_names,
+		port_ids, num_port_ids, json_integer_value(interval_json),
+		format);
 	if (ret < 0) {
-		TELEMETRY_LOG_ERR("Sending ports stats values failed");
+		TELEMETRY_LOG_ERR("Subscribing to ports stats failed");
 		return -1;
 	}
 
 	return 0;
+
+einval_fail:
+	ret = rte_telemetry_send_error_response(telemetry, -EINVAL);
+	if (ret < 0)
+		TELEMETRY_LOG_ERR("Could not send error");
+	return -1;
 }
 
 static int32_t
@@ -484,7 +720,27 @@ rte_telemetry_parse_command(struct telemetry_impl *telemetry, int action,
 		{
 			.text = "ports_all_stat_values",
 			.fn = &rte_telemetry_command_ports_all_stat_values
-		}
+		},
+		{
+			.text = "ports_stats_subscription",
+			.fn = &rte_telemetry_command_ports_stats_subscription
+		},
+#ifdef RTE_LIBRTE_VHOST
+		{
+			.text = "vhost_devices",
+			.fn = &rte_telemetry_command_vhost_devices
+		},
+#endif
+		{
+			.text = "keepalive",
+			.fn = &rte_telemetry_command_keepalive
+		},
+#ifdef RTE_LIBRTE_JOBSTATS
+		{
+			.text = "jobstats",
+			.fn = &rte_telemetry_command_jobstats
+		},
+#endif
 	};
 
 	const uint32_t num_commands = RTE_DIM(commands);
@@ -555,7 +811,8 @@ rte_telemetry_parse(struct telemetry_impl *telemetry, char *socket_rx_data)
 	}
 
 	action_int = json_integer_value(action);
-	if (action_int != ACTION_GET && action_int != ACTION_DELETE) {
+	if (action_int != ACTION_GET && action_int != ACTION_POST &&
+			action_int != ACTION_DELETE) {
 		TELEMETRY_LOG_WARN("Invalid action code");
 		goto einval_fail;
 	}
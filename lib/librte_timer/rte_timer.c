@@ -3,6 +3,7 @@
  */
 
 #include <string.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
@@ -14,6 +15,7 @@
 #include <rte_cycles.h>
 #include <rte_per_lcore.h>
 #include <rte_memory.h>
+#include <rte_malloc.h>
 #include <rte_launch.h>
 #include <rte_eal.h>
 #include <rte_lcore.h>
@@ -48,35 +50,115 @@ struct priv_timer {
 #endif
 } __rte_cache_aligned;
 
-/** per-lcore private info for timers */
-static struct priv_timer priv_timer[RTE_MAX_LCORE];
+/** per-lcore private info for timers of the default timer data */
+static struct priv_timer default_priv_timer[RTE_MAX_LCORE];
+
+/* maximum number of timer data, including the default one */
+#define TIMER_MAX_DATA 64
+
+/** per-lcore private info of each timer data, the first being the default */
+static struct priv_timer *timer_data[TIMER_MAX_DATA] = {
+	default_priv_timer,
+};
+static rte_spinlock_t timer_data_lock = RTE_SPINLOCK_INITIALIZER;
 
 /* when debug is enabled, store some statistics */
 #ifdef RTE_LIBRTE_TIMER_DEBUG
-#define __TIMER_STAT_ADD(name, n) do {					\
+#define __TIMER_STAT_ADD(priv_timer, name, n) do {			\
 		unsigned __lcore_id = rte_lcore_id();			\
 		if (__lcore_id < RTE_MAX_LCORE)				\
 			priv_timer[__lcore_id].stats.name += (n);	\
 	} while(0)
 #else
-#define __TIMER_STAT_ADD(name, n) do {} while(0)
+#define __TIMER_STAT_ADD(priv_timer, name, n) do {} while(0)
 #endif
 
-/* Init the timer library. */
-void
-rte_timer_subsystem_init(void)
+/* init the per-lcore private info of a zeroed timer data */
+static void
+timer_data_init(struct priv_timer *priv_timer)
 {
 	unsigned lcore_id;
 
-	/* since priv_timer is static, it's zeroed by default, so only init some
-	 * fields.
-	 */
 	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id ++) {
 		rte_spinlock_init(&priv_timer[lcore_id].list_lock);
 		priv_timer[lcore_id].prev_lcore = lcore_id;
 	}
 }
 
+/* get the per-lcore private info of an allocated timer data */
+static struct priv_timer *
+timer_data_get(uint32_t timer_data_id)
+{
+	if (timer_data_id >= TIMER_MAX_DATA)
+		return NULL;
+	return timer_data[timer_data_id];
+}
+
+/* Init the timer library. */
+void
+rte_timer_subsystem_init(void)
+{
+	/* since default_priv_timer is static, it's zeroed by default, so
+	 * only init some fields.
+	 */
+	timer_data_init(default_priv_timer);
+}
+
+int __rte_experimental
+rte_timer_data_alloc(uint32_t *id_ptr)
+{
+	struct priv_timer *priv_timer;
+	uint32_t id;
+
+	if (id_ptr == NULL)
+		return -EINVAL;
+
+	priv_timer = rte_zmalloc("timer_data",
+			sizeof(*priv_timer) * RTE_MAX_LCORE,
+			RTE_CACHE_LINE_SIZE);
+	if (priv_timer == NULL)
+		return -ENOMEM;
+	timer_data_init(priv_timer);
+
+	rte_spinlock_lock(&timer_data_lock);
+	for (id = 1; id < TIMER_MAX_DATA; id++) {
+		if (timer_data[id] == NULL) {
+			timer_data[id] = priv_timer;
+			break;
+		}
+	}
+	rte_spinlock_unlock(&timer_data_lock);
+
+	if (id == TIMER_MAX_DATA) {
+		rte_free(priv_timer);
+		return -ENOSPC;
+	}
+
+	*id_ptr = id;
+	return 0;
+}
+
+int __rte_experimental
+rte_timer_data_dealloc(uint32_t timer_data_id)
+{
+	struct priv_timer *priv_timer;
+
+	/* the default timer data cannot be freed */
+	if (timer_data_id == 0 || timer_data_id >= TIMER_MAX_DATA)
+		return -EINVAL;
+
+	rte_spinlock_lock(&timer_data_lock);
+	priv_timer = timer_data[timer_data_id];
+	timer_data[timer_data_id] = NULL;
+	rte_spinlock_unlock(&timer_data_lock);
+
+	if (priv_timer == NULL)
+		return -EINVAL;
+
+	rte_free(priv_timer);
+	return 0;
+}
+
 /* Initialize the timer handle tim for use */
 void
 rte_timer_init(struct rte_timer *tim)
@@ -95,7 +177,8 @@ rte_timer_init(struct rte_timer *tim)
  */
 static int
 timer_set_config_state(struct rte_timer *tim,
-		       union rte_timer_status *ret_prev_status)
+		       union rte_timer_status *ret_prev_status,
+		       struct priv_timer *priv_timer)
 {
 	union rte_timer_status prev_status, status;
 	int success = 0;
@@ -207,7 +290,7 @@ timer_get_skiplist_level(unsigned curr_depth)
  */
 static void
 timer_get_prev_entries(uint64_t time_val, unsigned tim_lcore,
-		struct rte_timer **prev)
+		struct rte_timer **prev, struct priv_timer *priv_timer)
 {
 	unsigned lvl = priv_timer[tim_lcore].curr_skiplist_depth;
 	prev[lvl] = &priv_timer[tim_lcore].pending_head;
@@ -226,13 +309,13 @@ timer_get_prev_entries(uint64_t time_val, unsigned tim_lcore,
  */
 static void
 timer_get_prev_entries_for_node(struct rte_timer *tim, unsigned tim_lcore,
-		struct rte_timer **prev)
+		struct rte_timer **prev, struct priv_timer *priv_timer)
 {
 	int i;
 	/* to get a specific entry in the list, look for just lower than the time
 	 * values, and then increment on each level individually if necessary
 	 */
-	timer_get_prev_entries(tim->expire - 1, tim_lcore, prev);
+	timer_get_prev_entries(tim->expire - 1, tim_lcore, prev, priv_timer);
 	for (i = priv_timer[tim_lcore].curr_skiplist_depth - 1; i >= 0; i--) {
 		while (prev[i]->sl_next[i] != NULL &&
 				prev[i]->sl_next[i] != tim &&
@@ -247,7 +330,8 @@ timer_get_prev_entries_for_node(struct rte_timer *tim, unsigned tim_lcore,
  * timer must not be in a list
  */
 static void
-timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
+timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked,
+		struct priv_timer *priv_timer)
 {
 	unsigned lcore_id = rte_lcore_id();
 	unsigned lvl;
@@ -261,7 +345,7 @@ timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
 
 	/* find where exactly this element goes in the list of elements
 	 * for each depth. */
-	timer_get_prev_entries(tim->expire, tim_lcore, prev);
+	timer_get_prev_entries(tim->expire, tim_lcore, prev, priv_timer);
 
 	/* now assign it a new level and add at that level */
 	const unsigned tim_level = timer_get_skiplist_level(
@@ -294,7 +378,7 @@ timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
  */
 static void
 timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
-		int local_is_locked)
+		int local_is_locked, struct priv_timer *priv_timer)
 {
 	unsigned lcore_id = rte_lcore_id();
 	unsigned prev_owner = prev_status.owner;
@@ -314,7 +398,7 @@ timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
 				((tim->sl_next[0] == NULL) ? 0 : tim->sl_next[0]->expire);
 
 	/* adjust pointers from previous entries to point past this */
-	timer_get_prev_entries_for_node(tim, prev_owner, prev);
+	timer_get_prev_entries_for_node(tim, prev_owner, prev, priv_timer);
 	for (i = priv_timer[prev_owner].curr_skiplist_depth - 1; i >= 0; i--) {
 		if (prev[i]->sl_next[i] == tim)
 			prev[i]->sl_next[i] = tim->sl_next[i];
@@ -336,7 +420,7 @@ static int
 __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 		  uint64_t period, unsigned tim_lcore,
 		  rte_timer_cb_t fct, void *arg,
-		  int local_is_locked)
+		  int local_is_locked, struct priv_timer *priv_timer)
 {
 	union rte_timer_status prev_status, status;
 	int ret;
@@ -358,11 +442,11 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 
 	/* wait that the timer is in correct status before update,
 	 * and mark it as being configured */
-	ret = timer_set_config_state(tim, &prev_status);
+	ret = timer_set_config_state(tim, &prev_status, priv_timer);
 	if (ret < 0)
 		return -1;
 
-	__TIMER_STAT_ADD(reset, 1);
+	__TIMER_STAT_ADD(priv_timer, reset, 1);
 	if (prev_status.state == RTE_TIMER_RUNNING &&
 	    lcore_id < RTE_MAX_LCORE) {
 		priv_timer[lcore_id].updated = 1;
@@ -370,8 +454,8 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 
 	/* remove it from list */
 	if (prev_status.state == RTE_TIMER_PENDING) {
-		timer_del(tim, prev_status, local_is_locked);
-		__TIMER_STAT_ADD(pending, -1);
+		timer_del(tim, prev_status, local_is_locked, priv_timer);
+		__TIMER_STAT_ADD(priv_timer, pending, -1);
 	}
 
 	tim->period = period;
@@ -379,8 +463,8 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 	tim->f = fct;
 	tim->arg = arg;
 
-	__TIMER_STAT_ADD(pending, 1);
-	timer_add(tim, tim_lcore, local_is_locked);
+	__TIMER_STAT_ADD(priv_timer, pending, 1);
+	timer_add(tim, tim_lcore, local_is_locked, priv_timer);
 
 	/* update state: as we are in CONFIG state, only us can modify
 	 * the state so we don't need to use cmpset() here */
@@ -392,11 +476,13 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 	return 0;
 }
 
-/* Reset and start the timer associated with the timer handle tim */
-int
-rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
+/* Reset and start the timer associated with the timer handle tim, in a
+ * timer data
+ */
+static int
+timer_reset(struct rte_timer *tim, uint64_t ticks,
 		enum rte_timer_type type, unsigned tim_lcore,
-		rte_timer_cb_t fct, void *arg)
+		rte_timer_cb_t fct, void *arg, struct priv_timer *priv_timer)
 {
 	uint64_t cur_time = rte_get_timer_cycles();
 	uint64_t period;
@@ -412,7 +498,30 @@ rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
 		period = 0;
 
 	return __rte_timer_reset(tim,  cur_time + ticks, period, tim_lcore,
-			  fct, arg, 0);
+			  fct, arg, 0, priv_timer);
+}
+
+/* Reset and start the timer associated with the timer handle tim */
+int
+rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
+		enum rte_timer_type type, unsigned tim_lcore,
+		rte_timer_cb_t fct, void *arg)
+{
+	return timer_reset(tim, ticks, type, tim_lcore, fct, arg,
+			default_priv_timer);
+}
+
+int __rte_experimental
+rte_timer_alt_reset(uint32_t timer_data_id, struct rte_timer *tim,
+		uint64_t ticks, enum rte_timer_type type,
+		unsigned int tim_lcore, rte_timer_cb_t fct, void *arg)
+{
+	struct priv_timer *priv_timer = timer_data_get(timer_data_id);
+
+	if (priv_timer == NULL)
+		return -EINVAL;
+
+	return timer_reset(tim, ticks, type, tim_lcore, fct, arg, priv_timer);
 }
 
 /* loop until rte_timer_reset() succeed */
@@ -426,9 +535,9 @@ rte_timer_reset_sync(struct rte_timer *tim, uint64_t ticks,
 		rte_pause();
 }
 
-/* Stop the timer associated with the timer handle tim */
-int
-rte_timer_stop(struct rte_timer *tim)
+/* Stop the timer associated with the timer handle tim, in a timer data */
+static int
+timer_stop(struct rte_timer *tim, struct priv_timer *priv_timer)
 {
 	union rte_timer_status prev_status, status;
 	unsigned lcore_id = rte_lcore_id();
@@ -436,11 +545,11 @@ rte_timer_stop(struct rte_timer *tim)
 
 	/* wait that the timer is in correct status before update,
 	 * and mark it as being configured */
-	ret = timer_set_config_state(tim, &prev_status);
+	ret = timer_set_config_state(tim, &prev_status, priv_timer);
 	if (ret < 0)
 		return -1;
 
-	__TIMER_STAT_ADD(stop, 1);
+	__TIMER_STAT_ADD(priv_timer, stop, 1);
 	if (prev_status.state == RTE_TIMER_RUNNING &&
 	    lcore_id < RTE_MAX_LCORE) {
 		priv_timer[lcore_id].updated = 1;
@@ -448,8 +557,8 @@ rte_timer_stop(struct rte_timer *tim)
 
 	/* remove it from list */
 	if (prev_status.state == RTE_TIMER_PENDING) {
-		timer_del(tim, prev_status, 0);
-		__TIMER_STAT_ADD(pending, -1);
+		timer_del(tim, prev_status, 0, priv_timer);
+		__TIMER_STAT_ADD(priv_timer, pending, -1);
 	}
 
 	/* mark timer as stopped */
@@ -461,6 +570,24 @@ rte_timer_stop(struct rte_timer *tim)
 	return 0;
 }
 
+/* Stop the timer associated with the timer handle tim */
+int
+rte_timer_stop(struct rte_timer *tim)
+{
+	return timer_stop(tim, default_priv_timer);
+}
+
+int __rte_experimental
+rte_timer_alt_stop(uint32_t timer_data_id, struct rte_timer *tim)
+{
+	struct priv_timer *priv_timer = timer_data_get(timer_data_id);
+
+	if (priv_timer == NULL)
+		return -EINVAL;
+
+	return timer_stop(tim, priv_timer);
+}
+
 /* loop until rte_timer_stop() succeed */
 void
 rte_timer_stop_sync(struct rte_timer *tim)
@@ -476,8 +603,9 @@ rte_timer_pending(struct rte_timer *tim)
 	return tim->status.state == RTE_TIMER_PENDING;
 }
 
-/* must be called periodically, run all timer that expired */
-void rte_timer_manage(void)
+/* run all timer that expired on this lcore, in a timer data */
+static void
+timer_manage(struct priv_timer *priv_timer)
 {
 	union rte_timer_status status;
 	struct rte_timer *tim, *next_tim;
@@ -490,7 +618,7 @@ void rte_timer_manage(void)
 	/* timer manager only runs on EAL thread with valid lcore_id */
 	assert(lcore_id < RTE_MAX_LCORE);
 
-	__TIMER_STAT_ADD(manage, 1);
+	__TIMER_STAT_ADD(priv_timer, manage, 1);
 	/* optimize for the case where per-cpu list is empty */
 	if (priv_timer[lcore_id].pending_head.sl_next[0] == NULL)
 		return;
@@ -518,7 +646,7 @@ void rte_timer_manage(void)
 	tim = priv_timer[lcore_id].pending_head.sl_next[0];
 
 	/* break the existing list at current time point */
-	timer_get_prev_entries(cur_time, lcore_id, prev);
+	timer_get_prev_entries(cur_time, lcore_id, prev, priv_timer);
 	for (i = priv_timer[lcore_id].curr_skiplist_depth -1; i >= 0; i--) {
 		if (prev[i] == &priv_timer[lcore_id].pending_head)
 			continue;
@@ -563,7 +691,7 @@ void rte_timer_manage(void)
 		/* execute callback function with list unlocked */
 		tim->f(tim, tim->arg);
 
-		__TIMER_STAT_ADD(pending, -1);
+		__TIMER_STAT_ADD(priv_timer, pending, -1);
 		/* the timer was stopped or reloaded by the callback
 		 * function, we have nothing to do here */
 		if (priv_timer[lcore_id].updated == 1)
@@ -580,20 +708,40 @@ void rte_timer_manage(void)
 			/* keep it in list and mark timer as pending */
 			rte_spinlock_lock(&priv_timer[lcore_id].list_lock);
 			status.state = RTE_TIMER_PENDING;
-			__TIMER_STAT_ADD(pending, 1);
+			__TIMER_STAT_ADD(priv_timer, pending, 1);
 			status.owner = (int16_t)lcore_id;
 			rte_wmb();
 			tim->status.u32 = status.u32;
 			__rte_timer_reset(tim, tim->expire + tim->period,
-				tim->period, lcore_id, tim->f, tim->arg, 1);
+				tim->period, lcore_id, tim->f, tim->arg, 1,
+				priv_timer);
 			rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
 		}
 	}
 	priv_timer[lcore_id].running_tim = NULL;
 }
 
-/* dump statistics about timers */
-void rte_timer_dump_stats(FILE *f)
+/* must be called periodically, run all timer that expired */
+void rte_timer_manage(void)
+{
+	timer_manage(default_priv_timer);
+}
+
+int __rte_experimental
+rte_timer_alt_manage(uint32_t timer_data_id)
+{
+	struct priv_timer *priv_timer = timer_data_get(timer_data_id);
+
+	if (priv_timer == NULL)
+		return -EINVAL;
+
+	timer_manage(priv_timer);
+	return 0;
+}
+
+/* dump statistics about timers of a timer data */
+static void
+timer_dump_stats(FILE *f, struct priv_timer *priv_timer)
 {
 #ifdef RTE_LIBRTE_TIMER_DEBUG
 	struct rte_timer_debug_stats sum;
@@ -612,6 +760,25 @@ void rte_timer_dump_stats(FILE *f)
 	fprintf(f, "  manage = %"PRIu64"\n", sum.manage);
 	fprintf(f, "  pending = %"PRIu64"\n", sum.pending);
 #else
+	RTE_SET_USED(priv_timer);
 	fprintf(f, "No timer statistics, RTE_LIBRTE_TIMER_DEBUG is disabled\n");
 #endif
 }
+
+/* dump statistics about timers */
+void rte_timer_dump_stats(FILE *f)
+{
+	timer_dump_stats(f, default_priv_timer);
+}
+
+int __rte_experimental
+rte_timer_alt_dump_stats(uint32_t timer_data_id, FILE *f)
+{
+	struct priv_timer *priv_timer = timer_data_get(timer_data_id);
+
+	if (priv_timer == NULL)
+		return -EINVAL;
+
+	timer_dump_stats(f, priv_timer);
+	return 0;
+}
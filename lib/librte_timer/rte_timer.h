@@ -39,6 +39,7 @@
 #include <stddef.h>
 #include <rte_common.h>
 #include <rte_config.h>
+#include <rte_compat.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -302,6 +303,129 @@ void rte_timer_manage(void);
  */
 void rte_timer_dump_stats(FILE *f);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Allocate a timer data instance.
+ *
+ * A timer data instance holds its own set of per-lcore timer lists,
+ * managed by rte_timer_alt_manage() independently of the lists of the
+ * other instances. This lets components run their timers at different
+ * frequencies or on different lcores, without a slow callback of one
+ * component delaying the timers of the others.
+ *
+ * The instance 0 is the default one, used by rte_timer_reset(),
+ * rte_timer_stop(), rte_timer_manage() and rte_timer_dump_stats().
+ *
+ * @param id_ptr
+ *   Pointer to the identifier of the allocated instance.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: *id_ptr* is NULL.
+ *   - -ENOMEM: Not enough memory.
+ *   - -ENOSPC: No more instance available.
+ */
+int __rte_experimental rte_timer_data_alloc(uint32_t *id_ptr);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free a timer data instance. Its timers must all be stopped, and no other
+ * function may use the instance during or after this call.
+ *
+ * @param timer_data_id
+ *   The identifier of the instance, other than the default one.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The instance is the default one or is not allocated.
+ */
+int __rte_experimental rte_timer_data_dealloc(uint32_t timer_data_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Reset and start a timer in a timer data instance. See rte_timer_reset()
+ * for details. A timer must always be used with the same instance until it
+ * is stopped.
+ *
+ * @param timer_data_id
+ *   The identifier of the instance.
+ * @param tim
+ *   The timer handle.
+ * @param ticks
+ *   The number of cycles before the callback function is called.
+ * @param type
+ *   PERIODICAL or SINGLE.
+ * @param tim_lcore
+ *   The ID of the lcore where the timer callback function has to be
+ *   executed, or LCORE_ID_ANY for round-robin.
+ * @param fct
+ *   The callback function of the timer.
+ * @param arg
+ *   The user argument of the callback function.
+ * @return
+ *   - 0: Success; the timer is scheduled.
+ *   - (-1): Timer is in the RUNNING or CONFIG state.
+ *   - -EINVAL: The instance is not allocated.
+ */
+int __rte_experimental
+rte_timer_alt_reset(uint32_t timer_data_id, struct rte_timer *tim,
+		    uint64_t ticks, enum rte_timer_type type,
+		    unsigned int tim_lcore, rte_timer_cb_t fct, void *arg);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Stop a timer of a timer data instance. See rte_timer_stop() for details.
+ *
+ * @param timer_data_id
+ *   The identifier of the instance the timer was started in.
+ * @param tim
+ *   The timer handle.
+ * @return
+ *   - 0: Success; the timer is stopped.
+ *   - (-1): The timer is in the RUNNING or CONFIG state.
+ *   - -EINVAL: The instance is not allocated.
+ */
+int __rte_experimental
+rte_timer_alt_stop(uint32_t timer_data_id, struct rte_timer *tim);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Run the expired timers of the calling lcore in a timer data instance.
+ * See rte_timer_manage() for details.
+ *
+ * @param timer_data_id
+ *   The identifier of the instance.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The instance is not allocated.
+ */
+int __rte_experimental rte_timer_alt_manage(uint32_t timer_data_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dump statistics about the timers of a timer data instance.
+ *
+ * @param timer_data_id
+ *   The identifier of the instance.
+ * @param f
+ *   A pointer to a file for output
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The instance is not allocated.
+ */
+int __rte_experimental
+rte_timer_alt_dump_stats(uint32_t timer_data_id, FILE *f);
+
 #ifdef __cplusplus
 }
 #endif
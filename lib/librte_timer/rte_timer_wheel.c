@@ -0,0 +1,364 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <sys/queue.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_malloc.h>
+#include <rte_memory.h>
+#include <rte_ring.h>
+
+#include "rte_timer_wheel.h"
+
+#define TW_BITS 8
+#define TW_MASK (RTE_TIMER_WHEEL_SLOTS - 1)
+/* largest expiry delta held by the wheel, later timers are clamped */
+#define TW_MAX_DELTA ((UINT64_C(1) << (TW_BITS * RTE_TIMER_WHEEL_LEVELS)) - 1)
+
+/* number of remote requests dequeued at once */
+#define TW_REQ_BURST 32
+/* low bit of a remote request, the timer pointer being at least 8 aligned */
+#define TW_REQ_CANCEL 1
+
+enum {
+	TW_TIMER_STOPPED,
+	TW_TIMER_ARMED,
+	TW_TIMER_RUNNING,
+};
+
+LIST_HEAD(tw_slot, rte_timer_wheel_timer);
+
+struct rte_timer_wheel {
+	struct rte_ring *ring;          /**< Remote requests. */
+	uint64_t tick_cycles;           /**< Cycles per tick. */
+	uint64_t start_cycles;          /**< Cycles at tick 0. */
+	uint64_t cur;                   /**< Next tick to process. */
+	struct rte_timer_wheel_stats stats;
+	uint32_t level_count[RTE_TIMER_WHEEL_LEVELS];
+	struct tw_slot slots[RTE_TIMER_WHEEL_LEVELS][RTE_TIMER_WHEEL_SLOTS];
+} __rte_cache_aligned;
+
+static inline uint64_t
+tw_now(const struct rte_timer_wheel *tw)
+{
+	return (rte_get_timer_cycles() - tw->start_cycles) / tw->tick_cycles;
+}
+
+static inline uint64_t
+tw_cycles_to_ticks(const struct rte_timer_wheel *tw, uint64_t cycles)
+{
+	return (cycles + tw->tick_cycles - 1) / tw->tick_cycles;
+}
+
+/* insert a timer in the slot matching its distance to the current tick */
+static void
+tw_link(struct rte_timer_wheel *tw, struct rte_timer_wheel_timer *tim)
+{
+	uint64_t expire = tim->expire;
+	uint64_t delta;
+	unsigned int level;
+
+	if (expire < tw->cur)
+		expire = tw->cur;
+	delta = expire - tw->cur;
+
+	if (delta < (UINT64_C(1) << TW_BITS))
+		level = 0;
+	else if (delta < (UINT64_C(1) << (2 * TW_BITS)))
+		level = 1;
+	else if (delta < (UINT64_C(1) << (3 * TW_BITS)))
+		level = 2;
+	else {
+		/* clamped again if still too far when cascaded */
+		if (delta > TW_MAX_DELTA)
+			expire = tw->cur + TW_MAX_DELTA;
+		level = 3;
+	}
+
+	tim->level = level;
+	tw->level_count[level]++;
+	LIST_INSERT_HEAD(&tw->slots[level][(expire >> (TW_BITS * level)) &
+			TW_MASK], tim, next);
+}
+
+static inline void
+tw_unlink(struct rte_timer_wheel *tw, struct rte_timer_wheel_timer *tim)
+{
+	tw->level_count[tim->level]--;
+	LIST_REMOVE(tim, next);
+}
+
+/* move the timers of a slot to the lower levels */
+static void
+tw_cascade(struct rte_timer_wheel *tw, unsigned int level, unsigned int idx)
+{
+	struct rte_timer_wheel_timer *tim;
+	struct tw_slot *slot = &tw->slots[level][idx];
+
+	while ((tim = LIST_FIRST(slot)) != NULL) {
+		tw_unlink(tw, tim);
+		tw_link(tw, tim);
+		tw->stats.cascaded++;
+	}
+}
+
+struct rte_timer_wheel * __rte_experimental
+rte_timer_wheel_create(const char *name,
+		const struct rte_timer_wheel_params *params)
+{
+	struct rte_timer_wheel *tw;
+
+	if (name == NULL || params == NULL || params->tick_cycles == 0) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	tw = rte_zmalloc_socket("timer_wheel", sizeof(*tw),
+			RTE_CACHE_LINE_SIZE, params->socket_id);
+	if (tw == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	/* any lcore may send requests, only the owner receives them */
+	tw->ring = rte_ring_create(name, params->ring_size, params->socket_id,
+			RING_F_SC_DEQ);
+	if (tw->ring == NULL) {
+		rte_free(tw);
+		return NULL;
+	}
+
+	tw->tick_cycles = params->tick_cycles;
+	tw->start_cycles = rte_get_timer_cycles();
+
+	return tw;
+}
+
+void __rte_experimental
+rte_timer_wheel_free(struct rte_timer_wheel *tw)
+{
+	if (tw == NULL)
+		return;
+
+	rte_ring_free(tw->ring);
+	rte_free(tw);
+}
+
+void __rte_experimental
+rte_timer_wheel_timer_init(struct rte_timer_wheel_timer *tim,
+		rte_timer_wheel_cb_t f, void *arg)
+{
+	memset(tim, 0, sizeof(*tim));
+	tim->f = f;
+	tim->arg = arg;
+	tim->state = TW_TIMER_STOPPED;
+}
+
+void __rte_experimental
+rte_timer_wheel_arm(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim, uint64_t cycles,
+		uint64_t period)
+{
+	if (tim->state == TW_TIMER_ARMED)
+		tw_unlink(tw, tim);
+	else
+		tw->stats.armed++;
+
+	tim->expire = tw_now(tw) + tw_cycles_to_ticks(tw, cycles);
+	tim->period = tw_cycles_to_ticks(tw, period);
+	tim->state = TW_TIMER_ARMED;
+	tw_link(tw, tim);
+}
+
+void __rte_experimental
+rte_timer_wheel_cancel(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim)
+{
+	if (tim->state == TW_TIMER_ARMED) {
+		tw_unlink(tw, tim);
+		tw->stats.armed--;
+	}
+	/* a running timer is not re-armed when cancelled by its callback */
+	tim->state = TW_TIMER_STOPPED;
+}
+
+int __rte_experimental
+rte_timer_wheel_arm_remote(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim, uint64_t cycles,
+		uint64_t period)
+{
+	tim->req_cycles = cycles;
+	tim->req_period = period;
+
+	/* the enqueue orders the request fields before the request */
+	if (rte_ring_mp_enqueue(tw->ring, tim) != 0)
+		return -ENOBUFS;
+
+	return 0;
+}
+
+int __rte_experimental
+rte_timer_wheel_cancel_remote(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim)
+{
+	if (rte_ring_mp_enqueue(tw->ring,
+			(void *)((uintptr_t)tim | TW_REQ_CANCEL)) != 0)
+		return -ENOBUFS;
+
+	return 0;
+}
+
+static void
+tw_apply_requests(struct rte_timer_wheel *tw)
+{
+	void *reqs[TW_REQ_BURST];
+	struct rte_timer_wheel_timer *tim;
+	unsigned int i, n;
+
+	do {
+		n = rte_ring_sc_dequeue_burst(tw->ring, reqs, TW_REQ_BURST,
+				NULL);
+		for (i = 0; i < n; i++) {
+			tim = (void *)((uintptr_t)reqs[i] &
+					~(uintptr_t)TW_REQ_CANCEL);
+			if ((uintptr_t)reqs[i] & TW_REQ_CANCEL)
+				rte_timer_wheel_cancel(tw, tim);
+			else
+				rte_timer_wheel_arm(tw, tim, tim->req_cycles,
+						tim->req_period);
+		}
+		tw->stats.remote += n;
+	} while (n == TW_REQ_BURST);
+}
+
+/* run the timers of the level 0 slot of a tick, already cascaded */
+static unsigned int
+tw_run_slot(struct rte_timer_wheel *tw, uint64_t tick)
+{
+	struct tw_slot *slot = &tw->slots[0][tick & TW_MASK];
+	struct tw_slot expired;
+	struct rte_timer_wheel_timer *tim;
+	unsigned int n = 0;
+
+	/*
+	 * Detach the slot, so that the timers armed by the callbacks 256
+	 * ticks later do not run now. The timers stay counted in level 0
+	 * so that the callbacks can still cancel them.
+	 */
+	LIST_INIT(&expired);
+	tim = LIST_FIRST(slot);
+	if (tim == NULL)
+		return 0;
+	LIST_FIRST(&expired) = tim;
+	tim->next.le_prev = &LIST_FIRST(&expired);
+	LIST_INIT(slot);
+
+	while ((tim = LIST_FIRST(&expired)) != NULL) {
+		tw_unlink(tw, tim);
+
+		tim->state = TW_TIMER_RUNNING;
+		tw->stats.armed--;
+		tim->f(tim, tim->arg);
+		n++;
+
+		/* neither re-armed nor cancelled by the callback */
+		if (tim->state == TW_TIMER_RUNNING) {
+			if (tim->period != 0) {
+				tim->expire += tim->period;
+				tim->state = TW_TIMER_ARMED;
+				tw->stats.armed++;
+				tw_link(tw, tim);
+			} else {
+				tim->state = TW_TIMER_STOPPED;
+			}
+		}
+	}
+
+	return n;
+}
+
+unsigned int __rte_experimental
+rte_timer_wheel_manage(struct rte_timer_wheel *tw)
+{
+	uint64_t now, tick;
+	unsigned int level, idx;
+	unsigned int n = 0;
+
+	if (rte_ring_count(tw->ring) != 0)
+		tw_apply_requests(tw);
+
+	now = tw_now(tw);
+
+	while (tw->cur <= now) {
+		if (tw->stats.armed == 0) {
+			tw->cur = now + 1;
+			break;
+		}
+
+		tick = tw->cur;
+		idx = tick & TW_MASK;
+		if (idx == 0) {
+			/* cascade until a level not wrapping around */
+			for (level = 1; level < RTE_TIMER_WHEEL_LEVELS;
+					level++) {
+				idx = (tick >> (TW_BITS * level)) & TW_MASK;
+				tw_cascade(tw, level, idx);
+				if (idx != 0)
+					break;
+			}
+		} else if (tw->level_count[0] == 0) {
+			/* nothing to run before the lowest level is cascaded */
+			for (level = 1; tw->level_count[level] == 0; level++)
+				;
+			tw->cur = RTE_MIN(RTE_ALIGN_CEIL(tick + 1,
+					UINT64_C(1) << (TW_BITS * level)), now + 1);
+			continue;
+		}
+
+		/* timers armed by the callbacks expire from the next tick */
+		tw->cur = tick + 1;
+		n += tw_run_slot(tw, tick);
+	}
+
+	tw->stats.expired += n;
+
+	return n;
+}
+
+int __rte_experimental
+rte_timer_wheel_pending(const struct rte_timer_wheel_timer *tim)
+{
+	return tim->state == TW_TIMER_ARMED;
+}
+
+void __rte_experimental
+rte_timer_wheel_stats_get(const struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_stats *stats)
+{
+	*stats = tw->stats;
+}
+
+void __rte_experimental
+rte_timer_wheel_dump(FILE *f, const struct rte_timer_wheel *tw)
+{
+	unsigned int level;
+
+	fprintf(f, "Timer wheel <%s>@%p\n", tw->ring->name, tw);
+	fprintf(f, "  tick_cycles=%"PRIu64"\n", tw->tick_cycles);
+	fprintf(f, "  cur_tick=%"PRIu64"\n", tw->cur);
+	for (level = 0; level < RTE_TIMER_WHEEL_LEVELS; level++)
+		fprintf(f, "  level%u=%"PRIu32"\n", level,
+				tw->level_count[level]);
+	fprintf(f, "  armed=%"PRIu64"\n", tw->stats.armed);
+	fprintf(f, "  expired=%"PRIu64"\n", tw->stats.expired);
+	fprintf(f, "  cascaded=%"PRIu64"\n", tw->stats.cascaded);
+	fprintf(f, "  remote=%"PRIu64"\n", tw->stats.remote);
+}
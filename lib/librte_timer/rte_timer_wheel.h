@@ -0,0 +1,280 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_TIMER_WHEEL_H_
+#define _RTE_TIMER_WHEEL_H_
+
+/**
+ * @file
+ * RTE Timer Wheel
+ *
+ * Hierarchical timing wheel for applications handling large numbers of
+ * timers, such as flow aging or retransmission timers.
+ *
+ * A wheel is owned by a single lcore, which runs the expired timers with
+ * rte_timer_wheel_manage(). Arming and cancelling a timer from the owner
+ * lcore are O(1) and take no lock. Other lcores arm and cancel timers through
+ * a ring of requests, applied in bursts by the owner lcore at the beginning
+ * of each rte_timer_wheel_manage() call.
+ *
+ * The wheel has RTE_TIMER_WHEEL_LEVELS levels of RTE_TIMER_WHEEL_SLOTS slots,
+ * the timers expiring within RTE_TIMER_WHEEL_SLOTS ticks are in the first
+ * level, the other ones are cascaded down from the upper levels as time
+ * goes. Expiry times are rounded up to the tick of the wheel.
+ *
+ * The rte_timer API is not changed and keeps its own implementation.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+#include <rte_common.h>
+#include <rte_compat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of levels of a timer wheel. */
+#define RTE_TIMER_WHEEL_LEVELS 4
+/** Number of slots of each level of a timer wheel. */
+#define RTE_TIMER_WHEEL_SLOTS 256
+
+struct rte_timer_wheel;
+struct rte_timer_wheel_timer;
+
+/**
+ * Callback function type for timer expiry. The callback runs on the owner
+ * lcore of the wheel, and may arm or cancel any timer of the wheel,
+ * including the expired one.
+ */
+typedef void (*rte_timer_wheel_cb_t)(struct rte_timer_wheel_timer *tim,
+		void *arg);
+
+/**
+ * A timer of a timer wheel. It is to be embedded in the application
+ * objects and initialized with rte_timer_wheel_timer_init(); its fields
+ * are private to the library.
+ */
+struct rte_timer_wheel_timer {
+	LIST_ENTRY(rte_timer_wheel_timer) next; /**< Slot list linkage. */
+	uint64_t expire;       /**< Expiry tick. */
+	uint64_t period;       /**< Period in ticks, 0 if not periodic. */
+	rte_timer_wheel_cb_t f; /**< Callback function. */
+	void *arg;             /**< Argument to callback function. */
+	uint64_t req_cycles;   /**< Delay of a remote arm request. */
+	uint64_t req_period;   /**< Period of a remote arm request. */
+	uint8_t state;         /**< Stopped, armed or running. */
+	uint8_t level;         /**< Level of the wheel holding the timer. */
+} __rte_aligned(8);
+
+/** Timer wheel creation parameters. */
+struct rte_timer_wheel_params {
+	/** Resolution of the wheel, in timer cycles. */
+	uint64_t tick_cycles;
+	/** Size of the ring of remote requests, a power of 2. */
+	unsigned int ring_size;
+	/** NUMA socket of the wheel memory. */
+	int socket_id;
+};
+
+/** Timer wheel statistics. */
+struct rte_timer_wheel_stats {
+	uint64_t armed;     /**< Number of timers currently armed. */
+	uint64_t expired;   /**< Number of timer expiries. */
+	uint64_t cascaded;  /**< Number of timers moved to a lower level. */
+	uint64_t remote;    /**< Number of remote requests applied. */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a timer wheel.
+ *
+ * @param name
+ *   Name of the wheel, also used for its ring of remote requests.
+ * @param params
+ *   Parameters of the wheel.
+ * @return
+ *   The wheel, or NULL on error with rte_errno set.
+ */
+struct rte_timer_wheel * __rte_experimental
+rte_timer_wheel_create(const char *name,
+		const struct rte_timer_wheel_params *params);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Free a timer wheel. Its timers are left as they are, they must not be
+ * used with the wheel anymore.
+ *
+ * @param tw
+ *   The wheel, or NULL.
+ */
+void __rte_experimental
+rte_timer_wheel_free(struct rte_timer_wheel *tw);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Initialize a timer before its first use.
+ *
+ * @param tim
+ *   The timer.
+ * @param f
+ *   The callback function of the timer.
+ * @param arg
+ *   The argument of the callback function.
+ */
+void __rte_experimental
+rte_timer_wheel_timer_init(struct rte_timer_wheel_timer *tim,
+		rte_timer_wheel_cb_t f, void *arg);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Arm a timer, or re-arm it if it is already armed. Must be called by the
+ * owner lcore of the wheel.
+ *
+ * @param tw
+ *   The wheel.
+ * @param tim
+ *   The timer.
+ * @param cycles
+ *   Delay before the expiry, in timer cycles.
+ * @param period
+ *   Period of the timer in timer cycles, 0 for a one-shot timer.
+ */
+void __rte_experimental
+rte_timer_wheel_arm(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim, uint64_t cycles,
+		uint64_t period);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Cancel a timer, doing nothing if it is not armed. Must be called by the
+ * owner lcore of the wheel.
+ *
+ * @param tw
+ *   The wheel.
+ * @param tim
+ *   The timer.
+ */
+void __rte_experimental
+rte_timer_wheel_cancel(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Request the owner lcore of the wheel to arm a timer. The request is
+ * applied at the next call to rte_timer_wheel_manage(), the delay being
+ * counted from then. Until then, no other request may be made for the
+ * timer.
+ *
+ * @param tw
+ *   The wheel.
+ * @param tim
+ *   The timer.
+ * @param cycles
+ *   Delay before the expiry, in timer cycles.
+ * @param period
+ *   Period of the timer in timer cycles, 0 for a one-shot timer.
+ * @return
+ *   0 on success, -ENOBUFS if the ring of requests is full.
+ */
+int __rte_experimental
+rte_timer_wheel_arm_remote(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim, uint64_t cycles,
+		uint64_t period);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Request the owner lcore of the wheel to cancel a timer. The request is
+ * applied at the next call to rte_timer_wheel_manage().
+ *
+ * @param tw
+ *   The wheel.
+ * @param tim
+ *   The timer.
+ * @return
+ *   0 on success, -ENOBUFS if the ring of requests is full.
+ */
+int __rte_experimental
+rte_timer_wheel_cancel_remote(struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_timer *tim);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Apply the pending remote requests and run the expired timers. Must be
+ * called periodically by the owner lcore of the wheel.
+ *
+ * @param tw
+ *   The wheel.
+ * @return
+ *   The number of timers run.
+ */
+unsigned int __rte_experimental
+rte_timer_wheel_manage(struct rte_timer_wheel *tw);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Test whether a timer is armed.
+ *
+ * @param tim
+ *   The timer.
+ * @return
+ *   1 if the timer is armed, 0 otherwise.
+ */
+int __rte_experimental
+rte_timer_wheel_pending(const struct rte_timer_wheel_timer *tim);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the statistics of a timer wheel.
+ *
+ * @param tw
+ *   The wheel.
+ * @param stats
+ *   The structure to fill.
+ */
+void __rte_experimental
+rte_timer_wheel_stats_get(const struct rte_timer_wheel *tw,
+		struct rte_timer_wheel_stats *stats);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Dump the state and statistics of a timer wheel.
+ *
+ * @param f
+ *   The output stream.
+ * @param tw
+ *   The wheel.
+ */
+void __rte_experimental
+rte_timer_wheel_dump(FILE *f, const struct rte_timer_wheel *tw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_TIMER_WHEEL_H_ */
@@ -10,6 +10,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 
 #include <rte_common.h>
 #include <rte_log.h>
@@ -19,99 +20,65 @@
 
 #define RTE_LOGTYPE_VHOST_FDMAN RTE_LOGTYPE_USER1
 
-#define FDPOLLERR (POLLERR | POLLHUP | POLLNVAL)
+#define FDPOLLERR (EPOLLERR | EPOLLHUP)
 
-static int
-get_last_valid_idx(struct fdset *pfdset, int last_valid_idx)
+/**
+ * Returns the entry of a given fd, or NULL if fd isn't in the fdset.
+ */
+static struct fdentry *
+fdset_find_fd(struct fdset *pfdset, int fd)
 {
-	int i;
-
-	for (i = last_valid_idx; i >= 0 && pfdset->fd[i].fd == -1; i--)
-		;
-
-	return i;
+	return fd < pfdset->size ? pfdset->fd[fd] : NULL;
 }
 
-static void
-fdset_move(struct fdset *pfdset, int dst, int src)
+/* Make room in the fd table for a given fd. */
+static int
+fdset_grow(struct fdset *pfdset, int fd)
 {
-	pfdset->fd[dst]    = pfdset->fd[src];
-	pfdset->rwfds[dst] = pfdset->rwfds[src];
-}
+	struct fdentry **table;
+	int size;
 
-static void
-fdset_shrink_nolock(struct fdset *pfdset)
-{
-	int i;
-	int last_valid_idx = get_last_valid_idx(pfdset, pfdset->num - 1);
+	if (fd < pfdset->size)
+		return 0;
 
-	for (i = 0; i < last_valid_idx; i++) {
-		if (pfdset->fd[i].fd != -1)
-			continue;
+	size = RTE_MAX(pfdset->size * 2, fd + 1);
+	size = RTE_MAX(size, FDSET_EVENTS_MAX);
+	table = realloc(pfdset->fd, size * sizeof(*table));
+	if (table == NULL)
+		return -1;
 
-		fdset_move(pfdset, i, last_valid_idx);
-		last_valid_idx = get_last_valid_idx(pfdset, last_valid_idx - 1);
-	}
-	pfdset->num = last_valid_idx + 1;
-}
+	memset(&table[pfdset->size], 0,
+		(size - pfdset->size) * sizeof(*table));
+	pfdset->fd = table;
+	pfdset->size = size;
 
-/*
- * Find deleted fd entries and remove them
- */
-static void
-fdset_shrink(struct fdset *pfdset)
-{
-	pthread_mutex_lock(&pfdset->fd_mutex);
-	fdset_shrink_nolock(pfdset);
-	pthread_mutex_unlock(&pfdset->fd_mutex);
+	return 0;
 }
 
-/**
- * Returns the index in the fdset for a given fd.
- * @return
- *   index for the fd, or -1 if fd isn't in the fdset.
+/*
+ * Drop an entry from the fd table and the epoll set. A busy entry is
+ * freed by the dispatch loop once its callback returns.
  */
-static int
-fdset_find_fd(struct fdset *pfdset, int fd)
-{
-	int i;
-
-	for (i = 0; i < pfdset->num && pfdset->fd[i].fd != fd; i++)
-		;
-
-	return i == pfdset->num ? -1 : i;
-}
-
 static void
-fdset_add_fd(struct fdset *pfdset, int idx, int fd,
-	fd_cb rcb, fd_cb wcb, void *dat)
+fdset_remove_nolock(struct fdset *pfdset, struct fdentry *pfdentry)
 {
-	struct fdentry *pfdentry = &pfdset->fd[idx];
-	struct pollfd *pfd = &pfdset->rwfds[idx];
-
-	pfdentry->fd  = fd;
-	pfdentry->rcb = rcb;
-	pfdentry->wcb = wcb;
-	pfdentry->dat = dat;
-
-	pfd->fd = fd;
-	pfd->events  = rcb ? POLLIN : 0;
-	pfd->events |= wcb ? POLLOUT : 0;
-	pfd->revents = 0;
+	/* Fails harmlessly when the fd was already closed. */
+	epoll_ctl(pfdset->epfd, EPOLL_CTL_DEL, pfdentry->fd, NULL);
+	pfdset->fd[pfdentry->fd] = NULL;
+	pfdset->num--;
+	if (!pfdentry->busy)
+		free(pfdentry);
 }
 
 void
 fdset_init(struct fdset *pfdset)
 {
-	int i;
-
 	if (pfdset == NULL)
 		return;
 
-	for (i = 0; i < MAX_FDS; i++) {
-		pfdset->fd[i].fd = -1;
-		pfdset->fd[i].dat = NULL;
-	}
+	pfdset->epfd = -1;
+	pfdset->fd = NULL;
+	pfdset->size = 0;
 	pfdset->num = 0;
 }
 
@@ -121,26 +88,62 @@ fdset_init(struct fdset *pfdset)
 int
 fdset_add(struct fdset *pfdset, int fd, fd_cb rcb, fd_cb wcb, void *dat)
 {
-	int i;
+	struct fdentry *pfdentry;
+	struct epoll_event ev;
 
 	if (pfdset == NULL || fd == -1)
 		return -1;
 
+	pfdentry = malloc(sizeof(*pfdentry));
+	if (pfdentry == NULL)
+		return -1;
+
+	pfdentry->fd  = fd;
+	pfdentry->rcb = rcb;
+	pfdentry->wcb = wcb;
+	pfdentry->dat = dat;
+	pfdentry->busy = 0;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events  = rcb ? EPOLLIN : 0;
+	ev.events |= wcb ? EPOLLOUT : 0;
+	ev.data.fd = fd;
+
 	pthread_mutex_lock(&pfdset->fd_mutex);
-	i = pfdset->num < MAX_FDS ? pfdset->num++ : -1;
-	if (i == -1) {
-		fdset_shrink_nolock(pfdset);
-		i = pfdset->num < MAX_FDS ? pfdset->num++ : -1;
-		if (i == -1) {
-			pthread_mutex_unlock(&pfdset->fd_mutex);
-			return -2;
-		}
+
+	if (pfdset->epfd < 0) {
+		pfdset->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (pfdset->epfd < 0)
+			goto err;
 	}
 
-	fdset_add_fd(pfdset, i, fd, rcb, wcb, dat);
+	if (fdset_grow(pfdset, fd) < 0)
+		goto err;
+
+	/*
+	 * An fd number is only reused once closed, an entry left for it
+	 * belongs to a closed fd whose removal is pending, e.g. a callback
+	 * closing its fd and opening a new socket.
+	 */
+	if (pfdset->fd[fd] != NULL)
+		fdset_remove_nolock(pfdset, pfdset->fd[fd]);
+
+	if (epoll_ctl(pfdset->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		RTE_LOG(ERR, VHOST_FDMAN, "failed to add fd %d to epoll: %s\n",
+			fd, strerror(errno));
+		goto err;
+	}
+
+	pfdset->fd[fd] = pfdentry;
+	pfdset->num++;
 	pthread_mutex_unlock(&pfdset->fd_mutex);
 
 	return 0;
+
+err:
+	pthread_mutex_unlock(&pfdset->fd_mutex);
+	free(pfdentry);
+	return -1;
 }
 
 /**
@@ -150,7 +153,7 @@ fdset_add(struct fdset *pfdset, int fd, fd_cb rcb, fd_cb wcb, void *dat)
 void *
 fdset_del(struct fdset *pfdset, int fd)
 {
-	int i;
+	struct fdentry *pfdentry;
 	void *dat = NULL;
 
 	if (pfdset == NULL || fd == -1)
@@ -159,17 +162,15 @@ fdset_del(struct fdset *pfdset, int fd)
 	do {
 		pthread_mutex_lock(&pfdset->fd_mutex);
 
-		i = fdset_find_fd(pfdset, fd);
-		if (i != -1 && pfdset->fd[i].busy == 0) {
+		pfdentry = fdset_find_fd(pfdset, fd);
+		if (pfdentry != NULL && pfdentry->busy == 0) {
 			/* busy indicates r/wcb is executing! */
-			dat = pfdset->fd[i].dat;
-			pfdset->fd[i].fd = -1;
-			pfdset->fd[i].rcb = pfdset->fd[i].wcb = NULL;
-			pfdset->fd[i].dat = NULL;
-			i = -1;
+			dat = pfdentry->dat;
+			fdset_remove_nolock(pfdset, pfdentry);
+			pfdentry = NULL;
 		}
 		pthread_mutex_unlock(&pfdset->fd_mutex);
-	} while (i != -1);
+	} while (pfdentry != NULL);
 
 	return dat;
 }
@@ -185,23 +186,20 @@ fdset_del(struct fdset *pfdset, int fd)
 int
 fdset_try_del(struct fdset *pfdset, int fd)
 {
-	int i;
+	struct fdentry *pfdentry;
 
 	if (pfdset == NULL || fd == -1)
 		return -2;
 
 	pthread_mutex_lock(&pfdset->fd_mutex);
-	i = fdset_find_fd(pfdset, fd);
-	if (i != -1 && pfdset->fd[i].busy) {
+	pfdentry = fdset_find_fd(pfdset, fd);
+	if (pfdentry != NULL && pfdentry->busy) {
 		pthread_mutex_unlock(&pfdset->fd_mutex);
 		return -1;
 	}
 
-	if (i != -1) {
-		pfdset->fd[i].fd = -1;
-		pfdset->fd[i].rcb = pfdset->fd[i].wcb = NULL;
-		pfdset->fd[i].dat = NULL;
-	}
+	if (pfdentry != NULL)
+		fdset_remove_nolock(pfdset, pfdentry);
 
 	pthread_mutex_unlock(&pfdset->fd_mutex);
 	return 0;
@@ -215,56 +213,50 @@ fdset_try_del(struct fdset *pfdset, int fd)
  * thread(now rte_vhost_driver_unregister) calls fdset_del concurrently, it
  * will wait until the flag is reset to zero(which indicates the callback is
  * finished), then it could free the context after fdset_del.
+ *
+ * The events carry the fd, not the entry: an entry deleted after
+ * epoll_wait() returned is looked up again and skipped.
  */
 void *
 fdset_event_dispatch(void *arg)
 {
 	int i;
-	struct pollfd *pfd;
+	struct epoll_event events[FDSET_EVENTS_MAX];
 	struct fdentry *pfdentry;
 	fd_cb rcb, wcb;
 	void *dat;
 	int fd, numfds;
 	int remove1, remove2;
-	int need_shrink;
+	uint32_t revents;
 	struct fdset *pfdset = arg;
-	int val;
 
 	if (pfdset == NULL)
 		return NULL;
 
-	while (1) {
-
-		/*
-		 * When poll is blocked, other threads might unregister
-		 * listenfds from and register new listenfds into fdset.
-		 * When poll returns, the entries for listenfds in the fdset
-		 * might have been updated. It is ok if there is unwanted call
-		 * for new listenfds.
-		 */
-		pthread_mutex_lock(&pfdset->fd_mutex);
-		numfds = pfdset->num;
-		pthread_mutex_unlock(&pfdset->fd_mutex);
+	pthread_mutex_lock(&pfdset->fd_mutex);
+	if (pfdset->epfd < 0)
+		pfdset->epfd = epoll_create1(EPOLL_CLOEXEC);
+	pthread_mutex_unlock(&pfdset->fd_mutex);
+	if (pfdset->epfd < 0) {
+		RTE_LOG(ERR, VHOST_FDMAN, "failed to create epoll: %s\n",
+			strerror(errno));
+		return NULL;
+	}
 
-		val = poll(pfdset->rwfds, numfds, 1000 /* millisecs */);
-		if (val < 0)
+	while (1) {
+		numfds = epoll_wait(pfdset->epfd, events, FDSET_EVENTS_MAX,
+				    -1);
+		if (numfds < 0)
 			continue;
 
-		need_shrink = 0;
 		for (i = 0; i < numfds; i++) {
-			pthread_mutex_lock(&pfdset->fd_mutex);
-
-			pfdentry = &pfdset->fd[i];
-			fd = pfdentry->fd;
-			pfd = &pfdset->rwfds[i];
+			fd = events[i].data.fd;
+			revents = events[i].events;
 
-			if (fd < 0) {
-				need_shrink = 1;
-				pthread_mutex_unlock(&pfdset->fd_mutex);
-				continue;
-			}
+			pthread_mutex_lock(&pfdset->fd_mutex);
 
-			if (!pfd->revents) {
+			pfdentry = fdset_find_fd(pfdset, fd);
+			if (pfdentry == NULL) {
 				pthread_mutex_unlock(&pfdset->fd_mutex);
 				continue;
 			}
@@ -278,10 +270,12 @@ fdset_event_dispatch(void *arg)
 
 			pthread_mutex_unlock(&pfdset->fd_mutex);
 
-			if (rcb && pfd->revents & (POLLIN | FDPOLLERR))
+			if (rcb && revents & (EPOLLIN | FDPOLLERR))
 				rcb(fd, dat, &remove1);
-			if (wcb && pfd->revents & (POLLOUT | FDPOLLERR))
+			if (wcb && revents & (EPOLLOUT | FDPOLLERR))
 				wcb(fd, dat, &remove2);
+
+			pthread_mutex_lock(&pfdset->fd_mutex);
 			pfdentry->busy = 0;
 			/*
 			 * fdset_del needs to check busy flag.
@@ -293,16 +287,15 @@ fdset_event_dispatch(void *arg)
 			 * because the fd is closed in the cb,
 			 * the old fd val could be reused by when creates new
 			 * listen fd in another thread, we couldn't call
-			 * fdset_del.
+			 * fdset_del: the entry is only dropped if the fd
+			 * was not registered again meanwhile.
 			 */
-			if (remove1 || remove2) {
-				pfdentry->fd = -1;
-				need_shrink = 1;
-			}
+			if (pfdset->fd[fd] != pfdentry)
+				free(pfdentry);
+			else if (remove1 || remove2)
+				fdset_remove_nolock(pfdset, pfdentry);
+			pthread_mutex_unlock(&pfdset->fd_mutex);
 		}
-
-		if (need_shrink)
-			fdset_shrink(pfdset);
 	}
 
 	return NULL;
@@ -6,14 +6,15 @@
 #define _FD_MAN_H_
 #include <stdint.h>
 #include <pthread.h>
-#include <poll.h>
+#include <sys/epoll.h>
 
-#define MAX_FDS 1024
+/* Events handled by one epoll_wait() of the dispatch loop. */
+#define FDSET_EVENTS_MAX 64
 
 typedef void (*fd_cb)(int fd, void *dat, int *remove);
 
 struct fdentry {
-	int fd;		/* -1 indicates this entry is empty */
+	int fd;		/* registered fd */
 	fd_cb rcb;	/* callback when this fd is readable. */
 	fd_cb wcb;	/* callback when this fd is writeable.*/
 	void *dat;	/* fd context */
@@ -21,8 +22,9 @@ struct fdentry {
 };
 
 struct fdset {
-	struct pollfd rwfds[MAX_FDS];
-	struct fdentry fd[MAX_FDS];
+	int epfd;	/* epoll instance, created on the first add */
+	struct fdentry **fd;	/* entries indexed by fd */
+	int size;	/* length of the fd table */
 	pthread_mutex_t fd_mutex;
 	int num;	/* current fd number of this fdset */
 
@@ -37,6 +39,13 @@ struct fdset {
 	} u;
 };
 
+#define FDSET_INITIALIZER { \
+	.epfd = -1, \
+	.fd = NULL, \
+	.size = 0, \
+	.fd_mutex = PTHREAD_MUTEX_INITIALIZER, \
+	.num = 0, \
+}
 
 void fdset_init(struct fdset *pfdset);
 
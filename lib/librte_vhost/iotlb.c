@@ -35,6 +35,7 @@
 #endif
 
 #include <rte_tailq.h>
+#include <rte_malloc.h>
 
 #include "iotlb.h"
 #include "vhost.h"
@@ -45,13 +46,14 @@ struct vhost_iotlb_entry {
 	uint64_t iova;
 	uint64_t uaddr;
 	uint64_t size;
+	uint64_t last_used; /* LRU clock of the last lookup hit */
 	uint8_t perm;
 };
 
 #define IOTLB_CACHE_SIZE 2048
 
 static void
-vhost_user_iotlb_cache_random_evict(struct vhost_virtqueue *vq);
+vhost_user_iotlb_cache_lru_evict(struct vhost_virtqueue *vq);
 
 static void
 vhost_user_iotlb_pending_remove_all(struct vhost_virtqueue *vq)
@@ -102,7 +104,7 @@ vhost_user_iotlb_pending_insert(struct vhost_virtqueue *vq,
 		if (!TAILQ_EMPTY(&vq->iotlb_pending_list))
 			vhost_user_iotlb_pending_remove_all(vq);
 		else
-			vhost_user_iotlb_cache_random_evict(vq);
+			vhost_user_iotlb_cache_lru_evict(vq);
 		ret = rte_mempool_get(vq->iotlb_pool, (void **)&node);
 		if (ret) {
 			RTE_LOG(ERR, VHOST_CONFIG, "IOTLB pool still empty, failure\n");
@@ -142,43 +144,78 @@ vhost_user_iotlb_pending_remove(struct vhost_virtqueue *vq,
 	rte_rwlock_write_unlock(&vq->iotlb_pending_lock);
 }
 
+/*
+ * The cache is an array of non-overlapping entries sorted by iova, so
+ * their ends are sorted too. Return the index of the first entry ending
+ * after iova, the number of entries if there is none.
+ */
+static __rte_always_inline uint32_t
+vhost_user_iotlb_cache_lookup(struct vhost_virtqueue *vq, uint64_t iova)
+{
+	uint32_t lo = 0, hi = vq->iotlb_cache_nr, mid;
+	struct vhost_iotlb_entry *node;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		node = vq->iotlb_cache[mid];
+		if (iova >= node->iova + node->size)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Called with iotlb_lock write-locked */
 static void
-vhost_user_iotlb_cache_remove_all(struct vhost_virtqueue *vq)
+vhost_user_iotlb_cache_del(struct vhost_virtqueue *vq, uint32_t start,
+				uint32_t end)
 {
-	struct vhost_iotlb_entry *node, *temp_node;
+	uint32_t i;
 
-	rte_rwlock_write_lock(&vq->iotlb_lock);
+	if (start == end)
+		return;
 
-	TAILQ_FOREACH_SAFE(node, &vq->iotlb_list, next, temp_node) {
-		TAILQ_REMOVE(&vq->iotlb_list, node, next);
-		rte_mempool_put(vq->iotlb_pool, node);
-	}
+	for (i = start; i < end; i++)
+		rte_mempool_put(vq->iotlb_pool, vq->iotlb_cache[i]);
 
-	vq->iotlb_cache_nr = 0;
+	memmove(&vq->iotlb_cache[start], &vq->iotlb_cache[end],
+		(vq->iotlb_cache_nr - end) * sizeof(*vq->iotlb_cache));
+	vq->iotlb_cache_nr -= end - start;
+	vq->iotlb_hint = 0;
+}
+
+static void
+vhost_user_iotlb_cache_remove_all(struct vhost_virtqueue *vq)
+{
+	rte_rwlock_write_lock(&vq->iotlb_lock);
+
+	vhost_user_iotlb_cache_del(vq, 0, vq->iotlb_cache_nr);
 
 	rte_rwlock_write_unlock(&vq->iotlb_lock);
 }
 
+/* Evict the least recently used entry, to make room for a new one. */
 static void
-vhost_user_iotlb_cache_random_evict(struct vhost_virtqueue *vq)
+vhost_user_iotlb_cache_lru_evict(struct vhost_virtqueue *vq)
 {
-	struct vhost_iotlb_entry *node, *temp_node;
-	int entry_idx;
+	uint32_t i, victim = 0;
 
 	rte_rwlock_write_lock(&vq->iotlb_lock);
 
-	entry_idx = rte_rand() % vq->iotlb_cache_nr;
+	if (unlikely(!vq->iotlb_cache_nr))
+		goto unlock;
 
-	TAILQ_FOREACH_SAFE(node, &vq->iotlb_list, next, temp_node) {
-		if (!entry_idx) {
-			TAILQ_REMOVE(&vq->iotlb_list, node, next);
-			rte_mempool_put(vq->iotlb_pool, node);
-			vq->iotlb_cache_nr--;
-			break;
-		}
-		entry_idx--;
+	for (i = 1; i < vq->iotlb_cache_nr; i++) {
+		if (vq->iotlb_cache[i]->last_used <
+				vq->iotlb_cache[victim]->last_used)
+			victim = i;
 	}
 
+	vhost_user_iotlb_cache_del(vq, victim, victim + 1);
+
+unlock:
 	rte_rwlock_write_unlock(&vq->iotlb_lock);
 }
 
@@ -186,14 +223,15 @@ void
 vhost_user_iotlb_cache_insert(struct vhost_virtqueue *vq, uint64_t iova,
 				uint64_t uaddr, uint64_t size, uint8_t perm)
 {
-	struct vhost_iotlb_entry *node, *new_node;
+	struct vhost_iotlb_entry *new_node;
+	uint32_t idx, end;
 	int ret;
 
 	ret = rte_mempool_get(vq->iotlb_pool, (void **)&new_node);
 	if (ret) {
 		RTE_LOG(DEBUG, VHOST_CONFIG, "IOTLB pool empty, clear entries\n");
-		if (!TAILQ_EMPTY(&vq->iotlb_list))
-			vhost_user_iotlb_cache_random_evict(vq);
+		if (vq->iotlb_cache_nr)
+			vhost_user_iotlb_cache_lru_evict(vq);
 		else
 			vhost_user_iotlb_pending_remove_all(vq);
 		ret = rte_mempool_get(vq->iotlb_pool, (void **)&new_node);
@@ -210,23 +248,31 @@ vhost_user_iotlb_cache_insert(struct vhost_virtqueue *vq, uint64_t iova,
 
 	rte_rwlock_write_lock(&vq->iotlb_lock);
 
-	TAILQ_FOREACH(node, &vq->iotlb_list, next) {
-		/*
-		 * Entries must be invalidated before being updated.
-		 * So if iova already in list, assume identical.
-		 */
-		if (node->iova == new_node->iova) {
-			rte_mempool_put(vq->iotlb_pool, new_node);
-			goto unlock;
-		} else if (node->iova > new_node->iova) {
-			TAILQ_INSERT_BEFORE(node, new_node, next);
-			vq->iotlb_cache_nr++;
-			goto unlock;
-		}
+	new_node->last_used = vq->iotlb_clock;
+
+	idx = vhost_user_iotlb_cache_lookup(vq, iova);
+
+	/*
+	 * Entries must be invalidated before being updated.
+	 * So if iova already in cache, assume identical.
+	 */
+	if (idx < vq->iotlb_cache_nr && vq->iotlb_cache[idx]->iova == iova) {
+		rte_mempool_put(vq->iotlb_pool, new_node);
+		goto unlock;
+	}
+
+	/* Entries overlapping the new one are stale, drop them. */
+	for (end = idx; end < vq->iotlb_cache_nr; end++) {
+		if (vq->iotlb_cache[end]->iova >= iova + size)
+			break;
 	}
+	vhost_user_iotlb_cache_del(vq, idx, end);
 
-	TAILQ_INSERT_TAIL(&vq->iotlb_list, new_node, next);
+	memmove(&vq->iotlb_cache[idx + 1], &vq->iotlb_cache[idx],
+		(vq->iotlb_cache_nr - idx) * sizeof(*vq->iotlb_cache));
+	vq->iotlb_cache[idx] = new_node;
 	vq->iotlb_cache_nr++;
+	vq->iotlb_hint = idx;
 
 unlock:
 	vhost_user_iotlb_pending_remove(vq, iova, size, perm);
@@ -239,54 +285,63 @@ void
 vhost_user_iotlb_cache_remove(struct vhost_virtqueue *vq,
 					uint64_t iova, uint64_t size)
 {
-	struct vhost_iotlb_entry *node, *temp_node;
+	uint32_t idx, end;
 
 	if (unlikely(!size))
 		return;
 
 	rte_rwlock_write_lock(&vq->iotlb_lock);
 
-	TAILQ_FOREACH_SAFE(node, &vq->iotlb_list, next, temp_node) {
-		/* Sorted list */
-		if (unlikely(iova + size < node->iova))
+	idx = vhost_user_iotlb_cache_lookup(vq, iova);
+	for (end = idx; end < vq->iotlb_cache_nr; end++) {
+		if (vq->iotlb_cache[end]->iova >= iova + size)
 			break;
-
-		if (iova < node->iova + node->size) {
-			TAILQ_REMOVE(&vq->iotlb_list, node, next);
-			rte_mempool_put(vq->iotlb_pool, node);
-			vq->iotlb_cache_nr--;
-		}
 	}
+	vhost_user_iotlb_cache_del(vq, idx, end);
 
 	rte_rwlock_write_unlock(&vq->iotlb_lock);
 }
 
+/* Called with iotlb_lock read-locked */
 uint64_t
 vhost_user_iotlb_cache_find(struct vhost_virtqueue *vq, uint64_t iova,
 						uint64_t *size, uint8_t perm)
 {
 	struct vhost_iotlb_entry *node;
 	uint64_t offset, vva = 0, mapped = 0;
+	uint32_t i;
 
 	if (unlikely(!*size))
 		goto out;
 
-	TAILQ_FOREACH(node, &vq->iotlb_list, next) {
-		/* List sorted by iova */
+	/*
+	 * A virtqueue is polled by one lcore, and its buffers mostly come
+	 * from the same mapping: try the last hit before searching.
+	 */
+	i = vq->iotlb_hint;
+	if (unlikely(i >= vq->iotlb_cache_nr ||
+		     iova < vq->iotlb_cache[i]->iova ||
+		     iova >= vq->iotlb_cache[i]->iova +
+			     vq->iotlb_cache[i]->size))
+		i = vhost_user_iotlb_cache_lookup(vq, iova);
+
+	for (; i < vq->iotlb_cache_nr; i++) {
+		node = vq->iotlb_cache[i];
+
 		if (unlikely(iova < node->iova))
 			break;
 
-		if (iova >= node->iova + node->size)
-			continue;
-
 		if (unlikely((perm & node->perm) != perm)) {
 			vva = 0;
 			break;
 		}
 
 		offset = iova - node->iova;
-		if (!vva)
+		if (!vva) {
 			vva = node->uaddr + offset;
+			vq->iotlb_hint = i;
+		}
+		node->last_used = ++vq->iotlb_clock;
 
 		mapped += node->size - offset;
 		iova = node->iova + node->size;
@@ -315,6 +370,7 @@ vhost_user_iotlb_init(struct virtio_net *dev, int vq_index)
 {
 	char pool_name[RTE_MEMPOOL_NAMESIZE];
 	struct vhost_virtqueue *vq = dev->virtqueue[vq_index];
+	uint32_t cache_size;
 	int socket = 0;
 
 	if (vq->iotlb_pool) {
@@ -333,9 +389,21 @@ vhost_user_iotlb_init(struct virtio_net *dev, int vq_index)
 	rte_rwlock_init(&vq->iotlb_lock);
 	rte_rwlock_init(&vq->iotlb_pending_lock);
 
-	TAILQ_INIT(&vq->iotlb_list);
 	TAILQ_INIT(&vq->iotlb_pending_list);
 
+	cache_size = dev->iotlb_cache_size ? dev->iotlb_cache_size :
+		IOTLB_CACHE_SIZE;
+
+	rte_free(vq->iotlb_cache);
+	vq->iotlb_cache = rte_malloc_socket("iotlb_cache",
+			cache_size * sizeof(*vq->iotlb_cache), 0, socket);
+	if (!vq->iotlb_cache) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+				"Failed to allocate IOTLB cache of vring %d\n",
+				vq_index);
+		return -1;
+	}
+
 	snprintf(pool_name, sizeof(pool_name), "iotlb_cache_%d_%d",
 			dev->vid, vq_index);
 
@@ -345,7 +413,7 @@ vhost_user_iotlb_init(struct virtio_net *dev, int vq_index)
 		rte_mempool_free(vq->iotlb_pool);
 
 	vq->iotlb_pool = rte_mempool_create(pool_name,
-			IOTLB_CACHE_SIZE, sizeof(struct vhost_iotlb_entry), 0,
+			cache_size, sizeof(struct vhost_iotlb_entry), 0,
 			0, 0, NULL, NULL, NULL, socket,
 			MEMPOOL_F_NO_CACHE_ALIGN |
 			MEMPOOL_F_SP_PUT |
@@ -358,6 +426,8 @@ vhost_user_iotlb_init(struct virtio_net *dev, int vq_index)
 	}
 
 	vq->iotlb_cache_nr = 0;
+	vq->iotlb_hint = 0;
+	vq->iotlb_clock = 0;
 
 	return 0;
 }
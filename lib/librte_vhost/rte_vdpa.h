@@ -16,6 +16,8 @@
 
 #define MAX_VDPA_NAME_LEN 128
 
+#define RTE_VDPA_XSTATS_NAME_SIZE 64
+
 enum vdpa_addr_type {
 	PCI_ADDR,
 	VDPA_ADDR_MAX
@@ -35,6 +37,37 @@ struct rte_vdpa_dev_addr {
 	};
 };
 
+/**
+ * vdpa queue basic statistics
+ */
+struct rte_vdpa_stats {
+	/** packets completed by the device */
+	uint64_t packets;
+	/** bytes completed by the device */
+	uint64_t bytes;
+	/** descriptor or completion errors */
+	uint64_t errors;
+	/** guest notifications relayed to the device */
+	uint64_t kicks;
+};
+
+/**
+ * vdpa queue extended statistic name
+ */
+struct rte_vdpa_xstat_name {
+	char name[RTE_VDPA_XSTATS_NAME_SIZE];
+};
+
+/**
+ * vdpa queue extended statistic value
+ */
+struct rte_vdpa_xstat {
+	/** index in the names array */
+	uint64_t id;
+	/** statistic value */
+	uint64_t value;
+};
+
 /**
  * vdpa device operations
  */
@@ -71,8 +104,25 @@ struct rte_vdpa_dev_ops {
 	int (*get_notify_area)(int vid, int qid,
 			uint64_t *offset, uint64_t *size);
 
+	/** Update the guest memory mapping after a memory table change */
+	int (*set_mem_table)(int vid);
+
+	/** Get basic statistics of a queue */
+	int (*get_stats)(int did, uint16_t qid, struct rte_vdpa_stats *stats);
+
+	/**
+	 * Get names and values of the extended statistics of a queue,
+	 * returns the number of statistics
+	 */
+	int (*get_xstats)(int did, uint16_t qid,
+			struct rte_vdpa_xstat_name *names,
+			struct rte_vdpa_xstat *xstats, unsigned int n);
+
+	/** Reset all the statistics of a queue */
+	int (*reset_stats)(int did, uint16_t qid);
+
 	/** Reserved for future extension */
-	void *reserved[5];
+	void *reserved[1];
 };
 
 /**
@@ -155,4 +205,102 @@ rte_vdpa_get_device(int did);
  */
 int __rte_experimental
 rte_vdpa_get_device_num(void);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Find the next registered vdpa device, to walk all the devices from 0.
+ *
+ * @param did
+ *  device id to start from
+ * @return
+ *  the first registered device id greater or equal to did, -1 if none
+ */
+int __rte_experimental
+rte_vdpa_find_next(int did);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Synchronize the used ring from a mediated ring to the guest, logging the
+ * dirty pages: the used entries and index copied, and the device-writable
+ * buffers of the descriptor chains they complete. Used by drivers relaying
+ * the datapath during live migration, the device writing the used entries
+ * to the mediated ring instead of the guest memory.
+ *
+ * @param vid
+ *  vhost device id
+ * @param qid
+ *  vhost queue id
+ * @param vring_m
+ *  mediated virtio ring pointer, a struct vring of the same size as the
+ *  guest vring
+ * @return
+ *  number of synced used entries on success, -1 on failure
+ */
+int __rte_experimental
+rte_vdpa_relay_vring_used(int vid, uint16_t qid, void *vring_m);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the basic statistics of a vdpa device queue
+ *
+ * @param did
+ *  device id
+ * @param qid
+ *  queue id
+ * @param stats
+ *  statistics of the queue, filled on success
+ * @return
+ *  0 on success, -ENOTSUP if the device does not report statistics,
+ *  other negative value on failure
+ */
+int __rte_experimental
+rte_vdpa_get_stats(int did, uint16_t qid, struct rte_vdpa_stats *stats);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the extended statistics of a vdpa device queue
+ *
+ * @param did
+ *  device id
+ * @param qid
+ *  queue id
+ * @param names
+ *  array filled with the statistics names, may be NULL to get the number
+ *  of statistics only
+ * @param xstats
+ *  array filled with the statistics values, may be NULL with names
+ * @param n
+ *  size of the names and xstats arrays
+ * @return
+ *  number of statistics of the queue on success, more than n if the arrays
+ *  are too small, negative value on failure
+ */
+int __rte_experimental
+rte_vdpa_get_xstats(int did, uint16_t qid, struct rte_vdpa_xstat_name *names,
+		struct rte_vdpa_xstat *xstats, unsigned int n);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Reset the basic and extended statistics of a vdpa device queue
+ *
+ * @param did
+ *  device id
+ * @param qid
+ *  queue id
+ * @return
+ *  0 on success, -ENOTSUP if the device does not report statistics,
+ *  other negative value on failure
+ */
+int __rte_experimental
+rte_vdpa_reset_stats(int did, uint16_t qid);
 #endif /* _RTE_VDPA_H_ */
@@ -24,11 +24,45 @@ extern "C" {
 #include <linux/vhost.h>
 #include <linux/virtio_ring.h>
 
+/* Declare packed ring related bits for older kernels */
+#ifndef VIRTIO_F_RING_PACKED
+
+#define VIRTIO_F_RING_PACKED 34
+
+struct vring_packed_desc {
+	uint64_t addr;
+	uint32_t len;
+	uint16_t id;
+	uint16_t flags;
+};
+
+struct vring_packed_desc_event {
+	uint16_t off_wrap;
+	uint16_t flags;
+};
+#endif
+
+/*
+ * Declare below packed ring defines unconditionally
+ * as Kernel header might use different names.
+ */
+#define VRING_DESC_F_AVAIL	(1ULL << 7)
+#define VRING_DESC_F_USED	(1ULL << 15)
+
+#define VRING_EVENT_F_ENABLE 0x0
+#define VRING_EVENT_F_DISABLE 0x1
+#define VRING_EVENT_F_DESC 0x2
+
 #define RTE_VHOST_USER_CLIENT		(1ULL << 0)
 #define RTE_VHOST_USER_NO_RECONNECT	(1ULL << 1)
 #define RTE_VHOST_USER_DEQUEUE_ZERO_COPY	(1ULL << 2)
 #define RTE_VHOST_USER_IOMMU_SUPPORT	(1ULL << 3)
 #define RTE_VHOST_USER_POSTCOPY_SUPPORT		(1ULL << 4)
+#define RTE_VHOST_USER_LOCKLESS		(1ULL << 5)
+#define RTE_VHOST_USER_PREFAULT		(1ULL << 6)
+#define RTE_VHOST_USER_SHARED_MEM	(1ULL << 7)
+#define RTE_VHOST_USER_NT_COPY		(1ULL << 8)
+#define RTE_VHOST_USER_SW_CKSUM		(1ULL << 9)
 
 /** Protocol features. */
 #ifndef VHOST_USER_PROTOCOL_F_MQ
@@ -71,6 +105,14 @@ extern "C" {
 #define VHOST_USER_PROTOCOL_F_HOST_NOTIFIER 11
 #endif
 
+#ifndef VHOST_USER_PROTOCOL_F_INFLIGHT_SHMFD
+#define VHOST_USER_PROTOCOL_F_INFLIGHT_SHMFD 12
+#endif
+
+#ifndef VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS
+#define VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS 15
+#endif
+
 /** Indicate whether protocol features negotiation is supported. */
 #ifndef VHOST_USER_F_PROTOCOL_FEATURES
 #define VHOST_USER_F_PROTOCOL_FEATURES	30
@@ -88,6 +130,7 @@ struct rte_vhost_mem_region {
 	void	 *mmap_addr;
 	uint64_t mmap_size;
 	int fd;
+	int numa_node; /**< NUMA node of the region memory, -1 if unknown */
 };
 
 /**
@@ -99,9 +142,21 @@ struct rte_vhost_memory {
 };
 
 struct rte_vhost_vring {
-	struct vring_desc	*desc;
-	struct vring_avail	*avail;
-	struct vring_used	*used;
+	RTE_STD_C11
+	union {
+		struct vring_desc	*desc;
+		struct vring_packed_desc *desc_packed;
+	};
+	RTE_STD_C11
+	union {
+		struct vring_avail	*avail;
+		struct vring_packed_desc_event *driver_event;
+	};
+	RTE_STD_C11
+	union {
+		struct vring_used	*used;
+		struct vring_packed_desc_event *device_event;
+	};
 	uint64_t		log_guest_addr;
 
 	/** Deprecated, use rte_vhost_vring_call() instead. */
@@ -297,6 +352,37 @@ rte_vhost_driver_detach_vdpa_device(const char *path);
 int __rte_experimental
 rte_vhost_driver_get_vdpa_device_id(const char *path);
 
+/**
+ * Set the number of IOTLB entries cached per virtqueue of the devices of
+ * a vhost-user socket, when VIRTIO_F_IOMMU_PLATFORM is negotiated. It
+ * takes effect on the next connections. The least recently used entry is
+ * evicted when the cache is full.
+ *
+ * @param path
+ *  The vhost-user socket file path
+ * @param size
+ *  Number of entries, 0 for the default of 2048
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_driver_set_iotlb_cache_size(const char *path, uint32_t size);
+
+/**
+ * Set the maximum number of queue pairs of the devices of a vhost-user
+ * socket, 128 by default. The virtqueue table of each device is sized
+ * from it. It takes effect on the next connections.
+ *
+ * @param path
+ *  The vhost-user socket file path
+ * @param max_queue_pairs
+ *  Number of queue pairs, between 1 and 128
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_driver_set_max_queue_num(const char *path, uint32_t max_queue_pairs);
+
 /**
  * Set the feature bits the vhost-user driver supports.
  *
@@ -508,7 +594,8 @@ struct rte_mempool;
  * @param count
  *  packets num to be enqueued
  * @return
- *  num of packets enqueued
+ *  num of packets enqueued, 0 on a virtqueue with an async channel
+ *  registered, see rte_vhost_submit_enqueue_burst()
  */
 uint16_t rte_vhost_enqueue_burst(int vid, uint16_t queue_id,
 	struct rte_mbuf **pkts, uint16_t count);
@@ -526,7 +613,9 @@ uint16_t rte_vhost_enqueue_burst(int vid, uint16_t queue_id,
  * @param pkts
  *  array to contain packets to be dequeued
  * @param count
- *  packets num to be dequeued
+ *  packets num to be dequeued, or RTE_VHOST_BURST_AUTO for the burst size
+ *  of rte_vhost_vring_get_burst_size(), pkts then holding
+ *  RTE_VHOST_BURST_MAX entries
  * @return
  *  num of packets dequeued
  */
@@ -577,6 +666,216 @@ int rte_vhost_get_vhost_vring(int vid, uint16_t vring_idx,
  */
 int rte_vhost_vring_call(int vid, uint16_t vring_idx);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Coalesce the guest signals of a vring: the used entries added by the
+ * datapath are signalled at most every usecs, or as soon as there are
+ * max_frames of them. Entries held back are signalled by the next
+ * enqueue or dequeue call on the vring, even an empty one, so the
+ * application must keep polling it. rte_vhost_vring_call() is never held
+ * back. The settings are kept when the vring is reset.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index
+ * @param usecs
+ *  Longest delay of a signal in microseconds, 0 disables coalescing
+ * @param max_frames
+ *  Used entries triggering a signal before the delay, 0 for no limit.
+ *  It needs a delay.
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_vring_set_coalesce(int vid, uint16_t vring_idx, uint32_t usecs,
+		uint16_t max_frames);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Pause the datapath of a vring, to move its polling to another lcore.
+ * The enqueue or dequeue call in progress on the vring is waited for, and
+ * the next ones return no packet until rte_vhost_vring_resume(). The used
+ * entries held back by coalescing are signalled. The vring state, e.g.
+ * the in flight asynchronous copies, is kept for the next lcore polling it.
+ *
+ * With RTE_VHOST_USER_LOCKLESS, the previous lcore must be done polling
+ * the vring before it is resumed, as the vring is meant to be polled by a
+ * single lcore at a time. The pause is kept when the vring is reset.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_vring_pause(int vid, uint16_t vring_idx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Resume the datapath of a vring paused by rte_vhost_vring_pause(). The
+ * vring may then be polled from another lcore than before the pause.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_vring_resume(int vid, uint16_t vring_idx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Bound the work of each enqueue or dequeue call on a vring of the builtin
+ * net backend, so that a guest posting long chains cannot hold the polling
+ * lcore while the other vrings starve. A burst stops once max_bytes of
+ * packet data have been processed, at least one packet being processed,
+ * and the next call resumes where it stopped. The bursts stopped early are
+ * counted in the budget_hits statistic. The budget is kept when the vring
+ * is reset.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index
+ * @param max_bytes
+ *  Bytes processed by a burst before it stops, 0 for no limit
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_vring_set_budget(int vid, uint16_t vring_idx, uint32_t max_bytes);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Hold back the used entries of the enqueue bursts on a split vring of the
+ * builtin net backend, and write them to the used ring once there are
+ * nb_entries of them, instead of at the end of each burst. When the lcore
+ * polling the vring is not on the socket of the guest memory, this saves
+ * most of the cache line transfers of the used ring and index between the
+ * sockets, at the cost of latency. A write stops at the end of the last
+ * full cache line of the used ring, the entries of the next line wait for
+ * the following write. With usecs, the entries held back for that long are
+ * all written by the next call, with or without packets. The entries are
+ * also written by a burst which could not enqueue all its packets, by a
+ * call without packets when usecs is 0, and when the vring stops, so the
+ * application must keep polling the vring. A warning is logged by the
+ * first burst of a vring polled from another socket. The setting is kept
+ * when the vring is reset.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index, of an RX queue of the guest
+ * @param nb_entries
+ *  Used entries held back before they are written, 0 to write them at
+ *  each burst
+ * @param usecs
+ *  Microseconds an entry may be held back, 0 for no bound
+ * @return
+ *  0 on success, -1 on failure, e.g. with a packed ring or an asynchronous
+ *  copy channel
+ */
+int __rte_experimental
+rte_vhost_vring_set_used_batch(int vid, uint16_t vring_idx,
+		uint16_t nb_entries, uint32_t usecs);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Pipeline the dequeue of a split vring of the builtin net backend: while
+ * a descriptor chain is copied, the head descriptors of the next 2 * depth
+ * chains are prefetched, and the first buffers of the next depth chains
+ * are translated and prefetched, so that the misses on the guest memory
+ * overlap instead of following each other. With an IOMMU, only the
+ * descriptors are prefetched, as translating the buffers ahead could miss
+ * the IOTLB. The setting is kept when the vring is reset.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index, of a TX queue of the guest
+ * @param depth
+ *  Chains prefetched ahead, at most 16, 0 to disable the pipeline
+ * @return
+ *  0 on success, -1 on failure, e.g. with a packed ring
+ */
+int __rte_experimental
+rte_vhost_vring_set_prefetch(int vid, uint16_t vring_idx, uint16_t depth);
+
+/** Largest burst size the burst size tuning may select */
+#define RTE_VHOST_BURST_MAX 32
+
+/** Count of rte_vhost_dequeue_burst() asking for the tuned burst size */
+#define RTE_VHOST_BURST_AUTO UINT16_MAX
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Tune the burst size of a vring of the builtin net backend to the traffic,
+ * instead of the one set by hand per host. The datapath measures the calls
+ * on the vring: the share of full bursts, i.e. the vring had more packets
+ * to dequeue or took all of a burst of the tuned size to enqueue, the
+ * cycles per packet, and the cycles per burst. Each period of 256 calls,
+ * the burst size doubles while most bursts are full, steps back if that
+ * made the packets cost more cycles, and halves when the bursts carry
+ * little or take longer than max_usecs.
+ *
+ * The tuned size is read with rte_vhost_vring_get_burst_size(), e.g. to
+ * gather the packets to enqueue, and is applied by rte_vhost_dequeue_burst()
+ * called with RTE_VHOST_BURST_AUTO. Tuning starts from min_burst, and the
+ * setting is kept when the vring is reset.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index
+ * @param min_burst
+ *  Smallest burst size, at least 1 when tuning
+ * @param max_burst
+ *  Largest burst size, at most RTE_VHOST_BURST_MAX, 0 to stop tuning
+ * @param max_usecs
+ *  Microseconds a burst may take, 0 for no bound
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_vring_set_burst_tune(int vid, uint16_t vring_idx,
+		uint16_t min_burst, uint16_t max_burst, uint32_t max_usecs);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the burst size recommended for a vring by its burst size tuning.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param vring_idx
+ *  vring index
+ * @return
+ *  The tuned burst size, RTE_VHOST_BURST_MAX if the vring is not tuned,
+ *  -1 on failure
+ */
+int __rte_experimental
+rte_vhost_vring_get_burst_size(int vid, uint16_t vring_idx);
+
 /**
  * Get vhost RX queue avail count.
  *
@@ -589,6 +888,49 @@ int rte_vhost_vring_call(int vid, uint16_t vring_idx);
  */
 uint32_t rte_vhost_rx_queue_count(int vid, uint16_t qid);
 
+/** Most descriptors counted in a packed vring by rte_vhost_vrings_pending() */
+#define RTE_VHOST_PACKED_PENDING_MAX 64
+
+/**
+ * A vring of a vhost device.
+ */
+struct rte_vhost_vring_ref {
+	int vid;	/**< vhost device ID */
+	uint16_t qid;	/**< virtio queue index */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the number of descriptors the guest made available and the backend
+ * did not fetch yet, for many vrings at once, to balance the vrings over
+ * polling threads or to skip the idle ones. The vrings and their rings are
+ * prefetched a few at a time, which makes it cheaper than calling
+ * rte_vhost_rx_queue_count() for each of them.
+ *
+ * A packed vring reports its available descriptors, up to
+ * RTE_VHOST_PACKED_PENDING_MAX. An invalid, disabled or unmapped vring
+ * reports 0. As rte_vhost_rx_queue_count(), it reads the vrings without
+ * locking them, so the counts are a hint which may be stale.
+ *
+ * @param vrings
+ *  Vrings to look at
+ * @param nb_vrings
+ *  Number of vrings
+ * @param pending
+ *  Filled with the number of pending descriptors of each vring
+ * @param kicked
+ *  If not NULL, a bitmap of (nb_vrings + 63) / 64 words whose bit i is set
+ *  when the guest made descriptors available in vring i since the previous
+ *  call looking at that vring
+ * @return
+ *  Number of vrings with pending descriptors, -1 on invalid arguments
+ */
+int __rte_experimental
+rte_vhost_vrings_pending(const struct rte_vhost_vring_ref *vrings,
+		uint32_t nb_vrings, uint16_t *pending, uint64_t *kicked);
+
 /**
  * Get log base and log size of the vhost device
  *
@@ -640,6 +982,296 @@ int __rte_experimental
 rte_vhost_set_vring_base(int vid, uint16_t queue_id,
 		uint16_t last_avail_idx, uint16_t last_used_idx);
 
+/**
+ * Get the number of pages the datapath of a virtqueue marked dirty in the
+ * vhost log, only pages which were not marked already are counted. The
+ * counter keeps growing across migrations, sampling it gives the dirty
+ * rate.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param queue_id
+ *  vhost queue index
+ * @param dirty_pages
+ *  the number of pages
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_get_vring_log_stats(int vid, uint16_t queue_id,
+		uint64_t *dirty_pages);
+
+/**
+ * Statistics of a vhost-user message type.
+ */
+struct rte_vhost_msg_stats {
+	uint64_t count;		/**< Messages handled */
+	uint64_t total_ns;	/**< Time spent handling them */
+	uint64_t max_ns;	/**< Longest handling */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the handling time of a vhost-user message type for a device, from
+ * the message read to its reply.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param request
+ *  vhost-user request type, as numbered by the protocol
+ * @param stats
+ *  statistics of the message type
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_get_msg_stats(int vid, uint32_t request,
+		struct rte_vhost_msg_stats *stats);
+
+/** Number of buckets of the histograms of a virtqueue. */
+#define RTE_VHOST_STATS_HIST_NR 8
+
+/**
+ * Statistics of a virtqueue. The histogram buckets count the values 1, 2,
+ * 3 to 4, 5 to 8, and so on by powers of 2, the last bucket also counts
+ * anything larger.
+ */
+struct rte_vhost_vring_stats {
+	uint64_t packets;	/**< Packets enqueued or dequeued */
+	uint64_t bytes;		/**< Bytes of these packets */
+	/** Packets per burst, the empty bursts are not counted */
+	uint64_t burst_hist[RTE_VHOST_STATS_HIST_NR];
+	/** Descriptors per chain */
+	uint64_t chain_hist[RTE_VHOST_STATS_HIST_NR];
+	/**
+	 * Bursts which ran out of available descriptors: dequeues which
+	 * got no packet, enqueues which could not take all the packets
+	 */
+	uint64_t empty_polls;
+	uint64_t guest_notifications;	/**< Interrupts sent to the guest */
+	uint64_t iotlb_misses;		/**< IOTLB misses sent to the master */
+	/** Dequeue zero copy buffers which had to be copied */
+	uint64_t zcopy_fallbacks;
+	/** Bytes of the small copies batched at the end of a burst */
+	uint64_t batch_copy_bytes;
+	uint64_t direct_copy_bytes;	/**< Bytes copied right away */
+	/** Pages marked dirty, as rte_vhost_get_vring_log_stats() */
+	uint64_t dirty_pages;
+	/** Bursts stopped by the budget of rte_vhost_vring_set_budget() */
+	uint64_t budget_hits;
+	/** Dequeued packets checksummed while copied, see SW_CKSUM */
+	uint64_t sw_cksums;
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the statistics of a virtqueue of the builtin net backend. The
+ * counters are maintained by the datapath of the virtqueue and keep
+ * growing until the virtqueue is reset; they can be read from any thread
+ * while it runs, without locking, and are a snapshot taken between two
+ * bursts. Sampling them gives the rates.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param queue_id
+ *  vhost queue index
+ * @param stats
+ *  statistics of the virtqueue
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_vring_stats_get(int vid, uint16_t queue_id,
+		struct rte_vhost_vring_stats *stats);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Find the next vhost device, to walk all the devices from 0.
+ *
+ * @param vid
+ *  vhost device ID to start from
+ * @return
+ *  the first existing device ID greater or equal to vid, -1 if none
+ */
+int __rte_experimental
+rte_vhost_find_next(int vid);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Start tracing the vring events of all the devices with TSC timestamps:
+ * available index seen by a burst, used index after a burst, guest
+ * notification, kick fd set, and vhost-user message handled. Each lcore
+ * records into its own ring, overwriting the oldest records. Tracing is
+ * only built with CONFIG_RTE_LIBRTE_VHOST_TRACE.
+ *
+ * @param nb_records
+ *  records kept per lcore, rounded up to a power of 2. The rings are
+ *  allocated by the first start, later starts reuse them.
+ * @return
+ *  0 on success, -ENOTSUP if tracing is not built, -EBUSY if it runs,
+ *  other negative value on failure
+ */
+int __rte_experimental
+rte_vhost_trace_start(uint32_t nb_records);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Stop tracing the vring events, the records are kept until the next
+ * start.
+ *
+ * @return
+ *  0 on success, -ENOTSUP if tracing is not built
+ */
+int __rte_experimental
+rte_vhost_trace_stop(void);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Write the records of the last trace to a file, to be decoded by
+ * usertools/dpdk-vhost-trace.py. Tracing must be stopped.
+ *
+ * @param path
+ *  file to write
+ * @return
+ *  0 on success, -ENOTSUP if tracing is not built, -EBUSY if it runs,
+ *  other negative value on failure
+ */
+int __rte_experimental
+rte_vhost_trace_dump(const char *path);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Set the number of threads handling the vhost-user messages, 1 by
+ * default and at most 16. The devices are spread on the threads, the
+ * messages of a device are handled in order by the same thread. With
+ * more than one thread the callbacks of different devices may run
+ * concurrently. It must be called before the first
+ * rte_vhost_driver_start().
+ *
+ * @param nr
+ *  number of threads
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_set_event_threads(unsigned int nr);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Set the maximum number of vhost devices, 1024 by default. The device
+ * table is allocated when the first device is created, it must be called
+ * before.
+ *
+ * @param max
+ *  number of devices
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_set_max_devices(uint32_t max);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Hand a device over to another process, to upgrade the application
+ * without the master renegotiating it. The negotiated features, the
+ * guest memory, the vring addresses and indexes, and the fds of the
+ * vhost-user connection, of the memory and of the vrings are sent to
+ * sockfd, a connected unix socket, where rte_vhost_state_import() is
+ * called. On success the device is destroyed in this process, else it
+ * is kept.
+ *
+ * The application must have stopped calling the datapath of the device.
+ * It must not be called from a callback of the device. Dirty page
+ * logging, IOMMU, inflight tracking, vDPA and packets in flight of the
+ * dequeue zero copy or of the asynchronous copies are not supported.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param sockfd
+ *  unix socket connected to the new process
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_state_export(int vid, int sockfd);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Take over a device exported by rte_vhost_state_export(). The path of
+ * the device must have been registered with the same features and
+ * callbacks, without starting it while the old process listens on it.
+ * The state is replayed to a new device, which is started, calling the
+ * new_device() callback, if it was running.
+ *
+ * @param sockfd
+ *  unix socket connected to the old process
+ * @return
+ *  vhost device ID on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_state_import(int sockfd);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Attach a secondary process to a device of the primary process, which
+ * serves the vhost-user socket. The guest memory is mapped at the same
+ * addresses as in the primary process, then the vrings of the device can
+ * be polled with the burst functions, rte_vhost_vring_call() and
+ * rte_vhost_get_vhost_vring(), which gives no kick eventfd.
+ *
+ * The memory table and call eventfd updates are forwarded by the primary
+ * process. Its destroy_device() callback must stop the polling of the
+ * secondary processes, which get detached once it returns.
+ *
+ * Dirty page logging, IOMMU, inflight tracking, vDPA, dequeue zero copy,
+ * the lockless mode and the asynchronous copies are not supported.
+ *
+ * @param vid
+ *  vhost device ID
+ * @return
+ *  0 on success, -EAGAIN if the device is being updated, a negative errno
+ *  value on other failures
+ */
+int __rte_experimental
+rte_vhost_mp_attach(int vid);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Detach a secondary process from a device, once its vrings are not
+ * polled anymore.
+ *
+ * @param vid
+ *  vhost device ID
+ * @return
+ *  0 on success, a negative errno value on failure
+ */
+int __rte_experimental
+rte_vhost_mp_detach(int vid);
+
 /**
  * Get vdpa device id for vhost device.
  *
@@ -651,6 +1283,38 @@ rte_vhost_set_vring_base(int vid, uint16_t queue_id,
 int __rte_experimental
 rte_vhost_get_vdpa_device_id(int vid);
 
+/**
+ * Move a vhost device to a vdpa device, the device may be running. A running
+ * device is configured in the vdpa device from the current ring state, the
+ * application must not call the vhost datapath of the device anymore.
+ *
+ * Only split rings are supported, and dequeue zero copy must be disabled.
+ *
+ * @param vid
+ *  vhost device id
+ * @param did
+ *  vdpa device id
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_attach_vdpa_device(int vid, int did);
+
+/**
+ * Move a vhost device from its vdpa device back to the software datapath,
+ * the device may be running. A running device is closed in the vdpa device,
+ * which saves the ring state in the vhost virtqueues, then the application
+ * can call the vhost datapath of the device, e.g. rte_vhost_enqueue_burst(),
+ * without any reset of the guest.
+ *
+ * @param vid
+ *  vhost device id
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_detach_vdpa_device(int vid);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#ifndef _RTE_VHOST_ASYNC_H_
+#define _RTE_VHOST_ASYNC_H_
+
+/**
+ * @file
+ * Interface to offload the guest RX copies of a vhost device to an
+ * asynchronous copy channel, e.g. a DMA engine driven by the application.
+ */
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <rte_compat.h>
+#include <rte_mbuf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Copy job of one packet. src[i] is copied to dst[i] for each segment,
+ * both have the same length. Addresses are host virtual addresses: mbuf
+ * data for the sources, guest memory for the destinations.
+ */
+struct rte_vhost_async_desc {
+	struct iovec *src;
+	struct iovec *dst;
+	uint16_t nr_segs;
+};
+
+/**
+ * Asynchronous copy channel of a virtqueue.
+ */
+struct rte_vhost_async_channel_ops {
+	/**
+	 * Submit the copy jobs of count packets. A packet may have no
+	 * segment when all its copies were done by the CPU, it still
+	 * takes its place in the completion order.
+	 *
+	 * @return
+	 *  Number of packets accepted, from the first one.
+	 */
+	uint16_t (*transfer_data)(int vid, uint16_t queue_id,
+			struct rte_vhost_async_desc *descs, uint16_t count);
+	/**
+	 * Check for completed packets, in the submission order.
+	 *
+	 * @return
+	 *  Number of packets whose copies are all done, at most max_packets.
+	 */
+	uint16_t (*check_completed_copies)(int vid, uint16_t queue_id,
+			uint16_t max_packets);
+};
+
+/**
+ * Register an asynchronous copy channel for an RX virtqueue. Only split
+ * rings are supported.
+ *
+ * @param vid
+ *  vhost device id
+ * @param queue_id
+ *  virtqueue id, an RX virtqueue of the guest
+ * @param threshold
+ *  Copies of at least this length go to the channel, smaller ones are
+ *  done by the CPU. The CPU does all the copies while dirty pages are
+ *  logged for a migration.
+ * @param ops
+ *  Operations of the channel, the structure is copied
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_async_channel_register(int vid, uint16_t queue_id,
+		uint32_t threshold, struct rte_vhost_async_channel_ops *ops);
+
+/**
+ * Unregister the asynchronous copy channel of a virtqueue, no packet must
+ * be in flight anymore.
+ *
+ * @param vid
+ *  vhost device id
+ * @param queue_id
+ *  virtqueue id
+ * @return
+ *  0 on success, -1 on failure
+ */
+int __rte_experimental
+rte_vhost_async_channel_unregister(int vid, uint16_t queue_id);
+
+/**
+ * Enqueue packets to the guest through the asynchronous copy channel. The
+ * packets are owned by vhost until rte_vhost_poll_enqueue_completed()
+ * returns them, the guest gets them in order once their copies are done.
+ *
+ * @param vid
+ *  vhost device id
+ * @param queue_id
+ *  virtqueue id
+ * @param pkts
+ *  Packets to enqueue
+ * @param count
+ *  Number of packets
+ * @return
+ *  Number of packets submitted
+ */
+uint16_t __rte_experimental
+rte_vhost_submit_enqueue_burst(int vid, uint16_t queue_id,
+		struct rte_mbuf **pkts, uint16_t count);
+
+/**
+ * Complete the packets of the asynchronous channel whose copies are done:
+ * write their used entries, notify the guest, and return the packets to
+ * the caller who frees them.
+ *
+ * @param vid
+ *  vhost device id
+ * @param queue_id
+ *  virtqueue id
+ * @param pkts
+ *  Array receiving the completed packets
+ * @param count
+ *  Size of the array
+ * @return
+ *  Number of packets completed
+ */
+uint16_t __rte_experimental
+rte_vhost_poll_enqueue_completed(int vid, uint16_t queue_id,
+		struct rte_mbuf **pkts, uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_VHOST_ASYNC_H_ */
@@ -95,8 +95,9 @@ rte_vhost_crypto_fetch_requests(int vid, uint32_t qid,
  * @param nb_ops
  *  The number of operations contained in the array.
  * @callfds
- *  The callfd number(s) contained in this burst, this shall be an array with
- *  no less than VIRTIO_CRYPTO_MAX_NUM_BURST_VQS elements.
+ *  The callfd number(s) contained in this burst, one per virt-queue the ops
+ *  belong to, this shall be an array with no less than
+ *  VIRTIO_CRYPTO_MAX_NUM_BURST_VQS elements.
  * @nb_callfds
  *  The number of call_fd numbers exist in the callfds.
  * @return
@@ -38,8 +38,15 @@ struct vhost_user_socket {
 	bool is_server;
 	bool reconnect;
 	bool dequeue_zero_copy;
+	bool lockless;
+	bool prefault;
+	bool shared_mem;
+	bool nt_copy;
+	bool sw_cksum;
 	bool iommu_support;
 	bool use_builtin_virtio_net;
+	uint32_t iotlb_cache_size;
+	uint32_t max_queue_pairs;
 
 	/*
 	 * The "supported_features" indicates the feature bits the
@@ -65,6 +72,7 @@ struct vhost_user_socket {
 
 struct vhost_user_connection {
 	struct vhost_user_socket *vsocket;
+	struct fdset *fdset;	/* event thread handling the messages */
 	int connfd;
 	int vid;
 
@@ -72,9 +80,17 @@ struct vhost_user_connection {
 };
 
 #define MAX_VHOST_SOCKET 1024
+#define MAX_VHOST_EVENT_THREADS 16
 struct vhost_user {
 	struct vhost_user_socket *vsockets[MAX_VHOST_SOCKET];
-	struct fdset fdset;
+	/*
+	 * One fdset per event thread. The listen fds are in the first
+	 * one, the connections are spread by vid, so the messages of a
+	 * device are handled in order by one thread.
+	 */
+	struct fdset fdset[MAX_VHOST_EVENT_THREADS];
+	pthread_t fdset_tid[MAX_VHOST_EVENT_THREADS];
+	unsigned int nr_fdsets;
 	int vsocket_cnt;
 	pthread_mutex_t mutex;
 };
@@ -87,11 +103,8 @@ static int create_unix_socket(struct vhost_user_socket *vsocket);
 static int vhost_user_start_client(struct vhost_user_socket *vsocket);
 
 static struct vhost_user vhost_user = {
-	.fdset = {
-		.fd = { [0 ... MAX_FDS - 1] = {-1, NULL, NULL, NULL, 0} },
-		.fd_mutex = PTHREAD_MUTEX_INITIALIZER,
-		.num = 0
-	},
+	.fdset = { [0 ... MAX_VHOST_EVENT_THREADS - 1] = FDSET_INITIALIZER },
+	.nr_fdsets = 1,
 	.vsocket_cnt = 0,
 	.mutex = PTHREAD_MUTEX_INITIALIZER,
 };
@@ -199,8 +212,9 @@ send_fd_message(int sockfd, char *buf, int buflen, int *fds, int fd_num)
 	return ret;
 }
 
-static void
-vhost_user_add_connection(int fd, struct vhost_user_socket *vsocket)
+/* Create the device of a new connection, which owns fd */
+static struct vhost_user_connection *
+vhost_user_new_connection(int fd, struct vhost_user_socket *vsocket)
 {
 	int vid;
 	size_t size;
@@ -208,15 +222,15 @@ vhost_user_add_connection(int fd, struct vhost_user_socket *vsocket)
 	int ret;
 
 	if (vsocket == NULL)
-		return;
+		return NULL;
 
 	conn = malloc(sizeof(*conn));
 	if (conn == NULL) {
 		close(fd);
-		return;
+		return NULL;
 	}
 
-	vid = vhost_new_device();
+	vid = vhost_new_device(vsocket->max_queue_pairs);
 	if (vid == -1) {
 		goto err;
 	}
@@ -228,9 +242,26 @@ vhost_user_add_connection(int fd, struct vhost_user_socket *vsocket)
 
 	vhost_attach_vdpa_device(vid, vsocket->vdpa_dev_id);
 
+	vhost_set_iotlb_cache_size(vid, vsocket->iotlb_cache_size);
+
 	if (vsocket->dequeue_zero_copy)
 		vhost_enable_dequeue_zero_copy(vid);
 
+	if (vsocket->lockless)
+		vhost_enable_lockless(vid);
+
+	if (vsocket->prefault)
+		vhost_enable_prefault(vid);
+
+	if (vsocket->shared_mem)
+		vhost_enable_shared_mem(vid);
+
+	if (vsocket->nt_copy)
+		vhost_enable_nt_copy(vid);
+
+	if (vsocket->sw_cksum)
+		vhost_enable_sw_cksum(vid);
+
 	RTE_LOG(INFO, VHOST_CONFIG, "new device, handle is %d\n", vid);
 
 	if (vsocket->notify_ops->new_connection) {
@@ -245,30 +276,59 @@ vhost_user_add_connection(int fd, struct vhost_user_socket *vsocket)
 
 	conn->connfd = fd;
 	conn->vsocket = vsocket;
+	conn->fdset = &vhost_user.fdset[vid % vhost_user.nr_fdsets];
 	conn->vid = vid;
-	ret = fdset_add(&vhost_user.fdset, fd, vhost_user_read_cb,
+
+	return conn;
+
+err:
+	free(conn);
+	close(fd);
+	return NULL;
+}
+
+/* Start handling the messages of a connection */
+static int
+vhost_user_poll_connection(struct vhost_user_connection *conn)
+{
+	struct vhost_user_socket *vsocket = conn->vsocket;
+	int ret;
+
+	/*
+	 * The fd is polled as soon as it is added, list conn at the same
+	 * time for the read callback to find it.
+	 */
+	pthread_mutex_lock(&vsocket->conn_mutex);
+	ret = fdset_add(conn->fdset, conn->connfd, vhost_user_read_cb,
 			NULL, conn);
 	if (ret < 0) {
+		pthread_mutex_unlock(&vsocket->conn_mutex);
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"failed to add fd %d into vhost server fdset\n",
-			fd);
+			conn->connfd);
 
 		if (vsocket->notify_ops->destroy_connection)
 			vsocket->notify_ops->destroy_connection(conn->vid);
 
-		goto err;
+		close(conn->connfd);
+		free(conn);
+		return -1;
 	}
-
-	pthread_mutex_lock(&vsocket->conn_mutex);
 	TAILQ_INSERT_TAIL(&vsocket->conn_list, conn, next);
 	pthread_mutex_unlock(&vsocket->conn_mutex);
 
-	fdset_pipe_notify(&vhost_user.fdset);
-	return;
+	fdset_pipe_notify(conn->fdset);
+	return 0;
+}
 
-err:
-	free(conn);
-	close(fd);
+static void
+vhost_user_add_connection(int fd, struct vhost_user_socket *vsocket)
+{
+	struct vhost_user_connection *conn;
+
+	conn = vhost_user_new_connection(fd, vsocket);
+	if (conn != NULL)
+		vhost_user_poll_connection(conn);
 }
 
 /* call back when there is new vhost-user connection from client  */
@@ -373,7 +433,8 @@ vhost_user_start_server(struct vhost_user_socket *vsocket)
 	if (ret < 0)
 		goto err;
 
-	ret = fdset_add(&vhost_user.fdset, fd, vhost_user_server_new_connection,
+	ret = fdset_add(&vhost_user.fdset[0], fd,
+		  vhost_user_server_new_connection,
 		  NULL, vsocket);
 	if (ret < 0) {
 		RTE_LOG(ERR, VHOST_CONFIG,
@@ -602,6 +663,41 @@ rte_vhost_driver_get_vdpa_device_id(const char *path)
 	return did;
 }
 
+int
+rte_vhost_driver_set_iotlb_cache_size(const char *path, uint32_t size)
+{
+	struct vhost_user_socket *vsocket;
+
+	pthread_mutex_lock(&vhost_user.mutex);
+	vsocket = find_vhost_user_socket(path);
+	if (vsocket)
+		vsocket->iotlb_cache_size = size;
+	pthread_mutex_unlock(&vhost_user.mutex);
+
+	return vsocket ? 0 : -1;
+}
+
+int __rte_experimental
+rte_vhost_driver_set_max_queue_num(const char *path, uint32_t max_queue_pairs)
+{
+	struct vhost_user_socket *vsocket;
+
+	if (max_queue_pairs == 0 || max_queue_pairs > VHOST_MAX_QUEUE_PAIRS) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"queue pairs must be between 1 and %d\n",
+			VHOST_MAX_QUEUE_PAIRS);
+		return -1;
+	}
+
+	pthread_mutex_lock(&vhost_user.mutex);
+	vsocket = find_vhost_user_socket(path);
+	if (vsocket)
+		vsocket->max_queue_pairs = max_queue_pairs;
+	pthread_mutex_unlock(&vhost_user.mutex);
+
+	return vsocket ? 0 : -1;
+}
+
 int
 rte_vhost_driver_disable_features(const char *path, uint64_t features)
 {
@@ -770,7 +866,7 @@ rte_vhost_driver_get_queue_num(const char *path, uint32_t *queue_num)
 	did = vsocket->vdpa_dev_id;
 	vdpa_dev = rte_vdpa_get_device(did);
 	if (!vdpa_dev || !vdpa_dev->ops->get_queue_num) {
-		*queue_num = VHOST_MAX_QUEUE_PAIRS;
+		*queue_num = vsocket->max_queue_pairs;
 		goto unlock_exit;
 	}
 
@@ -782,7 +878,7 @@ rte_vhost_driver_get_queue_num(const char *path, uint32_t *queue_num)
 		goto unlock_exit;
 	}
 
-	*queue_num = RTE_MIN((uint32_t)VHOST_MAX_QUEUE_PAIRS, vdpa_queue_num);
+	*queue_num = RTE_MIN(vsocket->max_queue_pairs, vdpa_queue_num);
 
 unlock_exit:
 	pthread_mutex_unlock(&vhost_user.mutex);
@@ -817,6 +913,8 @@ rte_vhost_driver_register(const char *path, uint64_t flags)
 	if (!path)
 		return -1;
 
+	vhost_mp_init();
+
 	pthread_mutex_lock(&vhost_user.mutex);
 
 	if (vhost_user.vsocket_cnt == MAX_VHOST_SOCKET) {
@@ -845,6 +943,19 @@ rte_vhost_driver_register(const char *path, uint64_t flags)
 	}
 	vsocket->dequeue_zero_copy = flags & RTE_VHOST_USER_DEQUEUE_ZERO_COPY;
 
+	vsocket->lockless = flags & RTE_VHOST_USER_LOCKLESS;
+	if (vsocket->lockless && vhost_lockless_init() < 0) {
+		RTE_LOG(WARNING, VHOST_CONFIG,
+			"membarrier unsupported, lockless mode disabled\n");
+		vsocket->lockless = false;
+	}
+
+	vsocket->prefault = flags & RTE_VHOST_USER_PREFAULT;
+	vsocket->shared_mem = flags & RTE_VHOST_USER_SHARED_MEM;
+	vsocket->nt_copy = flags & RTE_VHOST_USER_NT_COPY;
+	vsocket->sw_cksum = flags & RTE_VHOST_USER_SW_CKSUM;
+	vsocket->max_queue_pairs = VHOST_MAX_QUEUE_PAIRS;
+
 	/*
 	 * Set the supported features correctly for the builtin vhost-user
 	 * net driver.
@@ -875,6 +986,10 @@ rte_vhost_driver_register(const char *path, uint64_t flags)
 			"Dequeue zero copy requested, disabling postcopy support\n");
 		vsocket->protocol_features &=
 			~(1ULL << VHOST_USER_PROTOCOL_F_PAGEFAULT);
+
+		/* Zero copy buffers are given back out of order */
+		vsocket->protocol_features &=
+			~(1ULL << VHOST_USER_PROTOCOL_F_INFLIGHT_SHMFD);
 	}
 
 	if (!(flags & RTE_VHOST_USER_IOMMU_SUPPORT)) {
@@ -886,6 +1001,19 @@ rte_vhost_driver_register(const char *path, uint64_t flags)
 		vsocket->protocol_features &=
 			~(1ULL << VHOST_USER_PROTOCOL_F_PAGEFAULT);
 	} else {
+		/*
+		 * Postcopy needs the userfaultfd registration done on
+		 * VHOST_USER_SET_MEM_TABLE, which isn't sent any more once
+		 * memory slots are negotiated.
+		 */
+		vsocket->protocol_features &=
+			~(1ULL << VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS);
+
+		if (vsocket->prefault) {
+			RTE_LOG(INFO, VHOST_CONFIG,
+				"Postcopy requested, disabling prefault\n");
+			vsocket->prefault = false;
+		}
 #ifndef RTE_LIBRTE_VHOST_POSTCOPY
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"Postcopy requested but not compiled\n");
@@ -978,7 +1106,7 @@ rte_vhost_driver_unregister(const char *path)
 				 * conn_mutex lock, and try again since
 				 * the r/wcb may use the conn_mutex lock.
 				 */
-				if (fdset_try_del(&vhost_user.fdset,
+				if (fdset_try_del(conn->fdset,
 						  conn->connfd) == -1) {
 					pthread_mutex_unlock(
 							&vsocket->conn_mutex);
@@ -996,7 +1124,7 @@ rte_vhost_driver_unregister(const char *path)
 			pthread_mutex_unlock(&vsocket->conn_mutex);
 
 			if (vsocket->is_server) {
-				fdset_del(&vhost_user.fdset,
+				fdset_del(&vhost_user.fdset[0],
 						vsocket->socket_fd);
 				close(vsocket->socket_fd);
 				unlink(path);
@@ -1050,44 +1178,227 @@ vhost_driver_callback_get(const char *path)
 	return vsocket ? vsocket->notify_ops : NULL;
 }
 
-int
-rte_vhost_driver_start(const char *path)
+/* Called with vhost_user.mutex held */
+static int
+vhost_user_start_event_threads(void)
 {
-	struct vhost_user_socket *vsocket;
-	static pthread_t fdset_tid;
-
-	pthread_mutex_lock(&vhost_user.mutex);
-	vsocket = find_vhost_user_socket(path);
-	pthread_mutex_unlock(&vhost_user.mutex);
+	char name[RTE_MAX_THREAD_NAME_LEN];
+	struct fdset *fdset;
+	unsigned int i;
+	int ret;
 
-	if (!vsocket)
-		return -1;
+	for (i = 0; i < vhost_user.nr_fdsets; i++) {
+		if (vhost_user.fdset_tid[i] != 0)
+			continue;
 
-	if (fdset_tid == 0) {
+		fdset = &vhost_user.fdset[i];
 		/**
-		 * create a pipe which will be waited by poll and notified to
-		 * rebuild the wait list of poll.
+		 * create a pipe which will be waited by epoll and notified to
+		 * wake up the event dispatch thread.
 		 */
-		if (fdset_pipe_init(&vhost_user.fdset) < 0) {
+		if (fdset_pipe_init(fdset) < 0) {
 			RTE_LOG(ERR, VHOST_CONFIG,
 				"failed to create pipe for vhost fdset\n");
 			return -1;
 		}
 
-		int ret = rte_ctrl_thread_create(&fdset_tid,
-			"vhost-events", NULL, fdset_event_dispatch,
-			&vhost_user.fdset);
+		if (i == 0)
+			snprintf(name, sizeof(name), "vhost-events");
+		else
+			snprintf(name, sizeof(name), "vhost-events-%u", i);
+		ret = rte_ctrl_thread_create(&vhost_user.fdset_tid[i],
+			name, NULL, fdset_event_dispatch, fdset);
 		if (ret != 0) {
 			RTE_LOG(ERR, VHOST_CONFIG,
 				"failed to create fdset handling thread");
 
-			fdset_pipe_uninit(&vhost_user.fdset);
+			fdset_pipe_uninit(fdset);
+			vhost_user.fdset_tid[i] = 0;
 			return -1;
 		}
 	}
 
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_set_event_threads(unsigned int nr)
+{
+	int ret = -1;
+
+	if (nr == 0 || nr > MAX_VHOST_EVENT_THREADS) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"event threads must be between 1 and %d\n",
+			MAX_VHOST_EVENT_THREADS);
+		return -1;
+	}
+
+	pthread_mutex_lock(&vhost_user.mutex);
+	/* Devices are spread on the fdsets by vid, it cannot change. */
+	if (vhost_user.fdset_tid[0] != 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"event threads are already started\n");
+		goto out;
+	}
+	vhost_user.nr_fdsets = nr;
+	ret = 0;
+out:
+	pthread_mutex_unlock(&vhost_user.mutex);
+
+	return ret;
+}
+
+int
+rte_vhost_driver_start(const char *path)
+{
+	struct vhost_user_socket *vsocket;
+	int ret;
+
+	pthread_mutex_lock(&vhost_user.mutex);
+	vsocket = find_vhost_user_socket(path);
+	ret = vsocket ? vhost_user_start_event_threads() : -1;
+	pthread_mutex_unlock(&vhost_user.mutex);
+
+	if (ret < 0)
+		return -1;
+
 	if (vsocket->is_server)
 		return vhost_user_start_server(vsocket);
 	else
 		return vhost_user_start_client(vsocket);
 }
+
+int __rte_experimental
+rte_vhost_state_export(int vid, int sockfd)
+{
+	struct vhost_user_socket *vsocket = NULL;
+	struct vhost_user_connection *conn = NULL;
+	int i;
+
+	pthread_mutex_lock(&vhost_user.mutex);
+	for (i = 0; conn == NULL && i < vhost_user.vsocket_cnt; i++) {
+		vsocket = vhost_user.vsockets[i];
+again:
+		pthread_mutex_lock(&vsocket->conn_mutex);
+		TAILQ_FOREACH(conn, &vsocket->conn_list, next) {
+			if (conn->vid != vid)
+				continue;
+
+			/* Stop handling the messages of the device */
+			if (fdset_try_del(conn->fdset, conn->connfd) == -1) {
+				pthread_mutex_unlock(&vsocket->conn_mutex);
+				goto again;
+			}
+			TAILQ_REMOVE(&vsocket->conn_list, conn, next);
+			break;
+		}
+		pthread_mutex_unlock(&vsocket->conn_mutex);
+	}
+	pthread_mutex_unlock(&vhost_user.mutex);
+
+	if (conn == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) no vhost-user connection to export\n", vid);
+		return -1;
+	}
+
+	if (vhost_user_state_save(vid, conn->connfd, sockfd) < 0) {
+		/* Keep on serving the device */
+		vhost_user_poll_connection(conn);
+		return -1;
+	}
+
+	/* The importer holds its own references to the fds */
+	close(conn->connfd);
+	vhost_destroy_device(vid);
+
+	if (vsocket->notify_ops->destroy_connection)
+		vsocket->notify_ops->destroy_connection(vid);
+
+	free(conn);
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_state_import(int sockfd)
+{
+	struct vhost_user_socket *vsocket;
+	struct vhost_user_connection *conn;
+	struct vhost_state_dev *state;
+	int fds[VHOST_STATE_MAX_FDS];
+	int32_t status = -1;
+	int fd_num = 0;
+	int i, vid;
+
+	state = malloc(sizeof(*state));
+	if (state == NULL)
+		goto out;
+
+	fd_num = vhost_user_state_recv(sockfd, state, fds);
+	if (fd_num < 0) {
+		fd_num = 0;
+		goto out;
+	}
+
+	pthread_mutex_lock(&vhost_user.mutex);
+	vsocket = find_vhost_user_socket(state->ifname);
+	if (vsocket != NULL && vhost_user_start_event_threads() < 0)
+		vsocket = NULL;
+	pthread_mutex_unlock(&vhost_user.mutex);
+
+	if (vsocket == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"no vhost-user socket registered for %s\n",
+			state->ifname);
+		goto out;
+	}
+
+	/* The connection owns fds[0] */
+	conn = vhost_user_new_connection(fds[0], vsocket);
+	fds[0] = -1;
+	if (conn == NULL)
+		goto out;
+	vid = conn->vid;
+
+	if (vhost_user_state_load(vid, state, fds, sockfd) < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) failed to import the device state\n", vid);
+		goto destroy;
+	}
+
+	/* Let the exporter release the device before serving it */
+	status = vid;
+	if (send_fd_message(sockfd, (char *)&status, sizeof(status),
+			    NULL, 0) < 0) {
+		status = -1;
+		goto destroy;
+	}
+
+	if (vhost_user_poll_connection(conn) < 0) {
+		vhost_destroy_device(vid);
+		vid = -1;
+	}
+
+	for (i = 0; i < fd_num; i++)
+		if (fds[i] >= 0)
+			close(fds[i]);
+	free(state);
+	return vid;
+
+destroy:
+	close(conn->connfd);
+	vhost_destroy_device(vid);
+	if (vsocket->notify_ops->destroy_connection)
+		vsocket->notify_ops->destroy_connection(vid);
+	free(conn);
+out:
+	for (i = 0; i < fd_num; i++)
+		if (fds[i] >= 0)
+			close(fds[i]);
+	free(state);
+	/* The exporter keeps on serving the device */
+	status = -1;
+	send_fd_message(sockfd, (char *)&status, sizeof(status), NULL, 0);
+	return -1;
+}
@@ -0,0 +1,250 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2018 Intel Corporation
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_spinlock.h>
+
+#include "vhost.h"
+
+#ifdef RTE_LIBRTE_VHOST_TRACE
+
+#define VHOST_TRACE_MAGIC	"VHOSTTRC"
+#define VHOST_TRACE_VERSION	1
+
+struct vhost_trace_file_hdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t nr_bufs;
+	uint64_t tsc_hz;
+};
+
+struct vhost_trace_buf_hdr {
+	/* LCORE_ID_ANY for the buffer of the other threads */
+	uint32_t lcore_id;
+	uint32_t nr_records;
+};
+
+volatile int vhost_trace_on;
+uint32_t vhost_trace_mask;
+struct vhost_trace_buf *vhost_trace_bufs[VHOST_TRACE_NR_BUFS];
+
+static rte_spinlock_t vhost_trace_ctrl_lock = RTE_SPINLOCK_INITIALIZER;
+/* Serializes start, stop and dump. */
+static rte_spinlock_t vhost_trace_lock = RTE_SPINLOCK_INITIALIZER;
+
+void
+vhost_trace_ctrl(uint16_t vid, uint16_t qid, uint16_t event, uint16_t idx)
+{
+	struct vhost_trace_buf *buf = vhost_trace_bufs[VHOST_TRACE_CTRL_BUF];
+	struct vhost_trace_record *rec;
+
+	if (buf == NULL)
+		return;
+
+	rte_spinlock_lock(&vhost_trace_ctrl_lock);
+	rec = &buf->recs[buf->head & vhost_trace_mask];
+	rec->tsc = rte_rdtsc();
+	rec->vid = vid;
+	rec->qid = qid;
+	rec->event = event;
+	rec->idx = idx;
+	buf->head++;
+	rte_spinlock_unlock(&vhost_trace_ctrl_lock);
+}
+
+static void
+vhost_trace_free(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < VHOST_TRACE_NR_BUFS; i++) {
+		rte_free(vhost_trace_bufs[i]);
+		vhost_trace_bufs[i] = NULL;
+	}
+}
+
+int __rte_experimental
+rte_vhost_trace_start(uint32_t nb_records)
+{
+	uint32_t i, size;
+	int ret = 0;
+
+	if (nb_records == 0 || nb_records > (1U << 31))
+		return -EINVAL;
+
+	rte_spinlock_lock(&vhost_trace_lock);
+
+	if (vhost_trace_on) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	/*
+	 * The buffers are kept once allocated: a writer may still be
+	 * finishing a record of the previous run.
+	 */
+	if (vhost_trace_mask != 0) {
+		for (i = 0; i < VHOST_TRACE_NR_BUFS; i++) {
+			if (vhost_trace_bufs[i] != NULL)
+				vhost_trace_bufs[i]->head = 0;
+		}
+		goto start;
+	}
+
+	size = rte_align32pow2(nb_records);
+	for (i = 0; i < VHOST_TRACE_NR_BUFS; i++) {
+		if (i != VHOST_TRACE_CTRL_BUF && !rte_lcore_is_enabled(i))
+			continue;
+
+		vhost_trace_bufs[i] = rte_zmalloc("vhost_trace",
+				sizeof(struct vhost_trace_buf) +
+				size * sizeof(struct vhost_trace_record),
+				RTE_CACHE_LINE_SIZE);
+		if (vhost_trace_bufs[i] == NULL) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"failed to allocate trace buffer of %u records\n",
+				size);
+			vhost_trace_free();
+			ret = -ENOMEM;
+			goto out;
+		}
+	}
+	vhost_trace_mask = size - 1;
+
+start:
+	rte_smp_wmb();
+	vhost_trace_on = 1;
+out:
+	rte_spinlock_unlock(&vhost_trace_lock);
+
+	return ret;
+}
+
+int __rte_experimental
+rte_vhost_trace_stop(void)
+{
+	rte_spinlock_lock(&vhost_trace_lock);
+	vhost_trace_on = 0;
+	rte_spinlock_unlock(&vhost_trace_lock);
+
+	return 0;
+}
+
+static int
+vhost_trace_dump_buf(FILE *f, uint32_t lcore_id, struct vhost_trace_buf *buf)
+{
+	struct vhost_trace_buf_hdr hdr;
+	uint32_t size = vhost_trace_mask + 1;
+	uint32_t first;
+
+	hdr.lcore_id = lcore_id;
+	if (buf->head <= size) {
+		hdr.nr_records = buf->head;
+		first = 0;
+	} else {
+		hdr.nr_records = size;
+		first = buf->head & vhost_trace_mask;
+	}
+
+	if (fwrite(&hdr, sizeof(hdr), 1, f) != 1)
+		return -1;
+
+	/* Oldest first: the end of the ring, then its start. */
+	if (fwrite(&buf->recs[first], sizeof(buf->recs[0]),
+				hdr.nr_records - first, f) !=
+			hdr.nr_records - first)
+		return -1;
+	if (first != 0 && fwrite(&buf->recs[0], sizeof(buf->recs[0]),
+				first, f) != first)
+		return -1;
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_trace_dump(const char *path)
+{
+	struct vhost_trace_file_hdr hdr;
+	FILE *f;
+	uint32_t i;
+	int ret = 0;
+
+	if (path == NULL)
+		return -EINVAL;
+
+	rte_spinlock_lock(&vhost_trace_lock);
+
+	if (vhost_trace_on) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	f = fopen(path, "w");
+	if (f == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG, "failed to open %s: %s\n",
+			path, strerror(errno));
+		ret = -errno;
+		goto out;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, VHOST_TRACE_MAGIC, sizeof(hdr.magic));
+	hdr.version = VHOST_TRACE_VERSION;
+	for (i = 0; i < VHOST_TRACE_NR_BUFS; i++) {
+		if (vhost_trace_bufs[i] != NULL)
+			hdr.nr_bufs++;
+	}
+	hdr.tsc_hz = rte_get_tsc_hz();
+
+	if (fwrite(&hdr, sizeof(hdr), 1, f) != 1)
+		ret = -EIO;
+
+	for (i = 0; ret == 0 && i < VHOST_TRACE_NR_BUFS; i++) {
+		if (vhost_trace_bufs[i] == NULL)
+			continue;
+		if (vhost_trace_dump_buf(f, i == VHOST_TRACE_CTRL_BUF ?
+					LCORE_ID_ANY : i,
+					vhost_trace_bufs[i]) < 0)
+			ret = -EIO;
+	}
+
+	if (fclose(f) != 0 && ret == 0)
+		ret = -EIO;
+	if (ret < 0)
+		RTE_LOG(ERR, VHOST_CONFIG, "failed to write %s\n", path);
+out:
+	rte_spinlock_unlock(&vhost_trace_lock);
+
+	return ret;
+}
+
+#else
+
+int __rte_experimental
+rte_vhost_trace_start(uint32_t nb_records __rte_unused)
+{
+	return -ENOTSUP;
+}
+
+int __rte_experimental
+rte_vhost_trace_stop(void)
+{
+	return -ENOTSUP;
+}
+
+int __rte_experimental
+rte_vhost_trace_dump(const char *path __rte_unused)
+{
+	return -ENOTSUP;
+}
+
+#endif /* RTE_LIBRTE_VHOST_TRACE */
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2018 Intel Corporation
+ */
+
+#ifndef _VHOST_TRACE_H_
+#define _VHOST_TRACE_H_
+
+/*
+ * Binary trace of the vring events, built with
+ * CONFIG_RTE_LIBRTE_VHOST_TRACE and controlled with rte_vhost_trace_*().
+ * Each lcore records into its own ring, the threads which are not EAL
+ * lcores share a locked one.
+ */
+
+#include <stdint.h>
+
+#include <rte_branch_prediction.h>
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+
+enum vhost_trace_event {
+	VHOST_TRACE_AVAIL = 1,	/* idx: available index seen by a burst */
+	VHOST_TRACE_USED,	/* idx: used index after a burst */
+	VHOST_TRACE_CALL,	/* idx: used index signalled to the guest */
+	VHOST_TRACE_KICKFD,	/* idx: last available index at kick fd set */
+	VHOST_TRACE_MSG,	/* idx: vhost-user request handled */
+};
+
+/* Layout of the dump, see usertools/dpdk-vhost-trace.py */
+struct vhost_trace_record {
+	uint64_t tsc;
+	uint16_t vid;
+	uint16_t qid;
+	uint16_t event;
+	uint16_t idx;
+};
+
+#ifdef RTE_LIBRTE_VHOST_TRACE
+
+struct vhost_trace_buf {
+	/* Number of records written, wraps on the ring */
+	uint32_t head;
+	struct vhost_trace_record recs[];
+};
+
+/* The extra buffer is shared by the threads which are not EAL lcores. */
+#define VHOST_TRACE_CTRL_BUF	RTE_MAX_LCORE
+#define VHOST_TRACE_NR_BUFS	(RTE_MAX_LCORE + 1)
+
+extern volatile int vhost_trace_on;
+extern uint32_t vhost_trace_mask;
+extern struct vhost_trace_buf *vhost_trace_bufs[VHOST_TRACE_NR_BUFS];
+
+void vhost_trace_ctrl(uint16_t vid, uint16_t qid, uint16_t event,
+		uint16_t idx);
+
+static __rte_always_inline void
+vhost_trace(uint16_t vid, uint16_t qid, uint16_t event, uint16_t idx)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct vhost_trace_buf *buf;
+	struct vhost_trace_record *rec;
+
+	if (unlikely(lcore_id >= RTE_MAX_LCORE ||
+			vhost_trace_bufs[lcore_id] == NULL)) {
+		vhost_trace_ctrl(vid, qid, event, idx);
+		return;
+	}
+
+	buf = vhost_trace_bufs[lcore_id];
+	rec = &buf->recs[buf->head & vhost_trace_mask];
+	rec->tsc = rte_rdtsc();
+	rec->vid = vid;
+	rec->qid = qid;
+	rec->event = event;
+	rec->idx = idx;
+	buf->head++;
+}
+
+/* The arguments are only evaluated while tracing runs. */
+#define VHOST_TRACE(vid, qid, event, idx) do {				\
+	if (unlikely(vhost_trace_on))					\
+		vhost_trace((vid), (qid), VHOST_TRACE_ ## event, (idx));	\
+} while (0)
+
+#else
+
+#define VHOST_TRACE(vid, qid, event, idx) do { } while (0)
+
+#endif /* RTE_LIBRTE_VHOST_TRACE */
+
+#endif /* _VHOST_TRACE_H_ */
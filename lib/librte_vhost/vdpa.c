@@ -8,9 +8,13 @@
  * Device specific vhost lib
  */
 
+#include <errno.h>
 #include <stdbool.h>
+#include <linux/virtio_ring.h>
 
+#include <rte_dev.h>
 #include <rte_malloc.h>
+#include <rte_memcpy.h>
 #include "rte_vdpa.h"
 #include "vhost.h"
 
@@ -122,3 +126,195 @@ rte_vdpa_get_device_num(void)
 {
 	return vdpa_device_num;
 }
+
+int
+rte_vdpa_find_next(int did)
+{
+	if (did < 0)
+		did = 0;
+
+	for (; did < MAX_VHOST_DEVICE; did++) {
+		if (vdpa_devices[did] != NULL)
+			return did;
+	}
+
+	return -1;
+}
+
+int
+rte_vdpa_get_stats(int did, uint16_t qid, struct rte_vdpa_stats *stats)
+{
+	struct rte_vdpa_device *vdpa_dev;
+
+	vdpa_dev = rte_vdpa_get_device(did);
+	if (!vdpa_dev || !stats)
+		return -EINVAL;
+
+	RTE_FUNC_PTR_OR_ERR_RET(vdpa_dev->ops->get_stats, -ENOTSUP);
+
+	return vdpa_dev->ops->get_stats(did, qid, stats);
+}
+
+int
+rte_vdpa_get_xstats(int did, uint16_t qid, struct rte_vdpa_xstat_name *names,
+		struct rte_vdpa_xstat *xstats, unsigned int n)
+{
+	struct rte_vdpa_device *vdpa_dev;
+
+	vdpa_dev = rte_vdpa_get_device(did);
+	if (!vdpa_dev || (n && (!names || !xstats)))
+		return -EINVAL;
+
+	RTE_FUNC_PTR_OR_ERR_RET(vdpa_dev->ops->get_xstats, -ENOTSUP);
+
+	return vdpa_dev->ops->get_xstats(did, qid, names, xstats, n);
+}
+
+int
+rte_vdpa_reset_stats(int did, uint16_t qid)
+{
+	struct rte_vdpa_device *vdpa_dev;
+
+	vdpa_dev = rte_vdpa_get_device(did);
+	if (!vdpa_dev)
+		return -EINVAL;
+
+	RTE_FUNC_PTR_OR_ERR_RET(vdpa_dev->ops->reset_stats, -ENOTSUP);
+
+	return vdpa_dev->ops->reset_stats(did, qid);
+}
+
+static void *
+vdpa_copy_ind_table(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		uint64_t desc_addr, uint64_t desc_len)
+{
+	void *idesc;
+	uint64_t src, dst;
+	uint64_t len, remain = desc_len;
+
+	idesc = rte_malloc(__func__, desc_len, 0);
+	if (unlikely(!idesc))
+		return NULL;
+
+	dst = (uint64_t)(uintptr_t)idesc;
+
+	while (remain) {
+		len = remain;
+		src = vhost_iova_to_vva(dev, vq, desc_addr, &len,
+				VHOST_ACCESS_RO);
+		if (unlikely(!src || !len)) {
+			rte_free(idesc);
+			return NULL;
+		}
+
+		rte_memcpy((void *)(uintptr_t)dst, (void *)(uintptr_t)src, len);
+
+		remain -= len;
+		dst += len;
+		desc_addr += len;
+	}
+
+	return idesc;
+}
+
+/* Log the device-writable buffers of a descriptor chain. */
+static int
+vdpa_log_desc_chain(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		uint16_t desc_id)
+{
+	struct vring_desc *desc_ring = vq->desc;
+	struct vring_desc *idesc = NULL;
+	struct vring_desc desc;
+	uint32_t nr_descs = vq->size;
+	uint64_t dlen;
+
+	if (unlikely(desc_id >= vq->size))
+		return -1;
+
+	if (vq->desc[desc_id].flags & VRING_DESC_F_INDIRECT) {
+		dlen = vq->desc[desc_id].len;
+		nr_descs = dlen / sizeof(struct vring_desc);
+		if (unlikely(nr_descs > vq->size))
+			return -1;
+
+		desc_ring = (struct vring_desc *)(uintptr_t)
+			vhost_iova_to_vva(dev, vq, vq->desc[desc_id].addr,
+					&dlen, VHOST_ACCESS_RO);
+		if (unlikely(!desc_ring))
+			return -1;
+
+		if (unlikely(dlen < vq->desc[desc_id].len)) {
+			idesc = vdpa_copy_ind_table(dev, vq,
+					vq->desc[desc_id].addr,
+					vq->desc[desc_id].len);
+			if (unlikely(!idesc))
+				return -1;
+
+			desc_ring = idesc;
+		}
+
+		desc_id = 0;
+	}
+
+	do {
+		if (unlikely(desc_id >= nr_descs) || unlikely(nr_descs-- == 0))
+			goto fail;
+		desc = desc_ring[desc_id];
+		if (desc.flags & VRING_DESC_F_WRITE)
+			vhost_log_write(dev, desc.addr, desc.len);
+		desc_id = desc.next;
+	} while (desc.flags & VRING_DESC_F_NEXT);
+
+	rte_free(idesc);
+	return 0;
+
+fail:
+	rte_free(idesc);
+	return -1;
+}
+
+int
+rte_vdpa_relay_vring_used(int vid, uint16_t qid, void *vring_m)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	struct vring *s_vring;
+	uint16_t idx, idx_m;
+	uint16_t slot;
+	int ret;
+
+	if (!dev || !vring_m)
+		return -1;
+
+	if (qid >= dev->nr_vring)
+		return -1;
+
+	if (vq_is_packed(dev))
+		return -1;
+
+	s_vring = (struct vring *)vring_m;
+	vq = dev->virtqueue[qid];
+	idx = vq->used->idx;
+	idx_m = s_vring->used->idx;
+	ret = (uint16_t)(idx_m - idx);
+
+	while (idx != idx_m) {
+		slot = idx & (vq->size - 1);
+		vq->used->ring[slot] = s_vring->used->ring[slot];
+		vhost_log_used_vring(dev, vq,
+			offsetof(struct vring_used, ring[slot]),
+			sizeof(vq->used->ring[slot]));
+
+		if (vdpa_log_desc_chain(dev, vq, vq->used->ring[slot].id))
+			return -1;
+
+		idx++;
+	}
+
+	rte_smp_wmb();
+	vq->used->idx = idx_m;
+	vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
+			sizeof(vq->used->idx));
+
+	return ret;
+}
@@ -7,6 +7,8 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 #ifdef RTE_LIBRTE_VHOST_NUMA
 #include <numa.h>
 #include <numaif.h>
@@ -25,7 +27,11 @@
 #include "vhost.h"
 #include "vhost_user.h"
 
-struct virtio_net *vhost_devices[MAX_VHOST_DEVICE];
+struct virtio_net **vhost_devices;
+uint32_t vhost_nr_devices;
+static uint32_t vhost_max_devices = MAX_VHOST_DEVICE;
+/* Devices are created by the event threads and the reconnect thread. */
+static rte_spinlock_t vhost_dev_lock = RTE_SPINLOCK_INITIALIZER;
 
 /* Called with iotlb_lock read-locked */
 uint64_t
@@ -56,6 +62,7 @@ __vhost_iova_to_vva(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		vhost_user_iotlb_rd_unlock(vq);
 
 		vhost_user_iotlb_pending_insert(vq, iova, perm);
+		vq->stats.iotlb_misses++;
 		if (vhost_user_iotlb_miss(dev, iova, perm)) {
 			RTE_LOG(ERR, VHOST_CONFIG,
 				"IOTLB miss req failed for IOVA 0x%" PRIx64 "\n",
@@ -93,6 +100,21 @@ cleanup_device(struct virtio_net *dev, int destroy)
 		cleanup_vq(dev->virtqueue[i], destroy);
 }
 
+static void
+vhost_async_free(struct vhost_virtqueue *vq)
+{
+	rte_free(vq->async_pkts);
+	vq->async_pkts = NULL;
+	rte_free(vq->async_pkts_nr_used);
+	vq->async_pkts_nr_used = NULL;
+	rte_free(vq->async_used);
+	vq->async_used = NULL;
+	rte_free(vq->async_descs);
+	vq->async_descs = NULL;
+	rte_free(vq->async_iov);
+	vq->async_iov = NULL;
+}
+
 void
 free_vq(struct virtio_net *dev, struct vhost_virtqueue *vq)
 {
@@ -101,7 +123,12 @@ free_vq(struct virtio_net *dev, struct vhost_virtqueue *vq)
 	else
 		rte_free(vq->shadow_used_split);
 	rte_free(vq->batch_copy_elems);
+	rte_free(vq->ind_table);
+	rte_free(vq->resubmit_list);
+	rte_free(vq->log_cache);
 	rte_mempool_free(vq->iotlb_pool);
+	rte_free(vq->iotlb_cache);
+	vhost_async_free(vq);
 	rte_free(vq);
 }
 
@@ -116,6 +143,9 @@ free_device(struct virtio_net *dev)
 	for (i = 0; i < dev->nr_vring; i++)
 		free_vq(dev, dev->virtqueue[i]);
 
+	pthread_mutex_destroy(&dev->vdpa_lock);
+	rte_free(dev->mem_tables[0]);
+	rte_free(dev->virtqueue);
 	rte_free(dev);
 }
 
@@ -229,7 +259,7 @@ init_vring_queue(struct virtio_net *dev, uint32_t vring_idx)
 {
 	struct vhost_virtqueue *vq;
 
-	if (vring_idx >= VHOST_MAX_VRING) {
+	if (vring_idx >= dev->max_vring) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 				"Failed not init vring, out of bound (%d)\n",
 				vring_idx);
@@ -240,23 +270,30 @@ init_vring_queue(struct virtio_net *dev, uint32_t vring_idx)
 
 	memset(vq, 0, sizeof(struct vhost_virtqueue));
 
+	vq->index = vring_idx;
 	vq->kickfd = VIRTIO_UNINITIALIZED_EVENTFD;
 	vq->callfd = VIRTIO_UNINITIALIZED_EVENTFD;
 
 	vhost_user_iotlb_init(dev, vring_idx);
 	/* Backends are set to -1 indicating an inactive device. */
 	vq->backend = -1;
-
-	TAILQ_INIT(&vq->zmbuf_list);
 }
 
 static void
 reset_vring_queue(struct virtio_net *dev, uint32_t vring_idx)
 {
 	struct vhost_virtqueue *vq;
+	uint64_t coalesce_cycles;
+	uint16_t coalesce_frames;
+	uint32_t budget_bytes;
+	uint16_t used_batch;
+	uint64_t used_batch_cycles;
+	struct vhost_burst_tune burst_tune;
+	uint16_t prefetch_depth;
+	bool paused;
 	int callfd;
 
-	if (vring_idx >= VHOST_MAX_VRING) {
+	if (vring_idx >= dev->max_vring) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 				"Failed not init vring, out of bound (%d)\n",
 				vring_idx);
@@ -265,8 +302,28 @@ reset_vring_queue(struct virtio_net *dev, uint32_t vring_idx)
 
 	vq = dev->virtqueue[vring_idx];
 	callfd = vq->callfd;
+	coalesce_cycles = vq->coalesce_cycles;
+	coalesce_frames = vq->coalesce_frames;
+	budget_bytes = vq->budget_bytes;
+	used_batch = vq->used_batch;
+	used_batch_cycles = vq->used_batch_cycles;
+	burst_tune = vq->burst_tune;
+	prefetch_depth = vq->prefetch_depth;
+	paused = vq->paused;
+	rte_free(vq->ind_table);
+	rte_free(vq->iotlb_cache);
+	rte_free(vq->resubmit_list);
+	rte_free(vq->log_cache);
 	init_vring_queue(dev, vring_idx);
 	vq->callfd = callfd;
+	vq->coalesce_cycles = coalesce_cycles;
+	vq->coalesce_frames = coalesce_frames;
+	vq->budget_bytes = budget_bytes;
+	vq->used_batch = used_batch;
+	vq->used_batch_cycles = used_batch_cycles;
+	vq->burst_tune = burst_tune;
+	vq->prefetch_depth = prefetch_depth;
+	vq->paused = paused;
 }
 
 int
@@ -288,11 +345,36 @@ alloc_vring_queue(struct virtio_net *dev, uint32_t vring_idx)
 	vq->used_wrap_counter = 1;
 	vq->signalled_used_valid = false;
 
+	/* Logging goes to the dirty log directly if this fails */
+	if (dev->log_base)
+		vhost_log_cache_alloc(vq);
+
 	dev->nr_vring += 1;
 
 	return 0;
 }
 
+int
+vhost_log_cache_alloc(struct vhost_virtqueue *vq)
+{
+	if (vq->log_cache)
+		return 0;
+
+	vq->log_cache = rte_zmalloc(NULL,
+			sizeof(struct log_cache_entry) * VHOST_LOG_CACHE_NR +
+			sizeof(uint16_t) * VHOST_LOG_CACHE_MAX, 0);
+	if (vq->log_cache == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"Failed to allocate memory for the log cache.\n");
+		return -1;
+	}
+
+	vq->log_cache_used = (uint16_t *)(vq->log_cache + VHOST_LOG_CACHE_NR);
+	vq->log_cache_nb_elem = 0;
+
+	return 0;
+}
+
 /*
  * Reset some variables in device structure, while keeping few
  * others untouched, such as vid, ifname, nr_vring: they
@@ -306,6 +388,7 @@ reset_device(struct virtio_net *dev)
 	dev->features = 0;
 	dev->protocol_features = 0;
 	dev->flags &= VIRTIO_DEV_BUILTIN_VIRTIO_NET;
+	vhost_select_datapath(dev);
 
 	for (i = 0; i < dev->nr_vring; i++)
 		reset_vring_queue(dev, i);
@@ -316,36 +399,92 @@ reset_device(struct virtio_net *dev)
  * there is a new virtio device being attached).
  */
 int
-vhost_new_device(void)
+vhost_new_device(uint32_t max_queue_pairs)
 {
 	struct virtio_net *dev;
-	int i;
+	uint32_t i;
 
-	for (i = 0; i < MAX_VHOST_DEVICE; i++) {
-		if (vhost_devices[i] == NULL)
-			break;
+	dev = rte_zmalloc(NULL, sizeof(struct virtio_net), 0);
+	if (dev == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"Failed to allocate memory for new dev.\n");
+		return -1;
 	}
 
-	if (i == MAX_VHOST_DEVICE) {
+	dev->max_vring = max_queue_pairs * 2;
+	dev->virtqueue = rte_zmalloc(NULL,
+			sizeof(struct vhost_virtqueue *) * dev->max_vring, 0);
+	if (dev->virtqueue == NULL) {
 		RTE_LOG(ERR, VHOST_CONFIG,
-			"Failed to find a free slot for new device.\n");
+			"Failed to allocate memory for new dev vrings.\n");
+		rte_free(dev);
 		return -1;
 	}
 
-	dev = rte_zmalloc(NULL, sizeof(struct virtio_net), 0);
-	if (dev == NULL) {
+	/*
+	 * The memory tables are allocated here rather than when handling
+	 * the memory messages: a frontend in the same process holds the
+	 * heap lock while it sends them from a memory event.
+	 */
+	dev->mem_tables[0] = rte_zmalloc(NULL, 2 * VHOST_MEM_TABLE_SIZE, 0);
+	if (dev->mem_tables[0] == NULL) {
 		RTE_LOG(ERR, VHOST_CONFIG,
-			"Failed to allocate memory for new dev.\n");
+			"Failed to allocate memory tables for new dev.\n");
+		rte_free(dev->virtqueue);
+		rte_free(dev);
 		return -1;
 	}
+	dev->mem_tables[1] = RTE_PTR_ADD(dev->mem_tables[0],
+			VHOST_MEM_TABLE_SIZE);
 
-	vhost_devices[i] = dev;
-	dev->vid = i;
 	dev->flags = VIRTIO_DEV_BUILTIN_VIRTIO_NET;
 	dev->slave_req_fd = -1;
 	dev->vdpa_dev_id = -1;
 	dev->postcopy_ufd = -1;
+	dev->inflight_fd = -1;
 	rte_spinlock_init(&dev->slave_req_lock);
+	pthread_mutex_init(&dev->vdpa_lock, NULL);
+
+	rte_spinlock_lock(&vhost_dev_lock);
+	if (vhost_devices == NULL) {
+		vhost_devices = rte_zmalloc(NULL,
+				sizeof(struct virtio_net *) * vhost_max_devices,
+				0);
+		if (vhost_devices == NULL) {
+			rte_spinlock_unlock(&vhost_dev_lock);
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"Failed to allocate memory for devices.\n");
+			pthread_mutex_destroy(&dev->vdpa_lock);
+			rte_free(dev->mem_tables[0]);
+			rte_free(dev->virtqueue);
+			rte_free(dev);
+			return -1;
+		}
+		/* Published in this order for get_device() */
+		__atomic_store_n(&vhost_nr_devices, vhost_max_devices,
+				__ATOMIC_RELEASE);
+	}
+
+	for (i = 0; i < vhost_nr_devices; i++) {
+		if (vhost_devices[i] == NULL)
+			break;
+	}
+
+	if (i == vhost_nr_devices) {
+		rte_spinlock_unlock(&vhost_dev_lock);
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"Failed to find a free slot for new device.\n");
+		pthread_mutex_destroy(&dev->vdpa_lock);
+		rte_free(dev->mem_tables[0]);
+		rte_free(dev->virtqueue);
+		rte_free(dev);
+		return -1;
+	}
+
+	dev->vid = i;
+	/* get_device() finds the device initialized */
+	__atomic_store_n(&vhost_devices[i], dev, __ATOMIC_RELEASE);
+	rte_spinlock_unlock(&vhost_dev_lock);
 
 	return i;
 }
@@ -357,10 +496,13 @@ vhost_destroy_device_notify(struct virtio_net *dev)
 	int did;
 
 	if (dev->flags & VIRTIO_DEV_RUNNING) {
+		pthread_mutex_lock(&dev->vdpa_lock);
 		did = dev->vdpa_dev_id;
 		vdpa_dev = rte_vdpa_get_device(did);
 		if (vdpa_dev && vdpa_dev->ops->dev_close)
 			vdpa_dev->ops->dev_close(dev->vid);
+		dev->flags &= ~VIRTIO_DEV_VDPA_CONFIGURED;
+		pthread_mutex_unlock(&dev->vdpa_lock);
 		dev->flags &= ~VIRTIO_DEV_RUNNING;
 		dev->notify_ops->destroy_device(dev->vid);
 	}
@@ -379,11 +521,15 @@ vhost_destroy_device(int vid)
 		return;
 
 	vhost_destroy_device_notify(dev);
+	vhost_mp_destroy(dev);
 
 	cleanup_device(dev, 1);
-	free_device(dev);
 
+	/* No multi-process request reads it anymore */
+	vhost_mp_lock();
+	free_device(dev);
 	vhost_devices[vid] = NULL;
+	vhost_mp_unlock();
 }
 
 void
@@ -441,6 +587,127 @@ vhost_enable_dequeue_zero_copy(int vid)
 	dev->dequeue_zero_copy = 1;
 }
 
+#ifndef MEMBARRIER_CMD_PRIVATE_EXPEDITED
+#define MEMBARRIER_CMD_PRIVATE_EXPEDITED (1 << 3)
+#define MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED (1 << 4)
+#endif
+
+/* Lockless mode needs the expedited membarrier of Linux 4.14. */
+int
+vhost_lockless_init(void)
+{
+#ifdef __NR_membarrier
+	if (syscall(__NR_membarrier,
+		    MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0)
+		return 0;
+#endif
+	return -1;
+}
+
+/* Run a full memory barrier on all the running threads of the process. */
+static void
+vhost_membarrier(void)
+{
+#ifdef __NR_membarrier
+	if (syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0)
+		return;
+#endif
+	/* Registered in vhost_lockless_init(), it does not fail. */
+	RTE_LOG(ERR, VHOST_CONFIG, "membarrier failed\n");
+}
+
+void
+vhost_enable_lockless(int vid)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL)
+		return;
+
+	dev->lockless = 1;
+}
+
+void
+vhost_enable_prefault(int vid)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL)
+		return;
+
+	dev->prefault = 1;
+}
+
+void
+vhost_enable_nt_copy(int vid)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL)
+		return;
+
+	dev->nt_copy = 1;
+}
+
+void
+vhost_enable_sw_cksum(int vid)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL)
+		return;
+
+	dev->sw_cksum = 1;
+}
+
+void
+vhost_enable_shared_mem(int vid)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL)
+		return;
+
+	dev->shared_mem = 1;
+}
+
+/*
+ * Lock a vring against the control plane and the datapath. In lockless
+ * mode the datapath does not take access_lock: the request is raised,
+ * and once the barrier makes it visible to the datapath lcore, a
+ * datapath call which has not seen it is waited for, the next ones back
+ * off until vhost_vq_unlock(). The lock may be taken from the datapath
+ * lcore, out of the datapath.
+ */
+void
+vhost_vq_lock(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	uint32_t seq;
+
+	rte_spinlock_lock(&vq->access_lock);
+
+	if (!dev->lockless)
+		return;
+
+	__atomic_store_n(&vq->quiesce_req, 1, __ATOMIC_RELAXED);
+	vhost_membarrier();
+
+	seq = __atomic_load_n(&vq->dp_seq, __ATOMIC_ACQUIRE);
+	if (seq & 1) {
+		while (__atomic_load_n(&vq->dp_seq, __ATOMIC_ACQUIRE) == seq)
+			rte_pause();
+	}
+}
+
+void
+vhost_vq_unlock(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (dev->lockless)
+		__atomic_store_n(&vq->quiesce_req, 0, __ATOMIC_RELEASE);
+
+	rte_spinlock_unlock(&vq->access_lock);
+}
+
 void
 vhost_set_builtin_virtio_net(int vid, bool enable)
 {
@@ -455,6 +722,17 @@ vhost_set_builtin_virtio_net(int vid, bool enable)
 		dev->flags &= ~VIRTIO_DEV_BUILTIN_VIRTIO_NET;
 }
 
+void
+vhost_set_iotlb_cache_size(int vid, uint32_t size)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL)
+		return;
+
+	dev->iotlb_cache_size = size;
+}
+
 int
 rte_vhost_get_mtu(int vid, uint16_t *mtu)
 {
@@ -586,7 +864,7 @@ rte_vhost_get_vhost_vring(int vid, uint16_t vring_idx,
 	if (!dev)
 		return -1;
 
-	if (vring_idx >= VHOST_MAX_VRING)
+	if (vring_idx >= dev->max_vring)
 		return -1;
 
 	vq = dev->virtqueue[vring_idx];
@@ -598,8 +876,9 @@ rte_vhost_get_vhost_vring(int vid, uint16_t vring_idx,
 	vring->used  = vq->used;
 	vring->log_guest_addr  = vq->log_guest_addr;
 
-	vring->callfd  = vq->callfd;
-	vring->kickfd  = vq->kickfd;
+	/* The kick eventfds stay in the primary process */
+	vring->callfd  = vhost_vring_callfd(dev, vq);
+	vring->kickfd  = vhost_mp_devs == NULL ? vq->kickfd : -1;
 	vring->size    = vq->size;
 
 	return 0;
@@ -615,21 +894,436 @@ rte_vhost_vring_call(int vid, uint16_t vring_idx)
 	if (!dev)
 		return -1;
 
-	if (vring_idx >= VHOST_MAX_VRING)
+	if (vring_idx >= dev->max_vring)
 		return -1;
 
 	vq = dev->virtqueue[vring_idx];
 	if (!vq)
 		return -1;
 
+	/*
+	 * An explicit call is never held back by coalescing, and signals
+	 * the entries it held back so far.
+	 */
+	vhost_vring_coalesce_reset(vq, rte_rdtsc());
+
 	if (vq_is_packed(dev))
-		vhost_vring_call_packed(dev, vq);
+		vhost_vring_signal_packed(dev, vq);
 	else
-		vhost_vring_call_split(dev, vq);
+		vhost_vring_signal_split(dev, vq);
+
+	return 0;
+}
+
+uint32_t
+vhost_get_max_devices(void)
+{
+	return vhost_max_devices;
+}
+
+int __rte_experimental
+rte_vhost_set_max_devices(uint32_t max)
+{
+	int ret = -1;
+
+	if (max == 0 || max > INT_MAX) {
+		RTE_LOG(ERR, VHOST_CONFIG, "invalid max devices %u\n", max);
+		return -1;
+	}
+
+	rte_spinlock_lock(&vhost_dev_lock);
+	if (vhost_devices != NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"max devices can't change once devices are created\n");
+		goto out;
+	}
+	vhost_max_devices = max;
+	ret = 0;
+out:
+	rte_spinlock_unlock(&vhost_dev_lock);
+
+	return ret;
+}
+
+int __rte_experimental
+rte_vhost_get_msg_stats(int vid, uint32_t request,
+		struct rte_vhost_msg_stats *stats)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_msg_stats *s;
+	uint64_t hz = rte_get_tsc_hz();
+
+	if (dev == NULL || stats == NULL || request >= VHOST_MSG_STATS_MAX)
+		return -1;
+
+	s = &dev->msg_stats[request];
+	stats->count = s->count;
+	/* Split the conversion, the products would overflow in seconds. */
+	stats->total_ns = s->cycles / hz * NS_PER_S +
+		s->cycles % hz * NS_PER_S / hz;
+	stats->max_ns = s->max_cycles / hz * NS_PER_S +
+		s->max_cycles % hz * NS_PER_S / hz;
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_vring_stats_get(int vid, uint16_t queue_id,
+		struct rte_vhost_vring_stats *stats)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	struct vhost_vring_stats *s;
+	uint32_t seq, retries = 0;
+	uint32_t i;
+
+	if (dev == NULL || stats == NULL || queue_id >= dev->nr_vring)
+		return -1;
+
+	vq = dev->virtqueue[queue_id];
+	if (vq == NULL)
+		return -1;
+
+	s = &vq->stats;
+retry:
+	seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+	stats->packets = s->packets;
+	stats->bytes = s->bytes;
+	for (i = 0; i < RTE_VHOST_STATS_HIST_NR; i++) {
+		stats->burst_hist[i] = s->burst_hist[i];
+		stats->chain_hist[i] = s->chain_hist[i];
+	}
+	stats->empty_polls = s->empty_polls;
+	stats->guest_notifications = s->guest_notifications;
+	stats->iotlb_misses = s->iotlb_misses;
+	stats->zcopy_fallbacks = s->zcopy_fallbacks;
+	stats->batch_copy_bytes = s->batch_copy_bytes;
+	stats->direct_copy_bytes = s->direct_copy_bytes;
+	stats->dirty_pages = vq->log_dirty_pages;
+	stats->budget_hits = s->budget_hits;
+	stats->sw_cksums = s->sw_cksums;
+	rte_smp_rmb();
+
+	/*
+	 * Retry while a burst was updating the counters, a virtqueue busy
+	 * for that long gets the last copy, which may mix two bursts.
+	 */
+	if (((seq & 1) || seq != *(volatile uint32_t *)&s->seq) &&
+			retries++ < VHOST_STATS_READ_RETRIES) {
+		rte_pause();
+		goto retry;
+	}
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_find_next(int vid)
+{
+	uint32_t nr_devices;
+
+	if (vid < 0)
+		vid = 0;
+
+	nr_devices = vhost_nr_devices;
+	rte_smp_rmb();
+
+	for (; (uint32_t)vid < nr_devices; vid++) {
+		if (vhost_devices[vid] != NULL)
+			return vid;
+	}
+
+	return -1;
+}
+
+int __rte_experimental
+rte_vhost_vring_set_coalesce(int vid, uint16_t vring_idx, uint32_t usecs,
+		uint16_t max_frames)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	if (vring_idx >= dev->max_vring)
+		return -1;
+
+	vq = dev->virtqueue[vring_idx];
+	if (!vq)
+		return -1;
+
+	if (!usecs && max_frames) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) vring %u: frame coalescing needs a time limit\n",
+			vid, vring_idx);
+		return -1;
+	}
+
+	vhost_vq_lock(dev, vq);
+
+	vq->coalesce_cycles = (uint64_t)usecs * rte_get_tsc_hz() / US_PER_S;
+	vq->coalesce_frames = max_frames;
+	vq->coalesce_tsc = 0;
+
+	/* Signal the entries held back with the previous settings. */
+	if (vq->enabled && vq->access_ok &&
+	    vhost_vring_callfd(dev, vq) >= 0) {
+		if (vq_is_packed(dev))
+			vhost_vring_call_packed(dev, vq);
+		else
+			vhost_vring_call_split(dev, vq);
+	}
+
+	vhost_vq_unlock(dev, vq);
+
+	return 0;
+}
+
+static struct vhost_virtqueue *
+vhost_vring_get(struct virtio_net *dev, uint16_t vring_idx)
+{
+	if (vring_idx >= dev->max_vring)
+		return NULL;
+
+	return dev->virtqueue[vring_idx];
+}
+
+int __rte_experimental
+rte_vhost_vring_pause(int vid, uint16_t vring_idx)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	vq = vhost_vring_get(dev, vring_idx);
+	if (!vq)
+		return -1;
+
+	vhost_vq_lock(dev, vq);
+
+	vq->paused = true;
+
+	/*
+	 * The shadow used entries and batch copies are flushed at the end
+	 * of each burst, the entries held back by coalescing are the only
+	 * state the next lcore would not act on before its first burst.
+	 */
+	if (vq->coalesce_cycles && vq->enabled && vq->access_ok &&
+	    vhost_vring_callfd(dev, vq) >= 0 &&
+	    vhost_vring_coalesce_pending(dev, vq)) {
+		vq->coalesce_tsc = 0;
+		if (vq_is_packed(dev))
+			vhost_vring_call_packed(dev, vq);
+		else
+			vhost_vring_call_split(dev, vq);
+	}
+
+	vhost_vq_unlock(dev, vq);
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_vring_resume(int vid, uint16_t vring_idx)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	vq = vhost_vring_get(dev, vring_idx);
+	if (!vq)
+		return -1;
+
+	vhost_vq_lock(dev, vq);
+	vq->paused = false;
+	vhost_vq_unlock(dev, vq);
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_vring_set_budget(int vid, uint16_t vring_idx, uint32_t max_bytes)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	vq = vhost_vring_get(dev, vring_idx);
+	if (!vq)
+		return -1;
+
+	vhost_vq_lock(dev, vq);
+	vq->budget_bytes = max_bytes;
+	vhost_vq_unlock(dev, vq);
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_vring_set_used_batch(int vid, uint16_t vring_idx,
+		uint16_t nb_entries, uint32_t usecs)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+	int ret = 0;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	if (vq_is_packed(dev)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: packed ring is not supported.\n",
+			dev->vid, __func__);
+		return -1;
+	}
+
+	vq = vhost_vring_get(dev, vring_idx);
+	if (!vq)
+		return -1;
+
+	vhost_vq_lock(dev, vq);
+	if (vq->async_registered) {
+		ret = -1;
+	} else {
+		vq->used_batch = nb_entries;
+		vq->used_batch_cycles = nb_entries == 0 ? 0 :
+			(uint64_t)usecs * rte_get_tsc_hz() / US_PER_S;
+		vq->used_batch_tsc = rte_rdtsc();
+		/* Held back entries get the new settings from now on */
+		if (nb_entries == 0 && vq->access_ok)
+			vhost_flush_used_batch(dev, vq);
+	}
+	vhost_vq_unlock(dev, vq);
+
+	return ret;
+}
+
+int __rte_experimental
+rte_vhost_vring_set_prefetch(int vid, uint16_t vring_idx, uint16_t depth)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	if (vq_is_packed(dev)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: packed ring is not supported.\n",
+			dev->vid, __func__);
+		return -1;
+	}
+
+	vq = vhost_vring_get(dev, vring_idx);
+	if (!vq || depth > VHOST_PREFETCH_DEPTH_MAX)
+		return -1;
+
+	vhost_vq_lock(dev, vq);
+	vq->prefetch_depth = depth;
+	vhost_vq_unlock(dev, vq);
+
+	return 0;
+}
+
+int __rte_experimental
+rte_vhost_vring_set_burst_tune(int vid, uint16_t vring_idx,
+		uint16_t min_burst, uint16_t max_burst, uint32_t max_usecs)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+	struct vhost_burst_tune *t;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	vq = vhost_vring_get(dev, vring_idx);
+	if (!vq)
+		return -1;
+
+	if (max_burst > RTE_VHOST_BURST_MAX || min_burst > max_burst ||
+	    (max_burst != 0 && min_burst == 0)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: invalid burst range %u-%u.\n",
+			dev->vid, __func__, min_burst, max_burst);
+		return -1;
+	}
+
+	vhost_vq_lock(dev, vq);
+	t = &vq->burst_tune;
+	memset(t, 0, sizeof(*t));
+	t->min_burst = min_burst;
+	t->max_burst = max_burst;
+	t->max_cycles = (uint64_t)max_usecs * rte_get_tsc_hz() / US_PER_S;
+	t->burst = min_burst;
+	vhost_vq_unlock(dev, vq);
 
 	return 0;
 }
 
+int __rte_experimental
+rte_vhost_vring_get_burst_size(int vid, uint16_t vring_idx)
+{
+	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
+
+	dev = get_device(vid);
+	if (!dev)
+		return -1;
+
+	vq = vhost_vring_get(dev, vring_idx);
+	if (!vq)
+		return -1;
+
+	if (vq->burst_tune.max_burst == 0)
+		return RTE_VHOST_BURST_MAX;
+
+	return *(volatile uint16_t *)&vq->burst_tune.burst;
+}
+
+/*
+ * Warn once per ring setup when a vring is polled from another socket
+ * than the one of its rings, each index access crossing the sockets.
+ */
+void
+vhost_vring_check_numa(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+#ifdef RTE_LIBRTE_VHOST_NUMA
+	unsigned int socket_id = rte_socket_id();
+	int node;
+
+	vq->numa_checked = true;
+
+	if (numa_available() != 0 || socket_id == (unsigned int)SOCKET_ID_ANY)
+		return;
+
+	if (get_mempolicy(&node, NULL, 0, vq->desc,
+			MPOL_F_NODE | MPOL_F_ADDR) < 0)
+		return;
+
+	if ((unsigned int)node != socket_id)
+		RTE_LOG(WARNING, VHOST_DATA,
+			"(%d) vring %u polled from socket %u, its rings are on socket %d\n",
+			dev->vid, vq->index, socket_id, node);
+#else
+	RTE_SET_USED(dev);
+	vq->numa_checked = true;
+#endif
+}
+
 uint16_t
 rte_vhost_avail_entries(int vid, uint16_t queue_id)
 {
@@ -637,11 +1331,11 @@ rte_vhost_avail_entries(int vid, uint16_t queue_id)
 	struct vhost_virtqueue *vq;
 
 	dev = get_device(vid);
-	if (!dev)
+	if (!dev || queue_id >= dev->max_vring)
 		return 0;
 
 	vq = dev->virtqueue[queue_id];
-	if (!vq->enabled)
+	if (!vq || !vq->enabled)
 		return 0;
 
 	return *(volatile uint16_t *)&vq->avail->idx - vq->last_used_idx;
@@ -691,7 +1385,7 @@ rte_vhost_enable_guest_notification(int vid, uint16_t queue_id, int enable)
 	struct virtio_net *dev = get_device(vid);
 	struct vhost_virtqueue *vq;
 
-	if (!dev)
+	if (!dev || queue_id >= dev->nr_vring)
 		return -1;
 
 	vq = dev->virtqueue[queue_id];
@@ -726,7 +1420,7 @@ rte_vhost_log_used_vring(int vid, uint16_t vring_idx,
 	if (dev == NULL)
 		return;
 
-	if (vring_idx >= VHOST_MAX_VRING)
+	if (vring_idx >= dev->max_vring)
 		return;
 	vq = dev->virtqueue[vring_idx];
 	if (!vq)
@@ -761,6 +1455,118 @@ rte_vhost_rx_queue_count(int vid, uint16_t qid)
 	return *((volatile uint16_t *)&vq->avail->idx) - vq->last_avail_idx;
 }
 
+/* Vrings looked up and prefetched together by rte_vhost_vrings_pending() */
+#define VHOST_PENDING_CHUNK 8
+
+static __rte_always_inline struct vhost_virtqueue *
+vhost_pending_vq(const struct rte_vhost_vring_ref *ref, bool *packed)
+{
+	struct virtio_net *dev;
+
+	if (unlikely(ref->vid < 0 || (uint32_t)ref->vid >=
+			__atomic_load_n(&vhost_nr_devices, __ATOMIC_ACQUIRE)))
+		return NULL;
+
+	dev = __atomic_load_n(&vhost_devices[ref->vid], __ATOMIC_ACQUIRE);
+	if (unlikely(dev == NULL || ref->qid >= dev->nr_vring))
+		return NULL;
+
+	*packed = vq_is_packed(dev);
+
+	return dev->virtqueue[ref->qid];
+}
+
+static __rte_always_inline uint16_t
+vhost_pending_packed(struct vhost_virtqueue *vq, uint16_t *end)
+{
+	uint16_t idx = vq->last_avail_idx;
+	bool wrap = vq->avail_wrap_counter;
+	uint16_t n;
+
+	for (n = 0; n < RTE_VHOST_PACKED_PENDING_MAX; n++) {
+		if (!desc_is_avail(&vq->desc_packed[idx], wrap))
+			break;
+		if (++idx >= vq->size) {
+			idx -= vq->size;
+			wrap ^= 1;
+		}
+	}
+
+	/* The ring has at most 32768 entries, the wrap counter fits on top */
+	*end = idx | (uint16_t)wrap << 15;
+
+	return n;
+}
+
+int __rte_experimental
+rte_vhost_vrings_pending(const struct rte_vhost_vring_ref *vrings,
+		uint32_t nb_vrings, uint16_t *pending, uint64_t *kicked)
+{
+	struct vhost_virtqueue *vqs[VHOST_PENDING_CHUNK];
+	bool packed[VHOST_PENDING_CHUNK];
+	struct vhost_virtqueue *vq;
+	uint32_t i, j, n;
+	uint16_t end;
+	int busy = 0;
+
+	if (vrings == NULL || pending == NULL)
+		return -1;
+
+	if (kicked)
+		memset(kicked, 0, sizeof(*kicked) * ((nb_vrings + 63) / 64));
+
+	for (i = 0; i < nb_vrings; i += n) {
+		n = RTE_MIN(nb_vrings - i, (uint32_t)VHOST_PENDING_CHUNK);
+
+		for (j = 0; j < n; j++) {
+			vqs[j] = vhost_pending_vq(&vrings[i + j], &packed[j]);
+			if (vqs[j])
+				rte_prefetch0(vqs[j]);
+		}
+
+		for (j = 0; j < n; j++) {
+			vq = vqs[j];
+			if (vq == NULL)
+				continue;
+			if (unlikely(!vq->enabled || !vq->access_ok)) {
+				vqs[j] = NULL;
+				continue;
+			}
+			if (packed[j])
+				rte_prefetch0(&vq->desc_packed[vq->last_avail_idx]);
+			else
+				rte_prefetch0(&vq->avail->idx);
+		}
+
+		for (j = 0; j < n; j++) {
+			vq = vqs[j];
+			if (vq == NULL) {
+				pending[i + j] = 0;
+				continue;
+			}
+
+			if (packed[j]) {
+				pending[i + j] = vhost_pending_packed(vq, &end);
+			} else {
+				end = *((volatile uint16_t *)&vq->avail->idx);
+				pending[i + j] = end - vq->last_avail_idx;
+			}
+
+			if (pending[i + j])
+				busy++;
+
+			if (end != vq->pending_end) {
+				vq->pending_end = end;
+				if (kicked)
+					kicked[(i + j) / 64] |=
+						1ULL << ((i + j) % 64);
+			}
+		}
+	}
+
+	return busy;
+}
+
 int rte_vhost_get_vdpa_device_id(int vid)
 {
 	struct virtio_net *dev = get_device(vid);
@@ -771,6 +1577,209 @@ int rte_vhost_get_vdpa_device_id(int vid)
 	return dev->vdpa_dev_id;
 }
 
+int rte_vhost_attach_vdpa_device(int vid, int did)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct rte_vdpa_device *vdpa_dev;
+	int ret = 0;
+
+	if (dev == NULL)
+		return -1;
+
+	vdpa_dev = rte_vdpa_get_device(did);
+	if (vdpa_dev == NULL)
+		return -1;
+
+	pthread_mutex_lock(&dev->vdpa_lock);
+
+	if (dev->vdpa_dev_id >= 0) {
+		ret = -1;
+		goto unlock;
+	}
+
+	if (vq_is_packed(dev) || dev->dequeue_zero_copy) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: packed ring or dequeue zero copy in use.\n",
+			dev->vid, __func__);
+		ret = -1;
+		goto unlock;
+	}
+
+	/* Wait for the datapath calls in progress. */
+	vhost_user_lock_all_queue_pairs(dev);
+
+	dev->vdpa_dev_id = did;
+	/* Otherwise the device gets configured when it is ready. */
+	if (!(dev->flags & VIRTIO_DEV_READY))
+		goto out;
+
+	if (vdpa_dev->ops->dev_conf && vdpa_dev->ops->dev_conf(vid) < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: failed to configure vdpa device %d.\n",
+			dev->vid, __func__, did);
+		dev->vdpa_dev_id = -1;
+		ret = -1;
+		goto out;
+	}
+	dev->flags |= VIRTIO_DEV_VDPA_CONFIGURED;
+
+out:
+	vhost_user_unlock_all_queue_pairs(dev);
+unlock:
+	pthread_mutex_unlock(&dev->vdpa_lock);
+
+	/* The notifiers are set up with slave messages, not under the lock */
+	if (ret == 0 && (dev->flags & VIRTIO_DEV_VDPA_CONFIGURED) &&
+			vhost_user_host_notifier_ctrl(vid, true) != 0)
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%d) software relay is used for vDPA, performance may be low.\n",
+			dev->vid);
+
+	return ret;
+}
+
+int rte_vhost_detach_vdpa_device(int vid)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct rte_vdpa_device *vdpa_dev;
+	uint32_t i;
+
+	if (dev == NULL)
+		return -1;
+
+	/* The notifiers are removed with slave messages, not under the lock */
+	if (dev->flags & VIRTIO_DEV_VDPA_CONFIGURED)
+		vhost_user_host_notifier_ctrl(vid, false);
+
+	pthread_mutex_lock(&dev->vdpa_lock);
+
+	vdpa_dev = rte_vdpa_get_device(dev->vdpa_dev_id);
+	if (vdpa_dev == NULL) {
+		pthread_mutex_unlock(&dev->vdpa_lock);
+		return -1;
+	}
+
+	vhost_user_lock_all_queue_pairs(dev);
+
+	if (dev->flags & VIRTIO_DEV_VDPA_CONFIGURED) {
+		/* The driver saves the ring state with set_vring_base. */
+		if (vdpa_dev->ops->dev_close)
+			vdpa_dev->ops->dev_close(vid);
+		dev->flags &= ~VIRTIO_DEV_VDPA_CONFIGURED;
+
+		/* The device updated the used rings behind our back. */
+		for (i = 0; i < dev->nr_vring; i++)
+			dev->virtqueue[i]->signalled_used_valid = false;
+	}
+	dev->vdpa_dev_id = -1;
+
+	vhost_user_unlock_all_queue_pairs(dev);
+	pthread_mutex_unlock(&dev->vdpa_lock);
+
+	return 0;
+}
+
+int rte_vhost_async_channel_register(int vid, uint16_t queue_id,
+		uint32_t threshold, struct rte_vhost_async_channel_ops *ops)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	int ret = -1;
+
+	if (dev == NULL || ops == NULL || ops->transfer_data == NULL ||
+			ops->check_completed_copies == NULL)
+		return -1;
+
+	if (queue_id >= dev->nr_vring || dev->virtqueue[queue_id] == NULL)
+		return -1;
+
+	if (vq_is_packed(dev)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: packed ring is not supported.\n",
+			dev->vid, __func__);
+		return -1;
+	}
+
+	vq = dev->virtqueue[queue_id];
+
+	vhost_vq_lock(dev, vq);
+
+	if (vq->async_registered || vq->size == 0 || vq->used_batch != 0)
+		goto out;
+
+	vq->async_pkts = rte_zmalloc(NULL,
+			vq->size * sizeof(*vq->async_pkts), RTE_CACHE_LINE_SIZE);
+	vq->async_pkts_nr_used = rte_zmalloc(NULL,
+			vq->size * sizeof(*vq->async_pkts_nr_used),
+			RTE_CACHE_LINE_SIZE);
+	vq->async_used = rte_zmalloc(NULL,
+			vq->size * sizeof(*vq->async_used), RTE_CACHE_LINE_SIZE);
+	vq->async_descs = rte_zmalloc(NULL,
+			VHOST_ASYNC_BURST_MAX * sizeof(*vq->async_descs),
+			RTE_CACHE_LINE_SIZE);
+	vq->async_iov = rte_zmalloc(NULL,
+			2 * VHOST_ASYNC_IOV_MAX * sizeof(*vq->async_iov),
+			RTE_CACHE_LINE_SIZE);
+	if (!vq->async_pkts || !vq->async_pkts_nr_used || !vq->async_used ||
+			!vq->async_descs || !vq->async_iov) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: failed to allocate async channel memory.\n",
+			dev->vid, __func__);
+		vhost_async_free(vq);
+		goto out;
+	}
+
+	vq->async_ops = *ops;
+	vq->async_threshold = threshold;
+	vq->async_pkts_idx = 0;
+	vq->async_pkts_inflight_n = 0;
+	vq->async_used_idx = 0;
+	vq->async_used_n = 0;
+	vq->async_registered = true;
+	ret = 0;
+
+out:
+	vhost_vq_unlock(dev, vq);
+
+	return ret;
+}
+
+int rte_vhost_async_channel_unregister(int vid, uint16_t queue_id)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	int ret = -1;
+
+	if (dev == NULL)
+		return -1;
+
+	if (queue_id >= dev->nr_vring || dev->virtqueue[queue_id] == NULL)
+		return -1;
+
+	vq = dev->virtqueue[queue_id];
+
+	vhost_vq_lock(dev, vq);
+
+	if (!vq->async_registered)
+		goto out;
+
+	if (vq->async_pkts_inflight_n) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) %s: %u packets are in flight.\n",
+			dev->vid, __func__, vq->async_pkts_inflight_n);
+		goto out;
+	}
+
+	vhost_async_free(vq);
+	vq->async_registered = false;
+	ret = 0;
+
+out:
+	vhost_vq_unlock(dev, vq);
+
+	return ret;
+}
+
 int rte_vhost_get_log_base(int vid, uint64_t *log_base,
 		uint64_t *log_size)
 {
@@ -797,7 +1806,7 @@ int rte_vhost_get_vring_base(int vid, uint16_t queue_id,
 {
 	struct virtio_net *dev = get_device(vid);
 
-	if (!dev)
+	if (!dev || queue_id >= dev->nr_vring)
 		return -1;
 
 	if (unlikely(!(dev->flags & VIRTIO_DEV_BUILTIN_VIRTIO_NET))) {
@@ -813,12 +1822,25 @@ int rte_vhost_get_vring_base(int vid, uint16_t queue_id,
 	return 0;
 }
 
+int rte_vhost_get_vring_log_stats(int vid, uint16_t queue_id,
+		uint64_t *dirty_pages)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (!dev || queue_id >= dev->nr_vring || !dirty_pages)
+		return -1;
+
+	*dirty_pages = dev->virtqueue[queue_id]->log_dirty_pages;
+
+	return 0;
+}
+
 int rte_vhost_set_vring_base(int vid, uint16_t queue_id,
 		uint16_t last_avail_idx, uint16_t last_used_idx)
 {
 	struct virtio_net *dev = get_device(vid);
 
-	if (!dev)
+	if (!dev || queue_id >= dev->nr_vring)
 		return -1;
 
 	if (unlikely(!(dev->flags & VIRTIO_DEV_BUILTIN_VIRTIO_NET))) {
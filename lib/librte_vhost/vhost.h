@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/queue.h>
 #include <unistd.h>
@@ -18,9 +19,12 @@
 #include <rte_log.h>
 #include <rte_ether.h>
 #include <rte_rwlock.h>
+#include <rte_cycles.h>
 
 #include "rte_vhost.h"
 #include "rte_vdpa.h"
+#include "rte_vhost_async.h"
+#include "trace.h"
 
 /* Used to indicate that the device is running on a data core */
 #define VIRTIO_DEV_RUNNING 1
@@ -36,7 +40,24 @@
 
 #define BUF_VECTOR_MAX 256
 
-#define VHOST_LOG_CACHE_NR 32
+/* Max packets, and copy segments, of an asynchronous submission. */
+#define VHOST_ASYNC_BURST_MAX 32
+#define VHOST_ASYNC_IOV_MAX (VHOST_ASYNC_BURST_MAX * 64)
+
+/*
+ * Dirty log words cached per virtqueue for a burst, in a hash table with
+ * linear probing. Past VHOST_LOG_CACHE_MAX entries the probe sequences
+ * would get long, the pages are written to the log directly instead.
+ */
+#define VHOST_LOG_CACHE_SHIFT 8
+#define VHOST_LOG_CACHE_NR (1 << VHOST_LOG_CACHE_SHIFT)
+#define VHOST_LOG_CACHE_MAX (VHOST_LOG_CACHE_NR * 3 / 4)
+
+/*
+ * Small copies deferred per virtqueue, beyond the ring size or this
+ * limit they are done in place.
+ */
+#define VHOST_BATCH_COPY_MAX 128
 
 /**
  * Structure contains buffer address, length and descriptor index
@@ -57,11 +78,7 @@ struct zcopy_mbuf {
 	struct rte_mbuf *mbuf;
 	uint32_t desc_idx;
 	uint16_t desc_count;
-	uint16_t in_use;
-
-	TAILQ_ENTRY(zcopy_mbuf) next;
 };
-TAILQ_HEAD(zcopy_mbuf_list, zcopy_mbuf);
 
 /*
  * Structure contains the info for each batched memory copy.
@@ -74,7 +91,8 @@ struct batch_copy_elem {
 };
 
 /*
- * Structure that contains the info for batched dirty logging.
+ * Structure that contains the info for batched dirty logging,
+ * an entry is free when val is 0.
  */
 struct log_cache_entry {
 	uint32_t offset;
@@ -87,6 +105,87 @@ struct vring_used_elem_packed {
 	uint32_t count;
 };
 
+/*
+ * Statistics of a virtqueue, see struct rte_vhost_vring_stats. They are
+ * only written by the thread holding the virtqueue in the datapath, seq
+ * is odd while a burst updates them so that readers can take a consistent
+ * snapshot without locking.
+ */
+struct vhost_vring_stats {
+	uint32_t seq;
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t burst_hist[RTE_VHOST_STATS_HIST_NR];
+	uint64_t chain_hist[RTE_VHOST_STATS_HIST_NR];
+	uint64_t empty_polls;
+	uint64_t guest_notifications;
+	uint64_t iotlb_misses;
+	uint64_t zcopy_fallbacks;
+	uint64_t batch_copy_bytes;
+	uint64_t direct_copy_bytes;
+	uint64_t budget_hits;
+	uint64_t sw_cksums;
+};
+
+static __rte_always_inline void
+vhost_vring_stats_begin(struct vhost_vring_stats *stats)
+{
+	stats->seq++;
+	rte_smp_wmb();
+}
+
+static __rte_always_inline void
+vhost_vring_stats_end(struct vhost_vring_stats *stats)
+{
+	rte_smp_wmb();
+	stats->seq++;
+}
+
+/* Attempts of rte_vhost_vring_stats_get() at a consistent snapshot */
+#define VHOST_STATS_READ_RETRIES 1000
+
+/* Histogram bucket of a count: 1, 2, 3-4, 5-8, ... */
+static __rte_always_inline uint32_t
+vhost_stats_bucket(uint32_t n)
+{
+	uint32_t b;
+
+	if (n <= 1)
+		return 0;
+	b = 32 - __builtin_clz(n - 1);
+
+	return RTE_MIN(b, (uint32_t)RTE_VHOST_STATS_HIST_NR - 1);
+}
+
+/* Deepest dequeue prefetch pipeline of a split vring */
+#define VHOST_PREFETCH_DEPTH_MAX	16
+
+/* Calls of the datapath between two steps of the burst size tuning */
+#define VHOST_BURST_TUNE_PERIOD	256
+/* Periods without growth after the burst size was stepped back */
+#define VHOST_BURST_TUNE_HOLD	64
+
+/*
+ * Burst size tuning of a virtqueue, disabled when max_burst is 0. The
+ * counters cover the calls of the current period, cycles and pkts only
+ * the calls which moved packets.
+ */
+struct vhost_burst_tune {
+	uint16_t min_burst;
+	uint16_t max_burst;
+	uint64_t max_cycles;
+	uint16_t burst;
+	/* Burst size and cycles per packet before the last growth, if any */
+	uint16_t prev_burst;
+	uint64_t prev_cpp;
+	uint16_t hold;
+	uint32_t calls;
+	uint32_t busy_calls;
+	uint32_t full_calls;
+	uint64_t pkts;
+	uint64_t cycles;
+};
+
 /**
  * Structure contains variables relevant to RX/TX virtqueues.
  */
@@ -104,12 +203,16 @@ struct vhost_virtqueue {
 		struct vring_packed_desc_event *device_event;
 	};
 	uint32_t		size;
+	/* Index of the virtqueue in the device */
+	uint16_t		index;
 
 	uint16_t		last_avail_idx;
 	uint16_t		last_used_idx;
 	/* Last used index we notify to front end. */
 	uint16_t		signalled_used;
 	bool			signalled_used_valid;
+	/* Avail ring end last seen by rte_vhost_vrings_pending() */
+	uint16_t		pending_end;
 #define VIRTIO_INVALID_EVENTFD		(-1)
 #define VIRTIO_UNINITIALIZED_EVENTFD	(-2)
 
@@ -118,20 +221,50 @@ struct vhost_virtqueue {
 	int			enabled;
 	int			access_ok;
 	rte_spinlock_t		access_lock;
+	/* Lockless mode: odd while the datapath runs, see vhost_vq_lock() */
+	uint32_t		dp_seq;
+	uint32_t		quiesce_req;
+	/* Left alone by the datapath, see rte_vhost_vring_pause() */
+	bool			paused;
 
 	/* Used to notify the guest (trigger interrupt) */
 	int			callfd;
+	/*
+	 * Guest signal coalescing, disabled when coalesce_cycles is 0: the
+	 * used entries from coalesce_used_idx on are signalled after
+	 * coalesce_cycles from the last signal at coalesce_tsc, or once
+	 * there are coalesce_frames of them.
+	 */
+	uint64_t		coalesce_cycles;
+	uint64_t		coalesce_tsc;
+	uint16_t		coalesce_frames;
+	uint16_t		coalesce_used_idx;
+	bool			coalesce_used_wrap;
+	/* Bytes after which a burst stops, 0 for no limit */
+	uint32_t		budget_bytes;
+	/*
+	 * Used entries held back by the split ring enqueue before they are
+	 * written to the used ring, 0 to write them at each burst, and the
+	 * cycles they may be held from used_batch_tsc on, 0 for no bound
+	 */
+	uint16_t		used_batch;
+	uint64_t		used_batch_cycles;
+	uint64_t		used_batch_tsc;
+	struct vhost_burst_tune	burst_tune;
+	/* Chains whose buffers the split ring dequeue prefetches ahead */
+	uint16_t		prefetch_depth;
+	/* Socket of the polling lcore checked against the rings */
+	bool			numa_checked;
 	/* Currently unused as polling mode is enabled */
 	int			kickfd;
 
 	/* Physical address of used ring, for logging */
 	uint64_t		log_guest_addr;
 
+	/* Zero copy mbufs in flight, the first nr_zmbuf of zmbufs[] */
 	uint16_t		nr_zmbuf;
 	uint16_t		zmbuf_size;
-	uint16_t		last_zmbuf_idx;
 	struct zcopy_mbuf	*zmbufs;
-	struct zcopy_mbuf_list	zmbuf_list;
 
 	union {
 		struct vring_used_elem  *shadow_used_split;
@@ -140,20 +273,58 @@ struct vhost_virtqueue {
 	uint16_t                shadow_used_idx;
 	struct vhost_vring_addr ring_addrs;
 
+	/* Copy of the indirect table being walked, when not contiguous */
+	void			*ind_table;
+	uint32_t		ind_table_size;
+
+	/* Shared with the master, NULL when inflight tracking is off */
+	struct inflight_info_split *inflight_split;
+	uint64_t		inflight_counter;
+	/* Inflight descriptors left by a previous backend, oldest first */
+	struct resubmit_desc	*resubmit_list;
+	uint16_t		resubmit_num;
+	uint16_t		resubmit_idx;
+
 	struct batch_copy_elem	*batch_copy_elems;
 	uint16_t		batch_copy_nb_elems;
+	uint16_t		batch_copy_max;
 	bool			used_wrap_counter;
 	bool			avail_wrap_counter;
 
-	struct log_cache_entry log_cache[VHOST_LOG_CACHE_NR];
+	/* Allocated once dirty logging starts, see vhost_log_cache_alloc() */
+	struct log_cache_entry *log_cache;
+	uint16_t *log_cache_used;
 	uint16_t log_cache_nb_elem;
+	uint64_t log_dirty_pages;
 
 	rte_rwlock_t	iotlb_lock;
 	rte_rwlock_t	iotlb_pending_lock;
 	struct rte_mempool *iotlb_pool;
-	TAILQ_HEAD(, vhost_iotlb_entry) iotlb_list;
-	int				iotlb_cache_nr;
+	/* Cached entries sorted by iova, see iotlb.c */
+	struct vhost_iotlb_entry **iotlb_cache;
+	uint32_t		iotlb_cache_nr;
+	uint32_t		iotlb_hint;
+	uint64_t		iotlb_clock;
 	TAILQ_HEAD(, vhost_iotlb_entry) iotlb_pending_list;
+
+	/* Asynchronous copy channel, see rte_vhost_async.h */
+	bool			async_registered;
+	uint32_t		async_threshold;
+	struct rte_vhost_async_channel_ops async_ops;
+	/* In flight packets and their number of used entries, in order. */
+	struct rte_mbuf		**async_pkts;
+	uint16_t		*async_pkts_nr_used;
+	uint16_t		async_pkts_idx;
+	uint16_t		async_pkts_inflight_n;
+	/* Used entries of the in flight packets. */
+	struct vring_used_elem	*async_used;
+	uint16_t		async_used_idx;
+	uint16_t		async_used_n;
+	/* Copy jobs of a burst. */
+	struct rte_vhost_async_desc *async_descs;
+	struct iovec		*async_iov;
+
+	struct vhost_vring_stats stats;
 } __rte_cache_aligned;
 
 /* Old kernels have no such macros defined */
@@ -214,35 +385,6 @@ struct vhost_msg {
  #define VIRTIO_F_VERSION_1 32
 #endif
 
-/* Declare packed ring related bits for older kernels */
-#ifndef VIRTIO_F_RING_PACKED
-
-#define VIRTIO_F_RING_PACKED 34
-
-struct vring_packed_desc {
-	uint64_t addr;
-	uint32_t len;
-	uint16_t id;
-	uint16_t flags;
-};
-
-struct vring_packed_desc_event {
-	uint16_t off_wrap;
-	uint16_t flags;
-};
-#endif
-
-/*
- * Declare below packed ring defines unconditionally
- * as Kernel header might use different names.
- */
-#define VRING_DESC_F_AVAIL	(1ULL << 7)
-#define VRING_DESC_F_USED	(1ULL << 15)
-
-#define VRING_EVENT_F_ENABLE 0x0
-#define VRING_EVENT_F_DISABLE 0x1
-#define VRING_EVENT_F_DESC 0x2
-
 /*
  * Available and used descs are in same order
  */
@@ -279,6 +421,35 @@ struct vring_packed_desc_event {
 				(1ULL << VIRTIO_F_RING_PACKED))
 
 
+/*
+ * Inflight descriptors of a split ring, in the memory shared with the
+ * master for VHOST_USER_PROTOCOL_F_INFLIGHT_SHMFD. The layout is the one
+ * of the vhost-user specification.
+ */
+struct inflight_desc_split {
+	uint8_t		inflight;
+	uint8_t		padding[5];
+	uint16_t	next;
+	uint64_t	counter;
+};
+
+struct inflight_info_split {
+	uint64_t	features;
+	uint16_t	version;
+	uint16_t	desc_num;
+	uint16_t	last_inflight_io;
+	uint16_t	used_idx;
+	struct inflight_desc_split desc[0];
+};
+
+#define INFLIGHT_ALIGNMENT	64
+#define INFLIGHT_VERSION	0x1
+
+struct resubmit_desc {
+	uint16_t	index;
+	uint64_t	counter;
+};
+
 struct guest_page {
 	uint64_t guest_phys_addr;
 	uint64_t host_phys_addr;
@@ -335,6 +506,19 @@ struct vhost_user_extern_ops {
 	vhost_msg_post_handle post_msg_handle;
 };
 
+/* Guest memory prefault job, private to vhost_user.c */
+struct vhost_prefault;
+
+/* Handling time of a vhost-user message type, in TSC cycles. */
+struct vhost_msg_stats {
+	uint64_t count;
+	uint64_t cycles;
+	uint64_t max_cycles;
+};
+
+/* Message types with statistics, above the last vhost-user request. */
+#define VHOST_MSG_STATS_MAX 40
+
 /**
  * Device structure contains all configuration information relating
  * to the device.
@@ -342,21 +526,46 @@ struct vhost_user_extern_ops {
 struct virtio_net {
 	/* Frontend (QEMU) memory and memory region information */
 	struct rte_vhost_memory	*mem;
+	/* The two tables mem alternates between, see vhost_user.c */
+	struct rte_vhost_memory	*mem_tables[2];
 	uint64_t		features;
 	uint64_t		protocol_features;
 	int			vid;
 	uint32_t		flags;
 	uint16_t		vhost_hlen;
+	/* datapath variants for the features, see vhost_select_datapath() */
+	uint8_t			dp_rx;
+	uint8_t			dp_tx;
 	/* to tell if we need broadcast rarp packet */
 	rte_atomic16_t		broadcast_rarp;
 	uint32_t		nr_vring;
 	int			dequeue_zero_copy;
-	struct vhost_virtqueue	*virtqueue[VHOST_MAX_QUEUE_PAIRS * 2];
+	/* The datapath does not take the vring access locks */
+	int			lockless;
+	/* Guest memory is faulted in by a background thread once mapped */
+	int			prefault;
+	struct vhost_prefault	*prefault_ctx;
+	pthread_t		prefault_tid;
+	/* Regions of the EAL memory are used in place, not mapped again */
+	int			shared_mem;
+	/* Large copies to the guest use non-temporal stores */
+	int			nt_copy;
+	/* Dequeued L4 checksums are computed while copying */
+	int			sw_cksum;
+	/* IOTLB entries cached per virtqueue, 0 for the default */
+	uint32_t		iotlb_cache_size;
+	/* Updated by the event thread of the device only */
+	struct vhost_msg_stats	msg_stats[VHOST_MSG_STATS_MAX];
+	/* max_vring slots, from the queue pairs allowed on the socket */
+	struct vhost_virtqueue	**virtqueue;
+	uint32_t		max_vring;
 #define IF_NAME_SZ (PATH_MAX > IFNAMSIZ ? PATH_MAX : IFNAMSIZ)
 	char			ifname[IF_NAME_SZ];
 	uint64_t		log_size;
 	uint64_t		log_base;
 	uint64_t		log_addr;
+	/* Size of the log mapping, aligned on the pages of the log fd */
+	uint64_t		log_map_size;
 	struct ether_addr	mac;
 	uint16_t		mtu;
 
@@ -372,11 +581,28 @@ struct virtio_net {
 	int			postcopy_ufd;
 	int			postcopy_listening;
 
+	/* Inflight tracking memory shared with the master */
+	void			*inflight_addr;
+	uint64_t		inflight_size;
+	int			inflight_fd;
+	uint16_t		inflight_num_queues;
+	uint16_t		inflight_queue_size;
+
 	/*
 	 * Device id to identify a specific backend device.
 	 * It's set to -1 for the default software implementation.
 	 */
 	int			vdpa_dev_id;
+	/*
+	 * Serializes vdpa_dev_id and the vdpa device configuration between
+	 * the message handler and rte_vhost_{at,de}tach_vdpa_device().
+	 */
+	pthread_mutex_t		vdpa_lock;
+
+	/* Secondary processes attached, see vhost_mp.c */
+	uint32_t		mp_attached;
+	uint32_t		mp_gen;
+	uint32_t		mp_busy;
 
 	/* private data for virtio device */
 	void			*extern_data;
@@ -446,10 +672,33 @@ vhost_log_write(struct virtio_net *dev, uint64_t addr, uint64_t len)
 	}
 }
 
+/*
+ * OR a word into the dirty log, return the number of pages it newly
+ * marks dirty.
+ */
+static __rte_always_inline uint32_t
+vhost_log_word_or(unsigned long *log_base, uint32_t offset, unsigned long val)
+{
+	unsigned long old;
+
+#if defined(RTE_TOOLCHAIN_GCC) && (GCC_VERSION < 70100)
+	/*
+	 * '__sync' builtins are deprecated, but '__atomic' ones
+	 * are sub-optimized in older GCC versions.
+	 */
+	old = __sync_fetch_and_or(log_base + offset, val);
+#else
+	old = __atomic_fetch_or(log_base + offset, val, __ATOMIC_RELAXED);
+#endif
+
+	return __builtin_popcountl(val & ~old);
+}
+
 static __rte_always_inline void
 vhost_log_cache_sync(struct virtio_net *dev, struct vhost_virtqueue *vq)
 {
 	unsigned long *log_base;
+	uint64_t pages = 0;
 	int i;
 
 	if (likely(((dev->features & (1ULL << VHOST_F_LOG_ALL)) == 0) ||
@@ -464,23 +713,21 @@ vhost_log_cache_sync(struct virtio_net *dev, struct vhost_virtqueue *vq)
 	 */
 
 	for (i = 0; i < vq->log_cache_nb_elem; i++) {
-		struct log_cache_entry *elem = vq->log_cache + i;
-
-#if defined(RTE_TOOLCHAIN_GCC) && (GCC_VERSION < 70100)
-		/*
-		 * '__sync' builtins are deprecated, but '__atomic' ones
-		 * are sub-optimized in older GCC versions.
-		 */
-		__sync_fetch_and_or(log_base + elem->offset, elem->val);
-#else
-		__atomic_fetch_or(log_base + elem->offset, elem->val,
-				__ATOMIC_RELAXED);
-#endif
+		struct log_cache_entry *elem =
+			vq->log_cache + vq->log_cache_used[i];
+
+		/* the words are scattered over a large bitmap */
+		if (i + 1 < vq->log_cache_nb_elem)
+			rte_prefetch0(log_base + vq->log_cache[
+				vq->log_cache_used[i + 1]].offset);
+		pages += vhost_log_word_or(log_base, elem->offset, elem->val);
+		elem->val = 0;
 	}
 
 	rte_smp_wmb();
 
 	vq->log_cache_nb_elem = 0;
+	vq->log_dirty_pages += pages;
 }
 
 static __rte_always_inline void
@@ -489,31 +736,40 @@ vhost_log_cache_page(struct virtio_net *dev, struct vhost_virtqueue *vq,
 {
 	uint32_t bit_nr = page % (sizeof(unsigned long) << 3);
 	uint32_t offset = page / (sizeof(unsigned long) << 3);
-	int i;
+	uint16_t slot;
+	struct log_cache_entry *elem;
 
-	for (i = 0; i < vq->log_cache_nb_elem; i++) {
-		struct log_cache_entry *elem = vq->log_cache + i;
+	/* Spread strided guest buffers over the table. */
+	slot = (offset * 0x9e3779b1U) >> (32 - VHOST_LOG_CACHE_SHIFT);
 
+	/* There is always a free entry to end the search. */
+	for (;;) {
+		elem = vq->log_cache + slot;
+		if (elem->val == 0)
+			break;
 		if (elem->offset == offset) {
 			elem->val |= (1UL << bit_nr);
 			return;
 		}
+		slot = (slot + 1) & (VHOST_LOG_CACHE_NR - 1);
 	}
 
-	if (unlikely(i >= VHOST_LOG_CACHE_NR)) {
+	if (unlikely(vq->log_cache_nb_elem >= VHOST_LOG_CACHE_MAX)) {
 		/*
 		 * No more room for a new log cache entry,
 		 * so write the dirty log map directly.
 		 */
 		rte_smp_wmb();
-		vhost_log_page((uint8_t *)(uintptr_t)dev->log_base, page);
+		vq->log_dirty_pages += vhost_log_word_or(
+				(unsigned long *)(uintptr_t)dev->log_base,
+				offset, 1UL << bit_nr);
 
 		return;
 	}
 
-	vq->log_cache[i].offset = offset;
-	vq->log_cache[i].val = (1UL << bit_nr);
-	vq->log_cache_nb_elem++;
+	elem->offset = offset;
+	elem->val = (1UL << bit_nr);
+	vq->log_cache_used[vq->log_cache_nb_elem++] = slot;
 }
 
 static __rte_always_inline void
@@ -529,6 +785,11 @@ vhost_log_cache_write(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	if (unlikely(dev->log_size <= ((addr + len - 1) / VHOST_LOG_PAGE / 8)))
 		return;
 
+	if (unlikely(vq->log_cache == NULL)) {
+		vhost_log_write(dev, addr, len);
+		return;
+	}
+
 	page = addr / VHOST_LOG_PAGE;
 	while (page * VHOST_LOG_PAGE < addr + len) {
 		vhost_log_cache_page(dev, vq, page);
@@ -582,32 +843,124 @@ vhost_log_used_vring(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 extern uint64_t VHOST_FEATURES;
 #define MAX_VHOST_DEVICE	1024
-extern struct virtio_net *vhost_devices[MAX_VHOST_DEVICE];
+/* Allocated with vhost_nr_devices slots when the first device is created */
+extern struct virtio_net **vhost_devices;
+extern uint32_t vhost_nr_devices;
+
+#define VHOST_MP_MAX_REGIONS	16
 
-/* Convert guest physical address to host physical address */
+struct vhost_mp_region {
+	void			*addr;
+	uint64_t		size;
+};
+
+/* Guest memory and call eventfds of a device, in a secondary process */
+struct vhost_mp_dev {
+	uint32_t		mem_gen;
+	uint32_t		nregions;
+	struct vhost_mp_region	regions[VHOST_MP_MAX_REGIONS];
+	uint32_t		call_gen[VHOST_MAX_VRING];
+	int			callfd[VHOST_MAX_VRING];
+};
+
+/* NULL in the primary process */
+extern struct vhost_mp_dev **vhost_mp_devs;
+
+/* The eventfds are private to each process */
+static __rte_always_inline int
+vhost_vring_callfd(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (likely(vhost_mp_devs == NULL))
+		return vq->callfd;
+	return vhost_mp_devs[dev->vid]->callfd[vq->index];
+}
+
+/*
+ * Convert the start of a guest physical range to host physical address,
+ * *hpa_size gets the length of it contiguous in host physical memory. The
+ * guest pages are sorted by guest physical address and do not overlap.
+ */
 static __rte_always_inline rte_iova_t
-gpa_to_hpa(struct virtio_net *dev, uint64_t gpa, uint64_t size)
+gpa_to_first_hpa(struct virtio_net *dev, uint64_t gpa, uint64_t gpa_size,
+		 uint64_t *hpa_size)
 {
-	uint32_t i;
+	uint32_t lo = 0, hi = dev->nr_guest_pages, mid;
 	struct guest_page *page;
 
-	for (i = 0; i < dev->nr_guest_pages; i++) {
-		page = &dev->guest_pages[i];
-
-		if (gpa >= page->guest_phys_addr &&
-		    gpa + size < page->guest_phys_addr + page->size) {
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		page = &dev->guest_pages[mid];
+
+		if (gpa < page->guest_phys_addr) {
+			hi = mid;
+		} else if (gpa >= page->guest_phys_addr + page->size) {
+			lo = mid + 1;
+		} else {
+			*hpa_size = RTE_MIN(gpa_size, page->guest_phys_addr +
+					    page->size - gpa);
 			return gpa - page->guest_phys_addr +
 			       page->host_phys_addr;
 		}
 	}
 
+	*hpa_size = 0;
 	return 0;
 }
 
+/*
+ * Convert guest physical address to host physical address, 0 if the range
+ * is not contiguous in host physical memory.
+ */
+static __rte_always_inline rte_iova_t
+gpa_to_hpa(struct virtio_net *dev, uint64_t gpa, uint64_t size)
+{
+	rte_iova_t hpa;
+	uint64_t hpa_size;
+
+	hpa = gpa_to_first_hpa(dev, gpa, size, &hpa_size);
+
+	return hpa_size == size ? hpa : 0;
+}
+
+/* zero copy mbufs: no reference left but the one of vhost */
+static __rte_always_inline bool
+mbuf_is_consumed(struct rte_mbuf *m)
+{
+	while (m) {
+		if (rte_mbuf_refcnt_read(m) > 1)
+			return false;
+		m = m->next;
+	}
+
+	return true;
+}
+
+/* zero copy mbufs: point the buffer back to the mbuf own data room */
+static __rte_always_inline void
+restore_mbuf(struct rte_mbuf *m)
+{
+	uint32_t mbuf_size, priv_size;
+
+	while (m) {
+		priv_size = rte_pktmbuf_priv_size(m->pool);
+		mbuf_size = sizeof(struct rte_mbuf) + priv_size;
+		/* start of buffer is after mbuf structure and priv data */
+
+		m->buf_addr = (char *)m + mbuf_size;
+		m->buf_iova = rte_mempool_virt2iova(m) + mbuf_size;
+		m = m->next;
+	}
+}
+
 static __rte_always_inline struct virtio_net *
 get_device(int vid)
 {
-	struct virtio_net *dev = vhost_devices[vid];
+	struct virtio_net *dev = NULL;
+
+	/* Lockless, see the release stores of vhost_new_device() */
+	if (likely((uint32_t)vid < __atomic_load_n(&vhost_nr_devices,
+			__ATOMIC_ACQUIRE)))
+		dev = __atomic_load_n(&vhost_devices[vid], __ATOMIC_ACQUIRE);
 
 	if (unlikely(!dev)) {
 		RTE_LOG(ERR, VHOST_CONFIG,
@@ -617,23 +970,49 @@ get_device(int vid)
 	return dev;
 }
 
-int vhost_new_device(void);
+int vhost_new_device(uint32_t max_queue_pairs);
 void cleanup_device(struct virtio_net *dev, int destroy);
 void reset_device(struct virtio_net *dev);
 void vhost_destroy_device(int);
 void vhost_destroy_device_notify(struct virtio_net *dev);
+uint32_t vhost_get_max_devices(void);
+
+void vhost_mp_init(void);
+void vhost_mp_lock(void);
+void vhost_mp_unlock(void);
+void vhost_mp_mem_update_begin(struct virtio_net *dev,
+			       const struct rte_vhost_memory *mem);
+void vhost_mp_mem_update_end(struct virtio_net *dev);
+void vhost_mp_call_update(struct virtio_net *dev, uint32_t vring_idx);
+void vhost_mp_destroy(struct virtio_net *dev);
 
 void cleanup_vq(struct vhost_virtqueue *vq, int destroy);
 void free_vq(struct virtio_net *dev, struct vhost_virtqueue *vq);
+int vhost_log_cache_alloc(struct vhost_virtqueue *vq);
 
 int alloc_vring_queue(struct virtio_net *dev, uint32_t vring_idx);
 
 void vhost_attach_vdpa_device(int vid, int did);
 void vhost_detach_vdpa_device(int vid);
 
+void vhost_vq_lock(struct virtio_net *dev, struct vhost_virtqueue *vq);
+void vhost_vq_unlock(struct virtio_net *dev, struct vhost_virtqueue *vq);
+void vhost_user_lock_all_queue_pairs(struct virtio_net *dev);
+void vhost_user_unlock_all_queue_pairs(struct virtio_net *dev);
+
 void vhost_set_ifname(int, const char *if_name, unsigned int if_len);
 void vhost_enable_dequeue_zero_copy(int vid);
+int vhost_lockless_init(void);
+void vhost_enable_lockless(int vid);
+void vhost_enable_prefault(int vid);
+void vhost_enable_shared_mem(int vid);
+void vhost_enable_nt_copy(int vid);
+void vhost_enable_sw_cksum(int vid);
+void vhost_select_datapath(struct virtio_net *dev);
+void vhost_vring_check_numa(struct virtio_net *dev, struct vhost_virtqueue *vq);
+void vhost_flush_used_batch(struct virtio_net *dev, struct vhost_virtqueue *vq);
 void vhost_set_builtin_virtio_net(int vid, bool enable);
+void vhost_set_iotlb_cache_size(int vid, uint32_t size);
 
 struct vhost_device_ops const *vhost_driver_callback_get(const char *path);
 
@@ -659,6 +1038,54 @@ vhost_iova_to_vva(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	return __vhost_iova_to_vva(dev, vq, iova, len, perm);
 }
 
+/*
+ * Datapath side of the vring access lock, returns false when the vring
+ * must be left alone. In lockless mode a single lcore polls the vring and
+ * only marks with plain stores that it runs, the control plane pairs it
+ * with a process wide barrier in vhost_vq_lock().
+ */
+static __rte_always_inline bool
+vhost_vq_dp_enter(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		  bool try)
+{
+	if (!dev->lockless) {
+		if (try) {
+			if (!rte_spinlock_trylock(&vq->access_lock))
+				return false;
+		} else {
+			rte_spinlock_lock(&vq->access_lock);
+		}
+		if (unlikely(vq->paused)) {
+			rte_spinlock_unlock(&vq->access_lock);
+			return false;
+		}
+		return true;
+	}
+
+	__atomic_store_n(&vq->dp_seq, vq->dp_seq + 1, __ATOMIC_RELAXED);
+	rte_compiler_barrier();
+	if (unlikely(__atomic_load_n(&vq->quiesce_req, __ATOMIC_ACQUIRE) ||
+		     vq->paused)) {
+		__atomic_store_n(&vq->dp_seq, vq->dp_seq + 1,
+				 __ATOMIC_RELEASE);
+		return false;
+	}
+
+	return true;
+}
+
+static __rte_always_inline void
+vhost_vq_dp_leave(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (!dev->lockless) {
+		rte_spinlock_unlock(&vq->access_lock);
+		return;
+	}
+
+	/* The vring accesses are done before the control plane sees it. */
+	__atomic_store_n(&vq->dp_seq, vq->dp_seq + 1, __ATOMIC_RELEASE);
+}
+
 #define vhost_avail_event(vr) \
 	(*(volatile uint16_t*)&(vr)->used->ring[(vr)->size])
 #define vhost_used_event(vr) \
@@ -676,12 +1103,66 @@ vhost_need_event(uint16_t event_idx, uint16_t new_idx, uint16_t old)
 	return (uint16_t)(new_idx - event_idx - 1) < (uint16_t)(new_idx - old);
 }
 
+/* Number of used entries added since the last guest signal. */
+static __rte_always_inline uint16_t
+vhost_vring_coalesce_pending(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (!vq_is_packed(dev))
+		return vq->last_used_idx - vq->coalesce_used_idx;
+
+	if (vq->used_wrap_counter != vq->coalesce_used_wrap)
+		return vq->last_used_idx + vq->size - vq->coalesce_used_idx;
+
+	return vq->last_used_idx - vq->coalesce_used_idx;
+}
+
+/* Start a new coalescing period, the pending entries are signalled. */
 static __rte_always_inline void
-vhost_vring_call_split(struct virtio_net *dev, struct vhost_virtqueue *vq)
+vhost_vring_coalesce_reset(struct vhost_virtqueue *vq, uint64_t now)
 {
+	vq->coalesce_tsc = now;
+	vq->coalesce_used_idx = vq->last_used_idx;
+	vq->coalesce_used_wrap = vq->used_wrap_counter;
+}
+
+/*
+ * Return true when the coalescing settings of the vring hold the guest
+ * signal back, otherwise a new coalescing period starts.
+ */
+static __rte_always_inline bool
+vhost_vring_coalesce(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	uint16_t pending;
+	uint64_t now;
+
+	if (likely(!vq->coalesce_cycles))
+		return false;
+
+	pending = vhost_vring_coalesce_pending(dev, vq);
+	if (!pending)
+		return true;
+
+	now = rte_rdtsc();
+	if (now - vq->coalesce_tsc < vq->coalesce_cycles &&
+	    (!vq->coalesce_frames || pending < vq->coalesce_frames))
+		return true;
+
+	vhost_vring_coalesce_reset(vq, now);
+
+	return false;
+}
+
+/* Signal the guest for the used entries, coalescing aside. */
+static __rte_always_inline void
+vhost_vring_signal_split(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	int callfd;
+
 	/* Flush used->idx update before we read avail->flags. */
 	rte_smp_mb();
 
+	callfd = vhost_vring_callfd(dev, vq);
+
 	/* Don't kick guest if we don't reach index specified by guest. */
 	if (dev->features & (1ULL << VIRTIO_RING_F_EVENT_IDX)) {
 		uint16_t old = vq->signalled_used;
@@ -692,20 +1173,34 @@ vhost_vring_call_split(struct virtio_net *dev, struct vhost_virtqueue *vq)
 			vhost_used_event(vq),
 			old, new);
 		if (vhost_need_event(vhost_used_event(vq), new, old)
-			&& (vq->callfd >= 0)) {
+			&& (callfd >= 0)) {
 			vq->signalled_used = vq->last_used_idx;
-			eventfd_write(vq->callfd, (eventfd_t) 1);
+			eventfd_write(callfd, (eventfd_t) 1);
+			vq->stats.guest_notifications++;
+			VHOST_TRACE(dev->vid, vq->index, CALL,
+				vq->last_used_idx);
 		}
 	} else {
 		/* Kick the guest if necessary. */
 		if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT)
-				&& (vq->callfd >= 0))
-			eventfd_write(vq->callfd, (eventfd_t)1);
+				&& (callfd >= 0)) {
+			eventfd_write(callfd, (eventfd_t)1);
+			vq->stats.guest_notifications++;
+			VHOST_TRACE(dev->vid, vq->index, CALL,
+				vq->last_used_idx);
+		}
 	}
 }
 
 static __rte_always_inline void
-vhost_vring_call_packed(struct virtio_net *dev, struct vhost_virtqueue *vq)
+vhost_vring_call_split(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (!vhost_vring_coalesce(dev, vq))
+		vhost_vring_signal_split(dev, vq);
+}
+
+static __rte_always_inline void
+vhost_vring_signal_packed(struct virtio_net *dev, struct vhost_virtqueue *vq)
 {
 	uint16_t old, new, off, off_wrap;
 	bool signalled_used_valid, kick = false;
@@ -751,8 +1246,35 @@ vhost_vring_call_packed(struct virtio_net *dev, struct vhost_virtqueue *vq)
 	if (vhost_need_event(off, new, old))
 		kick = true;
 kick:
-	if (kick)
-		eventfd_write(vq->callfd, (eventfd_t)1);
+	if (kick) {
+		eventfd_write(vhost_vring_callfd(dev, vq), (eventfd_t)1);
+		vq->stats.guest_notifications++;
+		VHOST_TRACE(dev->vid, vq->index, CALL, vq->last_used_idx);
+	}
+}
+
+static __rte_always_inline void
+vhost_vring_call_packed(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (!vhost_vring_coalesce(dev, vq))
+		vhost_vring_signal_packed(dev, vq);
+}
+
+/*
+ * Called by the datapath when a burst added no used entry, so that the
+ * entries held back by coalescing get signalled once their period ends.
+ */
+static __rte_always_inline void
+vhost_vring_call_flush(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (likely(!vq->coalesce_cycles) ||
+	    !vhost_vring_coalesce_pending(dev, vq))
+		return;
+
+	if (vq_is_packed(dev))
+		vhost_vring_call_packed(dev, vq);
+	else
+		vhost_vring_call_split(dev, vq);
 }
 
 #endif /* _VHOST_NET_CDEV_H_ */
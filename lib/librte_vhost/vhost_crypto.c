@@ -196,6 +196,10 @@ struct vhost_crypto {
 	 *  session ID.
 	 */
 	struct rte_hash *session_map;
+	/** Used to lookup the session already created for the same
+	 *  parameters.
+	 */
+	struct rte_hash *session_cache;
 	struct rte_mempool *mbuf_pool;
 	struct rte_mempool *sess_pool;
 	struct rte_mempool *wb_pool;
@@ -206,16 +210,50 @@ struct vhost_crypto {
 
 	uint64_t last_session_id;
 
-	uint64_t cache_session_id;
-	struct rte_cryptodev_sym_session *cache_session;
 	/** socket id for the device */
 	int socket_id;
 
 	struct virtio_net *dev;
 
 	uint8_t option;
+	/** the cryptodev takes chained mbufs, zero copy needs no contiguity */
+	uint8_t sgl;
 } __rte_cache_aligned;
 
+/** The session parameters, two guest sessions equal here share a session */
+struct vhost_crypto_session_key {
+	uint32_t op_code;
+	uint32_t cipher_algo;
+	uint32_t cipher_key_len;
+	uint32_t hash_algo;
+	uint32_t digest_len;
+	uint32_t auth_key_len;
+	uint32_t aad_len;
+	uint8_t op_type;
+	uint8_t dir;
+	uint8_t hash_mode;
+	uint8_t chaining_dir;
+	uint8_t cipher_key[VHOST_USER_CRYPTO_MAX_CIPHER_KEY_LENGTH];
+	uint8_t auth_key[VHOST_USER_CRYPTO_MAX_HMAC_KEY_LENGTH];
+};
+
+struct vhost_crypto_session {
+	struct vhost_crypto_session_key key;
+	struct rte_cryptodev_sym_session *session;
+	/** guest sessions using it */
+	uint32_t refcnt;
+};
+
+/**
+ * Last session looked up, for the requests of one fetch burst. It is not
+ * kept in the device so that its data queues can be fetched from different
+ * lcores.
+ */
+struct vhost_crypto_sess_cache {
+	uint64_t session_id;
+	struct vhost_crypto_session *session;
+};
+
 struct vhost_crypto_writeback_data {
 	uint8_t *src;
 	uint8_t *dst;
@@ -318,31 +356,92 @@ transform_chain_param(struct rte_crypto_sym_xform *xforms,
 	return 0;
 }
 
-static void
-vhost_crypto_create_sess(struct vhost_crypto *vcrypto,
+static int
+vhost_crypto_session_key(struct vhost_crypto_session_key *key,
 		VhostUserCryptoSessionParam *sess_param)
+{
+	if (unlikely(sess_param->cipher_key_len >
+			VHOST_USER_CRYPTO_MAX_CIPHER_KEY_LENGTH ||
+			sess_param->auth_key_len >
+			VHOST_USER_CRYPTO_MAX_HMAC_KEY_LENGTH))
+		return -VIRTIO_CRYPTO_BADMSG;
+
+	memset(key, 0, sizeof(*key));
+	key->op_code = sess_param->op_code;
+	key->cipher_algo = sess_param->cipher_algo;
+	key->cipher_key_len = sess_param->cipher_key_len;
+	key->hash_algo = sess_param->hash_algo;
+	key->digest_len = sess_param->digest_len;
+	key->auth_key_len = sess_param->auth_key_len;
+	key->aad_len = sess_param->aad_len;
+	key->op_type = sess_param->op_type;
+	key->dir = sess_param->dir;
+	key->hash_mode = sess_param->hash_mode;
+	key->chaining_dir = sess_param->chaining_dir;
+	rte_memcpy(key->cipher_key, sess_param->cipher_key_buf,
+			sess_param->cipher_key_len);
+	rte_memcpy(key->auth_key, sess_param->auth_key_buf,
+			sess_param->auth_key_len);
+
+	return 0;
+}
+
+static void
+vhost_crypto_free_session(struct vhost_crypto *vcrypto,
+		struct vhost_crypto_session *sess)
+{
+	if (rte_cryptodev_sym_session_clear(vcrypto->cid, sess->session) < 0)
+		VC_LOG_ERR("Failed to clear session");
+	else if (rte_cryptodev_sym_session_free(sess->session) < 0)
+		VC_LOG_ERR("Failed to free session");
+
+	/* the keys are not left behind in freed memory */
+	memset(&sess->key, 0, sizeof(sess->key));
+	rte_free(sess);
+}
+
+/**
+ * Create, or find in the cache, the cryptodev session of the parameters.
+ * Guests re-creating sessions of the same keys, as on every reconnection
+ * of their driver, then don't go through the PMD session setup again.
+ */
+static struct vhost_crypto_session *
+vhost_crypto_get_session(struct vhost_crypto *vcrypto,
+		VhostUserCryptoSessionParam *sess_param, int64_t *err)
 {
 	struct rte_crypto_sym_xform xform1 = {0}, xform2 = {0};
-	struct rte_cryptodev_sym_session *session;
+	struct vhost_crypto_session_key key;
+	struct vhost_crypto_session *sess;
 	int ret;
 
+	ret = vhost_crypto_session_key(&key, sess_param);
+	if (unlikely(ret)) {
+		VC_LOG_ERR("Error transform session msg (%i)", ret);
+		*err = ret;
+		return NULL;
+	}
+
+	if (rte_hash_lookup_data(vcrypto->session_cache, &key,
+			(void **)&sess) >= 0)
+		return sess;
+
 	switch (sess_param->op_type) {
 	case VIRTIO_CRYPTO_SYM_OP_NONE:
 	case VIRTIO_CRYPTO_SYM_OP_CIPHER:
 		ret = transform_cipher_param(&xform1, sess_param);
 		if (unlikely(ret)) {
 			VC_LOG_ERR("Error transform session msg (%i)", ret);
-			sess_param->session_id = ret;
-			return;
+			*err = ret;
+			return NULL;
 		}
 		break;
 	case VIRTIO_CRYPTO_SYM_OP_ALGORITHM_CHAINING:
 		if (unlikely(sess_param->hash_mode !=
 				VIRTIO_CRYPTO_SYM_HASH_MODE_AUTH)) {
-			sess_param->session_id = -VIRTIO_CRYPTO_NOTSUPP;
+			*err = -VIRTIO_CRYPTO_NOTSUPP;
 			VC_LOG_ERR("Error transform session message (%i)",
 					-VIRTIO_CRYPTO_NOTSUPP);
-			return;
+			return NULL;
 		}
 
 		xform1.next = &xform2;
@@ -350,42 +449,80 @@ vhost_crypto_create_sess(struct vhost_crypto *vcrypto,
 		ret = transform_chain_param(&xform1, sess_param);
 		if (unlikely(ret)) {
 			VC_LOG_ERR("Error transform session message (%i)", ret);
-			sess_param->session_id = ret;
-			return;
+			*err = ret;
+			return NULL;
 		}
 
 		break;
 	default:
 		VC_LOG_ERR("Algorithm not yet supported");
-		sess_param->session_id = -VIRTIO_CRYPTO_NOTSUPP;
-		return;
+		*err = -VIRTIO_CRYPTO_NOTSUPP;
+		return NULL;
+	}
+
+	sess = rte_zmalloc(NULL, sizeof(*sess), 0);
+	if (!sess) {
+		VC_LOG_ERR("Insufficient memory");
+		*err = -VIRTIO_CRYPTO_ERR;
+		return NULL;
 	}
 
-	session = rte_cryptodev_sym_session_create(vcrypto->sess_pool);
-	if (!session) {
+	sess->session = rte_cryptodev_sym_session_create(vcrypto->sess_pool);
+	if (!sess->session) {
 		VC_LOG_ERR("Failed to create session");
-		sess_param->session_id = -VIRTIO_CRYPTO_ERR;
-		return;
+		rte_free(sess);
+		*err = -VIRTIO_CRYPTO_ERR;
+		return NULL;
 	}
 
-	if (rte_cryptodev_sym_session_init(vcrypto->cid, session, &xform1,
-			vcrypto->sess_pool) < 0) {
+	if (rte_cryptodev_sym_session_init(vcrypto->cid, sess->session,
+			&xform1, vcrypto->sess_pool) < 0) {
 		VC_LOG_ERR("Failed to initialize session");
-		sess_param->session_id = -VIRTIO_CRYPTO_ERR;
-		return;
+		vhost_crypto_free_session(vcrypto, sess);
+		*err = -VIRTIO_CRYPTO_ERR;
+		return NULL;
 	}
 
+	sess->key = key;
+	if (rte_hash_add_key_data(vcrypto->session_cache, &sess->key,
+			sess) < 0) {
+		VC_LOG_ERR("Failed to insert session to cache");
+		vhost_crypto_free_session(vcrypto, sess);
+		*err = -VIRTIO_CRYPTO_ERR;
+		return NULL;
+	}
+
+	return sess;
+}
+
+static void
+vhost_crypto_put_session(struct vhost_crypto *vcrypto,
+		struct vhost_crypto_session *sess)
+{
+	if (--sess->refcnt > 0)
+		return;
+
+	rte_hash_del_key(vcrypto->session_cache, &sess->key);
+	vhost_crypto_free_session(vcrypto, sess);
+}
+
+static void
+vhost_crypto_create_sess(struct vhost_crypto *vcrypto,
+		VhostUserCryptoSessionParam *sess_param)
+{
+	struct vhost_crypto_session *sess;
+
+	sess = vhost_crypto_get_session(vcrypto, sess_param,
+			&sess_param->session_id);
+	if (!sess)
+		return;
+	sess->refcnt++;
+
 	/* insert hash to map */
 	if (rte_hash_add_key_data(vcrypto->session_map,
-			&vcrypto->last_session_id, session) < 0) {
+			&vcrypto->last_session_id, sess) < 0) {
 		VC_LOG_ERR("Failed to insert session to hash table");
-
-		if (rte_cryptodev_sym_session_clear(vcrypto->cid, session) < 0)
-			VC_LOG_ERR("Failed to clear session");
-		else {
-			if (rte_cryptodev_sym_session_free(session) < 0)
-				VC_LOG_ERR("Failed to free session");
-		}
+		vhost_crypto_put_session(vcrypto, sess);
 		sess_param->session_id = -VIRTIO_CRYPTO_ERR;
 		return;
 	}
@@ -400,33 +537,25 @@ vhost_crypto_create_sess(struct vhost_crypto *vcrypto,
 static int
 vhost_crypto_close_sess(struct vhost_crypto *vcrypto, uint64_t session_id)
 {
-	struct rte_cryptodev_sym_session *session;
+	struct vhost_crypto_session *sess;
 	uint64_t sess_id = session_id;
 	int ret;
 
 	ret = rte_hash_lookup_data(vcrypto->session_map, &sess_id,
-			(void **)&session);
+			(void **)&sess);
 
 	if (unlikely(ret < 0)) {
 		VC_LOG_ERR("Failed to delete session %"PRIu64".", session_id);
 		return -VIRTIO_CRYPTO_INVSESS;
 	}
 
-	if (rte_cryptodev_sym_session_clear(vcrypto->cid, session) < 0) {
-		VC_LOG_DBG("Failed to clear session");
-		return -VIRTIO_CRYPTO_ERR;
-	}
-
-	if (rte_cryptodev_sym_session_free(session) < 0) {
-		VC_LOG_DBG("Failed to free session");
-		return -VIRTIO_CRYPTO_ERR;
-	}
-
 	if (rte_hash_del_key(vcrypto->session_map, &sess_id) < 0) {
 		VC_LOG_DBG("Failed to delete session from hash table.");
 		return -VIRTIO_CRYPTO_ERR;
 	}
 
+	vhost_crypto_put_session(vcrypto, sess);
+
 	VC_LOG_INFO("Session %"PRIu64" deleted for vdev %i.", sess_id,
 			vcrypto->dev->vid);
 
@@ -629,6 +758,97 @@ copy_data(void *dst_data, struct vhost_crypto_data_req *vc_req,
 	return 0;
 }
 
+/* Give back the segments chained to a zero copy mbuf */
+static void
+free_zero_copy_segs(struct rte_mbuf *m)
+{
+	struct rte_mbuf *seg = m->next, *next;
+
+	while (seg) {
+		next = seg->next;
+		rte_mempool_put(seg->pool, (void *)seg);
+		seg = next;
+	}
+
+	m->next = NULL;
+	m->nb_segs = 1;
+}
+
+/**
+ * Map a zero copy mbuf over the next size bytes of guest buffers, with one
+ * segment per piece contiguous in both the host virtual and the host
+ * physical address spaces. Unless the cryptodev takes chained mbufs the
+ * data has to fit a single piece.
+ */
+static int
+prepare_zero_copy_mbuf(struct vhost_crypto *vcrypto,
+		struct vhost_crypto_data_req *vc_req, struct rte_mbuf *m,
+		struct vring_desc **cur_desc, uint32_t size, uint8_t perm)
+{
+	struct vring_desc *desc = *cur_desc;
+	struct rte_mbuf *seg = NULL, *last = NULL;
+	uint64_t addr, len, dlen, hlen;
+	rte_iova_t iova;
+	uint32_t left = size;
+	void *data;
+
+	m->next = NULL;
+	m->nb_segs = 0;
+	m->pkt_len = size;
+
+	while (left > 0) {
+		addr = desc->addr;
+		len = RTE_MIN(desc->len, left);
+		left -= len;
+
+		while (len > 0) {
+			dlen = len;
+			data = IOVA_TO_VVA(void *, vc_req, addr, &dlen, perm);
+			iova = gpa_to_first_hpa(vcrypto->dev, addr, dlen,
+					&hlen);
+			if (unlikely(data == NULL || iova == 0))
+				goto error_exit;
+
+			if (last == NULL) {
+				seg = m;
+			} else if (unlikely(!vcrypto->sgl ||
+					rte_mempool_get(vcrypto->mbuf_pool,
+						(void **)&seg) < 0)) {
+				VC_LOG_ERR("zero_copy may fail due to cross page data");
+				goto error_exit;
+			} else {
+				last->next = seg;
+			}
+
+			seg->buf_addr = data;
+			seg->buf_iova = iova;
+			seg->buf_len = hlen;
+			seg->data_off = 0;
+			seg->data_len = hlen;
+			seg->next = NULL;
+			m->nb_segs++;
+			last = seg;
+
+			addr += hlen;
+			len -= hlen;
+		}
+
+		if (left > 0) {
+			if (unlikely(!(desc->flags & VRING_DESC_F_NEXT)))
+				goto error_exit;
+			desc = &vc_req->head[desc->next];
+		}
+	}
+
+	*cur_desc = &vc_req->head[desc->next];
+
+	return 0;
+
+error_exit:
+	free_zero_copy_segs(m);
+	return -1;
+}
+
 static void
 write_back_data(struct vhost_crypto_data_req *vc_req)
 {
@@ -807,18 +1027,9 @@ prepare_sym_cipher_op(struct vhost_crypto *vcrypto, struct rte_crypto_op *op,
 
 	switch (vcrypto->option) {
 	case RTE_VHOST_CRYPTO_ZERO_COPY_ENABLE:
-		m_src->buf_iova = gpa_to_hpa(vcrypto->dev, desc->addr,
-				cipher->para.src_data_len);
-		m_src->buf_addr = get_data_ptr(vc_req, desc, VHOST_ACCESS_RO);
-		if (unlikely(m_src->buf_iova == 0 ||
-				m_src->buf_addr == NULL)) {
-			VC_LOG_ERR("zero_copy may fail due to cross page data");
-			ret = VIRTIO_CRYPTO_ERR;
-			goto error_exit;
-		}
-
-		if (unlikely(move_desc(vc_req->head, &desc,
-				cipher->para.src_data_len) < 0)) {
+		if (unlikely(prepare_zero_copy_mbuf(vcrypto, vc_req, m_src,
+				&desc, cipher->para.src_data_len,
+				VHOST_ACCESS_RO) < 0)) {
 			VC_LOG_ERR("Incorrect descriptor");
 			ret = VIRTIO_CRYPTO_ERR;
 			goto error_exit;
@@ -856,23 +1067,14 @@ prepare_sym_cipher_op(struct vhost_crypto *vcrypto, struct rte_crypto_op *op,
 
 	switch (vcrypto->option) {
 	case RTE_VHOST_CRYPTO_ZERO_COPY_ENABLE:
-		m_dst->buf_iova = gpa_to_hpa(vcrypto->dev,
-				desc->addr, cipher->para.dst_data_len);
-		m_dst->buf_addr = get_data_ptr(vc_req, desc, VHOST_ACCESS_RW);
-		if (unlikely(m_dst->buf_iova == 0 || m_dst->buf_addr == NULL)) {
-			VC_LOG_ERR("zero_copy may fail due to cross page data");
-			ret = VIRTIO_CRYPTO_ERR;
-			goto error_exit;
-		}
-
-		if (unlikely(move_desc(vc_req->head, &desc,
-				cipher->para.dst_data_len) < 0)) {
+		if (unlikely(prepare_zero_copy_mbuf(vcrypto, vc_req, m_dst,
+				&desc, cipher->para.dst_data_len,
+				VHOST_ACCESS_RW) < 0)) {
 			VC_LOG_ERR("Incorrect descriptor");
 			ret = VIRTIO_CRYPTO_ERR;
 			goto error_exit;
 		}
 
-		m_dst->data_len = cipher->para.dst_data_len;
 		break;
 	case RTE_VHOST_CRYPTO_ZERO_COPY_DISABLE:
 		vc_req->wb = prepare_write_back_data(vc_req, &desc, &ewb,
@@ -910,6 +1112,10 @@ prepare_sym_cipher_op(struct vhost_crypto *vcrypto, struct rte_crypto_op *op,
 error_exit:
 	if (vc_req->wb)
 		free_wb_data(vc_req->wb, vc_req->wb_pool);
+	if (vcrypto->option == RTE_VHOST_CRYPTO_ZERO_COPY_ENABLE) {
+		free_zero_copy_segs(m_src);
+		free_zero_copy_segs(m_dst);
+	}
 
 	vc_req->len = INHDR_LEN;
 	return ret;
@@ -941,19 +1147,9 @@ prepare_sym_chain_op(struct vhost_crypto *vcrypto, struct rte_crypto_op *op,
 
 	switch (vcrypto->option) {
 	case RTE_VHOST_CRYPTO_ZERO_COPY_ENABLE:
-		m_dst->data_len = chain->para.dst_data_len;
-
-		m_src->buf_iova = gpa_to_hpa(vcrypto->dev, desc->addr,
-				chain->para.src_data_len);
-		m_src->buf_addr = get_data_ptr(vc_req, desc, VHOST_ACCESS_RO);
-		if (unlikely(m_src->buf_iova == 0 || m_src->buf_addr == NULL)) {
-			VC_LOG_ERR("zero_copy may fail due to cross page data");
-			ret = VIRTIO_CRYPTO_ERR;
-			goto error_exit;
-		}
-
-		if (unlikely(move_desc(vc_req->head, &desc,
-				chain->para.src_data_len) < 0)) {
+		if (unlikely(prepare_zero_copy_mbuf(vcrypto, vc_req, m_src,
+				&desc, chain->para.src_data_len,
+				VHOST_ACCESS_RO) < 0)) {
 			VC_LOG_ERR("Incorrect descriptor");
 			ret = VIRTIO_CRYPTO_ERR;
 			goto error_exit;
@@ -990,17 +1186,9 @@ prepare_sym_chain_op(struct vhost_crypto *vcrypto, struct rte_crypto_op *op,
 
 	switch (vcrypto->option) {
 	case RTE_VHOST_CRYPTO_ZERO_COPY_ENABLE:
-		m_dst->buf_iova = gpa_to_hpa(vcrypto->dev,
-				desc->addr, chain->para.dst_data_len);
-		m_dst->buf_addr = get_data_ptr(vc_req, desc, VHOST_ACCESS_RW);
-		if (unlikely(m_dst->buf_iova == 0 || m_dst->buf_addr == NULL)) {
-			VC_LOG_ERR("zero_copy may fail due to cross page data");
-			ret = VIRTIO_CRYPTO_ERR;
-			goto error_exit;
-		}
-
-		if (unlikely(move_desc(vc_req->head, &desc,
-				chain->para.dst_data_len) < 0)) {
+		if (unlikely(prepare_zero_copy_mbuf(vcrypto, vc_req, m_dst,
+				&desc, chain->para.dst_data_len,
+				VHOST_ACCESS_RW) < 0)) {
 			VC_LOG_ERR("Incorrect descriptor");
 			ret = VIRTIO_CRYPTO_ERR;
 			goto error_exit;
@@ -1089,6 +1277,10 @@ prepare_sym_chain_op(struct vhost_crypto *vcrypto, struct rte_crypto_op *op,
 error_exit:
 	if (vc_req->wb)
 		free_wb_data(vc_req->wb, vc_req->wb_pool);
+	if (vcrypto->option == RTE_VHOST_CRYPTO_ZERO_COPY_ENABLE) {
+		free_zero_copy_segs(m_src);
+		free_zero_copy_segs(m_dst);
+	}
 	vc_req->len = INHDR_LEN;
 	return ret;
 }
@@ -1099,10 +1291,11 @@ prepare_sym_chain_op(struct vhost_crypto *vcrypto, struct rte_crypto_op *op,
 static __rte_always_inline int
 vhost_crypto_process_one_req(struct vhost_crypto *vcrypto,
 		struct vhost_virtqueue *vq, struct rte_crypto_op *op,
-		struct vring_desc *head, uint16_t desc_idx)
+		struct vring_desc *head, uint16_t desc_idx,
+		struct vhost_crypto_sess_cache *cache)
 {
 	struct vhost_crypto_data_req *vc_req = rte_mbuf_to_priv(op->sym->m_src);
-	struct rte_cryptodev_sym_session *session;
+	struct vhost_crypto_session *session;
 	struct virtio_crypto_op_data_req *req, tmp_req;
 	struct virtio_crypto_inhdr *inhdr;
 	struct vring_desc *desc = NULL;
@@ -1164,7 +1357,7 @@ vhost_crypto_process_one_req(struct vhost_crypto *vcrypto,
 		session_id = req->header.session_id;
 
 		/* one branch to avoid unnecessary table lookup */
-		if (vcrypto->cache_session_id != session_id) {
+		if (cache->session_id != session_id) {
 			err = rte_hash_lookup_data(vcrypto->session_map,
 					&session_id, (void **)&session);
 			if (unlikely(err < 0)) {
@@ -1174,13 +1367,13 @@ vhost_crypto_process_one_req(struct vhost_crypto *vcrypto,
 				goto error_exit;
 			}
 
-			vcrypto->cache_session = session;
-			vcrypto->cache_session_id = session_id;
+			cache->session = session;
+			cache->session_id = session_id;
 		}
 
-		session = vcrypto->cache_session;
+		session = cache->session;
 
-		err = rte_crypto_op_attach_sym_session(op, session);
+		err = rte_crypto_op_attach_sym_session(op, session->session);
 		if (unlikely(err < 0)) {
 			err = VIRTIO_CRYPTO_ERR;
 			VC_LOG_ERR("Failed to attach session to op");
@@ -1222,24 +1415,13 @@ vhost_crypto_process_one_req(struct vhost_crypto *vcrypto,
 	return -1;
 }
 
-static __rte_always_inline struct vhost_virtqueue *
+static __rte_always_inline void
 vhost_crypto_finalize_one_request(struct rte_crypto_op *op,
-		struct vhost_virtqueue *old_vq)
+		struct vhost_crypto_data_req *vc_req)
 {
 	struct rte_mbuf *m_src = op->sym->m_src;
 	struct rte_mbuf *m_dst = op->sym->m_dst;
-	struct vhost_crypto_data_req *vc_req = rte_mbuf_to_priv(m_src);
-	uint16_t desc_idx;
-
-	if (unlikely(!vc_req)) {
-		VC_LOG_ERR("Failed to retrieve vc_req");
-		return NULL;
-	}
-
-	if (old_vq && (vc_req->vq != old_vq))
-		return vc_req->vq;
-
-	desc_idx = vc_req->desc_idx;
+	uint16_t desc_idx = vc_req->desc_idx;
 
 	if (unlikely(op->status != RTE_CRYPTO_OP_STATUS_SUCCESS))
 		vc_req->inhdr->status = VIRTIO_CRYPTO_ERR;
@@ -1251,44 +1433,13 @@ vhost_crypto_finalize_one_request(struct rte_crypto_op *op,
 	vc_req->vq->used->ring[desc_idx].id = desc_idx;
 	vc_req->vq->used->ring[desc_idx].len = vc_req->len;
 
-	rte_mempool_put(m_src->pool, (void *)m_src);
-
-	if (m_dst)
+	if (m_dst) {
+		free_zero_copy_segs(m_src);
+		free_zero_copy_segs(m_dst);
 		rte_mempool_put(m_dst->pool, (void *)m_dst);
-
-	return vc_req->vq;
-}
-
-static __rte_always_inline uint16_t
-vhost_crypto_complete_one_vm_requests(struct rte_crypto_op **ops,
-		uint16_t nb_ops, int *callfd)
-{
-	uint16_t processed = 1;
-	struct vhost_virtqueue *vq, *tmp_vq;
-
-	if (unlikely(nb_ops == 0))
-		return 0;
-
-	vq = vhost_crypto_finalize_one_request(ops[0], NULL);
-	if (unlikely(vq == NULL))
-		return 0;
-	tmp_vq = vq;
-
-	while ((processed < nb_ops)) {
-		tmp_vq = vhost_crypto_finalize_one_request(ops[processed],
-				tmp_vq);
-
-		if (unlikely(vq != tmp_vq))
-			break;
-
-		processed++;
 	}
 
-	*callfd = vq->callfd;
-
-	*(volatile uint16_t *)&vq->used->idx += processed;
-
-	return processed;
+	rte_mempool_put(m_src->pool, (void *)m_src);
 }
 
 int __rte_experimental
@@ -1297,6 +1448,7 @@ rte_vhost_crypto_create(int vid, uint8_t cryptodev_id,
 {
 	struct virtio_net *dev = get_device(vid);
 	struct rte_hash_parameters params = {0};
+	struct rte_cryptodev_info info;
 	struct vhost_crypto *vcrypto;
 	char name[128];
 	int ret;
@@ -1322,11 +1474,14 @@ rte_vhost_crypto_create(int vid, uint8_t cryptodev_id,
 
 	vcrypto->sess_pool = sess_pool;
 	vcrypto->cid = cryptodev_id;
-	vcrypto->cache_session_id = UINT64_MAX;
 	vcrypto->last_session_id = 1;
 	vcrypto->dev = dev;
 	vcrypto->option = RTE_VHOST_CRYPTO_ZERO_COPY_DISABLE;
 
+	rte_cryptodev_info_get(cryptodev_id, &info);
+	vcrypto->sgl = !!(info.feature_flags &
+			RTE_CRYPTODEV_FF_OOP_SGL_IN_SGL_OUT);
+
 	snprintf(name, 127, "HASH_VHOST_CRYPT_%u", (uint32_t)vid);
 	params.name = name;
 	params.entries = VHOST_CRYPTO_SESSION_MAP_ENTRIES;
@@ -1340,6 +1495,16 @@ rte_vhost_crypto_create(int vid, uint8_t cryptodev_id,
 		goto error_exit;
 	}
 
+	snprintf(name, 127, "SESS_CACHE_VHOST_CRYPT_%u", (uint32_t)vid);
+	params.name = name;
+	params.key_len = sizeof(struct vhost_crypto_session_key);
+	vcrypto->session_cache = rte_hash_create(&params);
+	if (!vcrypto->session_cache) {
+		VC_LOG_ERR("Failed to creath session cache");
+		ret = -ENOMEM;
+		goto error_exit;
+	}
+
 	snprintf(name, 127, "MBUF_POOL_VM_%u", (uint32_t)vid);
 	vcrypto->mbuf_pool = rte_pktmbuf_pool_create(name,
 			VHOST_CRYPTO_MBUF_POOL_SIZE, 512,
@@ -1373,6 +1538,8 @@ rte_vhost_crypto_create(int vid, uint8_t cryptodev_id,
 error_exit:
 	if (vcrypto->session_map)
 		rte_hash_free(vcrypto->session_map);
+	if (vcrypto->session_cache)
+		rte_hash_free(vcrypto->session_cache);
 	if (vcrypto->mbuf_pool)
 		rte_mempool_free(vcrypto->mbuf_pool);
 
@@ -1385,7 +1552,10 @@ int __rte_experimental
 rte_vhost_crypto_free(int vid)
 {
 	struct virtio_net *dev = get_device(vid);
+	struct vhost_crypto_session *sess;
 	struct vhost_crypto *vcrypto;
+	const void *key;
+	uint32_t iter = 0;
 
 	if (unlikely(dev == NULL)) {
 		VC_LOG_ERR("Invalid vid %i", vid);
@@ -1398,6 +1568,11 @@ rte_vhost_crypto_free(int vid)
 		return -ENOENT;
 	}
 
+	while (rte_hash_iterate(vcrypto->session_cache, &key, (void **)&sess,
+			&iter) >= 0)
+		vhost_crypto_free_session(vcrypto, sess);
+
+	rte_hash_free(vcrypto->session_cache);
 	rte_hash_free(vcrypto->session_map);
 	rte_mempool_free(vcrypto->mbuf_pool);
 	rte_mempool_free(vcrypto->wb_pool);
@@ -1470,6 +1645,7 @@ rte_vhost_crypto_fetch_requests(int vid, uint32_t qid,
 		struct rte_crypto_op **ops, uint16_t nb_ops)
 {
 	struct rte_mbuf *mbufs[VHOST_CRYPTO_MAX_BURST_SIZE * 2];
+	struct vhost_crypto_sess_cache cache = { .session_id = UINT64_MAX };
 	struct virtio_net *dev = get_device(vid);
 	struct vhost_crypto *vcrypto;
 	struct vhost_virtqueue *vq;
@@ -1483,7 +1659,7 @@ rte_vhost_crypto_fetch_requests(int vid, uint32_t qid,
 		return -EINVAL;
 	}
 
-	if (unlikely(qid >= VHOST_MAX_QUEUE_PAIRS)) {
+	if (unlikely(qid >= dev->nr_vring)) {
 		VC_LOG_ERR("Invalid qid %u", qid);
 		return -EINVAL;
 	}
@@ -1522,13 +1698,17 @@ rte_vhost_crypto_fetch_requests(int vid, uint32_t qid,
 			struct vring_desc *head = &vq->desc[desc_idx];
 			struct rte_crypto_op *op = ops[i];
 
+			if (i + 1 < count)
+				rte_prefetch0(&vq->desc[vq->avail->ring[
+					(used_idx + 1) & (vq->size - 1)]]);
+
 			op->sym->m_src = mbufs[i * 2];
 			op->sym->m_dst = mbufs[i * 2 + 1];
 			op->sym->m_src->data_off = 0;
 			op->sym->m_dst->data_off = 0;
 
 			if (unlikely(vhost_crypto_process_one_req(vcrypto, vq,
-					op, head, desc_idx)) < 0)
+					op, head, desc_idx, &cache)) < 0)
 				break;
 		}
 
@@ -1552,12 +1732,16 @@ rte_vhost_crypto_fetch_requests(int vid, uint32_t qid,
 			struct vring_desc *head = &vq->desc[desc_idx];
 			struct rte_crypto_op *op = ops[i];
 
+			if (i + 1 < count)
+				rte_prefetch0(&vq->desc[vq->avail->ring[
+					(used_idx + 1) & (vq->size - 1)]]);
+
 			op->sym->m_src = mbufs[i];
 			op->sym->m_dst = NULL;
 			op->sym->m_src->data_off = 0;
 
 			if (unlikely(vhost_crypto_process_one_req(vcrypto, vq,
-					op, head, desc_idx)) < 0)
+					op, head, desc_idx, &cache)) < 0)
 				break;
 		}
 
@@ -1579,29 +1763,47 @@ uint16_t __rte_experimental
 rte_vhost_crypto_finalize_requests(struct rte_crypto_op **ops,
 		uint16_t nb_ops, int *callfds, uint16_t *nb_callfds)
 {
-	struct rte_crypto_op **tmp_ops = ops;
-	uint16_t count = 0, left = nb_ops;
-	int callfd;
-	uint16_t idx = 0;
-
-	while (left) {
-		count = vhost_crypto_complete_one_vm_requests(tmp_ops, left,
-				&callfd);
-		if (unlikely(count == 0))
+	struct vhost_virtqueue *vqs[VIRTIO_CRYPTO_MAX_NUM_BURST_VQS];
+	uint16_t nb_used[VIRTIO_CRYPTO_MAX_NUM_BURST_VQS];
+	struct vhost_crypto_data_req *vc_req;
+	uint16_t nb_vqs = 0;
+	uint16_t i, j;
+
+	for (i = 0; i < nb_ops; i++) {
+		vc_req = rte_mbuf_to_priv(ops[i]->sym->m_src);
+		if (unlikely(!vc_req)) {
+			VC_LOG_ERR("Failed to retrieve vc_req");
 			break;
+		}
 
-		tmp_ops = &tmp_ops[count];
-		left -= count;
+		for (j = 0; j < nb_vqs && vqs[j] != vc_req->vq; j++)
+			;
+		if (j == nb_vqs) {
+			if (unlikely(nb_vqs >= VIRTIO_CRYPTO_MAX_NUM_BURST_VQS)) {
+				VC_LOG_ERR("Too many vqs");
+				break;
+			}
+			vqs[nb_vqs] = vc_req->vq;
+			nb_used[nb_vqs++] = 0;
+		}
 
-		callfds[idx++] = callfd;
+		if (i + 1 < nb_ops)
+			rte_prefetch0(rte_mbuf_to_priv(ops[i + 1]->sym->m_src));
 
-		if (unlikely(idx >= VIRTIO_CRYPTO_MAX_NUM_BURST_VQS)) {
-			VC_LOG_ERR("Too many vqs");
-			break;
-		}
+		vhost_crypto_finalize_one_request(ops[i], vc_req);
+		nb_used[j]++;
 	}
 
-	*nb_callfds = idx;
+	/* the used entries of a vq are published, and its guest signalled,
+	 * once for the whole burst
+	 */
+	rte_smp_wmb();
+	for (j = 0; j < nb_vqs; j++) {
+		*(volatile uint16_t *)&vqs[j]->used->idx += nb_used[j];
+		callfds[j] = vqs[j]->callfd;
+	}
 
-	return nb_ops - left;
+	*nb_callfds = nb_vqs;
+
+	return i;
 }
@@ -0,0 +1,713 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+/*
+ * Multi-process support: the primary process serves the vhost-user sockets,
+ * secondary processes attach to its devices to poll their vrings.
+ *
+ * The devices, their virtqueues and memory tables are allocated in the EAL
+ * memory, and a secondary maps the guest memory regions at the addresses the
+ * primary mapped them at, so that the addresses the datapath reads from a
+ * device are valid in both processes. The call eventfds of the vrings are
+ * passed along and kept per process.
+ *
+ * The primary pushes the updates of the attached devices. A memory table
+ * update is pushed twice: before it is installed, for the secondaries to map
+ * the new regions, and once installed, for them to unmap the removed ones.
+ * The generation of the device orders these pushes with the replies to the
+ * requests of a secondary attaching.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <rte_common.h>
+#include <rte_eal.h>
+#include <rte_errno.h>
+#include <rte_log.h>
+#include <rte_string_fns.h>
+
+#include "vhost.h"
+#include "vhost_user.h"
+
+#define VHOST_MP_ACTION		"vhost_mp"
+#define VHOST_MP_TIMEOUT_S	5
+
+enum vhost_mp_type {
+	VHOST_MP_INFO,		/* secondary: get the number of devices */
+	VHOST_MP_ATTACH,	/* secondary: attach to a device */
+	VHOST_MP_DETACH,	/* secondary: detach from a device */
+	VHOST_MP_VRING,		/* secondary: get a call eventfd */
+	VHOST_MP_MEM,		/* primary: update of the memory table */
+	VHOST_MP_CALL,		/* primary: update of a call eventfd */
+	VHOST_MP_DESTROY,	/* primary: device destroyed */
+};
+
+struct vhost_mp_param {
+	int32_t type;
+	int32_t vid;
+	int32_t result;
+	uint32_t gen;
+	uint32_t vring;		/* VRING, CALL */
+	uint32_t nr_devices;	/* INFO */
+	uint32_t prune;		/* MEM: unmap the regions not listed */
+	uint32_t nregions;	/* ATTACH, MEM: one fd per region */
+	uint64_t dev;		/* ATTACH: device in the EAL memory */
+	struct {
+		uint64_t addr;
+		uint64_t size;
+	} regions[VHOST_MEMORY_MAX_NREGIONS];
+};
+
+/* Secondary process view of the devices of the primary */
+struct vhost_mp_dev **vhost_mp_devs;
+
+/* Orders the requests with the updates of the devices, per process */
+static pthread_mutex_t vhost_mp_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t vhost_mp_init_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int vhost_mp_initialized;
+
+void
+vhost_mp_lock(void)
+{
+	pthread_mutex_lock(&vhost_mp_mutex);
+}
+
+void
+vhost_mp_unlock(void)
+{
+	pthread_mutex_unlock(&vhost_mp_mutex);
+}
+
+static void
+vhost_mp_init_msg(struct rte_mp_msg *msg, int type, int vid)
+{
+	struct vhost_mp_param *param = (struct vhost_mp_param *)msg->param;
+
+	RTE_BUILD_BUG_ON(sizeof(*param) > RTE_MP_MAX_PARAM_LEN);
+	RTE_BUILD_BUG_ON(VHOST_MEMORY_MAX_NREGIONS > RTE_MP_MAX_FD_NUM);
+
+	memset(msg, 0, sizeof(*msg));
+	strlcpy(msg->name, VHOST_MP_ACTION, sizeof(msg->name));
+	msg->len_param = sizeof(*param);
+	param->type = type;
+	param->vid = vid;
+}
+
+static void
+vhost_mp_close_fds(const struct rte_mp_msg *msg, int first)
+{
+	int i;
+
+	for (i = first; i < msg->num_fds; i++)
+		close(msg->fds[i]);
+}
+
+/*
+ * Primary side
+ */
+
+/* List the regions to map, the ones shared with EAL are mapped already. */
+static void
+vhost_mp_fill_mem(struct rte_mp_msg *msg, const struct rte_vhost_memory *mem)
+{
+	struct vhost_mp_param *param = (struct vhost_mp_param *)msg->param;
+	const struct rte_vhost_mem_region *reg;
+	uint32_t i, n = 0;
+
+	for (i = 0; mem != NULL && i < mem->nregions; i++) {
+		reg = &mem->regions[i];
+		if (reg->mmap_size == 0)
+			continue;
+		param->regions[n].addr = (uint64_t)(uintptr_t)reg->mmap_addr;
+		param->regions[n].size = reg->mmap_size;
+		msg->fds[n++] = reg->fd;
+	}
+	param->nregions = n;
+	msg->num_fds = n;
+}
+
+/* Send an update to the secondaries, they all reply. */
+static void
+vhost_mp_push(struct rte_mp_msg *msg)
+{
+	const struct vhost_mp_param *param =
+		(const struct vhost_mp_param *)msg->param;
+	struct timespec ts = { .tv_sec = VHOST_MP_TIMEOUT_S, .tv_nsec = 0 };
+	struct rte_mp_reply reply;
+
+	if (rte_mp_request_sync(msg, &reply, &ts) < 0 ||
+	    reply.nb_received != reply.nb_sent)
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) failed to update the secondary processes\n",
+			param->vid);
+	free(reply.msgs);
+}
+
+static int
+vhost_mp_attach_check(struct virtio_net *dev)
+{
+	uint32_t i;
+
+	if (dev == NULL || !(dev->flags & VIRTIO_DEV_RUNNING))
+		return -ENODEV;
+	if (dev->mp_busy)
+		return -EAGAIN;
+
+	/*
+	 * The lockless mode relies on process wide barriers, the other
+	 * features on memory or file descriptors private to the primary.
+	 */
+	if (dev->lockless || dev->dequeue_zero_copy ||
+	    dev->vdpa_dev_id >= 0 || dev->log_addr ||
+	    dev->inflight_addr != NULL ||
+	    (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM)))
+		return -ENOTSUP;
+	for (i = 0; i < dev->nr_vring; i++)
+		if (dev->virtqueue[i]->async_registered)
+			return -ENOTSUP;
+
+	return 0;
+}
+
+static int
+vhost_mp_primary(const struct rte_mp_msg *msg, const void *peer)
+{
+	const struct vhost_mp_param *m =
+		(const struct vhost_mp_param *)msg->param;
+	struct rte_mp_msg reply;
+	struct vhost_mp_param *r = (struct vhost_mp_param *)reply.param;
+	struct virtio_net *dev = NULL;
+	struct vhost_virtqueue *vq;
+
+	if (msg->len_param != sizeof(*m)) {
+		RTE_LOG(ERR, VHOST_CONFIG, "invalid multi-process message\n");
+		vhost_mp_close_fds(msg, 0);
+		return -1;
+	}
+
+	vhost_mp_init_msg(&reply, m->type, m->vid);
+
+	vhost_mp_lock();
+
+	if ((uint32_t)m->vid < vhost_nr_devices)
+		dev = vhost_devices[m->vid];
+
+	switch (m->type) {
+	case VHOST_MP_INFO:
+		r->nr_devices = vhost_get_max_devices();
+		break;
+	case VHOST_MP_ATTACH:
+		r->result = vhost_mp_attach_check(dev);
+		if (r->result < 0)
+			break;
+		vhost_mp_fill_mem(&reply, dev->mem);
+		r->dev = (uint64_t)(uintptr_t)dev;
+		r->gen = dev->mp_gen;
+		dev->mp_attached++;
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%d) attached by a secondary process\n", m->vid);
+		break;
+	case VHOST_MP_DETACH:
+		if (dev == NULL || dev->mp_attached == 0) {
+			r->result = -ENODEV;
+			break;
+		}
+		dev->mp_attached--;
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%d) detached by a secondary process\n", m->vid);
+		break;
+	case VHOST_MP_VRING:
+		if (dev == NULL || m->vring >= dev->nr_vring) {
+			r->result = -ENODEV;
+			break;
+		}
+		vq = dev->virtqueue[m->vring];
+		r->vring = m->vring;
+		r->gen = dev->mp_gen;
+		if (vq->callfd >= 0) {
+			reply.fds[0] = vq->callfd;
+			reply.num_fds = 1;
+		}
+		break;
+	default:
+		r->result = -EINVAL;
+		break;
+	}
+
+	/* The fds are duplicated in the message, the device can go. */
+	vhost_mp_unlock();
+
+	return rte_mp_reply(&reply, peer);
+}
+
+void
+vhost_mp_mem_update_begin(struct virtio_net *dev,
+			  const struct rte_vhost_memory *mem)
+{
+	struct rte_mp_msg msg;
+	uint32_t attached;
+
+	vhost_mp_lock();
+	dev->mp_busy = 1;
+	attached = dev->mp_attached;
+	vhost_mp_unlock();
+
+	if (!attached)
+		return;
+
+	vhost_mp_init_msg(&msg, VHOST_MP_MEM, dev->vid);
+	vhost_mp_fill_mem(&msg, mem);
+	((struct vhost_mp_param *)msg.param)->gen = dev->mp_gen + 1;
+	vhost_mp_push(&msg);
+}
+
+void
+vhost_mp_mem_update_end(struct virtio_net *dev)
+{
+	struct vhost_mp_param *param;
+	struct rte_mp_msg msg;
+	uint32_t attached;
+
+	vhost_mp_lock();
+	dev->mp_gen++;
+	dev->mp_busy = 0;
+	attached = dev->mp_attached;
+	vhost_mp_unlock();
+
+	if (!attached)
+		return;
+
+	vhost_mp_init_msg(&msg, VHOST_MP_MEM, dev->vid);
+	vhost_mp_fill_mem(&msg, dev->mem);
+	param = (struct vhost_mp_param *)msg.param;
+	param->gen = dev->mp_gen;
+	param->prune = 1;
+	vhost_mp_push(&msg);
+}
+
+void
+vhost_mp_call_update(struct virtio_net *dev, uint32_t vring_idx)
+{
+	struct vhost_virtqueue *vq = dev->virtqueue[vring_idx];
+	struct vhost_mp_param *param;
+	struct rte_mp_msg msg;
+	uint32_t attached;
+
+	vhost_mp_lock();
+	dev->mp_gen++;
+	attached = dev->mp_attached;
+	vhost_mp_unlock();
+
+	if (!attached)
+		return;
+
+	vhost_mp_init_msg(&msg, VHOST_MP_CALL, dev->vid);
+	param = (struct vhost_mp_param *)msg.param;
+	param->gen = dev->mp_gen;
+	param->vring = vring_idx;
+	if (vq->callfd >= 0) {
+		msg.fds[0] = vq->callfd;
+		msg.num_fds = 1;
+	}
+	vhost_mp_push(&msg);
+}
+
+void
+vhost_mp_destroy(struct virtio_net *dev)
+{
+	struct rte_mp_msg msg;
+	uint32_t attached;
+
+	/* Stays busy, no secondary can attach anymore */
+	vhost_mp_lock();
+	dev->mp_busy = 1;
+	attached = dev->mp_attached;
+	dev->mp_attached = 0;
+	vhost_mp_unlock();
+
+	if (!attached)
+		return;
+
+	vhost_mp_init_msg(&msg, VHOST_MP_DESTROY, dev->vid);
+	vhost_mp_push(&msg);
+}
+
+void
+vhost_mp_init(void)
+{
+	if (rte_eal_process_type() != RTE_PROC_PRIMARY)
+		return;
+
+	pthread_mutex_lock(&vhost_mp_init_mutex);
+	if (!vhost_mp_initialized) {
+		/* Without multi-process support, no secondary can attach */
+		if (rte_mp_action_register(VHOST_MP_ACTION,
+					   vhost_mp_primary) < 0 &&
+		    rte_errno != ENOTSUP)
+			RTE_LOG(WARNING, VHOST_CONFIG,
+				"failed to register the multi-process action\n");
+		vhost_mp_initialized = 1;
+	}
+	pthread_mutex_unlock(&vhost_mp_init_mutex);
+}
+
+/*
+ * Secondary side
+ */
+
+/* Map the listed regions at the addresses of the primary, consumes the fds */
+static int
+vhost_mp_map(struct vhost_mp_dev *mpdev, const struct rte_mp_msg *msg)
+{
+	const struct vhost_mp_param *param =
+		(const struct vhost_mp_param *)msg->param;
+	struct vhost_mp_region *reg;
+	uint32_t i, j;
+	void *hint, *addr;
+
+	for (i = 0; i < param->nregions && (int)i < msg->num_fds; i++) {
+		hint = (void *)(uintptr_t)param->regions[i].addr;
+
+		for (j = 0; j < mpdev->nregions; j++) {
+			reg = &mpdev->regions[j];
+			if (reg->addr == hint &&
+			    reg->size == param->regions[i].size)
+				break;
+		}
+		if (j < mpdev->nregions) {
+			close(msg->fds[i]);
+			continue;
+		}
+
+		if (mpdev->nregions == VHOST_MP_MAX_REGIONS)
+			goto err;
+
+		addr = mmap(hint, param->regions[i].size,
+			    PROT_READ | PROT_WRITE, MAP_SHARED,
+			    msg->fds[i], 0);
+		if (addr == MAP_FAILED)
+			goto err;
+		if (addr != hint) {
+			munmap(addr, param->regions[i].size);
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%d) address %p of a guest memory region is "
+				"in use\n", param->vid, hint);
+			goto err;
+		}
+		close(msg->fds[i]);
+
+		reg = &mpdev->regions[mpdev->nregions++];
+		reg->addr = addr;
+		reg->size = param->regions[i].size;
+	}
+
+	return 0;
+
+err:
+	RTE_LOG(ERR, VHOST_CONFIG, "(%d) failed to map guest memory\n",
+		param->vid);
+	vhost_mp_close_fds(msg, i);
+	return -1;
+}
+
+/* Unmap the regions which are not listed anymore */
+static void
+vhost_mp_prune(struct vhost_mp_dev *mpdev, const struct vhost_mp_param *param)
+{
+	struct vhost_mp_region *reg;
+	uint32_t i, j;
+
+	for (i = mpdev->nregions; i-- > 0; ) {
+		reg = &mpdev->regions[i];
+		for (j = 0; j < param->nregions; j++)
+			if ((uintptr_t)reg->addr == param->regions[j].addr &&
+			    reg->size == param->regions[j].size)
+				break;
+		if (j < param->nregions)
+			continue;
+
+		munmap(reg->addr, reg->size);
+		*reg = mpdev->regions[--mpdev->nregions];
+	}
+}
+
+/* Replace the call eventfd of a vring, unless a newer one is known */
+static void
+vhost_mp_set_callfd(struct vhost_mp_dev *mpdev, const struct rte_mp_msg *msg)
+{
+	const struct vhost_mp_param *param =
+		(const struct vhost_mp_param *)msg->param;
+	int fd = msg->num_fds > 0 ? msg->fds[0] : -1;
+
+	if (param->vring >= VHOST_MAX_VRING ||
+	    (int32_t)(param->gen - mpdev->call_gen[param->vring]) < 0) {
+		if (fd >= 0)
+			close(fd);
+		return;
+	}
+
+	if (mpdev->callfd[param->vring] >= 0)
+		close(mpdev->callfd[param->vring]);
+	mpdev->callfd[param->vring] = fd;
+	mpdev->call_gen[param->vring] = param->gen;
+}
+
+/* Called with the lock held, the device is not polled anymore */
+static void
+vhost_mp_release(int vid)
+{
+	struct vhost_mp_dev *mpdev = vhost_mp_devs[vid];
+	uint32_t i;
+
+	vhost_devices[vid] = NULL;
+	vhost_mp_devs[vid] = NULL;
+
+	for (i = 0; i < mpdev->nregions; i++)
+		munmap(mpdev->regions[i].addr, mpdev->regions[i].size);
+	for (i = 0; i < VHOST_MAX_VRING; i++)
+		if (mpdev->callfd[i] >= 0)
+			close(mpdev->callfd[i]);
+	free(mpdev);
+}
+
+static int
+vhost_mp_secondary(const struct rte_mp_msg *msg, const void *peer)
+{
+	const struct vhost_mp_param *m =
+		(const struct vhost_mp_param *)msg->param;
+	struct vhost_mp_dev *mpdev = NULL;
+	struct rte_mp_msg reply;
+
+	if (msg->len_param != sizeof(*m)) {
+		RTE_LOG(ERR, VHOST_CONFIG, "invalid multi-process message\n");
+		vhost_mp_close_fds(msg, 0);
+		return -1;
+	}
+
+	vhost_mp_lock();
+
+	if (vhost_mp_devs != NULL && (uint32_t)m->vid < vhost_nr_devices)
+		mpdev = vhost_mp_devs[m->vid];
+
+	if (mpdev == NULL) {
+		vhost_mp_close_fds(msg, 0);
+	} else if (m->type == VHOST_MP_MEM) {
+		if (vhost_mp_map(mpdev, msg) == 0 && m->prune) {
+			vhost_mp_prune(mpdev, m);
+			mpdev->mem_gen = m->gen;
+		}
+	} else if (m->type == VHOST_MP_CALL) {
+		vhost_mp_set_callfd(mpdev, msg);
+	} else if (m->type == VHOST_MP_DESTROY) {
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%d) device destroyed by the primary process\n",
+			m->vid);
+		vhost_mp_release(m->vid);
+	} else {
+		vhost_mp_close_fds(msg, 0);
+	}
+
+	vhost_mp_unlock();
+
+	vhost_mp_init_msg(&reply, m->type, m->vid);
+	return rte_mp_reply(&reply, peer);
+}
+
+/* Send a request to the primary, the reply is in *reply* on success */
+static int
+vhost_mp_request(struct rte_mp_msg *msg, struct rte_mp_msg *reply)
+{
+	struct timespec ts = { .tv_sec = VHOST_MP_TIMEOUT_S, .tv_nsec = 0 };
+	struct rte_mp_reply mp_reply;
+	int ret;
+
+	if (rte_mp_request_sync(msg, &mp_reply, &ts) < 0 ||
+	    mp_reply.nb_received != 1) {
+		free(mp_reply.msgs);
+		return -EIO;
+	}
+
+	*reply = mp_reply.msgs[0];
+	free(mp_reply.msgs);
+
+	ret = ((struct vhost_mp_param *)reply->param)->result;
+	if (ret < 0)
+		vhost_mp_close_fds(reply, 0);
+
+	return ret;
+}
+
+static int
+vhost_mp_secondary_init(void)
+{
+	struct rte_mp_msg msg, reply;
+	uint32_t nr;
+	int ret = 0;
+
+	pthread_mutex_lock(&vhost_mp_init_mutex);
+	if (vhost_mp_initialized)
+		goto out;
+
+	ret = rte_mp_action_register(VHOST_MP_ACTION, vhost_mp_secondary);
+	if (ret < 0) {
+		ret = -rte_errno;
+		goto out;
+	}
+
+	vhost_mp_init_msg(&msg, VHOST_MP_INFO, -1);
+	ret = vhost_mp_request(&msg, &reply);
+	if (ret < 0) {
+		rte_mp_action_unregister(VHOST_MP_ACTION);
+		goto out;
+	}
+	nr = ((struct vhost_mp_param *)reply.param)->nr_devices;
+
+	vhost_mp_lock();
+	vhost_devices = calloc(nr, sizeof(*vhost_devices));
+	vhost_mp_devs = calloc(nr, sizeof(*vhost_mp_devs));
+	if (vhost_devices == NULL || vhost_mp_devs == NULL) {
+		free(vhost_devices);
+		free(vhost_mp_devs);
+		vhost_devices = NULL;
+		vhost_mp_devs = NULL;
+		ret = -ENOMEM;
+	} else {
+		__atomic_store_n(&vhost_nr_devices, nr, __ATOMIC_RELEASE);
+		vhost_mp_initialized = 1;
+	}
+	vhost_mp_unlock();
+
+	if (ret < 0)
+		rte_mp_action_unregister(VHOST_MP_ACTION);
+out:
+	pthread_mutex_unlock(&vhost_mp_init_mutex);
+	return ret;
+}
+
+int __rte_experimental
+rte_vhost_mp_attach(int vid)
+{
+	struct vhost_mp_param *param;
+	struct rte_mp_msg msg, reply;
+	struct vhost_mp_dev *mpdev;
+	struct virtio_net *dev;
+	uint32_t i;
+	int ret;
+
+	if (rte_eal_process_type() != RTE_PROC_SECONDARY)
+		return -ENOTSUP;
+
+	ret = vhost_mp_secondary_init();
+	if (ret < 0)
+		return ret;
+
+	mpdev = calloc(1, sizeof(*mpdev));
+	if (mpdev == NULL)
+		return -ENOMEM;
+	for (i = 0; i < VHOST_MAX_VRING; i++)
+		mpdev->callfd[i] = -1;
+
+	/* Registered first, for the updates sent meanwhile to be applied */
+	vhost_mp_lock();
+	if ((uint32_t)vid >= vhost_nr_devices || vhost_mp_devs[vid] != NULL) {
+		vhost_mp_unlock();
+		free(mpdev);
+		return -EINVAL;
+	}
+	vhost_mp_devs[vid] = mpdev;
+	vhost_mp_unlock();
+
+	vhost_mp_init_msg(&msg, VHOST_MP_ATTACH, vid);
+	ret = vhost_mp_request(&msg, &reply);
+	if (ret < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) failed to attach the device: %s\n",
+			vid, strerror(-ret));
+		vhost_mp_lock();
+		vhost_mp_release(vid);
+		vhost_mp_unlock();
+		return ret;
+	}
+	param = (struct vhost_mp_param *)reply.param;
+	dev = (struct virtio_net *)(uintptr_t)param->dev;
+
+	/* A pruned table is newer than the one of the reply */
+	vhost_mp_lock();
+	if ((int32_t)(param->gen - mpdev->mem_gen) >= 0)
+		ret = vhost_mp_map(mpdev, &reply);
+	else
+		vhost_mp_close_fds(&reply, 0);
+	vhost_mp_unlock();
+	if (ret < 0)
+		goto detach;
+
+	for (i = 0; i < dev->nr_vring; i++) {
+		vhost_mp_init_msg(&msg, VHOST_MP_VRING, vid);
+		((struct vhost_mp_param *)msg.param)->vring = i;
+		ret = vhost_mp_request(&msg, &reply);
+		if (ret < 0)
+			goto detach;
+
+		vhost_mp_lock();
+		vhost_mp_set_callfd(mpdev, &reply);
+		vhost_mp_unlock();
+	}
+
+	vhost_mp_lock();
+	__atomic_store_n(&vhost_devices[vid], dev, __ATOMIC_RELEASE);
+	vhost_mp_unlock();
+
+	return 0;
+
+detach:
+	vhost_mp_init_msg(&msg, VHOST_MP_DETACH, vid);
+	if (vhost_mp_request(&msg, &reply) == 0)
+		vhost_mp_close_fds(&reply, 0);
+	vhost_mp_lock();
+	if (vhost_mp_devs[vid] == mpdev)
+		vhost_mp_release(vid);
+	vhost_mp_unlock();
+
+	return ret;
+}
+
+int __rte_experimental
+rte_vhost_mp_detach(int vid)
+{
+	struct rte_mp_msg msg, reply;
+	struct vhost_mp_dev *mpdev = NULL;
+	int ret;
+
+	if (rte_eal_process_type() != RTE_PROC_SECONDARY)
+		return -ENOTSUP;
+
+	vhost_mp_lock();
+	if (vhost_mp_devs != NULL && (uint32_t)vid < vhost_nr_devices &&
+	    vhost_devices[vid] != NULL)
+		mpdev = vhost_mp_devs[vid];
+	if (mpdev != NULL)
+		vhost_devices[vid] = NULL;
+	vhost_mp_unlock();
+
+	if (mpdev == NULL)
+		return -EINVAL;
+
+	vhost_mp_init_msg(&msg, VHOST_MP_DETACH, vid);
+	ret = vhost_mp_request(&msg, &reply);
+	if (ret == 0)
+		vhost_mp_close_fds(&reply, 0);
+
+	/* Destroyed meanwhile if it is not the same anymore */
+	vhost_mp_lock();
+	if (vhost_mp_devs[vid] == mpdev)
+		vhost_mp_release(vid);
+	vhost_mp_unlock();
+
+	return ret == -ENODEV ? 0 : ret;
+}
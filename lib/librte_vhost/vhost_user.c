@@ -38,9 +38,14 @@
 #include <linux/userfaultfd.h>
 #endif
 
+#include <rte_alarm.h>
 #include <rte_common.h>
+#include <rte_eal.h>
+#include <rte_eal_memconfig.h>
+#include <rte_lcore.h>
 #include <rte_malloc.h>
 #include <rte_log.h>
+#include <rte_string_fns.h>
 
 #include "iotlb.h"
 #include "vhost.h"
@@ -78,6 +83,11 @@ static const char *vhost_message_str[VHOST_USER_MAX] = {
 	[VHOST_USER_POSTCOPY_ADVISE]  = "VHOST_USER_POSTCOPY_ADVISE",
 	[VHOST_USER_POSTCOPY_LISTEN]  = "VHOST_USER_POSTCOPY_LISTEN",
 	[VHOST_USER_POSTCOPY_END]  = "VHOST_USER_POSTCOPY_END",
+	[VHOST_USER_GET_INFLIGHT_FD] = "VHOST_USER_GET_INFLIGHT_FD",
+	[VHOST_USER_SET_INFLIGHT_FD] = "VHOST_USER_SET_INFLIGHT_FD",
+	[VHOST_USER_GET_MAX_MEM_SLOTS] = "VHOST_USER_GET_MAX_MEM_SLOTS",
+	[VHOST_USER_ADD_MEM_REG] = "VHOST_USER_ADD_MEM_REG",
+	[VHOST_USER_REM_MEM_REG] = "VHOST_USER_REM_MEM_REG",
 };
 
 static int send_vhost_reply(int sockfd, struct VhostUserMsg *msg);
@@ -93,6 +103,18 @@ get_blk_size(int fd)
 	return ret == -1 ? (uint64_t)-1 : (uint64_t)stat.st_blksize;
 }
 
+/*
+ * A region shared with EAL, see vhost_user_share_region(), has no
+ * mapping of its own.
+ */
+static void
+unmap_mem_region(struct rte_vhost_mem_region *reg)
+{
+	if (reg->mmap_size)
+		munmap(reg->mmap_addr, reg->mmap_size);
+	close(reg->fd);
+}
+
 static void
 free_mem_region(struct virtio_net *dev)
 {
@@ -104,27 +126,159 @@ free_mem_region(struct virtio_net *dev)
 
 	for (i = 0; i < dev->mem->nregions; i++) {
 		reg = &dev->mem->regions[i];
-		if (reg->host_user_addr) {
-			munmap(reg->mmap_addr, reg->mmap_size);
-			close(reg->fd);
+		if (reg->host_user_addr)
+			unmap_mem_region(reg);
+	}
+}
+
+/*
+ * The regions in the prefault job are copied, so that it does not
+ * depend on the device, which can be reallocated on another node.
+ */
+struct vhost_prefault {
+	volatile int stop;
+	uint32_t nregions;
+	struct {
+		uint8_t *addr;
+		uint64_t size;
+		uint64_t page_size;
+	} regions[];
+};
+
+static void *
+vhost_user_prefault_thread(void *arg)
+{
+	struct vhost_prefault *ctx = arg;
+	uint64_t total = 0;
+	uint64_t off;
+	uint32_t i;
+
+	for (i = 0; i < ctx->nregions; i++) {
+		for (off = 0; off < ctx->regions[i].size;
+				off += ctx->regions[i].page_size) {
+			if (ctx->stop)
+				return NULL;
+			/* Reading is enough to populate the page tables */
+			(void)*(volatile uint8_t *)(ctx->regions[i].addr + off);
 		}
+		total += ctx->regions[i].size;
+	}
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"prefaulted %" PRIu64 " MB of guest memory\n", total >> 20);
+
+	return NULL;
+}
+
+/*
+ * Wait for the prefault job of the device, it must be done before any
+ * region is unmapped.
+ */
+static void
+vhost_user_prefault_stop(struct virtio_net *dev)
+{
+	if (dev->prefault_ctx == NULL)
+		return;
+
+	dev->prefault_ctx->stop = 1;
+	pthread_join(dev->prefault_tid, NULL);
+	free(dev->prefault_ctx);
+	dev->prefault_ctx = NULL;
+}
+
+static void
+vhost_user_prefault_start(struct virtio_net *dev)
+{
+	struct rte_vhost_memory *mem = dev->mem;
+	struct vhost_prefault *ctx;
+	uint64_t page_size;
+	uint32_t i;
+
+	/* Zero copy already populates the regions */
+	if (!dev->prefault || dev->dequeue_zero_copy || mem == NULL ||
+	    mem->nregions == 0)
+		return;
+
+	ctx = malloc(sizeof(*ctx) + sizeof(ctx->regions[0]) * mem->nregions);
+	if (ctx == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) failed to allocate memory for prefault\n",
+			dev->vid);
+		return;
+	}
+
+	ctx->stop = 0;
+	ctx->nregions = 0;
+	for (i = 0; i < mem->nregions; i++) {
+		/* EAL memory is already populated */
+		if (!mem->regions[i].mmap_size)
+			continue;
+
+		page_size = get_blk_size(mem->regions[i].fd);
+		if (page_size == (uint64_t)-1)
+			continue;
+
+		ctx->regions[ctx->nregions].addr = mem->regions[i].mmap_addr;
+		ctx->regions[ctx->nregions].size = mem->regions[i].mmap_size;
+		ctx->regions[ctx->nregions].page_size = page_size;
+		ctx->nregions++;
+	}
+
+	if (rte_ctrl_thread_create(&dev->prefault_tid, "vhost-prefault", NULL,
+			vhost_user_prefault_thread, ctx) != 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) failed to create prefault thread\n", dev->vid);
+		free(ctx);
+		return;
 	}
+
+	dev->prefault_ctx = ctx;
+}
+
+static uint64_t
+get_pervq_shm_size_split(uint16_t queue_size)
+{
+	return RTE_ALIGN_MUL_CEIL(sizeof(struct inflight_info_split) +
+			sizeof(struct inflight_desc_split) * queue_size,
+			INFLIGHT_ALIGNMENT);
+}
+
+static void
+inflight_mem_free(struct virtio_net *dev)
+{
+	uint32_t i;
+
+	if (dev->inflight_addr == NULL)
+		return;
+
+	for (i = 0; i < dev->max_vring; i++)
+		if (dev->virtqueue[i])
+			dev->virtqueue[i]->inflight_split = NULL;
+
+	munmap(dev->inflight_addr, dev->inflight_size);
+	close(dev->inflight_fd);
+	dev->inflight_addr = NULL;
+	dev->inflight_size = 0;
+	dev->inflight_fd = -1;
 }
 
 void
 vhost_backend_cleanup(struct virtio_net *dev)
 {
+	vhost_user_prefault_stop(dev);
+
 	if (dev->mem) {
 		free_mem_region(dev);
-		rte_free(dev->mem);
 		dev->mem = NULL;
 	}
 
 	free(dev->guest_pages);
 	dev->guest_pages = NULL;
+	dev->nr_guest_pages = 0;
+	dev->max_guest_pages = 0;
 
 	if (dev->log_addr) {
-		munmap((void *)(uintptr_t)dev->log_addr, dev->log_size);
+		munmap((void *)(uintptr_t)dev->log_addr, dev->log_map_size);
 		dev->log_addr = 0;
 	}
 
@@ -139,6 +293,8 @@ vhost_backend_cleanup(struct virtio_net *dev)
 	}
 
 	dev->postcopy_listening = 0;
+
+	inflight_mem_free(dev);
 }
 
 /*
@@ -252,6 +408,7 @@ vhost_user_set_features(struct virtio_net **pdev, struct VhostUserMsg *msg,
 	} else {
 		dev->vhost_hlen = sizeof(struct virtio_net_hdr);
 	}
+	vhost_select_datapath(dev);
 	VHOST_LOG_DEBUG(VHOST_CONFIG,
 		"(%d) mergeable RX buffers %s, virtio 1 %s\n",
 		dev->vid,
@@ -312,7 +469,6 @@ vhost_user_set_vring_num(struct virtio_net **pdev,
 
 	if (dev->dequeue_zero_copy) {
 		vq->nr_zmbuf = 0;
-		vq->last_zmbuf_idx = 0;
 		vq->zmbuf_size = vq->size;
 		vq->zmbufs = rte_zmalloc(NULL, vq->zmbuf_size *
 					 sizeof(struct zcopy_mbuf), 0);
@@ -321,8 +477,8 @@ vhost_user_set_vring_num(struct virtio_net **pdev,
 				"failed to allocate mem for zero copy; "
 				"zero copy is force disabled\n");
 			dev->dequeue_zero_copy = 0;
+			vhost_select_datapath(dev);
 		}
-		TAILQ_INIT(&vq->zmbuf_list);
 	}
 
 	if (vq_is_packed(dev)) {
@@ -347,8 +503,9 @@ vhost_user_set_vring_num(struct virtio_net **pdev,
 		}
 	}
 
+	vq->batch_copy_max = RTE_MIN(vq->size, (uint32_t)VHOST_BATCH_COPY_MAX);
 	vq->batch_copy_elems = rte_malloc(NULL,
-				vq->size * sizeof(struct batch_copy_elem),
+				vq->batch_copy_max * sizeof(struct batch_copy_elem),
 				RTE_CACHE_LINE_SIZE);
 	if (!vq->batch_copy_elems) {
 		RTE_LOG(ERR, VHOST_CONFIG,
@@ -379,6 +536,13 @@ numa_realloc(struct virtio_net *dev, int index)
 	old_dev = dev;
 	vq = old_vq = dev->virtqueue[index];
 
+	/* The secondary processes hold the device and its virtqueues */
+	vhost_mp_lock();
+	if (dev->mp_attached) {
+		vhost_mp_unlock();
+		return dev;
+	}
+
 	ret = get_mempolicy(&newnode, NULL, 0, old_vq->desc,
 			    MPOL_F_NODE | MPOL_F_ADDR);
 
@@ -388,17 +552,19 @@ numa_realloc(struct virtio_net *dev, int index)
 	if (ret) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"Unable to get vq numa information.\n");
+		vhost_mp_unlock();
 		return dev;
 	}
 	if (oldnode != newnode) {
 		RTE_LOG(INFO, VHOST_CONFIG,
 			"reallocate vq from %d to %d node\n", oldnode, newnode);
 		vq = rte_malloc_socket(NULL, sizeof(*vq), 0, newnode);
-		if (!vq)
+		if (!vq) {
+			vhost_mp_unlock();
 			return dev;
+		}
 
 		memcpy(vq, old_vq, sizeof(*vq));
-		TAILQ_INIT(&vq->zmbuf_list);
 
 		if (dev->dequeue_zero_copy) {
 			new_zmbuf = rte_malloc_socket(NULL, vq->zmbuf_size *
@@ -432,7 +598,7 @@ numa_realloc(struct virtio_net *dev, int index)
 		}
 
 		new_batch_copy_elems = rte_malloc_socket(NULL,
-			vq->size * sizeof(struct batch_copy_elem),
+			vq->batch_copy_max * sizeof(struct batch_copy_elem),
 			RTE_CACHE_LINE_SIZE,
 			newnode);
 		if (new_batch_copy_elems) {
@@ -469,6 +635,8 @@ numa_realloc(struct virtio_net *dev, int index)
 	dev->virtqueue[index] = vq;
 	vhost_devices[dev->vid] = dev;
 
+	vhost_mp_unlock();
+
 	if (old_vq != vq)
 		vhost_user_iotlb_init(dev, index);
 
@@ -725,33 +893,46 @@ vhost_user_set_vring_base(struct virtio_net **pdev,
 	return VH_RESULT_OK;
 }
 
+/*
+ * Guest physical to host physical translations of the zero copy mode,
+ * built aside and then switched in, so that the datapath keeps using
+ * the current ones while a new memory table is prepared.
+ */
+struct guest_page_set {
+	struct guest_page *pages;
+	uint32_t nr;
+	uint32_t max;
+};
+
 static int
-add_one_guest_page(struct virtio_net *dev, uint64_t guest_phys_addr,
+add_one_guest_page(struct guest_page_set *set, uint64_t guest_phys_addr,
 		   uint64_t host_phys_addr, uint64_t size)
 {
 	struct guest_page *page, *last_page;
 
-	if (dev->nr_guest_pages == dev->max_guest_pages) {
-		dev->max_guest_pages *= 2;
-		dev->guest_pages = realloc(dev->guest_pages,
-					dev->max_guest_pages * sizeof(*page));
-		if (!dev->guest_pages) {
+	if (set->nr == set->max) {
+		set->max = set->max ? set->max * 2 : 8;
+		page = realloc(set->pages, set->max * sizeof(*page));
+		if (!page) {
 			RTE_LOG(ERR, VHOST_CONFIG, "cannot realloc guest_pages\n");
 			return -1;
 		}
+		set->pages = page;
 	}
 
-	if (dev->nr_guest_pages > 0) {
-		last_page = &dev->guest_pages[dev->nr_guest_pages - 1];
+	if (set->nr > 0) {
+		last_page = &set->pages[set->nr - 1];
 		/* merge if the two pages are continuous */
-		if (host_phys_addr == last_page->host_phys_addr +
+		if (guest_phys_addr == last_page->guest_phys_addr +
+				       last_page->size &&
+		    host_phys_addr == last_page->host_phys_addr +
 				      last_page->size) {
 			last_page->size += size;
 			return 0;
 		}
 	}
 
-	page = &dev->guest_pages[dev->nr_guest_pages++];
+	page = &set->pages[set->nr++];
 	page->guest_phys_addr = guest_phys_addr;
 	page->host_phys_addr  = host_phys_addr;
 	page->size = size;
@@ -759,43 +940,82 @@ add_one_guest_page(struct virtio_net *dev, uint64_t guest_phys_addr,
 	return 0;
 }
 
+/*
+ * Copy the translations of a region kept from the previous memory
+ * table, instead of walking the pagemap for it again.
+ */
 static int
-add_guest_pages(struct virtio_net *dev, struct rte_vhost_mem_region *reg,
-		uint64_t page_size)
+copy_guest_pages(struct guest_page_set *set, struct virtio_net *dev,
+		 struct rte_vhost_mem_region *reg)
 {
-	uint64_t reg_size = reg->size;
-	uint64_t host_user_addr  = reg->host_user_addr;
-	uint64_t guest_phys_addr = reg->guest_phys_addr;
-	uint64_t host_phys_addr;
-	uint64_t size;
-
-	host_phys_addr = rte_mem_virt2iova((void *)(uintptr_t)host_user_addr);
-	size = page_size - (guest_phys_addr & (page_size - 1));
-	size = RTE_MIN(size, reg_size);
+	uint64_t reg_start = reg->guest_phys_addr;
+	uint64_t reg_end = reg->guest_phys_addr + reg->size;
+	struct guest_page *page;
+	uint64_t start, end;
+	uint32_t i;
 
-	if (add_one_guest_page(dev, guest_phys_addr, host_phys_addr, size) < 0)
-		return -1;
+	for (i = 0; i < dev->nr_guest_pages; i++) {
+		page = &dev->guest_pages[i];
 
-	host_user_addr  += size;
-	guest_phys_addr += size;
-	reg_size -= size;
+		start = RTE_MAX(page->guest_phys_addr, reg_start);
+		end = RTE_MIN(page->guest_phys_addr + page->size, reg_end);
+		if (start >= end)
+			continue;
 
-	while (reg_size > 0) {
-		size = RTE_MIN(reg_size, page_size);
-		host_phys_addr = rte_mem_virt2iova((void *)(uintptr_t)
-						  host_user_addr);
-		if (add_one_guest_page(dev, guest_phys_addr, host_phys_addr,
-				size) < 0)
+		if (add_one_guest_page(set, start, page->host_phys_addr +
+				start - page->guest_phys_addr, end - start) < 0)
 			return -1;
-
-		host_user_addr  += size;
-		guest_phys_addr += size;
-		reg_size -= size;
 	}
 
 	return 0;
 }
 
+static int
+guest_page_addrcmp(const void *p1, const void *p2)
+{
+	const struct guest_page *page1 = p1;
+	const struct guest_page *page2 = p2;
+
+	if (page1->guest_phys_addr < page2->guest_phys_addr)
+		return -1;
+	if (page1->guest_phys_addr > page2->guest_phys_addr)
+		return 1;
+	return 0;
+}
+
+/*
+ * Sort the guest pages by guest physical address for the binary search
+ * of gpa_to_hpa(), and merge the ones of different regions that turn
+ * out to be continuous.
+ */
+static void
+sort_guest_pages(struct guest_page_set *set)
+{
+	struct guest_page *page, *last_page;
+	uint32_t i, n;
+
+	if (set->nr < 2)
+		return;
+
+	qsort(set->pages, set->nr, sizeof(struct guest_page),
+	      guest_page_addrcmp);
+
+	n = 0;
+	for (i = 1; i < set->nr; i++) {
+		last_page = &set->pages[n];
+		page = &set->pages[i];
+		if (page->guest_phys_addr == last_page->guest_phys_addr +
+					     last_page->size &&
+		    page->host_phys_addr == last_page->host_phys_addr +
+					    last_page->size) {
+			last_page->size += page->size;
+			continue;
+		}
+		set->pages[++n] = *page;
+	}
+	set->nr = n + 1;
+}
+
 #ifdef RTE_LIBRTE_VHOST_DEBUG
 /* TODO: enable it only in debug mode? */
 static void
@@ -846,173 +1066,655 @@ vhost_memory_changed(struct VhostUserMemory *new,
 	return false;
 }
 
-static int
-vhost_user_set_mem_table(struct virtio_net **pdev, struct VhostUserMsg *msg,
-			int main_fd)
+/*
+ * A region of the new table can keep the mapping of an old one if it
+ * describes the same range, at the same offset of the same file.
+ */
+static bool
+mem_region_reusable(struct rte_vhost_mem_region *old,
+		    VhostUserMemoryRegion *new, int fd)
+{
+	struct stat old_stat, new_stat;
+
+	if (old->guest_phys_addr != new->guest_phys_addr ||
+	    old->size != new->memory_size ||
+	    old->guest_user_addr != new->userspace_addr ||
+	    old->host_user_addr - (uint64_t)(uintptr_t)old->mmap_addr !=
+			new->mmap_offset)
+		return false;
+
+	if (fstat(old->fd, &old_stat) < 0 || fstat(fd, &new_stat) < 0)
+		return false;
+
+	return old_stat.st_dev == new_stat.st_dev &&
+		old_stat.st_ino == new_stat.st_ino;
+}
+
+static bool
+mem_table_has_region(struct rte_vhost_memory *mem,
+		     struct rte_vhost_mem_region *reg)
+{
+	uint32_t i;
+
+	if (mem == NULL)
+		return false;
+
+	for (i = 0; i < mem->nregions; i++)
+		if (mem->regions[i].mmap_addr == reg->mmap_addr)
+			return true;
+
+	return false;
+}
+
+/*
+ * Get the memory table to fill for an update: the one of the device that
+ * is not installed. The tables are allocated with the device, as the heap
+ * lock may be held by a frontend in the same process waiting for the
+ * message being handled.
+ */
+static struct rte_vhost_memory *
+alloc_mem_table(struct virtio_net *dev)
+{
+	struct rte_vhost_memory *mem;
+
+	mem = dev->mem == dev->mem_tables[0] ?
+		dev->mem_tables[1] : dev->mem_tables[0];
+	memset(mem, 0, VHOST_MEM_TABLE_SIZE);
+	return mem;
+}
+
+/*
+ * Unmap the regions of a table that are not part of the other one, and
+ * release the table.
+ */
+static void
+free_mem_table(struct rte_vhost_memory *mem, struct rte_vhost_memory *other)
 {
-	struct virtio_net *dev = *pdev;
-	struct VhostUserMemory *memory = &msg->payload.memory;
 	struct rte_vhost_mem_region *reg;
-	void *mmap_addr;
-	uint64_t mmap_size;
-	uint64_t mmap_offset;
-	uint64_t alignment;
 	uint32_t i;
-	int populate;
-	int fd;
 
-	if (memory->nregions > VHOST_MEMORY_MAX_NREGIONS) {
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"too many memory regions (%u)\n", memory->nregions);
-		return VH_RESULT_ERR;
+	for (i = 0; i < mem->nregions; i++) {
+		reg = &mem->regions[i];
+		if (reg->host_user_addr && !mem_table_has_region(other, reg))
+			unmap_mem_region(reg);
 	}
 
-	if (dev->mem && !vhost_memory_changed(memory, dev->mem)) {
-		RTE_LOG(INFO, VHOST_CONFIG,
-			"(%d) memory regions not changed\n", dev->vid);
+	mem->nregions = 0;
+}
 
-		for (i = 0; i < memory->nregions; i++)
-			close(msg->fds[i]);
+/*
+ * Find the NUMA node of a newly mapped region, from its first page,
+ * and warn if no lcore of the application can poll it locally.
+ */
+#ifdef RTE_LIBRTE_VHOST_NUMA
+static int
+mem_region_numa_node(struct virtio_net *dev, struct rte_vhost_mem_region *reg)
+{
+	unsigned int lcore_id;
+	int node;
 
-		return VH_RESULT_OK;
+	/* Looking the node up faults the page in, not allowed in postcopy */
+	if (dev->postcopy_listening)
+		return -1;
+
+	if (get_mempolicy(&node, NULL, 0, reg->mmap_addr,
+			  MPOL_F_NODE | MPOL_F_ADDR)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"Unable to get region numa information.\n");
+		return -1;
 	}
 
-	if (dev->mem) {
-		free_mem_region(dev);
-		rte_free(dev->mem);
-		dev->mem = NULL;
+	RTE_LCORE_FOREACH(lcore_id) {
+		if (rte_lcore_to_socket_id(lcore_id) == (unsigned int)node)
+			return node;
 	}
 
-	/* Flush IOTLB cache as previous HVAs are now invalid */
-	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
-		for (i = 0; i < dev->nr_vring; i++)
-			vhost_user_iotlb_flush_all(dev->virtqueue[i]);
+	RTE_LOG(WARNING, VHOST_CONFIG,
+		"(%d) guest memory at 0x%" PRIx64 " is on node %d, "
+		"without any lcore\n",
+		dev->vid, reg->guest_phys_addr, node);
 
-	dev->nr_guest_pages = 0;
-	if (!dev->guest_pages) {
-		dev->max_guest_pages = 8;
-		dev->guest_pages = malloc(dev->max_guest_pages *
-						sizeof(struct guest_page));
-		if (dev->guest_pages == NULL) {
-			RTE_LOG(ERR, VHOST_CONFIG,
-				"(%d) failed to allocate memory "
-				"for dev->guest_pages\n",
-				dev->vid);
-			return VH_RESULT_ERR;
-		}
-	}
+	return node;
+}
+#else
+static int
+mem_region_numa_node(struct virtio_net *dev __rte_unused,
+		     struct rte_vhost_mem_region *reg __rte_unused)
+{
+	return -1;
+}
+#endif
 
-	dev->mem = rte_zmalloc("vhost-mem-table", sizeof(struct rte_vhost_memory) +
-		sizeof(struct rte_vhost_mem_region) * memory->nregions, 0);
-	if (dev->mem == NULL) {
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"(%d) failed to allocate memory for dev->mem\n",
-			dev->vid);
-		return VH_RESULT_ERR;
-	}
-	dev->mem->nregions = memory->nregions;
+/*
+ * With RTE_VHOST_USER_SHARED_MEM, a region sent by a virtio-user device
+ * of the same DPDK multi-process group, or of the same process, is made
+ * of hugepages EAL already maps at the same address, from the same file.
+ * The region is used in place instead of being mapped again: this saves
+ * the mapping and its TLB entries, the zero copy mbufs get the IOVAs of
+ * the EAL memory, which the devices can DMA to in any IOVA mode, and the
+ * buffers stay mapped until EAL frees them.
+ */
+static bool
+vhost_user_share_region(struct virtio_net *dev,
+			struct rte_vhost_mem_region *reg,
+			VhostUserMemoryRegion *region, int fd)
+{
+	void *start = (void *)(uintptr_t)region->userspace_addr;
+	void *last = RTE_PTR_ADD(start, region->memory_size - 1);
+	struct rte_memseg_list *msl;
+	struct rte_memseg *ms;
+	struct stat reg_stat, ms_stat;
+	size_t ms_offset;
+	int ms_fd;
+
+	if (!dev->shared_mem || dev->postcopy_listening)
+		return false;
 
-	for (i = 0; i < memory->nregions; i++) {
-		fd  = msg->fds[i];
-		reg = &dev->mem->regions[i];
+	/*
+	 * Pages in between may be free, the peer only gives buffers of the
+	 * memory it allocated.
+	 */
+	msl = rte_mem_virt2memseg_list(start);
+	if (msl == NULL || msl->external ||
+	    rte_mem_virt2memseg_list(last) != msl)
+		return false;
 
-		reg->guest_phys_addr = memory->regions[i].guest_phys_addr;
-		reg->guest_user_addr = memory->regions[i].userspace_addr;
-		reg->size            = memory->regions[i].memory_size;
-		reg->fd              = fd;
+	ms = rte_mem_virt2memseg(start, msl);
+	if (ms == NULL || !rte_fbarray_is_used(&msl->memseg_arr,
+			rte_fbarray_find_idx(&msl->memseg_arr, ms)))
+		return false;
 
-		mmap_offset = memory->regions[i].mmap_offset;
+	ms_fd = rte_memseg_get_fd(ms);
+	if (ms_fd < 0 || rte_memseg_get_fd_offset(ms, &ms_offset) < 0)
+		return false;
 
-		/* Check for memory_size + mmap_offset overflow */
-		if (mmap_offset >= -reg->size) {
-			RTE_LOG(ERR, VHOST_CONFIG,
-				"mmap_offset (%#"PRIx64") and memory_size "
-				"(%#"PRIx64") overflow\n",
-				mmap_offset, reg->size);
-			goto err_mmap;
-		}
+	if (fstat(fd, &reg_stat) < 0 || fstat(ms_fd, &ms_stat) < 0 ||
+	    reg_stat.st_dev != ms_stat.st_dev ||
+	    reg_stat.st_ino != ms_stat.st_ino ||
+	    region->mmap_offset != ms_offset + RTE_PTR_DIFF(start, ms->addr))
+		return false;
 
-		mmap_size = reg->size + mmap_offset;
+	reg->guest_phys_addr = region->guest_phys_addr;
+	reg->guest_user_addr = region->userspace_addr;
+	reg->host_user_addr  = region->userspace_addr;
+	reg->size            = region->memory_size;
+	reg->fd              = fd;
+	reg->mmap_addr       = start;
+	reg->mmap_size       = 0;
+	reg->numa_node       = msl->socket_id;
 
-		/* mmap() without flag of MAP_ANONYMOUS, should be called
-		 * with length argument aligned with hugepagesz at older
-		 * longterm version Linux, like 2.6.32 and 3.2.72, or
-		 * mmap() will fail with EINVAL.
-		 *
-		 * to avoid failure, make sure in caller to keep length
-		 * aligned.
-		 */
-		alignment = get_blk_size(fd);
-		if (alignment == (uint64_t)-1) {
-			RTE_LOG(ERR, VHOST_CONFIG,
-				"couldn't get hugepage size through fstat\n");
-			goto err_mmap;
-		}
-		mmap_size = RTE_ALIGN_CEIL(mmap_size, alignment);
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"guest memory region shared with EAL, size: 0x%" PRIx64 "\n"
+		"\t guest physical addr: 0x%" PRIx64 "\n"
+		"\t host  virtual  addr: 0x%" PRIx64 "\n"
+		"\t numa node : %d\n",
+		reg->size,
+		reg->guest_phys_addr,
+		reg->host_user_addr,
+		reg->numa_node);
+
+	return true;
+}
+
+/*
+ * Map one region sent by the master. On success the region owns the fd.
+ */
+static int
+vhost_user_mmap_region(struct virtio_net *dev,
+		       struct rte_vhost_mem_region *reg,
+		       VhostUserMemoryRegion *region, int fd)
+{
+	void *mmap_addr;
+	uint64_t mmap_size;
+	uint64_t mmap_offset;
+	uint64_t alignment;
 
-		populate = (dev->dequeue_zero_copy) ? MAP_POPULATE : 0;
-		mmap_addr = mmap(NULL, mmap_size, PROT_READ | PROT_WRITE,
-				 MAP_SHARED | populate, fd, 0);
+	mmap_offset = region->mmap_offset;
 
-		if (mmap_addr == MAP_FAILED) {
-			RTE_LOG(ERR, VHOST_CONFIG,
-				"mmap region %u failed.\n", i);
-			goto err_mmap;
-		}
+	/* Check for memory_size + mmap_offset overflow */
+	if (mmap_offset >= -region->memory_size) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"mmap_offset (%#"PRIx64") and memory_size "
+			"(%#"PRIx64") overflow\n",
+			mmap_offset, region->memory_size);
+		return -1;
+	}
 
-		reg->mmap_addr = mmap_addr;
-		reg->mmap_size = mmap_size;
-		reg->host_user_addr = (uint64_t)(uintptr_t)mmap_addr +
-				      mmap_offset;
+	if (vhost_user_share_region(dev, reg, region, fd))
+		return 0;
 
-		if (dev->dequeue_zero_copy)
-			if (add_guest_pages(dev, reg, alignment) < 0) {
-				RTE_LOG(ERR, VHOST_CONFIG,
-					"adding guest pages to region %u failed.\n",
-					i);
-				goto err_mmap;
-			}
+	reg->guest_phys_addr = region->guest_phys_addr;
+	reg->guest_user_addr = region->userspace_addr;
+	reg->size            = region->memory_size;
+	reg->fd              = fd;
 
-		RTE_LOG(INFO, VHOST_CONFIG,
-			"guest memory region %u, size: 0x%" PRIx64 "\n"
-			"\t guest physical addr: 0x%" PRIx64 "\n"
-			"\t guest virtual  addr: 0x%" PRIx64 "\n"
-			"\t host  virtual  addr: 0x%" PRIx64 "\n"
-			"\t mmap addr : 0x%" PRIx64 "\n"
-			"\t mmap size : 0x%" PRIx64 "\n"
-			"\t mmap align: 0x%" PRIx64 "\n"
-			"\t mmap off  : 0x%" PRIx64 "\n",
-			i, reg->size,
-			reg->guest_phys_addr,
-			reg->guest_user_addr,
-			reg->host_user_addr,
-			(uint64_t)(uintptr_t)mmap_addr,
-			mmap_size,
-			alignment,
-			mmap_offset);
+	mmap_size = reg->size + mmap_offset;
 
-		if (dev->postcopy_listening) {
-			/*
-			 * We haven't a better way right now than sharing
-			 * DPDK's virtual address with Qemu, so that Qemu can
-			 * retrieve the region offset when handling userfaults.
-			 */
-			memory->regions[i].userspace_addr =
-				reg->host_user_addr;
-		}
+	/* mmap() without flag of MAP_ANONYMOUS, should be called
+	 * with length argument aligned with hugepagesz at older
+	 * longterm version Linux, like 2.6.32 and 3.2.72, or
+	 * mmap() will fail with EINVAL.
+	 *
+	 * to avoid failure, make sure in caller to keep length
+	 * aligned.
+	 */
+	alignment = get_blk_size(fd);
+	if (alignment == (uint64_t)-1) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"couldn't get hugepage size through fstat\n");
+		return -1;
 	}
-	if (dev->postcopy_listening) {
-		/* Send the addresses back to qemu */
-		msg->fd_num = 0;
-		send_vhost_reply(main_fd, msg);
+	mmap_size = RTE_ALIGN_CEIL(mmap_size, alignment);
 
-		/* Wait for qemu to acknolwedge it's got the addresses
-		 * we've got to wait before we're allowed to generate faults.
-		 */
-		VhostUserMsg ack_msg;
-		if (read_vhost_message(main_fd, &ack_msg) <= 0) {
-			RTE_LOG(ERR, VHOST_CONFIG,
-				"Failed to read qemu ack on postcopy set-mem-table\n");
+	/* Zero copy populates the region while adding its guest pages */
+	mmap_addr = mmap(NULL, mmap_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED, fd, 0);
+
+	if (mmap_addr == MAP_FAILED) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"mmap region at 0x%" PRIx64 " failed.\n",
+			reg->guest_phys_addr);
+		return -1;
+	}
+
+	reg->mmap_addr = mmap_addr;
+	reg->mmap_size = mmap_size;
+	reg->host_user_addr = (uint64_t)(uintptr_t)mmap_addr +
+			      mmap_offset;
+	reg->numa_node = mem_region_numa_node(dev, reg);
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"guest memory region, size: 0x%" PRIx64 "\n"
+		"\t guest physical addr: 0x%" PRIx64 "\n"
+		"\t guest virtual  addr: 0x%" PRIx64 "\n"
+		"\t host  virtual  addr: 0x%" PRIx64 "\n"
+		"\t mmap addr : 0x%" PRIx64 "\n"
+		"\t mmap size : 0x%" PRIx64 "\n"
+		"\t mmap align: 0x%" PRIx64 "\n"
+		"\t mmap off  : 0x%" PRIx64 "\n"
+		"\t numa node : %d\n",
+		reg->size,
+		reg->guest_phys_addr,
+		reg->guest_user_addr,
+		reg->host_user_addr,
+		(uint64_t)(uintptr_t)mmap_addr,
+		mmap_size,
+		alignment,
+		mmap_offset,
+		reg->numa_node);
+
+	return 0;
+}
+
+/*
+ * The guest pages of the new regions are built by several threads, each
+ * taking chunks of guest memory in turn, as faulting in and translating
+ * every page of a large guest takes long.
+ */
+#define GUEST_PAGES_CHUNK_SIZE (1ULL << 32)
+#define GUEST_PAGES_MAX_THREADS 8
+
+struct guest_pages_chunk {
+	struct rte_vhost_mem_region *reg;
+	uint64_t page_size;
+	uint64_t guest_phys_addr;
+	uint64_t size;
+	struct guest_page_set set;
+	int ret;
+};
+
+struct guest_pages_job {
+	struct guest_pages_chunk *chunks;
+	uint32_t nr_chunks;
+	uint32_t next;
+};
+
+static void
+add_guest_pages_chunk(struct guest_pages_chunk *chunk)
+{
+	struct rte_vhost_mem_region *reg = chunk->reg;
+	uint64_t guest_phys_addr = chunk->guest_phys_addr;
+	uint64_t end = guest_phys_addr + chunk->size;
+	uint64_t host_user_addr;
+	uint64_t host_phys_addr;
+	uint64_t size;
+
+	while (guest_phys_addr < end) {
+		size = chunk->page_size -
+		       (guest_phys_addr & (chunk->page_size - 1));
+		size = RTE_MIN(size, end - guest_phys_addr);
+		host_user_addr = reg->host_user_addr +
+				 guest_phys_addr - reg->guest_phys_addr;
+
+		/* Reading the page faults it in, so that it has an address */
+		(void)*(volatile uint8_t *)(uintptr_t)host_user_addr;
+		host_phys_addr = rte_mem_virt2iova((void *)(uintptr_t)
+						  host_user_addr);
+
+		/* Without translation, the page is copied by the datapath */
+		if (host_phys_addr != RTE_BAD_IOVA &&
+		    add_one_guest_page(&chunk->set, guest_phys_addr,
+				       host_phys_addr, size) < 0) {
+			chunk->ret = -1;
+			return;
+		}
+
+		guest_phys_addr += size;
+	}
+}
+
+static void *
+guest_pages_thread(void *arg)
+{
+	struct guest_pages_job *job = arg;
+	uint32_t i;
+
+	while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+			job->nr_chunks)
+		add_guest_pages_chunk(&job->chunks[i]);
+
+	return NULL;
+}
+
+/*
+ * Add the guest pages of the regions that are not in the current table,
+ * which also populates them. The chunks are aligned on 4 GB, a multiple
+ * of the page size, so that no page is split.
+ */
+static int
+add_guest_pages(struct guest_page_set *set, struct rte_vhost_memory *mem,
+		struct rte_vhost_memory *old)
+{
+	pthread_t tids[GUEST_PAGES_MAX_THREADS - 1];
+	struct guest_pages_job job = { NULL, 0, 0 };
+	struct guest_pages_chunk *chunk;
+	struct rte_vhost_mem_region *reg;
+	uint64_t page_size, gpa, end;
+	uint32_t i, j, nr_threads;
+	int ret = 0;
+
+	for (i = 0; i < mem->nregions; i++) {
+		reg = &mem->regions[i];
+		if (!mem_table_has_region(old, reg))
+			job.nr_chunks += (reg->guest_phys_addr + reg->size - 1) /
+				GUEST_PAGES_CHUNK_SIZE -
+				reg->guest_phys_addr / GUEST_PAGES_CHUNK_SIZE + 1;
+	}
+
+	if (job.nr_chunks == 0)
+		return 0;
+
+	job.chunks = calloc(job.nr_chunks, sizeof(*job.chunks));
+	if (job.chunks == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG, "cannot alloc guest pages job\n");
+		return -1;
+	}
+
+	chunk = job.chunks;
+	for (i = 0; i < mem->nregions; i++) {
+		reg = &mem->regions[i];
+		if (mem_table_has_region(old, reg))
+			continue;
+
+		page_size = get_blk_size(reg->fd);
+		if (page_size == (uint64_t)-1) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"couldn't get page size of region %u\n", i);
+			ret = -1;
+			goto out;
+		}
+
+		end = reg->guest_phys_addr + reg->size;
+		for (gpa = reg->guest_phys_addr; gpa < end;
+				gpa += chunk->size, chunk++) {
+			chunk->reg = reg;
+			chunk->page_size = page_size;
+			chunk->guest_phys_addr = gpa;
+			chunk->size = RTE_MIN(end, RTE_ALIGN_FLOOR(gpa,
+				GUEST_PAGES_CHUNK_SIZE) +
+				GUEST_PAGES_CHUNK_SIZE) - gpa;
+		}
+	}
+
+	nr_threads = RTE_MIN(job.nr_chunks, (uint32_t)GUEST_PAGES_MAX_THREADS);
+	for (j = 0; j + 1 < nr_threads; j++) {
+		if (rte_ctrl_thread_create(&tids[j], "vhost-pages", NULL,
+				guest_pages_thread, &job) != 0)
+			break;
+	}
+	guest_pages_thread(&job);
+	while (j > 0)
+		pthread_join(tids[--j], NULL);
+
+	for (i = 0; i < job.nr_chunks; i++) {
+		chunk = &job.chunks[i];
+		if (chunk->ret < 0) {
+			ret = -1;
+			goto out;
+		}
+		for (j = 0; j < chunk->set.nr; j++) {
+			if (add_one_guest_page(set,
+					chunk->set.pages[j].guest_phys_addr,
+					chunk->set.pages[j].host_phys_addr,
+					chunk->set.pages[j].size) < 0) {
+				ret = -1;
+				goto out;
+			}
+		}
+	}
+
+out:
+	for (i = 0; i < job.nr_chunks; i++)
+		free(job.chunks[i].set.pages);
+	free(job.chunks);
+
+	return ret;
+}
+
+/*
+ * Switch the device to a new memory table, whose regions are either
+ * freshly mapped or shared with the current table. The queues are only
+ * locked for the switch itself, and the rings are translated again only
+ * if a region went away: the ones that stayed keep their mapping.
+ * The new table is consumed, even on failure.
+ */
+static int
+vhost_user_install_mem_table(struct virtio_net **pdev,
+			     struct rte_vhost_memory *mem)
+{
+	struct virtio_net *dev = *pdev;
+	struct rte_vhost_memory *old = dev->mem;
+	struct guest_page_set set = { NULL, 0, 0 };
+	struct rte_vhost_mem_region *reg;
+	bool removed = false;
+	int ret = VH_RESULT_OK;
+	uint32_t i;
+
+	for (i = 0; old && i < old->nregions; i++)
+		if (!mem_table_has_region(mem, &old->regions[i]))
+			removed = true;
+
+	for (i = 0; dev->dequeue_zero_copy && i < mem->nregions; i++) {
+		reg = &mem->regions[i];
+		if (mem_table_has_region(old, reg))
+			ret = copy_guest_pages(&set, dev, reg);
+		else if (reg->mmap_size && rte_eal_iova_mode() == RTE_IOVA_VA)
+			RTE_LOG(WARNING, VHOST_CONFIG,
+				"(%d) region %u is not EAL memory, devices "
+				"cannot DMA its zero copy buffers\n",
+				dev->vid, i);
+
+		if (ret < 0)
+			break;
+	}
+	if (ret == 0 && dev->dequeue_zero_copy)
+		ret = add_guest_pages(&set, mem, old);
+	if (ret < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG, "(%d) adding guest pages failed.\n",
+			dev->vid);
+		free(set.pages);
+		free_mem_table(mem, old);
+		return VH_RESULT_ERR;
+	}
+	sort_guest_pages(&set);
+
+	/* The attached secondary processes map the new regions first */
+	vhost_mp_mem_update_begin(dev, mem);
+
+	vhost_user_prefault_stop(dev);
+
+	vhost_user_lock_all_queue_pairs(dev);
+
+	dev->mem = mem;
+	if (dev->dequeue_zero_copy) {
+		struct guest_page *pages = dev->guest_pages;
+
+		dev->guest_pages = set.pages;
+		dev->nr_guest_pages = set.nr;
+		dev->max_guest_pages = set.max;
+		set.pages = pages;
+	}
+
+	/* Flush IOTLB cache as HVAs of the removed regions are now invalid */
+	if (removed && (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM)))
+		for (i = 0; i < dev->nr_vring; i++)
+			vhost_user_iotlb_flush_all(dev->virtqueue[i]);
+
+	for (i = 0; i < dev->nr_vring; i++) {
+		struct vhost_virtqueue *vq = dev->virtqueue[i];
+		bool mapped = vq->desc || vq->avail || vq->used;
+
+		/*
+		 * If the memory table got updated, the ring addresses need to
+		 * be translated again as virtual addresses have changed.
+		 * Without IOMMU, the rings of a started queue that lost their
+		 * memory with a removed region are mapped again once it gets
+		 * added back.
+		 */
+		if ((mapped && removed) ||
+		    (!mapped && vq->kickfd != VIRTIO_UNINITIALIZED_EVENTFD &&
+		     !(dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM)))) {
+			vring_invalidate(dev, vq);
+
+			dev = translate_ring_addresses(dev, i);
+			if (!dev) {
+				dev = *pdev;
+				ret = VH_RESULT_ERR;
+				break;
+			}
+
+			*pdev = dev;
+		}
+	}
+
+	vhost_user_unlock_all_queue_pairs(dev);
+
+	free(set.pages);
+	if (old)
+		free_mem_table(old, mem);
+
+	vhost_mp_mem_update_end(dev);
+
+	vhost_user_prefault_start(dev);
+
+	if (ret == VH_RESULT_ERR)
+		return ret;
+
+	dump_guest_pages(dev);
+
+	if (dev->flags & VIRTIO_DEV_VDPA_CONFIGURED) {
+		struct rte_vdpa_device *vdpa_dev;
+
+		vdpa_dev = rte_vdpa_get_device(dev->vdpa_dev_id);
+		if (vdpa_dev && vdpa_dev->ops->set_mem_table)
+			vdpa_dev->ops->set_mem_table(dev->vid);
+	}
+
+	return VH_RESULT_OK;
+}
+
+static int
+vhost_user_set_mem_table(struct virtio_net **pdev, struct VhostUserMsg *msg,
+			int main_fd)
+{
+	struct virtio_net *dev = *pdev;
+	struct VhostUserMemory *memory = &msg->payload.memory;
+	struct rte_vhost_memory *mem;
+	struct rte_vhost_mem_region *reg;
+	uint32_t i, j;
+
+	if (memory->nregions > VHOST_MEMORY_MAX_NREGIONS) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"too many memory regions (%u)\n", memory->nregions);
+		return VH_RESULT_ERR;
+	}
+
+	if (dev->mem && !vhost_memory_changed(memory, dev->mem)) {
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%d) memory regions not changed\n", dev->vid);
+
+		for (i = 0; i < memory->nregions; i++)
+			close(msg->fds[i]);
+
+		return VH_RESULT_OK;
+	}
+
+	mem = alloc_mem_table(dev);
+	mem->nregions = memory->nregions;
+
+	for (i = 0; i < memory->nregions; i++) {
+		reg = &mem->regions[i];
+
+		/*
+		 * Postcopy registers every region with userfaultfd again,
+		 * so only keep the mappings outside of it.
+		 */
+		for (j = 0; dev->mem && !dev->postcopy_listening &&
+				j < dev->mem->nregions; j++) {
+			if (mem_region_reusable(&dev->mem->regions[j],
+					&memory->regions[i], msg->fds[i]))
+				break;
+		}
+
+		if (dev->mem && !dev->postcopy_listening &&
+				j < dev->mem->nregions) {
+			RTE_LOG(INFO, VHOST_CONFIG,
+				"guest memory region %u unchanged, "
+				"keeping its mapping\n", i);
+			*reg = dev->mem->regions[j];
+			close(msg->fds[i]);
+			msg->fds[i] = -1;
+			continue;
+		}
+
+		if (vhost_user_mmap_region(dev, reg, &memory->regions[i],
+				msg->fds[i]) < 0)
+			goto err_mmap;
+		msg->fds[i] = -1;
+
+		if (dev->postcopy_listening) {
+			/*
+			 * We haven't a better way right now than sharing
+			 * DPDK's virtual address with Qemu, so that Qemu can
+			 * retrieve the region offset when handling userfaults.
+			 */
+			memory->regions[i].userspace_addr =
+				reg->host_user_addr;
+		}
+	}
+
+	if (dev->postcopy_listening) {
+		/* Send the addresses back to qemu */
+		msg->fd_num = 0;
+		send_vhost_reply(main_fd, msg);
+
+		/* Wait for qemu to acknolwedge it's got the addresses
+		 * we've got to wait before we're allowed to generate faults.
+		 */
+		VhostUserMsg ack_msg;
+		if (read_vhost_message(main_fd, &ack_msg) <= 0) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"Failed to read qemu ack on postcopy set-mem-table\n");
 			goto err_mmap;
 		}
 		if (ack_msg.request.master != VHOST_USER_SET_MEM_TABLE) {
@@ -1025,7 +1727,7 @@ vhost_user_set_mem_table(struct virtio_net **pdev, struct VhostUserMsg *msg,
 		/* Now userfault register and we can use the memory */
 		for (i = 0; i < memory->nregions; i++) {
 #ifdef RTE_LIBRTE_VHOST_POSTCOPY
-			reg = &dev->mem->regions[i];
+			reg = &mem->regions[i];
 			struct uffdio_register reg_struct;
 
 			/*
@@ -1056,38 +1758,140 @@ vhost_user_set_mem_table(struct virtio_net **pdev, struct VhostUserMsg *msg,
 		}
 	}
 
-	for (i = 0; i < dev->nr_vring; i++) {
-		struct vhost_virtqueue *vq = dev->virtqueue[i];
+	return vhost_user_install_mem_table(pdev, mem);
 
-		if (vq->desc || vq->avail || vq->used) {
-			/*
-			 * If the memory table got updated, the ring addresses
-			 * need to be translated again as virtual addresses have
-			 * changed.
-			 */
-			vring_invalidate(dev, vq);
+err_mmap:
+	free_mem_table(mem, dev->mem);
+	for (i = 0; i < memory->nregions; i++)
+		if (msg->fds[i] >= 0)
+			close(msg->fds[i]);
+	return VH_RESULT_ERR;
+}
 
-			dev = translate_ring_addresses(dev, i);
-			if (!dev) {
-				dev = *pdev;
-				goto err_mmap;
-			}
+/*
+ * The number of memory regions that can be added one by one.
+ */
+static int
+vhost_user_get_max_mem_slots(struct virtio_net **pdev __rte_unused,
+			struct VhostUserMsg *msg,
+			int main_fd __rte_unused)
+{
+	msg->payload.u64 = VHOST_MEMORY_MAX_SLOTS;
+	msg->size = sizeof(msg->payload.u64);
+	msg->fd_num = 0;
 
-			*pdev = dev;
+	return VH_RESULT_REPLY;
+}
+
+static int
+vhost_user_add_mem_reg(struct virtio_net **pdev, struct VhostUserMsg *msg,
+			int main_fd __rte_unused)
+{
+	struct virtio_net *dev = *pdev;
+	VhostUserMemoryRegion *region = &msg->payload.memory_single.region;
+	uint32_t nregions = dev->mem ? dev->mem->nregions : 0;
+	struct rte_vhost_memory *mem;
+	struct rte_vhost_mem_region *reg;
+	uint32_t i;
+
+	if (msg->fd_num != 1) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) invalid fd number %d for new memory region\n",
+			dev->vid, msg->fd_num);
+		goto err_fds;
+	}
+
+	if (dev->postcopy_listening) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) memory region added while postcopy listening\n",
+			dev->vid);
+		goto err_fds;
+	}
+
+	for (i = 0; i < nregions; i++) {
+		reg = &dev->mem->regions[i];
+
+		if (mem_region_reusable(reg, region, msg->fds[0])) {
+			RTE_LOG(INFO, VHOST_CONFIG,
+				"(%d) memory region already added\n", dev->vid);
+			close(msg->fds[0]);
+			return VH_RESULT_OK;
+		}
+
+		if (region->guest_phys_addr < reg->guest_phys_addr + reg->size &&
+		    reg->guest_phys_addr <
+				region->guest_phys_addr + region->memory_size) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%d) memory region at 0x%" PRIx64 " overlaps "
+				"region %u\n",
+				dev->vid, region->guest_phys_addr, i);
+			goto err_fds;
 		}
 	}
 
-	dump_guest_pages(dev);
+	if (nregions >= VHOST_MEMORY_MAX_SLOTS) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"too many memory regions (%u)\n", nregions + 1);
+		goto err_fds;
+	}
 
-	return VH_RESULT_OK;
+	mem = alloc_mem_table(dev);
+	if (nregions)
+		memcpy(mem->regions, dev->mem->regions,
+		       sizeof(struct rte_vhost_mem_region) * nregions);
+	mem->nregions = nregions + 1;
 
-err_mmap:
-	free_mem_region(dev);
-	rte_free(dev->mem);
-	dev->mem = NULL;
+	if (vhost_user_mmap_region(dev, &mem->regions[nregions], region,
+			msg->fds[0]) < 0) {
+		mem->nregions = 0;
+		goto err_fds;
+	}
+
+	return vhost_user_install_mem_table(pdev, mem);
+
+err_fds:
+	for (i = 0; i < (uint32_t)msg->fd_num; i++)
+		close(msg->fds[i]);
 	return VH_RESULT_ERR;
 }
 
+static int
+vhost_user_rem_mem_reg(struct virtio_net **pdev, struct VhostUserMsg *msg,
+			int main_fd __rte_unused)
+{
+	struct virtio_net *dev = *pdev;
+	VhostUserMemoryRegion *region = &msg->payload.memory_single.region;
+	struct rte_vhost_memory *mem;
+	struct rte_vhost_mem_region *reg;
+	uint32_t i, n;
+
+	/* The fd of the region to remove is of no use */
+	for (i = 0; i < (uint32_t)msg->fd_num; i++)
+		close(msg->fds[i]);
+
+	for (i = 0; dev->mem && i < dev->mem->nregions; i++) {
+		reg = &dev->mem->regions[i];
+		if (reg->guest_phys_addr == region->guest_phys_addr &&
+		    reg->size == region->memory_size &&
+		    reg->guest_user_addr == region->userspace_addr)
+			break;
+	}
+
+	if (!dev->mem || i == dev->mem->nregions) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) no memory region at 0x%" PRIx64 " to remove\n",
+			dev->vid, region->guest_phys_addr);
+		return VH_RESULT_ERR;
+	}
+
+	mem = alloc_mem_table(dev);
+	for (n = 0; n < dev->mem->nregions; n++)
+		if (n != i)
+			mem->regions[mem->nregions++] = dev->mem->regions[n];
+
+	return vhost_user_install_mem_table(pdev, mem);
+}
+
 static bool
 vq_is_ready(struct virtio_net *dev, struct vhost_virtqueue *vq)
 {
@@ -1149,6 +1953,8 @@ vhost_user_set_vring_call(struct virtio_net **pdev, struct VhostUserMsg *msg,
 
 	vq->callfd = file.fd;
 
+	vhost_mp_call_update(dev, file.index);
+
 	return VH_RESULT_OK;
 }
 
@@ -1163,6 +1969,264 @@ static int vhost_user_set_vring_err(struct virtio_net **pdev __rte_unused,
 	return VH_RESULT_OK;
 }
 
+/*
+ * The master asks for the memory to track the inflight descriptors in,
+ * it gives it back with VHOST_USER_SET_INFLIGHT_FD after a reconnection.
+ */
+static int
+vhost_user_get_inflight_fd(struct virtio_net **pdev, struct VhostUserMsg *msg,
+			int main_fd __rte_unused)
+{
+	struct virtio_net *dev = *pdev;
+	uint16_t num_queues, queue_size;
+	uint64_t pervq_size, mmap_size;
+	uint16_t i;
+	void *addr;
+	int fd;
+
+	if (msg->size != sizeof(msg->payload.inflight)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"invalid get_inflight_fd message size is %d\n",
+			msg->size);
+		return VH_RESULT_ERR;
+	}
+
+	num_queues = msg->payload.inflight.num_queues;
+	queue_size = msg->payload.inflight.queue_size;
+	pervq_size = get_pervq_shm_size_split(queue_size);
+	mmap_size = num_queues * pervq_size;
+
+#ifdef __NR_memfd_create
+	fd = syscall(__NR_memfd_create, "vhost-inflight", 1 /* MFD_CLOEXEC */);
+#else
+	fd = -1;
+	errno = ENOSYS;
+#endif
+	if (fd < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"failed to create inflight memfd: %s\n",
+			strerror(errno));
+		return VH_RESULT_ERR;
+	}
+
+	if (ftruncate(fd, mmap_size) < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"failed to size inflight memfd: %s\n",
+			strerror(errno));
+		close(fd);
+		return VH_RESULT_ERR;
+	}
+
+	addr = mmap(NULL, mmap_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    fd, 0);
+	if (addr == MAP_FAILED) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"failed to mmap inflight memory: %s\n",
+			strerror(errno));
+		close(fd);
+		return VH_RESULT_ERR;
+	}
+
+	memset(addr, 0, mmap_size);
+	for (i = 0; i < num_queues; i++) {
+		struct inflight_info_split *inflight;
+
+		inflight = RTE_PTR_ADD(addr, i * pervq_size);
+		inflight->desc_num = queue_size;
+	}
+
+	inflight_mem_free(dev);
+	dev->inflight_addr = addr;
+	dev->inflight_size = mmap_size;
+	dev->inflight_fd = fd;
+	dev->inflight_num_queues = num_queues;
+	dev->inflight_queue_size = queue_size;
+
+	msg->payload.inflight.mmap_size = mmap_size;
+	msg->payload.inflight.mmap_offset = 0;
+	msg->fds[0] = fd;
+	msg->fd_num = 1;
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"(%d) inflight memory of %u queues, %" PRIu64 " bytes\n",
+		dev->vid, num_queues, mmap_size);
+
+	return VH_RESULT_REPLY;
+}
+
+static int
+vhost_user_set_inflight_fd(struct virtio_net **pdev, struct VhostUserMsg *msg,
+			int main_fd __rte_unused)
+{
+	struct virtio_net *dev = *pdev;
+	uint64_t mmap_size, mmap_offset;
+	uint16_t num_queues, queue_size;
+	void *addr;
+	int fd;
+
+	if (msg->size != sizeof(msg->payload.inflight) || msg->fd_num != 1) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"invalid set_inflight_fd message size is %d, "
+			"fd number is %d\n", msg->size, msg->fd_num);
+		return VH_RESULT_ERR;
+	}
+
+	/* The secondary processes would not track their descriptors */
+	if (dev->mp_attached) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) inflight tracking with secondary processes "
+			"attached is not supported\n", dev->vid);
+		return VH_RESULT_ERR;
+	}
+
+	fd = msg->fds[0];
+	mmap_size = msg->payload.inflight.mmap_size;
+	mmap_offset = msg->payload.inflight.mmap_offset;
+	num_queues = msg->payload.inflight.num_queues;
+	queue_size = msg->payload.inflight.queue_size;
+
+	if (mmap_size < num_queues * get_pervq_shm_size_split(queue_size)) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"inflight memory of %" PRIu64 " bytes too small for "
+			"%u queues of %u descriptors\n",
+			mmap_size, num_queues, queue_size);
+		close(fd);
+		return VH_RESULT_ERR;
+	}
+
+	addr = mmap(NULL, mmap_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    fd, mmap_offset);
+	if (addr == MAP_FAILED) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"failed to mmap inflight memory: %s\n",
+			strerror(errno));
+		close(fd);
+		return VH_RESULT_ERR;
+	}
+
+	inflight_mem_free(dev);
+	dev->inflight_addr = addr;
+	dev->inflight_size = mmap_size;
+	dev->inflight_fd = fd;
+	dev->inflight_num_queues = num_queues;
+	dev->inflight_queue_size = queue_size;
+
+	return VH_RESULT_OK;
+}
+
+static int
+resubmit_desc_cmp(const void *a, const void *b)
+{
+	const struct resubmit_desc *desc0 = a;
+	const struct resubmit_desc *desc1 = b;
+
+	if (desc0->counter < desc1->counter)
+		return -1;
+	if (desc0->counter > desc1->counter)
+		return 1;
+	return 0;
+}
+
+/*
+ * Attach a split ring to its inflight memory when it is started, and
+ * collect the descriptors a previous backend left inflight, so that the
+ * datapath processes them again before the new available ones.
+ */
+static int
+vhost_check_queue_inflights_split(struct virtio_net *dev, uint32_t vring_idx)
+{
+	struct vhost_virtqueue *vq = dev->virtqueue[vring_idx];
+	struct inflight_info_split *inflight;
+	struct resubmit_desc *list;
+	uint16_t resubmit_num = 0;
+	uint64_t counter = 0;
+	uint16_t i;
+
+	if (!(dev->protocol_features &
+			(1ULL << VHOST_USER_PROTOCOL_F_INFLIGHT_SHMFD)) ||
+	    dev->inflight_addr == NULL ||
+	    vring_idx >= dev->inflight_num_queues)
+		return VH_RESULT_OK;
+
+	if (vq->used == NULL)
+		return VH_RESULT_OK;
+
+	if (vq_is_packed(dev)) {
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%d) no inflight tracking of packed vring %u\n",
+			dev->vid, vring_idx);
+		return VH_RESULT_OK;
+	}
+
+	if (dev->inflight_queue_size < vq->size) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) inflight memory too small for vring %u\n",
+			dev->vid, vring_idx);
+		return VH_RESULT_ERR;
+	}
+
+	inflight = RTE_PTR_ADD(dev->inflight_addr,
+		vring_idx * get_pervq_shm_size_split(dev->inflight_queue_size));
+
+	rte_free(vq->resubmit_list);
+	vq->resubmit_list = NULL;
+	vq->resubmit_num = 0;
+	vq->resubmit_idx = 0;
+	vq->inflight_counter = 0;
+	vq->inflight_split = inflight;
+
+	if (!inflight->version) {
+		inflight->version = INFLIGHT_VERSION;
+		return VH_RESULT_OK;
+	}
+
+	/* The used entries published before the crash aren't inflight */
+	for (i = inflight->used_idx; i != vq->used->idx; i++)
+		inflight->desc[vq->used->ring[i & (vq->size - 1)].id &
+			(vq->size - 1)].inflight = 0;
+	rte_smp_wmb();
+	inflight->used_idx = vq->used->idx;
+
+	for (i = 0; i < vq->size; i++) {
+		if (inflight->desc[i].inflight == 1)
+			resubmit_num++;
+		counter = RTE_MAX(counter, inflight->desc[i].counter);
+	}
+	vq->inflight_counter = counter + 1;
+
+	if (resubmit_num == 0)
+		return VH_RESULT_OK;
+
+	list = rte_malloc(NULL, sizeof(*list) * resubmit_num, 0);
+	if (list == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) failed to allocate resubmit list of vring %u\n",
+			dev->vid, vring_idx);
+		return VH_RESULT_ERR;
+	}
+
+	resubmit_num = 0;
+	for (i = 0; i < vq->size; i++) {
+		if (inflight->desc[i].inflight == 1) {
+			list[resubmit_num].index = i;
+			list[resubmit_num].counter = inflight->desc[i].counter;
+			resubmit_num++;
+		}
+	}
+	qsort(list, resubmit_num, sizeof(*list), resubmit_desc_cmp);
+
+	/* The master restarted the ring from its used index */
+	vq->last_avail_idx += resubmit_num;
+	vq->resubmit_list = list;
+	vq->resubmit_num = resubmit_num;
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"(%d) resubmitting %u inflight descriptors of vring %u\n",
+		dev->vid, resubmit_num, vring_idx);
+
+	return VH_RESULT_OK;
+}
+
 static int
 vhost_user_set_vring_kick(struct virtio_net **pdev, struct VhostUserMsg *msg,
 			int main_fd __rte_unused)
@@ -1188,6 +2252,9 @@ vhost_user_set_vring_kick(struct virtio_net **pdev, struct VhostUserMsg *msg,
 
 	vq = dev->virtqueue[file.index];
 
+	if (vhost_check_queue_inflights_split(dev, file.index) != VH_RESULT_OK)
+		return VH_RESULT_ERR;
+
 	/*
 	 * When VHOST_USER_F_PROTOCOL_FEATURES is not negotiated,
 	 * the ring starts already enabled. Otherwise, it is enabled via
@@ -1199,24 +2266,95 @@ vhost_user_set_vring_kick(struct virtio_net **pdev, struct VhostUserMsg *msg,
 	if (vq->kickfd >= 0)
 		close(vq->kickfd);
 	vq->kickfd = file.fd;
+	VHOST_TRACE(dev->vid, file.index, KICKFD, vq->last_avail_idx);
 
 	return VH_RESULT_OK;
 }
 
+/* Period of the reclaim of the zero copy mbufs of stopped vrings */
+#define ZMBUF_RECLAIM_PERIOD_US 10000
+
+/* Zero copy mbufs of a stopped vring the application still holds */
+struct zmbuf_reclaim {
+	struct zcopy_mbuf *zmbufs;
+	uint16_t nr_zmbuf;
+};
+
+/*
+ * The buffers of the mbufs are in guest memory: give the mbufs the
+ * application is done with their own data room back before they go to
+ * their mempool. Return the number of mbufs still in use.
+ */
+static uint16_t
+release_zmbufs(struct zcopy_mbuf *zmbufs, uint16_t nr_zmbuf)
+{
+	struct rte_mbuf *m;
+	uint16_t i = 0;
+
+	while (i < nr_zmbuf) {
+		m = zmbufs[i].mbuf;
+		if (!mbuf_is_consumed(m)) {
+			i++;
+			continue;
+		}
+
+		restore_mbuf(m);
+		rte_pktmbuf_free(m);
+		zmbufs[i] = zmbufs[--nr_zmbuf];
+	}
+
+	return nr_zmbuf;
+}
+
+static void
+zmbuf_reclaim_alarm(void *arg)
+{
+	struct zmbuf_reclaim *reclaim = arg;
+
+	reclaim->nr_zmbuf = release_zmbufs(reclaim->zmbufs,
+			reclaim->nr_zmbuf);
+	if (reclaim->nr_zmbuf == 0)
+		goto out;
+
+	if (rte_eal_alarm_set(ZMBUF_RECLAIM_PERIOD_US,
+			zmbuf_reclaim_alarm, reclaim) == 0)
+		return;
+
+	RTE_LOG(ERR, VHOST_CONFIG,
+		"failed to defer the release of %u zero copy mbufs\n",
+		reclaim->nr_zmbuf);
+out:
+	rte_free(reclaim->zmbufs);
+	rte_free(reclaim);
+}
+
+/*
+ * Called on the message thread, which must not wait for the application:
+ * the mbufs it still holds are released later from an EAL alarm.
+ */
 static void
 free_zmbufs(struct vhost_virtqueue *vq)
 {
-	struct zcopy_mbuf *zmbuf, *next;
-
-	for (zmbuf = TAILQ_FIRST(&vq->zmbuf_list);
-	     zmbuf != NULL; zmbuf = next) {
-		next = TAILQ_NEXT(zmbuf, next);
-
-		rte_pktmbuf_free(zmbuf->mbuf);
-		TAILQ_REMOVE(&vq->zmbuf_list, zmbuf, next);
+	struct zmbuf_reclaim *reclaim;
+
+	vq->nr_zmbuf = release_zmbufs(vq->zmbufs, vq->nr_zmbuf);
+	if (vq->nr_zmbuf != 0) {
+		reclaim = rte_malloc(NULL, sizeof(*reclaim), 0);
+		if (reclaim != NULL) {
+			reclaim->zmbufs = vq->zmbufs;
+			reclaim->nr_zmbuf = vq->nr_zmbuf;
+			vq->zmbufs = NULL;
+			zmbuf_reclaim_alarm(reclaim);
+		} else {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"failed to defer the release of %u zero copy mbufs\n",
+				vq->nr_zmbuf);
+		}
 	}
+	vq->nr_zmbuf = 0;
 
 	rte_free(vq->zmbufs);
+	vq->zmbufs = NULL;
 }
 
 /*
@@ -1237,6 +2375,10 @@ vhost_user_get_vring_base(struct virtio_net **pdev,
 	dev->flags &= ~VIRTIO_DEV_READY;
 	dev->flags &= ~VIRTIO_DEV_VDPA_CONFIGURED;
 
+	/* The guest gets back the buffers of the held back used entries */
+	if (vq->used_batch != 0 && vq->access_ok)
+		vhost_flush_used_batch(dev, vq);
+
 	/* Here we are safe to get the indexes */
 	if (vq_is_packed(dev)) {
 		/*
@@ -1376,7 +2518,8 @@ vhost_user_set_log_base(struct virtio_net **pdev, struct VhostUserMsg *msg,
 {
 	struct virtio_net *dev = *pdev;
 	int fd = msg->fds[0];
-	uint64_t size, off;
+	uint64_t size, off, alignment, map_size;
+	uint32_t i;
 	void *addr;
 
 	if (fd < 0) {
@@ -1391,6 +2534,14 @@ vhost_user_set_log_base(struct virtio_net **pdev, struct VhostUserMsg *msg,
 		return VH_RESULT_ERR;
 	}
 
+	/* The secondary processes would not log their writes */
+	if (dev->mp_attached) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) dirty logging with secondary processes "
+			"attached is not supported\n", dev->vid);
+		return VH_RESULT_ERR;
+	}
+
 	size = msg->payload.log.mmap_size;
 	off  = msg->payload.log.mmap_offset;
 
@@ -1406,27 +2557,59 @@ vhost_user_set_log_base(struct virtio_net **pdev, struct VhostUserMsg *msg,
 		"log mmap size: %"PRId64", offset: %"PRId64"\n",
 		size, off);
 
+	/*
+	 * A log backed by hugepages, e.g. a hugetlbfs file, saves the TLB
+	 * misses of the scattered writes to a large bitmap. Its mapping
+	 * length must be aligned on the hugepage size, as for the memory
+	 * regions.
+	 */
+	alignment = get_blk_size(fd);
+	if (alignment == (uint64_t)-1) {
+		RTE_LOG(ERR, VHOST_CONFIG, "couldn't get log page size\n");
+		close(fd);
+		return VH_RESULT_ERR;
+	}
+	map_size = RTE_ALIGN_CEIL(size + off, alignment);
+
 	/*
 	 * mmap from 0 to workaround a hugepage mmap bug: mmap will
 	 * fail when offset is not page size aligned.
 	 */
-	addr = mmap(0, size + off, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	addr = mmap(0, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 	close(fd);
 	if (addr == MAP_FAILED) {
 		RTE_LOG(ERR, VHOST_CONFIG, "mmap log base failed!\n");
 		return VH_RESULT_ERR;
 	}
 
+#ifdef MADV_HUGEPAGE
+	/* a shmem log may still get transparent hugepages */
+	if (alignment < RTE_PGSIZE_2M &&
+			madvise(addr, map_size, MADV_HUGEPAGE) < 0)
+		RTE_LOG(DEBUG, VHOST_CONFIG,
+			"no transparent hugepages for the log: %s\n",
+			strerror(errno));
+#endif
+
+	RTE_LOG(INFO, VHOST_CONFIG, "log mapped with %"PRIu64" KB pages\n",
+		alignment >> 10);
+
 	/*
 	 * Free previously mapped log memory on occasionally
 	 * multiple VHOST_USER_SET_LOG_BASE.
 	 */
 	if (dev->log_addr) {
-		munmap((void *)(uintptr_t)dev->log_addr, dev->log_size);
+		munmap((void *)(uintptr_t)dev->log_addr, dev->log_map_size);
 	}
 	dev->log_addr = (uint64_t)(uintptr_t)addr;
 	dev->log_base = dev->log_addr + off;
 	dev->log_size = size;
+	dev->log_map_size = map_size;
+
+	/* Logging goes to the dirty log directly where this fails */
+	for (i = 0; i < dev->max_vring; i++)
+		if (dev->virtqueue[i])
+			vhost_log_cache_alloc(dev->virtqueue[i]);
 
 	/*
 	 * The spec is not clear about it (yet), but QEMU doesn't expect
@@ -1722,6 +2905,11 @@ static vhost_message_handler_t vhost_message_handlers[VHOST_USER_MAX] = {
 	[VHOST_USER_POSTCOPY_ADVISE] = vhost_user_set_postcopy_advise,
 	[VHOST_USER_POSTCOPY_LISTEN] = vhost_user_set_postcopy_listen,
 	[VHOST_USER_POSTCOPY_END] = vhost_user_postcopy_end,
+	[VHOST_USER_GET_INFLIGHT_FD] = vhost_user_get_inflight_fd,
+	[VHOST_USER_SET_INFLIGHT_FD] = vhost_user_set_inflight_fd,
+	[VHOST_USER_GET_MAX_MEM_SLOTS] = vhost_user_get_max_mem_slots,
+	[VHOST_USER_ADD_MEM_REG] = vhost_user_add_mem_reg,
+	[VHOST_USER_REM_MEM_REG] = vhost_user_rem_mem_reg,
 };
 
 
@@ -1821,7 +3009,7 @@ vhost_user_check_and_alloc_queue_pair(struct virtio_net *dev,
 		return 0;
 	}
 
-	if (vring_idx >= VHOST_MAX_VRING) {
+	if (vring_idx >= dev->max_vring) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"invalid vring index: %u\n", vring_idx);
 		return -1;
@@ -1833,7 +3021,7 @@ vhost_user_check_and_alloc_queue_pair(struct virtio_net *dev,
 	return alloc_vring_queue(dev, vring_idx);
 }
 
-static void
+void
 vhost_user_lock_all_queue_pairs(struct virtio_net *dev)
 {
 	unsigned int i = 0;
@@ -1843,14 +3031,14 @@ vhost_user_lock_all_queue_pairs(struct virtio_net *dev)
 		struct vhost_virtqueue *vq = dev->virtqueue[i];
 
 		if (vq) {
-			rte_spinlock_lock(&vq->access_lock);
+			vhost_vq_lock(dev, vq);
 			vq_num++;
 		}
 		i++;
 	}
 }
 
-static void
+void
 vhost_user_unlock_all_queue_pairs(struct virtio_net *dev)
 {
 	unsigned int i = 0;
@@ -1860,13 +3048,47 @@ vhost_user_unlock_all_queue_pairs(struct virtio_net *dev)
 		struct vhost_virtqueue *vq = dev->virtqueue[i];
 
 		if (vq) {
-			rte_spinlock_unlock(&vq->access_lock);
+			vhost_vq_unlock(dev, vq);
 			vq_num++;
 		}
 		i++;
 	}
 }
 
+static void
+vhost_user_msg_stats_update(struct virtio_net *dev, uint32_t request,
+		uint64_t start)
+{
+	struct vhost_msg_stats *stats = &dev->msg_stats[request];
+	uint64_t cycles = rte_rdtsc() - start;
+
+	RTE_BUILD_BUG_ON(VHOST_USER_MAX > VHOST_MSG_STATS_MAX);
+
+	stats->count++;
+	stats->cycles += cycles;
+	if (cycles > stats->max_cycles)
+		stats->max_cycles = cycles;
+}
+
+/* Start the device once all its vrings are set up */
+static void
+vhost_user_check_ready(struct virtio_net *dev)
+{
+	if (!(dev->flags & VIRTIO_DEV_RUNNING) && virtio_is_ready(dev)) {
+		dev->flags |= VIRTIO_DEV_READY;
+
+		if (!(dev->flags & VIRTIO_DEV_RUNNING)) {
+			if (dev->dequeue_zero_copy) {
+				RTE_LOG(INFO, VHOST_CONFIG,
+						"dequeue zero copy is enabled\n");
+			}
+
+			if (dev->notify_ops->new_device(dev->vid) == 0)
+				dev->flags |= VIRTIO_DEV_RUNNING;
+		}
+	}
+}
+
 int
 vhost_user_msg_handler(int vid, int fd)
 {
@@ -1877,6 +3099,8 @@ vhost_user_msg_handler(int vid, int fd)
 	int ret;
 	int unlock_required = 0;
 	uint32_t skip_master = 0;
+	int need_reply;
+	uint64_t start;
 	int request;
 
 	dev = get_device(vid);
@@ -1908,6 +3132,8 @@ vhost_user_msg_handler(int vid, int fd)
 		return -1;
 	}
 
+	start = rte_rdtsc();
+	request = msg.request.master;
 	ret = 0;
 	if (msg.request.master != VHOST_USER_IOTLB_MSG)
 		RTE_LOG(INFO, VHOST_CONFIG, "read message %s\n",
@@ -1929,12 +3155,13 @@ vhost_user_msg_handler(int vid, int fd)
 	 * and device is destroyed. destroy_device waits for queues to be
 	 * inactive, so it is safe. Otherwise taking the access_lock
 	 * would cause a dead lock.
+	 * The memory table messages lock the queues by themselves, only
+	 * while switching to the new table.
 	 */
 	switch (msg.request.master) {
 	case VHOST_USER_SET_FEATURES:
 	case VHOST_USER_SET_PROTOCOL_FEATURES:
 	case VHOST_USER_SET_OWNER:
-	case VHOST_USER_SET_MEM_TABLE:
 	case VHOST_USER_SET_LOG_BASE:
 	case VHOST_USER_SET_LOG_FD:
 	case VHOST_USER_SET_VRING_NUM:
@@ -2016,46 +3243,470 @@ vhost_user_msg_handler(int vid, int fd)
 	 * this optional reply-ack won't be sent as the
 	 * VHOST_USER_NEED_REPLY was cleared in send_vhost_reply().
 	 */
-	if (msg.flags & VHOST_USER_NEED_REPLY) {
+	need_reply = msg.flags & VHOST_USER_NEED_REPLY;
+	if (need_reply) {
 		msg.payload.u64 = ret == VH_RESULT_ERR;
 		msg.size = sizeof(msg.payload.u64);
 		msg.fd_num = 0;
 		send_vhost_reply(fd, &msg);
-	} else if (ret == VH_RESULT_ERR) {
+	}
+
+	vhost_user_msg_stats_update(dev, request, start);
+	VHOST_TRACE(dev->vid, 0, MSG, request);
+
+	if (!need_reply && ret == VH_RESULT_ERR) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"vhost message handling failed.\n");
 		return -1;
 	}
 
-	if (!(dev->flags & VIRTIO_DEV_RUNNING) && virtio_is_ready(dev)) {
-		dev->flags |= VIRTIO_DEV_READY;
-
-		if (!(dev->flags & VIRTIO_DEV_RUNNING)) {
-			if (dev->dequeue_zero_copy) {
-				RTE_LOG(INFO, VHOST_CONFIG,
-						"dequeue zero copy is enabled\n");
-			}
+	vhost_user_check_ready(dev);
 
-			if (dev->notify_ops->new_device(dev->vid) == 0)
-				dev->flags |= VIRTIO_DEV_RUNNING;
-		}
-	}
+	if (msg.request.master != VHOST_USER_SET_VRING_ENABLE)
+		return 0;
 
+	/* rte_vhost_attach_vdpa_device() may configure the device as well */
+	pthread_mutex_lock(&dev->vdpa_lock);
 	did = dev->vdpa_dev_id;
 	vdpa_dev = rte_vdpa_get_device(did);
 	if (vdpa_dev && virtio_is_ready(dev) &&
-			!(dev->flags & VIRTIO_DEV_VDPA_CONFIGURED) &&
-			msg.request.master == VHOST_USER_SET_VRING_ENABLE) {
+			!(dev->flags & VIRTIO_DEV_VDPA_CONFIGURED)) {
 		if (vdpa_dev->ops->dev_conf)
 			vdpa_dev->ops->dev_conf(dev->vid);
 		dev->flags |= VIRTIO_DEV_VDPA_CONFIGURED;
-		if (vhost_user_host_notifier_ctrl(dev->vid, true) != 0) {
-			RTE_LOG(INFO, VHOST_CONFIG,
-				"(%d) software relay is used for vDPA, performance may be low.\n",
-				dev->vid);
+	} else {
+		vdpa_dev = NULL;
+	}
+	pthread_mutex_unlock(&dev->vdpa_lock);
+
+	if (vdpa_dev && vhost_user_host_notifier_ctrl(dev->vid, true) != 0) {
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%d) software relay is used for vDPA, performance may be low.\n",
+			dev->vid);
+	}
+
+	return 0;
+}
+
+/*
+ * Read a state message, which may be split by a stream socket after the
+ * part carrying the fds.
+ */
+static int
+vhost_user_state_read(int sockfd, void *buf, int len, int *fds, int max_fds)
+{
+	int fd_num, ret, i;
+	ssize_t n;
+
+	ret = read_fd_message(sockfd, buf, len, fds, max_fds, &fd_num);
+	if (ret <= 0)
+		return -1;
+
+	while (ret < len) {
+		n = read(sockfd, (char *)buf + ret, len - ret);
+		if (n <= 0) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"truncated device state message\n");
+			for (i = 0; i < fd_num; i++)
+				close(fds[i]);
+			return -1;
+		}
+		ret += n;
+	}
+
+	return fd_num;
+}
+
+/* Offset of a region in its fd, as given by the master */
+static int
+vhost_user_state_mmap_offset(struct rte_vhost_mem_region *reg,
+			     uint64_t *offset)
+{
+	struct rte_memseg *ms;
+	size_t ms_offset;
+
+	if (reg->mmap_size != 0) {
+		*offset = reg->host_user_addr -
+			(uint64_t)(uintptr_t)reg->mmap_addr;
+		return 0;
+	}
+
+	/* Shared with the EAL memory, see vhost_user_share_region() */
+	ms = rte_mem_virt2memseg(reg->mmap_addr, NULL);
+	if (ms == NULL || rte_memseg_get_fd_offset(ms, &ms_offset) < 0)
+		return -1;
+	*offset = ms_offset + RTE_PTR_DIFF(reg->mmap_addr, ms->addr);
+
+	return 0;
+}
+
+static uint8_t
+vhost_user_state_fd(int fd)
+{
+	if (fd >= 0)
+		return VHOST_STATE_FD_PASSED;
+	if (fd == VIRTIO_INVALID_EVENTFD)
+		return VHOST_STATE_FD_INVALID;
+	return VHOST_STATE_FD_NONE;
+}
+
+/*
+ * Send the state of a device to sockfd, connfd being its vhost-user
+ * connection, then wait for the importer to acknowledge it. The device
+ * is left untouched, to be destroyed by the caller on success.
+ */
+int
+vhost_user_state_save(int vid, int connfd, int sockfd)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_state_dev *state;
+	struct vhost_state_vring vstate;
+	struct rte_vhost_mem_region *reg;
+	struct vhost_virtqueue *vq;
+	int fds[VHOST_STATE_MAX_FDS];
+	int nr_fds = 0;
+	int32_t status;
+	uint32_t i;
+	int ret = -1;
+
+	if (dev == NULL)
+		return -1;
+
+	if ((dev->features & ((1ULL << VHOST_F_LOG_ALL) |
+			      (1ULL << VIRTIO_F_IOMMU_PLATFORM))) ||
+	    dev->postcopy_listening || dev->inflight_addr != NULL ||
+	    dev->vdpa_dev_id != -1) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) state can't be exported with dirty logging, IOMMU, inflight tracking or vDPA\n",
+			vid);
+		return -1;
+	}
+
+	state = calloc(1, sizeof(*state));
+	if (state == NULL)
+		return -1;
+
+	state->magic = VHOST_STATE_MAGIC;
+	state->size = sizeof(*state);
+	strlcpy(state->ifname, dev->ifname, sizeof(state->ifname));
+	state->features = dev->features;
+	state->protocol_features = dev->protocol_features;
+	state->mtu = dev->mtu;
+
+	fds[nr_fds++] = connfd;
+	if (dev->slave_req_fd >= 0) {
+		state->has_slave_req_fd = 1;
+		fds[nr_fds++] = dev->slave_req_fd;
+	}
+
+	for (i = 0; dev->mem != NULL && i < dev->mem->nregions; i++) {
+		reg = &dev->mem->regions[i];
+		state->regions[i].guest_phys_addr = reg->guest_phys_addr;
+		state->regions[i].memory_size = reg->size;
+		state->regions[i].userspace_addr = reg->guest_user_addr;
+		if (vhost_user_state_mmap_offset(reg,
+				&state->regions[i].mmap_offset) < 0) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%d) failed to get the offset of region %u\n",
+				vid, i);
+			goto out;
+		}
+		fds[nr_fds++] = reg->fd;
+	}
+	state->nregions = i;
+
+	/*
+	 * The application stopped the datapath: publish the entries it
+	 * used, and interrupt the guest for the ones it may wait for.
+	 */
+	for (i = 0; i < dev->nr_vring; i++) {
+		vq = dev->virtqueue[i];
+		if (vq == NULL)
+			continue;
+
+		vhost_vq_lock(dev, vq);
+		if (vq->nr_zmbuf != 0 || vq->async_pkts_inflight_n != 0) {
+			vhost_vq_unlock(dev, vq);
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%d) vring %u has packets in flight\n",
+				vid, i);
+			goto out;
+		}
+		vhost_flush_used_batch(dev, vq);
+		if (vq->callfd >= 0)
+			eventfd_write(vq->callfd, (eventfd_t)1);
+		vhost_vq_unlock(dev, vq);
+		state->nr_vring++;
+	}
+
+	if (send_fd_message(sockfd, (char *)state, sizeof(*state),
+			    fds, nr_fds) < 0)
+		goto out;
+
+	for (i = 0; i < dev->nr_vring; i++) {
+		vq = dev->virtqueue[i];
+		if (vq == NULL)
+			continue;
+
+		memset(&vstate, 0, sizeof(vstate));
+		vstate.index = i;
+		vstate.size = vq->size;
+		vstate.addr = vq->ring_addrs;
+		vstate.last_avail_idx = vq->last_avail_idx;
+		vstate.last_used_idx = vq->last_used_idx;
+		vstate.avail_wrap_counter = vq->avail_wrap_counter;
+		vstate.used_wrap_counter = vq->used_wrap_counter;
+		vstate.enabled = vq->enabled;
+		vstate.kick = vhost_user_state_fd(vq->kickfd);
+		vstate.call = vhost_user_state_fd(vq->callfd);
+
+		nr_fds = 0;
+		if (vstate.kick == VHOST_STATE_FD_PASSED)
+			fds[nr_fds++] = vq->kickfd;
+		if (vstate.call == VHOST_STATE_FD_PASSED)
+			fds[nr_fds++] = vq->callfd;
+
+		if (send_fd_message(sockfd, (char *)&vstate, sizeof(vstate),
+				    fds, nr_fds) < 0)
+			goto out;
+	}
+
+	if (vhost_user_state_read(sockfd, &status, sizeof(status),
+				  NULL, 0) < 0 || status < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) device state import failed\n", vid);
+		goto out;
+	}
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"(%d) device state exported, new handle is %d\n",
+		vid, status);
+	ret = 0;
+out:
+	free(state);
+	return ret;
+}
+
+static int
+vhost_user_state_replay(struct virtio_net **pdev, struct VhostUserMsg *msg)
+{
+	int request = msg->request.master;
+
+	if (vhost_user_check_and_alloc_queue_pair(*pdev, msg) < 0 ||
+	    vhost_message_handlers[request](pdev, msg, -1) == VH_RESULT_ERR) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%d) replaying %s failed\n",
+			(*pdev)->vid, vhost_message_str[request]);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Take the next fd of a state message, the replayed handler owning it */
+static int
+vhost_user_state_take_fd(int *fds, int *fd_idx)
+{
+	int fd = fds[*fd_idx];
+
+	fds[(*fd_idx)++] = -1;
+	return fd;
+}
+
+static int
+vhost_user_state_load_vring(struct virtio_net **pdev,
+			    const struct vhost_state_vring *vstate, int *fds)
+{
+	struct vhost_virtqueue *vq;
+	struct VhostUserMsg msg;
+	int fd_idx = 0;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request.master = VHOST_USER_SET_VRING_NUM;
+	msg.payload.state.index = vstate->index;
+	msg.payload.state.num = vstate->size;
+	if (vhost_user_state_replay(pdev, &msg) < 0)
+		return -1;
+
+	msg.request.master = VHOST_USER_SET_VRING_BASE;
+	msg.payload.state.num = vstate->last_avail_idx;
+	if (vq_is_packed(*pdev) && vstate->avail_wrap_counter)
+		msg.payload.state.num |= 1 << 15;
+	if (vhost_user_state_replay(pdev, &msg) < 0)
+		return -1;
+
+	/* Unlike at the vring start, the used entries may lag behind */
+	vq = (*pdev)->virtqueue[vstate->index];
+	vq->last_used_idx = vstate->last_used_idx;
+	vq->used_wrap_counter = vstate->used_wrap_counter;
+
+	msg.request.master = VHOST_USER_SET_VRING_ADDR;
+	msg.payload.addr = vstate->addr;
+	if (vhost_user_state_replay(pdev, &msg) < 0)
+		return -1;
+
+	if (vstate->call != VHOST_STATE_FD_NONE) {
+		msg.request.master = VHOST_USER_SET_VRING_CALL;
+		msg.payload.u64 = vstate->index;
+		msg.fd_num = 0;
+		if (vstate->call == VHOST_STATE_FD_PASSED) {
+			msg.fds[0] = vhost_user_state_take_fd(fds, &fd_idx);
+			msg.fd_num = 1;
+		} else {
+			msg.payload.u64 |= VHOST_USER_VRING_NOFD_MASK;
+		}
+		if (vhost_user_state_replay(pdev, &msg) < 0)
+			return -1;
+	}
+
+	if (vstate->kick != VHOST_STATE_FD_NONE) {
+		msg.request.master = VHOST_USER_SET_VRING_KICK;
+		msg.payload.u64 = vstate->index;
+		msg.fd_num = 0;
+		if (vstate->kick == VHOST_STATE_FD_PASSED) {
+			msg.fds[0] = vhost_user_state_take_fd(fds, &fd_idx);
+			msg.fd_num = 1;
+		} else {
+			msg.payload.u64 |= VHOST_USER_VRING_NOFD_MASK;
+		}
+		if (vhost_user_state_replay(pdev, &msg) < 0)
+			return -1;
+	}
+
+	if ((*pdev)->features & (1ULL << VHOST_USER_F_PROTOCOL_FEATURES)) {
+		msg.request.master = VHOST_USER_SET_VRING_ENABLE;
+		msg.payload.state.index = vstate->index;
+		msg.payload.state.num = vstate->enabled;
+		if (vhost_user_state_replay(pdev, &msg) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Receive the device part of a state, fds[0] being the vhost-user
+ * connection. Returns the number of fds received.
+ */
+int
+vhost_user_state_recv(int sockfd, struct vhost_state_dev *state, int *fds)
+{
+	int fd_num, i;
+
+	fd_num = vhost_user_state_read(sockfd, state, sizeof(*state),
+				       fds, VHOST_STATE_MAX_FDS);
+	if (fd_num < 0)
+		return -1;
+
+	if (state->magic != VHOST_STATE_MAGIC ||
+	    state->size != sizeof(*state) ||
+	    state->nregions > VHOST_MEMORY_MAX_SLOTS ||
+	    fd_num != 1 + !!state->has_slave_req_fd + (int)state->nregions) {
+		RTE_LOG(ERR, VHOST_CONFIG, "invalid device state\n");
+		for (i = 0; i < fd_num; i++)
+			close(fds[i]);
+		return -1;
+	}
+	state->ifname[sizeof(state->ifname) - 1] = '\0';
+
+	return fd_num;
+}
+
+/*
+ * Restore the state of the new device vid by replaying the messages
+ * which set it up, then read its vrings from sockfd. The fds consumed
+ * are set to -1, the caller closes the others.
+ */
+int
+vhost_user_state_load(int vid, const struct vhost_state_dev *state,
+		      int *fds, int sockfd)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_state_vring vstate;
+	struct VhostUserMsg msg;
+	int vfds[2];
+	int fd_idx = 1;
+	uint32_t i, n;
+	int fd_num, ret;
+
+	if (dev == NULL)
+		return -1;
+
+	dev->notify_ops = vhost_driver_callback_get(dev->ifname);
+	if (dev->notify_ops == NULL)
+		return -1;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request.master = VHOST_USER_SET_FEATURES;
+	msg.payload.u64 = state->features;
+	if (vhost_user_state_replay(&dev, &msg) < 0)
+		return -1;
+
+	if (state->features & (1ULL << VHOST_USER_F_PROTOCOL_FEATURES)) {
+		msg.request.master = VHOST_USER_SET_PROTOCOL_FEATURES;
+		msg.payload.u64 = state->protocol_features;
+		if (vhost_user_state_replay(&dev, &msg) < 0)
+			return -1;
+	}
+
+	if (state->has_slave_req_fd) {
+		msg.request.master = VHOST_USER_SET_SLAVE_REQ_FD;
+		msg.fds[0] = vhost_user_state_take_fd(fds, &fd_idx);
+		msg.fd_num = 1;
+		if (vhost_user_state_replay(&dev, &msg) < 0)
+			return -1;
+	}
+
+	/* The table holds the first regions, the others are added */
+	n = RTE_MIN(state->nregions, (uint32_t)VHOST_MEMORY_MAX_NREGIONS);
+	if (n > 0) {
+		memset(&msg, 0, sizeof(msg));
+		msg.request.master = VHOST_USER_SET_MEM_TABLE;
+		msg.payload.memory.nregions = n;
+		for (i = 0; i < n; i++) {
+			msg.payload.memory.regions[i] = state->regions[i];
+			msg.fds[i] = vhost_user_state_take_fd(fds, &fd_idx);
+		}
+		msg.fd_num = n;
+		if (vhost_user_state_replay(&dev, &msg) < 0)
+			return -1;
+	}
+	for (i = n; i < state->nregions; i++) {
+		memset(&msg, 0, sizeof(msg));
+		msg.request.master = VHOST_USER_ADD_MEM_REG;
+		msg.payload.memory_single.region = state->regions[i];
+		msg.fds[0] = vhost_user_state_take_fd(fds, &fd_idx);
+		msg.fd_num = 1;
+		if (vhost_user_state_replay(&dev, &msg) < 0)
+			return -1;
+	}
+
+	dev->mtu = state->mtu;
+
+	for (n = 0; n < state->nr_vring; n++) {
+		fd_num = vhost_user_state_read(sockfd, &vstate,
+					       sizeof(vstate), vfds, 2);
+		if (fd_num < 0)
+			return -1;
+
+		if (fd_num != (vstate.kick == VHOST_STATE_FD_PASSED) +
+			      (vstate.call == VHOST_STATE_FD_PASSED)) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%d) invalid vring state\n", vid);
+			ret = -1;
+		} else {
+			ret = vhost_user_state_load_vring(&dev, &vstate,
+							  vfds);
 		}
+		for (i = 0; i < 2; i++)
+			if (vfds[i] >= 0)
+				close(vfds[i]);
+		if (ret < 0)
+			return -1;
 	}
 
+	vhost_user_check_ready(dev);
+
 	return 0;
 }
 
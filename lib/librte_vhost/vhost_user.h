@@ -6,6 +6,7 @@
 #define _VHOST_NET_USER_H
 
 #include <stdint.h>
+#include <limits.h>
 #include <linux/vhost.h>
 
 #include "rte_vhost.h"
@@ -13,6 +14,13 @@
 /* refer to hw/virtio/vhost-user.c */
 
 #define VHOST_MEMORY_MAX_NREGIONS 8
+/* Regions that can be added one by one with VHOST_USER_ADD_MEM_REG */
+#define VHOST_MEMORY_MAX_SLOTS 32
+
+/* Size of a memory table holding the largest number of regions */
+#define VHOST_MEM_TABLE_SIZE (sizeof(struct rte_vhost_memory) + \
+	sizeof(struct rte_vhost_mem_region) * \
+	RTE_MAX(VHOST_MEMORY_MAX_NREGIONS, VHOST_MEMORY_MAX_SLOTS))
 
 #define VHOST_USER_PROTOCOL_FEATURES	((1ULL << VHOST_USER_PROTOCOL_F_MQ) | \
 					 (1ULL << VHOST_USER_PROTOCOL_F_LOG_SHMFD) |\
@@ -23,7 +31,9 @@
 					 (1ULL << VHOST_USER_PROTOCOL_F_CRYPTO_SESSION) | \
 					 (1ULL << VHOST_USER_PROTOCOL_F_SLAVE_SEND_FD) | \
 					 (1ULL << VHOST_USER_PROTOCOL_F_HOST_NOTIFIER) | \
-					 (1ULL << VHOST_USER_PROTOCOL_F_PAGEFAULT))
+					 (1ULL << VHOST_USER_PROTOCOL_F_PAGEFAULT) | \
+					 (1ULL << VHOST_USER_PROTOCOL_F_INFLIGHT_SHMFD) | \
+					 (1ULL << VHOST_USER_PROTOCOL_F_CONFIGURE_MEM_SLOTS))
 
 typedef enum VhostUserRequest {
 	VHOST_USER_NONE = 0,
@@ -54,7 +64,12 @@ typedef enum VhostUserRequest {
 	VHOST_USER_POSTCOPY_ADVISE = 28,
 	VHOST_USER_POSTCOPY_LISTEN = 29,
 	VHOST_USER_POSTCOPY_END = 30,
-	VHOST_USER_MAX = 31
+	VHOST_USER_GET_INFLIGHT_FD = 31,
+	VHOST_USER_SET_INFLIGHT_FD = 32,
+	VHOST_USER_GET_MAX_MEM_SLOTS = 36,
+	VHOST_USER_ADD_MEM_REG = 37,
+	VHOST_USER_REM_MEM_REG = 38,
+	VHOST_USER_MAX = 39
 } VhostUserRequest;
 
 typedef enum VhostUserSlaveRequest {
@@ -77,6 +92,18 @@ typedef struct VhostUserMemory {
 	VhostUserMemoryRegion regions[VHOST_MEMORY_MAX_NREGIONS];
 } VhostUserMemory;
 
+typedef struct VhostUserInflight {
+	uint64_t mmap_size;
+	uint64_t mmap_offset;
+	uint16_t num_queues;
+	uint16_t queue_size;
+} VhostUserInflight;
+
+typedef struct VhostUserMemRegMsg {
+	uint64_t padding;
+	VhostUserMemoryRegion region;
+} VhostUserMemRegMsg;
+
 typedef struct VhostUserLog {
 	uint64_t mmap_size;
 	uint64_t mmap_offset;
@@ -130,10 +157,12 @@ typedef struct VhostUserMsg {
 		struct vhost_vring_state state;
 		struct vhost_vring_addr addr;
 		VhostUserMemory memory;
+		VhostUserMemRegMsg memory_single;
 		VhostUserLog    log;
 		struct vhost_iotlb_msg iotlb;
 		VhostUserCryptoSessionParam crypto_session;
 		VhostUserVringArea area;
+		VhostUserInflight inflight;
 	} payload;
 	int fds[VHOST_MEMORY_MAX_NREGIONS];
 	int fd_num;
@@ -144,9 +173,53 @@ typedef struct VhostUserMsg {
 /* The version of the protocol we support */
 #define VHOST_USER_VERSION    0x1
 
+/*
+ * Device state handed over to another process by rte_vhost_state_export().
+ * The device message carries the fds of the vhost-user connection, of the
+ * slave channel if any and of the memory regions, then one message per
+ * vring carries its kick and call fds. The importer answers with its
+ * vid, or -1 on failure.
+ */
+#define VHOST_STATE_MAGIC 0x76687374 /* "vhst" */
+#define VHOST_STATE_MAX_FDS (2 + VHOST_MEMORY_MAX_SLOTS)
+
+struct vhost_state_dev {
+	uint32_t magic;
+	uint32_t size;
+	char ifname[PATH_MAX];
+	uint64_t features;
+	uint64_t protocol_features;
+	uint16_t mtu;
+	uint8_t has_slave_req_fd;
+	uint32_t nr_vring;	/* Vring messages following */
+	uint32_t nregions;
+	VhostUserMemoryRegion regions[VHOST_MEMORY_MAX_SLOTS];
+};
+
+/* Whether a vring fd was never set, passed along or set to none */
+#define VHOST_STATE_FD_NONE	0
+#define VHOST_STATE_FD_PASSED	1
+#define VHOST_STATE_FD_INVALID	2
+
+struct vhost_state_vring {
+	uint32_t index;
+	uint32_t size;
+	struct vhost_vring_addr addr;
+	uint16_t last_avail_idx;
+	uint16_t last_used_idx;
+	uint8_t avail_wrap_counter;
+	uint8_t used_wrap_counter;
+	uint8_t enabled;
+	uint8_t kick;
+	uint8_t call;
+};
 
 /* vhost_user.c */
 int vhost_user_msg_handler(int vid, int fd);
+int vhost_user_state_save(int vid, int connfd, int sockfd);
+int vhost_user_state_recv(int sockfd, struct vhost_state_dev *state, int *fds);
+int vhost_user_state_load(int vid, const struct vhost_state_dev *state,
+		int *fds, int sockfd);
 int vhost_user_iotlb_miss(struct virtio_net *dev, uint64_t iova, uint8_t perm);
 int vhost_user_host_notifier_ctrl(int vid, bool enable);
 
@@ -10,6 +10,7 @@
 #include <rte_memcpy.h>
 #include <rte_ether.h>
 #include <rte_ip.h>
+#include <rte_net_cksum.h>
 #include <rte_vhost.h>
 #include <rte_tcp.h>
 #include <rte_udp.h>
@@ -25,18 +26,89 @@
 
 #define MAX_BATCH_LEN 256
 
+/* Packets of a batch fast path, a cache line of packed descriptors. */
+#define VHOST_BATCH_SIZE \
+	(RTE_CACHE_LINE_SIZE / sizeof(struct vring_packed_desc))
+#define VHOST_BATCH_MASK (VHOST_BATCH_SIZE - 1)
+
+/* Packets ahead of the one whose offloads are handled to prefetch. */
+#define VHOST_HDR_PREFETCH_OFFSET 4
+
+/* Tx offloads to report in the virtio-net header on enqueue. */
+#define VHOST_ENQUEUE_OFFLOAD_MASK (PKT_TX_L4_MASK | PKT_TX_TCP_SEG | \
+		PKT_TX_UDP_SEG | PKT_TX_IP_CKSUM)
+
 static  __rte_always_inline bool
 rxvq_is_mergeable(struct virtio_net *dev)
 {
 	return dev->features & (1ULL << VIRTIO_NET_F_MRG_RXBUF);
 }
 
+static inline bool
+virtio_net_with_host_offload(struct virtio_net *dev)
+{
+	if (dev->features &
+			((1ULL << VIRTIO_NET_F_CSUM) |
+			 (1ULL << VIRTIO_NET_F_HOST_ECN) |
+			 (1ULL << VIRTIO_NET_F_HOST_TSO4) |
+			 (1ULL << VIRTIO_NET_F_HOST_TSO6) |
+			 (1ULL << VIRTIO_NET_F_HOST_UFO)))
+		return true;
+
+	return false;
+}
+
+/*
+ * Device state the datapath branches on. The burst functions take it as
+ * a dp argument, a constant in the specialized variants so that the
+ * compiler drops the checks of the features they do not handle, or read
+ * from the device by vhost_dp_flags() in the generic variants.
+ */
+#define VHOST_DP_PACKED		(1U << 0)
+#define VHOST_DP_MRG_RXBUF	(1U << 1)
+#define VHOST_DP_HOST_OFFLOAD	(1U << 2)
+#define VHOST_DP_ZCOPY		(1U << 3)
+#define VHOST_DP_IOMMU		(1U << 4)
+#define VHOST_DP_LOG		(1U << 5)
+
+/* Index of a variant in the tables, 0 is the generic one */
+#define VHOST_DP_GENERIC	0
+#define VHOST_DP_VARIANT(dp)	(1 + (dp))
+
+static __rte_always_inline uint32_t
+vhost_dp_flags(struct virtio_net *dev)
+{
+	uint32_t dp = 0;
+
+	if (vq_is_packed(dev))
+		dp |= VHOST_DP_PACKED;
+	if (rxvq_is_mergeable(dev))
+		dp |= VHOST_DP_MRG_RXBUF;
+	if (virtio_net_with_host_offload(dev))
+		dp |= VHOST_DP_HOST_OFFLOAD;
+	if (dev->dequeue_zero_copy)
+		dp |= VHOST_DP_ZCOPY;
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+		dp |= VHOST_DP_IOMMU;
+	if (dev->features & (1ULL << VHOST_F_LOG_ALL))
+		dp |= VHOST_DP_LOG;
+
+	return dp;
+}
+
 static bool
 is_valid_virt_queue_idx(uint32_t idx, int is_tx, uint32_t nr_vring)
 {
 	return (is_tx ^ (idx & 1)) == 0 && idx < nr_vring;
 }
 
+static __rte_always_inline void
+free_ind_table(struct vhost_virtqueue *vq, void *idesc)
+{
+	if (unlikely(idesc != vq->ind_table))
+		rte_free(idesc);
+}
+
 static __rte_always_inline void *
 alloc_copy_ind_table(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		uint64_t desc_addr, uint64_t desc_len)
@@ -45,7 +117,23 @@ alloc_copy_ind_table(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	uint64_t src, dst;
 	uint64_t len, remain = desc_len;
 
-	idesc = rte_malloc(__func__, desc_len, 0);
+	/*
+	 * A table cannot chain more descriptors than the ring size: it is
+	 * copied into the scratch table of the vq, allocated once. Bigger
+	 * ones get an allocation of their own.
+	 */
+	if (likely(desc_len <= vq->ind_table_size)) {
+		idesc = vq->ind_table;
+	} else if (desc_len <= vq->size * sizeof(struct vring_desc)) {
+		rte_free(vq->ind_table);
+		vq->ind_table_size = vq->size * sizeof(struct vring_desc);
+		vq->ind_table = rte_malloc(__func__, vq->ind_table_size, 0);
+		if (unlikely(!vq->ind_table))
+			vq->ind_table_size = 0;
+		idesc = vq->ind_table;
+	} else {
+		idesc = rte_malloc(__func__, desc_len, 0);
+	}
 	if (unlikely(!idesc))
 		return 0;
 
@@ -56,7 +144,7 @@ alloc_copy_ind_table(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		src = vhost_iova_to_vva(dev, vq, desc_addr, &len,
 				VHOST_ACCESS_RO);
 		if (unlikely(!src || !len)) {
-			rte_free(idesc);
+			free_ind_table(vq, idesc);
 			return 0;
 		}
 
@@ -70,54 +158,82 @@ alloc_copy_ind_table(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	return idesc;
 }
 
-static __rte_always_inline void
-free_ind_table(void *idesc)
-{
-	rte_free(idesc);
-}
-
 static __rte_always_inline void
 do_flush_shadow_used_ring_split(struct virtio_net *dev,
 			struct vhost_virtqueue *vq,
-			uint16_t to, uint16_t from, uint16_t size)
+			uint16_t to, uint16_t from, uint16_t size,
+			const uint32_t dp)
 {
 	rte_memcpy(&vq->used->ring[to],
 			&vq->shadow_used_split[from],
 			size * sizeof(struct vring_used_elem));
-	vhost_log_cache_used_vring(dev, vq,
-			offsetof(struct vring_used, ring[to]),
-			size * sizeof(struct vring_used_elem));
+	if (dp & VHOST_DP_LOG)
+		vhost_log_cache_used_vring(dev, vq,
+				offsetof(struct vring_used, ring[to]),
+				size * sizeof(struct vring_used_elem));
 }
 
 static __rte_always_inline void
-flush_shadow_used_ring_split(struct virtio_net *dev, struct vhost_virtqueue *vq)
+flush_shadow_used_ring_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+			const uint32_t dp)
 {
 	uint16_t used_idx = vq->last_used_idx & (vq->size - 1);
 
 	if (used_idx + vq->shadow_used_idx <= vq->size) {
 		do_flush_shadow_used_ring_split(dev, vq, used_idx, 0,
-					  vq->shadow_used_idx);
+					  vq->shadow_used_idx, dp);
 	} else {
 		uint16_t size;
 
 		/* update used ring interval [used_idx, vq->size] */
 		size = vq->size - used_idx;
-		do_flush_shadow_used_ring_split(dev, vq, used_idx, 0, size);
+		do_flush_shadow_used_ring_split(dev, vq, used_idx, 0, size,
+					  dp);
 
 		/* update the left half used ring interval [0, left_size] */
 		do_flush_shadow_used_ring_split(dev, vq, 0, size,
-					  vq->shadow_used_idx - size);
+					  vq->shadow_used_idx - size, dp);
 	}
 	vq->last_used_idx += vq->shadow_used_idx;
 
 	rte_smp_wmb();
 
-	vhost_log_cache_sync(dev, vq);
+	if (dp & VHOST_DP_LOG)
+		vhost_log_cache_sync(dev, vq);
 
 	*(volatile uint16_t *)&vq->used->idx += vq->shadow_used_idx;
+
+	if (unlikely(vq->inflight_split != NULL)) {
+		struct inflight_info_split *inflight = vq->inflight_split;
+		uint16_t i;
+
+		for (i = 0; i < vq->shadow_used_idx; i++)
+			inflight->desc[vq->shadow_used_split[i].id].inflight = 0;
+		rte_smp_wmb();
+		inflight->used_idx = vq->used->idx;
+	}
+
 	vq->shadow_used_idx = 0;
-	vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
-		sizeof(vq->used->idx));
+	if (dp & VHOST_DP_LOG)
+		vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
+			sizeof(vq->used->idx));
+}
+
+/*
+ * Record a descriptor chain the master must not reclaim, in the memory
+ * it keeps across the backend restarts.
+ */
+static __rte_always_inline void
+vhost_inflight_set_split(struct vhost_virtqueue *vq, uint16_t desc_idx)
+{
+	struct inflight_info_split *inflight = vq->inflight_split;
+
+	if (likely(inflight == NULL))
+		return;
+
+	inflight->desc[desc_idx].counter = vq->inflight_counter++;
+	inflight->desc[desc_idx].inflight = 1;
+	inflight->last_inflight_io = desc_idx;
 }
 
 static __rte_always_inline void
@@ -132,7 +248,7 @@ update_shadow_used_ring_split(struct vhost_virtqueue *vq,
 
 static __rte_always_inline void
 flush_shadow_used_ring_packed(struct virtio_net *dev,
-			struct vhost_virtqueue *vq)
+			struct vhost_virtqueue *vq, const uint32_t dp)
 {
 	int i;
 	uint16_t used_idx = vq->last_used_idx;
@@ -167,7 +283,8 @@ flush_shadow_used_ring_packed(struct virtio_net *dev,
 
 		vq->desc_packed[vq->last_used_idx].flags = flags;
 
-		vhost_log_cache_used_vring(dev, vq,
+		if (dp & VHOST_DP_LOG)
+			vhost_log_cache_used_vring(dev, vq,
 					vq->last_used_idx *
 					sizeof(struct vring_packed_desc),
 					sizeof(struct vring_packed_desc));
@@ -181,7 +298,8 @@ flush_shadow_used_ring_packed(struct virtio_net *dev,
 
 	rte_smp_wmb();
 	vq->shadow_used_idx = 0;
-	vhost_log_cache_sync(dev, vq);
+	if (dp & VHOST_DP_LOG)
+		vhost_log_cache_sync(dev, vq);
 }
 
 static __rte_always_inline void
@@ -195,17 +313,47 @@ update_shadow_used_ring_packed(struct vhost_virtqueue *vq,
 	vq->shadow_used_packed[i].count = count;
 }
 
-static inline void
-do_data_copy_enqueue(struct virtio_net *dev, struct vhost_virtqueue *vq)
+/*
+ * Copy to the guest, with non-temporal stores for the large copies if the
+ * device asks for them.
+ */
+static __rte_always_inline void
+vhost_copy_to_guest(struct virtio_net *dev, void *dst, const void *src,
+	uint32_t len)
+{
+	if (dev->nt_copy)
+		rte_memcpy_nt(dst, src, len);
+	else
+		rte_memcpy(dst, src, len);
+}
+
+/*
+ * The batched copies are short, their sources are prefetched a few
+ * elements ahead so that the loads of the next copies overlap the current
+ * one.
+ */
+#define VHOST_COPY_PREFETCH 2
+
+static __rte_always_inline void
+do_data_copy_enqueue(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	const uint32_t dp)
 {
 	struct batch_copy_elem *elem = vq->batch_copy_elems;
 	uint16_t count = vq->batch_copy_nb_elems;
 	int i;
 
+	for (i = 0; i < count && i < VHOST_COPY_PREFETCH; i++)
+		rte_prefetch0(elem[i].src);
+
 	for (i = 0; i < count; i++) {
+		if (i + VHOST_COPY_PREFETCH < count)
+			rte_prefetch0(elem[i + VHOST_COPY_PREFETCH].src);
 		rte_memcpy(elem[i].dst, elem[i].src, elem[i].len);
-		vhost_log_cache_write(dev, vq, elem[i].log_addr, elem[i].len);
+		if (dp & VHOST_DP_LOG)
+			vhost_log_cache_write(dev, vq, elem[i].log_addr,
+					elem[i].len);
 		PRINT_PACKET(dev, (uintptr_t)elem[i].dst, elem[i].len, 0);
+		vq->stats.batch_copy_bytes += elem[i].len;
 	}
 
 	vq->batch_copy_nb_elems = 0;
@@ -218,18 +366,179 @@ do_data_copy_dequeue(struct vhost_virtqueue *vq)
 	uint16_t count = vq->batch_copy_nb_elems;
 	int i;
 
-	for (i = 0; i < count; i++)
+	for (i = 0; i < count && i < VHOST_COPY_PREFETCH; i++)
+		rte_prefetch0(elem[i].src);
+
+	for (i = 0; i < count; i++) {
+		if (i + VHOST_COPY_PREFETCH < count)
+			rte_prefetch0(elem[i + VHOST_COPY_PREFETCH].src);
 		rte_memcpy(elem[i].dst, elem[i].src, elem[i].len);
+		vq->stats.batch_copy_bytes += elem[i].len;
+	}
 
 	vq->batch_copy_nb_elems = 0;
 }
 
+/*
+ * Account a burst of nb_pkts packets in the statistics of the virtqueue,
+ * empty tells whether it ran out of available descriptors.
+ */
+static __rte_always_inline void
+vhost_vring_stats_burst(struct vhost_virtqueue *vq, struct rte_mbuf **pkts,
+	uint32_t nb_pkts, bool empty)
+{
+	struct vhost_vring_stats *stats = &vq->stats;
+	uint32_t i;
+
+	if (empty)
+		stats->empty_polls++;
+	if (nb_pkts == 0)
+		return;
+
+	stats->packets += nb_pkts;
+	for (i = 0; i < nb_pkts; i++)
+		stats->bytes += pkts[i]->pkt_len;
+	stats->burst_hist[vhost_stats_bucket(nb_pkts)]++;
+}
+
+/*
+ * Every VHOST_BURST_TUNE_PERIOD calls, the burst size is halved when the
+ * bursts take longer than the latency bound, stepped back when its last
+ * growth made the packets cost more cycles, doubled when three quarters of
+ * the bursts were full, and halved when they carried less than a quarter
+ * of it on average.
+ */
+static __rte_noinline void
+vhost_burst_tune_step(struct vhost_burst_tune *t)
+{
+	uint16_t burst = t->burst;
+	uint64_t cpp;
+
+	if (t->pkts == 0)
+		goto out;
+
+	cpp = t->cycles / t->pkts;
+	if (t->max_cycles && t->cycles / t->busy_calls > t->max_cycles) {
+		burst /= 2;
+		t->hold = VHOST_BURST_TUNE_HOLD;
+	} else if (t->prev_burst && cpp > t->prev_cpp + t->prev_cpp / 16) {
+		burst = t->prev_burst;
+		t->hold = VHOST_BURST_TUNE_HOLD;
+	} else if (t->full_calls * 4 >= t->busy_calls * 3) {
+		if (t->hold == 0 && burst < t->max_burst) {
+			t->prev_burst = burst;
+			t->prev_cpp = cpp;
+			t->burst = RTE_MIN(burst * 2, t->max_burst);
+			goto out;
+		}
+	} else if (t->pkts * 4 < (uint64_t)t->busy_calls * burst) {
+		burst /= 2;
+	}
+
+	t->prev_burst = 0;
+	t->burst = RTE_MAX(burst, t->min_burst);
+out:
+	if (t->hold)
+		t->hold--;
+	t->calls = 0;
+	t->busy_calls = 0;
+	t->full_calls = 0;
+	t->pkts = 0;
+	t->cycles = 0;
+}
+
+static __rte_always_inline uint64_t
+vhost_burst_tune_begin(struct vhost_virtqueue *vq)
+{
+	return likely(vq->burst_tune.max_burst == 0) ? 0 : rte_rdtsc();
+}
+
+/*
+ * Account a call which moved nb_pkts packets from tsc on, full telling
+ * whether the vring or the caller had more to give.
+ */
+static __rte_always_inline void
+vhost_burst_tune_end(struct vhost_virtqueue *vq, uint64_t tsc,
+	uint32_t nb_pkts, bool full)
+{
+	struct vhost_burst_tune *t = &vq->burst_tune;
+
+	if (likely(t->max_burst == 0))
+		return;
+
+	if (nb_pkts) {
+		t->busy_calls++;
+		t->full_calls += full;
+		t->pkts += nb_pkts;
+		t->cycles += rte_rdtsc() - tsc;
+	}
+	if (++t->calls == VHOST_BURST_TUNE_PERIOD)
+		vhost_burst_tune_step(t);
+}
+
+/*
+ * Trim an enqueue burst to the budget of the virtqueue, the packet
+ * crossing it being kept.
+ */
+static __rte_always_inline uint32_t
+vhost_budget_trim(struct vhost_virtqueue *vq, struct rte_mbuf **pkts,
+	uint32_t count)
+{
+	uint64_t bytes = 0;
+	uint32_t i;
+
+	if (likely(vq->budget_bytes == 0))
+		return count;
+
+	for (i = 0; i + 1 < count; i++) {
+		bytes += pkts[i]->pkt_len;
+		if (bytes >= vq->budget_bytes) {
+			vq->stats.budget_hits++;
+			return i + 1;
+		}
+	}
+
+	return count;
+}
+
+/* Bytes of dequeued packets counted against the budget of the virtqueue */
+static __rte_always_inline uint64_t
+vhost_budget_count(struct vhost_virtqueue *vq, struct rte_mbuf **pkts,
+	uint32_t nb_pkts)
+{
+	uint64_t bytes = 0;
+	uint32_t i;
+
+	if (likely(vq->budget_bytes == 0))
+		return 0;
+
+	for (i = 0; i < nb_pkts; i++)
+		bytes += pkts[i]->pkt_len;
+
+	return bytes;
+}
+
+/* Tell whether a dequeue burst has to stop, having spent the budget */
+static __rte_always_inline bool
+vhost_budget_spent(struct vhost_virtqueue *vq, uint64_t bytes)
+{
+	if (likely(vq->budget_bytes == 0) || bytes < vq->budget_bytes)
+		return false;
+
+	vq->stats.budget_hits++;
+	return true;
+}
+
 /* avoid write operation when necessary, to lessen cache issues */
 #define ASSIGN_UNLESS_EQUAL(var, val) do {	\
 	if ((var) != (val))			\
 		(var) = (val);			\
 } while (0)
 
+/*
+ * Fill the virtio-net header of a packet to enqueue, all of its fields
+ * are written.
+ */
 static __rte_always_inline void
 virtio_enqueue_offload(struct rte_mbuf *m_buf, struct virtio_net_hdr *net_hdr)
 {
@@ -257,9 +566,9 @@ virtio_enqueue_offload(struct rte_mbuf *m_buf, struct virtio_net_hdr *net_hdr)
 			break;
 		}
 	} else {
-		ASSIGN_UNLESS_EQUAL(net_hdr->csum_start, 0);
-		ASSIGN_UNLESS_EQUAL(net_hdr->csum_offset, 0);
-		ASSIGN_UNLESS_EQUAL(net_hdr->flags, 0);
+		net_hdr->flags = 0;
+		net_hdr->csum_start = 0;
+		net_hdr->csum_offset = 0;
 	}
 
 	/* IP cksum verification cannot be bypassed, then calculate here */
@@ -268,6 +577,8 @@ virtio_enqueue_offload(struct rte_mbuf *m_buf, struct virtio_net_hdr *net_hdr)
 
 		ipv4_hdr = rte_pktmbuf_mtod_offset(m_buf, struct ipv4_hdr *,
 						   m_buf->l2_len);
+		/* the packet may be retried if it's not enqueued */
+		ipv4_hdr->hdr_checksum = 0;
 		ipv4_hdr->hdr_checksum = rte_ipv4_cksum(ipv4_hdr);
 	}
 
@@ -285,9 +596,45 @@ virtio_enqueue_offload(struct rte_mbuf *m_buf, struct virtio_net_hdr *net_hdr)
 		net_hdr->hdr_len = m_buf->l2_len + m_buf->l3_len +
 			m_buf->l4_len;
 	} else {
-		ASSIGN_UNLESS_EQUAL(net_hdr->gso_type, 0);
-		ASSIGN_UNLESS_EQUAL(net_hdr->gso_size, 0);
-		ASSIGN_UNLESS_EQUAL(net_hdr->hdr_len, 0);
+		net_hdr->gso_type = 0;
+		net_hdr->gso_size = 0;
+		net_hdr->hdr_len = 0;
+	}
+}
+
+/*
+ * Fill the virtio-net headers of a burst before its copies, so that the
+ * copy loops only store them. The IP checksum is the only offload which
+ * reads the packet, its header is prefetched a few packets ahead.
+ */
+static __rte_always_inline void
+virtio_enqueue_prefetch_hdr(struct rte_mbuf *m)
+{
+	if (m != NULL && (m->ol_flags & PKT_TX_IP_CKSUM))
+		rte_prefetch0(rte_pktmbuf_mtod_offset(m, void *, m->l2_len));
+}
+
+static __rte_always_inline void
+virtio_enqueue_offload_burst(struct rte_mbuf **pkts, uint32_t count,
+	struct virtio_net_hdr *hdrs)
+{
+	struct rte_mbuf *m;
+	uint32_t i;
+
+	for (i = 0; i < VHOST_HDR_PREFETCH_OFFSET && i < count; i++)
+		virtio_enqueue_prefetch_hdr(pkts[i]);
+
+	for (i = 0; i < count; i++) {
+		if (i + VHOST_HDR_PREFETCH_OFFSET < count)
+			virtio_enqueue_prefetch_hdr(
+				pkts[i + VHOST_HDR_PREFETCH_OFFSET]);
+
+		m = pkts[i];
+		if (likely(m == NULL ||
+				!(m->ol_flags & VHOST_ENQUEUE_OFFLOAD_MASK)))
+			memset(&hdrs[i], 0, sizeof(hdrs[i]));
+		else
+			virtio_enqueue_offload(m, &hdrs[i]);
 	}
 }
 
@@ -326,14 +673,14 @@ map_one_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 }
 
 static __rte_always_inline int
-fill_vec_buf_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
-			 uint32_t avail_idx, uint16_t *vec_idx,
+fill_vec_buf_split_head(struct virtio_net *dev, struct vhost_virtqueue *vq,
+			 uint16_t idx, uint16_t *vec_idx,
 			 struct buf_vector *buf_vec, uint16_t *desc_chain_head,
 			 uint32_t *desc_chain_len, uint8_t perm)
 {
-	uint16_t idx = vq->avail->ring[avail_idx & (vq->size - 1)];
 	uint16_t vec_id = *vec_idx;
 	uint32_t len    = 0;
+	uint32_t nr_descs = 0;
 	uint64_t dlen;
 	struct vring_desc *descs = vq->desc;
 	struct vring_desc *idesc = NULL;
@@ -367,16 +714,22 @@ fill_vec_buf_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 	while (1) {
 		if (unlikely(idx >= vq->size)) {
-			free_ind_table(idesc);
+			free_ind_table(vq, idesc);
 			return -1;
 		}
 
 		len += descs[idx].len;
+		nr_descs++;
+
+		/* Hide the miss on the next link behind the translation. */
+		if ((descs[idx].flags & VRING_DESC_F_NEXT) &&
+				likely(descs[idx].next < vq->size))
+			rte_prefetch0(&descs[descs[idx].next]);
 
 		if (unlikely(map_one_desc(dev, vq, buf_vec, &vec_id,
 						descs[idx].addr, descs[idx].len,
 						perm))) {
-			free_ind_table(idesc);
+			free_ind_table(vq, idesc);
 			return -1;
 		}
 
@@ -388,21 +741,34 @@ fill_vec_buf_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 	*desc_chain_len = len;
 	*vec_idx = vec_id;
+	vq->stats.chain_hist[vhost_stats_bucket(nr_descs)]++;
 
 	if (unlikely(!!idesc))
-		free_ind_table(idesc);
+		free_ind_table(vq, idesc);
 
 	return 0;
 }
 
+static __rte_always_inline int
+fill_vec_buf_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+			 uint32_t avail_idx, uint16_t *vec_idx,
+			 struct buf_vector *buf_vec, uint16_t *desc_chain_head,
+			 uint32_t *desc_chain_len, uint8_t perm)
+{
+	return fill_vec_buf_split_head(dev, vq,
+			vq->avail->ring[avail_idx & (vq->size - 1)],
+			vec_idx, buf_vec, desc_chain_head, desc_chain_len,
+			perm);
+}
+
 /*
  * Returns -1 on fail, 0 on success
  */
-static inline int
+static __rte_always_inline int
 reserve_avail_buf_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 				uint32_t size, struct buf_vector *buf_vec,
 				uint16_t *num_buffers, uint16_t avail_head,
-				uint16_t *nr_vec)
+				uint16_t *nr_vec, const uint32_t dp)
 {
 	uint16_t cur_idx;
 	uint16_t vec_idx = 0;
@@ -414,7 +780,7 @@ reserve_avail_buf_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	*num_buffers = 0;
 	cur_idx  = vq->last_avail_idx;
 
-	if (rxvq_is_mergeable(dev))
+	if (dp & VHOST_DP_MRG_RXBUF)
 		max_tries = vq->size - 1;
 	else
 		max_tries = 1;
@@ -480,26 +846,28 @@ fill_vec_buf_packed_indirect(struct virtio_net *dev,
 
 	nr_descs =  desc->len / sizeof(struct vring_packed_desc);
 	if (unlikely(nr_descs >= vq->size)) {
-		free_ind_table(idescs);
+		free_ind_table(vq, idescs);
 		return -1;
 	}
 
 	for (i = 0; i < nr_descs; i++) {
 		if (unlikely(vec_id >= BUF_VECTOR_MAX)) {
-			free_ind_table(idescs);
+			free_ind_table(vq, idescs);
 			return -1;
 		}
 
 		*len += descs[i].len;
 		if (unlikely(map_one_desc(dev, vq, buf_vec, &vec_id,
 						descs[i].addr, descs[i].len,
-						perm)))
+						perm))) {
+			free_ind_table(vq, idescs);
 			return -1;
+		}
 	}
 	*vec_idx = vec_id;
 
 	if (unlikely(!!idescs))
-		free_ind_table(idescs);
+		free_ind_table(vq, idescs);
 
 	return 0;
 }
@@ -556,6 +924,7 @@ fill_vec_buf_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	}
 
 	*vec_idx = vec_id;
+	vq->stats.chain_hist[vhost_stats_bucket(*desc_count)]++;
 
 	return 0;
 }
@@ -563,11 +932,11 @@ fill_vec_buf_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 /*
  * Returns -1 on fail, 0 on success
  */
-static inline int
+static __rte_always_inline int
 reserve_avail_buf_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 				uint32_t size, struct buf_vector *buf_vec,
 				uint16_t *nr_vec, uint16_t *num_buffers,
-				uint16_t *nr_descs)
+				uint16_t *nr_descs, const uint32_t dp)
 {
 	uint16_t avail_idx;
 	uint16_t vec_idx = 0;
@@ -580,7 +949,7 @@ reserve_avail_buf_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	*num_buffers = 0;
 	avail_idx = vq->last_avail_idx;
 
-	if (rxvq_is_mergeable(dev))
+	if (dp & VHOST_DP_MRG_RXBUF)
 		max_tries = vq->size - 1;
 	else
 		max_tries = 1;
@@ -618,10 +987,18 @@ reserve_avail_buf_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	return 0;
 }
 
+/*
+ * With an async desc, the copies of at least async_threshold bytes are
+ * added to its segments instead of being done by the CPU, as long as the
+ * burst has room for them and no dirty page is logged.
+ */
 static __rte_always_inline int
 copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			    struct rte_mbuf *m, struct buf_vector *buf_vec,
-			    uint16_t nr_vec, uint16_t num_buffers)
+			    uint16_t nr_vec, uint16_t num_buffers,
+			    const struct virtio_net_hdr *net_hdr,
+			    struct rte_vhost_async_desc *async,
+			    uint16_t *async_iov_idx, const uint32_t dp)
 {
 	uint32_t vec_idx = 0;
 	uint32_t mbuf_offset, mbuf_avail;
@@ -629,7 +1006,6 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	uint64_t buf_addr, buf_iova, buf_len;
 	uint32_t cpy_len;
 	uint64_t hdr_addr;
-	struct rte_mbuf *hdr_mbuf;
 	struct batch_copy_elem *batch_copy = vq->batch_copy_elems;
 	struct virtio_net_hdr_mrg_rxbuf tmp_hdr, *hdr = NULL;
 	int error = 0;
@@ -651,7 +1027,6 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		goto out;
 	}
 
-	hdr_mbuf = m;
 	hdr_addr = buf_addr;
 	if (unlikely(buf_len < dev->vhost_hlen))
 		hdr = &tmp_hdr;
@@ -705,8 +1080,8 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		}
 
 		if (hdr_addr) {
-			virtio_enqueue_offload(hdr_mbuf, &hdr->hdr);
-			if (rxvq_is_mergeable(dev))
+			hdr->hdr = *net_hdr;
+			if (dp & VHOST_DP_MRG_RXBUF)
 				ASSIGN_UNLESS_EQUAL(hdr->num_buffers,
 						num_buffers);
 
@@ -727,8 +1102,9 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 					PRINT_PACKET(dev, (uintptr_t)dst,
 							(uint32_t)len, 0);
-					vhost_log_cache_write(dev, vq,
-							iova, len);
+					if (dp & VHOST_DP_LOG)
+						vhost_log_cache_write(dev, vq,
+								iova, len);
 
 					remain -= len;
 					iova += len;
@@ -738,9 +1114,10 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			} else {
 				PRINT_PACKET(dev, (uintptr_t)hdr_addr,
 						dev->vhost_hlen, 0);
-				vhost_log_cache_write(dev, vq,
-						buf_vec[0].buf_iova,
-						dev->vhost_hlen);
+				if (dp & VHOST_DP_LOG)
+					vhost_log_cache_write(dev, vq,
+							buf_vec[0].buf_iova,
+							dev->vhost_hlen);
 			}
 
 			hdr_addr = 0;
@@ -748,13 +1125,31 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 		cpy_len = RTE_MIN(buf_avail, mbuf_avail);
 
-		if (likely(cpy_len > MAX_BATCH_LEN ||
-					vq->batch_copy_nb_elems >= vq->size)) {
-			rte_memcpy((void *)((uintptr_t)(buf_addr + buf_offset)),
+		if (async != NULL && cpy_len >= vq->async_threshold &&
+				*async_iov_idx < VHOST_ASYNC_IOV_MAX &&
+				!(dp & VHOST_DP_LOG)) {
+			struct iovec *src = &vq->async_iov[*async_iov_idx];
+			struct iovec *dst = &vq->async_iov[VHOST_ASYNC_IOV_MAX +
+							   *async_iov_idx];
+
+			src->iov_base = rte_pktmbuf_mtod_offset(m, void *,
+								mbuf_offset);
+			src->iov_len = cpy_len;
+			dst->iov_base = (void *)((uintptr_t)(buf_addr +
+							     buf_offset));
+			dst->iov_len = cpy_len;
+			(*async_iov_idx)++;
+			async->nr_segs++;
+		} else if (likely(cpy_len > MAX_BATCH_LEN ||
+					vq->batch_copy_nb_elems >= vq->batch_copy_max)) {
+			vhost_copy_to_guest(dev,
+				(void *)((uintptr_t)(buf_addr + buf_offset)),
 				rte_pktmbuf_mtod_offset(m, void *, mbuf_offset),
 				cpy_len);
-			vhost_log_cache_write(dev, vq, buf_iova + buf_offset,
-					cpy_len);
+			vq->stats.direct_copy_bytes += cpy_len;
+			if (dp & VHOST_DP_LOG)
+				vhost_log_cache_write(dev, vq,
+						buf_iova + buf_offset, cpy_len);
 			PRINT_PACKET(dev, (uintptr_t)(buf_addr + buf_offset),
 				cpy_len, 0);
 		} else {
@@ -779,90 +1174,391 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	return error;
 }
 
-static __rte_always_inline uint32_t
-virtio_dev_rx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
-	struct rte_mbuf **pkts, uint32_t count)
+/*
+ * Map the buffers of a batch, each of them must be contiguous in the
+ * host virtual address space.
+ */
+static __rte_always_inline int
+vhost_batch_map_descs(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint64_t *iovas, uint32_t *lens, uint64_t *addrs, uint8_t perm)
 {
-	uint32_t pkt_idx = 0;
-	uint16_t num_buffers;
-	struct buf_vector buf_vec[BUF_VECTOR_MAX];
-	uint16_t avail_head;
-
-	rte_prefetch0(&vq->avail->ring[vq->last_avail_idx & (vq->size - 1)]);
-	avail_head = *((volatile uint16_t *)&vq->avail->idx);
-
-	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
-		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
-		uint16_t nr_vec = 0;
+	uint64_t len;
+	uint16_t i;
 
-		if (unlikely(reserve_avail_buf_split(dev, vq,
-						pkt_len, buf_vec, &num_buffers,
-						avail_head, &nr_vec) < 0)) {
-			VHOST_LOG_DEBUG(VHOST_DATA,
-				"(%d) failed to get enough desc from vring\n",
-				dev->vid);
-			vq->shadow_used_idx -= num_buffers;
-			break;
-		}
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		len = lens[i];
+		addrs[i] = vhost_iova_to_vva(dev, vq, iovas[i], &len, perm);
+		if (unlikely(!addrs[i] || len != lens[i]))
+			return -1;
+	}
 
-		rte_prefetch0((void *)(uintptr_t)buf_vec[0].buf_addr);
+	return 0;
+}
 
-		VHOST_LOG_DEBUG(VHOST_DATA, "(%d) current index %d | end index %d\n",
-			dev->vid, vq->last_avail_idx,
-			vq->last_avail_idx + num_buffers);
+static __rte_always_inline void
+virtio_dev_rx_batch_copy(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mbuf **pkts, struct virtio_net_hdr *hdrs, uint64_t *iovas,
+	uint32_t *lens, uint64_t *addrs, const uint32_t dp)
+{
+	struct virtio_net_hdr_mrg_rxbuf *hdr;
+	uint16_t i;
 
-		if (copy_mbuf_to_desc(dev, vq, pkts[pkt_idx],
-						buf_vec, nr_vec,
-						num_buffers) < 0) {
-			vq->shadow_used_idx -= num_buffers;
-			break;
-		}
+	for (i = 0; i < VHOST_BATCH_SIZE; i++)
+		rte_prefetch0((void *)(uintptr_t)addrs[i]);
 
-		vq->last_avail_idx += num_buffers;
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		hdr = (struct virtio_net_hdr_mrg_rxbuf *)(uintptr_t)addrs[i];
+		hdr->hdr = hdrs[i];
+		if (dp & VHOST_DP_MRG_RXBUF)
+			ASSIGN_UNLESS_EQUAL(hdr->num_buffers, 1);
 	}
 
-	do_data_copy_enqueue(dev, vq);
-
-	if (likely(vq->shadow_used_idx)) {
-		flush_shadow_used_ring_split(dev, vq);
-		vhost_vring_call_split(dev, vq);
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		vhost_copy_to_guest(dev,
+			(void *)(uintptr_t)(addrs[i] + dev->vhost_hlen),
+			rte_pktmbuf_mtod(pkts[i], void *), pkts[i]->pkt_len);
+		if (dp & VHOST_DP_LOG)
+			vhost_log_cache_write(dev, vq, iovas[i], lens[i]);
+		PRINT_PACKET(dev, (uintptr_t)addrs[i], lens[i], 0);
+		vq->stats.direct_copy_bytes += pkts[i]->pkt_len;
 	}
 
-	return pkt_idx;
+	vq->stats.chain_hist[0] += VHOST_BATCH_SIZE;
 }
 
-static __rte_always_inline uint32_t
-virtio_dev_rx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
-	struct rte_mbuf **pkts, uint32_t count)
+/*
+ * Get the buffer of a batch candidate, which must be a single descriptor.
+ * Guests always using indirect descriptors qualify when the table holds a
+ * single descriptor.
+ */
+static __rte_always_inline int
+vhost_batch_desc_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t id, uint64_t *iova, uint32_t *len)
 {
-	uint32_t pkt_idx = 0;
-	uint16_t num_buffers;
-	struct buf_vector buf_vec[BUF_VECTOR_MAX];
+	struct vring_desc *desc = &vq->desc[id];
+	uint64_t dlen;
 
-	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
-		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
-		uint16_t nr_vec = 0;
-		uint16_t nr_descs = 0;
+	if (desc->flags & VRING_DESC_F_INDIRECT) {
+		if (unlikely(desc->len != sizeof(*desc) ||
+				(desc->flags & VRING_DESC_F_NEXT)))
+			return -1;
+		dlen = sizeof(*desc);
+		desc = (struct vring_desc *)(uintptr_t)
+			vhost_iova_to_vva(dev, vq, desc->addr, &dlen,
+					VHOST_ACCESS_RO);
+		if (unlikely(!desc || dlen != sizeof(*desc)))
+			return -1;
+	}
 
-		if (unlikely(reserve_avail_buf_packed(dev, vq,
-						pkt_len, buf_vec, &nr_vec,
-						&num_buffers, &nr_descs) < 0)) {
-			VHOST_LOG_DEBUG(VHOST_DATA,
-				"(%d) failed to get enough desc from vring\n",
-				dev->vid);
-			vq->shadow_used_idx -= num_buffers;
-			break;
-		}
+	if (unlikely(desc->flags &
+			(VRING_DESC_F_NEXT | VRING_DESC_F_INDIRECT)))
+		return -1;
 
-		rte_prefetch0((void *)(uintptr_t)buf_vec[0].buf_addr);
+	*iova = desc->addr;
+	*len = desc->len;
 
-		VHOST_LOG_DEBUG(VHOST_DATA, "(%d) current index %d | end index %d\n",
-			dev->vid, vq->last_avail_idx,
-			vq->last_avail_idx + num_buffers);
+	return 0;
+}
+
+/*
+ * Enqueue VHOST_BATCH_SIZE single segment packets into as many single
+ * descriptors taken from the avail ring, without walking the buffer
+ * vectors. Returns -1 when the batch does not qualify, nothing is
+ * consumed then and the caller falls back to the per packet path.
+ */
+static __rte_always_inline int
+virtio_dev_rx_batch_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mbuf **pkts, struct virtio_net_hdr *hdrs,
+	uint16_t avail_head, const uint32_t dp)
+{
+	uint16_t avail_idx = vq->last_avail_idx;
+	uint16_t ids[VHOST_BATCH_SIZE];
+	uint64_t iovas[VHOST_BATCH_SIZE];
+	uint64_t addrs[VHOST_BATCH_SIZE];
+	uint32_t lens[VHOST_BATCH_SIZE];
+	uint32_t buf_len;
+	uint16_t i;
+
+	if (unlikely((uint16_t)(avail_head - avail_idx) < VHOST_BATCH_SIZE))
+		return -1;
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		if (unlikely(pkts[i]->next != NULL))
+			return -1;
+		ids[i] = vq->avail->ring[(avail_idx + i) & (vq->size - 1)];
+		if (unlikely(ids[i] >= vq->size))
+			return -1;
+		if (unlikely(vhost_batch_desc_split(dev, vq, ids[i], &iovas[i],
+						&buf_len) < 0))
+			return -1;
+		lens[i] = pkts[i]->pkt_len + dev->vhost_hlen;
+		if (unlikely(lens[i] > buf_len))
+			return -1;
+	}
+
+	if (vhost_batch_map_descs(dev, vq, iovas, lens, addrs,
+				VHOST_ACCESS_RW) < 0)
+		return -1;
+
+	virtio_dev_rx_batch_copy(dev, vq, pkts, hdrs, iovas, lens, addrs, dp);
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++)
+		update_shadow_used_ring_split(vq, ids[i], lens[i]);
+
+	vq->last_avail_idx += VHOST_BATCH_SIZE;
+
+	return 0;
+}
+
+/*
+ * Packed ring flavour of virtio_dev_rx_batch_split(), the batch is one
+ * cache line of descriptors starting at a VHOST_BATCH_SIZE aligned index.
+ */
+static __rte_always_inline int
+virtio_dev_rx_batch_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mbuf **pkts, struct virtio_net_hdr *hdrs, const uint32_t dp)
+{
+	struct vring_packed_desc *descs = vq->desc_packed;
+	uint16_t avail_idx = vq->last_avail_idx;
+	uint64_t iovas[VHOST_BATCH_SIZE];
+	uint64_t addrs[VHOST_BATCH_SIZE];
+	uint32_t lens[VHOST_BATCH_SIZE];
+	uint16_t i;
+
+	if (unlikely(avail_idx & VHOST_BATCH_MASK))
+		return -1;
+	if (unlikely(avail_idx + VHOST_BATCH_SIZE > vq->size))
+		return -1;
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		if (unlikely(!desc_is_avail(&descs[avail_idx + i],
+					vq->avail_wrap_counter)))
+			return -1;
+	}
+
+	rte_smp_rmb();
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		if (unlikely(pkts[i]->next != NULL))
+			return -1;
+		if (unlikely(descs[avail_idx + i].flags &
+				(VRING_DESC_F_NEXT | VRING_DESC_F_INDIRECT)))
+			return -1;
+		lens[i] = pkts[i]->pkt_len + dev->vhost_hlen;
+		if (unlikely(lens[i] > descs[avail_idx + i].len))
+			return -1;
+		iovas[i] = descs[avail_idx + i].addr;
+	}
+
+	if (vhost_batch_map_descs(dev, vq, iovas, lens, addrs,
+				VHOST_ACCESS_RW) < 0)
+		return -1;
+
+	virtio_dev_rx_batch_copy(dev, vq, pkts, hdrs, iovas, lens, addrs, dp);
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++)
+		update_shadow_used_ring_packed(vq, descs[avail_idx + i].id,
+				lens[i], 1);
+
+	vq->last_avail_idx += VHOST_BATCH_SIZE;
+	if (vq->last_avail_idx >= vq->size) {
+		vq->last_avail_idx -= vq->size;
+		vq->avail_wrap_counter ^= 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Write the used entries held back by the used batch of a split vring once
+ * there are used_batch of them, or once the oldest one is held for
+ * used_batch_cycles. The entries ending in a cache line of the used ring
+ * which is not full yet wait for the next write, which would move that line
+ * to the guest socket again, so the lines and the index are moved once per
+ * write; the latency bound writes them all.
+ */
+static __rte_always_inline void
+vhost_used_batch_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t held, const uint32_t dp)
+{
+	uint16_t nb_used = vq->shadow_used_idx;
+	uint16_t end, tail;
+	uint64_t now = 0;
+
+	if (vq->used_batch_cycles) {
+		now = rte_rdtsc();
+		if (held == 0)
+			vq->used_batch_tsc = now;
+		else if (now - vq->used_batch_tsc >= vq->used_batch_cycles)
+			goto write_all;
+	}
+
+	if (nb_used < vq->used_batch)
+		return;
+
+	/* Ring position right after the last entry to write */
+	end = ((vq->last_used_idx + nb_used - 1) & (vq->size - 1)) + 1;
+	tail = ((uintptr_t)&vq->used->ring[end] & (RTE_CACHE_LINE_SIZE - 1)) /
+		sizeof(struct vring_used_elem);
+	if (tail == 0 || tail >= nb_used)
+		goto write_all;
+
+	vq->shadow_used_idx = nb_used - tail;
+	flush_shadow_used_ring_split(dev, vq, dp);
+	memmove(vq->shadow_used_split, &vq->shadow_used_split[nb_used - tail],
+		tail * sizeof(struct vring_used_elem));
+	vq->shadow_used_idx = tail;
+	vq->used_batch_tsc = now;
+	vhost_vring_call_split(dev, vq);
+	return;
+
+write_all:
+	flush_shadow_used_ring_split(dev, vq, dp);
+	vhost_vring_call_split(dev, vq);
+}
+
+static __rte_always_inline uint32_t
+virtio_dev_rx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mbuf **pkts, uint32_t count, const uint32_t dp)
+{
+	uint32_t pkt_idx = 0;
+	uint16_t num_buffers;
+	struct buf_vector buf_vec[BUF_VECTOR_MAX];
+	struct virtio_net_hdr hdrs[MAX_PKT_BURST];
+	uint16_t held = vq->shadow_used_idx;
+	uint16_t avail_head;
+
+	rte_prefetch0(&vq->avail->ring[vq->last_avail_idx & (vq->size - 1)]);
+	avail_head = *((volatile uint16_t *)&vq->avail->idx);
+
+	virtio_enqueue_offload_burst(pkts, count, hdrs);
+
+	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
+		uint16_t nr_vec = 0;
+
+		if (count - pkt_idx >= VHOST_BATCH_SIZE &&
+				virtio_dev_rx_batch_split(dev, vq,
+					&pkts[pkt_idx], &hdrs[pkt_idx],
+					avail_head, dp) == 0) {
+			pkt_idx += VHOST_BATCH_SIZE - 1;
+			continue;
+		}
+
+		if (unlikely(reserve_avail_buf_split(dev, vq,
+						pkt_len, buf_vec, &num_buffers,
+						avail_head, &nr_vec, dp) < 0)) {
+			VHOST_LOG_DEBUG(VHOST_DATA,
+				"(%d) failed to get enough desc from vring\n",
+				dev->vid);
+			vq->shadow_used_idx -= num_buffers;
+			break;
+		}
+
+		rte_prefetch0((void *)(uintptr_t)buf_vec[0].buf_addr);
+
+		VHOST_LOG_DEBUG(VHOST_DATA, "(%d) current index %d | end index %d\n",
+			dev->vid, vq->last_avail_idx,
+			vq->last_avail_idx + num_buffers);
+
+		if (copy_mbuf_to_desc(dev, vq, pkts[pkt_idx],
+						buf_vec, nr_vec, num_buffers,
+						&hdrs[pkt_idx], NULL, NULL,
+						dp) < 0) {
+			vq->shadow_used_idx -= num_buffers;
+			break;
+		}
+
+		vq->last_avail_idx += num_buffers;
+	}
+
+	do_data_copy_enqueue(dev, vq, dp);
+
+	/*
+	 * With a used batch, the used entries of several bursts are written
+	 * at once, so that the used ring and index lines go to the guest
+	 * socket less often. A burst not enqueuing all its packets writes
+	 * them, as the guest may wait for them before posting new buffers.
+	 */
+	if (likely(vq->shadow_used_idx)) {
+		if (likely(vq->used_batch == 0) || pkt_idx < count) {
+			flush_shadow_used_ring_split(dev, vq, dp);
+			vhost_vring_call_split(dev, vq);
+		} else {
+			vhost_used_batch_split(dev, vq, held, dp);
+		}
+	}
+
+	return pkt_idx;
+}
+
+/* True once the oldest held back used entry reached the latency bound */
+static __rte_always_inline bool
+vhost_used_batch_expired(struct vhost_virtqueue *vq)
+{
+	return vq->used_batch_cycles == 0 ||
+		rte_rdtsc() - vq->used_batch_tsc >= vq->used_batch_cycles;
+}
+
+/*
+ * Write the used entries held back by the used batch of a split vring,
+ * for a burst without packets or before the vring stops.
+ */
+void
+vhost_flush_used_batch(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (vq_is_packed(dev) || vq->shadow_used_idx == 0)
+		return;
+
+	flush_shadow_used_ring_split(dev, vq, vhost_dp_flags(dev));
+	vhost_vring_call_split(dev, vq);
+}
+
+static __rte_always_inline uint32_t
+virtio_dev_rx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mbuf **pkts, uint32_t count, const uint32_t dp)
+{
+	uint32_t pkt_idx = 0;
+	uint16_t num_buffers;
+	struct buf_vector buf_vec[BUF_VECTOR_MAX];
+	struct virtio_net_hdr hdrs[MAX_PKT_BURST];
+
+	virtio_enqueue_offload_burst(pkts, count, hdrs);
+
+	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
+		uint16_t nr_vec = 0;
+		uint16_t nr_descs = 0;
+
+		if (count - pkt_idx >= VHOST_BATCH_SIZE &&
+				virtio_dev_rx_batch_packed(dev, vq,
+					&pkts[pkt_idx], &hdrs[pkt_idx],
+					dp) == 0) {
+			pkt_idx += VHOST_BATCH_SIZE - 1;
+			continue;
+		}
+
+		if (unlikely(reserve_avail_buf_packed(dev, vq,
+						pkt_len, buf_vec, &nr_vec,
+						&num_buffers, &nr_descs,
+						dp) < 0)) {
+			VHOST_LOG_DEBUG(VHOST_DATA,
+				"(%d) failed to get enough desc from vring\n",
+				dev->vid);
+			vq->shadow_used_idx -= num_buffers;
+			break;
+		}
+
+		rte_prefetch0((void *)(uintptr_t)buf_vec[0].buf_addr);
+
+		VHOST_LOG_DEBUG(VHOST_DATA, "(%d) current index %d | end index %d\n",
+			dev->vid, vq->last_avail_idx,
+			vq->last_avail_idx + num_buffers);
 
 		if (copy_mbuf_to_desc(dev, vq, pkts[pkt_idx],
-						buf_vec, nr_vec,
-						num_buffers) < 0) {
+						buf_vec, nr_vec, num_buffers,
+						&hdrs[pkt_idx], NULL, NULL,
+						dp) < 0) {
 			vq->shadow_used_idx -= num_buffers;
 			break;
 		}
@@ -874,22 +1570,34 @@ virtio_dev_rx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		}
 	}
 
-	do_data_copy_enqueue(dev, vq);
+	do_data_copy_enqueue(dev, vq, dp);
 
 	if (likely(vq->shadow_used_idx)) {
-		flush_shadow_used_ring_packed(dev, vq);
+		flush_shadow_used_ring_packed(dev, vq, dp);
 		vhost_vring_call_packed(dev, vq);
 	}
 
 	return pkt_idx;
 }
 
+static uint32_t virtio_dev_rx_generic(struct virtio_net *dev,
+	uint16_t queue_id, struct rte_mbuf **pkts, uint32_t count);
+
+/*
+ * The variant is picked from dev->dp_rx before the vring is locked, and
+ * SET_FEATURES may change the features meanwhile, e.g. enable the dirty
+ * logging. Once locked, the generic variant reads the features, and a
+ * specialized one which is no longer selected hands the burst over to it.
+ */
 static __rte_always_inline uint32_t
 virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
-	struct rte_mbuf **pkts, uint32_t count)
+	struct rte_mbuf **pkts, uint32_t count, const uint8_t variant,
+	const uint32_t variant_dp)
 {
 	struct vhost_virtqueue *vq;
 	uint32_t nb_tx = 0;
+	uint32_t dp;
+	uint64_t tsc;
 
 	VHOST_LOG_DEBUG(VHOST_DATA, "(%d) %s\n", dev->vid, __func__);
 	if (unlikely(!is_valid_virt_queue_idx(queue_id, 0, dev->nr_vring))) {
@@ -900,37 +1608,116 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 
 	vq = dev->virtqueue[queue_id];
 
-	rte_spinlock_lock(&vq->access_lock);
+	if (unlikely(!vhost_vq_dp_enter(dev, vq, false)))
+		return 0;
+
+	/* The ring belongs to the async channel and its copies in flight */
+	if (unlikely(vq->async_registered)) {
+		vhost_vq_dp_leave(dev, vq);
+		RTE_LOG(ERR, VHOST_DATA,
+			"(%d) %s: async channel registered on virtqueue %d.\n",
+			dev->vid, __func__, queue_id);
+		return 0;
+	}
+
+	if (variant == VHOST_DP_GENERIC) {
+		dp = vhost_dp_flags(dev);
+	} else if (unlikely(dev->dp_rx != variant)) {
+		vhost_vq_dp_leave(dev, vq);
+		return virtio_dev_rx_generic(dev, queue_id, pkts, count);
+	} else {
+		dp = variant_dp;
+	}
+
+	vhost_vring_stats_begin(&vq->stats);
+	tsc = vhost_burst_tune_begin(vq);
 
 	if (unlikely(vq->enabled == 0))
 		goto out_access_unlock;
 
-	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+	if (dp & VHOST_DP_IOMMU)
 		vhost_user_iotlb_rd_lock(vq);
 
 	if (unlikely(vq->access_ok == 0))
 		if (unlikely(vring_translate(dev, vq) < 0))
 			goto out;
 
+	if (unlikely(!vq->numa_checked))
+		vhost_vring_check_numa(dev, vq);
+
 	count = RTE_MIN((uint32_t)MAX_PKT_BURST, count);
 	if (count == 0)
-		goto out;
+		goto flush;
+	count = vhost_budget_trim(vq, pkts, count);
 
-	if (vq_is_packed(dev))
-		nb_tx = virtio_dev_rx_packed(dev, vq, pkts, count);
+	VHOST_TRACE(dev->vid, queue_id, AVAIL, (dp & VHOST_DP_PACKED) ?
+			vq->last_avail_idx : vq->avail->idx);
+	if (dp & VHOST_DP_PACKED)
+		nb_tx = virtio_dev_rx_packed(dev, vq, pkts, count, dp);
 	else
-		nb_tx = virtio_dev_rx_split(dev, vq, pkts, count);
+		nb_tx = virtio_dev_rx_split(dev, vq, pkts, count, dp);
+	if (nb_tx != 0)
+		VHOST_TRACE(dev->vid, queue_id, USED, vq->last_used_idx);
+
+	vhost_vring_stats_burst(vq, pkts, nb_tx, nb_tx < count);
+	/* The caller had a full burst for a vring which took it all */
+	vhost_burst_tune_end(vq, tsc, nb_tx,
+		nb_tx == count && count >= vq->burst_tune.burst);
+
+flush:
+	if (nb_tx == 0) {
+		if (unlikely(vq->used_batch != 0) &&
+				vhost_used_batch_expired(vq))
+			vhost_flush_used_batch(dev, vq);
+		vhost_vring_call_flush(dev, vq);
+	}
 
 out:
-	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+	if (dp & VHOST_DP_IOMMU)
 		vhost_user_iotlb_rd_unlock(vq);
 
 out_access_unlock:
-	rte_spinlock_unlock(&vq->access_lock);
+	vhost_vring_stats_end(&vq->stats);
+	vhost_vq_dp_leave(dev, vq);
 
 	return nb_tx;
 }
 
+typedef uint32_t (*virtio_dev_rx_t)(struct virtio_net *dev,
+	uint16_t queue_id, struct rte_mbuf **pkts, uint32_t count);
+
+static uint32_t
+virtio_dev_rx_generic(struct virtio_net *dev, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint32_t count)
+{
+	return virtio_dev_rx(dev, queue_id, pkts, count, VHOST_DP_GENERIC, 0);
+}
+
+#define VIRTIO_DEV_RX_VARIANT(name, dp)					\
+static uint32_t								\
+name(struct virtio_net *dev, uint16_t queue_id,				\
+	struct rte_mbuf **pkts, uint32_t count)				\
+{									\
+	return virtio_dev_rx(dev, queue_id, pkts, count,		\
+			VHOST_DP_VARIANT(dp), dp);			\
+}
+
+VIRTIO_DEV_RX_VARIANT(virtio_dev_rx_split_std, 0)
+VIRTIO_DEV_RX_VARIANT(virtio_dev_rx_split_mrg, VHOST_DP_MRG_RXBUF)
+VIRTIO_DEV_RX_VARIANT(virtio_dev_rx_packed_std, VHOST_DP_PACKED)
+VIRTIO_DEV_RX_VARIANT(virtio_dev_rx_packed_mrg,
+	VHOST_DP_PACKED | VHOST_DP_MRG_RXBUF)
+
+/* Indexed by dev->dp_rx, see vhost_select_datapath() */
+static const virtio_dev_rx_t virtio_dev_rx_variants[] = {
+	[VHOST_DP_GENERIC] = virtio_dev_rx_generic,
+	[VHOST_DP_VARIANT(0)] = virtio_dev_rx_split_std,
+	[VHOST_DP_VARIANT(VHOST_DP_MRG_RXBUF)] = virtio_dev_rx_split_mrg,
+	[VHOST_DP_VARIANT(VHOST_DP_PACKED)] = virtio_dev_rx_packed_std,
+	[VHOST_DP_VARIANT(VHOST_DP_PACKED | VHOST_DP_MRG_RXBUF)] =
+		virtio_dev_rx_packed_mrg,
+};
+
 uint16_t
 rte_vhost_enqueue_burst(int vid, uint16_t queue_id,
 	struct rte_mbuf **pkts, uint16_t count)
@@ -947,21 +1734,267 @@ rte_vhost_enqueue_burst(int vid, uint16_t queue_id,
 		return 0;
 	}
 
-	return virtio_dev_rx(dev, queue_id, pkts, count);
+	return virtio_dev_rx_variants[dev->dp_rx](dev, queue_id, pkts, count);
 }
 
-static inline bool
-virtio_net_with_host_offload(struct virtio_net *dev)
+static __rte_always_inline uint32_t
+virtio_dev_rx_async_submit_split(struct virtio_net *dev,
+	struct vhost_virtqueue *vq, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint32_t count)
 {
-	if (dev->features &
-			((1ULL << VIRTIO_NET_F_CSUM) |
-			 (1ULL << VIRTIO_NET_F_HOST_ECN) |
-			 (1ULL << VIRTIO_NET_F_HOST_TSO4) |
-			 (1ULL << VIRTIO_NET_F_HOST_TSO6) |
-			 (1ULL << VIRTIO_NET_F_HOST_UFO)))
-		return true;
+	uint32_t pkt_idx = 0;
+	uint16_t num_buffers;
+	struct buf_vector buf_vec[BUF_VECTOR_MAX];
+	uint16_t nr_used[MAX_PKT_BURST];
+	struct virtio_net_hdr hdrs[MAX_PKT_BURST];
+	struct rte_vhost_async_desc *desc;
+	uint16_t avail_head;
+	uint16_t iov_idx = 0;
+	uint16_t nr_accepted;
+	uint16_t used_n = 0;
+	uint16_t slot;
+	uint32_t i;
+	const uint32_t dp = vhost_dp_flags(dev);
 
-	return false;
+	count = RTE_MIN(count, vq->size - vq->async_pkts_inflight_n);
+
+	rte_prefetch0(&vq->avail->ring[vq->last_avail_idx & (vq->size - 1)]);
+	avail_head = *((volatile uint16_t *)&vq->avail->idx);
+
+	virtio_enqueue_offload_burst(pkts, count, hdrs);
+
+	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
+		uint16_t nr_vec = 0;
+
+		if (unlikely(reserve_avail_buf_split(dev, vq,
+						pkt_len, buf_vec, &num_buffers,
+						avail_head, &nr_vec, dp) < 0)) {
+			VHOST_LOG_DEBUG(VHOST_DATA,
+				"(%d) failed to get enough desc from vring\n",
+				dev->vid);
+			vq->shadow_used_idx -= num_buffers;
+			break;
+		}
+
+		desc = &vq->async_descs[pkt_idx];
+		desc->src = &vq->async_iov[iov_idx];
+		desc->dst = &vq->async_iov[VHOST_ASYNC_IOV_MAX + iov_idx];
+		desc->nr_segs = 0;
+
+		if (copy_mbuf_to_desc(dev, vq, pkts[pkt_idx],
+						buf_vec, nr_vec, num_buffers,
+						&hdrs[pkt_idx], desc,
+						&iov_idx, dp) < 0) {
+			vq->shadow_used_idx -= num_buffers;
+			break;
+		}
+
+		nr_used[pkt_idx] = num_buffers;
+		vq->last_avail_idx += num_buffers;
+	}
+
+	do_data_copy_enqueue(dev, vq, dp);
+
+	if (unlikely(pkt_idx == 0))
+		return 0;
+
+	nr_accepted = vq->async_ops.transfer_data(dev->vid, queue_id,
+			vq->async_descs, pkt_idx);
+	nr_accepted = RTE_MIN(nr_accepted, pkt_idx);
+
+	/* The buffers of the rejected packets go back to the ring. */
+	for (i = 0; i < pkt_idx; i++) {
+		if (i < nr_accepted)
+			used_n += nr_used[i];
+		else
+			vq->last_avail_idx -= nr_used[i];
+	}
+
+	/* The used entries wait for the copies to complete. */
+	for (i = 0; i < used_n; i++) {
+		slot = (vq->async_used_idx + vq->async_used_n + i) &
+			(vq->size - 1);
+		vq->async_used[slot] = vq->shadow_used_split[i];
+	}
+	vq->async_used_n += used_n;
+	vq->shadow_used_idx = 0;
+
+	for (i = 0; i < nr_accepted; i++) {
+		slot = (vq->async_pkts_idx + vq->async_pkts_inflight_n + i) &
+			(vq->size - 1);
+		vq->async_pkts[slot] = pkts[i];
+		vq->async_pkts_nr_used[slot] = nr_used[i];
+	}
+	vq->async_pkts_inflight_n += nr_accepted;
+
+	return nr_accepted;
+}
+
+static __rte_always_inline void
+write_back_completed_used_split(struct virtio_net *dev,
+	struct vhost_virtqueue *vq, uint16_t used_n)
+{
+	uint16_t from, to;
+	uint16_t i;
+
+	for (i = 0; i < used_n; i++) {
+		from = (vq->async_used_idx + i) & (vq->size - 1);
+		to = (vq->last_used_idx + i) & (vq->size - 1);
+		vq->used->ring[to] = vq->async_used[from];
+		vhost_log_cache_used_vring(dev, vq,
+				offsetof(struct vring_used, ring[to]),
+				sizeof(struct vring_used_elem));
+	}
+	vq->async_used_idx += used_n;
+	vq->async_used_n -= used_n;
+	vq->last_used_idx += used_n;
+
+	rte_smp_wmb();
+
+	vhost_log_cache_sync(dev, vq);
+
+	*(volatile uint16_t *)&vq->used->idx += used_n;
+	vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
+		sizeof(vq->used->idx));
+}
+
+uint16_t
+rte_vhost_submit_enqueue_burst(int vid, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint16_t count)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	uint32_t nb_tx = 0;
+
+	if (!dev)
+		return 0;
+
+	if (unlikely(!(dev->flags & VIRTIO_DEV_BUILTIN_VIRTIO_NET))) {
+		RTE_LOG(ERR, VHOST_DATA,
+			"(%d) %s: built-in vhost net backend is disabled.\n",
+			dev->vid, __func__);
+		return 0;
+	}
+
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, 0, dev->nr_vring))) {
+		RTE_LOG(ERR, VHOST_DATA, "(%d) %s: invalid virtqueue idx %d.\n",
+			dev->vid, __func__, queue_id);
+		return 0;
+	}
+
+	vq = dev->virtqueue[queue_id];
+
+	if (unlikely(!vhost_vq_dp_enter(dev, vq, false)))
+		return 0;
+	vhost_vring_stats_begin(&vq->stats);
+
+	if (unlikely(vq->enabled == 0 || !vq->async_registered))
+		goto out_access_unlock;
+
+	if (unlikely(vq_is_packed(dev))) {
+		RTE_LOG(ERR, VHOST_DATA,
+			"(%d) %s: packed ring is not supported.\n",
+			dev->vid, __func__);
+		goto out_access_unlock;
+	}
+
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+		vhost_user_iotlb_rd_lock(vq);
+
+	if (unlikely(vq->access_ok == 0))
+		if (unlikely(vring_translate(dev, vq) < 0))
+			goto out;
+
+	count = RTE_MIN((uint32_t)MAX_PKT_BURST, count);
+	if (count == 0)
+		goto out;
+	count = vhost_budget_trim(vq, pkts, count);
+
+	VHOST_TRACE(dev->vid, queue_id, AVAIL, vq->avail->idx);
+	nb_tx = virtio_dev_rx_async_submit_split(dev, vq, queue_id,
+			pkts, count);
+	vhost_vring_stats_burst(vq, pkts, nb_tx, nb_tx < count);
+
+out:
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+		vhost_user_iotlb_rd_unlock(vq);
+
+out_access_unlock:
+	vhost_vring_stats_end(&vq->stats);
+	vhost_vq_dp_leave(dev, vq);
+
+	return nb_tx;
+}
+
+uint16_t
+rte_vhost_poll_enqueue_completed(int vid, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint16_t count)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	uint16_t n_pkts = 0;
+	uint16_t used_n = 0;
+	uint16_t slot;
+	uint16_t i;
+
+	if (!dev)
+		return 0;
+
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, 0, dev->nr_vring))) {
+		RTE_LOG(ERR, VHOST_DATA, "(%d) %s: invalid virtqueue idx %d.\n",
+			dev->vid, __func__, queue_id);
+		return 0;
+	}
+
+	vq = dev->virtqueue[queue_id];
+
+	if (unlikely(!vhost_vq_dp_enter(dev, vq, false)))
+		return 0;
+	vhost_vring_stats_begin(&vq->stats);
+
+	if (unlikely(!vq->async_registered))
+		goto out_access_unlock;
+
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+		vhost_user_iotlb_rd_lock(vq);
+
+	if (unlikely(vq->access_ok == 0))
+		if (unlikely(vring_translate(dev, vq) < 0))
+			goto out;
+
+	count = RTE_MIN(count, vq->async_pkts_inflight_n);
+	if (count) {
+		n_pkts = vq->async_ops.check_completed_copies(vid, queue_id,
+							      count);
+		n_pkts = RTE_MIN(n_pkts, count);
+	}
+	if (n_pkts == 0) {
+		vhost_vring_call_flush(dev, vq);
+		goto out;
+	}
+
+	for (i = 0; i < n_pkts; i++) {
+		slot = (vq->async_pkts_idx + i) & (vq->size - 1);
+		pkts[i] = vq->async_pkts[slot];
+		used_n += vq->async_pkts_nr_used[slot];
+	}
+	vq->async_pkts_idx += n_pkts;
+	vq->async_pkts_inflight_n -= n_pkts;
+
+	write_back_completed_used_split(dev, vq, used_n);
+	VHOST_TRACE(vid, queue_id, USED, vq->last_used_idx);
+	vhost_vring_call_split(dev, vq);
+
+out:
+	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+		vhost_user_iotlb_rd_unlock(vq);
+
+out_access_unlock:
+	vhost_vring_stats_end(&vq->stats);
+	vhost_vq_dp_leave(dev, vq);
+
+	return n_pkts;
 }
 
 static void
@@ -1065,15 +2098,119 @@ vhost_dequeue_offload(struct virtio_net_hdr *hdr, struct rte_mbuf *m)
 }
 
 static __rte_always_inline void
-put_zmbuf(struct zcopy_mbuf *zmbuf)
+vhost_dequeue_prefetch_hdr(struct virtio_net_hdr *hdr, struct rte_mbuf *m)
+{
+	if (hdr->flags != 0 || hdr->gso_type != VIRTIO_NET_HDR_GSO_NONE)
+		rte_prefetch0(rte_pktmbuf_mtod(m, void *));
+}
+
+/*
+ * Set the offloads of a dequeued burst from the virtio-net headers the
+ * copies saved, once all of them are done. This keeps the parsing of the
+ * packet headers out of the copy loop, and lets the copy of their first
+ * bytes be batched too. The packet headers are prefetched a few packets
+ * ahead.
+ */
+static __rte_always_inline void
+vhost_dequeue_offload_burst(struct virtio_net_hdr *hdrs,
+	struct rte_mbuf **pkts, uint16_t count)
+{
+	uint16_t i;
+
+	for (i = 0; i < VHOST_HDR_PREFETCH_OFFSET && i < count; i++)
+		vhost_dequeue_prefetch_hdr(&hdrs[i], pkts[i]);
+
+	for (i = 0; i < count; i++) {
+		if (i + VHOST_HDR_PREFETCH_OFFSET < count)
+			vhost_dequeue_prefetch_hdr(
+				&hdrs[i + VHOST_HDR_PREFETCH_OFFSET],
+				pkts[i + VHOST_HDR_PREFETCH_OFFSET]);
+		vhost_dequeue_offload(&hdrs[i], pkts[i]);
+	}
+}
+
+/*
+ * With RTE_VHOST_USER_SW_CKSUM, the TCP and UDP checksums the guest leaves
+ * to the device are summed while the packet is copied, so that it is
+ * handed out finished instead of being walked again by the application.
+ * GSO packets keep their offload requests, their segments are checksummed
+ * when they are built.
+ */
+struct vhost_sw_cksum {
+	uint32_t start;		/* Offset of the first summed byte */
+	uint32_t sum;		/* Sum of the bytes copied so far */
+};
+
+static __rte_always_inline bool
+vhost_sw_cksum_needed(const struct virtio_net_hdr *hdr)
+{
+	return hdr->flags == VIRTIO_NET_HDR_F_NEEDS_CSUM &&
+		hdr->gso_type == VIRTIO_NET_HDR_GSO_NONE &&
+		(hdr->csum_offset == offsetof(struct tcp_hdr, cksum) ||
+		 hdr->csum_offset == offsetof(struct udp_hdr, dgram_cksum));
+}
+
+/* Copy the bytes at pkt_off of a packet, summing those past csum_start */
+static __rte_always_inline void
+vhost_sw_cksum_copy(struct vhost_sw_cksum *cks, void *dst, const void *src,
+		uint32_t len, uint32_t pkt_off)
+{
+	uint32_t plain = 0;
+	uint16_t sum;
+
+	if (pkt_off < cks->start) {
+		plain = RTE_MIN(len, cks->start - pkt_off);
+		rte_memcpy(dst, src, plain);
+		if (plain == len)
+			return;
+	}
+
+	sum = __rte_raw_cksum_reduce(rte_net_raw_cksum_copy(
+			(char *)dst + plain, (const char *)src + plain,
+			len - plain, 0));
+	/* the words are shifted by one byte when starting at an odd offset */
+	if ((pkt_off + plain - cks->start) & 1)
+		sum = rte_bswap16(sum);
+	cks->sum += sum;
+}
+
+/* Store the checksum in the packet and drop the offload request */
+static __rte_always_inline void
+vhost_sw_cksum_finish(struct vhost_virtqueue *vq, struct vhost_sw_cksum *cks,
+		struct rte_mbuf *m, struct virtio_net_hdr *hdr)
 {
-	zmbuf->in_use = 0;
+	uint32_t off = hdr->csum_start + hdr->csum_offset;
+	struct rte_mbuf *seg = m;
+	uint16_t cksum;
+	uint8_t *p = (uint8_t *)&cksum;
+	unsigned int i;
+
+	/* a malformed request is left to the application */
+	if (unlikely(off + sizeof(cksum) > m->pkt_len))
+		return;
+
+	cksum = ~__rte_raw_cksum_reduce(cks->sum);
+	if (cksum == 0)
+		cksum = 0xffff;
+
+	/* the checksum may straddle two segments */
+	for (i = 0; i < sizeof(cksum); i++, off++) {
+		while (off >= seg->data_len) {
+			off -= seg->data_len;
+			seg = seg->next;
+		}
+		*rte_pktmbuf_mtod_offset(seg, uint8_t *, off) = p[i];
+	}
+
+	hdr->flags = 0;
+	vq->stats.sw_cksums++;
 }
 
 static __rte_always_inline int
 copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		  struct buf_vector *buf_vec, uint16_t nr_vec,
-		  struct rte_mbuf *m, struct rte_mempool *mbuf_pool)
+		  struct rte_mbuf *m, struct rte_mempool *mbuf_pool,
+		  struct virtio_net_hdr *net_hdr, bool zcopy, const uint32_t dp)
 {
 	uint32_t buf_avail, buf_offset;
 	uint64_t buf_addr, buf_iova, buf_len;
@@ -1085,6 +2222,8 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	/* A counter to avoid desc dead loop chain */
 	uint16_t vec_idx = 0;
 	struct batch_copy_elem *batch_copy = vq->batch_copy_elems;
+	struct vhost_sw_cksum cks;
+	bool sw_cksum = false;
 	int error = 0;
 
 	buf_addr = buf_vec[vec_idx].buf_addr;
@@ -1099,7 +2238,7 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	if (likely(nr_vec > 1))
 		rte_prefetch0((void *)(uintptr_t)buf_vec[1].buf_addr);
 
-	if (virtio_net_with_host_offload(dev)) {
+	if (dp & VHOST_DP_HOST_OFFLOAD) {
 		if (unlikely(buf_len < sizeof(struct virtio_net_hdr))) {
 			uint64_t len;
 			uint64_t remain = sizeof(struct virtio_net_hdr);
@@ -1128,6 +2267,19 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			hdr = (struct virtio_net_hdr *)((uintptr_t)buf_addr);
 			rte_prefetch0(hdr);
 		}
+
+		if (unlikely(dev->sw_cksum) && !zcopy) {
+			/* the guest must not change what is acted upon */
+			if (hdr != &tmp_hdr) {
+				tmp_hdr = *hdr;
+				hdr = &tmp_hdr;
+			}
+			if (vhost_sw_cksum_needed(hdr)) {
+				sw_cksum = true;
+				cks.start = hdr->csum_start;
+				cks.sum = 0;
+			}
+		}
 	}
 
 	/*
@@ -1143,8 +2295,11 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		buf_len = buf_vec[vec_idx].buf_len;
 		buf_avail  = buf_len - buf_offset;
 	} else if (buf_len == dev->vhost_hlen) {
-		if (unlikely(++vec_idx >= nr_vec))
+		if (unlikely(++vec_idx >= nr_vec)) {
+			/* no data, no offload */
+			hdr = NULL;
 			goto out;
+		}
 		buf_addr = buf_vec[vec_idx].buf_addr;
 		buf_iova = buf_vec[vec_idx].buf_iova;
 		buf_len = buf_vec[vec_idx].buf_len;
@@ -1175,7 +2330,7 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		 * not continuous. In such case (gpa_to_hpa returns 0), data
 		 * will be copied even though zero copy is enabled.
 		 */
-		if (unlikely(dev->dequeue_zero_copy && (hpa = gpa_to_hpa(dev,
+		if (unlikely(zcopy && (hpa = gpa_to_hpa(dev,
 					buf_iova + buf_offset, cpy_len)))) {
 			cur->data_len = cpy_len;
 			cur->data_off = 0;
@@ -1189,14 +2344,25 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			 */
 			mbuf_avail = cpy_len;
 		} else {
-			if (likely(cpy_len > MAX_BATCH_LEN ||
-				   vq->batch_copy_nb_elems >= vq->size ||
-				   (hdr && cur == m))) {
+			if (unlikely(zcopy))
+				vq->stats.zcopy_fallbacks++;
+
+			if (unlikely(sw_cksum)) {
+				vhost_sw_cksum_copy(&cks,
+					rte_pktmbuf_mtod_offset(cur, void *,
+								mbuf_offset),
+					(void *)((uintptr_t)(buf_addr +
+							     buf_offset)),
+					cpy_len, m->pkt_len + mbuf_offset);
+				vq->stats.direct_copy_bytes += cpy_len;
+			} else if (likely(cpy_len > MAX_BATCH_LEN ||
+				   vq->batch_copy_nb_elems >= vq->batch_copy_max)) {
 				rte_memcpy(rte_pktmbuf_mtod_offset(cur, void *,
 								   mbuf_offset),
 					   (void *)((uintptr_t)(buf_addr +
 							   buf_offset)),
 					   cpy_len);
+				vq->stats.direct_copy_bytes += cpy_len;
 			} else {
 				batch_copy[vq->batch_copy_nb_elems].dst =
 					rte_pktmbuf_mtod_offset(cur, void *,
@@ -1251,7 +2417,7 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 				error = -1;
 				goto out;
 			}
-			if (unlikely(dev->dequeue_zero_copy))
+			if (unlikely(zcopy))
 				rte_mbuf_refcnt_update(cur, 1);
 
 			prev->next = cur;
@@ -1268,100 +2434,348 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	prev->data_len = mbuf_offset;
 	m->pkt_len    += mbuf_offset;
 
-	if (hdr)
-		vhost_dequeue_offload(hdr, m);
-
 out:
+	/* the offloads are set by vhost_dequeue_offload_burst() */
+	if (hdr) {
+		*net_hdr = *hdr;
+		if (sw_cksum && !error)
+			vhost_sw_cksum_finish(vq, &cks, m, net_hdr);
+	} else
+		memset(net_hdr, 0, sizeof(*net_hdr));
 
 	return error;
 }
 
-static __rte_always_inline struct zcopy_mbuf *
-get_zmbuf(struct vhost_virtqueue *vq)
+/*
+ * Zero copy mbufs in flight past which packets are copied instead, so the
+ * guest keeps getting descriptors back while the application holds mbufs.
+ */
+#define ZCOPY_MAX_INFLIGHT(vq) ((vq)->zmbuf_size - ((vq)->zmbuf_size >> 2))
+
+/*
+ * Give the descriptors of the zero copy mbufs the application is done
+ * with back to the guest. They are returned out of order, which is why
+ * VIRTIO_F_IN_ORDER is not offered with zero copy. Each freed slot is
+ * filled with the last entry to keep the table dense.
+ */
+static __rte_always_inline void
+reclaim_zmbufs(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	struct rte_mbuf *free_pkts[MAX_PKT_BURST];
+	struct zcopy_mbuf *zmbuf;
+	uint16_t i = 0, nb_free = 0;
+
+	while (i < vq->nr_zmbuf) {
+		zmbuf = &vq->zmbufs[i];
+
+		if (!mbuf_is_consumed(zmbuf->mbuf)) {
+			i++;
+			continue;
+		}
+
+		if (vq_is_packed(dev))
+			update_shadow_used_ring_packed(vq, zmbuf->desc_idx,
+					0, zmbuf->desc_count);
+		else
+			update_shadow_used_ring_split(vq, zmbuf->desc_idx, 0);
+
+		restore_mbuf(zmbuf->mbuf);
+		free_pkts[nb_free++] = zmbuf->mbuf;
+		if (nb_free == MAX_PKT_BURST) {
+			rte_pktmbuf_free_bulk(free_pkts, nb_free);
+			nb_free = 0;
+		}
+		*zmbuf = vq->zmbufs[--vq->nr_zmbuf];
+	}
+
+	if (nb_free > 0)
+		rte_pktmbuf_free_bulk(free_pkts, nb_free);
+}
+
+/*
+ * Dequeue the single descriptor buffers of a batch into freshly allocated
+ * mbufs, lens[] are the buffer lengths including the virtio-net header.
+ */
+static __rte_always_inline int
+virtio_dev_tx_batch_copy(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts,
+	struct virtio_net_hdr *hdrs, uint32_t *lens, uint64_t *addrs,
+	const uint32_t dp)
 {
+	bool offload = dp & VHOST_DP_HOST_OFFLOAD;
 	uint16_t i;
-	uint16_t last;
-	int tries = 0;
-
-	/* search [last_zmbuf_idx, zmbuf_size) */
-	i = vq->last_zmbuf_idx;
-	last = vq->zmbuf_size;
-
-again:
-	for (; i < last; i++) {
-		if (vq->zmbufs[i].in_use == 0) {
-			vq->last_zmbuf_idx = i + 1;
-			vq->zmbufs[i].in_use = 1;
-			return &vq->zmbufs[i];
+
+	if (unlikely(rte_pktmbuf_alloc_bulk(mbuf_pool, pkts,
+					VHOST_BATCH_SIZE)))
+		return -1;
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		if (unlikely(lens[i] - dev->vhost_hlen >
+				rte_pktmbuf_tailroom(pkts[i])))
+			goto free_pkts;
+		rte_prefetch0((void *)(uintptr_t)addrs[i]);
+	}
+
+	if (offload) {
+		for (i = 0; i < VHOST_BATCH_SIZE; i++)
+			hdrs[i] = *(struct virtio_net_hdr *)(uintptr_t)addrs[i];
+	}
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		void *dst = rte_pktmbuf_mtod(pkts[i], void *);
+		void *src = (void *)(uintptr_t)(addrs[i] + dev->vhost_hlen);
+		uint32_t len = lens[i] - dev->vhost_hlen;
+
+		pkts[i]->pkt_len = len;
+		pkts[i]->data_len = len;
+		if (unlikely(dev->sw_cksum) && offload &&
+				vhost_sw_cksum_needed(&hdrs[i])) {
+			struct vhost_sw_cksum cks = {
+				.start = hdrs[i].csum_start,
+				.sum = 0,
+			};
+
+			vhost_sw_cksum_copy(&cks, dst, src, len, 0);
+			vhost_sw_cksum_finish(vq, &cks, pkts[i], &hdrs[i]);
+		} else {
+			rte_memcpy(dst, src, len);
 		}
+		vq->stats.direct_copy_bytes += len;
+	}
+	vq->stats.chain_hist[0] += VHOST_BATCH_SIZE;
+
+	return 0;
+
+free_pkts:
+	rte_pktmbuf_free_bulk(pkts, VHOST_BATCH_SIZE);
+	return -1;
+}
+
+/*
+ * Dequeue VHOST_BATCH_SIZE packets held in single descriptors, without
+ * walking the buffer vectors. Returns -1 when the batch does not qualify,
+ * nothing is consumed then and the caller falls back to the per packet
+ * path. Not used with dequeue zero copy. The caller moves last_avail_idx
+ * past the avail entries starting at avail_idx.
+ */
+static __rte_always_inline int
+virtio_dev_tx_batch_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts,
+	struct virtio_net_hdr *hdrs, uint16_t avail_idx, const uint32_t dp)
+{
+	uint16_t ids[VHOST_BATCH_SIZE];
+	uint64_t iovas[VHOST_BATCH_SIZE];
+	uint64_t addrs[VHOST_BATCH_SIZE];
+	uint32_t lens[VHOST_BATCH_SIZE];
+	uint16_t i;
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		ids[i] = vq->avail->ring[(avail_idx + i) & (vq->size - 1)];
+		if (unlikely(ids[i] >= vq->size))
+			return -1;
+		if (unlikely(vhost_batch_desc_split(dev, vq, ids[i], &iovas[i],
+						&lens[i]) < 0))
+			return -1;
+		if (unlikely(lens[i] <= dev->vhost_hlen))
+			return -1;
 	}
 
-	tries++;
-	if (tries == 1) {
-		/* search [0, last_zmbuf_idx) */
-		i = 0;
-		last = vq->last_zmbuf_idx;
-		goto again;
+	if (vhost_batch_map_descs(dev, vq, iovas, lens, addrs,
+				VHOST_ACCESS_RO) < 0)
+		return -1;
+
+	if (virtio_dev_tx_batch_copy(dev, vq, mbuf_pool, pkts, hdrs, lens,
+				addrs, dp) < 0)
+		return -1;
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		vhost_inflight_set_split(vq, ids[i]);
+		update_shadow_used_ring_split(vq, ids[i], 0);
 	}
 
-	return NULL;
+	return 0;
 }
 
-static __rte_always_inline bool
-mbuf_is_consumed(struct rte_mbuf *m)
+/*
+ * Packed ring flavour of virtio_dev_tx_batch_split(), the batch is one
+ * cache line of descriptors starting at a VHOST_BATCH_SIZE aligned index.
+ */
+static __rte_always_inline int
+virtio_dev_tx_batch_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts,
+	struct virtio_net_hdr *hdrs, const uint32_t dp)
 {
-	while (m) {
-		if (rte_mbuf_refcnt_read(m) > 1)
-			return false;
-		m = m->next;
+	struct vring_packed_desc *descs = vq->desc_packed;
+	uint16_t avail_idx = vq->last_avail_idx;
+	uint64_t iovas[VHOST_BATCH_SIZE];
+	uint64_t addrs[VHOST_BATCH_SIZE];
+	uint32_t lens[VHOST_BATCH_SIZE];
+	uint16_t i;
+
+	if (unlikely(avail_idx & VHOST_BATCH_MASK))
+		return -1;
+	if (unlikely(avail_idx + VHOST_BATCH_SIZE > vq->size))
+		return -1;
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		if (unlikely(!desc_is_avail(&descs[avail_idx + i],
+					vq->avail_wrap_counter)))
+			return -1;
 	}
 
-	return true;
+	rte_smp_rmb();
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++) {
+		if (unlikely(descs[avail_idx + i].flags &
+				(VRING_DESC_F_NEXT | VRING_DESC_F_INDIRECT)))
+			return -1;
+		lens[i] = descs[avail_idx + i].len;
+		if (unlikely(lens[i] <= dev->vhost_hlen))
+			return -1;
+		iovas[i] = descs[avail_idx + i].addr;
+	}
+
+	if (vhost_batch_map_descs(dev, vq, iovas, lens, addrs,
+				VHOST_ACCESS_RO) < 0)
+		return -1;
+
+	if (virtio_dev_tx_batch_copy(dev, vq, mbuf_pool, pkts, hdrs, lens,
+				addrs, dp) < 0)
+		return -1;
+
+	for (i = 0; i < VHOST_BATCH_SIZE; i++)
+		update_shadow_used_ring_packed(vq, descs[avail_idx + i].id,
+				0, 1);
+
+	vq->last_avail_idx += VHOST_BATCH_SIZE;
+	if (vq->last_avail_idx >= vq->size) {
+		vq->last_avail_idx -= vq->size;
+		vq->avail_wrap_counter ^= 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Dequeue the descriptors a previous backend left inflight, before the
+ * ones of the avail ring. They are already accounted in last_avail_idx.
+ */
+static __rte_noinline uint16_t
+virtio_dev_tx_split_resubmit(struct virtio_net *dev,
+	struct vhost_virtqueue *vq, struct rte_mempool *mbuf_pool,
+	struct rte_mbuf **pkts, uint16_t count, const uint32_t dp)
+{
+	struct virtio_net_hdr hdrs[MAX_PKT_BURST];
+	uint16_t i;
+
+	count = RTE_MIN(count, MAX_PKT_BURST);
+	count = RTE_MIN(count, vq->resubmit_num - vq->resubmit_idx);
+
+	for (i = 0; i < count; i++) {
+		struct buf_vector buf_vec[BUF_VECTOR_MAX];
+		uint16_t head_idx;
+		uint32_t dummy_len;
+		uint16_t nr_vec = 0;
+
+		if (unlikely(fill_vec_buf_split_head(dev, vq,
+				vq->resubmit_list[vq->resubmit_idx].index,
+				&nr_vec, buf_vec, &head_idx, &dummy_len,
+				VHOST_ACCESS_RO) < 0))
+			break;
+
+		pkts[i] = rte_pktmbuf_alloc(mbuf_pool);
+		if (unlikely(pkts[i] == NULL)) {
+			RTE_LOG(ERR, VHOST_DATA,
+				"Failed to allocate memory for mbuf.\n");
+			break;
+		}
+
+		if (unlikely(copy_desc_to_mbuf(dev, vq, buf_vec, nr_vec,
+				pkts[i], mbuf_pool, &hdrs[i], false, dp))) {
+			rte_pktmbuf_free(pkts[i]);
+			break;
+		}
+
+		update_shadow_used_ring_split(vq, head_idx, 0);
+		vq->resubmit_idx++;
+	}
+
+	if (vq->resubmit_idx == vq->resubmit_num) {
+		rte_free(vq->resubmit_list);
+		vq->resubmit_list = NULL;
+		vq->resubmit_num = 0;
+		vq->resubmit_idx = 0;
+	}
+
+	do_data_copy_dequeue(vq);
+	if (dp & VHOST_DP_HOST_OFFLOAD)
+		vhost_dequeue_offload_burst(hdrs, pkts, i);
+	if (likely(vq->shadow_used_idx)) {
+		flush_shadow_used_ring_split(dev, vq, dp);
+		vhost_vring_call_split(dev, vq);
+	}
+
+	return i;
 }
 
+/*
+ * Dequeue pipeline of a split vring, with a prefetch depth: while the chain
+ * i is copied, the head descriptors of the chains up to i + 2 * depth are
+ * prefetched, and the first buffers of the chains up to i + depth, whose
+ * descriptors were prefetched one step before, are translated and
+ * prefetched. The copy prefetches the next buffers of a chain itself.
+ * With an IOMMU, a translation could miss the IOTLB and request it from
+ * the master, so only the descriptors are prefetched.
+ */
 static __rte_always_inline void
-restore_mbuf(struct rte_mbuf *m)
+vhost_prefetch_tx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint16_t i, uint16_t nb_avail, uint16_t *pf_desc, uint16_t *pf_buf,
+	const uint32_t dp)
 {
-	uint32_t mbuf_size, priv_size;
+	uint16_t mask = vq->size - 1;
+	uint16_t end, head;
+	uint64_t addr, len;
+
+	end = RTE_MIN(i + 2 * vq->prefetch_depth, nb_avail);
+	for (; *pf_desc < end; (*pf_desc)++) {
+		head = vq->avail->ring[(vq->last_avail_idx + *pf_desc) & mask];
+		rte_prefetch0(&vq->desc[head & mask]);
+	}
 
-	while (m) {
-		priv_size = rte_pktmbuf_priv_size(m->pool);
-		mbuf_size = sizeof(struct rte_mbuf) + priv_size;
-		/* start of buffer is after mbuf structure and priv data */
+	if (dp & VHOST_DP_IOMMU)
+		return;
 
-		m->buf_addr = (char *)m + mbuf_size;
-		m->buf_iova = rte_mempool_virt2iova(m) + mbuf_size;
-		m = m->next;
+	end = RTE_MIN(i + 1 + vq->prefetch_depth, nb_avail);
+	for (; *pf_buf < end; (*pf_buf)++) {
+		head = vq->avail->ring[(vq->last_avail_idx + *pf_buf) & mask];
+		len = vq->desc[head & mask].len;
+		addr = rte_vhost_va_from_guest_pa(dev->mem,
+				vq->desc[head & mask].addr, &len);
+		if (likely(addr != 0))
+			rte_prefetch0((void *)(uintptr_t)addr);
 	}
 }
 
 static __rte_always_inline uint16_t
 virtio_dev_tx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
-	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count,
+	const uint32_t dp)
 {
+	struct virtio_net_hdr hdrs[MAX_PKT_BURST];
+	uint64_t bytes = 0;
 	uint16_t i;
 	uint16_t free_entries;
+	uint16_t pf_desc = 0, pf_buf = 1;
 
-	if (unlikely(dev->dequeue_zero_copy)) {
-		struct zcopy_mbuf *zmbuf, *next;
-
-		for (zmbuf = TAILQ_FIRST(&vq->zmbuf_list);
-		     zmbuf != NULL; zmbuf = next) {
-			next = TAILQ_NEXT(zmbuf, next);
-
-			if (mbuf_is_consumed(zmbuf->mbuf)) {
-				update_shadow_used_ring_split(vq,
-						zmbuf->desc_idx, 0);
-				TAILQ_REMOVE(&vq->zmbuf_list, zmbuf, next);
-				restore_mbuf(zmbuf->mbuf);
-				rte_pktmbuf_free(zmbuf->mbuf);
-				put_zmbuf(zmbuf);
-				vq->nr_zmbuf -= 1;
-			}
-		}
+	if (unlikely(vq->resubmit_num))
+		return virtio_dev_tx_split_resubmit(dev, vq, mbuf_pool, pkts,
+				count, dp);
+
+	if (unlikely(dp & VHOST_DP_ZCOPY)) {
+		reclaim_zmbufs(dev, vq);
 
 		if (likely(vq->shadow_used_idx)) {
-			flush_shadow_used_ring_split(dev, vq);
+			flush_shadow_used_ring_split(dev, vq, dp);
 			vhost_vring_call_split(dev, vq);
 		}
 	}
@@ -1385,8 +2799,32 @@ virtio_dev_tx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		uint16_t head_idx;
 		uint32_t dummy_len;
 		uint16_t nr_vec = 0;
+		bool zcopy;
 		int err;
 
+		if (unlikely(vhost_budget_spent(vq, bytes)))
+			break;
+
+		if (vq->prefetch_depth)
+			vhost_prefetch_tx_split(dev, vq, i, free_entries,
+					&pf_desc, &pf_buf, dp);
+
+		zcopy = (dp & VHOST_DP_ZCOPY) &&
+			vq->nr_zmbuf < ZCOPY_MAX_INFLIGHT(vq);
+		if (unlikely((dp & VHOST_DP_ZCOPY) && !zcopy))
+			vq->stats.zcopy_fallbacks++;
+
+		if (likely(!zcopy) &&
+				i + VHOST_BATCH_SIZE <= count &&
+				virtio_dev_tx_batch_split(dev, vq, mbuf_pool,
+					&pkts[i], &hdrs[i],
+					vq->last_avail_idx + i, dp) == 0) {
+			bytes += vhost_budget_count(vq, &pkts[i],
+					VHOST_BATCH_SIZE);
+			i += VHOST_BATCH_SIZE - 1;
+			continue;
+		}
+
 		if (unlikely(fill_vec_buf_split(dev, vq,
 						vq->last_avail_idx + i,
 						&nr_vec, buf_vec,
@@ -1394,9 +2832,6 @@ virtio_dev_tx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 						VHOST_ACCESS_RO) < 0))
 			break;
 
-		if (likely(dev->dequeue_zero_copy == 0))
-			update_shadow_used_ring_split(vq, head_idx, 0);
-
 		rte_prefetch0((void *)(uintptr_t)buf_vec[0].buf_addr);
 
 		pkts[i] = rte_pktmbuf_alloc(mbuf_pool);
@@ -1407,20 +2842,19 @@ virtio_dev_tx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		}
 
 		err = copy_desc_to_mbuf(dev, vq, buf_vec, nr_vec, pkts[i],
-				mbuf_pool);
+				mbuf_pool, &hdrs[i], zcopy, dp);
 		if (unlikely(err)) {
 			rte_pktmbuf_free(pkts[i]);
 			break;
 		}
 
-		if (unlikely(dev->dequeue_zero_copy)) {
+		if (likely(!zcopy)) {
+			vhost_inflight_set_split(vq, head_idx);
+			update_shadow_used_ring_split(vq, head_idx, 0);
+		} else {
 			struct zcopy_mbuf *zmbuf;
 
-			zmbuf = get_zmbuf(vq);
-			if (!zmbuf) {
-				rte_pktmbuf_free(pkts[i]);
-				break;
-			}
+			zmbuf = &vq->zmbufs[vq->nr_zmbuf++];
 			zmbuf->mbuf = pkts[i];
 			zmbuf->desc_idx = head_idx;
 
@@ -1431,21 +2865,18 @@ virtio_dev_tx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			 * update the used ring safely.
 			 */
 			rte_mbuf_refcnt_update(pkts[i], 1);
-
-			vq->nr_zmbuf += 1;
-			TAILQ_INSERT_TAIL(&vq->zmbuf_list, zmbuf, next);
 		}
+
+		bytes += vhost_budget_count(vq, &pkts[i], 1);
 	}
 	vq->last_avail_idx += i;
 
-	if (likely(dev->dequeue_zero_copy == 0)) {
-		do_data_copy_dequeue(vq);
-		if (unlikely(i < count))
-			vq->shadow_used_idx = i;
-		if (likely(vq->shadow_used_idx)) {
-			flush_shadow_used_ring_split(dev, vq);
-			vhost_vring_call_split(dev, vq);
-		}
+	do_data_copy_dequeue(vq);
+	if (dp & VHOST_DP_HOST_OFFLOAD)
+		vhost_dequeue_offload_burst(hdrs, pkts, i);
+	if (likely(vq->shadow_used_idx)) {
+		flush_shadow_used_ring_split(dev, vq, dp);
+		vhost_vring_call_split(dev, vq);
 	}
 
 	return i;
@@ -1453,35 +2884,20 @@ virtio_dev_tx_split(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 static __rte_always_inline uint16_t
 virtio_dev_tx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
-	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count,
+	const uint32_t dp)
 {
+	struct virtio_net_hdr hdrs[MAX_PKT_BURST];
+	uint64_t bytes = 0;
 	uint16_t i;
 
 	rte_prefetch0(&vq->desc_packed[vq->last_avail_idx]);
 
-	if (unlikely(dev->dequeue_zero_copy)) {
-		struct zcopy_mbuf *zmbuf, *next;
-
-		for (zmbuf = TAILQ_FIRST(&vq->zmbuf_list);
-		     zmbuf != NULL; zmbuf = next) {
-			next = TAILQ_NEXT(zmbuf, next);
-
-			if (mbuf_is_consumed(zmbuf->mbuf)) {
-				update_shadow_used_ring_packed(vq,
-						zmbuf->desc_idx,
-						0,
-						zmbuf->desc_count);
-
-				TAILQ_REMOVE(&vq->zmbuf_list, zmbuf, next);
-				restore_mbuf(zmbuf->mbuf);
-				rte_pktmbuf_free(zmbuf->mbuf);
-				put_zmbuf(zmbuf);
-				vq->nr_zmbuf -= 1;
-			}
-		}
+	if (unlikely(dp & VHOST_DP_ZCOPY)) {
+		reclaim_zmbufs(dev, vq);
 
 		if (likely(vq->shadow_used_idx)) {
-			flush_shadow_used_ring_packed(dev, vq);
+			flush_shadow_used_ring_packed(dev, vq, dp);
 			vhost_vring_call_packed(dev, vq);
 		}
 	}
@@ -1497,8 +2913,27 @@ virtio_dev_tx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		uint16_t buf_id;
 		uint32_t dummy_len;
 		uint16_t desc_count, nr_vec = 0;
+		bool zcopy;
 		int err;
 
+		if (unlikely(vhost_budget_spent(vq, bytes)))
+			break;
+
+		zcopy = (dp & VHOST_DP_ZCOPY) &&
+			vq->nr_zmbuf < ZCOPY_MAX_INFLIGHT(vq);
+		if (unlikely((dp & VHOST_DP_ZCOPY) && !zcopy))
+			vq->stats.zcopy_fallbacks++;
+
+		if (likely(!zcopy) &&
+				i + VHOST_BATCH_SIZE <= count &&
+				virtio_dev_tx_batch_packed(dev, vq, mbuf_pool,
+					&pkts[i], &hdrs[i], dp) == 0) {
+			bytes += vhost_budget_count(vq, &pkts[i],
+					VHOST_BATCH_SIZE);
+			i += VHOST_BATCH_SIZE - 1;
+			continue;
+		}
+
 		if (unlikely(fill_vec_buf_packed(dev, vq,
 						vq->last_avail_idx, &desc_count,
 						buf_vec, &nr_vec,
@@ -1506,10 +2941,6 @@ virtio_dev_tx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 						VHOST_ACCESS_RO) < 0))
 			break;
 
-		if (likely(dev->dequeue_zero_copy == 0))
-			update_shadow_used_ring_packed(vq, buf_id, 0,
-					desc_count);
-
 		rte_prefetch0((void *)(uintptr_t)buf_vec[0].buf_addr);
 
 		pkts[i] = rte_pktmbuf_alloc(mbuf_pool);
@@ -1520,20 +2951,19 @@ virtio_dev_tx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		}
 
 		err = copy_desc_to_mbuf(dev, vq, buf_vec, nr_vec, pkts[i],
-				mbuf_pool);
+				mbuf_pool, &hdrs[i], zcopy, dp);
 		if (unlikely(err)) {
 			rte_pktmbuf_free(pkts[i]);
 			break;
 		}
 
-		if (unlikely(dev->dequeue_zero_copy)) {
+		if (likely(!zcopy)) {
+			update_shadow_used_ring_packed(vq, buf_id, 0,
+					desc_count);
+		} else {
 			struct zcopy_mbuf *zmbuf;
 
-			zmbuf = get_zmbuf(vq);
-			if (!zmbuf) {
-				rte_pktmbuf_free(pkts[i]);
-				break;
-			}
+			zmbuf = &vq->zmbufs[vq->nr_zmbuf++];
 			zmbuf->mbuf = pkts[i];
 			zmbuf->desc_idx = buf_id;
 			zmbuf->desc_count = desc_count;
@@ -1545,9 +2975,6 @@ virtio_dev_tx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			 * update the used ring safely.
 			 */
 			rte_mbuf_refcnt_update(pkts[i], 1);
-
-			vq->nr_zmbuf += 1;
-			TAILQ_INSERT_TAIL(&vq->zmbuf_list, zmbuf, next);
 		}
 
 		vq->last_avail_idx += desc_count;
@@ -1555,39 +2982,36 @@ virtio_dev_tx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
 			vq->last_avail_idx -= vq->size;
 			vq->avail_wrap_counter ^= 1;
 		}
+
+		bytes += vhost_budget_count(vq, &pkts[i], 1);
 	}
 
-	if (likely(dev->dequeue_zero_copy == 0)) {
-		do_data_copy_dequeue(vq);
-		if (unlikely(i < count))
-			vq->shadow_used_idx = i;
-		if (likely(vq->shadow_used_idx)) {
-			flush_shadow_used_ring_packed(dev, vq);
-			vhost_vring_call_packed(dev, vq);
-		}
+	do_data_copy_dequeue(vq);
+	if (dp & VHOST_DP_HOST_OFFLOAD)
+		vhost_dequeue_offload_burst(hdrs, pkts, i);
+	if (likely(vq->shadow_used_idx)) {
+		flush_shadow_used_ring_packed(dev, vq, dp);
+		vhost_vring_call_packed(dev, vq);
 	}
 
 	return i;
 }
 
-uint16_t
-rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
-	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
+static uint16_t virtio_dev_tx_generic(struct virtio_net *dev,
+	uint16_t queue_id, struct rte_mempool *mbuf_pool,
+	struct rte_mbuf **pkts, uint16_t count);
+
+/* The variant is checked once locked, as in virtio_dev_rx() */
+static __rte_always_inline uint16_t
+virtio_dev_tx(struct virtio_net *dev, uint16_t queue_id,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count,
+	const uint8_t variant, const uint32_t variant_dp)
 {
-	struct virtio_net *dev;
 	struct rte_mbuf *rarp_mbuf = NULL;
 	struct vhost_virtqueue *vq;
-
-	dev = get_device(vid);
-	if (!dev)
-		return 0;
-
-	if (unlikely(!(dev->flags & VIRTIO_DEV_BUILTIN_VIRTIO_NET))) {
-		RTE_LOG(ERR, VHOST_DATA,
-			"(%d) %s: built-in vhost net backend is disabled.\n",
-			dev->vid, __func__);
-		return 0;
-	}
+	uint16_t nb_req;
+	uint32_t dp;
+	uint64_t tsc;
 
 	if (unlikely(!is_valid_virt_queue_idx(queue_id, 1, dev->nr_vring))) {
 		RTE_LOG(ERR, VHOST_DATA, "(%d) %s: invalid virtqueue idx %d.\n",
@@ -1597,15 +3021,32 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 
 	vq = dev->virtqueue[queue_id];
 
-	if (unlikely(rte_spinlock_trylock(&vq->access_lock) == 0))
+	if (unlikely(!vhost_vq_dp_enter(dev, vq, true)))
 		return 0;
 
+	if (variant == VHOST_DP_GENERIC) {
+		dp = vhost_dp_flags(dev);
+	} else if (unlikely(dev->dp_tx != variant)) {
+		vhost_vq_dp_leave(dev, vq);
+		return virtio_dev_tx_generic(dev, queue_id, mbuf_pool, pkts,
+				count);
+	} else {
+		dp = variant_dp;
+	}
+
+	vhost_vring_stats_begin(&vq->stats);
+	tsc = vhost_burst_tune_begin(vq);
+
+	if (count == RTE_VHOST_BURST_AUTO)
+		count = vq->burst_tune.max_burst ? vq->burst_tune.burst :
+			RTE_VHOST_BURST_MAX;
+
 	if (unlikely(vq->enabled == 0)) {
 		count = 0;
 		goto out_access_unlock;
 	}
 
-	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+	if (dp & VHOST_DP_IOMMU)
 		vhost_user_iotlb_rd_lock(vq);
 
 	if (unlikely(vq->access_ok == 0))
@@ -1614,6 +3055,9 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 			goto out;
 		}
 
+	if (unlikely(!vq->numa_checked))
+		vhost_vring_check_numa(dev, vq);
+
 	/*
 	 * Construct a RARP broadcast packet, and inject it to the "pkts"
 	 * array, to looks like that guest actually send such packet.
@@ -1643,17 +3087,31 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 		count -= 1;
 	}
 
-	if (vq_is_packed(dev))
-		count = virtio_dev_tx_packed(dev, vq, mbuf_pool, pkts, count);
+	nb_req = count;
+	VHOST_TRACE(dev->vid, queue_id, AVAIL, (dp & VHOST_DP_PACKED) ?
+			vq->last_avail_idx : vq->avail->idx);
+	if (dp & VHOST_DP_PACKED)
+		count = virtio_dev_tx_packed(dev, vq, mbuf_pool, pkts, count,
+				dp);
 	else
-		count = virtio_dev_tx_split(dev, vq, mbuf_pool, pkts, count);
+		count = virtio_dev_tx_split(dev, vq, mbuf_pool, pkts, count,
+				dp);
+	if (count != 0)
+		VHOST_TRACE(dev->vid, queue_id, USED, vq->last_used_idx);
+
+	vhost_vring_stats_burst(vq, pkts, count, count == 0);
+	vhost_burst_tune_end(vq, tsc, count, count == nb_req);
+
+	if (count == 0)
+		vhost_vring_call_flush(dev, vq);
 
 out:
-	if (dev->features & (1ULL << VIRTIO_F_IOMMU_PLATFORM))
+	if (dp & VHOST_DP_IOMMU)
 		vhost_user_iotlb_rd_unlock(vq);
 
 out_access_unlock:
-	rte_spinlock_unlock(&vq->access_lock);
+	vhost_vring_stats_end(&vq->stats);
+	vhost_vq_dp_leave(dev, vq);
 
 	if (unlikely(rarp_mbuf != NULL)) {
 		/*
@@ -1667,3 +3125,91 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 
 	return count;
 }
+
+typedef uint16_t (*virtio_dev_tx_t)(struct virtio_net *dev,
+	uint16_t queue_id, struct rte_mempool *mbuf_pool,
+	struct rte_mbuf **pkts, uint16_t count);
+
+static uint16_t
+virtio_dev_tx_generic(struct virtio_net *dev, uint16_t queue_id,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
+{
+	return virtio_dev_tx(dev, queue_id, mbuf_pool, pkts, count,
+			VHOST_DP_GENERIC, 0);
+}
+
+#define VIRTIO_DEV_TX_VARIANT(name, dp)					\
+static uint16_t								\
+name(struct virtio_net *dev, uint16_t queue_id,				\
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts,		\
+	uint16_t count)							\
+{									\
+	return virtio_dev_tx(dev, queue_id, mbuf_pool, pkts, count,	\
+			VHOST_DP_VARIANT(dp), dp);			\
+}
+
+VIRTIO_DEV_TX_VARIANT(virtio_dev_tx_split_std, 0)
+VIRTIO_DEV_TX_VARIANT(virtio_dev_tx_split_offload, VHOST_DP_HOST_OFFLOAD)
+VIRTIO_DEV_TX_VARIANT(virtio_dev_tx_packed_std, VHOST_DP_PACKED)
+VIRTIO_DEV_TX_VARIANT(virtio_dev_tx_packed_offload,
+	VHOST_DP_PACKED | VHOST_DP_HOST_OFFLOAD)
+
+/* Indexed by dev->dp_tx, see vhost_select_datapath() */
+static const virtio_dev_tx_t virtio_dev_tx_variants[] = {
+	[VHOST_DP_GENERIC] = virtio_dev_tx_generic,
+	[VHOST_DP_VARIANT(0)] = virtio_dev_tx_split_std,
+	[VHOST_DP_VARIANT(VHOST_DP_HOST_OFFLOAD)] =
+		virtio_dev_tx_split_offload,
+	[VHOST_DP_VARIANT(VHOST_DP_PACKED)] = virtio_dev_tx_packed_std,
+	[VHOST_DP_VARIANT(VHOST_DP_PACKED | VHOST_DP_HOST_OFFLOAD)] =
+		virtio_dev_tx_packed_offload,
+};
+
+uint16_t
+rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
+{
+	struct virtio_net *dev;
+
+	dev = get_device(vid);
+	if (!dev)
+		return 0;
+
+	if (unlikely(!(dev->flags & VIRTIO_DEV_BUILTIN_VIRTIO_NET))) {
+		RTE_LOG(ERR, VHOST_DATA,
+			"(%d) %s: built-in vhost net backend is disabled.\n",
+			dev->vid, __func__);
+		return 0;
+	}
+
+	return virtio_dev_tx_variants[dev->dp_tx](dev, queue_id, mbuf_pool,
+			pkts, count);
+}
+
+/*
+ * Specialized variants are only provided for the common feature
+ * combinations, the devices with an IOMMU, dirty page logging or
+ * dequeue zero copy use the generic ones.
+ */
+void
+vhost_select_datapath(struct virtio_net *dev)
+{
+	uint32_t dp = vhost_dp_flags(dev);
+
+	if (dp & (VHOST_DP_IOMMU | VHOST_DP_LOG)) {
+		dev->dp_rx = VHOST_DP_GENERIC;
+		dev->dp_tx = VHOST_DP_GENERIC;
+	} else {
+		dev->dp_rx = VHOST_DP_VARIANT(dp &
+				(VHOST_DP_PACKED | VHOST_DP_MRG_RXBUF));
+		if (dp & VHOST_DP_ZCOPY)
+			dev->dp_tx = VHOST_DP_GENERIC;
+		else
+			dev->dp_tx = VHOST_DP_VARIANT(dp &
+				(VHOST_DP_PACKED | VHOST_DP_HOST_OFFLOAD));
+	}
+
+	VHOST_LOG_DEBUG(VHOST_CONFIG,
+		"(%d) datapath variants: rx %u, tx %u\n",
+		dev->vid, dev->dp_rx, dev->dp_tx);
+}
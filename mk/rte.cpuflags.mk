@@ -68,6 +68,9 @@ endif
 ifneq ($(filter $(AUTO_CPUFLAGS),__AVX512F__),)
 ifeq ($(CONFIG_RTE_ENABLE_AVX512),y)
 CPUFLAGS += AVX512F
+ifneq ($(filter $(AUTO_CPUFLAGS),__AVX512BW__),)
+CPUFLAGS += AVX512BW
+endif
 else
 # disable AVX512F support of gcc as a workaround for Bug 97
 ifeq ($(CONFIG_RTE_TOOLCHAIN_GCC),y)
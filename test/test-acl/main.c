@@ -6,6 +6,7 @@
 #include <getopt.h>
 #include <string.h>
 
+#include <rte_cpuflags.h>
 #include <rte_cycles.h>
 #include <rte_per_lcore.h>
 #include <rte_lcore.h>
@@ -40,6 +41,7 @@
 #define	OPT_ITER_NUM		"iter"
 #define	OPT_VERBOSE		"verbose"
 #define	OPT_IPV6		"ipv6"
+#define	OPT_BENCH		"bench"
 
 #define	TRACE_DEFAULT_NUM	0x10000
 #define	TRACE_STEP_MAX		0x1000
@@ -80,6 +82,10 @@ static const struct acl_alg acl_alg[] = {
 		.name = "altivec",
 		.alg = RTE_ACL_CLASSIFY_ALTIVEC,
 	},
+	{
+		.name = "avx512",
+		.alg = RTE_ACL_CLASSIFY_AVX512,
+	},
 };
 
 static struct {
@@ -96,6 +102,7 @@ static struct {
 	uint32_t            iter_num;
 	uint32_t            verbose;
 	uint32_t            ipv6;
+	uint32_t            bench;
 	struct acl_alg      alg;
 	uint32_t            used_traces;
 	void               *traces;
@@ -881,6 +888,71 @@ search_ip5tuples(__attribute__((unused)) void *arg)
 	return 0;
 }
 
+/*
+ * Check that a classify method is built in and supported by the cpu,
+ * classifying no packet so that the check runs no vector instruction.
+ */
+static int
+alg_supported(enum rte_acl_classify_alg alg)
+{
+	const uint8_t *data = NULL;
+	uint32_t result;
+
+#if defined(RTE_ARCH_X86)
+	if ((alg == RTE_ACL_CLASSIFY_SSE &&
+			!rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE4_1)) ||
+			(alg == RTE_ACL_CLASSIFY_AVX2 &&
+			!rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2)) ||
+			(alg == RTE_ACL_CLASSIFY_AVX512 &&
+			(!rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) ||
+			!rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW))))
+		return 0;
+#endif
+
+	return rte_acl_classify_alg(config.acx, &data, &result, 0, 1,
+		alg) == 0;
+}
+
+/*
+ * Run the same traces with each classify method available on this
+ * machine, on the master lcore only.
+ */
+static void
+bench_ip5tuples(void)
+{
+	uint64_t pkt, start, tm;
+	uint32_t i, j;
+
+	for (j = 0; j != RTE_DIM(acl_alg); j++) {
+
+		if (!alg_supported(acl_alg[j].alg)) {
+			dump_verbose(DUMP_NONE, stdout,
+				"%s: %s not supported\n", __func__,
+				acl_alg[j].name);
+			continue;
+		}
+
+		rte_acl_set_ctx_classify(config.acx, acl_alg[j].alg);
+
+		start = rte_rdtsc();
+		pkt = 0;
+
+		for (i = 0; i != config.iter_num; i++) {
+			pkt += search_ip5tuples_once(config.run_categories,
+				config.trace_step, acl_alg[j].name);
+		}
+
+		tm = rte_rdtsc() - start;
+		dump_verbose(DUMP_NONE, stdout,
+			"%s: %s: %" PRIu32 " iterations, %" PRIu64 " pkts, %"
+			PRIu32 " categories, %" PRIu64 " cycles, "
+			"%#Lf cycles/pkt\n",
+			__func__, acl_alg[j].name, i, pkt,
+			config.run_categories, tm,
+			(pkt == 0) ? 0 : (long double)tm / pkt);
+	}
+}
+
 static unsigned long
 get_ulong_opt(const char *opt, const char *name, size_t min, size_t max)
 {
@@ -952,7 +1024,9 @@ print_usage(const char *prgname)
 		"[--" OPT_ITER_NUM "=<number of iterations to perform>]\n"
 		"[--" OPT_VERBOSE "=<verbose level>]\n"
 		"[--" OPT_SEARCH_ALG "=%s]\n"
-		"[--" OPT_IPV6 "=<IPv6 rules and trace files>]\n",
+		"[--" OPT_IPV6 "=<IPv6 rules and trace files>]\n"
+		"[--" OPT_BENCH "=<compare all the available "
+			"classify methods>]\n",
 		prgname, RTE_ACL_RESULTS_MULTIPLIER,
 		(uint32_t)RTE_ACL_MAX_CATEGORIES,
 		buf);
@@ -975,6 +1049,7 @@ dump_config(FILE *f)
 	fprintf(f, "%s:%u(%s)\n", OPT_SEARCH_ALG, config.alg.alg,
 		config.alg.name);
 	fprintf(f, "%s:%u\n", OPT_IPV6, config.ipv6);
+	fprintf(f, "%s:%u\n", OPT_BENCH, config.bench);
 }
 
 static void
@@ -985,6 +1060,11 @@ check_config(void)
 		rte_exit(-EINVAL, "mandatory option %s is not specified\n",
 			OPT_RULE_FILE);
 	}
+	if (config.bench != 0 && config.trace_file == NULL) {
+		print_usage(config.prgname);
+		rte_exit(-EINVAL, "option %s requires option %s\n",
+			OPT_BENCH, OPT_TRACE_FILE);
+	}
 }
 
 
@@ -1004,6 +1084,7 @@ get_input_opts(int argc, char **argv)
 		{OPT_VERBOSE, 1, 0, 0},
 		{OPT_SEARCH_ALG, 1, 0, 0},
 		{OPT_IPV6, 0, 0, 0},
+		{OPT_BENCH, 0, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 
@@ -1053,6 +1134,8 @@ get_input_opts(int argc, char **argv)
 			get_alg_opt(optarg, lgopts[opt_idx].name);
 		} else if (strcmp(lgopts[opt_idx].name, OPT_IPV6) == 0) {
 			config.ipv6 = 1;
+		} else if (strcmp(lgopts[opt_idx].name, OPT_BENCH) == 0) {
+			config.bench = 1;
 		}
 	}
 	config.trace_sz = config.ipv6 ? sizeof(struct ipv6_5tuple) :
@@ -1084,12 +1167,16 @@ main(int argc, char **argv)
 	if (config.trace_file != NULL)
 		tracef_init();
 
-	RTE_LCORE_FOREACH_SLAVE(lcore)
-		 rte_eal_remote_launch(search_ip5tuples, NULL, lcore);
+	if (config.bench != 0) {
+		bench_ip5tuples();
+	} else {
+		RTE_LCORE_FOREACH_SLAVE(lcore)
+			rte_eal_remote_launch(search_ip5tuples, NULL, lcore);
 
-	search_ip5tuples(NULL);
+		search_ip5tuples(NULL);
 
-	rte_eal_mp_wait_lcore();
+		rte_eal_mp_wait_lcore();
+	}
 
 	rte_acl_free(config.acx);
 	return 0;
@@ -87,6 +87,38 @@ app_parse_port_mask(const char *arg)
 	return 0;
 }
 
+static int
+app_parse_vhost(const char *arg)
+{
+	char *end = NULL;
+	unsigned long n;
+
+	n = strtoul(arg, &end, 0);
+	if ((end == NULL) || (*end != '\0'))
+		return -1;
+
+	/* Each port sends to its neighbour */
+	if ((n < 2) || (n > APP_MAX_PORTS) || !rte_is_power_of_2(n))
+		return -2;
+
+	app.vhost = n;
+	app.n_ports = n;
+
+	return 0;
+}
+
+static int
+app_parse_pkt_seed(const char *arg)
+{
+	char *end = NULL;
+
+	app.pkt_seed = strtoull(arg, &end, 0);
+	if ((arg[0] == '\0') || (end == NULL) || (*end != '\0'))
+		return -1;
+
+	return 0;
+}
+
 struct {
 	const char *name;
 	uint32_t value;
@@ -153,9 +185,11 @@ app_parse_args(int argc, char **argv)
 		{"hash-cuckoo-96", 0, 0, 0},
 		{"hash-cuckoo-112", 0, 0, 0},
 		{"hash-cuckoo-128", 0, 0, 0},
+		{"vhost", 1, 0, 0},
+		{"pkt-seed", 1, 0, 0},
 		{NULL, 0, 0, 0}
 	};
-	uint32_t lcores[3], n_lcores, lcore_id, pipeline_type_provided;
+	uint32_t lcores[4], n_lcores, lcore_id, pipeline_type_provided;
 
 	/* EAL args */
 	n_lcores = 0;
@@ -163,8 +197,9 @@ app_parse_args(int argc, char **argv)
 		if (rte_lcore_is_enabled(lcore_id) == 0)
 			continue;
 
-		if (n_lcores >= 3) {
-			RTE_LOG(ERR, USER1, "Number of cores must be 3\n");
+		if (n_lcores >= 4) {
+			RTE_LOG(ERR, USER1,
+				"Number of cores must be 3, or 4 with --vhost\n");
 			app_print_usage();
 			return -1;
 		}
@@ -173,16 +208,6 @@ app_parse_args(int argc, char **argv)
 		n_lcores++;
 	}
 
-	if (n_lcores != 3) {
-		RTE_LOG(ERR, USER1, "Number of cores must be 3\n");
-		app_print_usage();
-		return -1;
-	}
-
-	app.core_rx = lcores[0];
-	app.core_worker = lcores[1];
-	app.core_tx = lcores[2];
-
 	/* Non-EAL args */
 	argvopt = argv;
 
@@ -200,6 +225,22 @@ app_parse_args(int argc, char **argv)
 			break;
 
 		case 0: /* long options */
+			if (!strcmp(lgopts[option_index].name, "vhost")) {
+				if (app_parse_vhost(optarg) < 0) {
+					app_print_usage();
+					return -1;
+				}
+				break;
+			}
+
+			if (!strcmp(lgopts[option_index].name, "pkt-seed")) {
+				if (app_parse_pkt_seed(optarg) < 0) {
+					app_print_usage();
+					return -1;
+				}
+				break;
+			}
+
 			if (!pipeline_type_provided) {
 				uint32_t i;
 
@@ -224,6 +265,19 @@ app_parse_args(int argc, char **argv)
 		}
 	}
 
+	/* The virtio-user peers run on a fourth core */
+	if (n_lcores != (app.vhost ? 4U : 3U)) {
+		RTE_LOG(ERR, USER1, "Number of cores must be %u\n",
+			app.vhost ? 4 : 3);
+		app_print_usage();
+		return -1;
+	}
+
+	app.core_rx = lcores[0];
+	app.core_worker = lcores[1];
+	app.core_tx = lcores[2];
+	app.core_peer = app.vhost ? lcores[3] : RTE_MAX_LCORE;
+
 	if (optind >= 0)
 		argv[optind - 1] = prgname;
 
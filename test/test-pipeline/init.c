@@ -151,11 +151,17 @@ app_init_rings(void)
 
 }
 
+/* vhost ports come up once their virtio-user peer started */
+#define APP_LINK_WAIT_MS 5000
+
 static void
 app_ports_check_link(void)
 {
-	uint32_t all_ports_up, i;
+	uint32_t all_ports_up, i, n_retries;
+
+	n_retries = app.vhost ? APP_LINK_WAIT_MS / 10 : 0;
 
+check:
 	all_ports_up = 1;
 
 	for (i = 0; i < app.n_ports; i++) {
@@ -174,6 +180,11 @@ app_ports_check_link(void)
 			all_ports_up = 0;
 	}
 
+	if ((all_ports_up == 0) && (n_retries-- > 0)) {
+		rte_delay_ms(10);
+		goto check;
+	}
+
 	if (all_ports_up == 0)
 		rte_panic("Some NIC ports are DOWN\n");
 }
@@ -185,18 +196,26 @@ app_init_ports(void)
 
 	/* Init NIC ports, then start the ports */
 	for (i = 0; i < app.n_ports; i++) {
+		struct rte_eth_conf local_port_conf = port_conf;
+		struct rte_eth_dev_info dev_info;
 		uint16_t port;
 		int ret;
 
 		port = app.ports[i];
 		RTE_LOG(INFO, USER1, "Initializing NIC port %u ...\n", port);
 
+		/* Virtual ports offer no checksum offload nor RSS */
+		rte_eth_dev_info_get(port, &dev_info);
+		local_port_conf.rxmode.offloads &= dev_info.rx_offload_capa;
+		local_port_conf.rx_adv_conf.rss_conf.rss_hf &=
+			dev_info.flow_type_rss_offloads;
+
 		/* Init port */
 		ret = rte_eth_dev_configure(
 			port,
 			1,
 			1,
-			&port_conf);
+			&local_port_conf);
 		if (ret < 0)
 			rte_panic("Cannot init NIC port %u (%d)\n", port, ret);
 
@@ -230,16 +249,19 @@ app_init_ports(void)
 		if (ret < 0)
 			rte_panic("Cannot start port %u (%d)\n", port, ret);
 	}
-
-	app_ports_check_link();
 }
 
 void
 app_init(void)
 {
 	app_init_mbuf_pools();
+	if (app.vhost)
+		app_init_vhost();
 	app_init_rings();
 	app_init_ports();
+	if (app.vhost)
+		app_init_peer_ports();
+	app_ports_check_link();
 
 	RTE_LOG(INFO, USER1, "Initialization completed\n");
 }
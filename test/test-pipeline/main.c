@@ -153,5 +153,10 @@ app_lcore_main_loop(__attribute__((unused)) void *arg)
 		return 0;
 	}
 
+	if (lcore == app.core_peer) {
+		app_main_loop_peer();
+		return 0;
+	}
+
 	return 0;
 }
@@ -18,15 +18,38 @@ struct app_mbuf_array {
 #define APP_MAX_PORTS 4
 #endif
 
+/* Stages the cycles are attributed to, with --vhost */
+enum {
+	e_APP_STAGE_RX = 0,
+	e_APP_STAGE_WORKER,
+	e_APP_STAGE_TX,
+	e_APP_STAGE_PEER_TX,
+	e_APP_STAGE_PEER_RX,
+	e_APP_STAGES
+};
+
+struct app_stage_stats {
+	uint64_t pkts;
+	uint64_t bursts;
+	uint64_t cycles;
+} __rte_cache_aligned;
+
 struct app_params {
 	/* CPU cores */
 	uint32_t core_rx;
 	uint32_t core_worker;
 	uint32_t core_tx;
+	uint32_t core_peer;
 
 	/* Ports*/
 	uint32_t ports[APP_MAX_PORTS];
 	uint32_t n_ports;
+
+	/* vhost ports, each fed by a virtio-user peer port */
+	uint32_t vhost;
+	uint32_t peer_ports[APP_MAX_PORTS];
+	uint64_t pkt_seed;
+	struct app_stage_stats stats[e_APP_STAGES];
 	uint32_t port_rx_ring_size;
 	uint32_t port_tx_ring_size;
 
@@ -119,6 +142,30 @@ void app_main_loop_worker_pipeline_lpm(void);
 void app_main_loop_worker_pipeline_lpm_ipv6(void);
 
 void app_main_loop_tx(void);
+void app_main_loop_peer(void);
+
+void app_init_vhost(void);
+void app_init_peer_ports(void);
+
+/* Busy cycles of a stage: the iterations which moved packets */
+static inline uint64_t
+app_stage_begin(void)
+{
+	return app.vhost ? rte_rdtsc() : 0;
+}
+
+static inline void
+app_stage_end(uint32_t stage, uint64_t tsc, uint32_t n_pkts)
+{
+	struct app_stage_stats *stats = &app.stats[stage];
+
+	if (!app.vhost || n_pkts == 0)
+		return;
+
+	stats->cycles += rte_rdtsc() - tsc;
+	stats->bursts++;
+	stats->pkts += n_pkts;
+}
 
 #define APP_FLUSH 0
 #ifndef APP_FLUSH
@@ -0,0 +1,250 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_byteorder.h>
+#include <rte_log.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <rte_random.h>
+#include <rte_debug.h>
+#include <rte_ether.h>
+#include <rte_ethdev.h>
+#include <rte_bus_vdev.h>
+#include <rte_mempool.h>
+#include <rte_mbuf.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+
+#include "main.h"
+
+/*
+ * With --vhost, the ports of the pipeline are vhost ports, each connected
+ * to a virtio-user port of the same process standing for the VM. The peer
+ * core sends the input traffic through the virtio-user ports and drops what
+ * comes back, so the vrings are crossed twice by each packet.
+ */
+
+#define APP_PEER_QUEUE_SIZE 1024
+#define APP_PEER_BURST 32
+#define APP_STATS_PERIOD_MS 1000
+
+/*
+ * Frame sizes of the packet mix, CRC excluded: 7 x 64, 4 x 594 and
+ * 1 x 1518 bytes, in this order.
+ */
+static const uint16_t app_pkt_mix[] = {
+	60, 60, 60, 590, 60, 60, 590, 60, 60, 590, 1514, 590,
+};
+
+static const char * const app_stage_names[] = {
+	[e_APP_STAGE_RX] = "rx",
+	[e_APP_STAGE_WORKER] = "worker",
+	[e_APP_STAGE_TX] = "tx",
+	[e_APP_STAGE_PEER_TX] = "peer-tx",
+	[e_APP_STAGE_PEER_RX] = "peer-rx",
+};
+
+static uint16_t
+app_create_port(const char *name, const char *args)
+{
+	uint16_t port;
+
+	if ((rte_vdev_init(name, args) < 0) ||
+	    (rte_eth_dev_get_port_by_name(name, &port) != 0))
+		rte_panic("Cannot create port %s (%s)\n", name, args);
+
+	return port;
+}
+
+void
+app_init_vhost(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < app.vhost; i++) {
+		char path[PATH_MAX], name[RTE_ETH_NAME_MAX_LEN];
+		char args[PATH_MAX + 64];
+
+		snprintf(path, sizeof(path), "/tmp/test-pipeline-vhost%u-%d",
+			i, getpid());
+		unlink(path);
+
+		snprintf(name, sizeof(name), "net_vhost_tp%u", i);
+		snprintf(args, sizeof(args), "iface=%s,queues=1", path);
+		app.ports[i] = app_create_port(name, args);
+
+		/* Connects to the vhost port, which listens on the path */
+		snprintf(name, sizeof(name), "net_virtio_user_tp%u", i);
+		snprintf(args, sizeof(args), "path=%s,queues=1,queue_size=%u",
+			path, APP_PEER_QUEUE_SIZE);
+		app.peer_ports[i] = app_create_port(name, args);
+
+		RTE_LOG(INFO, USER1, "Port %u fed by virtio-user port %u\n",
+			app.ports[i], app.peer_ports[i]);
+	}
+
+	app.n_ports = app.vhost;
+}
+
+void
+app_init_peer_ports(void)
+{
+	static const struct rte_eth_conf peer_conf;
+	uint32_t i;
+
+	for (i = 0; i < app.vhost; i++) {
+		uint16_t port = app.peer_ports[i];
+		int ret;
+
+		ret = rte_eth_dev_configure(port, 1, 1, &peer_conf);
+		if (ret < 0)
+			rte_panic("Cannot init peer port %u (%d)\n", port, ret);
+
+		ret = rte_eth_rx_queue_setup(port, 0, APP_PEER_QUEUE_SIZE,
+			rte_eth_dev_socket_id(port), NULL, app.pool);
+		if (ret < 0)
+			rte_panic("Cannot init RX for peer port %u (%d)\n",
+				port, ret);
+
+		ret = rte_eth_tx_queue_setup(port, 0, APP_PEER_QUEUE_SIZE,
+			rte_eth_dev_socket_id(port), NULL);
+		if (ret < 0)
+			rte_panic("Cannot init TX for peer port %u (%d)\n",
+				port, ret);
+
+		/* The vhost port gets its device from there */
+		ret = rte_eth_dev_start(port);
+		if (ret < 0)
+			rte_panic("Cannot start peer port %u (%d)\n",
+				port, ret);
+	}
+}
+
+/*
+ * TCP packets to A.B.C.D with A fixed to 0 and B.C.D random, as described
+ * in the guide, over IPv6 for the IPv6 LPM pipeline.
+ */
+static void
+app_peer_build_pkt(struct rte_mbuf *m, uint32_t seq)
+{
+	uint16_t len = app_pkt_mix[seq % RTE_DIM(app_pkt_mix)];
+	struct ether_hdr *eth = rte_pktmbuf_mtod(m, struct ether_hdr *);
+	uint32_t dst = (uint32_t)rte_rand() & 0x00FFFFFF;
+	struct tcp_hdr *tcp;
+
+	memset(eth, 0, sizeof(*eth) + sizeof(struct ipv6_hdr) +
+		sizeof(struct tcp_hdr));
+
+	if (app.pipeline_type == e_APP_PIPELINE_LPM_IPV6) {
+		struct ipv6_hdr *ip = (struct ipv6_hdr *)(eth + 1);
+
+		eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv6);
+		ip->vtc_flow = rte_cpu_to_be_32(0x60000000);
+		ip->payload_len = rte_cpu_to_be_16(len - sizeof(*eth) -
+			sizeof(*ip));
+		ip->proto = IPPROTO_TCP;
+		ip->hop_limits = 64;
+		dst = rte_cpu_to_be_32(dst);
+		memcpy(ip->dst_addr, &dst, sizeof(dst));
+		tcp = (struct tcp_hdr *)(ip + 1);
+	} else {
+		struct ipv4_hdr *ip = (struct ipv4_hdr *)(eth + 1);
+
+		eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+		ip->version_ihl = 0x45;
+		ip->total_length = rte_cpu_to_be_16(len - sizeof(*eth));
+		ip->time_to_live = 64;
+		ip->next_proto_id = IPPROTO_TCP;
+		ip->dst_addr = rte_cpu_to_be_32(dst);
+		ip->hdr_checksum = rte_ipv4_cksum(ip);
+		tcp = (struct tcp_hdr *)(ip + 1);
+	}
+	tcp->data_off = 0x50;
+
+	m->data_len = len;
+	m->pkt_len = len;
+}
+
+/* Busy share of each stage on its core and its cost per packet */
+static void
+app_stats_print(uint64_t tsc_elapsed)
+{
+	static struct app_stage_stats prev[e_APP_STAGES];
+	double hz = rte_get_tsc_hz();
+	uint32_t i;
+
+	printf("\n%-10s%12s%12s%12s%12s\n",
+		"Stage", "Mpps", "Pkts/Burst", "Cycles/Pkt", "Busy %");
+
+	for (i = 0; i < e_APP_STAGES; i++) {
+		struct app_stage_stats cur = app.stats[i];
+		uint64_t pkts = cur.pkts - prev[i].pkts;
+		uint64_t bursts = cur.bursts - prev[i].bursts;
+		uint64_t cycles = cur.cycles - prev[i].cycles;
+
+		printf("%-10s%12.3f%12.1f%12.1f%12.1f\n", app_stage_names[i],
+			pkts * hz / tsc_elapsed / 1000000,
+			bursts ? (double)pkts / bursts : 0,
+			pkts ? (double)cycles / pkts : 0,
+			100.0 * cycles / tsc_elapsed);
+		prev[i] = cur;
+	}
+}
+
+void
+app_main_loop_peer(void)
+{
+	struct rte_mbuf *pkts[APP_PEER_BURST];
+	uint64_t tsc_period, tsc_last;
+	uint32_t i, seq = 0;
+
+	RTE_LOG(INFO, USER1, "Core %u is doing the virtio-user peers\n",
+		rte_lcore_id());
+
+	/* No other core draws random numbers, the mix is the same each run */
+	rte_srand(app.pkt_seed);
+
+	tsc_period = rte_get_tsc_hz() * APP_STATS_PERIOD_MS / 1000;
+	tsc_last = rte_rdtsc();
+
+	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		uint64_t tsc = app_stage_begin();
+		uint16_t n_pkts, k;
+
+		if (rte_pktmbuf_alloc_bulk(app.pool, pkts,
+				APP_PEER_BURST) == 0) {
+			for (k = 0; k < APP_PEER_BURST; k++)
+				app_peer_build_pkt(pkts[k], seq++);
+
+			n_pkts = rte_eth_tx_burst(app.peer_ports[i], 0, pkts,
+				APP_PEER_BURST);
+			for (k = n_pkts; k < APP_PEER_BURST; k++)
+				rte_pktmbuf_free(pkts[k]);
+
+			app_stage_end(e_APP_STAGE_PEER_TX, tsc, n_pkts);
+		}
+
+		tsc = app_stage_begin();
+		n_pkts = rte_eth_rx_burst(app.peer_ports[i], 0, pkts,
+			APP_PEER_BURST);
+		for (k = 0; k < n_pkts; k++)
+			rte_pktmbuf_free(pkts[k]);
+		app_stage_end(e_APP_STAGE_PEER_RX, tsc, n_pkts);
+
+		tsc = rte_rdtsc();
+		if (tsc - tsc_last >= tsc_period) {
+			app_stats_print(tsc - tsc_last);
+			tsc_last = tsc;
+		}
+	}
+}
@@ -6,7 +6,9 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <rte_cycles.h>
 #include <rte_log.h>
+#include <rte_net.h>
 #include <rte_ethdev.h>
 #include <rte_ether.h>
 #include <rte_ip.h>
@@ -366,11 +368,16 @@ app_main_loop_worker_pipeline_hash(void) {
 
 	/* Run-time */
 #if APP_FLUSH == 0
-	for ( ; ; )
-		rte_pipeline_run(p);
+	for ( ; ; ) {
+		uint64_t tsc = app_stage_begin();
+
+		app_stage_end(e_APP_STAGE_WORKER, tsc, rte_pipeline_run(p));
+	}
 #else
 	for (i = 0; ; i++) {
-		rte_pipeline_run(p);
+		uint64_t tsc = app_stage_begin();
+
+		app_stage_end(e_APP_STAGE_WORKER, tsc, rte_pipeline_run(p));
 
 		if ((i & APP_FLUSH) == 0)
 			rte_pipeline_flush(p);
@@ -412,6 +419,7 @@ app_main_loop_rx_metadata(void) {
 		rte_lcore_id());
 
 	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		uint64_t tsc = app_stage_begin();
 		uint16_t n_mbufs;
 
 		n_mbufs = rte_eth_rx_burst(
@@ -434,6 +442,12 @@ app_main_loop_rx_metadata(void) {
 
 			m = app.mbuf_rx.array[j];
 			m_data = rte_pktmbuf_mtod(m, uint8_t *);
+
+			/* Virtual ports do not parse the packet type */
+			if (m->packet_type == 0)
+				m->packet_type = rte_net_get_ptype(m, NULL,
+					RTE_PTYPE_L2_MASK | RTE_PTYPE_L3_MASK);
+
 			signature = RTE_MBUF_METADATA_UINT32_PTR(m,
 					APP_METADATA_OFFSET(0));
 			key = RTE_MBUF_METADATA_UINT8_PTR(m,
@@ -465,5 +479,7 @@ app_main_loop_rx_metadata(void) {
 				n_mbufs,
 				NULL);
 		} while (ret == 0);
+
+		app_stage_end(e_APP_STAGE_RX, tsc, n_mbufs);
 	}
 }
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <rte_cycles.h>
 #include <rte_log.h>
 #include <rte_port_ring.h>
 #include <rte_table_stub.h>
@@ -122,11 +123,16 @@ app_main_loop_worker_pipeline_stub(void) {
 
 	/* Run-time */
 #if APP_FLUSH == 0
-	for ( ; ; )
-		rte_pipeline_run(p);
+	for ( ; ; ) {
+		uint64_t tsc = app_stage_begin();
+
+		app_stage_end(e_APP_STAGE_WORKER, tsc, rte_pipeline_run(p));
+	}
 #else
 	for (i = 0; ; i++) {
-		rte_pipeline_run(p);
+		uint64_t tsc = app_stage_begin();
+
+		app_stage_end(e_APP_STAGE_WORKER, tsc, rte_pipeline_run(p));
 
 		if ((i & APP_FLUSH) == 0)
 			rte_pipeline_flush(p);
@@ -50,6 +50,7 @@ app_main_loop_rx(void) {
 	RTE_LOG(INFO, USER1, "Core %u is doing RX\n", rte_lcore_id());
 
 	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		uint64_t tsc = app_stage_begin();
 		uint16_t n_mbufs;
 
 		n_mbufs = rte_eth_rx_burst(
@@ -67,6 +68,8 @@ app_main_loop_rx(void) {
 				(void **) app.mbuf_rx.array,
 				n_mbufs, NULL);
 		} while (ret == 0);
+
+		app_stage_end(e_APP_STAGE_RX, tsc, n_mbufs);
 	}
 }
 
@@ -84,6 +87,7 @@ app_main_loop_worker(void) {
 		rte_panic("Worker thread: cannot allocate buffer space\n");
 
 	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		uint64_t tsc = app_stage_begin();
 		int ret;
 
 		ret = rte_ring_sc_dequeue_bulk(
@@ -102,6 +106,9 @@ app_main_loop_worker(void) {
 				app.burst_size_worker_write,
 				NULL);
 		} while (ret == 0);
+
+		app_stage_end(e_APP_STAGE_WORKER, tsc,
+			app.burst_size_worker_read);
 	}
 }
 
@@ -112,6 +119,7 @@ app_main_loop_tx(void) {
 	RTE_LOG(INFO, USER1, "Core %u is doing TX\n", rte_lcore_id());
 
 	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		uint64_t tsc = app_stage_begin();
 		uint16_t n_mbufs, n_pkts;
 		int ret;
 
@@ -151,5 +159,7 @@ app_main_loop_tx(void) {
 		}
 
 		app.mbuf_tx[i].n_mbufs = 0;
+
+		app_stage_end(e_APP_STAGE_TX, tsc, n_mbufs);
 	}
 }
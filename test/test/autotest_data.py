@@ -110,6 +110,12 @@
         "Func":    default_autotest,
         "Report":  None,
     },
+    {
+        "Name":    "LPM6 trie autotest",
+        "Command": "lpm6_trie_autotest",
+        "Func":    default_autotest,
+        "Report":  None,
+    },
     {
         "Name":    "Memcpy autotest",
         "Command": "memcpy_autotest",
@@ -290,6 +296,12 @@
         "Func":    default_autotest,
         "Report":  None,
     },
+    {
+        "Name":    "Rawdev swdma autotest",
+        "Command": "rawdev_swdma_autotest",
+        "Func":    default_autotest,
+        "Report":  None,
+    },
     {
         "Name":    "Kvargs autotest",
         "Command": "kvargs_autotest",
@@ -326,6 +338,12 @@
         "Func":    default_autotest,
         "Report":  None,
     },
+    {
+        "Name":    "Checksum autotest",
+        "Command": "cksum_autotest",
+        "Func":    default_autotest,
+        "Report":  None,
+    },
     {
         "Name":    "Distributor autotest",
         "Command": "distributor_autotest",
@@ -634,6 +652,12 @@
         "Func":    default_autotest,
         "Report":  None,
     },
+    {
+        "Name":    "Vhost perf autotest",
+        "Command": "vhost_perf_autotest",
+        "Func":    default_autotest,
+        "Report":  None,
+    },
     {
         "Name":    "Distributor perf autotest",
         "Command": "distributor_perf_autotest",
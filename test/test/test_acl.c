@@ -12,6 +12,7 @@
 #include <rte_byteorder.h>
 #include <rte_ip.h>
 #include <rte_acl.h>
+#include <rte_acl_incr.h>
 #include <rte_common.h>
 
 #include "test_acl.h"
@@ -1572,6 +1573,169 @@ test_invalid_parameters(void)
 /**
  * Various tests that don't test much but improve coverage
  */
+/*
+ * Compare the results of an incremental context with the ones of a context
+ * built from the same rules.
+ */
+static int
+test_incr_check(const struct rte_acl_incr_ctx *ictx,
+	const struct rte_acl_ipv4vlan_rule *rules, const uint8_t *live,
+	uint32_t num)
+{
+	uint32_t incr_results[RTE_DIM(acl_test_data) * RTE_ACL_MAX_CATEGORIES];
+	uint32_t results[RTE_DIM(acl_test_data) * RTE_ACL_MAX_CATEGORIES];
+	const uint8_t *data[RTE_DIM(acl_test_data)];
+	struct rte_acl_ctx *acx;
+	uint32_t i;
+	int ret;
+
+	acx = rte_acl_create(&acl_param);
+	if (acx == NULL) {
+		printf("Line %i: Error creating ACL context!\n", __LINE__);
+		return -1;
+	}
+
+	ret = 0;
+	for (i = 0; i != num && ret == 0; i++)
+		if (live[i])
+			ret = rte_acl_ipv4vlan_add_rules(acx, rules + i, 1);
+	if (ret == 0)
+		ret = rte_acl_ipv4vlan_build(acx, ipv4_7tuple_layout,
+			RTE_ACL_MAX_CATEGORIES);
+	if (ret != 0) {
+		printf("Line %i: Building ACL context failed!\n", __LINE__);
+		rte_acl_free(acx);
+		return ret;
+	}
+
+	bswap_test_data(acl_test_data, RTE_DIM(acl_test_data), 1);
+	for (i = 0; i != RTE_DIM(acl_test_data); i++)
+		data[i] = (uint8_t *)&acl_test_data[i];
+
+	ret = rte_acl_classify(acx, data, results, RTE_DIM(acl_test_data),
+		RTE_ACL_MAX_CATEGORIES);
+	if (ret == 0)
+		ret = rte_acl_incr_classify(ictx, data, incr_results,
+			RTE_DIM(acl_test_data), RTE_ACL_MAX_CATEGORIES);
+	if (ret != 0)
+		printf("Line %i: classify failed!\n", __LINE__);
+
+	for (i = 0; i != RTE_DIM(results) && ret == 0; i++) {
+		if (incr_results[i] != results[i]) {
+			printf("Line %i: Error in results at %u "
+				"(expected %"PRIu32" got %"PRIu32")!\n",
+				__LINE__, i, results[i], incr_results[i]);
+			ret = -EINVAL;
+		}
+	}
+
+	bswap_test_data(acl_test_data, RTE_DIM(acl_test_data), 0);
+	rte_acl_free(acx);
+	return ret;
+}
+
+/*
+ * Test incremental context updates.
+ */
+static int
+test_incr(void)
+{
+	struct acl_ipv4vlan_rule rules[RTE_DIM(acl_test_rules)];
+	uint8_t live[RTE_DIM(acl_test_rules)];
+	struct rte_acl_incr_ctx *ictx;
+	struct rte_acl_config cfg;
+	uint32_t i, num, userdata;
+	int ret;
+
+	num = RTE_DIM(acl_test_rules);
+	for (i = 0; i != num; i++)
+		acl_ipv4vlan_convert_rule(acl_test_rules + i, rules + i);
+
+	memset(&cfg, 0, sizeof(cfg));
+	acl_ipv4vlan_config(&cfg, ipv4_7tuple_layout, RTE_ACL_MAX_CATEGORIES);
+
+	ictx = rte_acl_incr_create(&acl_param, &cfg);
+	if (ictx == NULL) {
+		printf("Line %i: Error creating incremental context!\n",
+			__LINE__);
+		return -1;
+	}
+
+	/* first half of the rules in the main context, then the others */
+	memset(live, 1, sizeof(live));
+	ret = rte_acl_incr_add_rules(ictx, (struct rte_acl_rule *)rules,
+		num / 2);
+	if (ret == 0)
+		ret = rte_acl_incr_merge(ictx);
+	if (ret == 0)
+		ret = rte_acl_incr_add_rules(ictx,
+			(struct rte_acl_rule *)(rules + num / 2), num - num / 2);
+	if (ret != 0) {
+		printf("Line %i: Adding rules failed!\n", __LINE__);
+		goto err;
+	}
+	if (rte_acl_incr_delta_rules(ictx) != num - num / 2) {
+		printf("Line %i: Wrong number of delta rules!\n", __LINE__);
+		ret = -1;
+		goto err;
+	}
+	ret = test_incr_check(ictx, acl_test_rules, live, num);
+	if (ret != 0)
+		goto err;
+
+	/* invalid updates must leave the context unchanged */
+	userdata = num + 1;
+	if (rte_acl_incr_add_rules(ictx, (struct rte_acl_rule *)rules,
+			1) != -EEXIST ||
+			rte_acl_incr_del_rules(ictx, &userdata, 1) != -ENOENT) {
+		printf("Line %i: Invalid update succeeded!\n", __LINE__);
+		ret = -1;
+		goto err;
+	}
+
+	/* delete every third rule, from both the main and delta contexts */
+	for (i = 0; i < num; i += 3) {
+		userdata = rules[i].data.userdata;
+		ret = rte_acl_incr_del_rules(ictx, &userdata, 1);
+		if (ret != 0) {
+			printf("Line %i: Deleting rule %u failed!\n",
+				__LINE__, userdata);
+			goto err;
+		}
+		live[i] = 0;
+	}
+	ret = test_incr_check(ictx, acl_test_rules, live, num);
+	if (ret != 0)
+		goto err;
+
+	/* merge, then add the deleted rules back */
+	ret = rte_acl_incr_merge(ictx);
+	if (ret != 0 || rte_acl_incr_delta_rules(ictx) != 0) {
+		printf("Line %i: Merging failed!\n", __LINE__);
+		ret = -1;
+		goto err;
+	}
+	ret = test_incr_check(ictx, acl_test_rules, live, num);
+	if (ret != 0)
+		goto err;
+	for (i = 0; i < num; i += 3) {
+		ret = rte_acl_incr_add_rules(ictx,
+			(struct rte_acl_rule *)(rules + i), 1);
+		if (ret != 0) {
+			printf("Line %i: Adding rule %u failed!\n",
+				__LINE__, rules[i].data.userdata);
+			goto err;
+		}
+		live[i] = 1;
+	}
+	ret = test_incr_check(ictx, acl_test_rules, live, num);
+
+err:
+	rte_acl_incr_reclaim(ictx);
+	rte_acl_incr_free(ictx);
+	return ret;
+}
+
 static int
 test_misc(void)
 {
@@ -1616,6 +1780,8 @@ test_acl(void)
 		return -1;
 	if (test_convert() < 0)
 		return -1;
+	if (test_incr() < 0)
+		return -1;
 
 	return 0;
 }
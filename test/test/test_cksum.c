@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_ip.h>
+#include <rte_malloc.h>
+#include <rte_net_cksum.h>
+
+#include "test.h"
+
+#define CKSUM_BUF_LEN      (64 * 1024 + 64)
+#define CKSUM_MAX_OFFSET   8
+#define CKSUM_INIT         0x1234
+
+/* Compare an algorithm to __rte_raw_cksum() on all lengths and offsets */
+static int
+test_cksum_alg(const uint8_t *src, uint8_t *dst)
+{
+	uint32_t off;
+	uint32_t len;
+
+	for (off = 0; off < CKSUM_MAX_OFFSET; off++) {
+		for (len = 0; len + off <= CKSUM_BUF_LEN;
+		     len += len < 512 ? 1 : 509) {
+			uint16_t ref, res;
+
+			ref = __rte_raw_cksum_reduce(
+				__rte_raw_cksum(src + off, len, CKSUM_INIT));
+
+			res = __rte_raw_cksum_reduce(
+				rte_net_raw_cksum(src + off, len, CKSUM_INIT));
+			if (res != ref) {
+				printf("cksum off %u len %u: %#x instead of %#x\n",
+				       off, len, res, ref);
+				return -1;
+			}
+
+			res = __rte_raw_cksum_reduce(rte_net_raw_cksum_copy(
+				dst + CKSUM_MAX_OFFSET - off, src + off, len,
+				CKSUM_INIT));
+			if (res != ref) {
+				printf("cksum copy off %u len %u: %#x instead of %#x\n",
+				       off, len, res, ref);
+				return -1;
+			}
+			if (memcmp(dst + CKSUM_MAX_OFFSET - off, src + off,
+				   len) != 0) {
+				printf("cksum copy off %u len %u: bad copy\n",
+				       off, len);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void
+test_cksum_fill(uint8_t *buf)
+{
+	uint32_t i;
+
+	for (i = 0; i < CKSUM_BUF_LEN; i++)
+		buf[i] = rand();
+}
+
+static int
+test_cksum(void)
+{
+	static const struct {
+		enum rte_net_cksum_alg alg;
+		const char *name;
+	} algs[] = {
+		{ RTE_NET_CKSUM_SCALAR, "scalar" },
+		{ RTE_NET_CKSUM_AVX2, "avx2" },
+		{ RTE_NET_CKSUM_AVX512, "avx512" },
+		{ RTE_NET_CKSUM_NEON, "neon" },
+	};
+	enum rte_net_cksum_alg def_alg = rte_net_cksum_get_alg();
+	uint8_t *src, *dst;
+	unsigned int i;
+	int ret = 0;
+
+	src = rte_malloc(NULL, CKSUM_BUF_LEN, 0);
+	dst = rte_malloc(NULL, CKSUM_BUF_LEN + CKSUM_MAX_OFFSET, 0);
+	if (src == NULL || dst == NULL) {
+		printf("cannot allocate buffers\n");
+		ret = -1;
+		goto end;
+	}
+
+	for (i = 0; i < RTE_DIM(algs); i++) {
+		test_cksum_fill(src);
+		if (rte_net_cksum_set_alg(algs[i].alg) != 0) {
+			printf("test_cksum (%s): not supported\n",
+			       algs[i].name);
+			continue;
+		}
+		ret = test_cksum_alg(src, dst);
+		if (ret < 0) {
+			printf("test_cksum (%s): failed\n", algs[i].name);
+			break;
+		}
+		/* all carries: the sums must not overflow */
+		memset(src, 0xff, CKSUM_BUF_LEN);
+		ret = test_cksum_alg(src, dst);
+		if (ret < 0) {
+			printf("test_cksum (%s, 0xff): failed\n",
+			       algs[i].name);
+			break;
+		}
+	}
+
+end:
+	rte_net_cksum_set_alg(def_alg);
+	rte_free(src);
+	rte_free(dst);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(cksum_autotest, test_cksum);
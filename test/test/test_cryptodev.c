@@ -8868,6 +8868,15 @@ test_scheduler_mode_pkt_size_distr_op(void)
 	return 0;
 }
 
+static int
+test_scheduler_mode_load_aware_op(void)
+{
+	TEST_ASSERT(test_scheduler_mode_op(CDEV_SCHED_MODE_LOAD_AWARE) ==
+			0, "Failed to set load-aware mode");
+
+	return 0;
+}
+
 static struct unit_test_suite cryptodev_scheduler_testsuite  = {
 	.suite_name = "Crypto Device Scheduler Unit Test Suite",
 	.setup = testsuite_setup,
@@ -8917,6 +8926,17 @@ static struct unit_test_suite cryptodev_scheduler_testsuite  = {
 					test_authonly_scheduler_all),
 		TEST_CASE_ST(NULL, NULL, test_scheduler_detach_slave_op),
 
+		/* Load aware */
+		TEST_CASE_ST(NULL, NULL, test_scheduler_attach_slave_op),
+		TEST_CASE_ST(NULL, NULL, test_scheduler_mode_load_aware_op),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+					test_AES_chain_scheduler_all),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+					test_AES_cipheronly_scheduler_all),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+					test_authonly_scheduler_all),
+		TEST_CASE_ST(NULL, NULL, test_scheduler_detach_slave_op),
+
 		TEST_CASES_END() /**< NULL terminate unit test array */
 	}
 };
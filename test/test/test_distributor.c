@@ -570,6 +570,17 @@ quit_workers(struct worker_params *wp, struct rte_mempool *p)
 
 	zero_quit = 0;
 	quit = 1;
+
+	/* ring mode workers do not wait for packets */
+	if (strcmp(wp->name, "ring") == 0) {
+		rte_mempool_put_bulk(p, (void *)bufs, num_workers);
+		rte_distributor_flush(d);
+		rte_eal_mp_wait_lcore();
+		quit = 0;
+		worker_idx = 0;
+		return;
+	}
+
 	for (i = 0; i < num_workers; i++)
 		bufs[i]->hash.usr = i << 1;
 	rte_distributor_process(d, bufs, num_workers);
@@ -588,7 +599,8 @@ test_distributor(void)
 {
 	static struct rte_distributor *ds;
 	static struct rte_distributor *db;
-	static struct rte_distributor *dist[2];
+	static struct rte_distributor *dr;
+	static struct rte_distributor *dist[3];
 	static struct rte_mempool *p;
 	int i;
 
@@ -610,6 +622,19 @@ test_distributor(void)
 		rte_distributor_clear_returns(db);
 	}
 
+	if (dr == NULL) {
+		dr = rte_distributor_create("Test_dist_ring", rte_socket_id(),
+				rte_lcore_count() - 1,
+				RTE_DIST_ALG_RING);
+		if (dr == NULL) {
+			printf("Error creating ring distributor\n");
+			return -1;
+		}
+	} else {
+		rte_distributor_flush(dr);
+		rte_distributor_clear_returns(dr);
+	}
+
 	if (ds == NULL) {
 		ds = rte_distributor_create("Test_dist_single",
 				rte_socket_id(),
@@ -637,11 +662,14 @@ test_distributor(void)
 
 	dist[0] = ds;
 	dist[1] = db;
+	dist[2] = dr;
 
-	for (i = 0; i < 2; i++) {
+	for (i = 0; i < 3; i++) {
 
 		worker_params.dist = dist[i];
-		if (i)
+		if (i == 2)
+			sprintf(worker_params.name, "ring");
+		else if (i)
 			sprintf(worker_params.name, "burst");
 		else
 			sprintf(worker_params.name, "single");
@@ -658,7 +686,10 @@ test_distributor(void)
 			goto err;
 		quit_workers(&worker_params, p);
 
-		if (rte_lcore_count() > 2) {
+		/* ring mode workers must not stop with packets queued */
+		if (i == 2) {
+			printf("Worker shutdown tests skipped in ring mode\n");
+		} else if (rte_lcore_count() > 2) {
 			rte_eal_mp_remote_launch(handle_work_for_shutdown_test,
 					&worker_params,
 					SKIP_MASTER);
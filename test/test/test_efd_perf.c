@@ -6,6 +6,7 @@
 #include <inttypes.h>
 
 #include <rte_lcore.h>
+#include <rte_launch.h>
 #include <rte_cycles.h>
 #include <rte_malloc.h>
 #include <rte_random.h>
@@ -55,6 +56,7 @@ struct efd_perf_params {
 	struct rte_efd_table *efd_table;
 	uint32_t key_size;
 	unsigned int cycle;
+	uint32_t extra_flag;
 };
 
 static uint32_t hashtest_key_lens[] = {
@@ -157,9 +159,10 @@ setup_keys_and_data(struct efd_perf_params *params, unsigned int cycle)
 	/* Shuffle the random values again */
 	shuffle_input_keys(params);
 
-	params->efd_table = rte_efd_create("test_efd_perf",
+	params->efd_table = rte_efd_create_ext("test_efd_perf",
 			MAX_ENTRIES, params->key_size,
-			efd_get_all_sockets_bitmask(), test_socket_id);
+			efd_get_all_sockets_bitmask(), test_socket_id,
+			params->extra_flag);
 	TEST_ASSERT_NOT_NULL(params->efd_table, "Error creating the efd table\n");
 
 	return 0;
@@ -329,6 +332,7 @@ run_all_tbl_perf_tests(void)
 	fflush(stdout);
 
 	test_socket_id = rte_socket_id();
+	params.extra_flag = 0;
 
 	for (i = 0; i < NUM_KEYSIZES; i++) {
 
@@ -372,6 +376,143 @@ run_all_tbl_perf_tests(void)
 	return 0;
 }
 
+/* Lookups of each lcore while the master lcore updates the table */
+struct rw_lf_stats {
+	uint64_t cycles;
+	uint64_t lookups;
+} __rte_cache_aligned;
+
+static struct rw_lf_stats rw_lf_stats[RTE_MAX_LCORE];
+static uint32_t rw_lf_writer_done;
+
+static int
+lookups_rw_lf(void *arg)
+{
+	struct efd_perf_params *params = arg;
+	struct rw_lf_stats *stats = &rw_lf_stats[rte_lcore_id()];
+	efd_value_t result[RTE_EFD_BURST_MAX];
+	const void *keys_burst[RTE_EFD_BURST_MAX];
+	unsigned int j, k, data_idx;
+	uint64_t lookups = 0;
+	const uint64_t start_tsc = rte_rdtsc();
+
+	do {
+		for (j = 0; j < KEYS_TO_ADD / RTE_EFD_BURST_MAX; j++) {
+			for (k = 0; k < RTE_EFD_BURST_MAX; k++)
+				keys_burst[k] = keys[j * RTE_EFD_BURST_MAX + k];
+
+			rte_efd_lookup_bulk(params->efd_table, test_socket_id,
+					RTE_EFD_BURST_MAX, keys_burst, result);
+
+			/* the writer flips the lowest bit of the values */
+			for (k = 0; k < RTE_EFD_BURST_MAX; k++) {
+				data_idx = j * RTE_EFD_BURST_MAX + k;
+				if ((result[k] | 1) != (data[data_idx] | 1)) {
+					printf("Value mismatch using "
+						"rte_efd_lookup_bulk during "
+						"updates: expected %d, got %d\n",
+						data[data_idx], result[k]);
+					return -1;
+				}
+			}
+			lookups += RTE_EFD_BURST_MAX;
+		}
+	} while (!__atomic_load_n(&rw_lf_writer_done, __ATOMIC_RELAXED));
+
+	stats->cycles = rte_rdtsc() - start_tsc;
+	stats->lookups = lookups;
+	return 0;
+}
+
+/*
+ * Run lock-free bulk lookups on all the slave lcores, while the master lcore
+ * updates the values of the keys or not.
+ */
+static int
+timed_lookups_rw_lf(struct efd_perf_params *params, int with_updates,
+		uint64_t *lookup_cycles, uint64_t *update_cycles)
+{
+	unsigned int i, lcore_id, pass;
+	uint64_t cycles_sum = 0, lookups_sum = 0;
+	uint64_t start_tsc;
+	int ret = 0;
+
+	__atomic_store_n(&rw_lf_writer_done, !with_updates, __ATOMIC_RELAXED);
+	rte_eal_mp_remote_launch(lookups_rw_lf, params, SKIP_MASTER);
+
+	if (with_updates) {
+		start_tsc = rte_rdtsc();
+		for (pass = 1; pass <= 2 && ret == 0; pass++) {
+			for (i = 0; i < KEYS_TO_ADD; i++) {
+				ret = rte_efd_update(params->efd_table,
+						test_socket_id, keys[i],
+						data[i] ^ (pass & 1));
+				if (ret != 0 &&
+					ret != RTE_EFD_UPDATE_WARN_GROUP_FULL) {
+					printf("Error %d in rte_efd_update\n",
+							ret);
+					break;
+				}
+				ret = 0;
+			}
+		}
+		*update_cycles = (rte_rdtsc() - start_tsc) / (KEYS_TO_ADD * 2);
+		__atomic_store_n(&rw_lf_writer_done, 1, __ATOMIC_RELAXED);
+	}
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (rte_eal_wait_lcore(lcore_id) < 0)
+			ret = -1;
+		cycles_sum += rw_lf_stats[lcore_id].cycles;
+		lookups_sum += rw_lf_stats[lcore_id].lookups;
+	}
+
+	if (lookups_sum != 0)
+		*lookup_cycles = cycles_sum / lookups_sum;
+	return ret;
+}
+
+static int
+run_rw_lf_perf_test(void)
+{
+	struct efd_perf_params params;
+	uint64_t lookup_cycles = 0, lookup_cycles_rw = 0, update_cycles = 0;
+
+	if (rte_lcore_count() < 2) {
+		printf("\nLock-free lookups need at least 2 lcores, skipping\n");
+		return 0;
+	}
+
+	/* 16-byte keys */
+	params.extra_flag = RTE_EFD_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+	if (setup_keys_and_data(&params, 2) < 0) {
+		printf("Could not create keys/data/table\n");
+		return -1;
+	}
+
+	if (timed_adds(&params) < 0)
+		return exit_with_fail("timed_adds", &params, 2);
+
+	if (timed_lookups_rw_lf(&params, 0, &lookup_cycles, NULL) < 0)
+		return exit_with_fail("timed_lookups_rw_lf", &params, 2);
+
+	if (timed_lookups_rw_lf(&params, 1, &lookup_cycles_rw,
+			&update_cycles) < 0)
+		return exit_with_fail("timed_lookups_rw_lf", &params, 2);
+
+	perform_frees(&params);
+
+	printf("\nLock-free lookups with %u lookup lcores "
+			"(in CPU cycles/operation)\n", rte_lcore_count() - 1);
+	printf("-----------------------------------\n");
+	printf("\n%-18s%-18s%-18s%-18s\n", "Keysize", "Lookup_bulk",
+			"Lookup_bulk_rw", "Update_rw");
+	printf("%-18d%-18"PRIu64"%-18"PRIu64"%-18"PRIu64"\n",
+			hashtest_key_lens[2], lookup_cycles, lookup_cycles_rw,
+			update_cycles);
+	return 0;
+}
+
 static int
 test_efd_perf(void)
 {
@@ -379,6 +520,9 @@ test_efd_perf(void)
 	if (run_all_tbl_perf_tests() < 0)
 		return -1;
 
+	if (run_rw_lf_perf_test() < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -3,6 +3,7 @@
  */
 #include <string.h>
 #include <rte_common.h>
+#include <rte_errno.h>
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
 #include <rte_ethdev.h>
@@ -452,6 +453,119 @@ adapter_queue_add_del(void)
 	return TEST_SUCCESS;
 }
 
+static int
+adapter_queue_add_del_vector(void)
+{
+	int err;
+	struct rte_event ev;
+	struct rte_mempool *vector_mp;
+	struct rte_event_eth_rx_adapter_queue_conf queue_config;
+
+	vector_mp = rte_event_vector_pool_create("rxa_vector_pool", 64, 0, 32,
+						rte_socket_id());
+	TEST_ASSERT(vector_mp != NULL, "Failed to create vector pool %d",
+			rte_errno);
+
+	memset(&ev, 0, sizeof(ev));
+	ev.queue_id = 0;
+	ev.sched_type = RTE_SCHED_TYPE_ATOMIC;
+	ev.priority = 0;
+
+	memset(&queue_config, 0, sizeof(queue_config));
+	queue_config.rx_queue_flags =
+		RTE_EVENT_ETH_RX_ADAPTER_QUEUE_EVENT_VECTOR;
+	queue_config.ev = ev;
+	queue_config.servicing_weight = 1;
+	queue_config.vector_sz = 32;
+	queue_config.vector_timeout_ns = 100000;
+	queue_config.vector_mp = vector_mp;
+
+	if (default_params.caps & RTE_EVENT_ETH_RX_ADAPTER_CAP_INTERNAL_PORT) {
+		err = rte_event_eth_rx_adapter_queue_add(TEST_INST_ID,
+							TEST_ETHDEV_ID, -1,
+							&queue_config);
+		TEST_ASSERT(err == -ENOTSUP, "Expected -ENOTSUP got %d", err);
+		rte_mempool_free(vector_mp);
+		return TEST_SUCCESS;
+	}
+
+	/* Vectors too small for vector_sz mbufs */
+	queue_config.vector_sz = 64;
+	err = rte_event_eth_rx_adapter_queue_add(TEST_INST_ID, TEST_ETHDEV_ID,
+						-1, &queue_config);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+
+	queue_config.vector_sz = 32;
+	queue_config.vector_mp = NULL;
+	err = rte_event_eth_rx_adapter_queue_add(TEST_INST_ID, TEST_ETHDEV_ID,
+						-1, &queue_config);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+
+	queue_config.vector_mp = vector_mp;
+	err = rte_event_eth_rx_adapter_queue_add(TEST_INST_ID, TEST_ETHDEV_ID,
+						-1, &queue_config);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+
+	err = rte_event_eth_rx_adapter_queue_del(TEST_INST_ID, TEST_ETHDEV_ID,
+						-1);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+
+	rte_mempool_free(vector_mp);
+	return TEST_SUCCESS;
+}
+
+static uint16_t
+src_rx(void *rx_arg, struct rte_mbuf **mbufs __rte_unused,
+	uint16_t nb_mbufs __rte_unused)
+{
+	uint32_t *nb_calls = rx_arg;
+
+	(*nb_calls)++;
+	return 0;
+}
+
+static int
+adapter_src_add_del(void)
+{
+	int err;
+	uint16_t src_id[2];
+	uint32_t nb_calls = 0;
+	struct rte_event_eth_rx_adapter_src_conf src_conf;
+
+	memset(&src_conf, 0, sizeof(src_conf));
+	src_conf.rx_fn = src_rx;
+	src_conf.rx_arg = &nb_calls;
+	src_conf.intr_fd = -1;
+	src_conf.queue_conf.ev.queue_id = 0;
+	src_conf.queue_conf.ev.sched_type = RTE_SCHED_TYPE_ATOMIC;
+
+	/* Interrupt driven source without notification fd */
+	err = rte_event_eth_rx_adapter_src_add(TEST_INST_ID, &src_conf,
+						&src_id[0]);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+
+	src_conf.queue_conf.servicing_weight = 1;
+	err = rte_event_eth_rx_adapter_src_add(TEST_INST_ID, &src_conf,
+						&src_id[0]);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	err = rte_event_eth_rx_adapter_src_add(TEST_INST_ID, &src_conf,
+						&src_id[1]);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	TEST_ASSERT(src_id[0] != src_id[1], "Expected distinct source ids");
+
+	err = rte_event_eth_rx_adapter_free(TEST_INST_ID);
+	TEST_ASSERT(err == -EBUSY, "Expected -EBUSY got %d", err);
+
+	err = rte_event_eth_rx_adapter_src_del(TEST_INST_ID, src_id[0]);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+	err = rte_event_eth_rx_adapter_src_del(TEST_INST_ID, src_id[0]);
+	TEST_ASSERT(err == -EINVAL, "Expected -EINVAL got %d", err);
+	err = rte_event_eth_rx_adapter_src_del(TEST_INST_ID, src_id[1]);
+	TEST_ASSERT(err == 0, "Expected 0 got %d", err);
+
+	return TEST_SUCCESS;
+}
+
 static int
 adapter_multi_eth_add_del(void)
 {
@@ -677,6 +791,10 @@ static struct unit_test_suite event_eth_rx_tests = {
 		TEST_CASE_ST(NULL, NULL, adapter_create_free),
 		TEST_CASE_ST(adapter_create, adapter_free,
 					adapter_queue_add_del),
+		TEST_CASE_ST(adapter_create, adapter_free,
+					adapter_queue_add_del_vector),
+		TEST_CASE_ST(adapter_create, adapter_free,
+					adapter_src_add_del),
 		TEST_CASE_ST(adapter_create, adapter_free,
 					adapter_multi_eth_add_del),
 		TEST_CASE_ST(adapter_create, adapter_free, adapter_start_stop),
@@ -838,6 +838,125 @@ test_query_sctp(void)
 	return 0;
 }
 
+static int
+test_flow_cache_query(struct rte_flow_classifier *cache_cls,
+		struct rte_flow_classify_rule *rule, uint64_t hits)
+{
+	struct rte_flow_classify_cache_stats cache_stats;
+	int ret;
+
+	ret = rte_flow_classifier_query(cache_cls, bufs, MAX_PKT_BURST,
+			rule, &udp_classify_stats);
+	if (ret || udp_ntuple_stats.counter1 != MAX_PKT_BURST) {
+		printf("Line %i: flow_classifier_query", __LINE__);
+		printf(" should have matched the whole burst!\n");
+		return -1;
+	}
+
+	ret = rte_flow_classifier_cache_stats_read(cache_cls, &cache_stats, 1);
+	if (ret || cache_stats.lookups != MAX_PKT_BURST ||
+			cache_stats.hits != hits) {
+		printf("Line %i: flow cache hits %" PRIu64 ", expected %"
+			PRIu64 "\n", __LINE__, cache_stats.hits, hits);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * The burst is made of a single flow: the first burst misses the cache,
+ * the next ones hit it until the rules change.
+ */
+static int
+test_flow_cache(struct rte_table_acl_params *table_acl_params)
+{
+	struct rte_flow_classify_table_params cls_table_params;
+	struct rte_flow_classifier_params cls_params;
+	struct rte_flow_classify_cache_stats cache_stats;
+	struct rte_flow_classify_rule *rule;
+	struct rte_flow_classifier *cache_cls;
+	struct rte_flow_error error;
+	int key_found;
+	int ret = -1;
+	int i;
+
+	if (init_ipv4_udp_traffic(mbufpool[0], bufs, MAX_PKT_BURST) !=
+			MAX_PKT_BURST) {
+		printf("Line %i: init_udp_ipv4_traffic has failed!\n",
+				__LINE__);
+		return -1;
+	}
+	for (i = 0; i < MAX_PKT_BURST; i++)
+		bufs[i]->packet_type = RTE_PTYPE_L3_IPV4;
+
+	cls_params.name = "flow_classifier_cache";
+	cls_params.socket_id = 0;
+	cache_cls = rte_flow_classifier_create(&cls_params);
+	if (cache_cls == NULL) {
+		printf("Line %i: rte_flow_classifier_create", __LINE__);
+		printf(" should not have failed!\n");
+		return -1;
+	}
+
+	table_acl_params->name = "table_acl_ipv4_5tuple_cache";
+	cls_table_params.ops = &rte_table_acl_ops;
+	cls_table_params.arg_create = table_acl_params;
+	cls_table_params.type = RTE_FLOW_CLASSIFY_TABLE_ACL_IP4_5TUPLE;
+	cls_table_params.cache_size = 1024;
+	if (rte_flow_classify_table_create(cache_cls, &cls_table_params)) {
+		printf("Line %i: table with flow cache", __LINE__);
+		printf(" should not have failed!\n");
+		goto out;
+	}
+
+	attr.ingress = 1;
+	attr.priority = 1;
+	pattern[0] = eth_item;
+	pattern[1] = ipv4_udp_item_1;
+	pattern[2] = udp_item_1;
+	pattern[3] = end_item;
+	actions[0] = count_action;
+	actions[1] = end_action;
+
+	rule = rte_flow_classify_table_entry_add(cache_cls, &attr, pattern,
+			actions, &key_found, &error);
+	if (!rule) {
+		printf("Line %i: flow_classify_table_entry_add", __LINE__);
+		printf(" should not have failed!\n");
+		goto out;
+	}
+
+	if (test_flow_cache_query(cache_cls, rule, 0) < 0 ||
+			test_flow_cache_query(cache_cls, rule,
+				MAX_PKT_BURST) < 0)
+		goto out;
+
+	ret = rte_flow_classify_table_entry_delete(cache_cls, rule);
+	if (ret) {
+		printf("Line %i: rte_flow_classify_table_entry_delete",
+			__LINE__);
+		printf(" should not have failed!\n");
+		goto out;
+	}
+
+	/* The flow no longer matches, and its cached rule is gone */
+	ret = rte_flow_classifier_query(cache_cls, bufs, MAX_PKT_BURST,
+			rule, &udp_classify_stats);
+	rte_flow_classifier_cache_stats_read(cache_cls, &cache_stats, 0);
+	if (!ret || cache_stats.invalidations != 1 || cache_stats.hits) {
+		printf("Line %i: flow cache", __LINE__);
+		printf(" should have been invalidated!\n");
+		ret = -1;
+		goto out;
+	}
+	ret = 0;
+
+out:
+	rte_flow_classifier_free(cache_cls);
+	return ret;
+}
+
 static int
 test_flow_classify(void)
 {
@@ -865,6 +984,7 @@ test_flow_classify(void)
 	cls_table_params.ops = &rte_table_acl_ops;
 	cls_table_params.arg_create = &table_acl_params;
 	cls_table_params.type = RTE_FLOW_CLASSIFY_TABLE_ACL_IP4_5TUPLE;
+	cls_table_params.cache_size = 0;
 
 	ret = rte_flow_classify_table_create(cls->cls, &cls_table_params);
 	if (ret) {
@@ -895,6 +1015,8 @@ test_flow_classify(void)
 		return TEST_FAILED;
 	if (test_query_sctp() < 0)
 		return TEST_FAILED;
+	if (test_flow_cache(&table_acl_params) < 0)
+		return TEST_FAILED;
 
 	return TEST_SUCCESS;
 }
@@ -678,6 +678,198 @@ static int test_five_keys(void)
 	return 0;
 }
 
+/*
+ * Lookup of more keys than RTE_HASH_LOOKUP_BULK_MAX, with 8-byte keys
+ *	- add the even keys
+ *	- lookup all the keys at once: even keys hit, odd keys miss
+ */
+#define BULK_N_KEYS (RTE_HASH_LOOKUP_BULK_MAX * 3 + 9)
+static int test_lookup_bulk_n(void)
+{
+	struct rte_hash *handle;
+	struct rte_hash_parameters params;
+	uint64_t bulk_keys[BULK_N_KEYS];
+	const void *key_array[BULK_N_KEYS];
+	int32_t pos[BULK_N_KEYS];
+	int32_t expected_pos[BULK_N_KEYS];
+	void *data[BULK_N_KEYS];
+	unsigned int i;
+	int ret;
+
+	memcpy(&params, &ut_params, sizeof(params));
+	params.name = "test_bulk_n";
+	params.entries = BULK_N_KEYS * 2;
+	params.key_len = sizeof(uint64_t);
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < BULK_N_KEYS; i++) {
+		bulk_keys[i] = rte_rand();
+		key_array[i] = &bulk_keys[i];
+		expected_pos[i] = -ENOENT;
+		if (i & 1)
+			continue;
+		expected_pos[i] = rte_hash_add_key_data(handle, &bulk_keys[i],
+				(void *)(uintptr_t)(i + 1));
+		RETURN_IF_ERROR(expected_pos[i] != 0,
+				"failed to add key %u", i);
+		expected_pos[i] = rte_hash_lookup(handle, &bulk_keys[i]);
+		RETURN_IF_ERROR(expected_pos[i] < 0,
+				"failed to find key %u", i);
+	}
+
+	ret = rte_hash_lookup_bulk_n(handle, key_array, BULK_N_KEYS, pos,
+			data);
+	RETURN_IF_ERROR(ret != (BULK_N_KEYS + 1) / 2,
+			"found %d keys instead of %d", ret,
+			(BULK_N_KEYS + 1) / 2);
+	for (i = 0; i < BULK_N_KEYS; i++) {
+		RETURN_IF_ERROR(pos[i] != expected_pos[i],
+				"wrong position for key %u (pos=%d)",
+				i, pos[i]);
+		RETURN_IF_ERROR(pos[i] >= 0 &&
+				data[i] != (void *)(uintptr_t)(i + 1),
+				"wrong data for key %u", i);
+	}
+
+	rte_hash_free(handle);
+
+	return 0;
+}
+
+/*
+ * Bulk add and delete, with more keys than RTE_HASH_LOOKUP_BULK_MAX
+ *	- add the keys: all added
+ *	- lookup the keys: hit, with the positions returned by the add
+ *	- delete the even keys: all deleted
+ *	- delete all the keys: odd keys deleted, even keys not found
+ */
+static int test_add_del_bulk(void)
+{
+	struct rte_hash *handle;
+	struct rte_hash_parameters params;
+	uint64_t bulk_keys[BULK_N_KEYS];
+	const void *key_array[BULK_N_KEYS];
+	void *data[BULK_N_KEYS];
+	int32_t add_pos[BULK_N_KEYS];
+	int32_t pos[BULK_N_KEYS];
+	unsigned int i;
+	int ret;
+
+	memcpy(&params, &ut_params, sizeof(params));
+	params.name = "test_add_del_bulk";
+	params.entries = BULK_N_KEYS * 2;
+	params.key_len = sizeof(uint64_t);
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < BULK_N_KEYS; i++) {
+		bulk_keys[i] = rte_rand();
+		key_array[i] = &bulk_keys[i];
+		data[i] = (void *)(uintptr_t)(i + 1);
+	}
+
+	ret = rte_hash_add_key_bulk(handle, key_array, data, BULK_N_KEYS,
+			add_pos);
+	RETURN_IF_ERROR(ret != BULK_N_KEYS, "added %d keys", ret);
+
+	ret = rte_hash_lookup_bulk_n(handle, key_array, BULK_N_KEYS, pos,
+			data);
+	RETURN_IF_ERROR(ret != BULK_N_KEYS, "found %d keys", ret);
+	for (i = 0; i < BULK_N_KEYS; i++) {
+		RETURN_IF_ERROR(pos[i] != add_pos[i],
+				"wrong position for key %u (pos=%d)",
+				i, pos[i]);
+		RETURN_IF_ERROR(data[i] != (void *)(uintptr_t)(i + 1),
+				"wrong data for key %u", i);
+	}
+
+	for (i = 0; i < BULK_N_KEYS / 2; i++)
+		key_array[i] = &bulk_keys[i * 2];
+	ret = rte_hash_del_key_bulk(handle, key_array, BULK_N_KEYS / 2, pos);
+	RETURN_IF_ERROR(ret != BULK_N_KEYS / 2, "deleted %d keys", ret);
+
+	for (i = 0; i < BULK_N_KEYS; i++)
+		key_array[i] = &bulk_keys[i];
+	ret = rte_hash_del_key_bulk(handle, key_array, BULK_N_KEYS, pos);
+	RETURN_IF_ERROR(ret != BULK_N_KEYS - BULK_N_KEYS / 2,
+			"deleted %d keys", ret);
+	for (i = 0; i < BULK_N_KEYS; i++) {
+		if ((i & 1) || i >= BULK_N_KEYS / 2 * 2)
+			RETURN_IF_ERROR(pos[i] != add_pos[i],
+					"wrong position for key %u (pos=%d)",
+					i, pos[i]);
+		else
+			RETURN_IF_ERROR(pos[i] != -ENOENT,
+					"deleted key %u found", i);
+	}
+	RETURN_IF_ERROR(rte_hash_count(handle) != 0,
+			"keys left after delete");
+
+	rte_hash_free(handle);
+
+	return 0;
+}
+
+/*
+ * Aging of the entries of a table
+ *	- add 3 keys at time 1
+ *	- lookup the first key and update the second one at time 5
+ *	- scan for the keys not accessed since time 5: third key
+ *	- scan for the keys not accessed since time 6: all keys
+ */
+static int test_aging(void)
+{
+	struct rte_hash *handle;
+	struct rte_hash_parameters params;
+	const void *expired[16];
+	int32_t pos[16];
+	int32_t expected_pos[3];
+	uint32_t next = 0;
+	unsigned int i;
+	int ret;
+
+	memcpy(&params, &ut_params, sizeof(params));
+	params.name = "test_aging";
+	params.extra_flag = RTE_HASH_EXTRA_FLAGS_AGING;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	rte_hash_age_set_time(handle, 1);
+	for (i = 0; i < 3; i++) {
+		expected_pos[i] = rte_hash_add_key(handle, &keys[i]);
+		RETURN_IF_ERROR(expected_pos[i] < 0,
+				"failed to add key %u", i);
+	}
+
+	rte_hash_age_set_time(handle, 5);
+	ret = rte_hash_lookup(handle, &keys[0]);
+	RETURN_IF_ERROR(ret != expected_pos[0], "failed to find key 0");
+	ret = rte_hash_add_key(handle, &keys[1]);
+	RETURN_IF_ERROR(ret != expected_pos[1], "failed to update key 1");
+
+	/* The table has entries / 8 buckets */
+	ret = rte_hash_age_scan(handle, 5, &next, params.entries / 8,
+			expired, pos, RTE_DIM(pos));
+	RETURN_IF_ERROR(ret != 1 || pos[0] != expected_pos[2] ||
+			memcmp(expired[0], &keys[2], sizeof(keys[2])) != 0,
+			"wrong expired keys (%d)", ret);
+	RETURN_IF_ERROR(next != 0, "scan did not wrap around (%u)", next);
+
+	ret = rte_hash_age_scan(handle, 6, &next, params.entries / 8,
+			expired, pos, RTE_DIM(pos));
+	RETURN_IF_ERROR(ret != 3, "wrong number of expired keys (%d)", ret);
+
+	/* Output too small for a bucket */
+	ret = rte_hash_age_scan(handle, 6, &next, params.entries / 8,
+			expired, pos, 4);
+	RETURN_IF_ERROR(ret != -EINVAL, "scan with small output accepted");
+
+	rte_hash_free(handle);
+
+	return 0;
+}
+
 /*
  * Add keys to the same bucket until bucket full.
  *	- add 5 keys to the same bucket (hash created with 4 keys per bucket):
@@ -1741,6 +1933,12 @@ test_hash(void)
 		return -1;
 	if (test_five_keys() < 0)
 		return -1;
+	if (test_lookup_bulk_n() < 0)
+		return -1;
+	if (test_add_del_bulk() < 0)
+		return -1;
+	if (test_aging() < 0)
+		return -1;
 	if (test_full_bucket() < 0)
 		return -1;
 	if (test_extendable_bucket() < 0)
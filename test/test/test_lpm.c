@@ -40,6 +40,7 @@ static int32_t test15(void);
 static int32_t test16(void);
 static int32_t test17(void);
 static int32_t test18(void);
+static int32_t test19(void);
 
 rte_lpm_test tests[] = {
 /* Test Cases */
@@ -61,7 +62,8 @@ rte_lpm_test tests[] = {
 	test15,
 	test16,
 	test17,
-	test18
+	test18,
+	test19
 };
 
 #define NUM_LPM_TESTS (sizeof(tests)/sizeof(tests[0]))
@@ -1266,6 +1268,108 @@ test18(void)
 	return PASS;
 }
 
+/*
+ * Test bulk add and deferred tbl8 reclamation
+ *  - step 1: add routes in bulk, one already present and one twice
+ *  - step 2: check the lookups and the rules table
+ *  - step 3: delete the route using a tbl8 and check the tbl8 is not reused
+ *  - step 4: reclaim the freed tbl8s and check the first one is reused
+ *  - step 5: delete all the routes one by one
+ */
+int32_t
+test19(void)
+{
+#define group_idx next_hop
+#define NB_BULK_ROUTES 6
+	struct rte_lpm *lpm = NULL;
+	struct rte_lpm_config config;
+	uint32_t ips[NB_BULK_ROUTES] = {
+		IPv4(10, 0, 0, 0), IPv4(10, 1, 0, 0), IPv4(10, 1, 1, 0),
+		IPv4(10, 1, 1, 128), IPv4(10, 1, 1, 129), IPv4(192, 168, 0, 0),
+	};
+	uint8_t depths[NB_BULK_ROUTES] = { 8, 16, 24, 25, 25, 16 };
+	uint32_t next_hops[NB_BULK_ROUTES] = { 1, 2, 3, 4, 5, 6 };
+	uint32_t ip, next_hop_return, tbl8_group_index;
+	uint8_t depth;
+	int32_t status;
+	unsigned int i;
+
+	config.max_rules = MAX_RULES;
+	config.number_tbl8s = NUMBER_TBL8S;
+	config.flags = RTE_LPM_TBL8_DEFER_FREE;
+
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	status = rte_lpm_add(lpm, IPv4(10, 1, 0, 0), 16, 7);
+	TEST_LPM_ASSERT(status == 0);
+
+	depths[0] = 0;
+	status = rte_lpm_add_bulk(lpm, ips, depths, next_hops, NB_BULK_ROUTES);
+	TEST_LPM_ASSERT(status == -EINVAL);
+	depths[0] = 8;
+
+	status = rte_lpm_add_bulk(lpm, ips, depths, next_hops, NB_BULK_ROUTES);
+	TEST_LPM_ASSERT(status == 0);
+
+	status = rte_lpm_lookup(lpm, IPv4(10, 2, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 1);
+	status = rte_lpm_lookup(lpm, IPv4(10, 1, 2, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 2);
+	status = rte_lpm_lookup(lpm, IPv4(10, 1, 1, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 3);
+	status = rte_lpm_lookup(lpm, IPv4(10, 1, 1, 200), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 5);
+	status = rte_lpm_lookup(lpm, IPv4(192, 168, 1, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 6);
+	status = rte_lpm_lookup(lpm, IPv4(11, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	status = rte_lpm_is_rule_present(lpm, IPv4(10, 1, 0, 0), 16,
+			&next_hop_return);
+	TEST_LPM_ASSERT(status == 1 && next_hop_return == 2);
+	status = rte_lpm_is_rule_present(lpm, IPv4(10, 1, 1, 128), 25,
+			&next_hop_return);
+	TEST_LPM_ASSERT(status == 1 && next_hop_return == 5);
+
+	ip = IPv4(10, 1, 1, 128);
+	depth = 25;
+	TEST_LPM_ASSERT(lpm->tbl24[ip >> 8].valid_group);
+	tbl8_group_index = lpm->tbl24[ip >> 8].group_idx;
+
+	status = rte_lpm_delete(lpm, ip, depth);
+	TEST_LPM_ASSERT(status == 0);
+	TEST_LPM_ASSERT(!lpm->tbl24[ip >> 8].valid_group);
+
+	status = rte_lpm_add(lpm, ip, depth, 8);
+	TEST_LPM_ASSERT(status == 0);
+	TEST_LPM_ASSERT(tbl8_group_index != lpm->tbl24[ip >> 8].group_idx);
+	status = rte_lpm_delete(lpm, ip, depth);
+	TEST_LPM_ASSERT(status == 0);
+
+	TEST_LPM_ASSERT(rte_lpm_tbl8_reclaim(lpm) == 2);
+	TEST_LPM_ASSERT(rte_lpm_tbl8_reclaim(lpm) == 0);
+
+	status = rte_lpm_add(lpm, ip, depth, 8);
+	TEST_LPM_ASSERT(status == 0);
+	TEST_LPM_ASSERT(tbl8_group_index == lpm->tbl24[ip >> 8].group_idx);
+
+	for (i = 0; i < NB_BULK_ROUTES; i++) {
+		status = rte_lpm_delete(lpm, ips[i], depths[i]);
+		TEST_LPM_ASSERT(status == (i == 4 ? -EINVAL : 0));
+	}
+
+	for (i = 0; i < NB_BULK_ROUTES; i++) {
+		status = rte_lpm_lookup(lpm, ips[i], &next_hop_return);
+		TEST_LPM_ASSERT(status == -ENOENT);
+	}
+
+	rte_lpm_free(lpm);
+#undef NB_BULK_ROUTES
+#undef group_idx
+	return PASS;
+}
+
 /*
  * Do all unit tests.
  */
@@ -0,0 +1,147 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rte_memory.h>
+#include <rte_errno.h>
+#include <rte_lpm6.h>
+#include <rte_lpm6_trie.h>
+
+#include "test.h"
+#include "test_lpm6_data.h"
+
+#define TEST_LPM_ASSERT(cond) do {                                            \
+	if (!(cond)) {                                                        \
+		printf("Error at line %d:\n", __LINE__);                      \
+		goto out;                                                     \
+	}                                                                     \
+} while (0)
+
+#define MAX_RULES 2000
+#define NUMBER_TBL8S (1 << 14)
+
+static uint8_t ip_batch[NUM_IPS_ENTRIES][16];
+static int32_t trie_next_hops[NUM_IPS_ENTRIES];
+static int32_t lpm6_next_hops[NUM_IPS_ENTRIES];
+
+/* compare the trie with rte_lpm6 holding the same routes */
+static int
+check_lookups(struct rte_lpm6_trie *trie, struct rte_lpm6 *lpm6)
+{
+	uint32_t i, next_hop;
+	int ret;
+
+	rte_lpm6_trie_lookup_bulk(trie, ip_batch, trie_next_hops,
+			NUM_IPS_ENTRIES);
+	rte_lpm6_lookup_bulk_func(lpm6, ip_batch, lpm6_next_hops,
+			NUM_IPS_ENTRIES);
+
+	for (i = 0; i < NUM_IPS_ENTRIES; i++) {
+		if (trie_next_hops[i] != lpm6_next_hops[i]) {
+			printf("Bulk lookup %u: %d, expected %d\n", i,
+					trie_next_hops[i], lpm6_next_hops[i]);
+			return -1;
+		}
+		ret = rte_lpm6_trie_lookup(trie, ip_batch[i], &next_hop);
+		if ((ret == 0 ? (int32_t)next_hop : -1) != lpm6_next_hops[i]) {
+			printf("Lookup %u: %d, expected %d\n", i, ret,
+					lpm6_next_hops[i]);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_lpm6_trie(void)
+{
+	struct rte_lpm6_trie_config config = {
+		.max_rules = MAX_RULES,
+		.number_tbl8s = NUMBER_TBL8S,
+	};
+	struct rte_lpm6_config lpm6_config = {
+		.max_rules = MAX_RULES,
+		.number_tbl8s = NUMBER_TBL8S,
+		.flags = 0,
+	};
+	static uint8_t ips[NUM_ROUTE_ENTRIES][16];
+	uint8_t depths[NUM_ROUTE_ENTRIES];
+	uint32_t next_hops[NUM_ROUTE_ENTRIES];
+	uint8_t ip[16] = { 0 };
+	struct rte_lpm6_trie *trie = NULL;
+	struct rte_lpm6 *lpm6 = NULL;
+	uint32_t i, next_hop;
+	int ret = -1;
+
+	/* invalid parameters */
+	trie = rte_lpm6_trie_create(NULL, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(trie == NULL && rte_errno == EINVAL);
+	config.max_rules = 0;
+	trie = rte_lpm6_trie_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(trie == NULL && rte_errno == EINVAL);
+	config.max_rules = MAX_RULES;
+
+	trie = rte_lpm6_trie_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(trie != NULL);
+	lpm6 = rte_lpm6_create(__func__, SOCKET_ID_ANY, &lpm6_config);
+	TEST_LPM_ASSERT(lpm6 != NULL);
+
+	TEST_LPM_ASSERT(rte_lpm6_trie_add(trie, ip, 0, 1) == -EINVAL);
+	TEST_LPM_ASSERT(rte_lpm6_trie_add(trie, ip, 129, 1) == -EINVAL);
+	TEST_LPM_ASSERT(rte_lpm6_trie_add(trie, ip, 1,
+			RTE_LPM6_TRIE_MAX_NEXT_HOP + 1) == -EINVAL);
+	TEST_LPM_ASSERT(rte_lpm6_trie_delete(trie, ip, 1) == -ENOENT);
+	TEST_LPM_ASSERT(rte_lpm6_trie_lookup(trie, ip, &next_hop) == -ENOENT);
+
+	/* add the routes in one batch */
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i++) {
+		memcpy(ips[i], large_route_table[i].ip, 16);
+		depths[i] = large_route_table[i].depth;
+		next_hops[i] = large_route_table[i].next_hop;
+		rte_lpm6_add(lpm6, ips[i], depths[i], next_hops[i]);
+	}
+	TEST_LPM_ASSERT(rte_lpm6_trie_add_bulk(trie, ips, depths, next_hops,
+			NUM_ROUTE_ENTRIES) == 0);
+
+	generate_large_ips_table(0);
+	for (i = 0; i < NUM_IPS_ENTRIES; i++)
+		memcpy(ip_batch[i], large_ips_table[i].ip, 16);
+	TEST_LPM_ASSERT(check_lookups(trie, lpm6) == 0);
+
+	/* update next hops, then delete half of the routes */
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i += 3) {
+		TEST_LPM_ASSERT(rte_lpm6_trie_add(trie, ips[i], depths[i],
+				next_hops[i] + 1000) == 0);
+		rte_lpm6_add(lpm6, ips[i], depths[i], next_hops[i] + 1000);
+		TEST_LPM_ASSERT(rte_lpm6_trie_is_rule_present(trie, ips[i],
+				depths[i], &next_hop) == 1);
+		TEST_LPM_ASSERT(next_hop == next_hops[i] + 1000);
+	}
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i += 2) {
+		rte_lpm6_trie_delete(trie, ips[i], depths[i]);
+		rte_lpm6_delete(lpm6, ips[i], depths[i]);
+		TEST_LPM_ASSERT(rte_lpm6_trie_is_rule_present(trie, ips[i],
+				depths[i], &next_hop) == 0);
+	}
+	TEST_LPM_ASSERT(check_lookups(trie, lpm6) == 0);
+
+	rte_lpm6_trie_delete_all(trie);
+	rte_lpm6_delete_all(lpm6);
+	TEST_LPM_ASSERT(check_lookups(trie, lpm6) == 0);
+	for (i = 0; i < NUM_IPS_ENTRIES; i++)
+		TEST_LPM_ASSERT(trie_next_hops[i] == -1);
+
+	ret = 0;
+out:
+	rte_lpm6_free(lpm6);
+	rte_lpm6_trie_free(trie);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(lpm6_trie_autotest, test_lpm6_trie);
@@ -60,6 +60,17 @@ is_aligned(void *p, int align)
 	return 1;
 }
 
+static int
+is_memory_zeroed(const char *p, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		if (p[i] != 0)
+			return 0;
+	return 1;
+}
+
 static int
 test_align_overlap_per_lcore(__attribute__((unused)) void *arg)
 {
@@ -677,6 +688,62 @@ test_zero_aligned_alloc(void)
 	return -1;
 }
 
+/*
+ * Check that small elements freed and allocated again from the same lcore,
+ * which go through the lcore cache when --malloc-lcore-cache is given, are
+ * zeroed and big enough.
+ */
+static int
+test_small_alloc_free(void)
+{
+#define N_SMALL 64
+	static const size_t sizes[] = { 1, 64, 100, 1000, 2048, 4096 };
+	char *ptrs[N_SMALL];
+	size_t size, real_size;
+	unsigned int i, j, k;
+
+	for (i = 0; i < RTE_DIM(sizes); i++) {
+		size = sizes[i];
+		for (k = 0; k < 2; k++) {
+			for (j = 0; j < N_SMALL; j++) {
+				ptrs[j] = rte_zmalloc(NULL, size, 0);
+				if (ptrs[j] == NULL) {
+					printf("rte_zmalloc(%zu) failed\n", size);
+					goto err_return;
+				}
+				if (rte_malloc_validate(ptrs[j], &real_size) < 0 ||
+						real_size < size) {
+					printf("Bad element of size %zu\n", size);
+					j++;
+					goto err_return;
+				}
+				if (!is_aligned(ptrs[j], RTE_CACHE_LINE_SIZE)) {
+					printf("Unaligned element\n");
+					j++;
+					goto err_return;
+				}
+				if (!is_memory_zeroed(ptrs[j], real_size)) {
+					printf("Element of size %zu not zeroed\n",
+						size);
+					j++;
+					goto err_return;
+				}
+				memset(ptrs[j], 0xa5, real_size);
+			}
+			for (j = 0; j < N_SMALL; j++)
+				rte_free(ptrs[j]);
+		}
+	}
+	rte_malloc_dump_stats(stdout, NULL);
+	return 0;
+
+err_return:
+	while (j-- > 0)
+		rte_free(ptrs[j]);
+	return -1;
+#undef N_SMALL
+}
+
 static int
 test_malloc_bad_params(void)
 {
@@ -839,6 +906,12 @@ test_malloc(void)
 	}
 	else printf("test_malloc_bad_params() passed\n");
 
+	if (test_small_alloc_free() < 0){
+		printf("test_small_alloc_free() failed\n");
+		return -1;
+	}
+	else printf("test_small_alloc_free() passed\n");
+
 	if (test_realloc() < 0){
 		printf("test_realloc() failed\n");
 		return -1;
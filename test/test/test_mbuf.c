@@ -27,6 +27,8 @@
 #include <rte_mbuf.h>
 #include <rte_random.h>
 #include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_errno.h>
 
 #include "test.h"
 
@@ -501,6 +503,238 @@ test_attach_from_different_pool(struct rte_mempool *pktmbuf_pool,
 		rte_pktmbuf_free(clone2);
 	return -1;
 }
+
+/*
+ * test rte_pktmbuf_free_bulk() with mbufs from two pools, chained and
+ * cloned mbufs and NULL pointers, then check that all mbufs are back
+ */
+static int
+test_pktmbuf_free_bulk(struct rte_mempool *pktmbuf_pool,
+		struct rte_mempool *pktmbuf_pool2)
+{
+	struct rte_mbuf *m[NB_MBUF / 2];
+	unsigned int i;
+
+	memset(m, 0, sizeof(m));
+
+	for (i = 0; i < RTE_DIM(m); i++) {
+		/* leave some holes, and one for the clone */
+		if (i % 7 == 3 || i == RTE_DIM(m) - 1)
+			continue;
+		m[i] = rte_pktmbuf_alloc(i % 3 == 0 ? pktmbuf_pool2 :
+				pktmbuf_pool);
+		if (m[i] == NULL)
+			GOTO_FAIL("rte_pktmbuf_alloc() failed (%u)", i);
+	}
+
+	/* chain segments from both pools */
+	for (i = 0; i + 1 < RTE_DIM(m); i += 8) {
+		if (m[i] == NULL || m[i + 1] == NULL)
+			continue;
+		if (rte_pktmbuf_chain(m[i], m[i + 1]) != 0)
+			GOTO_FAIL("rte_pktmbuf_chain() failed (%u)", i);
+		m[i + 1] = NULL;
+	}
+
+	/* a shared mbuf is only freed with its last reference */
+	m[RTE_DIM(m) - 1] = rte_pktmbuf_clone(m[RTE_DIM(m) - 2],
+			pktmbuf_pool);
+	if (m[RTE_DIM(m) - 1] == NULL)
+		GOTO_FAIL("rte_pktmbuf_clone() failed");
+
+	rte_pktmbuf_free_bulk(m, RTE_DIM(m));
+
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF)
+		GOTO_FAIL("mbufs not returned to pool");
+	if (rte_mempool_avail_count(pktmbuf_pool2) != NB_MBUF)
+		GOTO_FAIL("mbufs not returned to pool2");
+
+	return 0;
+
+fail:
+	for (i = 0; i < RTE_DIM(m); i++)
+		rte_pktmbuf_free(m[i]);
+	return -1;
+}
+
+/*
+ * test the Rx refill allocation: the fields of the first cache line get
+ * the values of a reset mbuf, whatever was left by the previous user
+ */
+static int
+test_pktmbuf_alloc_bulk_rearm(struct rte_mempool *pktmbuf_pool)
+{
+	struct rte_mbuf *m[NB_MBUF / 4];
+	struct rte_mbuf tmpl;
+	uint64_t rearm;
+	unsigned int i;
+
+	memset(m, 0, sizeof(m));
+
+	if (rte_pktmbuf_alloc_bulk(pktmbuf_pool, m, RTE_DIM(m)) != 0)
+		GOTO_FAIL("rte_pktmbuf_alloc_bulk() failed");
+	for (i = 0; i < RTE_DIM(m); i++) {
+		rte_pktmbuf_append(m[i], MBUF_TEST_DATA_LEN);
+		m[i]->ol_flags = PKT_RX_IP_CKSUM_GOOD;
+		m[i]->packet_type = RTE_PTYPE_L3_IPV4;
+		m[i]->vlan_tci = 1;
+		m[i]->hash.rss = 1;
+		rte_pktmbuf_adj(m[i], MBUF_TEST_HDR1_LEN);
+	}
+	rte_pktmbuf_free_bulk(m, RTE_DIM(m));
+	memset(m, 0, sizeof(m));
+
+	memset(&tmpl, 0, sizeof(tmpl));
+	tmpl.data_off = RTE_PKTMBUF_HEADROOM;
+	rte_mbuf_refcnt_set(&tmpl, 1);
+	tmpl.nb_segs = 1;
+	tmpl.port = 1;
+	rearm = *(uint64_t *)&tmpl.rearm_data;
+
+	if (rte_pktmbuf_alloc_bulk_rearm(pktmbuf_pool, m, RTE_DIM(m),
+			rearm) != 0)
+		GOTO_FAIL("rte_pktmbuf_alloc_bulk_rearm() failed");
+	for (i = 0; i < RTE_DIM(m); i++) {
+		if (rte_mbuf_refcnt_read(m[i]) != 1 || m[i]->nb_segs != 1 ||
+				m[i]->port != 1 || m[i]->next != NULL)
+			GOTO_FAIL("bad rearm data (%u)", i);
+		if (m[i]->data_off != RTE_PKTMBUF_HEADROOM ||
+				m[i]->pkt_len != 0 || m[i]->data_len != 0)
+			GOTO_FAIL("bad length (%u)", i);
+		if (m[i]->ol_flags != 0 || m[i]->packet_type != 0 ||
+				m[i]->vlan_tci != 0 || m[i]->hash.rss != 0)
+			GOTO_FAIL("bad Rx fields (%u)", i);
+	}
+	rte_pktmbuf_free_bulk(m, RTE_DIM(m));
+
+	if (rte_mempool_avail_count(pktmbuf_pool) != NB_MBUF)
+		GOTO_FAIL("mbufs not returned to pool");
+
+	return 0;
+
+fail:
+	for (i = 0; i < RTE_DIM(m); i++)
+		rte_pktmbuf_free(m[i]);
+	return -1;
+}
+
+/*
+ * test a pool of mbufs with pinned external buffers: the buffers stay
+ * attached when the mbufs are freed, and a mbuf freed while cloned goes
+ * back to its pool with its last clone
+ */
+static int
+test_pktmbuf_ext_pinned_buffer(struct rte_mempool *pktmbuf_pool)
+{
+	struct rte_pktmbuf_extmem ext_mem;
+	struct rte_mempool *pinned_pool = NULL;
+	struct rte_mbuf *m[8], *clone = NULL, *parent;
+	struct rte_mbuf tmpl;
+	unsigned int i;
+	uint64_t rearm;
+	char *area;
+
+	memset(m, 0, sizeof(m));
+
+	area = rte_malloc(NULL, NB_MBUF * MBUF_DATA_SIZE, 0);
+	if (area == NULL)
+		GOTO_FAIL("cannot allocate external memory");
+
+	ext_mem.buf_ptr = area;
+	ext_mem.buf_iova = rte_malloc_virt2iova(area);
+	ext_mem.buf_len = NB_MBUF * MBUF_DATA_SIZE;
+	ext_mem.elt_size = MBUF_DATA_SIZE;
+
+	/* not enough buffers in the area */
+	pinned_pool = rte_pktmbuf_pool_create_extbuf("test_pinned_pool",
+			NB_MBUF + 1, 0, 0, MBUF_DATA_SIZE, SOCKET_ID_ANY,
+			&ext_mem, 1);
+	if (pinned_pool != NULL || rte_errno != ENOMEM)
+		GOTO_FAIL("pool created with too few external buffers");
+
+	pinned_pool = rte_pktmbuf_pool_create_extbuf("test_pinned_pool",
+			NB_MBUF, 0, 0, MBUF_DATA_SIZE, SOCKET_ID_ANY,
+			&ext_mem, 1);
+	if (pinned_pool == NULL)
+		GOTO_FAIL("cannot create pool with pinned external buffers");
+
+	for (i = 0; i < RTE_DIM(m); i++) {
+		m[i] = rte_pktmbuf_alloc(pinned_pool);
+		if (m[i] == NULL)
+			GOTO_FAIL("rte_pktmbuf_alloc() failed (%u)", i);
+		if (!RTE_MBUF_HAS_PINNED_EXTBUF(m[i]))
+			GOTO_FAIL("mbuf has no pinned external buffer");
+		if ((char *)m[i]->buf_addr < area ||
+		    (char *)m[i]->buf_addr >= area + ext_mem.buf_len)
+			GOTO_FAIL("buffer not in the external memory");
+		if (rte_pktmbuf_append(m[i], MBUF_TEST_DATA_LEN) == NULL)
+			GOTO_FAIL("cannot append data");
+	}
+
+	/* the original mbuf is only recycled with its clone */
+	parent = m[0];
+	clone = rte_pktmbuf_clone(m[0], pktmbuf_pool);
+	if (clone == NULL)
+		GOTO_FAIL("cannot clone mbuf");
+	if (clone->buf_addr != m[0]->buf_addr)
+		GOTO_FAIL("clone does not share the buffer");
+	rte_pktmbuf_free(m[0]);
+	m[0] = NULL;
+	if (rte_mempool_avail_count(pinned_pool) !=
+			NB_MBUF - RTE_DIM(m))
+		GOTO_FAIL("cloned mbuf returned to pool");
+	rte_pktmbuf_free(clone);
+	clone = NULL;
+	if (rte_mempool_avail_count(pinned_pool) !=
+			NB_MBUF - RTE_DIM(m) + 1)
+		GOTO_FAIL("cloned mbuf not returned to pool");
+	if (rte_mbuf_refcnt_read(parent) != 1)
+		GOTO_FAIL("cloned mbuf returned to pool with refcnt %u",
+			rte_mbuf_refcnt_read(parent));
+
+	rte_pktmbuf_free_bulk(&m[1], RTE_DIM(m) - 1);
+	memset(m, 0, sizeof(m));
+	if (rte_mempool_avail_count(pinned_pool) != NB_MBUF)
+		GOTO_FAIL("mbufs not returned to pool");
+
+	/* the buffer is still attached after reallocation */
+	m[0] = rte_pktmbuf_alloc(pinned_pool);
+	if (m[0] == NULL || !RTE_MBUF_HAS_PINNED_EXTBUF(m[0]) ||
+	    m[0]->data_len != 0)
+		GOTO_FAIL("reallocated mbuf is not reset");
+	rte_pktmbuf_free(m[0]);
+	m[0] = NULL;
+
+	/* and after a rearm allocation */
+	memset(&tmpl, 0, sizeof(tmpl));
+	tmpl.data_off = RTE_PKTMBUF_HEADROOM;
+	rte_mbuf_refcnt_set(&tmpl, 1);
+	tmpl.nb_segs = 1;
+	rearm = *(uint64_t *)&tmpl.rearm_data;
+	if (rte_pktmbuf_alloc_bulk_rearm(pinned_pool, m, RTE_DIM(m),
+			rearm) != 0)
+		GOTO_FAIL("rte_pktmbuf_alloc_bulk_rearm() failed");
+	for (i = 0; i < RTE_DIM(m); i++) {
+		if (!RTE_MBUF_HAS_PINNED_EXTBUF(m[i]))
+			GOTO_FAIL("rearmed mbuf has no pinned external buffer");
+	}
+	rte_pktmbuf_free_bulk(m, RTE_DIM(m));
+	memset(m, 0, sizeof(m));
+	if (rte_mempool_avail_count(pinned_pool) != NB_MBUF)
+		GOTO_FAIL("rearmed mbufs not returned to pool");
+
+	rte_mempool_free(pinned_pool);
+	rte_free(area);
+	return 0;
+
+fail:
+	rte_pktmbuf_free(clone);
+	for (i = 0; i < RTE_DIM(m); i++)
+		rte_pktmbuf_free(m[i]);
+	rte_mempool_free(pinned_pool);
+	rte_free(area);
+	return -1;
+}
 #undef GOTO_FAIL
 
 /*
@@ -1102,6 +1336,22 @@ test_mbuf(void)
 		goto err;
 	}
 
+	/* test bulk free of mbufs from several pools */
+	if (test_pktmbuf_free_bulk(pktmbuf_pool, pktmbuf_pool2) < 0) {
+		printf("test_pktmbuf_free_bulk() failed\n");
+		goto err;
+	}
+
+	if (test_pktmbuf_alloc_bulk_rearm(pktmbuf_pool) < 0) {
+		printf("test_pktmbuf_alloc_bulk_rearm() failed\n");
+		goto err;
+	}
+
+	if (test_pktmbuf_ext_pinned_buffer(pktmbuf_pool) < 0) {
+		printf("test_pktmbuf_ext_pinned_buffer() failed\n");
+		goto err;
+	}
+
 	if (testclone_testupdate_testdetach(pktmbuf_pool) < 0) {
 		printf("testclone_and_testupdate() failed \n");
 		goto err;
@@ -6,6 +6,7 @@
 #include <inttypes.h>
 
 #include <rte_lcore.h>
+#include <rte_launch.h>
 #include <rte_cycles.h>
 #include <rte_malloc.h>
 #include <rte_random.h>
@@ -612,6 +613,149 @@ run_all_tbl_perf_tests(void)
 	return 0;
 }
 
+/* Lookups of each lcore while the master lcore updates the set summary */
+struct rw_lf_stats {
+	uint64_t cycles;
+	uint64_t lookups;
+} __rte_cache_aligned;
+
+static struct rw_lf_stats rw_lf_stats[RTE_MAX_LCORE];
+static uint32_t rw_lf_writer_done;
+
+static int
+lookups_rw_lf(void *arg)
+{
+	struct rte_member_setsum *setsum = arg;
+	struct rw_lf_stats *stats = &rw_lf_stats[rte_lcore_id()];
+	member_set_t result[BURST_SIZE];
+	const void *keys_burst[BURST_SIZE];
+	unsigned int j, k;
+	uint64_t lookups = 0;
+	const uint64_t start_tsc = rte_rdtsc();
+
+	/* look up the first half of the keys, the writer moves them */
+	do {
+		for (j = 0; j < KEYS_TO_ADD / 2 / BURST_SIZE; j++) {
+			for (k = 0; k < BURST_SIZE; k++)
+				keys_burst[k] = keys[j * BURST_SIZE + k];
+
+			rte_member_lookup_bulk(setsum, keys_burst, BURST_SIZE,
+					result);
+
+			for (k = 0; k < BURST_SIZE; k++) {
+				if (result[k] == RTE_MEMBER_NO_MATCH) {
+					printf("HT mode shouldn't have false "
+						"negative during updates\n");
+					return -1;
+				}
+			}
+			lookups += BURST_SIZE;
+		}
+	} while (!__atomic_load_n(&rw_lf_writer_done, __ATOMIC_RELAXED));
+
+	stats->cycles = rte_rdtsc() - start_tsc;
+	stats->lookups = lookups;
+	return 0;
+}
+
+/*
+ * Run lock-free bulk lookups on all the slave lcores, while the master lcore
+ * adds and deletes the second half of the keys or not.
+ */
+static int
+timed_lookups_rw_lf(struct member_perf_params *params, int with_updates,
+		uint64_t *lookup_cycles, uint64_t *update_cycles)
+{
+	struct rte_member_setsum *setsum = params->setsum[HT];
+	unsigned int i, lcore_id, pass;
+	uint64_t cycles_sum = 0, lookups_sum = 0;
+	uint64_t start_tsc;
+	int ret = 0;
+
+	__atomic_store_n(&rw_lf_writer_done, !with_updates, __ATOMIC_RELAXED);
+	rte_eal_mp_remote_launch(lookups_rw_lf, setsum, SKIP_MASTER);
+
+	if (with_updates) {
+		start_tsc = rte_rdtsc();
+		for (pass = 0; pass < 2 && ret >= 0; pass++) {
+			for (i = KEYS_TO_ADD / 2; i < KEYS_TO_ADD; i++) {
+				ret = rte_member_add(setsum, &keys[i],
+						data[HT][i]);
+				if (ret < 0) {
+					printf("Error %d in rte_member_add\n",
+							ret);
+					break;
+				}
+			}
+			for (i = KEYS_TO_ADD / 2; i < KEYS_TO_ADD && ret >= 0;
+					i++)
+				rte_member_delete(setsum, &keys[i],
+						data[HT][i]);
+		}
+		*update_cycles = (rte_rdtsc() - start_tsc) / (KEYS_TO_ADD * 2);
+		__atomic_store_n(&rw_lf_writer_done, 1, __ATOMIC_RELAXED);
+	}
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (rte_eal_wait_lcore(lcore_id) < 0)
+			ret = -1;
+		cycles_sum += rw_lf_stats[lcore_id].cycles;
+		lookups_sum += rw_lf_stats[lcore_id].lookups;
+	}
+
+	if (lookups_sum != 0)
+		*lookup_cycles = cycles_sum / lookups_sum;
+	return ret < 0 ? -1 : 0;
+}
+
+static int
+run_rw_lf_perf_test(void)
+{
+	struct member_perf_params params;
+	uint64_t lookup_cycles = 0, lookup_cycles_rw = 0, update_cycles = 0;
+	unsigned int i;
+	int ret;
+
+	if (rte_lcore_count() < 2) {
+		printf("\nLock-free lookups need at least 2 lcores, skipping\n");
+		return 0;
+	}
+
+	/* 16-byte keys, only the HT set summary is used */
+	member_params.extra_flag = RTE_MEMBER_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+	ret = setup_keys_and_data(&params, 2, 0);
+	member_params.extra_flag = 0;
+	if (ret < 0) {
+		printf("Could not create keys/data/table\n");
+		return -1;
+	}
+
+	for (i = 0; i < KEYS_TO_ADD / 2; i++) {
+		if (rte_member_add(params.setsum[HT], &keys[i],
+				data[HT][i]) < 0)
+			return exit_with_fail("rte_member_add", &params, 2, HT);
+	}
+
+	if (timed_lookups_rw_lf(&params, 0, &lookup_cycles, NULL) < 0)
+		return exit_with_fail("timed_lookups_rw_lf", &params, 2, HT);
+
+	if (timed_lookups_rw_lf(&params, 1, &lookup_cycles_rw,
+			&update_cycles) < 0)
+		return exit_with_fail("timed_lookups_rw_lf", &params, 2, HT);
+
+	perform_frees(&params);
+
+	printf("\nLock-free HT lookups with %u lookup lcores "
+			"(in CPU cycles/operation)\n", rte_lcore_count() - 1);
+	printf("-----------------------------------\n");
+	printf("\n%-18s%-18s%-18s%-18s\n", "Keysize", "Lookup_bulk",
+			"Lookup_bulk_rw", "Add_delete_rw");
+	printf("%-18d%-18"PRIu64"%-18"PRIu64"%-18"PRIu64"\n",
+			hashtest_key_lens[2], lookup_cycles, lookup_cycles_rw,
+			update_cycles);
+	return 0;
+}
+
 static int
 test_member_perf(void)
 {
@@ -619,6 +763,9 @@ test_member_perf(void)
 	if (run_all_tbl_perf_tests() < 0)
 		return -1;
 
+	if (run_rw_lf_perf_test() < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -268,6 +268,68 @@ perf_test_variable_unaligned(void)
 	}
 }
 
+/*
+ * Run a single rte_memcpy_nt() performance test, compared to rte_memcpy().
+ * Each batch is followed by a store fence, as the users of non-temporal
+ * copies need one before publishing the data.
+ */
+#define SINGLE_NT_PERF_TEST(dst, is_dst_cached, dst_uoffset,                \
+                            src, is_src_cached, src_uoffset, size)          \
+do {                                                                        \
+    unsigned int iter, t;                                                   \
+    size_t dst_addrs[TEST_BATCH_SIZE], src_addrs[TEST_BATCH_SIZE];          \
+    uint64_t start_time, total_time = 0;                                    \
+    uint64_t total_time2 = 0;                                               \
+    for (iter = 0; iter < (TEST_ITERATIONS / TEST_BATCH_SIZE); iter++) {    \
+        fill_addr_arrays(dst_addrs, is_dst_cached, dst_uoffset,             \
+                         src_addrs, is_src_cached, src_uoffset);            \
+        start_time = rte_rdtsc();                                           \
+        for (t = 0; t < TEST_BATCH_SIZE; t++)                               \
+            rte_memcpy_nt(dst+dst_addrs[t], src+src_addrs[t], size);        \
+        rte_wmb();                                                          \
+        total_time += rte_rdtsc() - start_time;                             \
+    }                                                                       \
+    for (iter = 0; iter < (TEST_ITERATIONS / TEST_BATCH_SIZE); iter++) {    \
+        fill_addr_arrays(dst_addrs, is_dst_cached, dst_uoffset,             \
+                         src_addrs, is_src_cached, src_uoffset);            \
+        start_time = rte_rdtsc();                                           \
+        for (t = 0; t < TEST_BATCH_SIZE; t++)                               \
+            rte_memcpy(dst+dst_addrs[t], src+src_addrs[t], size);           \
+        rte_wmb();                                                          \
+        total_time2 += rte_rdtsc() - start_time;                            \
+    }                                                                       \
+    printf("%3.0f -", (double)total_time  / TEST_ITERATIONS);                 \
+    printf("%3.0f",   (double)total_time2 / TEST_ITERATIONS);                 \
+    printf("(%6.2f%%) ", ((double)total_time - total_time2)*100/total_time2); \
+} while (0)
+
+/* Sizes of the packet copies to guest buffers, mostly uncached */
+static size_t nt_buf_sizes[] = {
+	64, 128, 256, 512, 1024, 1518, 2048, 4096, 8192
+};
+
+/* Run rte_memcpy_nt() tests to cached and uncached destinations */
+static inline void
+perf_test_nt(void)
+{
+	unsigned int n = RTE_DIM(nt_buf_sizes);
+	unsigned int i;
+	size_t size;
+
+	for (i = 0; i < n; i++) {
+		size = nt_buf_sizes[i];
+		printf("\n%7u", (unsigned int)size);
+		SINGLE_NT_PERF_TEST(small_buf_write, 1, 0, small_buf_read, 1, 0,
+				size);
+		SINGLE_NT_PERF_TEST(large_buf_write, 0, 0, small_buf_read, 1, 0,
+				size);
+		SINGLE_NT_PERF_TEST(large_buf_write, 0, 1, small_buf_read, 1, 5,
+				size);
+		SINGLE_NT_PERF_TEST(large_buf_write, 0, 1, large_buf_read, 0, 5,
+				size);
+	}
+}
+
 /* Run all memcpy tests */
 static int
 perf_test(void)
@@ -333,6 +395,15 @@ perf_test(void)
 	printf("Aligned constant copy size   = %8.3f\n", time_aligned_const);
 	printf("Unaligned variable copy size = %8.3f\n", time_unaligned);
 	printf("Unaligned constant copy size = %8.3f\n", time_unaligned_const);
+
+	printf("\n** rte_memcpy_nt() - rte_memcpy() perf. tests **\n"
+		   "======= ================= ================= ================= =================\n"
+		   "   Size   Cache to cache     Cache to mem     Cache to mem       Mem to mem\n"
+		   "                                             (unaligned)       (unaligned)\n"
+		   "(bytes)          (ticks)          (ticks)           (ticks)           (ticks)\n"
+		   "------- ----------------- ----------------- ----------------- -----------------");
+	perf_test_nt();
+	printf("\n======= ================= ================= ================= =================\n\n");
 	free_buffers();
 
 	return 0;
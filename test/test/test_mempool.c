@@ -447,6 +447,80 @@ test_mempool_same_name_twice_creation(void)
 	return 0;
 }
 
+/*
+ * test that an adaptive cache grows when the gets and puts are unbalanced,
+ * then shrinks back to its minimum size when they are balanced
+ */
+static int
+test_mempool_adaptive_cache(void)
+{
+	struct rte_mempool *mp;
+	struct rte_mempool_cache *cache;
+	void *objs[4 * 32];
+	unsigned int i, j;
+	int ret = -1;
+
+	mp = rte_mempool_create("test_adaptive", MEMPOOL_SIZE,
+		MEMPOOL_ELT_SIZE, 32, 0,
+		NULL, NULL,
+		NULL, NULL,
+		SOCKET_ID_ANY, 0);
+	if (mp == NULL)
+		RET_ERR();
+
+	/* invalid bounds */
+	if (rte_mempool_cache_adaptive_set(mp, 0, 64) != -EINVAL)
+		GOTO_ERR(ret, out);
+	if (rte_mempool_cache_adaptive_set(mp, 64, 16) != -EINVAL)
+		GOTO_ERR(ret, out);
+	if (rte_mempool_cache_adaptive_set(mp, 16,
+			RTE_MEMPOOL_CACHE_MAX_SIZE + 1) != -EINVAL)
+		GOTO_ERR(ret, out);
+
+	if (rte_mempool_cache_adaptive_set(mp, 16, 256) < 0)
+		GOTO_ERR(ret, out);
+
+	cache = rte_mempool_default_cache(mp, rte_lcore_id());
+	if (cache == NULL || cache->size != 32)
+		GOTO_ERR(ret, out);
+
+	/* unbalanced: take several bursts before giving them back */
+	for (i = 0; i < 4 * RTE_MEMPOOL_CACHE_ADAPT_WINDOW; i++) {
+		for (j = 0; j < 4; j++)
+			if (rte_mempool_get_bulk(mp, &objs[j * 32], 32) < 0)
+				GOTO_ERR(ret, out);
+		for (j = 0; j < 4; j++)
+			rte_mempool_put_bulk(mp, &objs[j * 32], 32);
+	}
+	if (cache->stats.grows == 0)
+		GOTO_ERR(ret, out);
+
+	/* balanced: the cache always hits and shrinks to its minimum */
+	for (i = 0; i < 16 * RTE_MEMPOOL_CACHE_ADAPT_WINDOW; i++) {
+		if (rte_mempool_get(mp, &objs[0]) < 0)
+			GOTO_ERR(ret, out);
+		rte_mempool_put(mp, objs[0]);
+	}
+	if (cache->size != 16 || cache->len > cache->flushthresh ||
+			cache->stats.shrinks == 0)
+		GOTO_ERR(ret, out);
+
+	if (cache->stats.get_hits == 0 || cache->stats.get_misses == 0 ||
+			cache->stats.put_hits == 0)
+		GOTO_ERR(ret, out);
+
+	rte_mempool_dump(stdout, mp);
+
+	if (rte_mempool_avail_count(mp) != mp->size)
+		GOTO_ERR(ret, out);
+
+	ret = 0;
+
+out:
+	rte_mempool_free(mp);
+	return ret;
+}
+
 static void
 walk_cb(struct rte_mempool *mp, void *userdata __rte_unused)
 {
@@ -571,6 +645,9 @@ test_mempool(void)
 	if (test_mempool_same_name_twice_creation() < 0)
 		goto err;
 
+	if (test_mempool_adaptive_cache() < 0)
+		goto err;
+
 	/* test the stack handler */
 	if (test_mempool_basic(mp_stack, 1) < 0)
 		goto err;
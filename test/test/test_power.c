@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <limits.h>
 #include <string.h>
@@ -21,7 +22,65 @@ test_power(void)
 
 #else
 
+#include <rte_lcore.h>
 #include <rte_power.h>
+#include <rte_power_idle.h>
+
+static int
+test_power_idle(void)
+{
+	struct rte_power_idle_conf conf = {
+		.sleep_threshold = 4,
+		.sleep_us = 1,
+	};
+	struct rte_power_idle_stats stats;
+	unsigned int lcore_id = rte_lcore_id();
+	unsigned int i;
+
+	if (rte_power_idle_enable(RTE_MAX_LCORE, &conf) == 0) {
+		printf("Idle detection enabled on an invalid lcore\n");
+		return -1;
+	}
+
+	/* scaling needs an initialised environment */
+	conf.scale_period_us = 1000;
+	conf.scale_down_percent = 90;
+	conf.scale_up_percent = 50;
+	if (rte_power_idle_enable(lcore_id, &conf) == 0) {
+		printf("Idle scaling enabled without environment\n");
+		return -1;
+	}
+	conf.scale_period_us = 0;
+
+	if (rte_power_idle_enable(lcore_id, &conf) != 0) {
+		printf("Cannot enable idle detection\n");
+		return -1;
+	}
+
+	/* sleeps start at the 4th consecutive empty poll */
+	for (i = 0; i < 5; i++)
+		rte_power_idle_update(lcore_id, 0);
+	rte_power_idle_update(lcore_id, 32);
+	rte_power_idle_update(lcore_id, 0);
+
+	rte_power_idle_stats_get(lcore_id, &stats);
+	if (stats.polls != 7 || stats.empty_polls != 6 || stats.sleeps != 2) {
+		printf("Bad idle stats: polls %"PRIu64" empty %"PRIu64
+			" sleeps %"PRIu64"\n",
+			stats.polls, stats.empty_polls, stats.sleeps);
+		return -1;
+	}
+
+	rte_power_idle_disable(lcore_id);
+	rte_power_idle_update(lcore_id, 0);
+	rte_power_idle_stats_get(lcore_id, &stats);
+	if (stats.polls != 7) {
+		printf("Idle stats updated while disabled\n");
+		return -1;
+	}
+
+	return 0;
+}
 
 static int
 test_power(void)
@@ -80,6 +139,10 @@ test_power(void)
 		goto fail_all;
 	}
 	rte_power_unset_env();
+
+	if (test_power_idle() < 0)
+		return -1;
+
 	return 0;
 fail_all:
 	rte_power_unset_env();
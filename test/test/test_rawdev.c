@@ -25,3 +25,11 @@ test_rawdev_selftest_skeleton(void)
 }
 
 REGISTER_TEST_COMMAND(rawdev_autotest, test_rawdev_selftest_skeleton);
+
+static int
+test_rawdev_selftest_swdma(void)
+{
+	return test_rawdev_selftest_impl("rawdev_swdma", "");
+}
+
+REGISTER_TEST_COMMAND(rawdev_swdma_autotest, test_rawdev_selftest_swdma);
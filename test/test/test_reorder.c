@@ -330,6 +330,143 @@ test_reorder_drain(void)
 	return ret;
 }
 
+static int
+test_reorder_mp(void)
+{
+	struct rte_reorder_mp_buffer *b = NULL;
+	struct rte_mempool *p = test_params->p;
+	const unsigned int size = 4;
+	const unsigned int num_bufs = 10;
+	struct rte_mbuf *bufs[num_bufs];
+	struct rte_mbuf *robufs[num_bufs];
+	int ret = 0;
+	unsigned i, cnt;
+
+	for (i = 0; i < num_bufs; i++) {
+		bufs[i] = NULL;
+		robufs[i] = NULL;
+	}
+
+	b = rte_reorder_mp_create("test_mp", rte_socket_id(), size);
+	TEST_ASSERT_NOT_NULL(b, "Failed to create reorder buffer");
+
+	/* Check no drained packets if reorder is empty */
+	cnt = rte_reorder_mp_drain(b, robufs, 1);
+	if (cnt != 0) {
+		printf("%s:%d: drained packets from empty reorder buffer\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+
+	for (i = 0; i < num_bufs; i++) {
+		bufs[i] = rte_pktmbuf_alloc(p);
+		TEST_ASSERT_NOT_NULL(bufs[i], "Packet allocation failed\n");
+		bufs[i]->seqn = i;
+	}
+
+	/* Insert packets 0, 2 and 3, the first one setting the window:
+	 * min_seqn = 0
+	 * slots[] = {0, NULL, 2, 3}
+	 */
+	robufs[0] = bufs[0];
+	robufs[1] = bufs[2];
+	robufs[2] = bufs[3];
+	cnt = rte_reorder_mp_insert_burst(b, robufs, 3);
+	if (cnt != 3) {
+		printf("%s:%d: burst of packets not inserted\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	bufs[0] = bufs[2] = bufs[3] = NULL;
+	robufs[0] = robufs[1] = robufs[2] = NULL;
+
+	/* Only packet 0 is in order */
+	cnt = rte_reorder_mp_drain(b, robufs, num_bufs);
+	if (cnt != 1 || robufs[0]->seqn != 0) {
+		printf("%s:%d:%d: number of expected packets not drained\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+	rte_pktmbuf_free(robufs[0]);
+	robufs[0] = NULL;
+
+	/* Packet 6 is beyond the window, and requests skipping packet 1 */
+	ret = rte_reorder_mp_insert(b, bufs[6]);
+	if (!((ret == -1) && (rte_errno == ENOSPC))) {
+		printf("%s:%d: No error inserting early packet\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Packet 1 is skipped, 2 and 3 drained:
+	 * min_seqn = 4
+	 * slots[] = {NULL, NULL, NULL, NULL}
+	 */
+	cnt = rte_reorder_mp_drain(b, robufs, num_bufs);
+	if (cnt != 2 || robufs[0]->seqn != 2 || robufs[1]->seqn != 3) {
+		printf("%s:%d:%d: number of expected packets not drained\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+	for (i = 0; i < cnt; i++) {
+		rte_pktmbuf_free(robufs[i]);
+		robufs[i] = NULL;
+	}
+
+	/* Packet 6 now fits in the window */
+	ret = rte_reorder_mp_insert(b, bufs[6]);
+	if (ret != 0) {
+		printf("%s:%d: Error inserting packet\n", __func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	bufs[6] = NULL;
+
+	/* Packet 1 is late */
+	ret = rte_reorder_mp_insert(b, bufs[1]);
+	if (!((ret == -1) && (rte_errno == ERANGE))) {
+		printf("%s:%d: No error inserting late packet\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Packet 9 requests skipping packets 4 and 5 */
+	ret = rte_reorder_mp_insert(b, bufs[9]);
+	if (!((ret == -1) && (rte_errno == ENOSPC))) {
+		printf("%s:%d: No error inserting early packet\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+
+	cnt = rte_reorder_mp_drain(b, robufs, num_bufs);
+	if (cnt != 1 || robufs[0]->seqn != 6) {
+		printf("%s:%d:%d: number of expected packets not drained\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+	rte_pktmbuf_free(robufs[0]);
+	robufs[0] = NULL;
+
+	ret = 0;
+exit:
+	rte_reorder_mp_free(b);
+	for (i = 0; i < num_bufs; i++) {
+		if (bufs[i] != NULL)
+			rte_pktmbuf_free(bufs[i]);
+		if (robufs[i] != NULL)
+			rte_pktmbuf_free(robufs[i]);
+	}
+	return ret;
+}
+
 static int
 test_setup(void)
 {
@@ -380,6 +517,7 @@ static struct unit_test_suite reorder_test_suite  = {
 		TEST_CASE(test_reorder_free),
 		TEST_CASE(test_reorder_insert),
 		TEST_CASE(test_reorder_drain),
+		TEST_CASE(test_reorder_mp),
 		TEST_CASES_END()
 	}
 };
@@ -23,6 +23,7 @@
 #include <rte_branch_prediction.h>
 #include <rte_malloc.h>
 #include <rte_ring.h>
+#include <rte_ring_elem.h>
 #include <rte_random.h>
 #include <rte_errno.h>
 #include <rte_hexdump.h>
@@ -807,6 +808,219 @@ test_ring_with_exact_size(void)
 	return ret;
 }
 
+/*
+ * check the zero copy API, with objects wrapping around the end of the ring
+ */
+static void
+test_ring_zc_write(struct rte_ring_zc_data *zcd, unsigned int n,
+		uintptr_t *seq)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++, (*seq)++) {
+		if (i < zcd->n1)
+			zcd->ptr1[i] = (void *)*seq;
+		else
+			zcd->ptr2[i - zcd->n1] = (void *)*seq;
+	}
+}
+
+static int
+test_ring_zc_check(struct rte_ring_zc_data *zcd, unsigned int n,
+		uintptr_t *seq)
+{
+	unsigned int i;
+	void *obj;
+
+	for (i = 0; i < n; i++, (*seq)++) {
+		obj = (i < zcd->n1) ? zcd->ptr1[i] : zcd->ptr2[i - zcd->n1];
+		if (obj != (void *)*seq)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_ring_zero_copy(void)
+{
+	struct rte_ring *r;
+	struct rte_ring_zc_data zcd;
+	uintptr_t enq_seq = 0, deq_seq = 0;
+	unsigned int i, n, n_wraps = 0;
+	int ret = -1;
+
+	r = rte_ring_create("test_ring_zc", 16, rte_socket_id(),
+			RING_F_SP_ENQ | RING_F_SC_DEQ);
+	if (r == NULL) {
+		printf("%s: error, can't create ring\n", __func__);
+		return -1;
+	}
+
+	for (i = 0; i < 40; i++) {
+		n = rte_ring_sp_enqueue_zc_bulk_start(r, 5, &zcd, NULL);
+		if (n != 5) {
+			printf("%s: error, enqueue start failed\n", __func__);
+			goto end;
+		}
+		if (zcd.ptr2 != NULL)
+			n_wraps++;
+		test_ring_zc_write(&zcd, n, &enq_seq);
+		rte_ring_sp_enqueue_zc_finish(r, n);
+
+		/* reserve the rest of the ring, then release it */
+		n = rte_ring_sp_enqueue_zc_burst_start(r, 32, &zcd, NULL);
+		if (n != rte_ring_get_capacity(r) - 5) {
+			printf("%s: error, enqueue burst start returned %u\n",
+				__func__, n);
+			goto end;
+		}
+		rte_ring_sp_enqueue_zc_finish(r, 0);
+
+		/* consume part of the objects, the rest stay in the ring */
+		n = rte_ring_sc_dequeue_zc_burst_start(r, 8, &zcd, NULL);
+		if (n != 5 || test_ring_zc_check(&zcd, 3, &deq_seq) < 0) {
+			printf("%s: error, dequeue burst start failed\n",
+				__func__);
+			goto end;
+		}
+		rte_ring_sc_dequeue_zc_finish(r, 3);
+
+		n = rte_ring_sc_dequeue_zc_bulk_start(r, 2, &zcd, NULL);
+		if (n != 2 || test_ring_zc_check(&zcd, n, &deq_seq) < 0) {
+			printf("%s: error, dequeue bulk start failed\n",
+				__func__);
+			goto end;
+		}
+		rte_ring_sc_dequeue_zc_finish(r, n);
+
+		if (!rte_ring_empty(r)) {
+			printf("%s: error, ring not empty\n", __func__);
+			goto end;
+		}
+	}
+
+	if (n_wraps == 0) {
+		printf("%s: error, no object wrapped around\n", __func__);
+		goto end;
+	}
+
+	ret = 0;
+end:
+	rte_ring_free(r);
+	return ret;
+}
+
+/*
+ * check the rings of inline elements, for each supported element size
+ */
+static int
+test_ring_elem_size(unsigned int esize)
+{
+	struct rte_ring *r;
+	uint32_t src[MAX_BULK * 8], dst[MAX_BULK * 8];
+	unsigned int i, n, words = esize / sizeof(uint32_t);
+	char name[RTE_RING_NAMESIZE];
+	int ret = -1;
+
+	snprintf(name, sizeof(name), "test_ring_elem%u", esize);
+	r = rte_ring_create_elem(name, esize, 64, rte_socket_id(), 0);
+	if (r == NULL) {
+		printf("%s: error, can't create ring\n", __func__);
+		return -1;
+	}
+
+	for (i = 0; i < RTE_DIM(src); i++)
+		src[i] = i;
+
+	/* several rounds, so that the elements wrap around the ring */
+	for (i = 0; i < 8; i++) {
+		memset(dst, 0, sizeof(dst));
+
+		n = rte_ring_enqueue_bulk_elem(r, src, esize, MAX_BULK - 1,
+				NULL);
+		if (n != MAX_BULK - 1) {
+			printf("%s: error, bulk enqueue failed\n", __func__);
+			goto end;
+		}
+		if (rte_ring_sp_enqueue_elem(r, &src[n * words], esize) != 0) {
+			printf("%s: error, enqueue failed\n", __func__);
+			goto end;
+		}
+		if (rte_ring_count(r) != MAX_BULK) {
+			printf("%s: error, wrong count\n", __func__);
+			goto end;
+		}
+
+		n = rte_ring_mc_dequeue_burst_elem(r, dst, esize, MAX_BULK * 2,
+				NULL);
+		if (n != MAX_BULK ||
+				memcmp(src, dst, n * esize) != 0) {
+			printf("%s: error, wrong dequeued elements\n",
+				__func__);
+			goto end;
+		}
+		if (rte_ring_dequeue_elem(r, dst, esize) != -ENOENT) {
+			printf("%s: error, dequeue from empty ring\n",
+				__func__);
+			goto end;
+		}
+	}
+
+	ret = 0;
+end:
+	rte_ring_free(r);
+	return ret;
+}
+
+static int
+test_ring_elem(void)
+{
+	static const unsigned int esizes[] = {4, 8, 16, 32};
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(esizes); i++)
+		if (test_ring_elem_size(esizes[i]) < 0)
+			return -1;
+
+	/* unsupported element size */
+	if (rte_ring_create_elem("test_ring_elem_bad", 12, 64,
+			rte_socket_id(), 0) != NULL) {
+		printf("%s: error, created a ring with bad element size\n",
+			__func__);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * run the basic tests on a non-blocking ring
+ */
+static int
+test_ring_lf(void)
+{
+	struct rte_ring *r;
+	int ret = 0;
+
+	r = rte_ring_create("test_ring_lf", RING_SIZE, SOCKET_ID_ANY,
+			RING_F_LF);
+	if (r == NULL) {
+		if (rte_errno == ENOTSUP) {
+			printf("Non-blocking ring not supported, skipped\n");
+			return 0;
+		}
+		printf("%s: error, can't create ring\n", __func__);
+		return -1;
+	}
+
+	if (test_ring_burst_basic(r) < 0 || test_ring_basic(r) < 0)
+		ret = -1;
+
+	rte_ring_free(r);
+	return ret;
+}
+
 static int
 test_ring(void)
 {
@@ -860,6 +1074,15 @@ test_ring(void)
 	if (test_ring_with_exact_size() < 0)
 		goto test_fail;
 
+	if (test_ring_zero_copy() < 0)
+		goto test_fail;
+
+	if (test_ring_elem() < 0)
+		goto test_fail;
+
+	if (test_ring_lf() < 0)
+		goto test_fail;
+
 	/* dump the ring status */
 	rte_ring_list_dump(stdout);
 
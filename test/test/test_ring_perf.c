@@ -9,6 +9,7 @@
 #include <rte_cycles.h>
 #include <rte_launch.h>
 #include <rte_pause.h>
+#include <rte_errno.h>
 
 #include "test.h"
 
@@ -362,15 +363,10 @@ test_bulk_enqueue_dequeue(struct rte_ring *r)
 	}
 }
 
-static int
-test_ring_perf(void)
+static void
+test_ring_perf_run(struct rte_ring *r)
 {
 	struct lcore_pair cores;
-	struct rte_ring *r = NULL;
-
-	r = rte_ring_create(RING_NAME, RING_SIZE, rte_socket_id(), 0);
-	if (r == NULL)
-		return -1;
 
 	printf("### Testing single element and burst enq/deq ###\n");
 	test_single_enqueue_dequeue(r);
@@ -394,6 +390,29 @@ test_ring_perf(void)
 		printf("\n### Testing using two NUMA nodes ###\n");
 		run_on_core_pair(&cores, r, enqueue_bulk, dequeue_bulk);
 	}
+}
+
+static int
+test_ring_perf(void)
+{
+	struct rte_ring *r = NULL;
+
+	r = rte_ring_create(RING_NAME, RING_SIZE, rte_socket_id(), 0);
+	if (r == NULL)
+		return -1;
+
+	test_ring_perf_run(r);
+	rte_ring_free(r);
+
+	r = rte_ring_create(RING_NAME, RING_SIZE, rte_socket_id(), RING_F_LF);
+	if (r == NULL) {
+		if (rte_errno == ENOTSUP)
+			return 0;
+		return -1;
+	}
+
+	printf("\n### Non-blocking ring ###\n");
+	test_ring_perf_run(r);
 	rte_ring_free(r);
 	return 0;
 }
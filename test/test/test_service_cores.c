@@ -885,6 +885,95 @@ service_may_be_active(void)
 	return unregister_all();
 }
 
+/* map two busy services on one core, and check that the balancer moves one
+ * of them to an idle core
+ */
+static int
+service_balance(void)
+{
+	const uint32_t sid = 0;
+	uint32_t sid2, util, i;
+
+	if (rte_lcore_count() < 3) {
+		printf("Not enough cores for service balance test\n");
+		return TEST_SKIPPED;
+	}
+
+	uint32_t slcore_1 = rte_get_next_lcore(/* start core */ -1,
+					       /* skip master */ 1,
+					       /* wrap */ 0);
+	uint32_t slcore_2 = rte_get_next_lcore(/* start core */ slcore_1,
+					       /* skip master */ 1,
+					       /* wrap */ 0);
+
+	struct rte_service_spec service;
+	memset(&service, 0, sizeof(struct rte_service_spec));
+	service.callback = dummy_cb;
+	snprintf(service.name, sizeof(service.name), "balanced_service");
+	TEST_ASSERT_EQUAL(0, rte_service_component_register(&service, &sid2),
+			"Failed to register second service");
+	rte_service_component_runstate_set(sid2, 1);
+
+	TEST_ASSERT_EQUAL(-ENODATA, rte_service_utilization_get(sid, &util),
+			"Utilization available before any balancing period");
+
+	TEST_ASSERT_EQUAL(0, rte_service_lcore_add(slcore_1),
+			"Add service core 1 failed");
+	TEST_ASSERT_EQUAL(0, rte_service_lcore_add(slcore_2),
+			"Add service core 2 failed");
+	TEST_ASSERT_EQUAL(0, rte_service_map_lcore_set(sid, slcore_1, 1),
+			"Failed to map service on core 1");
+	TEST_ASSERT_EQUAL(0, rte_service_map_lcore_set(sid2, slcore_1, 1),
+			"Failed to map second service on core 1");
+	TEST_ASSERT_EQUAL(0, rte_service_runstate_set(sid, 1),
+			"Starting service failed");
+	TEST_ASSERT_EQUAL(0, rte_service_runstate_set(sid2, 1),
+			"Starting second service failed");
+	TEST_ASSERT_EQUAL(0, rte_service_lcore_start(slcore_1),
+			"Service core 1 start failed");
+	TEST_ASSERT_EQUAL(0, rte_service_lcore_start(slcore_2),
+			"Service core 2 start failed");
+
+	/* first call only starts the measurement */
+	TEST_ASSERT_EQUAL(0, rte_service_balance(),
+			"Service moved without measurement");
+	rte_delay_ms(100);
+	TEST_ASSERT_EQUAL(1, rte_service_balance(),
+			"Busy service not moved to the idle core");
+
+	TEST_ASSERT_EQUAL(0, rte_service_lcore_utilization_get(slcore_1,
+			&util), "Failed to get service core utilization");
+	TEST_ASSERT(util > 50, "Busy service core utilization %u%%", util);
+	TEST_ASSERT_EQUAL(0, rte_service_utilization_get(sid, &util),
+			"Failed to get service utilization");
+	TEST_ASSERT(util > 0, "Busy service utilization %u%%", util);
+
+	TEST_ASSERT_EQUAL(1, rte_service_lcore_count_services(slcore_1),
+			"Service core 1 not left with one service");
+	TEST_ASSERT_EQUAL(1, rte_service_lcore_count_services(slcore_2),
+			"Service core 2 not given one service");
+
+	/* both cores are now as busy, nothing should move anymore */
+	rte_delay_ms(100);
+	for (i = 0; i < 3; i++) {
+		rte_delay_ms(100);
+		TEST_ASSERT_EQUAL(0, rte_service_balance(),
+				"Service moved between even cores");
+	}
+
+	TEST_ASSERT_EQUAL(0, rte_service_runstate_set(sid, 0),
+			"Stopping service failed");
+	TEST_ASSERT_EQUAL(0, rte_service_runstate_set(sid2, 0),
+			"Stopping second service failed");
+	rte_service_lcore_stop(slcore_1);
+	rte_service_lcore_stop(slcore_2);
+	rte_eal_wait_lcore(slcore_1);
+	rte_eal_wait_lcore(slcore_2);
+	rte_service_balance_enable(0);
+
+	return unregister_all();
+}
+
 static struct unit_test_suite service_tests  = {
 	.suite_name = "service core test suite",
 	.setup = testsuite_setup,
@@ -906,6 +995,7 @@ static struct unit_test_suite service_tests  = {
 		TEST_CASE_ST(dummy_register, NULL, service_app_lcore_mt_safe),
 		TEST_CASE_ST(dummy_register, NULL, service_app_lcore_mt_unsafe),
 		TEST_CASE_ST(dummy_register, NULL, service_may_be_active),
+		TEST_CASE_ST(dummy_register, NULL, service_balance),
 		TEST_CASES_END() /**< NULL terminate unit test array */
 	}
 };
@@ -3,6 +3,7 @@
  */
 
 #include <string.h>
+#include <stdlib.h>
 #include <rte_byteorder.h>
 #include <rte_table_lpm_ipv6.h>
 #include <rte_lru.h>
@@ -17,6 +18,7 @@ table_test table_tests[] = {
 	test_table_lpm_ipv6,
 	test_table_hash_lru,
 	test_table_hash_ext,
+	test_table_hash_resizable,
 	test_table_hash_cuckoo,
 };
 
@@ -889,6 +891,104 @@ test_table_hash_ext(void)
 }
 
 
+int
+test_table_hash_resizable(void)
+{
+	int status, key_found;
+	uint32_t i, j, n_keys = 1 << 12;
+	uint64_t pkts_mask, result_mask;
+	struct rte_mbuf *mbufs[RTE_PORT_IN_BURST_SIZE_MAX];
+	char *entries[RTE_PORT_IN_BURST_SIZE_MAX];
+	void **entry_ptrs;
+	void *table;
+	char entry;
+	uint8_t key[32];
+	uint32_t *k32 = (uint32_t *) &key;
+
+	/* Initialize params and create tables: start small, then grow */
+	struct rte_table_hash_params hash_params = {
+		.name = "TABLE",
+		.key_size = 32,
+		.key_offset = APP_METADATA_OFFSET(32),
+		.key_mask = NULL,
+		.n_keys = 16,
+		.n_buckets = 4,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+	};
+
+	hash_params.n_buckets = 3;
+	table = rte_table_hash_resizable_ops.f_create(&hash_params, 0, 1);
+	if (table != NULL)
+		return -1;
+
+	hash_params.n_buckets = 4;
+	table = rte_table_hash_resizable_ops.f_create(&hash_params, 0, 1);
+	if (table == NULL)
+		return -2;
+
+	entry_ptrs = calloc(n_keys, sizeof(void *));
+	if (entry_ptrs == NULL) {
+		rte_table_hash_resizable_ops.f_free(table);
+		return -3;
+	}
+
+	/* Add way more keys than n_keys */
+	memset(key, 0, 32);
+	for (i = 0; i < n_keys; i++) {
+		k32[0] = rte_cpu_to_be_32(i);
+		entry = (char) i;
+		status = rte_table_hash_resizable_ops.f_add(table, &key, &entry,
+			&key_found, &entry_ptrs[i]);
+		if ((status != 0) || (key_found != 0)) {
+			status = -4;
+			goto out;
+		}
+	}
+
+	/* Delete the odd keys */
+	for (i = 1; i < n_keys; i += 2) {
+		k32[0] = rte_cpu_to_be_32(i);
+		status = rte_table_hash_resizable_ops.f_delete(table, &key,
+			&key_found, &entry);
+		if ((status != 0) || (key_found != 1) || (entry != (char) i)) {
+			status = -5;
+			goto out;
+		}
+	}
+
+	/* Lookup: the entries did not move while the table grew */
+	for (i = 0; i < n_keys; i += RTE_PORT_IN_BURST_SIZE_MAX) {
+		for (j = 0; j < RTE_PORT_IN_BURST_SIZE_MAX; j++)
+			PREPARE_PACKET(mbufs[j], rte_cpu_to_be_32(i + j));
+
+		pkts_mask = RTE_LEN2MASK(RTE_PORT_IN_BURST_SIZE_MAX, uint64_t);
+		rte_table_hash_resizable_ops.f_lookup(table, mbufs, pkts_mask,
+			&result_mask, (void **)entries);
+
+		for (j = 0; j < RTE_PORT_IN_BURST_SIZE_MAX; j++)
+			rte_pktmbuf_free(mbufs[j]);
+
+		if (result_mask != 0x5555555555555555LLU) {
+			status = -6;
+			goto out;
+		}
+
+		for (j = 0; j < RTE_PORT_IN_BURST_SIZE_MAX; j += 2)
+			if (entries[j] != entry_ptrs[i + j]) {
+				status = -7;
+				goto out;
+			}
+	}
+
+	status = 0;
+out:
+	free(entry_ptrs);
+	rte_table_hash_resizable_ops.f_free(table);
+	return status;
+}
+
+
 int
 test_table_hash_cuckoo(void)
 {
@@ -494,6 +494,93 @@ timer_basic_main_loop(__attribute__((unused)) void *arg)
 	return 0;
 }
 
+static volatile int data_cb_count;
+
+static void
+timer_data_cb(__attribute__((unused)) struct rte_timer *tim,
+	      __attribute__((unused)) void *arg)
+{
+	data_cb_count++;
+}
+
+/* timers of a timer data instance only run with its own manage call */
+static int
+timer_data_test(void)
+{
+	struct rte_timer tim;
+	uint32_t id, id2;
+	uint64_t end;
+	int ret;
+
+	ret = rte_timer_data_alloc(&id);
+	if (ret != 0 || id == 0) {
+		printf("Cannot allocate timer data: %d\n", ret);
+		return -1;
+	}
+
+	data_cb_count = 0;
+	rte_timer_init(&tim);
+	ret = rte_timer_alt_reset(id, &tim, 0, SINGLE, rte_lcore_id(),
+				  timer_data_cb, NULL);
+	if (ret != 0) {
+		printf("Cannot reset timer in timer data %u\n", id);
+		goto fail;
+	}
+
+	/* the default instance does not run it */
+	rte_delay_us(10);
+	rte_timer_manage();
+	if (data_cb_count != 0 || !rte_timer_pending(&tim)) {
+		printf("Timer of timer data %u run by rte_timer_manage()\n",
+		       id);
+		goto fail;
+	}
+
+	end = rte_get_timer_cycles() + rte_get_timer_hz();
+	while (data_cb_count == 0 && rte_get_timer_cycles() < end)
+		rte_timer_alt_manage(id);
+	if (data_cb_count != 1) {
+		printf("Timer of timer data %u not run\n", id);
+		goto fail;
+	}
+
+	/* a stopped timer does not run */
+	rte_timer_alt_reset(id, &tim, 0, SINGLE, rte_lcore_id(),
+			    timer_data_cb, NULL);
+	if (rte_timer_alt_stop(id, &tim) != 0) {
+		printf("Cannot stop timer in timer data %u\n", id);
+		goto fail;
+	}
+	rte_delay_us(10);
+	rte_timer_alt_manage(id);
+	if (data_cb_count != 1) {
+		printf("Stopped timer of timer data %u run\n", id);
+		goto fail;
+	}
+	rte_timer_alt_dump_stats(id, stdout);
+
+	/* the default instance and freed instances cannot be used */
+	if (rte_timer_data_dealloc(0) != -EINVAL ||
+	    rte_timer_data_dealloc(id) != 0 ||
+	    rte_timer_data_dealloc(id) != -EINVAL ||
+	    rte_timer_alt_manage(id) != -EINVAL) {
+		printf("Wrong timer data deallocation\n");
+		return -1;
+	}
+
+	/* the identifier is reused */
+	if (rte_timer_data_alloc(&id2) != 0 || id2 != id) {
+		printf("Timer data identifier not reused\n");
+		return -1;
+	}
+	rte_timer_data_dealloc(id2);
+
+	return 0;
+fail:
+	rte_timer_data_dealloc(id);
+	return -1;
+}
+
 static int
 timer_sanity_check(void)
 {
@@ -592,6 +679,10 @@ test_timer(void)
 		rte_timer_stop_sync(&mytiminfo[i].tim);
 	}
 
+	printf("\nStart timer data tests\n");
+	if (timer_data_test() < 0)
+		return TEST_FAILED;
+
 	rte_timer_dump_stats(stdout);
 
 	return TEST_SUCCESS;
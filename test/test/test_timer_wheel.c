@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_memory.h>
+#include <rte_timer_wheel.h>
+
+#include "test.h"
+
+#define NB_TIMERS 64
+#define RING_SIZE 128
+/* timeout of each test, in seconds */
+#define TEST_TIMEOUT 5
+
+struct test_timer {
+	struct rte_timer_wheel_timer tim;
+	uint64_t deadline;
+	unsigned int runs;
+	unsigned int max_runs;
+	int early;
+};
+
+static struct rte_timer_wheel *tw;
+static struct test_timer timers[NB_TIMERS];
+
+static void
+test_timer_cb(struct rte_timer_wheel_timer *tim, void *arg)
+{
+	struct test_timer *t = arg;
+
+	if (rte_get_timer_cycles() < t->deadline)
+		t->early = 1;
+	t->runs++;
+	if (t->max_runs != 0 && t->runs == t->max_runs)
+		rte_timer_wheel_cancel(tw, tim);
+}
+
+static void
+test_timer_arm(unsigned int i, uint64_t cycles, uint64_t period,
+		unsigned int max_runs)
+{
+	struct test_timer *t = &timers[i];
+
+	rte_timer_wheel_timer_init(&t->tim, test_timer_cb, t);
+	t->deadline = rte_get_timer_cycles() + cycles;
+	t->runs = 0;
+	t->max_runs = max_runs;
+	t->early = 0;
+	rte_timer_wheel_arm(tw, &t->tim, cycles, period);
+}
+
+/* run the wheel until no timer is armed */
+static int
+test_timer_wait(void)
+{
+	struct rte_timer_wheel_stats stats;
+	uint64_t end = rte_get_timer_cycles() +
+		TEST_TIMEOUT * rte_get_timer_hz();
+
+	do {
+		rte_timer_wheel_manage(tw);
+		rte_timer_wheel_stats_get(tw, &stats);
+		if (rte_get_timer_cycles() > end) {
+			printf("Timeout with %"PRIu64" timers armed\n",
+					stats.armed);
+			return -1;
+		}
+	} while (stats.armed != 0);
+
+	return 0;
+}
+
+/* one-shot timers spread over all the levels of the wheel */
+static int
+test_timer_wheel_oneshot(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NB_TIMERS; i++)
+		test_timer_arm(i, UINT64_C(1) << (i % 26), 0, 0);
+
+	if (test_timer_wait() < 0)
+		return -1;
+
+	for (i = 0; i < NB_TIMERS; i++) {
+		if (timers[i].runs != 1 || timers[i].early) {
+			printf("Timer %u ran %u times, early %d\n", i,
+					timers[i].runs, timers[i].early);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* cancelled and re-armed timers */
+static int
+test_timer_wheel_cancel(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NB_TIMERS; i++)
+		test_timer_arm(i, 1000 * (i + 1), 0, 0);
+	for (i = 0; i < NB_TIMERS; i += 2)
+		rte_timer_wheel_cancel(tw, &timers[i].tim);
+	for (i = 1; i < NB_TIMERS; i += 4) {
+		timers[i].deadline = rte_get_timer_cycles() + 100000;
+		rte_timer_wheel_arm(tw, &timers[i].tim, 100000, 0);
+	}
+
+	for (i = 0; i < NB_TIMERS; i++) {
+		if (rte_timer_wheel_pending(&timers[i].tim) != (int)(i & 1)) {
+			printf("Timer %u wrong pending state\n", i);
+			return -1;
+		}
+	}
+
+	if (test_timer_wait() < 0)
+		return -1;
+
+	for (i = 0; i < NB_TIMERS; i++) {
+		if (timers[i].runs != (i & 1) || timers[i].early) {
+			printf("Timer %u ran %u times, early %d\n", i,
+					timers[i].runs, timers[i].early);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* periodic timers stopped by their callback */
+static int
+test_timer_wheel_periodic(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NB_TIMERS; i++)
+		test_timer_arm(i, 1000, 5000 * (i + 1), i % 8 + 1);
+
+	if (test_timer_wait() < 0)
+		return -1;
+
+	for (i = 0; i < NB_TIMERS; i++) {
+		if (timers[i].runs != i % 8 + 1 || timers[i].early) {
+			printf("Timer %u ran %u times, early %d\n", i,
+					timers[i].runs, timers[i].early);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* requests through the ring, applied by the next manage call */
+static int
+test_timer_wheel_remote(void)
+{
+	struct rte_timer_wheel_stats stats;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < NB_TIMERS; i++) {
+		test_timer_arm(i, 1000, 0, 0);
+		rte_timer_wheel_cancel(tw, &timers[i].tim);
+		ret = rte_timer_wheel_arm_remote(tw, &timers[i].tim, 10000, 0);
+		if (ret != 0) {
+			printf("Remote arm failed: %d\n", ret);
+			return -1;
+		}
+	}
+	for (i = 0; i < NB_TIMERS; i += 2) {
+		ret = rte_timer_wheel_cancel_remote(tw, &timers[i].tim);
+		if (ret != 0) {
+			printf("Remote cancel failed: %d\n", ret);
+			return -1;
+		}
+	}
+
+	rte_timer_wheel_stats_get(tw, &stats);
+	if (stats.armed != 0) {
+		printf("Remote requests applied too early\n");
+		return -1;
+	}
+
+	if (test_timer_wait() < 0)
+		return -1;
+
+	rte_timer_wheel_stats_get(tw, &stats);
+	if (stats.remote != NB_TIMERS + NB_TIMERS / 2) {
+		printf("Wrong number of remote requests: %"PRIu64"\n",
+				stats.remote);
+		return -1;
+	}
+	for (i = 0; i < NB_TIMERS; i++) {
+		if (timers[i].runs != (i & 1)) {
+			printf("Timer %u ran %u times\n", i, timers[i].runs);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_timer_wheel(void)
+{
+	struct rte_timer_wheel_params params = {
+		.tick_cycles = 0,
+		.ring_size = RING_SIZE,
+		.socket_id = SOCKET_ID_ANY,
+	};
+	int ret = -1;
+
+	tw = rte_timer_wheel_create("test_timer_wheel", &params);
+	if (tw != NULL || rte_errno != EINVAL) {
+		printf("Wheel created with a null tick\n");
+		rte_timer_wheel_free(tw);
+		return -1;
+	}
+
+	/* small ticks, so that all levels are used within the timeout */
+	params.tick_cycles = 1;
+	tw = rte_timer_wheel_create("test_timer_wheel", &params);
+	if (tw == NULL) {
+		printf("Cannot create wheel: %d\n", rte_errno);
+		return -1;
+	}
+
+	if (test_timer_wheel_oneshot() < 0)
+		goto out;
+	if (test_timer_wheel_cancel() < 0)
+		goto out;
+	if (test_timer_wheel_periodic() < 0)
+		goto out;
+	if (test_timer_wheel_remote() < 0)
+		goto out;
+
+	rte_timer_wheel_dump(stdout, tw);
+	ret = 0;
+out:
+	rte_timer_wheel_free(tw);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(timer_wheel_autotest, test_timer_wheel);
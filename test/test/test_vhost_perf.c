@@ -0,0 +1,250 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2018 Intel Corporation
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+#include <rte_bus_vdev.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+
+#include "test.h"
+
+/*
+ * Cycles per packet of the vhost datapath, with a virtio-user port as the
+ * guest and a vhost port as the host in the same process:
+ *  - guest to host: virtio-user Tx burst, then vhost Rx burst
+ *  - host to guest: vhost Tx burst, then virtio-user Rx burst
+ * The cycles count both ends of the transfer, run on a single lcore.
+ */
+
+#define VHOST_PERF_NAME		"net_vhost_perf"
+#define VIRTIO_PERF_NAME	"net_virtio_user_perf"
+#define NB_MBUF			8191
+#define MBUF_CACHE_SIZE		256
+#define RING_SIZE		1024
+#define MAX_BURST		32
+#define ITERATIONS		(1 << 16)
+#define LINK_WAIT_MS		5000
+#define DRAIN_RETRIES		64
+
+struct vhost_perf_cfg {
+	const char *name;
+	const char *vhost_args;
+	const char *virtio_args;
+	/* keep a reference on the Tx mbufs so virtio cannot push the header */
+	int indirect;
+};
+
+static const struct vhost_perf_cfg vhost_perf_cfgs[] = {
+	{ "split", "", ",mrg_rxbuf=0,in_order=0", 0 },
+	{ "mergeable", "", ",mrg_rxbuf=1,in_order=0", 0 },
+	{ "in-order", "", ",mrg_rxbuf=1,in_order=1", 0 },
+	{ "indirect", "", ",mrg_rxbuf=0,in_order=0", 1 },
+	{ "dequeue zero copy", ",dequeue-zero-copy=1",
+		",mrg_rxbuf=0,in_order=0", 0 },
+	{ "packed", "", ",mrg_rxbuf=0,in_order=0,packed_vq=1", 0 },
+	{ "packed mergeable", "", ",mrg_rxbuf=1,in_order=0,packed_vq=1", 0 },
+	{ "packed in-order", "", ",mrg_rxbuf=1,in_order=1,packed_vq=1", 0 },
+};
+
+static const uint16_t pkt_sizes[] = { 64, 256, 1024, 1500 };
+
+static struct rte_mempool *mp;
+static char sock_path[PATH_MAX];
+
+static int
+port_setup(const char *name, uint16_t *port)
+{
+	struct rte_eth_conf conf;
+
+	memset(&conf, 0, sizeof(conf));
+
+	if (rte_eth_dev_get_port_by_name(name, port) != 0)
+		return -1;
+	if (rte_eth_dev_configure(*port, 1, 1, &conf) < 0)
+		return -1;
+	if (rte_eth_rx_queue_setup(*port, 0, RING_SIZE,
+			rte_eth_dev_socket_id(*port), NULL, mp) < 0)
+		return -1;
+	if (rte_eth_tx_queue_setup(*port, 0, RING_SIZE,
+			rte_eth_dev_socket_id(*port), NULL) < 0)
+		return -1;
+	if (rte_eth_dev_start(*port) < 0)
+		return -1;
+
+	return 0;
+}
+
+static void
+ports_teardown(void)
+{
+	uint16_t port;
+
+	if (rte_eth_dev_get_port_by_name(VIRTIO_PERF_NAME, &port) == 0) {
+		rte_eth_dev_stop(port);
+		rte_eth_dev_close(port);
+	}
+	rte_vdev_uninit(VIRTIO_PERF_NAME);
+
+	if (rte_eth_dev_get_port_by_name(VHOST_PERF_NAME, &port) == 0) {
+		rte_eth_dev_stop(port);
+		rte_eth_dev_close(port);
+	}
+	rte_vdev_uninit(VHOST_PERF_NAME);
+
+	unlink(sock_path);
+}
+
+static int
+ports_setup(const struct vhost_perf_cfg *cfg, uint16_t *vhost_port,
+		uint16_t *virtio_port)
+{
+	struct rte_eth_link link;
+	char args[PATH_MAX + 128];
+	int i;
+
+	snprintf(args, sizeof(args), "iface=%s,queues=1%s",
+			sock_path, cfg->vhost_args);
+	if (rte_vdev_init(VHOST_PERF_NAME, args) != 0) {
+		printf("Cannot create %s\n", VHOST_PERF_NAME);
+		goto fail;
+	}
+
+	snprintf(args, sizeof(args), "path=%s,queues=1,queue_size=%u%s",
+			sock_path, RING_SIZE, cfg->virtio_args);
+	if (rte_vdev_init(VIRTIO_PERF_NAME, args) != 0) {
+		printf("Cannot create %s\n", VIRTIO_PERF_NAME);
+		goto fail;
+	}
+
+	if (port_setup(VHOST_PERF_NAME, vhost_port) < 0 ||
+			port_setup(VIRTIO_PERF_NAME, virtio_port) < 0) {
+		printf("Cannot start the vhost and virtio-user ports\n");
+		goto fail;
+	}
+
+	/* the vhost link comes up once the virtio-user rings are set */
+	for (i = 0; i < LINK_WAIT_MS / 10; i++) {
+		rte_eth_link_get_nowait(*vhost_port, &link);
+		if (link.link_status == ETH_LINK_UP)
+			return 0;
+		rte_delay_ms(10);
+	}
+	printf("Timeout waiting for the vhost link\n");
+
+fail:
+	ports_teardown();
+	return -1;
+}
+
+/* Cycles per packet from tx_port to rx_port, 0 if nothing went through. */
+static double
+measure(uint16_t tx_port, uint16_t rx_port, uint16_t size, int indirect)
+{
+	struct rte_mbuf *tx_pkts[MAX_BURST];
+	struct rte_mbuf *rx_pkts[MAX_BURST];
+	uint64_t cycles = 0, nb_pkts = 0, start;
+	uint16_t nb_tx, nb_rx, j;
+	unsigned int i, retries;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		if (rte_pktmbuf_alloc_bulk(mp, tx_pkts, MAX_BURST) != 0)
+			return 0;
+		for (j = 0; j < MAX_BURST; j++) {
+			rte_pktmbuf_append(tx_pkts[j], size);
+			if (indirect)
+				rte_mbuf_refcnt_update(tx_pkts[j], 1);
+		}
+
+		start = rte_rdtsc();
+		nb_tx = rte_eth_tx_burst(tx_port, 0, tx_pkts, MAX_BURST);
+		nb_rx = 0;
+		for (retries = 0; nb_rx < nb_tx && retries < DRAIN_RETRIES;
+				retries++)
+			nb_rx += rte_eth_rx_burst(rx_port, 0,
+					&rx_pkts[nb_rx], nb_tx - nb_rx);
+		cycles += rte_rdtsc() - start;
+		nb_pkts += nb_rx;
+
+		for (j = 0; j < nb_rx; j++)
+			rte_pktmbuf_free(rx_pkts[j]);
+		/* the extra references of the transmitted mbufs */
+		for (j = 0; indirect && j < nb_tx; j++)
+			rte_pktmbuf_free(tx_pkts[j]);
+		for (j = nb_tx; j < MAX_BURST; j++) {
+			if (indirect)
+				rte_mbuf_refcnt_update(tx_pkts[j], -1);
+			rte_pktmbuf_free(tx_pkts[j]);
+		}
+	}
+
+	if (nb_pkts == 0)
+		return 0;
+
+	return (double)cycles / nb_pkts;
+}
+
+static int
+test_vhost_perf_cfg(const struct vhost_perf_cfg *cfg)
+{
+	uint16_t vhost_port, virtio_port;
+	unsigned int i;
+
+	if (ports_setup(cfg, &vhost_port, &virtio_port) < 0)
+		return -1;
+
+	for (i = 0; i < RTE_DIM(pkt_sizes); i++) {
+		printf("%-18s %5u %14.1F %14.1F\n", cfg->name, pkt_sizes[i],
+			measure(virtio_port, vhost_port, pkt_sizes[i],
+				cfg->indirect),
+			measure(vhost_port, virtio_port, pkt_sizes[i], 0));
+	}
+
+	ports_teardown();
+
+	return 0;
+}
+
+static int
+test_vhost_perf(void)
+{
+	unsigned int i;
+	int ret = TEST_SUCCESS;
+
+	snprintf(sock_path, sizeof(sock_path), "/tmp/vhost_perf_%d.sock",
+			getpid());
+
+	mp = rte_pktmbuf_pool_create("vhost_perf_pool", NB_MBUF,
+			MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+			rte_socket_id());
+	if (mp == NULL) {
+		printf("Cannot create the mbuf pool\n");
+		return TEST_FAILED;
+	}
+
+	printf("\nmbuf Tx offload fields on cache line %zu\n",
+		offsetof(struct rte_mbuf, tx_offload) / RTE_CACHE_LINE_MIN_SIZE);
+	printf("%-18s %5s %14s %14s\n", "config", "size",
+		"guest to host", "host to guest");
+	for (i = 0; i < RTE_DIM(vhost_perf_cfgs); i++) {
+		if (test_vhost_perf_cfg(&vhost_perf_cfgs[i]) < 0) {
+			/* e.g. no vhost or virtio-user PMD, or no hugepages */
+			ret = i == 0 ? TEST_SKIPPED : TEST_FAILED;
+			break;
+		}
+	}
+
+	rte_mempool_free(mp);
+	mp = NULL;
+
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(vhost_perf_autotest, test_vhost_perf);
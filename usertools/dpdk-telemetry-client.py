@@ -9,6 +9,7 @@
 BUFFER_SIZE = 200000
 
 METRICS_REQ = "{\"action\":0,\"command\":\"ports_all_stat_values\",\"data\":null}"
+VHOST_REQ = "{\"action\":0,\"command\":\"vhost_devices\",\"data\":null}"
 API_REG = "{\"action\":1,\"command\":\"clients\",\"data\":{\"client_path\":\""
 API_UNREG = "{\"action\":2,\"command\":\"clients\",\"data\":{\"client_path\":\""
 DEFAULT_FP = "/var/run/dpdk/default_client"
@@ -69,6 +70,11 @@ def requestMetrics(self): # Requests metrics for given client
         data = self.socket.client_fd.recv(BUFFER_SIZE)
         print "\nResponse: \n", str(data)
 
+    def requestVhost(self): # Requests the vhost and vdpa devices for given client
+        self.socket.client_fd.send(VHOST_REQ)
+        data = self.socket.client_fd.recv(BUFFER_SIZE)
+        print "\nResponse: \n", str(data)
+
     def repeatedlyRequestMetrics(self, sleep_time): # Recursively requests metrics for given client
         print("\nPlease enter the number of times you'd like to continuously request Metrics:")
         n_requests = int(input("\n:"))
@@ -79,11 +85,12 @@ def repeatedlyRequestMetrics(self, sleep_time): # Recursively requests metrics f
             time.sleep(sleep_time)
 
     def interactiveMenu(self, sleep_time): # Creates Interactive menu within the script
-        while self.choice != 3:
+        while self.choice != 4:
             print("\nOptions Menu")
             print("[1] Send for Metrics for all ports")
             print("[2] Send for Metrics for all ports recursively")
-            print("[3] Unregister client")
+            print("[3] Send for vhost and vdpa devices")
+            print("[4] Unregister client")
 
             try:
                 self.choice = int(input("\n:"))
@@ -94,6 +101,8 @@ def interactiveMenu(self, sleep_time): # Creates Interactive menu within the scr
                 elif self.choice == 2:
                     self.repeatedlyRequestMetrics(sleep_time)
                 elif self.choice == 3:
+                    self.requestVhost()
+                elif self.choice == 4:
                     self.unregister()
                     self.unregistered = 1
                 else:
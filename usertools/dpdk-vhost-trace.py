@@ -0,0 +1,114 @@
+#!/usr/bin/env python
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright(c) 2018 Intel Corporation
+
+#
+# Decode a vhost vring events trace written by rte_vhost_trace_dump()
+#
+from __future__ import print_function
+import struct
+import sys
+from optparse import OptionParser
+
+FILE_HDR = struct.Struct('<8sIIQ')
+BUF_HDR = struct.Struct('<II')
+RECORD = struct.Struct('<QHHHH')
+MAGIC = b'VHOSTTRC'
+VERSION = 1
+LCORE_ID_ANY = 0xffffffff
+
+EVENTS = {
+    1: 'avail',
+    2: 'used',
+    3: 'call',
+    4: 'kickfd',
+    5: 'msg',
+}
+
+
+def read_trace(path):
+    '''Return the TSC frequency and the records of all lcores by time'''
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    magic, version, nr_bufs, tsc_hz = FILE_HDR.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit('%s: not a vhost trace of version %d' % (path, VERSION))
+
+    records = []
+    off = FILE_HDR.size
+    for _ in range(nr_bufs):
+        lcore, nr = BUF_HDR.unpack_from(data, off)
+        off += BUF_HDR.size
+        for _ in range(nr):
+            tsc, vid, qid, event, idx = RECORD.unpack_from(data, off)
+            off += RECORD.size
+            records.append((tsc, lcore, vid, qid, event, idx))
+
+    records.sort()
+    return tsc_hz, records
+
+
+def print_records(tsc_hz, records):
+    start = records[0][0]
+    for tsc, lcore, vid, qid, event, idx in records:
+        print('%14.3f %5s vid %-4d qid %-4d %-7s %d' %
+              ((tsc - start) * 1e6 / tsc_hz,
+               'ctrl' if lcore == LCORE_ID_ANY else str(lcore),
+               vid, qid, EVENTS.get(event, str(event)), idx))
+
+
+def print_summary(tsc_hz, records):
+    '''Per vring: polls, longest gap between polls, longest used to call'''
+    vrings = {}
+    for tsc, lcore, vid, qid, event, idx in records:
+        if event == 5:
+            continue
+        v = vrings.setdefault((vid, qid), {'polls': 0, 'last_poll': None,
+                                           'max_gap': 0, 'calls': 0,
+                                           'last_used': None,
+                                           'max_call': 0})
+        if event == 1:
+            if v['last_poll'] is not None:
+                v['max_gap'] = max(v['max_gap'], tsc - v['last_poll'])
+            v['polls'] += 1
+            v['last_poll'] = tsc
+        elif event == 2:
+            if v['last_used'] is None:
+                v['last_used'] = tsc
+        elif event == 3:
+            v['calls'] += 1
+            if v['last_used'] is not None:
+                v['max_call'] = max(v['max_call'], tsc - v['last_used'])
+                v['last_used'] = None
+
+    print('%-5s %-5s %10s %14s %8s %16s' %
+          ('vid', 'qid', 'polls', 'max gap (us)', 'calls', 'max call (us)'))
+    for (vid, qid), v in sorted(vrings.items()):
+        print('%-5d %-5d %10d %14.3f %8d %16.3f' %
+              (vid, qid, v['polls'], v['max_gap'] * 1e6 / tsc_hz,
+               v['calls'], v['max_call'] * 1e6 / tsc_hz))
+
+
+def main():
+    parser = OptionParser(usage='%prog [options] trace_file')
+    parser.add_option('-s', '--summary', action='store_true',
+                      help='print per vring polling and notification delays '
+                      'instead of the records')
+    options, args = parser.parse_args()
+    if len(args) != 1:
+        parser.error('a trace file is required')
+
+    tsc_hz, records = read_trace(args[0])
+    if not records:
+        print('no records')
+        return
+
+    if options.summary:
+        print_summary(tsc_hz, records)
+    else:
+        print_records(tsc_hz, records)
+
+
+if __name__ == '__main__':
+    main()